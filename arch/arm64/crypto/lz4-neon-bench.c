@@ -0,0 +1,185 @@
+/*
+ * lz4-neon-bench.c - compare LZ4 decompression drivers on every CPU
+ *
+ * Loading this module decompresses a set of page sized blocks with each
+ * registered "lz4" driver on each online CPU in turn and reports the
+ * throughput, together with the CPU part number so that big and LITTLE
+ * clusters can be told apart. Like tcrypt, it does all its work from
+ * init() and then refuses to stay loaded.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <asm/cputype.h>
+#include <linux/cpu.h>
+#include <linux/crypto.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+#include <linux/lz4.h>
+#include <linux/math64.h>
+#include <linux/module.h>
+#include <linux/prandom.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+
+MODULE_DESCRIPTION("LZ4 decompression benchmark");
+MODULE_LICENSE("GPL v2");
+
+#define LZ4_BENCH_PAGES		64
+
+static unsigned int iterations = 200;
+module_param(iterations, uint, 0444);
+MODULE_PARM_DESC(iterations, "Passes over the test pages per driver and CPU");
+
+static const char * const lz4_bench_drivers[] = {
+	"lz4-generic",
+	"lz4-neon",
+};
+
+struct lz4_bench {
+	u8 *orig;
+	u8 *comp;
+	unsigned int clen[LZ4_BENCH_PAGES];
+	u8 *out;
+};
+
+/* Text-like content: words from a small dictionary, runs and noise */
+static void lz4_bench_fill(u8 *buf, size_t len)
+{
+	static const char * const words[] = {
+		"the ", "of ", "page ", "memory ", "swap ", "zram ", "\n\t",
+		"return ", "struct ", "0x0000", "    ", "int ", "void *",
+	};
+	struct rnd_state rnd;
+	size_t pos = 0;
+
+	prandom_seed_state(&rnd, 0x4c5a34);
+	while (pos < len) {
+		u32 r = prandom_u32_state(&rnd);
+		const char *w;
+		size_t n;
+
+		switch (r & 7) {
+		case 0:
+			n = min_t(size_t, (r >> 8) & 63, len - pos);
+			memset(buf + pos, r >> 16, n);
+			break;
+		case 1:
+			n = min_t(size_t, 4, len - pos);
+			memcpy(buf + pos, &r, n);
+			break;
+		default:
+			w = words[(r >> 8) % ARRAY_SIZE(words)];
+			n = min_t(size_t, strlen(w), len - pos);
+			memcpy(buf + pos, w, n);
+			break;
+		}
+		pos += n;
+	}
+}
+
+static int lz4_bench_pass(struct crypto_comp *tfm, struct lz4_bench *b,
+			  bool verify)
+{
+	unsigned int j;
+	int err;
+
+	for (j = 0; j < LZ4_BENCH_PAGES; j++) {
+		unsigned int dlen = PAGE_SIZE;
+
+		err = crypto_comp_decompress(tfm, b->comp + j * PAGE_SIZE * 2,
+					     b->clen[j], b->out, &dlen);
+		if (err)
+			return err;
+		if (verify && (dlen != PAGE_SIZE ||
+			       memcmp(b->out, b->orig + j * PAGE_SIZE,
+				      PAGE_SIZE)))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+static long lz4_bench_cpu(void *data)
+{
+	struct lz4_bench *b = data;
+	unsigned int i, d;
+
+	for (d = 0; d < ARRAY_SIZE(lz4_bench_drivers); d++) {
+		struct crypto_comp *tfm;
+		u64 start, ns;
+		int err = 0;
+
+		tfm = crypto_alloc_comp(lz4_bench_drivers[d], 0, 0);
+		if (IS_ERR(tfm))
+			continue;
+
+		/* the verifying pass doubles as cache warm up */
+		err = lz4_bench_pass(tfm, b, true);
+		start = ktime_get_ns();
+		for (i = 0; i < iterations && !err; i++) {
+			err = lz4_bench_pass(tfm, b, false);
+			cond_resched();
+		}
+		ns = ktime_get_ns() - start;
+		crypto_free_comp(tfm);
+
+		if (err) {
+			pr_err("lz4-bench: cpu%d %s: decompression failed (%d)\n",
+			       smp_processor_id(), lz4_bench_drivers[d], err);
+			continue;
+		}
+
+		pr_info("lz4-bench: cpu%d part 0x%03x %-12s %llu MB/s\n",
+			smp_processor_id(), read_cpuid_part_number(),
+			lz4_bench_drivers[d],
+			div64_u64((u64)iterations * LZ4_BENCH_PAGES * PAGE_SIZE *
+				  1000, max_t(u64, ns, 1)));
+	}
+
+	return 0;
+}
+
+static int __init lz4_bench_mod_init(void)
+{
+	struct lz4_bench b;
+	void *wrkmem;
+	unsigned int j;
+	int cpu, ret = -ENOMEM;
+
+	b.orig = vmalloc(LZ4_BENCH_PAGES * PAGE_SIZE);
+	b.comp = vmalloc(LZ4_BENCH_PAGES * PAGE_SIZE * 2);
+	b.out = vmalloc(PAGE_SIZE);
+	wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+	if (!b.orig || !b.comp || !b.out || !wrkmem)
+		goto out;
+
+	lz4_bench_fill(b.orig, LZ4_BENCH_PAGES * PAGE_SIZE);
+	for (j = 0; j < LZ4_BENCH_PAGES; j++) {
+		size_t clen = PAGE_SIZE * 2;
+
+		ret = lz4_compress(b.orig + j * PAGE_SIZE, PAGE_SIZE,
+				   b.comp + j * PAGE_SIZE * 2, &clen, wrkmem);
+		if (ret < 0)
+			goto out;
+		b.clen[j] = clen;
+	}
+
+	get_online_cpus();
+	for_each_online_cpu(cpu)
+		work_on_cpu(cpu, lz4_bench_cpu, &b);
+	put_online_cpus();
+
+	/* nothing to keep around, see tcrypt */
+	ret = -EAGAIN;
+out:
+	vfree(wrkmem);
+	vfree(b.out);
+	vfree(b.comp);
+	vfree(b.orig);
+	return ret;
+}
+
+module_init(lz4_bench_mod_init);
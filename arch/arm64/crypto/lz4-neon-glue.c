@@ -0,0 +1,223 @@
+/*
+ * lz4-neon-glue.c - LZ4 decompression using NEON instructions
+ *
+ * The NEON core decodes the bulk of a block and leaves the last sequences,
+ * as well as anything it does not want to deal with, to the generic
+ * decoder in lib/lz4 which resumes at the sequence it stopped at.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <asm/neon.h>
+#include <linux/crypto.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/lz4.h>
+#include <linux/module.h>
+#include <linux/string.h>
+#include <linux/vmalloc.h>
+
+MODULE_DESCRIPTION("LZ4 compression algorithm, NEON accelerated decompression");
+MODULE_LICENSE("GPL v2");
+MODULE_ALIAS_CRYPTO("lz4");
+MODULE_ALIAS_CRYPTO("lz4-neon");
+
+/* below these sizes the NEON core would bail out right away */
+#define LZ4_NEON_MIN_SRC	32
+#define LZ4_NEON_MIN_DST	64
+
+asmlinkage void lz4_neon_decode(const u8 **ip, u8 **op, const u8 *iend,
+				u8 *oend, const u8 *low);
+
+struct lz4_neon_ctx {
+	void *lz4_comp_mem;
+};
+
+static int lz4_neon_decompress(const u8 *src, unsigned int slen, u8 *dst,
+			       unsigned int dlen)
+{
+	const u8 *ip = src;
+	u8 *op = dst;
+	int ret;
+
+	if (slen >= LZ4_NEON_MIN_SRC && dlen >= LZ4_NEON_MIN_DST) {
+		kernel_neon_begin_partial(2);
+		lz4_neon_decode(&ip, &op, src + slen, dst + dlen, dst);
+		kernel_neon_end();
+	}
+
+	ret = LZ4_decompress_safe_withPrefix((const char *)ip, (char *)op,
+					     src + slen - ip, dst + dlen - op,
+					     op - dst);
+	if (ret < 0)
+		return ret;
+
+	return op - dst + ret;
+}
+
+static int lz4_neon_init(struct crypto_tfm *tfm)
+{
+	struct lz4_neon_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	ctx->lz4_comp_mem = vmalloc(LZ4_MEM_COMPRESS);
+	if (!ctx->lz4_comp_mem)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void lz4_neon_exit(struct crypto_tfm *tfm)
+{
+	struct lz4_neon_ctx *ctx = crypto_tfm_ctx(tfm);
+
+	vfree(ctx->lz4_comp_mem);
+}
+
+static int lz4_neon_compress_crypto(struct crypto_tfm *tfm, const u8 *src,
+				    unsigned int slen, u8 *dst,
+				    unsigned int *dlen)
+{
+	struct lz4_neon_ctx *ctx = crypto_tfm_ctx(tfm);
+	size_t tmp_len = *dlen;
+	int err;
+
+	err = lz4_compress(src, slen, dst, &tmp_len, ctx->lz4_comp_mem);
+	if (err < 0)
+		return -EINVAL;
+
+	*dlen = tmp_len;
+	return 0;
+}
+
+static int lz4_neon_decompress_crypto(struct crypto_tfm *tfm, const u8 *src,
+				      unsigned int slen, u8 *dst,
+				      unsigned int *dlen)
+{
+	int ret;
+
+	ret = lz4_neon_decompress(src, slen, dst, *dlen);
+	if (ret < 0)
+		return -EINVAL;
+
+	*dlen = ret;
+	return 0;
+}
+
+static struct crypto_alg alg_lz4_neon = {
+	.cra_name		= "lz4",
+	.cra_driver_name	= "lz4-neon",
+	.cra_priority		= 200,
+	.cra_flags		= CRYPTO_ALG_TYPE_COMPRESS,
+	.cra_ctxsize		= sizeof(struct lz4_neon_ctx),
+	.cra_module		= THIS_MODULE,
+	.cra_list		= LIST_HEAD_INIT(alg_lz4_neon.cra_list),
+	.cra_init		= lz4_neon_init,
+	.cra_exit		= lz4_neon_exit,
+	.cra_u			= { .compress = {
+	.coa_compress		= lz4_neon_compress_crypto,
+	.coa_decompress		= lz4_neon_decompress_crypto } }
+};
+
+/*
+ * Build a page that exercises every copy the NEON core has: short and
+ * long literal runs, overlapping matches for each offset below 16, long
+ * matches and a block end that has to be finished by the generic code.
+ */
+static void __init lz4_neon_fill(u8 *buf, size_t len)
+{
+	u32 seed = 0x2545f491;
+	size_t pos = 0, n, i;
+	unsigned int offset = 1;
+
+	while (pos < len) {
+		seed = seed * 1103515245 + 12345;
+		n = min_t(size_t, 1 + (seed >> 24), len - pos);
+
+		switch ((seed >> 8) & 3) {
+		case 0:		/* incompressible literals */
+			for (i = 0; i < n; i++) {
+				seed = seed * 1103515245 + 12345;
+				buf[pos + i] = seed >> 16;
+			}
+			break;
+		case 1:		/* overlapping match, offsets 1 to 15 */
+			if (pos < offset)
+				goto literal;
+			for (i = 0; i < n; i++)
+				buf[pos + i] = buf[pos + i - offset];
+			offset = offset % 15 + 1;
+			break;
+		case 2:		/* distant match */
+			if (pos < n + 16)
+				goto literal;
+			memcpy(buf + pos, buf + (seed >> 4) % (pos - n), n);
+			break;
+		default:
+literal:
+			for (i = 0; i < n; i++)
+				buf[pos + i] = 'a' + (pos + i) % 26;
+			break;
+		}
+		pos += n;
+	}
+}
+
+static int __init lz4_neon_selftest(void)
+{
+	const size_t len = PAGE_SIZE;
+	size_t clen = lz4_compressbound(len);
+	u8 *orig, *comp, *out;
+	void *wrkmem;
+	int ret = -ENOMEM;
+
+	orig = vmalloc(len);
+	out = vmalloc(len);
+	comp = vmalloc(clen);
+	wrkmem = vmalloc(LZ4_MEM_COMPRESS);
+	if (!orig || !out || !comp || !wrkmem)
+		goto out;
+
+	lz4_neon_fill(orig, len);
+	ret = -EINVAL;
+	if (lz4_compress(orig, len, comp, &clen, wrkmem) < 0)
+		goto out;
+
+	if (lz4_neon_decompress(comp, clen, out, len) != len ||
+	    memcmp(orig, out, len))
+		goto out;
+
+	/* a truncated block must be rejected, not overrun */
+	if (lz4_neon_decompress(comp, clen / 2, out, len) >= 0)
+		goto out;
+
+	ret = 0;
+out:
+	if (ret)
+		pr_err("lz4-neon: self-test failed (%d)\n", ret);
+	vfree(wrkmem);
+	vfree(comp);
+	vfree(out);
+	vfree(orig);
+	return ret;
+}
+
+static int __init lz4_neon_mod_init(void)
+{
+	int ret;
+
+	ret = lz4_neon_selftest();
+	if (ret)
+		return ret;
+
+	return crypto_register_alg(&alg_lz4_neon);
+}
+
+static void __exit lz4_neon_mod_fini(void)
+{
+	crypto_unregister_alg(&alg_lz4_neon);
+}
+
+module_init(lz4_neon_mod_init);
+module_exit(lz4_neon_mod_fini);
@@ -0,0 +1,26 @@
+#ifndef __ASM_COPY_PROFILE_H
+#define __ASM_COPY_PROFILE_H
+
+/*
+ * Large memcpy/copy_{to,from,in}_user loops are picked per CPU from the
+ * core type, see arch/arm64/lib/copy_profile.c.
+ */
+#define COPY_PROFILE_DEFAULT	0	/* in-order cores, e.g. Cortex-A53 */
+#define COPY_PROFILE_BIG	1	/* out-of-order cores, e.g. Cortex-A73 */
+
+/* copies at least this long use non-temporal stores on big cores */
+#define COPY_PROFILE_NT_THRESHOLD	(32 * 1024)
+
+/* clear_pages() ranges at least this long bypass the caches on big cores */
+#define COPY_PROFILE_ZERO_NT_THRESHOLD	(1024 * 1024)
+
+#ifndef __ASSEMBLY__
+#include <linux/percpu.h>
+
+DECLARE_PER_CPU(unsigned long, arm64_copy_profile);
+extern unsigned long arm64_copy_tuned;
+
+void arm64_copy_profile_init(int cpu, u32 midr);
+#endif
+
+#endif /* __ASM_COPY_PROFILE_H */
@@ -48,6 +48,8 @@ extern void __cpu_copy_user_page(void *to, const void *from,
 				 unsigned long user);
 extern void copy_page(void *to, const void *from);
 extern void clear_page(void *to);
+extern void clear_pages(void *to, unsigned long nr);
+#define __HAVE_ARCH_CLEAR_PAGES
 
 #define clear_user_page(addr,vaddr,pg)  __cpu_clear_user_page(addr, vaddr)
 #define copy_user_page(to,from,vaddr,pg) __cpu_copy_user_page(to, from, vaddr)
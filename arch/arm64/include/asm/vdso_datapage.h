@@ -20,6 +20,8 @@
 
 #ifndef __ASSEMBLY__
 
+#include <linux/threads.h>
+
 #ifndef _VDSO_WTM_CLOCK_SEC_T
 #define _VDSO_WTM_CLOCK_SEC_T
 typedef __u64 vdso_wtm_clock_nsec_t;
@@ -55,8 +57,21 @@ struct vdso_data {
 	__u32 tz_minuteswest;	/* Whacky timezone stuff */
 	__u32 tz_dsttime;
 	__u32 use_syscall;
+	/* per CPU: cluster << VDSO_HINT_CLUSTER_SHIFT | capacity */
+	__u32 cpu_hint[NR_CPUS];
 };
 
+#define VDSO_HINT_CLUSTER_SHIFT	16
+#define VDSO_HINT_CAPACITY_MASK	0xffff
+
+/*
+ * TPIDRRO_EL0 of native tasks holds the CPU they run on, written at each
+ * context switch. Zero when the register is not usable for it.
+ */
+#define VDSO_CPU_VALID		(1ULL << 63)
+#define VDSO_CPU_NODE_SHIFT	32
+#define VDSO_CPU_MASK		0xffffffffULL
+
 #endif /* !__ASSEMBLY__ */
 
 #endif /* __KERNEL__ */
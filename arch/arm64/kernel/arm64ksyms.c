@@ -32,6 +32,7 @@
 
 EXPORT_SYMBOL(copy_page);
 EXPORT_SYMBOL(clear_page);
+EXPORT_SYMBOL(clear_pages);
 
 	/* user mem (segment) */
 EXPORT_SYMBOL(__arch_copy_from_user);
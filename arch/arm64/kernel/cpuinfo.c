@@ -16,6 +16,7 @@
  */
 #include <asm/arch_timer.h>
 #include <asm/cachetype.h>
+#include <asm/copy_profile.h>
 #include <asm/cpu.h>
 #include <asm/cputype.h>
 #include <asm/cpufeature.h>
@@ -249,6 +250,7 @@ void cpuinfo_store_cpu(void)
 	struct cpuinfo_arm64 *info = this_cpu_ptr(&cpu_data);
 	__cpuinfo_store_cpu(info);
 	update_cpu_features(smp_processor_id(), info, &boot_cpu_data);
+	arm64_copy_profile_init(smp_processor_id(), info->reg_midr);
 }
 
 void __init cpuinfo_store_boot_cpu(void)
@@ -258,4 +260,5 @@ void __init cpuinfo_store_boot_cpu(void)
 
 	boot_cpu_data = *info;
 	init_cpu_features(&boot_cpu_data);
+	arm64_copy_profile_init(0, info->reg_midr);
 }
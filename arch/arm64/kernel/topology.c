@@ -19,6 +19,7 @@
 #include <linux/nodemask.h>
 #include <linux/of.h>
 #include <linux/sched.h>
+#include <linux/sched_energy.h>
 #include <linux/slab.h>
 
 #include <asm/cputype.h>
@@ -677,4 +678,6 @@ void __init init_cpu_topology(void)
 
 	reset_cpu_power();
 	parse_dt_cpu_power();
+
+	init_sched_energy_costs();
 }
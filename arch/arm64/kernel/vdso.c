@@ -22,6 +22,7 @@
 
 #include <linux/kernel.h>
 #include <linux/clocksource.h>
+#include <linux/cpu.h>
 #include <linux/elf.h>
 #include <linux/err.h>
 #include <linux/errno.h>
@@ -35,6 +36,7 @@
 
 #include <asm/cacheflush.h>
 #include <asm/signal32.h>
+#include <asm/topology.h>
 #include <asm/vdso.h>
 #include <asm/vdso_datapage.h>
 
@@ -357,3 +359,38 @@ void update_vsyscall_tz(void)
 	vdso_data->tz_minuteswest	= sys_tz.tz_minuteswest;
 	vdso_data->tz_dsttime		= sys_tz.tz_dsttime;
 }
+
+/*
+ * Cluster and capacity of each CPU for __kernel_cpu_hint. Both only
+ * change when a CPU comes up and its topology is stored.
+ */
+static void vdso_update_cpu_hint(unsigned int cpu)
+{
+	u32 cluster = topology_physical_package_id(cpu);
+	u32 capacity = arch_scale_cpu_capacity(NULL, cpu);
+
+	WRITE_ONCE(vdso_data->cpu_hint[cpu],
+		   cluster << VDSO_HINT_CLUSTER_SHIFT |
+		   (capacity & VDSO_HINT_CAPACITY_MASK));
+}
+
+static int vdso_cpu_notify(struct notifier_block *self,
+			   unsigned long action, void *hcpu)
+{
+	if ((action & ~CPU_TASKS_FROZEN) == CPU_ONLINE)
+		vdso_update_cpu_hint((unsigned long)hcpu);
+	return NOTIFY_OK;
+}
+
+static int __init vdso_cpu_hint_init(void)
+{
+	unsigned int cpu;
+
+	cpu_notifier_register_begin();
+	for_each_online_cpu(cpu)
+		vdso_update_cpu_hint(cpu);
+	__hotcpu_notifier(vdso_cpu_notify, 0);
+	cpu_notifier_register_done();
+	return 0;
+}
+late_initcall(vdso_cpu_hint_init);
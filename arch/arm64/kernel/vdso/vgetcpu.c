@@ -0,0 +1,71 @@
+/*
+ * Userspace implementations of getcpu and the CPU placement hint
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/compiler.h>	/* for notrace				*/
+#include <linux/errno.h>
+#include <linux/kernel.h>	/* for ARRAY_SIZE()			*/
+
+#include "compiler.h"
+#include "datapage.h"
+
+DEFINE_FALLBACK(getcpu, unsigned int *, cpu, unsigned int *, node)
+
+notrace int __kernel_getcpu(unsigned int *cpu, unsigned int *node,
+			    void *unused)
+{
+	u64 v = read_sysreg(tpidrro_el0);
+
+	if (!(v & VDSO_CPU_VALID))
+		return getcpu_fallback(cpu, node);
+
+	if (cpu)
+		*cpu = v & VDSO_CPU_MASK;
+	if (node)
+		*node = (v & ~VDSO_CPU_VALID) >> VDSO_CPU_NODE_SHIFT;
+	return 0;
+}
+
+/*
+ * The CPU the caller runs on, its cluster and its capacity (1024 for the
+ * biggest CPU). Like getcpu, the answer may be stale by the time it is
+ * used; it is meant for picking arenas and queues, not for correctness.
+ */
+notrace int __kernel_cpu_hint(unsigned int *cpu, unsigned int *cluster,
+			      unsigned int *capacity)
+{
+	const struct vdso_data *vd = __get_datapage();
+	u64 v = read_sysreg(tpidrro_el0);
+	unsigned int c;
+	u32 hint;
+	int ret;
+
+	if (v & VDSO_CPU_VALID) {
+		c = v & VDSO_CPU_MASK;
+	} else {
+		ret = getcpu_fallback(&c, NULL);
+		if (ret)
+			return ret;
+	}
+
+	if (c >= ARRAY_SIZE(vd->cpu_hint))
+		return -EINVAL;
+	hint = READ_ONCE(vd->cpu_hint[c]);
+
+	if (cpu)
+		*cpu = c;
+	if (cluster)
+		*cluster = hint >> VDSO_HINT_CLUSTER_SHIFT;
+	if (capacity)
+		*capacity = hint & VDSO_HINT_CAPACITY_MASK;
+	return 0;
+}
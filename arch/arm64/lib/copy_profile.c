@@ -0,0 +1,62 @@
+/*
+ * Per-CPU selection of the memcpy and user copy loops
+ *
+ * The big and LITTLE clusters want different large copy loops: the
+ * in-order Cortex-A53 needs loads and stores interleaved with a short
+ * prefetch distance, while the out-of-order Cortex-A73 keeps more
+ * lines in flight and should not pull a large copy's destination into
+ * its caches. copy_template.S reads this CPU's profile before entering
+ * the loop for copies of 128 bytes or more.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/percpu.h>
+
+#include <asm/copy_profile.h>
+#include <asm/cputype.h>
+
+DEFINE_PER_CPU(unsigned long, arm64_copy_profile);
+
+/*
+ * Zero until the boot CPU has a valid per-CPU offset, so that early and
+ * position independent callers of memcpy never read tpidr_el1.
+ */
+unsigned long arm64_copy_tuned __read_mostly;
+
+static bool copy_tune_disabled __initdata;
+
+static int __init nocopytune_setup(char *str)
+{
+	copy_tune_disabled = true;
+	return 0;
+}
+early_param("nocopytune", nocopytune_setup);
+
+static const u32 copy_profile_big_cores[] = {
+	MIDR_CORTEX_A57,
+	MIDR_CORTEX_A72,
+	MIDR_CORTEX_A73,
+	MIDR_CORTEX_A75,
+};
+
+void arm64_copy_profile_init(int cpu, u32 midr)
+{
+	unsigned long profile = COPY_PROFILE_DEFAULT;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(copy_profile_big_cores); i++) {
+		if ((midr & MIDR_CPU_MODEL_MASK) == copy_profile_big_cores[i]) {
+			profile = COPY_PROFILE_BIG;
+			break;
+		}
+	}
+	per_cpu(arm64_copy_profile, cpu) = profile;
+
+	if (cpu == 0 && !copy_tune_disabled)
+		arm64_copy_tuned = 1;
+}
@@ -28,6 +28,9 @@
 #include <linux/mempool.h>
 #include <linux/workqueue.h>
 #include <linux/cgroup.h>
+#include <linux/cpu.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <trace/events/block.h>
 
@@ -242,6 +245,196 @@ static void __bio_free(struct bio *bio)
 		bio_integrity_free(bio);
 }
 
+#ifdef CONFIG_BIO_PERCPU_CACHE
+/*
+ * Per-cpu cache of fs_bio_set bios, inline vecs included. Only bios the
+ * mempool would hand back to the slab are kept, so the mempool reserve
+ * stays where forward progress needs it. The lock is only contended when
+ * a cache is drained from another CPU, on hotplug or from the shrinker.
+ */
+#define BIO_CACHE_SIZE		32
+
+struct bio_cache {
+	spinlock_t lock;
+	unsigned int nr;
+	void *objs[BIO_CACHE_SIZE];
+
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long recycled;
+	unsigned long drained;
+};
+
+static DEFINE_PER_CPU(struct bio_cache, bio_cache);
+
+static void *bio_cache_get(struct bio_set *bs)
+{
+	struct bio_cache *c;
+	unsigned long flags;
+	void *p = NULL;
+
+	if (bs != fs_bio_set)
+		return NULL;
+
+	c = get_cpu_ptr(&bio_cache);
+	spin_lock_irqsave(&c->lock, flags);
+	if (c->nr) {
+		p = c->objs[--c->nr];
+		c->hits++;
+	} else {
+		c->misses++;
+	}
+	spin_unlock_irqrestore(&c->lock, flags);
+	put_cpu_ptr(&bio_cache);
+
+	return p;
+}
+
+static bool bio_cache_put(struct bio_set *bs, void *p)
+{
+	struct bio_cache *c;
+	unsigned long flags;
+	bool cached = false;
+
+	if (bs != fs_bio_set ||
+	    READ_ONCE(bs->bio_pool->curr_nr) < bs->bio_pool->min_nr)
+		return false;
+
+	c = get_cpu_ptr(&bio_cache);
+	spin_lock_irqsave(&c->lock, flags);
+	if (c->nr < BIO_CACHE_SIZE) {
+		c->objs[c->nr++] = p;
+		c->recycled++;
+		cached = true;
+	}
+	spin_unlock_irqrestore(&c->lock, flags);
+	put_cpu_ptr(&bio_cache);
+
+	return cached;
+}
+
+static unsigned long bio_cache_drain(int cpu)
+{
+	struct bio_cache *c = per_cpu_ptr(&bio_cache, cpu);
+	void *objs[BIO_CACHE_SIZE];
+	unsigned long flags;
+	unsigned int i, nr;
+
+	spin_lock_irqsave(&c->lock, flags);
+	nr = c->nr;
+	memcpy(objs, c->objs, nr * sizeof(void *));
+	c->nr = 0;
+	c->drained += nr;
+	spin_unlock_irqrestore(&c->lock, flags);
+
+	for (i = 0; i < nr; i++)
+		mempool_free(objs[i], fs_bio_set->bio_pool);
+
+	return nr;
+}
+
+static unsigned long bio_cache_count(struct shrinker *shrink,
+				     struct shrink_control *sc)
+{
+	unsigned long nr = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		nr += READ_ONCE(per_cpu_ptr(&bio_cache, cpu)->nr);
+
+	return nr;
+}
+
+static unsigned long bio_cache_scan(struct shrinker *shrink,
+				    struct shrink_control *sc)
+{
+	unsigned long freed = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		freed += bio_cache_drain(cpu);
+
+	return freed;
+}
+
+static struct shrinker bio_cache_shrinker = {
+	.count_objects	= bio_cache_count,
+	.scan_objects	= bio_cache_scan,
+	.seeks		= DEFAULT_SEEKS,
+};
+
+static int bio_cache_cpu_notify(struct notifier_block *self,
+				unsigned long action, void *hcpu)
+{
+	if (action == CPU_DEAD || action == CPU_DEAD_FROZEN)
+		bio_cache_drain((unsigned long)hcpu);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block bio_cache_cpu_notifier = {
+	.notifier_call	= bio_cache_cpu_notify,
+};
+
+static int bio_cache_stat_show(struct seq_file *s, void *v)
+{
+	int cpu;
+
+	seq_puts(s, "cpu cached hits misses recycled drained\n");
+	for_each_possible_cpu(cpu) {
+		struct bio_cache *c = per_cpu_ptr(&bio_cache, cpu);
+
+		seq_printf(s, "%d %u %lu %lu %lu %lu\n", cpu, c->nr,
+			   c->hits, c->misses, c->recycled, c->drained);
+	}
+
+	return 0;
+}
+
+static int bio_cache_stat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, bio_cache_stat_show, NULL);
+}
+
+static const struct file_operations bio_cache_stat_fops = {
+	.open		= bio_cache_stat_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void __init bio_cache_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(&bio_cache, cpu)->lock);
+
+	register_hotcpu_notifier(&bio_cache_cpu_notifier);
+	register_shrinker(&bio_cache_shrinker);
+}
+
+static int __init bio_cache_debugfs_init(void)
+{
+	debugfs_create_file("bio_cache", S_IRUGO, NULL, NULL,
+			    &bio_cache_stat_fops);
+	return 0;
+}
+late_initcall(bio_cache_debugfs_init);
+#else
+static inline void *bio_cache_get(struct bio_set *bs)
+{
+	return NULL;
+}
+
+static inline bool bio_cache_put(struct bio_set *bs, void *p)
+{
+	return false;
+}
+
+static inline void bio_cache_init(void) { }
+#endif
+
 static void bio_free(struct bio *bio)
 {
 	struct bio_set *bs = bio->bi_pool;
@@ -259,7 +452,8 @@ static void bio_free(struct bio *bio)
 		p = bio;
 		p -= bs->front_pad;
 
-		mempool_free(p, bs->bio_pool);
+		if (!bio_cache_put(bs, p))
+			mempool_free(p, bs->bio_pool);
 	} else {
 		/* Bio was allocated by bio_kmalloc() */
 		kfree(bio);
@@ -473,7 +667,9 @@ struct bio *bio_alloc_bioset(gfp_t gfp_mask, int nr_iovecs, struct bio_set *bs)
 		     !bio_list_empty(&current->bio_list[1])))
 			gfp_mask &= ~__GFP_DIRECT_RECLAIM;
 
-		p = mempool_alloc(bs->bio_pool, gfp_mask);
+		p = bio_cache_get(bs);
+		if (!p)
+			p = mempool_alloc(bs->bio_pool, gfp_mask);
 		if (!p && gfp_mask != saved_gfp) {
 			punt_bios_to_rescuer(bs);
 			gfp_mask = saved_gfp;
@@ -2106,6 +2302,8 @@ static int __init init_bio(void)
 	if (bioset_integrity_create(fs_bio_set, BIO_POOL_SIZE))
 		panic("bio: can't create integrity pool\n");
 
+	bio_cache_init();
+
 	return 0;
 }
 subsys_initcall(init_bio);
@@ -0,0 +1,271 @@
+/*
+ * Foreground I/O boost
+ *
+ * While the user waits on the foreground, during an app launch or right
+ * after the screen turns on, I/O submitted by tasks of the top-app group
+ * is raised to the real time I/O priority class, which elevators looking
+ * at request priorities serve first. Background work that would compete
+ * with it is held back at the same time: periodic writeback is deferred,
+ * and users of blk_boost_register_notifier(), such as zram writeback,
+ * are told to stop until the boost ends.
+ *
+ * Boosts are started and stopped per reason, and the time spent with at
+ * least one of them active is accounted in /sys/kernel/blk_boost.
+ */
+#include <linux/kernel.h>
+#include <linux/bio.h>
+#include <linux/blk-boost.h>
+#include <linux/fb.h>
+#include <linux/init.h>
+#include <linux/ioprio.h>
+#include <linux/kobject.h>
+#include <linux/ktime.h>
+#include <linux/sched.h>
+#include <linux/spinlock.h>
+#include <linux/sysfs.h>
+#include <linux/workqueue.h>
+
+unsigned long blk_boost_reasons;
+
+static DEFINE_SPINLOCK(blk_boost_lock);
+static ATOMIC_NOTIFIER_HEAD(blk_boost_notifier);
+static struct delayed_work blk_boost_timeout[BLK_BOOST_NR_REASONS];
+
+static bool blk_boost_enable = true;
+static bool blk_boost_screen_is_off;
+static unsigned int blk_boost_screen_on_ms = 1000;
+/* a launch that userspace never reports finished does not boost forever */
+static unsigned int blk_boost_max_ms = 5000;
+
+/* accounting, protected by blk_boost_lock */
+static u64 blk_boost_start_ns;
+static u64 blk_boost_total_ns;
+static unsigned long blk_boost_count;
+static atomic_long_t blk_boost_bios = ATOMIC_LONG_INIT(0);
+
+void blk_boost_start(enum blk_boost_reason reason)
+{
+	unsigned long flags;
+	bool first;
+
+	spin_lock_irqsave(&blk_boost_lock, flags);
+	if (!blk_boost_enable || test_bit(reason, &blk_boost_reasons))
+		goto out;
+
+	first = !blk_boost_reasons;
+	set_bit(reason, &blk_boost_reasons);
+	if (first) {
+		blk_boost_start_ns = ktime_get_ns();
+		blk_boost_count++;
+		atomic_notifier_call_chain(&blk_boost_notifier, 1, NULL);
+	}
+out:
+	spin_unlock_irqrestore(&blk_boost_lock, flags);
+}
+EXPORT_SYMBOL_GPL(blk_boost_start);
+
+void blk_boost_stop(enum blk_boost_reason reason)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&blk_boost_lock, flags);
+	if (test_and_clear_bit(reason, &blk_boost_reasons) &&
+	    !blk_boost_reasons) {
+		blk_boost_total_ns += ktime_get_ns() - blk_boost_start_ns;
+		atomic_notifier_call_chain(&blk_boost_notifier, 0, NULL);
+	}
+	spin_unlock_irqrestore(&blk_boost_lock, flags);
+}
+EXPORT_SYMBOL_GPL(blk_boost_stop);
+
+/* boost for @ms, or extend a boost for the same reason to end in @ms */
+void blk_boost_kick(enum blk_boost_reason reason, unsigned int ms)
+{
+	blk_boost_start(reason);
+	mod_delayed_work(system_wq, &blk_boost_timeout[reason],
+			 msecs_to_jiffies(ms));
+}
+EXPORT_SYMBOL_GPL(blk_boost_kick);
+
+static void blk_boost_timeout_work(struct work_struct *work)
+{
+	blk_boost_stop(to_delayed_work(work) - blk_boost_timeout);
+}
+
+void __blk_boost_bio(struct bio *bio)
+{
+	/* priorities set on purpose, like idle zram writeback, are kept */
+	if (bio_prio_valid(bio) || !schedtune_task_top_app(current))
+		return;
+
+	bio_set_prio(bio, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_RT, 0));
+	atomic_long_inc(&blk_boost_bios);
+}
+
+/* for background work that would rather run while nobody is looking */
+bool blk_boost_screen_off(void)
+{
+	return READ_ONCE(blk_boost_screen_is_off);
+}
+EXPORT_SYMBOL_GPL(blk_boost_screen_off);
+
+int blk_boost_register_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&blk_boost_notifier, nb);
+}
+EXPORT_SYMBOL_GPL(blk_boost_register_notifier);
+
+int blk_boost_unregister_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&blk_boost_notifier, nb);
+}
+EXPORT_SYMBOL_GPL(blk_boost_unregister_notifier);
+
+static int blk_boost_app_launch_notifier(struct notifier_block *nb,
+					 unsigned long action, void *data)
+{
+	if (action)
+		blk_boost_kick(BLK_BOOST_APP_LAUNCH, blk_boost_max_ms);
+	else
+		blk_boost_stop(BLK_BOOST_APP_LAUNCH);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block blk_boost_app_launch_nb = {
+	.notifier_call = blk_boost_app_launch_notifier,
+};
+
+#ifdef CONFIG_FB
+static int blk_boost_fb_notifier(struct notifier_block *nb,
+				 unsigned long event, void *data)
+{
+	struct fb_event *evdata = data;
+	int blank;
+
+	if (event != FB_EVENT_BLANK || !evdata || !evdata->data)
+		return NOTIFY_OK;
+
+	blank = *(int *)evdata->data;
+	if (blank == FB_BLANK_UNBLANK) {
+		WRITE_ONCE(blk_boost_screen_is_off, false);
+		blk_boost_kick(BLK_BOOST_SCREEN_ON, blk_boost_screen_on_ms);
+	} else if (blank == FB_BLANK_POWERDOWN) {
+		WRITE_ONCE(blk_boost_screen_is_off, true);
+	}
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block blk_boost_fb_nb = {
+	.notifier_call = blk_boost_fb_notifier,
+};
+#endif
+
+/*
+ * sysfs parts below
+ */
+
+static ssize_t enable_show(struct kobject *kobj, struct kobj_attribute *attr,
+			   char *buf)
+{
+	return sprintf(buf, "%d\n", blk_boost_enable);
+}
+
+static ssize_t enable_store(struct kobject *kobj, struct kobj_attribute *attr,
+			    const char *buf, size_t count)
+{
+	int reason;
+	bool val;
+
+	if (strtobool(buf, &val))
+		return -EINVAL;
+
+	blk_boost_enable = val;
+	if (!val)
+		for (reason = 0; reason < BLK_BOOST_NR_REASONS; reason++)
+			blk_boost_stop(reason);
+
+	return count;
+}
+
+#define BLK_BOOST_MS_ATTR(_name, _var)					\
+static ssize_t _name##_show(struct kobject *kobj,			\
+			    struct kobj_attribute *attr, char *buf)	\
+{									\
+	return sprintf(buf, "%u\n", _var);				\
+}									\
+static ssize_t _name##_store(struct kobject *kobj,			\
+			     struct kobj_attribute *attr,		\
+			     const char *buf, size_t count)		\
+{									\
+	unsigned int val;						\
+									\
+	if (kstrtouint(buf, 10, &val))					\
+		return -EINVAL;						\
+	_var = val;							\
+	return count;							\
+}
+BLK_BOOST_MS_ATTR(screen_on_ms, blk_boost_screen_on_ms);
+BLK_BOOST_MS_ATTR(max_ms, blk_boost_max_ms);
+#undef BLK_BOOST_MS_ATTR
+
+/* active reasons, boosts so far, time boosted and bios boosted */
+static ssize_t stat_show(struct kobject *kobj, struct kobj_attribute *attr,
+			 char *buf)
+{
+	unsigned long reasons, count;
+	unsigned long flags;
+	u64 total;
+
+	spin_lock_irqsave(&blk_boost_lock, flags);
+	reasons = blk_boost_reasons;
+	count = blk_boost_count;
+	total = blk_boost_total_ns;
+	if (reasons)
+		total += ktime_get_ns() - blk_boost_start_ns;
+	spin_unlock_irqrestore(&blk_boost_lock, flags);
+
+	return sprintf(buf, "active: %#lx\nboosts: %lu\nboosted_ms: %llu\n"
+		       "bios: %ld\n", reasons, count,
+		       div_u64(total, NSEC_PER_MSEC),
+		       atomic_long_read(&blk_boost_bios));
+}
+
+static struct kobj_attribute enable_attr = __ATTR_RW(enable);
+static struct kobj_attribute screen_on_ms_attr = __ATTR_RW(screen_on_ms);
+static struct kobj_attribute max_ms_attr = __ATTR_RW(max_ms);
+static struct kobj_attribute stat_attr = __ATTR_RO(stat);
+
+static struct attribute *blk_boost_attrs[] = {
+	&enable_attr.attr,
+	&screen_on_ms_attr.attr,
+	&max_ms_attr.attr,
+	&stat_attr.attr,
+	NULL,
+};
+
+static struct attribute_group blk_boost_attr_group = {
+	.attrs = blk_boost_attrs,
+	.name = "blk_boost",
+};
+
+static int __init blk_boost_init(void)
+{
+	int reason;
+
+	for (reason = 0; reason < BLK_BOOST_NR_REASONS; reason++)
+		INIT_DELAYED_WORK(&blk_boost_timeout[reason],
+				  blk_boost_timeout_work);
+
+	if (sysfs_create_group(kernel_kobj, &blk_boost_attr_group))
+		pr_err("blk_boost: failed to create sysfs group\n");
+
+	am_app_launch_notifier_register(&blk_boost_app_launch_nb);
+#ifdef CONFIG_FB
+	fb_register_client(&blk_boost_fb_nb);
+#endif
+
+	return 0;
+}
+late_initcall(blk_boost_init);
@@ -1093,6 +1093,11 @@ int blkcg_init_queue(struct request_queue *q)
 	q->root_rl.blkg = blkg;
 
 	ret = blk_throtl_init(q);
+	if (!ret) {
+		ret = blk_iolatency_init(q);
+		if (ret)
+			blk_throtl_exit(q);
+	}
 	if (ret) {
 		spin_lock_irq(q->queue_lock);
 		blkg_destroy_all(q);
@@ -1133,6 +1138,7 @@ void blkcg_exit_queue(struct request_queue *q)
 	blkg_destroy_all(q);
 	spin_unlock_irq(q->queue_lock);
 
+	blk_iolatency_exit(q);
 	blk_throtl_exit(q);
 }
 
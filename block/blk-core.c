@@ -33,6 +33,10 @@
 #include <linux/ratelimit.h>
 #include <linux/pm_runtime.h>
 #include <linux/blk-cgroup.h>
+#include <linux/blk-boost.h>
+#include <linux/hrtimer.h>
+#include <linux/ioprio.h>
+#include <linux/sched/rt.h>
 
 #define CREATE_TRACE_POINTS
 #include <trace/events/block.h>
@@ -141,6 +145,7 @@ void blk_rq_init(struct request_queue *q, struct request *rq)
 	rq->start_time = jiffies;
 	set_start_time_ns(rq);
 	rq->part = NULL;
+	blk_lat_hist_alloc(rq);
 }
 EXPORT_SYMBOL(blk_rq_init);
 
@@ -1084,6 +1089,10 @@ static struct request *__get_request(struct request_list *rl, int rw_flags,
 	if (may_queue == ELV_MQUEUE_NO)
 		goto rq_starved;
 
+	/* the group is held back for a group with a latency target */
+	if (!blk_iolatency_may_queue(rl, is_sync))
+		return ERR_PTR(-ENOMEM);
+
 	if (rl->count[is_sync]+1 >= queue_congestion_on_threshold(q)) {
 		if (rl->count[is_sync]+1 >= q->nr_requests) {
 			/*
@@ -2147,6 +2156,8 @@ blk_qc_t submit_bio(int rw, struct bio *bio)
 	if (bio_has_data(bio)) {
 		unsigned int count;
 
+		blk_boost_bio(bio);
+
 		if (unlikely(rw & REQ_WRITE_SAME))
 			count = bdev_logical_block_size(bio->bi_bdev) >> 9;
 		else
@@ -2324,6 +2335,8 @@ void blk_account_io_completion(struct request *req, unsigned int bytes)
 
 void blk_account_io_done(struct request *req)
 {
+	blk_ra_done(req);
+
 	/*
 	 * Account IO completion.  flush_rq isn't accounted as a
 	 * normal IO on queueing nor completion.  Accounting the
@@ -2538,6 +2551,7 @@ void blk_dequeue_request(struct request *rq)
 		q->in_flight[rq_is_sync(rq)]++;
 		set_io_start_time_ns(rq);
 	}
+	blk_ra_start(rq);
 }
 
 /**
@@ -2568,6 +2582,7 @@ void blk_start_request(struct request *req)
 
 	BUG_ON(test_bit(REQ_ATOM_COMPLETE, &req->atomic_flags));
 	blk_add_timer(req);
+	blk_lat_hist_issue(req);
 }
 EXPORT_SYMBOL(blk_start_request);
 
@@ -2791,6 +2806,8 @@ void blk_finish_request(struct request *req, int error)
 		blk_unprep_request(req);
 
 	blk_account_io_done(req);
+	blk_iolatency_done(req);
+	blk_lat_hist_done(req);
 
 	if (req->end_io)
 		req->end_io(req, error);
@@ -3372,23 +3389,80 @@ void blk_finish_plug(struct blk_plug *plug)
 }
 EXPORT_SYMBOL(blk_finish_plug);
 
+/*
+ * Spinning is only worth its CPU time for reads a latency sensitive task
+ * is waiting on, like the foreground faulting in code.
+ */
+static bool blk_poll_wanted(struct request *rq)
+{
+	if (rq->cmd_type != REQ_TYPE_FS || rq_data_dir(rq) != READ)
+		return false;
+
+	return rt_task(current) ||
+	       IOPRIO_PRIO_CLASS(req_get_ioprio(rq)) == IOPRIO_CLASS_RT;
+}
+
+/*
+ * Sleep through the part of the request the device is certain to take,
+ * once per request. Returns true if we slept, the caller then rechecks
+ * whether it is done before polling again.
+ */
+static bool blk_poll_hybrid_sleep(struct request_queue *q,
+				  struct blk_mq_hw_ctx *hctx,
+				  struct request *rq)
+{
+	struct hrtimer_sleeper hs;
+	u64 nsecs;
+
+	if (q->poll_nsec < 0 ||
+	    test_and_set_bit(REQ_ATOM_POLL_SLEPT, &rq->atomic_flags))
+		return false;
+
+	nsecs = q->poll_nsec ?: READ_ONCE(q->poll_mean_ns) / 2;
+	if (!nsecs)
+		return false;
+
+	hctx->poll_sleep++;
+
+	/* the caller set our state, a completion wakes us up early */
+	hrtimer_init_on_stack(&hs.timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	hrtimer_set_expires(&hs.timer, ns_to_ktime(nsecs));
+	hrtimer_init_sleeper(&hs, current);
+	hrtimer_start_expires(&hs.timer, HRTIMER_MODE_REL);
+	if (hs.task)
+		io_schedule();
+	hrtimer_cancel(&hs.timer);
+	destroy_hrtimer_on_stack(&hs.timer);
+
+	__set_current_state(TASK_RUNNING);
+	return true;
+}
+
 bool blk_poll(struct request_queue *q, blk_qc_t cookie)
 {
+	struct blk_mq_hw_ctx *hctx;
 	struct blk_plug *plug;
+	struct request *rq;
 	long state;
 
 	if (!q->mq_ops || !q->mq_ops->poll || !blk_qc_t_valid(cookie) ||
 	    !test_bit(QUEUE_FLAG_POLL, &q->queue_flags))
 		return false;
 
+	hctx = q->queue_hw_ctx[blk_qc_t_to_queue_num(cookie)];
+	rq = blk_mq_tag_to_rq(hctx->tags, blk_qc_t_to_tag(cookie));
+	if (!blk_poll_wanted(rq))
+		return false;
+
 	plug = current->plug;
 	if (plug)
 		blk_flush_plug_list(plug, false);
 
+	if (blk_poll_hybrid_sleep(q, hctx, rq))
+		return true;
+
 	state = current->state;
 	while (!need_resched()) {
-		unsigned int queue_num = blk_qc_t_to_queue_num(cookie);
-		struct blk_mq_hw_ctx *hctx = q->queue_hw_ctx[queue_num];
 		int ret;
 
 		hctx->poll_invoked++;
@@ -3410,6 +3484,7 @@ bool blk_poll(struct request_queue *q, blk_qc_t cookie)
 		cpu_relax();
 	}
 
+	hctx->poll_irq++;
 	return false;
 }
 
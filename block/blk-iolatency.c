@@ -0,0 +1,314 @@
+/*
+ * Latency target controller for blkio cgroups
+ *
+ * A group given a latency target on a device is protected: the completion
+ * latency of its requests, from allocation to completion, is averaged over
+ * windows of a few multiples of the target. When the average of a window
+ * exceeds the target, every other group on the queue that has no target,
+ * or a looser one, and that is not an ancestor of the protected group, has
+ * the number of requests it may allocate in each direction halved. The
+ * throttled groups get their depth doubled back each quiet window, until
+ * it reaches the queue's nr_requests and the limit is dropped.
+ *
+ * This works on the legacy request queue, where each group allocates from
+ * its own request_list, by refusing allocations over the limit. Allocators
+ * then sleep on the request_list just like on a full queue, and are woken
+ * up again as the group's own requests complete.
+ */
+
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/blkdev.h>
+#include <linux/blk-cgroup.h>
+#include <linux/ktime.h>
+#include "blk.h"
+
+/* Windows are 16 targets long, within these bounds */
+#define IOLAT_WIN_MIN_NS	(100 * NSEC_PER_MSEC)
+#define IOLAT_WIN_MAX_NS	NSEC_PER_SEC
+/* Too few samples to judge a window by */
+#define IOLAT_MIN_SAMPLES	4
+
+static struct blkcg_policy blkcg_policy_iolatency;
+
+struct iolat_grp {
+	/* must be the first member */
+	struct blkg_policy_data pd;
+
+	/* latency target, 0 when the group is not protected */
+	u64 target_ns;
+
+	/* current window of a protected group */
+	u64 win_start_ns;
+	u64 win_lat_ns;
+	unsigned int win_nr;
+	u64 last_avg_ns;
+	unsigned long nr_missed;
+
+	/* allowed requests per direction, 0 when not throttled */
+	unsigned int depth;
+	u64 throttle_ns;
+	u64 relax_ns;
+	unsigned long nr_throttled;
+};
+
+static inline struct iolat_grp *pd_to_iolat(struct blkg_policy_data *pd)
+{
+	return pd ? container_of(pd, struct iolat_grp, pd) : NULL;
+}
+
+static inline struct iolat_grp *blkg_to_iolat(struct blkcg_gq *blkg)
+{
+	return pd_to_iolat(blkg_to_pd(blkg, &blkcg_policy_iolatency));
+}
+
+static inline struct blkcg_gq *iolat_to_blkg(struct iolat_grp *iolat)
+{
+	return pd_to_blkg(&iolat->pd);
+}
+
+static u64 iolat_window(struct iolat_grp *iolat)
+{
+	return clamp_t(u64, iolat->target_ns * 16, IOLAT_WIN_MIN_NS,
+		       IOLAT_WIN_MAX_NS);
+}
+
+static struct request_list *iolat_rl(struct blkcg_gq *blkg)
+{
+	return blkg == blkg->q->root_blkg ? &blkg->q->root_rl : &blkg->rl;
+}
+
+/* give back depth to a throttled group after each quiet window */
+static void iolat_relax(struct iolat_grp *iolat, u64 now)
+{
+	struct request_queue *q = iolat_to_blkg(iolat)->q;
+
+	if (!iolat->depth || now - iolat->throttle_ns < iolat->relax_ns)
+		return;
+
+	iolat->depth *= 2;
+	if (iolat->depth >= q->nr_requests)
+		iolat->depth = 0;
+	iolat->throttle_ns = now;
+}
+
+static void iolat_throttle(struct iolat_grp *iolat, u64 now, u64 relax_ns)
+{
+	struct request_list *rl = iolat_rl(iolat_to_blkg(iolat));
+	unsigned int depth = iolat->depth;
+
+	/* start from what the group has allocated, so it bites right away */
+	if (!depth)
+		depth = max(rl->count[BLK_RW_SYNC], rl->count[BLK_RW_ASYNC]);
+
+	iolat->depth = max(depth / 2, 1U);
+	iolat->throttle_ns = now;
+	iolat->relax_ns = max(iolat->relax_ns, relax_ns);
+	iolat->nr_throttled++;
+}
+
+/* @prot missed its target, throttle the groups competing with it */
+static void iolat_throttle_siblings(struct iolat_grp *prot, u64 now)
+{
+	struct blkcg_gq *pblkg = iolat_to_blkg(prot);
+	struct blkcg_gq *blkg;
+	u64 relax_ns = iolat_window(prot);
+
+	list_for_each_entry(blkg, &pblkg->q->blkg_list, q_node) {
+		struct iolat_grp *iolat = blkg_to_iolat(blkg);
+
+		if (!iolat || iolat == prot)
+			continue;
+		if (iolat->target_ns && iolat->target_ns <= prot->target_ns)
+			continue;
+		if (cgroup_is_descendant(pblkg->blkcg->css.cgroup,
+					 blkg->blkcg->css.cgroup))
+			continue;
+
+		iolat_throttle(iolat, now, relax_ns);
+	}
+}
+
+/**
+ * blk_iolatency_may_queue - check a group's depth before allocating
+ * @rl: request_list the request is allocated from
+ * @sync: direction of the request
+ *
+ * Called with the queue lock held from __get_request().
+ */
+bool blk_iolatency_may_queue(struct request_list *rl, int sync)
+{
+	struct iolat_grp *iolat = blkg_to_iolat(rl->blkg);
+
+	if (!iolat || !iolat->depth)
+		return true;
+
+	iolat_relax(iolat, ktime_get_ns());
+	return !iolat->depth || rl->count[sync] < iolat->depth;
+}
+
+/**
+ * blk_iolatency_done - account the latency of a completed request
+ * @rq: request being completed
+ *
+ * Called with the queue lock held from blk_finish_request().
+ */
+void blk_iolatency_done(struct request *rq)
+{
+	struct iolat_grp *iolat;
+	u64 now, avg;
+
+	if (rq->cmd_type != REQ_TYPE_FS || !(rq->cmd_flags & REQ_ALLOCED))
+		return;
+
+	iolat = blkg_to_iolat(blk_rq_rl(rq)->blkg);
+	if (!iolat)
+		return;
+
+	now = ktime_get_ns();
+	iolat_relax(iolat, now);
+	if (!iolat->target_ns)
+		return;
+
+	if (now > rq_start_time_ns(rq)) {
+		iolat->win_lat_ns += now - rq_start_time_ns(rq);
+		iolat->win_nr++;
+	}
+
+	if (now - iolat->win_start_ns < iolat_window(iolat))
+		return;
+
+	if (iolat->win_nr >= IOLAT_MIN_SAMPLES) {
+		avg = div_u64(iolat->win_lat_ns, iolat->win_nr);
+		iolat->last_avg_ns = avg;
+		if (avg > iolat->target_ns) {
+			iolat->nr_missed++;
+			iolat_throttle_siblings(iolat, now);
+		}
+	}
+
+	iolat->win_start_ns = now;
+	iolat->win_lat_ns = 0;
+	iolat->win_nr = 0;
+}
+
+static struct blkg_policy_data *iolat_pd_alloc(gfp_t gfp, int node)
+{
+	struct iolat_grp *iolat;
+
+	iolat = kzalloc_node(sizeof(*iolat), gfp, node);
+	if (!iolat)
+		return NULL;
+
+	return &iolat->pd;
+}
+
+static void iolat_pd_free(struct blkg_policy_data *pd)
+{
+	kfree(pd_to_iolat(pd));
+}
+
+static u64 iolat_prfill_target(struct seq_file *sf,
+			       struct blkg_policy_data *pd, int off)
+{
+	struct iolat_grp *iolat = pd_to_iolat(pd);
+
+	if (!iolat->target_ns)
+		return 0;
+	return __blkg_prfill_u64(sf, pd, div_u64(iolat->target_ns,
+						 NSEC_PER_USEC));
+}
+
+static int iolat_print_target(struct seq_file *sf, void *v)
+{
+	blkcg_print_blkgs(sf, css_to_blkcg(seq_css(sf)), iolat_prfill_target,
+			  &blkcg_policy_iolatency, 0, false);
+	return 0;
+}
+
+static ssize_t iolat_set_target(struct kernfs_open_file *of,
+				char *buf, size_t nbytes, loff_t off)
+{
+	struct blkcg *blkcg = css_to_blkcg(of_css(of));
+	struct blkg_conf_ctx ctx;
+	struct iolat_grp *iolat;
+	int ret;
+	u64 v;
+
+	ret = blkg_conf_prep(blkcg, &blkcg_policy_iolatency, buf, &ctx);
+	if (ret)
+		return ret;
+
+	ret = -EINVAL;
+	if (sscanf(ctx.body, "%llu", &v) != 1)
+		goto out_finish;
+
+	iolat = blkg_to_iolat(ctx.blkg);
+	iolat->target_ns = v * NSEC_PER_USEC;
+	iolat->win_start_ns = ktime_get_ns();
+	iolat->win_lat_ns = 0;
+	iolat->win_nr = 0;
+	ret = 0;
+out_finish:
+	blkg_conf_finish(&ctx);
+	return ret ?: nbytes;
+}
+
+static u64 iolat_prfill_stat(struct seq_file *sf,
+			     struct blkg_policy_data *pd, int off)
+{
+	struct iolat_grp *iolat = pd_to_iolat(pd);
+	const char *dname = blkg_dev_name(pd->blkg);
+
+	if (!dname)
+		return 0;
+
+	seq_printf(sf, "%s avg_lat_us=%llu missed=%lu depth=%u throttled=%lu\n",
+		   dname, div_u64(iolat->last_avg_ns, NSEC_PER_USEC),
+		   iolat->nr_missed, iolat->depth, iolat->nr_throttled);
+	return 0;
+}
+
+static int iolat_print_stat(struct seq_file *sf, void *v)
+{
+	blkcg_print_blkgs(sf, css_to_blkcg(seq_css(sf)), iolat_prfill_stat,
+			  &blkcg_policy_iolatency, 0, false);
+	return 0;
+}
+
+static struct cftype iolat_legacy_files[] = {
+	{
+		.name = "latency.target_us",
+		.seq_show = iolat_print_target,
+		.write = iolat_set_target,
+	},
+	{
+		.name = "latency.stat",
+		.seq_show = iolat_print_stat,
+	},
+	{ }	/* terminate */
+};
+
+static struct blkcg_policy blkcg_policy_iolatency = {
+	.legacy_cftypes		= iolat_legacy_files,
+
+	.pd_alloc_fn		= iolat_pd_alloc,
+	.pd_free_fn		= iolat_pd_free,
+};
+
+int blk_iolatency_init(struct request_queue *q)
+{
+	return blkcg_activate_policy(q, &blkcg_policy_iolatency);
+}
+
+void blk_iolatency_exit(struct request_queue *q)
+{
+	blkcg_deactivate_policy(q, &blkcg_policy_iolatency);
+}
+
+static int __init iolatency_init(void)
+{
+	return blkcg_policy_register(&blkcg_policy_iolatency);
+}
+
+module_init(iolatency_init);
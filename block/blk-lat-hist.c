@@ -0,0 +1,185 @@
+/*
+ * Per-queue request latency breakdown
+ *
+ * Requests are stamped when they are allocated, inserted into the
+ * elevator, moved to the dispatch list and started by the driver. At
+ * completion the time spent in each of these stages is accounted in log2
+ * histograms of microseconds, per queue and per operation, and exposed in
+ * /sys/block/<dev>/queue/latency_hist:
+ *
+ *   queue	allocation to insertion, mostly time spent plugged
+ *   elevator	insertion to dispatch
+ *   driver	dispatch to the driver starting the request
+ *   device	start to completion
+ *
+ * Writing 1 to the file enables the breakdown, 0 disables it and 2 clears
+ * the histograms. With no queue enabled the hooks are a static branch.
+ *
+ * Updates are done without locks or atomics, blk-mq completes on several
+ * CPUs at once and a count may occasionally be lost.
+ */
+#include <linux/kernel.h>
+#include <linux/blkdev.h>
+#include <linux/jump_label.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/slab.h>
+
+#include "blk.h"
+
+DEFINE_STATIC_KEY_FALSE(blk_lat_hist_key);
+
+static const char * const blk_lat_op_name[BLK_LAT_NR_OPS] = {
+	[BLK_LAT_READ]		= "read",
+	[BLK_LAT_WRITE]		= "write",
+	[BLK_LAT_FLUSH]		= "flush",
+	[BLK_LAT_DISCARD]	= "discard",
+};
+
+static const char * const blk_lat_stage_name[BLK_LAT_NR_STAGES] = {
+	[BLK_LAT_QUEUE]		= "queue",
+	[BLK_LAT_ELEVATOR]	= "elevator",
+	[BLK_LAT_DRIVER]	= "driver",
+	[BLK_LAT_DEVICE]	= "device",
+};
+
+static enum blk_lat_op blk_lat_op(struct request *rq)
+{
+	if (rq->cmd_flags & REQ_DISCARD)
+		return BLK_LAT_DISCARD;
+	if ((rq->cmd_flags & REQ_FLUSH) && !blk_rq_bytes(rq))
+		return BLK_LAT_FLUSH;
+	return rq_data_dir(rq) == READ ? BLK_LAT_READ : BLK_LAT_WRITE;
+}
+
+static void blk_lat_hist_add(unsigned long *hist, u64 from, u64 to)
+{
+	u64 us;
+
+	if (!from || to < from)
+		return;
+
+	us = div_u64(to - from, NSEC_PER_USEC);
+	hist[us ? min_t(int, ilog2(us) + 1, BLK_LAT_BUCKETS - 1) : 0]++;
+}
+
+void __blk_lat_hist_done(struct request *rq)
+{
+	struct blk_lat_hist *lh = rq->q->lat_hist;
+	struct blk_lat_op_hist *oh;
+	u64 now, dispatch;
+
+	if (rq->cmd_type != REQ_TYPE_FS || !rq->lat_issue_ns)
+		return;
+
+	now = ktime_get_ns();
+	oh = &lh->op[blk_lat_op(rq)];
+	oh->nr++;
+
+	/* requests inserted straight onto the dispatch list skip a stage */
+	dispatch = rq->lat_dispatch_ns ?: rq->lat_issue_ns;
+
+	blk_lat_hist_add(oh->hist[BLK_LAT_QUEUE], rq->lat_alloc_ns,
+			 rq->lat_insert_ns ?: dispatch);
+	if (rq->lat_insert_ns)
+		blk_lat_hist_add(oh->hist[BLK_LAT_ELEVATOR], rq->lat_insert_ns,
+				 dispatch);
+	blk_lat_hist_add(oh->hist[BLK_LAT_DRIVER], dispatch, rq->lat_issue_ns);
+	blk_lat_hist_add(oh->hist[BLK_LAT_DEVICE], rq->lat_issue_ns, now);
+
+	rq->lat_issue_ns = 0;
+}
+
+ssize_t blk_lat_hist_show(struct request_queue *q, char *page)
+{
+	struct blk_lat_hist *lh = q->lat_hist;
+	ssize_t len;
+	int op, stage, i;
+
+	len = scnprintf(page, PAGE_SIZE, "enabled: %d\n", lh && lh->enabled);
+	if (!lh)
+		return len;
+
+	len += scnprintf(page + len, PAGE_SIZE - len, "%-8s %-9s", "op", "<us");
+	for (i = 0; i < BLK_LAT_BUCKETS - 1; i++)
+		len += scnprintf(page + len, PAGE_SIZE - len, " %7lu",
+				 1UL << i);
+	len += scnprintf(page + len, PAGE_SIZE - len, " %7s\n", "more");
+
+	for (op = 0; op < BLK_LAT_NR_OPS; op++) {
+		struct blk_lat_op_hist *oh = &lh->op[op];
+
+		if (!oh->nr)
+			continue;
+
+		for (stage = 0; stage < BLK_LAT_NR_STAGES; stage++) {
+			len += scnprintf(page + len, PAGE_SIZE - len,
+					 "%-8s %-9s", blk_lat_op_name[op],
+					 blk_lat_stage_name[stage]);
+			for (i = 0; i < BLK_LAT_BUCKETS; i++)
+				len += scnprintf(page + len, PAGE_SIZE - len,
+						 " %7lu", oh->hist[stage][i]);
+			len += scnprintf(page + len, PAGE_SIZE - len, "\n");
+		}
+	}
+
+	return len;
+}
+
+ssize_t blk_lat_hist_store(struct request_queue *q, const char *page,
+			   size_t count)
+{
+	struct blk_lat_hist *lh;
+	ssize_t ret = count;
+	int val;
+
+	if (kstrtoint(page, 10, &val))
+		return -EINVAL;
+
+	/* serialized by q->sysfs_lock, held by queue_attr_store() */
+	lh = q->lat_hist;
+	switch (val) {
+	case BLK_IO_LAT_HIST_ENABLE:
+		if (!lh) {
+			/* kept until the queue goes, requests may point at it */
+			lh = kzalloc_node(sizeof(*lh), GFP_KERNEL, q->node);
+			if (!lh) {
+				ret = -ENOMEM;
+				break;
+			}
+			q->lat_hist = lh;
+		}
+		if (!lh->enabled) {
+			static_branch_inc(&blk_lat_hist_key);
+			WRITE_ONCE(lh->enabled, true);
+		}
+		break;
+	case BLK_IO_LAT_HIST_DISABLE:
+		if (lh && lh->enabled) {
+			WRITE_ONCE(lh->enabled, false);
+			static_branch_dec(&blk_lat_hist_key);
+		}
+		break;
+	case BLK_IO_LAT_HIST_ZERO:
+		if (lh)
+			memset(lh->op, 0, sizeof(lh->op));
+		break;
+	default:
+		ret = -EINVAL;
+	}
+
+	return ret;
+}
+
+void blk_lat_hist_exit(struct request_queue *q)
+{
+	struct blk_lat_hist *lh = q->lat_hist;
+
+	if (!lh)
+		return;
+
+	if (lh->enabled)
+		static_branch_dec(&blk_lat_hist_key);
+	q->lat_hist = NULL;
+	kfree(lh);
+}
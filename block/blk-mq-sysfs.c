@@ -176,7 +176,9 @@ static ssize_t blk_mq_sysfs_rq_list_show(struct blk_mq_ctx *ctx, char *page)
 
 static ssize_t blk_mq_hw_sysfs_poll_show(struct blk_mq_hw_ctx *hctx, char *page)
 {
-	return sprintf(page, "invoked=%lu, success=%lu\n", hctx->poll_invoked, hctx->poll_success);
+	return sprintf(page, "invoked=%lu, success=%lu, sleep=%lu, irq=%lu, mean_ns=%llu\n",
+		       hctx->poll_invoked, hctx->poll_success, hctx->poll_sleep,
+		       hctx->poll_irq, READ_ONCE(hctx->queue->poll_mean_ns));
 }
 
 static ssize_t blk_mq_hw_sysfs_queued_show(struct blk_mq_hw_ctx *hctx,
@@ -168,6 +168,7 @@ static void blk_mq_rq_ctx_init(struct request_queue *q, struct blk_mq_ctx *ctx,
 	/* csd/requeue_work/fifo_time is initialized before use */
 	rq->q = q;
 	rq->mq_ctx = ctx;
+	blk_lat_hist_alloc(rq);
 	rq->cmd_flags |= rw_flags;
 	/* do not touch atomic flags, it needs atomic ops against the timer */
 	rq->cpu = -1;
@@ -282,6 +283,7 @@ static void __blk_mq_free_request(struct blk_mq_hw_ctx *hctx,
 	rq->cmd_flags = 0;
 
 	clear_bit(REQ_ATOM_STARTED, &rq->atomic_flags);
+	clear_bit(REQ_ATOM_POLL_SLEPT, &rq->atomic_flags);
 	blk_mq_put_tag(hctx, tag, &ctx->last_tag);
 	blk_queue_exit(q);
 }
@@ -306,10 +308,29 @@ void blk_mq_free_request(struct request *rq)
 }
 EXPORT_SYMBOL_GPL(blk_mq_free_request);
 
+/* running mean of read completion times, for hybrid polling */
+static void blk_mq_poll_stat_add(struct request *rq)
+{
+	struct request_queue *q = rq->q;
+	u64 now = ktime_get_ns(), mean;
+
+	if (now <= rq->poll_start_ns)
+		return;
+
+	mean = READ_ONCE(q->poll_mean_ns);
+	mean = mean - (mean >> 3) + ((now - rq->poll_start_ns) >> 3);
+	WRITE_ONCE(q->poll_mean_ns, mean);
+}
+
 inline void __blk_mq_end_request(struct request *rq, int error)
 {
 	blk_account_io_done(rq);
 
+	if (rq->cmd_type == REQ_TYPE_FS && rq_data_dir(rq) == READ &&
+	    test_bit(QUEUE_FLAG_POLL, &rq->q->queue_flags))
+		blk_mq_poll_stat_add(rq);
+	blk_lat_hist_done(rq);
+
 	if (rq->end_io) {
 		rq->end_io(rq, error);
 	} else {
@@ -425,6 +446,11 @@ void blk_mq_start_request(struct request *rq)
 	rq->resid_len = blk_rq_bytes(rq);
 	if (unlikely(blk_bidi_rq(rq)))
 		rq->next_rq->resid_len = blk_rq_bytes(rq->next_rq);
+	blk_ra_start(rq);
+
+	if (test_bit(QUEUE_FLAG_POLL, &q->queue_flags))
+		rq->poll_start_ns = ktime_get_ns();
+	blk_lat_hist_issue(rq);
 
 	blk_add_timer(rq);
 
@@ -1016,6 +1042,7 @@ static inline void __blk_mq_insert_req_list(struct blk_mq_hw_ctx *hctx,
 					    bool at_head)
 {
 	trace_block_rq_insert(hctx->queue, rq);
+	blk_lat_hist_insert(rq);
 
 	if (at_head)
 		list_add(&rq->queuelist, &ctx->rq_list);
@@ -9,10 +9,17 @@
 #include <linux/interrupt.h>
 #include <linux/cpu.h>
 #include <linux/sched.h>
+#include <linux/llist.h>
+#include <linux/topology.h>
 
 #include "blk.h"
 
 static DEFINE_PER_CPU(struct list_head, blk_cpu_done);
+#ifdef CONFIG_SMP
+/* completions handed over by other clusters, and the IPI kicking them */
+static DEFINE_PER_CPU(struct llist_head, blk_cpu_remote);
+static DEFINE_PER_CPU(struct call_single_data, blk_cpu_remote_csd);
+#endif
 
 /*
  * Softirq action handler - move entries to local list and loop over them
@@ -69,11 +76,86 @@ static int raise_blk_irq(int cpu, struct request *rq)
 
 	return 1;
 }
+
+/* move the requests handed over by other clusters to the done list */
+static void blk_splice_remote(struct llist_head *remote)
+{
+	struct list_head *list = this_cpu_ptr(&blk_cpu_done);
+	struct llist_node *entry;
+	struct request *rq, *next;
+	bool empty = list_empty(list);
+
+	entry = llist_reverse_order(llist_del_all(remote));
+	llist_for_each_entry_safe(rq, next, entry, csd.llist)
+		list_add_tail(&rq->ipi_list, list);
+
+	if (empty && !list_empty(list))
+		raise_softirq_irqoff(BLOCK_SOFTIRQ);
+}
+
+static void trigger_remote_softirq(void *data)
+{
+	blk_splice_remote(this_cpu_ptr(&blk_cpu_remote));
+	preempt_check_resched_rt();
+}
+
+/*
+ * Pick a busy CPU of the cluster @req was submitted on. An idle submitter
+ * is still woken up by the completion, but busy siblings avoid paying for
+ * the idle exit twice.
+ */
+static int blk_cluster_cpu(struct request *req)
+{
+	int cpu;
+
+	if (!idle_cpu(req->cpu))
+		return req->cpu;
+
+	for_each_cpu_and(cpu, topology_core_cpumask(req->cpu), cpu_online_mask)
+		if (!idle_cpu(cpu))
+			return cpu;
+
+	return -1;
+}
+
+/*
+ * Queue @req on @cpu. Only the first request queued since @cpu last ran
+ * its list sends an IPI, the ones following it ride along.
+ */
+static int raise_blk_cluster_irq(int cpu, struct request *req)
+{
+	struct request_queue *q = req->q;
+
+	if (!cpu_online(cpu))
+		return 1;
+
+	atomic_long_inc(&q->nr_cluster_comps);
+	if (llist_add(&req->csd.llist, &per_cpu(blk_cpu_remote, cpu))) {
+		struct call_single_data *data = &per_cpu(blk_cpu_remote_csd, cpu);
+
+		data->func = trigger_remote_softirq;
+		data->info = NULL;
+		atomic_long_inc(&q->nr_cluster_ipis);
+		smp_call_function_single_async(cpu, data);
+	}
+
+	return 0;
+}
 #else /* CONFIG_SMP */
 static int raise_blk_irq(int cpu, struct request *rq)
 {
 	return 1;
 }
+
+static int blk_cluster_cpu(struct request *req)
+{
+	return -1;
+}
+
+static int raise_blk_cluster_irq(int cpu, struct request *rq)
+{
+	return 1;
+}
 #endif
 
 static int blk_cpu_notify(struct notifier_block *self, unsigned long action,
@@ -89,6 +171,9 @@ static int blk_cpu_notify(struct notifier_block *self, unsigned long action,
 		local_irq_disable();
 		list_splice_init(&per_cpu(blk_cpu_done, cpu),
 				 this_cpu_ptr(&blk_cpu_done));
+#ifdef CONFIG_SMP
+		blk_splice_remote(&per_cpu(blk_cpu_remote, cpu));
+#endif
 		raise_softirq_irqoff(BLOCK_SOFTIRQ);
 		local_irq_enable();
 		preempt_check_resched_rt();
@@ -112,6 +197,19 @@ void __blk_complete_request(struct request *req)
 	local_irq_save(flags);
 	cpu = get_cpu();
 
+	/*
+	 * Cluster mode: stay local within the submitter's cluster, otherwise
+	 * batch the completion onto a busy CPU of that cluster.
+	 */
+	if (test_bit(QUEUE_FLAG_SAME_CLUSTER, &q->queue_flags) &&
+	    req->cpu != -1 && !cpus_share_cache(cpu, req->cpu)) {
+		ccpu = blk_cluster_cpu(req);
+		if (ccpu != -1 && !raise_blk_cluster_irq(ccpu, req))
+			goto out;
+		ccpu = cpu;
+		goto do_local;
+	}
+
 	/*
 	 * Select completion CPU
 	 *
@@ -151,7 +249,7 @@ do_local:
 			raise_softirq_irqoff(BLOCK_SOFTIRQ);
 	} else if (raise_blk_irq(ccpu, req))
 		goto do_local;
-
+out:
 	put_cpu();
 	preempt_check_resched_rt();
 	local_irq_restore(flags);
@@ -283,6 +283,8 @@ static ssize_t queue_rq_affinity_show(struct request_queue *q, char *page)
 	bool set = test_bit(QUEUE_FLAG_SAME_COMP, &q->queue_flags);
 	bool force = test_bit(QUEUE_FLAG_SAME_FORCE, &q->queue_flags);
 
+	if (test_bit(QUEUE_FLAG_SAME_CLUSTER, &q->queue_flags))
+		return queue_var_show(3, page);
 	return queue_var_show(set << force, page);
 }
 
@@ -298,6 +300,13 @@ queue_rq_affinity_store(struct request_queue *q, const char *page, size_t count)
 		return ret;
 
 	spin_lock_irq(q->queue_lock);
+	if (val == 3) {
+		queue_flag_set(QUEUE_FLAG_SAME_COMP, q);
+		queue_flag_clear(QUEUE_FLAG_SAME_FORCE, q);
+		queue_flag_set(QUEUE_FLAG_SAME_CLUSTER, q);
+	} else
+		queue_flag_clear(QUEUE_FLAG_SAME_CLUSTER, q);
+
 	if (val == 2) {
 		queue_flag_set(QUEUE_FLAG_SAME_COMP, q);
 		queue_flag_set(QUEUE_FLAG_SAME_FORCE, q);
@@ -313,6 +322,16 @@ queue_rq_affinity_store(struct request_queue *q, const char *page, size_t count)
 	return ret;
 }
 
+static ssize_t queue_rq_affinity_stat_show(struct request_queue *q, char *page)
+{
+#ifdef CONFIG_SMP
+	return sprintf(page, "%ld %ld\n", atomic_long_read(&q->nr_cluster_comps),
+		       atomic_long_read(&q->nr_cluster_ipis));
+#else
+	return sprintf(page, "0 0\n");
+#endif
+}
+
 static ssize_t queue_poll_show(struct request_queue *q, char *page)
 {
 	return queue_var_show(test_bit(QUEUE_FLAG_POLL, &q->queue_flags), page);
@@ -341,6 +360,29 @@ static ssize_t queue_poll_store(struct request_queue *q, const char *page,
 	return ret;
 }
 
+static ssize_t queue_poll_delay_show(struct request_queue *q, char *page)
+{
+	if (q->poll_nsec < 0)
+		return sprintf(page, "-1\n");
+
+	return sprintf(page, "%d\n", q->poll_nsec / NSEC_PER_USEC);
+}
+
+static ssize_t queue_poll_delay_store(struct request_queue *q, const char *page,
+				      size_t count)
+{
+	int val;
+
+	if (!q->mq_ops || !q->mq_ops->poll)
+		return -EINVAL;
+
+	if (kstrtoint(page, 10, &val) || val < -1 || val > USEC_PER_SEC)
+		return -EINVAL;
+
+	q->poll_nsec = val < 0 ? -1 : val * NSEC_PER_USEC;
+	return count;
+}
+
 static struct queue_sysfs_entry queue_requests_entry = {
 	.attr = {.name = "nr_requests", .mode = S_IRUGO | S_IWUSR },
 	.show = queue_requests_show,
@@ -454,6 +496,11 @@ static struct queue_sysfs_entry queue_rq_affinity_entry = {
 	.store = queue_rq_affinity_store,
 };
 
+static struct queue_sysfs_entry queue_rq_affinity_stat_entry = {
+	.attr = {.name = "rq_affinity_stat", .mode = S_IRUGO },
+	.show = queue_rq_affinity_stat_show,
+};
+
 static struct queue_sysfs_entry queue_iostats_entry = {
 	.attr = {.name = "iostats", .mode = S_IRUGO | S_IWUSR },
 	.show = queue_show_iostats,
@@ -472,6 +519,20 @@ static struct queue_sysfs_entry queue_poll_entry = {
 	.store = queue_poll_store,
 };
 
+#ifdef CONFIG_BLK_LATENCY_HIST
+static struct queue_sysfs_entry queue_latency_hist_entry = {
+	.attr = {.name = "latency_hist", .mode = S_IRUGO | S_IWUSR },
+	.show = blk_lat_hist_show,
+	.store = blk_lat_hist_store,
+};
+#endif
+
+static struct queue_sysfs_entry queue_poll_delay_entry = {
+	.attr = {.name = "io_poll_delay", .mode = S_IRUGO | S_IWUSR },
+	.show = queue_poll_delay_show,
+	.store = queue_poll_delay_store,
+};
+
 static struct attribute *default_attrs[] = {
 	&queue_requests_entry.attr,
 	&queue_ra_entry.attr,
@@ -494,9 +555,14 @@ static struct attribute *default_attrs[] = {
 	&queue_nonrot_entry.attr,
 	&queue_nomerges_entry.attr,
 	&queue_rq_affinity_entry.attr,
+	&queue_rq_affinity_stat_entry.attr,
 	&queue_iostats_entry.attr,
 	&queue_random_entry.attr,
 	&queue_poll_entry.attr,
+	&queue_poll_delay_entry.attr,
+#ifdef CONFIG_BLK_LATENCY_HIST
+	&queue_latency_hist_entry.attr,
+#endif
 	NULL,
 };
 
@@ -592,6 +658,7 @@ static void blk_release_queue(struct kobject *kobj)
 		blk_mq_release(q);
 
 	blk_trace_shutdown(q);
+	blk_lat_hist_exit(q);
 
 	if (q->bio_split)
 		bioset_free(q->bio_split);
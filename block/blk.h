@@ -2,6 +2,7 @@
 #define BLK_INTERNAL_H
 
 #include <linux/idr.h>
+#include <linux/jump_label.h>
 #include <linux/blk-mq.h>
 #include "blk-mq.h"
 
@@ -119,6 +120,7 @@ void blk_account_io_done(struct request *req);
 enum rq_atomic_flags {
 	REQ_ATOM_COMPLETE = 0,
 	REQ_ATOM_STARTED,
+	REQ_ATOM_POLL_SLEPT,
 };
 
 /*
@@ -195,6 +197,115 @@ static inline void elv_deactivate_rq(struct request_queue *q, struct request *rq
 		e->type->ops.elevator_deactivate_req_fn(q, rq);
 }
 
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+/* sample reads from dispatch to completion for the readahead model */
+static inline void blk_ra_start(struct request *rq)
+{
+	rq->ra_start_ns = 0;
+	if (rq->cmd_type == REQ_TYPE_FS && rq_data_dir(rq) == READ &&
+	    READ_ONCE(rq->q->backing_dev_info.ra_adaptive)) {
+		rq->ra_start_ns = ktime_get_ns();
+		rq->ra_bytes = blk_rq_bytes(rq);
+	}
+}
+
+static inline void blk_ra_done(struct request *rq)
+{
+	if (rq->ra_start_ns) {
+		bdi_ra_sample(&rq->q->backing_dev_info, rq->ra_bytes,
+			      ktime_get_ns() - rq->ra_start_ns);
+		rq->ra_start_ns = 0;
+	}
+}
+#else
+static inline void blk_ra_start(struct request *rq) { }
+static inline void blk_ra_done(struct request *rq) { }
+#endif
+
+#ifdef CONFIG_BLK_LATENCY_HIST
+enum blk_lat_op {
+	BLK_LAT_READ,
+	BLK_LAT_WRITE,
+	BLK_LAT_FLUSH,
+	BLK_LAT_DISCARD,
+	BLK_LAT_NR_OPS,
+};
+
+enum blk_lat_stage {
+	BLK_LAT_QUEUE,
+	BLK_LAT_ELEVATOR,
+	BLK_LAT_DRIVER,
+	BLK_LAT_DEVICE,
+	BLK_LAT_NR_STAGES,
+};
+
+/* bucket 0 is below 1us, bucket i up to 2^i us, the last one is overflow */
+#define BLK_LAT_BUCKETS		22
+
+struct blk_lat_op_hist {
+	unsigned long nr;
+	unsigned long hist[BLK_LAT_NR_STAGES][BLK_LAT_BUCKETS];
+};
+
+struct blk_lat_hist {
+	bool enabled;
+	struct blk_lat_op_hist op[BLK_LAT_NR_OPS];
+};
+
+DECLARE_STATIC_KEY_FALSE(blk_lat_hist_key);
+
+void __blk_lat_hist_done(struct request *rq);
+ssize_t blk_lat_hist_show(struct request_queue *q, char *page);
+ssize_t blk_lat_hist_store(struct request_queue *q, const char *page,
+			   size_t count);
+void blk_lat_hist_exit(struct request_queue *q);
+
+static inline bool blk_lat_hist_on(struct request_queue *q)
+{
+	return static_branch_unlikely(&blk_lat_hist_key) && q->lat_hist &&
+	       READ_ONCE(q->lat_hist->enabled);
+}
+
+static inline void blk_lat_hist_alloc(struct request *rq)
+{
+	rq->lat_alloc_ns = blk_lat_hist_on(rq->q) ? ktime_get_ns() : 0;
+	rq->lat_insert_ns = 0;
+	rq->lat_dispatch_ns = 0;
+	rq->lat_issue_ns = 0;
+}
+
+static inline void blk_lat_hist_insert(struct request *rq)
+{
+	if (rq->lat_alloc_ns && !rq->lat_insert_ns)
+		rq->lat_insert_ns = ktime_get_ns();
+}
+
+static inline void blk_lat_hist_dispatch(struct request *rq)
+{
+	if (rq->lat_alloc_ns)
+		rq->lat_dispatch_ns = ktime_get_ns();
+}
+
+static inline void blk_lat_hist_issue(struct request *rq)
+{
+	if (rq->lat_alloc_ns)
+		rq->lat_issue_ns = ktime_get_ns();
+}
+
+static inline void blk_lat_hist_done(struct request *rq)
+{
+	if (blk_lat_hist_on(rq->q))
+		__blk_lat_hist_done(rq);
+}
+#else
+static inline void blk_lat_hist_alloc(struct request *rq) { }
+static inline void blk_lat_hist_insert(struct request *rq) { }
+static inline void blk_lat_hist_dispatch(struct request *rq) { }
+static inline void blk_lat_hist_issue(struct request *rq) { }
+static inline void blk_lat_hist_done(struct request *rq) { }
+static inline void blk_lat_hist_exit(struct request_queue *q) { }
+#endif
+
 #ifdef CONFIG_FAIL_IO_TIMEOUT
 int blk_should_fake_timeout(struct request_queue *);
 ssize_t part_timeout_show(struct device *, struct device_attribute *, char *);
@@ -301,4 +412,19 @@ static inline int blk_throtl_init(struct request_queue *q) { return 0; }
 static inline void blk_throtl_exit(struct request_queue *q) { }
 #endif /* CONFIG_BLK_DEV_THROTTLING */
 
+#ifdef CONFIG_BLK_CGROUP_IOLATENCY
+extern int blk_iolatency_init(struct request_queue *q);
+extern void blk_iolatency_exit(struct request_queue *q);
+extern bool blk_iolatency_may_queue(struct request_list *rl, int sync);
+extern void blk_iolatency_done(struct request *rq);
+#else /* CONFIG_BLK_CGROUP_IOLATENCY */
+static inline int blk_iolatency_init(struct request_queue *q) { return 0; }
+static inline void blk_iolatency_exit(struct request_queue *q) { }
+static inline bool blk_iolatency_may_queue(struct request_list *rl, int sync)
+{
+	return true;
+}
+static inline void blk_iolatency_done(struct request *rq) { }
+#endif /* CONFIG_BLK_CGROUP_IOLATENCY */
+
 #endif /* BLK_INTERNAL_H */
@@ -0,0 +1,516 @@
+/*
+ * Latency target I/O scheduler
+ *
+ * Requests are split into classes, each with its own latency target:
+ *
+ *  read	 synchronous reads, what the foreground ends up waiting on
+ *  sync_write	 synchronous writes, mostly fsync() and O_SYNC/O_DSYNC
+ *  async	 background writeback
+ *  idle	 idle I/O priority, such as zram writeback to its backing device
+ *
+ * A request is due at its arrival time plus the target of its class and
+ * dispatch picks the request due first, earliest deadline first, among
+ * the classes that have a token left. Tokens bound how many requests of
+ * a class may be in flight on the device at once.
+ *
+ * Like Kyber, the scheduler tunes itself against the completion latency
+ * measured on the device: whenever the read or sync_write class misses
+ * its target over a window, the async and idle classes lose tokens, and
+ * they get them back while the targets are met with room to spare.
+ *
+ * Per-class latency histograms are exported as latency_hist in the
+ * iosched sysfs directory.
+ */
+#include <linux/kernel.h>
+#include <linux/fs.h>
+#include <linux/blkdev.h>
+#include <linux/elevator.h>
+#include <linux/bio.h>
+#include <linux/ioprio.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/slab.h>
+#include <linux/init.h>
+
+enum lat_class {
+	LAT_READ,
+	LAT_SYNC_WRITE,
+	LAT_ASYNC,
+	LAT_IDLE,
+	LAT_NR_CLASSES,
+};
+
+static const char * const lat_class_name[LAT_NR_CLASSES] = {
+	[LAT_READ]		= "read",
+	[LAT_SYNC_WRITE]	= "sync_write",
+	[LAT_ASYNC]		= "async",
+	[LAT_IDLE]		= "idle",
+};
+
+/* default latency targets, in usecs */
+static const unsigned int lat_target[LAT_NR_CLASSES] = {
+	[LAT_READ]		= 2000,
+	[LAT_SYNC_WRITE]	= 10000,
+	[LAT_ASYNC]		= 100000,
+	[LAT_IDLE]		= 500000,
+};
+
+static const unsigned int max_depth = 32;	/* tokens of each class */
+
+/* self-tuning window, and samples needed in it to act on a class */
+#define LAT_WINDOW_NS		(100 * NSEC_PER_MSEC)
+#define LAT_WINDOW_SAMPLES	8
+
+/* bucket 0: below 64us, bucket n: below 64us << n, the last one: the rest */
+#define LAT_HIST_SHIFT		6
+#define LAT_HIST_BUCKETS	16
+
+struct lat_class_data {
+	struct list_head fifo;
+	unsigned int target_us;
+	unsigned int depth;		/* tokens */
+	unsigned int in_flight;
+
+	/* from arrival to completion, since the last reset */
+	unsigned long hist[LAT_HIST_BUCKETS];
+	/* from dispatch to completion, in the current window */
+	unsigned long win_hist[LAT_HIST_BUCKETS];
+	unsigned long win_samples;
+};
+
+struct lat_data {
+	struct request_queue *q;
+	struct lat_class_data cls[LAT_NR_CLASSES];
+	int max_depth;
+	u64 window_start;
+	bool throttled;		/* requests wait for tokens to come back */
+};
+
+/*
+ * rq->elv.priv[0] holds the arrival time in ns, with the class stored in
+ * the two low bits, and rq->elv.priv[1] the dispatch time, 0 until then.
+ */
+#define LAT_CLASS_MASK		3UL
+
+static inline void lat_rq_set_start(struct request *rq, u64 start,
+				    enum lat_class class)
+{
+	rq->elv.priv[0] = (void *)(unsigned long)((start & ~LAT_CLASS_MASK) |
+						  class);
+}
+
+static inline u64 lat_rq_start(struct request *rq)
+{
+	return (unsigned long)rq->elv.priv[0] & ~LAT_CLASS_MASK;
+}
+
+static inline enum lat_class lat_rq_class(struct request *rq)
+{
+	return (unsigned long)rq->elv.priv[0] & LAT_CLASS_MASK;
+}
+
+static inline u64 lat_rq_dispatched(struct request *rq)
+{
+	return (unsigned long)rq->elv.priv[1];
+}
+
+static enum lat_class lat_classify(struct request *rq)
+{
+	if (IOPRIO_PRIO_CLASS(rq->ioprio) == IOPRIO_CLASS_IDLE)
+		return LAT_IDLE;
+	/* the foreground waits on RT writes as it would on sync ones */
+	if (!rq_is_sync(rq) && IOPRIO_PRIO_CLASS(rq->ioprio) != IOPRIO_CLASS_RT)
+		return LAT_ASYNC;
+	return rq_data_dir(rq) == READ ? LAT_READ : LAT_SYNC_WRITE;
+}
+
+static unsigned int lat_bucket(u64 ns)
+{
+	u64 us = div_u64(ns, NSEC_PER_USEC) >> LAT_HIST_SHIFT;
+
+	return min_t(unsigned int, us ? fls64(us) : 0, LAT_HIST_BUCKETS - 1);
+}
+
+/* upper bound, in usecs, of the bucket holding @pct percent of @hist */
+static unsigned int lat_percentile(const unsigned long *hist, unsigned int pct)
+{
+	unsigned long total = 0, sum = 0;
+	int b;
+
+	for (b = 0; b < LAT_HIST_BUCKETS; b++)
+		total += hist[b];
+	if (!total)
+		return 0;
+
+	for (b = 0; b < LAT_HIST_BUCKETS - 1; b++) {
+		sum += hist[b];
+		if (sum * 100 >= total * pct)
+			break;
+	}
+
+	return (1U << LAT_HIST_SHIFT) << b;
+}
+
+static void lat_add_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	enum lat_class class = lat_classify(rq);
+
+	lat_rq_set_start(rq, ktime_get_ns(), class);
+	rq->elv.priv[1] = NULL;
+	list_add_tail(&rq->queuelist, &ld->cls[class].fifo);
+}
+
+static void lat_merged_requests(struct request_queue *q, struct request *rq,
+				struct request *next)
+{
+	/* rq inherits the place of next if next arrived first */
+	if (lat_rq_start(next) < lat_rq_start(rq)) {
+		if (lat_rq_class(next) == lat_rq_class(rq))
+			list_move(&rq->queuelist, &next->queuelist);
+		lat_rq_set_start(rq, lat_rq_start(next), lat_rq_class(rq));
+	}
+
+	rq_fifo_clear(next);
+}
+
+static int lat_dispatch_requests(struct request_queue *q, int force)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	struct lat_class_data *lc;
+	struct request *rq = NULL;
+	u64 due, first = U64_MAX;
+	bool throttled = false;
+	int c, class = 0;
+
+	for (c = 0; c < LAT_NR_CLASSES; c++) {
+		struct request *head;
+
+		lc = &ld->cls[c];
+		if (list_empty(&lc->fifo))
+			continue;
+		if (!force && lc->in_flight >= lc->depth) {
+			throttled = true;
+			continue;
+		}
+
+		head = rq_entry_fifo(lc->fifo.next);
+		due = lat_rq_start(head) + (u64)lc->target_us * NSEC_PER_USEC;
+		if (due < first) {
+			first = due;
+			rq = head;
+			class = c;
+		}
+	}
+
+	/* completions have to restart the queue if nothing could go */
+	ld->throttled = !rq && throttled;
+	if (!rq)
+		return 0;
+
+	rq_fifo_clear(rq);
+	rq->elv.priv[1] = (void *)(unsigned long)ktime_get_ns();
+	ld->cls[class].in_flight++;
+	elv_dispatch_add_tail(q, rq);
+
+	return 1;
+}
+
+/*
+ * Throttle the async and idle classes while read or sync_write miss their
+ * target at the 90th percentile, and let them back up while both targets are
+ * met at least twice over.
+ */
+static void lat_adjust_depths(struct lat_data *ld, u64 now)
+{
+	bool missed = false, slack = true;
+	struct lat_class_data *lc;
+	int c;
+
+	for (c = LAT_READ; c <= LAT_SYNC_WRITE; c++) {
+		unsigned int p90;
+
+		lc = &ld->cls[c];
+		if (lc->win_samples < LAT_WINDOW_SAMPLES)
+			continue;
+
+		p90 = lat_percentile(lc->win_hist, 90);
+		if (p90 > lc->target_us)
+			missed = true;
+		else if (p90 > lc->target_us / 2)
+			slack = false;
+	}
+
+	for (c = LAT_ASYNC; c < LAT_NR_CLASSES; c++) {
+		lc = &ld->cls[c];
+		if (missed)
+			lc->depth = max(lc->depth / 2, 1U);
+		else if (slack)
+			lc->depth = min_t(unsigned int,
+					  lc->depth + max(lc->depth / 4, 1U),
+					  ld->max_depth);
+	}
+
+	for (c = 0; c < LAT_NR_CLASSES; c++) {
+		lc = &ld->cls[c];
+		memset(lc->win_hist, 0, sizeof(lc->win_hist));
+		lc->win_samples = 0;
+	}
+	ld->window_start = now;
+}
+
+static void lat_completed_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+	struct lat_class_data *lc = &ld->cls[lat_rq_class(rq)];
+	u64 dispatched = lat_rq_dispatched(rq);
+	u64 now;
+
+	if (!dispatched)
+		return;
+
+	now = ktime_get_ns();
+	if (lc->in_flight)
+		lc->in_flight--;
+	lc->hist[lat_bucket(now - lat_rq_start(rq))]++;
+	lc->win_hist[lat_bucket(now - dispatched)]++;
+	lc->win_samples++;
+
+	if (now - ld->window_start >= LAT_WINDOW_NS)
+		lat_adjust_depths(ld, now);
+
+	if (ld->throttled) {
+		ld->throttled = false;
+		blk_run_queue_async(q);
+	}
+}
+
+static struct request *
+lat_former_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+
+	if (rq->queuelist.prev == &ld->cls[lat_rq_class(rq)].fifo)
+		return NULL;
+
+	return list_entry(rq->queuelist.prev, struct request, queuelist);
+}
+
+static struct request *
+lat_latter_request(struct request_queue *q, struct request *rq)
+{
+	struct lat_data *ld = q->elevator->elevator_data;
+
+	if (rq->queuelist.next == &ld->cls[lat_rq_class(rq)].fifo)
+		return NULL;
+
+	return list_entry(rq->queuelist.next, struct request, queuelist);
+}
+
+static int lat_init_queue(struct request_queue *q, struct elevator_type *e)
+{
+	struct lat_data *ld;
+	struct elevator_queue *eq;
+	int c;
+
+	eq = elevator_alloc(q, e);
+	if (!eq)
+		return -ENOMEM;
+
+	ld = kzalloc_node(sizeof(*ld), GFP_KERNEL, q->node);
+	if (!ld) {
+		kobject_put(&eq->kobj);
+		return -ENOMEM;
+	}
+	eq->elevator_data = ld;
+
+	ld->q = q;
+	ld->max_depth = max_depth;
+	ld->window_start = ktime_get_ns();
+	for (c = 0; c < LAT_NR_CLASSES; c++) {
+		INIT_LIST_HEAD(&ld->cls[c].fifo);
+		ld->cls[c].target_us = lat_target[c];
+		ld->cls[c].depth = max_depth;
+	}
+
+	spin_lock_irq(q->queue_lock);
+	q->elevator = eq;
+	spin_unlock_irq(q->queue_lock);
+	return 0;
+}
+
+static void lat_exit_queue(struct elevator_queue *e)
+{
+	struct lat_data *ld = e->elevator_data;
+	int c;
+
+	for (c = 0; c < LAT_NR_CLASSES; c++)
+		BUG_ON(!list_empty(&ld->cls[c].fifo));
+
+	kfree(ld);
+}
+
+/*
+ * sysfs parts below
+ */
+
+static ssize_t
+lat_var_show(int var, char *page)
+{
+	return sprintf(page, "%d\n", var);
+}
+
+static void
+lat_var_store(int *var, const char *page)
+{
+	char *p = (char *) page;
+
+	*var = simple_strtol(p, &p, 10);
+}
+
+#define SHOW_FUNCTION(__FUNC, __VAR)					\
+static ssize_t __FUNC(struct elevator_queue *e, char *page)		\
+{									\
+	struct lat_data *ld = e->elevator_data;				\
+	return lat_var_show(__VAR, (page));				\
+}
+SHOW_FUNCTION(lat_read_target_us_show, ld->cls[LAT_READ].target_us);
+SHOW_FUNCTION(lat_sync_write_target_us_show, ld->cls[LAT_SYNC_WRITE].target_us);
+SHOW_FUNCTION(lat_async_target_us_show, ld->cls[LAT_ASYNC].target_us);
+SHOW_FUNCTION(lat_idle_target_us_show, ld->cls[LAT_IDLE].target_us);
+SHOW_FUNCTION(lat_max_depth_show, ld->max_depth);
+#undef SHOW_FUNCTION
+
+#define STORE_FUNCTION(__FUNC, __PTR, MIN, MAX)				\
+static ssize_t __FUNC(struct elevator_queue *e, const char *page, size_t count)	\
+{									\
+	struct lat_data *ld = e->elevator_data;				\
+	int __data;							\
+	lat_var_store(&__data, (page));					\
+	if (__data < (MIN))						\
+		__data = (MIN);						\
+	else if (__data > (MAX))					\
+		__data = (MAX);						\
+	*(__PTR) = __data;						\
+	return count;							\
+}
+STORE_FUNCTION(lat_read_target_us_store, &ld->cls[LAT_READ].target_us, 1, INT_MAX);
+STORE_FUNCTION(lat_sync_write_target_us_store, &ld->cls[LAT_SYNC_WRITE].target_us, 1, INT_MAX);
+STORE_FUNCTION(lat_async_target_us_store, &ld->cls[LAT_ASYNC].target_us, 1, INT_MAX);
+STORE_FUNCTION(lat_idle_target_us_store, &ld->cls[LAT_IDLE].target_us, 1, INT_MAX);
+#undef STORE_FUNCTION
+
+static ssize_t lat_max_depth_store(struct elevator_queue *e, const char *page,
+				   size_t count)
+{
+	struct lat_data *ld = e->elevator_data;
+	int depth, c;
+
+	lat_var_store(&depth, page);
+	depth = clamp(depth, 1, INT_MAX);
+
+	spin_lock_irq(ld->q->queue_lock);
+	ld->max_depth = depth;
+	for (c = 0; c < LAT_NR_CLASSES; c++)
+		if (c < LAT_ASYNC || ld->cls[c].depth > depth)
+			ld->cls[c].depth = depth;
+	spin_unlock_irq(ld->q->queue_lock);
+
+	return count;
+}
+
+/*
+ * One line per class: target and current tokens, p50/p90/p99 and the
+ * histogram of the time from arrival to completion, in usecs.
+ */
+static ssize_t lat_latency_hist_show(struct elevator_queue *e, char *page)
+{
+	struct lat_data *ld = e->elevator_data;
+	unsigned long hist[LAT_HIST_BUCKETS];
+	unsigned int target, depth;
+	ssize_t len = 0;
+	int c, b;
+
+	for (c = 0; c < LAT_NR_CLASSES; c++) {
+		spin_lock_irq(ld->q->queue_lock);
+		memcpy(hist, ld->cls[c].hist, sizeof(hist));
+		target = ld->cls[c].target_us;
+		depth = ld->cls[c].depth;
+		spin_unlock_irq(ld->q->queue_lock);
+
+		len += scnprintf(page + len, PAGE_SIZE - len,
+				 "%s: target %u depth %u p50 %u p90 %u p99 %u hist",
+				 lat_class_name[c], target, depth,
+				 lat_percentile(hist, 50),
+				 lat_percentile(hist, 90),
+				 lat_percentile(hist, 99));
+		for (b = 0; b < LAT_HIST_BUCKETS; b++)
+			len += scnprintf(page + len, PAGE_SIZE - len, " %lu",
+					 hist[b]);
+		len += scnprintf(page + len, PAGE_SIZE - len, "\n");
+	}
+
+	return len;
+}
+
+/* any write clears the histograms */
+static ssize_t lat_latency_hist_store(struct elevator_queue *e,
+				      const char *page, size_t count)
+{
+	struct lat_data *ld = e->elevator_data;
+	int c;
+
+	spin_lock_irq(ld->q->queue_lock);
+	for (c = 0; c < LAT_NR_CLASSES; c++)
+		memset(ld->cls[c].hist, 0, sizeof(ld->cls[c].hist));
+	spin_unlock_irq(ld->q->queue_lock);
+
+	return count;
+}
+
+#define LAT_ATTR(name) \
+	__ATTR(name, S_IRUGO|S_IWUSR, lat_##name##_show, \
+				      lat_##name##_store)
+
+static struct elv_fs_entry lat_attrs[] = {
+	LAT_ATTR(read_target_us),
+	LAT_ATTR(sync_write_target_us),
+	LAT_ATTR(async_target_us),
+	LAT_ATTR(idle_target_us),
+	LAT_ATTR(max_depth),
+	LAT_ATTR(latency_hist),
+	__ATTR_NULL
+};
+
+static struct elevator_type iosched_latency = {
+	.ops = {
+		.elevator_merge_req_fn =	lat_merged_requests,
+		.elevator_dispatch_fn =		lat_dispatch_requests,
+		.elevator_add_req_fn =		lat_add_request,
+		.elevator_completed_req_fn =	lat_completed_request,
+		.elevator_former_req_fn =	lat_former_request,
+		.elevator_latter_req_fn =	lat_latter_request,
+		.elevator_init_fn =		lat_init_queue,
+		.elevator_exit_fn =		lat_exit_queue,
+	},
+
+	.elevator_attrs = lat_attrs,
+	.elevator_name = "latency",
+	.elevator_owner = THIS_MODULE,
+};
+
+static int __init lat_init(void)
+{
+	return elv_register(&iosched_latency);
+}
+
+static void __exit lat_exit(void)
+{
+	elv_unregister(&iosched_latency);
+}
+
+module_init(lat_init);
+module_exit(lat_exit);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("Latency target I/O scheduler");
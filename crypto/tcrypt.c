@@ -1811,6 +1811,18 @@ static int do_test(const char *alg, u32 type, u32 mask, int m)
 				  speed_template_32);
 		break;
 
+	case 215:
+		test_aead_speed("rfc7539(chacha20,poly1305)", ENCRYPT, sec,
+				NULL, 0, 16, 8, aead_speed_template_32);
+		break;
+
+	case 216:
+		test_cipher_speed("chacha20-generic", ENCRYPT, sec, NULL, 0,
+				  speed_template_32);
+		test_hash_speed("poly1305-generic", sec,
+				poly1305_speed_template);
+		break;
+
 
 	case 300:
 		if (alg) {
@@ -68,6 +68,7 @@ static u8 speed_template_32[] = {32, 0};
  */
 static u8 aead_speed_template_19[] = {19, 0};
 static u8 aead_speed_template_20[] = {20, 0};
+static u8 aead_speed_template_32[] = {32, 0};
 static u8 aead_speed_template_36[] = {36, 0};
 
 /*
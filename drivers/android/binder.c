@@ -70,6 +70,7 @@
 #include <linux/security.h>
 #include <linux/spinlock.h>
 #include <linux/ratelimit.h>
+#include <linux/topology.h>
 
 #include <uapi/linux/android/binder.h>
 #include <uapi/linux/eventpoll.h>
@@ -149,6 +150,13 @@ module_param_named(debug_mask, binder_debug_mask, uint, 0644);
 char *binder_devices_param = CONFIG_ANDROID_BINDER_DEVICES;
 module_param_named(devices, binder_devices_param, charp, 0444);
 
+/*
+ * Waiting threads looked at, for a synchronous transaction, to find one that
+ * last ran in the caller's cluster; 0 takes the first waiting thread.
+ */
+static uint binder_cluster_scan = 8;
+module_param_named(cluster_scan, binder_cluster_scan, uint, 0644);
+
 static DECLARE_WAIT_QUEUE_HEAD(binder_user_error_wait);
 static int binder_stop_on_user_error;
 
@@ -206,6 +214,9 @@ struct binder_stats {
 	atomic_t bc[_IOC_NR(BC_REPLY_SG) + 1];
 	atomic_t obj_created[BINDER_STAT_COUNT];
 	atomic_t obj_deleted[BINDER_STAT_COUNT];
+	/* synchronous wakeups of a thread in the caller's cluster or not */
+	atomic_t sync_wakeup_local;
+	atomic_t sync_wakeup_cross;
 };
 
 static struct binder_stats binder_stats;
@@ -472,6 +483,7 @@ enum binder_deferred_state {
  * struct binder_priority - scheduler policy and priority
  * @sched_policy            scheduler policy
  * @prio                    [100..139] for SCHED_NORMAL, [0..99] for FIFO/RT
+ * @boost                   schedtune boost lent to the thread
  *
  * The binder driver supports inheriting the following scheduler policies:
  * SCHED_NORMAL
@@ -482,6 +494,7 @@ enum binder_deferred_state {
 struct binder_priority {
 	unsigned int sched_policy;
 	int prio;
+	int boost;
 };
 
 /**
@@ -1076,30 +1089,72 @@ static void binder_wakeup_poll_threads_ilocked(struct binder_proc *proc,
 	}
 }
 
+/*
+ * A synchronous caller blocks until the reply, so the thread handling the
+ * call had better run where the caller does: woken in another cluster it
+ * starts on, and is served at the speed of, the cores of that cluster.
+ */
+static struct binder_thread *
+binder_select_near_thread_ilocked(struct binder_proc *proc, int cluster)
+{
+	struct binder_thread *thread;
+	uint scan = READ_ONCE(binder_cluster_scan);
+
+	list_for_each_entry(thread, &proc->waiting_threads,
+			    waiting_thread_node) {
+		if (!scan--)
+			break;
+		if (topology_physical_package_id(task_cpu(thread->task)) ==
+		    cluster)
+			return thread;
+	}
+
+	return NULL;
+}
+
 /**
  * binder_select_thread_ilocked() - selects a thread for doing proc work.
  * @proc:	process to select a thread from
+ * @sync:	whether the work is a synchronous transaction of the caller
  *
  * Note that calling this function moves the thread off the waiting_threads
  * list, so it can only be woken up by the caller of this function, or a
  * signal. Therefore, callers *should* always wake up the thread this function
  * returns.
  *
+ * For @sync work, a thread that last ran in the caller's cluster is
+ * preferred over the first one waiting.
+ *
  * Return:	If there's a thread currently waiting for process work,
  *		returns that thread. Otherwise returns NULL.
  */
 static struct binder_thread *
-binder_select_thread_ilocked(struct binder_proc *proc)
+binder_select_thread_ilocked(struct binder_proc *proc, bool sync)
 {
-	struct binder_thread *thread;
+	struct binder_thread *thread = NULL;
+	int cluster = topology_physical_package_id(smp_processor_id());
 
 	assert_spin_locked(&proc->inner_lock);
-	thread = list_first_entry_or_null(&proc->waiting_threads,
-					  struct binder_thread,
-					  waiting_thread_node);
+	if (sync)
+		thread = binder_select_near_thread_ilocked(proc, cluster);
+	if (!thread)
+		thread = list_first_entry_or_null(&proc->waiting_threads,
+						  struct binder_thread,
+						  waiting_thread_node);
 
-	if (thread)
+	if (thread) {
 		list_del_init(&thread->waiting_thread_node);
+		if (sync) {
+			if (topology_physical_package_id(
+					task_cpu(thread->task)) == cluster) {
+				atomic_inc(&binder_stats.sync_wakeup_local);
+				atomic_inc(&proc->stats.sync_wakeup_local);
+			} else {
+				atomic_inc(&binder_stats.sync_wakeup_cross);
+				atomic_inc(&proc->stats.sync_wakeup_cross);
+			}
+		}
+	}
 
 	return thread;
 }
@@ -1152,7 +1207,7 @@ static void binder_wakeup_thread_ilocked(struct binder_proc *proc,
 
 static void binder_wakeup_proc_ilocked(struct binder_proc *proc)
 {
-	struct binder_thread *thread = binder_select_thread_ilocked(proc);
+	struct binder_thread *thread = binder_select_thread_ilocked(proc, false);
 
 	binder_wakeup_thread_ilocked(proc, thread, /* sync = */false);
 }
@@ -1197,6 +1252,9 @@ static void binder_do_set_priority(struct binder_thread *thread,
 	bool has_cap_nice;
 	unsigned int policy = desired->sched_policy;
 
+	/* ahead of the early return, the boost may differ on its own */
+	schedtune_set_inherited_boost(task, desired->boost);
+
 	if (task->policy == policy && task->normal_prio == desired->prio)
 		return;
 
@@ -1273,6 +1331,7 @@ static void binder_transaction_priority(struct binder_thread *thread,
 	const struct binder_priority node_prio = {
 		.sched_policy = node->sched_policy,
 		.prio = node->min_priority,
+		.boost = t->priority.boost,
 	};
 
 	if (t->set_priority_called)
@@ -1281,6 +1340,7 @@ static void binder_transaction_priority(struct binder_thread *thread,
 	t->set_priority_called = true;
 	t->saved_priority.sched_policy = task->policy;
 	t->saved_priority.prio = task->normal_prio;
+	t->saved_priority.boost = schedtune_inherited_boost(task);
 
 	if (!node->inherit_rt && is_rt_policy(desired.sched_policy)) {
 		desired.prio = NICE_TO_PRIO(0);
@@ -2963,7 +3023,7 @@ static int binder_proc_transaction(struct binder_transaction *t,
 	}
 
 	if (!thread && !pending_async)
-		thread = binder_select_thread_ilocked(proc);
+		thread = binder_select_thread_ilocked(proc, !oneway);
 
 	if (thread) {
 		binder_transaction_priority(thread, t, node);
@@ -3090,6 +3150,8 @@ static void freecess_sync_binder_report(struct binder_proc *proc,
 		&& (target_proc->tsk->cred->euid.val > 10000)
 		&& (proc->pid != target_proc->pid) 
 		&& thread_group_is_frozen(target_proc->tsk)) {
+		/* the caller is about to wait on it, thaw it here */
+		freecess_binder_thaw(target_proc->tsk);
 		//if sync binder, we don't need detecting info, so set code and interfacename as default value.
 		binder_report(target_proc->tsk, 0, "sync_binder", tr->flags & TF_ONE_WAY);
 	}
@@ -3374,6 +3436,9 @@ static void binder_transaction(struct binder_proc *proc,
 		/* Inherit supported policies for synchronous transactions */
 		t->priority.sched_policy = current->policy;
 		t->priority.prio = current->normal_prio;
+#ifdef CONFIG_CGROUP_SCHEDTUNE
+		t->priority.boost = schedtune_task_boost(current);
+#endif
 	} else {
 		/* Otherwise, fall back to the default priority */
 		t->priority = target_proc->default_priority;
@@ -6329,6 +6394,12 @@ static void print_binder_stats(struct seq_file *m, const char *prefix,
 				created - deleted,
 				created);
 	}
+
+	if (atomic_read(&stats->sync_wakeup_local) ||
+	    atomic_read(&stats->sync_wakeup_cross))
+		seq_printf(m, "%ssync wakeups: same cluster %d cross cluster %d\n",
+			   prefix, atomic_read(&stats->sync_wakeup_local),
+			   atomic_read(&stats->sync_wakeup_cross));
 }
 
 static void print_binder_proc_stats(struct seq_file *m,
@@ -28,6 +28,7 @@
 #include <linux/sched.h>
 #include <linux/list_lru.h>
 #include <linux/ratelimit.h>
+#include <linux/ktime.h>
 #include <asm/cacheflush.h>
 #include <linux/uaccess.h>
 #include <linux/highmem.h>
@@ -53,6 +54,17 @@ static uint32_t binder_alloc_debug_mask = BINDER_DEBUG_USER_ERROR;
 module_param_named(debug_mask, binder_alloc_debug_mask,
 		   uint, 0644);
 
+static bool binder_alloc_size_classes = true;
+module_param_named(size_classes, binder_alloc_size_classes, bool, 0444);
+
+/*
+ * Pages that a payload of at least this many bytes covers entirely are not
+ * zeroed when allocated, as the data copy overwrites them right after.
+ * 0 zeroes every page.
+ */
+static uint binder_alloc_nozero_min = 4 * PAGE_SIZE;
+module_param_named(nozero_min, binder_alloc_nozero_min, uint, 0644);
+
 #define binder_alloc_debug(mask, x...) \
 	do { \
 		if (binder_alloc_debug_mask & mask) \
@@ -206,8 +218,89 @@ struct binder_buffer *binder_alloc_prepare_to_free(struct binder_alloc *alloc,
 	return buffer;
 }
 
+/* size class of an allocation of @size bytes, 0 < @size <= CLASS_MAX */
+static inline int binder_alloc_class(size_t size)
+{
+	return (size - 1) >> BINDER_ALLOC_CLASS_SHIFT;
+}
+
+static inline size_t binder_alloc_class_size(int class)
+{
+	return (size_t)(class + 1) << BINDER_ALLOC_CLASS_SHIFT;
+}
+
+static struct binder_buffer *binder_alloc_class_get(struct binder_alloc *alloc,
+						    int class)
+{
+	struct binder_buffer *buffer;
+
+	if (list_empty(&alloc->class_free[class]))
+		return NULL;
+
+	buffer = list_first_entry(&alloc->class_free[class],
+				  struct binder_buffer, class_entry);
+	list_del_init(&buffer->class_entry);
+	alloc->class_count[class]--;
+	alloc->class_bytes -= binder_alloc_buffer_size(alloc, buffer);
+	alloc->class_hits++;
+	return buffer;
+}
+
+/*
+ * Keep a freed small buffer as it is, pages included, for the next
+ * allocation of its size class. It stays marked in use, so neighbours
+ * being freed do not merge with it. The address space held this way is
+ * bounded to 1/16 of the mapping and is given back to free_buffers before
+ * an allocation would fail for lack of it.
+ */
+static bool binder_alloc_class_put(struct binder_alloc *alloc,
+				   struct binder_buffer *buffer,
+				   size_t buffer_size)
+{
+	int class;
+
+	if (!alloc->size_classes || buffer_size > BINDER_ALLOC_CLASS_MAX)
+		return false;
+
+	/* the largest class this buffer can serve */
+	class = (buffer_size >> BINDER_ALLOC_CLASS_SHIFT) - 1;
+	if (class < 0 || alloc->class_count[class] >= BINDER_ALLOC_CLASS_DEPTH ||
+	    alloc->class_bytes + buffer_size > alloc->buffer_size / 16)
+		return false;
+
+	list_add(&buffer->class_entry, &alloc->class_free[class]);
+	alloc->class_count[class]++;
+	alloc->class_bytes += buffer_size;
+	return true;
+}
+
+static void binder_release_buf_locked(struct binder_alloc *alloc,
+				      struct binder_buffer *buffer,
+				      size_t buffer_size);
+
+static void binder_alloc_class_flush(struct binder_alloc *alloc)
+{
+	struct binder_buffer *buffer;
+	int class;
+
+	for (class = 0; class < BINDER_ALLOC_CLASSES; class++) {
+		while (!list_empty(&alloc->class_free[class])) {
+			buffer = list_first_entry(&alloc->class_free[class],
+						  struct binder_buffer,
+						  class_entry);
+			list_del_init(&buffer->class_entry);
+			binder_release_buf_locked(alloc, buffer,
+				binder_alloc_buffer_size(alloc, buffer));
+		}
+		alloc->class_count[class] = 0;
+	}
+	alloc->class_bytes = 0;
+}
+
 static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
-				    void __user *start, void __user *end)
+				    void __user *start, void __user *end,
+				    void __user *nozero_start,
+				    void __user *nozero_end)
 {
 	void __user *page_addr;
 	unsigned long user_page_addr;
@@ -215,6 +308,7 @@ static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 	struct vm_area_struct *vma = NULL;
 	struct mm_struct *mm = NULL;
 	bool need_mm = false;
+	gfp_t gfp;
 
 	binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
 		     "%d: %s pages %pK-%pK\n", alloc->pid,
@@ -273,8 +367,13 @@ static int binder_update_page_range(struct binder_alloc *alloc, int allocate,
 			goto err_page_ptr_cleared;
 
 		trace_binder_alloc_page_start(alloc, index);
-		page->page_ptr = alloc_page(GFP_KERNEL |
-					    __GFP_ZERO);
+		gfp = GFP_KERNEL;
+		if (page_addr >= nozero_start &&
+		    page_addr + PAGE_SIZE <= nozero_end)
+			alloc->unzeroed_pages++;
+		else
+			gfp |= __GFP_ZERO;
+		page->page_ptr = alloc_page(gfp);
 		if (!page->page_ptr) {
 			pr_err("%d: binder_alloc_buf failed for page at %pK\n",
 				alloc->pid, page_addr);
@@ -379,7 +478,11 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	struct rb_node *best_fit = NULL;
 	void __user *has_page_addr;
 	void __user *end_page_addr;
-	size_t size, data_offsets_size;
+	size_t size, data_offsets_size, async_size;
+	void __user *nozero_start = NULL;
+	void __user *nozero_end = NULL;
+	unsigned long unzeroed = 0;
+	bool flushed = false;
 	int ret;
 #ifdef CONFIG_SAMSUNG_FREECESS
 	struct task_struct *p = NULL;
@@ -431,7 +534,22 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 
 	/* Pad 0-size buffers so they get assigned unique addresses */
 	size = max(size, sizeof(void *));
+	async_size = size;
+
+	if (alloc->size_classes && size <= BINDER_ALLOC_CLASS_MAX) {
+		int class = binder_alloc_class(size);
 
+		buffer = binder_alloc_class_get(alloc, class);
+		if (buffer) {
+			/* pages were kept populated when it was freed */
+			buffer_size = binder_alloc_buffer_size(alloc, buffer);
+			goto got_buffer;
+		}
+		alloc->class_misses++;
+		size = binder_alloc_class_size(class);
+	}
+
+retry:
 	while (n) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 		BUG_ON(!buffer->free);
@@ -447,6 +565,15 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 			break;
 		}
 	}
+	if (best_fit == NULL && !flushed &&
+	    (alloc->class_bytes || size != async_size)) {
+		/* give kept buffers back and drop the rounding before failing */
+		binder_alloc_class_flush(alloc);
+		size = async_size;
+		flushed = true;
+		n = alloc->free_buffers.rb_node;
+		goto retry;
+	}
 	if (best_fit == NULL) {
 		size_t allocated_buffers = 0;
 		size_t largest_alloc_size = 0;
@@ -499,10 +626,19 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 		(void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data + size);
 	if (end_page_addr > has_page_addr)
 		end_page_addr = has_page_addr;
+	if (binder_alloc_nozero_min && data_size >= binder_alloc_nozero_min) {
+		nozero_start = (void __user *)
+			PAGE_ALIGN((uintptr_t)buffer->user_data);
+		nozero_end = (void __user *)
+			(((uintptr_t)buffer->user_data + data_size) & PAGE_MASK);
+	}
+	unzeroed = alloc->unzeroed_pages;
 	ret = binder_update_page_range(alloc, 1, (void __user *)
-		PAGE_ALIGN((uintptr_t)buffer->user_data), end_page_addr);
+		PAGE_ALIGN((uintptr_t)buffer->user_data), end_page_addr,
+		nozero_start, nozero_end);
 	if (ret)
 		return ERR_PTR(ret);
+	unzeroed = alloc->unzeroed_pages - unzeroed;
 
 	if (buffer_size != size) {
 		struct binder_buffer *new_buffer;
@@ -521,7 +657,9 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 
 	rb_erase(best_fit, &alloc->free_buffers);
 	buffer->free = 0;
+got_buffer:
 	buffer->allow_user_free = 0;
+	buffer->unzeroed = !!unzeroed;
 	binder_insert_allocated_buffer_locked(alloc, buffer);
 	binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC,
 		     "%d: binder_alloc_buf size %zd got %pK\n",
@@ -531,7 +669,8 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	buffer->async_transaction = is_async;
 	buffer->extra_buffers_size = extra_buffers_size;
 	if (is_async) {
-		alloc->free_async_space -= size + sizeof(struct binder_buffer);
+		alloc->free_async_space -= async_size +
+					   sizeof(struct binder_buffer);
 		binder_alloc_debug(BINDER_DEBUG_BUFFER_ALLOC_ASYNC,
 			     "%d: binder_alloc_buf size %zd async free %zd\n",
 			      alloc->pid, size, alloc->free_async_space);
@@ -539,9 +678,18 @@ static struct binder_buffer *binder_alloc_new_buf_locked(
 	return buffer;
 
 err_alloc_buf_struct_failed:
+	/* never copied into, the pages must not be reused unzeroed */
+	if (unzeroed) {
+		void __user *page_addr;
+
+		for (page_addr = nozero_start; page_addr < nozero_end;
+		     page_addr += PAGE_SIZE)
+			clear_highpage(alloc->pages[(page_addr - alloc->buffer) /
+						    PAGE_SIZE].page_ptr);
+	}
 	binder_update_page_range(alloc, 0, (void __user *)
 				 PAGE_ALIGN((uintptr_t)buffer->user_data),
-				 end_page_addr);
+				 end_page_addr, NULL, NULL);
 	return ERR_PTR(-ENOMEM);
 }
 
@@ -567,10 +715,17 @@ struct binder_buffer *binder_alloc_new_buf(struct binder_alloc *alloc,
 					   int is_async)
 {
 	struct binder_buffer *buffer;
+	u64 start = ktime_get_ns();
+	u64 delta_us;
+	int bucket;
 
 	mutex_lock(&alloc->mutex);
 	buffer = binder_alloc_new_buf_locked(alloc, data_size, offsets_size,
 					     extra_buffers_size, is_async);
+	delta_us = (ktime_get_ns() - start) >> 10;
+	bucket = delta_us ? min(ilog2(delta_us) + 1,
+				BINDER_ALLOC_LAT_BUCKETS - 1) : 0;
+	alloc->alloc_lat[bucket]++;
 	mutex_unlock(&alloc->mutex);
 	return buffer;
 }
@@ -628,7 +783,8 @@ static void binder_delete_free_buffer(struct binder_alloc *alloc,
 				   prev->user_data,
 				   next ? next->user_data : NULL);
 		binder_update_page_range(alloc, 0, buffer_start_page(buffer),
-					 buffer_start_page(buffer) + PAGE_SIZE);
+					 buffer_start_page(buffer) + PAGE_SIZE,
+					 NULL, NULL);
 	}
 	list_del(&buffer->entry);
 	kmem_cache_free(binder_buffer_pool, buffer);
@@ -663,12 +819,25 @@ static void binder_free_buf_locked(struct binder_alloc *alloc,
 			      alloc->pid, size, alloc->free_async_space);
 	}
 
+	rb_erase(&buffer->rb_node, &alloc->allocated_buffers);
+
+	if (binder_alloc_class_put(alloc, buffer, buffer_size))
+		return;
+
+	binder_release_buf_locked(alloc, buffer, buffer_size);
+}
+
+/* give a buffer that is in neither rb tree back to free_buffers */
+static void binder_release_buf_locked(struct binder_alloc *alloc,
+				      struct binder_buffer *buffer,
+				      size_t buffer_size)
+{
 	binder_update_page_range(alloc, 0,
 		(void __user *)PAGE_ALIGN((uintptr_t)buffer->user_data),
 		(void __user *)(((uintptr_t)
-			  buffer->user_data + buffer_size) & PAGE_MASK));
+			  buffer->user_data + buffer_size) & PAGE_MASK),
+		NULL, NULL);
 
-	rb_erase(&buffer->rb_node, &alloc->allocated_buffers);
 	buffer->free = 1;
 	if (!list_is_last(&buffer->entry, &alloc->buffers)) {
 		struct binder_buffer *next = binder_buffer_next(buffer);
@@ -802,6 +971,10 @@ void binder_alloc_deferred_release(struct binder_alloc *alloc)
 	mutex_lock(&alloc->mutex);
 	BUG_ON(alloc->vma);
 
+	/* no more reuse, so that the buffers below merge back into one */
+	alloc->size_classes = false;
+	binder_alloc_class_flush(alloc);
+
 	while ((n = rb_first(&alloc->allocated_buffers))) {
 		buffer = rb_entry(n, struct binder_buffer, rb_node);
 
@@ -897,6 +1070,9 @@ void binder_alloc_print_pages(struct seq_file *m,
 			      struct binder_alloc *alloc)
 {
 	struct binder_lru_page *page;
+	unsigned long lat[BINDER_ALLOC_LAT_BUCKETS];
+	unsigned long hits, misses, unzeroed;
+	size_t kept;
 	int i;
 	int active = 0;
 	int lru = 0;
@@ -918,9 +1094,22 @@ void binder_alloc_print_pages(struct seq_file *m,
 				lru++;
 		}
 	}
+	hits = alloc->class_hits;
+	misses = alloc->class_misses;
+	kept = alloc->class_bytes;
+	unzeroed = alloc->unzeroed_pages;
+	memcpy(lat, alloc->alloc_lat, sizeof(lat));
 	mutex_unlock(&alloc->mutex);
 	seq_printf(m, "  pages: %d:%d:%d\n", active, lru, free);
 	seq_printf(m, "  pages high watermark: %zu\n", alloc->pages_high);
+	seq_printf(m, "  size classes: hits %lu misses %lu kept %zu\n",
+		   hits, misses, kept);
+	seq_printf(m, "  zeroing skipped: %lu bytes\n",
+		   unzeroed * PAGE_SIZE);
+	seq_puts(m, "  alloc latency us:");
+	for (i = 0; i < BINDER_ALLOC_LAT_BUCKETS - 1; i++)
+		seq_printf(m, " <%d:%lu", 1 << i, lat[i]);
+	seq_printf(m, " >=%d:%lu\n", 1 << i, lat[i]);
 }
 
 /**
@@ -1060,9 +1249,14 @@ static struct shrinker binder_shrinker = {
  */
 void binder_alloc_init(struct binder_alloc *alloc)
 {
+	int class;
+
 	alloc->pid = current->group_leader->pid;
 	mutex_init(&alloc->mutex);
 	INIT_LIST_HEAD(&alloc->buffers);
+	for (class = 0; class < BINDER_ALLOC_CLASSES; class++)
+		INIT_LIST_HEAD(&alloc->class_free[class]);
+	alloc->size_classes = binder_alloc_size_classes;
 }
 
 int binder_alloc_shrinker_init(void)
@@ -1209,8 +1403,12 @@ binder_alloc_copy_user_to_buffer(struct binder_alloc *alloc,
 		kptr = kmap(page) + pgoff;
 		ret = copy_from_user(kptr, from, size);
 		kunmap(page);
-		if (ret)
+		if (ret) {
+			/* the tail was due to overwrite unzeroed pages */
+			if (buffer->unzeroed)
+				binder_alloc_clear_buf(alloc, buffer);
 			return bytes - size + ret;
+		}
 		bytes -= size;
 		from += size;
 		buffer_offset += size;
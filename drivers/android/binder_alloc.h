@@ -27,12 +27,29 @@
 extern struct list_lru binder_alloc_lru;
 struct binder_transaction;
 
+/*
+ * Buffers of up to BINDER_ALLOC_CLASS_MAX bytes are allocated in multiples of
+ * 1 << BINDER_ALLOC_CLASS_SHIFT and, once freed, may be kept with their pages
+ * on a per-size free list for the next allocation of the same size.
+ */
+#define BINDER_ALLOC_CLASS_SHIFT	8
+#define BINDER_ALLOC_CLASS_MAX		4096
+#define BINDER_ALLOC_CLASSES		\
+	(BINDER_ALLOC_CLASS_MAX >> BINDER_ALLOC_CLASS_SHIFT)
+#define BINDER_ALLOC_CLASS_DEPTH	4
+
+/* allocation latency buckets: < 1us, < 2us, ... < 64us, >= 64us */
+#define BINDER_ALLOC_LAT_BUCKETS	8
+
 /**
  * struct binder_buffer - buffer used for binder transactions
  * @entry:              entry alloc->buffers
  * @rb_node:            node for allocated_buffers/free_buffers rb trees
+ * @class_entry:        entry in alloc->class_free while kept for reuse
  * @free:               %true if buffer is free
  * @clear_on_free:      %true if buffer must be zeroed after use
+ * @unzeroed:           %true if pages of the buffer were not zeroed when
+ *                      allocated, the data copy being due to fill them
  * @allow_user_free:    %true if user is allowed to free buffer
  * @async_transaction:  %true if buffer is in use for an async txn
  * @debug_id:           unique ID for debugging
@@ -49,11 +66,13 @@ struct binder_buffer {
 	struct list_head entry; /* free and allocated entries by address */
 	struct rb_node rb_node; /* free entry by size or allocated entry */
 				/* by address */
+	struct list_head class_entry;
 	unsigned free:1;
 	unsigned clear_on_free:1;
 	unsigned allow_user_free:1;
 	unsigned async_transaction:1;
-	unsigned debug_id:28;
+	unsigned unzeroed:1;
+	unsigned debug_id:27;
 
 	struct binder_transaction *transaction;
 
@@ -95,6 +114,15 @@ struct binder_lru_page {
  * @buffer_size:        size of address space specified via mmap
  * @pid:                pid for associated binder_proc (invariant after init)
  * @pages_high:         high watermark of offset in @pages
+ * @class_free:         per size class lists of freed small buffers kept with
+ *                      their pages populated, neither free nor allocated
+ * @class_count:        number of buffers on each @class_free list
+ * @class_bytes:        bytes of address space held on @class_free
+ * @size_classes:       %true if small buffers use @class_free
+ * @class_hits:         allocations served from @class_free
+ * @class_misses:       small allocations that had to search @free_buffers
+ * @alloc_lat:          histogram of binder_alloc_new_buf() latencies
+ * @unzeroed_pages:     pages allocated without zeroing for large payloads
  *
  * Bookkeeping structure for per-proc address space management for binder
  * buffers. It is normally initialized during binder_init() and binder_mmap()
@@ -115,6 +143,14 @@ struct binder_alloc {
 	uint32_t buffer_free;
 	int pid;
 	size_t pages_high;
+	struct list_head class_free[BINDER_ALLOC_CLASSES];
+	unsigned int class_count[BINDER_ALLOC_CLASSES];
+	size_t class_bytes;
+	bool size_classes;
+	unsigned long class_hits;
+	unsigned long class_misses;
+	unsigned long alloc_lat[BINDER_ALLOC_LAT_BUCKETS];
+	unsigned long unzeroed_pages;
 };
 
 #ifdef CONFIG_ANDROID_BINDER_IPC_SELFTEST
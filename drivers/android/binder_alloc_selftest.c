@@ -291,6 +291,7 @@ static void binder_selftest_alloc_offset(struct binder_alloc *alloc,
 void binder_selftest_alloc(struct binder_alloc *alloc)
 {
 	size_t end_offset[BUFFER_NUM];
+	bool size_classes;
 
 	if (!binder_selftest_run)
 		return;
@@ -298,7 +299,11 @@ void binder_selftest_alloc(struct binder_alloc *alloc)
 	if (!binder_selftest_run || !alloc->vma)
 		goto done;
 	pr_info("STARTED\n");
+	/* the page checks expect every freed buffer to go through the lru */
+	size_classes = alloc->size_classes;
+	alloc->size_classes = false;
 	binder_selftest_alloc_offset(alloc, end_offset, 0);
+	alloc->size_classes = size_classes;
 	binder_selftest_run = false;
 	if (binder_selftest_failures > 0)
 		pr_info("%d tests FAILED\n", binder_selftest_failures);
@@ -49,6 +49,8 @@ struct driver_private {
 	struct klist_node knode_bus;
 	struct module_kobject *mkobj;
 	struct device_driver *driver;
+	/* async attach scheduled at registration and not yet done */
+	atomic_t async_attach;
 };
 #define to_driver(obj) container_of(obj, struct driver_private, kobj)
 
@@ -0,0 +1,271 @@
+/*
+ * drivers/base/boot_critpath.c - boot critical path through initcalls
+ * and driver probes
+ *
+ * This file is released under the GPLv2.
+ */
+
+#include <linux/async.h>
+#include <linux/atomic.h>
+#include <linux/boot_critpath.h>
+#include <linux/debugfs.h>
+#include <linux/device.h>
+#include <linux/kernel.h>
+#include <linux/moduleparam.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+
+#define BOOT_CRITPATH_MAX_EVENTS	512
+#define BOOT_CRITPATH_NAME_LEN		56
+#define BOOT_CRITPATH_LEVELS		8
+#define BOOT_CRITPATH_TOP		16
+
+enum {
+	CRITPATH_INITCALL,
+	CRITPATH_PROBE,
+	CRITPATH_BARRIER,
+};
+
+struct boot_critpath_event {
+	u64 start;
+	u64 end;
+	u8 type;
+	s8 level;
+	bool async;
+	char name[BOOT_CRITPATH_NAME_LEN];
+};
+
+bool boot_critpath_recording = true;
+
+/* shorter initcalls and probes are not recorded */
+static uint min_us = 500;
+module_param(min_us, uint, 0644);
+MODULE_PARM_DESC(min_us, "Shortest initcall or probe recorded, in us (default: 500)");
+
+static struct boot_critpath_event events[BOOT_CRITPATH_MAX_EVENTS];
+static atomic_t nr_events = ATOMIC_INIT(0);
+static atomic_t dropped = ATOMIC_INIT(0);
+static int cur_level = -1;
+static u64 level_start[BOOT_CRITPATH_LEVELS];
+static u64 level_end[BOOT_CRITPATH_LEVELS];
+static u64 level_barrier[BOOT_CRITPATH_LEVELS];
+static u64 boot_end;
+
+static struct boot_critpath_event *critpath_add(u8 type, u64 start, u64 end)
+{
+	struct boot_critpath_event *ev;
+	int i;
+
+	if (end - start < (u64)min_us * NSEC_PER_USEC)
+		return NULL;
+
+	i = atomic_inc_return(&nr_events) - 1;
+	if (i >= BOOT_CRITPATH_MAX_EVENTS) {
+		atomic_dec(&nr_events);
+		atomic_inc(&dropped);
+		return NULL;
+	}
+
+	ev = &events[i];
+	ev->start = start;
+	ev->end = end;
+	ev->type = type;
+	ev->level = cur_level;
+	ev->async = current_is_async();
+	return ev;
+}
+
+void boot_critpath_set_level(int level)
+{
+	if (!boot_critpath_recording || level >= BOOT_CRITPATH_LEVELS)
+		return;
+
+	cur_level = level;
+	level_start[level] = ktime_get_ns();
+}
+
+void boot_critpath_initcall(initcall_t fn, u64 start)
+{
+	struct boot_critpath_event *ev;
+
+	if (!start)
+		return;
+
+	ev = critpath_add(CRITPATH_INITCALL, start, ktime_get_ns());
+	if (ev)
+		snprintf(ev->name, sizeof(ev->name), "%pf", fn);
+}
+
+void boot_critpath_probe(struct device *dev, struct device_driver *drv,
+			 u64 start)
+{
+	struct boot_critpath_event *ev;
+
+	if (!start)
+		return;
+
+	ev = critpath_add(CRITPATH_PROBE, start, ktime_get_ns());
+	if (ev)
+		snprintf(ev->name, sizeof(ev->name), "%s %s", drv->name,
+			 dev_name(dev));
+}
+
+void boot_critpath_barrier(int level, u64 start)
+{
+	struct boot_critpath_event *ev;
+	u64 end;
+
+	if (!start)
+		return;
+
+	end = ktime_get_ns();
+	if (level < BOOT_CRITPATH_LEVELS) {
+		level_end[level] = end;
+		level_barrier[level] = end - start;
+	}
+
+	ev = critpath_add(CRITPATH_BARRIER, start, end);
+	if (ev)
+		snprintf(ev->name, sizeof(ev->name), "async barrier");
+}
+
+void boot_critpath_done(void)
+{
+	if (!boot_critpath_recording)
+		return;
+
+	boot_end = ktime_get_ns();
+	boot_critpath_recording = false;
+}
+
+static const char * const critpath_type[] = {
+	[CRITPATH_INITCALL]	= "initcall",
+	[CRITPATH_PROBE]	= "probe",
+	[CRITPATH_BARRIER]	= "barrier",
+};
+
+static void critpath_show_event(struct seq_file *m,
+				struct boot_critpath_event *ev)
+{
+	seq_printf(m, "%10llu %10llu  %d  %-8s %-5s %s\n",
+		   div_u64(ev->start, NSEC_PER_USEC),
+		   div_u64(ev->end - ev->start, NSEC_PER_USEC),
+		   ev->level, critpath_type[ev->type],
+		   ev->async ? "async" : "", ev->name);
+}
+
+static int critpath_cmp_duration(const void *a, const void *b)
+{
+	const struct boot_critpath_event *ea = *(struct boot_critpath_event **)a;
+	const struct boot_critpath_event *eb = *(struct boot_critpath_event **)b;
+	u64 da = ea->end - ea->start;
+	u64 db = eb->end - eb->start;
+
+	return da < db ? 1 : (da > db ? -1 : 0);
+}
+
+/*
+ * Walk back from the end of boot: each step takes the initcall or probe
+ * that finished last before the current point, then continues from its
+ * start. Barriers are skipped so that the async probe that held a level
+ * shows up instead of the wait for it.
+ */
+static int critpath_walk(struct boot_critpath_event **path, int n)
+{
+	u64 t = boot_end;
+	int len = 0;
+	int i;
+
+	while (len < n) {
+		struct boot_critpath_event *best = NULL;
+
+		for (i = 0; i < n; i++) {
+			struct boot_critpath_event *ev = &events[i];
+
+			if (ev->type == CRITPATH_BARRIER || ev->end > t ||
+			    ev->start >= t)
+				continue;
+			if (!best || ev->end > best->end ||
+			    (ev->end == best->end && ev->start < best->start))
+				best = ev;
+		}
+		if (!best)
+			break;
+		path[len++] = best;
+		t = best->start;
+	}
+	return len;
+}
+
+static int boot_critpath_show(struct seq_file *m, void *v)
+{
+	struct boot_critpath_event **path;
+	int n = atomic_read(&nr_events);
+	u64 on_path = 0;
+	int len, i;
+
+	if (boot_critpath_recording) {
+		seq_puts(m, "boot in progress\n");
+		return 0;
+	}
+
+	path = kcalloc(max(n, 1), sizeof(*path), GFP_KERNEL);
+	if (!path)
+		return -ENOMEM;
+
+	seq_printf(m, "boot to init: %llu us, %d events >= %u us recorded, %d dropped\n\n",
+		   div_u64(boot_end, NSEC_PER_USEC), n, min_us,
+		   atomic_read(&dropped));
+
+	seq_puts(m, "level    wall(us)  barrier(us)\n");
+	for (i = 0; i < BOOT_CRITPATH_LEVELS; i++) {
+		if (!level_end[i])
+			continue;
+		seq_printf(m, "%5d %11llu %12llu\n", i,
+			   div_u64(level_end[i] - level_start[i], NSEC_PER_USEC),
+			   div_u64(level_barrier[i], NSEC_PER_USEC));
+	}
+
+	len = critpath_walk(path, n);
+	seq_puts(m, "\ncritical path:\n");
+	seq_puts(m, " start(us)   dur(us) lvl type           name\n");
+	for (i = len - 1; i >= 0; i--) {
+		critpath_show_event(m, path[i]);
+		on_path += path[i]->end - path[i]->start;
+	}
+	seq_printf(m, "%d entries, %llu us of %llu us\n", len,
+		   div_u64(on_path, NSEC_PER_USEC),
+		   div_u64(boot_end, NSEC_PER_USEC));
+
+	for (i = 0; i < n; i++)
+		path[i] = &events[i];
+	sort(path, n, sizeof(*path), critpath_cmp_duration, NULL);
+	seq_puts(m, "\nslowest:\n");
+	for (i = 0; i < min(n, BOOT_CRITPATH_TOP); i++)
+		if (path[i]->type != CRITPATH_BARRIER)
+			critpath_show_event(m, path[i]);
+
+	kfree(path);
+	return 0;
+}
+
+static int boot_critpath_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, boot_critpath_show, NULL);
+}
+
+static const struct file_operations boot_critpath_fops = {
+	.open		= boot_critpath_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init boot_critpath_debugfs_init(void)
+{
+	debugfs_create_file("boot_critpath", 0400, NULL, NULL,
+			    &boot_critpath_fops);
+	return 0;
+}
+late_initcall(boot_critpath_debugfs_init);
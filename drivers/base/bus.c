@@ -660,15 +660,41 @@ static ssize_t uevent_store(struct device_driver *drv, const char *buf,
 }
 static DRIVER_ATTR_WO(uevent);
 
+static DECLARE_WAIT_QUEUE_HEAD(async_attach_waitqueue);
+
+/*
+ * Wait for the async attach of the drivers listed in @drv->probe_after.
+ * Only those already registered on the bus are waited for.
+ */
+static void driver_wait_probe_after(struct device_driver *drv)
+{
+	const char * const *name;
+	struct device_driver *dep;
+
+	for (name = drv->probe_after; name && *name; name++) {
+		dep = driver_find(*name, drv->bus);
+		if (!dep || dep == drv)
+			continue;
+		pr_debug("bus: '%s': driver %s waits for %s\n",
+			 drv->bus->name, drv->name, dep->name);
+		wait_event(async_attach_waitqueue,
+			   !atomic_read(&dep->p->async_attach));
+	}
+}
+
 static void driver_attach_async(void *_drv, async_cookie_t cookie)
 {
 	struct device_driver *drv = _drv;
 	int ret;
 
+	driver_wait_probe_after(drv);
 	ret = driver_attach(drv);
 
 	pr_debug("bus: '%s': driver %s async attach completed: %d\n",
 		 drv->bus->name, drv->name, ret);
+
+	atomic_dec(&drv->p->async_attach);
+	wake_up_all(&async_attach_waitqueue);
 }
 
 /**
@@ -706,6 +732,7 @@ int bus_add_driver(struct device_driver *drv)
 		if (driver_allows_async_probing(drv)) {
 			pr_debug("bus: '%s': probing driver %s asynchronously\n",
 				drv->bus->name, drv->name);
+			atomic_inc(&priv->async_attach);
 			async_schedule(driver_attach_async, drv);
 		} else {
 			error = driver_attach(drv);
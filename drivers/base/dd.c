@@ -23,6 +23,7 @@
 #include <linux/kthread.h>
 #include <linux/wait.h>
 #include <linux/async.h>
+#include <linux/boot_critpath.h>
 #include <linux/pm_runtime.h>
 #include <linux/pinctrl/devinfo.h>
 
@@ -413,6 +414,7 @@ EXPORT_SYMBOL_GPL(wait_for_device_probe);
 int driver_probe_device(struct device_driver *drv, struct device *dev)
 {
 	int ret = 0;
+	u64 start;
 
 	if (!device_is_registered(dev))
 		return -ENODEV;
@@ -424,7 +426,9 @@ int driver_probe_device(struct device_driver *drv, struct device *dev)
 		pm_runtime_get_sync(dev->parent);
 
 	pm_runtime_barrier(dev);
+	start = boot_critpath_start();
 	ret = really_probe(dev, drv);
+	boot_critpath_probe(dev, drv, start);
 	pm_request_idle(dev);
 
 	if (dev->parent)
@@ -15,9 +15,15 @@
 #include <linux/sched.h>
 #include <linux/cpu.h>
 #include <linux/crypto.h>
+#include <linux/ktime.h>
 
 #include "zcomp.h"
 
+/* streams kept for CPUs that have none of their own, or a busy one */
+#define ZCOMP_POOL_STREAMS	2
+/* per-cpu streams unused for this long are released */
+#define ZCOMP_IDLE_TIMEOUT	(30 * HZ)
+
 static const char * const backends[] = {
 #if IS_ENABLED(CONFIG_CRYPTO_LZO)
 	"lzo",
@@ -54,10 +60,11 @@ static void zcomp_strm_free(struct zcomp_strm *zstrm)
  */
 static struct zcomp_strm *zcomp_strm_alloc(struct zcomp *comp)
 {
-	struct zcomp_strm *zstrm = kmalloc(sizeof(*zstrm), GFP_KERNEL);
+	struct zcomp_strm *zstrm = kzalloc(sizeof(*zstrm), GFP_KERNEL);
 	if (!zstrm)
 		return NULL;
 
+	INIT_LIST_HEAD(&zstrm->list);
 	zstrm->tfm = crypto_alloc_comp(comp->name, 0, 0);
 	/*
 	 * allocate 2 pages. 1 for compressed data, plus 1 extra for the
@@ -121,13 +128,61 @@ ssize_t zcomp_available_show(const char *comp, char *buf)
 	return sz;
 }
 
+/*
+ * Streams are used with preemption disabled, whether they come from the
+ * CPU or from the pool, so a pool stream is never held for long and it
+ * is fine to spin for one.
+ */
+static struct zcomp_strm *zcomp_pool_get(struct zcomp *comp)
+{
+	struct zcomp_strm *zstrm;
+	u64 start = 0;
+
+	spin_lock(&comp->pool_lock);
+	while (list_empty(&comp->pool)) {
+		spin_unlock(&comp->pool_lock);
+		if (!start)
+			start = ktime_get_ns();
+		cpu_relax();
+		spin_lock(&comp->pool_lock);
+	}
+	zstrm = list_first_entry(&comp->pool, struct zcomp_strm, list);
+	list_del(&zstrm->list);
+	spin_unlock(&comp->pool_lock);
+
+	atomic64_inc(&comp->pool_gets);
+	if (start)
+		atomic64_add(ktime_get_ns() - start, &comp->wait_ns);
+	return zstrm;
+}
+
 struct zcomp_strm *zcomp_stream_get(struct zcomp *comp)
 {
-	return *get_cpu_ptr(comp->stream);
+	struct zcomp_strm *zstrm = READ_ONCE(*get_cpu_ptr(comp->stream));
+
+	if (likely(zstrm && !zstrm->busy)) {
+		zstrm->busy = true;
+		zstrm->last_used = jiffies;
+		return zstrm;
+	}
+
+	/* let the CPU have its own stream next time */
+	if (!zstrm && !cpumask_test_and_set_cpu(smp_processor_id(),
+						&comp->alloc_mask))
+		schedule_work(&comp->alloc_work);
+
+	return zcomp_pool_get(comp);
 }
 
-void zcomp_stream_put(struct zcomp *comp)
+void zcomp_stream_put(struct zcomp *comp, struct zcomp_strm *zstrm)
 {
+	if (zstrm->pooled) {
+		spin_lock(&comp->pool_lock);
+		list_add(&zstrm->list, &comp->pool);
+		spin_unlock(&comp->pool_lock);
+	} else {
+		zstrm->busy = false;
+	}
 	put_cpu_ptr(comp->stream);
 }
 
@@ -165,22 +220,62 @@ int zcomp_decompress(struct zcomp_strm *zstrm,
 			dst, &dst_len);
 }
 
+static void zcomp_alloc_work(struct work_struct *work)
+{
+	struct zcomp *comp = container_of(work, struct zcomp, alloc_work);
+	struct zcomp_strm *zstrm;
+	int cpu;
+
+	get_online_cpus();
+	for_each_cpu(cpu, &comp->alloc_mask) {
+		cpumask_clear_cpu(cpu, &comp->alloc_mask);
+		if (!cpu_online(cpu) || *per_cpu_ptr(comp->stream, cpu))
+			continue;
+		/* on failure the pool keeps serving; retried on next use */
+		zstrm = zcomp_strm_alloc(comp);
+		if (!zstrm)
+			continue;
+		zstrm->last_used = jiffies;
+		smp_store_release(per_cpu_ptr(comp->stream, cpu), zstrm);
+	}
+	put_online_cpus();
+}
+
+static void zcomp_idle_work(struct work_struct *work)
+{
+	struct zcomp *comp = container_of(to_delayed_work(work),
+					  struct zcomp, idle_work);
+	struct zcomp_strm *zstrm, *tmp;
+	LIST_HEAD(idle);
+	int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		zstrm = *per_cpu_ptr(comp->stream, cpu);
+		if (!zstrm || time_before(jiffies, zstrm->last_used +
+					  ZCOMP_IDLE_TIMEOUT))
+			continue;
+		*per_cpu_ptr(comp->stream, cpu) = NULL;
+		list_add(&zstrm->list, &idle);
+	}
+	put_online_cpus();
+
+	if (!list_empty(&idle)) {
+		/* users run with preemption disabled */
+		synchronize_sched();
+		list_for_each_entry_safe(zstrm, tmp, &idle, list)
+			zcomp_strm_free(zstrm);
+	}
+
+	schedule_delayed_work(&comp->idle_work, ZCOMP_IDLE_TIMEOUT);
+}
+
 static int __zcomp_cpu_notifier(struct zcomp *comp,
 		unsigned long action, unsigned long cpu)
 {
 	struct zcomp_strm *zstrm;
 
 	switch (action) {
-	case CPU_UP_PREPARE:
-		if (WARN_ON(*per_cpu_ptr(comp->stream, cpu)))
-			break;
-		zstrm = zcomp_strm_alloc(comp);
-		if (IS_ERR_OR_NULL(zstrm)) {
-			pr_err("Can't allocate a compression stream\n");
-			return NOTIFY_BAD;
-		}
-		*per_cpu_ptr(comp->stream, cpu) = zstrm;
-		break;
 	case CPU_DEAD:
 	case CPU_UP_CANCELED:
 		zstrm = *per_cpu_ptr(comp->stream, cpu);
@@ -203,44 +298,62 @@ static int zcomp_cpu_notifier(struct notifier_block *nb,
 	return __zcomp_cpu_notifier(comp, action, cpu);
 }
 
+static void zcomp_pool_free(struct zcomp *comp)
+{
+	struct zcomp_strm *zstrm, *tmp;
+
+	list_for_each_entry_safe(zstrm, tmp, &comp->pool, list) {
+		list_del(&zstrm->list);
+		zcomp_strm_free(zstrm);
+	}
+}
+
 static int zcomp_init(struct zcomp *comp)
 {
-	unsigned long cpu;
-	int ret;
+	struct zcomp_strm *zstrm;
+	int i;
 
 	comp->notifier.notifier_call = zcomp_cpu_notifier;
+	INIT_WORK(&comp->alloc_work, zcomp_alloc_work);
+	INIT_DELAYED_WORK(&comp->idle_work, zcomp_idle_work);
+	spin_lock_init(&comp->pool_lock);
+	INIT_LIST_HEAD(&comp->pool);
 
 	comp->stream = alloc_percpu(struct zcomp_strm *);
 	if (!comp->stream)
 		return -ENOMEM;
 
-	cpu_notifier_register_begin();
-	for_each_online_cpu(cpu) {
-		ret = __zcomp_cpu_notifier(comp, CPU_UP_PREPARE, cpu);
-		if (ret == NOTIFY_BAD)
-			goto cleanup;
+	for (i = 0; i < ZCOMP_POOL_STREAMS; i++) {
+		zstrm = zcomp_strm_alloc(comp);
+		if (!zstrm) {
+			pr_err("Can't allocate a compression stream\n");
+			zcomp_pool_free(comp);
+			free_percpu(comp->stream);
+			return -ENOMEM;
+		}
+		zstrm->pooled = true;
+		list_add(&zstrm->list, &comp->pool);
 	}
-	__register_cpu_notifier(&comp->notifier);
-	cpu_notifier_register_done();
-	return 0;
 
-cleanup:
-	for_each_online_cpu(cpu)
-		__zcomp_cpu_notifier(comp, CPU_UP_CANCELED, cpu);
-	cpu_notifier_register_done();
-	return -ENOMEM;
+	register_cpu_notifier(&comp->notifier);
+	schedule_delayed_work(&comp->idle_work, ZCOMP_IDLE_TIMEOUT);
+	return 0;
 }
 
 void zcomp_destroy(struct zcomp *comp)
 {
 	unsigned long cpu;
 
+	cancel_work_sync(&comp->alloc_work);
+	cancel_delayed_work_sync(&comp->idle_work);
+
 	cpu_notifier_register_begin();
-	for_each_online_cpu(cpu)
+	for_each_possible_cpu(cpu)
 		__zcomp_cpu_notifier(comp, CPU_UP_CANCELED, cpu);
 	__unregister_cpu_notifier(&comp->notifier);
 	cpu_notifier_register_done();
 
+	zcomp_pool_free(comp);
 	free_percpu(comp->stream);
 	kfree(comp);
 }
@@ -10,16 +10,37 @@
 #ifndef _ZCOMP_H_
 #define _ZCOMP_H_
 
+#include <linux/cpumask.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+#include <linux/workqueue.h>
+
 struct zcomp_strm {
 	/* compression/decompression buffer */
 	void *buffer;
 	struct crypto_comp *tfm;
+	/* shared pool linkage, or pending free for idle per-cpu streams */
+	struct list_head list;
+	unsigned long last_used;
+	bool busy;
+	bool pooled;
 };
 
 /* dynamic per-device compression frontend */
 struct zcomp {
+	/* allocated on first use, freed when idle or at CPU offline */
 	struct zcomp_strm * __percpu *stream;
 	struct notifier_block notifier;
+	cpumask_t alloc_mask;
+	struct work_struct alloc_work;
+	struct delayed_work idle_work;
+
+	/* fallback for CPUs whose own stream is missing or busy */
+	spinlock_t pool_lock;
+	struct list_head pool;
+
+	atomic64_t pool_gets;
+	atomic64_t wait_ns;
 
 	const char *name;
 };
@@ -31,7 +52,7 @@ struct zcomp *zcomp_create(const char *comp);
 void zcomp_destroy(struct zcomp *comp);
 
 struct zcomp_strm *zcomp_stream_get(struct zcomp *comp);
-void zcomp_stream_put(struct zcomp *comp);
+void zcomp_stream_put(struct zcomp *comp, struct zcomp_strm *zstrm);
 
 int zcomp_compress(struct zcomp_strm *zstrm,
 		const void *src, unsigned int *dst_len);
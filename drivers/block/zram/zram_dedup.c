@@ -0,0 +1,202 @@
+/*
+ * Deduplication of identical pages stored in zram
+ *
+ * Every compressed object is indexed by the xxhash of its uncompressed
+ * content. A page whose hash is already known is compared against the
+ * stored object and, when identical, shares its zsmalloc handle instead
+ * of being compressed and stored again.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#define KMSG_COMPONENT "zram"
+#define pr_fmt(fmt) KMSG_COMPONENT ": " fmt
+
+#include <linux/highmem.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
+#include <linux/xxhash.h>
+
+#include "zram_drv.h"
+
+/* One bucket for each two pages, within these bounds */
+#define ZRAM_HASH_SIZE_MIN	(1 << 10)
+#define ZRAM_HASH_SIZE_MAX	(1UL << 31)
+
+static struct zram_hash *zram_dedup_bucket(struct zram *zram, u64 checksum)
+{
+	return &zram->hash[checksum & (zram->hash_size - 1)];
+}
+
+static bool zram_dedup_match(struct zram *zram, struct zram_dedup_entry *entry,
+				struct page *page)
+{
+	struct zcomp_strm *zstrm;
+	void *src, *mem;
+	bool match = false;
+	int ret = 0;
+
+	src = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+	if (entry->len == PAGE_SIZE) {
+		mem = kmap_atomic(page);
+		match = !memcmp(mem, src, PAGE_SIZE);
+		kunmap_atomic(mem);
+	} else {
+		/* the stream buffer is free until we put the stream */
+		zstrm = zcomp_stream_get(zram->comp);
+		ret = zcomp_decompress(zstrm, src, entry->len, zstrm->buffer);
+		if (!ret) {
+			mem = kmap_atomic(page);
+			match = !memcmp(mem, zstrm->buffer, PAGE_SIZE);
+			kunmap_atomic(mem);
+		}
+		zcomp_stream_put(zram->comp, zstrm);
+	}
+	zs_unmap_object(zram->mem_pool, entry->handle);
+
+	return match;
+}
+
+/*
+ * Look up an object with the same content as @page. On success a reference
+ * is taken on the returned entry. The checksum of the page is returned in
+ * @checksum either way so it can be used for zram_dedup_insert().
+ */
+struct zram_dedup_entry *zram_dedup_find(struct zram *zram, struct page *page,
+				u64 *checksum)
+{
+	struct zram_dedup_entry *entry = NULL;
+	struct zram_hash *hash;
+	struct rb_node *rb_node;
+	void *mem;
+
+	mem = kmap_atomic(page);
+	*checksum = xxh64(mem, PAGE_SIZE, 0);
+	kunmap_atomic(mem);
+
+	hash = zram_dedup_bucket(zram, *checksum);
+	spin_lock(&hash->lock);
+	rb_node = hash->rb_root.rb_node;
+	while (rb_node) {
+		struct zram_dedup_entry *cur;
+
+		cur = rb_entry(rb_node, struct zram_dedup_entry, rb_node);
+		if (*checksum == cur->checksum) {
+			cur->refcount++;
+			entry = cur;
+			break;
+		}
+		rb_node = *checksum < cur->checksum ?
+				rb_node->rb_left : rb_node->rb_right;
+	}
+	spin_unlock(&hash->lock);
+
+	if (!entry)
+		return NULL;
+
+	/* xxh64 collisions are rare enough to only try the first candidate */
+	if (zram_dedup_match(zram, entry, page))
+		return entry;
+
+	zram_dedup_put(zram, entry);
+	return NULL;
+}
+
+/*
+ * Index a freshly stored object. Returns the entry holding the first
+ * reference, or NULL if the object could not be indexed, in which case the
+ * caller keeps owning @handle.
+ */
+struct zram_dedup_entry *zram_dedup_insert(struct zram *zram,
+				unsigned long handle, unsigned int len,
+				u64 checksum)
+{
+	struct zram_dedup_entry *entry;
+	struct zram_hash *hash;
+	struct rb_node **rb_node, *parent = NULL;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return NULL;
+
+	entry->checksum = checksum;
+	entry->handle = handle;
+	entry->len = len;
+	entry->refcount = 1;
+
+	hash = zram_dedup_bucket(zram, checksum);
+	spin_lock(&hash->lock);
+	rb_node = &hash->rb_root.rb_node;
+	while (*rb_node) {
+		struct zram_dedup_entry *cur;
+
+		parent = *rb_node;
+		cur = rb_entry(parent, struct zram_dedup_entry, rb_node);
+		rb_node = checksum < cur->checksum ?
+				&parent->rb_left : &parent->rb_right;
+	}
+	rb_link_node(&entry->rb_node, parent, rb_node);
+	rb_insert_color(&entry->rb_node, &hash->rb_root);
+	spin_unlock(&hash->lock);
+
+	atomic64_add(sizeof(*entry), &zram->stats.meta_data_size);
+	return entry;
+}
+
+/*
+ * Drop a reference. Returns true if it was the last one, in which case the
+ * zsmalloc object has been freed as well.
+ */
+bool zram_dedup_put(struct zram *zram, struct zram_dedup_entry *entry)
+{
+	struct zram_hash *hash = zram_dedup_bucket(zram, entry->checksum);
+	bool last;
+
+	spin_lock(&hash->lock);
+	last = !--entry->refcount;
+	if (last)
+		rb_erase(&entry->rb_node, &hash->rb_root);
+	spin_unlock(&hash->lock);
+
+	if (!last)
+		return false;
+
+	zs_free(zram->mem_pool, entry->handle);
+	kfree(entry);
+	atomic64_sub(sizeof(*entry), &zram->stats.meta_data_size);
+	return true;
+}
+
+int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	size_t i;
+
+	if (!zram->use_dedup)
+		return 0;
+
+	zram->hash_size = roundup_pow_of_two(max_t(size_t, num_pages >> 1,
+						   ZRAM_HASH_SIZE_MIN));
+	zram->hash_size = min_t(size_t, zram->hash_size, ZRAM_HASH_SIZE_MAX);
+	zram->hash = vzalloc(zram->hash_size * sizeof(struct zram_hash));
+	if (!zram->hash) {
+		pr_err("Error allocating zram entry hash\n");
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < zram->hash_size; i++) {
+		spin_lock_init(&zram->hash[i].lock);
+		zram->hash[i].rb_root = RB_ROOT;
+	}
+
+	return 0;
+}
+
+void zram_dedup_fini(struct zram *zram)
+{
+	vfree(zram->hash);
+	zram->hash = NULL;
+	zram->hash_size = 0;
+}
@@ -0,0 +1,58 @@
+/*
+ * Deduplication of identical pages stored in zram
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef _ZRAM_DEDUP_H_
+#define _ZRAM_DEDUP_H_
+
+#include <linux/rbtree.h>
+#include <linux/spinlock.h>
+
+struct zram;
+struct page;
+
+/* values of zram->use_dedup */
+enum zram_dedup_mode {
+	ZRAM_DEDUP_OFF,
+	ZRAM_DEDUP_ALL,
+	ZRAM_DEDUP_KSM,		/* only pages merged by KSM */
+};
+
+/* A zsmalloc object shared by all slots holding the same content */
+struct zram_dedup_entry {
+	struct rb_node rb_node;
+	u64 checksum;
+	unsigned long handle;
+	unsigned int len;
+	unsigned long refcount;	/* protected by zram_hash.lock */
+};
+
+struct zram_hash {
+	spinlock_t lock;
+	struct rb_root rb_root;
+};
+
+#ifdef CONFIG_ZRAM_DEDUP
+struct zram_dedup_entry *zram_dedup_find(struct zram *zram, struct page *page,
+				u64 *checksum);
+struct zram_dedup_entry *zram_dedup_insert(struct zram *zram,
+				unsigned long handle, unsigned int len,
+				u64 checksum);
+bool zram_dedup_put(struct zram *zram, struct zram_dedup_entry *entry);
+
+int zram_dedup_init(struct zram *zram, size_t num_pages);
+void zram_dedup_fini(struct zram *zram);
+#else
+static inline int zram_dedup_init(struct zram *zram, size_t num_pages)
+{
+	return 0;
+}
+static inline void zram_dedup_fini(struct zram *zram) {}
+#endif
+
+#endif /* _ZRAM_DEDUP_H_ */
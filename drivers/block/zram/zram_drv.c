@@ -30,6 +30,8 @@
 #include <linux/vmalloc.h>
 #include <linux/err.h>
 #include <linux/idr.h>
+#include <linux/ioprio.h>
+#include <linux/blk-boost.h>
 #include <linux/sysfs.h>
 #include <linux/debugfs.h>
 #include <linux/kthread.h>
@@ -37,6 +39,7 @@
 #include <linux/jiffies.h>
 #include <linux/vmstat.h>
 #include <linux/statfs.h>
+#include <linux/page-flags.h>
 #include <uapi/linux/sched.h>
 
 #include "zram_drv.h"
@@ -98,6 +101,14 @@ static inline struct zram *dev_to_zram(struct device *dev)
 
 static unsigned long zram_get_handle(struct zram *zram, u32 index)
 {
+#ifdef CONFIG_ZRAM_DEDUP
+	if (zram->table[index].flags & BIT(ZRAM_DEDUP)) {
+		struct zram_dedup_entry *entry;
+
+		entry = (struct zram_dedup_entry *)zram->table[index].handle;
+		return entry->handle;
+	}
+#endif
 	return zram->table[index].handle;
 }
 
@@ -106,6 +117,56 @@ static void zram_set_handle(struct zram *zram, u32 index, unsigned long handle)
 	zram->table[index].handle = handle;
 }
 
+static inline unsigned long zram_state_bit(u32 index,
+			enum zram_slot_state state)
+{
+	return (unsigned long)index * __NR_ZRAM_STATES + state;
+}
+
+/* keep zram->slot_state in sync with the flags it mirrors */
+static inline void zram_update_state(struct zram *zram, u32 index,
+			enum zram_pageflags flag, bool set)
+{
+	enum zram_slot_state state;
+
+	switch (flag) {
+	case ZRAM_SAME:
+		state = ZRAM_STATE_SAME;
+		break;
+	case ZRAM_WB:
+		state = ZRAM_STATE_WB;
+		break;
+	default:
+		return;
+	}
+
+	if (set)
+		set_bit(zram_state_bit(index, state), zram->slot_state);
+	else
+		clear_bit(zram_state_bit(index, state), zram->slot_state);
+}
+
+/*
+ * Lockless peek at the packed slot state. The answer can be stale by the
+ * time it is used, so it is only good for skipping slots early; anything
+ * acting on the slot has to check again under the slot lock.
+ */
+static bool zram_peek_state(struct zram *zram, u32 index,
+			enum zram_slot_state state)
+{
+	unsigned long bit = zram_state_bit(index, state);
+
+	return (READ_ONCE(zram->slot_state[BIT_WORD(bit)]) >>
+			(bit % BITS_PER_LONG)) & 1;
+}
+
+/* no SAME or WB slot can be written back, recompressed, ... */
+static bool zram_peek_skip(struct zram *zram, u32 index)
+{
+	return zram_peek_state(zram, index, ZRAM_STATE_SAME) ||
+		zram_peek_state(zram, index, ZRAM_STATE_WB);
+}
+
 /* flag operations require table entry bit_spin_lock() being held */
 static bool zram_test_flag(struct zram *zram, u32 index,
 			enum zram_pageflags flag)
@@ -113,16 +174,25 @@ static bool zram_test_flag(struct zram *zram, u32 index,
 	return zram->table[index].flags & BIT(flag);
 }
 
+/* same as zram_test_flag, for hints that are fine with a racy answer */
+static bool zram_test_flag_lockless(struct zram *zram, u32 index,
+			enum zram_pageflags flag)
+{
+	return READ_ONCE(zram->table[index].flags) & BIT(flag);
+}
+
 static void zram_set_flag(struct zram *zram, u32 index,
 			enum zram_pageflags flag)
 {
 	zram->table[index].flags |= BIT(flag);
+	zram_update_state(zram, index, flag, true);
 }
 
 static void zram_clear_flag(struct zram *zram, u32 index,
 			enum zram_pageflags flag)
 {
 	zram->table[index].flags &= ~BIT(flag);
+	zram_update_state(zram, index, flag, false);
 }
 
 static inline void zram_set_element(struct zram *zram, u32 index,
@@ -156,6 +226,35 @@ static inline bool zram_allocated(struct zram *zram, u32 index)
 			zram_test_flag(zram, index, ZRAM_WB);
 }
 
+static void zram_set_priority(struct zram *zram, u32 index, u32 prio)
+{
+	prio &= ZRAM_COMP_PRIORITY_MASK;
+	/*
+	 * Clear previous priority value first, in case if we recompress
+	 * further an already recompressed page
+	 */
+	zram->table[index].flags &= ~((unsigned long)ZRAM_COMP_PRIORITY_MASK <<
+				      ZRAM_COMP_PRIORITY_BIT1);
+	zram->table[index].flags |= ((unsigned long)prio <<
+				     ZRAM_COMP_PRIORITY_BIT1);
+}
+
+static u32 zram_get_priority(struct zram *zram, u32 index)
+{
+	u32 prio = zram->table[index].flags >> ZRAM_COMP_PRIORITY_BIT1;
+
+	return prio & ZRAM_COMP_PRIORITY_MASK;
+}
+
+static struct zcomp *zram_prio_comp(struct zram *zram, u32 prio)
+{
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	if (prio == ZRAM_SECONDARY_COMP && zram->recomp)
+		return zram->recomp;
+#endif
+	return zram->comp;
+}
+
 #if PAGE_SIZE != 4096
 static inline bool is_partial_io(struct bio_vec *bvec)
 {
@@ -347,6 +446,7 @@ static ssize_t idle_store(struct device *dev,
 #ifdef CONFIG_ZRAM_WRITEBACK
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
 static int zram_wbd(void *);
+static void zram_wb_ctrl_work(struct work_struct *work);
 static struct zram *g_zram;
 static bool is_app_launch;
 
@@ -379,9 +479,15 @@ static int init_lru_writeback(struct zram *zram)
 		goto out;
 	}
 
+	memset(&zram->wb_ctrl, 0, sizeof(zram->wb_ctrl));
+	INIT_DEFERRABLE_WORK(&zram->wb_ctrl.work, zram_wb_ctrl_work);
+	zram->wb_ctrl.enable = true;
+	zram->wb_ctrl.last_free = global_page_state(NR_FREE_PAGES);
+
 	g_zram = zram;
 	zram->wb_limit_enable = true;
 	sched_setscheduler(zram->wbd, SCHED_IDLE, &param);
+	schedule_delayed_work(&zram->wb_ctrl.work, 0);
 
 	return ret;
 out:
@@ -398,6 +504,7 @@ static void stop_lru_writeback(struct zram *zram)
 {
 	if (!IS_ERR_OR_NULL(zram->wbd)) {
 		g_zram = NULL;
+		cancel_delayed_work_sync(&zram->wb_ctrl.work);
 		kthread_stop(zram->wbd);
 		zram->wbd = NULL;
 	}
@@ -895,10 +1002,9 @@ static bool zram_wb_available(struct zram *zram)
 	return true;
 }
 
-static u32 entry_to_index(struct zram *zram, struct zram_table_entry *entry)
+static u32 lru_to_index(struct zram *zram, struct list_head *node)
 {
-	return (u32)(((unsigned long)entry - (unsigned long)zram->table) /
-			sizeof(struct zram_table_entry));
+	return (u32)(node - zram->lru);
 }
 
 #define SKIP 1
@@ -931,8 +1037,10 @@ void free_zwbs(struct zwbs **zwbs)
 	for (i = 0; i < NR_ZWBS; i++) {
 		if (!zwbs[i])
 			return;
-		if (zwbs[i]->page)
+		if (zwbs[i]->page) {
+			set_page_private(zwbs[i]->page, 0);
 			__free_page(zwbs[i]->page);
+		}
 		kfree(zwbs[i]);
 	}
 }
@@ -948,6 +1056,8 @@ int alloc_zwbs(struct zwbs **zwbs)
 		zwbs[i]->page = alloc_page(GFP_KERNEL);
 		if (!zwbs[i]->page)
 			goto out;
+		/* lets the bio completion find the zwbs of each bvec */
+		set_page_private(zwbs[i]->page, (unsigned long)zwbs[i]);
 	}
 	return 0;
 out:
@@ -984,6 +1094,17 @@ static bool zram_should_writeback(struct zram *zram,
 	if (pages > max_pages)
 		return false;
 
+	/*
+	 * The controller's budget, enforced through writeback_limit, takes
+	 * the place of the trigger interval and the ratio hysteresis.
+	 */
+	if (zram->wb_ctrl.enable) {
+		if (trigger && READ_ONCE(zram->wb_ctrl.budget) < NR_ZWBS)
+			return false;
+		return min_stored <= stored &&
+			writtenback_ratio <= zram_balance_ratio;
+	}
+
 	/* do not trigger again before time interval */
 	if (trigger && time_is_after_jiffies(time_stamp))
 		return false;
@@ -1020,17 +1141,147 @@ static void try_wakeup_zram_wbd(struct zram *zram)
 	}
 }
 
+/* share of the measured backing device bandwidth writeback may use */
+static int zram_wb_duty = 25;
+module_param(zram_wb_duty, int, 0644);
+
+#define ZRAM_WB_CTRL_WINDOW	(5 * HZ)
+
+/* hand the budget of the coming window to the writeback_limit accounting */
+static void zram_wb_ctrl_apply(struct zram *zram)
+{
+	struct zram_wb_ctrl *ctrl = &zram->wb_ctrl;
+
+	if (!ctrl->enable)
+		return;
+
+	spin_lock(&zram->wb_limit_lock);
+	zram->wb_limit_enable = true;
+	zram->bd_wb_limit = (u64)ctrl->budget << (PAGE_SHIFT - 12);
+	spin_unlock(&zram->wb_limit_lock);
+}
+
+/*
+ * Additive increase while free memory keeps falling, multiplicative
+ * decrease when written back pages are read back in, and a slow decay
+ * otherwise. The budget never exceeds the duty share of what the backing
+ * device was last measured to sustain over a window, and is zero while
+ * an app is launching.
+ */
+static void zram_wb_ctrl_update(struct zram *zram)
+{
+	struct zram_wb_ctrl *ctrl = &zram->wb_ctrl;
+	u64 reads = atomic64_read(&zram->stats.bd_reads);
+	u64 writes = atomic64_read(&zram->stats.bd_writes);
+	unsigned long free = global_page_state(NR_FREE_PAGES);
+	unsigned long kbps = atomic64_read(&zram->stats.bd_wb_kbps);
+	unsigned long budget = ctrl->budget;
+	unsigned long cap = CONFIG_ZRAM_LRU_WRITEBACK_LIMIT;
+
+	ctrl->swapin = reads - ctrl->last_reads;
+	ctrl->written = writes - ctrl->last_writes;
+	ctrl->free_delta = (long)free - (long)ctrl->last_free;
+	ctrl->last_reads = reads;
+	ctrl->last_writes = writes;
+	ctrl->last_free = free;
+
+	if (kbps)
+		ctrl->kbps = ctrl->kbps ? (3 * ctrl->kbps + kbps) / 4 : kbps;
+	/* until a run has been measured, the per-run limit is the cap */
+	if (ctrl->kbps)
+		cap = min_t(unsigned long, cap, ctrl->kbps * 1024 / PAGE_SIZE *
+			    (ZRAM_WB_CTRL_WINDOW / HZ) * zram_wb_duty / 100);
+
+	if (is_app_launch)
+		budget = 0;
+	else if (ctrl->swapin > NR_ZWBS && ctrl->swapin * 2 > ctrl->written)
+		budget /= 2;
+	else if (ctrl->free_delta < 0)
+		budget += max_t(unsigned long, -ctrl->free_delta, NR_ZWBS);
+	else
+		budget -= budget / 4;
+
+	ctrl->budget = min(budget, cap);
+}
+
+static void zram_wb_ctrl_work(struct work_struct *work)
+{
+	struct zram *zram = container_of(to_delayed_work(work),
+					 struct zram, wb_ctrl.work);
+
+	if (zram->wb_ctrl.enable) {
+		zram_wb_ctrl_update(zram);
+		zram_wb_ctrl_apply(zram);
+		try_wakeup_zram_wbd(zram);
+	}
+
+	schedule_delayed_work(&zram->wb_ctrl.work, ZRAM_WB_CTRL_WINDOW);
+}
+
 static int zram_app_launch_notifier(struct notifier_block *nb,
 				unsigned long action, void *data)
 {
 	is_app_launch = action ? true : false;
 
-	if (!is_app_launch && g_zram)
+	if (!g_zram)
+		return 0;
+
+	if (g_zram->wb_ctrl.enable) {
+		/* stop right away, and start a new window once done */
+		if (is_app_launch) {
+			g_zram->wb_ctrl.budget = 0;
+			zram_wb_ctrl_apply(g_zram);
+		} else {
+			mod_delayed_work(system_wq, &g_zram->wb_ctrl.work, 0);
+		}
+	} else if (!is_app_launch) {
 		try_wakeup_zram_wbd(g_zram);
+	}
 
 	return 0;
 }
 
+static ssize_t writeback_ctrl_enable_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	u64 val;
+
+	if (kstrtoull(buf, 10, &val))
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	zram->wb_ctrl.enable = val;
+	up_read(&zram->init_lock);
+
+	return len;
+}
+
+static ssize_t writeback_ctrl_enable_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%d\n", zram->wb_ctrl.enable);
+}
+
+static ssize_t writeback_ctrl_stat_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct zram *zram = dev_to_zram(dev);
+	struct zram_wb_ctrl *ctrl = &zram->wb_ctrl;
+	ssize_t ret;
+
+	down_read(&zram->init_lock);
+	ret = scnprintf(buf, PAGE_SIZE,
+			"%8lu %8lu %8lu %8lu %8ld\n",
+			ctrl->budget, ctrl->kbps, ctrl->written,
+			ctrl->swapin, ctrl->free_delta);
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+
 static struct notifier_block zram_app_launch_nb = {
 	.notifier_call = zram_app_launch_notifier,
 };
@@ -1047,6 +1298,7 @@ static void mark_end_of_page(struct zwbs *zwbs)
 		zhdr = (struct zram_wb_header *)(mem + offset);
 		zhdr->index = UINT_MAX;
 		zhdr->size = 0;
+		zhdr->prio = 0;
 		kunmap_atomic(mem);
 	}
 }
@@ -1087,7 +1339,7 @@ static int zram_writeback_fill_page(struct zram *zram, u32 index,
 	/* Need for hugepage writeback racing */
 	zram_set_flag(zram, index, ZRAM_IDLE);
 
-	handle = zram_get_element(zram, index);
+	handle = zram_get_handle(zram, index);
 	if (!handle) {
 		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
 		zram_clear_flag(zram, index, ZRAM_IDLE);
@@ -1100,6 +1352,7 @@ static int zram_writeback_fill_page(struct zram *zram, u32 index,
 		zhdr = (struct zram_wb_header *)(dst + offset);
 		zhdr->index = index;
 		zhdr->size = size;
+		zhdr->prio = zram_get_priority(zram, index);
 		dst = (u8 *)(zhdr + 1);
 	}
 	memcpy(dst, src, size);
@@ -1183,127 +1436,335 @@ static void zram_writeback_done(struct zram *zram,
 	}
 }
 
-static void zram_writeback_end_io(struct bio *bio)
+static struct zram_wb_ctx *zram_wb_ctx_alloc(struct zram *zram)
 {
-	if (g_zram && !g_zram->io_complete) {
-		g_zram->io_complete = true;
-		wake_up(&g_zram->wbd_wait);
+	struct zram_wb_ctx *ctx;
+	int i;
+
+	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
+	if (!ctx)
+		return NULL;
+
+	ctx->zram = zram;
+	spin_lock_init(&ctx->lock);
+	INIT_LIST_HEAD(&ctx->free);
+	INIT_LIST_HEAD(&ctx->done);
+	init_waitqueue_head(&ctx->wait);
+
+	for (i = 0; i < ZRAM_WB_MAX_INFLIGHT; i++) {
+		struct zram_wb_batch *batch = &ctx->batch[i];
+
+		if (alloc_zwbs(batch->zwbs))
+			goto out;
+		batch->ctx = ctx;
+		list_add_tail(&batch->list, &ctx->free);
 	}
+	return ctx;
+out:
+	while (--i >= 0)
+		free_zwbs(ctx->batch[i].zwbs);
+	kfree(ctx);
+	return NULL;
 }
 
-static int zram_writeback_page(struct zram *zram, struct zwbs **zwbs,
-			       int nr_to_write, bool sync)
+static void zram_wb_ctx_free(struct zram_wb_ctx *ctx)
 {
-	struct bio bio;
-	struct bio_vec *bio_vec;
-	unsigned long blk_idx;
-	int ret = 0;
-	int i, idx = 0;
-	int nr_pages = nr_to_write;
-retry:
-	blk_idx = try_alloc_block_bdev(zram, &nr_pages);
-	if (!blk_idx) {
-		ret = -ENOSPC;
-		goto out;
-	}
+	int i;
 
-	bio_vec = kmalloc_array(nr_pages, sizeof(struct bio_vec), GFP_KERNEL);
-	if (!bio_vec) {
-		ret = -ENOSPC;
-		goto out;
+	for (i = 0; i < ZRAM_WB_MAX_INFLIGHT; i++)
+		free_zwbs(ctx->batch[i].zwbs);
+	kfree(ctx);
+}
+
+static void zram_wb_batch_put(struct zram_wb_batch *batch)
+{
+	struct zram_wb_ctx *ctx = batch->ctx;
+	unsigned long flags;
+
+	if (!atomic_dec_and_test(&batch->pending))
+		return;
+
+	batch->done_time = ktime_get();
+	/*
+	 * Wake up under the lock: the waiter rechecks its condition under
+	 * the same lock, so ctx can't go away before we are done with it.
+	 */
+	spin_lock_irqsave(&ctx->lock, flags);
+	list_add_tail(&batch->list, &ctx->done);
+	ctx->inflight--;
+	wake_up(&ctx->wait);
+	spin_unlock_irqrestore(&ctx->lock, flags);
+}
+
+static void zram_writeback_end_io(struct bio *bio)
+{
+	struct zram_wb_batch *batch = bio->bi_private;
+	struct bio_vec *bvec;
+	int i;
+
+	if (bio->bi_error) {
+		bio_for_each_segment_all(bvec, bio, i) {
+			struct zwbs *zwbs;
+
+			zwbs = (struct zwbs *)page_private(bvec->bv_page);
+			zwbs->error = bio->bi_error;
+		}
 	}
+	bio_put(bio);
+	zram_wb_batch_put(batch);
+}
 
-	bio_init(&bio);
+/*
+ * Finish a batch in process context: hand the written slots over to the
+ * backing device, or roll back the slots of the pages that failed.
+ */
+static void zram_wb_complete(struct zram *zram, struct zram_wb_batch *batch)
+{
+	unsigned long written = 0;
+	u64 lat_us, max_us;
+	int i;
 
-	bio.bi_max_vecs = nr_pages;
-	bio.bi_io_vec = bio_vec;
-	bio.bi_bdev = zram->bdev;
+	for (i = 0; i < batch->nr; i++) {
+		struct zwbs *zwbs = batch->zwbs[i];
 
-	bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
-	for (i = 0; i < nr_pages; i++)
-		bio_add_page(&bio, zwbs[idx + i]->page, PAGE_SIZE, 0);
-	if (sync) {
-		ret = submit_bio_wait(WRITE, &bio);
-	} else {
-		bio.bi_end_io = zram_writeback_end_io;
-		zram->io_complete = false;
-		submit_bio(WRITE, &bio);
-		wait_event(zram->wbd_wait, zram->io_complete);
-		ret = bio.bi_error;
+		if (zwbs->error) {
+			if (zwbs->blk_idx)
+				free_block_bdev(zram, zwbs->blk_idx);
+			zram_writeback_clear_flag(zram, zwbs);
+		} else {
+			zram_writeback_done(zram, zwbs, zwbs->blk_idx);
+			written++;
+		}
+		zwbs->cnt = 0;
+		zwbs->off = 0;
+		zwbs->blk_idx = 0;
+		zwbs->error = 0;
 	}
-	kfree(bio_vec);
-out:
-	if (!ret) {
-		for (i = 0; i < nr_pages; i++)
-			zram_writeback_done(zram, zwbs[idx + i], blk_idx + i);
+	batch->nr = 0;
 
-		atomic64_add(nr_pages, &zram->stats.bd_writes);
+	if (written) {
+		atomic64_add(written, &zram->stats.bd_writes);
 		spin_lock(&zram->wb_limit_lock);
 		if (zram->wb_limit_enable) {
-			if (zram->bd_wb_limit > nr_pages)
-				zram->bd_wb_limit -= nr_pages;
+			if (zram->bd_wb_limit > written)
+				zram->bd_wb_limit -= written;
 			else
 				zram->bd_wb_limit = 0;
 		}
 		spin_unlock(&zram->wb_limit_lock);
+		batch->ctx->nr_written += written;
+	}
+
+	lat_us = ktime_us_delta(batch->done_time, batch->submit_time);
+	atomic64_inc(&zram->stats.bd_wb_batches);
+	atomic64_add(lat_us, &zram->stats.bd_wb_lat_us);
+	max_us = atomic64_read(&zram->stats.bd_wb_lat_max_us);
+	while (lat_us > max_us) {
+		u64 old = atomic64_cmpxchg(&zram->stats.bd_wb_lat_max_us,
+					   max_us, lat_us);
+		if (old == max_us)
+			break;
+		max_us = old;
+	}
+}
+
+static void zram_wb_reap(struct zram_wb_ctx *ctx)
+{
+	struct zram_wb_batch *batch, *n;
+	LIST_HEAD(done);
+
+	spin_lock_irq(&ctx->lock);
+	list_splice_init(&ctx->done, &done);
+	spin_unlock_irq(&ctx->lock);
+
+	list_for_each_entry_safe(batch, n, &done, list) {
+		zram_wb_complete(ctx->zram, batch);
+		spin_lock_irq(&ctx->lock);
+		list_move_tail(&batch->list, &ctx->free);
+		spin_unlock_irq(&ctx->lock);
+	}
+}
+
+static bool zram_wb_has_done(struct zram_wb_ctx *ctx)
+{
+	bool ret;
+
+	spin_lock_irq(&ctx->lock);
+	ret = !list_empty(&ctx->done);
+	spin_unlock_irq(&ctx->lock);
+
+	return ret;
+}
+
+static bool zram_wb_idle(struct zram_wb_ctx *ctx)
+{
+	bool ret;
+
+	spin_lock_irq(&ctx->lock);
+	ret = !ctx->inflight;
+	spin_unlock_irq(&ctx->lock);
+
+	return ret;
+}
+
+/* get an empty batch, waiting for writes in flight when all are busy */
+static struct zram_wb_batch *zram_wb_get_batch(struct zram_wb_ctx *ctx)
+{
+	struct zram_wb_batch *batch;
+
+	for (;;) {
+		zram_wb_reap(ctx);
+
+		spin_lock_irq(&ctx->lock);
+		batch = list_first_entry_or_null(&ctx->free,
+				struct zram_wb_batch, list);
+		if (batch)
+			list_del_init(&batch->list);
+		spin_unlock_irq(&ctx->lock);
+		if (batch)
+			return batch;
+
+		wait_event(ctx->wait, zram_wb_has_done(ctx));
+	}
+}
+
+/*
+ * Submit the first nr_to_write pages of the current batch without waiting
+ * for them. The pages go to one contiguous chunk when a free one exists,
+ * otherwise to single blocks; all bios of a batch are issued under one plug.
+ */
+static int zram_writeback_page(struct zram *zram, struct zram_wb_ctx *ctx,
+			       int nr_to_write)
+{
+	struct zram_wb_batch *batch = ctx->cur;
+	struct blk_plug plug;
+	unsigned long blk_idx;
+	int ret = 0;
+	int i, idx = 0;
+	int nr_pages = nr_to_write;
+
+	ctx->cur = NULL;
+	ctx->idx = 0;
+
+	batch->nr = nr_to_write;
+	batch->submit_time = ktime_get();
+	atomic_set(&batch->pending, 1);
+	spin_lock_irq(&ctx->lock);
+	ctx->inflight++;
+	spin_unlock_irq(&ctx->lock);
+
+	blk_start_plug(&plug);
+	while (idx < nr_to_write) {
+		struct bio *bio;
+
+		blk_idx = try_alloc_block_bdev(zram, &nr_pages);
+		if (!blk_idx) {
+			ret = -ENOSPC;
+			break;
+		}
+
+		bio = bio_alloc(GFP_NOIO, nr_pages);
+		bio->bi_bdev = zram->bdev;
+		bio->bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
+		bio->bi_end_io = zram_writeback_end_io;
+		bio->bi_private = batch;
+		bio_set_prio(bio, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0));
+		for (i = 0; i < nr_pages; i++) {
+			struct zwbs *zwbs = batch->zwbs[idx + i];
+
+			zwbs->blk_idx = blk_idx + i;
+			bio_add_page(bio, zwbs->page, PAGE_SIZE, 0);
+		}
+		atomic_inc(&batch->pending);
+		submit_bio(WRITE, bio);
 
 		idx += nr_pages;
-		if (idx < nr_to_write)
-			goto retry;
-	} else {
-		if (blk_idx)
-			for (i = 0; i < nr_pages; i++)
-				free_block_bdev(zram, blk_idx + i);
-		/* free all remaining entries when error */
-		for (i = idx; i < nr_to_write; i++)
-			zram_writeback_clear_flag(zram, zwbs[i]);
+		nr_pages = nr_to_write - idx;
 	}
+	blk_finish_plug(&plug);
+
+	/* entries that never made it to a bio are rolled back on completion */
+	for (i = idx; i < nr_to_write; i++)
+		batch->zwbs[i]->error = ret;
+
+	zram_wb_batch_put(batch);
 	return ret;
 }
 
+/* submit the partially filled batch and wait for all writes to finish */
+static void zram_wb_drain(struct zram_wb_ctx *ctx)
+{
+	struct zram_wb_batch *batch = ctx->cur;
+
+	if (batch) {
+		int nr = ctx->idx;
+
+		if (batch->zwbs[nr]->cnt) {
+			mark_end_of_page(batch->zwbs[nr]);
+			nr++;
+		}
+		if (nr) {
+			zram_writeback_page(ctx->zram, ctx, nr);
+		} else {
+			ctx->cur = NULL;
+			spin_lock_irq(&ctx->lock);
+			list_add(&batch->list, &ctx->free);
+			spin_unlock_irq(&ctx->lock);
+		}
+	}
+
+	wait_event(ctx->wait, zram_wb_idle(ctx));
+	zram_wb_reap(ctx);
+}
+
 static int zram_comp_writeback_index(struct zram *zram, u32 index,
-			struct zwbs **zwbs, int *idx, bool sync)
+			struct zram_wb_ctx *ctx)
 {
-	int size, ret = 0;
-	int i = *idx, j;
+	struct zwbs *zwbs;
+	int size, ret;
 retry:
-	size = zram_writeback_fill_page(zram, index, zwbs[i]);
+	if (!ctx->cur) {
+		ctx->cur = zram_wb_get_batch(ctx);
+		ctx->idx = 0;
+	}
+	zwbs = ctx->cur->zwbs[ctx->idx];
+
+	size = zram_writeback_fill_page(zram, index, zwbs);
 	if (size > 0) {
-		struct zram_wb_entry *entry = zwbs[i]->entry;
-		entry[zwbs[i]->cnt].index = index;
-		entry[zwbs[i]->cnt].offset = zwbs[i]->off;
-		entry[zwbs[i]->cnt].size = size;
-		zwbs[i]->off += size;
+		struct zram_wb_entry *entry = zwbs->entry;
+		entry[zwbs->cnt].index = index;
+		entry[zwbs->cnt].offset = zwbs->off;
+		entry[zwbs->cnt].size = size;
+		zwbs->off += size;
 		if (size < PAGE_SIZE)
-			zwbs[i]->off += sizeof(struct zram_wb_header);
-		zwbs[i]->cnt++;
+			zwbs->off += sizeof(struct zram_wb_header);
+		zwbs->cnt++;
 	}
 	/* writeback if page is full/entry is full */
-	if (size == -ENOSPC || zwbs[i]->cnt == ZRAM_WB_THRESHOLD) {
-		mark_end_of_page(zwbs[i]);
-		i = (i + 1) % NR_ZWBS;
-		if (i > 0)
-			goto retry;
-		ret = zram_writeback_page(zram, zwbs, NR_ZWBS, sync);
-		for (j = 0; j < NR_ZWBS; j++) {
-			zwbs[j]->cnt = 0;
-			zwbs[j]->off = 0;
+	if (size == -ENOSPC || zwbs->cnt == ZRAM_WB_THRESHOLD) {
+		mark_end_of_page(zwbs);
+		if (++ctx->idx < NR_ZWBS) {
+			if (size == -ENOSPC)
+				goto retry;
+			return 0;
 		}
-		if (ret == 0 && size == -ENOSPC)
+		ret = zram_writeback_page(zram, ctx, NR_ZWBS);
+		if (ret)
+			return ret;
+		if (size == -ENOSPC)
 			goto retry;
 	}
-	*idx = i;
-	return ret;
+	return 0;
 }
 
 static void zram_comp_writeback(struct zram *zram)
 {
-	struct zwbs *zwbs[NR_ZWBS];
+	struct zram_wb_ctx *ctx;
 	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
 	unsigned long index;
-	int idx = 0;
 
-	if (alloc_zwbs(zwbs)) {
+	ctx = zram_wb_ctx_alloc(zram);
+	if (!ctx) {
 		pr_info("%s alloc_zwbs failed", __func__);
 		return;
 	}
@@ -1311,55 +1772,70 @@ static void zram_comp_writeback(struct zram *zram)
 	for (index = 0; index < nr_pages; index++) {
 		if (!zram_wb_available(zram))
 			break;
-		if (zram_comp_writeback_index(zram, index, zwbs, &idx, true))
+		if (zram_peek_skip(zram, index))
+			continue;
+		if (zram_comp_writeback_index(zram, index, ctx))
 			break;
 	}
-	free_zwbs(zwbs);
+	zram_wb_drain(ctx);
+	zram_wb_ctx_free(ctx);
 	pr_info("%s done", __func__);
 }
 
 static int zram_wbd(void *p)
 {
 	struct zram *zram = (struct zram *)p;
-	struct zram_table_entry *zram_entry, *n;
-	struct zwbs *zwbs[NR_ZWBS];
+	struct list_head *node, *n;
+	struct zram_wb_ctx *ctx;
+	ktime_t start;
+	s64 elapsed_us;
 	u32 index;
-	int idx = 0;
 	int ret;
 
 	set_freezable();
 
-	if (alloc_zwbs(zwbs)) {
-		pr_info("%s alloc_zwbs failed", __func__);
-		return 0;
-	}
-
 	while (!kthread_should_stop()) {
 		unsigned long nr_pages = 0;
 		wait_event_freezable(zram->wbd_wait,
 				zram->wbd_running || kthread_should_stop());
-		list_for_each_entry_safe(zram_entry, n, &zram->list, lru_list) {
+		if (kthread_should_stop())
+			break;
+
+		ctx = zram_wb_ctx_alloc(zram);
+		if (!ctx) {
+			pr_info("%s alloc_zwbs failed", __func__);
+			zram->wbd_running = false;
+			continue;
+		}
+
+		start = ktime_get();
+		list_for_each_safe(node, n, &zram->list) {
 			if (try_to_freeze() || kthread_should_stop())
 				break;
 			if (!zram_wb_available(zram))
 				break;
-			index = entry_to_index(zram, zram_entry);
+			index = lru_to_index(zram, node);
 			ret = zram_try_mark_page(zram, index);
 			if (!ret) {
-				if (zram_comp_writeback_index(zram, index,
-						zwbs, &idx, false))
+				if (zram_comp_writeback_index(zram, index, ctx))
 					break;
 			} else if (ret == ABORT) {
-				n = list_first_entry(&zram->list,
-						struct zram_table_entry, lru_list);
+				n = zram->list.next;
 			}
 			if (!zram_should_writeback(zram, ++nr_pages, false))
 				break;
 		}
+		zram_wb_drain(ctx);
+
+		elapsed_us = ktime_us_delta(ktime_get(), start);
+		if (elapsed_us > 0)
+			atomic64_set(&zram->stats.bd_wb_kbps,
+				div64_u64((u64)ctx->nr_written * PAGE_SIZE *
+					  USEC_PER_SEC, (u64)elapsed_us * 1024));
+		zram_wb_ctx_free(ctx);
 		zram->wbd_running = false;
 		pr_info("%s done", __func__);
 	}
-	free_zwbs(zwbs);
 
 	return 0;
 }
@@ -1425,9 +1901,12 @@ static ssize_t writeback_store(struct device *dev,
 		goto release_init_lock;
 	}
 
-	while (nr_pages--) {
+	for (; nr_pages != 0; index++, nr_pages--) {
 		struct bio_vec bvec;
 
+		if (zram_peek_skip(zram, index))
+			continue;
+
 		bvec.bv_page = page;
 		bvec.bv_len = PAGE_SIZE;
 		bvec.bv_offset = 0;
@@ -1486,6 +1965,7 @@ static ssize_t writeback_store(struct device *dev,
 		bio.bi_bdev = zram->bdev;
 
 		bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
+		bio_set_prio(&bio, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0));
 		bio_add_page(&bio, bvec.bv_page, bvec.bv_len,
 				bvec.bv_offset);
 		/*
@@ -1604,7 +2084,12 @@ static int read_from_bdev(struct zram *zram, struct bio_vec *bvec,
 }
 
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
-static void zram_handle_remain(struct zram *zram, struct page *page,
+/*
+ * Move every object of a compressed backing block that is still stored
+ * there back to zsmalloc and drop the block reference taken by the caller.
+ * Returns the number of slots restored.
+ */
+static int zram_handle_remain(struct zram *zram, struct page *page,
 				unsigned int blk_idx)
 {
 	struct zram_wb_header *zhdr;
@@ -1614,6 +2099,7 @@ static void zram_handle_remain(struct zram *zram, struct page *page,
 	unsigned int size;
 	u32 index;
 	u8 *mem, *src, *dst;
+	int restored = 0;
 
 	mem = kmap_atomic(page);
 	while (offset + sizeof(struct zram_wb_header) < PAGE_SIZE) {
@@ -1621,8 +2107,8 @@ static void zram_handle_remain(struct zram *zram, struct page *page,
 		index = zhdr->index;
 		size = zhdr->size;
 
-		/* invalid index */
-		if (index >= (zram->disksize >> PAGE_SHIFT))
+		/* invalid index, or not a compressed block at all */
+		if (index >= (zram->disksize >> PAGE_SHIFT) || !size)
 			break;
 
 		if (!zram_slot_trylock(zram, index))
@@ -1655,23 +2141,149 @@ static void zram_handle_remain(struct zram *zram, struct page *page,
 		alloced_pages = zs_get_total_pages(zram->mem_pool);
 		update_used_max(zram, alloced_pages);
 
-		dst = zs_map_object(zram->mem_pool, handle, ZS_MM_WO);
-		src = (u8 *)(zhdr + 1);
-		memcpy(dst, src, size);
-		zs_unmap_object(zram->mem_pool, handle);
+		dst = zs_map_object(zram->mem_pool, handle, ZS_MM_WO);
+		src = (u8 *)(zhdr + 1);
+		memcpy(dst, src, size);
+		zs_unmap_object(zram->mem_pool, handle);
+
+		atomic64_add(size, &zram->stats.compr_data_size);
+		zram_free_page(zram, index);
+		zram_set_element(zram, index, handle);
+		zram_set_obj_size(zram, index, size);
+		zram_set_priority(zram, index, zhdr->prio);
+		zram_slot_unlock(zram, index);
+		atomic64_inc(&zram->stats.pages_stored);
+		restored++;
+next:
+		offset += (size + sizeof(struct zram_wb_header));
+	}
+	kunmap_atomic(mem);
+	free_block_bdev(zram, blk_idx);
+	atomic64_inc(&zram->stats.bd_objcnt);
+
+	return restored;
+}
+
+/*
+ * Number of neighbouring blocks of the same chunk to read back together
+ * with a compressed block on swap-in. 0 disables prefetch.
+ */
+static int zram_prefetch_window;
+module_param(zram_prefetch_window, int, 0644);
+
+/* pin a backing block that still holds live objects */
+static bool zram_get_wb_block(struct zram *zram, unsigned long blk_idx)
+{
+	unsigned long flags;
+	bool ret = false;
+
+	spin_lock_irqsave(&zram->wb_table_lock, flags);
+	if (zram->wb_table && zram->wb_table[blk_idx]) {
+		zram->wb_table[blk_idx]++;
+		ret = true;
+	}
+	spin_unlock_irqrestore(&zram->wb_table_lock, flags);
+
+	return ret;
+}
+
+static void zram_handle_prefetch_page(struct work_struct *work)
+{
+	struct zram_wb_work *zw = container_of(work, struct zram_wb_work, work);
+	struct zram *zram = zw->zram;
+	struct page *page = zw->src_page;
+	unsigned long blk_idx = zw->handle;
+	int restored;
+
+	if (!zw->bio->bi_error) {
+		restored = zram_handle_remain(zram, page, blk_idx);
+		atomic64_add(restored, &zram->stats.bd_prefetch);
+	} else {
+		free_block_bdev(zram, blk_idx);
+		atomic64_inc(&zram->stats.bd_objcnt);
+	}
+	bio_put(zw->bio);
+	set_page_private(page, 0);
+	__free_page(page);
+	kfree(zw);
+}
+
+static void zram_prefetch_end_io(struct bio *bio)
+{
+	struct page *page = bio->bi_io_vec[0].bv_page;
+	struct zram_wb_work *zw = (struct zram_wb_work *)page_private(page);
+
+	INIT_WORK(&zw->work, zram_handle_prefetch_page);
+	schedule_work(&zw->work);
+}
+
+static int zram_prefetch_block(struct zram *zram, unsigned long blk_idx)
+{
+	struct zram_wb_work *zw;
+	struct bio *bio;
+	struct page *page;
+
+	if (!zram_get_wb_block(zram, blk_idx))
+		return 0;
+
+	zw = kzalloc(sizeof(struct zram_wb_work), GFP_NOIO);
+	page = alloc_page(GFP_NOIO | __GFP_NOWARN);
+	bio = bio_alloc(GFP_NOIO, 1);
+	if (!zw || !page) {
+		bio_put(bio);
+		if (page)
+			__free_page(page);
+		kfree(zw);
+		free_block_bdev(zram, blk_idx);
+		atomic64_inc(&zram->stats.bd_objcnt);
+		return -ENOMEM;
+	}
+	zw->src_page = page;
+	zw->zram = zram;
+	zw->bio = bio;
+	zw->handle = blk_idx;
+	set_page_private(page, (unsigned long)zw);
+
+	bio->bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
+	bio->bi_bdev = zram->bdev;
+	bio->bi_end_io = zram_prefetch_end_io;
+	bio_add_page(bio, page, PAGE_SIZE, 0);
+	atomic64_inc(&zram->stats.bd_reads);
+	submit_bio(READ, bio);
+
+	return 1;
+}
+
+/*
+ * Objects of the same chunk were written back together, so they are
+ * likely to be swapped in together as well. Read the neighbouring blocks
+ * of the chunk and move their live objects back to zsmalloc ahead of the
+ * faults.
+ */
+static void zram_prefetch_siblings(struct zram *zram, unsigned long blk_idx)
+{
+	int window = min_t(int, READ_ONCE(zram_prefetch_window), NR_ZWBS - 1);
+	unsigned long first, last, blk;
+	struct blk_plug plug;
+
+	if (window <= 0)
+		return;
 
-		atomic64_add(size, &zram->stats.compr_data_size);
-		zram_free_page(zram, index);
-		zram_set_element(zram, index, handle);
-		zram_set_obj_size(zram, index, size);
-		zram_slot_unlock(zram, index);
-		atomic64_inc(&zram->stats.pages_stored);
-next:
-		offset += (size + sizeof(struct zram_wb_header));
+	first = chunk_to_blk_idx(blk_to_chunk_idx(blk_idx));
+	last = first + NR_ZWBS - 1;
+	first = max(first, blk_idx > window ? blk_idx - window : 0);
+	last = min(last, blk_idx + window);
+	last = min(last, zram->nr_pages - 1);
+
+	blk_start_plug(&plug);
+	for (blk = first; blk <= last; blk++) {
+		/* block 0 is never allocated, see alloc_block_bdev */
+		if (blk == blk_idx || !blk)
+			continue;
+		if (zram_prefetch_block(zram, blk) < 0)
+			break;
 	}
-	kunmap_atomic(mem);
-	free_block_bdev(zram, blk_idx);
-	atomic64_inc(&zram->stats.bd_objcnt);
+	blk_finish_plug(&plug);
 }
 
 static void zram_handle_comp_page(struct work_struct *work)
@@ -1679,6 +2291,7 @@ static void zram_handle_comp_page(struct work_struct *work)
 	struct zram_wb_work *zw = container_of(work, struct zram_wb_work, work);
 	struct zram_wb_header *zhdr;
 	struct zram *zram = zw->zram;
+	struct zcomp *comp;
 	struct zcomp_strm *zstrm;
 	struct page *src_page = zw->src_page;
 	struct page *dst_page = zw->dst_page;
@@ -1697,10 +2310,11 @@ static void zram_handle_comp_page(struct work_struct *work)
 	BUG_ON(zhdr->size != size);
 
 	dst = kmap_atomic(dst_page);
-	zstrm = zcomp_stream_get(zram->comp);
+	comp = zram_prio_comp(zram, zhdr->prio);
+	zstrm = zcomp_stream_get(comp);
 	ret = zcomp_decompress(zstrm,
 		src + offset + sizeof(struct zram_wb_header), size, dst);
-	zcomp_stream_put(zram->comp);
+	zcomp_stream_put(comp, zstrm);
 	if (ret) {
 		pr_err("%s Decompression failed! err=%d offset=%u size=%u addr=%p\n",
 			__func__, ret, offset, size, src);
@@ -1727,6 +2341,8 @@ static void zram_handle_comp_page(struct work_struct *work)
 	zram_handle_remain(zram, src_page, blk_idx);
 	kfree(zw);
 	__free_page(src_page);
+
+	zram_prefetch_siblings(zram, blk_idx);
 }
 
 static void zram_comp_page_end_io(struct bio *bio)
@@ -1981,6 +2597,262 @@ static ssize_t comp_algorithm_store(struct device *dev,
 	return len;
 }
 
+#ifdef CONFIG_ZRAM_MULTI_COMP
+static ssize_t recomp_algorithm_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	size_t sz;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	sz = zcomp_available_show(zram->recomp_algorithm, buf);
+	up_read(&zram->init_lock);
+
+	return sz;
+}
+
+static ssize_t recomp_algorithm_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	char compressor[ARRAY_SIZE(zram->recomp_algorithm)];
+	size_t sz;
+
+	strlcpy(compressor, buf, sizeof(compressor));
+	/* ignore trailing newline */
+	sz = strlen(compressor);
+	if (sz > 0 && compressor[sz - 1] == '\n')
+		compressor[sz - 1] = 0x00;
+
+	if (!zcomp_available_algorithm(compressor))
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change algorithm for initialized device\n");
+		return -EBUSY;
+	}
+
+	strcpy(zram->recomp_algorithm, compressor);
+	up_write(&zram->init_lock);
+	return len;
+}
+
+#define RECOMPRESS_IDLE		(1 << 0)
+#define RECOMPRESS_HUGE		(1 << 1)
+
+/*
+ * Recompress a single slot with the secondary algorithm. The caller holds
+ * the slot lock, so the allocation below must not enter direct reclaim.
+ * The old object is kept if the secondary algorithm does not save memory;
+ * the slot is then marked ZRAM_INCOMPRESSIBLE so it is not tried again.
+ */
+static int zram_recompress_slot(struct zram *zram, u32 index,
+				struct page *page, u64 *saved)
+{
+	unsigned long handle, new_handle;
+	unsigned int comp_len_old, comp_len_new;
+	struct zcomp_strm *zstrm;
+	void *src, *dst;
+	bool idle;
+	int ret;
+#ifdef CONFIG_ZRAM_LRU_WRITEBACK
+	unsigned long irq_flags;
+#endif
+
+	handle = zram_get_handle(zram, index);
+	comp_len_old = zram_get_obj_size(zram, index);
+
+	src = zs_map_object(zram->mem_pool, handle, ZS_MM_RO);
+	if (comp_len_old == PAGE_SIZE) {
+		dst = kmap_atomic(page);
+		memcpy(dst, src, PAGE_SIZE);
+		kunmap_atomic(dst);
+		ret = 0;
+	} else {
+		zstrm = zcomp_stream_get(zram->comp);
+		dst = kmap_atomic(page);
+		ret = zcomp_decompress(zstrm, src, comp_len_old, dst);
+		kunmap_atomic(dst);
+		zcomp_stream_put(zram->comp, zstrm);
+	}
+	zs_unmap_object(zram->mem_pool, handle);
+	if (ret)
+		return ret;
+
+	zstrm = zcomp_stream_get(zram->recomp);
+	src = kmap_atomic(page);
+	ret = zcomp_compress(zstrm, src, &comp_len_new);
+	kunmap_atomic(src);
+	if (ret) {
+		zcomp_stream_put(zram->recomp, zstrm);
+		return ret;
+	}
+
+	if (comp_len_new >= huge_class_size || comp_len_new >= comp_len_old) {
+		zcomp_stream_put(zram->recomp, zstrm);
+		zram_set_flag(zram, index, ZRAM_INCOMPRESSIBLE);
+		return 0;
+	}
+
+	new_handle = zs_malloc(zram->mem_pool, comp_len_new,
+			__GFP_KSWAPD_RECLAIM |
+			__GFP_NOWARN |
+			__GFP_HIGHMEM |
+			__GFP_MOVABLE |
+			__GFP_CMA);
+	if (!new_handle) {
+		zcomp_stream_put(zram->recomp, zstrm);
+		return -ENOMEM;
+	}
+
+	dst = zs_map_object(zram->mem_pool, new_handle, ZS_MM_WO);
+	memcpy(dst, zstrm->buffer, comp_len_new);
+	zcomp_stream_put(zram->recomp, zstrm);
+	zs_unmap_object(zram->mem_pool, new_handle);
+
+	idle = zram_test_flag(zram, index, ZRAM_IDLE);
+	zram_free_page(zram, index);
+	zram_set_handle(zram, index, new_handle);
+	zram_set_obj_size(zram, index, comp_len_new);
+	zram_set_priority(zram, index, ZRAM_SECONDARY_COMP);
+	if (idle)
+		zram_set_flag(zram, index, ZRAM_IDLE);
+#ifdef CONFIG_ZRAM_LRU_WRITEBACK
+	/* the page was cold enough to recompress, keep it at the cold end */
+	spin_lock_irqsave(&zram->list_lock, irq_flags);
+	list_add(&zram->lru[index], &zram->list);
+	spin_unlock_irqrestore(&zram->list_lock, irq_flags);
+#endif
+
+	atomic64_add(comp_len_new, &zram->stats.compr_data_size);
+	atomic64_inc(&zram->stats.pages_stored);
+	atomic64_add(comp_len_old - comp_len_new,
+			&zram->stats.recomp_saved_bytes);
+	*saved += comp_len_old - comp_len_new;
+
+	return 0;
+}
+
+static ssize_t recompress_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	struct zram *zram = dev_to_zram(dev);
+	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
+	unsigned long index;
+	struct page *page;
+	u64 saved = 0;
+	ssize_t ret = len;
+	int mode, err;
+
+	if (sysfs_streq(buf, "idle"))
+		mode = RECOMPRESS_IDLE;
+	else if (sysfs_streq(buf, "huge"))
+		mode = RECOMPRESS_HUGE;
+	else if (sysfs_streq(buf, "huge_idle"))
+		mode = RECOMPRESS_IDLE | RECOMPRESS_HUGE;
+	else
+		return -EINVAL;
+
+	down_read(&zram->init_lock);
+	if (!init_done(zram) || !zram->recomp) {
+		ret = -EINVAL;
+		goto release_init_lock;
+	}
+
+	page = alloc_page(GFP_KERNEL);
+	if (!page) {
+		ret = -ENOMEM;
+		goto release_init_lock;
+	}
+
+	for (index = 0; index < nr_pages; index++) {
+		err = 0;
+
+		if (zram_peek_skip(zram, index))
+			continue;
+
+		zram_slot_lock(zram, index);
+		if (!zram_allocated(zram, index))
+			goto next;
+
+		if (zram_test_flag(zram, index, ZRAM_WB) ||
+				zram_test_flag(zram, index, ZRAM_SAME) ||
+				zram_test_flag(zram, index, ZRAM_UNDER_WB) ||
+				zram_test_flag(zram, index, ZRAM_INCOMPRESSIBLE) ||
+				zram_test_flag(zram, index, ZRAM_DEDUP) ||
+				zram_get_priority(zram, index) != ZRAM_PRIMARY_COMP)
+			goto next;
+
+		if ((mode & RECOMPRESS_IDLE) &&
+				!zram_test_flag(zram, index, ZRAM_IDLE))
+			goto next;
+		if ((mode & RECOMPRESS_HUGE) &&
+				!zram_test_flag(zram, index, ZRAM_HUGE))
+			goto next;
+
+		err = zram_recompress_slot(zram, index, page, &saved);
+next:
+		zram_slot_unlock(zram, index);
+		if (err == -ENOMEM) {
+			ret = err;
+			break;
+		}
+		cond_resched();
+	}
+
+	__free_page(page);
+	pr_info("recompress saved %llu bytes\n", saved);
+release_init_lock:
+	up_read(&zram->init_lock);
+
+	return ret;
+}
+#endif
+
+#ifdef CONFIG_ZRAM_DEDUP
+static ssize_t use_dedup_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	u8 val;
+	struct zram *zram = dev_to_zram(dev);
+
+	down_read(&zram->init_lock);
+	val = zram->use_dedup;
+	up_read(&zram->init_lock);
+
+	if (val == ZRAM_DEDUP_KSM)
+		return scnprintf(buf, PAGE_SIZE, "ksm\n");
+	return scnprintf(buf, PAGE_SIZE, "%d\n", (int)val);
+}
+
+static ssize_t use_dedup_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t len)
+{
+	bool val;
+	u8 mode;
+	struct zram *zram = dev_to_zram(dev);
+
+	if (sysfs_streq(buf, "ksm"))
+		mode = ZRAM_DEDUP_KSM;
+	else if (!kstrtobool(buf, &val))
+		mode = val ? ZRAM_DEDUP_ALL : ZRAM_DEDUP_OFF;
+	else
+		return -EINVAL;
+
+	down_write(&zram->init_lock);
+	if (init_done(zram)) {
+		up_write(&zram->init_lock);
+		pr_info("Can't change dedup usage for initialized device\n");
+		return -EBUSY;
+	}
+	zram->use_dedup = mode;
+	up_write(&zram->init_lock);
+	return len;
+}
+#endif
+
 static ssize_t compact_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
 {
@@ -2022,6 +2894,8 @@ static ssize_t mm_stat_show(struct device *dev,
 	struct zram *zram = dev_to_zram(dev);
 	struct zs_pool_stats pool_stats;
 	u64 orig_size, mem_used = 0;
+	u64 recomp_saved = 0;
+	u64 dup_size = 0, meta_size = 0, dedup_hits = 0, ksm_hits = 0;
 	long max_used;
 	ssize_t ret;
 
@@ -2035,9 +2909,18 @@ static ssize_t mm_stat_show(struct device *dev,
 
 	orig_size = atomic64_read(&zram->stats.pages_stored);
 	max_used = atomic_long_read(&zram->stats.max_used_pages);
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	recomp_saved = atomic64_read(&zram->stats.recomp_saved_bytes);
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	dup_size = atomic64_read(&zram->stats.dup_data_size);
+	meta_size = atomic64_read(&zram->stats.meta_data_size);
+	dedup_hits = atomic64_read(&zram->stats.dedup_hits);
+	ksm_hits = atomic64_read(&zram->stats.ksm_dedup_hits);
+#endif
 
 	ret = scnprintf(buf, PAGE_SIZE,
-			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu\n",
+			"%8llu %8llu %8llu %8lu %8ld %8llu %8lu %8llu %8llu %8llu %8llu %8llu %8llu %8llu\n",
 			orig_size << PAGE_SHIFT,
 			(u64)atomic64_read(&zram->stats.compr_data_size),
 			mem_used << PAGE_SHIFT,
@@ -2046,7 +2929,12 @@ static ssize_t mm_stat_show(struct device *dev,
 			(u64)atomic64_read(&zram->stats.same_pages),
 			pool_stats.pages_compacted,
 			(u64)atomic64_read(&zram->stats.huge_pages),
-			(u64)atomic64_read(&zram->stats.huge_pages_since));
+			(u64)atomic64_read(&zram->stats.huge_pages_since),
+			recomp_saved,
+			dup_size,
+			meta_size,
+			dedup_hits,
+			ksm_hits);
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -2059,16 +2947,26 @@ static ssize_t bd_stat_show(struct device *dev,
 {
 	struct zram *zram = dev_to_zram(dev);
 	ssize_t ret;
+#ifdef CONFIG_ZRAM_LRU_WRITEBACK
+	u64 batches, lat_us;
+#endif
 
 	down_read(&zram->init_lock);
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
+	batches = atomic64_read(&zram->stats.bd_wb_batches);
+	lat_us = atomic64_read(&zram->stats.bd_wb_lat_us);
 	ret = scnprintf(buf, PAGE_SIZE,
-		"%8llu %8llu %8llu %8llu %8llu\n",
+		"%8llu %8llu %8llu %8llu %8llu %8llu %8llu %8llu %8llu %8llu\n",
 			FOUR_K((u64)atomic64_read(&zram->stats.bd_expire)),
 			FOUR_K((u64)atomic64_read(&zram->stats.bd_count)),
 			FOUR_K((u64)atomic64_read(&zram->stats.bd_reads)),
 			FOUR_K((u64)atomic64_read(&zram->stats.bd_writes)),
-			FOUR_K((u64)atomic64_read(&zram->stats.bd_objcnt)));
+			FOUR_K((u64)atomic64_read(&zram->stats.bd_objcnt)),
+			batches,
+			batches ? div64_u64(lat_us, batches) : 0,
+			(u64)atomic64_read(&zram->stats.bd_wb_lat_max_us),
+			(u64)atomic64_read(&zram->stats.bd_wb_kbps),
+			(u64)atomic64_read(&zram->stats.bd_prefetch));
 #else
 	ret = scnprintf(buf, PAGE_SIZE,
 		"%8llu %8llu %8llu\n",
@@ -2085,16 +2983,29 @@ static ssize_t bd_stat_show(struct device *dev,
 static ssize_t debug_stat_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
-	int version = 1;
+	int version = 2;
 	struct zram *zram = dev_to_zram(dev);
+	u64 pool_gets = 0, wait_ns = 0;
 	ssize_t ret;
 
 	down_read(&zram->init_lock);
+	if (init_done(zram)) {
+		pool_gets = atomic64_read(&zram->comp->pool_gets);
+		wait_ns = atomic64_read(&zram->comp->wait_ns);
+#ifdef CONFIG_ZRAM_MULTI_COMP
+		if (zram->recomp) {
+			pool_gets += atomic64_read(&zram->recomp->pool_gets);
+			wait_ns += atomic64_read(&zram->recomp->wait_ns);
+		}
+#endif
+	}
 	ret = scnprintf(buf, PAGE_SIZE,
-			"version: %d\n%8llu %8llu\n",
+			"version: %d\n%8llu %8llu %8llu %8llu\n",
 			version,
 			(u64)atomic64_read(&zram->stats.writestall),
-			(u64)atomic64_read(&zram->stats.miss_free));
+			(u64)atomic64_read(&zram->stats.miss_free),
+			pool_gets,
+			div_u64(wait_ns, NSEC_PER_USEC));
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -2116,7 +3027,14 @@ static void zram_meta_free(struct zram *zram, u64 disksize)
 	for (index = 0; index < num_pages; index++)
 		zram_free_page(zram, index);
 
+	zram_dedup_fini(zram);
 	zs_destroy_pool(zram->mem_pool);
+#ifdef CONFIG_ZRAM_LRU_WRITEBACK
+	vfree(zram->lru);
+	zram->lru = NULL;
+#endif
+	vfree(zram->slot_state);
+	zram->slot_state = NULL;
 	vfree(zram->table);
 }
 
@@ -2132,19 +3050,43 @@ static bool zram_meta_alloc(struct zram *zram, u64 disksize)
 	if (!zram->table)
 		return false;
 
+	zram->slot_state = vzalloc(BITS_TO_LONGS(num_pages * __NR_ZRAM_STATES) *
+				   sizeof(unsigned long));
+	if (!zram->slot_state)
+		goto out_free_table;
+
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
+	zram->lru = vmalloc(num_pages * sizeof(*zram->lru));
+	if (!zram->lru)
+		goto out_free_state;
 	for (i = 0; i < num_pages; i++)
-		INIT_LIST_HEAD(&zram->table[i].lru_list);
+		INIT_LIST_HEAD(&zram->lru[i]);
 #endif
 	zram->mem_pool = zs_create_pool(zram->disk->disk_name);
-	if (!zram->mem_pool) {
-		vfree(zram->table);
-		return false;
+	if (!zram->mem_pool)
+		goto out_free_lru;
+
+	if (zram_dedup_init(zram, num_pages)) {
+		zs_destroy_pool(zram->mem_pool);
+		goto out_free_lru;
 	}
 
 	if (!huge_class_size)
 		huge_class_size = zs_huge_class_size(zram->mem_pool);
 	return true;
+
+out_free_lru:
+#ifdef CONFIG_ZRAM_LRU_WRITEBACK
+	vfree(zram->lru);
+	zram->lru = NULL;
+out_free_state:
+#endif
+	vfree(zram->slot_state);
+	zram->slot_state = NULL;
+out_free_table:
+	vfree(zram->table);
+	zram->table = NULL;
+	return false;
 }
 
 /*
@@ -2165,6 +3107,9 @@ static void zram_free_page(struct zram *zram, size_t index)
 	if (zram_test_flag(zram, index, ZRAM_IDLE))
 		zram_clear_flag(zram, index, ZRAM_IDLE);
 
+	zram_clear_flag(zram, index, ZRAM_INCOMPRESSIBLE);
+	zram_set_priority(zram, index, ZRAM_PRIMARY_COMP);
+
 	if (zram_test_flag(zram, index, ZRAM_HUGE)) {
 		zram_clear_flag(zram, index, ZRAM_HUGE);
 		atomic64_dec(&zram->stats.huge_pages);
@@ -2192,6 +3137,22 @@ static void zram_free_page(struct zram *zram, size_t index)
 		goto out;
 	}
 
+#ifdef CONFIG_ZRAM_DEDUP
+	if (zram_test_flag(zram, index, ZRAM_DEDUP)) {
+		struct zram_dedup_entry *entry;
+
+		entry = (struct zram_dedup_entry *)zram->table[index].handle;
+		zram_clear_flag(zram, index, ZRAM_DEDUP);
+		if (zram_dedup_put(zram, entry))
+			atomic64_sub(zram_get_obj_size(zram, index),
+					&zram->stats.compr_data_size);
+		else
+			atomic64_sub(zram_get_obj_size(zram, index),
+					&zram->stats.dup_data_size);
+		goto out;
+	}
+#endif
+
 	handle = zram_get_handle(zram, index);
 	if (!handle)
 		return;
@@ -2206,8 +3167,8 @@ out:
 	zram_set_obj_size(zram, index, 0);
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
 	spin_lock_irqsave(&zram->list_lock, flags);
-	if (!list_empty(&zram->table[index].lru_list))
-		list_del_init(&zram->table[index].lru_list);
+	if (!list_empty(&zram->lru[index]))
+		list_del_init(&zram->lru[index]);
 	spin_unlock_irqrestore(&zram->list_lock, flags);
 #endif
 	WARN_ON_ONCE(zram->table[index].flags &
@@ -2272,18 +3233,27 @@ static int __zram_bvec_read(struct zram *zram, struct page *page, u32 index,
 		kunmap_atomic(dst);
 		ret = 0;
 	} else {
-		struct zcomp_strm *zstrm = zcomp_stream_get(zram->comp);
+		struct zcomp *comp;
+		struct zcomp_strm *zstrm;
+#ifdef CONFIG_RECLAIM_COST_MODEL
+		u64 start = ktime_get_ns();
+#endif
 
+		comp = zram_prio_comp(zram, zram_get_priority(zram, index));
+		zstrm = zcomp_stream_get(comp);
 		dst = kmap_atomic(page);
 		ret = zcomp_decompress(zstrm, src, size, dst);
 		kunmap_atomic(dst);
-		zcomp_stream_put(zram->comp);
+		zcomp_stream_put(comp, zstrm);
+#ifdef CONFIG_RECLAIM_COST_MODEL
+		count_vm_events(RECLAIM_COST_ANON_NS, ktime_get_ns() - start);
+#endif
 	}
 	zs_unmap_object(zram->mem_pool, handle);
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
 	spin_lock_irqsave(&zram->list_lock, flags);
-	if (!list_empty(&zram->table[index].lru_list))
-		list_del_init(&zram->table[index].lru_list);
+	if (!list_empty(&zram->lru[index]))
+		list_del_init(&zram->lru[index]);
 	spin_unlock_irqrestore(&zram->list_lock, flags);
 #endif
 	zram_slot_unlock(zram, index);
@@ -2328,6 +3298,22 @@ out:
 	return ret;
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+/*
+ * A KSM page is written out once whatever the number of its mappings,
+ * but its content tends to come back: KSM merges it again into a new page
+ * after a swap-in, or it is copied for each anon_vma that faults it in.
+ * Indexing just these pages catches most of the duplicates without paying
+ * for a checksum of every other page.
+ */
+static inline bool zram_dedup_page(struct zram *zram, struct page *page)
+{
+	if (zram->use_dedup == ZRAM_DEDUP_KSM)
+		return PageKsm(page);
+	return zram->use_dedup != ZRAM_DEDUP_OFF;
+}
+#endif
+
 static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 				u32 index, struct bio *bio)
 {
@@ -2340,6 +3326,14 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	struct page *page = bvec->bv_page;
 	unsigned long element = 0;
 	enum zram_pageflags flags = 0;
+	struct zram_dedup_entry *entry = NULL;
+#ifdef CONFIG_ZRAM_DEDUP
+	bool dedup = zram_dedup_page(zram, page);
+	u64 checksum = 0;
+#endif
+#ifdef CONFIG_RECLAIM_COST_MODEL
+	u64 start;
+#endif
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
 	unsigned long irq_flags;
 #endif
@@ -2354,14 +3348,34 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	}
 	kunmap_atomic(mem);
 
+#ifdef CONFIG_ZRAM_DEDUP
+	if (dedup) {
+		entry = zram_dedup_find(zram, page, &checksum);
+		if (entry) {
+			comp_len = entry->len;
+			atomic64_add(comp_len, &zram->stats.dup_data_size);
+			atomic64_inc(&zram->stats.dedup_hits);
+			if (PageKsm(page))
+				atomic64_inc(&zram->stats.ksm_dedup_hits);
+			goto out;
+		}
+	}
+#endif
+
 compress_again:
+#ifdef CONFIG_RECLAIM_COST_MODEL
+	start = ktime_get_ns();
+#endif
 	zstrm = zcomp_stream_get(zram->comp);
 	src = kmap_atomic(page);
 	ret = zcomp_compress(zstrm, src, &comp_len);
 	kunmap_atomic(src);
+#ifdef CONFIG_RECLAIM_COST_MODEL
+	count_vm_events(RECLAIM_COST_ANON_NS, ktime_get_ns() - start);
+#endif
 
 	if (unlikely(ret)) {
-		zcomp_stream_put(zram->comp);
+		zcomp_stream_put(zram->comp, zstrm);
 		pr_err("Compression failed! err=%d\n", ret);
 		zs_free(zram->mem_pool, handle);
 		return ret;
@@ -2390,7 +3404,7 @@ compress_again:
 				__GFP_MOVABLE |
 				__GFP_CMA);
 	if (!handle) {
-		zcomp_stream_put(zram->comp);
+		zcomp_stream_put(zram->comp, zstrm);
 		atomic64_inc(&zram->stats.writestall);
 		handle = zs_malloc(zram->mem_pool, comp_len,
 				GFP_NOIO | __GFP_HIGHMEM |
@@ -2405,7 +3419,7 @@ compress_again:
 	update_used_max(zram, alloced_pages);
 
 	if (zram->limit_pages && alloced_pages > zram->limit_pages) {
-		zcomp_stream_put(zram->comp);
+		zcomp_stream_put(zram->comp, zstrm);
 		zs_free(zram->mem_pool, handle);
 		return -ENOMEM;
 	}
@@ -2419,9 +3433,13 @@ compress_again:
 	if (comp_len == PAGE_SIZE)
 		kunmap_atomic(src);
 
-	zcomp_stream_put(zram->comp);
+	zcomp_stream_put(zram->comp, zstrm);
 	zs_unmap_object(zram->mem_pool, handle);
 	atomic64_add(comp_len, &zram->stats.compr_data_size);
+#ifdef CONFIG_ZRAM_DEDUP
+	if (dedup)
+		entry = zram_dedup_insert(zram, handle, comp_len, checksum);
+#endif
 out:
 	/*
 	 * Free memory associated with this sector
@@ -2440,11 +3458,16 @@ out:
 		zram_set_flag(zram, index, flags);
 		zram_set_element(zram, index, element);
 	}  else {
-		zram_set_handle(zram, index, handle);
+		if (entry) {
+			zram_set_handle(zram, index, (unsigned long)entry);
+			zram_set_flag(zram, index, ZRAM_DEDUP);
+		} else {
+			zram_set_handle(zram, index, handle);
+		}
 		zram_set_obj_size(zram, index, comp_len);
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
 		spin_lock_irqsave(&zram->list_lock, irq_flags);
-		list_add_tail(&zram->table[index].lru_list, &zram->list);
+		list_add_tail(&zram->lru[index], &zram->list);
 		spin_unlock_irqrestore(&zram->list_lock, irq_flags);
 #endif
 	}
@@ -2562,9 +3585,16 @@ static int zram_bvec_rw(struct zram *zram, struct bio_vec *bvec, u32 index,
 
 	generic_end_io_acct(rw, &zram->disk->part0, start_time);
 
-	zram_slot_lock(zram, index);
-	zram_accessed(zram, index);
-	zram_slot_unlock(zram, index);
+	/*
+	 * Without access time tracking there is only ZRAM_IDLE to clear,
+	 * so don't bounce the slot lock when it isn't set.
+	 */
+	if (IS_ENABLED(CONFIG_ZRAM_MEMORY_TRACKING) ||
+			zram_test_flag_lockless(zram, index, ZRAM_IDLE)) {
+		zram_slot_lock(zram, index);
+		zram_accessed(zram, index);
+		zram_slot_unlock(zram, index);
+	}
 
 	if (unlikely(ret < 0)) {
 		if (rw == READ)
@@ -2710,6 +3740,9 @@ out:
 static void zram_reset_device(struct zram *zram)
 {
 	struct zcomp *comp;
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	struct zcomp *recomp;
+#endif
 	u64 disksize;
 
 	down_write(&zram->init_lock);
@@ -2722,6 +3755,10 @@ static void zram_reset_device(struct zram *zram)
 	}
 
 	comp = zram->comp;
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	recomp = zram->recomp;
+	zram->recomp = NULL;
+#endif
 	disksize = zram->disksize;
 	zram->disksize = 0;
 
@@ -2733,6 +3770,10 @@ static void zram_reset_device(struct zram *zram)
 	zram_meta_free(zram, disksize);
 	memset(&zram->stats, 0, sizeof(zram->stats));
 	zcomp_destroy(comp);
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	if (recomp)
+		zcomp_destroy(recomp);
+#endif
 	reset_bdev(zram);
 }
 
@@ -2769,6 +3810,20 @@ static ssize_t disksize_store(struct device *dev,
 		goto out_free_meta;
 	}
 
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	if (zram->recomp_algorithm[0]) {
+		struct zcomp *recomp = zcomp_create(zram->recomp_algorithm);
+
+		if (IS_ERR(recomp)) {
+			pr_err("Cannot initialise %s recompressing backend\n",
+					zram->recomp_algorithm);
+			err = PTR_ERR(recomp);
+			zcomp_destroy(comp);
+			goto out_free_meta;
+		}
+		zram->recomp = recomp;
+	}
+#endif
 	zram->comp = comp;
 	zram->disksize = disksize;
 	set_capacity(zram->disk, zram->disksize >> SECTOR_SHIFT);
@@ -2863,12 +3918,23 @@ static DEVICE_ATTR_WO(mem_used_max);
 static DEVICE_ATTR_WO(idle);
 static DEVICE_ATTR_RW(max_comp_streams);
 static DEVICE_ATTR_RW(comp_algorithm);
+#ifdef CONFIG_ZRAM_DEDUP
+static DEVICE_ATTR_RW(use_dedup);
+#endif
+#ifdef CONFIG_ZRAM_MULTI_COMP
+static DEVICE_ATTR_RW(recomp_algorithm);
+static DEVICE_ATTR_WO(recompress);
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 static DEVICE_ATTR_RW(backing_dev);
 static DEVICE_ATTR_WO(writeback);
 static DEVICE_ATTR_RW(writeback_limit);
 static DEVICE_ATTR_RW(writeback_limit_enable);
 #endif
+#ifdef CONFIG_ZRAM_LRU_WRITEBACK
+static DEVICE_ATTR_RW(writeback_ctrl_enable);
+static DEVICE_ATTR_RO(writeback_ctrl_stat);
+#endif
 
 static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_disksize.attr,
@@ -2880,11 +3946,22 @@ static struct attribute *zram_disk_attrs[] = {
 	&dev_attr_idle.attr,
 	&dev_attr_max_comp_streams.attr,
 	&dev_attr_comp_algorithm.attr,
+#ifdef CONFIG_ZRAM_DEDUP
+	&dev_attr_use_dedup.attr,
+#endif
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	&dev_attr_recomp_algorithm.attr,
+	&dev_attr_recompress.attr,
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 	&dev_attr_backing_dev.attr,
 	&dev_attr_writeback.attr,
 	&dev_attr_writeback_limit.attr,
 	&dev_attr_writeback_limit_enable.attr,
+#endif
+#ifdef CONFIG_ZRAM_LRU_WRITEBACK
+	&dev_attr_writeback_ctrl_enable.attr,
+	&dev_attr_writeback_ctrl_stat.attr,
 #endif
 	&dev_attr_io_stat.attr,
 	&dev_attr_mm_stat.attr,
@@ -3175,7 +4252,12 @@ static int __init zram_init(void)
 
 	show_mem_extra_notifier_register(&zram_size_nb);
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
+#ifdef CONFIG_BLK_BOOST
+	/* covers app launch, and also backs off right after screen on */
+	blk_boost_register_notifier(&zram_app_launch_nb);
+#else
 	am_app_launch_notifier_register(&zram_app_launch_nb);
+#endif
 #endif
 	return 0;
 
@@ -3187,7 +4269,11 @@ out_error:
 static void __exit zram_exit(void)
 {
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
+#ifdef CONFIG_BLK_BOOST
+	blk_boost_unregister_notifier(&zram_app_launch_nb);
+#else
 	am_app_launch_notifier_unregister(&zram_app_launch_nb);
+#endif
 #endif
 	destroy_devices();
 }
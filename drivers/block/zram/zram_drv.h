@@ -20,6 +20,7 @@
 #include <linux/crypto.h>
 
 #include "zcomp.h"
+#include "zram_dedup.h"
 
 #define SECTORS_PER_PAGE_SHIFT	(PAGE_SHIFT - SECTOR_SHIFT)
 #define SECTORS_PER_PAGE	(1 << SECTORS_PER_PAGE_SHIFT)
@@ -38,8 +39,19 @@
  * footprint small so we can squeeze size and flags into a field.
  * The lower ZRAM_FLAG_SHIFT bits is for object size (excluding header),
  * the higher bits is for zram_pageflags.
+ *
+ * Object size never exceeds PAGE_SIZE, so PAGE_SHIFT + 1 bits are enough
+ * and leave room for the page flags even with a 32-bit unsigned long.
  */
-#define ZRAM_FLAG_SHIFT 24
+#define ZRAM_FLAG_SHIFT (PAGE_SHIFT + 1)
+
+/* Only 2 bits are allowed for comp priority index */
+#define ZRAM_COMP_PRIORITY_MASK	0x3
+
+/* Primary compressor plus one recompression tier */
+#define ZRAM_PRIMARY_COMP	0U
+#define ZRAM_SECONDARY_COMP	1U
+#define ZRAM_MAX_COMPS		2U
 
 /* Flags for zram pages (table[page_no].flags) */
 enum zram_pageflags {
@@ -52,13 +64,32 @@ enum zram_pageflags {
 	ZRAM_IDLE,	/* not accessed page since last idle marking */
 	ZRAM_EXPIRE,
 	ZRAM_READ_BDEV,
+	ZRAM_INCOMPRESSIBLE,	/* secondary compressor could not shrink it */
+	ZRAM_COMP_PRIORITY_BIT1, /* algorithm id the slot is compressed with */
+	ZRAM_COMP_PRIORITY_BIT2,
+	ZRAM_DEDUP,	/* handle is a struct zram_dedup_entry */
 
 	__NR_ZRAM_PAGEFLAGS,
 };
 
+/*
+ * Mirrors of the ZRAM_SAME/ZRAM_WB flags, packed in zram->slot_state so
+ * that table walks can skip such slots without taking the slot lock.
+ */
+enum zram_slot_state {
+	ZRAM_STATE_SAME,
+	ZRAM_STATE_WB,
+
+	__NR_ZRAM_STATES,
+};
+
 /*-- Data structures */
 
-/* Allocated for each disk page */
+/*
+ * Allocated for each disk page. Keep it to handle and size/flags on the
+ * hot path: the LRU writeback list lives in zram->lru so that several
+ * entries share a cache line.
+ */
 struct zram_table_entry {
 	union {
 		unsigned long handle;
@@ -68,9 +99,6 @@ struct zram_table_entry {
 #ifdef CONFIG_ZRAM_MEMORY_TRACKING
 	ktime_t ac_time;
 #endif
-#ifdef CONFIG_ZRAM_LRU_WRITEBACK
-	struct list_head lru_list;
-#endif
 };
 
 struct zram_stats {
@@ -88,6 +116,15 @@ struct zram_stats {
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t writestall;		/* no. of write slow paths */
 	atomic64_t miss_free;		/* no. of missed free */
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	atomic64_t recomp_saved_bytes;	/* bytes saved by recompression */
+#endif
+#ifdef CONFIG_ZRAM_DEDUP
+	atomic64_t dup_data_size;	/* compressed bytes saved by dedup */
+	atomic64_t meta_data_size;	/* memory used by dedup entries */
+	atomic64_t dedup_hits;		/* no. of writes served by dedup */
+	atomic64_t ksm_dedup_hits;	/* dedup_hits of KSM pages */
+#endif
 #ifdef CONFIG_ZRAM_WRITEBACK
 	atomic64_t bd_count;		/* no. of pages in backing device */
 	atomic64_t bd_reads;		/* no. of reads from backing device */
@@ -96,15 +133,23 @@ struct zram_stats {
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
 	atomic64_t bd_expire;
 	atomic64_t bd_objcnt;
+	atomic64_t bd_wb_batches;	/* no. of completed writeback batches */
+	atomic64_t bd_wb_lat_us;	/* sum of batch write latencies */
+	atomic64_t bd_wb_lat_max_us;	/* worst batch write latency */
+	atomic64_t bd_wb_kbps;		/* throughput of the last wbd run */
+	atomic64_t bd_prefetch;		/* no. of slots restored by prefetch */
 #endif
 };
 
 #ifdef CONFIG_ZRAM_LRU_WRITEBACK
 #define ZRAM_WB_THRESHOLD 32
 #define NR_ZWBS 16
+/* max number of NR_ZWBS-page batches under writeback at the same time */
+#define ZRAM_WB_MAX_INFLIGHT 4
 struct zram_wb_header {
 	u32 index;
-	u32 size;
+	u32 size:30;
+	u32 prio:2;	/* compressor priority the object was stored with */
 };
 
 struct zram_wb_work {
@@ -127,11 +172,55 @@ struct zwbs {
 	struct page *page;
 	u32 cnt;
 	u32 off;
+	unsigned long blk_idx;	/* backing block the page was written to */
+	int error;
+};
+
+struct zram_wb_ctx;
+
+/* writeback budget controller, re-evaluated every ZRAM_WB_CTRL_WINDOW */
+struct zram_wb_ctrl {
+	struct delayed_work work;
+	bool enable;
+	u64 last_reads;			/* bd_reads at the start of the window */
+	u64 last_writes;		/* bd_writes at the start of the window */
+	unsigned long last_free;	/* free pages at the start of the window */
+	unsigned long kbps;		/* smoothed writeback bandwidth */
+	unsigned long swapin;		/* pages read back in the last window */
+	unsigned long written;		/* pages written in the last window */
+	long free_delta;		/* free page change in the last window */
+	unsigned long budget;		/* pages allowed in the next window */
+};
+
+/* NR_ZWBS compressed pages written to the backing device together */
+struct zram_wb_batch {
+	struct list_head list;
+	struct zram_wb_ctx *ctx;
+	struct zwbs *zwbs[NR_ZWBS];
+	int nr;			/* no. of zwbs submitted */
+	atomic_t pending;	/* bios in flight + 1 for the submitter */
+	ktime_t submit_time;
+	ktime_t done_time;
+};
+
+/* state of one writeback run, shared by zram_wbd and writeback_store */
+struct zram_wb_ctx {
+	struct zram *zram;
+	struct zram_wb_batch batch[ZRAM_WB_MAX_INFLIGHT];
+	struct zram_wb_batch *cur;	/* batch being filled */
+	int idx;			/* zwbs being filled in cur */
+	spinlock_t lock;
+	struct list_head free;
+	struct list_head done;
+	int inflight;
+	wait_queue_head_t wait;
+	unsigned long nr_written;
 };
 #endif
 
 struct zram {
 	struct zram_table_entry *table;
+	unsigned long *slot_state;	/* __NR_ZRAM_STATES bits per slot */
 	struct zs_pool *mem_pool;
 	struct zcomp *comp;
 	struct gendisk *disk;
@@ -149,6 +238,16 @@ struct zram {
 	 */
 	u64 disksize;	/* bytes */
 	char compressor[CRYPTO_MAX_ALG_NAME];
+#ifdef CONFIG_ZRAM_DEDUP
+	u8 use_dedup;		/* enum zram_dedup_mode */
+	struct zram_hash *hash;
+	size_t hash_size;
+#endif
+#ifdef CONFIG_ZRAM_MULTI_COMP
+	/* secondary (usually slower, denser) recompression backend */
+	struct zcomp *recomp;
+	char recomp_algorithm[CRYPTO_MAX_ALG_NAME];
+#endif
 	/*
 	 * zram is claimed so open request will be failed
 	 */
@@ -170,9 +269,10 @@ struct zram {
 	struct task_struct *wbd;
 	wait_queue_head_t wbd_wait;
 	u8 *wb_table;
+	struct list_head *lru;		/* LRU list node of each slot */
 	unsigned long *chunk_bitmap;
 	bool wbd_running;
-	bool io_complete;
+	struct zram_wb_ctrl wb_ctrl;
 	struct list_head list;
 	spinlock_t list_lock;
 	spinlock_t wb_table_lock;
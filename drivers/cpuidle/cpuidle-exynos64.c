@@ -19,6 +19,8 @@
 #include <linux/of.h>
 #include <linux/psci.h>
 #include <linux/cpuidle_profiler.h>
+#include <linux/module.h>
+#include <linux/tick.h>
 
 #include <asm/tlbflush.h>
 #include <asm/cpuidle.h>
@@ -40,16 +42,174 @@ enum idle_states {
 	IDLE_STATE_MAX,
 };
 
+/***************************************************************************
+ *                        Cluster idle coordination                        *
+ ***************************************************************************/
+/*
+ * The power mode code picks cluster power-down (CPD) for the last CPU of a
+ * cluster to go idle, whether or not its siblings are about to wake up
+ * again. Each CPU entering C2 records when it expects to wake up, from its
+ * next timer event and, if available, the scheduler wakeup hint. CPD is
+ * only let through if every online CPU of the cluster is idle and expected
+ * to stay so for at least cpd_residency_us. Otherwise the last CPU is
+ * demoted to its own power gating.
+ */
+static unsigned int cpd_residency_us = 2000;
+module_param(cpd_residency_us, uint, 0644);
+MODULE_PARM_DESC(cpd_residency_us, "Idle time every CPU of a cluster must be expected to have for CPD");
+
+struct exynos_cluster_idle {
+	raw_spinlock_t lock;
+	struct cpumask idle_mask;
+	ktime_t cpd_entry;
+
+	/* statistics */
+	unsigned int cpd_count;
+	unsigned int cpd_vetoed;
+	unsigned int cpd_aborted;	/* woke up within cpd_residency_us */
+	u64 cpd_time_us;
+};
+
+/* only the instance of the first CPU of each cluster is used */
+static DEFINE_PER_CPU(struct exynos_cluster_idle, cluster_idle);
+static DEFINE_PER_CPU(ktime_t, idle_expected_end);
+
+static struct exynos_cluster_idle *cpu_cluster_idle(unsigned int cpu)
+{
+	return &per_cpu(cluster_idle,
+			cpumask_first(topology_core_cpumask(cpu)));
+}
+
+static ktime_t exynos_idle_expected_end(unsigned int cpu, ktime_t now)
+{
+	s64 sleep_ns = ktime_to_ns(tick_nohz_get_sleep_length());
+
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	sleep_ns = min_t(u64, sleep_ns, sched_cpu_wake_hint(cpu));
+#endif
+	return ktime_add_ns(now, sleep_ns);
+}
+
+/* Mark @cpu idle; returns whether its cluster may be powered down */
+static bool exynos_cluster_idle_enter(unsigned int cpu)
+{
+	struct exynos_cluster_idle *ci = cpu_cluster_idle(cpu);
+	ktime_t now = ktime_get();
+	ktime_t min_end;
+	struct cpumask online;
+	bool allow = true;
+	int sibling;
+
+	per_cpu(idle_expected_end, cpu) = exynos_idle_expected_end(cpu, now);
+	min_end = ktime_add_us(now, cpd_residency_us);
+
+	raw_spin_lock(&ci->lock);
+	cpumask_set_cpu(cpu, &ci->idle_mask);
+	cpumask_and(&online, topology_core_cpumask(cpu), cpu_online_mask);
+	if (!cpumask_subset(&online, &ci->idle_mask)) {
+		allow = false;
+	} else {
+		for_each_cpu(sibling, &online)
+			if (ktime_before(per_cpu(idle_expected_end, sibling),
+					 min_end)) {
+				allow = false;
+				break;
+			}
+	}
+	raw_spin_unlock(&ci->lock);
+
+	return allow;
+}
+
+static void exynos_cluster_idle_exit(unsigned int cpu, int fail)
+{
+	struct exynos_cluster_idle *ci = cpu_cluster_idle(cpu);
+	s64 residency_us;
+
+	raw_spin_lock(&ci->lock);
+	cpumask_clear_cpu(cpu, &ci->idle_mask);
+
+	/* the first CPU back accounts for the whole cluster */
+	if (ci->cpd_entry.tv64) {
+		residency_us = ktime_us_delta(ktime_get(), ci->cpd_entry);
+		ci->cpd_entry.tv64 = 0;
+		ci->cpd_time_us += max_t(s64, residency_us, 0);
+		if (fail || residency_us < cpd_residency_us)
+			ci->cpd_aborted++;
+	}
+	raw_spin_unlock(&ci->lock);
+}
+
+static void exynos_cluster_cpd_enter(unsigned int cpu)
+{
+	struct exynos_cluster_idle *ci = cpu_cluster_idle(cpu);
+
+	raw_spin_lock(&ci->lock);
+	ci->cpd_count++;
+	ci->cpd_entry = ktime_get();
+	raw_spin_unlock(&ci->lock);
+}
+
+static void exynos_cluster_cpd_veto(unsigned int cpu)
+{
+	struct exynos_cluster_idle *ci = cpu_cluster_idle(cpu);
+
+	raw_spin_lock(&ci->lock);
+	ci->cpd_vetoed++;
+	raw_spin_unlock(&ci->lock);
+}
+
+static ssize_t show_cluster_idle_stats(struct device *dev,
+				       struct device_attribute *attr,
+				       char *buf)
+{
+	struct exynos_cluster_idle *ci;
+	ssize_t ret = 0;
+	int cpu;
+
+	ret += scnprintf(buf + ret, PAGE_SIZE - ret,
+			 "cpus cpd vetoed aborted time_us\n");
+	for_each_possible_cpu(cpu) {
+		if (cpu != cpumask_first(topology_core_cpumask(cpu)))
+			continue;
+
+		ci = &per_cpu(cluster_idle, cpu);
+		raw_spin_lock_irq(&ci->lock);
+		ret += scnprintf(buf + ret, PAGE_SIZE - ret,
+				 "%*pbl %u %u %u %llu\n",
+				 cpumask_pr_args(topology_core_cpumask(cpu)),
+				 ci->cpd_count, ci->cpd_vetoed,
+				 ci->cpd_aborted, ci->cpd_time_us);
+		raw_spin_unlock_irq(&ci->lock);
+	}
+
+	return ret;
+}
+
+static DEVICE_ATTR(cluster_idle_stats, 0444, show_cluster_idle_stats, NULL);
+
 /***************************************************************************
  *                           Cpuidle state handler                         *
  ***************************************************************************/
 static unsigned int prepare_idle(unsigned int cpu, int index)
 {
 	unsigned int entry_state = 0;
+	bool allow_cpd;
 
 	if (index > 0) {
+		allow_cpd = exynos_cluster_idle_enter(cpu);
 		cpu_pm_enter();
 		entry_state = exynos_cpu_pm_enter(cpu, index);
+
+		if (entry_state == PSCI_CLUSTER_SLEEP) {
+			if (allow_cpd) {
+				exynos_cluster_cpd_enter(cpu);
+			} else {
+				/* a sibling is expected back too soon */
+				exynos_cluster_cpd_veto(cpu);
+				entry_state = index;
+			}
+		}
 	}
 
 	cpuidle_profile_start(cpu, index, entry_state);
@@ -66,6 +226,7 @@ static void post_idle(unsigned int cpu, int index, int fail)
 
 	exynos_cpu_pm_exit(cpu, fail);
 	cpu_pm_exit();
+	exynos_cluster_idle_exit(cpu, fail);
 }
 
 static int enter_idle(unsigned int index)
@@ -166,6 +327,9 @@ static int __init exynos_idle_init(void)
 {
 	int ret, cpu, i;
 
+	for_each_possible_cpu(cpu)
+		raw_spin_lock_init(&per_cpu(cluster_idle, cpu).lock);
+
 	for_each_possible_cpu(cpu) {
 		ret = exynos_idle_driver_init(&exynos_idle_driver[cpu],
 					      topology_sibling_cpumask(cpu));
@@ -207,6 +371,9 @@ static int __init exynos_idle_init(void)
 		}
 	}
 
+	if (device_create_file(cpu_subsys.dev_root, &dev_attr_cluster_idle_stats))
+		pr_warn("failed to create cluster idle statistics\n");
+
 	register_reboot_notifier(&exynos_cpuidle_reboot_nb);
 
 	cpuidle_profile_register(&exynos_idle_driver[0]);
@@ -19,6 +19,7 @@
 #include <linux/tick.h>
 #include <linux/sched.h>
 #include <linux/math64.h>
+#include <linux/module.h>
 
 /*
  * Please note when changing the tuning values:
@@ -36,6 +37,11 @@
 #define DECAY 8
 #define MAX_INTERESTING 50000
 
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+static bool sched_hint;
+module_param(sched_hint, bool, 0644);
+MODULE_PARM_DESC(sched_hint, "Skip states an expected task wakeup would cut short");
+#endif
 
 /*
  * Concepts and ideas behind the menu governor
@@ -115,6 +121,17 @@
  * The iowait factor may look low, but realize that this is also already
  * represented in the system load average.
  *
+ * Scheduler wakeup hint
+ * ---------------------
+ * The next timer event does not cover a task waking up from an interrupt,
+ * such as the next frame or a completed read, and the correction factor
+ * only learns about those on average. With sched_hint set, a state whose
+ * target residency lies beyond the next task wakeup the scheduler expects
+ * on this CPU is not picked. Since cluster power-down states have the
+ * longest residencies, those are what it vetoes in practice. Each veto is
+ * counted against the state, and so is each time the CPU ended up idle for
+ * longer than that state's residency anyway.
+ *
  */
 
 struct menu_device {
@@ -127,6 +144,10 @@ struct menu_device {
 	unsigned int	correction_factor[BUCKETS];
 	unsigned int	intervals[INTERVALS];
 	int		interval_ptr;
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	unsigned int	hint_us;
+	int		hint_veto_idx;	/* deepest state vetoed, or -1 */
+#endif
 };
 
 
@@ -280,6 +301,9 @@ static int menu_select(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 	}
 
 	data->last_state_idx = CPUIDLE_DRIVER_STATE_START - 1;
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	data->hint_veto_idx = -1;
+#endif
 
 	/* Special case when user has set very strict latency requirement */
 	if (unlikely(latency_req == 0))
@@ -305,6 +329,17 @@ static int menu_select(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 
 	get_typical_interval(data);
 
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	data->hint_us = UINT_MAX;
+	if (sched_hint) {
+		u64 hint_ns = sched_cpu_wake_hint(dev->cpu);
+
+		if (hint_ns != U64_MAX)
+			data->hint_us = min_t(u64, hint_ns / NSEC_PER_USEC,
+					      UINT_MAX);
+	}
+#endif
+
 	/*
 	 * Performance multiplier defines a minimum predicted idle
 	 * duration / latency ratio. Adjust the latency limit if
@@ -337,10 +372,21 @@ static int menu_select(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 			continue;
 		if (s->exit_latency > latency_req)
 			continue;
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+		if (s->target_residency > data->hint_us) {
+			data->hint_veto_idx = i;
+			continue;
+		}
+#endif
 
 		data->last_state_idx = i;
 	}
 
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	if (data->hint_veto_idx >= 0)
+		dev->states_usage[data->hint_veto_idx].hint_veto++;
+#endif
+
 	return data->last_state_idx;
 }
 
@@ -395,6 +441,13 @@ static void menu_update(struct cpuidle_driver *drv, struct cpuidle_device *dev)
 	if (measured_us > target->exit_latency)
 		measured_us -= target->exit_latency;
 
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	/* the vetoed state would have paid off after all */
+	if (data->hint_veto_idx >= 0 &&
+	    measured_us >= drv->states[data->hint_veto_idx].target_residency)
+		dev->states_usage[data->hint_veto_idx].hint_miss++;
+#endif
+
 	/* Make sure our coefficients do not exceed unity */
 	if (measured_us > data->next_timer_us)
 		measured_us = data->next_timer_us;
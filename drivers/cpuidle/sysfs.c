@@ -356,6 +356,10 @@ define_show_state_str_function(name)
 define_show_state_str_function(desc)
 define_show_state_ull_function(disable)
 define_store_state_ull_function(disable)
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+define_show_state_ull_function(hint_veto)
+define_show_state_ull_function(hint_miss)
+#endif
 
 define_one_state_ro(name, show_state_name);
 define_one_state_ro(desc, show_state_desc);
@@ -365,6 +369,10 @@ define_one_state_ro(power, show_state_power_usage);
 define_one_state_ro(usage, show_state_usage);
 define_one_state_ro(time, show_state_time);
 define_one_state_rw(disable, show_state_disable, store_state_disable);
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+define_one_state_ro(hint_veto, show_state_hint_veto);
+define_one_state_ro(hint_miss, show_state_hint_miss);
+#endif
 
 static struct attribute *cpuidle_state_default_attrs[] = {
 	&attr_name.attr,
@@ -375,6 +383,10 @@ static struct attribute *cpuidle_state_default_attrs[] = {
 	&attr_usage.attr,
 	&attr_time.attr,
 	&attr_disable.attr,
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	&attr_hint_veto.attr,
+	&attr_hint_miss.attr,
+#endif
 	NULL
 };
 
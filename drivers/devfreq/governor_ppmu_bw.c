@@ -0,0 +1,454 @@
+/*
+ *  linux/drivers/devfreq/governor_ppmu_bw.c
+ *
+ *  Copyright (C) 2015 Samsung Electronics
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * Bus governor scaling on the bandwidth measured by the PPMU of each bus
+ * master. The read and write data counted over a polling period give the
+ * demand, which is provisioned with some headroom and mapped to the lowest
+ * frequency sustaining it through a calibrated table. Client votes through
+ * PM QoS remain floors (and ceilings) on top of it, but no longer keep the
+ * bus at a high level once the traffic that called for it is over.
+ */
+
+#include <linux/errno.h>
+#include <linux/module.h>
+#include <linux/devfreq.h>
+#include <linux/devfreq-event.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/memory-state-time.h>
+#include <linux/pm_qos.h>
+#include <linux/slab.h>
+#include "governor.h"
+
+#define DEFAULT_HEADROOM	25
+
+static struct devfreq_ppmu_bw_data *to_ppmu_bw(struct devfreq *df)
+{
+	return df->data;
+}
+
+/* Read the data moved by every master since the last sample, in MB/s */
+static unsigned long ppmu_bw_sample(struct devfreq_ppmu_bw_data *data)
+{
+	struct devfreq_event_data edata;
+	ktime_t now = ktime_get();
+	s64 us = ktime_us_delta(now, data->last_sample);
+	unsigned long total = 0;
+	int i;
+
+	data->last_sample = now;
+
+	for (i = 0; i < data->num_edev; i++) {
+		unsigned long bw = 0;
+
+		if (!devfreq_event_get_event(data->edev[i], &edata) && us > 0)
+			bw = div64_s64((u64)edata.load_count * data->beat_bytes,
+				       us);
+
+		/* the counters stop when read, start the next period */
+		devfreq_event_set_event(data->edev[i]);
+
+		data->master_bw[i] = bw;
+		total += bw;
+	}
+
+	return total;
+}
+
+/* Drop what was counted while not sampling, e.g. across a suspend */
+static void ppmu_bw_restart(struct devfreq_ppmu_bw_data *data)
+{
+	int i;
+
+	for (i = 0; i < data->num_edev; i++)
+		devfreq_event_set_event(data->edev[i]);
+	data->last_sample = ktime_get();
+}
+
+/* Bandwidth in MB/s the bus sustains at @freq */
+static unsigned long ppmu_bw_capacity(struct devfreq_ppmu_bw_data *data,
+				      unsigned long freq)
+{
+	unsigned long bw = 0;
+	int i;
+
+	if (!data->map)
+		return freq * data->beat_bytes / 1000;
+
+	for (i = 0; i < data->map_size; i++) {
+		if (data->map[i].freq > freq)
+			break;
+		bw = data->map[i].bw;
+	}
+
+	return bw;
+}
+
+/* Lowest frequency sustaining @bw MB/s, ULONG_MAX if none does */
+static unsigned long ppmu_bw_to_freq(struct devfreq_ppmu_bw_data *data,
+				     unsigned long bw)
+{
+	int i;
+
+	if (!data->map)
+		return DIV_ROUND_UP(bw * 1000, max(data->beat_bytes, 1U));
+
+	for (i = 0; i < data->map_size; i++)
+		if (data->map[i].bw >= bw)
+			return data->map[i].freq;
+
+	return ULONG_MAX;
+}
+
+static void ppmu_bw_update_stats(struct devfreq *df)
+{
+	struct devfreq_ppmu_bw_data *data = to_ppmu_bw(df);
+	struct devfreq_dev_profile *profile = df->profile;
+	ktime_t now = ktime_get();
+	int i;
+
+	if (!data->time_in_state)
+		goto out;
+
+	for (i = 0; i < profile->max_state; i++) {
+		if (profile->freq_table[i] == df->previous_freq) {
+			data->time_in_state[i] +=
+				ktime_us_delta(now, data->last_stat);
+			break;
+		}
+	}
+out:
+	data->last_stat = now;
+}
+
+/*
+ * Sources are registered once per bus and kept across governor restarts,
+ * memory_state_time has no way to drop them.
+ */
+static void ppmu_bw_memory_state_init(struct devfreq_ppmu_bw_data *data)
+{
+	int i;
+
+	if (!data->memory_state || data->ms_bw)
+		return;
+
+	data->ms_bw = kcalloc(data->num_edev, sizeof(*data->ms_bw),
+			      GFP_KERNEL);
+	if (!data->ms_bw)
+		return;
+
+	data->ms_freq = memory_state_register_frequency_source();
+	for (i = 0; i < data->num_edev; i++)
+		data->ms_bw[i] = memory_state_register_named_bandwidth_source(
+					data->edev[i]->desc->name);
+}
+
+/* Report the sample just taken at the frequency it was taken at */
+static void ppmu_bw_memory_state(struct devfreq *df,
+				 struct devfreq_ppmu_bw_data *data)
+{
+	int i;
+
+	if (!data->ms_bw)
+		return;
+
+	if (data->ms_freq && df->previous_freq != data->ms_last_freq) {
+		UPDATE_MEMORY_STATE(data->ms_freq, df->previous_freq);
+		data->ms_last_freq = df->previous_freq;
+	}
+
+	for (i = 0; i < data->num_edev; i++)
+		if (data->ms_bw[i])
+			UPDATE_MEMORY_STATE(data->ms_bw[i], data->master_bw[i]);
+}
+
+static int devfreq_ppmu_bw_func(struct devfreq *df, unsigned long *freq)
+{
+	struct devfreq_ppmu_bw_data *data = to_ppmu_bw(df);
+	unsigned long bw, cap, target, floor = 0, ceiling = ULONG_MAX;
+	unsigned int headroom;
+
+	if (!data)
+		return -EINVAL;
+
+	ppmu_bw_update_stats(df);
+
+	bw = ppmu_bw_sample(data);
+	ppmu_bw_memory_state(df, data);
+	cap = ppmu_bw_capacity(data, df->previous_freq);
+	data->bw = bw;
+	data->efficiency = cap ? min_t(unsigned long, bw * 100 / cap, 100) : 0;
+
+	headroom = data->headroom ? data->headroom : DEFAULT_HEADROOM;
+	data->target_bw = bw + bw * headroom / 100;
+	target = ppmu_bw_to_freq(data, data->target_bw);
+
+	if (data->pm_qos_class)
+		floor = pm_qos_request(data->pm_qos_class);
+	if (data->pm_qos_class_max)
+		ceiling = pm_qos_request(data->pm_qos_class_max);
+
+	target = max(target, floor);
+	if (ceiling)
+		target = min(target, ceiling);
+	if (df->min_freq)
+		target = max(target, df->min_freq);
+	if (df->max_freq)
+		target = min(target, df->max_freq);
+
+	*freq = target;
+	return 0;
+}
+
+static int devfreq_ppmu_bw_notifier(struct notifier_block *nb,
+				    unsigned long val, void *v)
+{
+	struct devfreq_notifier_block *devfreq_nb;
+
+	devfreq_nb = container_of(nb, struct devfreq_notifier_block, nb);
+
+	mutex_lock(&devfreq_nb->df->lock);
+	update_devfreq(devfreq_nb->df);
+	mutex_unlock(&devfreq_nb->df->lock);
+
+	return NOTIFY_OK;
+}
+
+/*
+ * sysfs parts below
+ */
+
+static ssize_t bandwidth_show(struct device *dev,
+			      struct device_attribute *attr, char *buf)
+{
+	struct devfreq *df = to_devfreq(dev);
+	struct devfreq_ppmu_bw_data *data = to_ppmu_bw(df);
+	ssize_t len;
+	int i;
+
+	mutex_lock(&df->lock);
+	len = scnprintf(buf, PAGE_SIZE, "total %lu target %lu\n",
+			data->bw, data->target_bw);
+	for (i = 0; i < data->num_edev; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s %lu\n",
+				 data->edev[i]->desc->name, data->master_bw[i]);
+	mutex_unlock(&df->lock);
+
+	return len;
+}
+static DEVICE_ATTR_RO(bandwidth);
+
+static ssize_t efficiency_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct devfreq_ppmu_bw_data *data = to_ppmu_bw(to_devfreq(dev));
+
+	return sprintf(buf, "%u\n", data->efficiency);
+}
+static DEVICE_ATTR_RO(efficiency);
+
+static ssize_t time_in_state_show(struct device *dev,
+				  struct device_attribute *attr, char *buf)
+{
+	struct devfreq *df = to_devfreq(dev);
+	struct devfreq_ppmu_bw_data *data = to_ppmu_bw(df);
+	ssize_t len = 0;
+	int i;
+
+	if (!data->time_in_state)
+		return -ENODATA;
+
+	mutex_lock(&df->lock);
+	ppmu_bw_update_stats(df);
+	for (i = 0; i < df->profile->max_state; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%u %llu\n",
+				 df->profile->freq_table[i],
+				 div_u64(data->time_in_state[i], USEC_PER_MSEC));
+	mutex_unlock(&df->lock);
+
+	return len;
+}
+static DEVICE_ATTR_RO(time_in_state);
+
+static ssize_t headroom_show(struct device *dev,
+			     struct device_attribute *attr, char *buf)
+{
+	struct devfreq_ppmu_bw_data *data = to_ppmu_bw(to_devfreq(dev));
+
+	return sprintf(buf, "%u\n",
+		       data->headroom ? data->headroom : DEFAULT_HEADROOM);
+}
+
+static ssize_t headroom_store(struct device *dev,
+			      struct device_attribute *attr,
+			      const char *buf, size_t count)
+{
+	struct devfreq *df = to_devfreq(dev);
+	unsigned int val;
+	int ret;
+
+	ret = kstrtouint(buf, 10, &val);
+	if (ret)
+		return ret;
+	if (!val || val > 400)
+		return -EINVAL;
+
+	mutex_lock(&df->lock);
+	to_ppmu_bw(df)->headroom = val;
+	update_devfreq(df);
+	mutex_unlock(&df->lock);
+
+	return count;
+}
+static DEVICE_ATTR_RW(headroom);
+
+static struct attribute *ppmu_bw_attrs[] = {
+	&dev_attr_bandwidth.attr,
+	&dev_attr_efficiency.attr,
+	&dev_attr_time_in_state.attr,
+	&dev_attr_headroom.attr,
+	NULL,
+};
+
+static const struct attribute_group ppmu_bw_attr_group = {
+	.name = "ppmu_bw",
+	.attrs = ppmu_bw_attrs,
+};
+
+static int ppmu_bw_start(struct devfreq *df)
+{
+	struct devfreq_ppmu_bw_data *data = to_ppmu_bw(df);
+	int i, ret;
+
+	if (!data || !data->num_edev || !data->beat_bytes)
+		return -EINVAL;
+
+	data->master_bw = kcalloc(data->num_edev, sizeof(*data->master_bw),
+				  GFP_KERNEL);
+	if (!data->master_bw)
+		return -ENOMEM;
+
+	if (df->profile->freq_table && df->profile->max_state)
+		data->time_in_state = kcalloc(df->profile->max_state,
+					      sizeof(*data->time_in_state),
+					      GFP_KERNEL);
+
+	for (i = 0; i < data->num_edev; i++) {
+		ret = devfreq_event_enable_edev(data->edev[i]);
+		if (ret)
+			goto err_edev;
+	}
+	ppmu_bw_restart(data);
+	data->last_stat = data->last_sample;
+	ppmu_bw_memory_state_init(data);
+
+	if (data->pm_qos_class) {
+		data->nb.df = df;
+		data->nb.nb.notifier_call = devfreq_ppmu_bw_notifier;
+		pm_qos_add_notifier(data->pm_qos_class, &data->nb.nb);
+	}
+	if (data->pm_qos_class_max) {
+		data->nb_max.df = df;
+		data->nb_max.nb.notifier_call = devfreq_ppmu_bw_notifier;
+		pm_qos_add_notifier(data->pm_qos_class_max, &data->nb_max.nb);
+	}
+
+	if (sysfs_create_group(&df->dev.kobj, &ppmu_bw_attr_group))
+		dev_warn(&df->dev, "failed to create ppmu_bw sysfs group\n");
+
+	devfreq_monitor_start(df);
+	return 0;
+
+err_edev:
+	while (--i >= 0)
+		devfreq_event_disable_edev(data->edev[i]);
+	kfree(data->time_in_state);
+	data->time_in_state = NULL;
+	kfree(data->master_bw);
+	data->master_bw = NULL;
+	return ret;
+}
+
+static void ppmu_bw_stop(struct devfreq *df)
+{
+	struct devfreq_ppmu_bw_data *data = to_ppmu_bw(df);
+	int i;
+
+	devfreq_monitor_stop(df);
+
+	sysfs_remove_group(&df->dev.kobj, &ppmu_bw_attr_group);
+
+	if (data->pm_qos_class)
+		pm_qos_remove_notifier(data->pm_qos_class, &data->nb.nb);
+	if (data->pm_qos_class_max)
+		pm_qos_remove_notifier(data->pm_qos_class_max,
+				       &data->nb_max.nb);
+
+	for (i = 0; i < data->num_edev; i++)
+		devfreq_event_disable_edev(data->edev[i]);
+
+	kfree(data->time_in_state);
+	data->time_in_state = NULL;
+	kfree(data->master_bw);
+	data->master_bw = NULL;
+}
+
+static int devfreq_ppmu_bw_handler(struct devfreq *devfreq,
+				   unsigned int event, void *data)
+{
+	switch (event) {
+	case DEVFREQ_GOV_START:
+		return ppmu_bw_start(devfreq);
+
+	case DEVFREQ_GOV_STOP:
+		ppmu_bw_stop(devfreq);
+		break;
+
+	case DEVFREQ_GOV_INTERVAL:
+		devfreq_interval_update(devfreq, (unsigned int *)data);
+		break;
+
+	case DEVFREQ_GOV_SUSPEND:
+		devfreq_monitor_suspend(devfreq);
+		break;
+
+	case DEVFREQ_GOV_RESUME:
+		ppmu_bw_restart(to_ppmu_bw(devfreq));
+		devfreq_monitor_resume(devfreq);
+		break;
+
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static struct devfreq_governor devfreq_ppmu_bw = {
+	.name = "ppmu_bw",
+	.get_target_freq = devfreq_ppmu_bw_func,
+	.event_handler = devfreq_ppmu_bw_handler,
+};
+
+static int __init devfreq_ppmu_bw_init(void)
+{
+	return devfreq_add_governor(&devfreq_ppmu_bw);
+}
+subsys_initcall(devfreq_ppmu_bw_init);
+
+static void __exit devfreq_ppmu_bw_exit(void)
+{
+	int ret;
+
+	ret = devfreq_remove_governor(&devfreq_ppmu_bw);
+	if (ret)
+		pr_err("%s: failed remove governor %d\n", __func__, ret);
+}
+module_exit(devfreq_ppmu_bw_exit);
+MODULE_LICENSE("GPL");
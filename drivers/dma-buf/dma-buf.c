@@ -941,6 +941,10 @@ static int dma_buf_init_debugfs(void)
 	if (err)
 		pr_debug("dma_buf: debugfs: failed to create node bufinfo\n");
 
+	if (dma_buf_debugfs_create_file("fence_stats",
+					reservation_object_stats_show))
+		pr_debug("dma_buf: debugfs: failed to create node fence_stats\n");
+
 	return err;
 }
 
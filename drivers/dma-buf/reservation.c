@@ -34,6 +34,10 @@
 
 #include <linux/reservation.h>
 #include <linux/export.h>
+#include <linux/fence-array.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
 
 DEFINE_WW_CLASS(reservation_ww_class);
 EXPORT_SYMBOL(reservation_ww_class);
@@ -43,6 +47,26 @@ EXPORT_SYMBOL(reservation_seqcount_class);
 
 const char reservation_seqcount_string[] = "reservation_seqcount";
 EXPORT_SYMBOL(reservation_seqcount_string);
+
+/*
+ * Cost of the lockless fence checks, shown in dma_buf/fence_stats. Display
+ * and GPU look every buffer up each frame, so the per call numbers are
+ * what adds up.
+ */
+struct reservation_stats {
+	unsigned long test_calls;
+	unsigned long wait_calls;
+	unsigned long wait_blocked;
+	u64 wait_ns;
+	unsigned long merge_calls;
+	unsigned long merge_fences;
+	unsigned long seq_retries;
+};
+
+static DEFINE_PER_CPU(struct reservation_stats, reservation_stats);
+
+#define reservation_stat_inc(field)	this_cpu_inc(reservation_stats.field)
+#define reservation_stat_add(field, v)	this_cpu_add(reservation_stats.field, v)
 /*
  * Reserve space to add a shared fence to a reservation_object,
  * must be called with obj->lock held.
@@ -278,8 +302,10 @@ int reservation_object_get_fences_rcu(struct reservation_object *obj,
 		fence_excl = rcu_dereference(obj->fence_excl);
 
 		retry = read_seqcount_retry(&obj->seq, seq);
-		if (retry)
+		if (retry) {
+			reservation_stat_inc(seq_retries);
 			goto unlock;
+		}
 
 		if (!fence_excl || fence_get_rcu(fence_excl)) {
 			unsigned i;
@@ -326,10 +352,14 @@ long reservation_object_wait_timeout_rcu(struct reservation_object *obj,
 	struct fence *fence;
 	unsigned seq, shared_count, i = 0;
 	long ret = timeout;
+	u64 start;
 
 	if (!timeout)
 		return reservation_object_test_signaled_rcu(obj, wait_all);
 
+	start = local_clock();
+	reservation_stat_inc(wait_calls);
+
 retry:
 	fence = NULL;
 	shared_count = 0;
@@ -385,15 +415,18 @@ retry:
 
 	rcu_read_unlock();
 	if (fence) {
+		reservation_stat_inc(wait_blocked);
 		ret = fence_wait_timeout(fence, intr, ret);
 		fence_put(fence);
 		if (ret > 0 && wait_all && (i + 1 < shared_count))
 			goto retry;
 	}
+	reservation_stat_add(wait_ns, local_clock() - start);
 	return ret;
 
 unlock_retry:
 	rcu_read_unlock();
+	reservation_stat_inc(seq_retries);
 	goto retry;
 }
 EXPORT_SYMBOL_GPL(reservation_object_wait_timeout_rcu);
@@ -422,6 +455,7 @@ bool reservation_object_test_signaled_rcu(struct reservation_object *obj,
 	unsigned seq, shared_count;
 	int ret = true;
 
+	reservation_stat_inc(test_calls);
 retry:
 	shared_count = 0;
 	seq = read_seqcount_begin(&obj->seq);
@@ -476,6 +510,141 @@ retry:
 
 unlock_retry:
 	rcu_read_unlock();
+	reservation_stat_inc(seq_retries);
 	goto retry;
 }
 EXPORT_SYMBOL_GPL(reservation_object_test_signaled_rcu);
+
+static int reservation_merge_add(struct fence ***fences, unsigned *count,
+				 unsigned *max, struct fence *fence)
+{
+	/* failed fences are kept so that the caller sees the error */
+	if (fence_is_signaled(fence) && fence->status >= 0) {
+		fence_put(fence);
+		return 0;
+	}
+
+	if (*count == *max) {
+		unsigned nmax = max(*max * 2, 8U);
+		struct fence **n;
+
+		n = krealloc(*fences, nmax * sizeof(*n), GFP_KERNEL);
+		if (!n) {
+			fence_put(fence);
+			return -ENOMEM;
+		}
+		*fences = n;
+		*max = nmax;
+	}
+
+	(*fences)[(*count)++] = fence;
+	return 0;
+}
+
+/**
+ * reservation_object_merge_fences_rcu - one fence for many buffers
+ * @objs: the reservation objects
+ * @count: number of @objs
+ * @wait_all: take the shared fences as well as the exclusive ones
+ *
+ * Snapshots the fences of @objs without taking their locks, leaves out
+ * those already signaled and returns what is left as a single fence: NULL
+ * if nothing is pending, the fence itself if only one is, or a fence_array
+ * that signals once all have. Fences that signaled with an error are kept
+ * so that their status reaches the caller. A caller that would otherwise wait on or add
+ * a callback to each fence of each buffer needs only one of either.
+ *
+ * The returned fence holds a reference, ERR_PTR(-ENOMEM) on failure.
+ */
+struct fence *reservation_object_merge_fences_rcu(struct reservation_object **objs,
+						  unsigned count, bool wait_all)
+{
+	struct fence **fences = NULL;
+	struct fence_array *array;
+	unsigned nr = 0, max = 0;
+	unsigned i, j;
+	int ret = 0;
+
+	reservation_stat_inc(merge_calls);
+
+	for (i = 0; i < count && !ret; i++) {
+		struct fence *excl, **shared;
+		unsigned shared_count;
+
+		ret = reservation_object_get_fences_rcu(objs[i], &excl,
+							&shared_count, &shared);
+		if (ret)
+			break;
+
+		if (excl)
+			ret = reservation_merge_add(&fences, &nr, &max, excl);
+
+		for (j = 0; j < shared_count; j++) {
+			if (wait_all && !ret)
+				ret = reservation_merge_add(&fences, &nr, &max,
+							    shared[j]);
+			else
+				fence_put(shared[j]);
+		}
+		kfree(shared);
+	}
+
+	if (ret) {
+		while (nr--)
+			fence_put(fences[nr]);
+		kfree(fences);
+		return ERR_PTR(ret);
+	}
+
+	reservation_stat_add(merge_fences, nr);
+
+	if (nr <= 1) {
+		struct fence *fence = nr ? fences[0] : NULL;
+
+		kfree(fences);
+		return fence;
+	}
+
+	array = fence_array_create(nr, fences, fence_context_alloc(1), 1,
+				   false);
+	if (!array) {
+		while (nr--)
+			fence_put(fences[nr]);
+		kfree(fences);
+		return ERR_PTR(-ENOMEM);
+	}
+
+	return &array->base;
+}
+EXPORT_SYMBOL_GPL(reservation_object_merge_fences_rcu);
+
+#ifdef CONFIG_DEBUG_FS
+int reservation_object_stats_show(struct seq_file *s)
+{
+	struct reservation_stats sum = { 0 };
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct reservation_stats *st = per_cpu_ptr(&reservation_stats, cpu);
+
+		sum.test_calls += st->test_calls;
+		sum.wait_calls += st->wait_calls;
+		sum.wait_blocked += st->wait_blocked;
+		sum.wait_ns += st->wait_ns;
+		sum.merge_calls += st->merge_calls;
+		sum.merge_fences += st->merge_fences;
+		sum.seq_retries += st->seq_retries;
+	}
+
+	seq_printf(s, "test_signaled: %lu\n", sum.test_calls);
+	seq_printf(s, "wait: %lu (%lu blocked, %llu us)\n", sum.wait_calls,
+		   sum.wait_blocked, div_u64(sum.wait_ns, NSEC_PER_USEC));
+	seq_printf(s, "wait_avg_ns: %llu\n", sum.wait_calls ?
+		   div_u64(sum.wait_ns, sum.wait_calls) : 0);
+	seq_printf(s, "merge: %lu (%lu fences pending)\n", sum.merge_calls,
+		   sum.merge_fences);
+	seq_printf(s, "seq_retries: %lu\n", sum.seq_retries);
+
+	return 0;
+}
+#endif
@@ -151,6 +151,22 @@ static enum hrtimer_restart timer_callback(struct hrtimer *timer)
 						ticks > soft_stop_ticks)
 					ticks = atom->ticks = soft_stop_ticks;
 
+				/* A background atom keeping the foreground
+				 * app from the slot gets a shorter time slice.
+				 */
+				if (!kbase_ctx_flag(atom->kctx,
+						KCTX_FOREGROUND) &&
+					kbase_js_ctx_list_find_foreground(
+						kbdev, s)) {
+					js_devdata->fg_inversion_ticks++;
+					if (ticks ==
+						js_devdata->soft_stop_ticks_bg &&
+						ticks < soft_stop_ticks) {
+						js_devdata->fg_bg_soft_stops++;
+						soft_stop_ticks = ticks;
+					}
+				}
+
 				/* Job is Soft-Stoppable */
 				if (ticks == soft_stop_ticks) {
 					/* Job has been scheduled for at least
@@ -39,6 +39,9 @@
 #include <mali_kbase_dummy_job_wa.h>
 #include <mali_kbase_irq_internal.h>
 
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
+
 static void kbase_pm_gpu_poweroff_wait_wq(struct work_struct *data);
 static void kbase_pm_hwcnt_disable_worker(struct work_struct *data);
 static void kbase_pm_gpu_clock_control_worker(struct work_struct *data);
@@ -182,6 +185,12 @@ int kbase_hwaccess_pm_init(struct kbase_device *kbdev)
 	kbdev->pm.backend.hwcnt_disabled = true;
 	INIT_WORK(&kbdev->pm.backend.hwcnt_disable_work,
 		kbase_pm_hwcnt_disable_worker);
+	hrtimer_init(&kbdev->pm.backend.predictive_timer, CLOCK_MONOTONIC,
+			HRTIMER_MODE_REL);
+	kbdev->pm.backend.predictive_timer.function =
+			kbase_pm_predictive_timer_callback;
+	INIT_WORK(&kbdev->pm.backend.predictive_work,
+			kbase_pm_predictive_worker);
 	kbase_hwcnt_context_disable(kbdev->hwcnt_gpu_ctx);
 
 	if (IS_ENABLED(CONFIG_MALI_HW_ERRATA_1485982_NOT_AFFECTED)) {
@@ -587,6 +596,10 @@ void kbase_hwaccess_pm_halt(struct kbase_device *kbdev)
 {
 	KBASE_DEBUG_ASSERT(kbdev != NULL);
 
+	/* No more prewarming by the predictive policy */
+	hrtimer_cancel(&kbdev->pm.backend.predictive_timer);
+	cancel_work_sync(&kbdev->pm.backend.predictive_work);
+
 	mutex_lock(&kbdev->pm.lock);
 	kbase_pm_do_poweroff(kbdev);
 	mutex_unlock(&kbdev->pm.lock);
@@ -623,6 +636,52 @@ void kbase_hwaccess_pm_term(struct kbase_device *kbdev)
 	destroy_workqueue(kbdev->pm.backend.gpu_poweroff_wait_wq);
 }
 
+#ifdef CONFIG_DEBUG_FS
+static int kbase_pm_powerup_debugfs_show(struct seq_file *sfile, void *data)
+{
+	struct kbase_device *kbdev = sfile->private;
+	struct kbase_pm_powerup_stats powerup;
+	unsigned long flags;
+	int i;
+
+	CSTD_UNUSED(data);
+
+	spin_lock_irqsave(&kbdev->hwaccess_lock, flags);
+	powerup = kbdev->pm.backend.powerup;
+	spin_unlock_irqrestore(&kbdev->hwaccess_lock, flags);
+
+	seq_printf(sfile, "%-7s %s\n", "<us", "powerups");
+	for (i = 0; i < KBASE_PM_POWERUP_BUCKETS - 1; i++)
+		seq_printf(sfile, "%-7lu %u\n", 1UL << i, powerup.hist[i]);
+	seq_printf(sfile, "%-7s %u\n", "more", powerup.hist[i]);
+
+	seq_printf(sfile, "\nprewarm_hits %u\nprewarm_misses %u\n",
+		powerup.prewarm_hits, powerup.prewarm_misses);
+
+	return 0;
+}
+
+static int kbase_pm_powerup_debugfs_open(struct inode *in, struct file *file)
+{
+	return single_open(file, kbase_pm_powerup_debugfs_show, in->i_private);
+}
+
+static const struct file_operations kbase_pm_powerup_debugfs_fops = {
+	.owner = THIS_MODULE,
+	.open = kbase_pm_powerup_debugfs_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void kbase_pm_powerup_debugfs_init(struct kbase_device *kbdev)
+{
+	debugfs_create_file("pm_powerup_latency", 0444,
+		kbdev->mali_debugfs_directory, kbdev,
+		&kbase_pm_powerup_debugfs_fops);
+}
+#endif /* CONFIG_DEBUG_FS */
+
 void kbase_pm_power_changed(struct kbase_device *kbdev)
 {
 	unsigned long flags;
@@ -30,6 +30,7 @@
 #include "mali_kbase_pm_always_on.h"
 #include "mali_kbase_pm_coarse_demand.h"
 #include "mali_kbase_pm_adaptive.h"
+#include "mali_kbase_pm_predictive.h"
 #if !MALI_CUSTOMER_RELEASE
 #include "mali_kbase_pm_always_on_demand.h"
 #endif
@@ -243,10 +244,34 @@ struct kbasep_pm_tick_timer_state {
 	bool needed;
 };
 
+/* Log2 buckets of microseconds, the last one counts everything above */
+#define KBASE_PM_POWERUP_BUCKETS (16)
+
+/**
+ * struct kbase_pm_powerup_stats - Shader core power up latency
+ *
+ * @start_ns:       When the cores being powered up were first needed by an
+ *                  active GPU, or 0.
+ * @hist:           Time from @start_ns until the cores were ready.
+ * @prewarm_hits:   Active periods that found the GPU already powered by the
+ *                  predictive policy.
+ * @prewarm_misses: Predictions of the predictive policy that were not
+ *                  followed by activity.
+ *
+ * Protected by the hwaccess_lock.
+ */
+struct kbase_pm_powerup_stats {
+	u64 start_ns;
+	u32 hist[KBASE_PM_POWERUP_BUCKETS];
+	u32 prewarm_hits;
+	u32 prewarm_misses;
+};
+
 union kbase_pm_policy_data {
 	struct kbasep_pm_policy_always_on always_on;
 	struct kbasep_pm_policy_coarse_demand coarse_demand;
 	struct kbasep_pm_policy_adaptive adaptive;
+	struct kbasep_pm_policy_predictive predictive;
 #if !MALI_CUSTOMER_RELEASE
 	struct kbasep_pm_policy_always_on_demand always_on_demand;
 #endif
@@ -380,6 +405,11 @@ union kbase_pm_policy_data {
  *                         work function, kbase_pm_gpu_clock_control_worker.
  * @gpu_clock_control_work: work item to set GPU clock during L2 power cycle
  *                          using gpu_clock_control
+ * @predictive_timer: Timer of the predictive policy, to start and end the
+ *                    windows in which the GPU is powered ahead of a frame.
+ * @predictive_work: Work item doing the power changes @predictive_timer asks
+ *                   for, as they need the pm lock.
+ * @powerup: Shader core power up latency, for all policies.
  *
  * Note:
  * During an IRQ, @pm_current_policy can be NULL when the policy is being
@@ -460,6 +490,10 @@ struct kbase_pm_backend_data {
 	bool gpu_clock_slow_down_desired;
 	bool gpu_clock_slowed_down;
 	struct work_struct gpu_clock_control_work;
+
+	struct hrtimer predictive_timer;
+	struct work_struct predictive_work;
+	struct kbase_pm_powerup_stats powerup;
 };
 
 
@@ -470,6 +504,7 @@ enum kbase_pm_policy_id {
 	KBASE_PM_POLICY_ID_ALWAYS_ON_DEMAND,
 #endif
 	KBASE_PM_POLICY_ID_ADAPTIVE,
+	KBASE_PM_POLICY_ID_PREDICTIVE,
 	KBASE_PM_POLICY_ID_ALWAYS_ON
 };
 
@@ -902,6 +902,21 @@ static const char *kbase_shader_core_state_to_string(
 		return strings[state];
 }
 
+/* Account the time the cores being made ready were waited for */
+static void kbase_pm_powerup_done(struct kbase_device *kbdev)
+{
+	struct kbase_pm_powerup_stats *powerup = &kbdev->pm.backend.powerup;
+	u64 us;
+
+	if (!powerup->start_ns)
+		return;
+
+	us = div_u64(ktime_get_ns() - powerup->start_ns, NSEC_PER_USEC);
+	powerup->hist[us ? min_t(int, ilog2(us) + 1,
+			KBASE_PM_POWERUP_BUCKETS - 1) : 0]++;
+	powerup->start_ns = 0;
+}
+
 static int kbase_pm_shaders_update_state(struct kbase_device *kbdev)
 {
 	struct kbase_pm_backend_data *backend = &kbdev->pm.backend;
@@ -958,6 +973,12 @@ static int kbase_pm_shaders_update_state(struct kbase_device *kbdev)
 				kbase_pm_ca_get_core_mask(kbdev);
 			backend->pm_shaders_core_mask = 0;
 
+			if (!backend->shaders_desired)
+				backend->powerup.start_ns = 0;
+			else if (!backend->powerup.start_ns &&
+					kbase_pm_is_active(kbdev))
+				backend->powerup.start_ns = ktime_get_ns();
+
 			if (backend->shaders_desired &&
 				backend->l2_state == KBASE_L2_ON) {
 				if (backend->hwcnt_desired &&
@@ -999,6 +1020,7 @@ static int kbase_pm_shaders_update_state(struct kbase_device *kbdev)
 			if (!shaders_trans && shaders_ready == backend->shaders_avail) {
 				KBASE_KTRACE_ADD(kbdev, PM_CORES_CHANGE_AVAILABLE, NULL, shaders_ready);
 				backend->pm_shaders_core_mask = shaders_ready;
+				kbase_pm_powerup_done(kbdev);
 				backend->hwcnt_desired = true;
 				if (backend->hwcnt_disabled) {
 					kbase_hwcnt_context_enable(
@@ -42,6 +42,7 @@ static const struct kbase_pm_policy *const all_policy_list[] = {
 #if !MALI_CUSTOMER_RELEASE
 	&kbase_pm_always_on_demand_policy_ops,
 #endif
+	&kbase_pm_predictive_policy_ops,
 	&kbase_pm_always_on_policy_ops
 #endif /* CONFIG_MALI_NO_MALI */
 };
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ *
+ * (C) COPYRIGHT 2012-2016, 2018-2020 ARM Limited. All rights reserved.
+ *
+ * This program is free software and is provided to you under the terms of the
+ * GNU General Public License version 2 as published by the Free Software
+ * Foundation, and any use by you of this program is subject to the terms
+ * of such GNU licence.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can access it online at
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ */
+
+/*
+ * "Predictive" power management policy
+ *
+ * Rendering comes in frames: the GPU is active for a while, goes idle, and
+ * becomes active again one vsync later. Like coarse_demand the GPU is
+ * powered off as soon as it goes idle, but once the time between active
+ * periods has been stable for a few frames the policy powers the GPU back
+ * on shortly before the next frame is expected, so that its atoms do not
+ * wait for the L2 and shader cores to power up.
+ *
+ * A prediction that is not followed by activity within the prewarm window
+ * powers the GPU off again and is counted as a miss.
+ */
+
+#include <mali_kbase.h>
+#include <mali_kbase_pm.h>
+#include <backend/gpu/mali_kbase_pm_internal.h>
+
+/* How long before the predicted start of a frame the GPU is powered on */
+#define KBASE_PM_PREDICTIVE_LEAD_NS (2 * NSEC_PER_MSEC)
+
+/* Periods outside of this range are not taken as a frame cadence */
+#define KBASE_PM_PREDICTIVE_MIN_PERIOD_NS (4 * NSEC_PER_MSEC)
+#define KBASE_PM_PREDICTIVE_MAX_PERIOD_NS (100 * NSEC_PER_MSEC)
+
+/* Consecutive matching periods needed before predictions are made */
+#define KBASE_PM_PREDICTIVE_STABLE (3)
+
+static bool predictive_cadence_valid(struct kbasep_pm_policy_predictive *data)
+{
+	return data->period && data->stable >= KBASE_PM_PREDICTIVE_STABLE;
+}
+
+static void predictive_went_active(struct kbase_device *kbdev, u64 now)
+{
+	struct kbase_pm_backend_data *backend = &kbdev->pm.backend;
+	struct kbasep_pm_policy_predictive *data =
+		&backend->pm_policy_data.predictive;
+	u64 sample = now - data->last_start;
+	u64 diff;
+
+	hrtimer_try_to_cancel(&backend->predictive_timer);
+
+	if (data->prewarm) {
+		data->prewarm = false;
+		backend->powerup.prewarm_hits++;
+	}
+
+	if (!data->last_start || sample < KBASE_PM_PREDICTIVE_MIN_PERIOD_NS ||
+			sample > KBASE_PM_PREDICTIVE_MAX_PERIOD_NS) {
+		/* Not a frame, start learning again from this one */
+		data->period = 0;
+		data->deviation = 0;
+		data->stable = 0;
+	} else if (!data->period) {
+		data->period = sample;
+	} else {
+		diff = sample > data->period ? sample - data->period :
+				data->period - sample;
+		data->deviation = data->deviation - (data->deviation >> 2) +
+				(diff >> 2);
+		data->period = data->period - (data->period >> 3) +
+				(sample >> 3);
+		if (diff <= (data->period >> 3))
+			data->stable++;
+		else
+			data->stable = 0;
+	}
+
+	data->last_start = now;
+}
+
+static void predictive_went_idle(struct kbase_device *kbdev, u64 now)
+{
+	struct kbase_pm_backend_data *backend = &kbdev->pm.backend;
+	struct kbasep_pm_policy_predictive *data =
+		&backend->pm_policy_data.predictive;
+	struct kbasep_pm_tick_timer_state *stt = &backend->shader_tick_timer;
+	u64 lead, next, fire;
+
+	if (!predictive_cadence_valid(data)) {
+		stt->configured_ticks = stt->default_ticks;
+		return;
+	}
+
+	/* The next frame powers the cores back on in time, no need to wait */
+	stt->configured_ticks = 0;
+
+	lead = KBASE_PM_PREDICTIVE_LEAD_NS + data->deviation;
+	next = data->last_start + data->period;
+	fire = next - lead;
+
+	if (fire <= now) {
+		/* Too close to the next frame for powering off to pay off */
+		data->prewarm = true;
+		data->prewarm_until = next + lead;
+		fire = data->prewarm_until;
+	}
+
+	hrtimer_start(&backend->predictive_timer, ns_to_ktime(fire - now),
+			HRTIMER_MODE_REL);
+}
+
+static void predictive_update(struct kbase_device *kbdev)
+{
+	struct kbasep_pm_policy_predictive *data =
+		&kbdev->pm.backend.pm_policy_data.predictive;
+	bool active = kbase_pm_is_active(kbdev);
+
+	lockdep_assert_held(&kbdev->hwaccess_lock);
+
+	if (active == data->active)
+		return;
+
+	data->active = active;
+	if (active)
+		predictive_went_active(kbdev, ktime_get_ns());
+	else
+		predictive_went_idle(kbdev, ktime_get_ns());
+}
+
+static bool predictive_shaders_needed(struct kbase_device *kbdev)
+{
+	predictive_update(kbdev);
+
+	return kbdev->pm.backend.pm_policy_data.predictive.active ||
+		kbdev->pm.backend.pm_policy_data.predictive.prewarm;
+}
+
+static bool predictive_get_core_active(struct kbase_device *kbdev)
+{
+	return predictive_shaders_needed(kbdev);
+}
+
+enum hrtimer_restart kbase_pm_predictive_timer_callback(struct hrtimer *timer)
+{
+	struct kbase_device *kbdev = container_of(timer, struct kbase_device,
+			pm.backend.predictive_timer);
+
+	queue_work(system_highpri_wq, &kbdev->pm.backend.predictive_work);
+
+	return HRTIMER_NORESTART;
+}
+
+void kbase_pm_predictive_worker(struct work_struct *work)
+{
+	struct kbase_device *kbdev = container_of(work, struct kbase_device,
+			pm.backend.predictive_work);
+	struct kbase_pm_backend_data *backend = &kbdev->pm.backend;
+	struct kbasep_pm_policy_predictive *data =
+		&backend->pm_policy_data.predictive;
+	unsigned long flags;
+	bool update = false;
+
+	kbase_pm_lock(kbdev);
+	spin_lock_irqsave(&kbdev->hwaccess_lock, flags);
+
+	/* The policy may have been changed since the timer was started */
+	if (backend->pm_current_policy != &kbase_pm_predictive_policy_ops ||
+			data->active)
+		goto unlock;
+
+	if (data->prewarm) {
+		/* The frame did not come, power off again */
+		data->prewarm = false;
+		backend->powerup.prewarm_misses++;
+		update = !kbdev->pm.suspending;
+	} else if (!kbdev->pm.suspending) {
+		u64 window = 2 * (KBASE_PM_PREDICTIVE_LEAD_NS +
+				data->deviation);
+
+		data->prewarm = true;
+		data->prewarm_until = ktime_get_ns() + window;
+		hrtimer_start(&backend->predictive_timer, ns_to_ktime(window),
+				HRTIMER_MODE_REL);
+		update = true;
+	}
+
+unlock:
+	spin_unlock_irqrestore(&kbdev->hwaccess_lock, flags);
+	if (update)
+		kbase_pm_update_active(kbdev);
+	kbase_pm_unlock(kbdev);
+}
+
+static void predictive_init(struct kbase_device *kbdev)
+{
+	struct kbasep_pm_tick_timer_state *stt = &kbdev->pm.backend.shader_tick_timer;
+
+	stt->configured_ticks = stt->default_ticks;
+}
+
+static void predictive_term(struct kbase_device *kbdev)
+{
+	struct kbasep_pm_tick_timer_state *stt = &kbdev->pm.backend.shader_tick_timer;
+
+	/* The callback does not take any lock, but the worker takes the pm
+	 * lock held by our caller: it is not waited for and will find that the
+	 * policy is no longer current.
+	 */
+	hrtimer_cancel(&kbdev->pm.backend.predictive_timer);
+	stt->configured_ticks = stt->default_ticks;
+}
+
+/* The struct kbase_pm_policy structure for the predictive power policy.
+ *
+ * This is the static structure that defines the predictive power policy's
+ * callback and name.
+ */
+const struct kbase_pm_policy kbase_pm_predictive_policy_ops = {
+	"predictive",			/* name */
+	predictive_init,		/* init */
+	predictive_term,		/* term */
+	predictive_shaders_needed,	/* shaders_needed */
+	predictive_get_core_active,	/* get_core_active */
+	NULL,				/* handle_event */
+	KBASE_PM_POLICY_ID_PREDICTIVE,	/* id */
+#if MALI_USE_CSF
+	0u,				/* flags */
+#endif
+};
+
+KBASE_EXPORT_TEST_API(kbase_pm_predictive_policy_ops);
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ *
+ * (C) COPYRIGHT 2012-2016, 2018-2020 ARM Limited. All rights reserved.
+ *
+ * This program is free software and is provided to you under the terms of the
+ * GNU General Public License version 2 as published by the Free Software
+ * Foundation, and any use by you of this program is subject to the terms
+ * of such GNU licence.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you can access it online at
+ * http://www.gnu.org/licenses/gpl-2.0.html.
+ *
+ * SPDX-License-Identifier: GPL-2.0
+ *
+ */
+
+/*
+ * "Predictive" power management policy
+ */
+
+#ifndef MALI_KBASE_PM_PREDICTIVE_H
+#define MALI_KBASE_PM_PREDICTIVE_H
+
+/**
+ * struct kbasep_pm_policy_predictive - Private structure for the predictive
+ *                                      policy
+ *
+ * This contains data that is private to the predictive power policy. It is
+ * protected by the hwaccess_lock.
+ *
+ * @last_start:    The last time that the GPU went from idle to active, in ns.
+ * @period:        Running average of the time between two active periods,
+ *                 in ns, or 0 when no cadence has been seen yet.
+ * @deviation:     Running average of how far a period strays from @period.
+ * @stable:        Number of consecutive periods that matched @period.
+ * @prewarm_until: End of the current prewarm window, in ns.
+ * @active:        Whether the GPU was active the last time it was looked at.
+ * @prewarm:       Whether the GPU is being kept powered in expectation of
+ *                 the next active period.
+ */
+struct kbasep_pm_policy_predictive {
+	u64 last_start;
+	u64 period;
+	u64 deviation;
+	unsigned int stable;
+	u64 prewarm_until;
+	bool active;
+	bool prewarm;
+};
+
+extern const struct kbase_pm_policy kbase_pm_predictive_policy_ops;
+
+/**
+ * kbase_pm_predictive_worker - Start or end a prewarm window
+ *
+ * @work: The predictive_work of a struct kbase_pm_backend_data
+ */
+void kbase_pm_predictive_worker(struct work_struct *work);
+
+/**
+ * kbase_pm_predictive_timer_callback - Queue the predictive work
+ *
+ * @timer: The predictive_timer of a struct kbase_pm_backend_data
+ *
+ * Return: HRTIMER_NORESTART
+ */
+enum hrtimer_restart kbase_pm_predictive_timer_callback(struct hrtimer *timer);
+
+#endif /* MALI_KBASE_PM_PREDICTIVE_H */
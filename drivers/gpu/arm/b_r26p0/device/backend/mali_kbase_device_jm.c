@@ -45,6 +45,10 @@
 #include <mali_kbase_dummy_job_wa.h>
 #include <backend/gpu/mali_kbase_clk_rate_trace_mgr.h>
 
+#ifdef CONFIG_MALI_EXYNOS_IPA_COUNTERS
+#include <ipa/mali_kbase_ipa.h>
+#endif
+
 /**
  * kbase_backend_late_init - Perform any backend-specific initialization.
  * @kbdev:	Device pointer
@@ -194,6 +198,11 @@ static const struct kbase_device_init dev_init[] = {
 			"Virtual instrumentation initialization failed"},
 	{kbase_backend_late_init, kbase_backend_late_term,
 			"Late backend initialization failed"},
+#ifdef CONFIG_MALI_EXYNOS_IPA_COUNTERS
+	/* Without devfreq nothing else brings up the IPA models */
+	{kbase_ipa_init, kbase_ipa_term,
+			"IPA power model initialization failed"},
+#endif
 #ifdef MALI_KBASE_BUILD
 	{kbase_debug_job_fault_dev_init, kbase_debug_job_fault_dev_term,
 			"Job fault debug initialization failed"},
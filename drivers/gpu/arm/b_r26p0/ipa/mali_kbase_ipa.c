@@ -514,6 +514,32 @@ static u32 get_static_power_locked(struct kbase_device *kbdev,
 	return power;
 }
 
+int kbase_ipa_get_busy_power(struct kbase_device *kbdev, u32 *power,
+				unsigned long freq,
+				unsigned long voltage)
+{
+	struct kbase_ipa_model *model;
+	u32 power_coeff = 0;
+	int err;
+
+	mutex_lock(&kbdev->ipa.lock);
+
+	model = get_current_model(kbdev);
+	if (model == kbdev->ipa.fallback_model)
+		err = -ENODEV;
+	else
+		err = model->ops->get_dynamic_coeff(model, &power_coeff);
+
+	mutex_unlock(&kbdev->ipa.lock);
+
+	if (!err)
+		*power = kbase_scale_dynamic_power(power_coeff, freq, voltage);
+
+	return err;
+}
+KBASE_EXPORT_TEST_API(kbase_ipa_get_busy_power);
+
+#if defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_DEVFREQ_THERMAL)
 #if defined(CONFIG_MALI_PWRSOFT_765) || \
 	LINUX_VERSION_CODE >= KERNEL_VERSION(4, 10, 0)
 static unsigned long kbase_get_static_power(struct devfreq *df,
@@ -671,3 +697,4 @@ struct devfreq_cooling_power kbase_ipa_power_model_ops = {
 #endif
 };
 KBASE_EXPORT_TEST_API(kbase_ipa_power_model_ops);
+#endif /* defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_DEVFREQ_THERMAL) */
@@ -23,7 +23,7 @@
 #ifndef _KBASE_IPA_H_
 #define _KBASE_IPA_H_
 
-#if defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_DEVFREQ_THERMAL)
+#ifdef CONFIG_MALI_IPA_POWER_MODEL
 
 struct devfreq;
 
@@ -212,6 +212,27 @@ extern const struct kbase_ipa_model_ops kbase_g77_ipa_model_ops;
 extern const struct kbase_ipa_model_ops kbase_tnax_ipa_model_ops;
 extern const struct kbase_ipa_model_ops kbase_tbex_ipa_model_ops;
 
+/**
+ * kbase_ipa_get_busy_power() - get the dynamic power of the GPU while busy,
+ *                              from its counter model
+ * @kbdev: pointer to kbase device
+ * @power: where to store the power consumption, in mW.
+ * @freq: a frequency, in HZ.
+ * @voltage: a voltage, in mV.
+ *
+ * The power is the one of the work done since the previous call, for the
+ * time the GPU was active. Unlike kbase_get_real_power() it is not scaled by
+ * the GPU utilization and the simple model is never used in place of the
+ * counter model.
+ *
+ * Return: 0 on success, -ENODEV if there is no counter model for the GPU, or
+ * the error of the model, e.g. when too few cycles were sampled.
+ */
+int kbase_ipa_get_busy_power(struct kbase_device *kbdev, u32 *power,
+				unsigned long freq,
+				unsigned long voltage);
+
+#if defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_DEVFREQ_THERMAL)
 /**
  * kbase_get_real_power() - get the real power consumption of the GPU
  * @df: dynamic voltage and frequency scaling information for the GPU.
@@ -242,12 +263,13 @@ extern struct devfreq_cooling_ops kbase_ipa_power_model_ops;
 #else
 extern struct devfreq_cooling_power kbase_ipa_power_model_ops;
 #endif
+#endif /* defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_DEVFREQ_THERMAL) */
 
-#else /* !(defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_DEVFREQ_THERMAL)) */
+#else /* CONFIG_MALI_IPA_POWER_MODEL */
 
 static inline void kbase_ipa_protection_mode_switch_event(struct kbase_device *kbdev)
 { }
 
-#endif /* (defined(CONFIG_MALI_DEVFREQ) && defined(CONFIG_DEVFREQ_THERMAL)) */
+#endif /* CONFIG_MALI_IPA_POWER_MODEL */
 
 #endif
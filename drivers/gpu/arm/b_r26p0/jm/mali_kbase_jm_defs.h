@@ -589,6 +589,12 @@ struct kbase_jd_atom {
 		 * kctx->dma_fence.wq.
 		 */
 		atomic_t dep_count;
+#if defined(CONFIG_SYNC_FILE)
+		/* When the input fence signalled, if the wait was completed
+		 * from the job_done_wq work item.
+		 */
+		u64 signal_ns;
+#endif
 	} dma_fence;
 #endif /* CONFIG_MALI_DMA_FENCE || CONFIG_SYNC_FILE */
 
@@ -794,6 +800,13 @@ struct kbase_jd_renderpass {
  * @jit_pending_alloc:        A list of just-in-time memory allocation
  *                            soft-jobs which will be reattempted after the
  *                            impending free of other active allocations.
+ * @fence_signaller:          Task running jd_done_nolock() for this context,
+ *                            if any. Fence callbacks called from that task
+ *                            run with @lock held.
+ * @fence_ready:              Fence wait soft-jobs whose fence was signalled
+ *                            by @fence_signaller, linked through their
+ *                            jd_item and completed by jd_done_nolock()
+ *                            before it returns, protected by @lock.
  */
 struct kbase_jd_context {
 	struct mutex lock;
@@ -814,6 +827,9 @@ struct kbase_jd_context {
 
 	struct list_head jit_atoms_head;
 	struct list_head jit_pending_alloc;
+
+	struct task_struct *fence_signaller;
+	struct list_head fence_ready;
 };
 
 /**
@@ -597,6 +597,21 @@ void kbase_js_set_ctx_priority(struct kbase_context *kctx, int new_priority);
  */
 void kbase_js_update_ctx_priority(struct kbase_context *kctx);
 
+/**
+ * kbase_js_ctx_list_find_foreground - find a foreground context waiting for
+ *                                     a job slot
+ *
+ * @kbdev: Device pointer
+ * @js:    Job slot to look at
+ *
+ * Caller must hold hwaccess_lock.
+ *
+ * Return: The first context with KCTX_FOREGROUND on the pullable lists of @js,
+ *         or NULL if there is none or the foreground fast lane is disabled.
+ */
+struct kbase_context *kbase_js_ctx_list_find_foreground(
+		struct kbase_device *kbdev, int js);
+
 /*
  * Helpers follow
  */
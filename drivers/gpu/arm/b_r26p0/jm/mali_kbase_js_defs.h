@@ -274,6 +274,21 @@ struct kbasep_js_device_data {
 	u32 gpu_reset_ticks_dumping; /*< Value for JS_RESET_TICKS_DUMPING */
 	u32 ctx_timeslice_ns;		 /**< Value for JS_CTX_TIMESLICE_NS */
 
+	/*
+	 * Foreground fast lane: contexts with KCTX_FOREGROUND are pulled from
+	 * before any other, and background atoms keeping them waiting are
+	 * soft-stopped after soft_stop_ticks_bg. The hwaccess_lock must be
+	 * held when accessing these.
+	 */
+	bool fg_lane;
+	u32 soft_stop_ticks_bg;
+	/* Foreground contexts pulled ahead of another context */
+	u64 fg_lane_pulls;
+	/* Ticks a background atom ran while a foreground context waited */
+	u64 fg_inversion_ticks;
+	/* Background atoms soft-stopped early for a foreground context */
+	u64 fg_bg_soft_stops;
+
 	/** List of suspended soft jobs */
 	struct list_head suspended_soft_jobs_list;
 
@@ -136,6 +136,12 @@ enum {
  */
 #define DEFAULT_JS_SOFT_STOP_TICKS_CL    (1) /* 100ms-200ms */
 
+/**
+ * Default number of scheduling ticks before jobs of a background context are
+ * soft-stopped while the foreground context waits for the slot.
+ */
+#define DEFAULT_JS_SOFT_STOP_TICKS_BG    (0) /* 0ms-100ms */
+
 /**
  * Default minimum number of scheduling ticks before jobs are hard-stopped
  */
@@ -3352,6 +3352,164 @@ static DEVICE_ATTR(js_ctx_scheduling_mode, S_IRUGO | S_IWUSR,
 		show_js_ctx_scheduling_mode,
 		set_js_ctx_scheduling_mode);
 
+/**
+ * show_js_foreground - Show callback for the js_foreground sysfs entry.
+ * @dev:  The device this sysfs file is for.
+ * @attr: The attributes of the sysfs file.
+ * @buf:  The output buffer to receive the foreground fast lane state.
+ *
+ * This function is called to get whether contexts of the top-app group are
+ * pulled from first, the ticks after which background atoms are soft-stopped
+ * for them, and how often background work got in their way.
+ *
+ * Return: The number of bytes output to @buf.
+ */
+static ssize_t show_js_foreground(struct device *dev,
+		struct device_attribute *attr, char * const buf)
+{
+	struct kbasep_js_device_data *js_data;
+	struct kbase_device *kbdev;
+	u64 pulls, inversion_ticks, bg_soft_stops;
+	unsigned long flags;
+	u32 ticks_bg;
+	bool enabled;
+
+	kbdev = to_kbase_device(dev);
+	if (!kbdev)
+		return -ENODEV;
+
+	js_data = &kbdev->js_data;
+	spin_lock_irqsave(&kbdev->hwaccess_lock, flags);
+	enabled = js_data->fg_lane;
+	ticks_bg = js_data->soft_stop_ticks_bg;
+	pulls = js_data->fg_lane_pulls;
+	inversion_ticks = js_data->fg_inversion_ticks;
+	bg_soft_stops = js_data->fg_bg_soft_stops;
+	spin_unlock_irqrestore(&kbdev->hwaccess_lock, flags);
+
+	return scnprintf(buf, PAGE_SIZE,
+			"%d %u\nfg_pulls: %llu\ninversion_ticks: %llu\nbg_soft_stops: %llu\n",
+			enabled, ticks_bg, pulls, inversion_ticks, bg_soft_stops);
+}
+
+/**
+ * set_js_foreground - Store callback for the js_foreground sysfs entry.
+ * @dev:   The device this sysfs file is for.
+ * @attr:  The attributes of the sysfs file.
+ * @buf:   The value written to the sysfs file.
+ * @count: The number of bytes written to the sysfs file.
+ *
+ * This function is called when the js_foreground sysfs file is written to, in
+ * the format <enable> [<soft_stop_ticks_bg>].
+ *
+ * Return: @count if the function succeeded. An error code on failure.
+ */
+static ssize_t set_js_foreground(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct kbase_device *kbdev;
+	unsigned long flags;
+	unsigned int enable, ticks_bg;
+	int items;
+
+	kbdev = to_kbase_device(dev);
+	if (!kbdev)
+		return -ENODEV;
+
+	items = sscanf(buf, "%u %u", &enable, &ticks_bg);
+	if (items < 1 || enable > 1) {
+		dev_err(kbdev->dev, "Couldn't process js_foreground write operation.\n"
+				"Use format <enable> [<soft_stop_ticks_bg>]\n");
+		return -EINVAL;
+	}
+
+	spin_lock_irqsave(&kbdev->hwaccess_lock, flags);
+	kbdev->js_data.fg_lane = enable;
+	if (items > 1)
+		kbdev->js_data.soft_stop_ticks_bg = ticks_bg;
+	spin_unlock_irqrestore(&kbdev->hwaccess_lock, flags);
+
+	return count;
+}
+
+static DEVICE_ATTR(js_foreground, S_IRUGO | S_IWUSR,
+		show_js_foreground, set_js_foreground);
+
+/**
+ * show_jit_pool - Show callback for the jit_pool sysfs entry.
+ * @dev:  The device this sysfs file is for.
+ * @attr: The attributes of the sysfs file.
+ * @buf:  The output buffer to receive the JIT pool state.
+ *
+ * This function is called to get the pages the JIT pool of a context may keep
+ * backed and, for each context, how many JIT allocations were served from its
+ * pool, how many had to create a region and how many pool regions were freed
+ * to stay within the limit.
+ *
+ * Return: The number of bytes output to @buf.
+ */
+static ssize_t show_jit_pool(struct device *dev,
+		struct device_attribute *attr, char * const buf)
+{
+	struct kbase_device *kbdev;
+	struct kbase_context *kctx;
+	ssize_t ret;
+
+	kbdev = to_kbase_device(dev);
+	if (!kbdev)
+		return -ENODEV;
+
+	ret = scnprintf(buf, PAGE_SIZE, "max_pages: %u\n",
+			READ_ONCE(kbdev->jit_pool_max_pages));
+
+	mutex_lock(&kbdev->kctx_list_lock);
+	list_for_each_entry(kctx, &kbdev->kctx_list, kctx_list_link)
+		ret += scnprintf(buf + ret, PAGE_SIZE - ret,
+				"tgid=%d hits=%u misses=%u evictions=%u\n",
+				kctx->tgid, READ_ONCE(kctx->jit_pool_hits),
+				READ_ONCE(kctx->jit_pool_misses),
+				READ_ONCE(kctx->jit_pool_evictions));
+	mutex_unlock(&kbdev->kctx_list_lock);
+
+	return ret;
+}
+
+/**
+ * set_jit_pool - Store callback for the jit_pool sysfs entry.
+ * @dev:   The device this sysfs file is for.
+ * @attr:  The attributes of the sysfs file.
+ * @buf:   The value written to the sysfs file.
+ * @count: The number of bytes written to the sysfs file.
+ *
+ * This function is called when the jit_pool sysfs file is written to, with the
+ * pages the JIT pool of each context may keep backed, 0 for no limit. Pools
+ * over a lowered limit are trimmed the next time they take a region back.
+ *
+ * Return: @count if the function succeeded. An error code on failure.
+ */
+static ssize_t set_jit_pool(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct kbase_device *kbdev;
+	unsigned int max_pages;
+
+	kbdev = to_kbase_device(dev);
+	if (!kbdev)
+		return -ENODEV;
+
+	if (kstrtouint(buf, 0, &max_pages)) {
+		dev_err(kbdev->dev, "Couldn't process jit_pool write operation.\n"
+				"Use format <max_pages>\n");
+		return -EINVAL;
+	}
+
+	WRITE_ONCE(kbdev->jit_pool_max_pages, max_pages);
+
+	return count;
+}
+
+static DEVICE_ATTR(jit_pool, S_IRUGO | S_IWUSR, show_jit_pool, set_jit_pool);
+
 #ifdef MALI_KBASE_BUILD
 
 /* Number of entries in serialize_jobs_settings[] */
@@ -4227,6 +4385,10 @@ int kbase_device_debugfs_init(struct kbase_device *kbdev)
 
 	kbasep_gpu_memory_debugfs_init(kbdev);
 	kbase_as_fault_debugfs_init(kbdev);
+	kbase_pm_powerup_debugfs_init(kbdev);
+#if defined(CONFIG_SYNC_FILE)
+	kbase_sync_fence_debugfs_init(kbdev);
+#endif
 #ifdef CONFIG_MALI_PRFCNT_SET_SECONDARY_VIA_DEBUG_FS
 	kbase_instr_backend_debugfs_init(kbdev);
 #endif
@@ -4259,6 +4421,17 @@ int kbase_device_debugfs_init(struct kbase_device *kbdev)
 			&kbdev->mem_pool_defaults.large,
 			&kbase_device_debugfs_mem_pool_max_size_fops);
 
+	kbase_mem_pool_refill_debugfs_init(kbdev->mali_debugfs_directory,
+			kbdev);
+
+	/* flushes avoided by MMU batches are the difference of the two */
+	debugfs_create_atomic_t("mmu_flush_deferred", 0444,
+			kbdev->mali_debugfs_directory,
+			&kbdev->mmu_flush_deferred);
+	debugfs_create_atomic_t("mmu_flush_batched", 0444,
+			kbdev->mali_debugfs_directory,
+			&kbdev->mmu_flush_batched);
+
 	if (kbase_hw_has_feature(kbdev, BASE_HW_FEATURE_PROTECTED_DEBUG_MODE)) {
 		debugfs_create_file("protected_debug_mode", S_IRUGO,
 				kbdev->mali_debugfs_directory, kbdev,
@@ -4447,6 +4620,8 @@ static struct attribute *kbase_attrs[] = {
 	&dev_attr_lp_mem_pool_max_size.attr,
 #endif
 	&dev_attr_js_ctx_scheduling_mode.attr,
+	&dev_attr_js_foreground.attr,
+	&dev_attr_jit_pool.attr,
 	&dev_attr_total_gpu_mem.attr,
 	&dev_attr_dma_buf_gpu_mem.attr,
 	NULL
@@ -4799,6 +4974,7 @@ static struct platform_driver kbase_platform_driver = {
 	.driver = {
 		   .name = kbase_drv_name,
 		   .owner = THIS_MODULE,
+		   .probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		   .pm = &kbase_pm_ops,
 		   .of_match_table = of_match_ptr(kbase_dt_ids),
 	},
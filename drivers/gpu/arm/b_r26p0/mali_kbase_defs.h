@@ -166,6 +166,12 @@
  */
 #define KBASE_PERMANENTLY_MAPPED_MEM_LIMIT_PAGES ((32 * 1024ul * 1024ul) >> \
 								PAGE_SHIFT)
+
+/* Number of power of two size classes the JIT pool of a context is binned
+ * in, by VA pages. The last one also holds all larger regions.
+ */
+#define KBASE_JIT_POOL_CLASSES (32)
+
 /* Minimum threshold period for hwcnt dumps between different hwcnt virtualizer
  * clients, to reduce undesired system load.
  * If a virtualizer client requests a dump within this threshold period after
@@ -319,6 +325,14 @@ struct kbase_as {
  * @kctx:                 If this set of MMU tables belongs to a context then
  *                        this is a back-reference to the context, otherwise
  *                        it is NULL
+ * @batch_owner:          Task that started the current MMU batch, only its
+ *                        flushes are deferred, protected by @mmu_lock
+ * @batch_depth:          Number of kbase_mmu_batch_begin() calls of
+ *                        @batch_owner not ended yet, protected by @mmu_lock
+ * @batch_start:          First page of the range whose flush a batch has
+ *                        deferred, protected by @mmu_lock
+ * @batch_end:            Page after the range whose flush a batch has
+ *                        deferred, equal to @batch_start if there is none
  */
 struct kbase_mmu_table {
 	u64 *mmu_teardown_pages;
@@ -326,6 +340,10 @@ struct kbase_mmu_table {
 	phys_addr_t pgd;
 	u8 group_id;
 	struct kbase_context *kctx;
+	struct task_struct *batch_owner;
+	unsigned int batch_depth;
+	u64 batch_start;
+	u64 batch_end;
 };
 
 #include "jm/mali_kbase_jm_defs.h"
@@ -355,6 +373,9 @@ static inline int kbase_as_has_page_fault(struct kbase_as *as,
 struct kbasep_mem_device {
 	atomic_t used_pages;
 	atomic_t ir_threshold;
+	/* 4KB pages allocated to contexts, backed by 2MB pages or not */
+	atomic_long_t lp_backed_pages;
+	atomic_long_t sp_backed_pages;
 };
 
 struct kbase_clk_rate_listener;
@@ -511,6 +532,22 @@ struct kbase_pm_device_data {
  *                operations should be abandoned
  * @dont_reclaim: true if the shrinker is forbidden from reclaiming memory from
  *                this pool, eg during a grow operation
+ * @low_watermark: Number of free pages below which @refill_work tops the pool
+ *                up from the kernel, 0 if the pool is not refilled
+ * @reserve:      Number of free pages taken at boot and kept from the
+ *                shrinker, 0 for all but the kbdev 2MB pool of the default
+ *                memory group
+ * @refill_work:  Work item refilling the pool in the background
+ * @last_reclaim: jiffies when the shrinker last took pages from the pool,
+ *                refills wait a while after that
+ * @kernel_fail_until: jiffies until which allocations of 2MB pages do not
+ *                try the kernel after it had none, and rely on the pool
+ * @alloc_hits:   Pages allocated from the pool itself
+ * @alloc_misses: Pages that had to be allocated from the kernel instead
+ * @refill_runs:  Number of refills that added pages to the pool
+ * @refill_pages: Number of pages added by refills
+ * @refill_ns:    Total time spent in refills
+ * @refill_max_ns: Longest refill
  */
 struct kbase_mem_pool {
 	struct kbase_device *kbdev;
@@ -526,6 +563,18 @@ struct kbase_mem_pool {
 
 	bool dying;
 	bool dont_reclaim;
+
+	size_t low_watermark;
+	size_t reserve;
+	struct delayed_work refill_work;
+	unsigned long last_reclaim;
+	unsigned long kernel_fail_until;
+	atomic_long_t alloc_hits;
+	atomic_long_t alloc_misses;
+	u64 refill_runs;
+	u64 refill_pages;
+	u64 refill_ns;
+	u64 refill_max_ns;
 };
 
 /**
@@ -898,6 +947,8 @@ struct kbase_process {
  *                         allocations of a new context.
  * @mem_pool_defaults:     Default configuration for the group of memory pools
  *                         created for a new context.
+ * @jit_pool_max_pages:    Physical pages the JIT pool of each context may keep
+ *                         backed for reuse, 0 for no limit.
  * @current_gpu_coherency_mode: coherency mode in use, which can be different
  *                         from @system_coherency, when using protected mode.
  * @system_coherency:      coherency mode as retrieved from the device tree.
@@ -934,6 +985,16 @@ struct kbase_process {
  *                          the updates made to Job dispatcher + scheduler states.
  * @mmu_hw_mutex:           Protects access to MMU operations and address space
  *                          related state.
+ * @mmu_flush_deferred:     Number of page table flushes deferred to the end
+ *                          of an MMU batch.
+ * @mmu_flush_batched:      Number of flushes issued at the end of a batch for
+ *                          the deferred ones.
+ * @fence_wait_inline:      Number of fence waits completed by jd_done_nolock()
+ *                          of the context whose fence trigger signalled them.
+ * @fence_wait_queued:      Number of fence waits completed from job_done_wq.
+ * @fence_wait_queue_ns:    Total time from the fence callback to the worker
+ *                          of the queued fence waits.
+ * @fence_wait_max_ns:      Longest of these times.
  * @serialize_jobs:         Currently used mode for serialization of jobs, both
  *                          intra & inter slots serialization is supported.
  * @backup_serialize_jobs:  Copy of the original value of @serialize_jobs taken
@@ -1093,6 +1154,10 @@ struct kbase_device {
 #else
 	struct thermal_cooling_device *devfreq_cooling;
 #endif
+#endif /* CONFIG_DEVFREQ_THERMAL */
+#endif /* CONFIG_MALI_DEVFREQ */
+
+#ifdef CONFIG_MALI_IPA_POWER_MODEL
 	bool ipa_protection_mode_switched;
 	struct {
 		/* Access to this struct must be with ipa.lock held */
@@ -1111,8 +1176,7 @@ struct kbase_device {
 		/* true if use of fallback model has been forced by the User */
 		bool force_fallback_model;
 	} ipa;
-#endif /* CONFIG_DEVFREQ_THERMAL */
-#endif /* CONFIG_MALI_DEVFREQ */
+#endif /* CONFIG_MALI_IPA_POWER_MODEL */
 	unsigned long previous_frequency;
 
 	atomic_t job_fault_debug;
@@ -1161,6 +1225,7 @@ struct kbase_device {
 	u32 infinite_cache_active_default;
 #endif
 	struct kbase_mem_pool_group_config mem_pool_defaults;
+	u32 jit_pool_max_pages;
 
 	u32 current_gpu_coherency_mode;
 	u32 system_coherency;
@@ -1195,6 +1260,15 @@ struct kbase_device {
 	spinlock_t hwaccess_lock;
 
 	struct mutex mmu_hw_mutex;
+	atomic_t mmu_flush_deferred;
+	atomic_t mmu_flush_batched;
+
+#if defined(CONFIG_SYNC_FILE)
+	atomic_t fence_wait_inline;
+	atomic_t fence_wait_queued;
+	atomic64_t fence_wait_queue_ns;
+	atomic64_t fence_wait_max_ns;
+#endif
 
 	/* MALI_SEC_INTEGRATION */
 	struct kbase_vendor_callbacks *vendor_callbacks;
@@ -1363,6 +1437,9 @@ struct kbase_file {
  * refcount for the context drops to 0 or on when the address spaces are
  * re-enabled on GPU reset or power cycle.
  *
+ * @KCTX_FOREGROUND: Set when the last atoms of the context were submitted by a
+ * task of the top-app group, so the context is the one the user looks at.
+ *
  * All members need to be separate bits. This enum is intended for use in a
  * bitmask where multiple values get OR-ed together.
  */
@@ -1390,6 +1467,7 @@ enum kbase_context_flags {
 	 */
 	KCTX_JPL_ENABLED = 1U << 16,
 #endif /* !MALI_JIT_PRESSURE_LIMIT_BASE */
+	KCTX_FOREGROUND = 1U << 17,
 };
 
 struct kbase_sub_alloc {
@@ -1632,6 +1710,13 @@ struct kbase_reg_zone {
  *                        JIT allocations. They are released in case of memory
  *                        pressure as they are put on the @evict_list when they
  *                        are freed up by userspace.
+ * @jit_pool_class:       The allocations of @jit_pool_head binned by the power
+ *                        of two of their VA size, the only ones a request of
+ *                        that size can reuse.
+ * @jit_pool_hits:        Number of JIT allocations served from the pool.
+ * @jit_pool_misses:      Number of JIT allocations that had to create a region.
+ * @jit_pool_evictions:   Number of pool allocations freed to keep the pool
+ *                        within &kbase_device.jit_pool_max_pages.
  * @jit_destroy_head:     List containing the just-in-time memory allocations
  *                        which were moved to it from @jit_pool_head, in the
  *                        shrinker callback, after freeing their backing
@@ -1793,6 +1878,10 @@ struct kbase_context {
 #endif /* MALI_JIT_PRESSURE_LIMIT_BASE */
 	struct list_head jit_active_head;
 	struct list_head jit_pool_head;
+	struct list_head jit_pool_class[KBASE_JIT_POOL_CLASSES];
+	u32 jit_pool_hits;
+	u32 jit_pool_misses;
+	u32 jit_pool_evictions;
 	struct list_head jit_destroy_head;
 	struct mutex jit_evict_lock;
 	struct work_struct jit_work;
@@ -225,63 +225,32 @@ kbase_dma_fence_cb(struct dma_fence *fence, struct dma_fence_cb *cb)
 		kbase_dma_fence_queue_work(katom);
 }
 
+/*
+ * All fences of @resv the atom has to wait for are merged into one, so the
+ * atom takes a single callback per reservation however many fences it has.
+ */
 static int
 kbase_dma_fence_add_reservation_callback(struct kbase_jd_atom *katom,
 					 struct reservation_object *resv,
 					 bool exclusive)
 {
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(4, 10, 0))
-	struct fence *excl_fence = NULL;
-	struct fence **shared_fences = NULL;
+	struct fence *fence;
 #else
-	struct dma_fence *excl_fence = NULL;
-	struct dma_fence **shared_fences = NULL;
+	struct dma_fence *fence;
 #endif
-	unsigned int shared_count = 0;
-	int err, i;
-
-	err = reservation_object_get_fences_rcu(resv,
-						&excl_fence,
-						&shared_count,
-						&shared_fences);
-	if (err)
-		return err;
-
-	if (excl_fence) {
-		err = kbase_fence_add_callback(katom,
-						excl_fence,
-						kbase_dma_fence_cb);
+	int err;
 
-		/* Release our reference, taken by reservation_object_get_fences_rcu(),
-		 * to the fence. We have set up our callback (if that was possible),
-		 * and it's the fence's owner is responsible for singling the fence
-		 * before allowing it to disappear.
-		 */
-		dma_fence_put(excl_fence);
-
-		if (err)
-			goto out;
-	}
+	fence = reservation_object_merge_fences_rcu(&resv, 1, exclusive);
+	if (IS_ERR(fence))
+		return PTR_ERR(fence);
+	if (!fence)
+		return 0;
 
-	if (exclusive) {
-		for (i = 0; i < shared_count; i++) {
-			err = kbase_fence_add_callback(katom,
-							shared_fences[i],
-							kbase_dma_fence_cb);
-			if (err)
-				goto out;
-		}
-	}
+	err = kbase_fence_add_callback(katom, fence, kbase_dma_fence_cb);
 
-	/* Release all our references to the shared fences, taken by
-	 * reservation_object_get_fences_rcu(). We have set up our callback (if
-	 * that was possible), and it's the fence's owner is responsible for
-	 * signaling the fence before allowing it to disappear.
-	 */
-out:
-	for (i = 0; i < shared_count; i++)
-		dma_fence_put(shared_fences[i]);
-	kfree(shared_fences);
+	/* Release our reference, the callback holds its own */
+	dma_fence_put(fence);
 
 	if (err) {
 		/*
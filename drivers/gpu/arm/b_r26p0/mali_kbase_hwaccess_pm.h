@@ -226,4 +226,14 @@ int kbase_pm_protected_mode_enable(struct kbase_device *kbdev);
  */
 int kbase_pm_protected_mode_disable(struct kbase_device *kbdev);
 
+#ifdef CONFIG_DEBUG_FS
+/**
+ * kbase_pm_powerup_debugfs_init - Add a debugfs entry for the shader core
+ *                                 power up latency
+ *
+ * @kbdev: Address of the instance of a GPU platform device.
+ */
+void kbase_pm_powerup_debugfs_init(struct kbase_device *kbdev);
+#endif
+
 #endif /* _KBASE_HWACCESS_PM_H_ */
@@ -42,6 +42,7 @@
 #define KBASE_HWCNT_READER_SET_INTERVAL    _IOW(KBASE_HWCNT_READER, 0x30, u32)
 #define KBASE_HWCNT_READER_ENABLE_EVENT    _IOW(KBASE_HWCNT_READER, 0x40, u32)
 #define KBASE_HWCNT_READER_DISABLE_EVENT   _IOW(KBASE_HWCNT_READER, 0x41, u32)
+#define KBASE_HWCNT_READER_ENABLE_RING     _IOR(KBASE_HWCNT_READER, 0x50, u32)
 #define KBASE_HWCNT_READER_GET_API_VERSION _IOW(KBASE_HWCNT_READER, 0xFF, u32)
 #define KBASE_HWCNT_READER_GET_API_VERSION_WITH_FEATURES \
 		_IOW(KBASE_HWCNT_READER, 0xFF, \
@@ -72,6 +73,42 @@ struct kbase_hwcnt_reader_metadata {
 	struct kbase_hwcnt_reader_metadata_cycles cycles;
 };
 
+/**
+ * struct kbase_hwcnt_reader_ring_slot - state of one sample buffer in ring mode
+ * @seq:      odd while the kernel writes the buffer, even once it is complete
+ * @padding:  reserved, zero
+ * @start_ns: time when collection of the sample started
+ * @meta:     metadata of the sample, as returned by GET_BUFFER otherwise
+ */
+struct kbase_hwcnt_reader_ring_slot {
+	u32 seq;
+	u32 padding;
+	u64 start_ns;
+	struct kbase_hwcnt_reader_metadata meta;
+};
+
+/**
+ * struct kbase_hwcnt_reader_ring - header of the hwcnt reader ring
+ * @write_idx: number of samples written so far, the slot of sample n is
+ *             n % @buf_cnt
+ * @buf_cnt:   number of sample buffers in the ring
+ * @slots:     state of each sample buffer
+ *
+ * After KBASE_HWCNT_READER_ENABLE_RING, the kernel stops waiting for buffers
+ * to be put back and writes samples in a circle, overwriting the oldest one.
+ * The header is mapped read only at the offset returned by the ioctl, and a
+ * reader consumes samples without system calls: for each new sample it reads
+ * @seq of its slot, the buffer and metadata, then @seq again, and keeps the
+ * sample only if @seq was even and did not change. Samples more than
+ * @buf_cnt behind @write_idx were overwritten. Timestamps are in
+ * CLOCK_MONOTONIC_RAW, the mono_raw trace clock.
+ */
+struct kbase_hwcnt_reader_ring {
+	u32 write_idx;
+	u32 buf_cnt;
+	struct kbase_hwcnt_reader_ring_slot slots[];
+};
+
 /**
  * enum base_hwcnt_reader_event - hwcnt dumping events
  * @BASE_HWCNT_READER_EVENT_MANUAL:   manual request for dump
@@ -97,6 +134,7 @@ enum base_hwcnt_reader_event {
 #define KBASE_HWCNT_READER_API_VERSION_NO_FEATURE                  (0)
 #define KBASE_HWCNT_READER_API_VERSION_FEATURE_CYCLES_TOP          (1 << 0)
 #define KBASE_HWCNT_READER_API_VERSION_FEATURE_CYCLES_SHADER_CORES (1 << 1)
+#define KBASE_HWCNT_READER_API_VERSION_FEATURE_RING                (1 << 2)
 struct kbase_hwcnt_reader_api_version {
 	u32 version;
 	u32 features;
@@ -785,6 +785,29 @@ static void jd_mark_simple_gfx_frame_atoms(struct kbase_jd_atom *katom)
 	}
 }
 
+/*
+ * Complete the fence waits of the context whose fence was signalled by a
+ * fence trigger that jd_done_nolock() just ran: the fence callback found
+ * jctx.lock held by this task and left the atoms to us instead of queueing
+ * work that would have to wait for the lock.
+ */
+static void jd_complete_fence_ready(struct kbase_context *kctx,
+		struct list_head *completed_jobs)
+{
+	struct kbase_jd_atom *katom;
+
+	while (!list_empty(&kctx->jctx.fence_ready)) {
+		katom = list_first_entry(&kctx->jctx.fence_ready,
+				struct kbase_jd_atom, jd_item);
+		list_del(&katom->jd_item);
+
+		kbasep_remove_waiting_soft_job(katom);
+		kbase_finish_soft_job(katom);
+		jd_mark_atom_complete(katom);
+		list_add_tail(&katom->jd_item, completed_jobs);
+	}
+}
+
 /*
  * Perform the necessary handling of an atom that has finished running
  * on the GPU.
@@ -801,11 +824,15 @@ bool jd_done_nolock(struct kbase_jd_atom *katom,
 	struct list_head completed_jobs;
 	struct list_head runnable_jobs;
 	bool need_to_try_schedule_context = false;
+	bool signaller = !kctx->jctx.fence_signaller;
 	int i;
 
 	INIT_LIST_HEAD(&completed_jobs);
 	INIT_LIST_HEAD(&runnable_jobs);
 
+	if (signaller)
+		WRITE_ONCE(kctx->jctx.fence_signaller, current);
+
 	KBASE_DEBUG_ASSERT(katom->status != KBASE_JD_ATOM_STATE_UNUSED);
 
 #if MALI_JIT_PRESSURE_LIMIT_BASE
@@ -915,8 +942,13 @@ bool jd_done_nolock(struct kbase_jd_atom *katom,
 		if (--kctx->jctx.job_nr == 0)
 			wake_up(&kctx->jctx.zero_jobs_wait);	/* All events are safely queued now, and we can signal any waiter
 								 * that we've got no more jobs (so we can be safely terminated) */
+
+		jd_complete_fence_ready(kctx, &completed_jobs);
 	}
 
+	if (signaller)
+		WRITE_ONCE(kctx->jctx.fence_signaller, NULL);
+
 	return need_to_try_schedule_context;
 }
 
@@ -1372,6 +1404,12 @@ int kbase_jd_submit(struct kbase_context *kctx,
 	/* All atoms submitted in this call have the same flush ID */
 	latest_flush = kbase_backend_get_current_flush_id(kbdev);
 
+	/* Follows the app between foreground and background */
+	if (schedtune_task_top_app(current))
+		kbase_ctx_flag_set(kctx, KCTX_FOREGROUND);
+	else
+		kbase_ctx_flag_clear(kctx, KCTX_FOREGROUND);
+
 	for (i = 0; i < nr_atoms; i++) {
 		struct base_jd_atom user_atom;
 		struct base_jd_fragment user_jc_incr;
@@ -1912,6 +1950,8 @@ int kbase_jd_init(struct kbase_context *kctx)
 
 	spin_lock_init(&kctx->jctx.tb_lock);
 
+	INIT_LIST_HEAD(&kctx->jctx.fence_ready);
+
 	kctx->jctx.job_nr = 0;
 	INIT_LIST_HEAD(&kctx->completed_jobs);
 	atomic_set(&kctx->work_count, 0);
@@ -476,6 +476,8 @@ int kbasep_js_devdata_init(struct kbase_device * const kbdev)
 	jsdd->gpu_reset_ticks_cl = DEFAULT_JS_RESET_TICKS_CL;
 	jsdd->gpu_reset_ticks_dumping = DEFAULT_JS_RESET_TICKS_DUMPING;
 	jsdd->ctx_timeslice_ns = DEFAULT_JS_CTX_TIMESLICE_NS;
+	jsdd->fg_lane = true;
+	jsdd->soft_stop_ticks_bg = DEFAULT_JS_SOFT_STOP_TICKS_BG;
 	atomic_set(&jsdd->soft_job_timeout_ms, DEFAULT_JS_SOFT_JOB_TIMEOUT);
 
 	dev_dbg(kbdev->dev, "JS Config Attribs: ");
@@ -858,6 +860,28 @@ static bool kbase_js_ctx_list_remove_nolock(struct kbase_device *kbdev,
 	return ret;
 }
 
+struct kbase_context *kbase_js_ctx_list_find_foreground(
+		struct kbase_device *kbdev, int js)
+{
+	struct kbase_context *kctx;
+	int i;
+
+	lockdep_assert_held(&kbdev->hwaccess_lock);
+
+	if (!kbdev->js_data.fg_lane)
+		return NULL;
+
+	for (i = 0; i < KBASE_JS_ATOM_SCHED_PRIO_COUNT; i++) {
+		list_for_each_entry(kctx, &kbdev->js_data.ctx_list_pullable[js][i],
+				jctx.sched_info.ctx.ctx_list_entry[js]) {
+			if (kbase_ctx_flag(kctx, KCTX_FOREGROUND))
+				return kctx;
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * kbase_js_ctx_list_pop_head_nolock - Variant of kbase_js_ctx_list_pop_head()
  *                                     where the caller must hold
@@ -874,7 +898,8 @@ static struct kbase_context *kbase_js_ctx_list_pop_head_nolock(
 						struct kbase_device *kbdev,
 						int js)
 {
-	struct kbase_context *kctx;
+	struct kbase_context *kctx = NULL;
+	struct kbase_context *fg_kctx;
 	int i;
 
 	lockdep_assert_held(&kbdev->hwaccess_lock);
@@ -886,14 +911,24 @@ static struct kbase_context *kbase_js_ctx_list_pop_head_nolock(
 		kctx = list_entry(kbdev->js_data.ctx_list_pullable[js][i].next,
 				struct kbase_context,
 				jctx.sched_info.ctx.ctx_list_entry[js]);
+		break;
+	}
 
-		list_del_init(&kctx->jctx.sched_info.ctx.ctx_list_entry[js]);
-		dev_dbg(kbdev->dev,
-			"Popped %p from the pullable queue (s:%d)\n",
-			(void *)kctx, js);
-		return kctx;
+	if (!kctx)
+		return NULL;
+
+	/* The foreground app goes first, whatever the priority of the others */
+	fg_kctx = kbase_js_ctx_list_find_foreground(kbdev, js);
+	if (fg_kctx && fg_kctx != kctx) {
+		kbdev->js_data.fg_lane_pulls++;
+		kctx = fg_kctx;
 	}
-	return NULL;
+
+	list_del_init(&kctx->jctx.sched_info.ctx.ctx_list_entry[js]);
+	dev_dbg(kbdev->dev,
+		"Popped %p from the pullable queue (s:%d)\n",
+		(void *)kctx, js);
+	return kctx;
 }
 
 /**
@@ -3276,6 +3311,8 @@ struct kbase_jd_atom *kbase_js_complete_atom(struct kbase_jd_atom *katom,
 		/* MALI_SEC_INTEGRATION */
 		if (kbdev->vendor_callbacks->cl_boost_update_utilization)
 			kbdev->vendor_callbacks->cl_boost_update_utilization(kbdev, katom, microseconds_spent);
+		if (kbdev->vendor_callbacks->dvfs_job_done)
+			kbdev->vendor_callbacks->dvfs_job_done(kbdev, katom, microseconds_spent);
 
 		do_div(microseconds_spent, 1000);
 
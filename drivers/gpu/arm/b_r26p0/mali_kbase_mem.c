@@ -1150,9 +1150,12 @@ int kbase_mem_init(struct kbase_device *kbdev)
 
 	kbase_mem_pool_group_config_set_max_size(&kbdev->mem_pool_defaults,
 		KBASE_MEM_POOL_MAX_SIZE_KCTX);
+	kbdev->jit_pool_max_pages = KBASE_JIT_POOL_MAX_PAGES;
 
 	/* Initialize memory usage */
 	atomic_set(&memdev->used_pages, 0);
+	atomic_long_set(&memdev->lp_backed_pages, 0);
+	atomic_long_set(&memdev->sp_backed_pages, 0);
 
 	spin_lock_init(&kbdev->gpu_mem_usage_lock);
 	kbdev->total_gpu_pages = 0;
@@ -1287,6 +1290,7 @@ struct kbase_va_region *kbase_alloc_free_region(struct rb_root *rbtree,
 	new_reg->nr_pages = nr_pages;
 
 	INIT_LIST_HEAD(&new_reg->jit_node);
+	INIT_LIST_HEAD(&new_reg->jit_class_node);
 	INIT_LIST_HEAD(&new_reg->link);
 
 	return new_reg;
@@ -1411,6 +1415,7 @@ int kbase_gpu_mmap(struct kbase_context *kctx, struct kbase_va_region *reg, u64
 	unsigned long gwt_mask = ~0;
 	int group_id;
 	struct kbase_mem_phy_alloc *alloc;
+	bool batched;
 
 #ifdef CONFIG_MALI_CINSTR_GWT
 	if (kctx->gwt_enabled)
@@ -1433,6 +1438,9 @@ int kbase_gpu_mmap(struct kbase_context *kctx, struct kbase_va_region *reg, u64
 	alloc = reg->gpu_alloc;
 	group_id = alloc->group_id;
 
+	/* an alias is mapped piece by piece, flush them all at once */
+	batched = kbase_mmu_batch_begin(kctx);
+
 	if (reg->gpu_alloc->type == KBASE_MEM_TYPE_ALIAS) {
 		u64 const stride = alloc->imported.alias.stride;
 
@@ -1505,12 +1513,17 @@ int kbase_gpu_mmap(struct kbase_context *kctx, struct kbase_va_region *reg, u64
 			goto bad_insert;
 	}
 
+	if (batched)
+		kbase_mmu_batch_end(kctx);
+
 	return err;
 
 bad_insert:
 	kbase_mmu_teardown_pages(kctx->kbdev, &kctx->mmu,
 				 reg->start_pfn, reg->nr_pages,
 				 kctx->as_nr);
+	if (batched)
+		kbase_mmu_batch_end(kctx);
 
 	kbase_remove_va_region(reg);
 
@@ -2061,6 +2074,7 @@ int kbase_alloc_phy_pages_helper(struct kbase_mem_phy_alloc *alloc,
 {
 	int new_page_count __maybe_unused;
 	size_t nr_left = nr_pages_requested;
+	size_t nr_small;
 	int res;
 	struct kbase_context *kctx;
 	struct kbase_device *kbdev;
@@ -2203,6 +2217,7 @@ int kbase_alloc_phy_pages_helper(struct kbase_mem_phy_alloc *alloc,
 no_new_partial:
 #endif
 
+	nr_small = nr_left;
 	if (nr_left) {
 		res = kbase_mem_pool_alloc_pages(
 			&kctx->mem_pools.small[alloc->group_id],
@@ -2218,6 +2233,10 @@ no_new_partial:
 
 	alloc->nents += nr_pages_requested;
 
+	atomic_long_add(nr_pages_requested - nr_small,
+			&kbdev->memdev.lp_backed_pages);
+	atomic_long_add(nr_small, &kbdev->memdev.sp_backed_pages);
+
 	kbase_trace_gpu_mem_usage_inc(kctx->kbdev, kctx, nr_pages_requested);
 
 done:
@@ -2397,6 +2416,11 @@ struct tagged_addr *kbase_alloc_phy_pages_helper_locked(
 
 	alloc->nents += nr_pages_requested;
 
+	/* partials of a 2MB pool are 2MB backed too */
+	atomic_long_add(nr_pages_requested, pool->order ?
+			&kbdev->memdev.lp_backed_pages :
+			&kbdev->memdev.sp_backed_pages);
+
 	kbase_trace_gpu_mem_usage_inc(kctx->kbdev, kctx, nr_pages_requested);
 
 done:
@@ -3344,9 +3368,13 @@ static void kbase_jit_destroy_worker(struct work_struct *work)
 
 int kbase_jit_init(struct kbase_context *kctx)
 {
+	int i;
+
 	mutex_lock(&kctx->jit_evict_lock);
 	INIT_LIST_HEAD(&kctx->jit_active_head);
 	INIT_LIST_HEAD(&kctx->jit_pool_head);
+	for (i = 0; i < KBASE_JIT_POOL_CLASSES; i++)
+		INIT_LIST_HEAD(&kctx->jit_pool_class[i]);
 	INIT_LIST_HEAD(&kctx->jit_destroy_head);
 	INIT_WORK(&kctx->jit_work, kbase_jit_destroy_worker);
 
@@ -3357,10 +3385,32 @@ int kbase_jit_init(struct kbase_context *kctx)
 	kctx->jit_max_allocations = 0;
 	kctx->jit_current_allocations = 0;
 	kctx->trim_level = 0;
+	kctx->jit_pool_hits = 0;
+	kctx->jit_pool_misses = 0;
+	kctx->jit_pool_evictions = 0;
 
 	return 0;
 }
 
+static unsigned int kbase_jit_pool_class(u64 va_pages)
+{
+	if (!va_pages)
+		return 0;
+
+	return min_t(u64, ilog2(va_pages), KBASE_JIT_POOL_CLASSES - 1);
+}
+
+/* Put a freed allocation at the head of the pool and of its size class */
+static void kbase_jit_pool_add(struct kbase_context *kctx,
+		struct kbase_va_region *reg)
+{
+	lockdep_assert_held(&kctx->jit_evict_lock);
+
+	list_move(&reg->jit_node, &kctx->jit_pool_head);
+	list_move(&reg->jit_class_node,
+		&kctx->jit_pool_class[kbase_jit_pool_class(reg->nr_pages)]);
+}
+
 /* Check if the allocation from JIT pool is of the same size as the new JIT
  * allocation and also, if BASE_JIT_ALLOC_MEM_TILER_ALIGN_TOP is set, meets
  * the alignment requirements.
@@ -3814,13 +3864,13 @@ static bool jit_allow_allocate(struct kbase_context *kctx,
 
 static struct kbase_va_region *
 find_reasonable_region(const struct base_jit_alloc_info *info,
-		       struct list_head *pool_head, bool ignore_usage_id)
+		       struct list_head *class_head, bool ignore_usage_id)
 {
 	struct kbase_va_region *closest_reg = NULL;
 	struct kbase_va_region *walker;
 	size_t current_diff = SIZE_MAX;
 
-	list_for_each_entry(walker, pool_head, jit_node) {
+	list_for_each_entry(walker, class_head, jit_class_node) {
 		if ((ignore_usage_id ||
 		     walker->jit_usage_id == info->usage_id) &&
 		    walker->jit_bin_id == info->bin_id &&
@@ -3858,6 +3908,7 @@ struct kbase_va_region *kbase_jit_allocate(struct kbase_context *kctx,
 {
 	struct kbase_va_region *reg = NULL;
 	struct kbase_sub_alloc *prealloc_sas[2] = { NULL, NULL };
+	struct list_head *class_head;
 	int i;
 
 	lockdep_assert_held(&kctx->jctx.lock);
@@ -3879,17 +3930,19 @@ struct kbase_va_region *kbase_jit_allocate(struct kbase_context *kctx,
 
 	/*
 	 * Scan the pool for an existing allocation which meets our
-	 * requirements and remove it.
+	 * requirements and remove it. Only allocations of the requested VA
+	 * size can be reused, so only its size class is looked at.
 	 */
+	class_head = &kctx->jit_pool_class[kbase_jit_pool_class(info->va_pages)];
 	if (info->usage_id != 0)
 		/* First scan for an allocation with the same usage ID */
-		reg = find_reasonable_region(info, &kctx->jit_pool_head, false);
+		reg = find_reasonable_region(info, class_head, false);
 
 	if (!reg)
 		/* No allocation with the same usage ID, or usage IDs not in
 		 * use. Search for an allocation we can reuse.
 		 */
-		reg = find_reasonable_region(info, &kctx->jit_pool_head, true);
+		reg = find_reasonable_region(info, class_head, true);
 
 	if (reg) {
 #if MALI_JIT_PRESSURE_LIMIT_BASE
@@ -3902,6 +3955,8 @@ struct kbase_va_region *kbase_jit_allocate(struct kbase_context *kctx,
 		 * active list.
 		 */
 		list_move(&reg->jit_node, &kctx->jit_active_head);
+		list_del_init(&reg->jit_class_node);
+		kctx->jit_pool_hits++;
 
 		WARN_ON(reg->gpu_alloc->evicted);
 
@@ -3978,7 +4033,7 @@ struct kbase_va_region *kbase_jit_allocate(struct kbase_context *kctx,
 			}
 #endif /* MALI_JIT_PRESSURE_LIMIT_BASE */
 			mutex_lock(&kctx->jit_evict_lock);
-			list_move(&reg->jit_node, &kctx->jit_pool_head);
+			kbase_jit_pool_add(kctx, reg);
 			mutex_unlock(&kctx->jit_evict_lock);
 			reg = NULL;
 			goto end;
@@ -3991,6 +4046,8 @@ struct kbase_va_region *kbase_jit_allocate(struct kbase_context *kctx,
 				BASEP_MEM_NO_USER_FREE;
 		u64 gpu_addr;
 
+		kctx->jit_pool_misses++;
+
 		if (info->flags & BASE_JIT_ALLOC_MEM_TILER_ALIGN_TOP)
 			flags |= BASE_MEM_TILER_ALIGN_TOP;
 
@@ -4061,6 +4118,51 @@ end:
 	return reg;
 }
 
+/*
+ * Free the least recently used allocations of the pool until the pages it
+ * keeps backed are back within kbase_device.jit_pool_max_pages.
+ */
+static void kbase_jit_pool_evict(struct kbase_context *kctx)
+{
+	u32 max_pages = READ_ONCE(kctx->kbdev->jit_pool_max_pages);
+	struct kbase_va_region *reg;
+	size_t pages = 0;
+
+	if (!max_pages)
+		return;
+
+	mutex_lock(&kctx->jit_evict_lock);
+	list_for_each_entry(reg, &kctx->jit_pool_head, jit_node)
+		pages += reg->gpu_alloc->nents;
+	mutex_unlock(&kctx->jit_evict_lock);
+
+	if (pages <= max_pages)
+		return;
+
+	kbase_gpu_vm_lock(kctx);
+	do {
+		reg = NULL;
+
+		mutex_lock(&kctx->jit_evict_lock);
+		if (pages > max_pages && !list_empty(&kctx->jit_pool_head)) {
+			reg = list_last_entry(&kctx->jit_pool_head,
+					struct kbase_va_region, jit_node);
+			pages -= min(pages, reg->gpu_alloc->nents);
+			list_del(&reg->jit_node);
+			list_del_init(&reg->jit_class_node);
+			list_del_init(&reg->gpu_alloc->evict_node);
+			kctx->jit_pool_evictions++;
+		}
+		mutex_unlock(&kctx->jit_evict_lock);
+
+		if (reg) {
+			reg->flags &= ~KBASE_REG_NO_USER_FREE;
+			kbase_mem_free_region(kctx, reg);
+		}
+	} while (reg);
+	kbase_gpu_vm_unlock(kctx);
+}
+
 void kbase_jit_free(struct kbase_context *kctx, struct kbase_va_region *reg)
 {
 	u64 old_pages;
@@ -4111,9 +4213,11 @@ void kbase_jit_free(struct kbase_context *kctx, struct kbase_va_region *reg)
 	WARN_ON(!list_empty(&reg->gpu_alloc->evict_node));
 	list_add(&reg->gpu_alloc->evict_node, &kctx->evict_list);
 
-	list_move(&reg->jit_node, &kctx->jit_pool_head);
+	kbase_jit_pool_add(kctx, reg);
 
 	mutex_unlock(&kctx->jit_evict_lock);
+
+	kbase_jit_pool_evict(kctx);
 }
 
 void kbase_jit_backing_lost(struct kbase_va_region *reg)
@@ -4138,6 +4242,7 @@ void kbase_jit_backing_lost(struct kbase_va_region *reg)
 	 * the worker which will do the freeing.
 	 */
 	list_move(&reg->jit_node, &kctx->jit_destroy_head);
+	list_del_init(&reg->jit_class_node);
 
 	schedule_work(&kctx->jit_work);
 }
@@ -4154,6 +4259,7 @@ bool kbase_jit_evict(struct kbase_context *kctx)
 		reg = list_entry(kctx->jit_pool_head.prev,
 				struct kbase_va_region, jit_node);
 		list_del(&reg->jit_node);
+		list_del_init(&reg->jit_class_node);
 		list_del_init(&reg->gpu_alloc->evict_node);
 	}
 	mutex_unlock(&kctx->jit_evict_lock);
@@ -4179,6 +4285,7 @@ void kbase_jit_term(struct kbase_context *kctx)
 		walker = list_first_entry(&kctx->jit_pool_head,
 				struct kbase_va_region, jit_node);
 		list_del(&walker->jit_node);
+		list_del_init(&walker->jit_class_node);
 		list_del_init(&walker->gpu_alloc->evict_node);
 		mutex_unlock(&kctx->jit_evict_lock);
 		walker->flags &= ~KBASE_REG_NO_USER_FREE;
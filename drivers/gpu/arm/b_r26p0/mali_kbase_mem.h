@@ -269,6 +269,7 @@ static inline struct kbase_mem_phy_alloc *kbase_mem_phy_alloc_put(struct kbase_m
  * @cpu_alloc: The physical memory we mmap to the CPU when mapping this region.
  * @gpu_alloc: The physical memory we mmap to the GPU when mapping this region.
  * @jit_node:     Links to neighboring regions in the just-in-time memory pool.
+ * @jit_class_node: Links to the pool regions of the same size class.
  * @jit_usage_id: The last just-in-time memory usage ID for this region.
  * @jit_bin_id:   The just-in-time memory bin this region came from.
  * @va_refcnt:    Number of users of this region. Protected by reg_lock.
@@ -408,6 +409,7 @@ struct kbase_va_region {
 	struct kbase_mem_phy_alloc *cpu_alloc;
 	struct kbase_mem_phy_alloc *gpu_alloc;
 	struct list_head jit_node;
+	struct list_head jit_class_node;
 	u16 jit_usage_id;
 	u8 jit_bin_id;
 #if MALI_JIT_PRESSURE_LIMIT_BASE
@@ -654,6 +656,29 @@ static inline int kbase_reg_prepare_native(struct kbase_va_region *reg,
  */
 #define KBASE_MEM_POOL_MAX_SIZE_KCTX  (SZ_64M >> PAGE_SHIFT)
 
+/*
+ * Default for the physical pages the JIT pool of a context keeps backed
+ */
+#define KBASE_JIT_POOL_MAX_PAGES  (SZ_64M >> PAGE_SHIFT)
+
+/*
+ * Free memory below which a kbdev memory pool is refilled in the background,
+ * to twice as much (in 4KB pages)
+ */
+#define KBASE_MEM_POOL_REFILL_LOW_KBDEV (SZ_4M >> PAGE_SHIFT)
+
+/*
+ * Time a pool is not refilled after the shrinker took pages from it
+ */
+#define KBASE_MEM_POOL_REFILL_BACKOFF (HZ)
+
+/*
+ * Time after which a 2MB pool left below its low watermark or reserve tries
+ * again, and during which allocations do not look for 2MB pages in the
+ * kernel after it had none
+ */
+#define KBASE_MEM_POOL_REFILL_RETRY (5 * HZ)
+
 /*
  * The order required for a 2MB page allocation (2^order * 4KB = 2MB)
  */
@@ -718,6 +743,13 @@ static inline size_t kbase_mem_pool_config_get_max_size(
  * A shrinker is registered so that Linux mm can reclaim pages from the pool as
  * needed.
  *
+ * A pool without @next_pool, one of the kbdev pools, is refilled from the
+ * kernel by a background worker when allocations take it below
+ * KBASE_MEM_POOL_REFILL_LOW_KBDEV, so that allocations rarely have to get
+ * and zero pages themselves. The 2MB pool of the default memory group also
+ * takes CONFIG_MALI_2MB_POOL_RESERVE pages at boot and keeps them from the
+ * shrinker. 2MB pools compact memory to refill only while the GPU is idle.
+ *
  * Return: 0 on success, negative -errno on error
  */
 int kbase_mem_pool_init(struct kbase_mem_pool *pool,
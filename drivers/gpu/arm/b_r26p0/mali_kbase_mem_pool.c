@@ -28,6 +28,8 @@
 #include <linux/shrinker.h>
 #include <linux/atomic.h>
 #include <linux/version.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
 
 #define pool_dbg(pool, format, ...) \
 	dev_dbg(pool->kbdev->dev, "%s-pool [%zu/%zu]: " format,	\
@@ -136,8 +138,12 @@ static void kbase_mem_pool_zero_page(struct kbase_mem_pool *pool,
 {
 	int i;
 
-	for (i = 0; i < (1U << pool->order); i++)
-		clear_highpage(p+i);
+	if (!PageHighMem(p)) {
+		clear_pages(page_address(p), 1U << pool->order);
+	} else {
+		for (i = 0; i < (1U << pool->order); i++)
+			clear_highpage(p+i);
+	}
 
 	kbase_mem_pool_sync_page(pool, p);
 }
@@ -151,7 +157,8 @@ static void kbase_mem_pool_spill(struct kbase_mem_pool *next_pool,
 	kbase_mem_pool_add(next_pool, p);
 }
 
-struct page *kbase_mem_alloc_page(struct kbase_mem_pool *pool)
+static struct page *kbase_mem_pool_alloc_kernel_page(
+		struct kbase_mem_pool *pool, bool may_reclaim)
 {
 	struct page *p;
 	gfp_t gfp;
@@ -172,6 +179,10 @@ struct page *kbase_mem_alloc_page(struct kbase_mem_pool *pool)
 	if (pool->order)
 		gfp |= __GFP_NOWARN;
 
+	/* background refills leave reclaim to kswapd */
+	if (!may_reclaim)
+		gfp = (gfp & ~__GFP_DIRECT_RECLAIM) | __GFP_NOWARN;
+
 	p = kbdev->mgm_dev->ops.mgm_alloc_page(kbdev->mgm_dev,
 		pool->group_id, gfp, pool->order);
 	if (!p)
@@ -193,6 +204,80 @@ struct page *kbase_mem_alloc_page(struct kbase_mem_pool *pool)
 	return p;
 }
 
+struct page *kbase_mem_alloc_page(struct kbase_mem_pool *pool)
+{
+	return kbase_mem_pool_alloc_kernel_page(pool, true);
+}
+
+static size_t kbase_mem_pool_refill_level(struct kbase_mem_pool *pool)
+{
+	return max(pool->low_watermark, pool->reserve);
+}
+
+/* compaction for a 2MB page is only worth it while the GPU has nothing to do */
+static bool kbase_mem_pool_may_compact(struct kbase_mem_pool *pool)
+{
+	return pool->order && !READ_ONCE(pool->kbdev->pm.active_count);
+}
+
+static void kbase_mem_pool_refill_worker(struct work_struct *work)
+{
+	struct kbase_mem_pool *pool = container_of(work, struct kbase_mem_pool,
+			refill_work.work);
+	size_t target = min(max(2 * pool->low_watermark, pool->reserve),
+			kbase_mem_pool_max_size(pool));
+	bool may_compact = kbase_mem_pool_may_compact(pool);
+	size_t nr_added = 0;
+	u64 start = ktime_get_ns();
+	u64 elapsed;
+	struct page *p;
+
+	for (;;) {
+		kbase_mem_pool_lock(pool);
+		if (pool->dying || kbase_mem_pool_size(pool) >= target ||
+			time_before(jiffies, pool->last_reclaim +
+				KBASE_MEM_POOL_REFILL_BACKOFF)) {
+			kbase_mem_pool_unlock(pool);
+			break;
+		}
+		kbase_mem_pool_unlock(pool);
+
+		/* comes zeroed and synced for the device */
+		p = kbase_mem_pool_alloc_kernel_page(pool, may_compact);
+		if (!p)
+			break;
+
+		kbase_mem_pool_add(pool, p);
+		nr_added++;
+		cond_resched();
+	}
+
+	if (nr_added) {
+		/* only this worker writes them */
+		elapsed = ktime_get_ns() - start;
+		pool->refill_runs++;
+		pool->refill_pages += nr_added;
+		pool->refill_ns += elapsed;
+		if (elapsed > pool->refill_max_ns)
+			pool->refill_max_ns = elapsed;
+
+		pool_dbg(pool, "refilled %zu pages\n", nr_added);
+	}
+
+	/* 2MB pages may be missing only until the next idle window */
+	if (pool->order && !pool->dying &&
+		kbase_mem_pool_size(pool) < kbase_mem_pool_refill_level(pool))
+		queue_delayed_work(system_unbound_wq, &pool->refill_work,
+				KBASE_MEM_POOL_REFILL_RETRY);
+}
+
+static void kbase_mem_pool_check_refill(struct kbase_mem_pool *pool)
+{
+	if (kbase_mem_pool_refill_level(pool) && !pool->dying &&
+		kbase_mem_pool_size(pool) < kbase_mem_pool_refill_level(pool))
+		queue_delayed_work(system_unbound_wq, &pool->refill_work, 0);
+}
+
 static void kbase_mem_pool_free_page(struct kbase_mem_pool *pool,
 		struct page *p)
 {
@@ -334,6 +419,8 @@ static unsigned long kbase_mem_pool_reclaim_count_objects(struct shrinker *s,
 		return 0;
 	}
 	pool_size = kbase_mem_pool_size(pool);
+	if (!pool->dying)
+		pool_size -= min(pool_size, pool->reserve);
 	kbase_mem_pool_unlock(pool);
 
 	return pool_size;
@@ -344,6 +431,7 @@ static unsigned long kbase_mem_pool_reclaim_scan_objects(struct shrinker *s,
 {
 	struct kbase_mem_pool *pool;
 	unsigned long freed;
+	size_t reclaimable;
 
 	pool = container_of(s, struct kbase_mem_pool, reclaim);
 
@@ -355,7 +443,14 @@ static unsigned long kbase_mem_pool_reclaim_scan_objects(struct shrinker *s,
 
 	pool_dbg(pool, "reclaim scan %ld:\n", sc->nr_to_scan);
 
-	freed = kbase_mem_pool_shrink_locked(pool, sc->nr_to_scan);
+	reclaimable = kbase_mem_pool_size(pool);
+	if (!pool->dying)
+		reclaimable -= min(reclaimable, pool->reserve);
+
+	freed = kbase_mem_pool_shrink_locked(pool,
+			min_t(size_t, sc->nr_to_scan, reclaimable));
+	if (freed)
+		pool->last_reclaim = jiffies;
 
 	kbase_mem_pool_unlock(pool);
 
@@ -398,6 +493,25 @@ int kbase_mem_pool_init(struct kbase_mem_pool *pool,
 	spin_lock_init(&pool->pool_lock);
 	INIT_LIST_HEAD(&pool->page_list);
 
+	/* kctx pools get their pages from the kbdev pools */
+	pool->low_watermark = next_pool ? 0 :
+		KBASE_MEM_POOL_REFILL_LOW_KBDEV >> order;
+	pool->reserve = 0;
+#ifdef CONFIG_MALI_2MB_ALLOC
+	/* one 2MB pool shared by all contexts keeps a reserve */
+	if (!next_pool && order && group_id == BASE_MEM_GROUP_DEFAULT)
+		pool->reserve = CONFIG_MALI_2MB_POOL_RESERVE;
+#endif
+	INIT_DELAYED_WORK(&pool->refill_work, kbase_mem_pool_refill_worker);
+	pool->last_reclaim = jiffies - KBASE_MEM_POOL_REFILL_BACKOFF;
+	pool->kernel_fail_until = jiffies;
+	atomic_long_set(&pool->alloc_hits, 0);
+	atomic_long_set(&pool->alloc_misses, 0);
+	pool->refill_runs = 0;
+	pool->refill_pages = 0;
+	pool->refill_ns = 0;
+	pool->refill_max_ns = 0;
+
 	/* Register shrinker */
 #if LINUX_VERSION_CODE < KERNEL_VERSION(3, 12, 0)
 	pool->reclaim.shrink = kbase_mem_pool_reclaim_shrink;
@@ -413,6 +527,9 @@ int kbase_mem_pool_init(struct kbase_mem_pool *pool,
 #endif
 	register_shrinker(&pool->reclaim);
 
+	/* take the reserve while memory is least fragmented */
+	kbase_mem_pool_check_refill(pool);
+
 	pool_dbg(pool, "initialized\n");
 
 	return 0;
@@ -438,6 +555,11 @@ void kbase_mem_pool_term(struct kbase_mem_pool *pool)
 
 	unregister_shrinker(&pool->reclaim);
 
+	kbase_mem_pool_lock(pool);
+	pool->dying = true;
+	kbase_mem_pool_unlock(pool);
+	cancel_delayed_work_sync(&pool->refill_work);
+
 	kbase_mem_pool_lock(pool);
 	pool->max_size = 0;
 
@@ -487,8 +609,11 @@ struct page *kbase_mem_pool_alloc(struct kbase_mem_pool *pool)
 		pool_dbg(pool, "alloc()\n");
 		p = kbase_mem_pool_remove(pool);
 
-		if (p)
+		if (p) {
+			atomic_long_inc(&pool->alloc_hits);
+			kbase_mem_pool_check_refill(pool);
 			return p;
+		}
 
 		pool = pool->next_pool;
 	} while (pool);
@@ -505,8 +630,11 @@ struct page *kbase_mem_pool_alloc_locked(struct kbase_mem_pool *pool)
 	pool_dbg(pool, "alloc_locked()\n");
 	p = kbase_mem_pool_remove_locked(pool);
 
-	if (p)
+	if (p) {
+		atomic_long_inc(&pool->alloc_hits);
+		kbase_mem_pool_check_refill(pool);
 		return p;
+	}
 
 	return NULL;
 }
@@ -572,6 +700,7 @@ int kbase_mem_pool_alloc_pages(struct kbase_mem_pool *pool, size_t nr_4k_pages,
 	/* Get pages from this pool */
 	kbase_mem_pool_lock(pool);
 	nr_from_pool = min(nr_pages_internal, kbase_mem_pool_size(pool));
+	atomic_long_add(nr_from_pool, &pool->alloc_hits);
 	while (nr_from_pool--) {
 		int j;
 		p = kbase_mem_pool_remove_locked(pool);
@@ -586,6 +715,7 @@ int kbase_mem_pool_alloc_pages(struct kbase_mem_pool *pool, size_t nr_4k_pages,
 			pages[i++] = as_tagged(page_to_phys(p));
 		}
 	}
+	kbase_mem_pool_check_refill(pool);
 	kbase_mem_pool_unlock(pool);
 
 	if (i != nr_4k_pages && pool->next_pool) {
@@ -600,7 +730,22 @@ int kbase_mem_pool_alloc_pages(struct kbase_mem_pool *pool, size_t nr_4k_pages,
 	} else {
 		/* Get any remaining pages from kernel */
 		while (i != nr_4k_pages) {
+			/*
+			 * Memory too fragmented for 2MB pages, fall back to
+			 * 4KB ones without trying again each time. The pool
+			 * refill compacts for more when the GPU is idle.
+			 */
+			if (pool->order && partial_allowed &&
+				time_before(jiffies, pool->kernel_fail_until))
+				goto done;
+
+			atomic_long_inc(&pool->alloc_misses);
 			p = kbase_mem_alloc_page(pool);
+			if (!p && pool->order) {
+				pool->kernel_fail_until = jiffies +
+					KBASE_MEM_POOL_REFILL_RETRY;
+				kbase_mem_pool_check_refill(pool);
+			}
 			if (!p) {
 				if (partial_allowed)
 					goto done;
@@ -656,6 +801,7 @@ int kbase_mem_pool_alloc_pages_locked(struct kbase_mem_pool *pool,
 
 	if (kbase_mem_pool_size(pool) < nr_pages_internal) {
 		pool_dbg(pool, "Failed alloc\n");
+		kbase_mem_pool_check_refill(pool);
 		return -ENOMEM;
 	}
 
@@ -675,6 +821,8 @@ int kbase_mem_pool_alloc_pages_locked(struct kbase_mem_pool *pool,
 			*pages++ = as_tagged(page_to_phys(p));
 		}
 	}
+	atomic_long_add(nr_pages_internal, &pool->alloc_hits);
+	kbase_mem_pool_check_refill(pool);
 
 	return nr_4k_pages;
 }
@@ -166,6 +166,72 @@ static const struct file_operations kbase_mem_pool_debugfs_max_size_fops = {
 	.release = single_release,
 };
 
+static void kbase_mem_pool_refill_show_pool(struct seq_file *sfile,
+	const char *name, int gid, struct kbase_mem_pool *pool)
+{
+	u64 runs = READ_ONCE(pool->refill_runs);
+	u64 avg_ns = runs ? div64_u64(READ_ONCE(pool->refill_ns), runs) : 0;
+
+	seq_printf(sfile, "%-5s %3d %9zu %7zu %9zu %10ld %10ld %8llu %10llu %8llu %8llu\n",
+		name, gid, pool->low_watermark, pool->reserve,
+		kbase_mem_pool_size(pool),
+		atomic_long_read(&pool->alloc_hits),
+		atomic_long_read(&pool->alloc_misses),
+		runs, READ_ONCE(pool->refill_pages),
+		div_u64(avg_ns, NSEC_PER_USEC),
+		div_u64(READ_ONCE(pool->refill_max_ns), NSEC_PER_USEC));
+}
+
+static int kbase_mem_pool_refill_debugfs_show(struct seq_file *sfile,
+	void *data)
+{
+	struct kbase_device *kbdev = sfile->private;
+	long lp = atomic_long_read(&kbdev->memdev.lp_backed_pages);
+	long sp = atomic_long_read(&kbdev->memdev.sp_backed_pages);
+	int gid;
+
+	CSTD_UNUSED(data);
+
+	seq_printf(sfile, "%-5s %3s %9s %7s %9s %10s %10s %8s %10s %8s %8s\n",
+		"pool", "gid", "low_wmark", "reserve", "size", "hits", "misses",
+		"refills", "refilled", "avg_us", "max_us");
+
+	for (gid = 0; gid < MEMORY_GROUP_MANAGER_NR_GROUPS; gid++) {
+		kbase_mem_pool_refill_show_pool(sfile, "small", gid,
+			&kbdev->mem_pools.small[gid]);
+		kbase_mem_pool_refill_show_pool(sfile, "large", gid,
+			&kbdev->mem_pools.large[gid]);
+	}
+
+	/* 4KB pages handed to contexts since boot and how they were backed */
+	seq_printf(sfile, "\nbacked_2mb %ld\nbacked_4kb %ld\nbacked_2mb_pct %ld\n",
+		lp, sp, lp + sp ? lp * 100 / (lp + sp) : 0);
+
+	return 0;
+}
+
+static int kbase_mem_pool_refill_debugfs_open(struct inode *in,
+	struct file *file)
+{
+	return single_open(file, kbase_mem_pool_refill_debugfs_show,
+		in->i_private);
+}
+
+static const struct file_operations kbase_mem_pool_refill_debugfs_fops = {
+	.owner = THIS_MODULE,
+	.open = kbase_mem_pool_refill_debugfs_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void kbase_mem_pool_refill_debugfs_init(struct dentry *parent,
+		struct kbase_device *kbdev)
+{
+	debugfs_create_file("mem_pool_refill", 0444, parent, kbdev,
+		&kbase_mem_pool_refill_debugfs_fops);
+}
+
 void kbase_mem_pool_debugfs_init(struct dentry *parent,
 		struct kbase_context *kctx)
 {
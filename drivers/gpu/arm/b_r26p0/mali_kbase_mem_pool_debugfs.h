@@ -39,6 +39,19 @@
 void kbase_mem_pool_debugfs_init(struct dentry *parent,
 		struct kbase_context *kctx);
 
+/**
+ * kbase_mem_pool_refill_debugfs_init - add debugfs file for background refill
+ *                                      of the kbdev memory pools
+ * @parent:  Parent debugfs dentry
+ * @kbdev:   The kbase device
+ *
+ * Adds mem_pool_refill under @parent. For each kbdev pool it shows the low
+ * watermark, the current size, pages allocated from the pool and from the
+ * kernel, and the number, size and duration of background refills.
+ */
+void kbase_mem_pool_refill_debugfs_init(struct dentry *parent,
+		struct kbase_device *kbdev);
+
 /**
  * kbase_mem_pool_debugfs_trim - Grow or shrink a memory pool to a new size
  *
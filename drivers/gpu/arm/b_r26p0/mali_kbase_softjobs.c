@@ -1067,7 +1067,7 @@ static void kbase_jit_add_to_pending_alloc_list(struct kbase_jd_atom *katom)
 	list_add_tail(&katom->queue, target_list_head);
 }
 
-static int kbase_jit_allocate_process(struct kbase_jd_atom *katom)
+static int kbasep_jit_allocate_process(struct kbase_jd_atom *katom)
 {
 	struct kbase_context *kctx = katom->kctx;
 	struct kbase_device *kbdev = kctx->kbdev;
@@ -1245,6 +1245,24 @@ static int kbase_jit_allocate_process(struct kbase_jd_atom *katom)
 	return 0;
 }
 
+static int kbase_jit_allocate_process(struct kbase_jd_atom *katom)
+{
+	struct kbase_context *kctx = katom->kctx;
+	bool batched;
+	int ret;
+
+	/*
+	 * One flush for all the allocations of the atom, issued before the
+	 * atom completes and the jobs depending on it can run.
+	 */
+	batched = kbase_mmu_batch_begin(kctx);
+	ret = kbasep_jit_allocate_process(katom);
+	if (batched)
+		kbase_mmu_batch_end(kctx);
+
+	return ret;
+}
+
 static void kbase_jit_allocate_finish(struct kbase_jd_atom *katom)
 {
 	struct base_jit_alloc_info *info;
@@ -196,6 +196,15 @@ void kbase_sync_fence_info_get(struct fence *fence,
 void kbase_sync_fence_info_get(struct dma_fence *fence,
 			       struct kbase_sync_fence_info *info);
 #endif
+
+#ifdef CONFIG_DEBUG_FS
+/**
+ * kbase_sync_fence_debugfs_init() - Add a debugfs entry for the latency of
+ *                                   input fence waits
+ * @kbdev: Device pointer
+ */
+void kbase_sync_fence_debugfs_init(struct kbase_device *kbdev);
+#endif
 #endif
 
 /**
@@ -37,6 +37,8 @@
 #include <linux/uaccess.h>
 #include <linux/sync_file.h>
 #include <linux/slab.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include "mali_kbase_fence_defs.h"
 #include "mali_kbase_sync.h"
 #include "mali_kbase_fence.h"
@@ -169,6 +171,29 @@ kbase_sync_fence_out_trigger(struct kbase_jd_atom *katom, int result)
 	return (result != 0) ? BASE_JD_EVENT_JOB_CANCELLED : BASE_JD_EVENT_DONE;
 }
 
+/* Waits completed from the fence callback, for kbase_sync_fence_debugfs */
+static void kbase_fence_wait_worker(struct work_struct *data)
+{
+	struct kbase_jd_atom *katom = container_of(data, struct kbase_jd_atom,
+			work);
+	struct kbase_device *kbdev = katom->kctx->kbdev;
+	u64 delay = ktime_get_ns() - katom->dma_fence.signal_ns;
+	u64 max = atomic64_read(&kbdev->fence_wait_max_ns);
+
+	atomic_inc(&kbdev->fence_wait_queued);
+	atomic64_add(delay, &kbdev->fence_wait_queue_ns);
+	while (delay > max) {
+		u64 old = atomic64_cmpxchg(&kbdev->fence_wait_max_ns, max,
+				delay);
+
+		if (old == max)
+			break;
+		max = old;
+	}
+
+	kbase_soft_event_wait_callback(katom);
+}
+
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(4, 10, 0))
 static void kbase_fence_wait_callback(struct fence *fence,
 				      struct fence_cb *cb)
@@ -197,6 +222,16 @@ static void kbase_fence_wait_callback(struct dma_fence *fence,
 		/* We take responsibility of handling this */
 		kbase_fence_dep_count_set(katom, -1);
 
+		/* Signalled by a fence trigger of this context that
+		 * jd_done_nolock() is running with jctx.lock held: it
+		 * completes the atom before returning, skip the work item.
+		 */
+		if (READ_ONCE(kctx->jctx.fence_signaller) == current) {
+			list_add_tail(&katom->jd_item, &kctx->jctx.fence_ready);
+			atomic_inc(&kctx->kbdev->fence_wait_inline);
+			return;
+		}
+
 		/* To prevent a potential deadlock we schedule the work onto the
 		 * job_done_wq workqueue
 		 *
@@ -204,7 +239,8 @@ static void kbase_fence_wait_callback(struct dma_fence *fence,
 		 * kctx->jctx.lock and the callbacks are run synchronously from
 		 * sync_timeline_signal. So we simply defer the work.
 		 */
-		INIT_WORK(&katom->work, kbase_sync_fence_wait_worker);
+		katom->dma_fence.signal_ns = ktime_get_ns();
+		INIT_WORK(&katom->work, kbase_fence_wait_worker);
 		queue_work(kctx->jctx.job_done_wq, &katom->work);
 	}
 }
@@ -370,6 +406,46 @@ int kbase_sync_fence_out_info_get(struct kbase_jd_atom *katom,
 }
 
 
+#ifdef CONFIG_DEBUG_FS
+static int kbase_sync_fence_debugfs_show(struct seq_file *sfile, void *data)
+{
+	struct kbase_device *kbdev = sfile->private;
+	unsigned int queued = atomic_read(&kbdev->fence_wait_queued);
+	u64 total = atomic64_read(&kbdev->fence_wait_queue_ns);
+
+	CSTD_UNUSED(data);
+
+	seq_printf(sfile, "inline %u\nqueued %u\n",
+		atomic_read(&kbdev->fence_wait_inline), queued);
+	seq_printf(sfile, "queued_avg_us %llu\nqueued_max_us %llu\n",
+		queued ? div_u64(div_u64(total, queued), NSEC_PER_USEC) : 0,
+		div_u64(atomic64_read(&kbdev->fence_wait_max_ns),
+			NSEC_PER_USEC));
+
+	return 0;
+}
+
+static int kbase_sync_fence_debugfs_open(struct inode *in, struct file *file)
+{
+	return single_open(file, kbase_sync_fence_debugfs_show, in->i_private);
+}
+
+static const struct file_operations kbase_sync_fence_debugfs_fops = {
+	.owner = THIS_MODULE,
+	.open = kbase_sync_fence_debugfs_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void kbase_sync_fence_debugfs_init(struct kbase_device *kbdev)
+{
+	debugfs_create_file("fence_wait_latency", 0444,
+		kbdev->mali_debugfs_directory, kbdev,
+		&kbase_sync_fence_debugfs_fops);
+}
+#endif /* CONFIG_DEBUG_FS */
+
 #ifdef CONFIG_MALI_FENCE_DEBUG
 void kbase_sync_fence_in_dump(struct kbase_jd_atom *katom)
 {
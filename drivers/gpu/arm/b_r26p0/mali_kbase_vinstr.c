@@ -89,6 +89,8 @@ struct kbase_vinstr_context {
  * @read_idx:          Index of buffer read by userspace.
  * @write_idx:         Index of buffer being written by dump worker.
  * @waitq:             Client's notification queue.
+ * @ring:              Ring header shared with userspace once ring mode is
+ *                     enabled, else NULL.
  */
 struct kbase_vinstr_client {
 	struct kbase_vinstr_context *vctx;
@@ -103,6 +105,7 @@ struct kbase_vinstr_client {
 	atomic_t read_idx;
 	atomic_t write_idx;
 	wait_queue_head_t waitq;
+	struct kbase_hwcnt_reader_ring *ring;
 };
 
 static unsigned int kbasep_vinstr_hwcnt_reader_poll(
@@ -184,6 +187,7 @@ static int kbasep_vinstr_client_dump(
 	unsigned int read_idx;
 	struct kbase_hwcnt_dump_buffer *dump_buf;
 	struct kbase_hwcnt_reader_metadata *meta;
+	struct kbase_hwcnt_reader_ring_slot *slot = NULL;
 	u8 clk_cnt;
 
 	WARN_ON(!vcli);
@@ -192,14 +196,26 @@ static int kbasep_vinstr_client_dump(
 	write_idx = atomic_read(&vcli->write_idx);
 	read_idx = atomic_read(&vcli->read_idx);
 
-	/* Check if there is a place to copy HWC block into. */
-	if (write_idx - read_idx == vcli->dump_bufs.buf_cnt)
+	/* Check if there is a place to copy HWC block into. A ring overwrites
+	 * the oldest sample instead.
+	 */
+	if (!vcli->ring && write_idx - read_idx == vcli->dump_bufs.buf_cnt)
 		return -EBUSY;
 	write_idx %= vcli->dump_bufs.buf_cnt;
 
 	dump_buf = &vcli->dump_bufs.bufs[write_idx];
 	meta = &vcli->dump_bufs_meta[write_idx];
 
+	if (vcli->ring) {
+		/* Readers of this slot now know it is being rewritten. It is
+		 * still odd if the last dump into it failed half way.
+		 */
+		slot = &vcli->ring->slots[write_idx];
+		if (!(slot->seq & 1))
+			WRITE_ONCE(slot->seq, slot->seq + 1);
+		smp_wmb();
+	}
+
 	errcode = kbase_hwcnt_virtualizer_client_dump(
 		vcli->hvcli, &ts_start_ns, &ts_end_ns, dump_buf);
 	if (errcode)
@@ -222,6 +238,16 @@ static int kbasep_vinstr_client_dump(
 	meta->cycles.shader_cores =
 	    (clk_cnt > 1) ? dump_buf->clk_cnt_buf[1] : 0;
 
+	if (slot) {
+		slot->start_ns = ts_start_ns;
+		slot->meta = *meta;
+		smp_wmb();
+		WRITE_ONCE(slot->seq, slot->seq + 1);
+		smp_wmb();
+		WRITE_ONCE(vcli->ring->write_idx,
+			atomic_read(&vcli->write_idx) + 1);
+	}
+
 	/* Notify client. Make sure all changes to memory are visible. */
 	wmb();
 	atomic_inc(&vcli->write_idx);
@@ -369,6 +395,7 @@ static void kbasep_vinstr_client_destroy(struct kbase_vinstr_client *vcli)
 		return;
 
 	kbase_hwcnt_virtualizer_client_destroy(vcli->hvcli);
+	free_page((unsigned long)vcli->ring);
 	kfree(vcli->dump_bufs_meta);
 	kbase_hwcnt_dump_buffer_array_free(&vcli->dump_bufs);
 	kbase_hwcnt_enable_map_free(&vcli->enable_map);
@@ -687,6 +714,10 @@ static long kbasep_vinstr_hwcnt_reader_ioctl_get_buffer(
 	const size_t meta_size = sizeof(struct kbase_hwcnt_reader_metadata);
 	const size_t min_size = min(size, meta_size);
 
+	/* Ring readers take samples from the mapping */
+	if (unlikely(READ_ONCE(cli->ring)))
+		return -EPERM;
+
 	/* Metadata sanity check. */
 	WARN_ON(idx != meta->buffer_idx);
 
@@ -736,7 +767,8 @@ static long kbasep_vinstr_hwcnt_reader_ioctl_put_buffer(
 	size_t i;
 
 	/* Check if any buffer was taken. */
-	if (unlikely(atomic_read(&cli->meta_idx) == read_idx))
+	if (unlikely(READ_ONCE(cli->ring) ||
+		     atomic_read(&cli->meta_idx) == read_idx))
 		return -EPERM;
 
 	if (likely(max_size <= sizeof(stack_kbuf))) {
@@ -821,6 +853,66 @@ static long kbasep_vinstr_hwcnt_reader_ioctl_set_interval(
 	return 0;
 }
 
+/**
+ * kbasep_vinstr_hwcnt_reader_ring_offset() - Offset of the ring header in the
+ *                                            client's mapping.
+ * @cli: Non-NULL pointer to vinstr client.
+ *
+ * Return: Offset in bytes, on the page after the dump buffers.
+ */
+static unsigned long kbasep_vinstr_hwcnt_reader_ring_offset(
+	struct kbase_vinstr_client *cli)
+{
+	return PAGE_ALIGN(cli->dump_bufs.buf_cnt *
+		cli->vctx->metadata->dump_buf_bytes);
+}
+
+/**
+ * kbasep_vinstr_hwcnt_reader_ioctl_enable_ring() - Enable ring ioctl command.
+ * @cli:    Non-NULL pointer to vinstr client.
+ * @offset: Non-NULL pointer to user buffer where the mmap offset of the ring
+ *          header will be stored.
+ *
+ * Switches the client to ring mode, see struct kbase_hwcnt_reader_ring. Once
+ * enabled, it stays enabled for the life of the client.
+ *
+ * Return: 0 on success, else error code.
+ */
+static long kbasep_vinstr_hwcnt_reader_ioctl_enable_ring(
+	struct kbase_vinstr_client *cli,
+	u32 __user *offset)
+{
+	struct kbase_hwcnt_reader_ring *ring;
+	unsigned int i;
+
+	BUILD_BUG_ON(sizeof(*ring) + MAX_BUFFER_COUNT *
+		sizeof(ring->slots[0]) > PAGE_SIZE);
+
+	mutex_lock(&cli->vctx->lock);
+
+	if (!cli->ring) {
+		ring = (void *)get_zeroed_page(GFP_KERNEL);
+		if (!ring) {
+			mutex_unlock(&cli->vctx->lock);
+			return -ENOMEM;
+		}
+
+		/* Samples still waiting for GET_BUFFER are dropped */
+		ring->buf_cnt = cli->dump_bufs.buf_cnt;
+		for (i = 0; i < ring->buf_cnt; i++)
+			ring->slots[i].meta.buffer_idx = i;
+		atomic_set(&cli->write_idx, 0);
+		atomic_set(&cli->meta_idx, 0);
+		atomic_set(&cli->read_idx, 0);
+		WRITE_ONCE(cli->ring, ring);
+	}
+
+	mutex_unlock(&cli->vctx->lock);
+
+	return put_user((u32)kbasep_vinstr_hwcnt_reader_ring_offset(cli),
+			offset);
+}
+
 /**
  * kbasep_vinstr_hwcnt_reader_ioctl_enable_event() - Enable event ioctl command.
  * @cli:      Non-NULL pointer to vinstr client.
@@ -913,6 +1005,8 @@ static long kbasep_vinstr_hwcnt_reader_ioctl_get_api_version(
 		if (clk_cnt > 1)
 			api_version.features |=
 			    KBASE_HWCNT_READER_API_VERSION_FEATURE_CYCLES_SHADER_CORES;
+		api_version.features |=
+			KBASE_HWCNT_READER_API_VERSION_FEATURE_RING;
 
 		ret = put_user(api_version,
 			       (struct kbase_hwcnt_reader_api_version __user *)
@@ -984,6 +1078,10 @@ static long kbasep_vinstr_hwcnt_reader_ioctl(
 		rcode = kbasep_vinstr_hwcnt_reader_ioctl_disable_event(
 			cli, (enum base_hwcnt_reader_event)arg);
 		break;
+	case _IOC_NR(KBASE_HWCNT_READER_ENABLE_RING):
+		rcode = kbasep_vinstr_hwcnt_reader_ioctl_enable_ring(
+			cli, (u32 __user *)arg);
+		break;
 	default:
 		pr_warn("Unknown HWCNT ioctl 0x%x nr:%d", cmd, _IOC_NR(cmd));
 		rcode = -EINVAL;
@@ -1044,6 +1142,18 @@ static int kbasep_vinstr_hwcnt_reader_mmap(
 	vm_size = vma->vm_end - vma->vm_start;
 	size = cli->dump_bufs.buf_cnt * cli->vctx->metadata->dump_buf_bytes;
 
+	/* The ring header is only written by the kernel */
+	offset = kbasep_vinstr_hwcnt_reader_ring_offset(cli);
+	if (vma->vm_pgoff == (offset >> PAGE_SHIFT) && READ_ONCE(cli->ring)) {
+		if (vm_size != PAGE_SIZE || (vma->vm_flags & VM_WRITE))
+			return -EINVAL;
+		vma->vm_flags &= ~VM_MAYWRITE;
+
+		return remap_pfn_range(vma, vma->vm_start,
+				__pa(cli->ring) >> PAGE_SHIFT, vm_size,
+				vma->vm_page_prot);
+	}
+
 	if (vma->vm_pgoff > (size >> PAGE_SHIFT))
 		return -EINVAL;
 
@@ -1620,6 +1620,99 @@ static void kbase_mmu_flush_invalidate_no_ctx(struct kbase_device *kbdev,
 	}
 }
 
+/* Flush range covering [start, end), all of it if it cannot be locked at once */
+static void kbase_mmu_batch_range(u64 start, u64 end, u64 *vpfn, size_t *nr)
+{
+	if (end - start > U32_MAX) {
+		*vpfn = 0;
+		*nr = U32_MAX;
+	} else {
+		*vpfn = start;
+		*nr = end - start;
+	}
+}
+
+/*
+ * Defers a flush of @kctx to the end of its MMU batch, or widens a flush that
+ * must be issued now to cover what its batch has deferred so far.
+ */
+static bool kbase_mmu_batch_defer(struct kbase_context *kctx, u64 *vpfn,
+		size_t *nr, bool sync)
+{
+	struct kbase_mmu_table *mmut = &kctx->mmu;
+	bool deferred = false;
+	u64 start = *vpfn;
+	u64 end = *vpfn + *nr;
+
+	/* no batch started, the common case */
+	if (!READ_ONCE(mmut->batch_owner) &&
+			READ_ONCE(mmut->batch_end) == READ_ONCE(mmut->batch_start))
+		return false;
+
+	rt_mutex_lock(&mmut->mmu_lock);
+	if (mmut->batch_end != mmut->batch_start) {
+		start = min(start, mmut->batch_start);
+		end = max(end, mmut->batch_end);
+	}
+
+	if (!sync && mmut->batch_owner == current) {
+		mmut->batch_start = start;
+		mmut->batch_end = end;
+		atomic_inc(&kctx->kbdev->mmu_flush_deferred);
+		deferred = true;
+	} else if (mmut->batch_end != mmut->batch_start) {
+		mmut->batch_start = mmut->batch_end = 0;
+		kbase_mmu_batch_range(start, end, vpfn, nr);
+	}
+	rt_mutex_unlock(&mmut->mmu_lock);
+
+	return deferred;
+}
+
+bool kbase_mmu_batch_begin(struct kbase_context *kctx)
+{
+	struct kbase_mmu_table *mmut = &kctx->mmu;
+	bool started = false;
+
+	rt_mutex_lock(&mmut->mmu_lock);
+	if (!mmut->batch_owner)
+		mmut->batch_owner = current;
+	if (mmut->batch_owner == current) {
+		mmut->batch_depth++;
+		started = true;
+	}
+	rt_mutex_unlock(&mmut->mmu_lock);
+
+	return started;
+}
+
+void kbase_mmu_batch_end(struct kbase_context *kctx)
+{
+	struct kbase_mmu_table *mmut = &kctx->mmu;
+	u64 start, end;
+	u64 vpfn;
+	size_t nr;
+
+	rt_mutex_lock(&mmut->mmu_lock);
+	if (WARN_ON(mmut->batch_owner != current || !mmut->batch_depth) ||
+			--mmut->batch_depth) {
+		rt_mutex_unlock(&mmut->mmu_lock);
+		return;
+	}
+	mmut->batch_owner = NULL;
+	start = mmut->batch_start;
+	end = mmut->batch_end;
+	mmut->batch_start = mmut->batch_end = 0;
+	rt_mutex_unlock(&mmut->mmu_lock);
+
+	if (end == start)
+		return;
+
+	atomic_inc(&kctx->kbdev->mmu_flush_batched);
+	kbase_mmu_batch_range(start, end, &vpfn, &nr);
+	kbase_mmu_flush_invalidate(kctx, vpfn, nr, false);
+}
+
 static void kbase_mmu_flush_invalidate(struct kbase_context *kctx,
 		u64 vpfn, size_t nr, bool sync)
 {
@@ -1630,6 +1723,9 @@ static void kbase_mmu_flush_invalidate(struct kbase_context *kctx,
 	if (nr == 0)
 		return;
 
+	if (kbase_mmu_batch_defer(kctx, &vpfn, &nr, sync))
+		return;
+
 	/* MALI_SEC_INTEGRATION */
 #ifdef CONFIG_MALI_RT_PM
 	if (!gpu_is_power_on())
@@ -2015,6 +2111,10 @@ int kbase_mmu_init(struct kbase_device *const kbdev,
 	mmut->group_id = group_id;
 	rt_mutex_init(&mmut->mmu_lock);
 	mmut->kctx = kctx;
+	mmut->batch_owner = NULL;
+	mmut->batch_depth = 0;
+	mmut->batch_start = 0;
+	mmut->batch_end = 0;
 
 	/* Preallocate MMU depth of four pages for mmu_teardown_level to use */
 	mmut->mmu_teardown_pages = kmalloc(PAGE_SIZE * 4, GFP_KERNEL);
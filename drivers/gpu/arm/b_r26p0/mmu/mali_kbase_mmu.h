@@ -100,6 +100,38 @@ int kbase_mmu_update_pages(struct kbase_context *kctx, u64 vpfn,
 			   struct tagged_addr *phys, size_t nr,
 			   unsigned long flags, int const group_id);
 
+/**
+ * kbase_mmu_batch_begin - Start deferring page table flushes of a context
+ *
+ * @kctx: Context whose GPU mappings are about to be updated.
+ *
+ * Until the matching kbase_mmu_batch_end(), the flushes that follow pages
+ * being inserted into the page tables of @kctx are not issued but merged
+ * into a single flush of the range they cover. Flushes that follow pages
+ * being torn down or updated are still issued right away, since the pages
+ * may be freed next, and take the merged range with them.
+ *
+ * Batches nest, and only flushes of the calling task are deferred. Nothing
+ * mapped inside a batch may be used by the GPU before the batch ends.
+ *
+ * Return: true if the batch was started and kbase_mmu_batch_end() must be
+ *         called, false if another task has a batch open on @kctx.
+ */
+bool kbase_mmu_batch_begin(struct kbase_context *kctx);
+
+/**
+ * kbase_mmu_batch_end - Issue the page table flushes deferred by a batch
+ *
+ * @kctx: Context passed to kbase_mmu_batch_begin().
+ *
+ * Ends the batch started by the matching kbase_mmu_batch_begin() that
+ * returned true. When it
+ * is the outermost one, a single flush is issued for the deferred range, or
+ * for the whole address space if the range is too large to be locked in
+ * one operation.
+ */
+void kbase_mmu_batch_end(struct kbase_context *kctx);
+
 /**
  * kbase_mmu_bus_fault_interrupt - Process a bus fault interrupt.
  *
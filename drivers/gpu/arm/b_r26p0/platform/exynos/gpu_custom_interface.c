@@ -1454,6 +1454,39 @@ static ssize_t show_utilization_stats(struct device *dev, struct device_attribut
 	return ret;
 }
 #endif /* CONFIG_CPU_THERMAL_IPA */
+
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+static ssize_t show_frame_stats(struct device *dev, struct device_attribute *attr, char *buf)
+{
+	ssize_t ret = 0;
+	unsigned long flags;
+	unsigned long frames, missed;
+	u64 period_ns;
+	struct exynos_context *platform = (struct exynos_context *)pkbdev->platform_context;
+
+	if (!platform)
+		return -ENODEV;
+
+	spin_lock_irqsave(&platform->frame.lock, flags);
+	frames = platform->frame.frames;
+	missed = platform->frame.missed;
+	period_ns = platform->frame.period_ns;
+	spin_unlock_irqrestore(&platform->frame.lock, flags);
+
+	ret += snprintf(buf+ret, PAGE_SIZE-ret, "frames=%lu missed=%lu period_us=%llu",
+					frames, missed, div_u64(period_ns, NSEC_PER_USEC));
+
+	if (ret < PAGE_SIZE - 1) {
+		ret += snprintf(buf+ret, PAGE_SIZE-ret, "\n");
+	} else {
+		buf[PAGE_SIZE-2] = '\n';
+		buf[PAGE_SIZE-1] = '\0';
+		ret = PAGE_SIZE-1;
+	}
+
+	return ret;
+}
+#endif /* CONFIG_MALI_DVFS_FRAME_GOVERNOR */
 #endif /* CONFIG_MALI_DVFS */
 
 static ssize_t show_debug_level(struct device *dev, struct device_attribute *attr, char *buf)
@@ -1828,6 +1861,9 @@ DEVICE_ATTR(tmu, S_IRUGO|S_IWUSR, show_tmu, set_tmu_control);
 DEVICE_ATTR(norm_utilization, S_IRUGO, show_norm_utilization, NULL);
 DEVICE_ATTR(utilization_stats, S_IRUGO, show_utilization_stats, NULL);
 #endif /* CONFIG_CPU_THERMAL_IPA */
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+DEVICE_ATTR(frame_stats, S_IRUGO, show_frame_stats, NULL);
+#endif /* CONFIG_MALI_DVFS_FRAME_GOVERNOR */
 #endif /* CONFIG_MALI_DVFS */
 DEVICE_ATTR(debug_level, S_IRUGO|S_IWUSR, show_debug_level, set_debug_level);
 #ifdef CONFIG_MALI_EXYNOS_TRACE
@@ -2544,6 +2580,12 @@ int gpu_create_sysfs_file(struct device *dev)
 		goto out;
 	}
 #endif /* CONFIG_CPU_THERMAL_IPA */
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+	if (device_create_file(dev, &dev_attr_frame_stats)) {
+		GPU_LOG(DVFS_ERROR, DUMMY, 0u, 0u, "couldn't create sysfs file [frame_stats]\n");
+		goto out;
+	}
+#endif /* CONFIG_MALI_DVFS_FRAME_GOVERNOR */
 #endif /* CONFIG_MALI_DVFS */
 	if (device_create_file(dev, &dev_attr_debug_level)) {
 		GPU_LOG(DVFS_ERROR, DUMMY, 0u, 0u, "couldn't create sysfs file [debug_level]\n");
@@ -2654,6 +2696,9 @@ void gpu_remove_sysfs_file(struct device *dev)
 	device_remove_file(dev, &dev_attr_norm_utilization);
 	device_remove_file(dev, &dev_attr_utilization_stats);
 #endif /* CONFIG_CPU_THERMAL_IPA */
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+	device_remove_file(dev, &dev_attr_frame_stats);
+#endif /* CONFIG_MALI_DVFS_FRAME_GOVERNOR */
 #endif /* CONFIG_MALI_DVFS */
 	device_remove_file(dev, &dev_attr_debug_level);
 #ifdef CONFIG_MALI_EXYNOS_TRACE
@@ -26,6 +26,9 @@
 #include "gpu_control.h"
 #include "gpu_dvfs_handler.h"
 #include "gpu_dvfs_governor.h"
+#ifdef CONFIG_MALI_EXYNOS_IPA_COUNTERS
+#include <ipa/mali_kbase_ipa.h>
+#endif
 
 #ifdef CONFIG_EXYNOS9630_BTS
 #include <soc/samsung/bts.h>
@@ -643,6 +646,24 @@ int gpu_dvfs_get_utilization(void)
 	return util;
 }
 
+/* dynamic power in mW that the work of the last period draws while the GPU
+ * is busy at @clock (kHz), from the IPA counter model
+ */
+int gpu_dvfs_get_busy_power(int clock, u32 *power)
+{
+#ifdef CONFIG_MALI_EXYNOS_IPA_COUNTERS
+	int voltage = gpu_dvfs_get_voltage(clock);
+
+	if (voltage <= 0)
+		return -EINVAL;
+
+	return kbase_ipa_get_busy_power(pkbdev, power, clock * 1000UL,
+			voltage / 1000);
+#else
+	return -ENODEV;
+#endif /* CONFIG_MALI_EXYNOS_IPA_COUNTERS */
+}
+
 int gpu_dvfs_get_max_freq(void)
 {
 	struct kbase_device *kbdev = pkbdev;
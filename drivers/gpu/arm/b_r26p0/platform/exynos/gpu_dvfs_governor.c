@@ -33,6 +33,9 @@ static int gpu_dvfs_governor_interactive(struct exynos_context *platform, int ut
 static int gpu_dvfs_governor_static(struct exynos_context *platform, int utilization);
 static int gpu_dvfs_governor_booster(struct exynos_context *platform, int utilization);
 static int gpu_dvfs_governor_dynamic(struct exynos_context *platform, int utilization);
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+static int gpu_dvfs_governor_frame(struct exynos_context *platform, int utilization);
+#endif
 
 static gpu_dvfs_governor_info governor_info[G3D_MAX_GOVERNOR_NUM] = {
 	{
@@ -65,6 +68,14 @@ static gpu_dvfs_governor_info governor_info[G3D_MAX_GOVERNOR_NUM] = {
 		gpu_dvfs_governor_dynamic,
 		NULL
 	},
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+	{
+		G3D_DVFS_GOVERNOR_FRAME,
+		"Frame",
+		gpu_dvfs_governor_frame,
+		NULL
+	},
+#endif
 };
 
 void gpu_dvfs_update_start_clk(int governor_type, int clk)
@@ -285,6 +296,119 @@ static int gpu_dvfs_governor_dynamic(struct exynos_context *platform, int utiliz
 	return 0;
 }
 
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+extern int decon_register_vsync_notifier(struct notifier_block *nb);
+
+/* called from the job slot irq, for every job that ran on the GPU */
+void gpu_dvfs_frame_job_done(void *dev, void *atom, u64 ns_spent)
+{
+	struct kbase_device *kbdev = (struct kbase_device *)dev;
+	struct kbase_jd_atom *katom = (struct kbase_jd_atom *)atom;
+	struct exynos_context *platform = (struct exynos_context *)kbdev->platform_context;
+	u64 work = ns_spent * platform->cur_clock;
+	unsigned long flags;
+
+	spin_lock_irqsave(&platform->frame.lock, flags);
+	/* fragment jobs overlap with vertex and compute, keep them apart */
+	if (katom->core_req & BASE_JD_REQ_FS) {
+		platform->frame.frag_ns += ns_spent;
+		platform->frame.frag_work += work;
+	} else {
+		platform->frame.other_ns += ns_spent;
+		platform->frame.other_work += work;
+	}
+	spin_unlock_irqrestore(&platform->frame.lock, flags);
+}
+
+static int gpu_dvfs_frame_vsync(struct notifier_block *nb, unsigned long action, void *data)
+{
+	struct kbase_device *kbdev = gpu_get_device_structure();
+	struct exynos_context *platform = (struct exynos_context *)kbdev->platform_context;
+	ktime_t timestamp = *(ktime_t *)data;
+	unsigned long flags;
+	u64 delta, busy_ns, work;
+
+	spin_lock_irqsave(&platform->frame.lock, flags);
+	delta = ktime_to_ns(ktime_sub(timestamp, platform->frame.last_vsync));
+	platform->frame.last_vsync = timestamp;
+	if (delta < GPU_FRAME_MAX_PERIOD_NS)
+		platform->frame.period_ns = platform->frame.period_ns ?
+			(3 * platform->frame.period_ns + delta) >> 2 : delta;
+
+	busy_ns = max(platform->frame.frag_ns, platform->frame.other_ns);
+	work = max(platform->frame.frag_work, platform->frame.other_work);
+
+	/* vsyncs without GPU work are kept too, so an idle GPU clocks down */
+	platform->frame.work[platform->frame.head] = work;
+	platform->frame.head = (platform->frame.head + 1) % GPU_FRAME_HISTORY;
+	if (work) {
+		platform->frame.frames++;
+		if (platform->frame.period_ns && busy_ns > platform->frame.period_ns)
+			platform->frame.missed++;
+	}
+
+	platform->frame.frag_ns = 0;
+	platform->frame.frag_work = 0;
+	platform->frame.other_ns = 0;
+	platform->frame.other_work = 0;
+	spin_unlock_irqrestore(&platform->frame.lock, flags);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block gpu_dvfs_frame_vsync_nb = {
+	.notifier_call = gpu_dvfs_frame_vsync,
+};
+
+/*
+ * The heaviest frame of the last GPU_FRAME_HISTORY vsyncs must finish in
+ * GPU_FRAME_HEADROOM percent of the refresh period, pick the lowest clock
+ * that does it. Without vsyncs there is no deadline to meet, follow the
+ * utilization as the interactive governor does.
+ */
+static int gpu_dvfs_governor_frame(struct exynos_context *platform, int utilization)
+{
+	int max_clock_lev = gpu_dvfs_get_level(platform->gpu_max_clock);
+	int min_clock_lev = gpu_dvfs_get_level(platform->gpu_min_clock);
+	u64 period_ns, idle_ns, work = 0, need;
+	int i;
+
+	DVFS_ASSERT(platform);
+
+	/* gpu_dvfs_spinlock is held with irqs off */
+	spin_lock(&platform->frame.lock);
+	period_ns = platform->frame.period_ns;
+	idle_ns = ktime_to_ns(ktime_sub(ktime_get(), platform->frame.last_vsync));
+	for (i = 0; i < GPU_FRAME_HISTORY; i++)
+		work = max(work, platform->frame.work[i]);
+	spin_unlock(&platform->frame.lock);
+
+	if (!period_ns || idle_ns > GPU_FRAME_MAX_PERIOD_NS)
+		return gpu_dvfs_governor_interactive(platform, utilization);
+
+	/* in kHz, as the table is */
+	need = div64_u64(work * 100, period_ns * GPU_FRAME_HEADROOM);
+
+	platform->step = max_clock_lev;
+	for (i = min_clock_lev; i > max_clock_lev; i--) {
+		if (platform->table[i].clock >= need) {
+			platform->step = i;
+			break;
+		}
+	}
+
+	if (platform->table[platform->step].clock > platform->gpu_max_clock_limit)
+		platform->step = gpu_dvfs_get_level(platform->gpu_max_clock_limit);
+
+	platform->down_requirement = platform->table[platform->step].down_staycount;
+
+	DVFS_ASSERT((platform->step >= gpu_dvfs_get_level(platform->gpu_max_clock))
+					&& (platform->step <= gpu_dvfs_get_level(platform->gpu_min_clock)));
+
+	return 0;
+}
+#endif /* CONFIG_MALI_DVFS_FRAME_GOVERNOR */
+
 static int gpu_dvfs_decide_next_governor(struct exynos_context *platform)
 {
 	return 0;
@@ -370,6 +494,10 @@ int gpu_dvfs_governor_init(struct kbase_device *kbdev)
 #ifdef CONFIG_MALI_DVFS
 	governor_type = platform->governor_type;
 #endif /* CONFIG_MALI_DVFS */
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+	spin_lock_init(&platform->frame.lock);
+	decon_register_vsync_notifier(&gpu_dvfs_frame_vsync_nb);
+#endif /* CONFIG_MALI_DVFS_FRAME_GOVERNOR */
 	if (gpu_dvfs_governor_setting(platform, governor_type) < 0) {
 		GPU_LOG(DVFS_WARNING, DUMMY, 0u, 0u, "%s: fail to initialize governor\n", __func__);
 		return -1;
@@ -24,6 +24,9 @@ typedef enum {
 	G3D_DVFS_GOVERNOR_STATIC,
 	G3D_DVFS_GOVERNOR_BOOSTER,
 	G3D_DVFS_GOVERNOR_DYNAMIC,
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+	G3D_DVFS_GOVERNOR_FRAME,
+#endif
 	G3D_MAX_GOVERNOR_NUM,
 } gpu_governor_type;
 
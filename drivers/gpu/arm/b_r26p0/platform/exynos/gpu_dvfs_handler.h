@@ -59,6 +59,7 @@ int gpu_dvfs_get_clock(int level);
 int gpu_dvfs_get_step(void);
 int gpu_dvfs_get_cur_clock(void);
 int gpu_dvfs_get_utilization(void);
+int gpu_dvfs_get_busy_power(int clock, u32 *power);
 int gpu_dvfs_get_max_freq(void);
 
 int gpu_dvfs_decide_max_clock(struct exynos_context *platform);
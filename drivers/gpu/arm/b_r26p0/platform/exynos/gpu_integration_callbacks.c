@@ -84,6 +84,10 @@ extern struct pm_qos_request exynos5_g3d_mif_min_qos;
 
 extern int gpu_register_dump(void);
 
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+extern void gpu_dvfs_frame_job_done(void *dev, void *atom, u64 ns_spent);
+#endif
+
 void gpu_create_context(void *ctx)
 {
 #if MALI_SEC_PROBE_TEST != 1
@@ -686,6 +690,11 @@ struct kbase_vendor_callbacks exynos_callbacks = {
 	.cl_boost_init = NULL,
 	.cl_boost_update_utilization = NULL,
 #endif
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+	.dvfs_job_done = gpu_dvfs_frame_job_done,
+#else
+	.dvfs_job_done = NULL,
+#endif
 #if defined(CONFIG_SOC_EXYNOS7420) || defined(CONFIG_SOC_EXYNOS7890)
 	.init_hw = exynos_gpu_init_hw,
 #else
@@ -48,6 +48,13 @@ do { \
 #define DVFS_TABLE_ROW_MAX 20
 #define OF_DATA_NUM_MAX 160
 
+/* vsyncs the frame governor looks back over, about 130ms at 60Hz */
+#define GPU_FRAME_HISTORY 8
+/* percent of the refresh period the GPU work of a frame may take */
+#define GPU_FRAME_HEADROOM 85
+/* longer gaps are an idle display, not a refresh period */
+#define GPU_FRAME_MAX_PERIOD_NS (50 * NSEC_PER_MSEC)
+
 typedef enum {
 	DVFS_DEBUG_START = 0,
 	DVFS_DEBUG,
@@ -212,6 +219,26 @@ struct exynos_context {
 		int eureka_gpu_highspeed_clock;
 		int eureka_gpu_highspeed_load;
 	} interactive;
+#ifdef CONFIG_MALI_DVFS_FRAME_GOVERNOR
+	/*
+	 * For the frame governor, GPU work is kept in ns * kHz, the time a job
+	 * ran times the clock it ran at. Protected by frame.lock.
+	 */
+	struct {
+		spinlock_t lock;
+		ktime_t last_vsync;
+		u64 period_ns;
+		/* jobs done since the last vsync, fragment and the others */
+		u64 frag_ns;
+		u64 frag_work;
+		u64 other_ns;
+		u64 other_work;
+		u64 work[GPU_FRAME_HISTORY];
+		int head;
+		unsigned long frames;
+		unsigned long missed;
+	} frame;
+#endif /* CONFIG_MALI_DVFS_FRAME_GOVERNOR */
 #ifdef CONFIG_CPU_THERMAL_IPA
 	int norm_utilisation;
 	int freq_for_normalisation;
@@ -16,6 +16,7 @@
 #define EVDEV_BUF_PACKETS	8
 
 #include <linux/poll.h>
+#include <linux/hrtimer.h>
 #include <linux/sched.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
@@ -47,6 +48,9 @@ struct evdev {
 	struct device dev;
 	struct cdev cdev;
 	bool exist;
+	/* reader wakeups done and held back by coalescing clients */
+	atomic_long_t wakeups;
+	atomic_long_t wakeups_saved;
 };
 
 struct evdev_client {
@@ -59,6 +63,11 @@ struct evdev_client {
 	struct list_head node;
 	unsigned int clk_type;
 	bool revoked;
+	/* wakeup coalescing, see struct input_coalesce */
+	u32 coalesce_ns;
+	unsigned int coalesce_packets;
+	unsigned int pending_packets;
+	struct hrtimer coalesce_timer;
 	unsigned long *evmasks[EV_CNT];
 	unsigned int bufsize;
 	struct input_event buffer[];
@@ -252,8 +261,90 @@ static void __pass_event(struct evdev_client *client,
 
 	if (event->type == EV_SYN && event->code == SYN_REPORT) {
 		client->packet_head = client->head;
+		if (!client->coalesce_ns)
+			kill_fasync(&client->fasync, SIGIO, POLL_IN);
+	}
+}
+
+/*
+ * Decide whether a coalescing client is woken for the report just queued,
+ * and if not, make sure the timer will. Caller must hold client->buffer_lock.
+ */
+static bool __evdev_coalesce_wakeup(struct evdev_client *client, bool urgent)
+{
+	u64 now, next;
+
+	client->pending_packets++;
+	if (urgent || (client->coalesce_packets &&
+		       client->pending_packets >= client->coalesce_packets)) {
+		client->pending_packets = 0;
+		hrtimer_try_to_cancel(&client->coalesce_timer);
+		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+		return true;
+	}
+
+	atomic_long_inc(&client->evdev->wakeups_saved);
+	if (!hrtimer_is_queued(&client->coalesce_timer)) {
+		now = ktime_get_ns();
+		next = now + client->coalesce_ns;
+		next -= do_div(now, client->coalesce_ns);
+		hrtimer_start(&client->coalesce_timer, ns_to_ktime(next),
+			      HRTIMER_MODE_ABS);
+	}
+
+	return false;
+}
+
+static enum hrtimer_restart evdev_coalesce_timer(struct hrtimer *timer)
+{
+	struct evdev_client *client =
+		container_of(timer, struct evdev_client, coalesce_timer);
+	unsigned long flags;
+	bool wakeup;
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	wakeup = client->pending_packets != 0;
+	client->pending_packets = 0;
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	if (wakeup) {
+		/* one of the held back wakeups is done after all */
+		atomic_long_dec(&client->evdev->wakeups_saved);
+		atomic_long_inc(&client->evdev->wakeups);
 		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+		wake_up_interruptible(&client->evdev->wait);
 	}
+
+	return HRTIMER_NORESTART;
+}
+
+static int evdev_set_coalesce(struct evdev_client *client,
+			      const struct input_coalesce *coalesce)
+{
+	unsigned long flags;
+	bool wakeup;
+
+	if (coalesce->interval_us > USEC_PER_SEC)
+		return -EINVAL;
+
+	/* flush what the old settings held back */
+	hrtimer_cancel(&client->coalesce_timer);
+
+	spin_lock_irqsave(&client->buffer_lock, flags);
+	client->coalesce_ns = coalesce->interval_us * NSEC_PER_USEC;
+	client->coalesce_packets = coalesce->max_packets;
+	wakeup = client->pending_packets != 0;
+	client->pending_packets = 0;
+	spin_unlock_irqrestore(&client->buffer_lock, flags);
+
+	if (wakeup) {
+		atomic_long_dec(&client->evdev->wakeups_saved);
+		atomic_long_inc(&client->evdev->wakeups);
+		kill_fasync(&client->fasync, SIGIO, POLL_IN);
+		wake_up_interruptible(&client->evdev->wait);
+	}
+
+	return 0;
 }
 
 static void evdev_pass_values(struct evdev_client *client,
@@ -264,6 +355,7 @@ static void evdev_pass_values(struct evdev_client *client,
 	const struct input_value *v;
 	struct input_event event;
 	bool wakeup = false;
+	bool urgent = false;
 
 	if (client->revoked)
 		return;
@@ -283,6 +375,8 @@ static void evdev_pass_values(struct evdev_client *client,
 				continue;
 
 			wakeup = true;
+		} else if (v->type == EV_KEY || v->type == EV_SW) {
+			urgent = true;
 		}
 
 		event.type = v->type;
@@ -291,10 +385,15 @@ static void evdev_pass_values(struct evdev_client *client,
 		__pass_event(client, &event);
 	}
 
+	if (wakeup && client->coalesce_ns)
+		wakeup = __evdev_coalesce_wakeup(client, urgent);
+
 	spin_unlock(&client->buffer_lock);
 
-	if (wakeup)
+	if (wakeup) {
+		atomic_long_inc(&evdev->wakeups);
 		wake_up_interruptible(&evdev->wait);
+	}
 }
 
 /*
@@ -464,6 +563,7 @@ static int evdev_release(struct inode *inode, struct file *file)
 	mutex_unlock(&evdev->mutex);
 
 	evdev_detach_client(evdev, client);
+	hrtimer_cancel(&client->coalesce_timer);
 
 	for (i = 0; i < EV_CNT; ++i)
 		kfree(client->evmasks[i]);
@@ -501,6 +601,8 @@ static int evdev_open(struct inode *inode, struct file *file)
 
 	client->bufsize = bufsize;
 	spin_lock_init(&client->buffer_lock);
+	hrtimer_init(&client->coalesce_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	client->coalesce_timer.function = evdev_coalesce_timer;
 	client->evdev = evdev;
 	evdev_attach_client(evdev, client);
 
@@ -1146,6 +1248,15 @@ static long evdev_do_ioctl(struct file *file, unsigned int cmd,
 
 		return evdev_set_clk_type(client, i);
 
+	case EVIOCSCOALESCE: {
+		struct input_coalesce coalesce;
+
+		if (copy_from_user(&coalesce, p, sizeof(coalesce)))
+			return -EFAULT;
+
+		return evdev_set_coalesce(client, &coalesce);
+	}
+
 	case EVIOCGKEYCODE:
 		return evdev_handle_get_keycode(dev, p);
 
@@ -1357,6 +1468,22 @@ static void evdev_cleanup(struct evdev *evdev)
  * Create new evdev device. Note that input core serializes calls
  * to connect and disconnect.
  */
+static ssize_t wakeups_show(struct device *dev,
+			    struct device_attribute *attr, char *buf)
+{
+	struct evdev *evdev = container_of(dev, struct evdev, dev);
+
+	return sprintf(buf, "%ld %ld\n", atomic_long_read(&evdev->wakeups),
+		       atomic_long_read(&evdev->wakeups_saved));
+}
+static DEVICE_ATTR_RO(wakeups);
+
+static struct attribute *evdev_attrs[] = {
+	&dev_attr_wakeups.attr,
+	NULL,
+};
+ATTRIBUTE_GROUPS(evdev);
+
 static int evdev_connect(struct input_handler *handler, struct input_dev *dev,
 			 const struct input_device_id *id)
 {
@@ -1399,6 +1526,7 @@ static int evdev_connect(struct input_handler *handler, struct input_dev *dev,
 	evdev->dev.class = &input_class;
 	evdev->dev.parent = &dev->dev;
 	evdev->dev.release = evdev_free;
+	evdev->dev.groups = evdev_groups;
 	device_initialize(&evdev->dev);
 
 	error = input_register_handle(&evdev->handle);
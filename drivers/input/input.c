@@ -425,18 +425,6 @@ static void input_handle_event(struct input_dev *dev,
 }
 
 #if !defined(CONFIG_INPUT_BOOSTER) // Input Booster +
-// ********** Define Timeout Functions ********** //
-DECLARE_TIMEOUT_FUNC(touch);
-DECLARE_TIMEOUT_FUNC(multitouch);
-DECLARE_TIMEOUT_FUNC(key);
-DECLARE_TIMEOUT_FUNC(touchkey);
-DECLARE_TIMEOUT_FUNC(keyboard);
-DECLARE_TIMEOUT_FUNC(mouse);
-DECLARE_TIMEOUT_FUNC(mouse_wheel);
-DECLARE_TIMEOUT_FUNC(pen);
-DECLARE_TIMEOUT_FUNC(hover);
-DECLARE_TIMEOUT_FUNC(key_two);
-
 // ********** Define Set Booster Functions ********** //
 DECLARE_SET_BOOSTER_FUNC(touch);
 DECLARE_SET_BOOSTER_FUNC(multitouch);
@@ -461,27 +449,223 @@ DECLARE_RESET_BOOSTER_FUNC(pen);
 DECLARE_RESET_BOOSTER_FUNC(hover);
 DECLARE_RESET_BOOSTER_FUNC(key_two);
 
+// ********** Boost Arbiter ********** //
+int input_booster_add_source(const char *name)
+{
+	struct t_input_booster_arbiter *arb = &input_booster_arbiter;
+
+	if (arb->nsources >= INPUT_BOOSTER_MAX_SOURCES) {
+		pr_err("[Input Booster] too many sources, %s not boosted\n", name);
+		return -1;
+	}
+	arb->source[arb->nsources].name = name;
+	return arb->nsources++;
+}
+
+static bool input_booster_source_active(struct t_input_booster_source *src)
+{
+	int slot;
+
+	for (slot = 0; slot < INPUT_BOOSTER_SLOTS; slot++)
+		if (src->req[slot].active)
+			return true;
+	return false;
+}
+
+/* called with arb->lock held whenever a request of @src is changed */
+static void input_booster_account(struct t_input_booster_source *src,
+				  bool was_active, ktime_t now)
+{
+	bool active = input_booster_source_active(src);
+
+	if (!was_active && active) {
+		src->active_since = now;
+		src->count++;
+	} else if (was_active && !active) {
+		src->residency_ns += ktime_to_ns(ktime_sub(now, src->active_since));
+	}
+}
+
+/* drop requests past their deadline and arm the timer for the next one */
+static void input_booster_expire(struct t_input_booster_arbiter *arb,
+				 ktime_t now)
+{
+	ktime_t next = ktime_set(KTIME_SEC_MAX, 0);
+	bool timed = false;
+	int i, slot;
+
+	for (i = 0; i < arb->nsources; i++) {
+		struct t_input_booster_source *src = &arb->source[i];
+		bool was_active = input_booster_source_active(src);
+
+		for (slot = 0; slot < INPUT_BOOSTER_SLOTS; slot++) {
+			struct t_input_booster_request *req = &src->req[slot];
+
+			if (!req->active || req->held)
+				continue;
+			if (ktime_compare(req->deadline, now) <= 0) {
+				req->active = false;
+			} else if (ktime_before(req->deadline, next)) {
+				next = req->deadline;
+				timed = true;
+			}
+		}
+		input_booster_account(src, was_active, now);
+	}
+
+	if (timed)
+		hrtimer_start(&arb->release_timer, next, HRTIMER_MODE_ABS);
+	else
+		hrtimer_try_to_cancel(&arb->release_timer);
+}
+
+/*
+ * Ask @param for @ms milliseconds from now on behalf of @source, for as long
+ * as it is not changed with INPUT_BOOSTER_HOLD, or drop the request with 0.
+ */
+void input_booster_arbiter_set(int source, int slot,
+			       const struct t_input_booster_param *param, int ms)
+{
+	struct t_input_booster_arbiter *arb = &input_booster_arbiter;
+	struct t_input_booster_source *src;
+	struct t_input_booster_request *req;
+	unsigned long flags;
+	bool was_active;
+	ktime_t now;
+
+	if (source < 0 || source >= arb->nsources)
+		return;
+
+	spin_lock_irqsave(&arb->lock, flags);
+	now = ktime_get();
+	src = &arb->source[source];
+	req = &src->req[slot];
+	was_active = input_booster_source_active(src);
+	if (ms) {
+		req->param = *param;
+		req->held = (ms == INPUT_BOOSTER_HOLD);
+		if (!req->held)
+			req->deadline = ktime_add_ms(now, ms);
+		req->active = true;
+	} else {
+		req->active = false;
+	}
+	input_booster_account(src, was_active, now);
+	input_booster_expire(arb, now);
+	spin_unlock_irqrestore(&arb->lock, flags);
+
+	schedule_work(&arb->apply_work);
+}
+
+void input_booster_arbiter_release(int source)
+{
+	input_booster_arbiter_set(source, INPUT_BOOSTER_SLOT_HEAD, NULL, 0);
+	input_booster_arbiter_set(source, INPUT_BOOSTER_SLOT_TAIL, NULL, 0);
+}
+
+static enum hrtimer_restart input_booster_release_timer_func(struct hrtimer *timer)
+{
+	struct t_input_booster_arbiter *arb = &input_booster_arbiter;
+	unsigned long flags;
+
+	spin_lock_irqsave(&arb->lock, flags);
+	input_booster_expire(arb, ktime_get());
+	spin_unlock_irqrestore(&arb->lock, flags);
+
+	/* PM QoS requests may sleep */
+	schedule_work(&arb->apply_work);
+
+	return HRTIMER_NORESTART;
+}
+
+static void input_booster_apply_work_func(struct work_struct *work)
+{
+	struct t_input_booster_arbiter *arb = &input_booster_arbiter;
+	struct t_input_booster_param sum;
+	unsigned long flags;
+	int i, slot;
+
+	memset(&sum, 0, sizeof(sum));
+	spin_lock_irqsave(&arb->lock, flags);
+	for (i = 0; i < arb->nsources; i++) {
+		for (slot = 0; slot < INPUT_BOOSTER_SLOTS; slot++) {
+			struct t_input_booster_request *req = &arb->source[i].req[slot];
+
+			if (!req->active)
+				continue;
+			sum.cpu_freq = max(sum.cpu_freq, req->param.cpu_freq);
+			sum.kfc_freq = max(sum.kfc_freq, req->param.kfc_freq);
+			sum.mif_freq = max(sum.mif_freq, req->param.mif_freq);
+			sum.int_freq = max(sum.int_freq, req->param.int_freq);
+			sum.gpu_freq = max(sum.gpu_freq, req->param.gpu_freq);
+			sum.hmp_boost = max(sum.hmp_boost, req->param.hmp_boost);
+		}
+	}
+	spin_unlock_irqrestore(&arb->lock, flags);
+
+	pr_debug("[Input Booster] %s      apply cpu : %u, kfc : %u, mif : %u, int : %u, gpu : %u, hmp : %u\n",
+		 glGage, sum.cpu_freq, sum.kfc_freq, sum.mif_freq, sum.int_freq, sum.gpu_freq, sum.hmp_boost);
+	SET_BOOSTER(sum);
+}
+
+static void input_booster_arbiter_init(void)
+{
+	struct t_input_booster_arbiter *arb = &input_booster_arbiter;
+
+	spin_lock_init(&arb->lock);
+	hrtimer_init(&arb->release_timer, CLOCK_MONOTONIC, HRTIMER_MODE_ABS);
+	arb->release_timer.function = input_booster_release_timer_func;
+	INIT_WORK(&arb->apply_work, input_booster_apply_work_func);
+}
+
+/* boost like the head of a touch, for as long as the launch is reported */
+static int input_booster_app_launch_notifier(struct notifier_block *nb,
+					     unsigned long action, void *data)
+{
+	if (action)
+		input_booster_arbiter_set(launch_booster_source, INPUT_BOOSTER_SLOT_HEAD,
+					  &touch_booster.param[0], launch_booster_max_ms);
+	else
+		input_booster_arbiter_release(launch_booster_source);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block input_booster_app_launch_nb = {
+	.notifier_call = input_booster_app_launch_notifier,
+};
+
+/*
+ * Called from the hard IRQ of a touch controller, before the report has been
+ * read, so the head boost is being applied while the threaded handler runs.
+ * The touch booster takes over once the report reaches input_booster().
+ */
+void input_booster_irq_hint(void)
+{
+	input_booster_arbiter_set(irq_booster_source, INPUT_BOOSTER_SLOT_HEAD,
+				  &touch_booster.param[0], touch_booster.param[0].time);
+}
+EXPORT_SYMBOL(input_booster_irq_hint);
+
 // ********** Define State Functions ********** //
+/*
+ * A press asks for the head parameters for the head time and holds the tail
+ * ones; the release lets the tail run its time from then on.
+ */
 DECLARE_STATE_FUNC(idle)
 {
 	struct t_input_booster *_this = (struct t_input_booster *)(__this);
 	glGage = HEADGAGE;
 	if(input_booster_event == BOOSTER_ON) {
-		int i;
-		pr_debug("[Input Booster] %s      State0 : Idle  index : %d, hmp : %d, cpu : %d, time : %d, input_booster_event : %d\n", glGage, _this->index, _this->param[_this->index].hmp_boost, _this->param[_this->index].cpu_freq, _this->param[_this->index].time, input_booster_event);
-		_this->index=0;
-		for(i=0;i<2;i++) {
-			if(delayed_work_pending(&_this->input_booster_timeout_work[i])) {
-				pr_debug("[Input Booster] ****             cancel the pending workqueue\n");
-				cancel_delayed_work(&_this->input_booster_timeout_work[i]);
-			}
-		}
-		SET_BOOSTER;
-		schedule_delayed_work(&_this->input_booster_timeout_work[_this->index], msecs_to_jiffies(_this->param[_this->index].time));
-		_this->index++;
+		pr_debug("[Input Booster] %s      State0 : Idle  hmp : %d, cpu : %d, time : %d, input_booster_event : %d\n", glGage, _this->param[0].hmp_boost, _this->param[0].cpu_freq, _this->param[0].time, input_booster_event);
+		input_booster_arbiter_set(_this->source, INPUT_BOOSTER_SLOT_HEAD,
+					  &_this->param[0], _this->param[0].time);
+		input_booster_arbiter_set(_this->source, INPUT_BOOSTER_SLOT_TAIL,
+					  &_this->param[1],
+					  _this->param[1].time ? INPUT_BOOSTER_HOLD : 0);
 		CHANGE_STATE_TO(press);
 	} else if(input_booster_event == BOOSTER_OFF) {
-		pr_debug("[Input Booster] %s      Skipped  index : %d, hmp : %d, cpu : %d, input_booster_event : %d\n", glGage, _this->index, _this->param[_this->index].hmp_boost, _this->param[_this->index].cpu_freq, input_booster_event);
+		pr_debug("[Input Booster] %s      Skipped  hmp : %d, cpu : %d, input_booster_event : %d\n", glGage, _this->param[0].hmp_boost, _this->param[0].cpu_freq, input_booster_event);
 		pr_debug("\n");
 	}
 }
@@ -492,37 +676,15 @@ DECLARE_STATE_FUNC(press)
 	glGage = TAILGAGE;
 
 	if(input_booster_event == BOOSTER_OFF) {
-		pr_debug("[Input Booster] %s      State : Press  index : %d, time : %d\n", glGage, _this->index, _this->param[_this->index].time);
-		if(_this->multi_events <= 0 && _this->index < 2) {
-			if(delayed_work_pending(&_this->input_booster_timeout_work[(_this->index) ? _this->index-1 : 0]) || (_this->param[(_this->index) ? _this->index-1 : 0].time == 0)) {
-				if(_this->change_on_release || (_this->param[(_this->index) ? _this->index-1 : 0].time == 0)) {
-					pr_debug("[Input Booster] %s           cancel the pending workqueue\n", glGage);
-					cancel_delayed_work(&_this->input_booster_timeout_work[(_this->index) ? _this->index-1 : 0]);
-					SET_BOOSTER;
-				}
-				schedule_delayed_work(&_this->input_booster_timeout_work[_this->index], msecs_to_jiffies(_this->param[_this->index].time));
-				pr_debug("[Input Booster] %s           schedule_delayed_work again  time : %d\n", glGage, _this->param[_this->index].time);
-				if(!delayed_work_pending(&_this->input_booster_timeout_work[_this->index]) && _this->param[_this->index].time > 0) {
-					pr_debug("[Input Booster] %s           schedule_delayed_work Re-again time : %d\n", glGage, _this->param[(_this->index > 0) ? _this->index-1 : _this->index].time);
-					schedule_delayed_work(&_this->input_booster_timeout_work[(_this->index > 0) ? _this->index-1 : _this->index], msecs_to_jiffies(_this->param[(_this->index > 0) ? _this->index-1 : _this->index].time));
-				}
-			} else if(_this->param[_this->index].time > 0) {
-				schedule_delayed_work(&_this->input_booster_timeout_work[_this->index], msecs_to_jiffies(_this->param[_this->index].time));
-			} else {
-				schedule_delayed_work(&_this->input_booster_timeout_work[(_this->index) ? _this->index-1 : 0], msecs_to_jiffies(_this->param[(_this->index > 0) ? _this->index-1 : _this->index].time));
-			}
-			_this->index++;
+		pr_debug("[Input Booster] %s      State : Press  time : %d\n", glGage, _this->param[1].time);
+		if(_this->multi_events <= 0) {
+			input_booster_arbiter_set(_this->source, INPUT_BOOSTER_SLOT_TAIL,
+						  &_this->param[1], _this->param[1].time);
 			_this->multi_events = (_this->multi_events > 0) ? 0 : _this->multi_events;
 			CHANGE_STATE_TO(idle);
 		}
 	} else if(input_booster_event == BOOSTER_ON) {
-		if(delayed_work_pending(&_this->input_booster_timeout_work[_this->index])) {
-			pr_debug("[Input Booster] %s           cancel the pending workqueue for multi events\n", glGage);
-			cancel_delayed_work(&_this->input_booster_timeout_work[_this->index]);
-			schedule_delayed_work(&_this->input_booster_timeout_work[(_this->index) ? _this->index-1 : 0], msecs_to_jiffies(_this->param[(_this->index > 0) ? _this->index-1 : _this->index].time));
-		} else {
-			pr_debug("[Input Booster] %s      State : Press  index : %d, time : %d\n", glGage, _this->index, _this->param[_this->index].time);
-		}
+		pr_debug("[Input Booster] %s      State : Press  multi events : %d\n", glGage, _this->multi_events);
 	}
 }
 
@@ -627,18 +789,6 @@ void input_booster(struct input_dev *dev)
 								pr_debug("[Input Booster] MULTI-TOUCH EVENT - PRESS - ID: 0x%x, Slot: 0x%x, multi : %d\n", input_events[iTouchID].value, input_events[iTouchSlot].value, touch_booster.multi_events);
 								touch_booster.multi_events++;
 								RUN_BOOSTER(multitouch, BOOSTER_ON );
-/*
-								if(delayed_work_pending(&touch_booster.input_booster_timeout_work[0])) {
-									int temp_hmp_boost = touch_booster.param[0].hmp_boost, temp_index = touch_booster.index;
-									pr_debug("[Input Booster] ****             cancel the pending touch booster workqueue\n");
-									cancel_delayed_work(&touch_booster.input_booster_timeout_work[0]);
-									touch_booster.param[0].hmp_boost = multitouch_booster.param[0].hmp_boost;
-									touch_booster.index = 1;
-									TIMEOUT_FUNC(touch)(NULL);
-									touch_booster.param[0].hmp_boost = temp_hmp_boost;
-									touch_booster.index = ( temp_index >= 2 ? 1 : temp_index );
-								}
-*/
 							}
 						} else if(TouchIDs[input_events[iTouchSlot].value] >= 0 && input_events[iTouchID].value < 0) {
 							TouchIDs[input_events[iTouchSlot].value] = input_events[iTouchID].value;
@@ -701,6 +851,35 @@ void input_booster(struct input_dev *dev)
 	}
 }
 
+// ********** Residency ********** //
+/* per source: times boosted and total time boosted so far, in ms */
+static ssize_t input_booster_sysfs_class_show_residency(struct class *dev, struct class_attribute *attr, char *buf)
+{
+	struct t_input_booster_arbiter *arb = &input_booster_arbiter;
+	unsigned long flags;
+	ssize_t ret = 0;
+	ktime_t now;
+	int i;
+
+	spin_lock_irqsave(&arb->lock, flags);
+	now = ktime_get();
+	for (i = 0; i < arb->nsources; i++) {
+		struct t_input_booster_source *src = &arb->source[i];
+		u64 ns = src->residency_ns;
+		bool active = input_booster_source_active(src);
+
+		if (active)
+			ns += ktime_to_ns(ktime_sub(now, src->active_since));
+		ret += scnprintf(buf + ret, PAGE_SIZE - ret, "%s%s: %lu %llu\n",
+				 src->name, active ? "*" : "", src->count,
+				 div_u64(ns, NSEC_PER_MSEC));
+	}
+	spin_unlock_irqrestore(&arb->lock, flags);
+
+	return ret;
+}
+static CLASS_ATTR(residency, S_IRUGO, input_booster_sysfs_class_show_residency, NULL);
+
 // ********** Init Booster ********** //
 void input_booster_init(void)
 {
@@ -783,12 +962,16 @@ void input_booster_init(void)
 				if (err) {
 					printk("Failed to get [%d] param table property\n", i);
 				}
+				// optional, the GPU is not boosted without it
+				if (of_property_read_u32_index(cnp, "input_booster,gpu_freqs", i, &dt_infor->param_tables[i].gpu_freq))
+					dt_infor->param_tables[i].gpu_freq = 0;
 
-				printk("[Input Booster] Level %d : frequency[%d,%d,%d,%d] hmp_boost[%d] times[%d,%d,%d]\n", i,
+				printk("[Input Booster] Level %d : frequency[%d,%d,%d,%d,%d] hmp_boost[%d] times[%d,%d,%d]\n", i,
 					dt_infor->param_tables[i].cpu_freq,
 					dt_infor->param_tables[i].kfc_freq,
 					dt_infor->param_tables[i].mif_freq,
 					dt_infor->param_tables[i].int_freq,
+					dt_infor->param_tables[i].gpu_freq,
 					dt_infor->param_tables[i].hmp_boost,
 					dt_infor->param_tables[i].head_time,
 					dt_infor->param_tables[i].tail_time,
@@ -805,6 +988,7 @@ void input_booster_init(void)
 	}
 
 	// ********** Initialize Booster **********
+	input_booster_arbiter_init();
 	INIT_BOOSTER(touch)
 	INIT_BOOSTER(multitouch)
 	INIT_BOOSTER(key)
@@ -815,7 +999,9 @@ void input_booster_init(void)
 	INIT_BOOSTER(pen)
 	INIT_BOOSTER(hover)
 	INIT_BOOSTER(key_two)
-	multitouch_booster.change_on_release = 1;
+	launch_booster_source = input_booster_add_source("launch");
+	irq_booster_source = input_booster_add_source("irq");
+	am_app_launch_notifier_register(&input_booster_app_launch_nb);
 
 	// ********** Initialize Sysfs **********
 	{
@@ -831,6 +1017,7 @@ void input_booster_init(void)
 		INIT_SYSFS_CLASS(head)
 		INIT_SYSFS_CLASS(tail)
 		INIT_SYSFS_CLASS(level)
+		INIT_SYSFS_CLASS(residency)
 
 		INIT_SYSFS_DEVICE(touch)
 		INIT_SYSFS_DEVICE(multitouch)
@@ -24,6 +24,7 @@
 #include <linux/i2c.h>
 #include <linux/platform_data/atmel_mxt_ts.h>
 #include <linux/input/mt.h>
+#include <linux/input/touch_fastpath.h>
 #include <linux/interrupt.h>
 #include <linux/of.h>
 #include <linux/slab.h>
@@ -214,6 +215,7 @@ struct mxt_data {
 	struct mxt_object *object_table;
 	struct mxt_info info;
 	unsigned int irq;
+	struct touch_fastpath fastpath;
 	unsigned int max_x;
 	unsigned int max_y;
 	bool in_bootloader;
@@ -684,6 +686,7 @@ static void mxt_input_sync(struct mxt_data *data)
 	input_mt_report_pointer_emulation(data->input_dev,
 					  data->pdata->t19_num_keys);
 	input_sync(data->input_dev);
+	touch_fastpath_sync(&data->fastpath);
 }
 
 static void mxt_proc_t9_message(struct mxt_data *data, u8 *message)
@@ -2639,9 +2642,10 @@ static int mxt_probe(struct i2c_client *client, const struct i2c_device_id *id)
 	init_completion(&data->reset_completion);
 	init_completion(&data->crc_completion);
 
-	error = request_threaded_irq(client->irq, NULL, mxt_interrupt,
-				     pdata->irqflags | IRQF_ONESHOT,
-				     client->name, data);
+	error = touch_fastpath_request_irq(&data->fastpath, client->irq,
+					   mxt_interrupt,
+					   pdata->irqflags | IRQF_ONESHOT,
+					   client->name, data);
 	if (error) {
 		dev_err(&client->dev, "Failed to register interrupt\n");
 		goto err_free_mem;
@@ -2666,7 +2670,7 @@ err_free_object:
 	mxt_free_input_device(data);
 	mxt_free_object_table(data);
 err_free_irq:
-	free_irq(client->irq, data);
+	touch_fastpath_free_irq(&data->fastpath, client->irq, data);
 err_free_mem:
 	kfree(data);
 	return error;
@@ -2677,7 +2681,7 @@ static int mxt_remove(struct i2c_client *client)
 	struct mxt_data *data = i2c_get_clientdata(client);
 
 	sysfs_remove_group(&client->dev.kobj, &mxt_attr_group);
-	free_irq(data->irq, data);
+	touch_fastpath_free_irq(&data->fastpath, data->irq, data);
 	mxt_free_input_device(data);
 	mxt_free_object_table(data);
 	kfree(data);
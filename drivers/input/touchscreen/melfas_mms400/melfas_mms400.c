@@ -1519,6 +1519,7 @@ static struct i2c_driver mms_driver = {
 	.driver = {
 		.name = MMS_DEVICE_NAME,
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 #if MMS_USE_DEVICETREE
 		.of_match_table = mms_match_table,
 #endif
@@ -1491,7 +1491,7 @@ static int mms_probe(struct i2c_client *client, const struct i2c_device_id *id)
 				VBUS_NOTIFY_DEV_CHARGER);
 #endif
 
-	ret = request_threaded_irq(client->irq, NULL, mms_interrupt,
+	ret = touch_fastpath_request_irq(&info->fastpath, client->irq, mms_interrupt,
 			IRQF_TRIGGER_LOW | IRQF_ONESHOT | IRQF_PERF_CRITICAL, MMS_DEVICE_NAME, info);
 	if (ret) {
 		input_err(true, &client->dev, "%s [ERROR] request_threaded_irq\n", __func__);
@@ -1596,7 +1596,7 @@ err_test_sysfs_create:
 err_test_dev_create:
 #endif
 	mms_disable(info);
-	free_irq(info->irq, info);
+	touch_fastpath_free_irq(&info->fastpath, info->irq, info);
 err_request_irq:
 err_fw_update:
 	mms_power_control(info, 0);
@@ -1644,7 +1644,7 @@ static int mms_remove(struct i2c_client *client)
 	struct mms_ts_info *info = i2c_get_clientdata(client);
 
 	if (info->irq >= 0)
-		free_irq(info->irq, info);
+		touch_fastpath_free_irq(&info->fastpath, info->irq, info);
 
 #if MMS_USE_CMD_MODE
 	mms_sysfs_cmd_remove(info);
@@ -1786,6 +1786,7 @@ static struct i2c_driver mms_driver = {
 	.driver = {
 		.name = MMS_DEVICE_NAME,
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 #if MMS_USE_DEVICETREE
 		.of_match_table = mms_match_table,
 #endif
@@ -22,6 +22,7 @@
 #include <linux/slab.h>
 #include <linux/input.h>
 #include <linux/input/mt.h>
+#include <linux/input/touch_fastpath.h>
 #include <linux/fs.h>
 #include <linux/debugfs.h>
 #include <linux/cdev.h>
@@ -279,6 +280,7 @@ struct mms_ts_info {
 	struct mms_ts_coordinate coord[MAX_FINGER_NUM];
 
 	int irq;
+	struct touch_fastpath fastpath;
 	bool	 enabled;
 	bool init;
 	char *fw_name;
@@ -547,6 +547,7 @@ void mms_input_event_handler(struct mms_ts_info *info, u8 sz, u8 *buf)
 	}
 
 	input_sync(info->input_dev);
+	touch_fastpath_sync(&info->fastpath);
 	input_dbg(false, &client->dev, "%s [DONE]\n", __func__);
 error:
 	return;
@@ -0,0 +1,309 @@
+/*
+ * Low latency interrupt handling for touch controllers
+ *
+ * Touch controllers raise an interrupt and leave the report to be read over
+ * I2C from the threaded handler, which is where most of the latency a user
+ * feels comes from: the IRQ thread runs round robin among the other IRQ
+ * threads, possibly on a little core at a low frequency. Drivers requesting
+ * their interrupt through touch_fastpath_request_irq() get
+ *
+ *  - the time of the hard IRQ recorded, and an input booster hint raised,
+ *    before the thread is even woken,
+ *  - the thread run at SCHED_FIFO, ahead of ordinary IRQ threads, and
+ *    optionally kept on one cluster,
+ *  - the latency from the hard IRQ to the input_sync() of the report, which
+ *    they mark with touch_fastpath_sync(), accounted in a histogram found in
+ *    /sys/kernel/touch_fastpath/latency.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published by
+ * the Free Software Foundation.
+ */
+#include <linux/kernel.h>
+#include <linux/cpumask.h>
+#include <linux/init.h>
+#include <linux/input.h>
+#include <linux/input/touch_fastpath.h>
+#include <linux/kobject.h>
+#include <linux/module.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/sched.h>
+#include <linux/sched/rt.h>
+#include <linux/sysfs.h>
+#include <linux/topology.h>
+
+static LIST_HEAD(touch_fastpath_list);
+static DEFINE_MUTEX(touch_fastpath_mutex);
+
+static bool boost = true;
+module_param(boost, bool, 0644);
+MODULE_PARM_DESC(boost, "Raise the input booster from the hard IRQ");
+
+/* one above the IRQ threads, which run at MAX_USER_RT_PRIO/2 */
+static int rt_prio = MAX_USER_RT_PRIO / 2 + 1;
+/* cluster for the IRQ and its thread, -1 to keep what the driver asked */
+static int cluster = -1;
+/* bumped when rt_prio changes, for the IRQ threads to pick it up */
+static unsigned int touch_fastpath_gen = 1;
+
+static const struct cpumask *touch_fastpath_cluster_mask(int id)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		if (topology_physical_package_id(cpu) == id)
+			return topology_core_cpumask(cpu);
+
+	return NULL;
+}
+
+/* called with touch_fastpath_mutex held */
+static void touch_fastpath_set_affinity(struct touch_fastpath *fp)
+{
+	const struct cpumask *mask = NULL;
+
+	if (cluster >= 0)
+		mask = touch_fastpath_cluster_mask(cluster);
+	irq_set_affinity_hint(fp->irq, mask);
+}
+
+static int rt_prio_set(const char *val, const struct kernel_param *kp)
+{
+	int prio, ret;
+
+	ret = kstrtoint(val, 10, &prio);
+	if (ret)
+		return ret;
+	if (prio < 1 || prio >= MAX_USER_RT_PRIO)
+		return -EINVAL;
+
+	rt_prio = prio;
+	WRITE_ONCE(touch_fastpath_gen, touch_fastpath_gen + 1);
+	return 0;
+}
+
+static const struct kernel_param_ops rt_prio_ops = {
+	.set = rt_prio_set,
+	.get = param_get_int,
+};
+module_param_cb(rt_prio, &rt_prio_ops, &rt_prio, 0644);
+MODULE_PARM_DESC(rt_prio, "SCHED_FIFO priority of touch IRQ threads");
+
+static int cluster_set(const char *val, const struct kernel_param *kp)
+{
+	struct touch_fastpath *fp;
+	int id, ret;
+
+	ret = kstrtoint(val, 10, &id);
+	if (ret)
+		return ret;
+
+	mutex_lock(&touch_fastpath_mutex);
+	cluster = id < 0 ? -1 : id;
+	list_for_each_entry(fp, &touch_fastpath_list, list)
+		touch_fastpath_set_affinity(fp);
+	mutex_unlock(&touch_fastpath_mutex);
+
+	return 0;
+}
+
+static const struct kernel_param_ops cluster_ops = {
+	.set = cluster_set,
+	.get = param_get_int,
+};
+module_param_cb(cluster, &cluster_ops, &cluster, 0644);
+MODULE_PARM_DESC(cluster, "Cluster to handle touch IRQs on, -1 for any");
+
+static irqreturn_t touch_fastpath_hardirq(int irq, void *dev_id)
+{
+	struct touch_fastpath *fp = dev_id;
+
+	fp->irq_time = ktime_get();
+	if (boost)
+		input_booster_irq_hint();
+
+	return IRQ_WAKE_THREAD;
+}
+
+static irqreturn_t touch_fastpath_thread(int irq, void *dev_id)
+{
+	struct touch_fastpath *fp = dev_id;
+	unsigned int gen = READ_ONCE(touch_fastpath_gen);
+	irqreturn_t ret;
+
+	if (unlikely(fp->applied != gen)) {
+		struct sched_param param = { .sched_priority = rt_prio };
+
+		sched_setscheduler_nocheck(current, SCHED_FIFO, &param);
+		fp->applied = gen;
+	}
+
+	ret = fp->thread_fn(irq, fp->dev_id);
+
+	/* not every interrupt is a report, those are not accounted */
+	fp->irq_time.tv64 = 0;
+	return ret;
+}
+
+/**
+ * touch_fastpath_sync - account a report
+ * @fp: the touch device's fast path
+ *
+ * Called by the threaded handler right after the input_sync() of a report,
+ * which is accounted against the hard IRQ that brought it. Reports past the
+ * first of an interrupt are not.
+ */
+void touch_fastpath_sync(struct touch_fastpath *fp)
+{
+	u64 us;
+	int bucket;
+
+	if (!fp->irq_time.tv64)
+		return;
+
+	us = ktime_us_delta(ktime_get(), fp->irq_time);
+	fp->irq_time.tv64 = 0;
+	bucket = min_t(int, fls64(us), TOUCH_FASTPATH_BUCKETS - 1);
+
+	spin_lock(&fp->lock);
+	fp->hist[bucket]++;
+	fp->count++;
+	fp->total_us += us;
+	fp->max_us = max_t(u32, fp->max_us, min_t(u64, us, U32_MAX));
+	spin_unlock(&fp->lock);
+}
+EXPORT_SYMBOL_GPL(touch_fastpath_sync);
+
+/**
+ * touch_fastpath_request_irq - request a touch controller's interrupt
+ * @fp: fast path state, kept by the driver until touch_fastpath_free_irq()
+ * @irq: the interrupt
+ * @thread_fn: threaded handler reading and reporting the touch events
+ * @flags: IRQF_* flags, as for request_threaded_irq()
+ * @name: name of the device, for the IRQ thread and the statistics
+ * @dev_id: passed to @thread_fn
+ *
+ * Works as request_threaded_irq() with no primary handler does.
+ */
+int touch_fastpath_request_irq(struct touch_fastpath *fp, unsigned int irq,
+			       irq_handler_t thread_fn, unsigned long flags,
+			       const char *name, void *dev_id)
+{
+	int ret;
+
+	memset(fp, 0, sizeof(*fp));
+	fp->name = name;
+	fp->irq = irq;
+	fp->thread_fn = thread_fn;
+	fp->dev_id = dev_id;
+	spin_lock_init(&fp->lock);
+
+	ret = request_threaded_irq(irq, touch_fastpath_hardirq,
+				   touch_fastpath_thread, flags, name, fp);
+	if (ret)
+		return ret;
+
+	mutex_lock(&touch_fastpath_mutex);
+	list_add_tail(&fp->list, &touch_fastpath_list);
+	if (cluster >= 0)
+		touch_fastpath_set_affinity(fp);
+	mutex_unlock(&touch_fastpath_mutex);
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(touch_fastpath_request_irq);
+
+void touch_fastpath_free_irq(struct touch_fastpath *fp, unsigned int irq,
+			     void *dev_id)
+{
+	mutex_lock(&touch_fastpath_mutex);
+	list_del(&fp->list);
+	irq_set_affinity_hint(irq, NULL);
+	mutex_unlock(&touch_fastpath_mutex);
+
+	free_irq(irq, fp);
+}
+EXPORT_SYMBOL_GPL(touch_fastpath_free_irq);
+
+/*
+ * sysfs parts below
+ */
+
+/* per device: reports, mean and max latency, then the histogram */
+static ssize_t latency_show(struct kobject *kobj, struct kobj_attribute *attr,
+			    char *buf)
+{
+	unsigned long hist[TOUCH_FASTPATH_BUCKETS];
+	struct touch_fastpath *fp;
+	unsigned long count;
+	u64 total;
+	u32 max;
+	ssize_t len = 0;
+	int i;
+
+	mutex_lock(&touch_fastpath_mutex);
+	list_for_each_entry(fp, &touch_fastpath_list, list) {
+		spin_lock(&fp->lock);
+		memcpy(hist, fp->hist, sizeof(hist));
+		count = fp->count;
+		total = fp->total_us;
+		max = fp->max_us;
+		spin_unlock(&fp->lock);
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%s: reports %lu mean_us %llu max_us %u\n",
+				 fp->name, count,
+				 count ? div64_u64(total, count) : 0, max);
+		for (i = 0; i < TOUCH_FASTPATH_BUCKETS - 1; i++)
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					 "  <%u: %lu\n", 1U << i, hist[i]);
+		len += scnprintf(buf + len, PAGE_SIZE - len, "  >=%u: %lu\n",
+				 1U << (i - 1), hist[i]);
+	}
+	mutex_unlock(&touch_fastpath_mutex);
+
+	return len;
+}
+
+static ssize_t reset_store(struct kobject *kobj, struct kobj_attribute *attr,
+			   const char *buf, size_t count)
+{
+	struct touch_fastpath *fp;
+
+	mutex_lock(&touch_fastpath_mutex);
+	list_for_each_entry(fp, &touch_fastpath_list, list) {
+		spin_lock(&fp->lock);
+		memset(fp->hist, 0, sizeof(fp->hist));
+		fp->count = 0;
+		fp->total_us = 0;
+		fp->max_us = 0;
+		spin_unlock(&fp->lock);
+	}
+	mutex_unlock(&touch_fastpath_mutex);
+
+	return count;
+}
+
+static struct kobj_attribute latency_attr = __ATTR_RO(latency);
+static struct kobj_attribute reset_attr = __ATTR_WO(reset);
+
+static struct attribute *touch_fastpath_attrs[] = {
+	&latency_attr.attr,
+	&reset_attr.attr,
+	NULL,
+};
+
+static struct attribute_group touch_fastpath_attr_group = {
+	.attrs = touch_fastpath_attrs,
+	.name = "touch_fastpath",
+};
+
+static int __init touch_fastpath_init(void)
+{
+	if (sysfs_create_group(kernel_kobj, &touch_fastpath_attr_group))
+		pr_err("touch_fastpath: failed to create sysfs group\n");
+
+	return 0;
+}
+late_initcall(touch_fastpath_init);
@@ -213,6 +213,33 @@ void exynos_sysmmu_tlb_invalidate(struct iommu_domain *iommu_domain,
 	spin_unlock_irqrestore(&domain->lock, flags);
 }
 
+/* for a batch of unmaps too large to invalidate range by range */
+void exynos_sysmmu_tlb_invalidate_all(struct iommu_domain *iommu_domain)
+{
+	struct exynos_iommu_domain *domain = to_exynos_domain(iommu_domain);
+	struct exynos_iommu_owner *owner;
+	struct sysmmu_list_data *list;
+	unsigned long flags;
+
+	spin_lock_irqsave(&domain->lock, flags);
+	list_for_each_entry(owner, &domain->clients_list, client) {
+		list_for_each_entry(list, &owner->sysmmu_list, node) {
+			struct sysmmu_drvdata *drvdata = dev_get_drvdata(list->sysmmu);
+
+			spin_lock(&drvdata->lock);
+			if (is_runtime_active_or_enabled(drvdata) &&
+					is_sysmmu_active(drvdata)) {
+				exynos_ss_printk("TLB invalidation %s: all\n",
+						dev_name(drvdata->sysmmu));
+				__sysmmu_tlb_invalidate_all(drvdata->sfrbase,
+							    drvdata->is_abox);
+			}
+			spin_unlock(&drvdata->lock);
+		}
+	}
+	spin_unlock_irqrestore(&domain->lock, flags);
+}
+
 
 static unsigned int dump_tlb_entry_way_type(void __iomem *sfrbase,
 						int idx_way, int idx_set)
@@ -2007,6 +2034,10 @@ static int __init exynos_iommu_create_domain(void)
 				domain = to_exynos_domain(vmm->domain);
 				vmm->group = iommu_group_alloc();
 				iommu_attach_group(vmm->domain, vmm->group);
+
+				/* the TLB is invalidated on every unmap */
+				vmm->strict = of_property_read_bool(domain_np,
+							"samsung,strict-unmap");
 			}
 			/* Relationship between domain and client is added. */
 			ret = exynos_client_add(np, vmm);
@@ -14,6 +14,9 @@
 #include <linux/kernel.h>
 #include <linux/spinlock.h>
 #include <linux/list.h>
+#include <linux/rbtree.h>
+#include <linux/percpu.h>
+#include <linux/workqueue.h>
 #include <linux/device.h>
 #include <linux/platform_device.h>
 #include <linux/genalloc.h>
@@ -351,11 +354,47 @@ struct sysmmu_drvdata {
 };
 
 struct exynos_vm_region {
-	struct list_head node;
+	union {
+		struct rb_node node;
+		struct list_head flush_node;	/* unmapped, TLB not flushed */
+	};
 	u32 start;
 	u32 size;
 	u32 section_off;
 	u32 dummy_size;
+	bool cacheable;		/* allocated from the bitmap */
+};
+
+/*
+ * Freed iova ranges are kept allocated in the bitmap and cached per cpu,
+ * one magazine per power of two size class, so that the next map of a
+ * similar size reuses them without searching the bitmap.
+ */
+#define IOVMM_RCACHE_MIN_ORDER	6	/* 256KB, the smallest padded region */
+#define IOVMM_RCACHE_CLASSES	9	/* up to 64MB */
+#define IOVMM_RCACHE_MAG_SIZE	8
+
+#define IOVMM_LAT_BUCKETS	12	/* log2 usecs, the last is 1ms and over */
+
+/*
+ * Unless the domain is strict, the TLB is invalidated for unmapped regions
+ * in batches, at most IOVMM_FLUSH_MS after the unmap. Their iova is not
+ * reused until then. Past IOVMM_FLUSH_ALL_THRESHOLD regions, the whole TLB
+ * is invalidated instead of each range.
+ */
+#define IOVMM_FLUSH_MS			10
+#define IOVMM_FLUSH_QUEUE_MAX		64
+#define IOVMM_FLUSH_ALL_THRESHOLD	16
+
+struct iovmm_rcache_mag {
+	int count;
+	u32 index[IOVMM_RCACHE_MAG_SIZE];	/* page index in the bitmap */
+	u32 vsize[IOVMM_RCACHE_MAG_SIZE];	/* pages */
+};
+
+struct iovmm_rcache {
+	spinlock_t lock;
+	struct iovmm_rcache_mag mags[IOVMM_RCACHE_CLASSES];
 };
 
 struct exynos_iovmm {
@@ -363,9 +402,22 @@ struct exynos_iovmm {
 	size_t iovm_size;		/* iovm bitmap size per plane */
 	u32 iova_start;			/* iovm start address per plane */
 	unsigned long *vm_map;		/* iovm biatmap per plane */
-	struct list_head regions_list;	/* list of exynos_vm_region */
-	spinlock_t vmlist_lock;		/* lock for updating regions_list */
+	struct rb_root regions_tree;	/* exynos_vm_region by start */
+	spinlock_t vmlist_lock;		/* lock for updating regions_tree */
 	spinlock_t bitmap_lock;		/* lock for manipulating bitmaps */
+	struct iovmm_rcache __percpu *rcache;
+	atomic_t rcache_hit;
+	atomic_t rcache_miss;
+	atomic_t rcache_flush;
+	atomic_t map_lat[IOVMM_LAT_BUCKETS];
+	bool strict;			/* no deferred TLB invalidation */
+	spinlock_t flush_lock;		/* lock for flush_list */
+	struct list_head flush_list;	/* unmapped regions to invalidate */
+	int flush_cnt;
+	struct delayed_work flush_work;
+	atomic_t flush_batches;
+	atomic_t flush_alls;
+	atomic_t flush_regions;
 	struct device *dev;	/* peripheral device that has this iovmm */
 	size_t allocated_size;
 	int num_areas;
@@ -377,6 +429,7 @@ struct exynos_iovmm {
 
 void exynos_sysmmu_tlb_invalidate(struct iommu_domain *domain, dma_addr_t start,
 				  size_t size);
+void exynos_sysmmu_tlb_invalidate_all(struct iommu_domain *domain);
 int exynos_iommu_map_userptr(struct iommu_domain *dom, unsigned long addr,
 			      dma_addr_t iova, size_t size, int prot);
 void exynos_iommu_unmap_userptr(struct iommu_domain *dom,
@@ -19,6 +19,8 @@
 #include <linux/err.h>
 #include <linux/debugfs.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
 
 #include <linux/exynos_iovmm.h>
 
@@ -26,6 +28,158 @@
 
 #define sg_physically_continuous(sg) (sg_next(sg) == NULL)
 
+static int iovmm_rcache_class(u32 vsize)
+{
+	int class = order_base_2(vsize) - IOVMM_RCACHE_MIN_ORDER;
+
+	return (class >= 0 && class < IOVMM_RCACHE_CLASSES) ? class : -1;
+}
+
+/*
+ * Takes a cached range of at least *vsize pages from this cpu's magazine.
+ * On success *index and *vsize are set to the range taken.
+ */
+static bool iovmm_rcache_get(struct exynos_iovmm *vmm, u32 *index, u32 *vsize)
+{
+	int class = iovmm_rcache_class(*vsize);
+	struct iovmm_rcache *rcache;
+	struct iovmm_rcache_mag *mag;
+	bool found = false;
+	int i;
+
+	if (class < 0)
+		return false;
+
+	rcache = raw_cpu_ptr(vmm->rcache);
+	spin_lock(&rcache->lock);
+	mag = &rcache->mags[class];
+	for (i = mag->count - 1; i >= 0; i--) {
+		if (mag->vsize[i] < *vsize)
+			continue;
+
+		*index = mag->index[i];
+		*vsize = mag->vsize[i];
+		mag->count--;
+		mag->index[i] = mag->index[mag->count];
+		mag->vsize[i] = mag->vsize[mag->count];
+		found = true;
+		break;
+	}
+	spin_unlock(&rcache->lock);
+
+	return found;
+}
+
+/* returns false if the range is to be released to the bitmap instead */
+static bool iovmm_rcache_put(struct exynos_iovmm *vmm, u32 index, u32 vsize)
+{
+	int class = iovmm_rcache_class(vsize);
+	struct iovmm_rcache *rcache;
+	struct iovmm_rcache_mag *mag;
+	bool cached = false;
+
+	if (class < 0)
+		return false;
+
+	rcache = raw_cpu_ptr(vmm->rcache);
+	spin_lock(&rcache->lock);
+	mag = &rcache->mags[class];
+	if (mag->count < IOVMM_RCACHE_MAG_SIZE) {
+		mag->index[mag->count] = index;
+		mag->vsize[mag->count] = vsize;
+		mag->count++;
+		cached = true;
+	}
+	spin_unlock(&rcache->lock);
+
+	return cached;
+}
+
+/* releases the ranges cached by all cpus, returns the number released */
+static int iovmm_rcache_flush(struct exynos_iovmm *vmm)
+{
+	struct iovmm_rcache *rcache;
+	struct iovmm_rcache_mag *mag;
+	int cpu, class, released = 0;
+
+	for_each_possible_cpu(cpu) {
+		rcache = per_cpu_ptr(vmm->rcache, cpu);
+		spin_lock(&rcache->lock);
+		spin_lock(&vmm->bitmap_lock);
+		for (class = 0; class < IOVMM_RCACHE_CLASSES; class++) {
+			mag = &rcache->mags[class];
+			while (mag->count) {
+				mag->count--;
+				bitmap_clear(vmm->vm_map, mag->index[mag->count],
+					     mag->vsize[mag->count]);
+				released++;
+			}
+		}
+		spin_unlock(&vmm->bitmap_lock);
+		spin_unlock(&rcache->lock);
+	}
+
+	if (released)
+		atomic_inc(&vmm->rcache_flush);
+
+	return released;
+}
+
+/*
+ * Regions are indexed by their page aligned start: the page offset of an
+ * allocated region may make it overlap the next one by less than a page.
+ */
+static inline u32 iovm_region_start(struct exynos_vm_region *region)
+{
+	return region->start & PAGE_MASK;
+}
+
+/* caller holds vmlist_lock */
+static struct exynos_vm_region *__find_iovm_region(struct exynos_iovmm *vmm,
+							dma_addr_t iova)
+{
+	struct rb_node *n = vmm->regions_tree.rb_node;
+	struct exynos_vm_region *region;
+
+	while (n) {
+		region = rb_entry(n, struct exynos_vm_region, node);
+		if (iova < iovm_region_start(region))
+			n = n->rb_left;
+		else if (iova >= iovm_region_start(region) + region->size)
+			n = n->rb_right;
+		else
+			return region;
+	}
+
+	return NULL;
+}
+
+/* caller holds vmlist_lock, returns false if @region overlaps another one */
+static bool __insert_iovm_region(struct exynos_iovmm *vmm,
+				 struct exynos_vm_region *region)
+{
+	struct rb_node **p = &vmm->regions_tree.rb_node;
+	struct rb_node *parent = NULL;
+	u32 start = iovm_region_start(region);
+	struct exynos_vm_region *pos;
+
+	while (*p) {
+		parent = *p;
+		pos = rb_entry(parent, struct exynos_vm_region, node);
+		if (start + region->size <= iovm_region_start(pos))
+			p = &parent->rb_left;
+		else if (start >= iovm_region_start(pos) + pos->size)
+			p = &parent->rb_right;
+		else
+			return false;
+	}
+
+	rb_link_node(&region->node, parent, p);
+	rb_insert_color(&region->node, &vmm->regions_tree);
+
+	return true;
+}
+
 /* alloc_iovm_region - Allocate IO virtual memory region
  * vmm: virtual memory allocator
  * size: total size to allocate vm region from @vmm.
@@ -44,7 +198,13 @@
  * constraints: the caller will get the allocated virtual address plus
  * (section_offset + page_offset). Returns 0 if this function is not able
  * to allocate IO virtual memory.
+ *
+ * A range freed earlier with a similar size is reused from the per cpu
+ * cache before the bitmap is searched. The bitmap is searched again after
+ * releasing all unmapped and cached ranges if it has no room.
  */
+static int iovmm_flush_queue(struct exynos_iovmm *vmm);
+
 static dma_addr_t alloc_iovm_region(struct exynos_iovmm *vmm, size_t size,
 			size_t section_offset,
 			off_t page_offset)
@@ -55,6 +215,7 @@ static dma_addr_t alloc_iovm_region(struct exynos_iovmm *vmm, size_t size,
 	unsigned long end, i;
 	struct exynos_vm_region *region;
 	size_t align = SZ_1M;
+	bool flushed = false;
 
 	BUG_ON(page_offset >= PAGE_SIZE);
 
@@ -63,6 +224,13 @@ static dma_addr_t alloc_iovm_region(struct exynos_iovmm *vmm, size_t size,
 	align >>= PAGE_SHIFT;
 	section_offset >>= PAGE_SHIFT;
 
+	/* cached ranges are all aligned by 1MB */
+	if (iovmm_rcache_get(vmm, &index, &vsize)) {
+		atomic_inc(&vmm->rcache_hit);
+		goto found;
+	}
+	atomic_inc(&vmm->rcache_miss);
+
 	spin_lock(&vmm->bitmap_lock);
 again:
 	index = find_next_zero_bit(vmm->vm_map,
@@ -70,10 +238,8 @@ again:
 
 	if (align) {
 		index = ALIGN(index, align);
-		if (index >= IOVM_NUM_PAGES(vmm->iovm_size)) {
-			spin_unlock(&vmm->bitmap_lock);
-			return 0;
-		}
+		if (index >= IOVM_NUM_PAGES(vmm->iovm_size))
+			goto nospace;
 
 		if (test_bit(index, vmm->vm_map))
 			goto again;
@@ -81,10 +247,8 @@ again:
 
 	end = index + vsize;
 
-	if (end >= IOVM_NUM_PAGES(vmm->iovm_size)) {
-		spin_unlock(&vmm->bitmap_lock);
-		return 0;
-	}
+	if (end >= IOVM_NUM_PAGES(vmm->iovm_size))
+		goto nospace;
 
 	i = find_next_bit(vmm->vm_map, end, index);
 	if (i < end) {
@@ -95,7 +259,7 @@ again:
 	bitmap_set(vmm->vm_map, index, vsize);
 
 	spin_unlock(&vmm->bitmap_lock);
-
+found:
 	vstart = (index << PAGE_SHIFT) + vmm->iova_start + page_offset;
 
 	region = kmalloc(sizeof(*region), GFP_KERNEL);
@@ -106,20 +270,36 @@ again:
 		return 0;
 	}
 
-	INIT_LIST_HEAD(&region->node);
 	region->start = vstart;
 	region->size = vsize << PAGE_SHIFT;
 	region->dummy_size = region->size - size;
 	region->section_off = section_offset << PAGE_SHIFT;
+	region->cacheable = true;
 
 	spin_lock(&vmm->vmlist_lock);
-	list_add_tail(&region->node, &vmm->regions_list);
+	/* the bitmap already made sure that nothing else is there */
+	WARN_ON(!__insert_iovm_region(vmm, region));
 	vmm->allocated_size += region->size;
 	vmm->num_areas++;
 	vmm->num_map++;
 	spin_unlock(&vmm->vmlist_lock);
 
 	return region->start + region->section_off;
+
+nospace:
+	spin_unlock(&vmm->bitmap_lock);
+	if (flushed)
+		return 0;
+
+	/* the unmapped regions go to the cache, so flush the queue first */
+	iovmm_flush_queue(vmm);
+	if (!iovmm_rcache_flush(vmm))
+		return 0;
+
+	flushed = true;
+	index = 0;
+	spin_lock(&vmm->bitmap_lock);
+	goto again;
 }
 
 struct exynos_vm_region *find_iovm_region(struct exynos_iovmm *vmm,
@@ -128,18 +308,10 @@ struct exynos_vm_region *find_iovm_region(struct exynos_iovmm *vmm,
 	struct exynos_vm_region *region;
 
 	spin_lock(&vmm->vmlist_lock);
-
-	list_for_each_entry(region, &vmm->regions_list, node) {
-		if (region->start <= iova &&
-			(region->start + region->size) > iova) {
-			spin_unlock(&vmm->vmlist_lock);
-			return region;
-		}
-	}
-
+	region = __find_iovm_region(vmm, iova);
 	spin_unlock(&vmm->vmlist_lock);
 
-	return NULL;
+	return region;
 }
 
 static struct exynos_vm_region *remove_iovm_region(struct exynos_iovmm *vmm,
@@ -149,63 +321,128 @@ static struct exynos_vm_region *remove_iovm_region(struct exynos_iovmm *vmm,
 
 	spin_lock(&vmm->vmlist_lock);
 
-	list_for_each_entry(region, &vmm->regions_list, node) {
-		if (region->start + region->section_off == iova) {
-			list_del(&region->node);
-			vmm->allocated_size -= region->size;
-			vmm->num_areas--;
-			vmm->num_unmap++;
-			spin_unlock(&vmm->vmlist_lock);
-			return region;
-		}
+	region = __find_iovm_region(vmm, iova);
+	if (region && (region->start + region->section_off == iova)) {
+		rb_erase(&region->node, &vmm->regions_tree);
+		vmm->allocated_size -= region->size;
+		vmm->num_areas--;
+		vmm->num_unmap++;
+	} else {
+		region = NULL;
 	}
 
 	spin_unlock(&vmm->vmlist_lock);
 
-	return NULL;
+	return region;
 }
 
 static void free_iovm_region(struct exynos_iovmm *vmm,
 				struct exynos_vm_region *region)
 {
+	u32 index, vsize;
+
 	if (!region)
 		return;
 
-	spin_lock(&vmm->bitmap_lock);
-	bitmap_clear(vmm->vm_map,
-		(region->start - vmm->iova_start) >> PAGE_SHIFT,
-			region->size >> PAGE_SHIFT);
-	spin_unlock(&vmm->bitmap_lock);
+	index = (region->start - vmm->iova_start) >> PAGE_SHIFT;
+	vsize = region->size >> PAGE_SHIFT;
+
+	if (!region->cacheable || !iovmm_rcache_put(vmm, index, vsize)) {
+		spin_lock(&vmm->bitmap_lock);
+		bitmap_clear(vmm->vm_map, index, vsize);
+		spin_unlock(&vmm->bitmap_lock);
+	}
 
 	kfree(region);
 }
 
+/*
+ * Invalidates the TLB for the regions unmapped so far and releases them.
+ * Returns the number of regions released.
+ */
+static int iovmm_flush_queue(struct exynos_iovmm *vmm)
+{
+	struct exynos_vm_region *region, *tmp;
+	LIST_HEAD(flush_list);
+	int cnt;
+
+	spin_lock(&vmm->flush_lock);
+	list_splice_init(&vmm->flush_list, &flush_list);
+	cnt = vmm->flush_cnt;
+	vmm->flush_cnt = 0;
+	spin_unlock(&vmm->flush_lock);
+
+	if (!cnt)
+		return 0;
+
+	if (cnt > IOVMM_FLUSH_ALL_THRESHOLD) {
+		exynos_sysmmu_tlb_invalidate_all(vmm->domain);
+		atomic_inc(&vmm->flush_alls);
+	} else {
+		list_for_each_entry(region, &flush_list, flush_node)
+			exynos_sysmmu_tlb_invalidate(vmm->domain,
+					region->start, region->size);
+	}
+
+	/* TODO: for sysmmu v6, remove it later */
+	/* 60us is required to guarantee that PTW ends itself */
+	udelay(60);
+
+	list_for_each_entry_safe(region, tmp, &flush_list, flush_node)
+		free_iovm_region(vmm, region);
+
+	atomic_inc(&vmm->flush_batches);
+	atomic_add(cnt, &vmm->flush_regions);
+
+	return cnt;
+}
+
+static void iovmm_flush_work(struct work_struct *work)
+{
+	struct exynos_iovmm *vmm = container_of(to_delayed_work(work),
+					struct exynos_iovmm, flush_work);
+
+	iovmm_flush_queue(vmm);
+}
+
+/* defers the TLB invalidation and the release of an unmapped region */
+static void iovmm_queue_flush(struct exynos_iovmm *vmm,
+			      struct exynos_vm_region *region)
+{
+	int cnt;
+
+	spin_lock(&vmm->flush_lock);
+	list_add_tail(&region->flush_node, &vmm->flush_list);
+	cnt = ++vmm->flush_cnt;
+	spin_unlock(&vmm->flush_lock);
+
+	if (cnt >= IOVMM_FLUSH_QUEUE_MAX)
+		iovmm_flush_queue(vmm);
+	else if (cnt == 1)
+		schedule_delayed_work(&vmm->flush_work,
+				      msecs_to_jiffies(IOVMM_FLUSH_MS));
+}
+
 static dma_addr_t add_iovm_region(struct exynos_iovmm *vmm,
 					dma_addr_t start, size_t size)
 {
-	struct exynos_vm_region *region, *pos;
+	struct exynos_vm_region *region;
 
 	region = kzalloc(sizeof(*region), GFP_KERNEL);
 	if (!region)
 		return 0;
 
-	INIT_LIST_HEAD(&region->node);
 	region->start = start;
 	region->size = size;
 
 	spin_lock(&vmm->vmlist_lock);
 
-	list_for_each_entry(pos, &vmm->regions_list, node) {
-		if ((start < (pos->start + pos->size)) &&
-					((start + size) > pos->start)) {
-			spin_unlock(&vmm->vmlist_lock);
-			kfree(region);
-			return 0;
-		}
+	if (!__insert_iovm_region(vmm, region)) {
+		spin_unlock(&vmm->vmlist_lock);
+		kfree(region);
+		return 0;
 	}
 
-	list_add(&region->node, &vmm->regions_list);
-
 	spin_unlock(&vmm->vmlist_lock);
 
 	return start;
@@ -214,10 +451,12 @@ static dma_addr_t add_iovm_region(struct exynos_iovmm *vmm,
 static void show_iovm_regions(struct exynos_iovmm *vmm)
 {
 	struct exynos_vm_region *pos;
+	struct rb_node *n;
 
 	pr_err("LISTING IOVMM REGIONS...\n");
 	spin_lock(&vmm->vmlist_lock);
-	list_for_each_entry(pos, &vmm->regions_list, node) {
+	for (n = rb_first(&vmm->regions_tree); n; n = rb_next(n)) {
+		pos = rb_entry(n, struct exynos_vm_region, node);
 		pr_err("REGION: %#x (SIZE: %#x, +[%#x, %#x])\n",
 				pos->start, pos->size,
 				pos->section_off, pos->dummy_size);
@@ -250,6 +489,17 @@ void iovmm_deactivate(struct device *dev)
 	iommu_detach_device(vmm->domain, dev);
 }
 
+static void iovmm_account_map_latency(struct exynos_iovmm *vmm, ktime_t begin)
+{
+	s64 us = ktime_us_delta(ktime_get(), begin);
+	int bucket = 0;
+
+	if (us > 0)
+		bucket = min_t(int, ilog2(us) + 1, IOVMM_LAT_BUCKETS - 1);
+
+	atomic_inc(&vmm->map_lat[bucket]);
+}
+
 struct iommu_domain *get_domain_from_dev(struct device *dev)
 {
 	struct exynos_iovmm *vmm = exynos_get_iovmm(dev);
@@ -290,6 +540,7 @@ dma_addr_t iovmm_map(struct device *dev, struct scatterlist *sg, off_t offset,
 	int idx;
 	struct scatterlist *tsg;
 	struct exynos_vm_region *region;
+	ktime_t begin = ktime_get();
 
 	if (vmm == NULL) {
 		dev_err(dev, "%s: IOVMM not found\n", __func__);
@@ -416,6 +667,8 @@ dma_addr_t iovmm_map(struct device *dev, struct scatterlist *sg, off_t offset,
 	dev_dbg(dev, "IOVMM: Allocated VM region @ %#x/%#x bytes.\n",
 				(unsigned int)start, (unsigned int)size);
 
+	iovmm_account_map_latency(vmm, begin);
+
 	return start;
 
 err_map_map:
@@ -482,13 +735,18 @@ void iovmm_unmap(struct device *dev, dma_addr_t iova)
 			return;
 		}
 
-		exynos_sysmmu_tlb_invalidate(vmm->domain, region->start, region->size);
+		if (vmm->strict) {
+			exynos_sysmmu_tlb_invalidate(vmm->domain,
+					region->start, region->size);
 
-		/* TODO: for sysmmu v6, remove it later */
-		/* 60us is required to guarantee that PTW ends itself */
-		udelay(60);
+			/* TODO: for sysmmu v6, remove it later */
+			/* 60us is required to guarantee that PTW ends itself */
+			udelay(60);
 
-		free_iovm_region(vmm, region);
+			free_iovm_region(vmm, region);
+		} else {
+			iovmm_queue_flush(vmm, region);
+		}
 
 		dev_dbg(dev, "IOVMM: Unmapped %#x bytes from %#x.\n",
 				(unsigned int)unmap_size, (unsigned int)iova);
@@ -685,6 +943,9 @@ arch_initcall(exynos_iovmm_create_debugfs);
 static int iovmm_debug_show(struct seq_file *s, void *unused)
 {
 	struct exynos_iovmm *vmm = s->private;
+	size_t cached = 0;
+	int nr_cached = 0;
+	int cpu, class, i;
 
 	seq_printf(s, "%10.s  %10.s  %10.s  %6.s\n",
 			"VASTART", "SIZE", "FREE", "CHUNKS");
@@ -700,6 +961,38 @@ static int iovmm_debug_show(struct seq_file *s, void *unused)
 	seq_printf(s, "Total number of unmappings: %d\n", vmm->num_unmap);
 	spin_unlock(&vmm->vmlist_lock);
 
+	for_each_possible_cpu(cpu) {
+		struct iovmm_rcache *rcache = per_cpu_ptr(vmm->rcache, cpu);
+
+		spin_lock(&rcache->lock);
+		for (class = 0; class < IOVMM_RCACHE_CLASSES; class++) {
+			struct iovmm_rcache_mag *mag = &rcache->mags[class];
+
+			for (i = 0; i < mag->count; i++)
+				cached += (size_t)mag->vsize[i] << PAGE_SHIFT;
+			nr_cached += mag->count;
+		}
+		spin_unlock(&rcache->lock);
+	}
+
+	seq_puts(s, "---------------------------------------------\n");
+	seq_printf(s, "Cached ranges             : %d (%#zx)\n",
+			nr_cached, cached);
+	seq_printf(s, "Cache hits/misses/flushes : %d/%d/%d\n",
+			atomic_read(&vmm->rcache_hit),
+			atomic_read(&vmm->rcache_miss),
+			atomic_read(&vmm->rcache_flush));
+	seq_printf(s, "Deferred TLB flush        : %s\n",
+			vmm->strict ? "off (strict)" : "on");
+	seq_printf(s, "Flushes/full/regions      : %d/%d/%d\n",
+			atomic_read(&vmm->flush_batches),
+			atomic_read(&vmm->flush_alls),
+			atomic_read(&vmm->flush_regions));
+	seq_puts(s, "Map latency (usec)        :");
+	for (i = 0; i < IOVMM_LAT_BUCKETS - 1; i++)
+		seq_printf(s, " <%d:%d", 1 << i, atomic_read(&vmm->map_lat[i]));
+	seq_printf(s, " >=%d:%d\n", 1 << i, atomic_read(&vmm->map_lat[i]));
+
 	return 0;
 }
 
@@ -713,11 +1006,20 @@ static ssize_t iovmm_debug_write(struct file *filp, const char __user *p,
 {
 	struct seq_file *s = filp->private_data;
 	struct exynos_iovmm *vmm = s->private;
-	/* clears the map count in IOVMM */
+	int i;
+	/* clears the map count and the statistics in IOVMM */
 	spin_lock(&vmm->vmlist_lock);
 	vmm->num_map = 0;
 	vmm->num_unmap = 0;
 	spin_unlock(&vmm->vmlist_lock);
+	atomic_set(&vmm->rcache_hit, 0);
+	atomic_set(&vmm->rcache_miss, 0);
+	atomic_set(&vmm->rcache_flush, 0);
+	atomic_set(&vmm->flush_batches, 0);
+	atomic_set(&vmm->flush_alls, 0);
+	atomic_set(&vmm->flush_regions, 0);
+	for (i = 0; i < IOVMM_LAT_BUCKETS; i++)
+		atomic_set(&vmm->map_lat[i], 0);
 	return len;
 }
 
@@ -743,6 +1045,7 @@ struct exynos_iovmm *exynos_create_single_iovmm(const char *name,
 {
 	struct exynos_iovmm *vmm;
 	int ret = 0;
+	int cpu;
 
 	vmm = kzalloc(sizeof(*vmm), GFP_KERNEL);
 	if (!vmm) {
@@ -758,6 +1061,15 @@ struct exynos_iovmm *exynos_create_single_iovmm(const char *name,
 		goto err_setup_domain;
 	}
 
+	vmm->rcache = alloc_percpu(struct iovmm_rcache);
+	if (!vmm->rcache) {
+		ret = -ENOMEM;
+		goto err_setup_domain;
+	}
+
+	for_each_possible_cpu(cpu)
+		spin_lock_init(&per_cpu_ptr(vmm->rcache, cpu)->lock);
+
 	vmm->domain = iommu_domain_alloc(&platform_bus_type);
 	if (!vmm->domain) {
 		ret = -ENOMEM;
@@ -767,7 +1079,11 @@ struct exynos_iovmm *exynos_create_single_iovmm(const char *name,
 	spin_lock_init(&vmm->vmlist_lock);
 	spin_lock_init(&vmm->bitmap_lock);
 
-	INIT_LIST_HEAD(&vmm->regions_list);
+	vmm->regions_tree = RB_ROOT;
+
+	spin_lock_init(&vmm->flush_lock);
+	INIT_LIST_HEAD(&vmm->flush_list);
+	INIT_DELAYED_WORK(&vmm->flush_work, iovmm_flush_work);
 
 	vmm->domain_name = name;
 
@@ -778,6 +1094,8 @@ struct exynos_iovmm *exynos_create_single_iovmm(const char *name,
 	return vmm;
 
 err_setup_domain:
+	free_percpu(vmm->rcache);
+	kfree(vmm->vm_map);
 	kfree(vmm);
 err_alloc_vmm:
 	pr_err("%s IOVMM: Failed to create IOVMM (%d)\n", name, ret);
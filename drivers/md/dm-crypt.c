@@ -17,6 +17,8 @@
 #include <linux/mempool.h>
 #include <linux/slab.h>
 #include <linux/crypto.h>
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
 #include <linux/workqueue.h>
 #include <linux/kthread.h>
 #include <linux/backing-dev.h>
@@ -56,6 +58,8 @@ struct convert_context {
 	sector_t cc_sector;
 	atomic_t cc_pending;
 	struct ablkcipher_request *req;
+	bool atomic;		/* converting in the bio completion context */
+	bool restart_pending;	/* a backlogged request is yet to be taken */
 };
 
 /*
@@ -71,6 +75,9 @@ struct dm_crypt_io {
 	atomic_t io_pending;
 	int error;
 	sector_t sector;
+	bool inline_write;	/* submitted without the write thread */
+	ktime_t queued;		/* when queued to kcryptd */
+	struct tasklet_struct tasklet;
 
 	struct rb_node rb_node;
 } CRYPTO_MINALIGN_ATTR;
@@ -123,7 +130,8 @@ struct iv_tcw_private {
  * and encrypts / decrypts at the same time.
  */
 enum flags { DM_CRYPT_SUSPENDED, DM_CRYPT_KEY_VALID,
-	     DM_CRYPT_SAME_CPU, DM_CRYPT_NO_OFFLOAD };
+	     DM_CRYPT_SAME_CPU, DM_CRYPT_NO_OFFLOAD,
+	     DM_CRYPT_NO_READ_WORKQUEUE, DM_CRYPT_NO_WRITE_WORKQUEUE };
 
 /*
  * The fields in here must be read only after initialization.
@@ -188,6 +196,13 @@ struct crypt_config {
 	unsigned int per_bio_data_size;
 
 	unsigned long flags;
+
+	/* the only fields changing after initialization: statistics */
+	atomic64_t inline_reads;
+	atomic64_t inline_writes;
+	atomic64_t queued_ios;
+	atomic64_t queued_ns;
+
 	unsigned int key_size;
 	unsigned int key_parts;      /* independent parts in key buffer */
 	unsigned int key_extra_size; /* additional keys length */
@@ -196,6 +211,15 @@ struct crypt_config {
 
 #define MIN_IOS        16
 
+/*
+ * Largest bio converted in the completion context for reads, or in the
+ * submitter's context for writes, with no_read_workqueue and
+ * no_write_workqueue.
+ */
+static unsigned dm_crypt_inline_max_bytes = 65536;
+module_param_named(inline_max_bytes, dm_crypt_inline_max_bytes, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(inline_max_bytes, "Largest bio converted without kcryptd");
+
 static void clone_init(struct dm_crypt_io *, struct bio *);
 static void kcryptd_queue_crypt(struct dm_crypt_io *io);
 static u8 *iv_of_dmreq(struct crypt_config *cc, struct dm_crypt_request *dmreq);
@@ -826,6 +850,8 @@ static void crypt_convert_init(struct crypt_config *cc,
 	if (bio_out)
 		ctx->iter_out = bio_out->bi_iter;
 	ctx->cc_sector = sector + cc->iv_offset;
+	ctx->atomic = false;
+	ctx->restart_pending = false;
 	init_completion(&ctx->restart);
 }
 
@@ -897,13 +923,17 @@ static int crypt_convert_block(struct crypt_config *cc,
 static void kcryptd_async_done(struct crypto_async_request *async_req,
 			       int error);
 
-static void crypt_alloc_req(struct crypt_config *cc,
-			    struct convert_context *ctx)
+static int crypt_alloc_req(struct crypt_config *cc,
+			   struct convert_context *ctx)
 {
 	unsigned key_index = ctx->cc_sector & (cc->tfms_count - 1);
 
-	if (!ctx->req)
-		ctx->req = mempool_alloc(cc->req_pool, GFP_NOIO);
+	if (!ctx->req) {
+		ctx->req = mempool_alloc(cc->req_pool,
+					 ctx->atomic ? GFP_ATOMIC : GFP_NOIO);
+		if (!ctx->req)
+			return -ENOMEM;
+	}
 
 	ablkcipher_request_set_tfm(ctx->req, cc->tfms[key_index]);
 
@@ -912,8 +942,11 @@ static void crypt_alloc_req(struct crypt_config *cc,
 	 * requests if driver request queue is full.
 	 */
 	ablkcipher_request_set_callback(ctx->req,
-	    CRYPTO_TFM_REQ_MAY_BACKLOG | CRYPTO_TFM_REQ_MAY_SLEEP,
+	    CRYPTO_TFM_REQ_MAY_BACKLOG |
+	    (ctx->atomic ? 0 : CRYPTO_TFM_REQ_MAY_SLEEP),
 	    kcryptd_async_done, dmreq_of_req(cc, ctx->req));
+
+	return 0;
 }
 
 static void crypt_free_req(struct crypt_config *cc,
@@ -927,17 +960,24 @@ static void crypt_free_req(struct crypt_config *cc,
 
 /*
  * Encrypt / decrypt data from one bio to another one (can be the same one)
+ *
+ * In the completion context (ctx->atomic), -EAGAIN is returned when the
+ * conversion cannot go on without sleeping; it is then resumed from where
+ * it stopped by calling again with reset_pending false, from process
+ * context.
  */
 static int crypt_convert(struct crypt_config *cc,
-			 struct convert_context *ctx)
+			 struct convert_context *ctx, bool reset_pending)
 {
 	int r;
 
-	atomic_set(&ctx->cc_pending, 1);
+	if (reset_pending)
+		atomic_set(&ctx->cc_pending, 1);
 
 	while (ctx->iter_in.bi_size && ctx->iter_out.bi_size) {
 
-		crypt_alloc_req(cc, ctx);
+		if (crypt_alloc_req(cc, ctx))
+			return -EAGAIN;
 
 		atomic_inc(&ctx->cc_pending);
 
@@ -949,6 +989,12 @@ static int crypt_convert(struct crypt_config *cc,
 		 * but the driver request queue is full, let's wait.
 		 */
 		case -EBUSY:
+			if (ctx->atomic) {
+				ctx->restart_pending = true;
+				ctx->req = NULL;
+				ctx->cc_sector++;
+				return -EAGAIN;
+			}
 			wait_for_completion(&ctx->restart);
 			reinit_completion(&ctx->restart);
 			/* fall through */
@@ -966,7 +1012,8 @@ static int crypt_convert(struct crypt_config *cc,
 		case 0:
 			atomic_dec(&ctx->cc_pending);
 			ctx->cc_sector++;
-			cond_resched();
+			if (!ctx->atomic)
+				cond_resched();
 			continue;
 
 		/* There was an error while processing the request. */
@@ -1068,6 +1115,7 @@ static void crypt_io_init(struct dm_crypt_io *io, struct crypt_config *cc,
 	io->sector = sector;
 	io->error = 0;
 	io->ctx.req = NULL;
+	io->inline_write = false;
 	atomic_set(&io->io_pending, 0);
 }
 
@@ -1316,7 +1364,8 @@ static void kcryptd_crypt_write_io_submit(struct dm_crypt_io *io, int async)
 
 	clone->bi_iter.bi_sector = cc->start + io->sector;
 
-	if (likely(!async) && test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags)) {
+	if (likely(!async) && (test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags) ||
+			       io->inline_write)) {
 		generic_make_request(clone);
 		return;
 	}
@@ -1365,7 +1414,7 @@ static void kcryptd_crypt_write_convert(struct dm_crypt_io *io)
 	sector += bio_sectors(clone);
 
 	crypt_inc_pending(io);
-	r = crypt_convert(cc, &io->ctx);
+	r = crypt_convert(cc, &io->ctx, true);
 	if (r)
 		io->error = -EIO;
 	crypt_finished = atomic_dec_and_test(&io->ctx.cc_pending);
@@ -1385,7 +1434,33 @@ static void kcryptd_crypt_read_done(struct dm_crypt_io *io)
 	crypt_dec_pending(io);
 }
 
-static void kcryptd_crypt_read_convert(struct dm_crypt_io *io)
+/*
+ * Finish in kcryptd a read conversion the completion context had to stop.
+ */
+static void kcryptd_crypt_read_continue(struct work_struct *work)
+{
+	struct dm_crypt_io *io = container_of(work, struct dm_crypt_io, work);
+	struct crypt_config *cc = io->cc;
+	int r;
+
+	if (io->ctx.restart_pending) {
+		wait_for_completion(&io->ctx.restart);
+		reinit_completion(&io->ctx.restart);
+		io->ctx.restart_pending = false;
+	}
+
+	io->ctx.atomic = false;
+	r = crypt_convert(cc, &io->ctx, false);
+	if (r < 0)
+		io->error = -EIO;
+
+	if (atomic_dec_and_test(&io->ctx.cc_pending))
+		kcryptd_crypt_read_done(io);
+
+	crypt_dec_pending(io);
+}
+
+static void kcryptd_crypt_read_convert(struct dm_crypt_io *io, bool atomic)
 {
 	struct crypt_config *cc = io->cc;
 	int r = 0;
@@ -1394,8 +1469,14 @@ static void kcryptd_crypt_read_convert(struct dm_crypt_io *io)
 
 	crypt_convert_init(cc, &io->ctx, io->base_bio, io->base_bio,
 			   io->sector);
+	io->ctx.atomic = atomic;
 
-	r = crypt_convert(cc, &io->ctx);
+	r = crypt_convert(cc, &io->ctx, true);
+	if (r == -EAGAIN) {
+		INIT_WORK(&io->work, kcryptd_crypt_read_continue);
+		queue_work(cc->crypt_queue, &io->work);
+		return;
+	}
 	if (r < 0)
 		io->error = -EIO;
 
@@ -1443,13 +1524,65 @@ static void kcryptd_async_done(struct crypto_async_request *async_req,
 static void kcryptd_crypt(struct work_struct *work)
 {
 	struct dm_crypt_io *io = container_of(work, struct dm_crypt_io, work);
+	struct crypt_config *cc = io->cc;
+
+	atomic64_inc(&cc->queued_ios);
+	atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), io->queued)),
+		     &cc->queued_ns);
 
 	if (bio_data_dir(io->base_bio) == READ)
-		kcryptd_crypt_read_convert(io);
+		kcryptd_crypt_read_convert(io, false);
 	else
 		kcryptd_crypt_write_convert(io);
 }
 
+static void kcryptd_crypt_tasklet(unsigned long data)
+{
+	kcryptd_crypt_read_convert((struct dm_crypt_io *)data, true);
+}
+
+/*
+ * With no_read_workqueue, small reads are decrypted on the cpu completing
+ * them, from the completion context, and with no_write_workqueue small
+ * writes are encrypted by the submitter and sent down without the write
+ * thread while it has nothing to sort. Returns false when the conversion
+ * is to be queued to kcryptd instead.
+ */
+static bool kcryptd_crypt_inline(struct dm_crypt_io *io)
+{
+	struct crypt_config *cc = io->cc;
+
+	if (io->base_bio->bi_iter.bi_size > ACCESS_ONCE(dm_crypt_inline_max_bytes))
+		return false;
+
+	if (bio_data_dir(io->base_bio) == READ) {
+		if (!test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags))
+			return false;
+
+		atomic64_inc(&cc->inline_reads);
+		if (in_irq()) {
+			/* the cipher walk does not work in hard irq context */
+			tasklet_init(&io->tasklet, kcryptd_crypt_tasklet,
+				     (unsigned long)io);
+			tasklet_schedule(&io->tasklet);
+			return true;
+		}
+
+		/* completions may run with locks held, never sleep here */
+		kcryptd_crypt_read_convert(io, true);
+		return true;
+	}
+
+	if (!test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags) ||
+	    !RB_EMPTY_ROOT(&cc->write_tree))
+		return false;
+
+	atomic64_inc(&cc->inline_writes);
+	io->inline_write = true;
+	kcryptd_crypt_write_convert(io);
+	return true;
+}
+
 static void kcryptd_fmp_io(struct work_struct *work)
 {
 	struct dm_crypt_io *io = container_of(work, struct dm_crypt_io, work);
@@ -1468,6 +1601,10 @@ static void kcryptd_queue_crypt(struct dm_crypt_io *io)
 		INIT_WORK(&io->work, kcryptd_fmp_io);
 		queue_work(cc->io_queue, &io->work);
 	} else {
+		if (kcryptd_crypt_inline(io))
+			return;
+
+		io->queued = ktime_get();
 		INIT_WORK(&io->work, kcryptd_crypt);
 		queue_work(cc->crypt_queue, &io->work);
 	}
@@ -1981,7 +2118,7 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 	char dummy;
 
 	static struct dm_arg _args[] = {
-		{0, 3, "Invalid number of feature args"},
+		{0, 5, "Invalid number of feature args"},
 	};
 
 	if (argc < 5) {
@@ -2103,6 +2240,12 @@ static int crypt_ctr(struct dm_target *ti, unsigned int argc, char **argv)
 			else if (!strcasecmp(opt_string, "submit_from_crypt_cpus"))
 				set_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags);
 
+			else if (!strcasecmp(opt_string, "no_read_workqueue"))
+				set_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags);
+
+			else if (!strcasecmp(opt_string, "no_write_workqueue"))
+				set_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags);
+
 			else {
 				ti->error = "Invalid feature arguments";
 				goto bad;
@@ -2227,7 +2370,11 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 
 	switch (type) {
 	case STATUSTYPE_INFO:
-		result[0] = '\0';
+		DMEMIT("inline_reads %llu inline_writes %llu queued %llu queued_ns %llu",
+		       (unsigned long long)atomic64_read(&cc->inline_reads),
+		       (unsigned long long)atomic64_read(&cc->inline_writes),
+		       (unsigned long long)atomic64_read(&cc->queued_ios),
+		       (unsigned long long)atomic64_read(&cc->queued_ns));
 		break;
 
 	case STATUSTYPE_TABLE:
@@ -2247,6 +2394,8 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 		num_feature_args += !!ti->num_discard_bios;
 		num_feature_args += test_bit(DM_CRYPT_SAME_CPU, &cc->flags);
 		num_feature_args += test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags);
+		num_feature_args += test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags);
+		num_feature_args += test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags);
 		if (num_feature_args) {
 			DMEMIT(" %d", num_feature_args);
 			if (ti->num_discard_bios)
@@ -2255,6 +2404,10 @@ static void crypt_status(struct dm_target *ti, status_type_t type,
 				DMEMIT(" same_cpu_crypt");
 			if (test_bit(DM_CRYPT_NO_OFFLOAD, &cc->flags))
 				DMEMIT(" submit_from_crypt_cpus");
+			if (test_bit(DM_CRYPT_NO_READ_WORKQUEUE, &cc->flags))
+				DMEMIT(" no_read_workqueue");
+			if (test_bit(DM_CRYPT_NO_WRITE_WORKQUEUE, &cc->flags))
+				DMEMIT(" no_write_workqueue");
 		}
 
 		break;
@@ -35,6 +35,8 @@
 
 #define DM_VERITY_DEFAULT_PREFETCH_SIZE	262144
 
+#define DM_VERITY_DEFAULT_HASH_CACHE	1024
+
 #define DM_VERITY_MAX_CORRUPTED_ERRS	100
 
 #define DM_VERITY_OPT_LOGGING		"ignore_corruption"
@@ -59,11 +61,22 @@ int start_meta;
 
 static unsigned dm_verity_prefetch_cluster = DM_VERITY_DEFAULT_PREFETCH_SIZE;
 
+static unsigned dm_verity_hash_cache = DM_VERITY_DEFAULT_HASH_CACHE;
+
 ulong gTotalBlock = 0;
 ulong gMetaTotalBlock = 0;
 module_param_named(total, gTotalBlock, ulong, 0444);
 module_param_named(mtotal, gMetaTotalBlock, ulong, 0444);
 module_param_named(prefetch_cluster, dm_verity_prefetch_cluster, uint, S_IRUGO | S_IWUSR);
+module_param_named(hash_cache, dm_verity_hash_cache, uint, S_IRUGO | S_IWUSR);
+
+/* reads completed in the bio completion context, or handed to kverityd */
+static bool dm_verity_complete_inline = true;
+ulong gInlineIo = 0;
+ulong gDeferredIo = 0;
+module_param_named(complete_inline, dm_verity_complete_inline, bool, S_IRUGO | S_IWUSR);
+module_param_named(inline_io, gInlineIo, ulong, 0444);
+module_param_named(deferred_io, gDeferredIo, ulong, 0444);
 
 #ifdef DMV_ALTA
 /* Verity bitmap. Each bit represents one block and will be set when integrity
@@ -292,6 +305,74 @@ out:
 	return 1;
 }
 #endif
+
+/*
+ * Cache of the digests of verified hash blocks, indexed by hash block.
+ *
+ * A digest is only entered once the block matched it, and it is the one
+ * its parent block gave, so it is as trusted as the parent itself. When the
+ * block has been dropped from dm-bufio and is read again, it is hashed and
+ * checked against the cached digest instead of walking the tree up to the
+ * root again. Hash blocks are never trusted without being hashed: only the
+ * walk up to a trusted digest is saved.
+ *
+ * Entries are dropped when reading the block fails or FEC has to correct
+ * it; a colliding block replaces the entry.
+ */
+static bool verity_hash_cache_get(struct dm_verity *v, sector_t hash_block,
+				  u8 *digest)
+{
+	sector_t key = hash_block;
+	unsigned idx;
+	bool hit = false;
+
+	if (!v->hash_cache_entries)
+		return false;
+
+	idx = sector_div(key, v->hash_cache_entries);
+	spin_lock(&v->hash_cache_lock);
+	if (v->hash_cache_blocks[idx] == hash_block) {
+		memcpy(digest, v->hash_cache_digests + idx * v->digest_size,
+		       v->digest_size);
+		hit = true;
+	}
+	spin_unlock(&v->hash_cache_lock);
+
+	return hit;
+}
+
+static void verity_hash_cache_set(struct dm_verity *v, sector_t hash_block,
+				  const u8 *digest)
+{
+	sector_t key = hash_block;
+	unsigned idx;
+
+	if (!v->hash_cache_entries)
+		return;
+
+	idx = sector_div(key, v->hash_cache_entries);
+	spin_lock(&v->hash_cache_lock);
+	v->hash_cache_blocks[idx] = hash_block;
+	memcpy(v->hash_cache_digests + idx * v->digest_size, digest,
+	       v->digest_size);
+	spin_unlock(&v->hash_cache_lock);
+}
+
+static void verity_hash_cache_drop(struct dm_verity *v, sector_t hash_block)
+{
+	sector_t key = hash_block;
+	unsigned idx;
+
+	if (!v->hash_cache_entries)
+		return;
+
+	idx = sector_div(key, v->hash_cache_entries);
+	spin_lock(&v->hash_cache_lock);
+	if (v->hash_cache_blocks[idx] == hash_block)
+		v->hash_cache_blocks[idx] = (sector_t)-1;
+	spin_unlock(&v->hash_cache_lock);
+}
+
 /*
  * Verify hash of a metadata block pertaining to the specified data block
  * ("block" argument) at a specified level ("level" argument).
@@ -317,8 +398,10 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 	verity_hash_at_level(v, block, level, &hash_block, &offset);
 
 	data = dm_bufio_read(v->bufio, hash_block, &buf);
-	if (IS_ERR(data))
+	if (IS_ERR(data)) {
+		verity_hash_cache_drop(v, hash_block);
 		return PTR_ERR(data);
+	}
 
 	aux = dm_bufio_get_aux_data(buf);
 
@@ -335,15 +418,17 @@ static int verity_verify_level(struct dm_verity *v, struct dm_verity_io *io,
 			goto release_ret_r;
 
 		if (likely(memcmp(verity_io_real_digest(v, io), want_digest,
-				  v->digest_size) == 0))
+				  v->digest_size) == 0)) {
 			aux->hash_verified = 1;
-		else if (verity_fec_decode(v, io,
+			verity_hash_cache_set(v, hash_block, want_digest);
+		} else if (verity_fec_decode(v, io,
 					DM_VERITY_BLOCK_TYPE_METADATA,
 					hash_block, data, NULL) == 0) {
 #ifdef SEC_HEX_DEBUG
 			add_fec_correct_blks();
 			add_fc_blks_entry(hash_block,v->data_dev->name);
 #endif
+			verity_hash_cache_drop(v, hash_block);
 			aux->hash_verified = 1;
 		}
 #ifdef SEC_HEX_DEBUG
@@ -377,7 +462,8 @@ release_ret_r:
 int verity_hash_for_block(struct dm_verity *v, struct dm_verity_io *io,
 			  sector_t block, u8 *digest, bool *is_zero)
 {
-	int r = 0, i;
+	int r = 0, i, top;
+	sector_t hash_block;
 
 	if (likely(v->levels)) {
 		/*
@@ -392,9 +478,21 @@ int verity_hash_for_block(struct dm_verity *v, struct dm_verity_io *io,
 			goto out;
 	}
 
+	/*
+	 * Start the walk from the lowest level whose hash block has a cached
+	 * digest, or from the root.
+	 */
 	memcpy(digest, v->root_digest, v->digest_size);
+	top = v->levels - 1;
+	for (i = 0; i < (int)v->levels - 1; i++) {
+		verity_hash_at_level(v, block, i, &hash_block, NULL);
+		if (verity_hash_cache_get(v, hash_block, digest)) {
+			top = i;
+			break;
+		}
+	}
 
-	for (i = v->levels - 1; i >= 0; i--) {
+	for (i = top; i >= 0; i--) {
 		r = verity_verify_level(v, io, block, i, false, digest);
 		if (unlikely(r))
 			goto out;
@@ -542,6 +640,9 @@ static int verity_verify_io(struct dm_verity_io *io)
 			add_fec_correct_blks();
 			add_fc_blks_entry(cur_block,v->data_dev->name);
 #endif
+			/* the device returned bad data, check it every time */
+			if (v->validated_blocks)
+				clear_bit(cur_block, v->validated_blocks);
 			continue;
 		}
 		else
@@ -608,15 +709,51 @@ static void verity_work(struct work_struct *w)
 	
 }
 
+/*
+ * With check_at_most_once, a read of blocks that were all verified before
+ * needs no hashing at all and is completed right away, without the round
+ * trip through kverityd.
+ */
+static bool verity_io_validated(struct dm_verity_io *io)
+{
+	struct dm_verity *v = io->v;
+	unsigned b;
+
+	if (!v->validated_blocks || !ACCESS_ONCE(dm_verity_complete_inline))
+		return false;
+
+	for (b = 0; b < io->n_blocks; b++)
+		if (!test_bit(io->block + b, v->validated_blocks))
+			return false;
+
+	return true;
+}
+
 static void verity_end_io(struct bio *bio)
 {
 	struct dm_verity_io *io = bio->bi_private;
+	unsigned b;
+
+	/*
+	 * Blocks that failed to read must not be taken as already verified,
+	 * keep checking them until they read and verify again.
+	 */
+	if (bio->bi_error && io->v->validated_blocks)
+		for (b = 0; b < io->n_blocks; b++)
+			clear_bit(io->block + b, io->v->validated_blocks);
 
 	if (bio->bi_error && !verity_fec_is_enabled(io->v)) {
 		verity_finish_io(io, bio->bi_error);
 		return;
 	}
 
+	if (!bio->bi_error && verity_io_validated(io)) {
+		gInlineIo++;
+		verity_finish_io(io, 0);
+		return;
+	}
+
+	gDeferredIo++;
 	INIT_WORK(&io->work, verity_work);
 	queue_work(io->v->verify_wq, &io->work);
 }
@@ -957,6 +1094,8 @@ void verity_dtr(struct dm_target *ti)
 		dm_bufio_client_destroy(v->bufio);
 
 	vfree(v->validated_blocks);
+	vfree(v->hash_cache_blocks);
+	vfree(v->hash_cache_digests);
 	kfree(v->salt);
 	kfree(v->root_digest);
 	kfree(v->zero_digest);
@@ -978,6 +1117,30 @@ void verity_dtr(struct dm_target *ti)
 }
 EXPORT_SYMBOL_GPL(verity_dtr);
 
+static int verity_alloc_hash_cache(struct dm_verity *v)
+{
+	unsigned entries = min_t(sector_t, ACCESS_ONCE(dm_verity_hash_cache),
+				 v->hash_blocks);
+	unsigned i;
+
+	spin_lock_init(&v->hash_cache_lock);
+	if (!entries)
+		return 0;
+
+	v->hash_cache_blocks = vmalloc(entries * sizeof(sector_t));
+	v->hash_cache_digests = vmalloc(entries * v->digest_size);
+	if (!v->hash_cache_blocks || !v->hash_cache_digests) {
+		v->ti->error = "Cannot allocate hash block cache";
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < entries; i++)
+		v->hash_cache_blocks[i] = (sector_t)-1;
+	v->hash_cache_entries = entries;
+
+	return 0;
+}
+
 static int verity_alloc_most_once(struct dm_verity *v)
 {
 	struct dm_target *ti = v->ti;
@@ -1324,6 +1487,10 @@ int verity_ctr(struct dm_target *ti, unsigned argc, char **argv)
 		goto bad;
 	}
 
+	r = verity_alloc_hash_cache(v);
+	if (r)
+		goto bad;
+
 	/*
 	 * Using WQ_HIGHPRI improves throughput and completion latency by
 	 * reducing wait times when reading from a dm-verity device.
@@ -66,6 +66,12 @@ struct dm_verity {
 
 	struct dm_verity_fec *fec;	/* forward error correction */
 	unsigned long *validated_blocks; /* bitset blocks validated */
+
+	/* digests of verified hash blocks, to verify them again on reload */
+	spinlock_t hash_cache_lock;
+	unsigned hash_cache_entries;
+	sector_t *hash_cache_blocks;
+	u8 *hash_cache_digests;
 #ifdef DMV_ALTA
 	u8 *verity_bitmap; /* bitmap for skipping verification on blocks */
 #endif
@@ -62,17 +62,16 @@ static void m2m1shot2_timeout_handler(unsigned long arg);
  *     # set in __m2m1shot2_finish_context() on an error
  *     # clear in m2m1shot2_ioctl() before returning to user
  */
-static int m2m1shot2_open(struct inode *inode, struct file *filp)
+static struct m2m1shot2_context *m2m1shot2_create_context(
+					struct m2m1shot2_device *m21dev)
 {
-	struct m2m1shot2_device *m21dev = container_of(filp->private_data,
-						struct m2m1shot2_device, misc);
 	struct m2m1shot2_context *ctx;
 	unsigned long flags;
 	int ret;
 
 	ctx = kzalloc(sizeof(*ctx), GFP_KERNEL);
 	if (!ctx)
-		return -ENOMEM;
+		return ERR_PTR(-ENOMEM);
 
 	ctx->timeline = sw_sync_timeline_create(dev_name(m21dev->dev));
 	if (!ctx->timeline) {
@@ -92,8 +91,6 @@ static int m2m1shot2_open(struct inode *inode, struct file *filp)
 	init_completion(&ctx->complete);
 	complete_all(&ctx->complete); /* prevent to wait for completion */
 
-	filp->private_data = ctx;
-
 	for (ret = 0; ret < M2M1SHOT2_MAX_IMAGES; ret++) {
 		ctx->source[ret].img.index = ret;
 		sync_fence_waiter_init(&ctx->source[ret].img.waiter,
@@ -116,13 +113,28 @@ static int m2m1shot2_open(struct inode *inode, struct file *filp)
 	setup_timer(&ctx->timer, m2m1shot2_timeout_handler,
 						(unsigned long)ctx);
 
-	return 0;
+	return ctx;
 err_init:
 	sync_timeline_destroy(&ctx->timeline->obj);
 err_timeline:
 	kfree(ctx);
-	return ret;
+	return ERR_PTR(ret);
+
+}
 
+static int m2m1shot2_open(struct inode *inode, struct file *filp)
+{
+	struct m2m1shot2_device *m21dev = container_of(filp->private_data,
+						struct m2m1shot2_device, misc);
+	struct m2m1shot2_context *ctx;
+
+	ctx = m2m1shot2_create_context(m21dev);
+	if (IS_ERR(ctx))
+		return PTR_ERR(ctx);
+
+	filp->private_data = ctx;
+
+	return 0;
 }
 
 /*
@@ -234,10 +246,23 @@ static void m2m1shot2_put_images(struct m2m1shot2_context *ctx)
 	m2m1shot2_put_image(ctx, &ctx->target);
 }
 
+static void m2m1shot2_complete_context(struct m2m1shot2_context *ctx,
+					bool success)
+{
+	if (!success)
+		set_bit(M2M1S2_CTXSTATE_ERROR, &ctx->state);
+
+	set_bit(M2M1S2_CTXSTATE_PROCESSED, &ctx->state);
+	clear_bit(M2M1S2_CTXSTATE_PROCESSING, &ctx->state);
+
+	complete_all(&ctx->complete);
+}
+
 static void __m2m1shot2_finish_context(struct m2m1shot2_context *ctx,
 					bool success)
 {
 	struct m2m1shot2_device *m21dev = ctx->m21dev;
+	struct m2m1shot2_context *merged;
 	unsigned long flags;
 
 	sw_sync_timeline_inc(ctx->timeline, 1);
@@ -253,15 +278,65 @@ static void __m2m1shot2_finish_context(struct m2m1shot2_context *ctx,
 	m21dev->current_ctx = NULL;
 	list_add_tail(&ctx->node, &m21dev->contexts);
 
+	merged = m21dev->merged_ctx;
+	m21dev->merged_ctx = NULL;
+	if (merged)
+		list_add_tail(&merged->node, &m21dev->contexts);
+
 	spin_unlock_irqrestore(&m21dev->lock_ctx, flags);
 
-	if (!success)
-		set_bit(M2M1S2_CTXSTATE_ERROR, &ctx->state);
+	m2m1shot2_complete_context(ctx, success);
 
-	set_bit(M2M1S2_CTXSTATE_PROCESSED, &ctx->state);
-	clear_bit(M2M1S2_CTXSTATE_PROCESSING, &ctx->state);
+	/* the merged context is processed by the same H/W run */
+	if (merged) {
+		merged->work_delay_in_nsec = ctx->work_delay_in_nsec;
+		sw_sync_timeline_inc(merged->timeline, 1);
+		m2m1shot2_complete_context(merged, success);
+	}
+}
 
-	complete_all(&ctx->complete);
+/**
+ * m2m1shot2_merge_next_context() - process the next context with the current
+ * @m21dev: the m2m1shot2 device
+ * @merge: client's decision if the next context can be processed together
+ *	   with the current context. Called with m2m1shot2_device.lock_ctx held.
+ *
+ * The context at the front of m2m1shot2_device.active_contexts is taken off
+ * the list if @merge returns true for it. The client should then program it
+ * into the same H/W run with the current context, and both of them are
+ * finished by one m2m1shot2_finish_context() of the current context.
+ * Only one context can be merged to the current context.
+ * It should be called only in m2m1shot2_devops.device_run() and no failure is
+ * allowed after a context is merged.
+ */
+struct m2m1shot2_context *m2m1shot2_merge_next_context(
+		struct m2m1shot2_device *m21dev,
+		bool (*merge)(struct m2m1shot2_context *cur,
+			      struct m2m1shot2_context *next))
+{
+	struct m2m1shot2_context *ctx = NULL;
+	unsigned long flags;
+
+	spin_lock_irqsave(&m21dev->lock_ctx, flags);
+
+	if (WARN_ON(!m21dev->current_ctx) || m21dev->merged_ctx ||
+			list_empty(&m21dev->active_contexts))
+		goto out;
+
+	ctx = list_first_entry(&m21dev->active_contexts,
+				struct m2m1shot2_context, node);
+	if (!merge(m21dev->current_ctx, ctx)) {
+		ctx = NULL;
+		goto out;
+	}
+
+	m21dev->merged_ctx = ctx;
+	list_del_init(&ctx->node);
+	clear_bit(M2M1S2_CTXSTATE_PENDING, &ctx->state);
+out:
+	spin_unlock_irqrestore(&m21dev->lock_ctx, flags);
+
+	return ctx;
 }
 
 /**
@@ -761,11 +836,8 @@ static void m2m1shot2_cancel_context(struct m2m1shot2_context *ctx)
 		"state should be IDLE but %#lx\n", ctx->state);
 }
 
-static void m2m1shot2_destroy_context(struct work_struct *work)
+static void __m2m1shot2_destroy_context(struct m2m1shot2_context *ctx)
 {
-	struct m2m1shot2_context *ctx =
-		container_of(work, struct m2m1shot2_context, dwork);
-
 	mutex_lock(&ctx->mutex);
 
 	m2m1shot2_cancel_context(ctx);
@@ -786,6 +858,18 @@ static void m2m1shot2_destroy_context(struct work_struct *work)
 	kfree(ctx);
 }
 
+static void m2m1shot2_destroy_context(struct work_struct *work)
+{
+	struct m2m1shot2_context *ctx =
+		container_of(work, struct m2m1shot2_context, dwork);
+
+	/* no more ioctl on ctx, ctx->batch is stable */
+	while (ctx->num_batch > 0)
+		__m2m1shot2_destroy_context(ctx->batch[--ctx->num_batch]);
+
+	__m2m1shot2_destroy_context(ctx);
+}
+
 /*
  * m2m1shot2_release() may be called during the context to be destroyed is ready
  * for processing or currently waiting for completion of processing due to the
@@ -1577,6 +1661,140 @@ err_busy:
 	return -EBUSY;
 }
 
+static void m2m1shot2_update_priority(struct m2m1shot2_context *ctx,
+				      enum m2m1shot2_priority priority)
+{
+	struct m2m1shot2_device *m21dev = ctx->m21dev;
+
+	if (priority == ctx->priority)
+		return;
+
+	spin_lock(&m21dev->lock_priority);
+	m21dev->prior_stats[ctx->priority] -= 1;
+	m21dev->prior_stats[priority] += 1;
+	ctx->priority = priority;
+	spin_unlock(&m21dev->lock_priority);
+}
+
+/*
+ * m2m1shot2_process() - queue a task described by @data to the H/W
+ *
+ * This function should be called under ctx->mutex held. @data is the copy of
+ * the task at @uptr where the release fences and the results are returned.
+ */
+static int m2m1shot2_process(struct m2m1shot2_context *ctx,
+			     struct m2m1shot2 __user *uptr,
+			     struct m2m1shot2 *data)
+{
+	struct m2m1shot2_device *m21dev = ctx->m21dev;
+	int ret;
+	int i;
+
+	/* wait for completion of the previous task */
+	if (!M2M1S2_CTXSTATE_IDLE(ctx))
+		m2m1shot2_wait_process(m21dev, ctx);
+
+	/*
+	 * A new process request with the lower priority than the
+	 * heighest priority currently configured is not allowed
+	 * to be executed and m2m1shot2 simply returns -EBUSY
+	 */
+	spin_lock(&m21dev->lock_priority);
+	for (i = ctx->priority + 1; i < M2M1SHOT2_PRIORITY_END; i++) {
+		if (m21dev->prior_stats[i] > 0)
+			break;
+	}
+	spin_unlock(&m21dev->lock_priority);
+
+	if (i < M2M1SHOT2_PRIORITY_END)
+		return -EBUSY;
+
+	kref_init(&ctx->starter);
+
+	ret = m2m1shot2_get_userdata(ctx, data);
+	if (ret < 0)
+		return ret;
+
+	ctx->release_fence = NULL;
+	if (!!(data->flags & M2M1SHOT2_FLAG_NONBLOCK)) {
+		ret = m2m1shot2_create_release_fence(ctx, &uptr->target,
+					data->sources, data->num_sources);
+		if (ret < 0) {
+			m2m1shot2_put_images(ctx);
+			return ret;
+		}
+	}
+
+	m2m1shot2_start_context(ctx->m21dev, ctx);
+
+	if (!(data->flags & M2M1SHOT2_FLAG_NONBLOCK)) {
+		ret = m2m1shot2_wait_put_user(ctx, uptr, data->flags);
+		m2m1shot2_put_images(ctx);
+	}
+
+	return ret;
+}
+
+/*
+ * m2m1shot2_process_batch() - queue the tasks of @batch back to back
+ *
+ * Each task is carried by a context of its own in ctx->batch, as if the user
+ * opened as many contexts and called M2M1SHOT2_IOC_PROCESS in a row. The
+ * contexts are queued to m2m1shot2_device.active_contexts one after another
+ * and the client driver starts the next from the IRQ of the previous one.
+ * This function should be called under ctx->mutex held.
+ */
+static int m2m1shot2_process_batch(struct m2m1shot2_context *ctx,
+				   struct m2m1shot2_batch *batch)
+{
+	struct m2m1shot2_device *m21dev = ctx->m21dev;
+	struct m2m1shot2 __user *ujobs = batch->jobs;
+	struct m2m1shot2_context *jctx;
+	struct m2m1shot2 data;
+	int ret = 0;
+
+	batch->num_queued = 0;
+
+	if ((batch->num_jobs < 1) || (batch->num_jobs > M2M1SHOT2_MAX_BATCH)) {
+		dev_err(m21dev->dev, "%s: Invalid number of tasks %u\n",
+			__func__, batch->num_jobs);
+		return -EINVAL;
+	}
+
+	while (ctx->num_batch < batch->num_jobs) {
+		jctx = m2m1shot2_create_context(m21dev);
+		if (IS_ERR(jctx))
+			return PTR_ERR(jctx);
+
+		m2m1shot2_update_priority(jctx, ctx->priority);
+		ctx->batch[ctx->num_batch++] = jctx;
+	}
+
+	for (; batch->num_queued < batch->num_jobs; batch->num_queued++) {
+		if (copy_from_user(&data, &ujobs[batch->num_queued],
+				   sizeof(data))) {
+			dev_err(m21dev->dev,
+				"%s: Failed to read userdata\n", __func__);
+			return -EFAULT;
+		}
+
+		if (!(data.flags & M2M1SHOT2_FLAG_NONBLOCK)) {
+			dev_err(m21dev->dev, "%s: task %u of batch is blocking\n",
+				__func__, batch->num_queued);
+			return -EINVAL;
+		}
+
+		jctx = ctx->batch[batch->num_queued];
+		mutex_lock_nested(&jctx->mutex, SINGLE_DEPTH_NESTING);
+		ret = m2m1shot2_process(jctx, &ujobs[batch->num_queued], &data);
+		mutex_unlock(&jctx->mutex);
+		if (ret < 0)
+			break;
+	}
+
+	return ret;
+}
+
 static long m2m1shot2_ioctl(struct file *filp,
 			    unsigned int cmd, unsigned long arg)
 {
@@ -1625,6 +1843,7 @@ static long m2m1shot2_ioctl(struct file *filp,
 	case M2M1SHOT2_IOC_SET_PRIORITY:
 	{
 		enum m2m1shot2_priority data;
+		unsigned int i;
 
 		get_user(data, (enum m2m1shot2_priority __user *)arg);
 
@@ -1637,14 +1856,9 @@ static long m2m1shot2_ioctl(struct file *filp,
 			break;
 		}
 
-		/* update current priority */
-		if (data != ctx->priority) {
-			spin_lock(&m21dev->lock_priority);
-			m21dev->prior_stats[ctx->priority] -= 1;
-			m21dev->prior_stats[data] += 1;
-			ctx->priority = data;
-			spin_unlock(&m21dev->lock_priority);
-		}
+		m2m1shot2_update_priority(ctx, data);
+		for (i = 0; i < ctx->num_batch; i++)
+			m2m1shot2_update_priority(ctx->batch[i], data);
 
 		ret = m2m1shot2_prepare_priority_context(ctx);
 		if (ret < 0)
@@ -1656,7 +1870,6 @@ static long m2m1shot2_ioctl(struct file *filp,
 	{
 		struct m2m1shot2 __user *uptr = (struct m2m1shot2 __user *)arg;
 		struct m2m1shot2 data;
-		int i;
 
 		if (copy_from_user(&data, uptr, sizeof(data))) {
 			dev_err(ctx->m21dev->dev,
@@ -1665,50 +1878,24 @@ static long m2m1shot2_ioctl(struct file *filp,
 			break;
 		}
 
-		/* wait for completion of the previous task */
-		if (!M2M1S2_CTXSTATE_IDLE(ctx))
-			m2m1shot2_wait_process(m21dev, ctx);
-
-		/*
-		 * A new process request with the lower priority than the
-		 * heighest priority currently configured is not allowed
-		 * to be executed and m2m1shot2 simply returns -EBUSY
-		 */
-		spin_lock(&m21dev->lock_priority);
-		for (i = ctx->priority + 1; i < M2M1SHOT2_PRIORITY_END; i++) {
-			if (m21dev->prior_stats[i] > 0)
-				break;
-		}
-		spin_unlock(&m21dev->lock_priority);
-
-		if (i < M2M1SHOT2_PRIORITY_END) {
-			ret = -EBUSY;
-			break;
-		}
-
-		kref_init(&ctx->starter);
+		ret = m2m1shot2_process(ctx, uptr, &data);
+		break;
+	}
+	case M2M1SHOT2_IOC_PROCESS_BATCH:
+	{
+		struct m2m1shot2_batch __user *uptr = (void __user *)arg;
+		struct m2m1shot2_batch data;
 
-		ret = m2m1shot2_get_userdata(ctx, &data);
-		if (ret < 0)
+		if (copy_from_user(&data, uptr, sizeof(data))) {
+			dev_err(ctx->m21dev->dev,
+				"%s: Failed to read userdata\n", __func__);
+			ret = -EFAULT;
 			break;
-
-		ctx->release_fence = NULL;
-		if (!!(data.flags & M2M1SHOT2_FLAG_NONBLOCK)) {
-			ret = m2m1shot2_create_release_fence(ctx, &uptr->target,
-						data.sources, data.num_sources);
-			if (ret < 0) {
-				m2m1shot2_put_images(ctx);
-				break;
-			}
-		}
-
-		m2m1shot2_start_context(ctx->m21dev, ctx);
-
-		if (!(data.flags & M2M1SHOT2_FLAG_NONBLOCK)) {
-			ret = m2m1shot2_wait_put_user(ctx, uptr, data.flags);
-			m2m1shot2_put_images(ctx);
 		}
 
+		ret = m2m1shot2_process_batch(ctx, &data);
+		if (put_user(data.num_queued, &uptr->num_queued) && !ret)
+			ret = -EFAULT;
 		break;
 	}
 	case M2M1SHOT2_IOC_WAIT_PROCESS:
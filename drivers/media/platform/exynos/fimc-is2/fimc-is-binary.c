@@ -14,6 +14,7 @@
 #include <linux/file.h>
 #include <linux/slab.h>
 #include <linux/firmware.h>
+#include <linux/mutex.h>
 
 #include "fimc-is-binary.h"
 #include "exynos-fimc-is-sensor.h"
@@ -224,6 +225,113 @@ void setup_binary_loader(struct fimc_is_binary *bin,
 	bin->customized = (unsigned long)bin;
 }
 
+/* binaries read ahead of their first use, keyed by name */
+struct binary_stage {
+	char name[IS_BIN_STAGE_NAME_LEN];
+	struct fimc_is_binary bin;
+};
+static struct binary_stage bin_stage[IS_BIN_STAGE_MAX];
+static DEFINE_MUTEX(bin_stage_lock);
+
+/**
+  * stage_binary: keep a loaded binary until its first request
+  * @bin: pointer to a loaded fimc_is_binary structure, owned by the stage
+  *	  on success
+  * @name: name of binary file, as passed to request_binary later
+  **/
+int stage_binary(struct fimc_is_binary *bin, const char *name)
+{
+	struct binary_stage *free_slot = NULL;
+	int i;
+
+	mutex_lock(&bin_stage_lock);
+	for (i = 0; i < IS_BIN_STAGE_MAX; i++) {
+		if (!bin_stage[i].name[0]) {
+			if (!free_slot)
+				free_slot = &bin_stage[i];
+		} else if (!strncmp(bin_stage[i].name, name, IS_BIN_STAGE_NAME_LEN)) {
+			/* already staged */
+			mutex_unlock(&bin_stage_lock);
+			return -EEXIST;
+		}
+	}
+
+	if (!free_slot) {
+		mutex_unlock(&bin_stage_lock);
+		return -ENOSPC;
+	}
+
+	strlcpy(free_slot->name, name, IS_BIN_STAGE_NAME_LEN);
+	free_slot->bin = *bin;
+	mutex_unlock(&bin_stage_lock);
+
+	return 0;
+}
+
+/**
+  * take_staged_binary: hand a staged binary over to its first request
+  * @bin: pointer to fimc_is_binary structure to fill
+  * @name: name of binary file
+  **/
+int take_staged_binary(struct fimc_is_binary *bin, const char *name)
+{
+	int ret = -ENOENT;
+	int i;
+
+	mutex_lock(&bin_stage_lock);
+	for (i = 0; i < IS_BIN_STAGE_MAX; i++) {
+		if (!bin_stage[i].name[0] ||
+			strncmp(bin_stage[i].name, name, IS_BIN_STAGE_NAME_LEN))
+			continue;
+
+		bin->data = bin_stage[i].bin.data;
+		bin->size = bin_stage[i].bin.size;
+		bin->fw = bin_stage[i].bin.fw;
+		bin->free = bin_stage[i].bin.free;
+		memset(&bin_stage[i], 0, sizeof(bin_stage[i]));
+		ret = 0;
+		break;
+	}
+	mutex_unlock(&bin_stage_lock);
+
+	return ret;
+}
+
+/**
+  * nr_staged_binaries: count binaries waiting for their first request
+  **/
+int nr_staged_binaries(void)
+{
+	int nr = 0;
+	int i;
+
+	mutex_lock(&bin_stage_lock);
+	for (i = 0; i < IS_BIN_STAGE_MAX; i++)
+		if (bin_stage[i].name[0])
+			nr++;
+	mutex_unlock(&bin_stage_lock);
+
+	return nr;
+}
+
+/**
+  * drop_staged_binaries: release every binary not requested yet
+  **/
+void drop_staged_binaries(void)
+{
+	int i;
+
+	mutex_lock(&bin_stage_lock);
+	for (i = 0; i < IS_BIN_STAGE_MAX; i++) {
+		if (!bin_stage[i].name[0])
+			continue;
+
+		release_binary(&bin_stage[i].bin);
+		memset(&bin_stage[i], 0, sizeof(bin_stage[i]));
+	}
+	mutex_unlock(&bin_stage_lock);
+}
+
  /**
   * request_binary: send loading request to the loader
   * @bin: pointer to fimc_is_binary structure
@@ -252,6 +360,10 @@ int request_binary(struct fimc_is_binary *bin, const char *path,
 		retry_err = bin->retry_err;
 	}
 
+	/* already read ahead by the stage */
+	if (!take_staged_binary(bin, name))
+		return 0;
+
 	/* read the requested binary from file system directly */
 	if (path) {
 		filename = __getname();
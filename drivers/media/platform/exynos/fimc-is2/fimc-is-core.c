@@ -1589,6 +1589,7 @@ static struct platform_driver fimc_is_driver = {
 	.driver = {
 		.name	= FIMC_IS_DRV_NAME,
 		.owner	= THIS_MODULE,
+		.probe_type	= PROBE_PREFER_ASYNCHRONOUS,
 		.pm	= &fimc_is_pm_ops,
 		.of_match_table = exynos_fimc_is_match,
 	}
@@ -1601,6 +1602,7 @@ static struct platform_driver fimc_is_driver = {
 	.driver = {
 		.name	= FIMC_IS_DRV_NAME,
 		.owner	= THIS_MODULE,
+		.probe_type	= PROBE_PREFER_ASYNCHRONOUS,
 		.pm	= &fimc_is_pm_ops,
 	}
 };
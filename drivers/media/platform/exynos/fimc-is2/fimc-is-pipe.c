@@ -28,6 +28,7 @@ int fimc_is_pipe_probe(struct fimc_is_pipe *pipe)
 
 	pipe->src = NULL;
 	pipe->dst = NULL;
+	seqcount_init(&pipe->stats_seq);
 
 	for (i = 0; i < PIPE_SLOT_MAX; i++)
 		pipe->vctx[i] = NULL;
@@ -378,7 +379,7 @@ static int fimc_is_pipe_dqbuf(struct fimc_is_video_ctx *vctx,
 	bool blocking)
 {
 	int ret = 0;
-	unsigned long flags;
+	unsigned int seq;
 	int index, src_findex, capture_id;
 
 	struct fimc_is_device_ischain *device;
@@ -421,7 +422,6 @@ static int fimc_is_pipe_dqbuf(struct fimc_is_video_ctx *vctx,
 		/* Source */
 		ret = fimc_is_video_dqbuf(src_vctx, buf, blocking);
 		src_framemgr = GET_FRAMEMGR(src_vctx);
-		dst_framemgr = GET_FRAMEMGR(dst_vctx);
 		src_frame = &src_framemgr->frames[buf->index];
 
 		if (ret) {
@@ -429,12 +429,15 @@ static int fimc_is_pipe_dqbuf(struct fimc_is_video_ctx *vctx,
 		} else if (!(buf->flags & V4L2_BUF_FLAG_ERROR)) {
 			/*
 			 * In case of giving a feedback(dynamic meta) from dst to src,
-			 * the integrity has to be guaranteed with a spinlock.
-			 * For this process, dst's framemgr spinlock can be used.
+			 * the integrity is guaranteed by the seqcount, a done of dst
+			 * in the middle of the copy makes it retry. dst's framemgr
+			 * is not locked so that its shot done is never held off.
 			 */
-			framemgr_e_barrier_irqs(dst_framemgr, pipe->id, flags);
-			memcpy(&src_frame->shot->dm.stats, &pipe->pipe_dm.stats, sizeof(struct camera2_stats_dm));
-			framemgr_x_barrier_irqr(dst_framemgr, pipe->id, flags);
+			do {
+				seq = read_seqcount_begin(&pipe->stats_seq);
+				memcpy(&src_frame->shot->dm.stats, &pipe->pipe_stats,
+					sizeof(struct camera2_stats_dm));
+			} while (read_seqcount_retry(&pipe->stats_seq, seq));
 		}
 
 		/*
@@ -593,8 +596,10 @@ static int fimc_is_pipe_done(struct fimc_is_video_ctx *vctx,
 		dst_framemgr = GET_FRAMEMGR(dst_vctx);
 		dst_frame = &dst_framemgr->frames[index];
 
-		/* dm meta copy */
-		memcpy(&pipe->pipe_dm, &dst_frame->shot->dm, sizeof(struct camera2_dm));
+		/* only the stats are fed back, see fimc_is_pipe_dqbuf() */
+		write_seqcount_begin(&pipe->stats_seq);
+		memcpy(&pipe->pipe_stats, &dst_frame->shot->dm.stats, sizeof(struct camera2_stats_dm));
+		write_seqcount_end(&pipe->stats_seq);
 	}
 
 	ret = fimc_is_video_buffer_done(vctx, index, state);
@@ -11,6 +11,8 @@
 #ifndef FIMC_IS_PIPE_H
 #define FIMC_IS_PIPE_H
 
+#include <linux/seqlock.h>
+
 #include "fimc-is-groupmgr.h"
 
 #define FIMC_IS_MAX_PIPE_BUFS (5)
@@ -27,8 +29,13 @@ struct fimc_is_pipe {
 	struct fimc_is_group *src;
 	struct fimc_is_group *dst;
 	struct fimc_is_video_ctx *vctx[PIPE_SLOT_MAX];
-	struct camera2_dm pipe_dm;
-	struct camera2_udm pipe_udm;
+	/*
+	 * dm.stats of the last destination shot, fed back to the source.
+	 * Written at the destination's buffer done, under its framemgr lock,
+	 * and read at the source's dqbuf without taking that lock.
+	 */
+	struct camera2_stats_dm pipe_stats;
+	seqcount_t stats_seq;
 	struct v4l2_buffer buf[PIPE_SLOT_MAX][FIMC_IS_MAX_PIPE_BUFS];
 	struct v4l2_plane planes[PIPE_SLOT_MAX][FIMC_IS_MAX_PIPE_BUFS][FIMC_IS_MAX_PLANES];
 };
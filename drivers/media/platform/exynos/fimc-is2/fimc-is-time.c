@@ -114,6 +114,9 @@ void monitor_init(struct fimc_is_time *time)
 	time->time4_cur = 0;
 	time->time4_old = 0;
 	time->time4_tot = 0;
+	time->late_s = 0;
+	time->late_sd = 0;
+	time->late_d = 0;
 }
 
 static void monitor_report(void *group_data,
@@ -147,8 +150,10 @@ static void monitor_report(void *group_data,
 	/* Shot kthread */
 	if (!frame->result && mp[TMS_Q].check && mp[TMS_SHOT1].check) {
 		temp_s = (mp[TMS_SHOT1].time - mp[TMS_Q].time) / 1000;
-		if (!test_bit(FIMC_IS_GROUP_OTF_INPUT, &group->state) && temp_s > ctime)
+		if (!test_bit(FIMC_IS_GROUP_OTF_INPUT, &group->state) && temp_s > ctime) {
+			time->late_s++;
 			mgrinfo("[TIM] late S(%llu us > %llu us)\n", device, group, frame, temp_s, ctime);
+		}
 		if (time->t_dq[f_dqq])
 			temp_dqq = (mp[TMS_Q].time - time->t_dq[f_dqq]) / 1000;
 	} else {
@@ -163,8 +168,10 @@ static void monitor_report(void *group_data,
 
 	if (!frame->result && mp[shotindex].check && mp[TMS_SDONE].check) {
 		temp_sd = (mp[TMS_SDONE].time - mp[shotindex].time) / 1000;
-		if (temp_sd > fduration)
+		if (temp_sd > fduration) {
+			time->late_sd++;
 			mgrinfo("[TIM] late S-D(%llu us > %llu us)\n", device, group, frame, temp_sd, fduration);
+		}
 	} else {
 		valid = false;
 	}
@@ -172,8 +179,10 @@ static void monitor_report(void *group_data,
 	/* Done - Deque */
 	if (!frame->result && mp[TMS_SDONE].check && mp[TMS_DQ].check) {
 		temp_d = (mp[TMS_DQ].time - mp[TMS_SDONE].time) / 1000;
-		if (temp_d > dtime)
+		if (temp_d > dtime) {
+			time->late_d++;
 			mgrinfo("[TIM] late D(%llu us > %llu us)\n", device, group, frame, temp_d, dtime);
+		}
 		if (group->gnext)
 			group->gnext->time.t_dq[f_dqq] = mp[TMS_DQ].time;
 	} else {
@@ -226,12 +235,13 @@ static void monitor_report(void *group_data,
 
 	shot_to_shot = time->time4_tot / avg_cnt;
 
-	mginfo("[TIM] DQ-Q(avg: %05llu max: %05llu), S(avg: %05llu max: %05llu), S-D(avg: %05llu max: %05llu), D(avg: %05llu max: %05llu): %llu(%llufps)\n",
+	mginfo("[TIM] DQ-Q(avg: %05llu max: %05llu), S(avg: %05llu max: %05llu), S-D(avg: %05llu max: %05llu), D(avg: %05llu max: %05llu), late(%u/%u/%u): %llu(%llufps)\n",
 		device, group,
 		time->t_dqq_tot / avg_cnt, time->t_dqq_max,
 		time->time1_tot / avg_cnt, time->time1_max,
 		time->time2_tot / avg_cnt, time->time2_max,
 		time->time3_tot / avg_cnt, time->time3_max,
+		time->late_s, time->late_sd, time->late_d,
 		shot_to_shot, 1000000 / shot_to_shot);
 
 	time->time_count = 0;
@@ -240,6 +250,9 @@ static void monitor_report(void *group_data,
 	time->time2_tot = 0;
 	time->time3_tot = 0;
 	time->time4_tot = 0;
+	time->late_s = 0;
+	time->late_sd = 0;
+	time->late_d = 0;
 }
 #endif
 
@@ -52,6 +52,10 @@ struct fimc_is_time {
 	unsigned long long time4_cur;
 	unsigned long long time4_old;
 	unsigned long long time4_tot;
+	/* shots over the late threshold of each stage since the last report */
+	u32 late_s;
+	u32 late_sd;
+	u32 late_d;
 };
 
 struct fimc_is_interface_time {
@@ -187,6 +187,10 @@ struct is_bin_ver_info {
 #define IS_BIN_LIB_HINT_DDK	0
 #define IS_BIN_LIB_HINT_RTA	1
 
+/* binaries kept by the stage until their first request */
+#define IS_BIN_STAGE_MAX	4
+#define IS_BIN_STAGE_NAME_LEN	64
+
 struct fimc_is_binary {
 	void *data;
 	size_t size;
@@ -214,6 +218,10 @@ void setup_binary_loader(struct fimc_is_binary *bin,
 int request_binary(struct fimc_is_binary *bin, const char *path,
 				const char *name, struct device *device);
 void release_binary(struct fimc_is_binary *bin);
+int stage_binary(struct fimc_is_binary *bin, const char *name);
+int take_staged_binary(struct fimc_is_binary *bin, const char *name);
+int nr_staged_binaries(void);
+void drop_staged_binaries(void);
 int was_loaded_by(struct fimc_is_binary *bin);
 
 /* FIXME: void carve_binary_version(enum is_bin_type type, int hint, struct fimc_is_binary *bin); */
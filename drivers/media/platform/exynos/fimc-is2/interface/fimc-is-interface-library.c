@@ -13,6 +13,8 @@
 #include <linux/mm.h>
 #include <linux/kallsyms.h>
 #include <linux/stacktrace.h>
+#include <linux/moduleparam.h>
+#include <linux/workqueue.h>
 
 #include <asm/cacheflush.h>
 #include <asm/pgtable.h>
@@ -33,6 +35,23 @@ struct fimc_is_lib_support gPtr_lib_support;
 struct mutex gPtr_bin_load_ctrl;
 extern struct fimc_is_lib_vra *g_lib_vra;
 
+/*
+ * Library binaries are read into the binary stage once the boot settles,
+ * so that the first camera open only copies them into the library region.
+ */
+static uint lib_stage_delay_ms = 10000;
+module_param(lib_stage_delay_ms, uint, 0644);
+static uint lib_first_load_us;
+module_param(lib_first_load_us, uint, 0444);
+static uint lib_last_load_us;
+module_param(lib_last_load_us, uint, 0444);
+static bool lib_first_load_staged;
+module_param(lib_first_load_staged, bool, 0444);
+
+#define LIB_STAGE_RETRY_MAX	6
+static struct delayed_work lib_stage_work;
+static int lib_stage_retry;
+
 /*
  * Log write
  */
@@ -2438,10 +2457,90 @@ int fimc_is_load_rta_bin(int loadType)
 	return ret;
 }
 
+static void fimc_is_lib_stage_one(const char *path1, const char *path2,
+	const char *name, struct device *device)
+{
+	struct fimc_is_binary bin;
+	int ret;
+
+	setup_binary_loader(&bin, 0, 0, NULL, NULL);
+#ifdef CAMERA_FW_LOADING_FROM
+	if (path2)
+		ret = fimc_is_vender_request_binary(&bin, path1, path2, name, device);
+	else
+#endif
+		ret = request_binary(&bin, path1, name, device);
+	if (ret) {
+		warn_lib("failed to stage %s (%d)", name, ret);
+		return;
+	}
+
+	/* the camera was opened meanwhile, nothing left to speed up */
+	if (gPtr_lib_support.binary_load_flg || stage_binary(&bin, name))
+		release_binary(&bin);
+	else
+		info_lib("binary staged[%s] - size: %#zx\n", name, bin.size);
+}
+
+static void fimc_is_lib_stage_work_fn(struct work_struct *data)
+{
+	struct fimc_is_lib_support *lib = &gPtr_lib_support;
+	struct device *device;
+
+	if (lib->binary_load_flg)
+		return;
+
+	if (!lib->pdev
+#ifdef CAMERA_FW_LOADING_FROM
+		|| !lib->fw_name[0]
+#endif
+		) {
+		/* the binary names are known only after the sensor check */
+		if (++lib_stage_retry < LIB_STAGE_RETRY_MAX)
+			schedule_delayed_work(&lib_stage_work,
+				msecs_to_jiffies(lib_stage_delay_ms));
+		return;
+	}
+	device = &lib->pdev->dev;
+
+#ifdef CAMERA_FW_LOADING_FROM
+	fimc_is_lib_stage_one(FIMC_IS_ISP_LIB_SDCARD_PATH, FIMC_IS_FW_DUMP_PATH,
+		lib->fw_name, device);
+#else
+	fimc_is_lib_stage_one(FIMC_IS_ISP_LIB_SDCARD_PATH, NULL,
+		FIMC_IS_ISP_LIB, device);
+#endif
+#ifndef USE_ONE_BINARY
+	fimc_is_lib_stage_one(FIMC_IS_ISP_LIB_SDCARD_PATH, NULL,
+		FIMC_IS_VRA_LIB, device);
+#endif
+#ifdef USE_RTA_BINARY
+#ifdef CAMERA_FW_LOADING_FROM
+	fimc_is_lib_stage_one(FIMC_IS_ISP_LIB_SDCARD_PATH, FIMC_IS_FW_DUMP_PATH,
+		lib->rta_fw_name, device);
+#else
+	fimc_is_lib_stage_one(FIMC_IS_ISP_LIB_SDCARD_PATH, NULL,
+		FIMC_IS_RTA_LIB, device);
+#endif
+#endif
+}
+
+static void fimc_is_lib_stage_start(void)
+{
+	if (!lib_stage_delay_ms)
+		return;
+
+	lib_stage_retry = 0;
+	schedule_delayed_work(&lib_stage_work,
+		msecs_to_jiffies(lib_stage_delay_ms));
+}
+
 int fimc_is_load_bin(void)
 {
 	int ret = 0;
 	struct fimc_is_lib_support *lib = &gPtr_lib_support;
+	bool staged;
+	u64 start;
 
 	info_lib("binary load start\n");
 
@@ -2450,7 +2549,9 @@ int fimc_is_load_bin(void)
 		return ret;
 	}
 
+	start = ktime_get_ns();
 	fimc_is_load_ctrl_lock();
+	staged = nr_staged_binaries() > 0;
 #ifdef USE_TZ_CONTROLLED_MEM_ATTRIBUTE
 	if (gPtr_lib_support.binary_code_load_flg & BINARY_LOAD_DDK_DONE) {
 		ret = fimc_is_load_ddk_bin(BINARY_LOAD_DATA);
@@ -2521,7 +2622,14 @@ int fimc_is_load_bin(void)
 	spin_lock_init(&lib->slock_nmb);
 	INIT_LIST_HEAD(&lib->list_of_nmb);
 
-	info_lib("binary load done\n");
+	lib_last_load_us = div_u64(ktime_get_ns() - start, NSEC_PER_USEC);
+	if (!lib_first_load_us) {
+		lib_first_load_us = lib_last_load_us;
+		lib_first_load_staged = staged;
+	}
+
+	info_lib("binary load done (%u us%s)\n", lib_last_load_us,
+		staged ? ", staged" : "");
 
 	return 0;
 }
@@ -2531,6 +2639,9 @@ void fimc_is_load_ctrl_init(void)
 	mutex_init(&gPtr_bin_load_ctrl);
 	spin_lock_init(&gPtr_lib_support.slock_debug);
 	gPtr_lib_support.binary_code_load_flg = 0;
+
+	INIT_DELAYED_WORK(&lib_stage_work, fimc_is_lib_stage_work_fn);
+	fimc_is_lib_stage_start();
 }
 
 void fimc_is_load_ctrl_lock(void)
@@ -2568,6 +2679,9 @@ int fimc_is_load_bin_on_boot(void)
 			gPtr_lib_support.binary_code_load_flg |= BINARY_LOAD_RTA_DONE;
 	}
 
+	/* the code load above used up the stage, read the data ahead again */
+	fimc_is_lib_stage_start();
+
 	return ret;
 }
 
@@ -182,6 +182,15 @@ struct g2d1shot_dev {
 
 	unsigned int num_rec;
 
+	/* bytes transferred by the current run and saved by merging */
+	u64 run_bytes;
+	u64 run_saved_bytes;
+	/* accumulated over all runs */
+	unsigned long nr_runs;
+	unsigned long nr_merged;
+	u64 total_bytes;
+	u64 total_saved_bytes;
+
 	struct mutex			lock_qos;
 	struct list_head		qos_contexts;
 	struct work_struct		work;
@@ -339,7 +348,7 @@ void g2d_hw_set_source_format(struct g2d1shot_dev *g2d_dev, int n,
 void g2d_hw_set_dest_addr(struct m2m1shot2_context *ctx,
 		struct m2m1shot2_context_format *ctx_fmt,
 		struct g2d1shot_dev *g2d_dev, bool compressed);
-void g2d_hw_set_source_address(struct m2m1shot2_context *ctx,
+void g2d_hw_set_source_address(struct m2m1shot2_context *ctx, int index,
 		struct m2m1shot2_context_format *ctx_fmt,
 		struct g2d1shot_dev *g2d_dev, int n, bool compressed);
 void g2d_hw_set_source_repeat(struct g2d1shot_dev *g2d_dev, int n,
@@ -353,7 +362,7 @@ void g2d_hw_set_source_valid(struct g2d1shot_dev *g2d_dev, int n);
 void g2d_hw_set_dest_format(struct g2d1shot_dev *g2d_dev,
 		struct m2m1shot2_context_format *ctx_fmt, u32 flags);
 void g2d_hw_set_dest_premult(struct g2d1shot_dev *g2d_dev, u32 flags);
-void g2d_hw_set_source_ycbcr(struct g2d1shot_ctx *g2d_ctx,
+void g2d_hw_set_source_ycbcr(struct g2d1shot_ctx *g2d_ctx, int index,
 	int n, struct m2m1shot2_context_format *ctx_fmt);
 void g2d_hw_set_dest_ycbcr(struct g2d1shot_dev *g2d_dev,
 	struct m2m1shot2_context_format *ctx_fmt);
@@ -34,6 +34,9 @@ module_param(g2d_debug, int, S_IRUGO | S_IWUSR);
 int g2d_dump;
 module_param(g2d_dump, int, S_IRUGO | S_IWUSR);
 
+static int g2d_merge = 1;
+module_param(g2d_merge, int, S_IRUGO | S_IWUSR);
+
 static void g2d_pm_qos_update_cpufreq(struct g2d_qos_reqs *reqs,
 				u32 freq_c1, u32 freq_c0)
 {
@@ -1060,12 +1063,13 @@ static int disable_g2d(struct g2d1shot_dev *g2d_dev)
 	return 0;
 }
 
+/* program source @index of @ctx to the H/W layer @layer_num */
 static void g2d_set_source(struct g2d1shot_dev *g2d_dev,
-		struct m2m1shot2_context *ctx,
-		struct m2m1shot2_source_image *source, int layer_num)
+		struct m2m1shot2_context *ctx, int index, int layer_num)
 {
+	struct m2m1shot2_source_image *source = &ctx->source[index];
 	struct m2m1shot2_context_format *ctx_fmt =
-				m2m1shot2_src_format(ctx, layer_num);
+				m2m1shot2_src_format(ctx, index);
 	struct g2d1shot_ctx *g2d_ctx = ctx->priv;
 	u32 src_type = G2D_LAYER_SELECT_NORMAL;
 	u32 img_flags = source->img.flags;
@@ -1082,7 +1086,8 @@ static void g2d_set_source(struct g2d1shot_dev *g2d_dev,
 		g2d_hw_set_source_premult(g2d_dev, layer_num, img_flags);
 		g2d_hw_set_source_blending(g2d_dev, layer_num, &source->ext);
 		/* set source address */
-		g2d_hw_set_source_address(ctx, ctx_fmt, g2d_dev, layer_num, compressed);
+		g2d_hw_set_source_address(ctx, index, ctx_fmt, g2d_dev,
+						layer_num, compressed);
 		/* set repeat mode */
 		g2d_hw_set_source_repeat(g2d_dev, layer_num, &source->ext);
 		/* set scaling mode */
@@ -1092,7 +1097,7 @@ static void g2d_set_source(struct g2d1shot_dev *g2d_dev,
 		/* set rotation mode */
 		g2d_hw_set_source_rotate(g2d_dev, layer_num, &source->ext);
 		/* set ycbcr mode */
-		g2d_hw_set_source_ycbcr(g2d_ctx, layer_num, ctx_fmt);
+		g2d_hw_set_source_ycbcr(g2d_ctx, index, layer_num, ctx_fmt);
 	}
 
 	/* set source type */
@@ -1133,9 +1138,10 @@ static int m2m1shot2_g2d_device_run(struct m2m1shot2_context *ctx)
 {
 	struct g2d1shot_ctx *g2d_ctx = ctx->priv;
 	struct g2d1shot_dev *g2d_dev = g2d_ctx->g2d_dev;
+	struct m2m1shot2_context *merged = NULL;
 	unsigned long flags;
 	int ret;
-	int i;
+	int i, n;
 
 	g2d_dbg_begin();
 
@@ -1166,7 +1172,31 @@ static int m2m1shot2_g2d_device_run(struct m2m1shot2_context *ctx)
 
 	/* setting for source */
 	for (i = 0; i < ctx->num_sources; i++)
-		g2d_set_source(g2d_dev, ctx, &ctx->source[i], i);
+		g2d_set_source(g2d_dev, ctx, i, i);
+
+	g2d_dev->run_bytes = g2d_composition_bytes(ctx, 0, true);
+	g2d_dev->run_saved_bytes = 0;
+
+	/*
+	 * stack the layers of the next job above ours if its bottom layer is
+	 * just our target. Its target is ours, so it is not programmed.
+	 */
+	if (g2d_merge)
+		merged = m2m1shot2_merge_next_context(ctx->m21dev,
+							g2d_can_merge);
+	if (merged) {
+		for (i = 1, n = ctx->num_sources; i < merged->num_sources; i++)
+			g2d_set_source(g2d_dev, merged, i, n++);
+
+		g2d_dev->run_bytes += g2d_composition_bytes(merged, 1, false);
+		g2d_dev->run_saved_bytes = g2d_composition_bytes(ctx, 0, true) +
+			g2d_composition_bytes(merged, 0, true) -
+			g2d_dev->run_bytes;
+		g2d_dev->nr_merged++;
+	}
+	g2d_dev->nr_runs++;
+	g2d_dev->total_bytes += g2d_dev->run_bytes;
+	g2d_dev->total_saved_bytes += g2d_dev->run_saved_bytes;
 
 	/* setting for destination */
 	g2d_set_target(g2d_dev, ctx, &ctx->target);
@@ -1180,6 +1210,8 @@ static int m2m1shot2_g2d_device_run(struct m2m1shot2_context *ctx)
 
 	if (g2d_dump) {
 		g2d_disp_info(ctx);
+		if (merged)
+			g2d_disp_info(merged);
 		g2d_dump_regs(g2d_dev);
 	}
 
@@ -1287,6 +1319,9 @@ static irqreturn_t exynos_g2d_irq_handler(int irq, void *priv)
 		g2d_info("G2D_operation time = %llu.%06llu ms\n",
 					m21ctx->work_delay_in_nsec / 1000000,
 					m21ctx->work_delay_in_nsec % 1000000);
+		g2d_info("G2D_operation bytes = %llu (%llu saved by merging)\n",
+					g2d_dev->run_bytes,
+					g2d_dev->run_saved_bytes);
 	}
 
 	m2m1shot2_finish_context(m21ctx, status);
@@ -1544,6 +1579,18 @@ static int exynos_g2d_reboot_notifier(struct notifier_block *nb,
 	return 0;
 }
 
+static ssize_t composition_show(struct device *dev,
+				struct device_attribute *attr, char *buf)
+{
+	struct g2d1shot_dev *g2d_dev = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE,
+		"runs: %lu\nmerged: %lu\nbytes: %llu\nsaved_bytes: %llu\n",
+		g2d_dev->nr_runs, g2d_dev->nr_merged,
+		g2d_dev->total_bytes, g2d_dev->total_saved_bytes);
+}
+static DEVICE_ATTR_RO(composition);
+
 static int exynos_g2d_probe(struct platform_device *pdev)
 {
 	struct g2d1shot_dev *g2d_dev;
@@ -1627,6 +1674,9 @@ static int exynos_g2d_probe(struct platform_device *pdev)
 	g2d_dev->reboot_notifier.notifier_call = exynos_g2d_reboot_notifier;
 	register_reboot_notifier(&g2d_dev->reboot_notifier);
 
+	if (device_create_file(&pdev->dev, &dev_attr_composition))
+		dev_err(&pdev->dev, "Failed to create composition attribute\n");
+
 	dev_info(&pdev->dev, "G2D with m2m1shot2 is probed successfully.\n");
 
 	return 0;
@@ -1642,6 +1692,7 @@ static int exynos_g2d_remove(struct platform_device *pdev)
 {
 	struct g2d1shot_dev *g2d_dev = platform_get_drvdata(pdev);
 
+	device_remove_file(&pdev->dev, &dev_attr_composition);
 	unregister_pm_notifier(&g2d_dev->pm_notifier);
 
 	m2m1shot2_destroy_device(g2d_dev->oneshot2_dev);
@@ -147,6 +147,120 @@ static void _g2d_disp_target(struct m2m1shot2_context *ctx)
 			(unsigned long)m2m1shot2_dst_dma_addr(ctx, i));
 }
 
+static bool g2d_same_buffer(struct m2m1shot2_context_image *a,
+			    struct m2m1shot2_context_image *b)
+{
+	int i;
+
+	if (a->memory != b->memory || a->num_planes != b->num_planes)
+		return false;
+
+	for (i = 0; i < a->num_planes; i++) {
+		if (a->memory == M2M1SHOT2_BUFTYPE_DMABUF) {
+			if (a->plane[i].dmabuf.dmabuf != b->plane[i].dmabuf.dmabuf ||
+			    a->plane[i].dmabuf.offset != b->plane[i].dmabuf.offset)
+				return false;
+		} else if (a->memory == M2M1SHOT2_BUFTYPE_USERPTR) {
+			if (a->plane[i].userptr.addr != b->plane[i].userptr.addr)
+				return false;
+		} else {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * SurfaceFlinger composes more layers than the H/W has by blending a group of
+ * them into the target and then blending the target, as the bottom layer, with
+ * the next group into the same target. If the next job is such a job, its
+ * layers are stacked on the layers of @cur in a single H/W run and the target
+ * is neither written nor read in between.
+ * It is called with the lock of m2m1shot2 held and only looks at the images.
+ */
+bool g2d_can_merge(struct m2m1shot2_context *cur, struct m2m1shot2_context *next)
+{
+	struct m2m1shot2_context_image *dst = &cur->target;
+	struct m2m1shot2_source_image *bottom = &next->source[0];
+	struct m2m1shot2_format *dst_fmt = &dst->fmt.fmt;
+	struct m2m1shot2_format *fmt = &bottom->img.fmt.fmt;
+	const u32 nocopy = M2M1SHOT2_IMGFLAG_COMPRESSED |
+			M2M1SHOT2_IMGFLAG_SECURE | M2M1SHOT2_IMGFLAG_COLORFILL;
+	int i;
+
+	if (cur->num_sources + next->num_sources - 1 > G2D_MAX_SOURCES)
+		return false;
+
+	if ((cur->flags ^ next->flags) & M2M1SHOT2_FLAG_DITHER)
+		return false;
+
+	/* both write the same buffer in the same way */
+	if (((dst->flags | next->target.flags) & nocopy) ||
+	    ((dst->flags ^ next->target.flags) & M2M1SHOT2_IMGFLAG_PREMUL_ALPHA) ||
+	    !g2d_same_buffer(dst, &next->target) ||
+	    memcmp(dst_fmt, &next->target.fmt.fmt, sizeof(*dst_fmt)) ||
+	    dst->fmt.colorspace != next->target.fmt.colorspace)
+		return false;
+
+	/* the bottom layer of next is a plain copy of what cur writes */
+	if ((bottom->img.flags & nocopy) ||
+	    ((bottom->img.flags ^ dst->flags) & M2M1SHOT2_IMGFLAG_PREMUL_ALPHA) ||
+	    !g2d_same_buffer(dst, &bottom->img) ||
+	    fmt->pixelformat != dst_fmt->pixelformat ||
+	    memcmp(&fmt->crop, &dst_fmt->crop, sizeof(fmt->crop)) ||
+	    memcmp(&fmt->window, &dst_fmt->crop, sizeof(fmt->window)) ||
+	    bottom->ext.transform || bottom->ext.galpha != 0xff ||
+	    (bottom->ext.composit_mode != M2M1SHOT2_BLEND_SRC &&
+	     bottom->ext.composit_mode != M2M1SHOT2_BLEND_SRCOVER))
+		return false;
+
+	/* the csc coefficients of next are not programmed */
+	for (i = 1; i < next->num_sources; i++) {
+		struct g2d1shot_fmt *g2d_fmt = next->source[i].img.fmt.priv;
+
+		if ((next->source[i].img.flags & M2M1SHOT2_IMGFLAG_SECURE) ||
+		    is_yuv(g2d_fmt->value))
+			return false;
+	}
+
+	return true;
+}
+
+static u64 g2d_image_bytes(struct m2m1shot2_context_image *img,
+			   struct v4l2_rect *rect)
+{
+	struct g2d1shot_fmt *g2d_fmt = img->fmt.priv;
+	u64 bits = 0;
+	int i;
+
+	if (img->flags & M2M1SHOT2_IMGFLAG_COLORFILL)
+		return 0;
+
+	for (i = 0; i < g2d_fmt->num_planes; i++)
+		bits += g2d_fmt->bpp[i];
+
+	return (u64)rect->width * rect->height * bits / 8;
+}
+
+/* bytes read from the sources from @first and written to the target */
+u64 g2d_composition_bytes(struct m2m1shot2_context *ctx, int first,
+			  bool target)
+{
+	u64 bytes = 0;
+	int i;
+
+	for (i = first; i < ctx->num_sources; i++)
+		bytes += g2d_image_bytes(&ctx->source[i].img,
+					&ctx->source[i].img.fmt.fmt.crop);
+
+	if (target)
+		bytes += g2d_image_bytes(&ctx->target,
+					&ctx->target.fmt.fmt.crop);
+
+	return bytes;
+}
+
 int g2d_disp_info(struct m2m1shot2_context *ctx)
 {
 	int i;
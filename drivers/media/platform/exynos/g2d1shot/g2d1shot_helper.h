@@ -47,4 +47,8 @@ do {									\
 
 void g2d_dump_regs(struct g2d1shot_dev *g2d_dev);
 int g2d_disp_info(struct m2m1shot2_context *ctx);
+bool g2d_can_merge(struct m2m1shot2_context *cur,
+		   struct m2m1shot2_context *next);
+u64 g2d_composition_bytes(struct m2m1shot2_context *ctx, int first,
+			  bool target);
 #endif /* __EXYNOS_G2D1SHOT_HELPER_H_ */
@@ -287,12 +287,12 @@ void g2d_hw_set_source_format(struct g2d1shot_dev *g2d_dev, int n,
 	}
 }
 
-void g2d_hw_set_source_address(struct m2m1shot2_context *ctx,
+void g2d_hw_set_source_address(struct m2m1shot2_context *ctx, int index,
 		struct m2m1shot2_context_format *ctx_fmt,
 		struct g2d1shot_dev *g2d_dev, int n, bool compressed)
 {
 	struct g2d1shot_fmt *fmt = ctx_fmt->priv;
-	dma_addr_t addr = m2m1shot2_src_dma_addr(ctx, n, 0);
+	dma_addr_t addr = m2m1shot2_src_dma_addr(ctx, index, 0);
 
 	if (compressed) {
 		__raw_writel(addr,
@@ -311,7 +311,7 @@ void g2d_hw_set_source_address(struct m2m1shot2_context *ctx,
 				addr_cb = NV12N_10B_CBCR_BASE(addr, w, h);
 			} else if (fmt->pixelformat == V4L2_PIX_FMT_NV12M ||
 				(fmt->pixelformat == V4L2_PIX_FMT_NV21M)) {
-				addr_cb = m2m1shot2_src_dma_addr(ctx, n, 1);
+				addr_cb = m2m1shot2_src_dma_addr(ctx, index, 1);
 			} else { /* contiguous format */
 				addr_cb = addr + w * h;
 			}
@@ -728,7 +728,7 @@ void g2d_hw_set_csc_coeff(struct m2m1shot2_context *ctx)
 	}
 }
 
-void g2d_hw_set_source_ycbcr(struct g2d1shot_ctx *g2d_ctx, int n,
+void g2d_hw_set_source_ycbcr(struct g2d1shot_ctx *g2d_ctx, int index, int n,
 	struct m2m1shot2_context_format *ctx_fmt)
 {
 	u32 cfg = 0;
@@ -741,7 +741,7 @@ void g2d_hw_set_source_ycbcr(struct g2d1shot_ctx *g2d_ctx, int n,
 
 	g2d_csc_fmt = find_colorspace(ctx_fmt->colorspace);
 	cfg = g2d_csc_fmt->range << G2D_LAYER_YCBCR_RANGE_SHIFT |
-			g2d_ctx->src_csc_value[n];
+			g2d_ctx->src_csc_value[index];
 
 	__raw_writel(cfg, g2d_dev->reg + G2D_LAYERn_YCBCR_MODE_REG(n));
 }
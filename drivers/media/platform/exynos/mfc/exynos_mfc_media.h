@@ -483,4 +483,8 @@ enum v4l2_mpeg_video_hevc_hierarchical_coding_type {
 #define V4L2_CID_MPEG_VIDEO_TRANSFER_CHARACTERISTICS		\
 					(V4L2_CID_MPEG_MFC_BASE + 231)
 
+/* Scheduling class: 0 realtime, 1 normal, 2 batch */
+#define V4L2_CID_MPEG_VIDEO_PRIORITY				\
+					(V4L2_CID_MPEG_MFC_BASE + 232)
+
 #endif /* __EXYNOS_MFC_MEDIA_H */
@@ -136,6 +136,7 @@ static int mfc_init_dec_ctx(struct s5p_mfc_ctx *ctx)
 	s5p_mfc_qos_reset_framerate(ctx);
 
 	ctx->qos_ratio = 100;
+	ctx->prio = MFC_PRIO_NORMAL;
 #ifdef CONFIG_MFC_USE_BUS_DEVFREQ
 	INIT_LIST_HEAD(&ctx->qos_list);
 #endif
@@ -253,6 +254,7 @@ static int mfc_init_enc_ctx(struct s5p_mfc_ctx *ctx)
 	s5p_mfc_qos_reset_framerate(ctx);
 
 	ctx->qos_ratio = 100;
+	ctx->prio = MFC_PRIO_NORMAL;
 
 	/* disable IVF header by default (VP8, VP9) */
 	p = &enc->params;
@@ -311,6 +313,8 @@ static int s5p_mfc_open(struct file *file)
 	int ret = 0;
 	enum s5p_mfc_node_type node;
 	struct video_device *vdev = NULL;
+	bool warm;
+	u64 open_ns;
 
 	mfc_debug(2, "mfc driver open called\n");
 
@@ -426,6 +430,8 @@ static int s5p_mfc_open(struct file *file)
 
 	/* Load firmware if this is the first instance */
 	if (dev->num_inst == 1) {
+		open_ns = ktime_get_ns();
+
 		/* set watchdog timer */
 		dev->watchdog_timer.expires = jiffies +
 					msecs_to_jiffies(WATCHDOG_TICK_INTERVAL);
@@ -443,9 +449,14 @@ static int s5p_mfc_open(struct file *file)
 			dev->fw.status = 1;
 		}
 
-		ret = s5p_mfc_load_firmware(dev);
-		if (ret)
-			goto err_fw_load;
+		/* the F/W left asleep by the last close is woken up instead */
+		warm = dev->fw.warm;
+		dev->fw.warm = 0;
+		if (!warm) {
+			ret = s5p_mfc_load_firmware(dev);
+			if (ret)
+				goto err_fw_load;
+		}
 
 #ifdef CONFIG_EXYNOS_CONTENT_PATH_PROTECTION
 		trace_mfc_dcpp_start(ctx->num, 1, dev->fw.drm_status);
@@ -494,14 +505,33 @@ static int s5p_mfc_open(struct file *file)
 		dev->preempt_ctx = MFC_NO_INSTANCE_SET;
 		dev->curr_ctx_is_drm = ctx->is_drm;
 
-		ret = s5p_mfc_init_hw(dev);
-		if (ret) {
-			mfc_err_ctx("Failed to init mfc h/w\n");
-			goto err_hw_init;
+		/* the DRM F/W has to be initialized, as after a failed wakeup */
+		if (warm && (dev->fw.drm_status || s5p_mfc_init_hw_warm(dev))) {
+			warm = false;
+			ret = s5p_mfc_load_firmware(dev);
+			if (ret)
+				goto err_hw_init;
+		}
+
+		if (!warm) {
+			ret = s5p_mfc_init_hw(dev);
+			if (ret) {
+				mfc_err_ctx("Failed to init mfc h/w\n");
+				goto err_hw_init;
+			}
 		}
 
 		s5p_mfc_release_hwlock_dev(dev);
 
+		open_ns = ktime_get_ns() - open_ns;
+		if (warm) {
+			dev->fw.nr_warm_open++;
+			dev->fw.warm_open_ns = open_ns;
+		} else {
+			dev->fw.nr_cold_open++;
+			dev->fw.cold_open_ns = open_ns;
+		}
+
 #ifdef NAL_Q_ENABLE
 		dev->nal_q_handle = s5p_mfc_nal_q_create(dev);
 		if (dev->nal_q_handle == NULL)
@@ -677,7 +707,11 @@ static int s5p_mfc_release(struct file *file)
 	dev->num_inst--;
 
 	if (dev->num_inst == 0) {
-		s5p_mfc_deinit_hw(dev);
+		if (fw_warm_resume && !dev->fw.drm_status &&
+				!atomic_read(&dev->watchdog_run))
+			s5p_mfc_deinit_hw_warm(dev);
+		else
+			s5p_mfc_deinit_hw(dev);
 		del_timer_sync(&dev->watchdog_timer);
 		del_timer_sync(&dev->mfc_idle_timer);
 
@@ -1187,6 +1221,7 @@ static int s5p_mfc_probe(struct platform_device *pdev)
 
 #ifdef CONFIG_MFC_USE_BUS_DEVFREQ
 	INIT_LIST_HEAD(&dev->qos_queue);
+	INIT_WORK(&dev->qos_tune_work, mfc_qos_tune_worker);
 #endif
 
 	/* default FW alloc is added */
@@ -1276,6 +1311,12 @@ static int s5p_mfc_probe(struct platform_device *pdev)
 		goto err_alloc_debug;
 	}
 
+	ret = s5p_mfc_init_codec_buf_cache(dev);
+	if (ret) {
+		dev_err(&pdev->dev, "failed to register codec buffer shrinker\n");
+		goto err_alloc_debug;
+	}
+
 	s5p_mfc_init_debugfs(dev);
 
 	pr_debug("%s--\n", __func__);
@@ -1365,6 +1406,7 @@ static int s5p_mfc_remove(struct platform_device *pdev)
 #ifdef CONFIG_ION_EXYNOS
 	ion_client_destroy(dev->mfc_ion_client);
 #endif
+	s5p_mfc_destroy_codec_buf_cache(dev);
 	mfc_debug(2, "Will now deinit HW\n");
 	s5p_mfc_deinit_hw(dev);
 	vb2_ion_destroy_context(dev->alloc_ctx);
@@ -223,6 +223,139 @@ void s5p_mfc_release_instance_context(struct s5p_mfc_ctx *ctx)
 	mfc_debug_leave();
 }
 
+/*
+ * Codec buffers only depend on the resolution and the codec, seeking and
+ * switching between the streams of an adaptive playback release and
+ * allocate them again and again. Released normal buffers are kept in
+ * classes of MFC_CODEC_BUF_CACHE_CLASS, up to max_size, and reused by the
+ * next allocation of the same class. Secure buffers are never kept, the
+ * secure heap is too small to hold on to.
+ */
+struct mfc_cached_buf {
+	struct list_head list;
+	void *alloc;
+	size_t size;
+};
+
+static void mfc_buf_cache_evict(struct s5p_mfc_buf_cache *cache,
+		size_t target)
+{
+	struct mfc_cached_buf *cbuf;
+
+	while (cache->size > target && !list_empty(&cache->list)) {
+		cbuf = list_last_entry(&cache->list,
+				struct mfc_cached_buf, list);
+		list_del(&cbuf->list);
+		cache->size -= cbuf->size;
+		s5p_mfc_mem_free(cbuf->alloc);
+		kfree(cbuf);
+	}
+}
+
+static void *mfc_buf_cache_get(struct s5p_mfc_buf_cache *cache, size_t size)
+{
+	struct mfc_cached_buf *cbuf;
+	void *alloc = NULL;
+
+	mutex_lock(&cache->lock);
+	list_for_each_entry(cbuf, &cache->list, list) {
+		if (cbuf->size != size)
+			continue;
+
+		list_del(&cbuf->list);
+		cache->size -= size;
+		alloc = cbuf->alloc;
+		kfree(cbuf);
+		break;
+	}
+
+	if (alloc)
+		cache->hits++;
+	else
+		cache->misses++;
+	mutex_unlock(&cache->lock);
+
+	return alloc;
+}
+
+/* Return false if the buffer is not kept and should be freed */
+static bool mfc_buf_cache_put(struct s5p_mfc_buf_cache *cache,
+		void *alloc, size_t size)
+{
+	struct mfc_cached_buf *cbuf;
+
+	if (size > cache->max_size)
+		return false;
+
+	cbuf = kmalloc(sizeof(*cbuf), GFP_KERNEL);
+	if (!cbuf)
+		return false;
+
+	cbuf->alloc = alloc;
+	cbuf->size = size;
+
+	mutex_lock(&cache->lock);
+	list_add(&cbuf->list, &cache->list);
+	cache->size += size;
+	mfc_buf_cache_evict(cache, cache->max_size);
+	mutex_unlock(&cache->lock);
+
+	return true;
+}
+
+static unsigned long mfc_buf_cache_count(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	struct s5p_mfc_buf_cache *cache = container_of(shrinker,
+			struct s5p_mfc_buf_cache, shrinker);
+
+	return READ_ONCE(cache->size) >> PAGE_SHIFT;
+}
+
+static unsigned long mfc_buf_cache_scan(struct shrinker *shrinker,
+		struct shrink_control *sc)
+{
+	struct s5p_mfc_buf_cache *cache = container_of(shrinker,
+			struct s5p_mfc_buf_cache, shrinker);
+	size_t freed, goal = sc->nr_to_scan << PAGE_SHIFT;
+
+	/* the allocation below the lock may be what is reclaiming */
+	if (!mutex_trylock(&cache->lock))
+		return SHRINK_STOP;
+
+	freed = cache->size;
+	mfc_buf_cache_evict(cache, cache->size > goal ? cache->size - goal : 0);
+	freed -= cache->size;
+	mutex_unlock(&cache->lock);
+
+	return freed >> PAGE_SHIFT;
+}
+
+int s5p_mfc_init_codec_buf_cache(struct s5p_mfc_dev *dev)
+{
+	struct s5p_mfc_buf_cache *cache = &dev->codec_buf_cache;
+
+	INIT_LIST_HEAD(&cache->list);
+	mutex_init(&cache->lock);
+	cache->max_size = MFC_CODEC_BUF_CACHE_MAX;
+	cache->shrinker.count_objects = mfc_buf_cache_count;
+	cache->shrinker.scan_objects = mfc_buf_cache_scan;
+	cache->shrinker.seeks = DEFAULT_SEEKS;
+
+	return register_shrinker(&cache->shrinker);
+}
+
+void s5p_mfc_destroy_codec_buf_cache(struct s5p_mfc_dev *dev)
+{
+	struct s5p_mfc_buf_cache *cache = &dev->codec_buf_cache;
+
+	unregister_shrinker(&cache->shrinker);
+	mutex_lock(&cache->lock);
+	mfc_buf_cache_evict(cache, 0);
+	mutex_unlock(&cache->lock);
+	mutex_destroy(&cache->lock);
+}
+
 /* Allocate codec buffers */
 int s5p_mfc_alloc_codec_buffers(struct s5p_mfc_ctx *ctx)
 {
@@ -406,8 +539,25 @@ int s5p_mfc_alloc_codec_buffers(struct s5p_mfc_ctx *ctx)
 
 	/* Allocate only if memory from bank 1 is necessary */
 	if (ctx->codec_buf.size > 0) {
-		ctx->codec_buf.alloc = s5p_mfc_mem_alloc(
-				alloc_ctx, ctx->codec_buf.size);
+		size_t alloc_size = ctx->codec_buf.size;
+
+		ctx->codec_buf.alloc = NULL;
+		if (!ctx->is_drm) {
+			alloc_size = ALIGN(alloc_size, MFC_CODEC_BUF_CACHE_CLASS);
+			ctx->codec_buf.alloc = mfc_buf_cache_get(
+					&dev->codec_buf_cache, alloc_size);
+		}
+		if (!ctx->codec_buf.alloc)
+			ctx->codec_buf.alloc = s5p_mfc_mem_alloc(
+					alloc_ctx, alloc_size);
+		if (IS_ERR(ctx->codec_buf.alloc) && !ctx->is_drm) {
+			/* what the cache holds may be what is missing */
+			mutex_lock(&dev->codec_buf_cache.lock);
+			mfc_buf_cache_evict(&dev->codec_buf_cache, 0);
+			mutex_unlock(&dev->codec_buf_cache.lock);
+			ctx->codec_buf.alloc = s5p_mfc_mem_alloc(
+					alloc_ctx, alloc_size);
+		}
 		if (IS_ERR_OR_NULL(ctx->codec_buf.alloc)) {
 			ctx->codec_buf.alloc = NULL;
 			mfc_err_ctx("Allocating codec buffer failed.\n");
@@ -454,7 +604,11 @@ void s5p_mfc_release_codec_buffers(struct s5p_mfc_ctx *ctx)
 
 	if (ctx->codec_buf.alloc) {
 		ctx->codec_buffer_allocated = 0;
-		s5p_mfc_mem_free(ctx->codec_buf.alloc);
+		if (ctx->is_drm || !mfc_buf_cache_put(&dev->codec_buf_cache,
+					ctx->codec_buf.alloc,
+					ALIGN(ctx->codec_buf.size,
+						MFC_CODEC_BUF_CACHE_CLASS)))
+			s5p_mfc_mem_free(ctx->codec_buf.alloc);
 		ctx->codec_buf.alloc = NULL;
 		ctx->codec_buf.daddr = 0;
 		ctx->codec_buf.vaddr = NULL;
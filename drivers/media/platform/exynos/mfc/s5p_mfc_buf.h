@@ -15,6 +15,10 @@
 
 #include "s5p_mfc_common.h"
 
+/* codec buffers are cached in classes of this size */
+#define MFC_CODEC_BUF_CACHE_CLASS	SZ_1M
+#define MFC_CODEC_BUF_CACHE_MAX		SZ_64M
+
 /* Memory allocation */
 int s5p_mfc_alloc_common_context(struct s5p_mfc_dev *dev);
 void s5p_mfc_release_common_context(struct s5p_mfc_dev *dev);
@@ -25,6 +29,9 @@ void s5p_mfc_release_instance_context(struct s5p_mfc_ctx *ctx);
 int s5p_mfc_alloc_codec_buffers(struct s5p_mfc_ctx *ctx);
 void s5p_mfc_release_codec_buffers(struct s5p_mfc_ctx *ctx);
 
+int s5p_mfc_init_codec_buf_cache(struct s5p_mfc_dev *dev);
+void s5p_mfc_destroy_codec_buf_cache(struct s5p_mfc_dev *dev);
+
 int s5p_mfc_alloc_enc_roi_buffer(struct s5p_mfc_ctx *ctx);
 void s5p_mfc_release_enc_roi_buffer(struct s5p_mfc_ctx *ctx);
 
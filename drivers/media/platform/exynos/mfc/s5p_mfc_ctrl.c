@@ -199,6 +199,100 @@ void s5p_mfc_deinit_hw(struct s5p_mfc_dev *dev)
 	mfc_debug(2, "mfc deinit completed\n");
 }
 
+/*
+ * Put the firmware to sleep instead of turning it off when the last instance
+ * is closed. What it keeps in the firmware buffer survives the power gating,
+ * so the next first open can wake it up with s5p_mfc_init_hw_warm() rather
+ * than load and initialize it again. Falls back to a plain deinit.
+ */
+void s5p_mfc_deinit_hw_warm(struct s5p_mfc_dev *dev)
+{
+	int ret;
+
+	mfc_debug(2, "mfc warm deinit start\n");
+
+	ret = s5p_mfc_pm_clock_on(dev);
+	if (ret) {
+		mfc_err_dev("Failed to enable clock before sleep(%d)\n", ret);
+		return;
+	}
+
+	s5p_mfc_cmd_sleep(dev);
+	if (s5p_mfc_wait_for_done_dev(dev, S5P_FIMV_R2H_CMD_SLEEP_RET)) {
+		mfc_err_dev("Failed to SLEEP, F/W will be loaded again\n");
+		s5p_mfc_clean_dev_int_flags(dev);
+		goto out;
+	}
+
+	dev->int_condition = 0;
+	if (dev->int_err != 0 || dev->int_reason != S5P_FIMV_R2H_CMD_SLEEP_RET) {
+		mfc_err_dev("Failed to sleep - error: %d int: %d.\n",
+				dev->int_err, dev->int_reason);
+		goto out;
+	}
+
+	dev->fw.warm = 1;
+
+out:
+	s5p_mfc_mfc_off(dev);
+	s5p_mfc_pm_clock_off(dev);
+
+	mfc_debug(2, "mfc warm deinit completed (asleep: %d)\n", dev->fw.warm);
+}
+
+/* Wake up the firmware put to sleep by s5p_mfc_deinit_hw_warm() */
+int s5p_mfc_init_hw_warm(struct s5p_mfc_dev *dev)
+{
+	int ret;
+
+	mfc_debug_enter();
+
+	ret = s5p_mfc_pm_clock_on(dev);
+	if (ret) {
+		mfc_err_dev("Failed to enable clock before reset(%d)\n", ret);
+		return ret;
+	}
+
+	ret = s5p_mfc_reset_mfc(dev);
+	if (ret) {
+		mfc_err_dev("Failed to reset MFC - timeout.\n");
+		goto err_init_hw_warm;
+	}
+
+	s5p_mfc_set_risc_base_addr(dev, MFCBUF_NORMAL);
+	s5p_mfc_risc_on(dev);
+
+	if (s5p_mfc_wait_for_done_dev(dev, S5P_FIMV_R2H_CMD_FW_STATUS_RET)) {
+		mfc_err_dev("Failed to RISC_ON\n");
+		s5p_mfc_clean_dev_int_flags(dev);
+		ret = -EIO;
+		goto err_init_hw_warm;
+	}
+
+	s5p_mfc_cmd_wakeup(dev);
+	if (s5p_mfc_wait_for_done_dev(dev, S5P_FIMV_R2H_CMD_WAKEUP_RET)) {
+		mfc_err_dev("Failed to WAKEUP\n");
+		s5p_mfc_clean_dev_int_flags(dev);
+		ret = -EIO;
+		goto err_init_hw_warm;
+	}
+
+	dev->int_condition = 0;
+	if (dev->int_err != 0 || dev->int_reason != S5P_FIMV_R2H_CMD_WAKEUP_RET) {
+		mfc_err_dev("Failed to wakeup - error: %d int: %d.\n",
+				dev->int_err, dev->int_reason);
+		ret = -EIO;
+	}
+
+err_init_hw_warm:
+	if (ret)
+		s5p_mfc_mfc_off(dev);
+	s5p_mfc_pm_clock_off(dev);
+	mfc_debug_leave();
+
+	return ret;
+}
+
 int s5p_mfc_sleep(struct s5p_mfc_dev *dev)
 {
 	struct s5p_mfc_ctx *ctx;
@@ -17,6 +17,8 @@
 
 int s5p_mfc_init_hw(struct s5p_mfc_dev *dev);
 void s5p_mfc_deinit_hw(struct s5p_mfc_dev *dev);
+int s5p_mfc_init_hw_warm(struct s5p_mfc_dev *dev);
+void s5p_mfc_deinit_hw_warm(struct s5p_mfc_dev *dev);
 
 int s5p_mfc_sleep(struct s5p_mfc_dev *dev);
 int s5p_mfc_wakeup(struct s5p_mfc_dev *dev);
@@ -21,6 +21,7 @@
 #include <linux/pm_qos.h>
 #include <soc/samsung/bts.h>
 #endif
+#include <linux/shrinker.h>
 #include <linux/videodev2.h>
 
 #include <media/v4l2-device.h>
@@ -312,6 +313,11 @@ struct s5p_mfc_fw {
 	size_t		size;
 	int		status;
 	int		drm_status;
+	int		warm;
+	unsigned int	nr_cold_open;
+	unsigned int	nr_warm_open;
+	u64		cold_open_ns;
+	u64		warm_open_ns;
 };
 
 struct s5p_mfc_buf_align {
@@ -345,11 +351,13 @@ struct s5p_mfc_debugfs {
 	struct dentry *root;
 	struct dentry *mfc_info;
 	struct dentry *debug_info;
+	struct dentry *sched;
 	struct dentry *debug;
 	struct dentry *debug_ts;
 	struct dentry *dbg_enable;
 	struct dentry *nal_q_dump;
 	struct dentry *nal_q_disable;
+	struct dentry *fw_warm_resume;
 	struct dentry *nal_q_parallel_enable;
 };
 
@@ -368,6 +376,26 @@ struct s5p_mfc_special_buf {
 	size_t		size;
 };
 
+/**
+ * struct s5p_mfc_buf_cache - codec buffers kept after their instance let go
+ * @list:		cached buffers, most recently released first
+ * @lock:		protects the fields below
+ * @size:		bytes held by the cached buffers
+ * @max_size:		bytes the cache may hold at most
+ * @hits:		allocations served from the cache
+ * @misses:		allocations that went to the allocator
+ * @shrinker:		gives the cached buffers back under memory pressure
+ */
+struct s5p_mfc_buf_cache {
+	struct list_head list;
+	struct mutex lock;
+	size_t size;
+	size_t max_size;
+	unsigned int hits;
+	unsigned int misses;
+	struct shrinker shrinker;
+};
+
 #ifdef CONFIG_MFC_USE_BUS_DEVFREQ
 struct mfc_qos_bw_data {
 	unsigned long	peak;
@@ -478,6 +506,7 @@ struct s5p_mfc_dev {
 	struct work_struct watchdog_work;
 
 	struct vb2_alloc_ctx *alloc_ctx;
+	struct s5p_mfc_buf_cache codec_buf_cache;
 
 	atomic_t hw_run_cnt;
 	atomic_t queued_cnt;
@@ -509,6 +538,15 @@ struct s5p_mfc_dev {
 	struct pm_qos_request qos_req_cluster0;
 #endif
 	int qos_has_enc_ctx;
+	/* closed-loop tuning, see s5p_mfc_qos_frame_done() */
+	int qos_base_step;
+	int qos_down_steps;
+	unsigned int qos_budget_us;
+	unsigned int qos_last_hw_us;
+	unsigned int qos_win_frames;
+	unsigned int qos_win_max_us;
+	unsigned int qos_misses;
+	struct work_struct qos_tune_work;
 #ifdef CONFIG_EXYNOS8890_BTS_OPTIMIZATION
 	int qos_extra;
 #endif
@@ -1018,6 +1056,35 @@ struct s5p_mfc_fmt {
 	u32 mem_planes;
 };
 
+/**
+ * enum s5p_mfc_prio - Scheduling class of an MFC instance, set by
+ * V4L2_CID_MPEG_VIDEO_PRIORITY. Lower classes are served first, instances
+ * of the realtime class by the earliest frame deadline, the others round
+ * robin.
+ */
+enum s5p_mfc_prio {
+	MFC_PRIO_REALTIME = 0,
+	MFC_PRIO_NORMAL = 1,
+	MFC_PRIO_BATCH = 2,
+	MFC_PRIO_NUM,
+};
+
+/**
+ * struct s5p_mfc_sched_stats - Frame deadlines of an MFC instance
+ * @ready_ns:	when the next source frame became ready, 0 if none is
+ * @frames:	frames completed
+ * @misses:	frames completed after their deadline
+ * @max_late_ns: largest time a frame completed after its deadline
+ *
+ * The deadline of a frame is one frame period after it became ready.
+ */
+struct s5p_mfc_sched_stats {
+	u64 ready_ns;
+	unsigned int frames;
+	unsigned int misses;
+	u64 max_late_ns;
+};
+
 /**
  * struct s5p_mfc_ctx - This struct contains the instance context
  */
@@ -1120,6 +1187,9 @@ struct s5p_mfc_ctx {
 	int framerate;
 	int last_framerate;
 
+	enum s5p_mfc_prio prio;
+	struct s5p_mfc_sched_stats sched;
+
 	struct mfc_timestamp ts_array[MFC_TIME_INDEX];
 	struct list_head ts_list;
 	int ts_count;
@@ -23,6 +23,7 @@ extern unsigned int dbg_enable;
 extern unsigned int nal_q_dump;
 extern unsigned int nal_q_disable;
 extern unsigned int nal_q_parallel_enable;
+extern unsigned int fw_warm_resume;
 
 #define mfc_debug(level, fmt, args...)				\
 	do {							\
@@ -28,6 +28,7 @@ unsigned int nal_q_dump;
 /* Do not support NAL-Q at KM */
 unsigned int nal_q_disable = 1;
 unsigned int nal_q_parallel_enable;
+unsigned int fw_warm_resume = 1;
 
 static int mfc_info_show(struct seq_file *s, void *unused)
 {
@@ -47,8 +48,33 @@ static int mfc_info_show(struct seq_file *s, void *unused)
 	seq_printf(s, "[HWLOCK] bits: %#lx, dev: %#lx, owned_by_irq = %d, wl_count = %d\n",
 			dev->hwlock.bits, dev->hwlock.dev,
 			dev->hwlock.owned_by_irq, dev->hwlock.wl_count);
-	if (dev->nal_q_handle)
-		seq_printf(s, "[NAL-Q] state: %d\n", dev->nal_q_handle->nal_q_state);
+	if (dev->nal_q_handle) {
+		nal_queue_handle *nal_q_handle = dev->nal_q_handle;
+		u64 residency = nal_q_handle->residency_ns;
+
+		if (nal_q_handle->nal_q_state == NAL_Q_STATE_STARTED ||
+				nal_q_handle->nal_q_state == NAL_Q_STATE_STOPPED)
+			residency += ktime_get_ns() - nal_q_handle->start_ns;
+		seq_printf(s, "[NAL-Q] state: %d, starts: %u, frames: %u, residency: %llums\n",
+				nal_q_handle->nal_q_state, nal_q_handle->nr_start,
+				nal_q_handle->nr_frames,
+				div_u64(residency, NSEC_PER_MSEC));
+	}
+	seq_printf(s, "[F/W] asleep: %d, cold open: %u (last %lluus), warm open: %u (last %lluus)\n",
+			dev->fw.warm, dev->fw.nr_cold_open,
+			div_u64(dev->fw.cold_open_ns, NSEC_PER_USEC),
+			dev->fw.nr_warm_open,
+			div_u64(dev->fw.warm_open_ns, NSEC_PER_USEC));
+	seq_printf(s, "[CODEC BUF CACHE] size: %zuKB, max: %zuKB, hits: %u, misses: %u\n",
+			dev->codec_buf_cache.size >> 10,
+			dev->codec_buf_cache.max_size >> 10,
+			dev->codec_buf_cache.hits, dev->codec_buf_cache.misses);
+#ifdef CONFIG_MFC_USE_BUS_DEVFREQ
+	seq_printf(s, "[QoS] step: %d (base: %d, down: %d), budget: %uus, last: %uus, missed: %u\n",
+			atomic_read(&dev->qos_req_cur) - 1, dev->qos_base_step,
+			dev->qos_down_steps, dev->qos_budget_us,
+			dev->qos_last_hw_us, dev->qos_misses);
+#endif
 
 	seq_puts(s, ">> MFC device information(instance)\n");
 	for (i = 0; i < MFC_NUM_CONTEXTS; i++) {
@@ -74,6 +100,31 @@ static int mfc_info_show(struct seq_file *s, void *unused)
 	return 0;
 }
 
+static int mfc_sched_show(struct seq_file *s, void *unused)
+{
+	static const char * const prio_name[MFC_PRIO_NUM] = {
+		"realtime", "normal", "batch",
+	};
+	struct s5p_mfc_dev *dev = s->private;
+	struct s5p_mfc_ctx *ctx;
+	int i;
+
+	seq_puts(s, ">> MFC frame deadlines\n");
+	for (i = 0; i < MFC_NUM_CONTEXTS; i++) {
+		ctx = dev->ctx[i];
+		if (!ctx)
+			continue;
+
+		seq_printf(s, "[CTX:%d] %s, prio: %s, fps: %d, frames: %u, missed: %u, max_late: %lluus\n",
+			ctx->num, ctx->type == MFCINST_DECODER ? "DEC" : "ENC",
+			prio_name[ctx->prio], ctx->framerate / 1000,
+			ctx->sched.frames, ctx->sched.misses,
+			div_u64(ctx->sched.max_late_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
 static int mfc_debug_info_show(struct seq_file *s, void *unused)
 {
 	seq_puts(s, ">> MFC debug information\n");
@@ -85,6 +136,11 @@ static int mfc_info_open(struct inode *inode, struct file *file)
 	return single_open(file, mfc_info_show, inode->i_private);
 }
 
+static int mfc_sched_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, mfc_sched_show, inode->i_private);
+}
+
 static int mfc_debug_info_open(struct inode *inode, struct file *file)
 {
 	return single_open(file, mfc_debug_info_show, inode->i_private);
@@ -97,6 +153,13 @@ static const struct file_operations mfc_info_fops = {
 	.release = single_release,
 };
 
+static const struct file_operations mfc_sched_fops = {
+	.open = mfc_sched_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static const struct file_operations debug_info_fops = {
 	.open = mfc_debug_info_open,
 	.read = seq_read,
@@ -118,6 +181,8 @@ void s5p_mfc_init_debugfs(struct s5p_mfc_dev *dev)
 			0444, debugfs->root, dev, &mfc_info_fops);
 	debugfs->debug_info = debugfs_create_file("debug_info",
 			0444, debugfs->root, dev, &debug_info_fops);
+	debugfs->sched = debugfs_create_file("sched",
+			0444, debugfs->root, dev, &mfc_sched_fops);
 	debugfs->debug = debugfs_create_u32("debug",
 			0644, debugfs->root, &debug);
 	debugfs->debug_ts = debugfs_create_u32("debug_ts",
@@ -130,4 +195,6 @@ void s5p_mfc_init_debugfs(struct s5p_mfc_dev *dev)
 			0644, debugfs->root, &nal_q_disable);
 	debugfs->nal_q_parallel_enable = debugfs_create_u32("nal_q_parallel_enable",
 			0644, debugfs->root, &nal_q_parallel_enable);
+	debugfs->fw_warm_resume = debugfs_create_u32("fw_warm_resume",
+			0644, debugfs->root, &fw_warm_resume);
 }
@@ -931,6 +931,9 @@ static int mfc_dec_get_ctrl_val(struct s5p_mfc_ctx *ctx, struct v4l2_control *ct
 	case V4L2_CID_MPEG_VIDEO_QOS_RATIO:
 		ctrl->value = ctx->qos_ratio;
 		break;
+	case V4L2_CID_MPEG_VIDEO_PRIORITY:
+		ctrl->value = ctx->prio;
+		break;
 	case V4L2_CID_MPEG_MFC_SET_DYNAMIC_DPB_MODE:
 		ctrl->value = dec->is_dynamic_dpb;
 		break;
@@ -1062,6 +1065,10 @@ static int vidioc_s_ctrl(struct file *file, void *priv,
 		ctx->qos_ratio = ctrl->value;
 		mfc_info_ctx("set %d qos_ratio.\n", ctrl->value);
 		break;
+	case V4L2_CID_MPEG_VIDEO_PRIORITY:
+		ctx->prio = ctrl->value;
+		mfc_info_ctx("set %d priority.\n", ctrl->value);
+		break;
 	case V4L2_CID_MPEG_MFC_SET_DYNAMIC_DPB_MODE:
 		dec->is_dynamic_dpb = ctrl->value;
 		if (dec->is_dynamic_dpb == 0)
@@ -603,6 +603,7 @@ static void s5p_mfc_dec_buf_queue(struct vb2_buffer *vb)
 		buf->vir_addr = stream_vir;
 
 		s5p_mfc_add_tail_buf(&ctx->buf_queue_lock, &ctx->src_buf_queue, buf);
+		s5p_mfc_sched_frame_queued(ctx);
 
 		MFC_TRACE_CTX("Q src[%d] fd: %d, %#llx\n",
 				vb->index, vb->planes[0].m.fd, buf->planes.stream);
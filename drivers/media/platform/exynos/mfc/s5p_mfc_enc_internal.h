@@ -878,6 +878,15 @@ static struct v4l2_queryctrl controls[] = {
 		.step = 10,
 		.default_value = 100,
 	},
+	{
+		.id = V4L2_CID_MPEG_VIDEO_PRIORITY,
+		.type = V4L2_CTRL_TYPE_INTEGER,
+		.name = "Scheduling priority",
+		.minimum = MFC_PRIO_REALTIME,
+		.maximum = MFC_PRIO_BATCH,
+		.step = 1,
+		.default_value = MFC_PRIO_NORMAL,
+	},
 	{
 		.id = V4L2_CID_MPEG_MFC70_VIDEO_VP8_VERSION,
 		.type = V4L2_CTRL_TYPE_INTEGER,
@@ -391,6 +391,7 @@ static void s5p_mfc_enc_buf_queue(struct vb2_buffer *vb)
 		s5p_mfc_qos_update_framerate(ctx, 1);
 	} else if (vq->type == V4L2_BUF_TYPE_VIDEO_OUTPUT_MPLANE) {
 		s5p_mfc_add_tail_buf(&ctx->buf_queue_lock, &ctx->src_buf_queue, buf);
+		s5p_mfc_sched_frame_queued(ctx);
 	} else {
 		mfc_err_ctx("unsupported buffer type (%d)\n", vq->type);
 	}
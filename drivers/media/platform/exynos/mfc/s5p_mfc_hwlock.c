@@ -19,6 +19,7 @@
 
 #include "s5p_mfc_inst.h"
 #include "s5p_mfc_pm.h"
+#include "s5p_mfc_qos.h"
 #include "s5p_mfc_cmd.h"
 #include "s5p_mfc_cal.h"
 #include "s5p_mfc_reg.h"
@@ -923,6 +924,11 @@ void s5p_mfc_hwlock_handler_irq(struct s5p_mfc_dev *dev, struct s5p_mfc_ctx *cur
 		return;
 	}
 
+	if (reason == S5P_FIMV_R2H_CMD_FRAME_DONE_RET) {
+		s5p_mfc_sched_frame_done(curr_ctx);
+		s5p_mfc_qos_frame_done(dev);
+	}
+
 	spin_lock_irqsave(&dev->hwlock.lock, flags);
 	mfc_print_hwlock(dev);
 
@@ -1369,6 +1369,7 @@ static inline int mfc_nal_q_irq(struct s5p_mfc_dev *dev,
 	case S5P_FIMV_R2H_CMD_QUEUE_DONE_RET:
 		pOutStr = s5p_mfc_nal_q_dequeue_out_buf(dev,
 			nal_q_handle->nal_q_out_handle, &errcode);
+		nal_q_handle->nr_frames++;
 		if (pOutStr) {
 			if (s5p_mfc_nal_q_handle_out_buf(dev, pOutStr))
 				mfc_err_dev("NAL Q: Failed to handle out buf\n");
@@ -1386,6 +1387,7 @@ static inline int mfc_nal_q_irq(struct s5p_mfc_dev *dev,
 	case S5P_FIMV_R2H_CMD_COMPLETE_QUEUE_RET:
 		s5p_mfc_watchdog_stop_tick(dev);
 		s5p_mfc_nal_q_cleanup_queue(dev);
+		nal_q_handle->residency_ns += ktime_get_ns() - nal_q_handle->start_ns;
 		nal_q_handle->nal_q_state = NAL_Q_STATE_CREATED;
 		MFC_TRACE_DEV("** NAL Q state : %d\n", nal_q_handle->nal_q_state);
 		mfc_debug(2, "NAL Q: return to created state\n");
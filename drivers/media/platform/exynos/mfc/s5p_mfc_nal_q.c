@@ -46,6 +46,18 @@ int s5p_mfc_nal_q_check_enable(struct s5p_mfc_dev *dev)
 	for (i = 0; i < MFC_NUM_CONTEXTS; i++) {
 		temp_ctx = dev->ctx[i];
 		if (temp_ctx) {
+			/*
+			 * An instance with nothing to run, like one opened but
+			 * not streaming yet, doesn't need host commands now.
+			 * Once it has work it is checked again and stops
+			 * NAL-Q if it isn't running.
+			 */
+			if (i != dev->curr_ctx &&
+					!test_bit(i, &dev->work_bits.bits)) {
+				mfc_debug(2, "There is an idle ctx. index: %d, state: %d\n",
+						i, temp_ctx->state);
+				continue;
+			}
 			/* NAL-Q doesn't support drm */
 			if (temp_ctx->is_drm) {
 				mfc_debug(2, "There is a drm ctx. Can't start NAL-Q\n");
@@ -398,6 +410,8 @@ void s5p_mfc_nal_q_start(struct s5p_mfc_dev *dev, nal_queue_handle *nal_q_handle
 		s5p_mfc_get_nal_q_output_ize());
 
 	nal_q_handle->nal_q_state = NAL_Q_STATE_STARTED;
+	nal_q_handle->start_ns = ktime_get_ns();
+	nal_q_handle->nr_start++;
 	MFC_TRACE_DEV("** NAL Q state : %d\n", nal_q_handle->nal_q_state);
 	mfc_debug(2, "NAL Q: started, state = %d\n", nal_q_handle->nal_q_state);
 
@@ -221,6 +221,11 @@ typedef struct _nal_queue_handle {
 	nal_queue_out_handle *nal_q_out_handle;
 	nal_queue_state nal_q_state;
 	int nal_q_exception;
+	/* residency, for debugfs */
+	u64 start_ns;
+	u64 residency_ns;
+	unsigned int nr_start;
+	unsigned int nr_frames;
 } nal_queue_handle;
 
 #endif /* __S5P_MFC_NAL_Q_STRUCT_H  */
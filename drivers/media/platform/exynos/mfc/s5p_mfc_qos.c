@@ -104,6 +104,11 @@ static void mfc_qos_operate(struct s5p_mfc_dev *dev, int opr_type, int idx)
 		dev->mfc_bw.write = 0;
 		bts_update_bw(BTS_BW_MFC, dev->mfc_bw);
 
+		dev->qos_down_steps = 0;
+		dev->qos_budget_us = 0;
+		dev->qos_win_frames = 0;
+		dev->qos_win_max_us = 0;
+
 		atomic_set(&dev->qos_req_cur, 0);
 		MFC_TRACE_DEV("-- QOS remove\n");
 		mfc_debug(2, "QoS remove\n");
@@ -150,6 +155,20 @@ static void mfc_qos_set(struct s5p_mfc_ctx *ctx, struct bts_bw *mfc_bw, int i)
 		mfc_qos_operate(dev, MFC_QOS_UPDATE, i);
 }
 
+/*
+ * The table step found from the macroblock count is the worst case for the
+ * codec. Hold it as the base and give back the steps the frames have shown
+ * they do not need, with @total_fps setting the budget of each frame.
+ */
+static int mfc_qos_tuned_step(struct s5p_mfc_dev *dev, int i,
+		unsigned int total_fps)
+{
+	dev->qos_base_step = i;
+	dev->qos_budget_us = total_fps ? USEC_PER_SEC / total_fps : 0;
+
+	return max(i - READ_ONCE(dev->qos_down_steps), 0);
+}
+
 static inline unsigned long mfc_qos_get_weighted_mb(struct s5p_mfc_ctx *ctx,
 						unsigned long mb)
 {
@@ -394,6 +413,7 @@ void s5p_mfc_qos_on(struct s5p_mfc_ctx *ctx)
 	if (total_mb > pdata->max_mb)
 		mfc_debug(4, "QoS overspec mb %ld > %d\n", total_mb, pdata->max_mb);
 
+	i = mfc_qos_tuned_step(dev, i, total_fps);
 	mfc_qos_set(ctx, &mfc_bw, i);
 	mutex_unlock(&dev->qos_mutex);
 }
@@ -465,8 +485,79 @@ void s5p_mfc_qos_off(struct s5p_mfc_ctx *ctx)
 	if (list_empty(&dev->qos_queue) || total_mb == 0)
 		mfc_qos_operate(dev, MFC_QOS_REMOVE, 0);
 	else
-		mfc_qos_set(ctx, &mfc_bw, i);
+		mfc_qos_set(ctx, &mfc_bw, mfc_qos_tuned_step(dev, i, total_fps));
+
+	mutex_unlock(&dev->qos_mutex);
+}
+
+/*
+ * Should be called from the irq once a frame is done. The time from the
+ * command to the interrupt is what the frame took at the current step:
+ * a frame over its budget takes back every step given up so far, and a
+ * window of frames all well within it gives up one more.
+ */
+void s5p_mfc_qos_frame_done(struct s5p_mfc_dev *dev)
+{
+	unsigned int budget = READ_ONCE(dev->qos_budget_us);
+	unsigned int hw_us;
+	s64 delta;
+
+	if (!budget || atomic_read(&dev->qos_req_cur) == 0)
+		return;
+
+	delta = timeval_to_ns(&dev->last_int_time) -
+		timeval_to_ns(&dev->last_cmd_time);
+	if (delta < 0)
+		return;
+
+	hw_us = div_u64(delta, NSEC_PER_USEC);
+	dev->qos_last_hw_us = hw_us;
+
+	if (hw_us > budget) {
+		dev->qos_misses++;
+		dev->qos_win_frames = 0;
+		dev->qos_win_max_us = 0;
+		if (dev->qos_down_steps) {
+			WRITE_ONCE(dev->qos_down_steps, 0);
+			queue_work(dev->mfc_idle_wq, &dev->qos_tune_work);
+		}
+		return;
+	}
+
+	dev->qos_win_max_us = max(dev->qos_win_max_us, hw_us);
+	if (++dev->qos_win_frames < MFC_QOS_TUNE_FRAMES)
+		return;
+
+	if (dev->qos_win_max_us * 100 < budget * MFC_QOS_TUNE_MARGIN &&
+			dev->qos_down_steps < READ_ONCE(dev->qos_base_step)) {
+		WRITE_ONCE(dev->qos_down_steps, dev->qos_down_steps + 1);
+		queue_work(dev->mfc_idle_wq, &dev->qos_tune_work);
+	}
+
+	dev->qos_win_frames = 0;
+	dev->qos_win_max_us = 0;
+}
+
+void mfc_qos_tune_worker(struct work_struct *work)
+{
+	struct s5p_mfc_dev *dev;
+	int i;
+
+	dev = container_of(work, struct s5p_mfc_dev, qos_tune_work);
+
+	mutex_lock(&dev->qos_mutex);
+	if (list_empty(&dev->qos_queue) || atomic_read(&dev->qos_req_cur) == 0) {
+		mutex_unlock(&dev->qos_mutex);
+		return;
+	}
 
+	i = max(dev->qos_base_step - READ_ONCE(dev->qos_down_steps), 0);
+	if (atomic_read(&dev->qos_req_cur) != (i + 1)) {
+		mfc_debug(2, "QoS tuned to table[%d] (base %d, last frame %uus of %uus)\n",
+				i, dev->qos_base_step, dev->qos_last_hw_us,
+				dev->qos_budget_us);
+		mfc_qos_operate(dev, MFC_QOS_UPDATE, i);
+	}
 	mutex_unlock(&dev->qos_mutex);
 }
 
@@ -32,12 +32,20 @@
 #define MFC_QOS_WEIGHT_10BIT		75
 #define MFC_QOS_WEIGHT_422_10INTRA	70
 
+/* frames a step must keep within the margin before the next step down */
+#define MFC_QOS_TUNE_FRAMES		30
+/* percentage of the frame budget the slowest frame may use to step down */
+#define MFC_QOS_TUNE_MARGIN		70
+
 #ifdef CONFIG_MFC_USE_BUS_DEVFREQ
 void s5p_mfc_qos_on(struct s5p_mfc_ctx *ctx);
 void s5p_mfc_qos_off(struct s5p_mfc_ctx *ctx);
+void s5p_mfc_qos_frame_done(struct s5p_mfc_dev *dev);
+void mfc_qos_tune_worker(struct work_struct *work);
 #else
 #define s5p_mfc_qos_on(ctx)	do {} while (0)
 #define s5p_mfc_qos_off(ctx)	do {} while (0)
+#define s5p_mfc_qos_frame_done(dev)	do {} while (0)
 #endif
 
 void mfc_qos_idle_worker(struct work_struct *work);
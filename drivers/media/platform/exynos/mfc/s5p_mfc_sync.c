@@ -125,11 +125,104 @@ void s5p_mfc_wake_up_ctx(struct s5p_mfc_ctx *ctx, unsigned int reason,
 	wake_up(&ctx->cmd_wq);
 }
 
+/* Frames per second assumed for an instance that has not shown its rate */
+#define MFC_SCHED_DEFAULT_FPS	30
+
+static u64 mfc_sched_period_ns(struct s5p_mfc_ctx *ctx)
+{
+	/* framerate is in frames per 1000 seconds */
+	int framerate = ctx->framerate > 0 ? ctx->framerate :
+			MFC_SCHED_DEFAULT_FPS * 1000;
+
+	return div_u64(NSEC_PER_SEC * 1000ULL, framerate);
+}
+
+static u64 mfc_sched_deadline(struct s5p_mfc_ctx *ctx, u64 now)
+{
+	u64 ready = READ_ONCE(ctx->sched.ready_ns);
+
+	return (ready ? ready : now) + mfc_sched_period_ns(ctx);
+}
+
+/*
+ * Should be called with work_bits.lock
+ *
+ * Pick a context with work in the lowest priority class. Realtime ones go
+ * by the earliest frame deadline, the others round robin from the context
+ * after the current one. As only a frame is run at a time, batch work is
+ * preempted at its next frame boundary.
+ */
+static int mfc_sched_pick_ctx(struct s5p_mfc_dev *dev)
+{
+	struct s5p_mfc_ctx *ctx;
+	u64 now = ktime_get_ns();
+	u64 deadline, best_deadline = U64_MAX;
+	int best_prio = MFC_PRIO_NUM;
+	int new_ctx_index = -EAGAIN;
+	int i, index;
+
+	for (i = 1; i <= MFC_NUM_CONTEXTS; i++) {
+		index = (dev->curr_ctx + i) % MFC_NUM_CONTEXTS;
+		ctx = dev->ctx[index];
+		if (!ctx || !test_bit(index, &dev->work_bits.bits))
+			continue;
+
+		if (ctx->prio > best_prio)
+			continue;
+
+		if (ctx->prio == MFC_PRIO_REALTIME) {
+			deadline = mfc_sched_deadline(ctx, now);
+			if (best_prio == MFC_PRIO_REALTIME &&
+					deadline >= best_deadline)
+				continue;
+			best_deadline = deadline;
+		} else if (ctx->prio == best_prio) {
+			continue;
+		}
+
+		best_prio = ctx->prio;
+		new_ctx_index = index;
+	}
+
+	return new_ctx_index;
+}
+
+/* Should be called when the source frame queue of the context grows */
+void s5p_mfc_sched_frame_queued(struct s5p_mfc_ctx *ctx)
+{
+	if (!READ_ONCE(ctx->sched.ready_ns))
+		WRITE_ONCE(ctx->sched.ready_ns, ktime_get_ns());
+}
+
+/* Should be called from the irq once a frame of the context is done */
+void s5p_mfc_sched_frame_done(struct s5p_mfc_ctx *ctx)
+{
+	struct s5p_mfc_sched_stats *sched = &ctx->sched;
+	u64 now = ktime_get_ns();
+	u64 deadline;
+
+	if (!sched->ready_ns)
+		return;
+
+	deadline = sched->ready_ns + mfc_sched_period_ns(ctx);
+	sched->frames++;
+	if (now > deadline) {
+		sched->misses++;
+		sched->max_late_ns = max(sched->max_late_ns, now - deadline);
+	}
+
+	/* frames still queued are ready from now on */
+	if (s5p_mfc_is_queue_count_greater(&ctx->buf_queue_lock,
+				&ctx->src_buf_queue, 0))
+		WRITE_ONCE(sched->ready_ns, now);
+	else
+		WRITE_ONCE(sched->ready_ns, 0);
+}
+
 int s5p_mfc_get_new_ctx(struct s5p_mfc_dev *dev)
 {
 	unsigned long wflags;
 	int new_ctx_index = 0;
-	int cnt = 0;
 
 	if (!dev) {
 		mfc_err_dev("no mfc device to run\n");
@@ -145,15 +238,11 @@ int s5p_mfc_get_new_ctx(struct s5p_mfc_dev *dev)
 		new_ctx_index = dev->preempt_ctx;
 		mfc_debug(2, "preempt_ctx is : %d\n", new_ctx_index);
 	} else {
-		new_ctx_index = (dev->curr_ctx + 1) % MFC_NUM_CONTEXTS;
-		while (!test_bit(new_ctx_index, &dev->work_bits.bits)) {
-			new_ctx_index = (new_ctx_index + 1) % MFC_NUM_CONTEXTS;
-			cnt++;
-			if (cnt > MFC_NUM_CONTEXTS) {
-				/* No contexts to run */
-				spin_unlock_irqrestore(&dev->work_bits.lock, wflags);
-				return -EAGAIN;
-			}
+		new_ctx_index = mfc_sched_pick_ctx(dev);
+		if (new_ctx_index < 0) {
+			/* No contexts to run */
+			spin_unlock_irqrestore(&dev->work_bits.lock, wflags);
+			return -EAGAIN;
 		}
 	}
 
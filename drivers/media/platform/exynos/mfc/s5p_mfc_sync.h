@@ -44,6 +44,8 @@ void s5p_mfc_wake_up_ctx(struct s5p_mfc_ctx *ctx, unsigned int reason,
 		unsigned int err);
 
 int s5p_mfc_get_new_ctx(struct s5p_mfc_dev *dev);
+void s5p_mfc_sched_frame_queued(struct s5p_mfc_ctx *ctx);
+void s5p_mfc_sched_frame_done(struct s5p_mfc_ctx *ctx);
 int s5p_mfc_dec_ctx_ready(struct s5p_mfc_ctx *ctx);
 int s5p_mfc_enc_ctx_ready(struct s5p_mfc_ctx *ctx);
 int s5p_mfc_ctx_ready(struct s5p_mfc_ctx *ctx);
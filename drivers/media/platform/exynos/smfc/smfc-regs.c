@@ -211,22 +211,23 @@ void smfc_hwconfigure_2nd_tables(struct smfc_ctx *ctx, unsigned int qfactor)
 
 void smfc_hwconfigure_tables_for_decompression(struct smfc_ctx *ctx)
 {
+	struct smfc_decomp_header *hdr = ctx->hdr;
 	void __iomem *base = ctx->smfc->reg;
 	void __iomem *qtbl_base = ctx->smfc->reg + REG_QTBL_BASE;
-	u32 tblsel = ctx->num_components << 16;
+	u32 tblsel = hdr->num_components << 16;
 	int i;
 
 	/* Huffman table selector configuration */
-	for (i = 0; i < ctx->num_components; i++) {
-		u32 val = (ctx->huffman_tables->compsel[i].idx_dc |
-			(ctx->huffman_tables->compsel[i].idx_ac << 1)) & 3;
+	for (i = 0; i < hdr->num_components; i++) {
+		u32 val = (hdr->huffman_tables.compsel[i].idx_dc |
+			(hdr->huffman_tables.compsel[i].idx_ac << 1)) & 3;
 		tblsel |= val << (i * 2 + 4);
 	}
 
 	/* quantization table configuration */
-	for (i = 0; i < ctx->num_components; i++) {
-		if (ctx->quantizer_tables->compsel[i] != INVALID_QTBLIDX) {
-			u8 *table = ctx->quantizer_tables->table[i];
+	for (i = 0; i < hdr->num_components; i++) {
+		if (hdr->quantizer_tables.compsel[i] != INVALID_QTBLIDX) {
+			u8 *table = hdr->quantizer_tables.table[i];
 			int j;
 
 			for (j = 0; j < SMFC_MCU_SIZE; j += 4) {
@@ -240,30 +241,30 @@ void smfc_hwconfigure_tables_for_decompression(struct smfc_ctx *ctx)
 					qtbl_base + SMFC_MCU_SIZE * i + j);
 			}
 			/* quantization table selector */
-			tblsel |= ctx->quantizer_tables->compsel[i] << (i * 2);
+			tblsel |= hdr->quantizer_tables.compsel[i] << (i * 2);
 		}
 	}
 
 	/* Huffman table configuration */
 	for (i = 0; i < 4; i++) {
-		__raw_writel(ctx->huffman_tables->dc[0].code32[i],
+		__raw_writel(hdr->huffman_tables.dc[0].code32[i],
 				base + REG_HTBL_LUMA_DCLEN + i * sizeof(u32));
-		__raw_writel(ctx->huffman_tables->dc[0].value32[i],
+		__raw_writel(hdr->huffman_tables.dc[0].value32[i],
 				base + REG_HTBL_LUMA_DCVAL + i * sizeof(u32));
-		__raw_writel(ctx->huffman_tables->dc[1].code32[i],
+		__raw_writel(hdr->huffman_tables.dc[1].code32[i],
 				base + REG_HTBL_CHROMA_DCLEN + i * sizeof(u32));
-		__raw_writel(ctx->huffman_tables->dc[1].value32[i],
+		__raw_writel(hdr->huffman_tables.dc[1].value32[i],
 				base + REG_HTBL_CHROMA_DCVAL + i * sizeof(u32));
-		__raw_writel(ctx->huffman_tables->ac[0].code32[i],
+		__raw_writel(hdr->huffman_tables.ac[0].code32[i],
 				base + REG_HTBL_LUMA_ACLEN + i * sizeof(u32));
-		__raw_writel(ctx->huffman_tables->ac[1].code32[i],
+		__raw_writel(hdr->huffman_tables.ac[1].code32[i],
 				base + REG_HTBL_CHROMA_ACLEN + i * sizeof(u32));
 	}
 
 	for (i = 0; i < (SMFC_NUM_AC_HVAL / 4); i++) {
-		__raw_writel(ctx->huffman_tables->ac[0].value32[i],
+		__raw_writel(hdr->huffman_tables.ac[0].value32[i],
 				base + REG_HTBL_LUMA_ACVAL + i * sizeof(u32));
-		__raw_writel(ctx->huffman_tables->ac[1].value32[i],
+		__raw_writel(hdr->huffman_tables.ac[1].value32[i],
 				base + REG_HTBL_CHROMA_ACVAL + i * sizeof(u32));
 	}
 
@@ -389,9 +390,11 @@ void smfc_hwconfigure_image(struct smfc_ctx *ctx,
 	u32 format = ctx->img_fmt->regcfg;
 	unsigned char num_plane = ctx->img_fmt->num_planes;
 	u32 burstlen = 1 << ctx->smfc->devdata->burstlenth_bits;
+	unsigned int offset_of_sos = 0;
 	unsigned int i;
 
 	if (!(ctx->flags & SMFC_CTX_COMPRESS)) {
+		offset_of_sos = ctx->hdr->offset_of_sos;
 		__raw_writel(ctx->width | (ctx->height << 16),
 					ctx->smfc->reg + REG_MAIN_IMAGE_SIZE);
 
@@ -425,11 +428,11 @@ void smfc_hwconfigure_image(struct smfc_ctx *ctx,
 	smfc_hwconfigure_image_base(ctx, vb2buf_img, false);
 	__raw_writel(format, ctx->smfc->reg + REG_MAIN_IMAGE_FORMAT);
 	stream_address = smfc_hwconfigure_jpeg_base(ctx, vb2buf_jpg,
-						    ctx->offset_of_sos, false);
+						    offset_of_sos, false);
 	if (!(ctx->flags & SMFC_CTX_COMPRESS)) {
 		u32 streamsize = vb2_plane_size(vb2buf_jpg, 0);
 
-		streamsize -= ctx->offset_of_sos;
+		streamsize -= offset_of_sos;
 		streamsize += stream_address & SMFC_ADDR_ALIGN_MASK(burstlen);
 		streamsize = ALIGN(streamsize, burstlen);
 		streamsize >>= ctx->smfc->devdata->burstlenth_bits;
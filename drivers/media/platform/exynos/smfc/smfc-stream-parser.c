@@ -17,29 +17,15 @@
 
 #include "smfc.h"
 
-static bool smfc_alloc_tables(struct smfc_ctx *ctx)
+static void smfc_init_tables(struct smfc_decomp_header *hdr)
 {
 	int i;
 
-	if (!ctx->quantizer_tables) {
-		ctx->quantizer_tables = kmalloc(
-				sizeof(*ctx->quantizer_tables), GFP_KERNEL);
-		if (!ctx->quantizer_tables)
-			return false;
-	}
-	memset(ctx->quantizer_tables, 0, sizeof(*ctx->quantizer_tables));
+	memset(&hdr->quantizer_tables, 0, sizeof(hdr->quantizer_tables));
 	for (i = 0; i < SMFC_MAX_QTBL_COUNT; i++)
-		ctx->quantizer_tables->compsel[i] = INVALID_QTBLIDX;
-
-	if (!ctx->huffman_tables) {
-		ctx->huffman_tables = kmalloc(
-				sizeof(*ctx->huffman_tables), GFP_KERNEL);
-		if (!ctx->huffman_tables)
-			return false;
-	}
-	memset(ctx->huffman_tables, 0, sizeof(*ctx->huffman_tables));
+		hdr->quantizer_tables.compsel[i] = INVALID_QTBLIDX;
 
-	return true;
+	memset(&hdr->huffman_tables, 0, sizeof(hdr->huffman_tables));
 }
 
 union jpeg_hword_t {
@@ -94,7 +80,8 @@ unsigned int smfc_get_num_huffval(u8 *hufflen)
 	return num;
 }
 
-static int smfc_parse_dht(struct smfc_ctx *ctx, unsigned long *cursor)
+static int smfc_parse_dht(struct smfc_ctx *ctx,
+			  struct smfc_decomp_header *hdr, unsigned long *cursor)
 {
 	u8 __user *pcursor = (u8 __user *)*cursor;
 	unsigned long segend;
@@ -127,8 +114,8 @@ static int smfc_parse_dht(struct smfc_ctx *ctx, unsigned long *cursor)
 
 		/* HUFFLEN */
 		dc = (((tcth >> 4) & 0xF) == 0);
-		table = dc ? ctx->huffman_tables->dc[tcth & 1].code
-			   : ctx->huffman_tables->ac[tcth & 1].code;
+		table = dc ? hdr->huffman_tables.dc[tcth & 1].code
+			   : hdr->huffman_tables.ac[tcth & 1].code;
 		ret = copy_from_user(table, pcursor, SMFC_NUM_HCODE);
 		pcursor += SMFC_NUM_HCODE;
 		if (ret) {
@@ -151,8 +138,8 @@ static int smfc_parse_dht(struct smfc_ctx *ctx, unsigned long *cursor)
 			break;
 
 		/* HUFFVAL */
-		table = dc ? ctx->huffman_tables->dc[tcth & 1].value
-			   : ctx->huffman_tables->ac[tcth & 1].value;
+		table = dc ? hdr->huffman_tables.dc[tcth & 1].value
+			   : hdr->huffman_tables.ac[tcth & 1].value;
 		ret = copy_from_user(table, pcursor, num_values);
 		pcursor += num_values;
 		if (ret) {
@@ -173,7 +160,8 @@ static int smfc_parse_dht(struct smfc_ctx *ctx, unsigned long *cursor)
 	return 0;
 }
 
-static int smfc_parse_dqt(struct smfc_ctx *ctx, unsigned long *cursor)
+static int smfc_parse_dqt(struct smfc_ctx *ctx,
+			  struct smfc_decomp_header *hdr, unsigned long *cursor)
 {
 	u8 __user *pcursor = (u8 __user *)*cursor;
 	unsigned long segend;
@@ -202,7 +190,7 @@ static int smfc_parse_dqt(struct smfc_ctx *ctx, unsigned long *cursor)
 			return -EINVAL;
 		}
 
-		ret = copy_from_user(ctx->quantizer_tables->table[pqtq],
+		ret = copy_from_user(hdr->quantizer_tables.table[pqtq],
 							pcursor, SMFC_MCU_SIZE);
 		pcursor += SMFC_MCU_SIZE;
 		if (ret) {
@@ -218,7 +206,8 @@ static int smfc_parse_dqt(struct smfc_ctx *ctx, unsigned long *cursor)
 }
 
 #define SOF0_LENGTH 17 /* Lf+P+Y+X+Nf+Nf*Comp */
-static int smfc_parse_frameheader(struct smfc_ctx *ctx, unsigned long *cursor)
+static int smfc_parse_frameheader(struct smfc_ctx *ctx,
+			struct smfc_decomp_header *hdr, unsigned long *cursor)
 {
 	u8 *pos;
 	int i, ret;
@@ -243,27 +232,27 @@ static int smfc_parse_frameheader(struct smfc_ctx *ctx, unsigned long *cursor)
 	}
 	pos++;
 
-	ctx->stream_height = __get_u16(pos);
-	ctx->stream_width = __get_u16(pos);
+	hdr->stream_height = __get_u16(pos);
+	hdr->stream_width = __get_u16(pos);
 
 	if ((*pos != 3) && (*pos != 1)) { /* Nf: number of components */
 		dev_err(ctx->smfc->dev, "Unsupported component count %d", *pos);
 		return -EINVAL;
 	}
 
-	/* ctx->num_components is not 0 if SOS appeared earlier than SOF0 */
-	if ((ctx->num_components != 0) && (ctx->num_components != *pos)) {
+	/* hdr->num_components is not 0 if SOS appeared earlier than SOF0 */
+	if ((hdr->num_components != 0) && (hdr->num_components != *pos)) {
 		dev_err(ctx->smfc->dev,
 			"comp. count differs in Ns(%u) and Nf(%u)\n",
-			ctx->num_components, *pos);
+			hdr->num_components, *pos);
 		return -EINVAL;
 	}
 
-	ctx->num_components = *pos;
+	hdr->num_components = *pos;
 
 	pos++;
 
-	for (i = 0; i < ctx->num_components; i++, pos += 3) {
+	for (i = 0; i < hdr->num_components; i++, pos += 3) {
 		u8 h = (pos[1] >> 4) & 0xF;
 		u8 v = pos[1] & 0xF;
 
@@ -276,15 +265,15 @@ static int smfc_parse_frameheader(struct smfc_ctx *ctx, unsigned long *cursor)
 		}
 
 		if (pos[0] == 1) { /* Luma component */
-			ctx->stream_hfactor = h;
-			ctx->stream_vfactor = v;
+			hdr->stream_hfactor = h;
+			hdr->stream_vfactor = v;
 		} else if ((h != 1) || (v != 1)) { /* Chroma component */
 			dev_err(ctx->smfc->dev,
 				"Unsupported chroma factor %dx%d\n", h, v);
 			return -EINVAL;
 		}
 
-		ctx->quantizer_tables->compsel[pos[0] - 1] = pos[2];
+		hdr->quantizer_tables.compsel[pos[0] - 1] = pos[2];
 	}
 
 	*cursor += SOF0_LENGTH;
@@ -294,6 +283,7 @@ static int smfc_parse_frameheader(struct smfc_ctx *ctx, unsigned long *cursor)
 
 #define SOS_LENGTH 12 /* Ls+Ns+Ns*Comp+Ss+Se+AhAl */
 static int smfc_parse_scanheader(struct smfc_ctx *ctx,
+				struct smfc_decomp_header *hdr,
 				unsigned long streambase, unsigned long *cursor)
 {
 	u8 *pos;
@@ -302,7 +292,7 @@ static int smfc_parse_scanheader(struct smfc_ctx *ctx,
 
 	pos = sos;
 
-	ctx->offset_of_sos = *cursor - streambase - SMFC_JPEG_MARKER_LEN;
+	hdr->offset_of_sos = *cursor - streambase - SMFC_JPEG_MARKER_LEN;
 
 	ret = copy_from_user(sos, (void __user *)*cursor, sizeof(sos));
 	if (ret) {
@@ -320,19 +310,19 @@ static int smfc_parse_scanheader(struct smfc_ctx *ctx,
 		return -EINVAL;
 	}
 
-	/* ctx->num_components is not 0 if SOF0 appeared earlier than SOS */
-	if ((ctx->num_components != 0) && (ctx->num_components != *pos)) {
+	/* hdr->num_components is not 0 if SOF0 appeared earlier than SOS */
+	if ((hdr->num_components != 0) && (hdr->num_components != *pos)) {
 		dev_err(ctx->smfc->dev,
 			"comp. count differs in Nf(%u) and Ns(%u)\n",
-			ctx->num_components, *pos);
+			hdr->num_components, *pos);
 		return -EINVAL;
 	}
 
-	ctx->num_components = *pos;
+	hdr->num_components = *pos;
 
 	pos++;
 
-	for (i = 0; i < ctx->num_components; i++, pos += 2) {
+	for (i = 0; i < hdr->num_components; i++, pos += 2) {
 		if ((pos[0] > 3) || __halfbytes_larger_than(pos[1], 1)) {
 			dev_err(ctx->smfc->dev,
 				"Invalid component %d data %02x%02x in SOS\n",
@@ -340,9 +330,9 @@ static int smfc_parse_scanheader(struct smfc_ctx *ctx,
 			return -EINVAL;
 		}
 
-		ctx->huffman_tables->compsel[pos[0] - 1].idx_dc =
+		hdr->huffman_tables.compsel[pos[0] - 1].idx_dc =
 							(pos[1] >> 4) & 0xF;
-		ctx->huffman_tables->compsel[pos[0] - 1].idx_ac = pos[1] & 0xF;
+		hdr->huffman_tables.compsel[pos[0] - 1].idx_ac = pos[1] & 0xF;
 	}
 
 	/*
@@ -357,8 +347,13 @@ static int smfc_parse_scanheader(struct smfc_ctx *ctx,
 	return 0;
 }
 
+/*
+ * The header is parsed into @vb rather than @ctx so that a stream can be
+ * queued while the H/W is decompressing the previous one with its own tables.
+ */
 int smfc_parse_jpeg_header(struct smfc_ctx *ctx, struct vb2_buffer *vb)
 {
+	struct smfc_decomp_header *hdr = &vb2_to_smfc_buffer(vb)->hdr;
 	int ret;
 	union jpeg_hword_t marker;
 	u16 len;
@@ -366,10 +361,9 @@ int smfc_parse_jpeg_header(struct smfc_ctx *ctx, struct vb2_buffer *vb)
 	unsigned long cursor = streambase;
 	unsigned long streamend = streambase + vb2_get_plane_payload(vb, 0);
 
-	ctx->num_components = 0;
+	hdr->num_components = 0;
 
-	if (!smfc_alloc_tables(ctx))
-		return -ENOMEM;
+	smfc_init_tables(hdr);
 
 	/* the buffer in vb the entire JPEG stream from SOI */
 
@@ -399,22 +393,23 @@ int smfc_parse_jpeg_header(struct smfc_ctx *ctx, struct vb2_buffer *vb)
 
 		switch (marker.byte[1]) {
 		case 0xC4: /* DHT */
-			ret = smfc_parse_dht(ctx, &cursor);
+			ret = smfc_parse_dht(ctx, hdr, &cursor);
 			if (ret)
 				return ret;
 			break;
 		case 0xDB: /* DQT */
-			ret = smfc_parse_dqt(ctx, &cursor);
+			ret = smfc_parse_dqt(ctx, hdr, &cursor);
 			if (ret)
 				return ret;
 			break;
 		case 0xC0: /* SOF0 */
-			ret = smfc_parse_frameheader(ctx, &cursor);
+			ret = smfc_parse_frameheader(ctx, hdr, &cursor);
 			if (ret)
 				return ret;
 			break;
 		case 0xDA: /**** SOS - THE END OF HEADER PARSING ****/
-			return smfc_parse_scanheader(ctx, streambase, &cursor);
+			return smfc_parse_scanheader(ctx, hdr, streambase,
+						     &cursor);
 		case 0xD9: /* EOI */
 			dev_err(ctx->smfc->dev,
 				"EOI found during header parsing\n");
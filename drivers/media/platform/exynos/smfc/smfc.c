@@ -21,6 +21,8 @@
 #include <linux/wait.h>
 #include <linux/exynos_iovmm.h>
 #include <linux/reboot.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 
 #include <media/videobuf2-core.h>
 #include <media/videobuf2-ion.h>
@@ -38,6 +40,35 @@ enum {
 	SMFC_HWFC_WAIT,
 };
 
+/*
+ * Images per second is measured over windows of at least a second of
+ * consecutive jobs. An idle gap longer than a second starts a new window.
+ */
+static void smfc_account_throughput(struct smfc_dev *smfc,
+				    struct smfc_ctx *ctx, ktime_t now)
+{
+	s64 window_us;
+
+	smfc->nr_images++;
+	smfc->busy_us += ktime_us_delta(now, ctx->ktime_beg);
+
+	if (ktime_us_delta(ctx->ktime_beg, smfc->tput_last) > USEC_PER_SEC) {
+		smfc->tput_window_beg = ctx->ktime_beg;
+		smfc->tput_window_images = 0;
+	}
+	smfc->tput_last = now;
+
+	smfc->tput_window_images++;
+	window_us = ktime_us_delta(now, smfc->tput_window_beg);
+	if (window_us >= USEC_PER_SEC) {
+		smfc->images_per_sec = (unsigned int)div64_u64(
+			(u64)smfc->tput_window_images * USEC_PER_SEC,
+			window_us);
+		smfc->tput_window_beg = now;
+		smfc->tput_window_images = 0;
+	}
+}
+
 static irqreturn_t exynos_smfc_irq_handler(int irq, void *priv)
 {
 	struct smfc_dev *smfc = priv;
@@ -98,6 +129,8 @@ static irqreturn_t exynos_smfc_irq_handler(int irq, void *priv)
 
 			vb->timestamp.tv_usec =
 				(__u32)ktime_us_delta(ktime, ctx->ktime_beg);
+			if (state == VB2_BUF_STATE_DONE)
+				smfc_account_throughput(smfc, ctx, ktime);
 			v4l2_m2m_buf_done(vb, state);
 
 			if ((!!(ctx->flags & SMFC_CTX_COMPRESS)) && ctx->enable_hwfc) {
@@ -195,13 +228,6 @@ static int smfc_vb2_queue_setup(struct vb2_queue *vq,
 {
 	struct smfc_ctx *ctx = vb2_get_drv_priv(vq);
 
-	if (!(ctx->flags & SMFC_CTX_COMPRESS) && (*num_buffers > 1)) {
-		dev_info(ctx->smfc->dev,
-			"Decompression does not allow >1 buffers\n");
-		dev_info(ctx->smfc->dev, "forced buffer count to 1\n");
-		*num_buffers = 1;
-	}
-
 	if (smfc_is_compressed_type(ctx, vq->type)) {
 		/*
 		 * SMFC is able to stop compression if the target buffer is not
@@ -325,9 +351,46 @@ static void smfc_vb2_buf_finish(struct vb2_buffer *vb)
 		vb2_ion_buf_finish_exact(vb);
 }
 
+static void smfc_fence_work(struct work_struct *work)
+{
+	struct smfc_buffer *sb =
+			container_of(work, struct smfc_buffer, fence_work);
+	struct vb2_buffer *vb = &sb->mb.vb.vb2_buf;
+	struct smfc_ctx *ctx = vb2_get_drv_priv(vb->vb2_queue);
+	struct sync_fence *fence = vb->acquire_fence;
+	int ret;
+
+	vb->acquire_fence = NULL;
+
+	ret = sync_fence_wait(fence, 1000);
+	if (ret == -ETIME) {
+		dev_warn(ctx->smfc->dev, "sync_fence_wait() timeout\n");
+		ret = sync_fence_wait(fence, 10 * MSEC_PER_SEC);
+		if (ret)
+			dev_warn(ctx->smfc->dev,
+				 "sync_fence_wait() error (%d)\n", ret);
+	}
+
+	sync_fence_put(fence);
+
+	/* the buffer is processed anyway even though the fence timed out */
+	v4l2_m2m_buf_queue(ctx->fh.m2m_ctx, &sb->mb.vb);
+	v4l2_m2m_try_schedule(ctx->fh.m2m_ctx);
+}
+
+static int smfc_vb2_buf_init(struct vb2_buffer *vb)
+{
+	INIT_WORK(&vb2_to_smfc_buffer(vb)->fence_work, smfc_fence_work);
+
+	return 0;
+}
+
 static void smfc_vb2_buf_cleanup(struct vb2_buffer *vb)
 {
 	struct smfc_ctx *ctx = vb2_get_drv_priv(vb->vb2_queue);
+
+	flush_work(&vb2_to_smfc_buffer(vb)->fence_work);
+
 	if (!V4L2_TYPE_IS_OUTPUT(vb->vb2_queue->type) &&
 			!!(ctx->flags & SMFC_CTX_COMPRESS)) {
 		/*
@@ -346,6 +409,18 @@ static void smfc_vb2_buf_queue(struct vb2_buffer *vb)
 	struct smfc_ctx *ctx = vb2_get_drv_priv(vb->vb2_queue);
 	struct vb2_v4l2_buffer *vbuf = container_of(vb,
 				struct vb2_v4l2_buffer, vb2_buf);
+
+	/*
+	 * The buffer is given to m2m_ctx when its producer signals the fence.
+	 * QBUF does not block on it and the shots of a burst capture can be
+	 * queued back to back, each with its own acquire and release fences.
+	 */
+	if (vb->acquire_fence) {
+		queue_work(ctx->smfc->fence_wq,
+			   &vb2_to_smfc_buffer(vb)->fence_work);
+		return;
+	}
+
 	v4l2_m2m_buf_queue(ctx->fh.m2m_ctx, vbuf);
 }
 
@@ -353,6 +428,12 @@ static void smfc_vb2_stop_streaming(struct vb2_queue *vq)
 {
 	struct vb2_buffer *vb;
 	struct smfc_ctx *ctx = vb2_get_drv_priv(vq);
+	unsigned int i;
+
+	/* buffers waiting for their fences are queued to m2m_ctx first */
+	for (i = 0; i < vq->num_buffers; i++)
+		if (vq->bufs[i]->state == VB2_BUF_STATE_ACTIVE)
+			flush_work(&vb2_to_smfc_buffer(vq->bufs[i])->fence_work);
 
 	if (V4L2_TYPE_IS_OUTPUT(vq->type)) {
 		while ((vb = v4l2_m2m_src_buf_remove(ctx->fh.m2m_ctx)))
@@ -367,6 +448,7 @@ static void smfc_vb2_stop_streaming(struct vb2_queue *vq)
 
 static struct vb2_ops smfc_vb2_ops = {
 	.queue_setup	= smfc_vb2_queue_setup,
+	.buf_init	= smfc_vb2_buf_init,
 	.buf_prepare	= smfc_vb2_buf_prepare,
 	.buf_finish	= smfc_vb2_buf_finish,
 	.buf_cleanup	= smfc_vb2_buf_cleanup,
@@ -388,7 +470,7 @@ static int smfc_queue_init(void *priv, struct vb2_queue *src_vq,
 	src_vq->ops = &smfc_vb2_ops;
 	src_vq->mem_ops = &vb2_ion_memops;
 	src_vq->drv_priv = ctx;
-	src_vq->buf_struct_size = sizeof(struct v4l2_m2m_buffer);
+	src_vq->buf_struct_size = sizeof(struct smfc_buffer);
 	src_vq->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_COPY;
 	src_vq->lock = &ctx->smfc->video_device_mutex;
 
@@ -402,7 +484,7 @@ static int smfc_queue_init(void *priv, struct vb2_queue *src_vq,
 	dst_vq->ops = &smfc_vb2_ops;
 	dst_vq->mem_ops = &vb2_ion_memops;
 	dst_vq->drv_priv = ctx;
-	dst_vq->buf_struct_size = sizeof(struct v4l2_m2m_buffer);
+	dst_vq->buf_struct_size = sizeof(struct smfc_buffer);
 	dst_vq->timestamp_flags = V4L2_BUF_FLAG_TIMESTAMP_COPY;
 	dst_vq->lock = &ctx->smfc->video_device_mutex;
 
@@ -521,9 +603,6 @@ static int exynos_smfc_release(struct file *filp)
 			clk_unprepare(ctx->smfc->clk_gate2);
 	}
 
-	kfree(ctx->quantizer_tables);
-	kfree(ctx->huffman_tables);
-
 	kfree(ctx);
 
 	return 0;
@@ -606,16 +685,20 @@ static void smfc_m2m_device_run(void *priv)
 			smfc_hwconfigure_2nd_image(ctx, !!enable_hwfc);
 		}
 	} else {
-		if ((ctx->stream_width != ctx->width) ||
-				(ctx->stream_height != ctx->height)) {
+		struct vb2_v4l2_buffer *vb = v4l2_m2m_next_src_buf(
+							ctx->fh.m2m_ctx);
+
+		ctx->hdr = &vb2_to_smfc_buffer(&vb->vb2_buf)->hdr;
+		if ((ctx->hdr->stream_width != ctx->width) ||
+				(ctx->hdr->stream_height != ctx->height)) {
 			dev_err(ctx->smfc->dev,
 				"Downscaling on decompression not allowed\n");
 			/* It is okay to abort after reset */
 			goto err_invalid_size;
 		}
 
-		smfc_hwconfigure_image(ctx,
-				ctx->stream_hfactor, ctx->stream_vfactor);
+		smfc_hwconfigure_image(ctx, ctx->hdr->stream_hfactor,
+				       ctx->hdr->stream_vfactor);
 		smfc_hwconfigure_tables_for_decompression(ctx);
 	}
 
@@ -870,6 +953,29 @@ static const struct of_device_id exynos_smfc_match[] = {
 };
 MODULE_DEVICE_TABLE(of, exynos_smfc_match);
 
+static int smfc_throughput_show(struct seq_file *s, void *unused)
+{
+	struct smfc_dev *smfc = s->private;
+
+	seq_printf(s, "images: %lu\n", smfc->nr_images);
+	seq_printf(s, "busy_us: %llu\n", smfc->busy_us);
+	seq_printf(s, "images_per_sec: %u\n", smfc->images_per_sec);
+
+	return 0;
+}
+
+static int smfc_throughput_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, smfc_throughput_show, inode->i_private);
+}
+
+static const struct file_operations smfc_throughput_fops = {
+	.open		= smfc_throughput_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static int exynos_smfc_reboot_notifier(struct notifier_block *nb,
 				unsigned long l, void *p)
 {
@@ -989,6 +1095,18 @@ static int exynos_smfc_probe(struct platform_device *pdev)
 	if (ret < 0)
 		goto err_hwver;
 
+	smfc->fence_wq = create_singlethread_workqueue("smfc_fence_work");
+	if (!smfc->fence_wq) {
+		dev_err(&pdev->dev, "Failed to create workqueue for fence\n");
+		ret = -ENOMEM;
+		goto err_hwver;
+	}
+
+	smfc->debugfs = debugfs_create_dir(dev_name(&pdev->dev), NULL);
+	if (!IS_ERR_OR_NULL(smfc->debugfs))
+		debugfs_create_file("throughput", S_IRUGO, smfc->debugfs,
+				    smfc, &smfc_throughput_fops);
+
 	spin_lock_init(&smfc->flag_lock);
 	smfc->reboot_notifier.notifier_call = exynos_smfc_reboot_notifier;
 	register_reboot_notifier(&smfc->reboot_notifier);
@@ -1022,6 +1140,8 @@ static int exynos_smfc_remove(struct platform_device *pdev)
 {
 	struct smfc_dev *smfc = platform_get_drvdata(pdev);
 
+	debugfs_remove_recursive(smfc->debugfs);
+	destroy_workqueue(smfc->fence_wq);
 	pm_qos_remove_request(&smfc->qosreq_int);
 	vb2_ion_destroy_context(smfc->vb2_alloc_ctx);
 	smfc_deinit_clock(smfc);
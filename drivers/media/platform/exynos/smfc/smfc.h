@@ -14,6 +14,7 @@
 
 #include <linux/ktime.h>
 #include <linux/pm_qos.h>
+#include <linux/workqueue.h>
 #include <media/v4l2-ioctl.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-mem2mem.h>
@@ -24,6 +25,7 @@
 #define MODULE_NAME	"exynos-jpeg"
 
 struct device;
+struct dentry;
 struct video_device;
 
 struct smfc_image_format {
@@ -111,6 +113,17 @@ struct smfc_dev {
 	struct pm_qos_request qosreq_int;
 	s32 qosreq_int_level;
 	struct notifier_block reboot_notifier;
+	/* waits for the acquire fences of buffers before queueing them */
+	struct workqueue_struct *fence_wq;
+
+	/* throughput statistics, updated in exynos_smfc_irq_handler() */
+	struct dentry *debugfs;
+	unsigned long nr_images;
+	unsigned long long busy_us;
+	ktime_t tput_last;
+	ktime_t tput_window_beg;
+	unsigned int tput_window_images;
+	unsigned int images_per_sec;
 };
 
 #define SMFC_CTX_COMPRESS	(1 << 0)
@@ -156,6 +169,29 @@ struct smfc_decomp_qtable {
 	char compsel[SMFC_MAX_QTBL_COUNT];
 };
 
+/* the result of smfc_parse_jpeg_header() on a stream to decompress */
+struct smfc_decomp_header {
+	struct smfc_decomp_qtable quantizer_tables;
+	struct smfc_decomp_htable huffman_tables;
+	unsigned char stream_hfactor;
+	unsigned char stream_vfactor;
+	unsigned char num_components;
+	unsigned int offset_of_sos;
+	__u16 stream_width;
+	__u16 stream_height;
+};
+
+struct smfc_buffer {
+	struct v4l2_m2m_buffer mb;
+	struct work_struct fence_work;
+	struct smfc_decomp_header hdr; /* valid for JPEG streams to decompress */
+};
+
+static inline struct smfc_buffer *vb2_to_smfc_buffer(struct vb2_buffer *vb)
+{
+	return container_of(to_vb2_v4l2_buffer(vb), struct smfc_buffer, mb.vb);
+}
+
 struct smfc_crop {
 	u32 width;
 	u32 height;
@@ -193,15 +229,8 @@ struct smfc_ctx {
 	unsigned char thumb_quality_factor;
 	unsigned char enable_hwfc;
 
-	/* Decompression settings */
-	struct smfc_decomp_qtable *quantizer_tables;
-	struct smfc_decomp_htable *huffman_tables;
-	unsigned char stream_hfactor;
-	unsigned char stream_vfactor;
-	unsigned char num_components;
-	unsigned int offset_of_sos;
-	__u16 stream_width;
-	__u16 stream_height;
+	/* Decompression settings: the header of the stream being decompressed */
+	struct smfc_decomp_header *hdr;
 };
 
 extern const struct v4l2_ioctl_ops smfc_v4l2_ioctl_ops;
@@ -19,6 +19,7 @@
 #include <linux/of_platform.h>
 #include <linux/dma-mapping.h>
 #include <linux/delay.h>
+#include <linux/ktime.h>
 #include <soc/samsung/exynos-pmu.h>
 
 #include "regs-mcu_ipc.h"
@@ -55,41 +56,81 @@ void mcu_ipc_reg_dump(enum mcu_ipc_region id)
 }
 EXPORT_SYMBOL(mcu_ipc_reg_dump);
 
+/*
+ * Bits raised while the handlers of a pass ran are picked up by another
+ * pass of the same interrupt, up to mcu_ipc_batch passes, so that a burst
+ * of control messages does not take an interrupt per message.
+ */
+static unsigned int mcu_ipc_batch = 4;
+module_param(mcu_ipc_batch, uint, 0644);
+MODULE_PARM_DESC(mcu_ipc_batch, "Max dispatch passes per mailbox interrupt");
+
+/* upper bound of the busy wait in mbox_poll_irq() */
+static unsigned int mcu_ipc_poll_max_us = 200;
+module_param(mcu_ipc_poll_max_us, uint, 0644);
+MODULE_PARM_DESC(mcu_ipc_poll_max_us, "Max busy wait of mbox_poll_irq in us");
+
+static void mcu_ipc_dispatch(u32 id, u32 i)
+{
+	struct mcu_ipc_irq_stat *stat = &mcu_dat[id].stat[i];
+	u64 start, delta;
+
+	if (!((1 << (i + 16)) & mcu_dat[id].registered_irq)) {
+		dev_err(mcu_dat[id].mcu_ipc_dev,
+			"Unregistered INT received.\n");
+		return;
+	}
+
+	start = ktime_get_ns();
+	mcu_dat[id].hd[i].handler(mcu_dat[id].hd[i].data);
+	delta = ktime_get_ns() - start;
+
+	stat->total_ns += delta;
+	if (delta > stat->max_ns)
+		stat->max_ns = delta;
+	/* after the handler, mbox_poll_irq() takes the change as done */
+	smp_wmb();
+	stat->count++;
+}
+
 static irqreturn_t mcu_ipc_handler(int irq, void *data)
 {
 	u32 irq_stat, i;
 	u32 id;
+	unsigned int pass = 0;
 
 	id = ((struct mcu_ipc_drv_data *)data)->id;
 
-	spin_lock(&mcu_dat[id].reg_lock);
-
-	/* Check raised interrupts */
-	irq_stat = mcu_ipc_readl(id, EXYNOS_MCU_IPC_INTSR0) & 0xFFFF0000;
-
+	mcu_dat[id].irq_count++;
 
-	/* Only clear and handle unmasked interrupts */
-	irq_stat &= mcu_dat[id].unmasked_irq << 16;
+	do {
+		spin_lock(&mcu_dat[id].reg_lock);
 
+		/* Check raised interrupts */
+		irq_stat = mcu_ipc_readl(id, EXYNOS_MCU_IPC_INTSR0) & 0xFFFF0000;
 
-	/* Interrupt Clear */
-	mcu_ipc_writel(id, irq_stat, EXYNOS_MCU_IPC_INTCR0);
-	spin_unlock(&mcu_dat[id].reg_lock);
+		/* Only clear and handle unmasked interrupts */
+		irq_stat &= mcu_dat[id].unmasked_irq << 16;
 
-	for (i = 0; i < 16; i++) {
-		if (irq_stat & (1 << (i + 16))) {
-			if ((1 << (i + 16)) & mcu_dat[id].registered_irq)
-				mcu_dat[id].hd[i].handler(mcu_dat[id].hd[i].data);
-			else
-				dev_err(mcu_dat[id].mcu_ipc_dev,
-					"Unregistered INT received.\n");
-
-			irq_stat &= ~(1 << (i + 16));
-		}
+		/* Interrupt Clear */
+		mcu_ipc_writel(id, irq_stat, EXYNOS_MCU_IPC_INTCR0);
+		spin_unlock(&mcu_dat[id].reg_lock);
 
 		if (!irq_stat)
 			break;
-	}
+
+		mcu_dat[id].irq_passes++;
+
+		for (i = 0; i < 16; i++) {
+			if (irq_stat & (1 << (i + 16))) {
+				mcu_ipc_dispatch(id, i);
+				irq_stat &= ~(1 << (i + 16));
+			}
+
+			if (!irq_stat)
+				break;
+		}
+	} while (++pass < mcu_ipc_batch);
 
 	return IRQ_HANDLED;
 }
@@ -183,6 +224,56 @@ int mbox_check_irq(enum mcu_ipc_region id, u32 int_num)
 }
 EXPORT_SYMBOL(mbox_check_irq);
 
+/*
+ * mbox_poll_irq
+ *
+ * This function busy waits up to @timeout_us, bounded by
+ * mcu_ipc_poll_max_us, for a mailbox interrupt instead of sleeping until
+ * the IRQ is taken. It is meant for control exchanges whose reply is due
+ * within microseconds. A raised bit is cleared and its handler is run from
+ * here with local interrupts disabled. Returns 1 once the handler has run,
+ * here or from the IRQ, and 0 on timeout.
+ */
+int mbox_poll_irq(enum mcu_ipc_region id, u32 int_num, unsigned int timeout_us)
+{
+	struct mcu_ipc_irq_stat *stat;
+	unsigned long count, flags;
+	u32 irq_stat;
+	ktime_t end;
+
+	if (int_num > 15 || !(mcu_dat[id].registered_irq & BIT(int_num + 16)))
+		return -EINVAL;
+
+	stat = &mcu_dat[id].stat[int_num];
+	count = READ_ONCE(stat->count);
+	end = ktime_add_us(ktime_get(),
+			   min(timeout_us, READ_ONCE(mcu_ipc_poll_max_us)));
+
+	do {
+		if (READ_ONCE(stat->count) != count)
+			return 1;
+
+		spin_lock_irqsave(&mcu_dat[id].reg_lock, flags);
+		irq_stat = mcu_ipc_readl(id, EXYNOS_MCU_IPC_INTSR0) &
+			   BIT(int_num + 16);
+		if (irq_stat) {
+			mcu_ipc_writel(id, irq_stat, EXYNOS_MCU_IPC_INTCR0);
+			spin_unlock(&mcu_dat[id].reg_lock);
+
+			stat->polled++;
+			mcu_ipc_dispatch(id, int_num);
+			local_irq_restore(flags);
+			return 1;
+		}
+		spin_unlock_irqrestore(&mcu_dat[id].reg_lock, flags);
+
+		cpu_relax();
+	} while (ktime_before(ktime_get(), end));
+
+	return 0;
+}
+EXPORT_SYMBOL(mbox_poll_irq);
+
 /*
  * mbox_disable_irq
  *
@@ -373,6 +464,33 @@ static int mcu_ipc_set_affinity(enum mcu_ipc_region id, struct device *dev, int
 }
 #endif
 
+static ssize_t irq_stat_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct mcu_ipc_drv_data *data = dev_get_drvdata(dev);
+	struct mcu_ipc_irq_stat *stat;
+	ssize_t count;
+	u32 i;
+
+	count = scnprintf(buf, PAGE_SIZE, "irqs: %lu passes: %lu\n",
+			data->irq_count, data->irq_passes);
+
+	for (i = 0; i < 16; i++) {
+		stat = &data->stat[i];
+		if (!(data->registered_irq & BIT(i + 16)) && !stat->count)
+			continue;
+
+		count += scnprintf(&buf[count], PAGE_SIZE - count,
+				"int%u: count: %lu polled: %lu avg_ns: %llu max_ns: %llu\n",
+				i, stat->count, stat->polled,
+				stat->count ? div64_u64(stat->total_ns, stat->count) : 0,
+				stat->max_ns);
+	}
+
+	return count;
+}
+static DEVICE_ATTR_RO(irq_stat);
+
 #ifdef CONFIG_MCU_IPC_TEST
 static void test_without_dev(enum mcu_ipc_region id)
 {
@@ -490,6 +608,7 @@ static int mcu_ipc_probe(struct platform_device *pdev)
 
 	mcu_dat[id].id = id;
 	mcu_dat[id].mcu_ipc_dev = &pdev->dev;
+	platform_set_drvdata(pdev, &mcu_dat[id]);
 
 	if (!pdev->dev.dma_mask)
 		pdev->dev.dma_mask = &pdev->dev.coherent_dma_mask;
@@ -540,6 +659,9 @@ static int mcu_ipc_probe(struct platform_device *pdev)
 	shared_reg_ready = true;
 #endif
 
+	if (device_create_file(dev, &dev_attr_irq_stat))
+		dev_err(dev, "failed to create irq_stat sysfs node\n");
+
 	dev_err(&pdev->dev, "%s: mcu_ipc probe done.\n", __func__);
 
 	return 0;
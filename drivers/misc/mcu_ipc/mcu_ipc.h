@@ -28,6 +28,13 @@ struct mcu_ipc_ipc_handler {
 	void (*handler)(void *);
 };
 
+struct mcu_ipc_irq_stat {
+	unsigned long count;	/* handler runs, from the IRQ or polled */
+	unsigned long polled;
+	u64 total_ns;
+	u64 max_ns;
+};
+
 struct mcu_ipc_drv_data {
 	char *name;
 	u32 id;
@@ -44,6 +51,9 @@ struct mcu_ipc_drv_data {
 
 	struct device *mcu_ipc_dev;
 	struct mcu_ipc_ipc_handler hd[16];
+	struct mcu_ipc_irq_stat stat[16];
+	unsigned long irq_count;
+	unsigned long irq_passes;
 	spinlock_t lock;
 	spinlock_t reg_lock;
 
@@ -49,6 +49,7 @@ static DEFINE_MUTEX(mem_lock);
 #define NUM_SOURCES "num-sources"
 
 #define LOWEST_FREQ 2
+#define MAX_SOURCES 16
 
 static int curr_bw;
 static int curr_freq;
@@ -62,10 +63,14 @@ static bool init_success;
 static struct workqueue_struct *memory_wq;
 static u32 num_sources = 10;
 static int *bandwidths;
+static const char *source_names[MAX_SOURCES];
+/* time each source spent in each bandwidth bucket, num_buckets per source */
+static u64 *source_buckets;
 
 struct freq_entry {
 	int freq;
 	u64 *buckets; /* Bandwidth buckets. */
+	u64 *top_source; /* Time each source moved the most data. */
 	struct hlist_node hash;
 };
 
@@ -134,18 +139,141 @@ static ssize_t show_stat_show(struct kobject *kobj,
 }
 KERNEL_ATTR_RO(show_stat);
 
+static struct freq_entry *find_freq_entry(int freq)
+{
+	struct freq_entry *freq_entry;
+
+	hash_for_each_possible(freq_hash_table, freq_entry, hash, freq) {
+		if (freq_entry->freq == freq)
+			return freq_entry;
+	}
+	return NULL;
+}
+
+/* Time at each frequency, whatever the bandwidth. */
+static ssize_t freq_time_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct freq_entry *freq_entry;
+	int i, j;
+	int len = 0;
+	u64 total;
+
+	mutex_lock(&mem_lock);
+	for (i = 0; i < num_freqs; i++) {
+		freq_entry = find_freq_entry(freq_buckets[i]);
+		if (!freq_entry)
+			continue;
+		total = 0;
+		for (j = 0; j < num_buckets; j++)
+			total += freq_entry->buckets[j];
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%d %llu\n",
+				freq_buckets[i], total);
+	}
+	mutex_unlock(&mem_lock);
+	return len;
+}
+KERNEL_ATTR_RO(freq_time);
+
+/* Time each bandwidth source spent in each bandwidth bucket. */
+static ssize_t master_stat_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	char name[16];
+	int i, j;
+	int len = 0;
+
+	if (!init_success)
+		return -ENODEV;
+
+	mutex_lock(&mem_lock);
+	for (i = 0; i < registered_bw_sources; i++) {
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%s",
+				source_name(i, name, sizeof(name)));
+		for (j = 0; j < num_buckets; j++)
+			len += scnprintf(buf + len, PAGE_SIZE - len, " %llu",
+					source_buckets[i * num_buckets + j]);
+		len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	}
+	mutex_unlock(&mem_lock);
+	return len;
+}
+KERNEL_ATTR_RO(master_stat);
+
+/* Time at each frequency per source moving the most data meanwhile. */
+static ssize_t top_master_stat_show(struct kobject *kobj,
+		struct kobj_attribute *attr, char *buf)
+{
+	struct freq_entry *freq_entry;
+	char name[16];
+	int i, j;
+	int len = 0;
+
+	mutex_lock(&mem_lock);
+	len += scnprintf(buf + len, PAGE_SIZE - len, "freq");
+	for (j = 0; j < registered_bw_sources; j++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, " %s",
+				source_name(j, name, sizeof(name)));
+	len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+
+	for (i = 0; i < num_freqs; i++) {
+		freq_entry = find_freq_entry(freq_buckets[i]);
+		if (!freq_entry)
+			continue;
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%d",
+				freq_buckets[i]);
+		for (j = 0; j < registered_bw_sources; j++)
+			len += scnprintf(buf + len, PAGE_SIZE - len, " %llu",
+					freq_entry->top_source[j]);
+		len += scnprintf(buf + len, PAGE_SIZE - len, "\n");
+	}
+	mutex_unlock(&mem_lock);
+	return len;
+}
+KERNEL_ATTR_RO(top_master_stat);
+
+static const char *source_name(int id, char *buf, size_t len)
+{
+	if (source_names[id])
+		return source_names[id];
+	snprintf(buf, len, "source%d", id);
+	return buf;
+}
+
+/* The source with the highest bandwidth, -1 while all are idle */
+static int find_top_source(void)
+{
+	int i, top = -1, top_bw = 0;
+
+	for (i = 0; i < registered_bw_sources; i++) {
+		if (bandwidths[i] > top_bw) {
+			top_bw = bandwidths[i];
+			top = i;
+		}
+	}
+	return top;
+}
+
 static void update_table(u64 time_now)
 {
 	struct freq_entry *freq_entry;
+	u64 diff = get_time_diff(time_now);
+	int i, top;
 
 	pr_debug("Last known bw %d freq %d\n", curr_bw, curr_freq);
+	top = find_top_source();
 	hash_for_each_possible(freq_hash_table, freq_entry, hash, curr_freq) {
 		if (curr_freq == freq_entry->freq) {
-			freq_entry->buckets[find_bucket(curr_bw)]
-					+= get_time_diff(time_now);
+			freq_entry->buckets[find_bucket(curr_bw)] += diff;
+			if (top >= 0)
+				freq_entry->top_source[top] += diff;
 			break;
 		}
 	}
+
+	for (i = 0; i < registered_bw_sources; i++)
+		source_buckets[i * num_buckets + find_bucket(bandwidths[i])]
+				+= diff;
 }
 
 static bool freq_exists(int freq)
@@ -261,7 +389,8 @@ struct memory_state_update_block *memory_state_register_frequency_source(void)
 }
 EXPORT_SYMBOL_GPL(memory_state_register_frequency_source);
 
-struct memory_state_update_block *memory_state_register_bandwidth_source(void)
+struct memory_state_update_block *
+memory_state_register_named_bandwidth_source(const char *name)
 {
 	struct memory_state_update_block *block;
 
@@ -274,7 +403,9 @@ struct memory_state_update_block *memory_state_register_bandwidth_source(void)
 			return NULL;
 		block->update_call = memory_state_bw_update;
 		if (registered_bw_sources < num_sources) {
-			block->id = registered_bw_sources++;
+			block->id = registered_bw_sources;
+			source_names[block->id] = name;
+			registered_bw_sources++;
 		} else {
 			pr_err("Unable to allocate source; max number reached\n");
 			kfree(block);
@@ -285,6 +416,12 @@ struct memory_state_update_block *memory_state_register_bandwidth_source(void)
 	pr_err("Config option disabled.\n");
 	return NULL;
 }
+EXPORT_SYMBOL_GPL(memory_state_register_named_bandwidth_source);
+
+struct memory_state_update_block *memory_state_register_bandwidth_source(void)
+{
+	return memory_state_register_named_bandwidth_source(NULL);
+}
 EXPORT_SYMBOL_GPL(memory_state_register_bandwidth_source);
 
 /* Buckets are designated by their maximum.
@@ -296,6 +433,8 @@ static int get_bw_buckets(struct device *dev)
 	struct device_node *node = dev->of_node;
 
 	of_property_read_u32(node, NUM_SOURCES, &num_sources);
+	num_sources = clamp_t(u32, num_sources, registered_bw_sources,
+			MAX_SOURCES);
 	if (!of_find_property(node, BW_TBL, &lenb)) {
 		pr_err("Missing %s property\n", BW_TBL);
 		return -ENODATA;
@@ -321,6 +460,14 @@ static int get_bw_buckets(struct device *dev)
 		return ret;
 	}
 
+	source_buckets = devm_kcalloc(dev, num_sources * lenb,
+			sizeof(*source_buckets), GFP_KERNEL);
+	if (!source_buckets) {
+		devm_kfree(dev, bandwidths);
+		devm_kfree(dev, bw_buckets);
+		return -ENOMEM;
+	}
+
 	curr_bw = 0;
 	num_buckets = lenb;
 	return 0;
@@ -370,6 +517,13 @@ static int freq_buckets_init(struct device *dev)
 			devm_kfree(dev, freq_entry);
 			return -ENOMEM;
 		}
+		freq_entry->top_source = devm_kcalloc(dev, num_sources,
+				sizeof(u64), GFP_KERNEL);
+		if (!freq_entry->top_source) {
+			devm_kfree(dev, freq_entry->buckets);
+			devm_kfree(dev, freq_entry);
+			return -ENOMEM;
+		}
 		pr_debug("memory_state_time Adding freq to ht %d\n",
 				freq_buckets[i]);
 		freq_entry->freq = freq_buckets[i];
@@ -383,6 +537,9 @@ EXPORT_SYMBOL_GPL(memory_kobj);
 
 static struct attribute *memory_attrs[] = {
 	&show_stat_attr.attr,
+	&freq_time_attr.attr,
+	&master_stat_attr.attr,
+	&top_master_stat_attr.attr,
 	NULL
 };
 
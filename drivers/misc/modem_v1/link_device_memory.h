@@ -178,6 +178,8 @@ struct mem_ipc_device {
 #ifdef GROUP_MEM_FLOW_CONTROL
 #define MAX_SKB_TXQ_DEPTH		1024
 #define TX_PERIOD_MS			1	/* 1 ms */
+#define TX_BULK_FPS			2000	/* coalesce doorbells above it */
+#define TX_RATE_WINDOW_MS		100	/* 100 ms */
 #define MAX_TX_BUSY_COUNT		1024
 #define BUSY_COUNT_MASK			0xF
 
@@ -494,9 +496,23 @@ struct mem_link_device {
 	struct dentry *dbgfs_frame;
 #endif
 	unsigned int tx_period_ms;
+
+	/*
+	Adaptive TX doorbell coalescing, protected by mc->lock
+	*/
+	unsigned int tx_bulk_fps;	/* 0 always waits for tx_period_ms */
+	bool tx_bulk;
+	unsigned int tx_batch;		/* frames sent without waiting */
+	unsigned int tx_fps;
+	unsigned int tx_doorbell_rate;
+	unsigned int tx_window_frames;
+	unsigned int tx_window_doorbells;
+	u64 tx_window_start;
+
 	unsigned int force_use_memcpy;
 	unsigned int memcpy_packet_count;
 	unsigned int zeromemcpy_packet_count;
+	u64 zeromemcpy_bytes;
 
 #ifdef CONFIG_LINK_DEVICE_NAPI
 	struct net_device dummy_net;
@@ -894,7 +910,8 @@ static inline struct sk_buff *mem_alloc_skb(unsigned int len)
 
 	priority = in_interrupt() ? GFP_ATOMIC : GFP_KERNEL;
 
-	skb = alloc_skb(len + NET_SKB_PAD, priority);
+	/* NET_SKB_PAD headroom is reserved by the pool */
+	skb = skb_rx_pool_alloc(mif_rx_pool, len, priority);
 	if (!skb) {
 		mif_err("ERR! alloc_skb(len:%d + pad:%d, gfp:0x%x) fail\n",
 			len, NET_SKB_PAD, priority);
@@ -904,7 +921,6 @@ static inline struct sk_buff *mem_alloc_skb(unsigned int len)
 		return NULL;
 	}
 
-	skb_reserve(skb, NET_SKB_PAD);
 	return skb;
 }
 
@@ -25,6 +25,11 @@
 #include "link_device_memory.h"
 #include "include/sbd.h"
 #include <linux/shm_ipc.h>
+#ifdef CONFIG_CP_ZEROCOPY
+#include <linux/kfifo.h>
+#include <linux/dma-direction.h>
+#include <asm/cacheflush.h>
+#endif
 
 #ifdef GROUP_MEM_LINK_SBD
 /**
@@ -592,7 +597,7 @@ static inline struct sk_buff *recv_data(struct sbd_ring_buffer *rb, u16 out)
 		return NULL;
 	}
 
-	skb = dev_alloc_skb(len);
+	skb = skb_rx_pool_alloc(mif_rx_pool, len, GFP_ATOMIC);
 	if (unlikely(!skb)) {
 		mif_err("ERR! {id:%d ch:%d} alloc_skb(%d) fail\n",
 			rb->id, rb->ch, len);
@@ -606,10 +611,9 @@ static inline struct sk_buff *recv_data(struct sbd_ring_buffer *rb, u16 out)
 	return skb;
 }
 
-static inline void set_skb_priv(struct sbd_ring_buffer *rb, struct sk_buff *skb)
+static inline void set_skb_priv(struct sbd_ring_buffer *rb, struct sk_buff *skb,
+				unsigned int out)
 {
-	unsigned int out = *rb->rp;
-
 	/* Record the IO device, the link device, etc. into &skb->cb */
 	if (sipc_ps_ch(rb->ch)) {
 		unsigned ch = (rb->size_v[out] >> 16) & 0xff;
@@ -640,7 +644,7 @@ struct sk_buff *sbd_pio_rx(struct sbd_ring_buffer *rb)
 
 	set_lnk_hdr(rb, skb);
 
-	set_skb_priv(rb, skb);
+	set_skb_priv(rb, skb, out);
 
 	check_more(rb, skb);
 
@@ -649,6 +653,194 @@ struct sk_buff *sbd_pio_rx(struct sbd_ring_buffer *rb)
 	return skb;
 }
 
+#ifdef CONFIG_CP_ZEROCOPY
+/*
+In a zerocopy DL RB the SBDs point into the ZMB region instead of buff_rgn.
+AP posts empty mif_buff cells by advancing wp, CP fills them and advances rp,
+and AP consumes them from pre_rp. A filled cell becomes the head of an skb
+as is, and goes back to the pool when the stack frees the skb.
+*/
+#define ZEROCOPY_HEADROOM	NET_SKB_PAD
+
+/* CP sees the ZMB region at its offset from the base of CP memory */
+static inline u32 zerocopy_buff_offset(u8 *buff)
+{
+	return (u32)(virt_to_phys(buff) - shm_get_phys_base());
+}
+
+int allocate_data_in_advance(struct zerocopy_adaptor *zdptr)
+{
+	struct sbd_ring_buffer *rb = zdptr->rb;
+	struct mif_buff_mng *bm = rb->ld->mif_buff_mng;
+	unsigned int wp;
+	unsigned int posted = 0;
+	unsigned long flags;
+	u8 *buff;
+	int ret = 0;
+
+	spin_lock_irqsave(&zdptr->lock, flags);
+
+	wp = *zdptr->wp;
+	while (circ_get_space(zdptr->len, wp, zdptr->pre_rp) > 0) {
+		buff = alloc_mif_buff(bm);
+		if (!buff) {
+			ret = -ENOMEM;
+			break;
+		}
+
+		/* No dirty line may be written back over what CP puts here */
+		__dma_map_area(buff + ZEROCOPY_HEADROOM, rb->buff_size,
+			       DMA_FROM_DEVICE);
+
+		kfifo_in_spinlocked(&zdptr->fifo, &buff, sizeof(buff),
+				    &zdptr->lock_kfifo);
+
+		rb->addr_v[wp] = zerocopy_buff_offset(buff + ZEROCOPY_HEADROOM);
+		rb->size_v[wp] = 0;
+		wp = circ_new_ptr(zdptr->len, wp, 1);
+		posted++;
+	}
+
+	if (posted) {
+		/* Commit the SBDs before handing all of them over at once */
+		wmb();
+		*zdptr->wp = wp;
+	}
+
+	spin_unlock_irqrestore(&zdptr->lock, flags);
+
+	return ret;
+}
+
+struct sk_buff *sbd_pio_rx_zerocopy_adaptor(struct sbd_ring_buffer *rb,
+					    int use_memcpy)
+{
+	struct zerocopy_adaptor *zdptr = rb->zdptr;
+	struct mif_buff_mng *bm = rb->ld->mif_buff_mng;
+	struct mem_link_device *mld = ld_to_mem_link_device(rb->ld);
+	unsigned int out = zdptr->pre_rp;
+	unsigned int len = rb->size_v[out] & 0xFFFF;
+	struct sk_buff *skb = NULL;
+	u8 *buff;
+
+	if (out >= zdptr->len) {
+		mif_err("out value exceeds ring buffer size\n");
+		return NULL;
+	}
+
+	if (unlikely(kfifo_out_spinlocked(&zdptr->fifo, &buff, sizeof(buff),
+			&zdptr->lock_kfifo) != sizeof(buff))) {
+		mif_err("ERR! {id:%d ch:%d} no buffer posted at %u\n",
+			rb->id, rb->ch, out);
+		return NULL;
+	}
+
+	if (unlikely(len > rb->buff_size)) {
+		mif_err("ERR! {id:%d ch:%d} size %d > space %d\n",
+			rb->id, rb->ch, len, rb->buff_size);
+		free_mif_buff(bm, buff);
+		goto next;
+	}
+
+	/* Drop lines the CPU may have pulled in while CP was writing */
+	__dma_unmap_area(buff + ZEROCOPY_HEADROOM, len, DMA_FROM_DEVICE);
+
+	if (use_memcpy) {
+		skb = skb_rx_pool_alloc(mif_rx_pool, len, GFP_ATOMIC);
+		if (likely(skb))
+			skb_copy_to_linear_data(skb, buff + ZEROCOPY_HEADROOM,
+						len);
+		free_mif_buff(bm, buff);
+	} else {
+		skb = build_skb(buff, bm->cell_size);
+		if (likely(skb)) {
+			/* Not a page fragment, the head goes back to the pool */
+			skb->head_frag = 0;
+			skb_reserve(skb, ZEROCOPY_HEADROOM);
+			mld->zeromemcpy_bytes += len;
+		} else {
+			free_mif_buff(bm, buff);
+		}
+	}
+
+	if (unlikely(!skb)) {
+		mif_err("ERR! {id:%d ch:%d} alloc_skb(%d) fail\n",
+			rb->id, rb->ch, len);
+		goto next;
+	}
+
+	skb_put(skb, len);
+
+	set_lnk_hdr(rb, skb);
+
+	set_skb_priv(rb, skb, out);
+
+	check_more(rb, skb);
+
+next:
+	zdptr->pre_rp = circ_new_ptr(zdptr->len, out, 1);
+
+	return skb;
+}
+
+int setup_zerocopy_adaptor(struct sbd_ipc_device *ipc_dev)
+{
+	struct sbd_ring_buffer *rb = &ipc_dev->rb[DL];
+	struct mif_buff_mng *bm = rb->ld->mif_buff_mng;
+	struct zerocopy_adaptor *zdptr = ipc_dev->zdptr;
+	u8 *buff;
+
+	if (!rb->zerocopy)
+		return 0;
+
+	if (!bm || rb->buff_size + ZEROCOPY_HEADROOM +
+	    SKB_DATA_ALIGN(sizeof(struct skb_shared_info)) > bm->cell_size) {
+		mif_err("ERR! RB[%d:%d] no mif_buff pool for %u byte SBDs\n",
+			rb->id, rb->ch, rb->buff_size);
+		return -ENOMEM;
+	}
+
+	if (!zdptr) {
+		zdptr = kzalloc(sizeof(struct zerocopy_adaptor), GFP_ATOMIC);
+		if (!zdptr)
+			return -ENOMEM;
+
+		if (kfifo_alloc(&zdptr->fifo, rb->len * sizeof(u8 *),
+				GFP_ATOMIC)) {
+			kfree(zdptr);
+			return -ENOMEM;
+		}
+
+		spin_lock_init(&zdptr->lock);
+		spin_lock_init(&zdptr->lock_kfifo);
+		hrtimer_init(&zdptr->datalloc_timer, CLOCK_MONOTONIC,
+			     HRTIMER_MODE_REL);
+		zdptr->datalloc_timer.function = datalloc_timer_func;
+
+		ipc_dev->zdptr = zdptr;
+	} else {
+		/* CP has restarted, take back whatever was posted to it */
+		while (kfifo_out(&zdptr->fifo, &buff, sizeof(buff)) ==
+		       sizeof(buff))
+			free_mif_buff(bm, buff);
+	}
+
+	zdptr->rb = rb;
+	zdptr->rp = rb->rp;
+	zdptr->wp = rb->wp;
+	zdptr->len = rb->len;
+	zdptr->pre_rp = *rb->rp;
+	rb->zdptr = zdptr;
+
+	mif_err("RB[%d:%d] zerocopy with %u free mif_buff cells\n",
+		rb->id, rb->ch, get_mif_buff_free_count(bm));
+
+	allocate_data_in_advance(zdptr);
+
+	return 0;
+}
+#endif
+
 /**
 @}
 */
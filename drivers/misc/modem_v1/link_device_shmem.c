@@ -132,6 +132,7 @@ enum smc_error_flag {
 
 static inline void start_tx_timer(struct mem_link_device *mld,
 				  struct hrtimer *timer);
+static inline void tx_doorbell(struct mem_link_device *mld, u16 mask);
 
 static char *smc_err_string[32] = {
 	"CP_NO_ERROR",
@@ -798,6 +799,79 @@ static int tx_frames_to_dev(struct mem_link_device *mld,
 	return (ret < 0) ? ret : tx_bytes;
 }
 
+/*
+While frames come in slowly each one is pushed and rung to CP right away,
+so a ping does not sit out tx_period_ms. Once the fill rate of the TX queues
+reaches tx_bulk_fps the timer waits for tx_period_ms, or until as many
+frames as usually arrive within it are queued, and one doorbell covers the
+lot. Both rates are measured over TX_RATE_WINDOW_MS; mc->lock must be held.
+*/
+static void tx_rate_update(struct mem_link_device *mld, unsigned int frames,
+			   unsigned int doorbells)
+{
+	u64 now = ktime_get_ns();
+	u64 elapsed = now - mld->tx_window_start;
+
+	mld->tx_window_frames += frames;
+	mld->tx_window_doorbells += doorbells;
+
+	if (elapsed < TX_RATE_WINDOW_MS * NSEC_PER_MSEC)
+		return;
+
+	mld->tx_fps = div64_u64((u64)mld->tx_window_frames * NSEC_PER_SEC,
+				elapsed);
+	mld->tx_doorbell_rate = div64_u64(
+			(u64)mld->tx_window_doorbells * NSEC_PER_SEC, elapsed);
+	mld->tx_window_frames = 0;
+	mld->tx_window_doorbells = 0;
+	mld->tx_window_start = now;
+
+	/* Leave bulk mode only well below the rate that entered it */
+	if (!mld->tx_bulk_fps)
+		mld->tx_bulk = true;
+	else if (mld->tx_fps >= mld->tx_bulk_fps)
+		mld->tx_bulk = true;
+	else if (mld->tx_fps < mld->tx_bulk_fps / 2)
+		mld->tx_bulk = false;
+
+	mld->tx_batch = max_t(unsigned int, 1,
+			      mld->tx_fps * mld->tx_period_ms / MSEC_PER_SEC);
+}
+
+static inline void tx_doorbell(struct mem_link_device *mld, u16 mask)
+{
+	send_ipc_irq(mld, mask2int(mask));
+	tx_rate_update(mld, 0, 1);
+}
+
+static inline void kick_tx_timer(struct mem_link_device *mld,
+				 struct hrtimer *timer, unsigned int qlen)
+{
+	struct link_device *ld = &mld->link_dev;
+	struct modem_ctl *mc = ld->mc;
+	unsigned long flags;
+	ktime_t ktime;
+
+	spin_lock_irqsave(&mc->lock, flags);
+
+	if (unlikely(cp_offline(mc)))
+		goto exit;
+
+	tx_rate_update(mld, 1, 0);
+
+	if (!mld->tx_bulk || (mld->tx_bulk_fps && qlen >= mld->tx_batch)) {
+		/* Also pulls in a pending timer once a full batch is queued */
+		if (!hrtimer_is_queued(timer) || qlen == mld->tx_batch)
+			hrtimer_start(timer, ktime_set(0, 0), HRTIMER_MODE_REL);
+	} else if (!hrtimer_is_queued(timer)) {
+		ktime = ktime_set(0, mld->tx_period_ms * NSEC_PER_MSEC);
+		hrtimer_start(timer, ktime, HRTIMER_MODE_REL);
+	}
+
+exit:
+	spin_unlock_irqrestore(&mc->lock, flags);
+}
+
 static enum hrtimer_restart tx_timer_func(struct hrtimer *timer)
 {
 	struct mem_link_device *mld;
@@ -883,7 +957,7 @@ static enum hrtimer_restart tx_timer_func(struct hrtimer *timer)
 	}
 
 	if (mask)
-		send_ipc_irq(mld, mask2int(mask));
+		tx_doorbell(mld, mask);
 
 exit:
 	if (need_schedule) {
@@ -1103,7 +1177,7 @@ static enum hrtimer_restart sbd_tx_timer_func(struct hrtimer *timer)
 			need_schedule = false;
 			goto exit;
 		}
-		send_ipc_irq(mld, mask2int(mask));
+		tx_doorbell(mld, mask);
 		spin_unlock_irqrestore(&mc->lock, flags);
 	}
 
@@ -1184,7 +1258,7 @@ static int xmit_ipc_to_rb(struct mem_link_device *mld, enum sipc_ch_id ch,
 
 		ret = skb->len;
 		skb_queue_tail(skb_txq, skb);
-		start_tx_timer(mld, &mld->sbd_tx_timer);
+		kick_tx_timer(mld, &mld->sbd_tx_timer, skb_txq->qlen);
 	}
 
 	spin_unlock_irqrestore(&rb->lock, flags);
@@ -1228,7 +1302,7 @@ static int xmit_ipc_to_dev(struct mem_link_device *mld, enum sipc_ch_id ch,
 	} else {
 		ret = skb->len;
 		skb_queue_tail(dev->skb_txq, skb);
-		start_tx_timer(mld, &mld->tx_timer);
+		kick_tx_timer(mld, &mld->tx_timer, skb_txq->qlen);
 	}
 
 #ifdef CONFIG_LINK_POWER_MANAGEMENT
@@ -2294,10 +2368,12 @@ module_param(gro_flush_time, long, 0644);
 static void gro_flush_timer(struct link_device *ld)
 {
 	struct mem_link_device *mld = to_mem_link_device(ld);
+	/* mld_napi or the NAPI of a PDN, whichever is running the frame */
+	struct napi_struct *napi = napi_get_current();
 	struct timespec curr, diff;
 
 	if (!gro_flush_time) {
-		napi_gro_flush(&mld->mld_napi, false);
+		napi_gro_flush(napi, false);
 		return;
 	}
 
@@ -2307,7 +2383,7 @@ static void gro_flush_timer(struct link_device *ld)
 		getnstimeofday(&(curr));
 		diff = timespec_sub(curr, mld->flush_time);
 		if ((diff.tv_sec > 0) || (diff.tv_nsec > gro_flush_time)) {
-			napi_gro_flush(&mld->mld_napi, false);
+			napi_gro_flush(napi, false);
 			getnstimeofday(&mld->flush_time);
 		}
 	}
@@ -3183,6 +3259,43 @@ static ssize_t tx_period_ms_store(struct device *dev,
 	return ret;
 }
 
+static ssize_t tx_bulk_fps_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct modem_data *modem;
+	modem = (struct modem_data *)dev->platform_data;
+	return sprintf(buf, "%u\n", modem->mld->tx_bulk_fps);
+}
+
+static ssize_t tx_bulk_fps_store(struct device *dev,
+		struct device_attribute *attr,
+		const char *buf, size_t count)
+{
+	int ret;
+	struct modem_data *modem;
+	modem = (struct modem_data *)dev->platform_data;
+
+	ret = sscanf(buf, "%u", &modem->mld->tx_bulk_fps);
+	if (ret != 1)
+		return -EINVAL;
+
+	ret = count;
+	return ret;
+}
+
+static ssize_t tx_coalesce_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct modem_data *modem;
+	struct mem_link_device *mld;
+	modem = (struct modem_data *)dev->platform_data;
+	mld = modem->mld;
+
+	return sprintf(buf, "mode(%s) frames/s(%u) batch(%u) doorbells/s(%u)\n",
+			mld->tx_bulk ? "bulk" : "latency", mld->tx_fps,
+			mld->tx_batch, mld->tx_doorbell_rate);
+}
+
 static int rb_ch_id = 8;
 static ssize_t rb_info_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
@@ -3237,8 +3350,9 @@ static ssize_t zmc_count_show(struct device *dev,
 	struct modem_data *modem;
 	modem = (struct modem_data *)dev->platform_data;
 
-	return sprintf(buf, "memcpy_packet(%d)/zeromemcpy_packet(%d)\n",
-			modem->mld->memcpy_packet_count, modem->mld->zeromemcpy_packet_count);
+	return sprintf(buf, "memcpy_packet(%d)/zeromemcpy_packet(%d) saved %llu bytes\n",
+			modem->mld->memcpy_packet_count, modem->mld->zeromemcpy_packet_count,
+			modem->mld->zeromemcpy_bytes);
 }
 
 static ssize_t zmc_count_store(struct device *dev,
@@ -3254,6 +3368,7 @@ static ssize_t zmc_count_store(struct device *dev,
 	if (val == 0) {
 		modem->mld->memcpy_packet_count = 0;
 		modem->mld->zeromemcpy_packet_count = 0;
+		modem->mld->zeromemcpy_bytes = 0;
 	}
 
 	return count;
@@ -3298,6 +3413,8 @@ static ssize_t force_use_memcpy_store(struct device *dev,
 #endif
 
 static DEVICE_ATTR_RW(tx_period_ms);
+static DEVICE_ATTR_RW(tx_bulk_fps);
+static DEVICE_ATTR_RO(tx_coalesce);
 static DEVICE_ATTR_RW(rb_info);
 #if defined(CONFIG_CP_ZEROCOPY)
 static DEVICE_ATTR_RO(mif_buff_mng);
@@ -3307,6 +3424,8 @@ static DEVICE_ATTR_RW(force_use_memcpy);
 
 static struct attribute *shmem_attrs[] = {
 	&dev_attr_tx_period_ms.attr,
+	&dev_attr_tx_bulk_fps.attr,
+	&dev_attr_tx_coalesce.attr,
 	&dev_attr_rb_info.attr,
 #if defined(CONFIG_CP_ZEROCOPY)
 	&dev_attr_mif_buff_mng.attr,
@@ -3423,6 +3542,71 @@ static ssize_t rx_int_disabled_time_store(struct device *dev,
 	return count;
 }
 
+#ifdef CONFIG_LINK_DEVICE_PDN_NAPI
+static ssize_t pdn_napi_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct modem_data *modem;
+	struct modem_shared *msd;
+	struct io_device *iod;
+	ssize_t count = 0;
+	int cpu;
+
+	modem = (struct modem_data *)dev->platform_data;
+	msd = modem->mld->link_dev.msd;
+
+	spin_lock(&msd->active_list_lock);
+	list_for_each_entry(iod, &msd->activated_ndev_list, node_ndev) {
+		count += scnprintf(&buf[count], PAGE_SIZE - count,
+				"%s: cpu(%d) rx(%lu) drop(%lu) qlen(%u) polls",
+				iod->name, iod->napi_cpu, iod->napi_rx_packets,
+				iod->napi_rx_dropped, skb_queue_len(&iod->napi_q));
+		for_each_possible_cpu(cpu)
+			count += scnprintf(&buf[count], PAGE_SIZE - count,
+					" %u", iod->napi_cpu_polls[cpu]);
+		count += scnprintf(&buf[count], PAGE_SIZE - count, "\n");
+	}
+	spin_unlock(&msd->active_list_lock);
+
+	return count;
+}
+
+/* "<ndev name> <cpu>", cpu -1 runs the PDN in the link device NAPI */
+static ssize_t pdn_napi_store(struct device *dev,
+		struct device_attribute *attr,
+		const char *buf, size_t count)
+{
+	struct modem_data *modem;
+	struct modem_shared *msd;
+	struct io_device *iod;
+	char name[IFNAMSIZ];
+	int cpu;
+	int ret = -ENODEV;
+
+	modem = (struct modem_data *)dev->platform_data;
+	msd = modem->mld->link_dev.msd;
+
+	if (sscanf(buf, "%15s %d", name, &cpu) != 2)
+		return -EINVAL;
+
+	if (cpu >= nr_cpu_ids || (cpu >= 0 && !cpu_possible(cpu)))
+		return -EINVAL;
+
+	spin_lock(&msd->active_list_lock);
+	list_for_each_entry(iod, &msd->activated_ndev_list, node_ndev) {
+		if (!strcmp(iod->name, name)) {
+			WRITE_ONCE(iod->napi_cpu, cpu < 0 ? -1 : cpu);
+			ret = count;
+			break;
+		}
+	}
+	spin_unlock(&msd->active_list_lock);
+
+	return ret;
+}
+static DEVICE_ATTR_RW(pdn_napi);
+#endif
+
 static DEVICE_ATTR_RO(rx_napi_list);
 static DEVICE_ATTR_RO(rx_int_enable);
 static DEVICE_ATTR_RW(rx_int_count);
@@ -3435,6 +3619,9 @@ static struct attribute *napi_attrs[] = {
 	&dev_attr_rx_int_count.attr,
 	&dev_attr_rx_poll_count.attr,
 	&dev_attr_rx_int_disabled_time.attr,
+#ifdef CONFIG_LINK_DEVICE_PDN_NAPI
+	&dev_attr_pdn_napi.attr,
+#endif
 	NULL,
 };
 
@@ -3724,6 +3911,16 @@ struct link_device *shmem_create_link_device(struct platform_device *pdev)
 				CLOCK_MONOTONIC, HRTIMER_MODE_REL);
 		mld->sbd_print_timer.function = sbd_print;
 
+#ifdef CONFIG_CP_ZEROCOPY
+		/* The ZMB region CP can reach is carved into skb heads */
+		if (!g_mif_buff_mng && shm_get_zmb_size())
+			g_mif_buff_mng = init_mif_buff_mng(
+					(unsigned char *)shm_get_zmb_region(),
+					shm_get_zmb_size(),
+					MIF_BUFF_DEFAULT_CELL_SIZE);
+		ld->mif_buff_mng = g_mif_buff_mng;
+#endif
+
 		err = create_sbd_link_device(ld,
 				&mld->sbd_link_dev, mld->base, mld->size);
 		if (err < 0)
@@ -3887,6 +4084,8 @@ struct link_device *shmem_create_link_device(struct platform_device *pdev)
 	clean_vss_magic_code();
 
 	mld->tx_period_ms = TX_PERIOD_MS;
+	mld->tx_bulk_fps = TX_BULK_FPS;
+	mld->tx_batch = 1;
 
 	if (sysfs_create_group(&pdev->dev.kobj, &shmem_group))
 		mif_err("failed to create sysfs node related shmem\n");
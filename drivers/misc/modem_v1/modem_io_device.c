@@ -316,14 +316,119 @@ static int check_gro_support(struct sk_buff *skb)
 }
 #endif
 
-static int rx_multi_pdp(struct sk_buff *skb)
+static int rx_multi_pdp_deliver(struct io_device *iod, struct sk_buff *skb)
 {
 	struct link_device *ld = skbpriv(skb)->ld;
+	struct net_device *ndev = iod->ndev;
+	int ret;
+
+	if (check_gro_support(skb)) {
+		ret = napi_gro_receive(napi_get_current(), skb);
+		if (ret == GRO_DROP) {
+			ndev->stats.rx_dropped++;
+		}
+
+		if (ld->gro_flush)
+			ld->gro_flush(ld);
+	} else {
+#ifdef CONFIG_LINK_DEVICE_NAPI
+		ret = netif_receive_skb(skb);
+#else /* !CONFIG_LINK_DEVICE_NAPI */
+		if (in_interrupt())
+			ret = netif_rx(skb);
+		else
+			ret = netif_rx_ni(skb);
+#endif /* CONFIG_LINK_DEVICE_NAPI */
+
+		if (ret != NET_RX_SUCCESS) {
+			ndev->stats.rx_dropped++;
+		}
+	}
+
+	return ret;
+}
+
+#ifdef CONFIG_LINK_DEVICE_PDN_NAPI
+#define MAX_PDN_NAPI_QLEN	2048
+
+/*
+A PDN with a napi_cpu gets its frames handed over by the link device NAPI
+and runs the stack for them, GRO included, in its own NAPI on that CPU.
+*/
+static void pdn_napi_csd_func(void *info)
+{
+	struct io_device *iod = info;
+
+	__napi_schedule(&iod->napi);
+}
+
+static int pdn_napi_poll(struct napi_struct *napi, int budget)
+{
+	struct io_device *iod = container_of(napi, struct io_device, napi);
+	struct sk_buff *skb;
+	int rcvd = 0;
+
+	iod->napi_cpu_polls[smp_processor_id()]++;
+
+	while (rcvd < budget) {
+		skb = skb_dequeue(&iod->napi_q);
+		if (!skb)
+			break;
+
+		rx_multi_pdp_deliver(iod, skb);
+		rcvd++;
+	}
+	iod->napi_rx_packets += rcvd;
+
+	if (rcvd < budget) {
+		napi_complete_done(napi, rcvd);
+		/* A frame queued while SCHED was still set has no one to run it */
+		if (!skb_queue_empty(&iod->napi_q))
+			napi_schedule(napi);
+	}
+
+	return rcvd;
+}
+
+static void pdn_napi_queue(struct io_device *iod, struct sk_buff *skb, int cpu)
+{
+	if (unlikely(skb_queue_len(&iod->napi_q) >= MAX_PDN_NAPI_QLEN)) {
+		iod->napi_rx_dropped++;
+		iod->ndev->stats.rx_dropped++;
+		dev_kfree_skb_any(skb);
+		return;
+	}
+
+	skb_queue_tail(&iod->napi_q, skb);
+
+	if (!napi_schedule_prep(&iod->napi))
+		return;
+
+	if (cpu == smp_processor_id() ||
+	    smp_call_function_single_async(cpu, &iod->napi_csd))
+		__napi_schedule(&iod->napi);
+}
+
+static void init_pdn_napi(struct io_device *iod)
+{
+	skb_queue_head_init(&iod->napi_q);
+	iod->napi_cpu = -1;
+	iod->napi_csd.func = pdn_napi_csd_func;
+	iod->napi_csd.info = iod;
+	netif_napi_add(iod->ndev, &iod->napi, pdn_napi_poll, NAPI_POLL_WEIGHT);
+	napi_enable(&iod->napi);
+}
+#endif
+
+static int rx_multi_pdp(struct sk_buff *skb)
+{
 	struct io_device *iod = skbpriv(skb)->iod;
 	struct net_device *ndev;
 	struct iphdr *iphdr;
 	int len = skb->len;
-	int ret;
+#ifdef CONFIG_LINK_DEVICE_PDN_NAPI
+	int cpu;
+#endif
 
 	ndev = iod->ndev;
 	if (!ndev) {
@@ -371,28 +476,16 @@ static int rx_multi_pdp(struct sk_buff *skb)
 	skb_reset_network_header(skb);
 	skb_reset_mac_header(skb);
 
-	if (check_gro_support(skb)) {
-		ret = napi_gro_receive(napi_get_current(), skb);
-		if (ret == GRO_DROP) {
-			ndev->stats.rx_dropped++;
-		}
+#ifdef CONFIG_LINK_DEVICE_PDN_NAPI
+	cpu = READ_ONCE(iod->napi_cpu);
+	if (cpu >= 0 && cpu_online(cpu)) {
+		pdn_napi_queue(iod, skb, cpu);
+		return len;
+	}
+#endif
 
-		if (ld->gro_flush)
-			ld->gro_flush(ld);
-	} else {
-#ifdef CONFIG_LINK_DEVICE_NAPI
-		ret = netif_receive_skb(skb);
-#else /* !CONFIG_LINK_DEVICE_NAPI */
-		if (in_interrupt())
-			ret = netif_rx(skb);
-		else
-			ret = netif_rx_ni(skb);
-#endif /* CONFIG_LINK_DEVICE_NAPI */
+	rx_multi_pdp_deliver(iod, skb);
 
-		if (ret != NET_RX_SUCCESS) {
-			ndev->stats.rx_dropped++;
-		}
-	}
 	return len;
 }
 
@@ -1550,6 +1643,10 @@ int sipc5_init_io_device(struct io_device *iod)
 		mif_debug("vnet 0x%pK\n", vnet);
 		vnet->iod = iod;
 
+#ifdef CONFIG_LINK_DEVICE_PDN_NAPI
+		init_pdn_napi(iod);
+#endif
+
 		break;
 
 	case IODEV_DUMMY:
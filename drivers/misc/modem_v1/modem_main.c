@@ -58,6 +58,13 @@
 #define RAW_WAKE_TIME   (HZ*6)
 #define NET_WAKE_TIME	(HZ/2)
 
+/* Pages per cpu kept for recycling RX skb heads, 0 disables the pool */
+static unsigned int rx_pool_pages = 64;
+module_param(rx_pool_pages, uint, S_IRUGO);
+MODULE_PARM_DESC(rx_pool_pages, "RX page pool depth per cpu");
+
+struct skb_rx_pool *mif_rx_pool;
+
 static struct modem_shared *create_modem_shared_data(
 				struct platform_device *pdev)
 {
@@ -775,6 +782,13 @@ static int modem_probe(struct platform_device *pdev)
 		return -ENOMEM;
 	}
 
+	/* Without the pool RX falls back to the netdev fragment cache */
+	if (!mif_rx_pool && rx_pool_pages) {
+		mif_rx_pool = skb_rx_pool_create("modem_v1", rx_pool_pages);
+		if (!mif_rx_pool)
+			mif_err("%s: no RX page pool\n", pdata->name);
+	}
+
 	modemctl = create_modemctl_device(pdev, msd);
 	if (!modemctl) {
 		mif_err("%s: modemctl == NULL\n", pdata->name);
@@ -985,6 +999,7 @@ static struct platform_driver modem_driver = {
 	.driver = {
 		.name = "mif_sipc5",
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.pm = &modem_pm_ops,
 		.suppress_bind_attrs = true,
 #ifdef CONFIG_OF
@@ -19,6 +19,8 @@
 #include <linux/skbuff.h>
 #include <linux/interrupt.h>
 #include <linux/netdevice.h>
+#include <linux/vmalloc.h>
+#include <linux/percpu.h>
 
 #include "modem_pktlog.h"
 
@@ -54,13 +56,83 @@ void pktlog_copy_buf(struct pktlog_data *pktlog, int type, void *buf)
 }
 #endif
 
+static inline unsigned pktlog_snaplen(struct pktlog_data *pktlog)
+{
+	if (pktlog->hdr_only)
+		return min_t(unsigned, pktlog->snaplen, PKTLOG_HDR_ONLY_LEN);
+	return pktlog->snaplen;
+}
+
+static inline struct pktlog_ring_hdr *pktlog_ring_of(struct pktlog_data *pktlog,
+		int cpu)
+{
+	return pktlog->ring + cpu * PKTLOG_RING_CPU_SZ;
+}
+
+/* the ring is ready to be read once it holds this many records */
+#define PKTLOG_RING_WAKE_SLOTS	(PKTLOG_RING_SLOTS / 8)
+
+/* called with irqs off: the only producer of this CPU ring */
+static void pktlog_ring_put(struct pktlog_data *pktlog, unsigned char dir,
+		struct sk_buff *skb)
+{
+	struct pktlog_ring_hdr *rh = pktlog_ring_of(pktlog, smp_processor_id());
+	struct pktlog_rec *rec;
+	unsigned head = rh->head;
+	unsigned used = head - READ_ONCE(rh->tail);
+	unsigned caplen;
+
+	if (unlikely(used >= PKTLOG_RING_SLOTS)) {
+		rh->dropped++;
+		return;
+	}
+
+	rec = (void *)rh + PAGE_SIZE +
+		(head % PKTLOG_RING_SLOTS) * PKTLOG_SLOT_SIZE;
+	caplen = min_t(unsigned, skb->len, pktlog_snaplen(pktlog));
+	caplen = min_t(unsigned, caplen, PKTLOG_REC_MAX_CAPLEN);
+
+	rec->tstamp_ns = ktime_get_real_ns();
+	rec->len = skb->len;
+	rec->caplen = caplen;
+	rec->dir = dir;
+	if (skb_copy_bits(skb, 0, rec->data, caplen))
+		rec->caplen = 0;
+
+	/* record content visible before the producer index */
+	smp_wmb();
+	WRITE_ONCE(rh->head, head + 1);
+
+	if (used + 1 == PKTLOG_RING_WAKE_SLOTS && waitqueue_active(&pktlog->wq))
+		wake_up(&pktlog->wq);
+}
+
 void pktlog_queue_skb(struct pktlog_data *pktlog, unsigned char dir,
 		struct sk_buff *skb)
 {
 	struct sk_buff *pkt;
+	struct pktlog_cpu *pc;
+	unsigned long flags;
 
-	if (!pktlog || !pktlog->qmax)
+	if (!pktlog || !(pktlog->qmax || READ_ONCE(pktlog->ring_active)))
+		return;
+
+	local_irq_save(flags);
+	pc = this_cpu_ptr(pktlog->pcpu);
+	if (pktlog->sample_rate > 1 && ++pc->sample_cnt < pktlog->sample_rate) {
+		pc->sampled_out++;
+		local_irq_restore(flags);
 		return;
+	}
+	pc->sample_cnt = 0;
+	pc->logged++;
+
+	if (READ_ONCE(pktlog->ring_active)) {
+		pktlog_ring_put(pktlog, dir, skb);
+		local_irq_restore(flags);
+		return;
+	}
+	local_irq_restore(flags);
 
 	pkt = skb_clone(skb, in_interrupt() ? GFP_ATOMIC : GFP_KERNEL);
 	if (!pkt) {
@@ -81,6 +153,63 @@ void pktlog_queue_skb(struct pktlog_data *pktlog, unsigned char dir,
 	wake_up(&pktlog->wq);
 }
 
+static bool pktlog_ring_ready(struct pktlog_data *pktlog)
+{
+	struct pktlog_ring_hdr *rh;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		rh = pktlog_ring_of(pktlog, cpu);
+		if (READ_ONCE(rh->head) - READ_ONCE(rh->tail) >=
+				PKTLOG_RING_WAKE_SLOTS)
+			return true;
+	}
+	return false;
+}
+
+static int pktlog_ring_start(struct pktlog_data *pktlog)
+{
+	struct pktlog_ring_hdr *rh;
+	int cpu;
+
+	if (pktlog->ring_active)
+		return 0;
+
+	if (!pktlog->ring) {
+		pktlog->ring = vmalloc_user(nr_cpu_ids * PKTLOG_RING_CPU_SZ);
+		if (!pktlog->ring) {
+			pr_err("%s: pktlog ring alloc fail\n", __func__);
+			return -ENOMEM;
+		}
+	}
+
+	for_each_possible_cpu(cpu) {
+		rh = pktlog_ring_of(pktlog, cpu);
+		rh->head = 0;
+		rh->tail = 0;
+		rh->nr_slots = PKTLOG_RING_SLOTS;
+		rh->slot_size = PKTLOG_SLOT_SIZE;
+		rh->data_offset = PAGE_SIZE;
+		rh->dropped = 0;
+		rh->cpu = cpu;
+		rh->nr_cpus = nr_cpu_ids;
+	}
+	smp_wmb();
+	WRITE_ONCE(pktlog->ring_active, true);
+
+	return 0;
+}
+
+static void pktlog_ring_stop(struct pktlog_data *pktlog)
+{
+	if (!pktlog->ring_active)
+		return;
+
+	WRITE_ONCE(pktlog->ring_active, false);
+	/* producers run with irqs off, wait for those still in the ring */
+	synchronize_sched();
+}
+
 static int pktlog_open(struct inode *inode, struct file *filp)
 {
 	struct pktlog_data *pktlog = filp->private_data;
@@ -108,6 +237,7 @@ static int pktlog_release(struct inode *inode, struct file *filp)
 {
 	struct pktlog_data *pktlog = filp->private_data;
 
+	pktlog_ring_stop(pktlog);
 	pr_info("%s: qmax = %d close by %s- %d\n", __func__, pktlog->qmax,
 			current->comm, atomic_dec_return(&pktlog->opened));
 	return 0;
@@ -122,6 +252,11 @@ static unsigned int pktlog_poll(struct file *filp, struct poll_table_struct *wai
 		return POLLERR;
 	}
 
+	if (pktlog->ring_active) {
+		poll_wait(filp, &pktlog->wq, wait);
+		return pktlog_ring_ready(pktlog) ? POLLIN | POLLRDNORM : 0;
+	}
+
 	if (skb_queue_empty(&pktlog->logq))
 		poll_wait(filp, &pktlog->wq, wait);
 
@@ -167,7 +302,7 @@ static ssize_t pktlog_read(struct file *filp, char *buf, size_t count,
 	hdr->pcap.tv_sec = tv.tv_sec;
 	hdr->pcap.tv_usec = tv.tv_usec;
 	hdr->pcap.len = cook_hdr_len + pkt->len;
-	hdr->pcap.caplen = min(hdr->pcap.len, pktlog->snaplen);
+	hdr->pcap.caplen = min(hdr->pcap.len, pktlog_snaplen(pktlog));
 
 	hdr->sd.dir = pktpriv(pkt)->dir;
 
@@ -180,7 +315,7 @@ static ssize_t pktlog_read(struct file *filp, char *buf, size_t count,
 	cplen += sizeof(struct pktdump_hdr);
 
 	p += sizeof(struct pktdump_hdr);
-	payload_len = min(pkt->len, pktlog->snaplen - cook_hdr_len);
+	payload_len = min(pkt->len, pktlog_snaplen(pktlog) - cook_hdr_len);
 	ret = copy_to_user(p, pkt->data, payload_len);
 	if (ret < 0) {
 		printk_ratelimited(KERN_ERR "%s: pcap data copy fail\n",
@@ -253,12 +388,108 @@ static ssize_t store_qmax(struct device *dev,
 static struct device_attribute attr_qmax =
 	__ATTR(qmax, S_IRUGO | S_IWUSR, show_qmax, store_qmax);
 
+static int pktlog_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct pktlog_data *pktlog = filp->private_data;
+	unsigned long size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (vma->vm_pgoff || size > nr_cpu_ids * PKTLOG_RING_CPU_SZ)
+		return -EINVAL;
+
+	ret = pktlog_ring_start(pktlog);
+	if (ret)
+		return ret;
+
+	return remap_vmalloc_range(vma, pktlog->ring, 0);
+}
+
+static ssize_t show_sample_rate(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct pktlog_data *pktlog = dev_get_drvdata(dev);
+
+	return sprintf(buf, "packet log sample rate : 1/%u\n",
+			pktlog->sample_rate ? pktlog->sample_rate : 1);
+}
+
+static ssize_t store_sample_rate(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct pktlog_data *pktlog = dev_get_drvdata(dev);
+	unsigned rate;
+	int ret;
+
+	ret = kstrtouint(buf, 10, &rate);
+	if (ret)
+		return count;
+
+	pktlog->sample_rate = rate;
+	return count;
+}
+
+static struct device_attribute attr_sample_rate =
+	__ATTR(sample_rate, S_IRUGO | S_IWUSR, show_sample_rate,
+		store_sample_rate);
+
+static ssize_t show_hdr_only(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct pktlog_data *pktlog = dev_get_drvdata(dev);
+
+	return sprintf(buf, "packet log header only : %d\n", pktlog->hdr_only);
+}
+
+static ssize_t store_hdr_only(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct pktlog_data *pktlog = dev_get_drvdata(dev);
+	bool hdr_only;
+	int ret;
+
+	ret = strtobool(buf, &hdr_only);
+	if (ret)
+		return count;
+
+	pktlog->hdr_only = hdr_only;
+	return count;
+}
+
+static struct device_attribute attr_hdr_only =
+	__ATTR(hdr_only, S_IRUGO | S_IWUSR, show_hdr_only, store_hdr_only);
+
+static ssize_t show_stats(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct pktlog_data *pktlog = dev_get_drvdata(dev);
+	struct pktlog_cpu *pc;
+	char *p = buf;
+	int cpu;
+
+	p += sprintf(p, "ring %s\n", pktlog->ring_active ? "on" : "off");
+	for_each_possible_cpu(cpu) {
+		pc = per_cpu_ptr(pktlog->pcpu, cpu);
+		p += sprintf(p, "cpu%d: logged %lu sampled_out %lu", cpu,
+				pc->logged, pc->sampled_out);
+		if (pktlog->ring)
+			p += sprintf(p, " ring_dropped %u",
+				pktlog_ring_of(pktlog, cpu)->dropped);
+		p += sprintf(p, "\n");
+	}
+
+	return p - buf;
+}
+
+static struct device_attribute attr_stats =
+	__ATTR(stats, S_IRUGO, show_stats, NULL);
+
 static const struct file_operations pktlog_fops = {
 	.owner = THIS_MODULE,
 	.open = pktlog_open,
 	.release = pktlog_release,
 	.poll = pktlog_poll,
 	.read = pktlog_read,
+	.mmap = pktlog_mmap,
 };
 
 static void init_pcap_fileheader(struct pktlog_data *pktlog)
@@ -295,8 +526,15 @@ struct pktlog_data *create_pktlog(char *name)
 	skb_queue_head_init(&pktlog->logq);
 	pktlog->qmax = 0;
 	pktlog->snaplen = 256;
+	pktlog->sample_rate = 1;
 	atomic_set(&pktlog->opened, 0);
 
+	pktlog->pcpu = alloc_percpu(struct pktlog_cpu);
+	if (!pktlog->pcpu) {
+		pr_err("%s: pktlog percpu alloc fail\n", __func__);
+		goto free_exit;
+	}
+
 	ret = misc_register(&pktlog->misc);
 	if (ret < 0) {
 		pr_err("%s: fail to register misc device '%s'\n", __func__,
@@ -317,12 +555,34 @@ struct pktlog_data *create_pktlog(char *name)
 				name);
 		goto free_exit;
 	}
+
+	ret = device_create_file(pktlog->misc.this_device, &attr_sample_rate);
+	if (ret) {
+		pr_err("%s: fail to create sample_rate sysfs file: %s\n",
+				__func__, name);
+		goto free_exit;
+	}
+
+	ret = device_create_file(pktlog->misc.this_device, &attr_hdr_only);
+	if (ret) {
+		pr_err("%s: fail to create hdr_only sysfs file: %s\n",
+				__func__, name);
+		goto free_exit;
+	}
+
+	ret = device_create_file(pktlog->misc.this_device, &attr_stats);
+	if (ret) {
+		pr_err("%s: fail to create stats sysfs file: %s\n", __func__,
+				name);
+		goto free_exit;
+	}
 	init_pcap_fileheader(pktlog);
 	pr_info("%s: probed - %s\n", __func__, name);
 
 	return pktlog;
 
 free_exit:
+	free_percpu(pktlog->pcpu);
 	kfree(pktlog);
 	return NULL;
 }
@@ -332,7 +592,12 @@ void remove_pktlog(struct pktlog_data *pktlog)
 	if (!pktlog)
 		return;
 
+	device_remove_file(pktlog->misc.this_device, &attr_stats);
+	device_remove_file(pktlog->misc.this_device, &attr_hdr_only);
+	device_remove_file(pktlog->misc.this_device, &attr_sample_rate);
 	device_remove_file(pktlog->misc.this_device, &attr_qmax);
 	misc_deregister(&pktlog->misc);
+	vfree(pktlog->ring);
+	free_percpu(pktlog->pcpu);
 	kfree(pktlog);
 }
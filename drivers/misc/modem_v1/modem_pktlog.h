@@ -52,6 +52,47 @@ struct pktdump_hdr {
 	struct sipc_debug sd;
 } __packed;
 
+/*
+ * mmap'ed capture: one single-producer ring per possible CPU, laid out
+ * back to back every PKTLOG_RING_CPU_SZ bytes. Each ring starts with a
+ * control page followed by fixed-size record slots. The kernel advances
+ * @head, the reader advances @tail; a full ring drops new records.
+ */
+#define PKTLOG_RING_SLOTS	1024
+#define PKTLOG_SLOT_SIZE	256
+#define PKTLOG_RING_CPU_SZ	(PAGE_SIZE + PKTLOG_RING_SLOTS * PKTLOG_SLOT_SIZE)
+
+/* capture length in header-only mode: sipc header + IPv6 + TCP w/ options */
+#define PKTLOG_HDR_ONLY_LEN	112
+
+struct pktlog_ring_hdr {
+	unsigned head;
+	unsigned tail;
+	unsigned nr_slots;
+	unsigned slot_size;
+	unsigned data_offset;
+	unsigned dropped;
+	unsigned cpu;
+	unsigned nr_cpus;
+} __packed;
+
+struct pktlog_rec {
+	unsigned long long tstamp_ns;
+	unsigned len;
+	unsigned short caplen;
+	unsigned char dir;
+	unsigned char reserved;
+	unsigned char data[];
+} __packed;
+
+#define PKTLOG_REC_MAX_CAPLEN	(PKTLOG_SLOT_SIZE - sizeof(struct pktlog_rec))
+
+struct pktlog_cpu {
+	unsigned sample_cnt;
+	unsigned long logged;
+	unsigned long sampled_out;
+};
+
 struct pktlog_data {
 	struct miscdevice misc;
 	atomic_t opened;
@@ -60,6 +101,15 @@ struct pktlog_data {
 	unsigned qmax;
 	unsigned snaplen;
 
+	/* log one packet every @sample_rate, 0 and 1 log them all */
+	unsigned sample_rate;
+	bool hdr_only;
+
+	/* vmalloc_user'ed at first mmap, kept until remove_pktlog() */
+	void *ring;
+	bool ring_active;
+	struct pktlog_cpu __percpu *pcpu;
+
 	struct sk_buff_head logq;
 
 	bool copy_file_header;
@@ -20,6 +20,7 @@
 #include <linux/platform_device.h>
 #include <linux/miscdevice.h>
 #include <linux/skbuff.h>
+#include <linux/skb_rx_pool.h>
 #include <linux/wait.h>
 #include <linux/completion.h>
 #include <linux/wakelock.h>
@@ -391,6 +392,17 @@ struct io_device {
 	struct wake_lock wakelock;
 	long waketime;
 
+#ifdef CONFIG_LINK_DEVICE_PDN_NAPI
+	/* RX NAPI of a PDN, run on @napi_cpu unless it is -1 */
+	struct napi_struct napi;
+	struct sk_buff_head napi_q;
+	struct call_single_data napi_csd;
+	int napi_cpu;
+	unsigned long napi_rx_packets;
+	unsigned long napi_rx_dropped;
+	unsigned int napi_cpu_polls[NR_CPUS];
+#endif
+
 	/* DO NOT use __current_link directly
 	 * you MUST use skbpriv(skb)->ld in mc, link, etc..
 	 */
@@ -526,12 +538,15 @@ struct link_device {
 
 #define pm_to_link_device(pm)	container_of(pm, struct link_device, pm)
 
+/* Recycling pool for RX skb heads copied out of shared memory */
+extern struct skb_rx_pool *mif_rx_pool;
+
 static inline struct sk_buff *rx_alloc_skb(unsigned int length,
 		struct io_device *iod, struct link_device *ld)
 {
 	struct sk_buff *skb;
 
-	skb = dev_alloc_skb(length);
+	skb = skb_rx_pool_alloc(mif_rx_pool, length, GFP_ATOMIC);
 	if (likely(skb)) {
 		skbpriv(skb)->iod = iod;
 		skbpriv(skb)->ld = ld;
@@ -11,6 +11,9 @@
 #include <asm/uaccess.h>
 #include <linux/slab.h>
 #include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <linux/mutex.h>
+#include <linux/ktime.h>
 
 #include <scsc/scsc_logring.h>
 #include <scsc/scsc_mx.h>
@@ -128,6 +131,40 @@ static bool force_flat = false; /* Refer to hcf from /vendor/etc/wifi/mx140/conf
 module_param(force_flat, bool, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(force_flat, "Forcely request flat conf");
 
+/* The f/w image is read and checked ahead of the first WLBT start */
+static unsigned int fw_stage_delay_ms = 8000;
+module_param(fw_stage_delay_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(fw_stage_delay_ms, "Delay after probe before the fw image is staged, 0 = disabled");
+
+static unsigned int fw_load_us;
+module_param(fw_load_us, uint, S_IRUGO);
+MODULE_PARM_DESC(fw_load_us, "Duration of the last fw download in us");
+
+static unsigned int fw_first_load_us;
+module_param(fw_first_load_us, uint, S_IRUGO);
+MODULE_PARM_DESC(fw_first_load_us, "Duration of the first fw download in us");
+
+static bool fw_first_load_staged;
+module_param(fw_first_load_staged, bool, S_IRUGO);
+MODULE_PARM_DESC(fw_first_load_staged, "First fw download was served from the staged image");
+
+/* Retries while /system and /vendor are not mounted yet */
+#define MX140_FW_STAGE_TRIES	8
+
+static struct {
+	struct mutex            lock;
+	struct delayed_work     work;
+	struct scsc_mx          *mx;
+	mx140_file_verify_fw_t  verify;
+	const struct firmware   *firm;
+	int                     suffix;
+	bool                    verified;
+	bool                    used;
+	int                     tries;
+} fw_stage = {
+	.lock = __MUTEX_INITIALIZER(fw_stage.lock),
+};
+
 /* Reads a configuration file into memory (f/w profile specific) */
 static int __mx140_file_request_conf(struct scsc_mx *mx,
 		const struct firmware **conf,
@@ -315,12 +352,134 @@ static int __mx140_file_download_fw(struct scsc_mx *mx, void *dest, size_t dest_
 	return r;
 }
 
-/* Download firmware binary into a buffer supplied by the caller */
-int mx140_file_download_fw(struct scsc_mx *mx, void *dest, size_t dest_size, u32 *fw_image_size)
+static void mx140_file_stage_work(struct work_struct *work)
+{
+	const struct firmware *firm = NULL;
+	char                  img_path_name[MX140_FW_PATH_MAX_LENGTH];
+	bool                  try_all = false;
+	int                   r = -ENOENT;
+	int                   i;
+
+	mutex_lock(&fw_stage.lock);
+	if (fw_stage.firm || fw_stage.used)
+		goto out;
+
+	r = mx140_basedir_file(fw_stage.mx);
+	if (r) {
+		if (r == -EAGAIN && ++fw_stage.tries < MX140_FW_STAGE_TRIES)
+			schedule_delayed_work(&fw_stage.work, msecs_to_jiffies(fw_stage_delay_ms));
+		goto out;
+	}
+
+	/* Same suffix selection as mx140_file_download_fw() */
+	if (!strcmp(firmware_hw_ver, "manual")) {
+		i = ARRAY_SIZE(fw_suffixes) - 1;
+	} else if (fw_suffix_found != -1) {
+		i = fw_suffix_found;
+	} else {
+		i = 0;
+		try_all = true;
+	}
+
+	for (; i < ARRAY_SIZE(fw_suffixes); i++) {
+		scnprintf(img_path_name, sizeof(img_path_name), "%s/%s%s.bin",
+			base_dir, firmware_variant, fw_suffixes[i].suffix);
+		r = mx140_request_file(fw_stage.mx, img_path_name, &firm);
+		if (r != -ENOENT || !try_all)
+			break;
+	}
+	if (r)
+		goto out;
+
+	/* The full image CRC is done here rather than at WLBT start */
+	if (fw_stage.verify) {
+		r = fw_stage.verify((char *)firm->data, firm->size);
+		if (r) {
+			SCSC_TAG_ERR(MX_FILE, "staged fw failed verification (%d)\n", r);
+			mx140_release_file(fw_stage.mx, firm);
+			goto out;
+		}
+	}
+
+	fw_stage.firm = firm;
+	fw_stage.suffix = i;
+	fw_stage.verified = !!fw_stage.verify;
+	SCSC_TAG_INFO(MX_FILE, "staged fw %s, size %zu\n", img_path_name, firm->size);
+out:
+	mutex_unlock(&fw_stage.lock);
+}
+
+/* Start reading the f/w image in the background, after boot has settled */
+void mx140_file_stage_fw(struct scsc_mx *mx, mx140_file_verify_fw_t verify)
+{
+	INIT_DELAYED_WORK(&fw_stage.work, mx140_file_stage_work);
+	fw_stage.mx = mx;
+	fw_stage.verify = verify;
+	fw_stage.tries = 0;
+
+	if (fw_stage_delay_ms)
+		schedule_delayed_work(&fw_stage.work, msecs_to_jiffies(fw_stage_delay_ms));
+}
+
+void mx140_file_unstage_fw(struct scsc_mx *mx)
+{
+	cancel_delayed_work_sync(&fw_stage.work);
+
+	mutex_lock(&fw_stage.lock);
+	if (fw_stage.firm)
+		mx140_release_file(mx, fw_stage.firm);
+	fw_stage.firm = NULL;
+	fw_stage.mx = NULL;
+	mutex_unlock(&fw_stage.lock);
+}
+
+/* Copy the staged image if it is the one that would be downloaded.
+ * The stage is used once: later starts read the file again.
+ */
+static int mx140_file_take_staged_fw(struct scsc_mx *mx, void *dest, size_t dest_size, u32 *fw_image_size, bool *verified)
+{
+	int r = -ENOENT;
+
+	/* Don't wait for a stage that has not started yet */
+	cancel_delayed_work(&fw_stage.work);
+
+	mutex_lock(&fw_stage.lock);
+	fw_stage.used = true;
+	if (!fw_stage.firm)
+		goto out;
+
+	if (fw_suffix_found == -1 || fw_suffix_found == fw_stage.suffix) {
+		if (fw_stage.firm->size > dest_size) {
+			SCSC_TAG_ERR(MX_FILE, "firmware image too big for buffer (%zu > %zu)", fw_stage.firm->size, dest_size);
+			r = -EINVAL;
+		} else {
+			memcpy(dest, fw_stage.firm->data, fw_stage.firm->size);
+			*fw_image_size = fw_stage.firm->size;
+			*verified = fw_stage.verified;
+			fw_suffix_found = fw_stage.suffix;
+			r = 0;
+		}
+	}
+
+	mx140_release_file(mx, fw_stage.firm);
+	fw_stage.firm = NULL;
+out:
+	mutex_unlock(&fw_stage.lock);
+	return r;
+}
+
+/* Download firmware binary into a buffer supplied by the caller.
+ * verified is set if the image CRCs were already checked while staging.
+ */
+int mx140_file_download_fw(struct scsc_mx *mx, void *dest, size_t dest_size, u32 *fw_image_size, bool *verified)
 {
 	int r;
 	int i;
 	int manual;
+	u64 start = ktime_get_ns();
+	bool staged = false;
+
+	*verified = false;
 
 	/* Override to use the verbatim image only */
 	manual = !strcmp(firmware_hw_ver, "manual");
@@ -331,6 +490,12 @@ int mx140_file_download_fw(struct scsc_mx *mx, void *dest, size_t dest_size, u32
 
 	SCSC_TAG_DEBUG(MX_FILE, "fw_suffix_found %d\n", fw_suffix_found);
 
+	r = mx140_file_take_staged_fw(mx, dest, dest_size, fw_image_size, verified);
+	if (r != -ENOENT) {
+		staged = true;
+		goto done;
+	}
+
 	/* If we know which f/w suffix to use, select it immediately */
 	if (fw_suffix_found != -1) {
 		r = __mx140_file_download_fw(mx, dest, dest_size, fw_image_size, fw_suffixes[fw_suffix_found].suffix);
@@ -350,6 +515,13 @@ int mx140_file_download_fw(struct scsc_mx *mx, void *dest, size_t dest_size, u32
 	if (r == 0)
 		fw_suffix_found = i;
 done:
+	fw_load_us = div_u64(ktime_get_ns() - start, NSEC_PER_USEC);
+	if (!r && !fw_first_load_us) {
+		fw_first_load_us = fw_load_us;
+		fw_first_load_staged = staged;
+	}
+	SCSC_TAG_INFO(MX_FILE, "fw download took %u us%s\n", fw_load_us, staged ? " (staged)" : "");
+
 	/* Update firmware_hw_ver to reflect what got auto selected, for moredump */
 	if (fw_suffix_found != -1 && !manual) {
 		/* User will only read this, so casting away const is safe */
@@ -860,15 +860,33 @@ static int fwhdr_init(char *fw, struct fwhdr *fwhdr, bool *fwhdr_parsed_ok, bool
 	return 0;
 }
 
+/* Checks a f/w image staged by mx140_file ahead of its first start */
+static int fw_stage_verify(char *fw, u32 fw_image_size)
+{
+	struct fwhdr fwhdr;
+	bool         fwhdr_parsed_ok;
+	bool         check_crc;
+	int          r;
+
+	r = fwhdr_init(fw, &fwhdr, &fwhdr_parsed_ok, &check_crc);
+	if (r)
+		return r;
+	if (!check_crc)
+		return 0;
+
+	return do_fw_crc32_checks(fw, fw_image_size, &fwhdr, true);
+}
+
 static int fw_init(struct mxman *mxman, void *start_dram, size_t size_dram, bool *fwhdr_parsed_ok)
 {
 	int                 r;
 	char                *build_id;
 	u32                 fw_image_size;
+	bool                fw_verified;
 	struct fwhdr        *fwhdr = &mxman->fwhdr;
 	char                *fw = start_dram;
 
-	r = mx140_file_download_fw(mxman->mx, start_dram, size_dram, &fw_image_size);
+	r = mx140_file_download_fw(mxman->mx, start_dram, size_dram, &fw_image_size, &fw_verified);
 	if (r) {
 		SCSC_TAG_ERR(MXMAN, "mx140_file_download_fw() failed (%d)\n", r);
 		return r;
@@ -882,11 +900,13 @@ static int fw_init(struct mxman *mxman, void *start_dram, size_t size_dram, bool
 	mxman->fw = fw;
 	mxman->fw_image_size = fw_image_size;
 	if (mxman->check_crc) {
-		/* do CRC on the entire image */
-		r = do_fw_crc32_checks(fw, fw_image_size, &mxman->fwhdr, true);
-		if (r) {
-			SCSC_TAG_ERR(MXMAN, "do_fw_crc32_checks() failed\n");
-			return r;
+		/* do CRC on the entire image, unless it was checked when staged */
+		if (!fw_verified) {
+			r = do_fw_crc32_checks(fw, fw_image_size, &mxman->fwhdr, true);
+			if (r) {
+				SCSC_TAG_ERR(MXMAN, "do_fw_crc32_checks() failed\n");
+				return r;
+			}
 		}
 		fw_crc_wq_start(mxman);
 	}
@@ -1864,6 +1884,7 @@ void mxman_init(struct mxman *mxman, struct scsc_mx *mx)
 	       sizeof(saved_fw_build_id));
 	mxproc_create_info_proc_dir(&mxman->mxproc, mxman);
 	active_mxman = mxman;
+	mx140_file_stage_fw(mx, fw_stage_verify);
 
 #if defined(SCSC_SEP_VERSION) && SCSC_SEP_VERSION >= 9
 	mxman_create_sysfs_memdump();
@@ -1875,6 +1896,7 @@ void mxman_deinit(struct mxman *mxman)
 #if defined(SCSC_SEP_VERSION) && SCSC_SEP_VERSION >= 9
 	mxman_destroy_sysfs_memdump();
 #endif
+	mx140_file_unstage_fw(mxman->mx);
 	active_mxman = NULL;
 	mxproc_remove_info_proc_dir(&mxman->mxproc);
 	fw_crc_wq_deinit(mxman);
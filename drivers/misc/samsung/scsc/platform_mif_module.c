@@ -159,6 +159,7 @@ static struct platform_driver    platform_mif_driver = {
 	.driver = {
 		.name = DRV_NAME,
 		.owner = THIS_MODULE,
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
 		.pm = &platform_mif_pm_ops,
 		.of_match_table = of_match_ptr(scsc_wifibt),
 	},
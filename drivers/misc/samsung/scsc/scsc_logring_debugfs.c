@@ -230,6 +230,7 @@ static ssize_t samsg_read(struct file *filp, char __user *ubuf,
 	/* open() assures us that this private data is certainly non-NULL */
 	i = filp->private_data;
 	if (!i->t_used) {
+		scsc_pcpu_drain(-1);
 		raw_spin_lock_irqsave(&i->rb->lock, flags);
 		current_head = *f_pos ? i->f_pos : i->rb->head;
 		while (current_head == i->rb->head) {
@@ -362,6 +363,8 @@ static int debugfile_open_snapshot(struct inode *ino, struct file *filp)
 		size_t			snap_sz;
 		struct scsc_ibox	*i = filp->private_data;
 
+		/* the snapshot must hold the deferred records too */
+		scsc_pcpu_drain(-1);
 		/* This is read-only...no spinlocking needed */
 		snap_sz = i->rb->bsz + i->rb->ssz;
 		/* Allocate here to minimize lock time... */
@@ -517,6 +520,8 @@ static ssize_t statfile_read(struct file *filp, char __user *ubuf,
 			"sz:%zd  used:%lld  free:%lld  logged:%lld  records:%d\nhead:%lld  tail:%lld  last:%lld  written:%lld  wraps:%d  oos:%d\n",
 			bsz, used, max_chunk, logged, records,
 			head, tail, last, written, wraps, oos);
+	if (slen >= 0 && slen < STATSTR_SZ)
+		slen += scsc_pcpu_stats(statstr + slen, STATSTR_SZ - slen);
 	if (slen >= 0 && *f_pos < slen) {
 		count = (count <= slen - *f_pos) ? count : (slen - *f_pos);
 		if (copy_to_user(ubuf, statstr + *f_pos, count))
@@ -18,7 +18,7 @@
 #include <scsc/scsc_logring.h>
 #include "scsc_logring_ring.h"
 
-#define STATSTR_SZ				256
+#define STATSTR_SZ				512
 #define SCSC_DEBUGFS_ROOT			"scsc"
 #define SCSC_SAMSG_FNAME			"samsg"
 #define SCSC_SAMLOG_FNAME			"samlog"
@@ -25,6 +25,10 @@ static int              scsc_droplevel_all = DEFAULT_ALL_DISABLED;
 static int              scsc_droplevel_atomic = DEFAULT_DROPLEVEL;
 static int              scsc_redirect_to_printk_droplvl = DEFAULT_REDIRECT_DROPLVL;
 static int              scsc_reset_all_droplevels_to;
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+static int              deferred_format = 1;
+static int              pcpu_ringsize = SCSC_PCPU_RING_SZ;
+#endif
 
 struct scsc_ring_buffer *the_ringbuf;
 
@@ -75,6 +79,16 @@ int __init samlog_init(void)
 #else
 	pr_info("scsc_logring:: Allocated STATIC ring buffer of size %zd bytes.\n",
 		rb->bsz);
+#endif
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+	if (!is_power_of_2(pcpu_ringsize) ||
+	    pcpu_ringsize < 2 * SCSC_PCPU_REC_MAX) {
+		pcpu_ringsize = SCSC_PCPU_RING_SZ;
+		pr_info("Samlog: scsc_logring.pcpu_ringsize MUST be power-of-two. Using default: %d\n",
+			pcpu_ringsize);
+	}
+	if (scsc_pcpu_rings_init(rb, pcpu_ringsize))
+		pr_info("Samlog: Cannot allocate per-CPU rings...formatting at once.\n");
 #endif
 	the_ringbuf = rb;
 	initialized = true;
@@ -105,6 +119,9 @@ void __exit samlog_exit(void)
 	if (the_ringbuf && the_ringbuf->private)
 		samlog_debugfs_exit(&the_ringbuf->private);
 	initialized = false;
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+	scsc_pcpu_rings_exit();
+#endif
 	free_ring_buffer(the_ringbuf);
 	the_ringbuf = NULL;
 #ifdef CONFIG_SCSC_LOG_COLLECTION
@@ -156,6 +173,18 @@ SCSC_MODPARAM_DESC(scsc_droplevel_atomic,
 		   "This droplevel is applied to logmsg emitted in atomic context.",
 		   "run-time", DEFAULT_KEEP_ALL);
 
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+module_param(deferred_format, int, S_IRUGO | S_IWUSR);
+SCSC_MODPARAM_DESC(deferred_format,
+		   "Store string records in per-CPU rings and format them on read.",
+		   "run-time", 1);
+
+module_param(pcpu_ringsize, int, S_IRUGO);
+SCSC_MODPARAM_DESC(pcpu_ringsize,
+		   "Per-CPU deferred ring size, power-of-two.",
+		   "load-time", SCSC_PCPU_RING_SZ);
+#endif
+
 /**
  * This macro code has been freely 'inspired' (read copied) from the
  * slsi_ original/old debug.c implementaion: it takes care to register
@@ -331,6 +360,7 @@ static int logring_collect(struct scsc_log_collector_client *collect_client, siz
 	scsc_droplevel_all = DEFAULT_DROP_ALL;
 
 	/* Write buffer */
+	scsc_pcpu_drain(-1);
 	ret = scsc_log_collector_write(the_ringbuf->buf, the_ringbuf->bsz, 1);
 
 	scsc_droplevel_all = saved_droplevel;
@@ -408,14 +438,33 @@ static inline int _scsc_printk(int level, int tag,
 {
 	int  written = 0;
 	char *msg_head = NULL;
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+	u64  start;
+#endif
 
 	if (!initialized || !enable || !fmt ||
 	    ((scsc_droplevel_all < 0 && level >= *scsc_droplevels[tag]) ||
 	     (scsc_droplevel_all >= 0 && level >= scsc_droplevel_all)))
 		return written;
 	drop_message_level_macro(fmt, &msg_head);
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+	if (deferred_format) {
+		va_list aq;
+
+		va_copy(aq, args);
+		written = scsc_pcpu_push_string(tag, level, prepend_header,
+						msg_head, aq);
+		va_end(aq);
+		if (written >= 0)
+			return written;
+	}
+	start = local_clock();
+#endif
 	written = push_record_string(the_ringbuf, tag, level,
 				     prepend_header, msg_head, args);
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+	scsc_pcpu_account_eager(local_clock() - start);
+#endif
 	return written;
 }
 
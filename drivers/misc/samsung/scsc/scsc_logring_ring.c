@@ -4,6 +4,9 @@
  *
  ****************************************************************************/
 
+#include <asm/sections.h>
+#include <linux/math64.h>
+
 #include "scsc_logring_ring.h"
 
 #ifdef CONFIG_SCSC_STATIC_RING_SIZE
@@ -349,22 +352,11 @@ int tag_writer_string(char *spare, int tag, int lev,
  * After the record has been created and pushed into the ring any process
  * waiting on the related waiting queue is awakened.
  */
-int push_record_string(struct scsc_ring_buffer *rb, int tag, int lev,
-		       int prepend_header, const char *msg_head, va_list args)
+static inline
+void scsc_ring_buffer_append_spare(struct scsc_ring_buffer *rb, int rec_len)
 {
-	int           rec_len = 0;
-	loff_t        free_bytes;
-	unsigned long flags;
+	loff_t free_bytes;
 
-	/* Prepare ring_record and header if needed */
-	raw_spin_lock_irqsave(&rb->lock, flags);
-	rec_len = tag_writer_string(rb->spare, tag, lev, prepend_header,
-				    msg_head, args);
-	/* Line too long anyway drop */
-	if (rec_len >= BASE_SPARE_SZ - SCSC_RINGREC_SZ) {
-		raw_spin_unlock_irqrestore(&rb->lock, flags);
-		return 0;
-	}
 	free_bytes = SCSC_RING_FREE_BYTES(rb);
 	/**
 	 * Evaluate if it's a trivial append or if we must account for
@@ -381,12 +373,310 @@ int push_record_string(struct scsc_ring_buffer *rb, int tag, int lev,
 						SCSC_RINGREC_SZ + rec_len,
 						NULL, 0);
 	rb->written += rec_len;
+}
+
+int push_record_string(struct scsc_ring_buffer *rb, int tag, int lev,
+		       int prepend_header, const char *msg_head, va_list args)
+{
+	int           rec_len = 0;
+	unsigned long flags;
+
+	/* Prepare ring_record and header if needed */
+	raw_spin_lock_irqsave(&rb->lock, flags);
+	rec_len = tag_writer_string(rb->spare, tag, lev, prepend_header,
+				    msg_head, args);
+	/* Line too long anyway drop */
+	if (rec_len >= BASE_SPARE_SZ - SCSC_RINGREC_SZ) {
+		raw_spin_unlock_irqrestore(&rb->lock, flags);
+		return 0;
+	}
+	scsc_ring_buffer_append_spare(rb, rec_len);
 	raw_spin_unlock_irqrestore(&rb->lock, flags);
 	/* WAKEUP EVERYONE WAITING ON THIS BUFFER */
 	wake_up_interruptible(&rb->wq);
 	return rec_len;
 }
 
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+static struct scsc_pcpu_ring __percpu *scsc_pcpu_rings;
+static struct scsc_ring_buffer *scsc_pcpu_target;
+static DEFINE_RAW_SPINLOCK(scsc_pcpu_drain_lock);
+static struct irq_work scsc_pcpu_drain_work;
+
+/**
+ * The format is dereferenced only when draining, so it must live in the
+ * core kernel rodata, and %p arguments are NOT safe either since most of
+ * the pointer extensions would dereference them at read time.
+ * Anything else is formatted at once as usual.
+ */
+static inline bool scsc_pcpu_fmt_deferrable(const char *fmt)
+{
+	return fmt >= __start_rodata && fmt < __end_rodata &&
+	       !strstr(fmt, "%p");
+}
+
+/**
+ * Push a deferred string record into the ring of the current CPU.
+ * Returns a negative value when the record can NOT be deferred and
+ * must be formatted at once: @args is consumed anyway.
+ */
+int scsc_pcpu_push_string(int tag, int lev, int prepend_header,
+			  const char *fmt, va_list args)
+{
+	struct scsc_pcpu_ring   *pr;
+	struct scsc_pcpu_record *rec;
+	unsigned long           flags;
+	u32                     off, to_end, used, len;
+	int                     words;
+	u64                     start;
+
+	if (!scsc_pcpu_rings)
+		return -ENODEV;
+	local_irq_save(flags);
+	pr = this_cpu_ptr(scsc_pcpu_rings);
+	if (!scsc_pcpu_fmt_deferrable(fmt)) {
+		pr->fallback++;
+		local_irq_restore(flags);
+		return -EINVAL;
+	}
+	start = local_clock();
+	used = pr->head - READ_ONCE(pr->tail);
+	off = pr->head & (pr->bsz - 1);
+	to_end = pr->bsz - off;
+	/* records never wrap: skip the ring end, padding it if possible */
+	if (to_end < SCSC_PCPU_REC_MAX) {
+		if (used + to_end + SCSC_PCPU_REC_MAX > pr->bsz)
+			goto drop;
+		if (to_end >= SCSC_PCPU_RECHDR_SZ) {
+			rec = (struct scsc_pcpu_record *)(pr->buf + off);
+			rec->fmt = NULL;
+			rec->len = to_end;
+		}
+		smp_wmb();
+		WRITE_ONCE(pr->head, pr->head + to_end);
+		used += to_end;
+		off = 0;
+	}
+	if (used + SCSC_PCPU_REC_MAX > pr->bsz)
+		goto drop;
+	rec = (struct scsc_pcpu_record *)(pr->buf + off);
+	words = vbin_printf(rec->args, SCSC_PCPU_MAX_ARGS, fmt, args);
+	if (words > SCSC_PCPU_MAX_ARGS) {
+		pr->fallback++;
+		local_irq_restore(flags);
+		return -E2BIG;
+	}
+	len = ALIGN(SCSC_PCPU_RECHDR_SZ + words * sizeof(u32), 8);
+	rec->nsec = start;
+	rec->fmt = fmt;
+	rec->len = len;
+	rec->tag = tag;
+	rec->lev = lev;
+	rec->ctx = in_interrupt() ? (in_softirq() ? 'S' : 'I') : 'P';
+	rec->prepend_header = prepend_header;
+	/* publish the record only once it is complete */
+	smp_wmb();
+	WRITE_ONCE(pr->head, pr->head + len);
+	pr->records++;
+	pr->cost_ns += local_clock() - start;
+	used += len;
+	local_irq_restore(flags);
+	/* let waiting readers or a half full ring get the records soon */
+	if (used > pr->bsz / 2 || waitqueue_active(&scsc_pcpu_target->wq))
+		irq_work_queue(&scsc_pcpu_drain_work);
+	return len;
+
+drop:
+	pr->dropped++;
+	local_irq_restore(flags);
+	irq_work_queue(&scsc_pcpu_drain_work);
+	return 0;
+}
+
+void scsc_pcpu_account_eager(u64 ns)
+{
+	struct scsc_pcpu_ring *pr;
+	unsigned long         flags;
+
+	if (!scsc_pcpu_rings)
+		return;
+	local_irq_save(flags);
+	pr = this_cpu_ptr(scsc_pcpu_rings);
+	pr->eager_records++;
+	pr->eager_cost_ns += ns;
+	local_irq_restore(flags);
+}
+
+/* Oldest record still to drain on this ring, skipping the padding. */
+static struct scsc_pcpu_record *scsc_pcpu_peek(struct scsc_pcpu_ring *pr)
+{
+	struct scsc_pcpu_record *rec;
+	u32                     head = READ_ONCE(pr->head);
+	u32                     off, to_end;
+
+	while (pr->tail != head) {
+		/* read the record after having seen head */
+		smp_rmb();
+		off = pr->tail & (pr->bsz - 1);
+		to_end = pr->bsz - off;
+		rec = (struct scsc_pcpu_record *)(pr->buf + off);
+		if (to_end < SCSC_PCPU_RECHDR_SZ || !rec->fmt) {
+			smp_mb();
+			WRITE_ONCE(pr->tail, pr->tail + to_end);
+			continue;
+		}
+		return rec;
+	}
+	return NULL;
+}
+
+/* Expand a deferred record into the main ring, keeping its timestamp. */
+static void scsc_pcpu_format_record(struct scsc_ring_buffer *rb,
+				    const struct scsc_pcpu_record *prec,
+				    int core)
+{
+	struct scsc_ring_record *rrec;
+	char                    bheader[SCSC_HBUF_LEN] = {};
+	int                     written, room;
+	unsigned long           flags;
+
+	raw_spin_lock_irqsave(&rb->lock, flags);
+	rrec = (struct scsc_ring_record *)rb->spare;
+	SCSC_FILL_RING_RECORD(rrec, prec->tag, prec->lev);
+	rrec->nsec = prec->nsec;
+	rrec->ctx = prec->ctx;
+	rrec->core = core;
+	if (prec->prepend_header)
+		build_header(bheader, SCSC_HBUF_LEN, rrec, NULL);
+	written = scnprintf(SCSC_GET_REC_BUF(rb->spare),
+			    BASE_SPARE_SZ - SCSC_RINGREC_SZ, "%s", bheader);
+	room = BASE_SPARE_SZ - SCSC_RINGREC_SZ - written;
+	/* bstr_printf returns the untruncated length: clamp as vscnprintf */
+	written += min(bstr_printf(SCSC_GET_REC_BUF(rb->spare) + written,
+				   room, prec->fmt, prec->args), room - 1);
+	rrec->len = written;
+	scsc_ring_buffer_append_spare(rb, written);
+	raw_spin_unlock_irqrestore(&rb->lock, flags);
+}
+
+/**
+ * Move up to @budget records (all of them if negative) from the per-CPU
+ * rings into the main ring, always picking the oldest one across CPUs.
+ * Returns true if records are left behind.
+ */
+bool scsc_pcpu_drain(int budget)
+{
+	struct scsc_pcpu_record *rec, *best;
+	struct scsc_pcpu_ring   *pr, *best_pr;
+	unsigned long           flags;
+	int                     cpu, best_cpu, drained = 0;
+
+	if (!scsc_pcpu_rings)
+		return false;
+	if (!raw_spin_trylock_irqsave(&scsc_pcpu_drain_lock, flags))
+		return false;
+	while (budget < 0 || drained < budget) {
+		best = NULL;
+		best_pr = NULL;
+		best_cpu = 0;
+		for_each_possible_cpu(cpu) {
+			pr = per_cpu_ptr(scsc_pcpu_rings, cpu);
+			rec = scsc_pcpu_peek(pr);
+			if (rec && (!best || rec->nsec < best->nsec)) {
+				best = rec;
+				best_pr = pr;
+				best_cpu = cpu;
+			}
+		}
+		if (!best)
+			break;
+		scsc_pcpu_format_record(scsc_pcpu_target, best, best_cpu);
+		smp_mb();
+		WRITE_ONCE(best_pr->tail, best_pr->tail + best->len);
+		drained++;
+	}
+	raw_spin_unlock_irqrestore(&scsc_pcpu_drain_lock, flags);
+	if (drained)
+		wake_up_interruptible(&scsc_pcpu_target->wq);
+	return budget >= 0 && drained == budget;
+}
+
+static void scsc_pcpu_drain_work_func(struct irq_work *work)
+{
+	/* keep hard irq time bounded: go on in another round if needed */
+	if (scsc_pcpu_drain(SCSC_PCPU_DRAIN_BUDGET))
+		irq_work_queue(work);
+}
+
+int scsc_pcpu_stats(char *buf, size_t sz)
+{
+	struct scsc_pcpu_ring *pr;
+	u64                   records = 0, dropped = 0, fallback = 0, cost = 0;
+	u64                   eager = 0, eager_cost = 0;
+	int                   cpu;
+
+	if (!scsc_pcpu_rings)
+		return 0;
+	for_each_possible_cpu(cpu) {
+		pr = per_cpu_ptr(scsc_pcpu_rings, cpu);
+		records += pr->records;
+		dropped += pr->dropped;
+		fallback += pr->fallback;
+		cost += pr->cost_ns;
+		eager += pr->eager_records;
+		eager_cost += pr->eager_cost_ns;
+	}
+	return scnprintf(buf, sz,
+			 "deferred:%llu  avg_ns:%llu  dropped:%llu  fallback:%llu\nformatted:%llu  avg_ns:%llu\n",
+			 records, records ? div64_u64(cost, records) : 0,
+			 dropped, fallback,
+			 eager, eager ? div64_u64(eager_cost, eager) : 0);
+}
+
+int __init scsc_pcpu_rings_init(struct scsc_ring_buffer *rb, size_t bsz)
+{
+	struct scsc_pcpu_ring *pr;
+	int                   cpu;
+
+	scsc_pcpu_rings = alloc_percpu(struct scsc_pcpu_ring);
+	if (!scsc_pcpu_rings)
+		return -ENOMEM;
+	for_each_possible_cpu(cpu) {
+		pr = per_cpu_ptr(scsc_pcpu_rings, cpu);
+		pr->buf = kzalloc_node(bsz, GFP_KERNEL, cpu_to_node(cpu));
+		if (!pr->buf)
+			goto fail;
+		pr->bsz = bsz;
+	}
+	scsc_pcpu_target = rb;
+	init_irq_work(&scsc_pcpu_drain_work, scsc_pcpu_drain_work_func);
+	return 0;
+
+fail:
+	for_each_possible_cpu(cpu)
+		kfree(per_cpu_ptr(scsc_pcpu_rings, cpu)->buf);
+	free_percpu(scsc_pcpu_rings);
+	scsc_pcpu_rings = NULL;
+	return -ENOMEM;
+}
+
+void scsc_pcpu_rings_exit(void)
+{
+	struct scsc_pcpu_ring __percpu *rings = scsc_pcpu_rings;
+	int                            cpu;
+
+	if (!rings)
+		return;
+	scsc_pcpu_rings = NULL;
+	/* writers run with interrupts off */
+	synchronize_sched();
+	irq_work_sync(&scsc_pcpu_drain_work);
+	for_each_possible_cpu(cpu)
+		kfree(per_cpu_ptr(rings, cpu)->buf);
+	free_percpu(rings);
+}
+#endif
+
 /* This simply builds up a record descriptor for a binary entry. */
 static inline
 int tag_writer_binary(char *spare, int tag, int lev, size_t hexlen)
@@ -19,6 +19,8 @@
 #include <linux/jiffies.h>
 #include <linux/time.h>
 #include <linux/crc32.h>
+#include <linux/percpu.h>
+#include <linux/irq_work.h>
 
 #include <scsc/scsc_logring.h>
 
@@ -227,6 +229,73 @@ struct scsc_ring_record {
 	(rpos + SCSC_RINGREC_SZ + \
 	 SCSC_GET_REC_LEN(SCSC_GET_PTR((ring), (rpos))))
 
+#ifdef CONFIG_SCSC_LOGRING_DEFERRED
+/**
+ * String records can be kept out of the main ring until it is read: the
+ * writer only stores the format pointer and the arguments packed by
+ * vbin_printf() in a ring of its own CPU, and bstr_printf() expands them
+ * when the per-CPU rings are drained into the main ring, oldest record
+ * first across all CPUs.
+ * Each per-CPU ring has exactly one writer, its CPU with interrupts off,
+ * and one reader, whoever holds the drain lock: head is only moved by the
+ * writer and tail only by the reader, so writers never share a lock.
+ * A full per-CPU ring drops the new record instead of overwriting.
+ *
+ * @fmt: the format string, NULL for a record padding up to the ring end
+ * @len: the whole record length, header included, multiple of 8
+ * @args: vbin_printf() packed arguments
+ */
+struct scsc_pcpu_record {
+	s64         nsec;
+	const char  *fmt;
+	u16         len;
+	u8          tag;
+	u8          lev;
+	u8          ctx;
+	u8          prepend_header;
+	u32         args[0];
+};
+
+#define SCSC_PCPU_RING_SZ	16384
+#define SCSC_PCPU_MAX_ARGS	128
+#define SCSC_PCPU_RECHDR_SZ	(sizeof(struct scsc_pcpu_record))
+#define SCSC_PCPU_REC_MAX \
+	ALIGN(SCSC_PCPU_RECHDR_SZ + SCSC_PCPU_MAX_ARGS * sizeof(u32), 8)
+#define SCSC_PCPU_DRAIN_BUDGET	64
+
+/**
+ * @head: free running write position, updated by the owning CPU only
+ * @tail: free running read position, updated by the drainer only
+ * @records, @dropped, @fallback: deferred, dropped on a full ring, and
+ * not deferrable records (formatted at once into the main ring)
+ * @cost_ns, @eager_records, @eager_cost_ns: time spent by writers on
+ * deferred and on directly formatted string records
+ */
+struct scsc_pcpu_ring {
+	char              *buf;
+	u32               bsz;
+	u32               head;
+	u32               tail;
+	u64               records;
+	u64               dropped;
+	u64               fallback;
+	u64               cost_ns;
+	u64               eager_records;
+	u64               eager_cost_ns;
+};
+
+int scsc_pcpu_rings_init(struct scsc_ring_buffer *rb, size_t bsz) __init;
+void scsc_pcpu_rings_exit(void);
+int scsc_pcpu_push_string(int tag, int lev, int prepend_header,
+			  const char *fmt, va_list args);
+void scsc_pcpu_account_eager(u64 ns);
+bool scsc_pcpu_drain(int budget);
+int scsc_pcpu_stats(char *buf, size_t sz);
+#else
+static inline bool scsc_pcpu_drain(int budget) { return false; }
+static inline int scsc_pcpu_stats(char *buf, size_t sz) { return 0; }
+#endif
+
 /* Ring buffer API */
 struct scsc_ring_buffer *alloc_ring_buffer(size_t bsz, size_t ssz,
 					   const char *name) __init;
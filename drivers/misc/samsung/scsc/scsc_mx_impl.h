@@ -39,7 +39,12 @@ struct mxlog_transport  *scsc_mx_get_mxlog_transport(struct scsc_mx *mx);
 struct mxlogger         *scsc_mx_get_mxlogger(struct scsc_mx *mx);
 struct panicmon         *scsc_mx_get_panicmon(struct scsc_mx *mx);
 struct suspendmon	*scsc_mx_get_suspendmon(struct scsc_mx *mx);
-int mx140_file_download_fw(struct scsc_mx *mx, void *dest, size_t dest_size, u32 *fw_image_size);
+/* Checks a staged f/w image, returns 0 if it can be started without further checks */
+typedef int (*mx140_file_verify_fw_t)(char *fw, u32 fw_image_size);
+
+int mx140_file_download_fw(struct scsc_mx *mx, void *dest, size_t dest_size, u32 *fw_image_size, bool *verified);
+void mx140_file_stage_fw(struct scsc_mx *mx, mx140_file_verify_fw_t verify);
+void mx140_file_unstage_fw(struct scsc_mx *mx);
 int mx140_request_file(struct scsc_mx *mx, char *path, const struct firmware **firmp);
 int mx140_release_file(struct scsc_mx *mx, const struct firmware *firmp);
 int mx140_basedir_file(struct scsc_mx *mx);
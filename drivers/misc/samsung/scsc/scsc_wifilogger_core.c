@@ -12,6 +12,8 @@
 #include <linux/time.h>
 #include <linux/workqueue.h>
 #include <linux/spinlock.h>
+#include <linux/mm.h>
+#include <linux/gfp.h>
 #include <scsc/scsc_logring.h>
 #include <linux/uaccess.h>
 
@@ -26,6 +28,7 @@ static void wlog_drain_worker(struct work_struct *work)
 
 	r = container_of(work, struct scsc_wlog_ring, drain_work);
 
+	r->drain_wakeups++;
 	if (r && r->ops.drain_ring)
 		r->ops.drain_ring(r, r->flushing ? r->st.rb_byte_size : DEFAULT_DRAIN_CHUNK_SZ(r));
 }
@@ -47,17 +50,19 @@ static void drain_timer_callback(unsigned long data)
 
 static int wlog_ring_init(struct scsc_wlog_ring *r)
 {
-	/* Allocate buffer and spare area */
-	r->buf = kzalloc(r->st.rb_byte_size + MAX_RECORD_SZ, GFP_KERNEL);
+	/* Allocate buffer and spare area, page backed to be mmap'able */
+	r->buf = alloc_pages_exact(WLOG_BUF_ALLOC_SZ(r),
+				   GFP_KERNEL | __GFP_ZERO);
 	if (!r->buf)
 		return -ENOMEM;
 	r->drain_sz = DRAIN_BUF_SZ;
 	r->drain_buf = kzalloc(r->drain_sz, GFP_KERNEL);
 	if (!r->drain_buf) {
-		kfree(r->buf);
+		free_pages_exact(r->buf, WLOG_BUF_ALLOC_SZ(r));
 		return -ENOMEM;
 	}
 	mutex_init(&r->drain_lock);
+	init_waitqueue_head(&r->mmap_wq);
 
 	r->drain_workq = create_workqueue("wifilogger");
 	INIT_WORK(&r->drain_work, wlog_drain_worker);
@@ -83,8 +88,10 @@ static void wlog_ring_finalize(struct scsc_wlog_ring *r)
 
 	r->initialized = false;
 	kfree(r->drain_buf);
-	kfree(r->buf);
+	free_pages_exact(r->buf, WLOG_BUF_ALLOC_SZ(r));
 	r->buf = NULL;
+	free_page((unsigned long)r->mctrl);
+	r->mctrl = NULL;
 }
 
 static wifi_error wlog_get_ring_status(struct scsc_wlog_ring *r,
@@ -110,6 +117,10 @@ static int wlog_read_records(struct scsc_wlog_ring *r, u8 *buf,
 	if (scsc_wlog_ring_is_flushing(r))
 		return 0;
 
+	/* The mapped reader consumes in place */
+	if (r->mapped)
+		return 0;
+
 	/**
 	 * req_records has been loaded with a max u32 value by default
 	 *  on purpose...if a max number of records is provided in records
@@ -170,6 +181,10 @@ static int wlog_default_ring_drainer(struct scsc_wlog_ring *r, size_t drain_sz)
 
 	/* An SRCU on callback here would better */
 	mutex_lock(&r->drain_lock);
+	if (r->mapped && !r->flushing) {
+		mutex_unlock(&r->drain_lock);
+		return 0;
+	}
 	do {
 		/* drain ... consumes data */
 		rval = r->ops.read_records(r, r->drain_buf, chunk_sz, NULL, &ring_status, false);
@@ -187,6 +202,7 @@ static int wlog_default_ring_drainer(struct scsc_wlog_ring *r, size_t drain_sz)
 			mutex_unlock(&r->wl->lock);
 		}
 		drained_bytes += rval;
+		r->copied_bytes += rval;
 	} while (rval && drained_bytes <= drain_sz);
 	SCSC_TAG_DBG3(WLOG, "%s %d bytes\n", (r->flushing) ? "Flushed" : "Drained",
 		      drained_bytes);
@@ -200,6 +216,12 @@ static int wlog_default_ring_drainer(struct scsc_wlog_ring *r, size_t drain_sz)
 		r->dropped = 0;
 		r->st.written_records = 0;
 		r->st.read_bytes = r->st.written_bytes = 0;
+		if (r->mctrl) {
+			r->mctrl->read_bytes = 0;
+			r->mctrl->written_bytes = 0;
+			r->mctrl->written_records = 0;
+			r->mctrl->dropped = 0;
+		}
 		r->flushing = false;
 		raw_spin_unlock_irqrestore(&r->wlock, flags);
 		SCSC_TAG_INFO(WLOG, "Ring '%s' flushed.\n", r->st.name);
@@ -209,6 +231,18 @@ static int wlog_default_ring_drainer(struct scsc_wlog_ring *r, size_t drain_sz)
 	return drained_bytes;
 }
 
+/**
+ * Pick up what the mapped reader consumed: a consumer index outside the
+ * unread window is ignored.
+ */
+static inline void wlog_mmap_sync_reader(struct scsc_wlog_ring *r)
+{
+	u32 rd = READ_ONCE(r->mctrl->read_bytes);
+
+	if (rd - r->st.read_bytes <= r->st.written_bytes - r->st.read_bytes)
+		r->st.read_bytes = rd;
+}
+
 /**
  * A generic write that takes care to build the final payload created
  * concatenating:
@@ -259,6 +293,7 @@ static int wlog_write_record(struct scsc_wlog_ring *r, u8 *buf, size_t blen,
 	u8 *start = NULL;
 	u16 chunk_sz;
 	unsigned long flags;
+	bool wake = false;
 
 	if (scsc_wlog_ring_is_flushing(r))
 		return 0;
@@ -276,12 +311,14 @@ static int wlog_write_record(struct scsc_wlog_ring *r, u8 *buf, size_t blen,
 	}
 
 	raw_spin_lock_irqsave(&r->wlock, flags);
+	if (r->mapped)
+		wlog_mmap_sync_reader(r);
 	/**
 	 * Are there enough data to drain ?
 	 * if so...drain...queueing work....
 	 * if not (min_data_size ==  0) just do nothing
 	 */
-	if (!r->drop_on_full && r->min_data_size &&
+	if (!r->mapped && !r->drop_on_full && r->min_data_size &&
 	    AVAIL_BYTES(r) >= r->min_data_size)
 		queue_work(r->drain_workq, &r->drain_work);
 	/**
@@ -295,6 +332,8 @@ static int wlog_write_record(struct scsc_wlog_ring *r, u8 *buf, size_t blen,
 		SCSC_TAG_DBG4(WLOG, "[%s]:: dropped %zd bytes\n",
 			      r->st.name, blen + hlen);
 		r->dropped += blen + hlen;
+		if (r->mapped)
+			r->mctrl->dropped = r->dropped;
 		raw_spin_unlock_irqrestore(&r->wlock, flags);
 		return 0;
 	}
@@ -313,8 +352,21 @@ static int wlog_write_record(struct scsc_wlog_ring *r, u8 *buf, size_t blen,
 		memcpy(BUF_START(r), BUF_END(r), start + blen - BUF_END(r));
 	r->st.written_bytes += chunk_sz;
 	r->st.written_records++;
+	r->total_written += chunk_sz;
+	if (r->mapped) {
+		/* record content visible before the producer index */
+		smp_wmb();
+		WRITE_ONCE(r->mctrl->written_bytes, r->st.written_bytes);
+		r->mctrl->written_records = r->st.written_records;
+		wake = AVAIL_BYTES(r) >= max_t(u32, r->mctrl->wakeup_threshold, 1);
+	}
 	raw_spin_unlock_irqrestore(&r->wlock, flags);
 
+	if (wake && waitqueue_active(&r->mmap_wq)) {
+		r->mmap_wakeups++;
+		wake_up_interruptible(&r->mmap_wq);
+	}
+
 	return chunk_sz;
 }
 
@@ -471,6 +523,86 @@ int scsc_wlog_drain_whole_ring(struct scsc_wlog_ring *r)
 	return r->ops.drain_ring(r, r->st.rb_byte_size);
 }
 
+/**
+ * Hand the ring over to a single in place reader. Pending data is left
+ * to it, and the drainers are stopped from consuming while mapped.
+ */
+int scsc_wlog_mmap_attach(struct scsc_wlog_ring *r)
+{
+	unsigned long flags;
+
+	mutex_lock(&r->drain_lock);
+	if (r->mapped) {
+		mutex_unlock(&r->drain_lock);
+		return -EBUSY;
+	}
+	if (!r->mctrl) {
+		r->mctrl = (struct scsc_wlog_mmap_ctrl *)get_zeroed_page(GFP_KERNEL);
+		if (!r->mctrl) {
+			mutex_unlock(&r->drain_lock);
+			return -ENOMEM;
+		}
+	}
+	raw_spin_lock_irqsave(&r->wlock, flags);
+	r->mctrl->rb_byte_size = BUF_SZ(r);
+	r->mctrl->data_offset = WLOG_MMAP_DATA_OFF;
+	r->mctrl->read_bytes = r->st.read_bytes;
+	r->mctrl->written_bytes = r->st.written_bytes;
+	r->mctrl->written_records = r->st.written_records;
+	r->mctrl->dropped = r->dropped;
+	r->mapped = true;
+	raw_spin_unlock_irqrestore(&r->wlock, flags);
+	mutex_unlock(&r->drain_lock);
+
+	SCSC_TAG_INFO(WLOG, "Ring '%s' mapped by user reader\n", r->st.name);
+	return 0;
+}
+
+void scsc_wlog_mmap_detach(struct scsc_wlog_ring *r)
+{
+	unsigned long flags;
+
+	mutex_lock(&r->drain_lock);
+	raw_spin_lock_irqsave(&r->wlock, flags);
+	wlog_mmap_sync_reader(r);
+	r->mapped = false;
+	raw_spin_unlock_irqrestore(&r->wlock, flags);
+	mutex_unlock(&r->drain_lock);
+}
+
+int scsc_wlog_mmap(struct scsc_wlog_ring *r, struct vm_area_struct *vma)
+{
+	unsigned long size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (!r->mapped || vma->vm_pgoff ||
+	    size > WLOG_MMAP_DATA_OFF + WLOG_BUF_ALLOC_SZ(r))
+		return -EINVAL;
+
+	ret = remap_pfn_range(vma, vma->vm_start,
+			      virt_to_pfn(r->mctrl), PAGE_SIZE,
+			      vma->vm_page_prot);
+	if (ret || size <= PAGE_SIZE)
+		return ret;
+
+	return remap_pfn_range(vma, vma->vm_start + WLOG_MMAP_DATA_OFF,
+			       virt_to_pfn(r->buf),
+			       size - WLOG_MMAP_DATA_OFF, vma->vm_page_prot);
+}
+
+bool scsc_wlog_mmap_readable(struct scsc_wlog_ring *r)
+{
+	unsigned long flags;
+	bool ret;
+
+	raw_spin_lock_irqsave(&r->wlock, flags);
+	wlog_mmap_sync_reader(r);
+	ret = AVAIL_BYTES(r) >= max_t(u32, r->mctrl->wakeup_threshold, 1);
+	raw_spin_unlock_irqrestore(&r->wlock, flags);
+
+	return ret;
+}
+
 void scsc_wlog_flush_ring(struct scsc_wlog_ring *r)
 {
 	r->flushing = true;
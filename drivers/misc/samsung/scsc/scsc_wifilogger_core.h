@@ -59,6 +59,10 @@
  * polling-read mechanism, the ring would finally FILL-UP: in such a case all
  * the data received once the ring is full will be DROPPED.
  * This behavior fits the pkt_fate use case scenario.
+ *
+ * A ring can also be consumed in place by ONE user space reader through
+ * its debugfs 'mmap' file: while mapped, the periodic and threshold
+ * drainers are inhibited and the reader owns @read_bytes.
  */
 
 #include "scsc_wifilogger_types.h"
@@ -123,6 +127,29 @@ enum {
 	RING_STATE_ACTIVE
 };
 
+/**
+ * Layout of a ring mapped through its debugfs 'mmap' file: this control
+ * page first, then at @data_offset the ring buffer followed by its spare
+ * area, so that a record rolling over the ring end can be read in place
+ * as a whole exactly like wlog_read_records() does.
+ *
+ * @written_bytes: producer index, published by the kernel after each record
+ * @read_bytes: consumer index, advanced by the mapped reader
+ * @wakeup_threshold: unread bytes needed for poll() to report POLLIN
+ */
+struct scsc_wlog_mmap_ctrl {
+	u32 written_bytes;
+	u32 read_bytes;
+	u32 rb_byte_size;
+	u32 data_offset;
+	u32 wakeup_threshold;
+	u32 written_records;
+	u32 dropped;
+};
+
+#define	WLOG_MMAP_DATA_OFF			PAGE_SIZE
+#define	WLOG_BUF_ALLOC_SZ(r)	PAGE_ALIGN(BUF_SZ(r) + MAX_RECORD_SZ)
+
 struct scsc_wlog_ring;
 
 typedef	bool (*init_cb)(struct scsc_wlog_ring *r);
@@ -171,6 +198,17 @@ struct scsc_wlog_ring {
 
 	struct scsc_wlog_ring_ops ops;
 
+	/* in place reader, see struct scsc_wlog_mmap_ctrl */
+	bool			mapped;
+	struct scsc_wlog_mmap_ctrl *mctrl;
+	wait_queue_head_t	mmap_wq;
+
+	/* bytes copied out by the drainer and reader wakeups */
+	u64			total_written;
+	u64			copied_bytes;
+	u32			drain_wakeups;
+	u32			mmap_wakeups;
+
 	void			*priv;
 
 	struct scsc_wifi_logger	*wl;
@@ -267,4 +305,9 @@ static inline void scsc_wlog_ring_change_verbosity(struct scsc_wlog_ring *r, u32
 
 void scsc_wlog_flush_ring(struct scsc_wlog_ring *r);
 
+int scsc_wlog_mmap_attach(struct scsc_wlog_ring *r);
+void scsc_wlog_mmap_detach(struct scsc_wlog_ring *r);
+int scsc_wlog_mmap(struct scsc_wlog_ring *r, struct vm_area_struct *vma);
+bool scsc_wlog_mmap_readable(struct scsc_wlog_ring *r);
+
 #endif /*_SCSC_WIFI_LOGGER_CORE_H_*/
@@ -23,7 +23,7 @@ int dfs_release(struct inode *ino, struct file *filp)
 	return 0;
 }
 
-#define	SCSC_RING_TEST_STAT_SZ		512
+#define	SCSC_RING_TEST_STAT_SZ		768
 
 static ssize_t dfs_stats_read(struct file *filp, char __user *ubuf,
 			      size_t count, loff_t *f_pos)
@@ -41,6 +41,18 @@ static ssize_t dfs_stats_read(struct file *filp, char __user *ubuf,
 			rto->r->st.written_bytes - rto->r->st.read_bytes,
 			rto->r->st.written_bytes, rto->r->st.read_bytes,
 			rto->r->st.written_records, rto->r->dropped, rto->r->buf);
+	if (slen > 0 && slen < SCSC_RING_TEST_STAT_SZ) {
+		u32 mb = (u32)(rto->r->total_written >> 20) ? : 1;
+
+		slen += snprintf(statstr + slen, SCSC_RING_TEST_STAT_SZ - slen,
+				 "\tmapped:%d  total_written:%llu  copied:%llu  drain_wakeups:%u  mmap_wakeups:%u\n"
+				 "\tper MB:: copied:%llu  wakeups:%u\n",
+				 rto->r->mapped, rto->r->total_written,
+				 rto->r->copied_bytes, rto->r->drain_wakeups,
+				 rto->r->mmap_wakeups,
+				 div_u64(rto->r->copied_bytes, mb),
+				 (rto->r->drain_wakeups + rto->r->mmap_wakeups) / mb);
+	}
 	if (slen >= 0 && *f_pos < slen) {
 		count = (count <= slen - *f_pos) ? count : (slen - *f_pos);
 		if (copy_to_user(ubuf, statstr + *f_pos, count))
@@ -59,6 +71,60 @@ const struct file_operations stats_fops = {
 	.release = dfs_release,
 };
 
+static int dfs_mmap_open(struct inode *ino, struct file *filp)
+{
+	int ret;
+	struct scsc_ring_test_object *rto;
+
+	ret = dfs_open(ino, filp);
+	if (ret)
+		return ret;
+
+	rto = filp->private_data;
+	ret = scsc_wlog_mmap_attach(rto->r);
+	if (ret) {
+		SCSC_TAG_ERR(WLOG,
+			     "Ring '%s' already mapped...ONLY one reader allowed !!!\n",
+			     rto->r->st.name);
+		dfs_release(ino, filp);
+	}
+
+	return ret;
+}
+
+static int dfs_mmap_release(struct inode *ino, struct file *filp)
+{
+	struct scsc_ring_test_object *rto = filp->private_data;
+
+	scsc_wlog_mmap_detach(rto->r);
+
+	return dfs_release(ino, filp);
+}
+
+static int dfs_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+	struct scsc_ring_test_object *rto = filp->private_data;
+
+	return scsc_wlog_mmap(rto->r, vma);
+}
+
+static unsigned int dfs_mmap_poll(struct file *filp, poll_table *wait)
+{
+	struct scsc_ring_test_object *rto = filp->private_data;
+
+	poll_wait(filp, &rto->r->mmap_wq, wait);
+
+	return scsc_wlog_mmap_readable(rto->r) ? POLLIN | POLLRDNORM : 0;
+}
+
+const struct file_operations mmap_fops = {
+	.owner = THIS_MODULE,
+	.open = dfs_mmap_open,
+	.mmap = dfs_mmap,
+	.poll = dfs_mmap_poll,
+	.release = dfs_mmap_release,
+};
+
 #ifdef CONFIG_SCSC_WIFILOGGER_TEST
 static int dfs_read_record_open(struct inode *ino, struct file *filp)
 {
@@ -427,6 +493,8 @@ void scsc_register_common_debugfs_entries(char *ring_name, void *rto,
 {
 	scsc_wlog_register_debugfs_entry(ring_name, "stats",
 					 &stats_fops, rto, di);
+	scsc_wlog_register_debugfs_entry(ring_name, "mmap",
+					 &mmap_fops, rto, di);
 #ifdef CONFIG_SCSC_WIFILOGGER_TEST
 	scsc_wlog_register_debugfs_entry(ring_name, "verbose_level",
 					 &verbosity_fops, rto, di);
@@ -16,6 +16,8 @@
 #include <linux/slab.h>
 #include <linux/fs.h>
 #include <linux/vmalloc.h>
+#include <linux/poll.h>
+#include <linux/math64.h>
 #include <asm/uaccess.h>
 
 #include <scsc/scsc_logring.h>
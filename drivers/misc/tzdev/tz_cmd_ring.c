@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2013-2016 Samsung Electronics, Inc.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include <linux/atomic.h>
+#include <linux/kernel.h>
+#include <linux/spinlock.h>
+
+#include "tzdev.h"
+#include "tz_cmd_ring.h"
+#include "tz_iwio.h"
+
+#define TZ_CMD_RING_SIZE	((CONFIG_TZ_CMD_RING_PG_CNT * PAGE_SIZE - \
+		sizeof(struct tz_cmd_ring)) / sizeof(struct tz_cmd_ring_entry))
+
+static struct tz_cmd_ring *tz_cmd_ring;
+static DEFINE_SPINLOCK(tz_cmd_ring_lock);
+static unsigned int tz_cmd_ring_kicking;
+
+int tz_cmd_ring_initialize(unsigned int swd_flags)
+{
+	struct tz_cmd_ring *ring;
+
+	if (!(swd_flags & SYSCONF_CMD_RING))
+		return 0;
+
+	ring = tz_iwio_alloc_iw_channel(TZ_IWIO_CONNECT_CMD_RING,
+			CONFIG_TZ_CMD_RING_PG_CNT);
+	if (!ring)
+		return -ENOMEM;
+
+	ring->size = TZ_CMD_RING_SIZE;
+	tz_cmd_ring = ring;
+
+	tzdev_print(0, "Command ring of %u entries\n", ring->size);
+
+	return 0;
+}
+
+/*
+ * Queue a command. The first caller to find no kick in progress becomes
+ * the kicker and enters SWd; commands queued meanwhile are picked up by
+ * SWd in the same world switch or by the kicker's next one.
+ */
+int tz_cmd_ring_push(unsigned int tid, unsigned int shm_id)
+{
+	struct tz_cmd_ring *ring = tz_cmd_ring;
+	struct tz_cmd_ring_entry *entry;
+	unsigned int head;
+	int ret;
+
+	if (!ring)
+		return -ENODEV;
+
+	spin_lock(&tz_cmd_ring_lock);
+	head = ring->head;
+	if (head - READ_ONCE(ring->tail) >= TZ_CMD_RING_SIZE) {
+		spin_unlock(&tz_cmd_ring_lock);
+		return -ENOSPC;
+	}
+
+	entry = &ring->entries[head % TZ_CMD_RING_SIZE];
+	entry->tid = tid;
+	entry->shm_id = shm_id;
+	/* SWd must see the entry before the new head */
+	smp_wmb();
+	WRITE_ONCE(ring->head, head + 1);
+
+	if (tz_cmd_ring_kicking) {
+		ret = TZ_CMD_RING_QUEUED;
+	} else {
+		tz_cmd_ring_kicking = 1;
+		ret = TZ_CMD_RING_KICK;
+	}
+	spin_unlock(&tz_cmd_ring_lock);
+
+	return ret;
+}
+
+/*
+ * Called by the kicker after each TZDEV_SMC_CMD_RING_KICK. Returns 1 once
+ * SWd has drained everything, handing the kick over to the next pusher,
+ * or 0 if commands arrived after SWd stopped polling.
+ */
+int tz_cmd_ring_kick_done(void)
+{
+	struct tz_cmd_ring *ring = tz_cmd_ring;
+	int done;
+
+	spin_lock(&tz_cmd_ring_lock);
+	done = READ_ONCE(ring->tail) == ring->head;
+	if (done)
+		tz_cmd_ring_kicking = 0;
+	spin_unlock(&tz_cmd_ring_lock);
+
+	return done;
+}
+
+/* Kick failed: stop using the ring, commands go by SMC from now on */
+void tz_cmd_ring_abort(void)
+{
+	spin_lock(&tz_cmd_ring_lock);
+	tz_cmd_ring = NULL;
+	tz_cmd_ring_kicking = 0;
+	spin_unlock(&tz_cmd_ring_lock);
+
+	tzdev_print(0, "Command ring disabled\n");
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2013-2016 Samsung Electronics, Inc.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef __TZ_CMD_RING_H__
+#define __TZ_CMD_RING_H__
+
+#include <linux/errno.h>
+#include <linux/types.h>
+
+struct tz_cmd_ring_entry {
+	uint32_t tid;
+	uint32_t shm_id;
+} __packed;
+
+/*
+ * Shared with SWd. NWd advances head after filling an entry, SWd advances
+ * tail after taking one and keeps draining while head != tail before it
+ * returns from TZDEV_SMC_CMD_RING_KICK.
+ */
+struct tz_cmd_ring {
+	uint32_t head;
+	uint32_t tail;
+	uint32_t size;
+	uint32_t reserved;
+	struct tz_cmd_ring_entry entries[];
+} __packed;
+
+enum {
+	TZ_CMD_RING_KICK,	/* queued, caller must kick SWd */
+	TZ_CMD_RING_QUEUED,	/* queued behind a kick in progress */
+};
+
+#if defined(CONFIG_TZ_CMD_RING)
+int tz_cmd_ring_initialize(unsigned int swd_flags);
+int tz_cmd_ring_push(unsigned int tid, unsigned int shm_id);
+int tz_cmd_ring_kick_done(void);
+void tz_cmd_ring_abort(void);
+#else
+static inline int tz_cmd_ring_initialize(unsigned int swd_flags)
+{
+	return 0;
+}
+
+static inline int tz_cmd_ring_push(unsigned int tid, unsigned int shm_id)
+{
+	return -ENODEV;
+}
+
+static inline int tz_cmd_ring_kick_done(void)
+{
+	return 1;
+}
+
+static inline void tz_cmd_ring_abort(void)
+{
+}
+#endif /* CONFIG_TZ_CMD_RING */
+
+#endif /* __TZ_CMD_RING_H__ */
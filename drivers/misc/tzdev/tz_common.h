@@ -50,6 +50,7 @@ struct tzio_access_info {
 /* NB: Sysconf related definitions should match with those in SWd */
 #define SYSCONF_VERSION_LEN			(256)
 #define SYSCONF_CRYPTO_CLOCK_MANAGEMENT		(1 << 0)
+#define SYSCONF_CMD_RING			(1 << 1)
 
 struct tzio_sysconf {
 	uint32_t os_version;			/* SWd OS version */
@@ -20,6 +20,7 @@ enum {
 	TZ_IWIO_CONNECT_TRANSPORT,
 	TZ_IWIO_CONNECT_PROFILER,
 	TZ_IWIO_CONNECT_PANIC_DUMP,
+	TZ_IWIO_CONNECT_CMD_RING,
 	TZ_IWIO_CONNECT_CNT
 };
 
@@ -47,6 +47,19 @@ static long tz_telemetry_unlocked_ioctl(struct file *file, unsigned int cmd,
 
 		return tzdev_smc_telemetry_control(ctrl.mode, ctrl.type, ctrl.arg);
 	}
+	case TZ_TELEMETRY_GET_SMC_STATS: {
+		struct tzio_telemetry_smc_stats __user *argp
+				= (struct tzio_telemetry_smc_stats __user *) arg;
+		struct tzio_telemetry_smc_stats stats;
+
+		tzdev_get_smc_stats(&stats);
+
+		if (copy_to_user(argp, &stats,
+				sizeof(struct tzio_telemetry_smc_stats)))
+			return -EFAULT;
+
+		return 0;
+	}
 
 	default:
 		return -ENOTTY;
@@ -18,6 +18,7 @@
 
 #define TZ_TELEMETRY_IOC_MAGIC		'c'
 #define TZ_TELEMETRY_CONTROL		_IOW(TZ_TELEMETRY_IOC_MAGIC, 0, struct tzio_telemetry_ctrl)
+#define TZ_TELEMETRY_GET_SMC_STATS	_IOR(TZ_TELEMETRY_IOC_MAGIC, 1, struct tzio_telemetry_smc_stats)
 
 struct tzio_telemetry_ctrl {
 	__u32 mode;
@@ -25,4 +26,13 @@ struct tzio_telemetry_ctrl {
 	__u32 arg;
 };
 
+/* World switches against TA commands; smcs / commands is SMCs per command */
+struct tzio_telemetry_smc_stats {
+	__u64 smcs;		/* all world switches */
+	__u64 commands;		/* TA commands sent */
+	__u64 command_smcs;	/* world switches made for TA commands */
+	__u64 ring_batched;	/* commands queued behind another kick */
+	__u64 ring_fallbacks;	/* commands sent by SMC with the ring on */
+};
+
 #endif /*!__TZ_TELEMETRY_H__*/
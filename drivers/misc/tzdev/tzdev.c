@@ -46,6 +46,7 @@
 #include "tz_boost.h"
 #include "tz_cdev.h"
 #include "tz_cma.h"
+#include "tz_cmd_ring.h"
 #include "tz_iw_boot_log.h"
 #include "tz_iwio.h"
 #include "tz_iwlog.h"
@@ -54,6 +55,7 @@
 #include "tz_mem.h"
 #include "tz_panic_dump.h"
 #include "tz_platform.h"
+#include "tz_telemetry.h"
 #include "tzprofiler.h"
 #include "tz_wormhole.h"
 
@@ -98,6 +100,12 @@ static struct tzio_service_channel *tzdev_service_channel;
  * moving Tzdaemon worker threads to TZDEV */
 static unsigned long tzdaemon_cpu_mask;
 
+static atomic64_t tzdev_smc_count = ATOMIC64_INIT(0);
+static atomic64_t tzdev_cmd_count = ATOMIC64_INIT(0);
+static atomic64_t tzdev_cmd_smc_count = ATOMIC64_INIT(0);
+static atomic64_t tzdev_cmd_batched = ATOMIC64_INIT(0);
+static atomic64_t tzdev_cmd_fallbacks = ATOMIC64_INIT(0);
+
 int __tzdev_smc_cmd(struct tzio_smc_data *data,
 		unsigned int swd_ctx_present)
 {
@@ -110,6 +118,7 @@ int __tzdev_smc_cmd(struct tzio_smc_data *data,
 	tzprofiler_enter_sw();
 	tz_iwlog_schedule_delayed_work();
 
+	atomic64_inc(&tzdev_smc_count);
 	ret = tzdev_platform_smc_call(data);
 
 	tz_iwlog_cancel_delayed_work();
@@ -337,6 +346,10 @@ static int tzdev_run_init_sequence(void)
 			goto out;
 		}
 
+		/* Not fatal, commands are then sent one SMC each */
+		if (tz_cmd_ring_initialize(tz_sysconf.flags))
+			tzdev_print(0, "tz_cmd_ring_initialize() failed\n");
+
 		tzdev_register_iwis();
 		tz_iwnotify_initialize();
 		tzdev_kapi_init();
@@ -393,12 +406,48 @@ static int tzdev_get_access_info(struct tzio_access_info *s)
 	return 0;
 }
 
+static void tzdev_put_reply_locked(unsigned int pipe, unsigned int is_pipe_user)
+{
+	unsigned int num_written;
+
+	num_written = is_pipe_user ?
+		sysdep_kfifo_put(&tzdev_rsp_ufifo, pipe) :
+		sysdep_kfifo_put(&tzdev_rsp_kfifo, pipe);
+	if (!num_written) {
+		tzdev_print(0, "Putting response to %s queue failed\n",
+				is_pipe_user ? "user" : "kernel");
+		/* User FIFO overflow is handled by dropping the message. */
+		BUG_ON(!is_pipe_user);
+	}
+}
+
+/* Queue a reply that no caller returns, e.g. from a repeated ring kick */
+static void tzdev_stash_reply(struct tzio_smc_data d)
+{
+	unsigned int pipe;
+	unsigned int is_pipe_user = 1;
+
+	if (!tzdev_is_mem_exist(d.pipe, &is_pipe_user))
+		tzdev_print(2, "Pipe 0x%x not found in TZDEV shmem idr\n", d.args[0]);
+
+	pipe = d.args[0] & TZDEV_PIPE_TARGET_DEAD_MASK;
+
+	spin_lock(&tzdev_rsp_lock);
+	tzdev_rsp_event_mask |= d.event_mask;
+	if (pipe)
+		tzdev_put_reply_locked(pipe, is_pipe_user);
+	spin_unlock(&tzdev_rsp_lock);
+
+	if (pipe || d.event_mask)
+		complete(&tzdev_iwi_event_done);
+}
+
 static struct tzio_smc_data tzdev_process_reply(struct tzio_smc_data d, unsigned int is_user)
 {
 	unsigned int pipe = 0;
 	unsigned int is_pipe_user = 1;
 	unsigned int notify_user = 0;
-	unsigned int num_written, num_read;
+	unsigned int num_read;
 
 	if (!tzdev_is_mem_exist(d.pipe, &is_pipe_user))
 		tzdev_print(2, "Pipe 0x%x not found in TZDEV shmem idr\n", d.args[0]);
@@ -428,15 +477,7 @@ static struct tzio_smc_data tzdev_process_reply(struct tzio_smc_data d, unsigned
 	if (!pipe)
 		goto read_reply;
 
-	num_written = is_pipe_user ?
-		sysdep_kfifo_put(&tzdev_rsp_ufifo, pipe) :
-		sysdep_kfifo_put(&tzdev_rsp_kfifo, pipe);
-	if (!num_written) {
-		tzdev_print(0, "Putting response to %s queue failed\n",
-				is_pipe_user ? "user" : "kernel");
-		/* User FIFO overflow is handled by dropping the message. */
-		BUG_ON(!is_pipe_user);
-	}
+	tzdev_put_reply_locked(pipe, is_pipe_user);
 
 read_reply:
 	memset(&d, 0, sizeof(d));
@@ -465,22 +506,73 @@ read_reply:
 	return d;
 }
 
-static struct tzio_smc_data tzdev_send_command_user(unsigned int tid, unsigned int shm_id)
+/*
+ * Commands go through the command ring when SWd supports it. Only the
+ * caller that finds SWd idle enters it; SWd keeps taking commands while
+ * the ring is not empty, and other callers just pick their replies up
+ * from the FIFOs like after an empty GET_EVENT.
+ */
+static struct tzio_smc_data __tzdev_send_command(unsigned int tid,
+		unsigned int shm_id, unsigned int is_user)
 {
 	struct tzio_smc_data d;
+	int ret;
 
-	d = tzdev_smc_command(tid, shm_id);
+	atomic64_inc(&tzdev_cmd_count);
 
-	return tzdev_process_reply(d, 1);
+	ret = tz_cmd_ring_push(tid, shm_id);
+	if (ret < 0) {
+		if (ret == -ENOSPC)
+			atomic64_inc(&tzdev_cmd_fallbacks);
+		atomic64_inc(&tzdev_cmd_smc_count);
+		d = tzdev_smc_command(tid, shm_id);
+		return tzdev_process_reply(d, is_user);
+	}
+
+	if (ret == TZ_CMD_RING_QUEUED) {
+		atomic64_inc(&tzdev_cmd_batched);
+		memset(&d, 0, sizeof(d));
+		return tzdev_process_reply(d, is_user);
+	}
+
+	for (;;) {
+		memset(&d, 0, sizeof(d));
+		d.args[0] = TZDEV_SMC_CMD_RING_KICK;
+
+		atomic64_inc(&tzdev_cmd_smc_count);
+		ret = __tzdev_smc_cmd(&d, 1);
+		if (ret) {
+			tz_cmd_ring_abort();
+			d.args[0] = ret;
+			break;
+		}
+
+		if (tz_cmd_ring_kick_done())
+			break;
+
+		tzdev_stash_reply(d);
+	}
+
+	return tzdev_process_reply(d, is_user);
 }
 
-struct tzio_smc_data tzdev_send_command(unsigned int tid, unsigned int shm_id)
+static struct tzio_smc_data tzdev_send_command_user(unsigned int tid, unsigned int shm_id)
 {
-	struct tzio_smc_data d;
+	return __tzdev_send_command(tid, shm_id, 1);
+}
 
-	d = tzdev_smc_command(tid, shm_id);
+struct tzio_smc_data tzdev_send_command(unsigned int tid, unsigned int shm_id)
+{
+	return __tzdev_send_command(tid, shm_id, 0);
+}
 
-	return tzdev_process_reply(d, 0);
+void tzdev_get_smc_stats(struct tzio_telemetry_smc_stats *stats)
+{
+	stats->smcs = atomic64_read(&tzdev_smc_count);
+	stats->commands = atomic64_read(&tzdev_cmd_count);
+	stats->command_smcs = atomic64_read(&tzdev_cmd_smc_count);
+	stats->ring_batched = atomic64_read(&tzdev_cmd_batched);
+	stats->ring_fallbacks = atomic64_read(&tzdev_cmd_fallbacks);
 }
 
 static struct tzio_smc_data tzdev_get_event_user(void)
@@ -63,6 +63,7 @@
 #define TZDEV_SMC_PROFILER_CONTROL_RAW		17
 #define TZDEV_SMC_NW_KERNEL_API_CMD_RAW		18
 #define TZDEV_SMC_SPI_SET_CLOCK_SPEED_RAW	19
+#define TZDEV_SMC_CMD_RING_KICK_RAW		20
 
 #if defined(CONFIG_TZDEV_USE_ARM_CALLING_CONVENTION)
 
@@ -86,6 +87,7 @@
 #define TZDEV_SMC_PROFILER_CONTROL	CREATE_SMC_CMD(SMC_TYPE_FAST, SMC_CURRENT_AARCH, SMC_TOS0_SERVICE_MASK, TZDEV_SMC_PROFILER_CONTROL_RAW)
 #define TZDEV_SMC_NW_KERNEL_API_CMD	CREATE_SMC_CMD(SMC_TYPE_FAST, SMC_CURRENT_AARCH, SMC_TOS0_SERVICE_MASK, TZDEV_SMC_NW_KERNEL_API_CMD_RAW)
 #define TZDEV_SMC_SPI_SET_CLOCK_SPEED	CREATE_SMC_CMD(SMC_TYPE_FAST, SMC_CURRENT_AARCH, SMC_TOS0_SERVICE_MASK, TZDEV_SMC_SPI_SET_CLOCK_SPEED_RAW)
+#define TZDEV_SMC_CMD_RING_KICK		CREATE_SMC_CMD(SMC_TYPE_FAST, SMC_CURRENT_AARCH, SMC_TOS0_SERVICE_MASK, TZDEV_SMC_CMD_RING_KICK_RAW)
 
 #else /* CONFIG_TZDEV_USE_ARM_CALLING_CONVENTION */
 
@@ -109,6 +111,7 @@
 #define TZDEV_SMC_PROFILER_CONTROL	TZDEV_SMC_PROFILER_CONTROL_RAW
 #define TZDEV_SMC_NW_KERNEL_API_CMD	TZDEV_SMC_NW_KERNEL_API_CMD_RAW
 #define TZDEV_SMC_SPI_SET_CLOCK_SPEED	TZDEV_SMC_SPI_SET_CLOCK_SPEED_RAW
+#define TZDEV_SMC_CMD_RING_KICK		TZDEV_SMC_CMD_RING_KICK_RAW
 
 #endif /* CONFIG_TZDEV_USE_ARM_CALLING_CONVENTION */
 
@@ -203,4 +206,7 @@ struct tzio_smc_data tzdev_get_event(void);
 struct tzio_smc_data tzdev_send_command(unsigned int tid, unsigned int shm_id);
 int tzdev_is_opened(void);
 
+struct tzio_telemetry_smc_stats;
+void tzdev_get_smc_stats(struct tzio_telemetry_smc_stats *stats);
+
 #endif /* __TZDEV_H__ */
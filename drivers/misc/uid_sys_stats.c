@@ -19,10 +19,13 @@
 #include <linux/hashtable.h>
 #include <linux/init.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/list.h>
 #include <linux/mm.h>
+#include <linux/percpu.h>
 #include <linux/proc_fs.h>
 #include <linux/profile.h>
+#include <linux/rcupdate.h>
 #include <linux/rtmutex.h>
 #include <linux/sched.h>
 #include <linux/seq_file.h>
@@ -298,6 +301,126 @@ static void show_io_uid_tasks(struct seq_file *m,
 		struct uid_entry *uid_entry) {}
 #endif
 
+/*
+ * Exiting tasks are accounted to per-cpu buckets with preemption disabled,
+ * rather than under uid_lock, and the buckets are folded into the uid
+ * table by the readers. A fold switches every cpu to the other bank and
+ * waits for a sched RCU grace period, after which no exiting task can be
+ * adding to the old bank any more and it can be drained without locking.
+ * Tasks finding their cpu's bank full take uid_lock as before.
+ */
+#define UID_PCPU_SLOTS		16
+
+struct uid_pending {
+	uid_t uid;
+	bool used;
+	cputime_t utime;
+	cputime_t stime;
+	struct io_stats io;
+};
+
+struct uid_pcpu {
+	struct uid_pending bank[2][UID_PCPU_SLOTS];
+};
+
+static DEFINE_PER_CPU(struct uid_pcpu, uid_pcpu);
+static int uid_pcpu_bank;
+
+/* fold statistics, under uid_lock */
+static u64 uid_fold_count;
+static u64 uid_fold_records;
+static u64 uid_fold_total_ns;
+static u64 uid_fold_max_ns;
+static atomic64_t uid_pcpu_full = ATOMIC64_INIT(0);
+
+static bool uid_pcpu_add(uid_t uid, struct task_struct *task)
+{
+	struct uid_pending *bank, *slot = NULL;
+	cputime_t utime, stime;
+	int i;
+
+	task_cputime_adjusted(task, &utime, &stime);
+
+	preempt_disable();
+	bank = this_cpu_ptr(&uid_pcpu)->bank[READ_ONCE(uid_pcpu_bank)];
+	for (i = 0; i < UID_PCPU_SLOTS; i++) {
+		/* slots are taken in order, a free one ends the search */
+		if (!bank[i].used || bank[i].uid == uid) {
+			slot = &bank[i];
+			break;
+		}
+	}
+
+	if (slot) {
+		slot->uid = uid;
+		slot->used = true;
+		slot->utime += utime;
+		slot->stime += stime;
+		slot->io.read_bytes += task->ioac.read_bytes;
+		slot->io.write_bytes += compute_write_bytes(task);
+		slot->io.rchar += task->ioac.rchar;
+		slot->io.wchar += task->ioac.wchar;
+		slot->io.fsync += task->ioac.syscfs;
+	}
+	preempt_enable();
+
+	if (!slot)
+		atomic64_inc(&uid_pcpu_full);
+
+	return slot != NULL;
+}
+
+static struct uid_entry *find_or_register_uid(uid_t uid);
+
+static void fold_pcpu_stats_locked(void)
+{
+	struct uid_entry *uid_entry;
+	struct uid_pending *bank;
+	struct io_stats *io;
+	int old = uid_pcpu_bank;
+	ktime_t start = ktime_get();
+	u64 records = 0, ns;
+	int cpu, i;
+
+	for_each_possible_cpu(cpu)
+		if (per_cpu(uid_pcpu, cpu).bank[old][0].used)
+			break;
+	if (cpu >= nr_cpu_ids)
+		return;
+
+	WRITE_ONCE(uid_pcpu_bank, !old);
+	synchronize_sched();
+
+	for_each_possible_cpu(cpu) {
+		bank = per_cpu(uid_pcpu, cpu).bank[old];
+		for (i = 0; i < UID_PCPU_SLOTS && bank[i].used; i++) {
+			uid_entry = find_or_register_uid(bank[i].uid);
+			if (!uid_entry) {
+				pr_err("%s: failed to find uid %d\n", __func__,
+					bank[i].uid);
+				continue;
+			}
+
+			uid_entry->utime += bank[i].utime;
+			uid_entry->stime += bank[i].stime;
+			io = &uid_entry->io[UID_STATE_DEAD_TASKS];
+			io->read_bytes += bank[i].io.read_bytes;
+			io->write_bytes += bank[i].io.write_bytes;
+			io->rchar += bank[i].io.rchar;
+			io->wchar += bank[i].io.wchar;
+			io->fsync += bank[i].io.fsync;
+			records++;
+		}
+		memset(bank, 0, sizeof(per_cpu(uid_pcpu, cpu).bank[old]));
+	}
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	uid_fold_count++;
+	uid_fold_records += records;
+	uid_fold_total_ns += ns;
+	uid_fold_max_ns = max(uid_fold_max_ns, ns);
+}
+
 static struct uid_entry *find_uid_entry(uid_t uid)
 {
 	struct uid_entry *uid_entry;
@@ -341,6 +464,8 @@ static int uid_cputime_show(struct seq_file *m, void *v)
 
 	rt_mutex_lock(&uid_lock);
 
+	fold_pcpu_stats_locked();
+
 	hash_for_each(hash_table, bkt, uid_entry, hash) {
 		uid_entry->active_stime = 0;
 		uid_entry->active_utime = 0;
@@ -432,6 +557,9 @@ static ssize_t uid_remove_write(struct file *file,
 
 	rt_mutex_lock(&uid_lock);
 
+	/* so that no pending exit brings the uids back */
+	fold_pcpu_stats_locked();
+
 	for (; uid_start <= uid_end; uid_start++) {
 		hash_for_each_possible_safe(hash_table, uid_entry, tmp,
 							hash, (uid_t)uid_start) {
@@ -538,6 +666,7 @@ static int uid_io_show(struct seq_file *m, void *v)
 
 	rt_mutex_lock(&uid_lock);
 
+	fold_pcpu_stats_locked();
 	update_io_stats_all_locked();
 
 	hash_for_each(hash_table, bkt, uid_entry, hash) {
@@ -614,6 +743,7 @@ static ssize_t uid_procstat_write(struct file *file,
 		return count;
 	}
 
+	fold_pcpu_stats_locked();
 	update_io_stats_uid_locked(uid_entry);
 
 	uid_entry->state = state;
@@ -640,8 +770,13 @@ static int process_notifier(struct notifier_block *self,
 	if (!task)
 		return NOTIFY_OK;
 
-	rt_mutex_lock(&uid_lock);
 	uid = from_kuid_munged(current_user_ns(), task_uid(task));
+
+	/* per task entries need the task, keep those on the locked path */
+	if (!IS_ENABLED(CONFIG_UID_SYS_STATS_DEBUG) && uid_pcpu_add(uid, task))
+		return NOTIFY_OK;
+
+	rt_mutex_lock(&uid_lock);
 	uid_entry = find_or_register_uid(uid);
 	if (!uid_entry) {
 		pr_err("%s: failed to find uid %d\n", __func__, uid);
@@ -659,6 +794,32 @@ exit:
 	return NOTIFY_OK;
 }
 
+static int uid_fold_stat_show(struct seq_file *m, void *v)
+{
+	rt_mutex_lock(&uid_lock);
+	seq_printf(m, "folds: %llu\nrecords: %llu\ntotal_ns: %llu\n"
+		   "avg_ns: %llu\nmax_ns: %llu\nbank_full: %lld\n",
+		   uid_fold_count, uid_fold_records, uid_fold_total_ns,
+		   uid_fold_count ?
+			div64_u64(uid_fold_total_ns, uid_fold_count) : 0,
+		   uid_fold_max_ns,
+		   (long long)atomic64_read(&uid_pcpu_full));
+	rt_mutex_unlock(&uid_lock);
+	return 0;
+}
+
+static int uid_fold_stat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, uid_fold_stat_show, PDE_DATA(inode));
+}
+
+static const struct file_operations uid_fold_stat_fops = {
+	.open		= uid_fold_stat_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static struct notifier_block process_notifier_block = {
 	.notifier_call	= process_notifier,
 };
@@ -678,6 +839,8 @@ static int __init proc_uid_sys_stats_init(void)
 		&uid_remove_fops, NULL);
 	proc_create_data("show_uid_stat", 0444, cpu_parent,
 		&uid_cputime_fops, NULL);
+	proc_create_data("fold_stat", 0444, cpu_parent,
+		&uid_fold_stat_fops, NULL);
 
 	io_parent = proc_mkdir("uid_io", NULL);
 	if (!io_parent) {
@@ -28,6 +28,15 @@
 
 #define MMC_QUEUE_BOUNCESZ	65536
 
+#ifdef CONFIG_MMC_BLOCK_MQ
+/* without command queueing, deep enough to batch and merge behind mmcqd */
+#define MMC_MQ_QUEUE_DEPTH	32
+
+static bool use_blk_mq = true;
+module_param(use_blk_mq, bool, 0444);
+MODULE_PARM_DESC(use_blk_mq, "Queue requests through blk-mq");
+#endif
+
 /*
  * Prepare a MMC request. This just filters out odd stuff.
  */
@@ -139,6 +148,48 @@ static int mmc_cmdq_thread(void *d)
 	return 0;
 }
 
+/*
+ * Take the next request to issue. Called with the queue lock held, like
+ * blk_fetch_request().
+ */
+struct request *mmc_queue_fetch(struct mmc_queue *mq)
+{
+	struct request *req = NULL;
+
+#ifdef CONFIG_MMC_BLOCK_MQ
+	if (mq->queue->mq_ops) {
+		spin_lock(&mq->mq_lock);
+		if (!list_empty(&mq->mq_list)) {
+			req = list_first_entry(&mq->mq_list, struct request,
+					       queuelist);
+			list_del_init(&req->queuelist);
+		}
+		spin_unlock(&mq->mq_lock);
+
+		return req;
+	}
+#endif
+	req = blk_fetch_request(mq->queue);
+
+	return req;
+}
+
+/* Hand back a fetched request that will not be issued now */
+void mmc_queue_requeue(struct mmc_queue *mq, struct request *req)
+{
+	struct request_queue *q = mq->queue;
+
+	if (q->mq_ops) {
+		blk_mq_requeue_request(req);
+		blk_mq_kick_requeue_list(q);
+		return;
+	}
+
+	spin_lock_irq(q->queue_lock);
+	blk_requeue_request(q, req);
+	spin_unlock_irq(q->queue_lock);
+}
+
 static int mmc_queue_thread(void *d)
 {
 	struct mmc_queue *mq = d;
@@ -158,7 +209,7 @@ static int mmc_queue_thread(void *d)
 				 mq->card->host->pm_progress))
 			req = NULL;
 		else
-			req = blk_fetch_request(q);
+			req = mmc_queue_fetch(mq);
 		mq->mqrq_cur->req = req;
 		spin_unlock_irq(q->queue_lock);
 
@@ -213,21 +264,11 @@ static void mmc_cmdq_dispatch_req(struct request_queue *q)
  * on any queue on this host, and attempt to issue it.  This may
  * not be the queue we were asked to process.
  */
-static void mmc_request_fn(struct request_queue *q)
+static void mmc_queue_kick(struct mmc_queue *mq)
 {
-	struct mmc_queue *mq = q->queuedata;
-	struct request *req;
 	unsigned long flags;
 	struct mmc_context_info *cntx;
 
-	if (!mq) {
-		while ((req = blk_fetch_request(q)) != NULL) {
-			req->cmd_flags |= REQ_QUIET;
-			__blk_end_request_all(req, -EIO);
-		}
-		return;
-	}
-
 	cntx = &mq->card->host->context_info;
 	if (!mq->mqrq_cur->req && mq->mqrq_prev->req) {
 		/*
@@ -245,6 +286,222 @@ static void mmc_request_fn(struct request_queue *q)
 		wake_up_process(mq->thread);
 }
 
+static void mmc_request_fn(struct request_queue *q)
+{
+	struct mmc_queue *mq = q->queuedata;
+	struct request *req;
+
+	if (!mq) {
+		while ((req = blk_fetch_request(q)) != NULL) {
+			req->cmd_flags |= REQ_QUIET;
+			__blk_end_request_all(req, -EIO);
+		}
+		return;
+	}
+
+	mmc_queue_kick(mq);
+}
+
+#ifdef CONFIG_MMC_BLOCK_MQ
+/*
+ * blk-mq submission
+ *
+ * The software queues of blk-mq take the place of the elevator and of the
+ * queue lock every submitter used to contend on. Dispatched requests are
+ * queued for mmcqd, which keeps issuing them with the same asynchronous
+ * request pipelining as in legacy mode.
+ *
+ * All queues of a card, one per partition, share one tag set, so that the
+ * partitions compete for the same slots the card has.
+ */
+struct mmc_mq_tag_set {
+	struct list_head	list;
+	struct mmc_card		*card;	/* NULL once the card is removed */
+	struct blk_mq_tag_set	set;
+	int			users;
+};
+
+static LIST_HEAD(mmc_mq_tag_sets);
+static DEFINE_MUTEX(mmc_mq_tag_sets_lock);
+
+static int mmc_mq_queue_rq(struct blk_mq_hw_ctx *hctx,
+			   const struct blk_mq_queue_data *bd)
+{
+	struct request_queue *q = hctx->queue;
+	struct mmc_queue *mq = q->queuedata;
+	struct request *req = bd->rq;
+	unsigned long flags;
+
+	if (!mq || mmc_prep_request(q, req) != BLKPREP_OK) {
+		req->cmd_flags |= REQ_QUIET;
+		return BLK_MQ_RQ_QUEUE_ERROR;
+	}
+
+	blk_mq_start_request(req);
+
+	spin_lock_irqsave(&mq->mq_lock, flags);
+	list_add_tail(&req->queuelist, &mq->mq_list);
+	spin_unlock_irqrestore(&mq->mq_lock, flags);
+
+	/* one wake up for the whole batch blk-mq is dispatching */
+	if (bd->last)
+		mmc_queue_kick(mq);
+
+	return BLK_MQ_RQ_QUEUE_OK;
+}
+
+/*
+ * Requests are completed by mmcqd, there is nothing to reap here. Polling
+ * still spares the waiter the sleep and the wake up, blk_poll() returns
+ * as soon as the completion marks it running.
+ */
+static int mmc_mq_poll(struct blk_mq_hw_ctx *hctx, unsigned int tag)
+{
+	return 0;
+}
+
+static struct blk_mq_ops mmc_mq_ops = {
+	.queue_rq	= mmc_mq_queue_rq,
+	.map_queue	= blk_mq_map_queue,
+	.poll		= mmc_mq_poll,
+};
+
+static struct mmc_mq_tag_set *mmc_mq_get_tag_set(struct mmc_card *card)
+{
+	struct mmc_mq_tag_set *ts;
+
+	mutex_lock(&mmc_mq_tag_sets_lock);
+	list_for_each_entry(ts, &mmc_mq_tag_sets, list)
+		if (ts->card == card)
+			goto found;
+
+	ts = kzalloc(sizeof(*ts), GFP_KERNEL);
+	if (!ts)
+		goto out;
+
+	ts->card = card;
+	ts->set.ops = &mmc_mq_ops;
+	ts->set.nr_hw_queues = 1;
+	ts->set.queue_depth = card->ext_csd.cmdq_support ?
+			      card->ext_csd.cmdq_depth : MMC_MQ_QUEUE_DEPTH;
+	ts->set.numa_node = NUMA_NO_NODE;
+	ts->set.flags = BLK_MQ_F_SHOULD_MERGE | BLK_MQ_F_SG_MERGE;
+	if (blk_mq_alloc_tag_set(&ts->set)) {
+		kfree(ts);
+		ts = NULL;
+		goto out;
+	}
+	list_add(&ts->list, &mmc_mq_tag_sets);
+found:
+	ts->users++;
+out:
+	mutex_unlock(&mmc_mq_tag_sets_lock);
+
+	return ts;
+}
+
+/* Called once the queue using @ts has been cleaned up */
+static void mmc_mq_put_tag_set(struct mmc_mq_tag_set *ts)
+{
+	mutex_lock(&mmc_mq_tag_sets_lock);
+	if (--ts->users) {
+		ts = NULL;
+	} else {
+		list_del(&ts->list);
+	}
+	mutex_unlock(&mmc_mq_tag_sets_lock);
+
+	if (ts) {
+		blk_mq_free_tag_set(&ts->set);
+		kfree(ts);
+	}
+}
+
+static struct request_queue *mmc_mq_init_queue(struct mmc_queue *mq,
+					       struct mmc_card *card)
+{
+	struct request_queue *q;
+
+	INIT_LIST_HEAD(&mq->mq_list);
+	spin_lock_init(&mq->mq_lock);
+	mq->mq_tag_set = NULL;
+
+	if (!use_blk_mq)
+		return NULL;
+
+	mq->mq_tag_set = mmc_mq_get_tag_set(card);
+	if (!mq->mq_tag_set)
+		return NULL;
+
+	q = blk_mq_init_queue(&mq->mq_tag_set->set);
+	if (IS_ERR(q)) {
+		pr_warn("%s: blk-mq unavailable (%ld), using legacy queue\n",
+			mmc_card_name(card), PTR_ERR(q));
+		mmc_mq_put_tag_set(mq->mq_tag_set);
+		mq->mq_tag_set = NULL;
+		return NULL;
+	}
+
+	return q;
+}
+
+/* Fail whatever blk-mq dispatched that mmcqd will no longer issue */
+static void mmc_mq_flush_list(struct mmc_queue *mq)
+{
+	struct request *req;
+	unsigned long flags;
+	LIST_HEAD(list);
+
+	spin_lock_irqsave(&mq->mq_lock, flags);
+	list_splice_init(&mq->mq_list, &list);
+	spin_unlock_irqrestore(&mq->mq_lock, flags);
+
+	while (!list_empty(&list)) {
+		req = list_first_entry(&list, struct request, queuelist);
+		list_del_init(&req->queuelist);
+		req->cmd_flags |= REQ_QUIET;
+		blk_mq_end_request(req, -EIO);
+	}
+}
+#else
+static inline struct request_queue *mmc_mq_init_queue(struct mmc_queue *mq,
+						      struct mmc_card *card)
+{
+	return NULL;
+}
+static inline void mmc_mq_flush_list(struct mmc_queue *mq) {}
+#endif
+
+static void mmc_queue_stop(struct mmc_queue *mq)
+{
+	struct request_queue *q = mq->queue;
+	unsigned long flags;
+
+	if (q->mq_ops) {
+		blk_mq_stop_hw_queues(q);
+		return;
+	}
+
+	spin_lock_irqsave(q->queue_lock, flags);
+	blk_stop_queue(q);
+	spin_unlock_irqrestore(q->queue_lock, flags);
+}
+
+static void mmc_queue_start(struct mmc_queue *mq)
+{
+	struct request_queue *q = mq->queue;
+	unsigned long flags;
+
+	if (q->mq_ops) {
+		blk_mq_start_stopped_hw_queues(q, true);
+		return;
+	}
+
+	spin_lock_irqsave(q->queue_lock, flags);
+	blk_start_queue(q);
+	spin_unlock_irqrestore(q->queue_lock, flags);
+}
+
 static struct scatterlist *mmc_alloc_sg(int sg_len, int *err)
 {
 	struct scatterlist *sg;
@@ -361,7 +618,9 @@ int mmc_init_queue(struct mmc_queue *mq, struct mmc_card *card,
 		}
 	}
 
-	mq->queue = blk_init_queue(mmc_request_fn, lock);
+	mq->queue = mmc_mq_init_queue(mq, card);
+	if (!mq->queue)
+		mq->queue = blk_init_queue(mmc_request_fn, lock);
 	if (!mq->queue)
 		return -ENOMEM;
 
@@ -458,7 +717,7 @@ int mmc_init_queue(struct mmc_queue *mq, struct mmc_card *card,
 	mq->thread = kthread_run(mmc_queue_thread, mq, "mmcqd/%d%s",
 		host->index, subname ? subname : "");
 
-	if (mmc_card_sd(card)) {
+	if (mmc_card_sd(card) && !mq->queue->mq_ops) {
 		/* decrease max # of requests to 32. The goal of this tunning is
 		 * reducing the time for draining elevator when elevator_switch
 		 * function is called. It is effective for slow external sdcard.
@@ -504,6 +763,7 @@ int mmc_init_queue(struct mmc_queue *mq, struct mmc_card *card,
 	mqrq_prev->bounce_buf = NULL;
 
 	blk_cleanup_queue(mq->queue);
+	mmc_release_queue(mq);
 	return ret;
 }
 
@@ -521,10 +781,22 @@ void mmc_cleanup_queue(struct mmc_queue *mq)
 	kthread_stop(mq->thread);
 
 	/* Empty the queue */
-	spin_lock_irqsave(q->queue_lock, flags);
-	q->queuedata = NULL;
-	blk_start_queue(q);
-	spin_unlock_irqrestore(q->queue_lock, flags);
+	if (q->mq_ops) {
+		q->queuedata = NULL;
+		mmc_mq_flush_list(mq);
+		blk_mq_start_stopped_hw_queues(q, false);
+#ifdef CONFIG_MMC_BLOCK_MQ
+		/* a new card at the same address must get its own tag set */
+		mutex_lock(&mmc_mq_tag_sets_lock);
+		mq->mq_tag_set->card = NULL;
+		mutex_unlock(&mmc_mq_tag_sets_lock);
+#endif
+	} else {
+		spin_lock_irqsave(q->queue_lock, flags);
+		q->queuedata = NULL;
+		blk_start_queue(q);
+		spin_unlock_irqrestore(q->queue_lock, flags);
+	}
 
 	kfree(mqrq_cur->bounce_sg);
 	mqrq_cur->bounce_sg = NULL;
@@ -548,6 +820,17 @@ void mmc_cleanup_queue(struct mmc_queue *mq)
 }
 EXPORT_SYMBOL(mmc_cleanup_queue);
 
+/* Drop what the queue still holds once blk_cleanup_queue() is done with it */
+void mmc_release_queue(struct mmc_queue *mq)
+{
+#ifdef CONFIG_MMC_BLOCK_MQ
+	if (mq->mq_tag_set) {
+		mmc_mq_put_tag_set(mq->mq_tag_set);
+		mq->mq_tag_set = NULL;
+	}
+#endif
+}
+
 int mmc_packed_init(struct mmc_queue *mq, struct mmc_card *card)
 {
 	struct mmc_queue_req *mqrq_cur = &mq->mqrq[0];
@@ -791,9 +1074,7 @@ int mmc_queue_suspend(struct mmc_queue *mq, int wait)
 	}
 
 	if (!(test_and_set_bit(MMC_QUEUE_SUSPENDED, &mq->flags))) {
-		spin_lock_irqsave(q->queue_lock, flags);
-		blk_stop_queue(q);
-		spin_unlock_irqrestore(q->queue_lock, flags);
+		mmc_queue_stop(mq);
 
 		rc = down_trylock(&mq->thread_sem);
 		if (rc && !wait) {
@@ -802,10 +1083,15 @@ int mmc_queue_suspend(struct mmc_queue *mq, int wait)
 			 * suspend because mmcqd thread is processing requests.
 			 */
 			clear_bit(MMC_QUEUE_SUSPENDED, &mq->flags);
-			spin_lock_irqsave(q->queue_lock, flags);
-			blk_start_queue(q);
-			spin_unlock_irqrestore(q->queue_lock, flags);
+			mmc_queue_start(mq);
 			rc = -EBUSY;
+		} else if (wait && q->mq_ops) {
+			blk_set_queue_dying(q);
+			mmc_mq_flush_list(mq);
+			if (rc) {
+				down(&mq->thread_sem);
+				rc = 0;
+			}
 		} else if (wait) {
 			printk("%s: mq->flags: %lx, q->queue_flags: 0x%lx, "\
 					"q->in_flight (%d, %d) \n",
@@ -847,16 +1133,13 @@ void mmc_queue_resume(struct mmc_queue *mq)
 {
 	struct request_queue *q = mq->queue;
 	struct mmc_card *card = mq->card;
-	unsigned long flags;
 
 	if (test_and_clear_bit(MMC_QUEUE_SUSPENDED, &mq->flags)) {
 
 		if (!(card->cmdq_init && blk_queue_tagged(q)))
 			up(&mq->thread_sem);
 
-		spin_lock_irqsave(q->queue_lock, flags);
-		blk_start_queue(q);
-		spin_unlock_irqrestore(q->queue_lock, flags);
+		mmc_queue_start(mq);
 	}
 }
 
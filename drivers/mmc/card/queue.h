@@ -1,10 +1,13 @@
 #ifndef MMC_QUEUE_H
 #define MMC_QUEUE_H
 
+#include <linux/blk-mq.h>
+
 #define MMC_REQ_SPECIAL_MASK	(REQ_DISCARD | REQ_FLUSH)
 
 struct request;
 struct task_struct;
+struct mmc_mq_tag_set;
 
 struct mmc_blk_request {
 	struct mmc_request	mrq;
@@ -77,6 +80,13 @@ struct mmc_queue {
 	struct list_head eh_mrq;
 	spinlock_t	eh_lock;
 
+#ifdef CONFIG_MMC_BLOCK_MQ
+	/* requests dispatched by blk-mq, waiting for mmcqd */
+	struct list_head	mq_list;
+	spinlock_t		mq_lock;
+	struct mmc_mq_tag_set	*mq_tag_set;
+#endif
+
 #ifdef CONFIG_MMC_SIMULATE_MAX_SPEED
 	atomic_t max_write_speed;
 	atomic_t max_read_speed;
@@ -90,6 +100,7 @@ struct mmc_queue {
 extern int mmc_init_queue(struct mmc_queue *, struct mmc_card *, spinlock_t *,
 			  const char *, int);
 extern void mmc_cleanup_queue(struct mmc_queue *);
+extern void mmc_release_queue(struct mmc_queue *);
 extern int mmc_queue_suspend(struct mmc_queue *, int);
 extern void mmc_queue_resume(struct mmc_queue *);
 
@@ -105,4 +116,34 @@ extern int mmc_access_rpmb(struct mmc_queue *);
 
 extern int mmc_cmdq_init(struct mmc_queue *mq, struct mmc_card *card);
 extern void mmc_cmdq_clean(struct mmc_queue *mq, struct mmc_card *card);
+
+extern struct request *mmc_queue_fetch(struct mmc_queue *);
+extern void mmc_queue_requeue(struct mmc_queue *, struct request *);
+
+/*
+ * blk_end_request() and blk_end_request_all() for both legacy and blk-mq
+ * queues. Returns true if part of @req is still pending.
+ */
+static inline bool mmc_blk_end_request(struct request *req, int error,
+				       unsigned int nr_bytes)
+{
+	if (!req->q->mq_ops)
+		return blk_end_request(req, error, nr_bytes);
+
+	if (blk_update_request(req, error, nr_bytes))
+		return true;
+
+	__blk_mq_end_request(req, error);
+	return false;
+}
+
+static inline void mmc_blk_end_request_all(struct request *req, int error)
+{
+	if (!req->q->mq_ops) {
+		blk_end_request_all(req, error);
+		return;
+	}
+
+	WARN_ON(mmc_blk_end_request(req, error, blk_rq_bytes(req)));
+}
 #endif
@@ -16,6 +16,7 @@
 #include <linux/mmc/host.h>
 #include <linux/mmc/dw_mmc.h>
 #include <linux/mmc/mmc.h>
+#include <linux/fscrypt.h>
 
 #include "dw_mmc.h"
 #include "dw_mmc-exynos.h"
@@ -362,6 +363,44 @@ bypass_out:
 	return ret;
 }
 
+#ifdef CONFIG_FS_ENCRYPTION_INLINE_CRYPT
+/*
+ * fscrypt files in AES-256-XTS get the same per-file setup as ext4's
+ * private encryption, exynos_mmc_fmp_file_cfg() picks it up per page.
+ */
+static int exynos_mmc_fmp_setup_key(struct address_space *mapping, u8 mode,
+				    const u8 *key, unsigned int keysize)
+{
+	if (mode != FS_ENCRYPTION_MODE_AES_256_XTS ||
+	    keysize != FMP_XTS_MAX_KEY_SIZE)
+		return -EOPNOTSUPP;
+
+	memcpy(mapping->key, key, keysize);
+	mapping->key_length = keysize;
+	mapping->private_algo_mode = EXYNOS_FMP_ALGO_MODE_AES_XTS;
+	mapping->sensitive_data_index = 0;
+	/* last, it is what tells the filesystem to skip software crypto */
+	smp_wmb();
+	mapping->private_enc_mode = EXYNOS_FMP_FILE_ENC;
+
+	return 0;
+}
+
+static void exynos_mmc_fmp_clear_key(struct address_space *mapping)
+{
+	mapping->private_enc_mode = 0;
+	mapping->private_algo_mode = EXYNOS_FMP_BYPASS_MODE;
+	memzero_explicit(mapping->key, sizeof(mapping->key));
+	mapping->key_length = 0;
+}
+
+static const struct fscrypt_inline_ops exynos_mmc_fmp_inline_ops = {
+	.name = "exynos-mmc-fmp",
+	.setup_key = exynos_mmc_fmp_setup_key,
+	.clear_key = exynos_mmc_fmp_clear_key,
+};
+#endif
+
 int exynos_mmc_fmp_host_set_device(struct platform_device *host_pdev,
 				struct platform_device *pdev,
 				struct exynos_fmp_variant_ops *fmp_vops)
@@ -389,6 +428,11 @@ int exynos_mmc_fmp_host_set_device(struct platform_device *host_pdev,
 	priv->fmp.pdev = pdev;
 	priv->fmp.vops = fmp_vops;
 
+#ifdef CONFIG_FS_ENCRYPTION_INLINE_CRYPT
+	/* the first host with FMP does it for all, as with ext4 */
+	fscrypt_register_inline_crypt(&exynos_mmc_fmp_inline_ops);
+#endif
+
 	return 0;
 }
 EXPORT_SYMBOL(exynos_mmc_fmp_host_set_device);
@@ -70,6 +70,14 @@
 /* Each descriptor can transfer up to 4KB of data in chained mode */
 #define DW_MCI_DESC_DATA_LENGTH	0x1000
 
+/*
+ * The 64-bit descriptor ring is MMC_DW_IDMAC_MULTIPLIER times as long as the
+ * longest chain a request can need. Two sets of ring_size descriptors are
+ * used alternately, so that the chain of the next request can be built while
+ * the current one is still being transferred.
+ */
+#define DW_MCI_DESC_SETS	2
+
 static bool dw_mci_reset(struct dw_mci *host);
 
 static int dw_mci_card_busy(struct mmc_host *mmc);
@@ -331,6 +339,30 @@ static ssize_t dw_mci_transferred_cnt_show(struct device *dev,
 
 DEVICE_ATTR(trans_count, 0444, dw_mci_transferred_cnt_show, NULL);
 
+static ssize_t dw_mci_xfer_gap_show(struct device *dev,
+		struct device_attribute *attr,
+		char *buf)
+{
+	struct mmc_host *mmc = container_of(dev, struct mmc_host, class_dev);
+	struct dw_mci_slot *slot = mmc_priv(mmc);
+	unsigned long count, prebuilt;
+	u64 gap_ns;
+
+	spin_lock_bh(&slot->host->lock);
+	count = slot->gap_count;
+	prebuilt = slot->desc_prebuilt_count;
+	gap_ns = slot->gap_ns;
+	spin_unlock_bh(&slot->host->lock);
+
+	return sprintf(buf, "gaps: %lu\ntotal_us: %llu\navg_us: %llu\n"
+			"prebuilt: %lu\nrebuilt: %lu\n",
+			count, div_u64(gap_ns, NSEC_PER_USEC),
+			count ? div64_u64(gap_ns, (u64)count * NSEC_PER_USEC) : 0,
+			prebuilt, count - prebuilt);
+}
+
+DEVICE_ATTR(xfer_gap, 0444, dw_mci_xfer_gap_show, NULL);
+
 static void dw_mci_transferred_cnt_init(struct dw_mci *host, struct mmc_host *mmc)
 {
 	int sysfs_err = 0;
@@ -338,6 +370,9 @@ static void dw_mci_transferred_cnt_init(struct dw_mci *host, struct mmc_host *mm
 			&(dev_attr_trans_count.attr));
 	pr_info("%s: trans_count: %s.....\n", __func__,
 			sysfs_err ? "failed" : "successed");
+
+	if (sysfs_create_file(&mmc->class_dev.kobj, &dev_attr_xfer_gap.attr))
+		pr_warn("%s: failed to create xfer_gap\n", mmc_hostname(mmc));
 }
 
 bool dw_mci_fifo_reset(struct device *dev, struct dw_mci *host);
@@ -757,6 +792,9 @@ static void dw_mci_dmac_complete_dma(void *arg)
 	const struct dw_mci_drv_data *drv_data = host->drv_data;
 	struct idmac_desc_64addr *desc = host->sg_cpu;
 
+	if (host->dma_64bit_address == 1 && host->cur_slot)
+		desc += host->cur_slot->desc_set * host->ring_size;
+
 	dev_vdbg(host->dev, "DMA complete\n");
 
 	if ((host->use_dma == TRANS_MODE_EDMAC) &&
@@ -788,8 +826,23 @@ static void dw_mci_dmac_complete_dma(void *arg)
 	}
 }
 
-static void dw_mci_translate_sglist(struct dw_mci *host, struct mmc_data *data,
-				    unsigned int sg_len)
+/* Whether the chain built for the current data has to set up FMP */
+static bool dw_mci_desc_crypto(struct dw_mci *host)
+{
+	return host->cmd != NULL &&
+		(host->cmd->opcode == MMC_READ_SINGLE_BLOCK ||
+		 host->cmd->opcode == MMC_READ_MULTIPLE_BLOCK ||
+		 host->cmd->opcode == MMC_WRITE_BLOCK ||
+		 host->cmd->opcode == MMC_WRITE_MULTIPLE_BLOCK);
+}
+
+/*
+ * Build the descriptor chain of @data in descriptor set @set, which is
+ * always 0 with 32-bit descriptors.
+ */
+static int dw_mci_translate_sglist(struct dw_mci *host, struct mmc_data *data,
+				   unsigned int sg_len, unsigned int set,
+				   bool crypto)
 {
 	unsigned int desc_len;
 	int i, ret;
@@ -799,7 +852,9 @@ static void dw_mci_translate_sglist(struct dw_mci *host, struct mmc_data *data,
 		struct idmac_desc_64addr *desc_first, *desc_last, *desc;
 		int sector_offset = 0;
 
-		desc_first = desc_last = desc = host->sg_cpu;
+		desc_first = (struct idmac_desc_64addr *)host->sg_cpu +
+			     set * host->ring_size;
+		desc_last = desc = desc_first;
 
 		for (i = 0; i < sg_len; i++) {
 			unsigned int length = sg_dma_len(&data->sg[i]);
@@ -826,11 +881,7 @@ static void dw_mci_translate_sglist(struct dw_mci *host, struct mmc_data *data,
 				desc->des4 = mem_addr & 0xffffffff;
 				desc->des5 = mem_addr >> 32;
 
-				if ((host->cmd != NULL) &&
-					((host->cmd->opcode == MMC_READ_SINGLE_BLOCK) ||
-					(host->cmd->opcode == MMC_READ_MULTIPLE_BLOCK) ||
-					(host->cmd->opcode == MMC_WRITE_BLOCK) ||
-					(host->cmd->opcode == MMC_WRITE_MULTIPLE_BLOCK))) {
+				if (crypto) {
 					if (drv_data->crypto_engine_cfg) {
 						ret = drv_data->crypto_engine_cfg(host, desc, data,
 								sg_page(&data->sg[i]), sector_offset, false);
@@ -838,7 +889,7 @@ static void dw_mci_translate_sglist(struct dw_mci *host, struct mmc_data *data,
 							dev_err(host->dev,
 									"%s: failed to configure crypto engine (%d)\n",
 									__func__, ret);
-							return;
+							return ret;
 						}
 						sector_offset += desc_len / DW_MMC_SECTOR_SIZE;
 					}
@@ -907,13 +958,90 @@ static void dw_mci_translate_sglist(struct dw_mci *host, struct mmc_data *data,
 	}
 
 	wmb(); /* drain writebuffer */
+
+	return 0;
+}
+
+/*
+ * Called from pre_req() while the previous request may still be running:
+ * build the chain of @data in the descriptor set that request is not using.
+ * The chain is built without FMP, and only used if the request still does not
+ * need FMP when it is started; otherwise, and whenever the ring has been
+ * reinitialized in between, the chain is built again at start time.
+ */
+static void dw_mci_idmac_prebuild(struct dw_mci_slot *slot,
+				  struct mmc_data *data)
+{
+	struct dw_mci *host = slot->host;
+	unsigned int set;
+
+	if (host->use_dma != TRANS_MODE_IDMAC || host->dma_64bit_address != 1 ||
+	    host->num_slots != 1)
+		return;
+
+	spin_lock_bh(&host->lock);
+	set = (slot->desc_set + 1) % DW_MCI_DESC_SETS;
+	if (!dw_mci_translate_sglist(host, data, data->host_cookie, set,
+				     false)) {
+		slot->desc_prebuilt_set = set;
+		slot->desc_prebuilt = data;
+	}
+	spin_unlock_bh(&host->lock);
+}
+
+/* Whether the chain built by dw_mci_idmac_prebuild() can be used for @data */
+static bool dw_mci_idmac_prebuilt(struct dw_mci *host, struct mmc_data *data)
+{
+	struct dw_mci_slot *slot = host->cur_slot;
+
+	return host->use_dma == TRANS_MODE_IDMAC && slot &&
+		slot->desc_prebuilt == data && !dw_mci_desc_crypto(host);
+}
+
+/*
+ * Account the dead time between the end of the previous transfer and the
+ * start of @data, if pre_req() had prepared it, i.e. if it was already
+ * waiting when the previous transfer ended.
+ */
+static void dw_mci_account_xfer_gap(struct dw_mci *host, struct mmc_data *data)
+{
+	struct dw_mci_slot *slot = host->cur_slot;
+
+	if (!slot->xfer_end_ns)
+		return;
+
+	if (data->host_cookie) {
+		slot->gap_ns += ktime_get_ns() - slot->xfer_end_ns;
+		slot->gap_count++;
+		if (dw_mci_idmac_prebuilt(host, data))
+			slot->desc_prebuilt_count++;
+	}
+	slot->xfer_end_ns = 0;
 }
 
 static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
 {
+	struct dw_mci_slot *slot = host->cur_slot;
+	unsigned int set = 0;
 	u32 temp;
 
-	dw_mci_translate_sglist(host, host->data, sg_len);
+	if (dw_mci_idmac_prebuilt(host, host->data)) {
+		set = slot->desc_prebuilt_set;
+		mci_writel(host, IDSTS64, IDMAC_INT_CLR);
+	} else {
+		dw_mci_translate_sglist(host, host->data, sg_len, 0,
+					dw_mci_desc_crypto(host));
+	}
+	slot->desc_prebuilt = NULL;
+	slot->desc_set = set;
+
+	if (host->dma_64bit_address == 1) {
+		dma_addr_t addr = host->sg_dma + set * host->ring_size *
+				  sizeof(struct idmac_desc_64addr);
+
+		mci_writel(host, DBADDRL, addr & 0xffffffff);
+		mci_writel(host, DBADDRU, (u64)addr >> 32);
+	}
 
 	/* Select IDMAC interface */
 	temp = mci_readl(host, CTRL);
@@ -938,6 +1066,11 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 {
 	int i;
 
+	/* relinking the ring below wipes out any chain built ahead */
+	for (i = 0; i < host->num_slots; i++)
+		if (host->slot[i])
+			host->slot[i]->desc_prebuilt = NULL;
+
 	if (host->dma_64bit_address == 1) {
 		struct idmac_desc_64addr *p;
 		/* Number of descriptors in the ring buffer */
@@ -1209,6 +1342,8 @@ static void dw_mci_pre_req(struct mmc_host *mmc,
 
 	if (dw_mci_pre_dma_transfer(slot->host, mrq->data, 1) < 0)
 		data->host_cookie = 0;
+	else
+		dw_mci_idmac_prebuild(slot, data);
 }
 
 static void dw_mci_post_req(struct mmc_host *mmc,
@@ -1221,6 +1356,11 @@ static void dw_mci_post_req(struct mmc_host *mmc,
 	if (!slot->host->use_dma || !data)
 		return;
 
+	spin_lock_bh(&slot->host->lock);
+	if (slot->desc_prebuilt == data)
+		slot->desc_prebuilt = NULL;
+	spin_unlock_bh(&slot->host->lock);
+
 	if (data->host_cookie)
 		dma_unmap_sg(slot->host->dev,
 			     data->sg,
@@ -1333,8 +1473,12 @@ static int dw_mci_submit_data_dma(struct dw_mci *host, struct mmc_data *data)
 	if (!host->use_dma)
 		return -ENODEV;
 
+	dw_mci_account_xfer_gap(host, data);
+
 	if (host->use_dma && host->dma_ops->init && host->dma_ops->reset) {
-		host->dma_ops->init(host);
+		/* keep a chain built by pre_req() */
+		if (!dw_mci_idmac_prebuilt(host, data))
+			host->dma_ops->init(host);
 		host->dma_ops->reset(host);
 	}
 
@@ -2193,6 +2337,9 @@ static void dw_mci_request_end(struct dw_mci *host, struct mmc_request *mrq)
 
 	del_timer(&host->timer);
 
+	if (mrq->data && !mrq->data->error)
+		host->cur_slot->xfer_end_ns = ktime_get_ns();
+
 	host->req_state = DW_MMC_REQ_IDLE;
 
 	dw_mci_debug_req_log(host, mrq, STATE_REQ_END, 0);
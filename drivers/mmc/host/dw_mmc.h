@@ -310,6 +310,15 @@ extern int dw_mci_resume(struct dw_mci *host);
  * @id: Number of this slot.
  * @sdio_id: Number of this slot in the SDIO interrupt registers.
  * @last_detect_state: Most recently observed card detect state.
+ * @desc_prebuilt: Data whose IDMAC descriptor chain pre_req() already built,
+ *	or NULL. Protected by host->lock.
+ * @desc_prebuilt_set: Descriptor set holding the chain of @desc_prebuilt.
+ * @desc_set: Descriptor set used by the transfer currently running.
+ * @xfer_end_ns: When the last data transfer ended, 0 once accounted.
+ * @gap_ns: Total time between the end of a transfer and the start of the
+ *	next one, for those already prepared by pre_req().
+ * @gap_count: Number of gaps in @gap_ns.
+ * @desc_prebuilt_count: Gaps whose transfer started on a prebuilt chain.
  */
 struct dw_mci_slot {
 	struct mmc_host		*mmc;
@@ -332,6 +341,15 @@ struct dw_mci_slot {
 	int			id;
 	int			sdio_id;
 	int			last_detect_state;
+
+	struct mmc_data		*desc_prebuilt;
+	unsigned int		desc_prebuilt_set;
+	unsigned int		desc_set;
+
+	u64			xfer_end_ns;
+	u64			gap_ns;
+	unsigned long		gap_count;
+	unsigned long		desc_prebuilt_count;
 };
 
 /**
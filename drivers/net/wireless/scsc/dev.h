@@ -130,6 +130,8 @@ static const u16 slsi_rates_table[3][2][10] = {
  * This timeout value can be fine-tuned based on the test results.
  */
 #define SLSI_RX_WAKELOCK_TIME (1000)
+/* Frames held by GRO are flushed to the stack at least this often */
+#define SLSI_RX_GRO_BATCH 64
 #define MAX_BA_BUFFER_SIZE 64
 #define NUM_BA_SESSIONS_PER_PEER 8
 #define SLSI_NCHO_MAX_CHANNEL_LIST 20
@@ -824,6 +826,15 @@ struct netdev_vif {
 	struct slsi_skb_work        rx_mlme;
 #ifdef CONFIG_SCSC_WLAN_RX_NAPI
 	struct slsi_napi            napi;
+#endif
+#ifdef CONFIG_SCSC_WLAN_RX_GRO
+	/* Only a GRO context, never scheduled: the rx_data work feeds and
+	 * flushes it with vif_mutex held
+	 */
+	struct napi_struct          rx_gro_napi;
+	u32                         rx_gro_held;
+	u64                         rx_gro_packets;
+	u64                         rx_gro_merged;
 #endif
 	u16                         ifnum;
 	enum nl80211_iftype         iftype;
@@ -1304,7 +1315,11 @@ struct llc_snap_hdr {
 #ifdef CONFIG_SCSC_WLAN_RX_NAPI
 int slsi_rx_data_napi(struct slsi_dev *sdev, struct net_device *dev, struct sk_buff *skb, bool from_ba);
 #endif
+u64 slsi_rx_data_cpu_packets(int cpu);
 void slsi_rx_data_deliver_skb(struct slsi_dev *sdev, struct net_device *dev, struct sk_buff *skb);
+#ifdef CONFIG_SCSC_WLAN_RX_GRO
+int slsi_rx_gro_poll(struct napi_struct *napi, int budget);
+#endif
 void slsi_rx_dbg_sap_work(struct work_struct *work);
 void slsi_rx_netdev_data_work(struct work_struct *work);
 void slsi_rx_netdev_mlme_work(struct work_struct *work);
@@ -27,10 +27,36 @@ static bool hip4_system_wq;
 module_param(hip4_system_wq, bool, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(hip4_system_wq, "Use system wq instead of named workqueue. (default: N)");
 
+/* Above this rate of to-host entries the bottom half stops taking an
+ * interrupt for every batch and polls the queues from a timer instead,
+ * until the rate halves or a poll finds nothing to do. 0 disables it.
+ */
+static uint hip4_poll_enter_fps = 20000;
+module_param(hip4_poll_enter_fps, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(hip4_poll_enter_fps, "To-host entries per second above which hip4 polls instead of taking interrupts, 0 to disable (default: 20000)");
+
+static uint hip4_poll_interval_us = 500;
+module_param(hip4_poll_interval_us, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(hip4_poll_interval_us, "Interval between hip4 polls in microseconds (default: 500)");
+
+static uint hip4_poll_budget = 64;
+module_param(hip4_poll_budget, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(hip4_poll_budget, "Maximum data frames processed per hip4 poll (default: 64)");
+
+#define HIP4_RATE_WINDOW_NS	(100 * NSEC_PER_MSEC)
+
 static int max_buffered_frames = 10000;
 module_param(max_buffered_frames, int, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(max_buffered_frames, "Maximum number of frames to buffer in the driver");
 
+static uint hip4_rx_pool_pages = 64;
+module_param(hip4_rx_pool_pages, uint, S_IRUGO);
+MODULE_PARM_DESC(hip4_rx_pool_pages, "Pages per cpu recycled for RX skbs, 0 to use the netdev fragment cache (default: 64)");
+
+static bool hip4_summary_enable = true;
+module_param(hip4_summary_enable, bool, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(hip4_summary_enable, "Keep the always-on latency and batch histograms of /proc/driver/hip4/summary (default: Y)");
+
 static ktime_t intr_received;
 static ktime_t bh_init;
 static ktime_t bh_end;
@@ -323,7 +349,20 @@ static int hip4_proc_show(struct seq_file *m, void *v)
 	/* HIP statistics */
 	seq_printf(m, "HIP IRQs: %u\n", atomic_read(&hip->hip_priv->stats.irqs));
 	seq_printf(m, "HIP IRQs spurious: %u\n", atomic_read(&hip->hip_priv->stats.spurious_irqs));
-	seq_printf(m, "FW debug-inds: %u\n\n", atomic_read(&sdev->debug_inds));
+	seq_printf(m, "FW debug-inds: %u\n", atomic_read(&sdev->debug_inds));
+	seq_printf(m, "RX frames: %llu\n", hip->hip_priv->stats.rx_frames);
+	seq_printf(m, "RX bytes copied from mbulks: %llu\n", hip->hip_priv->stats.rx_copied_bytes);
+	seq_printf(m, "TX data frames: %llu\n", hip->hip_priv->stats.tx_frames);
+	seq_printf(m, "TX data doorbells: %llu\n", hip->hip_priv->stats.tx_doorbells);
+	if (hip->hip_priv->stats.tx_doorbells)
+		seq_printf(m, "TX frames per doorbell (x100): %llu\n",
+			   div64_u64(hip->hip_priv->stats.tx_frames * 100, hip->hip_priv->stats.tx_doorbells));
+	seq_printf(m, "HIP IRQs/s: %u\n", hip->hip_priv->stats.irq_rate);
+	seq_printf(m, "HIP entries/s: %u\n", hip->hip_priv->stats.frame_rate);
+	seq_printf(m, "HIP polling: %s (entered %u times, %llu ms)\n",
+		   hip->hip_priv->polling ? "on" : "off", hip->hip_priv->stats.polls,
+		   div_u64(hip->hip_priv->stats.poll_ns, NSEC_PER_MSEC));
+	seq_puts(m, "\n");
 
 	seq_puts(m, "Queue\tIndex\tFrames\n");
 	seq_puts(m, "-----\t-----\t------\n");
@@ -351,6 +390,124 @@ static const struct file_operations hip4_procfs_stats_fops = {
 };
 #endif
 
+/* host_tag of a returned MA-UNITDATA.REQ, read straight out of the mbulk
+ * as the profiling round-trip does: there is no room for it in the mbulk
+ * descriptor
+ */
+static inline u16 hip4_fb_host_tag(struct mbulk *m)
+{
+	u8 *get_host_tag = (u8 *)m;
+
+	return get_host_tag[37] << 8 | get_host_tag[36];
+}
+
+static inline void hip4_summary_tx(struct hip4_priv *hip_priv, u16 host_tag)
+{
+	hip_priv->summary_tx_ts[host_tag % HIP4_SUMMARY_TX_TAGS] =
+		((u64)ktime_to_ns(ktime_get()) << 16) | host_tag;
+}
+
+static inline void hip4_summary_tx_done(struct hip4_priv *hip_priv, u16 colour, u16 host_tag)
+{
+	u64 ts = READ_ONCE(hip_priv->summary_tx_ts[host_tag % HIP4_SUMMARY_TX_TAGS]);
+	u64 now = (u64)ktime_to_ns(ktime_get()) << 16;
+	s64 lat;
+
+	if ((u16)ts != host_tag || !(ts >> 16))
+		return;
+	/* both times lose their top 16 bits: the difference does not */
+	lat = (s64)((now - (ts & ~0xffffULL)) >> 16);
+	this_cpu_inc(hip_priv->summary->tx_lat[(colour >> 8) & (HIP4_SUMMARY_TX_Q - 1)]
+		     [hip4_summary_lat_bucket(lat)]);
+}
+
+static inline void hip4_summary_rx(struct hip4_priv *hip_priv, int q)
+{
+	s64 lat = ktime_to_ns(ktime_sub(ktime_get(), hip_priv->summary_rx_sched));
+
+	this_cpu_inc(hip_priv->summary->rx_lat[q][hip4_summary_lat_bucket(lat)]);
+}
+
+static inline void hip4_summary_rx_batch(struct hip4_priv *hip_priv, int q, u32 frames)
+{
+	if (hip_priv->summary && hip4_summary_enable && frames)
+		this_cpu_inc(hip_priv->summary->rx_batch[q][hip4_summary_batch_bucket(frames)]);
+}
+
+static inline void hip4_summary_tx_batch(struct hip4_priv *hip_priv, u32 frames)
+{
+	if (hip_priv->summary && hip4_summary_enable)
+		this_cpu_inc(hip_priv->summary->tx_batch[hip4_summary_batch_bucket(frames)]);
+}
+
+static void hip4_summary_print_hist(struct seq_file *m, const char *name, const u32 *hist, int n)
+{
+	int i;
+
+	seq_printf(m, "%-10s", name);
+	for (i = 0; i < n; i++)
+		seq_printf(m, " %8u", hist[i]);
+	seq_puts(m, "\n");
+}
+
+static int hip4_proc_show_summary(struct seq_file *m, void *v)
+{
+	static const char * const ac_name[HIP4_SUMMARY_TX_Q] = { "tx_be", "tx_bk", "tx_vi", "tx_vo" };
+	struct slsi_hip4 *hip = m->private;
+	struct hip4_summary sum;
+	u32 *dst = (u32 *)&sum;
+	u32 *src;
+	int cpu, q, i;
+
+	if (!hip->hip_priv || !hip->hip_priv->summary) {
+		seq_puts(m, "HIP4 not active\n");
+		return 0;
+	}
+
+	memset(&sum, 0, sizeof(sum));
+	for_each_possible_cpu(cpu) {
+		src = (u32 *)per_cpu_ptr(hip->hip_priv->summary, cpu);
+		for (i = 0; i < sizeof(sum) / sizeof(u32); i++)
+			dst[i] += src[i];
+	}
+
+	seq_printf(m, "%-10s", "lat(us)");
+	seq_printf(m, " %8s", "<1");
+	for (i = 1; i < HIP4_SUMMARY_LAT_BUCKETS; i++)
+		seq_printf(m, " %7u%c", 1U << (i - 1),
+			   i == HIP4_SUMMARY_LAT_BUCKETS - 1 ? '+' : ' ');
+	seq_puts(m, "\n");
+	for (q = 0; q < HIP4_SUMMARY_TX_Q; q++)
+		hip4_summary_print_hist(m, ac_name[q], sum.tx_lat[q], HIP4_SUMMARY_LAT_BUCKETS);
+	hip4_summary_print_hist(m, "rx_ctrl", sum.rx_lat[HIP4_SUMMARY_RX_Q_CTRL], HIP4_SUMMARY_LAT_BUCKETS);
+	hip4_summary_print_hist(m, "rx_dat", sum.rx_lat[HIP4_SUMMARY_RX_Q_DAT], HIP4_SUMMARY_LAT_BUCKETS);
+	seq_puts(m, "\n");
+
+	seq_printf(m, "%-10s", "batch");
+	for (i = 0; i < HIP4_SUMMARY_BATCH_BUCKETS; i++)
+		seq_printf(m, " %7u%c", 1U << i,
+			   i == HIP4_SUMMARY_BATCH_BUCKETS - 1 ? '+' : ' ');
+	seq_puts(m, "\n");
+	hip4_summary_print_hist(m, "tx_dat", sum.tx_batch, HIP4_SUMMARY_BATCH_BUCKETS);
+	hip4_summary_print_hist(m, "rx_ctrl", sum.rx_batch[HIP4_SUMMARY_RX_Q_CTRL], HIP4_SUMMARY_BATCH_BUCKETS);
+	hip4_summary_print_hist(m, "rx_dat", sum.rx_batch[HIP4_SUMMARY_RX_Q_DAT], HIP4_SUMMARY_BATCH_BUCKETS);
+
+	return 0;
+}
+
+static int hip4_proc_summary_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hip4_proc_show_summary, PDE_DATA(inode));
+}
+
+static const struct file_operations hip4_procfs_summary_fops = {
+	.owner   = THIS_MODULE,
+	.open    = hip4_proc_summary_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = single_release,
+};
+
 #if (LINUX_VERSION_CODE < KERNEL_VERSION(3, 11, 0))
 static inline ktime_t ktime_add_ms(const ktime_t kt, const u64 msec)
 {
@@ -361,6 +518,9 @@ static inline ktime_t ktime_add_ms(const ktime_t kt, const u64 msec)
 #define FB_NO_SPC_NUM_RET    10
 #define FB_NO_SPC_SLEEP_MS   10
 
+/* Max data frames written to FH_DAT before the firmware is interrupted */
+#define HIP4_TX_BATCH_MAX    16
+
 /* Update scoreboard index */
 /* Function can be called from BH context */
 static void hip4_update_index(struct slsi_hip4 *hip, u32 q, enum rw r_w, u8 value)
@@ -662,11 +822,16 @@ static struct sk_buff *hip4_mbulk_to_skb(struct scsc_service *service, struct hi
 	}
 
 cont:
+	/* MIF RAM is mapped write-combined and is not in the linear map, so
+	 * the skb can not be built around the mbulk: the frame is copied out
+	 * once, into a head taken from the per cpu RX page pool rather than
+	 * the slab. A-MSDU subframes are later split out as clones.
+	 */
 	if (atomic)
-		skb = alloc_skb(bytes_to_alloc, GFP_ATOMIC);
+		skb = skb_rx_pool_alloc(hip_priv->rx_pool, bytes_to_alloc, GFP_ATOMIC);
 	else {
 		spin_unlock_bh(&hip_priv->rx_lock);
-		skb = alloc_skb(bytes_to_alloc, GFP_KERNEL);
+		skb = skb_rx_pool_alloc(hip_priv->rx_pool, bytes_to_alloc, GFP_KERNEL);
 		spin_lock_bh(&hip_priv->rx_lock);
 	}
 	if (!skb) {
@@ -697,20 +862,44 @@ cont:
 	for (j = 0; j < i; j++)
 		fapi_append_data(skb, mbulk_dat_r(next_mbulk[j]), next_mbulk[j]->len);
 
+	hip_priv->stats.rx_frames++;
+	hip_priv->stats.rx_copied_bytes += skb->len;
+
 	return skb;
 }
 
-/* Add signal reference (offset in shared memory) in the selected queue */
+/* Publish the write index of the queue and interrupt the firmware */
+static void hip4_q_publish(struct slsi_hip4 *hip, enum hip4_hip_q_conf conf, u8 idx_w, struct scsc_service *service)
+{
+	struct hip4_priv *hip_priv = hip->hip_priv;
+
+	/* Update the scoreboard */
+	hip4_update_index(hip, conf, widx, idx_w);
+
+	send = ktime_get();
+	scsc_service_mifintrbit_bit_set(service, hip_priv->rx_intr_fromhost, SCSC_MIFINTR_TARGET_R4);
+}
+
+/* Add signal reference (offset in shared memory) in the selected queue
+ * If more is set, a FH_DAT signal is only written to the queue: it is
+ * published, with the ones written before it, by the next signal added
+ * without more or by scsc_wifi_transmit_kick(). The batch is protected
+ * by tx_lock.
+ */
 /* This function should be called in atomic context. Callers should supply proper locking mechanism */
-static int hip4_q_add_signal(struct slsi_hip4 *hip, enum hip4_hip_q_conf conf, scsc_mifram_ref phy_m, struct scsc_service *service)
+static int __hip4_q_add_signal(struct slsi_hip4 *hip, enum hip4_hip_q_conf conf, scsc_mifram_ref phy_m, struct scsc_service *service, bool more)
 {
 	struct hip4_hip_control *ctrl = hip->hip_control;
 	struct hip4_priv        *hip_priv = hip->hip_priv;
+	bool                    batch = conf == HIP4_MIF_Q_FH_DAT;
 	u8                      idx_w;
 	u8                      idx_r;
 
-	/* Read the current q write pointer */
-	idx_w = hip4_read_index(hip, conf, widx);
+	/* Read the current q write pointer, unless some signals are unpublished */
+	if (batch && hip_priv->tx_batch_cnt)
+		idx_w = hip_priv->tx_batch_widx;
+	else
+		idx_w = hip4_read_index(hip, conf, widx);
 	/* Read the current q read pointer */
 	idx_r = hip4_read_index(hip, conf, ridx);
 	SCSC_HIP4_SAMPLER_Q(hip_priv->minor, conf, widx, idx_w, 1);
@@ -733,15 +922,30 @@ static int hip4_q_add_signal(struct slsi_hip4 *hip, enum hip4_hip_q_conf conf, s
 	idx_w++;
 	idx_w &= (MAX_NUM - 1);
 
-	/* Update the scoreboard */
-	hip4_update_index(hip, conf, widx, idx_w);
+	if (!batch) {
+		hip4_q_publish(hip, conf, idx_w, service);
+		return 0;
+	}
 
-	send = ktime_get();
-	scsc_service_mifintrbit_bit_set(service, hip_priv->rx_intr_fromhost, SCSC_MIFINTR_TARGET_R4);
+	hip_priv->tx_batch_cnt++;
+	hip_priv->tx_batch_widx = idx_w;
+	if (more && hip_priv->tx_batch_cnt < HIP4_TX_BATCH_MAX)
+		return 0;
+
+	hip4_q_publish(hip, conf, idx_w, service);
+	hip4_summary_tx_batch(hip_priv, hip_priv->tx_batch_cnt);
+	hip_priv->stats.tx_frames += hip_priv->tx_batch_cnt;
+	hip_priv->stats.tx_doorbells++;
+	hip_priv->tx_batch_cnt = 0;
 
 	return 0;
 }
 
+static int hip4_q_add_signal(struct slsi_hip4 *hip, enum hip4_hip_q_conf conf, scsc_mifram_ref phy_m, struct scsc_service *service)
+{
+	return __hip4_q_add_signal(hip, conf, phy_m, service, false);
+}
+
 static void hip4_watchdog(unsigned long data)
 {
 	struct slsi_hip4        *hip = (struct slsi_hip4 *)data;
@@ -831,6 +1035,86 @@ static bool slsi_check_rx_flowcontrol(struct slsi_dev *sdev)
  * never run on more than one CPU of a given processor, for a given tasklet)
  */
 
+static void hip4_schedule_bh(struct hip4_priv *hip_priv)
+{
+#ifdef TASKLET
+	tasklet_schedule(&hip_priv->intr_tq);
+#else
+	if (hip4_system_wq)
+		schedule_work(&hip_priv->intr_wq);
+	else
+		queue_work(hip_priv->hip4_workq, &hip_priv->intr_wq);
+#endif
+}
+
+static enum hrtimer_restart hip4_poll_timer(struct hrtimer *timer)
+{
+	struct hip4_priv *hip_priv = container_of(timer, struct hip4_priv, poll_timer);
+
+	if (!atomic_read(&hip_priv->closing)) {
+		hip_priv->summary_rx_sched = ktime_get();
+		hip4_schedule_bh(hip_priv);
+	}
+
+	return HRTIMER_NORESTART;
+}
+
+static void hip4_poll_stop(struct hip4_priv *hip_priv)
+{
+	if (!hip_priv->polling)
+		return;
+
+	hip_priv->polling = false;
+	hip_priv->stats.poll_ns += ktime_to_ns(ktime_sub(ktime_get(), hip_priv->stats.poll_start));
+}
+
+/* Called at the end of every bottom half run with the number of entries it
+ * consumed, decides whether the next run is triggered by the interrupt or
+ * by the poll timer.
+ */
+static bool hip4_poll_update(struct hip4_priv *hip_priv, u32 work, bool budget_hit)
+{
+	ktime_t now = ktime_get();
+	s64     elapsed;
+	u32     irqs;
+
+	hip_priv->poll_window_frames += work;
+	elapsed = ktime_to_ns(ktime_sub(now, hip_priv->poll_window_start));
+	if (elapsed >= HIP4_RATE_WINDOW_NS) {
+		irqs = atomic_read(&hip_priv->stats.irqs);
+		hip_priv->stats.irq_rate = div64_u64((u64)(irqs - hip_priv->poll_window_irqs) * NSEC_PER_SEC, elapsed);
+		hip_priv->stats.frame_rate = div64_u64((u64)hip_priv->poll_window_frames * NSEC_PER_SEC, elapsed);
+		hip_priv->poll_window_start = now;
+		hip_priv->poll_window_frames = 0;
+		hip_priv->poll_window_irqs = irqs;
+	}
+
+	if (!hip4_poll_enter_fps || atomic_read(&hip_priv->closing) ||
+	    atomic_read(&hip_priv->in_suspend)) {
+		hip4_poll_stop(hip_priv);
+		return false;
+	}
+
+	if (!hip_priv->polling) {
+		if (hip_priv->stats.frame_rate >= hip4_poll_enter_fps) {
+			hip_priv->polling = true;
+			hip_priv->stats.polls++;
+			hip_priv->stats.poll_start = now;
+		}
+	} else if (!budget_hit && (!work || hip_priv->stats.frame_rate < hip4_poll_enter_fps / 2)) {
+		hip4_poll_stop(hip_priv);
+		/* Traffic stopped: measure afresh before polling again */
+		if (!work) {
+			hip_priv->stats.frame_rate = 0;
+			hip_priv->poll_window_start = now;
+			hip_priv->poll_window_frames = 0;
+			hip_priv->poll_window_irqs = atomic_read(&hip_priv->stats.irqs);
+		}
+	}
+
+	return hip_priv->polling;
+}
+
 /* Worqueue: Lower priority, run in process context. Can run simultaneously on
  * different CPUs
  */
@@ -860,6 +1144,12 @@ static void hip4_wq(struct work_struct *data)
 	bool			no_change = true;
 	u8                      retry;
 	bool                    rx_flowcontrol = false;
+	u32                     work = 0;
+	u32                     dat_work = 0;
+	bool                    budget_hit = false;
+	bool                    summary = hip_priv->summary && hip4_summary_enable;
+	u32                     ctrl_frames = 0;
+	u32                     dat_frames = 0;
 
 #if defined(CONFIG_SCSC_WLAN_HIP4_PROFILING) || defined(CONFIG_SCSC_WLAN_DEBUG)
 	int                     id;
@@ -935,6 +1225,8 @@ static void hip4_wq(struct work_struct *data)
 				SCSC_HIP4_SAMPLER_PKT_TX_FB(hip->hip_priv->minor, host_tag);
 			}
 #endif
+			if (summary)
+				hip4_summary_tx_done(hip_priv, colour, hip4_fb_host_tag(m));
 			/* Ignore return value */
 			slsi_hip_tx_done(sdev, colour);
 		}
@@ -944,6 +1236,7 @@ consume_fb_mbulk:
 		idx_r++;
 		idx_r &= (MAX_NUM - 1);
 		update = true;
+		work++;
 	}
 	/* Update the scoreboard */
 	if (update)
@@ -1016,6 +1309,8 @@ consume_fb_mbulk:
 			SLSI_ERR_NODEV("Ctrl: Error detected slsi_hip_rx\n");
 			hip4_dump_dbg(hip, m, skb, service);
 			slsi_kfree_skb(skb);
+		} else if (summary) {
+			hip4_summary_rx(hip_priv, HIP4_SUMMARY_RX_Q_CTRL);
 		}
 consume_ctl_mbulk:
 		/* Increase index */
@@ -1043,11 +1338,14 @@ consume_ctl_mbulk:
 			SCSC_HIP4_SAMPLER_TOFREE(hip_priv->minor, i - 1);
 #endif
 		update = true;
+		work++;
+		ctrl_frames++;
 	}
 
 	/* Update the scoreboard */
 	if (update)
 		hip4_update_index(hip, HIP4_MIF_Q_TH_CTRL, ridx, idx_r);
+	hip4_summary_rx_batch(hip_priv, HIP4_SUMMARY_RX_Q_CTRL, ctrl_frames);
 
 	if (rx_flowcontrol)
 		goto skip_data_q;
@@ -1112,6 +1410,8 @@ consume_ctl_mbulk:
 			SLSI_ERR_NODEV("Dat: Error detected slsi_hip_rx\n");
 			hip4_dump_dbg(hip, m, skb, service);
 			slsi_kfree_skb(skb);
+		} else if (summary) {
+			hip4_summary_rx(hip_priv, HIP4_SUMMARY_RX_Q_DAT);
 		}
 consume_dat_mbulk:
 		/* Increase index */
@@ -1139,22 +1439,37 @@ consume_dat_mbulk:
 			SCSC_HIP4_SAMPLER_TOFREE(hip_priv->minor, i - 1);
 #endif
 		update = true;
+		work++;
+		dat_frames++;
+		/* Leave the rest to the next poll rather than starve others */
+		if (hip_priv->polling && ++dat_work >= hip4_poll_budget) {
+			budget_hit = true;
+			break;
+		}
 	}
 	/* Update the scoreboard */
 	if (update)
 		hip4_update_index(hip, HIP4_MIF_Q_TH_DAT, ridx, idx_r);
+	hip4_summary_rx_batch(hip_priv, HIP4_SUMMARY_RX_Q_DAT, dat_frames);
 
 	if (no_change)
 		atomic_inc(&hip->hip_priv->stats.spurious_irqs);
 
 skip_data_q:
-	if (!atomic_read(&hip->hip_priv->closing)) {
+	if (hip4_poll_update(hip_priv, work, budget_hit)) {
+		/* Keep the interrupt masked and the wake lock held, the
+		 * poll timer runs the next bottom half
+		 */
+		atomic_set(&hip->hip_priv->watchdog_timer_active, 0);
+		hrtimer_start(&hip_priv->poll_timer, ns_to_ktime((u64)hip4_poll_interval_us * NSEC_PER_USEC),
+			      HRTIMER_MODE_REL);
+	} else if (!atomic_read(&hip->hip_priv->closing)) {
 		/* Reset status variable. DO THIS BEFORE UNMASKING!!!*/
 		atomic_set(&hip->hip_priv->watchdog_timer_active, 0);
 		scsc_service_mifintrbit_bit_unmask(service, hip->hip_priv->rx_intr_tohost);
 	}
 
-	if (wake_lock_active(&hip->hip_priv->hip4_wake_lock)) {
+	if (!hip_priv->polling && wake_lock_active(&hip->hip_priv->hip4_wake_lock)) {
 		wake_unlock(&hip->hip_priv->hip4_wake_lock);
 		SCSC_WLOG_WAKELOCK(WLOG_LAZY, WL_RELEASED, "hip4_wake_lock", WL_REASON_RX);
 	}
@@ -1221,14 +1536,8 @@ static void hip4_irq_handler(int irq, void *data)
 	}
 
 	atomic_inc(&hip->hip_priv->stats.irqs);
-#ifdef TASKLET
-	tasklet_schedule(&hip->hip_priv->intr_tq);
-#else
-	if (hip4_system_wq)
-		schedule_work(&hip->hip_priv->intr_wq);
-	else
-		queue_work(hip->hip_priv->hip4_workq, &hip->hip_priv->intr_wq);
-#endif
+	hip->hip_priv->summary_rx_sched = intr_received;
+	hip4_schedule_bh(hip->hip_priv);
 end:
 	/* Clear interrupt */
 	scsc_service_mifintrbit_bit_clear(sdev->service, hip->hip_priv->rx_intr_tohost);
@@ -1253,10 +1562,14 @@ int hip4_init(struct slsi_hip4 *hip)
 	hip->hip_priv = kzalloc(sizeof(*hip->hip_priv), GFP_ATOMIC);
 	if (!hip->hip_priv)
 		return -ENOMEM;
+	/* The summary histograms are always on, whatever the debug config */
+	hip->hip_priv->summary = alloc_percpu(struct hip4_summary);
+	hip->hip_priv->stats.procfs_dir = proc_mkdir("driver/hip4", NULL);
+	if (hip->hip_priv->stats.procfs_dir && hip->hip_priv->summary)
+		proc_create_data("summary", S_IRUSR | S_IRGRP,
+				 hip->hip_priv->stats.procfs_dir, &hip4_procfs_summary_fops, hip);
 #ifdef CONFIG_SCSC_WLAN_DEBUG
-	memset(&hip->hip_priv->stats, 0, sizeof(hip->hip_priv->stats));
 	hip->hip_priv->stats.start = ktime_get();
-	hip->hip_priv->stats.procfs_dir = proc_mkdir("driver/hip4", NULL);
 	if (NULL != hip->hip_priv->stats.procfs_dir) {
 		proc_create_data("info", S_IRUSR | S_IRGRP,
 				 hip->hip_priv->stats.procfs_dir, &hip4_procfs_stats_fops, hip);
@@ -1497,11 +1810,19 @@ int hip4_init(struct slsi_hip4 *hip)
 	spin_lock_init(&hip->hip_priv->watchdog_lock);
 	setup_timer(&hip->hip_priv->watchdog, hip4_watchdog, (unsigned long)hip);
 
+	hrtimer_init(&hip->hip_priv->poll_timer, CLOCK_MONOTONIC, HRTIMER_MODE_REL);
+	hip->hip_priv->poll_timer.function = hip4_poll_timer;
+	hip->hip_priv->polling = false;
+	hip->hip_priv->poll_window_start = ktime_get();
+
 	atomic_set(&hip->hip_priv->gmod, HIP4_DAT_SLOTS);
 	atomic_set(&hip->hip_priv->gactive, 1);
 	spin_lock_init(&hip->hip_priv->gbot_lock);
 	hip->hip_priv->saturated = 0;
 
+	/* Without the pool RX skbs come from the netdev fragment cache */
+	hip->hip_priv->rx_pool = skb_rx_pool_create("hip4", hip4_rx_pool_pages);
+
 	return 0;
 }
 
@@ -1564,7 +1885,9 @@ int scsc_wifi_transmit_frame(struct slsi_hip4 *hip, bool ctrl_packet, struct sk_
 		goto error;
 	}
 
-	if (hip4_q_add_signal(hip, ctrl_packet ? HIP4_MIF_Q_FH_CTRL : HIP4_MIF_Q_FH_DAT, offset, service)) {
+	/* the stack tells when more frames follow right away: ring once for all */
+	if (__hip4_q_add_signal(hip, ctrl_packet ? HIP4_MIF_Q_FH_CTRL : HIP4_MIF_Q_FH_DAT, offset, service,
+				!ctrl_packet && skb->xmit_more)) {
 		SCSC_HIP4_SAMPLER_QFULL(hip->hip_priv->minor, ctrl_packet ? HIP4_MIF_Q_FH_CTRL : HIP4_MIF_Q_FH_DAT);
 		mbulk_free_virt_host(m);
 		ret = -ENOSPC;
@@ -1590,6 +1913,8 @@ int scsc_wifi_transmit_frame(struct slsi_hip4 *hip, bool ctrl_packet, struct sk_
 #ifdef CONFIG_SCSC_WLAN_DEBUG
 	hip4_history_record_add(FH, fapi_header->id);
 #endif
+	if (!ctrl_packet && hip->hip_priv->summary && hip4_summary_enable)
+		hip4_summary_tx(hip->hip_priv, fapi_get_u16(skb, u.ma_unitdata_req.host_tag));
 
 	/* Here we push a copy of the bare skb TRANSMITTED data also to the logring
 	 * as a binary record. Note that bypassing UDI subsystem as a whole
@@ -1619,6 +1944,28 @@ error:
 	return ret;
 }
 
+/* Publish the data frames held back by scsc_wifi_transmit_frame(), if any.
+ * Called at the end of each batch of frames from the network stack.
+ */
+void scsc_wifi_transmit_kick(struct slsi_hip4 *hip)
+{
+	struct slsi_dev  *sdev = container_of(hip, struct slsi_dev, hip4_inst);
+	struct hip4_priv *hip_priv = hip->hip_priv;
+
+	if (!hip_priv || !sdev->service)
+		return;
+
+	spin_lock_bh(&hip_priv->tx_lock);
+	if (hip_priv->tx_batch_cnt) {
+		hip4_q_publish(hip, HIP4_MIF_Q_FH_DAT, hip_priv->tx_batch_widx, sdev->service);
+		hip4_summary_tx_batch(hip_priv, hip_priv->tx_batch_cnt);
+		hip_priv->stats.tx_frames += hip_priv->tx_batch_cnt;
+		hip_priv->stats.tx_doorbells++;
+		hip_priv->tx_batch_cnt = 0;
+	}
+	spin_unlock_bh(&hip_priv->tx_lock);
+}
+
 /* HIP4 has been initialize, setup with values
  * provided by FW
  */
@@ -1721,11 +2068,21 @@ void hip4_freeze(struct slsi_hip4 *hip)
 
 	scsc_service_mifintrbit_bit_mask(service, hip->hip_priv->rx_intr_tohost);
 
+	/* A bottom half already past the closing check may re-arm the poll
+	 * timer once, so cancel it on both sides of the bottom half
+	 */
+	hrtimer_cancel(&hip->hip_priv->poll_timer);
 #ifdef TASKLET
 	tasklet_kill(&hip->hip_priv->intr_tq);
 #else
 	cancel_work_sync(&hip->hip_priv->intr_wq);
 #endif
+	hrtimer_cancel(&hip->hip_priv->poll_timer);
+	hip4_poll_stop(hip->hip_priv);
+	if (wake_lock_active(&hip->hip_priv->hip4_wake_lock)) {
+		wake_unlock(&hip->hip_priv->hip4_wake_lock);
+		SCSC_WLOG_WAKELOCK(WLOG_LAZY, WL_RELEASED, "hip4_wake_lock", WL_REASON_RX);
+	}
 	flush_workqueue(hip->hip_priv->hip4_workq);
 	destroy_workqueue(hip->hip_priv->hip4_workq);
 	atomic_set(&hip->hip_priv->rx_ready, 0);
@@ -1751,11 +2108,14 @@ void hip4_deinit(struct slsi_hip4 *hip)
 
 	scsc_service_mifintrbit_bit_mask(service, hip->hip_priv->rx_intr_tohost);
 
+	hrtimer_cancel(&hip->hip_priv->poll_timer);
 #ifdef TASKLET
 	tasklet_kill(&hip->hip_priv->intr_tq);
 #else
 	cancel_work_sync(&hip->hip_priv->intr_wq);
 #endif
+	hrtimer_cancel(&hip->hip_priv->poll_timer);
+	hip4_poll_stop(hip->hip_priv);
 	scsc_service_mifintrbit_unregister_tohost(service, hip->hip_priv->rx_intr_tohost);
 
 	flush_workqueue(hip->hip_priv->hip4_workq);
@@ -1772,13 +2132,16 @@ void hip4_deinit(struct slsi_hip4 *hip)
 	/* Deactive the wd timer prior its expiration */
 	del_timer_sync(&hip->hip_priv->watchdog);
 
-#ifdef CONFIG_SCSC_WLAN_DEBUG
 	if (hip->hip_priv->stats.procfs_dir) {
+#ifdef CONFIG_SCSC_WLAN_DEBUG
 		remove_proc_entry("driver/hip4/info", NULL);
 		remove_proc_entry("driver/hip4/history", NULL);
+#endif
+		remove_proc_entry("driver/hip4/summary", NULL);
 		remove_proc_entry("driver/hip4", NULL);
 	}
-#endif
+	free_percpu(hip->hip_priv->summary);
+	skb_rx_pool_destroy(hip->hip_priv->rx_pool);
 	kfree(hip->hip_priv);
 
 	hip->hip_priv = NULL;
@@ -19,12 +19,15 @@
 #include <linux/types.h>
 #include <linux/device.h>
 #include <linux/skbuff.h>
+#include <linux/skb_rx_pool.h>
+#include <linux/hrtimer.h>
 #include <scsc/scsc_mifram.h>
 #include <scsc/scsc_mx.h>
 #ifndef SLSI_TEST_DEV
 #include <linux/wakelock.h>
 #endif
 #include "mbulk.h"
+#include "hip4_sampler.h"
 
 #define MIF_HIP_COMPAT_FLAG_NEED_MLME_RESET     BIT(0)
 #define MIF_HIP_COMPAT_FLAG_MIB_DAT_BY_FAPI     BIT(1)
@@ -199,8 +202,13 @@ struct hip4_priv {
 	/* rx cycle lock */
 	spinlock_t                   rx_lock;
 #endif
+	/* Recycling pages for skb heads copied out of MIF RAM, or NULL */
+	struct skb_rx_pool           *rx_pool;
 	/* tx cycle lock */
 	spinlock_t                   tx_lock;
+	/* Data frames written to FH_DAT but not yet published, tx_lock */
+	u8                           tx_batch_cnt;
+	u8                           tx_batch_widx;
 
 	/* Scoreboard update spinlock */
 	rwlock_t                     rw_scoreboard;
@@ -227,14 +235,40 @@ struct hip4_priv {
 	atomic_t                     in_suspend;
 	u32                          storm_count;
 
+	/* Interrupt moderation, updated by the rx bottom half only */
+	struct hrtimer               poll_timer;
+	bool                         polling;
+	ktime_t                      poll_window_start;
+	u32                          poll_window_frames;
+	u32                          poll_window_irqs;
+
 	struct {
 		atomic_t	     irqs;
 		atomic_t	     spurious_irqs;
 		u32 q_num_frames[MIF_HIP_CFG_Q_NUM];
+		/* Updated by the rx bottom half only */
+		u64 rx_frames;
+		u64 rx_copied_bytes;
+		/* Updated under tx_lock */
+		u64 tx_frames;
+		u64 tx_doorbells;
+		/* Rates over the last moderation window, per second */
+		u32 irq_rate;
+		u32 frame_rate;
+		u32 polls;
+		u64 poll_ns;
+		ktime_t poll_start;
 		ktime_t start;
 		struct proc_dir_entry   *procfs_dir;
 	} stats;
 
+	/* Always-on histograms, see hip4_sampler.h, or NULL */
+	struct hip4_summary __percpu *summary;
+	/* Low 16 bits host_tag, high bits TX time in ns; under tx_lock */
+	u64                          summary_tx_ts[HIP4_SUMMARY_TX_TAGS];
+	/* Time the rx bottom half was last scheduled, by irq or poll */
+	ktime_t                      summary_rx_sched;
+
 #ifdef CONFIG_SCSC_WLAN_HIP4_PROFILING
 	/*minor*/
 	u32                          minor;
@@ -280,6 +314,7 @@ void hip4_deinit(struct slsi_hip4 *hip);
 int hip4_free_ctrl_slots_count(struct slsi_hip4 *hip);
 
 int scsc_wifi_transmit_frame(struct slsi_hip4 *hip, bool ctrl_packet, struct sk_buff *skb);
+void scsc_wifi_transmit_kick(struct slsi_hip4 *hip);
 
 /* Macros for accessing information stored in the hip_config struct */
 #define scsc_wifi_get_hip_config_version_4_u8(buff_ptr, member) le16_to_cpu((((struct hip4_hip_config_version_4 *)(buff_ptr))->member))
@@ -293,4 +293,40 @@ extern bool hip4_sampler_pkt_tx;
 #define SCSC_HIP4_SAMPLER_PKT_TX_FB(minor, host_tag)
 #endif /* CONFIG_SCSC_WLAN_HIP4_PROFILING */
 
+/* Summarized mode: unlike the record stream above it is always built and
+ * only keeps log2 histograms, per CPU, shown in /proc/driver/hip4/summary.
+ * Latency buckets are 2^n us (bucket 0 is under 1 us), batch buckets are
+ * 2^n frames; the last bucket of each is open ended.
+ */
+#define HIP4_SUMMARY_LAT_BUCKETS	16
+#define HIP4_SUMMARY_BATCH_BUCKETS	8
+#define HIP4_SUMMARY_TX_Q		4	/* per AC, from the FB colour */
+#define HIP4_SUMMARY_RX_Q		2	/* TH_CTRL, TH_DAT */
+#define HIP4_SUMMARY_RX_Q_CTRL		0
+#define HIP4_SUMMARY_RX_Q_DAT		1
+/* In flight MA-UNITDATA host_tags whose TX time is remembered */
+#define HIP4_SUMMARY_TX_TAGS		256
+
+struct hip4_summary {
+	u32 tx_lat[HIP4_SUMMARY_TX_Q][HIP4_SUMMARY_LAT_BUCKETS];
+	u32 rx_lat[HIP4_SUMMARY_RX_Q][HIP4_SUMMARY_LAT_BUCKETS];
+	u32 tx_batch[HIP4_SUMMARY_BATCH_BUCKETS];
+	u32 rx_batch[HIP4_SUMMARY_RX_Q][HIP4_SUMMARY_BATCH_BUCKETS];
+};
+
+/* ns are shifted to ~us rather than divided, this is a histogram */
+static inline u32 hip4_summary_lat_bucket(s64 ns)
+{
+	u32 b = ns > 0 ? fls64((u64)ns >> 10) : 0;
+
+	return min_t(u32, b, HIP4_SUMMARY_LAT_BUCKETS - 1);
+}
+
+static inline u32 hip4_summary_batch_bucket(u32 frames)
+{
+	u32 b = frames ? fls(frames) - 1 : 0;
+
+	return min_t(u32, b, HIP4_SUMMARY_BATCH_BUCKETS - 1);
+}
+
 #endif /* __HIP4_SAMPLER_H__ */
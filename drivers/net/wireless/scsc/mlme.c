@@ -2741,6 +2741,7 @@ int slsi_mlme_get_sinfo_mib(struct slsi_dev *sdev, struct net_device *dev,
 		if (values[mib_index].type != SLSI_MIB_TYPE_NONE) {
 			SLSI_CHECK_TYPE(sdev, values[mib_index].type, SLSI_MIB_TYPE_UINT);
 			slsi_decode_fw_rate((u16)values[mib_index].u.uintValue, &peer->sinfo.txrate, &ndev_vif->sta.data_rate_mbps);
+			scsc_wifi_fcq_update_tx_rate(dev, &peer->data_qs, sdev, cfg80211_calculate_bitrate(&peer->sinfo.txrate));
 #if (LINUX_VERSION_CODE >= KERNEL_VERSION(4, 0, 0))
 			peer->sinfo.filled |= BIT(NL80211_STA_INFO_TX_BITRATE);
 #else
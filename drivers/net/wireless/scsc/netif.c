@@ -54,6 +54,11 @@
 
 #define SLSI_TX_WAKELOCK_TIME (100)
 
+/* e.g. 0xc0 for the big cluster; RPS can then spread the flows further */
+static unsigned long rx_data_cpus;
+module_param(rx_data_cpus, ulong, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(rx_data_cpus, "Mask of CPUs to run RX data processing on, 0 (default) for the CPU that received the frames");
+
 static bool tcp_ack_suppression_disable;
 module_param(tcp_ack_suppression_disable, bool, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(tcp_ack_suppression_disable, "Disable TCP ack suppression feature");
@@ -817,6 +822,8 @@ static netdev_tx_t slsi_net_hw_xmit(struct sk_buff *skb, struct net_device *dev)
 	 */
 	unsigned int packet_len = skb->len;
 	enum slsi_traffic_q traffic_q = slsi_frame_priority_to_ac_queue(skb->priority);
+	/* Frames of a batch are published to the firmware with the last one */
+	bool more = skb->xmit_more;
 
 	slsi_wakelock(&sdev->wlan_wl);
 	slsi_wakelock_timeout(&sdev->wlan_wl_to, SLSI_TX_WAKELOCK_TIME);
@@ -886,6 +893,8 @@ static netdev_tx_t slsi_net_hw_xmit(struct sk_buff *skb, struct net_device *dev)
 
 	skb = slsi_netif_tcp_ack_suppression_pkt(dev, skb);
 	if (!skb) {
+		if (!more)
+			scsc_wifi_transmit_kick(&sdev->hip4_inst);
 		slsi_wakeunlock(&sdev->wlan_wl);
 		if (original_skb)
 			slsi_kfree_skb(original_skb);
@@ -958,6 +967,9 @@ evaluate:
 	/* SKBs are always considered consumed if the driver
 	 * returns NETDEV_TX_OK.
 	 */
+	/* A requeued frame ends the batch as well */
+	if (!more || r == NETDEV_TX_BUSY)
+		scsc_wifi_transmit_kick(&sdev->hip4_inst);
 	slsi_wakeunlock(&sdev->wlan_wl);
 	return r;
 }
@@ -972,7 +984,7 @@ static netdev_features_t slsi_net_fix_features(struct net_device *dev, netdev_fe
 	features |= NETIF_F_GSO;
 #endif
 
-#ifdef CONFIG_SCSC_WLAN_RX_NAPI_GRO
+#if defined(CONFIG_SCSC_WLAN_RX_NAPI_GRO) || defined(CONFIG_SCSC_WLAN_RX_GRO)
 	SLSI_NET_DBG1(dev, SLSI_RX, "napi rx gro enabled\n");
 	features |= NETIF_F_GRO;
 #else
@@ -1263,7 +1275,7 @@ int slsi_netif_add_locked(struct slsi_dev *sdev, const char *name, int ifnum)
 
 	INIT_DELAYED_WORK(&ndev_vif->scan_timeout_work, slsi_scan_ind_timeout_handle);
 
-	ret = slsi_skb_work_init(sdev, dev, &ndev_vif->rx_data, "slsi_wlan_rx_data", slsi_rx_netdev_data_work);
+	ret = slsi_skb_work_init_steered(sdev, dev, &ndev_vif->rx_data, "slsi_wlan_rx_data", slsi_rx_netdev_data_work, &rx_data_cpus);
 	if (ret)
 		goto exit_with_error;
 
@@ -1303,6 +1315,10 @@ int slsi_netif_add_locked(struct slsi_dev *sdev, const char *name, int ifnum)
 	/* TODO_HARDMAC: What weight should we use? 32 is just a Guess */
 	netif_napi_add(dev, &ndev_vif->napi.napi, slsi_net_rx_poll, 32);
 	napi_enable(&ndev_vif->napi.napi);
+#endif
+#ifdef CONFIG_SCSC_WLAN_RX_GRO
+	netif_napi_add(dev, &ndev_vif->rx_gro_napi, slsi_rx_gro_poll, SLSI_RX_GRO_BATCH);
+	napi_enable(&ndev_vif->rx_gro_napi);
 #endif
 	ndev_vif->delete_probe_req_ies = false;
 	ndev_vif->probe_req_ies = NULL;
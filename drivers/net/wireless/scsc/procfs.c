@@ -488,6 +488,10 @@ static int slsi_procfs_vifs_show(struct seq_file *m, void *v)
 			continue;
 		}
 		seq_printf(m, "vif:%d %pM %s\n", vif, dev->dev_addr, slsi_procfs_vif_type_to_str(ndev_vif->vif_type));
+#ifdef CONFIG_SCSC_WLAN_RX_GRO
+		seq_printf(m, "vif:%d rx_gro packets:%llu merged:%llu\n", vif,
+			   ndev_vif->rx_gro_packets, ndev_vif->rx_gro_merged);
+#endif
 		for (peer_index = 0; peer_index < SLSI_ADHOC_PEER_CONNECTIONS_MAX; peer_index++) {
 			struct slsi_peer *peer = ndev_vif->peer_sta_record[peer_index];
 
@@ -894,12 +898,14 @@ static int slsi_procfs_fcq_show(struct seq_file *m, void *v)
 			struct scsc_wifi_fcq_q_stat    queue_stat;
 			u32                            peer_ps_state_transitions = 0;
 			enum scsc_wifi_fcq_8021x_state cp_state;
+			u32                            tx_rate = 0, latency_us = 0;
 
 			if (!peer || !peer->valid)
 				continue;
 
 			if (scsc_wifi_fcq_stat_queueset(&peer->data_qs, &queue_stat, &smod, &scod, &cp_state, &peer_ps_state_transitions) != 0)
 				continue;
+			(void)scsc_wifi_fcq_stat_airtime(&peer->data_qs, &tx_rate, &latency_us);
 
 			seq_printf(m, "|%-12s|%-6d|%-6s|\n%d). peer:%pM, qs:%2d, smod:%u, scod:%u, netq stops :%u, netq resumes :%u, PS transitions :%u Controlled port :%s\n",
 				   netdev_name(dev),
@@ -914,6 +920,8 @@ static int slsi_procfs_fcq_show(struct seq_file *m, void *v)
 				   queue_stat.netq_resumes,
 				   peer_ps_state_transitions,
 				   cp_state == SCSC_WIFI_FCQ_8021x_STATE_BLOCKED ? "Blocked" : "Opened");
+			seq_printf(m, "    tx rate:%u.%u Mbps, avg tx latency:%u us\n",
+				   tx_rate / 10, tx_rate % 10, latency_us);
 
 			seq_printf(m, "    |%-12s|%-17s|%4s|%8s|%8s|%8s|%8s|%10s|%8s|\n",
 				   "netdev",
@@ -1058,6 +1066,17 @@ static int slsi_procfs_tcp_ack_suppression_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+static int slsi_procfs_rx_cpu_stats_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	seq_puts(m, "cpu  rx_data_packets\n");
+	for_each_possible_cpu(cpu)
+		seq_printf(m, "%3d  %llu\n", cpu, slsi_rx_data_cpu_packets(cpu));
+
+	return 0;
+}
+
 static ssize_t slsi_procfs_nan_mac_addr_read(struct file *file,	char __user *user_buf, size_t count, loff_t *ppos)
 {
 	char              buf[20];
@@ -1180,6 +1199,7 @@ SLSI_PROCFS_READ_FILE_OPS(sta_bss);
 SLSI_PROCFS_READ_FILE_OPS(big_data);
 SLSI_PROCFS_READ_FILE_OPS(throughput_stats);
 SLSI_PROCFS_SEQ_FILE_OPS(tcp_ack_suppression);
+SLSI_PROCFS_SEQ_FILE_OPS(rx_cpu_stats);
 SLSI_PROCFS_READ_FILE_OPS(nan_mac_addr);
 #ifdef CONFIG_SCSC_WIFI_NAN_ENABLE
 SLSI_PROCFS_READ_FILE_OPS(nan_info);
@@ -1226,6 +1246,7 @@ int slsi_create_proc_dir(struct slsi_dev *sdev)
 		SLSI_PROCFS_ADD_FILE(sdev, big_data, parent, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
 		SLSI_PROCFS_ADD_FILE(sdev, throughput_stats, parent, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
 		SLSI_PROCFS_SEQ_ADD_FILE(sdev, tcp_ack_suppression, sdev->procfs_dir, S_IRUSR | S_IRGRP);
+		SLSI_PROCFS_SEQ_ADD_FILE(sdev, rx_cpu_stats, sdev->procfs_dir, S_IRUSR | S_IRGRP);
 		SLSI_PROCFS_ADD_FILE(sdev, nan_mac_addr, parent, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
 #ifdef CONFIG_SCSC_WIFI_NAN_ENABLE
 		SLSI_PROCFS_ADD_FILE(sdev, nan_info, parent, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
@@ -1270,6 +1291,7 @@ void slsi_remove_proc_dir(struct slsi_dev *sdev)
 		SLSI_PROCFS_REMOVE_FILE(big_data, sdev->procfs_dir);
 		SLSI_PROCFS_REMOVE_FILE(throughput_stats, sdev->procfs_dir);
 		SLSI_PROCFS_REMOVE_FILE(tcp_ack_suppression, sdev->procfs_dir);
+		SLSI_PROCFS_REMOVE_FILE(rx_cpu_stats, sdev->procfs_dir);
 		SLSI_PROCFS_REMOVE_FILE(nan_mac_addr, sdev->procfs_dir);
 #ifdef CONFIG_SCSC_WIFI_NAN_ENABLE
 		SLSI_PROCFS_REMOVE_FILE(nan_info, sdev->procfs_dir);
@@ -87,6 +87,57 @@ static int sap_ma_version_supported(u16 version)
 	return -EINVAL;
 }
 
+/* Data frames passed to the stack, per CPU */
+static DEFINE_PER_CPU(u64, slsi_rx_cpu_packets);
+
+u64 slsi_rx_data_cpu_packets(int cpu)
+{
+	return per_cpu(slsi_rx_cpu_packets, cpu);
+}
+
+#ifdef CONFIG_SCSC_WLAN_RX_GRO
+/* rx_gro_napi is never scheduled, but a napi_struct needs a poll function */
+int slsi_rx_gro_poll(struct napi_struct *napi, int budget)
+{
+	napi_complete(napi);
+	return 0;
+}
+
+static void slsi_rx_gro_flush(struct net_device *dev)
+{
+	struct netdev_vif *ndev_vif = netdev_priv(dev);
+
+	if (!ndev_vif->rx_gro_held)
+		return;
+
+	local_bh_disable();
+	napi_gro_flush(&ndev_vif->rx_gro_napi, false);
+	local_bh_enable();
+	ndev_vif->rx_gro_held = 0;
+}
+
+static void slsi_rx_gro_receive(struct net_device *dev, struct sk_buff *skb)
+{
+	struct netdev_vif *ndev_vif = netdev_priv(dev);
+	gro_result_t      ret;
+
+	if (!(dev->features & NETIF_F_GRO)) {
+		netif_rx_ni(skb);
+		return;
+	}
+
+	local_bh_disable();
+	ret = napi_gro_receive(&ndev_vif->rx_gro_napi, skb);
+	local_bh_enable();
+
+	ndev_vif->rx_gro_packets++;
+	if (ret == GRO_MERGED || ret == GRO_MERGED_FREE)
+		ndev_vif->rx_gro_merged++;
+	if (++ndev_vif->rx_gro_held >= SLSI_RX_GRO_BATCH)
+		slsi_rx_gro_flush(dev);
+}
+#endif
+
 static int slsi_rx_amsdu_deaggregate(struct net_device *dev, struct sk_buff *skb, struct sk_buff_head *msdu_list)
 {
 	unsigned int msdu_len;
@@ -364,7 +415,12 @@ void slsi_rx_data_deliver_skb(struct slsi_dev *sdev, struct net_device *dev, str
 		slsi_dbg_untrack_skb(rx_skb);
 
 		SLSI_DBG4(sdev, SLSI_RX, "pass %u bytes to local stack\n", rx_skb->len);
+		this_cpu_inc(slsi_rx_cpu_packets);
+#ifdef CONFIG_SCSC_WLAN_RX_GRO
+		slsi_rx_gro_receive(dev, rx_skb);
+#else
 		netif_rx_ni(rx_skb);
+#endif
 		slsi_wakelock_timeout(&sdev->wlan_wl_to, SLSI_RX_WAKELOCK_TIME);
 	}
 }
@@ -540,6 +596,9 @@ void slsi_rx_netdev_data_work(struct work_struct *work)
 		SLSI_MUTEX_LOCK(ndev_vif->vif_mutex);
 		if (!ndev_vif->activated) {
 			slsi_skb_queue_purge(&w->queue);
+#ifdef CONFIG_SCSC_WLAN_RX_GRO
+			slsi_rx_gro_flush(dev);
+#endif
 			SLSI_MUTEX_UNLOCK(ndev_vif->vif_mutex);
 			break;
 		}
@@ -550,6 +609,10 @@ void slsi_rx_netdev_data_work(struct work_struct *work)
 
 		skb = slsi_skb_work_dequeue(w);
 		if (!skb) {
+#ifdef CONFIG_SCSC_WLAN_RX_GRO
+			/* Queue drained: hand the coalesced frames up */
+			slsi_rx_gro_flush(dev);
+#endif
 			SLSI_MUTEX_UNLOCK(ndev_vif->vif_mutex);
 			break;
 		}
@@ -67,6 +67,24 @@ uint scsc_wifi_fcq_minimum_smod = 50;
 module_param(scsc_wifi_fcq_minimum_smod, uint, S_IRUGO | S_IWUSR);
 MODULE_PARM_DESC(scsc_wifi_fcq_minimum_smod, "Initial value of minimum smod - peer normal (default = 50)");
 
+/* With airtime fairness the unicast smod is shared in proportion to the
+ * peers' tx rates rather than equally, so every peer has about the same
+ * airtime worth of frames in flight and a slow peer cannot hold most of
+ * the firmware buffers. The frames in flight of a peer are also capped to
+ * scsc_wifi_fcq_airtime_max_ms of airtime at its rate.
+ */
+bool scsc_wifi_fcq_airtime = true;
+module_param(scsc_wifi_fcq_airtime, bool, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(scsc_wifi_fcq_airtime, "Share unicast smod by peer tx rate (default = Y)");
+
+uint scsc_wifi_fcq_airtime_max_ms = 20;
+module_param(scsc_wifi_fcq_airtime_max_ms, uint, S_IRUGO | S_IWUSR);
+MODULE_PARM_DESC(scsc_wifi_fcq_airtime_max_ms, "Maximum airtime of frames in flight per peer in ms (default = 20)");
+
+/* Nominal frame size used to turn a rate into frames */
+#define SCSC_WIFI_FCQ_AIRTIME_FRAME_BITS	(1500 * 8)
+#define SCSC_WIFI_FCQ_AIRTIME_MIN_SMOD		8
+
 #define SCSC_WIFI_FCQ_SMOD_RESUME_HYSTERESIS 10
 #define SCSC_WIFI_FCQ_QMOD_RESUME_HYSTERESIS 10
 #define SCSC_WIFI_FCQ_GMOD_RESUME_HYSTERESIS 30
@@ -277,8 +295,37 @@ static void fcq_redistribute_qmod(struct net_device *dev, struct scsc_wifi_fcq_d
 }
 #endif
 
+/* Share of scsc_wifi_fcq_smod for qs, given the sum of the known tx rates
+ * of the peers sharing it. Peers whose rate is not known yet weigh as the
+ * average of the others.
+ */
+static u32 fcq_airtime_smod(struct scsc_wifi_fcq_data_qset *qs, u32 equal_smod, u64 rate_sum, int rated, int peers)
+{
+	u32 avg_rate, rate;
+	u64 smod, cap;
+
+	if (!scsc_wifi_fcq_airtime || !rated)
+		return equal_smod;
+
+	avg_rate = div_u64(rate_sum, rated);
+	rate = qs->tx_rate ? qs->tx_rate : avg_rate;
+	rate_sum += (u64)(peers - rated) * avg_rate;
+	if (!rate_sum)
+		return equal_smod;
+
+	smod = div64_u64((u64)scsc_wifi_fcq_smod * rate, rate_sum);
+	smod = max_t(u64, smod, scsc_wifi_fcq_minimum_smod);
+	/* rate is in 100 kbps, so rate * 100 bits are sent per ms */
+	cap = div_u64((u64)rate * 100 * scsc_wifi_fcq_airtime_max_ms, SCSC_WIFI_FCQ_AIRTIME_FRAME_BITS);
+	smod = min(smod, cap);
+
+	return max_t(u32, smod, SCSC_WIFI_FCQ_AIRTIME_MIN_SMOD);
+}
+
 static void fcq_redistribute_smod(struct net_device *dev, struct slsi_dev *sdev, int total_to_distribute)
 {
+	u64 rate_sum = 0;
+	int rated = 0, peers = 0;
 #ifdef CLOSE_IN_OVERSHOOT
 	int i;
 #endif
@@ -305,6 +352,21 @@ static void fcq_redistribute_smod(struct net_device *dev, struct slsi_dev *sdev,
 	/* Saturate if number is lower than certian low level */
 	if (new_smod < scsc_wifi_fcq_minimum_smod)
 		new_smod = scsc_wifi_fcq_minimum_smod;
+
+	list_for_each_entry_safe(pc_node, next, &peers_cache_list, list) {
+		if (!pc_node->is_unicast)
+			continue;
+#ifdef EXPERIMENTAL_DYNAMIC_SMOD_ADAPTATION
+		if (pc_node->qs->in_sleep)
+			continue;
+#endif
+		peers++;
+		if (pc_node->qs->tx_rate) {
+			rate_sum += pc_node->qs->tx_rate;
+			rated++;
+		}
+	}
+
 	list_for_each_entry_safe(pc_node, next, &peers_cache_list, list) {
 		if (pc_node->is_unicast) {
 			qs_redis = pc_node->qs;
@@ -312,9 +374,9 @@ static void fcq_redistribute_smod(struct net_device *dev, struct slsi_dev *sdev,
 			if (qs_redis->in_sleep)
 				atomic_set(&qs_redis->smod, 0);
 			else
-				atomic_set(&qs_redis->smod, new_smod);
+				atomic_set(&qs_redis->smod, fcq_airtime_smod(qs_redis, new_smod, rate_sum, rated, peers));
 #else
-			atomic_set(&qs_redis->smod, new_smod);
+			atomic_set(&qs_redis->smod, fcq_airtime_smod(qs_redis, new_smod, rate_sum, rated, peers));
 #endif
 #ifdef CLOSE_IN_OVERSHOOT
 			/* Stop queues to avoid overshooting if scod > smod */
@@ -364,6 +426,15 @@ static int fcq_redistribute_smod_before_stopping(struct net_device *dev, struct
 }
 #endif
 
+/* This function should be called in spinlock(qs), before scod changes */
+static inline void fcq_account_occupancy(struct scsc_wifi_fcq_data_qset *qs)
+{
+	ktime_t now = ktime_get();
+
+	qs->occupancy_ns += (u64)atomic_read(&qs->scod) * ktime_to_ns(ktime_sub(now, qs->occupancy_t));
+	qs->occupancy_t = now;
+}
+
 static int fcq_transmit_gmod_domain(struct net_device *dev, struct scsc_wifi_fcq_data_qset *qs, u16 priority, struct slsi_dev *sdev, u8 vif, u8 peer_index)
 {
 	int gcod;
@@ -599,6 +670,7 @@ found:
 		spin_unlock_bh(&qs->cp_lock);
 		return -EPERM;
 	}
+	fcq_account_occupancy(qs);
 	rc = fcq_transmit_gmod_domain(dev, qs, priority, sdev, vif, peer_index);
 	if (rc) {
 		spin_unlock_bh(&qs->cp_lock);
@@ -813,6 +885,8 @@ int scsc_wifi_fcq_receive_data(struct net_device *dev, struct scsc_wifi_fcq_data
 	if (rc)
 		goto end;
 
+	fcq_account_occupancy(qs);
+	qs->tx_done++;
 	rc = fcq_receive_smod_domain(dev, qs, sdev, priority, peer_index, vif);
 	if (rc)
 		goto end;
@@ -862,6 +936,21 @@ int scsc_wifi_fcq_8021x_port_state(struct net_device *dev, struct scsc_wifi_fcq_
 	return 0;
 }
 
+/* Called with the rate the firmware last reported for the peer of qs */
+void scsc_wifi_fcq_update_tx_rate(struct net_device *dev, struct scsc_wifi_fcq_data_qset *qs, struct slsi_dev *sdev, u32 tx_rate)
+{
+	if (WARN_ON(!qs))
+		return;
+
+	if (qs->tx_rate == tx_rate)
+		return;
+
+	SLSI_DBG4_NODEV(SLSI_WIFI_FCQ, "qs %p tx rate %u -> %u (100 kbps)\n", qs, qs->tx_rate, tx_rate);
+	qs->tx_rate = tx_rate;
+	if (scsc_wifi_fcq_airtime && total)
+		fcq_redistribute_smod(dev, sdev, total);
+}
+
 /**
  * Statistics
  */
@@ -895,6 +984,24 @@ int scsc_wifi_fcq_stat_queueset(struct scsc_wifi_fcq_data_qset *queue_set,
 	return 0;
 }
 
+/* By Little's law, the average time a frame spends between the host and
+ * its tx done is the average number of frames in flight over the rate
+ * at which they complete.
+ */
+int scsc_wifi_fcq_stat_airtime(struct scsc_wifi_fcq_data_qset *queue_set, u32 *tx_rate, u32 *avg_latency_us)
+{
+	if (WARN_ON(!queue_set) || WARN_ON(!tx_rate) || WARN_ON(!avg_latency_us))
+		return -EINTR;
+
+	spin_lock_bh(&queue_set->cp_lock);
+	fcq_account_occupancy(queue_set);
+	*tx_rate = queue_set->tx_rate;
+	*avg_latency_us = queue_set->tx_done ?
+			  div64_u64(queue_set->occupancy_ns, queue_set->tx_done * NSEC_PER_USEC) : 0;
+	spin_unlock_bh(&queue_set->cp_lock);
+	return 0;
+}
+
 /**
  * Queue and Queue Set init/deinit
  */
@@ -993,6 +1100,7 @@ static void fcq_qset_init(struct net_device *dev, struct slsi_dev *sdev, enum sc
 	qs->can_be_distributed = false;
 #endif
 	qs->controlled_port_state = SCSC_WIFI_FCQ_8021x_STATE_BLOCKED;
+	qs->occupancy_t = ktime_get();
 
 	/* Queues init */
 	for (i = 0; i < SLSI_NETIF_Q_PER_PEER; i++) {
@@ -77,6 +77,13 @@ struct scsc_wifi_fcq_data_qset {
 #endif
 	bool                        saturated;
 	int                         guard;
+
+	/* Airtime fairness: last reported tx rate in 100 kbps, 0 if unknown */
+	u32                         tx_rate;
+	/* Frames in flight integrated over time, for the average latency */
+	ktime_t                     occupancy_t;
+	u64                         occupancy_ns;
+	u64                         tx_done;
 };
 
 /* Queue and queue set management */
@@ -101,6 +108,7 @@ int scsc_wifi_fcq_receive_ctrl(struct net_device *dev, struct scsc_wifi_fcq_ctrl
 int scsc_wifi_fcq_update_smod(struct scsc_wifi_fcq_data_qset *qs, enum scsc_wifi_fcq_ps_state peer_ps_state,
 			      enum scsc_wifi_fcq_queue_set_type type);
 int scsc_wifi_fcq_8021x_port_state(struct net_device *dev, struct scsc_wifi_fcq_data_qset *qs, enum scsc_wifi_fcq_8021x_state state);
+void scsc_wifi_fcq_update_tx_rate(struct net_device *dev, struct scsc_wifi_fcq_data_qset *qs, struct slsi_dev *sdev, u32 tx_rate);
 
 /* Statistics */
 int scsc_wifi_fcq_stat_queue(struct scsc_wifi_fcq_q_header *queue,
@@ -112,4 +120,6 @@ int scsc_wifi_fcq_stat_queueset(struct scsc_wifi_fcq_data_qset *queue_set,
 				int *smod, int *scod, enum scsc_wifi_fcq_8021x_state *cp_state,
 				u32 *peer_ps_state_transitions);
 
+int scsc_wifi_fcq_stat_airtime(struct scsc_wifi_fcq_data_qset *queue_set, u32 *tx_rate, u32 *avg_latency_us);
+
 #endif /* #ifndef __SCSC_WIFI_FCQ_H */
@@ -157,6 +157,10 @@ int scsc_wifi_transmit_frame(struct slsi_hip4 *hip, bool ctrl_packet, struct sk_
 	return 0;
 }
 
+void scsc_wifi_transmit_kick(struct slsi_hip4 *hip)
+{
+}
+
 void slsi_test_bh_work_f(struct work_struct *work)
 {
 }
@@ -259,6 +263,10 @@ int scsc_wifi_fcq_8021x_port_state(struct net_device *dev, struct scsc_wifi_fcq_
 	return 0;
 }
 
+void scsc_wifi_fcq_update_tx_rate(struct net_device *dev, struct scsc_wifi_fcq_data_qset *qs, struct slsi_dev *sdev, u32 tx_rate)
+{
+}
+
 int scsc_wifi_fcq_stat_queue(struct scsc_wifi_fcq_q_header *queue,
 			     struct scsc_wifi_fcq_q_stat *queue_stat,
 			     int *qmod, int *qcod)
@@ -274,3 +282,8 @@ int scsc_wifi_fcq_stat_queueset(struct scsc_wifi_fcq_data_qset *queue_set,
 	return 0;
 }
 
+int scsc_wifi_fcq_stat_airtime(struct scsc_wifi_fcq_data_qset *queue_set, u32 *tx_rate, u32 *avg_latency_us)
+{
+	return 0;
+}
+
@@ -439,6 +439,7 @@ struct slsi_skb_work {
 	struct work_struct      work;
 	struct sk_buff_head     queue;
 	void __rcu              *sync_ptr;
+	const unsigned long     *cpu_mask; /* CPUs to run on, unless empty */
 };
 
 static inline int slsi_skb_work_init(struct slsi_dev *sdev, struct net_device *dev, struct slsi_skb_work *work, const char *name, void (*func)(struct work_struct *work))
@@ -449,6 +450,26 @@ static inline int slsi_skb_work_init(struct slsi_dev *sdev, struct net_device *d
 	skb_queue_head_init(&work->queue);
 	INIT_WORK(&work->work, func);
 	work->workqueue = alloc_ordered_workqueue(name, 0);
+	work->cpu_mask = NULL;
+
+	if (!work->workqueue)
+		return -ENOMEM;
+	return 0;
+}
+
+/* The work runs on a CPU of *cpu_mask, the one that queued it if in the
+ * mask. With an empty mask it runs on the CPU that queued it. The single
+ * work item of the bound workqueue still never runs concurrently.
+ */
+static inline int slsi_skb_work_init_steered(struct slsi_dev *sdev, struct net_device *dev, struct slsi_skb_work *work, const char *name, void (*func)(struct work_struct *work), const unsigned long *cpu_mask)
+{
+	rcu_assign_pointer(work->sync_ptr, (void *)sdev);
+	work->sdev = sdev;
+	work->dev = dev;
+	skb_queue_head_init(&work->queue);
+	INIT_WORK(&work->work, func);
+	work->workqueue = alloc_workqueue(name, 0, 1);
+	work->cpu_mask = cpu_mask;
 
 	if (!work->workqueue)
 		return -ENOMEM;
@@ -457,6 +478,22 @@ static inline int slsi_skb_work_init(struct slsi_dev *sdev, struct net_device *d
 
 static inline void slsi_skb_schedule_work(struct slsi_skb_work *work)
 {
+	unsigned long mask = work->cpu_mask ? READ_ONCE(*work->cpu_mask) : 0;
+	int cpu;
+
+	if (mask) {
+		cpu = raw_smp_processor_id();
+		if (cpu < BITS_PER_LONG && (mask & BIT(cpu))) {
+			queue_work_on(cpu, work->workqueue, &work->work);
+			return;
+		}
+		for_each_set_bit(cpu, &mask, BITS_PER_LONG) {
+			if (cpu_online(cpu)) {
+				queue_work_on(cpu, work->workqueue, &work->work);
+				return;
+			}
+		}
+	}
 	queue_work(work->workqueue, &work->work);
 }
 
@@ -19,6 +19,7 @@
 #include <linux/list.h>
 #include <linux/wait.h>
 #include <linux/slab.h>
+#include <linux/workqueue.h>
 
 #include "acpm.h"
 #include "acpm_ipc.h"
@@ -316,6 +317,42 @@ unsigned int acpm_ipc_release_channel(struct device_node *np, unsigned int chann
 	return 0;
 }
 
+static void acpm_ipc_account(struct acpm_ipc_ch *channel, u64 start)
+{
+	u64 us = div_u64(sched_clock() - start, NSEC_PER_USEC);
+	int bucket = min_t(int, fls64(us), ACPM_IPC_LAT_BUCKETS - 1);
+
+	spin_lock(&channel->ch_lock);
+	channel->lat_hist[bucket]++;
+	channel->lat_count++;
+	if (us > channel->lat_max_us)
+		channel->lat_max_us = us;
+	spin_unlock(&channel->ch_lock);
+}
+
+/* called with rx_lock held */
+static struct acpm_ipc_async *acpm_ipc_async_match(struct acpm_ipc_ch *channel,
+		unsigned int seq)
+{
+	struct acpm_ipc_async *req;
+
+	list_for_each_entry(req, &channel->async_pending, list)
+		if (req->seq == seq)
+			return req;
+
+	return NULL;
+}
+
+static void acpm_ipc_async_complete(struct list_head *done, int err)
+{
+	struct acpm_ipc_async *req, *n;
+
+	list_for_each_entry_safe(req, n, done, list) {
+		list_del(&req->list);
+		req->done(req, err);
+	}
+}
+
 static bool check_response(struct acpm_ipc_ch *channel, struct ipc_config *cfg)
 {
 	unsigned int front;
@@ -387,6 +424,8 @@ static void dequeue_policy(struct acpm_ipc_ch *channel)
 	unsigned int rear;
 	struct list_head *cb_list = &channel->list;
 	struct callback_info *cb;
+	struct acpm_ipc_async *req;
+	LIST_HEAD(done);
 
 	spin_lock(&channel->rx_lock);
 
@@ -412,12 +451,21 @@ static void dequeue_policy(struct acpm_ipc_ch *channel)
 			if (cb && cb->ipc_callback)
 				cb->ipc_callback(channel->cmd, channel->rx_ch.size);
 
+		req = acpm_ipc_async_match(channel,
+				(channel->cmd[0] >> ACPM_IPC_PROTOCOL_SEQ_NUM) & 0x3f);
+		if (req) {
+			memcpy_align_4(req->cfg.cmd, channel->cmd, channel->rx_ch.size);
+			list_move_tail(&req->list, &done);
+			acpm_ipc_account(channel, req->start);
+		}
+
 		if (channel->rx_ch.len == (rear + 1))
 			rear = 0;
 		else
 			rear++;
 
-		if (!channel->polling)
+		/* async responses are not for the sync waiter */
+		if (!channel->polling && !req)
 			complete(&channel->wait);
 
 		__raw_writel(rear, channel->rx_ch.rear);
@@ -426,6 +474,8 @@ static void dequeue_policy(struct acpm_ipc_ch *channel)
 
 	acpm_log_print();
 	spin_unlock(&channel->rx_lock);
+
+	acpm_ipc_async_complete(&done, 0);
 }
 
 static irqreturn_t acpm_ipc_irq_handler(int irq, void *data)
@@ -517,6 +567,7 @@ int acpm_ipc_send_data_sync(unsigned int channel_id, struct ipc_config *cfg)
 {
 	int ret;
 	struct acpm_ipc_ch *channel;
+	u64 start = sched_clock();
 
 	ret = acpm_ipc_send_data(channel_id, cfg);
 
@@ -530,6 +581,7 @@ int acpm_ipc_send_data_sync(unsigned int channel_id, struct ipc_config *cfg)
 				pr_err("[%s] ipc_timeout!!!\n", __func__);
 				ret = -ETIMEDOUT;
 			} else {
+				acpm_ipc_account(channel, start);
 				ret = 0;
 			}
 		}
@@ -546,7 +598,7 @@ int acpm_ipc_send_data(unsigned int channel_id, struct ipc_config *cfg)
 	struct acpm_ipc_ch *channel;
 	bool timeout_flag = 0;
 	int ret;
-	u64 timeout, now;
+	u64 timeout, now, start = sched_clock();
 
 	if (channel_id >= acpm_ipc->num_channels && !cfg)
 		return -EIO;
@@ -643,12 +695,198 @@ int acpm_ipc_send_data(unsigned int channel_id, struct ipc_config *cfg)
 			return -ETIMEDOUT;
 		}
 
+		acpm_ipc_account(channel, start);
 		acpm_log_print();
 	}
 
 	return 0;
 }
 
+static int acpm_ipc_poll_async(struct acpm_ipc_ch *channel,
+		struct acpm_ipc_async *req)
+{
+	u64 timeout = sched_clock() + IPC_TIMEOUT;
+
+	while (!(__raw_readl(acpm_ipc->intr + INTSR1) & (1 << channel->id)) ||
+			check_response(channel, &req->cfg)) {
+		if (timeout < sched_clock()) {
+			if (!check_response(channel, &req->cfg))
+				break;
+			pr_err("[ACPM] async seq %u timeout\n", req->seq);
+			return -ETIMEDOUT;
+		}
+		cpu_relax();
+	}
+
+	acpm_ipc_account(channel, req->start);
+	return 0;
+}
+
+static void acpm_ipc_async_timeout(struct work_struct *work)
+{
+	struct acpm_ipc_ch *channel = container_of(to_delayed_work(work),
+			struct acpm_ipc_ch, async_work);
+	struct acpm_ipc_async *req, *n;
+	u64 now = sched_clock();
+	LIST_HEAD(expired);
+	bool more;
+
+	spin_lock(&channel->rx_lock);
+	list_for_each_entry_safe(req, n, &channel->async_pending, list) {
+		if (now - req->start >= IPC_TIMEOUT) {
+			pr_err("[ACPM] ch%u async seq %u timeout\n",
+					channel->id, req->seq);
+			list_move_tail(&req->list, &expired);
+		}
+	}
+	more = !list_empty(&channel->async_pending);
+	spin_unlock(&channel->rx_lock);
+
+	acpm_ipc_async_complete(&expired, -ETIMEDOUT);
+
+	if (more)
+		schedule_delayed_work(&channel->async_work,
+				msecs_to_jiffies(IPC_TIMEOUT / NSEC_PER_MSEC));
+}
+
+/**
+ * acpm_ipc_send_batch - send requests without waiting for their responses
+ * @channel_id: channel, as given by acpm_ipc_request_channel()
+ * @reqs: the requests, each with its done callback set
+ * @nr: number of requests
+ *
+ * The requests are queued back to back and the APM is interrupted once for
+ * all of them, so that requests to several domains pay for one round trip
+ * instead of one each. Each response is reported to the done callback of
+ * its request, matched by sequence number. Indirect commands are not
+ * supported, the channel having one indirection buffer only.
+ *
+ * Returns 0 once all are sent, in which case every done callback will be
+ * called, or an error, in which case none of them will.
+ */
+int acpm_ipc_send_batch(unsigned int channel_id, struct acpm_ipc_async *reqs,
+		unsigned int nr)
+{
+	struct acpm_ipc_ch *channel;
+	unsigned int front, tmp_index, i;
+	bool timeout_flag = 0;
+	LIST_HEAD(sent);
+	int ret;
+
+	if (channel_id >= acpm_ipc->num_channels || !nr)
+		return -EINVAL;
+
+	channel = &acpm_ipc->channel[channel_id];
+
+	/* the queue needs a free slot to tell full from empty */
+	if (channel->type == TYPE_BUFFER || nr >= channel->tx_ch.len)
+		return -EINVAL;
+
+	for (i = 0; i < nr; i++)
+		if (!reqs[i].cfg.cmd || !reqs[i].done || reqs[i].cfg.indirection)
+			return -EINVAL;
+
+	spin_lock(&channel->tx_lock);
+
+	front = __raw_readl(channel->tx_ch.front);
+	for (i = 0; i < nr; i++) {
+		struct acpm_ipc_async *req = &reqs[i];
+
+		tmp_index = front + 1;
+		if (tmp_index >= channel->tx_ch.len)
+			tmp_index = 0;
+
+		/* buffer full check */
+		UNTIL_EQUAL(true, tmp_index != __raw_readl(channel->tx_ch.rear),
+				timeout_flag);
+		if (timeout_flag) {
+			/* nothing was published to the APM yet */
+			spin_unlock(&channel->tx_lock);
+			pr_err("[%s] tx buffer full! timeout!!!\n", __func__);
+			return -ETIMEDOUT;
+		}
+
+		if (++channel->seq_num == 64)
+			channel->seq_num = 1;
+		req->seq = channel->seq_num;
+		req->cfg.cmd[0] |= (req->seq & 0x3f) << ACPM_IPC_PROTOCOL_SEQ_NUM;
+		req->cfg.response = true;
+
+		memcpy_align_4(channel->tx_ch.base + channel->tx_ch.size * front,
+				req->cfg.cmd, channel->tx_ch.size);
+		req->cfg.cmd[1] = 0;
+		req->cfg.cmd[2] = 0;
+		req->cfg.cmd[3] = 0;
+
+		front = tmp_index;
+	}
+
+	for (i = 0; i < nr; i++)
+		reqs[i].start = sched_clock();
+
+	if (!channel->polling) {
+		spin_lock(&channel->rx_lock);
+		for (i = 0; i < nr; i++)
+			list_add_tail(&reqs[i].list, &channel->async_pending);
+		spin_unlock(&channel->rx_lock);
+		schedule_delayed_work(&channel->async_work,
+				msecs_to_jiffies(IPC_TIMEOUT / NSEC_PER_MSEC));
+	}
+
+	/* one interrupt for the whole batch */
+	__raw_writel(front, channel->tx_ch.front);
+	timestamp_write();
+	apm_interrupt_gen(channel->id);
+	spin_unlock(&channel->tx_lock);
+
+	if (!channel->polling)
+		return 0;
+
+	for (i = 0; i < nr; i++) {
+		ret = acpm_ipc_poll_async(channel, &reqs[i]);
+		reqs[i].done(&reqs[i], ret);
+	}
+	acpm_log_print();
+
+	return 0;
+}
+EXPORT_SYMBOL_GPL(acpm_ipc_send_batch);
+
+static ssize_t ipc_latency_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct acpm_ipc_ch *channel;
+	unsigned long hist[ACPM_IPC_LAT_BUCKETS];
+	unsigned long count, max;
+	ssize_t len = 0;
+	int i, j;
+
+	for (i = 0; i < acpm_ipc->num_channels; i++) {
+		channel = &acpm_ipc->channel[i];
+
+		spin_lock(&channel->ch_lock);
+		memcpy(hist, channel->lat_hist, sizeof(hist));
+		count = channel->lat_count;
+		max = channel->lat_max_us;
+		spin_unlock(&channel->ch_lock);
+
+		if (!count)
+			continue;
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				"ch%u: responses %lu max_us %lu\n",
+				channel->id, count, max);
+		for (j = 0; j < ACPM_IPC_LAT_BUCKETS - 1; j++)
+			len += scnprintf(buf + len, PAGE_SIZE - len,
+					"  <%u: %lu\n", 1U << j, hist[j]);
+		len += scnprintf(buf + len, PAGE_SIZE - len, "  >=%u: %lu\n",
+				1U << (j - 1), hist[j]);
+	}
+
+	return len;
+}
+static DEVICE_ATTR_RO(ipc_latency);
+
 static void log_buffer_init(struct device *dev, struct device_node *node)
 {
 	const __be32 *prop;
@@ -751,6 +989,9 @@ static int channel_init(void)
 		spin_lock_init(&acpm_ipc->channel[i].tx_lock);
 		spin_lock_init(&acpm_ipc->channel[i].ch_lock);
 		INIT_LIST_HEAD(&acpm_ipc->channel[i].list);
+		INIT_LIST_HEAD(&acpm_ipc->channel[i].async_pending);
+		INIT_DELAYED_WORK(&acpm_ipc->channel[i].async_work,
+				acpm_ipc_async_timeout);
 	}
 
 	__raw_writel(mask, acpm_ipc->intr + INTMR1);
@@ -818,6 +1059,9 @@ static int acpm_ipc_probe(struct platform_device *pdev)
 
 	channel_init();
 
+	if (device_create_file(&pdev->dev, &dev_attr_ipc_latency))
+		dev_err(&pdev->dev, "failed to create ipc_latency attr\n");
+
 	if (acpm_debug->period) {
 		debug_logging_wq = create_freezable_workqueue("acpm_debug_logging");
 		INIT_DELAYED_WORK(&acpm_debug->work, acpm_debug_logging);
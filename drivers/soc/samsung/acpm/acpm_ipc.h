@@ -20,6 +20,8 @@ struct callback_info {
 	struct list_head list;
 };
 
+#define ACPM_IPC_LAT_BUCKETS	12
+
 struct acpm_ipc_ch {
 	struct buff_info rx_ch;
 	struct buff_info tx_ch;
@@ -36,6 +38,15 @@ struct acpm_ipc_ch {
 
 	struct completion wait;
 	bool polling;
+
+	/* acpm_ipc_async requests waiting for their response, under rx_lock */
+	struct list_head async_pending;
+	struct delayed_work async_work;
+
+	/* request to response latency, in powers of two microseconds */
+	unsigned long lat_hist[ACPM_IPC_LAT_BUCKETS];
+	unsigned long lat_count;
+	unsigned long lat_max_us;
 };
 
 struct acpm_ipc_info {
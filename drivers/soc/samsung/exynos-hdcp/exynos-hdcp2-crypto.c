@@ -10,55 +10,72 @@
 #include <linux/err.h>
 #include <linux/crypto.h>
 #include <linux/ctype.h>
+#include <linux/mutex.h>
 #include <crypto/hash.h>
 #include <crypto/sha.h>
 
-struct sdesc {
-	struct shash_desc shash;
-	char ctx[];
-};
+/*
+ * The transform is allocated once and kept: allocating it per call walks
+ * the algorithm list and probes the implementation each time. The ARMv8
+ * CE driver is asked for by name so that a generic implementation with a
+ * higher priority registered later does not shadow it.
+ */
+static const char * const hdcp_sha1_drivers[] = { "sha1-ce", "sha1" };
+
+static DEFINE_MUTEX(hdcp_sha1_lock);
+static struct crypto_shash *hdcp_sha1_tfm;
 
-static struct sdesc *alloc_sdesc(struct crypto_shash *alg)
+static struct crypto_shash *hdcp_sha1_get(void)
 {
-	struct sdesc *sdesc;
-	int size;
+	struct crypto_shash *tfm = ERR_PTR(-ENOENT);
+	int i;
+
+	if (hdcp_sha1_tfm)
+		return hdcp_sha1_tfm;
+
+	for (i = 0; i < ARRAY_SIZE(hdcp_sha1_drivers); i++) {
+		tfm = crypto_alloc_shash(hdcp_sha1_drivers[i], 0,
+					 CRYPTO_ALG_ASYNC);
+		if (!IS_ERR(tfm))
+			break;
+	}
+
+	if (IS_ERR(tfm)) {
+		pr_info("encrypted_key: could not allocate crypto sha1\n");
+		return tfm;
+	}
 
-	size = sizeof(struct shash_desc) + crypto_shash_descsize(alg);
-	sdesc = kmalloc(size, GFP_KERNEL);
-	if (!sdesc)
-		return ERR_PTR(-ENOMEM);
-	sdesc->shash.tfm = alg;
-	sdesc->shash.flags = 0x0;
-	return sdesc;
+	hdcp_sha1_tfm = tfm;
+	return tfm;
 }
 
 int hdcp_calc_sha1(u8 *digest, const u8 *buf, unsigned int buflen)
 {
-	struct crypto_shash *hashalg;
-	const char hash_alg[] = "sha1";
-	struct sdesc *sdesc;
+	struct crypto_shash *tfm;
 	int ret;
 
-	hashalg = crypto_alloc_shash(hash_alg, 0, CRYPTO_ALG_ASYNC);
-	if (IS_ERR(hashalg)) {
-		pr_info("encrypted_key: could not allocate crypto %s\n",
-			hash_alg);
-		return PTR_ERR(hashalg);
-	}
+	mutex_lock(&hdcp_sha1_lock);
+	tfm = hdcp_sha1_get();
+	if (IS_ERR(tfm)) {
+		ret = PTR_ERR(tfm);
+	} else {
+		SHASH_DESC_ON_STACK(desc, tfm);
 
-	sdesc = alloc_sdesc(hashalg);
-	if (IS_ERR(sdesc)) {
-		pr_err("alloc_sdesc: can't alloc %s\n", hash_alg);
-		if (hashalg)
-			crypto_free_shash(hashalg);
-		return PTR_ERR(sdesc);
+		desc->tfm = tfm;
+		desc->flags = 0x0;
+		ret = crypto_shash_digest(desc, buf, buflen, digest);
+		shash_desc_zero(desc);
 	}
-
-	ret = crypto_shash_digest(&sdesc->shash, buf, buflen, digest);
-	kfree(sdesc);
-
-	if (hashalg)
-		crypto_free_shash(hashalg);
+	mutex_unlock(&hdcp_sha1_lock);
 
 	return ret;
 }
+
+void hdcp_crypto_exit(void)
+{
+	mutex_lock(&hdcp_sha1_lock);
+	if (hdcp_sha1_tfm)
+		crypto_free_shash(hdcp_sha1_tfm);
+	hdcp_sha1_tfm = NULL;
+	mutex_unlock(&hdcp_sha1_lock);
+}
@@ -16,5 +16,6 @@
 #define HDCP_SHA1_SIZE (160 / 8)
 
 int hdcp_calc_sha1(u8 *digest, const u8 *buf, unsigned int buflen);
+void hdcp_crypto_exit(void);
 
 #endif
@@ -151,6 +151,9 @@ struct hdcp_tx_ctx {
 	uint8_t rn[HDCP_AKE_RTX_BYTE_LEN];
 	uint8_t riv[HDCP_AKE_RTX_BYTE_LEN];
 	uint8_t lsb16_hmac[HDCP_HMAC_SHA256_LEN / 2];
+	/* rn and its hmac, riv generated ahead of LC_Init and SKE_Send_Eks */
+	uint8_t lc_ready;
+	uint8_t riv_ready;
 
 	/* session key */
 	uint8_t str_ctr[HDCP_STR_CTR_LEN];
@@ -227,7 +230,9 @@ int lc_make_hmac(struct hdcp_tx_ctx *tx_ctx,
 		  struct hdcp_rx_ctx *rx_ctx, uint32_t lk_type);
 int lc_generate_rn(uint8_t *out, size_t out_len);
 int lc_compare_hmac(uint8_t *rx_hmac, size_t hmac_len);
+int lc_precompute(struct hdcp_tx_ctx *tx_ctx, struct hdcp_rx_ctx *rx_ctx);
 
 int ske_generate_riv(uint8_t *out);
+int ske_precompute_riv(struct hdcp_tx_ctx *tx_ctx);
 int ske_generate_sessionkey(uint32_t lk_type, uint8_t *enc_skey,
 			int share_skey);
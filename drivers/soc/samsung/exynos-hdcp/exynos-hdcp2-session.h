@@ -47,6 +47,20 @@ typedef enum hdcp_tx_hdcp_link_state {
         LINK_ST_END
 } hdcp_tx_hdcp_link_state;
 
+/* authentication phases timed per link */
+enum {
+	HDCP_AUTH_AKE,
+	HDCP_AUTH_LC,
+	HDCP_AUTH_SKE,
+	HDCP_AUTH_REPEATER,
+	HDCP_AUTH_PHASE_CNT
+};
+
+struct hdcp_auth_times {
+	u64 start;				/* first AKE step, ns */
+	u64 phase_ns[HDCP_AUTH_PHASE_CNT];	/* time spent in the driver */
+};
+
 struct hdcp_session_node {
         struct hdcp_session_data *ss_data;
         struct hdcp_session_node *next;
@@ -74,6 +88,7 @@ struct hdcp_link_data {
         struct hdcp_tx_ctx tx_ctx; /* Transmitter context data */
         struct hdcp_rx_ctx rx_ctx; /* Receiver context data */
         struct hdcp_timer timer; /* to check timeout */
+	struct hdcp_auth_times auth_times;
         struct hdcp_session_node *ss_ptr; /* session pointer link belong */
 };
 
@@ -22,6 +22,7 @@
 #include "exynos-hdcp2-teeif.h"
 #include "iia_link/exynos-hdcp2-iia-selftest.h"
 #include "exynos-hdcp2-encrypt.h"
+#include "exynos-hdcp2-crypto.h"
 #include "exynos-hdcp2-log.h"
 #include "dp_link/exynos-hdcp2-dplink-if.h"
 #include "dp_link/exynos-hdcp2-dplink.h"
@@ -419,6 +420,7 @@ static void __exit hdcp_exit(void)
 	misc_deregister(&hdcp);
 	hdcp_session_list_destroy(&g_hdcp_session_list);
 	hdcp_tee_close();
+	hdcp_crypto_exit();
 }
 
 static const struct file_operations hdcp_fops = {
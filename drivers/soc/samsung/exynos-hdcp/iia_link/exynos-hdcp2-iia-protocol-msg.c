@@ -146,6 +146,49 @@ int lc_generate_rn(uint8_t *out, size_t out_len)
 	return 0;
 }
 
+/*
+ * rn and riv are transmitter nonces and the LC hmac only needs rn and the
+ * AKE results, so they can be made as soon as AKE is done, off the
+ * LC_Init -> L' and SKE steps. They are used once; a retried LC_Init
+ * makes a fresh rn.
+ */
+int lc_precompute(struct hdcp_tx_ctx *tx_ctx, struct hdcp_rx_ctx *rx_ctx)
+{
+	int ret;
+
+	tx_ctx->lc_ready = 0;
+
+	ret = lc_generate_rn(tx_ctx->rn, HDCP_RTX_BYTE_LEN);
+	if (ret)
+		return ret;
+
+	if ((rx_ctx->version != HDCP_VERSION_2_0) &&
+		tx_ctx->lc_precomp && rx_ctx->lc_precomp) {
+		ret = lc_make_hmac(tx_ctx, rx_ctx, 0);
+		if (ret)
+			return ret;
+	}
+
+	tx_ctx->lc_ready = 1;
+	return 0;
+}
+
+int ske_precompute_riv(struct hdcp_tx_ctx *tx_ctx)
+{
+	int ret;
+
+	tx_ctx->riv_ready = 0;
+	if (tx_ctx->share_skey)
+		return 0;
+
+	ret = ske_generate_riv(tx_ctx->riv);
+	if (ret)
+		return ret;
+
+	tx_ctx->riv_ready = 1;
+	return 0;
+}
+
 int lc_make_hmac(struct hdcp_tx_ctx *tx_ctx,
 		  struct hdcp_rx_ctx *rx_ctx, uint32_t lk_type)
 {
@@ -604,11 +647,13 @@ static int cap_lc_init(uint8_t *m, size_t *m_len, struct hdcp_tx_ctx *tx_ctx,
 	NULL))
 		return ERR_WRONG_BUFFER;
 
-	/* Generate rn */
-	ret = lc_generate_rn(tx_ctx->rn, HDCP_RTX_BYTE_LEN);
-	if (ret) {
-		hdcp_err("failed to generate rtx\n");
-		return ERR_GENERATE_RN;
+	/* Generate rn, unless done when AKE completed */
+	if (!tx_ctx->lc_ready) {
+		ret = lc_generate_rn(tx_ctx->rn, HDCP_RTX_BYTE_LEN);
+		if (ret) {
+			hdcp_err("failed to generate rtx\n");
+			return ERR_GENERATE_RN;
+		}
 	}
 
 	/* Make Message */
@@ -616,7 +661,9 @@ static int cap_lc_init(uint8_t *m, size_t *m_len, struct hdcp_tx_ctx *tx_ctx,
 	memcpy(&m[1], tx_ctx->rn, HDCP_RTX_BYTE_LEN);
 	*m_len = 1 + HDCP_RTX_BYTE_LEN;
 
-	if ((rx_ctx->version != HDCP_VERSION_2_0) &&
+	if (tx_ctx->lc_ready) {
+		tx_ctx->lc_ready = 0;
+	} else if ((rx_ctx->version != HDCP_VERSION_2_0) &&
 		tx_ctx->lc_precomp &&
 		rx_ctx->lc_precomp) {
 		/* compute HMAC,
@@ -714,12 +761,13 @@ static int cap_ske_send_eks(uint8_t *m, size_t *m_len, struct hdcp_tx_ctx *tx_ct
 	(rx_ctx == NULL))
 		return ERR_WRONG_BUFFER;
 
-	/* Generate riv */
-	if (!tx_ctx->share_skey) {
+	/* Generate riv, unless done when LC completed */
+	if (!tx_ctx->share_skey && !tx_ctx->riv_ready) {
 		ret = ske_generate_riv(tx_ctx->riv);
 		if (ret)
 			return ERR_GENERATE_RIV;
 	}
+	tx_ctx->riv_ready = 0;
 
 	/* Generate encrypted Session Key */
 	ret = ske_generate_sessionkey(0, enc_skey, tx_ctx->share_skey);
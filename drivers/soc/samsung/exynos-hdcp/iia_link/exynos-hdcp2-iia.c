@@ -8,7 +8,10 @@
  * it under the terms of the GNU General Public License version 2 as
  * published by the Free Software Foundation.
  */
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/uaccess.h>
 #include <linux/smc.h>
@@ -58,6 +61,100 @@ static char *hdcp_link_st_str[] = {
 
 int state_init_flag;
 
+static const char * const hdcp_auth_phase_str[HDCP_AUTH_PHASE_CNT] = {
+	[HDCP_AUTH_AKE]		= "ake",
+	[HDCP_AUTH_LC]		= "lc",
+	[HDCP_AUTH_SKE]		= "ske",
+	[HDCP_AUTH_REPEATER]	= "repeater",
+};
+
+/* the last completed authentication */
+static struct hdcp_auth_times hdcp_last_auth;
+static u64 hdcp_last_auth_wall;
+static unsigned int hdcp_auth_count;
+
+static int hdcp_auth_phase(uint32_t state)
+{
+	switch (state) {
+	case LINK_ST_A1_EXCHANGE_MASTER_KEY:
+		return HDCP_AUTH_AKE;
+	case LINK_ST_A2_LOCALITY_CHECK:
+		return HDCP_AUTH_LC;
+	case LINK_ST_A3_EXCHANGE_SESSION_KEY:
+		return HDCP_AUTH_SKE;
+	case LINK_ST_A4_TEST_REPEATER:
+	case LINK_ST_A6_WAIT_RECEIVER_ID_LIST:
+	case LINK_ST_A7_VERIFY_RECEIVER_ID_LIST:
+	case LINK_ST_A8_SEND_RECEIVER_ID_LIST_ACK:
+		return HDCP_AUTH_REPEATER;
+	default:
+		return -1;
+	}
+}
+
+static void hdcp_auth_account(struct hdcp_link_data *lk, int phase, u64 start)
+{
+	struct hdcp_auth_times *t = &lk->auth_times;
+	u64 now = ktime_get_ns();
+
+	if (phase < 0)
+		return;
+
+	if (phase == HDCP_AUTH_AKE && !t->start)
+		t->start = start;
+	t->phase_ns[phase] += now - start;
+
+	if (lk->state == LINK_ST_A5_AUTHENTICATED && t->start) {
+		hdcp_last_auth = *t;
+		hdcp_last_auth_wall = now - t->start;
+		hdcp_auth_count++;
+		hdcp_info("auth done in %llu us (ake %llu lc %llu ske %llu rp %llu us in driver)\n",
+			div_u64(hdcp_last_auth_wall, NSEC_PER_USEC),
+			div_u64(t->phase_ns[HDCP_AUTH_AKE], NSEC_PER_USEC),
+			div_u64(t->phase_ns[HDCP_AUTH_LC], NSEC_PER_USEC),
+			div_u64(t->phase_ns[HDCP_AUTH_SKE], NSEC_PER_USEC),
+			div_u64(t->phase_ns[HDCP_AUTH_REPEATER], NSEC_PER_USEC));
+		memset(t, 0, sizeof(*t));
+	} else if (lk->state == LINK_ST_H1_TX_LOW_VALUE_CONTENT) {
+		/* failed, the next attempt starts over */
+		memset(t, 0, sizeof(*t));
+	}
+}
+
+static int hdcp_auth_times_show(struct seq_file *m, void *v)
+{
+	int i;
+
+	seq_printf(m, "authentications: %u\n", hdcp_auth_count);
+	seq_printf(m, "last wall_us: %llu\n",
+		   div_u64(hdcp_last_auth_wall, NSEC_PER_USEC));
+	for (i = 0; i < HDCP_AUTH_PHASE_CNT; i++)
+		seq_printf(m, "last %s_us: %llu\n", hdcp_auth_phase_str[i],
+			   div_u64(hdcp_last_auth.phase_ns[i], NSEC_PER_USEC));
+
+	return 0;
+}
+
+static int hdcp_auth_times_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, hdcp_auth_times_show, NULL);
+}
+
+static const struct file_operations hdcp_auth_times_fops = {
+	.open		= hdcp_auth_times_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init hdcp_auth_times_init(void)
+{
+	debugfs_create_file("hdcp2_auth_times", 0400, NULL, NULL,
+			    &hdcp_auth_times_fops);
+	return 0;
+}
+late_initcall(hdcp_auth_times_init);
+
 enum hdcp_result hdcp_unwrap_key(char *wkey)
 {
 
@@ -211,30 +308,14 @@ enum hdcp_result hdcp_link_close(struct hdcp_link_info *lk_info)
 	return HDCP_SUCCESS;
 }
 
-enum hdcp_result hdcp_link_authenticate(struct hdcp_msg_info *msg_info)
+static enum hdcp_result __hdcp_link_authenticate(struct hdcp_link_data *lk_data,
+		struct hdcp_msg_info *msg_info)
 {
-	struct hdcp_session_node *ss_node;
-	struct hdcp_link_node *lk_node;
-	struct hdcp_link_data *lk_data;
 	int ret = HDCP_SUCCESS;
 	int rval = TX_AUTH_SUCCESS;
 	int ake_retry = 0;
 	int lc_retry = 0;
 
-	/* find Session node which contains the Link */
-	ss_node = hdcp_session_list_find(msg_info->ss_handle, &g_hdcp_session_list);
-	if (!ss_node)
-		return HDCP_ERROR_INVALID_INPUT;
-
-	lk_node = hdcp_link_list_find(msg_info->lk_id, &ss_node->ss_data->ln);
-	if (!lk_node)
-		return HDCP_ERROR_INVALID_INPUT;
-
-	lk_data = lk_node->lk_data;
-
-	if (!lk_data)
-		return HDCP_ERROR_INVALID_INPUT;
-
 	/**
 	 * if Upstream Content Control Function call this API,
 	 * it changes state to ST_A0_DETERMINE_RX_HDCP_CAP automatically.
@@ -264,6 +345,9 @@ enum hdcp_result hdcp_link_authenticate(struct hdcp_msg_info *msg_info)
 					UPDATE_LINK_STATE(lk_data, LINK_ST_A2_LOCALITY_CHECK);
 					msg_info->next_step = SEND_MSG;
 					state_init_flag = 1;
+					/* not fatal, LC_Init makes them itself */
+					if (lc_precompute(&lk_data->tx_ctx, &lk_data->rx_ctx))
+						hdcp_info("LC precompute failed\n");
 				}
 			} else {
 				ret = HDCP_ERROR_EXCHANGE_KM;
@@ -277,6 +361,8 @@ enum hdcp_result hdcp_link_authenticate(struct hdcp_msg_info *msg_info)
 					lc_retry = 0;
 					UPDATE_LINK_STATE(lk_data, LINK_ST_A3_EXCHANGE_SESSION_KEY);
 					msg_info->next_step = SEND_MSG;
+					if (ske_precompute_riv(&lk_data->tx_ctx))
+						hdcp_info("riv precompute failed\n");
 				}
 			} else {
 				UPDATE_LINK_STATE(lk_data, LINK_ST_H1_TX_LOW_VALUE_CONTENT);
@@ -345,6 +431,39 @@ enum hdcp_result hdcp_link_authenticate(struct hdcp_msg_info *msg_info)
 	return ret;
 }
 
+enum hdcp_result hdcp_link_authenticate(struct hdcp_msg_info *msg_info)
+{
+	struct hdcp_session_node *ss_node;
+	struct hdcp_link_node *lk_node;
+	struct hdcp_link_data *lk_data;
+	enum hdcp_result ret;
+	u64 start;
+	int phase;
+
+	/* find Session node which contains the Link */
+	ss_node = hdcp_session_list_find(msg_info->ss_handle, &g_hdcp_session_list);
+	if (!ss_node)
+		return HDCP_ERROR_INVALID_INPUT;
+
+	lk_node = hdcp_link_list_find(msg_info->lk_id, &ss_node->ss_data->ln);
+	if (!lk_node)
+		return HDCP_ERROR_INVALID_INPUT;
+
+	lk_data = lk_node->lk_data;
+
+	if (!lk_data)
+		return HDCP_ERROR_INVALID_INPUT;
+
+	start = ktime_get_ns();
+	/* state before the call, A0 moves on to A1 right away */
+	phase = hdcp_auth_phase(state_init_flag ? lk_data->state :
+				LINK_ST_A1_EXCHANGE_MASTER_KEY);
+	ret = __hdcp_link_authenticate(lk_data, msg_info);
+	hdcp_auth_account(lk_data, phase, start);
+
+	return ret;
+}
+
 enum hdcp_result hdcp_link_stream_manage(struct hdcp_stream_info *stream_info)
 {
 	struct hdcp_session_node *ss_node;
@@ -4,11 +4,112 @@
 #include "pwrcal-vclk.h"
 #include "pwrcal-dfs.h"
 
+#ifdef PWRCAL_TARGET_LINUX
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#endif
+
+/*
+ * Every clock operation of a transition goes through dfs_step(). Without
+ * a context recording them, as for the exported helpers, it is applied
+ * right away. A recording context instead appends it to a step list, or
+ * only counts it, without touching the hardware: with a known source
+ * level every decision below is taken from the table alone, which is what
+ * lets transitions be prebuilt.
+ */
+struct dfs_trans_ctx {
+	unsigned int rate_from;
+	unsigned int rate_switch;
+	unsigned int rate_to;
+	int record;
+	struct dfs_trans_step *steps;	/* NULL to count steps only */
+	int num_of_steps;
+};
 
+static int dfs_apply_step(struct dfs_table *table,
+			const struct dfs_trans_step *step,
+			unsigned int rate_from,
+			unsigned int rate_switch,
+			unsigned int rate_to)
+{
+	unsigned long long rate;
+	unsigned int from, to;
+
+	from = step->value ? rate_switch : rate_from;
+	to = step->value ? rate_to : rate_switch;
+
+	switch (step->op) {
+	case DFS_OP_DIV:
+		return pwrcal_div_set_ratio(step->clk, step->value);
+	case DFS_OP_MUX:
+		return pwrcal_mux_set_src(step->clk, step->value);
+	case DFS_OP_GATE:
+		if (step->value)
+			return pwrcal_gate_enable(step->clk);
+		return pwrcal_gate_disable(step->clk);
+	case DFS_OP_PLL:
+		rate = (unsigned long long)step->value * 1000;
+		if (rate != 0) {
+			if (pwrcal_pll_set_rate(step->clk, rate))
+				return -1;
+			if (pwrcal_pll_is_enabled(step->clk) != 1)
+				if (pwrcal_pll_enable(step->clk))
+					return -1;
+		} else {
+			if (pwrcal_pll_is_enabled(step->clk) != 0)
+				if (pwrcal_pll_disable(step->clk))
+					return -1;
+		}
+		return 0;
+	case DFS_OP_TRANS_PRE:
+		table->trans_pre(rate_from, rate_to);
+		return 0;
+	case DFS_OP_TRANS_POST:
+		table->trans_post(rate_from, rate_to);
+		return 0;
+	case DFS_OP_SWITCH_PRE:
+		table->switch_pre(from, to);
+		return 0;
+	case DFS_OP_SWITCH_POST:
+		table->switch_post(from, to);
+		return 0;
+	default:
+		break;
+	}
 
-unsigned int dfs_set_rate_switch(unsigned int rate_from,
+	return -1;
+}
+
+static int dfs_step(struct dfs_table *table, struct dfs_trans_ctx *ctx,
+			unsigned int op, struct pwrcal_clk *clk,
+			unsigned int value)
+{
+	struct dfs_trans_step step = {
+		.clk = clk,
+		.op = op,
+		.value = value,
+	};
+
+	if (ctx && ctx->record) {
+		if (ctx->steps)
+			ctx->steps[ctx->num_of_steps] = step;
+		ctx->num_of_steps++;
+		return 0;
+	}
+
+	if (ctx)
+		return dfs_apply_step(table, &step, ctx->rate_from,
+					ctx->rate_switch, ctx->rate_to);
+
+	return dfs_apply_step(table, &step, 0, 0, 0);
+}
+
+static unsigned int __dfs_set_rate_switch(unsigned int rate_from,
 					unsigned int rate_to,
-					struct dfs_table *table)
+					struct dfs_table *table,
+					struct dfs_trans_ctx *ctx)
 {
 	unsigned int rate_max;
 	int i;
@@ -18,13 +119,13 @@ unsigned int dfs_set_rate_switch(unsigned int rate_from,
 	for (i = 0; i < table->num_of_switches; i++) {
 		if (rate_max >= table->switches[i].switch_rate) {
 			if (is_div(table->switch_src_div))
-				if (pwrcal_div_set_ratio(
+				if (dfs_step(table, ctx, DFS_OP_DIV,
 					table->switch_src_div,
 					table->switches[i].div_value + 1))
 					goto errorout;
 
 			if (is_mux(table->switch_src_mux))
-				if (pwrcal_mux_set_src(
+				if (dfs_step(table, ctx, DFS_OP_MUX,
 					table->switch_src_mux,
 					table->switches[i].mux_value))
 					goto errorout;
@@ -38,56 +139,94 @@ errorout:
 	return 0;
 }
 
-int dfs_enable_switch(struct dfs_table *table)
+unsigned int dfs_set_rate_switch(unsigned int rate_from,
+					unsigned int rate_to,
+					struct dfs_table *table)
+{
+	return __dfs_set_rate_switch(rate_from, rate_to, table, NULL);
+}
+
+static int __dfs_enable_switch(struct dfs_table *table,
+				struct dfs_trans_ctx *ctx)
 {
 	if (is_gate(table->switch_src_gate))
-		if (pwrcal_gate_enable(table->switch_src_gate))
+		if (dfs_step(table, ctx, DFS_OP_GATE,
+				table->switch_src_gate, 1))
 			return -1;
 
 	if (is_mux(table->switch_src_usermux))
-		if (pwrcal_mux_set_src(table->switch_src_usermux, 1))
+		if (dfs_step(table, ctx, DFS_OP_MUX,
+				table->switch_src_usermux, 1))
 			return -1;
 
 	return 0;
 }
 
-int dfs_disable_switch(struct dfs_table *table)
+int dfs_enable_switch(struct dfs_table *table)
+{
+	return __dfs_enable_switch(table, NULL);
+}
+
+static int __dfs_disable_switch(struct dfs_table *table,
+				struct dfs_trans_ctx *ctx)
 {
 	if (is_mux(table->switch_src_usermux))
-		if (pwrcal_mux_set_src(table->switch_src_usermux, 0))
+		if (dfs_step(table, ctx, DFS_OP_MUX,
+				table->switch_src_usermux, 0))
 			return -1;
 
 	if (is_div(table->switch_src_div))
-		if (pwrcal_div_set_ratio(table->switch_src_div, 1))
+		if (dfs_step(table, ctx, DFS_OP_DIV,
+				table->switch_src_div, 1))
 			return -1;
 
 	if (is_gate(table->switch_src_gate))
-		if (pwrcal_gate_disable(table->switch_src_gate))
+		if (dfs_step(table, ctx, DFS_OP_GATE,
+				table->switch_src_gate, 0))
 			return -1;
 
 	return 0;
 }
 
-int dfs_use_switch(struct dfs_table *table)
+int dfs_disable_switch(struct dfs_table *table)
+{
+	return __dfs_disable_switch(table, NULL);
+}
+
+static int __dfs_use_switch(struct dfs_table *table,
+				struct dfs_trans_ctx *ctx)
 {
 	if (is_mux(table->switch_mux))
-		if (pwrcal_mux_set_src(table->switch_mux,
+		if (dfs_step(table, ctx, DFS_OP_MUX, table->switch_mux,
 					table->switch_use))
 			return -1;
 
 	return 0;
 }
 
-int dfs_not_use_switch(struct dfs_table *table)
+int dfs_use_switch(struct dfs_table *table)
+{
+	return __dfs_use_switch(table, NULL);
+}
+
+static int __dfs_not_use_switch(struct dfs_table *table,
+				struct dfs_trans_ctx *ctx)
 {
 	if (is_mux(table->switch_mux))
-		if (pwrcal_mux_set_src(table->switch_mux, table->switch_notuse))
+		if (dfs_step(table, ctx, DFS_OP_MUX, table->switch_mux,
+					table->switch_notuse))
 			return -1;
 
 	return 0;
 }
 
-int dfs_trans_div(int lv_from, int lv_to, struct dfs_table *table, int opt)
+int dfs_not_use_switch(struct dfs_table *table)
+{
+	return __dfs_not_use_switch(table, NULL);
+}
+
+static int __dfs_trans_div(int lv_from, int lv_to, struct dfs_table *table,
+				int opt, struct dfs_trans_ctx *ctx)
 {
 	unsigned int from;
 	unsigned int to;
@@ -128,7 +267,7 @@ int dfs_trans_div(int lv_from, int lv_to, struct dfs_table *table, int opt)
 			if (trans == 0)
 				continue;
 
-			if (pwrcal_div_set_ratio(clk, to + 1))
+			if (dfs_step(table, ctx, DFS_OP_DIV, clk, to + 1))
 				goto errorout;
 		}
 	}
@@ -139,7 +278,13 @@ errorout:
 	return -1;
 }
 
-int dfs_trans_pll(int lv_from, int lv_to, struct dfs_table *table, int opt)
+int dfs_trans_div(int lv_from, int lv_to, struct dfs_table *table, int opt)
+{
+	return __dfs_trans_div(lv_from, lv_to, table, opt, NULL);
+}
+
+static int __dfs_trans_pll(int lv_from, int lv_to, struct dfs_table *table,
+				int opt, struct dfs_trans_ctx *ctx)
 {
 	unsigned long long rate;
 	unsigned int from;
@@ -189,18 +334,8 @@ int dfs_trans_pll(int lv_from, int lv_to, struct dfs_table *table, int opt)
 			if (trans == 0)
 				continue;
 
-			rate = (unsigned long long)to * 1000;
-			if (rate != 0) {
-				if (pwrcal_pll_set_rate(clk, rate))
-					goto errorout;
-				if (pwrcal_pll_is_enabled(clk) != 1)
-					if (pwrcal_pll_enable(clk))
-						goto errorout;
-			} else {
-				if (pwrcal_pll_is_enabled(clk) != 0)
-					if (pwrcal_pll_disable(clk))
-						goto errorout;
-			}
+			if (dfs_step(table, ctx, DFS_OP_PLL, clk, to))
+				goto errorout;
 		}
 	}
 	return 0;
@@ -210,7 +345,13 @@ errorout:
 	return -1;
 }
 
-int dfs_trans_mux(int lv_from, int lv_to, struct dfs_table *table, int opt)
+int dfs_trans_pll(int lv_from, int lv_to, struct dfs_table *table, int opt)
+{
+	return __dfs_trans_pll(lv_from, lv_to, table, opt, NULL);
+}
+
+static int __dfs_trans_mux(int lv_from, int lv_to, struct dfs_table *table,
+				int opt, struct dfs_trans_ctx *ctx)
 {
 	unsigned int from;
 	unsigned int to;
@@ -252,7 +393,7 @@ int dfs_trans_mux(int lv_from, int lv_to, struct dfs_table *table, int opt)
 			if (trans == 0)
 				continue;
 
-			if (pwrcal_mux_set_src(clk, to) != 0)
+			if (dfs_step(table, ctx, DFS_OP_MUX, clk, to) != 0)
 				goto errorout;
 		}
 	}
@@ -264,7 +405,13 @@ errorout:
 	return -1;
 }
 
-int dfs_trans_gate(int lv_from, int lv_to, struct dfs_table *table, int opt)
+int dfs_trans_mux(int lv_from, int lv_to, struct dfs_table *table, int opt)
+{
+	return __dfs_trans_mux(lv_from, lv_to, table, opt, NULL);
+}
+
+static int __dfs_trans_gate(int lv_from, int lv_to, struct dfs_table *table,
+				int opt, struct dfs_trans_ctx *ctx)
 {
 	unsigned int from;
 	unsigned int to;
@@ -303,15 +450,17 @@ int dfs_trans_gate(int lv_from, int lv_to, struct dfs_table *table, int opt)
 			if (trans == 0)
 				continue;
 
-			if (to)
-				pwrcal_gate_enable(clk);
-			else
-				pwrcal_gate_disable(clk);
+			dfs_step(table, ctx, DFS_OP_GATE, clk, to ? 1 : 0);
 		}
 	}
 	return 0;
 }
 
+int dfs_trans_gate(int lv_from, int lv_to, struct dfs_table *table, int opt)
+{
+	return __dfs_trans_gate(lv_from, lv_to, table, opt, NULL);
+}
+
 int dfs_get_lv(unsigned int rate, struct dfs_table *table)
 {
 	int i;
@@ -332,78 +481,71 @@ int dfs_get_lv(unsigned int rate, struct dfs_table *table)
 
 
 
-static int transition(unsigned int rate_from,
-			unsigned int rate_to,
-			struct dfs_table *table)
+static int __transition(int lv_from, int lv_to, struct dfs_table *table,
+			struct dfs_trans_ctx *ctx)
 {
-	int lv_from, lv_to, lv_switch;
-	unsigned int rate_switch;
-
-	lv_from = dfs_get_lv(rate_from, table);
-	lv_to = dfs_get_lv(rate_to, table);
-
-	if (lv_from == lv_to)
-		return 0;
-
-	if (lv_from >= table->num_of_lv || lv_to >= table->num_of_lv)
-		goto errorout;
+	int lv_switch;
 
 	if (table->trans_pre)
-		table->trans_pre(rate_from, rate_to);
+		dfs_step(table, ctx, DFS_OP_TRANS_PRE, NULL, 0);
 
 	if (table->num_of_switches != 0) {
-		rate_switch = dfs_set_rate_switch(rate_from, rate_to, table);
-		lv_switch = dfs_get_lv(rate_switch, table);
+		ctx->rate_switch = __dfs_set_rate_switch(ctx->rate_from,
+						ctx->rate_to, table, ctx);
+		lv_switch = dfs_get_lv(ctx->rate_switch, table);
+		if (ctx->record && (lv_switch < 0 ||
+					lv_switch >= table->num_of_lv))
+			goto errorout;
 
-		if (dfs_enable_switch(table))
+		if (__dfs_enable_switch(table, ctx))
 			goto errorout;
-		if (dfs_trans_div(lv_from, lv_switch, table, TRANS_HIGH))
+		if (__dfs_trans_div(lv_from, lv_switch, table, TRANS_HIGH, ctx))
 			goto errorout;
 		if (table->switch_pre)
-			table->switch_pre(rate_from, rate_switch);
-		if (dfs_use_switch(table))
+			dfs_step(table, ctx, DFS_OP_SWITCH_PRE, NULL, 0);
+		if (__dfs_use_switch(table, ctx))
 			goto errorout;
 		if (table->switch_post)
-			table->switch_post(rate_from, rate_switch);
-		if (dfs_trans_mux(lv_from, lv_switch, table, TRANS_DIFF))
+			dfs_step(table, ctx, DFS_OP_SWITCH_POST, NULL, 0);
+		if (__dfs_trans_mux(lv_from, lv_switch, table, TRANS_DIFF, ctx))
 			goto errorout;
-		if (dfs_trans_div(lv_from, lv_switch, table, TRANS_LOW))
+		if (__dfs_trans_div(lv_from, lv_switch, table, TRANS_LOW, ctx))
 			goto errorout;
-		if (dfs_trans_pll(lv_from, lv_to, table, TRANS_DIFF))
+		if (__dfs_trans_pll(lv_from, lv_to, table, TRANS_DIFF, ctx))
 			goto errorout;
-		if (dfs_trans_div(lv_switch, lv_to, table, TRANS_HIGH))
+		if (__dfs_trans_div(lv_switch, lv_to, table, TRANS_HIGH, ctx))
 			goto errorout;
 		if (table->switch_pre)
-			table->switch_pre(rate_switch, rate_to);
-		if (dfs_not_use_switch(table))
+			dfs_step(table, ctx, DFS_OP_SWITCH_PRE, NULL, 1);
+		if (__dfs_not_use_switch(table, ctx))
 			goto errorout;
 		if (table->switch_post)
-			table->switch_post(rate_switch, rate_to);
-		if (dfs_trans_mux(lv_switch, lv_to, table, TRANS_DIFF))
+			dfs_step(table, ctx, DFS_OP_SWITCH_POST, NULL, 1);
+		if (__dfs_trans_mux(lv_switch, lv_to, table, TRANS_DIFF, ctx))
 			goto errorout;
-		if (dfs_trans_div(lv_switch, lv_to, table, TRANS_LOW))
+		if (__dfs_trans_div(lv_switch, lv_to, table, TRANS_LOW, ctx))
 			goto errorout;
-		if (dfs_disable_switch(table))
+		if (__dfs_disable_switch(table, ctx))
 			goto errorout;
 	} else {
-		if (dfs_trans_gate(lv_from, lv_to, table, TRANS_HIGH))
+		if (__dfs_trans_gate(lv_from, lv_to, table, TRANS_HIGH, ctx))
 			goto errorout;
-		if (dfs_trans_div(lv_from, lv_to, table, TRANS_HIGH))
+		if (__dfs_trans_div(lv_from, lv_to, table, TRANS_HIGH, ctx))
 			goto errorout;
-		if (dfs_trans_pll(lv_from, lv_to, table, TRANS_LOW))
+		if (__dfs_trans_pll(lv_from, lv_to, table, TRANS_LOW, ctx))
 			goto errorout;
-		if (dfs_trans_mux(lv_from, lv_to, table, TRANS_DIFF))
+		if (__dfs_trans_mux(lv_from, lv_to, table, TRANS_DIFF, ctx))
 			goto errorout;
-		if (dfs_trans_pll(lv_from, lv_to, table, TRANS_HIGH))
+		if (__dfs_trans_pll(lv_from, lv_to, table, TRANS_HIGH, ctx))
 			goto errorout;
-		if (dfs_trans_div(lv_from, lv_to, table, TRANS_LOW))
+		if (__dfs_trans_div(lv_from, lv_to, table, TRANS_LOW, ctx))
 			goto errorout;
-		if (dfs_trans_gate(lv_from, lv_to, table, TRANS_LOW))
+		if (__dfs_trans_gate(lv_from, lv_to, table, TRANS_LOW, ctx))
 			goto errorout;
 	}
 
 	if (table->trans_post)
-		table->trans_post(rate_from, rate_to);
+		dfs_step(table, ctx, DFS_OP_TRANS_POST, NULL, 0);
 
 	return 0;
 
@@ -411,6 +553,125 @@ errorout:
 	return -1;
 }
 
+#ifdef PWRCAL_TARGET_LINUX
+/*
+ * Transition cache
+ *
+ * Walking the member list level by level costs tens of us on every rate
+ * change before the hardware starts switching. As every decision is taken
+ * from the table, the steps of each (from, to) level pair are recorded
+ * once at boot into a flat list and replayed from there. A prebuilt
+ * sequence is checked against the table before it is used: all of its
+ * clocks must be of the right type, and following it from the source
+ * level must leave every member at the target level's setting. Rates not
+ * at a level, and pairs left out for space, take the walk as before.
+ */
+#define DFS_TRANS_CACHE_MAX_STEPS	4096
+
+static struct dfs_trans_seq *dfs_trans_cache_lookup(struct dfs_table *table,
+					unsigned int rate_from,
+					unsigned int rate_to,
+					int lv_from, int lv_to)
+{
+	struct dfs_trans_cache *cache = table->trans_cache;
+	struct dfs_trans_seq *seq;
+
+	if (!cache || lv_from < 0)
+		return NULL;
+
+	if (get_value(table, lv_from, 0) != rate_from ||
+			get_value(table, lv_to, 0) != rate_to)
+		return NULL;
+
+	seq = &cache->seqs[lv_from * table->num_of_lv + lv_to];
+	if (!seq->valid)
+		return NULL;
+
+	return seq;
+}
+
+static int dfs_trans_cache_apply(struct dfs_table *table,
+				struct dfs_trans_seq *seq,
+				unsigned int rate_from,
+				unsigned int rate_to)
+{
+	struct dfs_trans_step *step = table->trans_cache->steps + seq->first;
+	int i;
+
+	for (i = 0; i < seq->num_of_steps; i++, step++) {
+		if (dfs_apply_step(table, step, rate_from, seq->rate_switch,
+					rate_to)) {
+			pr_err("%s %s step %d\n", __func__,
+				step->clk ? step->clk->name : "callback", i);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+static void dfs_trans_account(struct dfs_table *table, int hit, ktime_t start)
+{
+	struct dfs_trans_cache *cache = table->trans_cache;
+	u64 ns;
+
+	if (!cache)
+		return;
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	if (hit) {
+		cache->hits++;
+		cache->hit_ns += ns;
+		cache->hit_max_ns = max_t(u64, cache->hit_max_ns, ns);
+	} else {
+		cache->misses++;
+		cache->miss_ns += ns;
+		cache->miss_max_ns = max_t(u64, cache->miss_max_ns, ns);
+	}
+}
+#endif
+
+static int transition(unsigned int rate_from,
+			unsigned int rate_to,
+			struct dfs_table *table)
+{
+	struct dfs_trans_ctx ctx = {
+		.rate_from = rate_from,
+		.rate_to = rate_to,
+	};
+	int lv_from, lv_to;
+	int ret;
+#ifdef PWRCAL_TARGET_LINUX
+	struct dfs_trans_seq *seq;
+	ktime_t start = ktime_get();
+#endif
+
+	lv_from = dfs_get_lv(rate_from, table);
+	lv_to = dfs_get_lv(rate_to, table);
+
+	if (lv_from == lv_to)
+		return 0;
+
+	if (lv_from >= table->num_of_lv || lv_to >= table->num_of_lv)
+		return -1;
+
+#ifdef PWRCAL_TARGET_LINUX
+	seq = dfs_trans_cache_lookup(table, rate_from, rate_to, lv_from, lv_to);
+	if (seq) {
+		ret = dfs_trans_cache_apply(table, seq, rate_from, rate_to);
+		dfs_trans_account(table, 1, start);
+		return ret;
+	}
+#endif
+
+	ret = __transition(lv_from, lv_to, table, &ctx);
+
+#ifdef PWRCAL_TARGET_LINUX
+	dfs_trans_account(table, 0, start);
+#endif
+	return ret;
+}
+
 static unsigned int get_rate(struct dfs_table *table)
 {
 	int l, m;
@@ -630,3 +891,243 @@ unsigned long dfs_get_min_freq(struct vclk *vclk)
 
 	return dfs->table->min_freq;
 }
+
+#ifdef PWRCAL_TARGET_LINUX
+static int dfs_trans_validate(struct dfs_table *table, int lv_from, int lv_to,
+				const struct dfs_trans_step *steps, int num)
+{
+	unsigned int cur[128];
+	struct pwrcal_clk *clk;
+	unsigned int to;
+	int i, m, ok;
+
+	if (table->num_of_members > ARRAY_SIZE(cur))
+		return -1;
+
+	for (m = 1; m < table->num_of_members; m++)
+		cur[m] = get_value(table, lv_from, m);
+
+	for (i = 0; i < num; i++) {
+		clk = steps[i].clk;
+		switch (steps[i].op) {
+		case DFS_OP_DIV:
+			ok = is_div(clk) && steps[i].value != 0;
+			break;
+		case DFS_OP_MUX:
+			ok = is_mux(clk);
+			break;
+		case DFS_OP_GATE:
+			ok = is_gate(clk);
+			break;
+		case DFS_OP_PLL:
+			ok = is_pll(clk);
+			break;
+		default:
+			ok = !clk;
+			break;
+		}
+		if (!ok)
+			return -1;
+		if (!clk)
+			continue;
+
+		for (m = 1; m < table->num_of_members; m++)
+			if (table->members[m] == clk)
+				break;
+		if (m == table->num_of_members)
+			continue;
+
+		if (steps[i].op == DFS_OP_DIV)
+			cur[m] = steps[i].value - 1;
+		else
+			cur[m] = steps[i].value;
+	}
+
+	for (m = 1; m < table->num_of_members; m++) {
+		clk = table->members[m];
+		to = get_value(table, lv_to, m);
+
+		if (is_gate(clk)) {
+			/* the walk through the switch leaves gates alone */
+			if (table->num_of_switches == 0 && !cur[m] != !to)
+				return -1;
+			continue;
+		}
+		if ((is_div(clk) || is_mux(clk) || is_pll(clk)) && cur[m] != to)
+			return -1;
+	}
+
+	return 0;
+}
+
+static struct dfs_trans_cache *dfs_trans_cache_build(struct dfs_table *table)
+{
+	struct dfs_trans_cache *cache;
+	struct dfs_trans_seq *seq;
+	struct dfs_trans_ctx ctx;
+	int num = table->num_of_lv;
+	int total = 0;
+	int i, j;
+
+	if (num <= 1)
+		return NULL;
+
+	cache = kzalloc(sizeof(*cache), GFP_KERNEL);
+	if (!cache)
+		return NULL;
+
+	cache->seqs = kcalloc(num * num, sizeof(*cache->seqs), GFP_KERNEL);
+	if (!cache->seqs)
+		goto err_seqs;
+
+	/* size every sequence first, to keep them in one flat list */
+	for (i = 0; i < num; i++) {
+		for (j = 0; j < num; j++) {
+			if (i == j || !get_value(table, i, 0) ||
+					!get_value(table, j, 0))
+				continue;
+			if (dfs_get_lv(get_value(table, i, 0), table) != i ||
+				dfs_get_lv(get_value(table, j, 0), table) != j)
+				continue;
+
+			memset(&ctx, 0, sizeof(ctx));
+			ctx.rate_from = get_value(table, i, 0);
+			ctx.rate_to = get_value(table, j, 0);
+			ctx.record = 1;
+			if (__transition(i, j, table, &ctx))
+				continue;
+			if (total + ctx.num_of_steps > DFS_TRANS_CACHE_MAX_STEPS)
+				continue;
+
+			seq = &cache->seqs[i * num + j];
+			seq->first = total;
+			seq->num_of_steps = ctx.num_of_steps;
+			seq->valid = 1;
+			total += ctx.num_of_steps;
+		}
+	}
+
+	if (!total)
+		goto err_steps;
+
+	cache->steps = kcalloc(total, sizeof(*cache->steps), GFP_KERNEL);
+	if (!cache->steps)
+		goto err_steps;
+	cache->num_of_steps = total;
+
+	for (i = 0; i < num * num; i++) {
+		seq = &cache->seqs[i];
+		if (!seq->valid)
+			continue;
+
+		memset(&ctx, 0, sizeof(ctx));
+		ctx.rate_from = get_value(table, i / num, 0);
+		ctx.rate_to = get_value(table, i % num, 0);
+		ctx.record = 1;
+		ctx.steps = cache->steps + seq->first;
+		__transition(i / num, i % num, table, &ctx);
+		seq->rate_switch = ctx.rate_switch;
+
+		if (ctx.num_of_steps != seq->num_of_steps ||
+			dfs_trans_validate(table, i / num, i % num,
+					ctx.steps, ctx.num_of_steps)) {
+			pr_warn("dfs: transition %d->%d not cached\n",
+					i / num, i % num);
+			seq->valid = 0;
+			continue;
+		}
+		cache->num_of_seqs++;
+	}
+
+	return cache;
+
+err_steps:
+	kfree(cache->seqs);
+err_seqs:
+	kfree(cache);
+	return NULL;
+}
+
+static int dfs_trans_cache_show(struct seq_file *s, void *unused)
+{
+	struct pwrcal_vclk_dfs *dfs;
+	struct dfs_trans_cache *cache;
+	unsigned long hits, misses;
+	u64 hit_ns, miss_ns, hit_max_ns, miss_max_ns;
+	unsigned long flag;
+	int i;
+
+	seq_puts(s, "domain             cached   steps      hits    misses  hit_avg_ns  hit_max_ns miss_avg_ns miss_max_ns\n");
+
+	for (i = 0; i < vclk_dfs_list_size; i++) {
+		dfs = vclk_dfs_list[i];
+		if (!dfs || !dfs->table || !dfs->table->trans_cache)
+			continue;
+		cache = dfs->table->trans_cache;
+
+		spin_lock_irqsave(dfs->lock, flag);
+		hits = cache->hits;
+		misses = cache->misses;
+		hit_ns = cache->hit_ns;
+		miss_ns = cache->miss_ns;
+		hit_max_ns = cache->hit_max_ns;
+		miss_max_ns = cache->miss_max_ns;
+		spin_unlock_irqrestore(dfs->lock, flag);
+
+		seq_printf(s, "%-16s %4d/%-4d %6d %9lu %9lu %11llu %11llu %11llu %11llu\n",
+				dfs->vclk.name, cache->num_of_seqs,
+				dfs->table->num_of_lv * (dfs->table->num_of_lv - 1),
+				cache->num_of_steps, hits, misses,
+				hits ? div64_u64(hit_ns, hits) : 0, hit_max_ns,
+				misses ? div64_u64(miss_ns, misses) : 0,
+				miss_max_ns);
+	}
+
+	return 0;
+}
+
+static int dfs_trans_cache_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, dfs_trans_cache_show, inode->i_private);
+}
+
+static const struct file_operations dfs_trans_cache_fops = {
+	.open		= dfs_trans_cache_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init dfs_trans_cache_init(void)
+{
+	struct pwrcal_vclk_dfs *dfs;
+	struct dfs_trans_cache *cache;
+	unsigned long flag;
+	int i;
+
+	for (i = 0; i < vclk_dfs_list_size; i++) {
+		dfs = vclk_dfs_list[i];
+		/* private transitions do not walk the table */
+		if (!dfs || !dfs->table || dfs->table->private_trans)
+			continue;
+
+		cache = dfs_trans_cache_build(dfs->table);
+		if (!cache)
+			continue;
+
+		spin_lock_irqsave(dfs->lock, flag);
+		dfs->table->trans_cache = cache;
+		spin_unlock_irqrestore(dfs->lock, flag);
+
+		pr_info("dfs: %s: %d transitions prebuilt in %d steps\n",
+				dfs->vclk.name, cache->num_of_seqs,
+				cache->num_of_steps);
+	}
+
+	debugfs_create_file("pwrcal_dfs_trans", S_IRUGO, NULL, NULL,
+				&dfs_trans_cache_fops);
+
+	return 0;
+}
+late_initcall(dfs_trans_cache_init);
+#endif
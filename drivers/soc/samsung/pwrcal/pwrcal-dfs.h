@@ -14,6 +14,46 @@
 #define get_value(_table, _level, _member)	\
 	(*(_table->rate_table + (_table->num_of_members * _level + _member)))
 
+/* clock operations of a transition */
+#define DFS_OP_DIV		0
+#define DFS_OP_MUX		1
+#define DFS_OP_GATE		2
+#define DFS_OP_PLL		3
+#define DFS_OP_TRANS_PRE	4
+#define DFS_OP_TRANS_POST	5
+#define DFS_OP_SWITCH_PRE	6	/* value 0: to the switch, 1: from it */
+#define DFS_OP_SWITCH_POST	7
+
+struct dfs_trans_step {
+	struct pwrcal_clk *clk;
+	unsigned int op;
+	unsigned int value;	/* ratio, source, gate on, or PLL rate in KHZ */
+};
+
+#ifdef PWRCAL_TARGET_LINUX
+struct dfs_trans_seq {
+	unsigned int rate_switch;
+	unsigned short first;		/* index in dfs_trans_cache.steps */
+	unsigned short num_of_steps;
+	unsigned char valid;
+};
+
+/* prebuilt transitions of a domain, indexed by lv_from * num_of_lv + lv_to */
+struct dfs_trans_cache {
+	struct dfs_trans_seq *seqs;
+	struct dfs_trans_step *steps;
+	int num_of_steps;
+	int num_of_seqs;
+
+	unsigned long hits;
+	unsigned long misses;
+	u64 hit_ns;
+	u64 miss_ns;
+	u64 hit_max_ns;
+	u64 miss_max_ns;
+};
+#endif
+
 
 extern unsigned int dfs_set_rate_switch(unsigned int rate_from,
 					unsigned int rate_to,
@@ -125,6 +125,8 @@ struct dfs_table {
 	int (*private_switch)(unsigned int rate_from, unsigned int rate_switch,
 					struct dfs_table *table);
 	unsigned long (*private_getrate)(struct dfs_table *table);
+
+	struct dfs_trans_cache *trans_cache;
 };
 
 /* dfs ops */
@@ -20,6 +20,7 @@
 
 #include <linux/init.h>
 #include <linux/export.h>
+#include <linux/moduleparam.h>
 #include <linux/file.h>
 #include <linux/fs.h>
 #include <linux/falloc.h>
@@ -47,6 +48,7 @@
  * @file_is_setup:	Boolean indicating the file is setup
  * @size:		The size of the mapping, in bytes
  * @prot_mask:		The allowed protection bits, as vm_flags
+ * @populate:		Boolean indicating the file is populated on setup
  *
  * The lifecycle of this structure is from our parent file's open() until
  * its release().
@@ -61,6 +63,7 @@ struct ashmem_area {
 	bool file_is_setup;
 	size_t size;
 	unsigned long prot_mask;
+	bool populate;
 };
 
 /**
@@ -93,6 +96,14 @@ static atomic_long_t lru_count;
 /* mmap_lock - protects mmap operations */
 static DEFINE_MUTEX(mmap_lock);
 
+/*
+ * populate_min - areas of at least this many bytes get all their pages
+ * allocated when first mapped, rather than one page per fault. 0 is off.
+ */
+static unsigned long populate_min;
+module_param(populate_min, ulong, 0644);
+MODULE_PARM_DESC(populate_min, "Populate areas this large on creation");
+
 static struct kmem_cache *ashmem_area_cachep __read_mostly;
 static struct kmem_cache *ashmem_range_cachep __read_mostly;
 
@@ -441,6 +452,12 @@ static int ashmem_mmap(struct file *file, struct vm_area_struct *vma)
 
 		if (do_setup && ret)
 			return ret;
+
+		/* best effort: what is not allocated now is on fault */
+		if (do_setup && (asma->populate ||
+				 (populate_min && size >= populate_min)))
+			vfs_fallocate(asma->file, FALLOC_FL_KEEP_SIZE, 0,
+				      PAGE_ALIGN(size));
 	}
 	get_file(asma->file);
 
@@ -466,13 +483,16 @@ static int ashmem_mmap(struct file *file, struct vm_area_struct *vma)
  * proceed without risk of deadlock (due to gfp_mask).
  *
  * We approximate LRU via least-recently-unpinned, jettisoning unpinned partial
- * chunks of ashmem regions LRU-wise one-at-a-time until we hit 'nr_to_scan'
- * pages freed.
+ * chunks of ashmem regions LRU-wise until we hit 'nr_to_scan' pages freed.
+ * Ranges next to each other in both the LRU and their area, as left by
+ * unpinning a region piecewise, are punched out of the file together.
  */
 static unsigned long
 ashmem_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 {
 	struct ashmem_range *range, *next;
+	struct file *file = NULL;
+	loff_t start = 0, end = 0;
 	unsigned long freed = 0;
 
 	/* We might recurse into filesystem code, so bail out if necessary */
@@ -483,19 +503,32 @@ ashmem_shrink_scan(struct shrinker *shrink, struct shrink_control *sc)
 		return -1;
 
 	list_for_each_entry_safe(range, next, &ashmem_lru_list, lru) {
-		loff_t start = range->pgstart * PAGE_SIZE;
-		loff_t end = (range->pgend + 1) * PAGE_SIZE;
+		loff_t rstart = range->pgstart * PAGE_SIZE;
+		loff_t rend = (range->pgend + 1) * PAGE_SIZE;
 
-		range->asma->file->f_op->fallocate(range->asma->file,
-				FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
-				start, end - start);
+		if (file == range->asma->file && (rstart == end || rend == start)) {
+			start = min(start, rstart);
+			end = max(end, rend);
+		} else {
+			if (file)
+				file->f_op->fallocate(file,
+					FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+					start, end - start);
+			file = range->asma->file;
+			start = rstart;
+			end = rend;
+		}
 		range->purged = ASHMEM_WAS_PURGED;
 		lru_del(range);
 
 		freed += range_size(range);
-		if (--sc->nr_to_scan <= 0)
+		if (freed >= sc->nr_to_scan)
 			break;
 	}
+	if (file)
+		file->f_op->fallocate(file,
+				FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+				start, end - start);
 	mutex_unlock(&list_lock);
 	return freed;
 }
@@ -766,6 +799,41 @@ static int ashmem_pin_unpin(struct ashmem_area *asma, unsigned long cmd,
 	return ret;
 }
 
+/*
+ * ashmem_populate - allocate the pages of a range up front
+ *
+ * Before the area is first mapped, the whole of it is marked to be
+ * populated when it is, whatever range is passed.
+ */
+static int ashmem_populate(struct ashmem_area *asma, void __user *p)
+{
+	struct ashmem_pin pin;
+	struct file *file;
+
+	if (copy_from_user(&pin, p, sizeof(pin)))
+		return -EFAULT;
+
+	file = READ_ONCE(asma->file);
+	if (!file) {
+		asma->populate = true;
+		return 0;
+	}
+
+	if (!pin.len)
+		pin.len = PAGE_ALIGN(asma->size) - pin.offset;
+
+	if ((pin.offset | pin.len) & ~PAGE_MASK)
+		return -EINVAL;
+
+	if (((__u32)-1) - pin.offset < pin.len)
+		return -EINVAL;
+
+	if (PAGE_ALIGN(asma->size) < pin.offset + pin.len)
+		return -EINVAL;
+
+	return vfs_fallocate(file, FALLOC_FL_KEEP_SIZE, pin.offset, pin.len);
+}
+
 static long ashmem_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	struct ashmem_area *asma = file->private_data;
@@ -800,6 +868,9 @@ static long ashmem_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 	case ASHMEM_GET_PIN_STATUS:
 		ret = ashmem_pin_unpin(asma, cmd, (void __user *)arg);
 		break;
+	case ASHMEM_POPULATE:
+		ret = ashmem_populate(asma, (void __user *)arg);
+		break;
 	case ASHMEM_PURGE_ALL_CACHES:
 		ret = -EPERM;
 		if (capable(CAP_SYS_ADMIN)) {
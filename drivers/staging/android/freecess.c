@@ -12,11 +12,14 @@
 #include <linux/module.h>
 #include <linux/netlink.h>
 #include <linux/skbuff.h>
+#include <linux/cgroup.h>
 #include <linux/freecess.h>
 #include <linux/freezer.h>
 #include <net/sock.h>
 #include <linux/hrtimer.h>
+#include <linux/kobject.h>
 #include <linux/proc_fs.h>
+#include <linux/sysfs.h>
 
 
 #define RET_OK   0
@@ -39,6 +42,41 @@ struct priv_data
 
 static freecess_hook mod_recv_handler[MOD_END];
 
+/*
+ * Frozen apps are kept in a child of the freezer hierarchy's root that
+ * stays FROZEN, and thawed by moving them to one that stays THAWED. The
+ * batch freezer moves every process of a uid in one go.
+ */
+static char *frozen_cgroup = "frozen";
+module_param(frozen_cgroup, charp, 0644);
+static char *thawed_cgroup = "thaw";
+module_param(thawed_cgroup, charp, 0644);
+/* thaw the target of a sync binder call right away, not through userspace */
+static bool binder_thaw = true;
+module_param(binder_thaw, bool, 0644);
+
+enum {
+	FREEZER_STAT_FREEZE,
+	FREEZER_STAT_THAW,
+	FREEZER_STAT_BINDER_THAW,
+	FREEZER_STAT_END,
+};
+
+static const char * const freezer_stat_names[FREEZER_STAT_END] = {
+	"freeze", "thaw", "binder_thaw",
+};
+
+struct freezer_stat {
+	unsigned long count;
+	unsigned long procs;
+	unsigned long errors;
+	u64 total_us;
+	u64 max_us;
+};
+
+static DEFINE_SPINLOCK(freezer_stat_lock);
+static struct freezer_stat freezer_stats[FREEZER_STAT_END];
+
 static int check_msg_type(int type)
 {
 	return (type < MSG_TYPE_END) && (type > 0);
@@ -175,6 +213,62 @@ int pkg_report(int target_uid)
 	return ret;
 }
 
+static int freecess_move_uid(uid_t uid, const char *name, int stat)
+{
+	struct freezer_stat *st = &freezer_stats[stat];
+	ktime_t start = ktime_get();
+	u64 us;
+	int ret;
+
+#ifdef CONFIG_CGROUP_FREEZER
+	ret = cgroup_attach_uid(&freezer_cgrp_subsys, name,
+				make_kuid(&init_user_ns, uid));
+#else
+	ret = -ENODEV;
+#endif
+	us = ktime_us_delta(ktime_get(), start);
+
+	spin_lock(&freezer_stat_lock);
+	st->count++;
+	if (ret < 0) {
+		st->errors++;
+	} else {
+		st->procs += ret;
+		st->total_us += us;
+		st->max_us = max(st->max_us, us);
+	}
+	spin_unlock(&freezer_stat_lock);
+
+	if (ret < 0)
+		pr_err("freecess: moving uid %d to %s failed, %d\n",
+		       uid, name, ret);
+	return ret;
+}
+
+/* freeze every process of @uid, returns how many or a negative errno */
+int freecess_freeze_uid(uid_t uid)
+{
+	return freecess_move_uid(uid, frozen_cgroup, FREEZER_STAT_FREEZE);
+}
+
+int freecess_thaw_uid(uid_t uid)
+{
+	return freecess_move_uid(uid, thawed_cgroup, FREEZER_STAT_THAW);
+}
+
+/*
+ * The caller of a sync binder transaction to a frozen app would otherwise
+ * wait for the report to reach userspace and the thaw to come back.
+ */
+int freecess_binder_thaw(struct task_struct *p)
+{
+	if (!binder_thaw)
+		return -EPERM;
+
+	return freecess_move_uid(task_uid(p).val, thawed_cgroup,
+				 FREEZER_STAT_BINDER_THAW);
+}
+
 int cfb_report(int target_uid, const char *reason)
 {
 	int ret = RET_OK;
@@ -247,6 +341,23 @@ static void recv_handler(struct sk_buff *skb)
 }
 
 
+static void freezer_recv_handler(void *buf, unsigned int len)
+{
+	struct kfreecess_msg_data *payload = buf;
+	struct priv_data data;
+
+	memset(&data, 0, sizeof(struct priv_data));
+	data.target_uid = payload->target_uid;
+	if (payload->target_uid < UID_MIN_VALUE)
+		data.flag = -EPERM;
+	else if (payload->flag == FREEZER_FREEZE)
+		data.flag = freecess_freeze_uid(payload->target_uid);
+	else
+		data.flag = freecess_thaw_uid(payload->target_uid);
+
+	mod_sendmsg(MSG_TO_USER, MOD_FREEZER, &data);
+}
+
 int register_kfreecess_hook(int mod, freecess_hook hook)
 {
 
@@ -270,6 +381,44 @@ int unregister_kfreecess_hook(int mod)
 	return RET_OK;
 }
 
+/* per kind: operations, processes moved, failures, mean and max time */
+static ssize_t stat_show(struct kobject *kobj, struct kobj_attribute *attr,
+			 char *buf)
+{
+	struct freezer_stat st[FREEZER_STAT_END];
+	ssize_t len = 0;
+	int i;
+
+	spin_lock(&freezer_stat_lock);
+	memcpy(st, freezer_stats, sizeof(st));
+	spin_unlock(&freezer_stat_lock);
+
+	for (i = 0; i < FREEZER_STAT_END; i++) {
+		unsigned long ok = st[i].count - st[i].errors;
+
+		len += scnprintf(buf + len, PAGE_SIZE - len,
+				 "%s: count %lu procs %lu errors %lu mean_us %llu max_us %llu\n",
+				 freezer_stat_names[i], st[i].count,
+				 st[i].procs, st[i].errors,
+				 ok ? div64_u64(st[i].total_us, ok) : 0,
+				 st[i].max_us);
+	}
+
+	return len;
+}
+
+static struct kobj_attribute stat_attr = __ATTR_RO(stat);
+
+static struct attribute *kfreecess_attrs[] = {
+	&stat_attr.attr,
+	NULL,
+};
+
+static struct attribute_group kfreecess_attr_group = {
+	.attrs = kfreecess_attrs,
+	.name = "freecess",
+};
+
 static int __init kfreecess_init(void)
 {
 	int ret = RET_ERR;
@@ -287,6 +436,10 @@ static int __init kfreecess_init(void)
 	for(i = 1; i<MOD_END; i++)
 		atomic_set(&bind_port[i], 0);
 
+	register_kfreecess_hook(MOD_FREEZER, freezer_recv_handler);
+	if (sysfs_create_group(kernel_kobj, &kfreecess_attr_group))
+		pr_err("%s: failed to create sysfs group\n", __func__);
+
 	atomic_set(&kfreecess_init_suc, 1);
 	return RET_OK;
 }
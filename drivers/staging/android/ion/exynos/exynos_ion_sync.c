@@ -1,4 +1,7 @@
+#include <linux/atomic.h>
+#include <linux/debugfs.h>
 #include <linux/dma-mapping.h>
+#include <linux/init.h>
 #include <linux/mutex.h>
 #include <linux/exynos_ion.h>
 
@@ -70,6 +73,29 @@ static void exynos_flush_sg(struct device *dev, size_t size,
 	__exynos_sync_sg_for_cpu(dev, size, sg, nents, dir)
 #define exynos_sync_all					flush_all_cpu_caches
 
+/* syncs for a device done, and skipped for buffers the cpu did not touch */
+static atomic_t exynos_ion_sync_done = ATOMIC_INIT(0);
+static atomic_t exynos_ion_sync_skipped = ATOMIC_INIT(0);
+
+/* called with buffer->lock held, false if there is nothing to write back */
+static bool exynos_ion_sync_needed(struct ion_buffer *buffer)
+{
+	if (!(buffer->private_flags & ION_PRIV_FLAG_CPU_DIRTY)) {
+		atomic_inc(&exynos_ion_sync_skipped);
+		return false;
+	}
+
+	atomic_inc(&exynos_ion_sync_done);
+	return true;
+}
+
+/* called with buffer->lock held once the buffer was written back */
+static void exynos_ion_sync_done_for_device(struct ion_buffer *buffer)
+{
+	if (!buffer->kmap_cnt && !buffer->cpu_map_cnt)
+		buffer->private_flags &= ~ION_PRIV_FLAG_CPU_DIRTY;
+}
+
 void exynos_ion_flush_dmabuf_for_device(struct device *dev,
 					struct dma_buf *dmabuf, size_t size)
 {
@@ -81,18 +107,27 @@ void exynos_ion_flush_dmabuf_for_device(struct device *dev,
 
 	mutex_lock(&buffer->lock);
 
+	if (!exynos_ion_sync_needed(buffer))
+		goto out;
+
 	pr_debug("%s: flushing for device %s, buffer: %p, size: %zd\n",
 		 __func__, dev ? dev_name(dev) : "null", buffer, size);
 
 	trace_ion_sync_start(_RET_IP_, dev, DMA_BIDIRECTIONAL, size,
 			     buffer->vaddr, 0, size >= ION_FLUSH_ALL_HIGHLIMIT);
 
-	exynos_flush_sg(dev, size, buffer->sg_table->sgl,
-			buffer->sg_table->nents);
+	/* walking a large buffer by lines takes longer than flushing all */
+	if (size >= ION_FLUSH_ALL_HIGHLIMIT)
+		exynos_sync_all();
+	else
+		exynos_flush_sg(dev, size, buffer->sg_table->sgl,
+				buffer->sg_table->nents);
 
 	trace_ion_sync_end(_RET_IP_, dev, DMA_BIDIRECTIONAL, size,
 			   buffer->vaddr, 0, size >= ION_FLUSH_ALL_HIGHLIMIT);
 
+	exynos_ion_sync_done_for_device(buffer);
+out:
 	mutex_unlock(&buffer->lock);
 }
 EXPORT_SYMBOL(exynos_ion_flush_dmabuf_for_device);
@@ -113,6 +148,9 @@ void exynos_ion_sync_dmabuf_for_device(struct device *dev,
 
 	mutex_lock(&buffer->lock);
 
+	if (!exynos_ion_sync_needed(buffer))
+		goto out;
+
 	pr_debug("%s: syncing for device %s, buffer: %p, size: %zd\n",
 			__func__, dev ? dev_name(dev) : "null", buffer, size);
 
@@ -130,6 +168,8 @@ void exynos_ion_sync_dmabuf_for_device(struct device *dev,
 	trace_ion_sync_end(_RET_IP_, dev, dir, size,
 			buffer->vaddr, 0, size >= ION_FLUSH_ALL_HIGHLIMIT);
 
+	exynos_ion_sync_done_for_device(buffer);
+out:
 	mutex_unlock(&buffer->lock);
 }
 EXPORT_SYMBOL(exynos_ion_sync_dmabuf_for_device);
@@ -240,3 +280,18 @@ void exynos_ion_sync_vaddr_for_cpu(struct device *dev,
 			vaddr, offset, size >= ION_FLUSH_ALL_HIGHLIMIT);
 }
 EXPORT_SYMBOL(exynos_ion_sync_vaddr_for_cpu);
+
+static int __init exynos_ion_sync_debugfs_init(void)
+{
+	struct dentry *root = debugfs_create_dir("ion_sync", NULL);
+
+	if (IS_ERR_OR_NULL(root))
+		return 0;
+
+	debugfs_create_atomic_t("done", 0444, root, &exynos_ion_sync_done);
+	debugfs_create_atomic_t("skipped", 0444, root,
+				&exynos_ion_sync_skipped);
+
+	return 0;
+}
+late_initcall(exynos_ion_sync_debugfs_init);
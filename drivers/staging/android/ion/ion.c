@@ -462,6 +462,8 @@ static struct ion_buffer *ion_buffer_create(struct ion_heap *heap,
 
 	buffer->dev = dev;
 	buffer->size = len;
+	/* zeroed, or used, through the cache */
+	buffer->private_flags |= ION_PRIV_FLAG_CPU_DIRTY;
 	INIT_LIST_HEAD(&buffer->vmas);
 	INIT_LIST_HEAD(&buffer->iovas);
 	mutex_init(&buffer->lock);
@@ -927,6 +929,7 @@ static void *ion_buffer_kmap_get(struct ion_buffer *buffer)
 		return vaddr;
 	buffer->vaddr = vaddr;
 	buffer->kmap_cnt++;
+	buffer->private_flags |= ION_PRIV_FLAG_CPU_DIRTY;
 
 	return vaddr;
 }
@@ -1390,6 +1393,31 @@ static const struct vm_operations_struct ion_vma_ops = {
 	.fault = ion_vm_fault,
 };
 
+/* mapped up front, only counted to know when the cpu lost its access */
+static void ion_cpu_vm_open(struct vm_area_struct *vma)
+{
+	struct ion_buffer *buffer = vma->vm_private_data;
+
+	mutex_lock(&buffer->lock);
+	buffer->cpu_map_cnt++;
+	buffer->private_flags |= ION_PRIV_FLAG_CPU_DIRTY;
+	mutex_unlock(&buffer->lock);
+}
+
+static void ion_cpu_vm_close(struct vm_area_struct *vma)
+{
+	struct ion_buffer *buffer = vma->vm_private_data;
+
+	mutex_lock(&buffer->lock);
+	buffer->cpu_map_cnt--;
+	mutex_unlock(&buffer->lock);
+}
+
+static const struct vm_operations_struct ion_cpu_vma_ops = {
+	.open = ion_cpu_vm_open,
+	.close = ion_cpu_vm_close,
+};
+
 static int ion_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 {
 	struct ion_buffer *buffer = dmabuf->priv;
@@ -1445,9 +1473,14 @@ static int ion_mmap(struct dma_buf *dmabuf, struct vm_area_struct *vma)
 	ret = buffer->heap->ops->map_user(buffer->heap, buffer, vma);
 	mutex_unlock(&buffer->lock);
 
-	if (ret)
+	if (ret) {
 		pr_err("%s: failure mapping buffer to userspace\n",
 		       __func__);
+	} else {
+		vma->vm_private_data = buffer;
+		vma->vm_ops = &ion_cpu_vma_ops;
+		ion_cpu_vm_open(vma);
+	}
 
 	ION_EVENT_MMAP(buffer, ION_EVENT_DONE());
 	trace_ion_mmap_end((unsigned long) buffer, buffer->size,
@@ -110,7 +110,7 @@ static int ion_heap_clear_pages(struct page **pages, int num, pgprot_t pgprot)
 
 	if (!addr)
 		return -ENOMEM;
-	memset(addr, 0, PAGE_SIZE * num);
+	clear_pages(addr, num);
 	vunmap(addr);
 
 	return 0;
@@ -124,6 +124,21 @@ static int ion_heap_sglist_zero(struct scatterlist *sgl, unsigned int nents,
 	struct sg_page_iter piter;
 	struct page *pages[32];
 
+	/*
+	 * Cached buffers are zeroed in place through the linear map, a whole
+	 * chunk at a time, instead of being remapped 32 pages at a time.
+	 */
+	if (!IS_ENABLED(CONFIG_HIGHMEM) &&
+	    pgprot_val(pgprot) == pgprot_val(PAGE_KERNEL)) {
+		struct scatterlist *sg;
+		int i;
+
+		for_each_sg(sgl, sg, nents, i)
+			clear_pages(page_address(sg_page(sg)),
+				    PAGE_ALIGN(sg->length) >> PAGE_SHIFT);
+		return 0;
+	}
+
 	for_each_sg_page(sgl, &piter, nents, 0) {
 		pages[p++] = sg_page_iter_page(&piter);
 		if (p == ARRAY_SIZE(pages)) {
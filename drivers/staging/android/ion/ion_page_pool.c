@@ -20,13 +20,20 @@
 #include <linux/fs.h>
 #include <linux/list.h>
 #include <linux/init.h>
+#include <linux/percpu.h>
+#include <linux/prezero.h>
 #include <linux/slab.h>
 #include <linux/swap.h>
 #include "ion_priv.h"
 
 void *ion_page_pool_alloc_pages(struct ion_page_pool *pool)
 {
-	struct page *page = alloc_pages(pool->gfp_mask, pool->order);
+	struct page *page = NULL;
+
+	if (!pool->order && (pool->gfp_mask & __GFP_ZERO))
+		page = prezero_page_get();
+	if (!page)
+		page = alloc_pages(pool->gfp_mask, pool->order);
 
 	if (!page)
 		return NULL;
@@ -49,25 +56,41 @@ static void ion_page_pool_free_pages(struct ion_page_pool *pool,
 	mod_zone_page_state(page_zone(page), NR_ION_HEAP, -(1 << pool->order));
 }
 
-static int ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
+/* per-cpu caches hold about 64KB of each order */
+#define ION_PCP_BATCH_PAGES	16
+
+static void ion_page_pool_lock(struct ion_page_pool *pool)
 {
-#ifdef CONFIG_DEBUG_LIST
-	BUG_ON(page->lru.next != LIST_POISON1 ||
-			page->lru.prev != LIST_POISON2);
-#endif
-	if (pool->cached)
-		ion_clear_page_clean(page);
+	if (!spin_trylock(&pool->lock)) {
+		pool->contended++;
+		spin_lock(&pool->lock);
+	}
+}
+
+/*
+ * Pages freed through the deferred free thread come zeroed and cleaned from
+ * the cache. They go to the head, where allocations take pages from, so an
+ * allocation finds them before pages that still need a flush.
+ */
+static void __ion_page_pool_add(struct ion_page_pool *pool, struct page *page)
+{
+	struct list_head *items;
+	bool clean = ion_get_page_clean(page);
 
-	spin_lock(&pool->lock);
 	if (PageHighMem(page)) {
-		list_add_tail(&page->lru, &pool->high_items);
+		items = &pool->high_items;
 		pool->high_count++;
 	} else {
-		list_add_tail(&page->lru, &pool->low_items);
+		items = &pool->low_items;
 		pool->low_count++;
 	}
-	spin_unlock(&pool->lock);
-	return 0;
+
+	if (clean) {
+		list_add(&page->lru, items);
+		pool->clean_count++;
+	} else {
+		list_add_tail(&page->lru, items);
+	}
 }
 
 static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high)
@@ -85,20 +108,91 @@ static struct page *ion_page_pool_remove(struct ion_page_pool *pool, bool high)
 	}
 
 	list_del(&page->lru);
+	if (ion_get_page_clean(page))
+		pool->clean_count--;
 	return page;
 }
 
+static void ion_page_pool_pcp_add(struct ion_page_pool_pcp *pcp,
+				  struct page *page)
+{
+	if (ion_get_page_clean(page))
+		list_add(&page->lru, &pcp->items);
+	else
+		list_add_tail(&page->lru, &pcp->items);
+	pcp->count++;
+}
+
+/* moves up to @nr pages from the tail of @pcp, dirty ones first */
+static void ion_page_pool_pcp_drain(struct ion_page_pool *pool,
+				    struct ion_page_pool_pcp *pcp, int nr)
+{
+	struct page *page;
+
+	ion_page_pool_lock(pool);
+	while (nr-- > 0 && pcp->count) {
+		page = list_last_entry(&pcp->items, struct page, lru);
+		list_del(&page->lru);
+		pcp->count--;
+		__ion_page_pool_add(pool, page);
+	}
+	spin_unlock(&pool->lock);
+}
+
+static void ion_page_pool_drain_all(struct ion_page_pool *pool)
+{
+	struct ion_page_pool_pcp *pcp;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock(&pcp->lock);
+		ion_page_pool_pcp_drain(pool, pcp, pcp->count);
+		spin_unlock(&pcp->lock);
+	}
+}
+
+int ion_page_pool_pcp_count(struct ion_page_pool *pool)
+{
+	int cpu, count = 0;
+
+	for_each_possible_cpu(cpu)
+		count += READ_ONCE(per_cpu_ptr(pool->pcp, cpu)->count);
+
+	return count;
+}
+
 struct page *ion_page_pool_alloc(struct ion_page_pool *pool)
 {
+	struct ion_page_pool_pcp *pcp;
 	struct page *page = NULL;
+	int nr;
 
 	BUG_ON(!pool);
 
-	spin_lock(&pool->lock);
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	if (!pcp->count && pool->low_count) {
+		ion_page_pool_lock(pool);
+		for (nr = 0; nr < pool->batch && pool->low_count; nr++)
+			ion_page_pool_pcp_add(pcp,
+					ion_page_pool_remove(pool, false));
+		spin_unlock(&pool->lock);
+	}
+	if (pcp->count) {
+		page = list_first_entry(&pcp->items, struct page, lru);
+		list_del(&page->lru);
+		pcp->count--;
+	}
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
+
+	if (page || !pool->high_count)
+		return page;
+
+	ion_page_pool_lock(pool);
 	if (pool->high_count)
 		page = ion_page_pool_remove(pool, true);
-	else if (pool->low_count)
-		page = ion_page_pool_remove(pool, false);
 	spin_unlock(&pool->lock);
 
 	return page;
@@ -106,13 +200,28 @@ struct page *ion_page_pool_alloc(struct ion_page_pool *pool)
 
 void ion_page_pool_free(struct ion_page_pool *pool, struct page *page)
 {
-	int ret;
+	struct ion_page_pool_pcp *pcp;
 
 	BUG_ON(pool->order != compound_order(page));
+#ifdef CONFIG_DEBUG_LIST
+	BUG_ON(page->lru.next != LIST_POISON1 ||
+			page->lru.prev != LIST_POISON2);
+#endif
 
-	ret = ion_page_pool_add(pool, page);
-	if (ret)
-		ion_page_pool_free_pages(pool, page);
+	if (PageHighMem(page)) {
+		ion_page_pool_lock(pool);
+		__ion_page_pool_add(pool, page);
+		spin_unlock(&pool->lock);
+		return;
+	}
+
+	pcp = get_cpu_ptr(pool->pcp);
+	spin_lock(&pcp->lock);
+	ion_page_pool_pcp_add(pcp, page);
+	if (pcp->count > pool->batch * 2)
+		ion_page_pool_pcp_drain(pool, pcp, pool->batch);
+	spin_unlock(&pcp->lock);
+	put_cpu_ptr(pool->pcp);
 }
 
 void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
@@ -122,7 +231,7 @@ void ion_page_pool_free_immediate(struct ion_page_pool *pool, struct page *page)
 
 static int ion_page_pool_total(struct ion_page_pool *pool, bool high)
 {
-	int count = pool->low_count;
+	int count = pool->low_count + ion_page_pool_pcp_count(pool);
 
 	if (high)
 		count += pool->high_count;
@@ -144,6 +253,8 @@ int ion_page_pool_shrink(struct ion_page_pool *pool, gfp_t gfp_mask,
 	if (nr_to_scan == 0)
 		return ion_page_pool_total(pool, high);
 
+	ion_page_pool_drain_all(pool);
+
 	while (freed < nr_to_scan) {
 		struct page *page;
 
@@ -168,10 +279,28 @@ struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order)
 {
 	struct ion_page_pool *pool = kmalloc(sizeof(struct ion_page_pool),
 					     GFP_KERNEL);
+	struct ion_page_pool_pcp *pcp;
+	int cpu;
+
 	if (!pool)
 		return NULL;
+
+	pool->pcp = alloc_percpu(struct ion_page_pool_pcp);
+	if (!pool->pcp) {
+		kfree(pool);
+		return NULL;
+	}
+	for_each_possible_cpu(cpu) {
+		pcp = per_cpu_ptr(pool->pcp, cpu);
+		spin_lock_init(&pcp->lock);
+		INIT_LIST_HEAD(&pcp->items);
+		pcp->count = 0;
+	}
+	pool->batch = max_t(int, ION_PCP_BATCH_PAGES >> order, 1);
+	pool->contended = 0;
 	pool->high_count = 0;
 	pool->low_count = 0;
+	pool->clean_count = 0;
 	INIT_LIST_HEAD(&pool->low_items);
 	INIT_LIST_HEAD(&pool->high_items);
 	pool->gfp_mask = gfp_mask | __GFP_COMP;
@@ -184,6 +313,8 @@ struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order)
 
 void ion_page_pool_destroy(struct ion_page_pool *pool)
 {
+	ion_page_pool_drain_all(pool);
+	free_percpu(pool->pcp);
 	kfree(pool);
 }
 
@@ -111,6 +111,8 @@ struct ion_buffer {
 	struct sg_table *sg_table;
 	struct page **pages;
 	struct list_head vmas;
+	/* user mappings not tracked in @vmas */
+	int cpu_map_cnt;
 	struct list_head iovas;
 	/* used to track orphaned buffers */
 	int handle_count;
@@ -202,6 +204,14 @@ struct ion_heap_ops {
  */
 #define ION_PRIV_FLAG_NEED_TO_FLUSH (1 << 1)
 
+/*
+ * The cpu may have written the buffer through its cache since it was last
+ * synced for a device: set while it has cpu mappings and until the sync
+ * after they are gone. Syncs for a device of a buffer without it are
+ * skipped, there is nothing to write back.
+ */
+#define ION_PRIV_FLAG_CPU_DIRTY (1 << 2)
+
 /**
  * struct ion_heap - represents a heap in the system
  * @node:		rb node to put the heap on the device's tree of heaps
@@ -468,6 +478,11 @@ void ion_carveout_free(struct ion_heap *heap, ion_phys_addr_t addr,
  * @low_count:		number of lowmem items in the pool
  * @high_items:		list of highmem items
  * @low_items:		list of lowmem items
+ * @clean_count:	number of items already zeroed and cleaned from the
+ *			cache, kept at the head of the lists
+ * @pcp:		per-cpu front caches of lowmem items
+ * @batch:		number of items moved between @pcp and the lists at once
+ * @contended:		number of times @lock was found taken
  * @mutex:		lock protecting this struct and especially the count
  *			item list
  * @gfp_mask:		gfp_mask to use from alloc
@@ -484,6 +499,10 @@ struct ion_page_pool {
 	int low_count;
 	struct list_head high_items;
 	struct list_head low_items;
+	int clean_count;
+	struct ion_page_pool_pcp __percpu *pcp;
+	int batch;
+	unsigned long contended;
 	spinlock_t lock;
 	gfp_t gfp_mask;
 	unsigned int order;
@@ -491,12 +510,24 @@ struct ion_page_pool {
 	struct plist_node list;
 };
 
+/*
+ * Buffers are allocated a page at a time, from several threads at once. A
+ * small cache per cpu takes most of those off the shared lock. Its lock is
+ * only taken from other cpus to drain it.
+ */
+struct ion_page_pool_pcp {
+	spinlock_t lock;
+	struct list_head items;
+	int count;
+};
+
 struct ion_page_pool *ion_page_pool_create(gfp_t gfp_mask, unsigned int order);
 void ion_page_pool_destroy(struct ion_page_pool *);
 void *ion_page_pool_alloc_pages(struct ion_page_pool *pool);
 struct page *ion_page_pool_alloc(struct ion_page_pool *);
 void ion_page_pool_free(struct ion_page_pool *, struct page *);
 void ion_page_pool_free_immediate(struct ion_page_pool *, struct page *);
+int ion_page_pool_pcp_count(struct ion_page_pool *pool);
 
 #ifdef CONFIG_ION_POOL_CACHE_POLICY
 static inline void ion_page_pool_alloc_set_cache_policy
@@ -183,6 +183,9 @@ static int ion_system_heap_allocate(struct ion_heap *heap,
 			if (!ion_buffer_cached(buffer))
 				ion_set_page_clean(page);
 		}
+		/* written through cached mappings until freed again */
+		if (ion_buffer_cached(buffer))
+			ion_clear_page_clean(page);
 		list_del(&page->lru);
 	}
 
@@ -215,11 +218,26 @@ static void ion_system_heap_free(struct ion_buffer *buffer)
 	 *  for security purposes (other allocations are zerod at
 	 *  alloc time
 	 */
-	if (!(buffer->private_flags & ION_PRIV_FLAG_SHRINKER_FREE))
-		ion_heap_buffer_zero(buffer);
+	if (!(buffer->private_flags & ION_PRIV_FLAG_SHRINKER_FREE) &&
+	    ion_heap_buffer_zero(buffer))
+		buffer->private_flags |= ION_PRIV_FLAG_SHRINKER_FREE;
 
-	for_each_sg(table->sgl, sg, table->nents, i)
+	for_each_sg(table->sgl, sg, table->nents, i) {
+		/*
+		 * This runs on the deferred free thread. Cleaning the cache
+		 * here lets the next allocation of the page, cached or not,
+		 * skip the flush. Uncached buffers were flushed when
+		 * allocated and zeroed through a write-combine mapping, so
+		 * they hold no dirty lines.
+		 */
+		if (!(buffer->private_flags & ION_PRIV_FLAG_SHRINKER_FREE)) {
+			if (ion_buffer_cached(buffer))
+				__flush_dcache_area(page_address(sg_page(sg)),
+						    sg->length);
+			ion_set_page_clean(sg_page(sg));
+		}
 		free_buffer_page(sys_heap, buffer, sg_page(sg));
+	}
 	sg_free_table(table);
 	kfree(table);
 }
@@ -296,6 +314,12 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 		seq_printf(s, "%d order %u lowmem pages in cached pool = %lu total\n",
 			   pool->low_count, pool->order,
 			   (PAGE_SIZE << pool->order) * pool->low_count);
+		seq_printf(s, "%d clean %d dirty order %u pages in cached pool\n",
+			   pool->clean_count, pool->high_count +
+			   pool->low_count - pool->clean_count, pool->order);
+		seq_printf(s, "%d order %u pages in cached per-cpu caches, %lu contended\n",
+			   ion_page_pool_pcp_count(pool), pool->order,
+			   pool->contended);
 	}
 
 	for (i = num_orders; i < (num_orders * 2); i++) {
@@ -307,6 +331,12 @@ static int ion_system_heap_debug_show(struct ion_heap *heap, struct seq_file *s,
 		seq_printf(s, "%d order %u lowmem pages in uncached pool = %lu total\n",
 			   pool->low_count, pool->order,
 			   (PAGE_SIZE << pool->order) * pool->low_count);
+		seq_printf(s, "%d clean %d dirty order %u pages in uncached pool\n",
+			   pool->clean_count, pool->high_count +
+			   pool->low_count - pool->clean_count, pool->order);
+		seq_printf(s, "%d order %u pages in uncached per-cpu caches, %lu contended\n",
+			   ion_page_pool_pcp_count(pool), pool->order,
+			   pool->contended);
 	}
 
 	return 0;
@@ -345,6 +375,7 @@ void show_ion_system_heap_pool_size(struct seq_file *s)
 		pool = system_heap->pools[i];
 		pool_size += (1 << pool->order) * pool->high_count;
 		pool_size += (1 << pool->order) * pool->low_count;
+		pool_size += (1 << pool->order) * ion_page_pool_pcp_count(pool);
 	}
 
 	if (s)
@@ -43,6 +43,9 @@
 #include <linux/profile.h>
 #include <linux/notifier.h>
 #include <linux/ratelimit.h>
+#include <linux/ktime.h>
+#include <linux/list_sort.h>
+#include <linux/vmpressure.h>
 
 #if defined(CONFIG_LMK_SKIP_KILL)
 #include <linux/delay.h>
@@ -67,11 +70,24 @@ static int lowmem_minfree[6] = {
 };
 static int lowmem_minfree_size = 4;
 static uint32_t lowmem_lmkcount = 0;
+static unsigned int lowmem_scan_last_us; /* victim selection latency */
+static unsigned int lowmem_scan_max_us;
 static int lmkd_count;
 static int lmkd_cricount;
 
 static unsigned long lowmem_deathpending_timeout;
 
+/*
+ * In stall mode, kill when tasks have been stalled in direct reclaim for
+ * more than lowmem_stall_pct percent of the vmpressure stall window, rather
+ * than on the minfree thresholds. Every LOWMEM_STALL_STEP percent above that
+ * moves one entry down the adj array, starting from its last entry.
+ */
+#define LOWMEM_STALL_STEP	10
+static bool lowmem_stall_mode;
+static unsigned int lowmem_stall_pct = 30;
+static unsigned long lowmem_stall_next; /* no stall kill before, in jiffies */
+
 #define lowmem_print(level, x...)			\
 	do {						\
 		if (lowmem_debug_level >= (level))	\
@@ -153,17 +169,372 @@ extern u64 zswap_pool_pages;
 extern atomic_t zswap_stored_pages;
 #endif
 
-static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
+struct lowmem_victim {
+	struct task_struct *task;
+	int tasksize;
+#if defined(CONFIG_ZSWAP)
+	int swap_rss;
+#endif
+	short oom_score_adj;
+};
+
+/*
+ * Check whether the process @tsk may be killed on behalf of @min_score_adj and
+ * fill @v if so. Returns 1 for a candidate, 0 if it must be skipped and -1 if
+ * an earlier victim is still dying and the scan should stop.
+ */
+static int lowmem_check_task(struct task_struct *tsk, short min_score_adj,
+			     struct lowmem_victim *v)
+{
+	struct task_struct *p;
+	short oom_score_adj;
+	int tasksize;
+#if defined(CONFIG_ZSWAP)
+	int zswap_stored_pages_temp;
+	int swap_rss;
+#endif
+
+	if (tsk->flags & PF_KTHREAD)
+		return 0;
+
+#if defined(CONFIG_ARM) || defined(CONFIG_ARM64)
+	if (test_task_flag(tsk, TIF_MEMALLOC))
+		return 0;
+#endif
+	p = find_lock_task_mm(tsk);
+	if (!p)
+		return 0;
+
+	if (test_tsk_thread_flag(p, TIF_MEMDIE)) {
+		task_unlock(p);
+
+		if (time_before_eq(jiffies, lowmem_deathpending_timeout))
+			return -1;
+
+		return 0;
+	}
+	if (p->state & TASK_UNINTERRUPTIBLE) {
+		task_unlock(p);
+		return 0;
+	}
+	oom_score_adj = p->signal->oom_score_adj;
+	if (oom_score_adj < min_score_adj) {
+		task_unlock(p);
+		return 0;
+	}
+
+#if defined(CONFIG_LMK_SKIP_KILL)
+	if (oom_score_adj == 200 &&
+	    (!strncmp(p->group_leader->comm, ".android.chrome", 15) ||
+		 !strncmp(p->group_leader->comm, "id.app.sbrowser", 15))) {
+		task_unlock(p);
+		return 0;
+	}
+#endif
+
+	tasksize = get_mm_rss(p->mm);
+#if defined(CONFIG_ZSWAP)
+	zswap_stored_pages_temp = atomic_read(&zswap_stored_pages);
+	if (zswap_stored_pages_temp) {
+		lowmem_print(3, "shown tasksize : %d\n", tasksize);
+		swap_rss = (int)zswap_pool_pages
+				* get_mm_counter(p->mm, MM_SWAPENTS)
+				/ zswap_stored_pages_temp;
+		tasksize += swap_rss;
+		lowmem_print(3, "real tasksize : %d\n", tasksize);
+	} else {
+		swap_rss = 0;
+	}
+#endif
+	task_unlock(p);
+	if (tasksize <= 0)
+		return 0;
+	if (same_thread_group(p, current))
+		return 0;
+
+	v->task = p;
+	v->tasksize = tasksize;
+#if defined(CONFIG_ZSWAP)
+	v->swap_rss = swap_rss;
+#endif
+	v->oom_score_adj = oom_score_adj;
+	return 1;
+}
+
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_TASK_INDEX
+/*
+ * Thread group leaders are indexed by oom_score_adj so that lowmem_scan() only
+ * has to look at the buckets at or above its threshold, highest first. Each
+ * bucket is kept sorted by the RSS last seen for its tasks, largest first,
+ * and a scan only samples the first LOWMEM_INDEX_PEEK candidates of a bucket
+ * again. The victim is therefore the largest task of its bucket within the
+ * accuracy of those samples, which is refreshed every time the bucket is hit.
+ */
+#define LOWMEM_INDEX_BUCKETS	(OOM_SCORE_ADJ_MAX - OOM_SCORE_ADJ_MIN + 1)
+#define LOWMEM_INDEX_PEEK	4
+#define LOWMEM_INDEX_BATCH	16	/* tasks looked at per bucket */
+
+static struct list_head lowmem_index[LOWMEM_INDEX_BUCKETS];
+static DECLARE_BITMAP(lowmem_index_used, LOWMEM_INDEX_BUCKETS);
+static DEFINE_SPINLOCK(lowmem_index_lock);
+static bool lowmem_index_ready;
+
+/* insert keeping the bucket sorted by lmk_rss, largest first */
+static void __lowmem_index_insert(struct task_struct *p, short adj)
+{
+	int idx = adj - OOM_SCORE_ADJ_MIN;
+	struct task_struct *pos;
+
+	list_for_each_entry(pos, &lowmem_index[idx], lmk_node)
+		if (pos->lmk_rss < p->lmk_rss)
+			break;
+	list_add_tail(&p->lmk_node, &pos->lmk_node);
+	p->lmk_adj = adj;
+	__set_bit(idx, lowmem_index_used);
+}
+
+static void __lowmem_index_remove(struct task_struct *p)
+{
+	int idx = p->lmk_adj - OOM_SCORE_ADJ_MIN;
+
+	list_del_init(&p->lmk_node);
+	if (list_empty(&lowmem_index[idx]))
+		__clear_bit(idx, lowmem_index_used);
+}
+
+static int lowmem_index_cmp(void *priv, struct list_head *a,
+			    struct list_head *b)
+{
+	struct task_struct *ta = list_entry(a, struct task_struct, lmk_node);
+	struct task_struct *tb = list_entry(b, struct task_struct, lmk_node);
+
+	if (ta->lmk_rss == tb->lmk_rss)
+		return 0;
+	return ta->lmk_rss < tb->lmk_rss ? 1 : -1;
+}
+
+/* called with tasklist_lock held for writing, from copy_process() */
+void lowmem_index_add(struct task_struct *p)
+{
+	if (!lowmem_index_ready || (p->flags & PF_KTHREAD))
+		return;
+
+	p->lmk_rss = p->mm ? get_mm_rss(p->mm) : 0;
+	spin_lock(&lowmem_index_lock);
+	if (list_empty(&p->lmk_node))
+		__lowmem_index_insert(p, p->signal->oom_score_adj);
+	spin_unlock(&lowmem_index_lock);
+}
+
+/* called with tasklist_lock held for writing, when @p is released */
+void lowmem_index_remove(struct task_struct *p)
+{
+	spin_lock(&lowmem_index_lock);
+	if (!list_empty(&p->lmk_node))
+		__lowmem_index_remove(p);
+	spin_unlock(&lowmem_index_lock);
+}
+
+/* called with tasklist_lock held for writing, when @new takes over @old */
+void lowmem_index_replace(struct task_struct *old, struct task_struct *new)
+{
+	spin_lock(&lowmem_index_lock);
+	if (!list_empty(&old->lmk_node)) {
+		new->lmk_adj = old->lmk_adj;
+		new->lmk_rss = old->lmk_rss;
+		list_replace_init(&old->lmk_node, &new->lmk_node);
+	}
+	spin_unlock(&lowmem_index_lock);
+}
+
+/* move the process of @task to the bucket of its current oom_score_adj */
+void lowmem_index_update(struct task_struct *task)
+{
+	struct task_struct *leader, *p;
+	unsigned long rss = 0;
+
+	rcu_read_lock();
+	p = find_lock_task_mm(task);
+	if (p) {
+		rss = get_mm_rss(p->mm);
+		task_unlock(p);
+	}
+
+	leader = task->group_leader;
+	spin_lock(&lowmem_index_lock);
+	if (!list_empty(&leader->lmk_node)) {
+		__lowmem_index_remove(leader);
+		if (rss)
+			leader->lmk_rss = rss;
+		__lowmem_index_insert(leader,
+				      READ_ONCE(leader->signal->oom_score_adj));
+	}
+	spin_unlock(&lowmem_index_lock);
+	rcu_read_unlock();
+}
+
+/*
+ * Find the process with the highest oom_score_adj not below @min_score_adj,
+ * and the largest among those. Called under rcu_read_lock(), which keeps the
+ * tasks of a batch valid once lowmem_index_lock has been dropped: checking
+ * them takes task locks, which nest outside the index lock on exit.
+ * Returns -1 if the scan should stop.
+ */
+static int lowmem_select_victim(short min_score_adj,
+			       struct lowmem_victim *selected)
+{
+	struct task_struct *batch[LOWMEM_INDEX_BATCH];
+	int rss[LOWMEM_INDEX_BATCH];
+	unsigned long end = LOWMEM_INDEX_BUCKETS;
+	unsigned long idx;
+	struct task_struct *tsk;
+	struct lowmem_victim v;
+	int nr, i, peeked, ret;
+	short adj;
+
+	for (;;) {
+		nr = 0;
+		spin_lock(&lowmem_index_lock);
+		idx = find_last_bit(lowmem_index_used, end);
+		adj = (int)idx + OOM_SCORE_ADJ_MIN;
+		if (idx < end && adj >= min_score_adj) {
+			list_for_each_entry(tsk, &lowmem_index[idx], lmk_node) {
+				batch[nr++] = tsk;
+				if (nr == LOWMEM_INDEX_BATCH)
+					break;
+			}
+		}
+		spin_unlock(&lowmem_index_lock);
+		if (!nr)
+			return 0;
+
+		peeked = 0;
+		for (i = 0; i < nr && peeked < LOWMEM_INDEX_PEEK; i++) {
+			rss[i] = 0;
+			ret = lowmem_check_task(batch[i], min_score_adj, &v);
+			if (ret < 0)
+				return ret;
+			if (!ret)
+				continue;
+
+			rss[i] = v.tasksize;
+			peeked++;
+			if (!selected->task || v.tasksize > selected->tasksize) {
+				*selected = v;
+				lowmem_print(2, "select '%s' (%d), adj %hd, size %d, to kill\n",
+					     v.task->comm, v.task->pid,
+					     v.oom_score_adj, v.tasksize);
+			}
+		}
+		nr = i;
+
+		if (peeked) {
+			spin_lock(&lowmem_index_lock);
+			for (i = 0; i < nr; i++) {
+				/* it may have left the bucket meanwhile */
+				if (!rss[i] || list_empty(&batch[i]->lmk_node) ||
+				    batch[i]->lmk_adj != adj)
+					continue;
+				batch[i]->lmk_rss = rss[i];
+			}
+			list_sort(NULL, &lowmem_index[idx], lowmem_index_cmp);
+			spin_unlock(&lowmem_index_lock);
+		}
+
+		if (selected->task)
+			return 0;
+		end = idx;
+	}
+}
+
+static void __init lowmem_index_init(void)
+{
+	struct task_struct *p;
+	int i;
+
+	for (i = 0; i < LOWMEM_INDEX_BUCKETS; i++)
+		INIT_LIST_HEAD(&lowmem_index[i]);
+
+	/* forks are serialised against this by tasklist_lock */
+	read_lock(&tasklist_lock);
+	lowmem_index_ready = true;
+	for_each_process(p) {
+		struct task_struct *t;
+
+		if (p->flags & PF_KTHREAD)
+			continue;
+
+		t = find_lock_task_mm(p);
+		if (t) {
+			p->lmk_rss = get_mm_rss(t->mm);
+			task_unlock(t);
+		}
+		spin_lock(&lowmem_index_lock);
+		if (list_empty(&p->lmk_node))
+			__lowmem_index_insert(p, p->signal->oom_score_adj);
+		spin_unlock(&lowmem_index_lock);
+	}
+	read_unlock(&tasklist_lock);
+}
+#else
+/* as above, by walking all processes */
+static int lowmem_select_victim(short min_score_adj,
+			      struct lowmem_victim *selected)
 {
 	struct task_struct *tsk;
-	struct task_struct *selected = NULL;
+	struct lowmem_victim v;
+	int ret;
+
+	for_each_process(tsk) {
+		ret = lowmem_check_task(tsk, min_score_adj, &v);
+		if (ret < 0)
+			return ret;
+		if (!ret)
+			continue;
+
+		if (selected->task) {
+			if (v.oom_score_adj < selected->oom_score_adj)
+				continue;
+			if (v.oom_score_adj == selected->oom_score_adj &&
+			    v.tasksize <= selected->tasksize)
+				continue;
+		}
+		*selected = v;
+		lowmem_print(2, "select '%s' (%d), adj %hd, size %d, to kill\n",
+			     v.task->comm, v.task->pid, v.oom_score_adj,
+			     v.tasksize);
+	}
+
+	return 0;
+}
+#endif
+
+static short lowmem_stall_adj(int array_size)
+{
+	unsigned int pct, level;
+
+	if (!array_size || time_before(jiffies, lowmem_stall_next))
+		return OOM_SCORE_ADJ_MAX + 1;
+
+	pct = vmpressure_stall_pct();
+	lowmem_print(3, "stall %u%% over %ums\n", pct,
+		     vmpressure_stall_window_ms());
+	if (pct < lowmem_stall_pct)
+		return OOM_SCORE_ADJ_MAX + 1;
+
+	level = min_t(unsigned int, (pct - lowmem_stall_pct) / LOWMEM_STALL_STEP,
+		      array_size - 1);
+	return lowmem_adj[array_size - 1 - level];
+}
+
+static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
+{
+	struct lowmem_victim victim = { .task = NULL };
+	struct task_struct *selected;
 	unsigned long rem = 0;
-	int tasksize;
 	int i;
 	short min_score_adj = OOM_SCORE_ADJ_MAX + 1;
 	int minfree = 0;
-	int selected_tasksize = 0;
-	short selected_oom_score_adj;
 	int array_size = ARRAY_SIZE(lowmem_adj);
 	int other_free = global_page_state(NR_FREE_PAGES) - totalreserve_pages;
 	int other_file = global_page_state(NR_FILE_PAGES) -
@@ -172,11 +543,8 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 						total_swapcache_pages();
 	unsigned long nr_cma_free = global_page_state(NR_FREE_CMA_PAGES);
 	static DEFINE_RATELIMIT_STATE(lmk_rs, DEFAULT_RATELIMIT_INTERVAL, 1);
-#if defined(CONFIG_ZSWAP)
-	int zswap_stored_pages_temp;
-	int swap_rss;
-	int selected_swap_rss;
-#endif
+	ktime_t start;
+	int ret;
 
 	if (!(sc->gfp_mask & __GFP_CMA))
 		other_free -= nr_cma_free;
@@ -185,11 +553,15 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		array_size = lowmem_adj_size;
 	if (lowmem_minfree_size < array_size)
 		array_size = lowmem_minfree_size;
-	for (i = 0; i < array_size; i++) {
-		minfree = lowmem_minfree[i];
-		if (other_free < minfree && other_file < minfree) {
-			min_score_adj = lowmem_adj[i];
-			break;
+	if (IS_ENABLED(CONFIG_VMPRESSURE_STALL) && lowmem_stall_mode) {
+		min_score_adj = lowmem_stall_adj(array_size);
+	} else {
+		for (i = 0; i < array_size; i++) {
+			minfree = lowmem_minfree[i];
+			if (other_free < minfree && other_file < minfree) {
+				min_score_adj = lowmem_adj[i];
+				break;
+			}
 		}
 	}
 
@@ -203,91 +575,20 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		return SHRINK_STOP;
 	}
 
-	selected_oom_score_adj = min_score_adj;
-
+	start = ktime_get();
 	rcu_read_lock();
-	for_each_process(tsk) {
-		struct task_struct *p;
-		short oom_score_adj;
-
-		if (tsk->flags & PF_KTHREAD)
-			continue;
-
-#if defined(CONFIG_ARM) || defined(CONFIG_ARM64)
-		if (test_task_flag(tsk, TIF_MEMALLOC))
-			continue;
-#endif
-		p = find_lock_task_mm(tsk);
-		if (!p)
-			continue;
-
-		if (test_tsk_thread_flag(p, TIF_MEMDIE)) {
-			task_unlock(p);
-
-		    if (time_before_eq(jiffies, lowmem_deathpending_timeout)) {
-				rcu_read_unlock();
-				return SHRINK_STOP;
-			}
-
-			continue;
-		}
-		if (p->state & TASK_UNINTERRUPTIBLE) {
-			task_unlock(p);
-			continue;
-		}
-		oom_score_adj = p->signal->oom_score_adj;
-		if (oom_score_adj < min_score_adj) {
-			task_unlock(p);
-			continue;
-		}
-
-#if defined(CONFIG_LMK_SKIP_KILL)
-		if (oom_score_adj == 200 &&
-		    (!strncmp(p->group_leader->comm, ".android.chrome", 15) ||
-			 !strncmp(p->group_leader->comm, "id.app.sbrowser", 15))) {
-			task_unlock(p);
-			continue;
-		}
-#endif
-
-		tasksize = get_mm_rss(p->mm);
-#if defined(CONFIG_ZSWAP)
-		zswap_stored_pages_temp = atomic_read(&zswap_stored_pages);
-		if (zswap_stored_pages_temp) {
-			lowmem_print(3, "shown tasksize : %d\n", tasksize);
-			swap_rss = (int)zswap_pool_pages
-					* get_mm_counter(p->mm, MM_SWAPENTS)
-					/ zswap_stored_pages_temp;
-			tasksize += swap_rss;
-			lowmem_print(3, "real tasksize : %d\n", tasksize);
-		} else {
-			swap_rss = 0;
-		}
-#endif
-		task_unlock(p);
-		if (tasksize <= 0)
-			continue;
-		if (same_thread_group(p, current))
-			continue;
-		if (selected) {
-			if (oom_score_adj < selected_oom_score_adj)
-				continue;
-			if (oom_score_adj == selected_oom_score_adj &&
-			    tasksize <= selected_tasksize)
-				continue;
-		}
-		selected = p;
-		selected_tasksize = tasksize;
-#if defined(CONFIG_ZSWAP)
-		selected_swap_rss = swap_rss;
-#endif
-		selected_oom_score_adj = oom_score_adj;
-		lowmem_print(2, "select '%s' (%d), adj %hd, size %d, to kill\n",
-			     p->comm, p->pid, oom_score_adj, tasksize);
+	ret = lowmem_select_victim(min_score_adj, &victim);
+	lowmem_scan_last_us = ktime_us_delta(ktime_get(), start);
+	lowmem_scan_max_us = max(lowmem_scan_max_us, lowmem_scan_last_us);
+	if (ret < 0) {
+		rcu_read_unlock();
+		return SHRINK_STOP;
 	}
+
+	selected = victim.task;
 	if (selected) {
 #if defined(CONFIG_ZSWAP)
-		int orig_tasksize = selected_tasksize - selected_swap_rss;
+		int orig_tasksize = victim.tasksize - victim.swap_rss;
 #endif
 		long cache_size = other_file * (long)(PAGE_SIZE / 1024);
 		long cache_limit = minfree * (long)(PAGE_SIZE / 1024);
@@ -309,13 +610,13 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 			        "   Free memory is %ldkB above reserved\n"
 					"   GFP mask is %#x(%pGg)\n",
 			     selected->comm, selected->pid, selected->tgid,
-			     selected_oom_score_adj,
+			     victim.oom_score_adj,
 #if defined(CONFIG_ZSWAP)
-			     selected_tasksize * (long)(PAGE_SIZE / 1024),
+			     victim.tasksize * (long)(PAGE_SIZE / 1024),
 			     orig_tasksize * (long)(PAGE_SIZE / 1024),
-			     selected_swap_rss * (long)(PAGE_SIZE / 1024),
+			     victim.swap_rss * (long)(PAGE_SIZE / 1024),
 #else
-			     selected_tasksize * (long)(PAGE_SIZE / 1024),
+			     victim.tasksize * (long)(PAGE_SIZE / 1024),
 #endif
 			     current->comm, current->pid,
 			     cache_size, cache_limit,
@@ -325,9 +626,12 @@ static unsigned long lowmem_scan(struct shrinker *s, struct shrink_control *sc)
 		show_mem_extra_call_notifiers();
 		show_memory();
 		lowmem_deathpending_timeout = jiffies + HZ;
-		rem += selected_tasksize;
+		/* let the window forget the stall that led to this kill */
+		lowmem_stall_next = jiffies +
+			msecs_to_jiffies(vmpressure_stall_window_ms());
+		rem += victim.tasksize;
 		lowmem_lmkcount++;
-		if ((selected_oom_score_adj <= 100) && (__ratelimit(&lmk_rs)))
+		if ((victim.oom_score_adj <= 100) && (__ratelimit(&lmk_rs)))
 			dump_tasks(NULL, NULL);
 	}
 
@@ -355,6 +659,9 @@ static struct shrinker lowmem_shrinker = {
 
 static int __init lowmem_init(void)
 {
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_TASK_INDEX
+	lowmem_index_init();
+#endif
 	register_shrinker(&lowmem_shrinker);
 	return 0;
 }
@@ -455,5 +762,11 @@ module_param_array_named(minfree, lowmem_minfree, uint, &lowmem_minfree_size,
 			 S_IRUGO | S_IWUSR);
 module_param_named(debug_level, lowmem_debug_level, uint, S_IRUGO | S_IWUSR);
 module_param_named(lmkcount, lowmem_lmkcount, uint, S_IRUGO);
+module_param_named(scan_last_us, lowmem_scan_last_us, uint, S_IRUGO);
+module_param_named(scan_max_us, lowmem_scan_max_us, uint, S_IRUGO | S_IWUSR);
+#ifdef CONFIG_VMPRESSURE_STALL
+module_param_named(stall_mode, lowmem_stall_mode, bool, S_IRUGO | S_IWUSR);
+module_param_named(stall_pct, lowmem_stall_pct, uint, S_IRUGO | S_IWUSR);
+#endif
 module_param_named(lmkd_count, lmkd_count, int, 0644);
 module_param_named(lmkd_cricount, lmkd_cricount, int, 0644);
@@ -44,5 +44,6 @@ struct ashmem_pin {
 #define ASHMEM_UNPIN		_IOW(__ASHMEMIOC, 8, struct ashmem_pin)
 #define ASHMEM_GET_PIN_STATUS	_IO(__ASHMEMIOC, 9)
 #define ASHMEM_PURGE_ALL_CACHES	_IO(__ASHMEMIOC, 10)
+#define ASHMEM_POPULATE		_IOW(__ASHMEMIOC, 11, struct ashmem_pin)
 
 #endif	/* _UAPI_LINUX_ASHMEM_H */
@@ -30,6 +30,7 @@
 #include <linux/slab.h>
 #include <linux/cpu.h>
 #include <linux/cpu_cooling.h>
+#include <linux/sched.h>
 #include <linux/exynos-ss.h>
 
 #include <trace/events/thermal.h>
@@ -87,6 +88,34 @@ static BLOCKING_NOTIFIER_HEAD(cpu_notifier);
 
 static enum tmu_noti_state_t cpu_tstate = TMU_NORMAL;
 
+/*
+ * Budget allocation: instead of each cluster being capped to the power it
+ * is granted, the sum of the grants is taken as one cpu budget and the
+ * scheduler is asked to move load off the fastest cluster whenever the
+ * slowest one would turn the same power into more work.
+ */
+static bool budget_alloc;
+module_param(budget_alloc, bool, 0644);
+MODULE_PARM_DESC(budget_alloc, "Spend the cpu power budget on HMP migration");
+
+static unsigned int budget_bias_step = 64;
+module_param(budget_bias_step, uint, 0644);
+MODULE_PARM_DESC(budget_bias_step, "HMP threshold bias change per update");
+
+static unsigned int budget_bias_max = 512;
+module_param(budget_bias_max, uint, 0644);
+MODULE_PARM_DESC(budget_bias_max, "Maximum HMP threshold bias");
+
+/* idle capacity in % the slowest cluster must have left to take load */
+static unsigned int budget_headroom = 25;
+module_param(budget_headroom, uint, 0644);
+MODULE_PARM_DESC(budget_headroom, "Idle % needed on the slow cluster");
+
+/* protected by cooling_list_lock */
+static u32 cpu_power_budget;
+static unsigned int cpu_budget_bias;
+static struct cpufreq_cooling_device *cpu_budget_fastest;
+
 /**
  * get_idr - function to get a unique id.
  * @idr: struct idr * handle used to create a id.
@@ -583,6 +612,126 @@ static u32 get_dynamic_power(struct cpufreq_cooling_device *cpufreq_device,
 	return (raw_cpu_power * cpufreq_device->last_load) / 100;
 }
 
+/* work per mW a cpu of @cpufreq_device does at @freq, in capacity units */
+static unsigned long budget_efficiency(struct cpufreq_cooling_device *cpufreq_device,
+				       unsigned int freq)
+{
+	u32 power = cpu_freq_to_power(cpufreq_device, freq);
+	unsigned long work;
+
+	work = cpufreq_device->capacity * freq / cpufreq_device->freq_table[0];
+	return (work << SCHED_CAPACITY_SHIFT) / max_t(u32, power, 1);
+}
+
+static void budget_set_bias(unsigned int bias)
+{
+	if (bias == cpu_budget_bias)
+		return;
+
+	cpu_budget_bias = bias;
+#ifdef CONFIG_SCHED_HMP
+	set_hmp_thermal_bias(bias);
+#endif
+}
+
+/**
+ * budget_rebalance() - share the cpu power budget between the clusters
+ *
+ * Called once a cluster had its grant converted to a state. While the
+ * fastest cluster is capped and the slowest would do more work per mW at
+ * the frequency its own grant allows, with enough idle capacity to take
+ * the load, the HMP thresholds are raised a step so that tasks drift down;
+ * otherwise they are lowered a step back.
+ */
+static void budget_rebalance(void)
+{
+	struct cpufreq_cooling_device *dev, *fast = NULL, *slow = NULL;
+	unsigned int bias = cpu_budget_bias, ncpus, idle;
+	u32 total = 0;
+
+	mutex_lock(&cooling_list_lock);
+	list_for_each_entry(dev, &cpufreq_dev_list, node) {
+		if (!dev->dyn_power_table)
+			continue;
+
+		total += dev->granted_power;
+		if (!fast || dev->capacity > fast->capacity)
+			fast = dev;
+		if (!slow || dev->capacity < slow->capacity)
+			slow = dev;
+	}
+	cpu_power_budget = total;
+	cpu_budget_fastest = fast;
+
+	if (!budget_alloc || !fast || fast == slow) {
+		bias = 0;
+		goto out;
+	}
+
+	ncpus = cpumask_weight(&slow->allowed_cpus);
+	idle = 100 - min(slow->last_load / max(ncpus, 1U), 100U);
+
+	if (fast->budget_state && idle >= budget_headroom &&
+	    budget_efficiency(slow, slow->freq_table[slow->budget_state]) >
+	    budget_efficiency(fast, fast->freq_table[fast->budget_state]))
+		bias = min(bias + budget_bias_step, budget_bias_max);
+	else
+		bias = bias > budget_bias_step ? bias - budget_bias_step : 0;
+out:
+	budget_set_bias(bias);
+	mutex_unlock(&cooling_list_lock);
+}
+
+/* the fastest cluster is no longer capped, nothing left to move */
+static void budget_release(struct cpufreq_cooling_device *cpufreq_device)
+{
+	mutex_lock(&cooling_list_lock);
+	if (cpufreq_device == cpu_budget_fastest)
+		budget_set_bias(0);
+	mutex_unlock(&cooling_list_lock);
+}
+
+static ssize_t budget_show(struct device *dev, struct device_attribute *attr,
+			   char *buf)
+{
+	struct thermal_cooling_device *cdev =
+		container_of(dev, struct thermal_cooling_device, device);
+	struct cpufreq_cooling_device *cpufreq_device = cdev->devdata;
+	ssize_t len;
+
+	mutex_lock(&cooling_list_lock);
+	len = scnprintf(buf, PAGE_SIZE,
+			"requested %u granted %u state %lu total %u bias %u\n",
+			cpufreq_device->requested_power,
+			cpufreq_device->granted_power,
+			cpufreq_device->budget_state,
+			cpu_power_budget, cpu_budget_bias);
+	mutex_unlock(&cooling_list_lock);
+
+	return len;
+}
+static DEVICE_ATTR_RO(budget);
+
+/**
+ * cpufreq_cooling_power_budget() - cpu power budget of the last update
+ * @bias: if not NULL, filled with the HMP threshold bias applied
+ *
+ * Return: the power in mW granted to all the cpu cooling devices.
+ */
+u32 cpufreq_cooling_power_budget(unsigned int *bias)
+{
+	u32 total;
+
+	mutex_lock(&cooling_list_lock);
+	total = cpu_power_budget;
+	if (bias)
+		*bias = cpu_budget_bias;
+	mutex_unlock(&cooling_list_lock);
+
+	return total;
+}
+EXPORT_SYMBOL_GPL(cpufreq_cooling_power_budget);
+
 /* cpufreq cooling device callback functions are defined below */
 
 /**
@@ -653,6 +802,9 @@ static int cpufreq_set_cur_state(struct thermal_cooling_device *cdev,
 	if (WARN_ON(state > cpufreq_device->max_level))
 		return -EINVAL;
 
+	if (!state)
+		budget_release(cpufreq_device);
+
 	/* Check if the old cooling action is same as new cooling action */
 	if (cpufreq_device->cpufreq_state == state)
 		return 0;
@@ -766,6 +918,7 @@ static int cpufreq_get_requested_power(struct thermal_cooling_device *cdev,
 	}
 
 	*power = static_power + dynamic_power;
+	cpufreq_device->requested_power = *power;
 	return 0;
 }
 
@@ -875,6 +1028,10 @@ static int cpufreq_power2state(struct thermal_cooling_device *cdev,
 		return -EINVAL;
 	}
 
+	cpufreq_device->granted_power = power;
+	cpufreq_device->budget_state = *state;
+	budget_rebalance();
+
 	trace_thermal_power_cpu_limit(&cpufreq_device->allowed_cpus,
 				      target_freq, *state, power);
 	return 0;
@@ -1058,6 +1215,12 @@ __cpufreq_cooling_register(struct device_node *np,
 
 	cpufreq_dev->clipped_freq = cpufreq_dev->freq_table[0];
 	cpufreq_dev->cool_dev = cool_dev;
+	cpufreq_dev->capacity = arch_scale_cpu_capacity(NULL,
+						cpumask_first(clip_cpus));
+
+	if (capacitance && device_create_file(&cool_dev->device,
+					      &dev_attr_budget))
+		pr_warn("%s: failed to create budget attribute\n", __func__);
 
 	mutex_lock(&cooling_cpufreq_lock);
 
@@ -1221,8 +1384,16 @@ void cpufreq_cooling_unregister(struct thermal_cooling_device *cdev)
 
 	mutex_lock(&cooling_list_lock);
 	list_del(&cpufreq_dev->node);
+	if (cpufreq_dev == cpu_budget_fastest) {
+		budget_set_bias(0);
+		cpu_budget_fastest = NULL;
+	}
 	mutex_unlock(&cooling_list_lock);
 
+	if (cpufreq_dev->dyn_power_table)
+		device_remove_file(&cpufreq_dev->cool_dev->device,
+				   &dev_attr_budget);
+
 	mutex_unlock(&cooling_cpufreq_lock);
 
 	thermal_cooling_device_unregister(cpufreq_dev->cool_dev);
@@ -58,6 +58,9 @@ struct power_table {
  * @gpufreq_val: integer value representing the absolute value of the clipped
  *	frequency.
  * @allowed_gpus: all the gpus involved for this gpufreq_cooling_device.
+ * @last_load: GPU utilization in percent at the last power request.
+ * @last_busy_pct: busy power of the GPU counter model at the last power
+ *	request, in percent of the power table, or 0 when the table was used.
  *
  * This structure is required for keeping information of each
  * gpufreq_cooling_device registered. In order to prevent corruption of this a
@@ -69,6 +72,7 @@ struct gpufreq_cooling_device {
 	unsigned long gpufreq_state;
 	unsigned int gpufreq_val;
 	u32 last_load;
+	u32 last_busy_pct;
 	struct power_table *dyn_power_table;
 	int dyn_power_table_entries;
 	get_static_t plat_get_static_power;
@@ -536,15 +540,26 @@ static int get_static_power(struct gpufreq_cooling_device *gpufreq_device,
  * @gpufreq_device:	&gpufreq_cooling_device for this cdev
  * @freq:	current frequency
  *
+ * The power drawn while busy is taken from the GPU counter model when the
+ * GPU driver has one, the power table assumes the heaviest workload.
+ *
  * Return: the dynamic power consumed by the gpus described by
  * @gpufreq_device.
  */
 static u32 get_dynamic_power(struct gpufreq_cooling_device *gpufreq_device,
 			     unsigned long freq)
 {
-	u32 raw_gpu_power;
+	u32 raw_gpu_power, busy_power;
 
 	raw_gpu_power = gpu_freq_to_power(gpufreq_device, freq);
+
+	gpufreq_device->last_busy_pct = 0;
+	if (raw_gpu_power && !gpu_dvfs_get_busy_power(freq, &busy_power)) {
+		gpufreq_device->last_busy_pct =
+			max_t(u32, busy_power * 100 / raw_gpu_power, 1);
+		raw_gpu_power = busy_power;
+	}
+
 	return (raw_gpu_power * gpufreq_device->last_load) / 100;
 }
 
@@ -827,6 +842,10 @@ static int gpufreq_power2state(struct thermal_cooling_device *cdev,
 
 	dyn_power = power - static_power;
 	dyn_power = dyn_power > 0 ? dyn_power : 0;
+	/* the table is for the heaviest workload, not for the current one */
+	if (gpufreq_device->last_busy_pct)
+		dyn_power = div_u64((u64)dyn_power * 100,
+				    gpufreq_device->last_busy_pct);
 	target_freq = gpu_power_to_freq(gpufreq_device, dyn_power);
 
 #if defined(CONFIG_SOC_EXYNOS7885_ANDROID_VERSION_P)
@@ -0,0 +1,564 @@
+/*
+ * A predictive thermal governor
+ *
+ * Reactive governors start throttling once a trip point is crossed, and
+ * under a sustained load the temperature then oscillates around it, with
+ * the performance following in a sawtooth. This governor instead models
+ * each thermal zone as a first order RC circuit,
+ *
+ *	dT/dt = a * P + c * (T - T_ambient)
+ *
+ * with P the power the zone's power actors consume, as estimated by their
+ * cooling devices, a the inverse of the thermal capacitance and c (< 0) the
+ * inverse of the time constant. a and c are fitted online, by least squares
+ * with exponential forgetting, from the samples the zone is polled with.
+ * The model forecasts the temperature horizon_ms ahead, and the power
+ * budget is the one the forecast reaches the control temperature with: it
+ * is cut before the trip, and gradually.
+ *
+ * The forecast error is kept per zone, in the predictive directory of the
+ * thermal zone device.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed "as is" WITHOUT ANY WARRANTY of any
+ * kind, whether express or implied; without even the implied warranty
+ * of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ */
+
+#define pr_fmt(fmt) "Predictive: " fmt
+
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
+#include <linux/mutex.h>
+#include <linux/slab.h>
+#include <linux/sysfs.h>
+#include <linux/thermal.h>
+
+#include "thermal_core.h"
+
+#define INVALID_TRIP -1
+
+/* model parameters are fixed point, with PRED_FRAC fractional bits */
+#define PRED_FRAC		16
+/* the sums of the fit forget 1/2^PRED_FORGET of themselves per sample */
+#define PRED_FORGET		6
+/* samples before the fitted parameters replace the initial ones */
+#define PRED_MIN_SAMPLES	16
+/* integration step of the forecast */
+#define PRED_STEP_MS		100
+/* forecasts waiting to be compared with the temperature they are for */
+#define PRED_PENDING		32
+
+/* how far ahead the temperature is forecast */
+static unsigned int horizon_ms = 3000;
+module_param(horizon_ms, uint, 0644);
+MODULE_PARM_DESC(horizon_ms, "Forecast horizon in ms");
+
+/* temperature the zones cool down to without power, in millicelsius */
+static int ambient = 30000;
+module_param(ambient, int, 0644);
+MODULE_PARM_DESC(ambient, "Ambient temperature in millicelsius");
+
+/*
+ * Initial model, until enough samples have been fitted: 10 C per W in
+ * steady state and a 20 s time constant.
+ */
+#define PRED_INIT_A		((1 << PRED_FRAC) / 2)
+#define PRED_INIT_C		(-(1 << PRED_FRAC) / 20)
+
+struct pred_forecast {
+	ktime_t due;
+	int temp;
+};
+
+/**
+ * struct predictive_params - state of the predictive governor for a zone
+ * @trip_switch_on:	first passive trip, from which the zone is polled
+ * @trip_control:	last passive trip, the temperature not to exceed
+ * @a:			heating per mW, in millicelsius/s, fixed point
+ * @c:			cooling per millicelsius above ambient, in 1/s,
+ *			fixed point and negative
+ * @s11, @s12, @s22, @s1y, @s2y:	sums of the least squares fit
+ * @samples:		samples fitted
+ * @last_time:		time of the previous sample, 0 if none
+ * @last_temp:		temperature of the previous sample
+ * @last_power:		power consumed since the previous sample, in mW
+ * @budget:		power budget, smoothed over the samples
+ * @pending:		forecasts made, to evaluate when they are due
+ * @err_*:		forecast error statistics, in millicelsius
+ * @lock:		protects the parameters and statistics from sysfs
+ */
+struct predictive_params {
+	int trip_switch_on;
+	int trip_control;
+
+	s64 a;
+	s64 c;
+	s64 s11, s12, s22, s1y, s2y;
+	unsigned long samples;
+
+	ktime_t last_time;
+	int last_temp;
+	u32 last_power;
+	u32 budget;
+
+	struct pred_forecast pending[PRED_PENDING];
+	unsigned int pending_head;
+	unsigned int pending_tail;
+
+	unsigned long err_count;
+	s64 err_abs_sum;
+	int err_max;
+	int err_last;
+
+	struct mutex lock;
+};
+
+static inline s64 pred_abs(s64 x)
+{
+	return x < 0 ? -x : x;
+}
+
+/* account a sample in the fit and solve it for a and c */
+static void pred_fit(struct predictive_params *p, s64 x1, s64 x2, s64 y)
+{
+	s64 s11, s12, s22, s1y, s2y, det, na, nc, a, c;
+	u64 big;
+	int shift = 0;
+
+	p->s11 += x1 * x1 - (p->s11 >> PRED_FORGET);
+	p->s12 += x1 * x2 - (p->s12 >> PRED_FORGET);
+	p->s22 += x2 * x2 - (p->s22 >> PRED_FORGET);
+	p->s1y += x1 * y - (p->s1y >> PRED_FORGET);
+	p->s2y += x2 * y - (p->s2y >> PRED_FORGET);
+
+	if (++p->samples < PRED_MIN_SAMPLES)
+		return;
+
+	/* scale the sums down for the products below to fit in 64 bits */
+	big = max(max(pred_abs(p->s11), pred_abs(p->s22)),
+		  max(pred_abs(p->s12),
+		      max(pred_abs(p->s1y), pred_abs(p->s2y))));
+	while (big >= (1ULL << 30)) {
+		big >>= 1;
+		shift++;
+	}
+	s11 = p->s11 >> shift;
+	s12 = p->s12 >> shift;
+	s22 = p->s22 >> shift;
+	s1y = p->s1y >> shift;
+	s2y = p->s2y >> shift;
+
+	/* power and temperature moving together cannot be told apart */
+	det = s11 * s22 - s12 * s12;
+	if ((det >> PRED_FRAC) == 0)
+		return;
+
+	na = s1y * s22 - s2y * s12;
+	nc = s11 * s2y - s12 * s1y;
+	a = div64_s64(na, det >> PRED_FRAC);
+	c = div64_s64(nc, det >> PRED_FRAC);
+
+	/* keep the previous model over a non physical one */
+	if (a <= 0 || c >= 0)
+		return;
+
+	p->a = a;
+	p->c = c;
+}
+
+/* temperature horizon_ms after @temp at a constant @power */
+static int pred_forecast(struct predictive_params *p, int temp, u32 power)
+{
+	unsigned int steps = DIV_ROUND_UP(horizon_ms, PRED_STEP_MS);
+	s64 t = temp;
+
+	while (steps--)
+		t += div_s64((p->a * power + p->c * (t - ambient)) * PRED_STEP_MS,
+			     1000LL << PRED_FRAC);
+
+	return clamp_t(s64, t, INT_MIN, INT_MAX);
+}
+
+/* compare the forecasts due by now with the temperature */
+static void pred_check_forecasts(struct predictive_params *p, ktime_t now,
+				 int temp)
+{
+	while (p->pending_tail != p->pending_head) {
+		struct pred_forecast *f = &p->pending[p->pending_tail];
+		int err;
+
+		if (ktime_before(now, f->due))
+			break;
+
+		err = temp - f->temp;
+		p->err_count++;
+		p->err_abs_sum += pred_abs(err);
+		p->err_max = max_t(int, p->err_max, pred_abs(err));
+		p->err_last = err;
+		p->pending_tail = (p->pending_tail + 1) % PRED_PENDING;
+	}
+}
+
+static void pred_add_forecast(struct predictive_params *p, ktime_t now,
+			      int temp)
+{
+	unsigned int next = (p->pending_head + 1) % PRED_PENDING;
+
+	/* polled faster than the horizon allows to track: drop the oldest */
+	if (next == p->pending_tail)
+		p->pending_tail = (p->pending_tail + 1) % PRED_PENDING;
+
+	p->pending[p->pending_head].due = ktime_add_ms(now, horizon_ms);
+	p->pending[p->pending_head].temp = temp;
+	p->pending_head = next;
+}
+
+/*
+ * Give each actor a share of @budget in proportion of its request, none
+ * more than its maximum, the surplus going to those below theirs.
+ */
+static void pred_divide(u32 *req_power, u32 *max_power, u32 *granted,
+			int num_actors, u32 total_req, u32 budget)
+{
+	u32 surplus = 0, room = 0;
+	int i;
+
+	if (!total_req)
+		total_req = 1;
+
+	for (i = 0; i < num_actors; i++) {
+		granted[i] = div_u64((u64)req_power[i] * budget, total_req);
+		if (granted[i] > max_power[i]) {
+			surplus += granted[i] - max_power[i];
+			granted[i] = max_power[i];
+		}
+		room += max_power[i] - granted[i];
+	}
+
+	if (!surplus || !room)
+		return;
+
+	surplus = min(surplus, room);
+	for (i = 0; i < num_actors; i++)
+		granted[i] += div_u64((u64)(max_power[i] - granted[i]) * surplus,
+				      room);
+}
+
+static int predictive_control(struct thermal_zone_device *tz, int control_temp,
+			      bool switched_on)
+{
+	struct predictive_params *p = tz->governor_data;
+	struct thermal_instance *instance;
+	u32 *req_power, *max_power, *granted;
+	u32 total_req = 0, total_max = 0, budget;
+	int temp = tz->temperature;
+	int i, num_actors = 0, t0, t1, forecast;
+	ktime_t now = ktime_get();
+	int ret = 0;
+
+	mutex_lock(&tz->lock);
+
+	list_for_each_entry(instance, &tz->thermal_instances, tz_node)
+		if (instance->trip == p->trip_control &&
+		    cdev_is_power_actor(instance->cdev))
+			num_actors++;
+
+	if (!num_actors) {
+		ret = -ENODEV;
+		goto unlock;
+	}
+
+	req_power = kcalloc(num_actors * 3, sizeof(*req_power), GFP_KERNEL);
+	if (!req_power) {
+		ret = -ENOMEM;
+		goto unlock;
+	}
+	max_power = &req_power[num_actors];
+	granted = &req_power[2 * num_actors];
+
+	i = 0;
+	list_for_each_entry(instance, &tz->thermal_instances, tz_node) {
+		struct thermal_cooling_device *cdev = instance->cdev;
+
+		if (instance->trip != p->trip_control ||
+		    !cdev_is_power_actor(cdev))
+			continue;
+
+		/* at the current frequency and load: what is consumed now */
+		if (cdev->ops->get_requested_power(cdev, tz, &req_power[i]))
+			continue;
+		if (power_actor_get_max_power(cdev, tz, &max_power[i]))
+			continue;
+
+		total_req += req_power[i];
+		total_max += max_power[i];
+		i++;
+	}
+	num_actors = i;
+
+	mutex_lock(&p->lock);
+
+	if (p->last_time.tv64) {
+		s64 dt_ms = ktime_ms_delta(now, p->last_time);
+
+		/* too close to measure a slope, or too far apart to trust */
+		if (dt_ms >= 10 && dt_ms <= 10 * MSEC_PER_SEC)
+			pred_fit(p, p->last_power, p->last_temp - ambient,
+				 div_s64((s64)(temp - p->last_temp) *
+					 MSEC_PER_SEC, dt_ms));
+	}
+	p->last_time = now;
+	p->last_temp = temp;
+	p->last_power = total_req;
+
+	pred_check_forecasts(p, now, temp);
+	forecast = pred_forecast(p, temp, total_req);
+	pred_add_forecast(p, now, forecast);
+
+	if (!switched_on && forecast <= control_temp) {
+		/* nothing to do yet: release the actors */
+		p->budget = total_max;
+		budget = total_max;
+	} else {
+		/* the forecast is linear in the power */
+		t0 = pred_forecast(p, temp, 0);
+		t1 = pred_forecast(p, temp, total_max);
+		if (t1 <= t0 || control_temp >= t1)
+			budget = total_max;
+		else if (control_temp <= t0)
+			budget = 0;
+		else
+			budget = div_s64((s64)(control_temp - t0) * total_max,
+					 t1 - t0);
+
+		/* halfway there each sample, for the cap to move smoothly */
+		p->budget = min(p->budget, total_max);
+		p->budget = (p->budget + budget) / 2;
+		budget = p->budget;
+	}
+
+	mutex_unlock(&p->lock);
+
+	pred_divide(req_power, max_power, granted, num_actors, total_req,
+		    budget);
+
+	i = 0;
+	list_for_each_entry(instance, &tz->thermal_instances, tz_node) {
+		if (instance->trip != p->trip_control ||
+		    !cdev_is_power_actor(instance->cdev))
+			continue;
+		if (i == num_actors)
+			break;
+
+		power_actor_set_power(instance->cdev, instance, granted[i]);
+		i++;
+	}
+
+	kfree(req_power);
+unlock:
+	mutex_unlock(&tz->lock);
+
+	return ret;
+}
+
+/* the first and last passive trips, as the power allocator takes them */
+static void get_governor_trips(struct thermal_zone_device *tz,
+			       struct predictive_params *p)
+{
+	int i, last_active, last_passive;
+	bool found_first_passive;
+
+	found_first_passive = false;
+	last_active = INVALID_TRIP;
+	last_passive = INVALID_TRIP;
+
+	for (i = 0; i < tz->trips; i++) {
+		enum thermal_trip_type type;
+
+		if (tz->ops->get_trip_type(tz, i, &type))
+			continue;
+
+		if (type == THERMAL_TRIP_PASSIVE) {
+			if (!found_first_passive) {
+				p->trip_switch_on = i;
+				found_first_passive = true;
+			} else {
+				last_passive = i;
+			}
+		} else if (type == THERMAL_TRIP_ACTIVE) {
+			last_active = i;
+		} else {
+			break;
+		}
+	}
+
+	if (last_passive != INVALID_TRIP) {
+		p->trip_control = last_passive;
+	} else if (found_first_passive) {
+		p->trip_control = p->trip_switch_on;
+		p->trip_switch_on = last_active;
+	} else {
+		p->trip_switch_on = INVALID_TRIP;
+		p->trip_control = last_active;
+	}
+}
+
+/*
+ * sysfs parts below
+ */
+
+static struct predictive_params *dev_to_params(struct device *dev)
+{
+	struct thermal_zone_device *tz =
+		container_of(dev, struct thermal_zone_device, device);
+
+	return tz->governor_data;
+}
+
+static ssize_t forecast_error_show(struct device *dev,
+				   struct device_attribute *attr, char *buf)
+{
+	struct predictive_params *p = dev_to_params(dev);
+	ssize_t len;
+
+	mutex_lock(&p->lock);
+	len = sprintf(buf, "count %lu mean_abs %lld max_abs %d last %d\n",
+		      p->err_count,
+		      p->err_count ? div64_s64(p->err_abs_sum, p->err_count) : 0,
+		      p->err_max, p->err_last);
+	mutex_unlock(&p->lock);
+
+	return len;
+}
+
+static ssize_t forecast_error_store(struct device *dev,
+				    struct device_attribute *attr,
+				    const char *buf, size_t count)
+{
+	struct predictive_params *p = dev_to_params(dev);
+
+	mutex_lock(&p->lock);
+	p->err_count = 0;
+	p->err_abs_sum = 0;
+	p->err_max = 0;
+	p->err_last = 0;
+	mutex_unlock(&p->lock);
+
+	return count;
+}
+
+/* the model, as steady state rise per W in millicelsius and tau in ms */
+static ssize_t model_show(struct device *dev, struct device_attribute *attr,
+			  char *buf)
+{
+	struct predictive_params *p = dev_to_params(dev);
+	ssize_t len;
+
+	mutex_lock(&p->lock);
+	len = sprintf(buf, "r_mc_per_w %lld tau_ms %lld samples %lu budget_mw %u\n",
+		      div64_s64(p->a * 1000, -p->c),
+		      div64_s64((s64)MSEC_PER_SEC << PRED_FRAC, -p->c),
+		      p->samples, p->budget);
+	mutex_unlock(&p->lock);
+
+	return len;
+}
+
+static DEVICE_ATTR_RW(forecast_error);
+static DEVICE_ATTR_RO(model);
+
+static struct attribute *predictive_attrs[] = {
+	&dev_attr_forecast_error.attr,
+	&dev_attr_model.attr,
+	NULL,
+};
+
+static const struct attribute_group predictive_attr_group = {
+	.name = "predictive",
+	.attrs = predictive_attrs,
+};
+
+static int predictive_bind(struct thermal_zone_device *tz)
+{
+	struct predictive_params *p;
+
+	p = kzalloc(sizeof(*p), GFP_KERNEL);
+	if (!p)
+		return -ENOMEM;
+
+	mutex_init(&p->lock);
+	p->a = PRED_INIT_A;
+	p->c = PRED_INIT_C;
+	p->budget = U32_MAX;
+	get_governor_trips(tz, p);
+
+	tz->governor_data = p;
+
+	if (sysfs_create_group(&tz->device.kobj, &predictive_attr_group))
+		dev_warn(&tz->device, "predictive: failed to create sysfs group\n");
+
+	return 0;
+}
+
+static void predictive_unbind(struct thermal_zone_device *tz)
+{
+	sysfs_remove_group(&tz->device.kobj, &predictive_attr_group);
+
+	kfree(tz->governor_data);
+	tz->governor_data = NULL;
+}
+
+static int predictive_throttle(struct thermal_zone_device *tz, int trip)
+{
+	struct predictive_params *p = tz->governor_data;
+	int switch_on_temp, control_temp;
+	bool switched_on = true;
+	int ret;
+
+	/* called for every trip, once is enough */
+	if (trip != p->trip_control)
+		return 0;
+
+	ret = tz->ops->get_trip_temp(tz, p->trip_control, &control_temp);
+	if (ret) {
+		dev_warn(&tz->device,
+			 "Failed to get the control temperature: %d\n", ret);
+		return ret;
+	}
+
+	if (p->trip_switch_on != INVALID_TRIP &&
+	    !tz->ops->get_trip_temp(tz, p->trip_switch_on, &switch_on_temp) &&
+	    tz->temperature < switch_on_temp)
+		switched_on = false;
+
+	ret = predictive_control(tz, control_temp, switched_on);
+
+	/* poll while the budget binds, for the caps to follow the forecast */
+	mutex_lock(&p->lock);
+	tz->passive = switched_on || p->budget < p->last_power;
+	mutex_unlock(&p->lock);
+
+	return ret;
+}
+
+static struct thermal_governor thermal_gov_predictive = {
+	.name		= "predictive",
+	.bind_to_tz	= predictive_bind,
+	.unbind_from_tz	= predictive_unbind,
+	.throttle	= predictive_throttle,
+};
+
+int thermal_gov_predictive_register(void)
+{
+	return thermal_register_governor(&thermal_gov_predictive);
+}
+
+void thermal_gov_predictive_unregister(void)
+{
+	thermal_unregister_governor(&thermal_gov_predictive);
+}
@@ -2354,7 +2354,11 @@ static int __init thermal_register_governors(void)
 	if (result)
 		return result;
 
-	return thermal_gov_power_allocator_register();
+	result = thermal_gov_power_allocator_register();
+	if (result)
+		return result;
+
+	return thermal_gov_predictive_register();
 }
 
 static void thermal_unregister_governors(void)
@@ -2364,6 +2368,7 @@ static void thermal_unregister_governors(void)
 	thermal_gov_bang_bang_unregister();
 	thermal_gov_user_space_unregister();
 	thermal_gov_power_allocator_unregister();
+	thermal_gov_predictive_unregister();
 }
 
 #ifdef CONFIG_SCHED_HMP
@@ -97,6 +97,14 @@ static inline int thermal_gov_power_allocator_register(void) { return 0; }
 static inline void thermal_gov_power_allocator_unregister(void) {}
 #endif /* CONFIG_THERMAL_GOV_POWER_ALLOCATOR */
 
+#ifdef CONFIG_THERMAL_GOV_PREDICTIVE
+int thermal_gov_predictive_register(void);
+void thermal_gov_predictive_unregister(void);
+#else
+static inline int thermal_gov_predictive_register(void) { return 0; }
+static inline void thermal_gov_predictive_unregister(void) {}
+#endif /* CONFIG_THERMAL_GOV_PREDICTIVE */
+
 /* device tree support */
 #ifdef CONFIG_THERMAL_OF
 int of_parse_thermal_zones(void);
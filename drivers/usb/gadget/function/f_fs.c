@@ -24,6 +24,12 @@
 #include <linux/hid.h>
 #include <linux/module.h>
 #include <linux/uio.h>
+#include <linux/debugfs.h>
+#include <linux/dma-buf.h>
+#include <linux/fence.h>
+#include <linux/reservation.h>
+#include <linux/scatterlist.h>
+#include <linux/seq_file.h>
 #include <asm/unaligned.h>
 
 #include <linux/usb/composite.h>
@@ -47,6 +53,8 @@ static void ffs_data_get(struct ffs_data *ffs);
 static void ffs_data_put(struct ffs_data *ffs);
 /* Creates new ffs_data object. */
 static struct ffs_data *__must_check ffs_data_new(void) __attribute__((malloc));
+/* Creates the debugfs stats file, failure is not fatal. */
+static void ffs_debugfs_create(struct ffs_data *ffs);
 
 /* Opened counter handling. */
 static void ffs_data_opened(struct ffs_data *ffs);
@@ -121,6 +129,15 @@ struct ffs_ep {
 	u8				num;
 
 	int				status;	/* P: epfile->mutex */
+
+	/*
+	 * Transfer accounting for the debugfs stats file, updated from
+	 * the completion handlers so kept lockless.
+	 */
+	atomic_t			inflight;
+	unsigned int			inflight_max;
+	atomic_long_t			requests;
+	atomic64_t			bytes;
 };
 
 struct ffs_epfile {
@@ -197,6 +214,10 @@ struct ffs_epfile {
 	unsigned char			isoc;	/* P: ffs->eps_lock */
 
 	unsigned char			_pad;
+
+	/* DMA-bufs attached with FUNCTIONFS_DMABUF_ATTACH */
+	struct list_head		dmabufs;	/* P: dmabufs_mutex */
+	struct mutex			dmabufs_mutex;
 };
 
 struct ffs_buffer {
@@ -225,6 +246,34 @@ struct ffs_io_data {
 	struct ffs_data *ffs;
 };
 
+/*  DMA-buf endpoint transfers **********************************************/
+
+struct ffs_dmabuf_priv {
+	struct list_head entry;
+	struct kref ref;
+	struct ffs_data *ffs;
+	struct dma_buf_attachment *attach;
+	struct sg_table *sgt;
+	unsigned context;
+	unsigned seqno;
+
+	/* Reused for every transfer, one is in flight at a time */
+	struct usb_request *req;	/* P: ffs->eps_lock */
+	struct usb_ep *ep;		/* P: ffs->eps_lock */
+};
+
+/*
+ * The fence may stay in the reservation object after the transfer and
+ * the attachment are gone, so it carries its own lock and is freed by
+ * fence_free(), which needs base to come first.
+ */
+struct ffs_dma_fence {
+	struct fence base;
+	spinlock_t lock;
+	struct ffs_dmabuf_priv *priv;
+	struct work_struct work;
+};
+
 struct ffs_desc_helper {
 	struct ffs_data *ffs;
 	unsigned interfaces_count;
@@ -701,11 +750,29 @@ static const struct file_operations ffs_ep0_operations = {
 
 /* "Normal" endpoints operations ********************************************/
 
+static void ffs_ep_stats_queued(struct ffs_ep *ep)
+{
+	unsigned int depth = atomic_inc_return(&ep->inflight);
+
+	if (depth > ep->inflight_max)
+		ep->inflight_max = depth;
+}
+
+static void ffs_ep_stats_done(struct ffs_ep *ep, struct usb_request *req)
+{
+	atomic_dec(&ep->inflight);
+	if (req->status)
+		return;
+	atomic_long_inc(&ep->requests);
+	atomic64_add(req->actual, &ep->bytes);
+}
+
 static void ffs_epfile_io_complete(struct usb_ep *_ep, struct usb_request *req)
 {
 	ENTER();
 	if (likely(req->context)) {
 		struct ffs_ep *ep = _ep->driver_data;
+		ffs_ep_stats_done(ep, req);
 		ep->status = req->status ? req->status : req->actual;
 		complete(req->context);
 	}
@@ -792,8 +859,10 @@ static void ffs_epfile_async_io_complete(struct usb_ep *_ep,
 
 	ENTER();
 
+	ffs_ep_stats_done(_ep->driver_data, req);
+
 	INIT_WORK(&io_data->work, ffs_user_copy_worker);
-	schedule_work(&io_data->work);
+	queue_work(io_data->ffs->io_completion_wq, &io_data->work);
 }
 
 static void __ffs_epfile_read_buffer_free(struct ffs_epfile *epfile)
@@ -1003,6 +1072,7 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 				usb_ep_free_request(ep->ep, req);
 				goto error_lock;
 			}
+			ffs_ep_stats_queued(ep);
 			ret = -EIOCBQUEUED;
 
 		spin_unlock_irq(&epfile->ffs->eps_lock);
@@ -1045,6 +1115,7 @@ static ssize_t ffs_epfile_io(struct file *file, struct ffs_io_data *io_data)
 			usb_ep_free_request(ep->ep, req);
 			goto error_lock;
 		}
+		ffs_ep_stats_queued(ep);
 
 		ret = -EIOCBQUEUED;
 		/*
@@ -1186,13 +1257,366 @@ static ssize_t ffs_epfile_read_iter(struct kiocb *kiocb, struct iov_iter *to)
 	return res;
 }
 
+static void ffs_dmabuf_release(struct kref *ref)
+{
+	struct ffs_dmabuf_priv *priv = container_of(ref,
+					struct ffs_dmabuf_priv, ref);
+	struct dma_buf *dmabuf = priv->attach->dmabuf;
+
+	ENTER();
+
+	if (priv->req)
+		usb_ep_free_request(priv->ep, priv->req);
+	dma_buf_unmap_attachment(priv->attach, priv->sgt, DMA_BIDIRECTIONAL);
+	dma_buf_detach(dmabuf, priv->attach);
+	dma_buf_put(dmabuf);
+	ffs_data_put(priv->ffs);
+	kfree(priv);
+}
+
+static void ffs_dmabuf_put(struct ffs_dmabuf_priv *priv)
+{
+	kref_put(&priv->ref, ffs_dmabuf_release);
+}
+
+static const char *ffs_dmabuf_get_driver_name(struct fence *fence)
+{
+	return "functionfs";
+}
+
+static const char *ffs_dmabuf_get_timeline_name(struct fence *fence)
+{
+	return "";
+}
+
+static bool ffs_dmabuf_enable_signaling(struct fence *fence)
+{
+	return true;
+}
+
+static const struct fence_ops ffs_dmabuf_fence_ops = {
+	.get_driver_name	= ffs_dmabuf_get_driver_name,
+	.get_timeline_name	= ffs_dmabuf_get_timeline_name,
+	.enable_signaling	= ffs_dmabuf_enable_signaling,
+	.wait			= fence_default_wait,
+};
+
+/*
+ * Dropping the attachment may sleep, so the last references are put
+ * from a work item rather than from the completion handler.  This is
+ * the system workqueue since the final ffs_data_put() would destroy
+ * io_completion_wq.
+ */
+static void ffs_dmabuf_cleanup(struct work_struct *work)
+{
+	struct ffs_dma_fence *dma_fence = container_of(work,
+					struct ffs_dma_fence, work);
+	struct ffs_dmabuf_priv *priv = dma_fence->priv;
+
+	fence_put(&dma_fence->base);
+	ffs_dmabuf_put(priv);
+}
+
+static void ffs_dmabuf_signal_done(struct ffs_dma_fence *dma_fence)
+{
+	fence_signal(&dma_fence->base);
+
+	INIT_WORK(&dma_fence->work, ffs_dmabuf_cleanup);
+	schedule_work(&dma_fence->work);
+}
+
+static void ffs_epfile_dmabuf_io_complete(struct usb_ep *ep,
+					  struct usb_request *req)
+{
+	ENTER();
+
+	pr_vdebug("FFS: DMABUF transfer complete, status=%d\n", req->status);
+	ffs_ep_stats_done(ep->driver_data, req);
+	ffs_dmabuf_signal_done(req->context);
+}
+
+/* Assumes epfile->dmabufs_mutex is held. */
+static struct ffs_dmabuf_priv *
+ffs_dmabuf_find(struct ffs_epfile *epfile, struct dma_buf *dmabuf)
+{
+	struct ffs_dmabuf_priv *priv;
+
+	list_for_each_entry(priv, &epfile->dmabufs, entry)
+		if (priv->attach->dmabuf == dmabuf)
+			return priv;
+
+	return NULL;
+}
+
+static int ffs_dmabuf_attach(struct file *file, int fd)
+{
+	struct ffs_epfile *epfile = file->private_data;
+	struct usb_gadget *gadget = epfile->ffs->gadget;
+	struct dma_buf_attachment *attach;
+	struct ffs_dmabuf_priv *priv;
+	struct sg_table *sgt;
+	struct dma_buf *dmabuf;
+	int ret;
+
+	/* The request is handed to the controller as a scatterlist */
+	if (!gadget || !gadget->sg_supported)
+		return -EPERM;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	attach = dma_buf_attach(dmabuf, gadget->dev.parent);
+	if (IS_ERR(attach)) {
+		ret = PTR_ERR(attach);
+		goto err_dmabuf_put;
+	}
+
+	priv = kzalloc(sizeof(*priv), GFP_KERNEL);
+	if (!priv) {
+		ret = -ENOMEM;
+		goto err_dmabuf_detach;
+	}
+
+	/*
+	 * The mapping lives as long as the attachment and the direction of
+	 * the endpoint is not known before it is enabled.
+	 */
+	sgt = dma_buf_map_attachment(attach, DMA_BIDIRECTIONAL);
+	if (IS_ERR(sgt)) {
+		ret = PTR_ERR(sgt);
+		goto err_free_priv;
+	}
+
+	kref_init(&priv->ref);
+	priv->attach = attach;
+	priv->sgt = sgt;
+	priv->context = fence_context_alloc(1);
+	priv->ffs = epfile->ffs;
+	ffs_data_get(priv->ffs);
+
+	mutex_lock(&epfile->dmabufs_mutex);
+	if (ffs_dmabuf_find(epfile, dmabuf)) {
+		mutex_unlock(&epfile->dmabufs_mutex);
+		/* drops the extra dma_buf reference as well */
+		ffs_dmabuf_put(priv);
+		return -EEXIST;
+	}
+	list_add(&priv->entry, &epfile->dmabufs);
+	mutex_unlock(&epfile->dmabufs_mutex);
+
+	return 0;
+
+err_free_priv:
+	kfree(priv);
+err_dmabuf_detach:
+	dma_buf_detach(dmabuf, attach);
+err_dmabuf_put:
+	dma_buf_put(dmabuf);
+
+	return ret;
+}
+
+/* Assumes epfile->dmabufs_mutex is held. */
+static void __ffs_dmabuf_detach(struct ffs_epfile *epfile,
+				struct ffs_dmabuf_priv *priv)
+{
+	struct ffs_data *ffs = epfile->ffs;
+
+	/* Cancel any pending transfer, it completes with -ECONNRESET */
+	spin_lock_irq(&ffs->eps_lock);
+	if (priv->ep && priv->req)
+		usb_ep_dequeue(priv->ep, priv->req);
+	spin_unlock_irq(&ffs->eps_lock);
+
+	list_del(&priv->entry);
+	ffs_dmabuf_put(priv);
+}
+
+static int ffs_dmabuf_detach(struct file *file, int fd)
+{
+	struct ffs_epfile *epfile = file->private_data;
+	struct ffs_dmabuf_priv *priv;
+	struct dma_buf *dmabuf;
+	int ret = -EINVAL;
+
+	dmabuf = dma_buf_get(fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	mutex_lock(&epfile->dmabufs_mutex);
+	priv = ffs_dmabuf_find(epfile, dmabuf);
+	if (priv) {
+		__ffs_dmabuf_detach(epfile, priv);
+		ret = 0;
+	}
+	mutex_unlock(&epfile->dmabufs_mutex);
+
+	dma_buf_put(dmabuf);
+
+	return ret;
+}
+
+static int ffs_dmabuf_transfer(struct file *file,
+			       const struct usb_ffs_dmabuf_transfer_req *req)
+{
+	bool nonblock = file->f_flags & O_NONBLOCK;
+	struct ffs_epfile *epfile = file->private_data;
+	struct reservation_object *resv;
+	struct ffs_dma_fence *dma_fence;
+	struct ffs_dmabuf_priv *priv;
+	struct usb_request *usb_req;
+	struct dma_buf *dmabuf;
+	struct ffs_ep *ep;
+	int ret;
+
+	if (req->flags)
+		return -EINVAL;
+
+	/* Wait for endpoint to be enabled */
+	ep = epfile->ep;
+	if (!ep) {
+		if (nonblock)
+			return -EAGAIN;
+
+		ret = wait_event_interruptible(epfile->wait, (ep = epfile->ep));
+		if (ret)
+			return -EINTR;
+	}
+	if (epfile->isoc)
+		return -EINVAL;
+
+	dmabuf = dma_buf_get(req->fd);
+	if (IS_ERR(dmabuf))
+		return PTR_ERR(dmabuf);
+
+	if (!req->length || req->length > dmabuf->size) {
+		ret = -EINVAL;
+		goto err_dmabuf_put;
+	}
+
+	mutex_lock(&epfile->dmabufs_mutex);
+	priv = ffs_dmabuf_find(epfile, dmabuf);
+	if (priv)
+		kref_get(&priv->ref);
+	mutex_unlock(&epfile->dmabufs_mutex);
+	if (!priv) {
+		ret = -EINVAL;
+		goto err_dmabuf_put;
+	}
+
+	dma_fence = kmalloc(sizeof(*dma_fence), GFP_KERNEL);
+	if (!dma_fence) {
+		ret = -ENOMEM;
+		goto err_priv_put;
+	}
+
+	resv = dmabuf->resv;
+	if (nonblock) {
+		if (!ww_mutex_trylock(&resv->lock)) {
+			ret = -EBUSY;
+			goto err_fence_free;
+		}
+	} else {
+		ret = ww_mutex_lock_interruptible(&resv->lock, NULL);
+		if (ret)
+			goto err_fence_free;
+	}
+
+	/* One transfer per buffer, user space batches across buffers */
+	if (!reservation_object_test_signaled_rcu(resv, true)) {
+		ret = -EBUSY;
+		goto err_resv_unlock;
+	}
+
+	if (epfile->in) {
+		/* the controller reads the buffer */
+		ret = reservation_object_reserve_shared(resv);
+		if (ret)
+			goto err_resv_unlock;
+	}
+
+	spin_lock_irq(&epfile->ffs->eps_lock);
+
+	/* In the meantime, endpoint got disabled or changed. */
+	if (epfile->ep != ep) {
+		ret = -ESHUTDOWN;
+		goto err_eps_unlock;
+	}
+
+	usb_req = priv->req;
+	if (usb_req && priv->ep != ep->ep) {
+		usb_ep_free_request(priv->ep, usb_req);
+		usb_req = NULL;
+	}
+	if (!usb_req) {
+		usb_req = usb_ep_alloc_request(ep->ep, GFP_ATOMIC);
+		if (!usb_req) {
+			priv->req = NULL;
+			ret = -ENOMEM;
+			goto err_eps_unlock;
+		}
+		priv->req = usb_req;
+		priv->ep = ep->ep;
+	}
+
+	spin_lock_init(&dma_fence->lock);
+	fence_init(&dma_fence->base, &ffs_dmabuf_fence_ops, &dma_fence->lock,
+		   priv->context, ++priv->seqno);
+	dma_fence->priv = priv;
+
+	if (epfile->in)
+		reservation_object_add_shared_fence(resv, &dma_fence->base);
+	else
+		reservation_object_add_excl_fence(resv, &dma_fence->base);
+
+	usb_req->buf = NULL;
+	usb_req->length = req->length;
+	usb_req->sg = priv->sgt->sgl;
+	usb_req->num_sgs = sg_nents_for_len(priv->sgt->sgl, req->length);
+	usb_req->context = dma_fence;
+	usb_req->complete = ffs_epfile_dmabuf_io_complete;
+
+	/* The fence and its work item now own the priv reference */
+	ret = usb_ep_queue(ep->ep, usb_req, GFP_ATOMIC);
+	if (ret)
+		ffs_dmabuf_signal_done(dma_fence);
+	else
+		ffs_ep_stats_queued(ep);
+
+	spin_unlock_irq(&epfile->ffs->eps_lock);
+	ww_mutex_unlock(&resv->lock);
+	dma_buf_put(dmabuf);
+
+	return ret;
+
+err_eps_unlock:
+	spin_unlock_irq(&epfile->ffs->eps_lock);
+err_resv_unlock:
+	ww_mutex_unlock(&resv->lock);
+err_fence_free:
+	kfree(dma_fence);
+err_priv_put:
+	ffs_dmabuf_put(priv);
+err_dmabuf_put:
+	dma_buf_put(dmabuf);
+
+	return ret;
+}
+
 static int
 ffs_epfile_release(struct inode *inode, struct file *file)
 {
 	struct ffs_epfile *epfile = inode->i_private;
+	struct ffs_dmabuf_priv *priv, *tmp;
 
 	ENTER();
 
+	mutex_lock(&epfile->dmabufs_mutex);
+	list_for_each_entry_safe(priv, tmp, &epfile->dmabufs, entry)
+		__ffs_dmabuf_detach(epfile, priv);
+	mutex_unlock(&epfile->dmabufs_mutex);
+
 	__ffs_epfile_read_buffer_free(epfile);
 	ffs_data_closed(epfile->ffs);
 
@@ -1210,6 +1634,31 @@ static long ffs_epfile_ioctl(struct file *file, unsigned code,
 	if (WARN_ON(epfile->ffs->state != FFS_ACTIVE))
 		return -ENODEV;
 
+	/* These may sleep, so are handled outside of eps_lock */
+	switch (code) {
+	case FUNCTIONFS_DMABUF_ATTACH:
+	case FUNCTIONFS_DMABUF_DETACH:
+	{
+		int fd;
+
+		if (copy_from_user(&fd, (void __user *)value, sizeof(fd)))
+			return -EFAULT;
+
+		if (code == FUNCTIONFS_DMABUF_ATTACH)
+			return ffs_dmabuf_attach(file, fd);
+		return ffs_dmabuf_detach(file, fd);
+	}
+	case FUNCTIONFS_DMABUF_TRANSFER:
+	{
+		struct usb_ffs_dmabuf_transfer_req req;
+
+		if (copy_from_user(&req, (void __user *)value, sizeof(req)))
+			return -EFAULT;
+
+		return ffs_dmabuf_transfer(file, &req);
+	}
+	}
+
 	spin_lock_irq(&epfile->ffs->eps_lock);
 	if (likely(epfile->ep)) {
 		switch (code) {
@@ -1513,6 +1962,19 @@ ffs_fs_mount(struct file_system_type *t, int flags,
 		return ERR_PTR(-ENOMEM);
 	}
 
+	/*
+	 * AIO completions are handed back from here rather than from the
+	 * shared system workqueue, ordered so that user space sees them in
+	 * the order the controller finished them.
+	 */
+	ffs->io_completion_wq = alloc_ordered_workqueue("ffs-%s",
+					WQ_MEM_RECLAIM | WQ_HIGHPRI, dev_name);
+	if (unlikely(!ffs->io_completion_wq)) {
+		ffs_data_put(ffs);
+		return ERR_PTR(-ENOMEM);
+	}
+	ffs_debugfs_create(ffs);
+
 	ffs_dev = ffs_acquire_dev(dev_name);
 	if (IS_ERR(ffs_dev)) {
 		ffs_data_put(ffs);
@@ -1606,6 +2068,9 @@ static void ffs_data_put(struct ffs_data *ffs)
 
 	if (unlikely(atomic_dec_and_test(&ffs->ref))) {
 		pr_info("%s(): freeing\n", __func__);
+		debugfs_remove(ffs->debugfs);
+		if (ffs->io_completion_wq)
+			destroy_workqueue(ffs->io_completion_wq);
 		ffs_data_clear(ffs);
 		BUG_ON(waitqueue_active(&ffs->ev.waitq) ||
 		       swait_active(&ffs->ep0req_completion.wait));
@@ -1622,9 +2087,14 @@ static void ffs_data_closed(struct ffs_data *ffs)
 		if (ffs->no_disconnect) {
 			ffs->state = FFS_DEACTIVATED;
 			if (ffs->epfiles) {
-				ffs_epfiles_destroy(ffs->epfiles,
-						   ffs->eps_count);
+				struct ffs_epfile *epfiles;
+
+				spin_lock_irq(&ffs->eps_lock);
+				epfiles = ffs->epfiles;
 				ffs->epfiles = NULL;
+				spin_unlock_irq(&ffs->eps_lock);
+
+				ffs_epfiles_destroy(epfiles, ffs->eps_count);
 			}
 			if (ffs->setup_state == FFS_SETUP_PENDING)
 				__ffs_ep0_stall(ffs);
@@ -1641,6 +2111,60 @@ static void ffs_data_closed(struct ffs_data *ffs)
 	ffs_data_put(ffs);
 }
 
+static int ffs_debugfs_stats_show(struct seq_file *s, void *unused)
+{
+	struct ffs_data *ffs = s->private;
+	struct ffs_epfile *epfile;
+	unsigned i;
+
+	seq_puts(s, "ep       inflight max  requests bytes\n");
+
+	spin_lock_irq(&ffs->eps_lock);
+	epfile = ffs->epfiles;
+	for (i = 0; epfile && i < ffs->eps_count; ++i, ++epfile) {
+		struct ffs_ep *ep = epfile->ep;
+
+		if (!ep) {
+			seq_printf(s, "%-8s disabled\n", epfile->name);
+			continue;
+		}
+		seq_printf(s, "%-8s %-8d %-4u %-8ld %lld\n", epfile->name,
+			   atomic_read(&ep->inflight), ep->inflight_max,
+			   atomic_long_read(&ep->requests),
+			   (long long)atomic64_read(&ep->bytes));
+	}
+	spin_unlock_irq(&ffs->eps_lock);
+
+	return 0;
+}
+
+static int ffs_debugfs_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ffs_debugfs_stats_show, inode->i_private);
+}
+
+static const struct file_operations ffs_debugfs_stats_fops = {
+	.open		= ffs_debugfs_stats_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/*
+ * One file per mounted instance, /sys/kernel/debug/functionfs-<dev_name>.
+ * Sampling the byte counters twice gives the throughput.
+ */
+static void ffs_debugfs_create(struct ffs_data *ffs)
+{
+	char name[64];
+
+	snprintf(name, sizeof(name), "functionfs-%s", ffs->dev_name);
+	ffs->debugfs = debugfs_create_file(name, S_IRUGO, NULL, ffs,
+					   &ffs_debugfs_stats_fops);
+	if (IS_ERR(ffs->debugfs))
+		ffs->debugfs = NULL;
+}
+
 static struct ffs_data *ffs_data_new(void)
 {
 	struct ffs_data *ffs = kzalloc(sizeof *ffs, GFP_KERNEL);
@@ -1672,8 +2196,15 @@ static void ffs_data_clear(struct ffs_data *ffs)
 	BUG_ON(ffs->gadget);
 
 	if (ffs->epfiles) {
-		ffs_epfiles_destroy(ffs->epfiles, ffs->eps_count);
+		struct ffs_epfile *epfiles;
+
+		/* ffs_debugfs_stats_show() walks the list under eps_lock */
+		spin_lock_irq(&ffs->eps_lock);
+		epfiles = ffs->epfiles;
 		ffs->epfiles = NULL;
+		spin_unlock_irq(&ffs->eps_lock);
+
+		ffs_epfiles_destroy(epfiles, ffs->eps_count);
 	}
 
 	if (ffs->ffs_eventfd) {
@@ -1788,6 +2319,8 @@ static int ffs_epfiles_create(struct ffs_data *ffs)
 		epfile->ffs = ffs;
 		mutex_init(&epfile->mutex);
 		init_waitqueue_head(&epfile->wait);
+		INIT_LIST_HEAD(&epfile->dmabufs);
+		mutex_init(&epfile->dmabufs_mutex);
 		if (ffs->user_flags & FUNCTIONFS_VIRTUAL_ADDR)
 			sprintf(epfile->name, "ep%02x", ffs->eps_addrmap[i]);
 		else
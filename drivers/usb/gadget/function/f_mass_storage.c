@@ -197,6 +197,7 @@
 /* #define VERBOSE_DEBUG */
 /* #define DUMP_MSGS */
 
+#include <linux/bio.h>
 #include <linux/blkdev.h>
 #include <linux/completion.h>
 #include <linux/dcache.h>
@@ -207,6 +208,7 @@
 #include <linux/fs.h>
 #include <linux/kref.h>
 #include <linux/kthread.h>
+#include <linux/ktime.h>
 #include <linux/limits.h>
 #include <linux/rwsem.h>
 #include <linux/slab.h>
@@ -215,6 +217,7 @@
 #include <linux/freezer.h>
 #include <linux/module.h>
 #include <linux/uaccess.h>
+#include <linux/uio.h>
 
 #include <linux/usb/ch9.h>
 #include <linux/usb/gadget.h>
@@ -281,6 +284,7 @@ struct fsg_common {
 	struct fsg_buffhd	*next_buffhd_to_drain;
 	struct fsg_buffhd	*buffhds;
 	unsigned int		fsg_num_buffers;
+	u32			buflen;		/* Size of each buffer */
 
 	int			cmnd_size;
 	u8			cmnd[MAX_COMMAND_SIZE];
@@ -751,6 +755,78 @@ static int sleep_thread(struct fsg_common *common, bool can_freeze)
 }
 
 
+/*-------------------------------------------------------------------------*/
+
+/*
+ * Backing file I/O.  A file opened O_DIRECT can't take the kernel
+ * buffer through vfs_read()/vfs_write(), those would go looking for
+ * user pages, so its pages are passed down as a bvec instead.
+ */
+static unsigned int fsg_buf_to_bvec(struct fsg_buffhd *bh, char *buf,
+				    unsigned int amount)
+{
+	unsigned int n = 0;
+
+	while (amount) {
+		unsigned int offset = offset_in_page(buf);
+		unsigned int len = min_t(unsigned int, amount,
+					 PAGE_SIZE - offset);
+
+		bh->bvec[n].bv_page = virt_to_page(buf);
+		bh->bvec[n].bv_offset = offset;
+		bh->bvec[n].bv_len = len;
+		++n;
+		buf += len;
+		amount -= len;
+	}
+	return n;
+}
+
+static ssize_t fsg_file_read(struct fsg_lun *curlun, struct fsg_buffhd *bh,
+			     char *buf, unsigned int amount, loff_t *pos)
+{
+	ktime_t start = ktime_get();
+	struct iov_iter iter;
+	ssize_t nread;
+
+	if (curlun->filp->f_flags & O_DIRECT) {
+		iov_iter_bvec(&iter, ITER_BVEC, bh->bvec,
+			      fsg_buf_to_bvec(bh, buf, amount), amount);
+		nread = vfs_iter_read(curlun->filp, &iter, pos);
+	} else {
+		nread = vfs_read(curlun->filp, (char __user *)buf, amount,
+				 pos);
+	}
+
+	if (nread > 0)
+		curlun->read_bytes += nread;
+	curlun->read_usecs += ktime_us_delta(ktime_get(), start);
+	return nread;
+}
+
+static ssize_t fsg_file_write(struct fsg_lun *curlun, struct fsg_buffhd *bh,
+			      unsigned int amount, loff_t *pos)
+{
+	ktime_t start = ktime_get();
+	struct iov_iter iter;
+	ssize_t nwritten;
+
+	if (curlun->filp->f_flags & O_DIRECT) {
+		iov_iter_bvec(&iter, ITER_BVEC, bh->bvec,
+			      fsg_buf_to_bvec(bh, bh->buf, amount), amount);
+		nwritten = vfs_iter_write(curlun->filp, &iter, pos);
+	} else {
+		nwritten = vfs_write(curlun->filp, (char __user *)bh->buf,
+				     amount, pos);
+	}
+
+	if (nwritten > 0)
+		curlun->write_bytes += nwritten;
+	curlun->write_usecs += ktime_us_delta(ktime_get(), start);
+	return nwritten;
+}
+
+
 #ifdef _SUPPORT_MAC_
 static void _lba_to_msf(u8 *buf, int lba)
 {
@@ -904,7 +980,7 @@ static int do_read_cd(struct fsg_common *common)
 		 *	the next page.
 		 * If this means reading 0 then we were asked to read past
 		 *	the end of file. */
-		amount = min(amount_left, FSG_BUFLEN);
+		amount = min(amount_left, common->buflen);
 		amount = min((loff_t) amount,
 				curlun->file_length - file_offset);
 		partial_page = file_offset & (PAGE_CACHE_SIZE - 1);
@@ -935,12 +1011,12 @@ static int do_read_cd(struct fsg_common *common)
 		/* Perform the read */
 		file_offset_tmp = file_offset;
 		if ((transfer_request & 0xf8) == 0xf8) {
-			nread = vfs_read(curlun->filp,
-					((char __user *)bh->buf)+16,
+			nread = fsg_file_read(curlun, bh,
+					((char *)bh->buf)+16,
 						amount, &file_offset_tmp);
 		} else {
-			nread = vfs_read(curlun->filp,
-					(char __user *)bh->buf,
+			nread = fsg_file_read(curlun, bh,
+					(char *)bh->buf,
 					amount, &file_offset_tmp);
 		}
 		VLDBG(curlun, "file read %u @ %llu -> %d\n", amount,
@@ -1039,7 +1115,7 @@ static int do_read(struct fsg_common *common)
 		 * But don't read more than the buffer size.
 		 * And don't try to read past the end of the file.
 		 */
-		amount = min(amount_left, FSG_BUFLEN);
+		amount = min(amount_left, common->buflen);
 		amount = min((loff_t)amount,
 			     curlun->file_length - file_offset);
 
@@ -1068,9 +1144,8 @@ static int do_read(struct fsg_common *common)
 
 		/* Perform the read */
 		file_offset_tmp = file_offset;
-		nread = vfs_read(curlun->filp,
-				 (char __user *)bh->buf,
-				 amount, &file_offset_tmp);
+		nread = fsg_file_read(curlun, bh, bh->buf, amount,
+				      &file_offset_tmp);
 		VLDBG(curlun, "file read %u @ %llu -> %d\n", amount,
 		      (unsigned long long)file_offset, (int)nread);
 		if (signal_pending(current))
@@ -1189,7 +1264,7 @@ static int do_write(struct fsg_common *common)
 			 * Try to get the remaining amount,
 			 * but not more than the buffer size.
 			 */
-			amount = min(amount_left_to_req, FSG_BUFLEN);
+			amount = min(amount_left_to_req, common->buflen);
 
 			/* Beyond the end of the backing file? */
 			if (usb_offset >= curlun->file_length) {
@@ -1261,9 +1336,8 @@ static int do_write(struct fsg_common *common)
 
 			/* Perform the write */
 			file_offset_tmp = file_offset;
-			nwritten = vfs_write(curlun->filp,
-					     (char __user *)bh->buf,
-					     amount, &file_offset_tmp);
+			nwritten = fsg_file_write(curlun, bh, amount,
+						  &file_offset_tmp);
 			VLDBG(curlun, "file write %u @ %llu -> %d\n", amount,
 			      (unsigned long long)file_offset, (int)nwritten);
 			if (signal_pending(current))
@@ -1393,7 +1467,7 @@ static int do_verify(struct fsg_common *common)
 		 * the buffer size.
 		 * And don't try to read past the end of the file.
 		 */
-		amount = min(amount_left, FSG_BUFLEN);
+		amount = min(amount_left, common->buflen);
 		amount = min((loff_t)amount,
 			     curlun->file_length - file_offset);
 		if (amount == 0) {
@@ -1407,9 +1481,8 @@ static int do_verify(struct fsg_common *common)
 
 		/* Perform the read */
 		file_offset_tmp = file_offset;
-		nread = vfs_read(curlun->filp,
-				(char __user *) bh->buf,
-				amount, &file_offset_tmp);
+		nread = fsg_file_read(curlun, bh, bh->buf, amount,
+				      &file_offset_tmp);
 		VLDBG(curlun, "file read %u @ %llu -> %d\n", amount,
 				(unsigned long long) file_offset,
 				(int) nread);
@@ -1902,7 +1975,7 @@ static int throw_away_data(struct fsg_common *common)
 		bh = common->next_buffhd_to_fill;
 		if (bh->state == BUF_STATE_EMPTY
 		 && common->usb_amount_left > 0) {
-			amount = min(common->usb_amount_left, FSG_BUFLEN);
+			amount = min(common->usb_amount_left, common->buflen);
 
 			/*
 			 * Except at the end of the transfer, amount will be
@@ -3131,6 +3204,7 @@ static struct fsg_common *fsg_common_setup(struct fsg_common *common)
 	init_completion(&common->thread_notifier);
 	init_waitqueue_head(&common->fsg_wait);
 	common->state = FSG_STATE_TERMINATED;
+	common->buflen = FSG_BUFLEN;
 	memset(common->luns, 0, sizeof(common->luns));
 
 	return common;
@@ -3147,6 +3221,7 @@ static void _fsg_common_free_buffers(struct fsg_buffhd *buffhds, unsigned n)
 	if (buffhds) {
 		struct fsg_buffhd *bh = buffhds;
 		while (n--) {
+			kfree(bh->bvec);
 			kfree(bh->buf);
 			++bh;
 		}
@@ -3175,9 +3250,14 @@ int fsg_common_set_num_buffers(struct fsg_common *common, unsigned int n)
 		bh->next = bh + 1;
 		++bh;
 buffhds_first_it:
-		bh->buf = kmalloc(FSG_BUFLEN, GFP_KERNEL);
+		bh->buf = kmalloc(common->buflen, GFP_KERNEL);
 		if (unlikely(!bh->buf))
 			goto error_release;
+		/* one more in case buf does not start on a page */
+		bh->bvec = kcalloc(common->buflen / PAGE_SIZE + 1,
+				   sizeof(*bh->bvec), GFP_KERNEL);
+		if (unlikely(!bh->bvec))
+			goto error_release;
 	} while (--i);
 	bh->next = buffhds;
 
@@ -3198,6 +3278,33 @@ error_release:
 }
 EXPORT_SYMBOL_GPL(fsg_common_set_num_buffers);
 
+/*
+ * Larger buffers mean fewer, larger backing file calls and USB
+ * requests per command; the pipeline depth stays num_buffers.
+ */
+int fsg_common_set_buflen(struct fsg_common *common, u32 buflen)
+{
+	u32 old = common->buflen;
+	int rc;
+
+	if (buflen < FSG_BUFLEN || buflen > FSG_MAX_BUFLEN ||
+	    !IS_ALIGNED(buflen, PAGE_SIZE)) {
+		pr_err("buflen %u is out of range (%u to %u, page aligned)\n",
+		       buflen, FSG_BUFLEN, FSG_MAX_BUFLEN);
+		return -EINVAL;
+	}
+
+	common->buflen = buflen;
+	if (!common->buffhds)
+		return 0;
+
+	rc = fsg_common_set_num_buffers(common, common->fsg_num_buffers);
+	if (rc)
+		common->buflen = old;
+	return rc;
+}
+EXPORT_SYMBOL_GPL(fsg_common_set_buflen);
+
 void fsg_common_remove_lun(struct fsg_lun *lun)
 {
 	if (device_is_registered(&lun->dev))
@@ -3530,7 +3637,7 @@ static int fsg_bind(struct usb_configuration *c, struct usb_function *f)
 		fsg_fs_bulk_out_desc.bEndpointAddress;
 
 	/* Calculate bMaxBurst, we know packet size is 1024 */
-	max_burst = min_t(unsigned, FSG_BUFLEN / 1024, 15);
+	max_burst = min_t(unsigned, common->buflen / 1024, 15);
 
 	fsg_ss_bulk_in_desc.bEndpointAddress =
 		fsg_fs_bulk_in_desc.bEndpointAddress;
@@ -3679,12 +3786,39 @@ static ssize_t fsg_lun_opts_nofua_store(struct config_item *item,
 
 CONFIGFS_ATTR(fsg_lun_opts_, nofua);
 
+static ssize_t fsg_lun_opts_direct_io_show(struct config_item *item,
+					   char *page)
+{
+	return fsg_show_direct_io(to_fsg_lun_opts(item)->lun, page);
+}
+
+static ssize_t fsg_lun_opts_direct_io_store(struct config_item *item,
+					    const char *page, size_t len)
+{
+	struct fsg_lun_opts *opts = to_fsg_lun_opts(item);
+	struct fsg_opts *fsg_opts = to_fsg_opts(opts->group.cg_item.ci_parent);
+
+	return fsg_store_direct_io(opts->lun, &fsg_opts->common->filesem,
+				   page, len);
+}
+
+CONFIGFS_ATTR(fsg_lun_opts_, direct_io);
+
+static ssize_t fsg_lun_opts_stats_show(struct config_item *item, char *page)
+{
+	return fsg_show_stats(to_fsg_lun_opts(item)->lun, page);
+}
+
+CONFIGFS_ATTR_RO(fsg_lun_opts_, stats);
+
 static struct configfs_attribute *fsg_lun_attrs[] = {
 	&fsg_lun_opts_attr_file,
 	&fsg_lun_opts_attr_ro,
 	&fsg_lun_opts_attr_removable,
 	&fsg_lun_opts_attr_cdrom,
 	&fsg_lun_opts_attr_nofua,
+	&fsg_lun_opts_attr_direct_io,
+	&fsg_lun_opts_attr_stats,
 	NULL,
 };
 
@@ -3827,7 +3961,6 @@ static ssize_t fsg_opts_stall_store(struct config_item *item, const char *page,
 
 CONFIGFS_ATTR(fsg_opts_, stall);
 
-#ifdef CONFIG_USB_GADGET_DEBUG_FILES
 static ssize_t fsg_opts_num_buffers_show(struct config_item *item, char *page)
 {
 	struct fsg_opts *opts = to_fsg_opts(item);
@@ -3869,13 +4002,51 @@ end:
 }
 
 CONFIGFS_ATTR(fsg_opts_, num_buffers);
-#endif
+
+static ssize_t fsg_opts_buflen_show(struct config_item *item, char *page)
+{
+	struct fsg_opts *opts = to_fsg_opts(item);
+	int result;
+
+	mutex_lock(&opts->lock);
+	result = sprintf(page, "%u", opts->common->buflen);
+	mutex_unlock(&opts->lock);
+
+	return result;
+}
+
+static ssize_t fsg_opts_buflen_store(struct config_item *item,
+				     const char *page, size_t len)
+{
+	struct fsg_opts *opts = to_fsg_opts(item);
+	int ret;
+	u32 num;
+
+	mutex_lock(&opts->lock);
+	if (opts->refcnt) {
+		ret = -EBUSY;
+		goto end;
+	}
+	ret = kstrtou32(page, 0, &num);
+	if (ret)
+		goto end;
+
+	ret = fsg_common_set_buflen(opts->common, num);
+	if (ret)
+		goto end;
+	ret = len;
+
+end:
+	mutex_unlock(&opts->lock);
+	return ret;
+}
+
+CONFIGFS_ATTR(fsg_opts_, buflen);
 
 static struct configfs_attribute *fsg_attrs[] = {
 	&fsg_opts_attr_stall,
-#ifdef CONFIG_USB_GADGET_DEBUG_FILES
 	&fsg_opts_attr_num_buffers,
-#endif
+	&fsg_opts_attr_buflen,
 	NULL,
 };
 
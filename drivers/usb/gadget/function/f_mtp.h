@@ -28,6 +28,7 @@
 #define GET_HIGH_FULL_SPEED	10
 #define SEND_FILE_WITH_HEADER 11
 #define MTP_VBUS_DISABLE 12
+#define RECEIVE_FILE 13
 #define SIG_SETUP		44
 
 /*PIMA15740-2000 spec*/
@@ -69,6 +70,12 @@ struct read_send_info {
 	uint32_t TransactionID;/* host generated number */
 };
 
+struct receive_file_info {
+	int	Fd;/* Media File fd */
+	int64_t Offset;/* where in the file the data goes */
+	int64_t Length;/* bytes of data to receive, after the header */
+};
+
 
 extern struct usb_function_instance *alloc_inst_mtp_ptp(bool mtp_config);
 extern struct usb_function *function_alloc_mtp_ptp(
@@ -53,6 +53,9 @@
 #include <linux/kernel.h>
 #include <linux/file.h>
 #include <linux/configfs.h>
+#include <linux/pipe_fs_i.h>
+#include <linux/splice.h>
+#include <linux/ktime.h>
 #include "f_mtp.h"
 #include "configfs.h"
 
@@ -96,12 +99,20 @@
 
 #define MTPG_BULK_BUFFER_SIZE	32768
 #define MTPG_INTR_BUFFER_SIZE	28
+/* rx buffers are split in order-0 pages, which splice hands out one by one */
+#define MTPG_RX_BUF_ORDER	get_order(MTPG_BULK_BUFFER_SIZE)
 
 /* number of rx and tx requests to allocate */
 #define MTPG_RX_REQ_MAX				8
 #define MTPG_MTPG_TX_REQ_MAX		8
 #define MTPG_INTR_REQ_MAX	5
 
+/* Kernel side file transfers stream through two large requests, one
+ * on the bus while the other is filled from or drained to the file.
+ */
+#define MTPG_FILE_BUFFER_SIZE	(256 * 1024)
+#define MTPG_FILE_REQ_MAX	2
+
 /* ID for Microsoft MTP OS String */
 #define MTPG_OS_STRING_ID   0xEE
 
@@ -147,6 +158,10 @@ struct mtpg_dev {
 	struct usb_request	*read_req;
 	unsigned char		*read_buf;
 	unsigned		read_count;
+	/* read_req had pages spliced, read_newbuf replaces them on release */
+	bool			read_spliced;
+	void			*read_newbuf;
+	u64			splice_bytes;
 
 	struct usb_ep		*bulk_in;
 	struct usb_ep		*bulk_out;
@@ -155,9 +170,20 @@ struct mtpg_dev {
 
 	struct workqueue_struct *wq;
 	struct work_struct read_send_work;
+	struct work_struct receive_file_work;
 	struct file *read_send_file;
 
 	int64_t read_send_length;
+	loff_t receive_file_offset;
+
+	struct list_head	file_tx_idle;
+	struct usb_request	*file_rx_req[MTPG_FILE_REQ_MAX];
+	int			file_rx_done;
+	/* last kernel side transfer each way, for the xfer_stats attr */
+	u64			send_bytes;
+	s64			send_usecs;
+	u64			receive_bytes;
+	s64			receive_usecs;
 
 	uint16_t read_send_cmd;
 	uint32_t read_send_id;
@@ -627,6 +653,45 @@ static int mtpg_open(struct inode *ip, struct file *fp)
 	return 0;
 }
 
+static void *mtpg_rx_buf_alloc(gfp_t gfp)
+{
+	struct page *page = alloc_pages(gfp, MTPG_RX_BUF_ORDER);
+
+	if (!page)
+		return NULL;
+	split_page(page, MTPG_RX_BUF_ORDER);
+	return page_address(page);
+}
+
+static void mtpg_rx_buf_free(void *buf)
+{
+	struct page *page = virt_to_page(buf);
+	int i;
+
+	for (i = 0; i < 1 << MTPG_RX_BUF_ORDER; i++)
+		put_page(page + i);
+}
+
+/* give the emptied read_req back to rx_idle, called with read_excl held */
+static void mtpg_release_read_req(struct mtpg_dev *dev)
+{
+	struct usb_request *req = dev->read_req;
+
+	if (dev->read_spliced) {
+		/*
+		 * Pipes hold references to some pages of the buffer, which
+		 * must not be received into again: they go with the pipe,
+		 * and the request gets the buffer allocated at splice time.
+		 */
+		mtpg_rx_buf_free(req->buf);
+		req->buf = dev->read_newbuf;
+		dev->read_newbuf = NULL;
+		dev->read_spliced = false;
+	}
+	mtpg_req_put(dev, &dev->rx_idle, req);
+	dev->read_req = NULL;
+}
+
 static ssize_t mtpg_read(struct file *fp, char __user *buf,
 				size_t count, loff_t *pos)
 {
@@ -718,8 +783,7 @@ requeue_req:
 			if (dev->read_count == 0) {
 				DEBUG_MTPR("[%s] and line is = %d\n",
 							__func__, __LINE__);
-				mtpg_req_put(dev, &dev->rx_idle, dev->read_req);
-				dev->read_req = 0;
+				mtpg_release_read_req(dev);
 			}
 
 			/*Updating the buffer size and returnung
@@ -771,6 +835,128 @@ fail:
 
 }
 
+/* wait for received data in read_buf, called with read_excl held */
+static int mtpg_wait_rx(struct mtpg_dev *dev)
+{
+	struct usb_request *req;
+	int ret;
+
+	ret = wait_event_interruptible(dev->read_wq,
+		((dev->online || dev->error) && dev->read_ready));
+	if (ret < 0)
+		return ret;
+
+	while (dev->read_count == 0) {
+		if (dev->error)
+			return -EIO;
+
+		while ((req = mtpg_req_get(dev, &dev->rx_idle))) {
+requeue_req:
+			req->length = MTPG_BULK_BUFFER_SIZE;
+			ret = usb_ep_queue(dev->bulk_out, req, GFP_ATOMIC);
+			if (ret < 0) {
+				dev->error = 1;
+				mtpg_req_put(dev, &dev->rx_idle, req);
+				return -EIO;
+			}
+		}
+
+		req = NULL;
+		ret = wait_event_interruptible(dev->read_wq,
+				((req = mtpg_req_get(dev, &dev->rx_done))
+							|| dev->error));
+		if (req) {
+			/* 0-len ones go back into service, as in mtpg_read */
+			if (req->actual == 0)
+				goto requeue_req;
+
+			dev->read_req = req;
+			dev->read_count = req->actual;
+			dev->read_buf = req->buf;
+		}
+		if (ret < 0)
+			return ret;
+	}
+
+	return 0;
+}
+
+static const struct pipe_buf_operations mtpg_pipe_buf_ops = {
+	.can_merge = 0,
+	.confirm = generic_pipe_buf_confirm,
+	.release = generic_pipe_buf_release,
+	.steal = generic_pipe_buf_steal,
+	.get = generic_pipe_buf_get,
+};
+
+/*
+ * Hand the pages the bulk OUT data was received into to the pipe, with no
+ * copy, for the MTP daemon to splice them on to the file being written.
+ */
+static ssize_t mtpg_splice_read(struct file *fp, loff_t *ppos,
+		struct pipe_inode_info *pipe, size_t len, unsigned int flags)
+{
+	struct mtpg_dev *dev = fp->private_data;
+	struct page *pages[PIPE_DEF_BUFFERS];
+	struct partial_page partial[PIPE_DEF_BUFFERS];
+	struct splice_pipe_desc spd = {
+		.pages = pages,
+		.partial = partial,
+		.nr_pages_max = PIPE_DEF_BUFFERS,
+		.flags = flags,
+		.ops = &mtpg_pipe_buf_ops,
+		.spd_release = spd_release_page,
+	};
+	unsigned char *buf;
+	size_t xfer;
+	ssize_t r;
+
+	if (_lock(&dev->read_excl))
+		return -EBUSY;
+
+	r = mtpg_wait_rx(dev);
+	if (r < 0)
+		goto out;
+
+	if (!dev->read_spliced) {
+		dev->read_newbuf = mtpg_rx_buf_alloc(GFP_KERNEL);
+		if (!dev->read_newbuf) {
+			r = -ENOMEM;
+			goto out;
+		}
+		dev->read_spliced = true;
+	}
+
+	buf = dev->read_buf;
+	xfer = min_t(size_t, len, dev->read_count);
+	while (xfer && spd.nr_pages < PIPE_DEF_BUFFERS) {
+		unsigned int off = offset_in_page(buf);
+		unsigned int n = min_t(size_t, xfer, PAGE_SIZE - off);
+
+		pages[spd.nr_pages] = virt_to_page(buf);
+		get_page(pages[spd.nr_pages]);
+		partial[spd.nr_pages].offset = off;
+		partial[spd.nr_pages].len = n;
+		spd.nr_pages++;
+
+		buf += n;
+		xfer -= n;
+	}
+
+	r = splice_to_pipe(pipe, &spd);
+	if (r > 0) {
+		dev->read_buf += r;
+		dev->read_count -= r;
+		dev->splice_bytes += r;
+		if (dev->read_count == 0)
+			mtpg_release_read_req(dev);
+	}
+
+out:
+	_unlock(&dev->read_excl);
+	return r;
+}
+
 static ssize_t mtpg_write(struct file *fp, const char __user *buf,
 				 size_t count, loff_t *pos)
 {
@@ -965,6 +1151,10 @@ static void read_send_work(struct work_struct *work)
 	int64_t hdr_length = 0;
 	int r = 0;
 	int ZLP_flag = 0;
+	struct list_head *idle = &dev->tx_idle;
+	int bufsize = MTPG_BULK_BUFFER_SIZE;
+	ktime_t start = ktime_get();
+	u64 sent = 0;
 
 	/* read our parameters */
 	smp_rmb();
@@ -973,6 +1163,12 @@ static void read_send_work(struct work_struct *work)
 	hdr_length = sizeof(struct usb_container_header);
 	count += hdr_length;
 
+	/* all of them are idle between transfers */
+	if (!list_empty(&dev->file_tx_idle)) {
+		idle = &dev->file_tx_idle;
+		bufsize = MTPG_FILE_BUFFER_SIZE;
+	}
+
 	printk(KERN_DEBUG "[%s:%d] offset=[%lld]\t leth+hder=[%lld]\n",
 					 __func__, __LINE__, file_pos, count);
 
@@ -1003,7 +1199,7 @@ static void read_send_work(struct work_struct *work)
 		/* get an idle tx request to use */
 		req = 0;
 		ret = wait_event_interruptible(dev->write_wq,
-				((req = mtpg_req_get(dev, &dev->tx_idle))
+				((req = mtpg_req_get(dev, idle))
 							|| dev->error));
 		if (ret < 0 || !req) {
 			r = ret;
@@ -1012,8 +1208,8 @@ static void read_send_work(struct work_struct *work)
 			break;
 		}
 
-		if (count > MTPG_BULK_BUFFER_SIZE)
-			xfer = MTPG_BULK_BUFFER_SIZE;
+		if (count > bufsize)
+			xfer = bufsize;
 		else
 			xfer = count;
 
@@ -1047,15 +1243,114 @@ static void read_send_work(struct work_struct *work)
 		}
 
 		count -= xfer;
+		sent += xfer;
 
 		req = 0;
 	}
 
 	if (req)
-		mtpg_req_put(dev, &dev->tx_idle, req);
+		mtpg_req_put(dev, idle, req);
 
 	DEBUG_MTPB("[%s] \tline = [%d] \t r = [%d]\n", __func__, __LINE__, r);
 
+	dev->send_bytes = sent;
+	dev->send_usecs = ktime_us_delta(ktime_get(), start);
+	printk(KERN_DEBUG "[%s] sent %llu bytes in %lld us\n", __func__,
+			sent, dev->send_usecs);
+
+	dev->read_send_result = r;
+	smp_wmb();
+}
+
+/*
+ * Host to device counterpart of read_send_work: the OUT data goes
+ * straight from the two large requests into the file. One request is
+ * on the bus while the data of the other is written out.
+ */
+static void receive_file_work(struct work_struct *work)
+{
+	struct mtpg_dev	*dev = container_of(work, struct mtpg_dev,
+							receive_file_work);
+	struct usb_request *read_req = NULL, *write_req = NULL;
+	struct file *file;
+	loff_t offset;
+	int64_t count;
+	int cur = 0;
+	int ret, r = 0;
+	ktime_t start = ktime_get();
+	u64 received = 0;
+
+	/* read our parameters */
+	smp_rmb();
+	file = dev->read_send_file;
+	offset = dev->receive_file_offset;
+	count = dev->read_send_length;
+
+	while (count > 0 || write_req) {
+		if (count > 0) {
+			/* queue a request */
+			read_req = dev->file_rx_req[cur];
+			cur = (cur + 1) % MTPG_FILE_REQ_MAX;
+
+			read_req->length = min_t(int64_t, count,
+						 MTPG_FILE_BUFFER_SIZE);
+			read_req->length = ALIGN(read_req->length,
+						 dev->bulk_out->maxpacket);
+			dev->file_rx_done = 0;
+			ret = usb_ep_queue(dev->bulk_out, read_req, GFP_KERNEL);
+			if (ret < 0) {
+				r = -EIO;
+				dev->error = 1;
+				break;
+			}
+		}
+
+		if (write_req) {
+			ret = vfs_write(file, write_req->buf, write_req->actual,
+					&offset);
+			if (ret != write_req->actual) {
+				r = ret < 0 ? ret : -EIO;
+				if (read_req)
+					usb_ep_dequeue(dev->bulk_out, read_req);
+				break;
+			}
+			received += ret;
+			write_req = NULL;
+		}
+
+		if (read_req) {
+			/* wait for our last read to complete */
+			ret = wait_event_interruptible(dev->read_wq,
+					dev->file_rx_done || dev->error ||
+					dev->cancel_io);
+			if (dev->cancel_io) {
+				dev->cancel_io = 0; /*reported to user space*/
+				r = -EIO;
+				if (!dev->file_rx_done)
+					usb_ep_dequeue(dev->bulk_out, read_req);
+				break;
+			}
+			if (ret < 0 || dev->error) {
+				r = ret < 0 ? ret : -EIO;
+				if (!dev->file_rx_done)
+					usb_ep_dequeue(dev->bulk_out, read_req);
+				break;
+			}
+
+			count -= read_req->actual;
+			/* a short packet ends the data phase */
+			if (read_req->actual < read_req->length)
+				count = 0;
+			write_req = read_req;
+			read_req = NULL;
+		}
+	}
+
+	dev->receive_bytes = received;
+	dev->receive_usecs = ktime_us_delta(ktime_get(), start);
+	printk(KERN_DEBUG "[%s] received %llu bytes in %lld us\n", __func__,
+			received, dev->receive_usecs);
+
 	dev->read_send_result = r;
 	smp_wmb();
 }
@@ -1297,6 +1592,52 @@ static long  mtpg_ioctl(struct file *fd, unsigned int code, unsigned long arg)
 		_unlock(&dev->ioctl_excl);
 		break;
 	}
+	case RECEIVE_FILE:
+	{
+		struct receive_file_info	info;
+		struct file *file = NULL;
+
+		if (!dev->file_rx_req[0]) {
+			status = -ENOMEM;
+			goto exit;
+		}
+
+		if (_lock(&dev->ioctl_excl)){
+			status = -EBUSY;
+			goto exit;
+		}
+
+		if (copy_from_user(&info, (void __user *)arg, sizeof(info))) {
+			status = -EFAULT;
+			_unlock(&dev->ioctl_excl);
+			goto exit;
+		}
+
+		file = fget(info.Fd);
+		if (!file) {
+			status = -EBADF;
+			_unlock(&dev->ioctl_excl);
+			printk(KERN_DEBUG "[%s] line=[%d] bad file number\n",
+							__func__, __LINE__);
+			goto exit;
+		}
+
+		dev->read_send_file = file;
+		dev->receive_file_offset = info.Offset;
+		dev->read_send_length = info.Length;
+		smp_wmb();
+
+		queue_work(dev->wq, &dev->receive_file_work);
+		/* Wait for the work to be complted on work queue */
+		flush_workqueue(dev->wq);
+
+		fput(file);
+
+		smp_rmb();
+		status = dev->read_send_result;
+		_unlock(&dev->ioctl_excl);
+		break;
+	}
 	case MTP_VBUS_DISABLE:
 		printk(KERN_DEBUG "[%s] line=[%d] \n",
 							__func__, __LINE__);
@@ -1333,6 +1674,7 @@ static int mtpg_release_device(struct inode *ip, struct file *fp)
 static const struct file_operations mtpg_fops = {
 	.owner   = THIS_MODULE,
 	.read    = mtpg_read,
+	.splice_read = mtpg_splice_read,
 	.write   = mtpg_write,
 	.open    = mtpg_open,
 	.unlocked_ioctl = mtpg_ioctl,
@@ -1376,6 +1718,30 @@ static void mtpg_request_free(struct usb_request *req, struct usb_ep *ep)
 	}
 }
 
+static void mtpg_rx_request_free(struct usb_request *req, struct usb_ep *ep)
+{
+	if (req) {
+		mtpg_rx_buf_free(req->buf);
+		usb_ep_free_request(ep, req);
+	}
+}
+
+static struct usb_request *mtpg_rx_request_new(struct usb_ep *ep)
+{
+	struct usb_request *req = usb_ep_alloc_request(ep, GFP_KERNEL);
+
+	if (!req)
+		return NULL;
+
+	req->buf = mtpg_rx_buf_alloc(GFP_KERNEL);
+	if (!req->buf) {
+		usb_ep_free_request(ep, req);
+		return NULL;
+	}
+
+	return req;
+}
+
 static struct usb_request *mtpg_request_new(struct usb_ep *ep, int buffer_size)
 {
 
@@ -1410,6 +1776,28 @@ static void mtpg_complete_in(struct usb_ep *ep, struct usb_request *req)
 	wake_up(&dev->write_wq);
 }
 
+static void mtpg_complete_file_in(struct usb_ep *ep, struct usb_request *req)
+{
+	struct mtpg_dev *dev = the_mtpg;
+
+	if (req->status != 0)
+		dev->error = 1;
+
+	mtpg_req_put(dev, &dev->file_tx_idle, req);
+	wake_up(&dev->write_wq);
+}
+
+static void mtpg_complete_file_out(struct usb_ep *ep, struct usb_request *req)
+{
+	struct mtpg_dev *dev = the_mtpg;
+
+	if (req->status != 0)
+		dev->error = 1;
+
+	dev->file_rx_done = 1;
+	wake_up(&dev->read_wq);
+}
+
 static void mtpg_complete_out(struct usb_ep *ep, struct usb_request *req)
 {
 	struct mtpg_dev *dev = the_mtpg;
@@ -1443,21 +1831,57 @@ static void mtpg_complete_intr(struct usb_ep *ep, struct usb_request *req)
 }
 static DEVICE_ATTR(guid,  S_IRUGO | S_IWUSR,
 		guid_show, guid_store);
+
+static ssize_t splice_bytes_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%llu\n",
+			the_mtpg ? (unsigned long long)the_mtpg->splice_bytes : 0);
+}
+static DEVICE_ATTR_RO(splice_bytes);
+
+static ssize_t xfer_stats_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct mtpg_dev *mtpg = the_mtpg;
+
+	if (!mtpg)
+		return -ENODEV;
+
+	return sprintf(buf, "send %llu bytes %lld us\nreceive %llu bytes %lld us\n",
+			mtpg->send_bytes, mtpg->send_usecs,
+			mtpg->receive_bytes, mtpg->receive_usecs);
+}
+static DEVICE_ATTR_RO(xfer_stats);
+
 static void
 mtpg_function_unbind(struct usb_configuration *c, struct usb_function *f)
 {
 	struct mtpg_dev	*dev = mtpg_func_to_dev(f);
 	struct usb_request *req;
+	int i;
 
 	printk(KERN_DEBUG "[%s]\tline = [%d]\n", __func__, __LINE__);
 	
 	strings_dev_mtp[F_MTP_IDX].id = 0;
 	while ((req = mtpg_req_get(dev, &dev->rx_idle)))
-		mtpg_request_free(req, dev->bulk_out);
+		mtpg_rx_request_free(req, dev->bulk_out);
+	if (dev->read_newbuf) {
+		mtpg_rx_buf_free(dev->read_newbuf);
+		dev->read_newbuf = NULL;
+		dev->read_spliced = false;
+	}
 
 	while ((req = mtpg_req_get(dev, &dev->tx_idle)))
 		mtpg_request_free(req, dev->bulk_in);
 
+	while ((req = mtpg_req_get(dev, &dev->file_tx_idle)))
+		mtpg_request_free(req, dev->bulk_in);
+	for (i = 0; i < MTPG_FILE_REQ_MAX; i++) {
+		mtpg_request_free(dev->file_rx_req[i], dev->bulk_out);
+		dev->file_rx_req[i] = NULL;
+	}
+
 	while ((req = mtpg_req_get(dev, &dev->intr_idle)))
 		mtpg_request_free(req, dev->int_in);
 	memset(guid_info, 0, sizeof (guid_info));
@@ -1531,7 +1955,7 @@ mtpg_function_bind(struct usb_configuration *c, struct usb_function *f)
 		mtpg_req_put(mtpg, &mtpg->intr_idle, req);
 	}
 	for (i = 0; i < MTPG_RX_REQ_MAX; i++) {
-		req = mtpg_request_new(mtpg->bulk_out, MTPG_BULK_BUFFER_SIZE);
+		req = mtpg_rx_request_new(mtpg->bulk_out);
 		if (!req)
 			goto out;
 		req->complete = mtpg_complete_out;
@@ -1546,6 +1970,30 @@ mtpg_function_bind(struct usb_configuration *c, struct usb_function *f)
 		mtpg_req_put(mtpg, &mtpg->tx_idle, req);
 	}
 
+	/* Without the large requests file sends use the small ones and
+	 * RECEIVE_FILE is refused, neither is worth failing bind for.
+	 */
+	for (i = 0; i < MTPG_FILE_REQ_MAX; i++) {
+		req = mtpg_request_new(mtpg->bulk_in, MTPG_FILE_BUFFER_SIZE);
+		if (!req)
+			break;
+		req->complete = mtpg_complete_file_in;
+		mtpg_req_put(mtpg, &mtpg->file_tx_idle, req);
+	}
+	for (i = 0; i < MTPG_FILE_REQ_MAX; i++) {
+		req = mtpg_request_new(mtpg->bulk_out, MTPG_FILE_BUFFER_SIZE);
+		if (!req)
+			break;
+		req->complete = mtpg_complete_file_out;
+		mtpg->file_rx_req[i] = req;
+	}
+	if (i < MTPG_FILE_REQ_MAX) {
+		while (i--) {
+			mtpg_request_free(mtpg->file_rx_req[i], mtpg->bulk_out);
+			mtpg->file_rx_req[i] = NULL;
+		}
+	}
+
 	if (gadget_is_dualspeed(cdev->gadget)) {
 
 		DEBUG_MTPB("[%s]\tdual speed line = [%d]\n",
@@ -1710,6 +2158,8 @@ mtp_complete_cancel_io(struct usb_ep *ep, struct usb_request *req)
 			DEBUG_MTPB("[%s]cancel_io_buf[%d]=%x\tline = [%d]\n",
 				__func__, i, dev->cancel_io_buf[i], __LINE__);
 		mtp_send_signal(USB_PTPREQUEST_CANCELIO);
+		/* receive_file_work may be waiting on an OUT request */
+		wake_up(&dev->read_wq);
 	}
 
 }
@@ -1942,6 +2392,7 @@ static int mtp_setup(struct mtp_instance *fi_mtp)
 	INIT_LIST_HEAD(&mtpg->rx_done);
 	INIT_LIST_HEAD(&mtpg->tx_idle);
 	INIT_LIST_HEAD(&mtpg->intr_idle);
+	INIT_LIST_HEAD(&mtpg->file_tx_idle);
 	mtpg->wq = create_singlethread_workqueue("mtp_read_send");
 	if (!mtpg->wq) {
 		printk(KERN_ERR "mtpg_dev_alloc work queue creation failed\n");
@@ -1950,6 +2401,7 @@ static int mtp_setup(struct mtp_instance *fi_mtp)
 	}
 
 	INIT_WORK(&mtpg->read_send_work, read_send_work);
+	INIT_WORK(&mtpg->receive_file_work, receive_file_work);
 
 	/* the_mtpg must be set before calling usb_gadget_register_driver */
 	the_mtpg = mtpg;
@@ -1968,6 +2420,12 @@ static int mtp_setup(struct mtp_instance *fi_mtp)
 	else
 		printk(KERN_DEBUG "mtp: %s success to create guid attr\n",
 				__func__);
+	if (device_create_file(mtpg_device.this_device, &dev_attr_splice_bytes))
+		printk(KERN_DEBUG "mtp: %s failed to create splice_bytes attr\n",
+				__func__);
+	if (device_create_file(mtpg_device.this_device, &dev_attr_xfer_stats))
+		printk(KERN_DEBUG "mtp: %s failed to create xfer_stats attr\n",
+				__func__);
 	return 0;
 err_work:
 err_misc_register:
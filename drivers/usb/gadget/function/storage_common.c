@@ -184,6 +184,7 @@ EXPORT_SYMBOL_GPL(fsg_lun_close);
 int fsg_lun_open(struct fsg_lun *curlun, const char *filename)
 {
 	int				ro;
+	int				flags = O_LARGEFILE;
 	struct file			*filp = NULL;
 	int				rc = -EINVAL;
 	struct inode			*inode = NULL;
@@ -193,15 +194,18 @@ int fsg_lun_open(struct fsg_lun *curlun, const char *filename)
 	unsigned int			blkbits;
 	unsigned int			blksize;
 
+	if (curlun->direct_io)
+		flags |= O_DIRECT;
+
 	/* R/W if we can, R/O if we must */
 	ro = curlun->initially_ro;
 	if (!ro) {
-		filp = filp_open(filename, O_RDWR | O_LARGEFILE, 0);
+		filp = filp_open(filename, O_RDWR | flags, 0);
 		if (PTR_ERR(filp) == -EROFS || PTR_ERR(filp) == -EACCES)
 			ro = 1;
 	}
 	if (ro)
-		filp = filp_open(filename, O_RDONLY | O_LARGEFILE, 0);
+		filp = filp_open(filename, O_RDONLY | flags, 0);
 	if (IS_ERR(filp)) {
 		LINFO(curlun, "unable to open backing file: %s\n", filename);
 		return PTR_ERR(filp);
@@ -271,6 +275,8 @@ int fsg_lun_open(struct fsg_lun *curlun, const char *filename)
 	curlun->filp = filp;
 	curlun->file_length = size;
 	curlun->num_sectors = num_sectors;
+	curlun->read_bytes = curlun->read_usecs = 0;
+	curlun->write_bytes = curlun->write_usecs = 0;
 	LDBG(curlun, "open backing file: %s\n", filename);
 	return 0;
 
@@ -335,6 +341,31 @@ ssize_t fsg_show_nofua(struct fsg_lun *curlun, char *buf)
 }
 EXPORT_SYMBOL_GPL(fsg_show_nofua);
 
+ssize_t fsg_show_direct_io(struct fsg_lun *curlun, char *buf)
+{
+	return sprintf(buf, "%u\n", curlun->direct_io);
+}
+EXPORT_SYMBOL_GPL(fsg_show_direct_io);
+
+/* Throughput of the backing file alone, in KB/s, next to the totals */
+ssize_t fsg_show_stats(struct fsg_lun *curlun, char *buf)
+{
+	u64 read_kbps = 0, write_kbps = 0;
+
+	if (curlun->read_usecs)
+		read_kbps = div64_u64(curlun->read_bytes * 1000,
+				      curlun->read_usecs);
+	if (curlun->write_usecs)
+		write_kbps = div64_u64(curlun->write_bytes * 1000,
+				       curlun->write_usecs);
+
+	return sprintf(buf, "read %llu bytes %llu us %llu KB/s\n"
+			    "write %llu bytes %llu us %llu KB/s\n",
+		       curlun->read_bytes, curlun->read_usecs, read_kbps,
+		       curlun->write_bytes, curlun->write_usecs, write_kbps);
+}
+EXPORT_SYMBOL_GPL(fsg_show_stats);
+
 ssize_t fsg_show_file(struct fsg_lun *curlun, struct rw_semaphore *filesem,
 		      char *buf)
 {
@@ -433,6 +464,32 @@ ssize_t fsg_store_nofua(struct fsg_lun *curlun, const char *buf, size_t count)
 }
 EXPORT_SYMBOL_GPL(fsg_store_nofua);
 
+ssize_t fsg_store_direct_io(struct fsg_lun *curlun,
+			    struct rw_semaphore *filesem,
+			    const char *buf, size_t count)
+{
+	ssize_t		rc;
+	bool		direct_io;
+
+	rc = strtobool(buf, &direct_io);
+	if (rc)
+		return rc;
+
+	/* O_DIRECT is picked when the backing file is opened */
+	down_read(filesem);
+	if (fsg_lun_is_open(curlun)) {
+		LDBG(curlun, "direct I/O change prevented\n");
+		rc = -EBUSY;
+	} else {
+		curlun->direct_io = direct_io;
+		rc = count;
+	}
+	up_read(filesem);
+
+	return rc;
+}
+EXPORT_SYMBOL_GPL(fsg_store_direct_io);
+
 ssize_t fsg_store_file(struct fsg_lun *curlun, struct rw_semaphore *filesem,
 		       const char *buf, size_t count)
 {
@@ -106,6 +106,7 @@ struct fsg_lun {
 	unsigned int	registered:1;
 	unsigned int	info_valid:1;
 	unsigned int	nofua:1;
+	unsigned int	direct_io:1;	/* open the backing file O_DIRECT */
 
 	u32		sense_data;
 	u32		sense_data_info;
@@ -114,6 +115,13 @@ struct fsg_lun {
 	unsigned int	blkbits; /* Bits of logical block size
 						       of bound block device */
 	unsigned int	blksize; /* logical block size of bound block device */
+
+	/* Backing file I/O totals, time spent in the file calls */
+	u64		read_bytes;
+	u64		read_usecs;
+	u64		write_bytes;
+	u64		write_usecs;
+
 	struct device	dev;
 	const char	*name;		/* "lun.name" */
 	const char	**name_pfx;	/* "function.name" */
@@ -127,6 +135,9 @@ static inline bool fsg_lun_is_open(struct fsg_lun *curlun)
 /* Default size of buffer length. */
 #define FSG_BUFLEN	((u32)16384)
 
+/* Largest buffer length that may be configured. */
+#define FSG_MAX_BUFLEN	((u32)(1024 * 1024))
+
 /* Maximal number of LUNs supported in mass storage function */
 #define FSG_MAX_LUNS	16
 
@@ -138,6 +149,8 @@ enum fsg_buffer_state {
 
 struct fsg_buffhd {
 	void				*buf;
+	/* pages of buf, handed to the backing file for direct I/O */
+	struct bio_vec			*bvec;
 	enum fsg_buffer_state		state;
 	struct fsg_buffhd		*next;
 
@@ -217,9 +230,14 @@ ssize_t fsg_show_file(struct fsg_lun *curlun, struct rw_semaphore *filesem,
 		      char *buf);
 ssize_t fsg_show_cdrom(struct fsg_lun *curlun, char *buf);
 ssize_t fsg_show_removable(struct fsg_lun *curlun, char *buf);
+ssize_t fsg_show_direct_io(struct fsg_lun *curlun, char *buf);
+ssize_t fsg_show_stats(struct fsg_lun *curlun, char *buf);
 ssize_t fsg_store_ro(struct fsg_lun *curlun, struct rw_semaphore *filesem,
 		     const char *buf, size_t count);
 ssize_t fsg_store_nofua(struct fsg_lun *curlun, const char *buf, size_t count);
+ssize_t fsg_store_direct_io(struct fsg_lun *curlun,
+			    struct rw_semaphore *filesem,
+			    const char *buf, size_t count);
 ssize_t fsg_store_file(struct fsg_lun *curlun, struct rw_semaphore *filesem,
 		       const char *buf, size_t count);
 ssize_t fsg_store_cdrom(struct fsg_lun *curlun, struct rw_semaphore *filesem,
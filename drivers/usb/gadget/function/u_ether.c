@@ -56,8 +56,6 @@
  * blocks and still have efficient handling. */
 #define GETHER_MAX_ETH_FRAME_LEN 15412
 
-static struct workqueue_struct	*uether_wq;
-
 struct eth_dev {
 	/* lock is held while accessing port_usb
 	 */
@@ -98,7 +96,15 @@ struct eth_dev {
 						struct sk_buff_head *list);
 
 	struct work_struct	work;
-	struct work_struct	rx_work;
+	struct napi_struct	rx_napi;
+
+	/* transfer level counts, in sysfs under uether/ */
+	unsigned long		tx_frames;
+	atomic_long_t		tx_transfers;
+	unsigned long		rx_frames_in;
+	unsigned long		rx_transfers;
+	unsigned long		rx_polls;
+	unsigned long		rx_polls_full;
 
 	unsigned long		todo;
 #define	WORK_RX_MEMORY		0
@@ -303,6 +309,7 @@ static void rx_complete(struct usb_ep *ep, struct usb_request *req)
 	/* normal completion */
 	case 0:
 		skb_put(skb, req->actual);
+		dev->rx_transfers++;
 
 		if (dev->unwrap) {
 			unsigned long	flags;
@@ -361,7 +368,7 @@ clean:
 	spin_unlock(&dev->req_lock);
 
 	if (queue)
-		queue_work(uether_wq, &dev->rx_work);
+		napi_schedule(&dev->rx_napi);
 }
 
 
@@ -475,29 +482,31 @@ static void rx_fill(struct eth_dev *dev, gfp_t gfp_flags)
 	spin_unlock_irqrestore(&dev->req_lock, flags);
 }
 
-static void process_rx_w(struct work_struct *work)
+/*
+ * The frames rx_complete() unwrapped are handed to GRO from NAPI, which
+ * also puts the emptied requests back on the endpoint.
+ */
+static int eth_rx_poll(struct napi_struct *napi, int budget)
 {
-	struct eth_dev	*dev = container_of(work, struct eth_dev, rx_work);
+	struct eth_dev	*dev = container_of(napi, struct eth_dev, rx_napi);
+	struct gether	*link = dev->port_usb;
 	struct sk_buff	*skb;
-	int		status = 0;
+	int		work = 0;
 	int is_ncm = 0;
 
-	if (!dev->port_usb)
-		return;
-	else
-		is_ncm = !strcmp(dev->port_usb->func.name,"ncm");
+	if (link)
+		is_ncm = !strcmp(link->func.name, "ncm");
 
-	while ((skb = skb_dequeue(&dev->rx_frames))) {
-		if (status < 0
-				|| ETH_HLEN > skb->len
+	while (work < budget && (skb = skb_dequeue(&dev->rx_frames))) {
+		work++;
+		if (ETH_HLEN > skb->len
 				|| skb->len > ETH_FRAME_LEN) {
 #ifdef CONFIG_USB_NCM_SUPPORT_MTU_CHANGE
 		/*
 		  Need to revisit net->mtu	does not include header size incase of changed MTU
 		*/
 			if(is_ncm) {
-				if (status < 0
-					|| ETH_HLEN > skb->len
+				if (ETH_HLEN > skb->len
 					|| skb->len > (dev->net->mtu + ETH_HLEN)) {
 					printk(KERN_ERR "usb: %s  drop incase of NCM rx length %d\n",__func__,skb->len);
 				} else {
@@ -524,12 +533,26 @@ process_frame:
 		skb->protocol = eth_type_trans(skb, dev->net);
 		dev->net->stats.rx_packets++;
 		dev->net->stats.rx_bytes += skb->len;
+		dev->rx_frames_in++;
 
-		status = netif_rx_ni(skb);
+		napi_gro_receive(napi, skb);
 	}
 
+	dev->rx_polls++;
+	if (work < budget) {
+		napi_complete_done(napi, work);
+		/* rx_complete() may have queued frames while we finished */
+		if (!skb_queue_empty(&dev->rx_frames))
+			napi_schedule(napi);
+	} else {
+		dev->rx_polls_full++;
+	}
+
+	/* refills that fail here are retried from eth_work */
 	if (netif_running(dev->net))
-		rx_fill(dev, GFP_KERNEL);
+		rx_fill(dev, GFP_ATOMIC);
+
+	return work;
 }
 
 static void eth_work(struct work_struct *work)
@@ -643,6 +666,7 @@ static void tx_complete(struct usb_ep *ep, struct usb_request *req)
 					spin_lock(&dev->req_lock);
 					dev->no_tx_req_used++;
 					spin_unlock(&dev->req_lock);
+					atomic_long_inc(&dev->tx_transfers);
 					net->trans_start = jiffies;
 				}
 			} else {
@@ -783,6 +807,7 @@ static enum hrtimer_restart tx_timeout(struct hrtimer *data)
 			break;
 
 		case 0:
+			atomic_long_inc(&dev->tx_transfers);
 			dev->net->trans_start = jiffies;
 	}
 
@@ -863,6 +888,10 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		/* ignores USB_CDC_PACKET_TYPE_DIRECTED */
 	}
 
+	/* NCM flushes its pending NTB with a NULL skb */
+	if (skb)
+		dev->tx_frames++;
+
 	spin_lock_irqsave(&dev->req_lock, flags);
 	/*
 	 * this freelist can be empty if an interrupt triggered disconnect()
@@ -996,6 +1025,7 @@ static netdev_tx_t eth_start_xmit(struct sk_buff *skb,
 		DBG(dev, "tx queue err %d\n", retval);
 		break;
 	case 0:
+		atomic_long_inc(&dev->tx_transfers);
 		net->trans_start = jiffies;
 	}
 
@@ -1035,6 +1065,7 @@ static int eth_open(struct net_device *net)
 	struct gether	*link;
 
 	DBG(dev, "%s\n", __func__);
+	napi_enable(&dev->rx_napi);
 	if (netif_carrier_ok(dev->net))
 		eth_start(dev, GFP_KERNEL);
 
@@ -1093,6 +1124,9 @@ static int eth_stop(struct net_device *net)
 	}
 	spin_unlock_irqrestore(&dev->lock, flags);
 
+	napi_disable(&dev->rx_napi);
+	skb_queue_purge(&dev->rx_frames);
+
 	return 0;
 }
 
@@ -1155,6 +1189,42 @@ static struct device_type gadget_type = {
 	.name	= "gadget",
 };
 
+/* Frames per USB transfer are tx_frames/tx_transfers and
+ * rx_frames/rx_transfers, NAPI batching is rx_frames/rx_polls.
+ */
+#define UETHER_STAT_ATTR(name, expr)					\
+static ssize_t uether_show_##name(struct device *d,			\
+				  struct device_attribute *attr,	\
+				  char *buf)				\
+{									\
+	struct eth_dev *dev = netdev_priv(to_net_dev(d));		\
+									\
+	return sprintf(buf, "%lu\n", (unsigned long)(expr));		\
+}									\
+static DEVICE_ATTR(name, S_IRUGO, uether_show_##name, NULL)
+
+UETHER_STAT_ATTR(tx_frames, dev->tx_frames);
+UETHER_STAT_ATTR(tx_transfers, atomic_long_read(&dev->tx_transfers));
+UETHER_STAT_ATTR(rx_frames, dev->rx_frames_in);
+UETHER_STAT_ATTR(rx_transfers, dev->rx_transfers);
+UETHER_STAT_ATTR(rx_polls, dev->rx_polls);
+UETHER_STAT_ATTR(rx_polls_full, dev->rx_polls_full);
+
+static struct attribute *uether_sysfs_attrs[] = {
+	&dev_attr_tx_frames.attr,
+	&dev_attr_tx_transfers.attr,
+	&dev_attr_rx_frames.attr,
+	&dev_attr_rx_transfers.attr,
+	&dev_attr_rx_polls.attr,
+	&dev_attr_rx_polls_full.attr,
+	NULL,
+};
+
+static struct attribute_group uether_attr_group = {
+	.name = "uether",
+	.attrs = uether_sysfs_attrs,
+};
+
 /**
  * gether_setup_name - initialize one ethernet-over-usb link
  * @g: gadget to associated with these links
@@ -1185,11 +1255,12 @@ struct eth_dev *gether_setup_name(struct usb_gadget *g,
 	spin_lock_init(&dev->lock);
 	spin_lock_init(&dev->req_lock);
 	INIT_WORK(&dev->work, eth_work);
-	INIT_WORK(&dev->rx_work, process_rx_w);
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 
 	skb_queue_head_init(&dev->rx_frames);
+	netif_napi_add(net, &dev->rx_napi, eth_rx_poll, NAPI_POLL_WEIGHT);
+	net->sysfs_groups[0] = &uether_attr_group;
 
 	/* network device setup */
 	dev->net = net;
@@ -1253,7 +1324,6 @@ struct net_device *gether_setup_name_default(const char *netname)
 	spin_lock_init(&dev->lock);
 	spin_lock_init(&dev->req_lock);
 	INIT_WORK(&dev->work, eth_work);
-	INIT_WORK(&dev->rx_work, process_rx_w);
 	INIT_LIST_HEAD(&dev->tx_reqs);
 	INIT_LIST_HEAD(&dev->rx_reqs);
 #ifdef CONFIG_USB_RNDIS_MULTIPACKET_WITH_TIMER
@@ -1261,6 +1331,8 @@ struct net_device *gether_setup_name_default(const char *netname)
 	dev->tx_timer.function = tx_timeout;
 #endif
 	skb_queue_head_init(&dev->rx_frames);
+	netif_napi_add(net, &dev->rx_napi, eth_rx_poll, NAPI_POLL_WEIGHT);
+	net->sysfs_groups[0] = &uether_attr_group;
 
 	/* network device setup */
 	dev->net = net;
@@ -1671,23 +1743,6 @@ void gether_disconnect(struct gether *link)
 }
 EXPORT_SYMBOL_GPL(gether_disconnect);
 
-static int __init gether_init(void)
-{
-	uether_wq  = create_singlethread_workqueue("uether");
-	if (!uether_wq) {
-		pr_err("%s: Unable to create workqueue: uether\n", __func__);
-		return -ENOMEM;
-	}
-	return 0;
-}
-module_init(gether_init);
-
-static void __exit gether_exit(void)
-{
-	destroy_workqueue(uether_wq);
-
-}
-module_exit(gether_exit);
 MODULE_AUTHOR("David Brownell");
 MODULE_DESCRIPTION("ethernet over USB driver");
 MODULE_LICENSE("GPL v2");
@@ -273,9 +273,13 @@ struct ffs_data {
 	}				file_perms;
 
 	struct eventfd_ctx *ffs_eventfd;
+	struct workqueue_struct *io_completion_wq;
 	bool no_disconnect;
 	struct work_struct reset_work;
 
+	/* Per endpoint queue depth and byte counters in debugfs */
+	struct dentry			*debugfs;
+
 	/*
 	 * The endpoint files, filled by ffs_epfiles_create(),
 	 * destroyed by ffs_epfiles_destroy().
@@ -296,4 +300,22 @@ static inline struct f_fs_opts *to_f_fs_opts(struct usb_function_instance *fi)
 	return container_of(fi, struct f_fs_opts, func_inst);
 }
 
+/*
+ * DMA-buf backed endpoint transfers. Same numbers and layout as the
+ * FUNCTIONFS_DMABUF_* ioctls of later kernels, so the user space side
+ * can be shared.
+ */
+#ifndef FUNCTIONFS_DMABUF_ATTACH
+struct usb_ffs_dmabuf_transfer_req {
+	int fd;
+	__u32 flags;
+	__u64 length;
+} __attribute__((packed));
+
+#define FUNCTIONFS_DMABUF_ATTACH	_IOW('g', 131, int)
+#define FUNCTIONFS_DMABUF_DETACH	_IOW('g', 132, int)
+#define FUNCTIONFS_DMABUF_TRANSFER	_IOW('g', 133, \
+					     struct usb_ffs_dmabuf_transfer_req)
+#endif
+
 #endif /* U_FFS_H */
@@ -20,6 +20,9 @@
 #define LCD_REFRESH_RATE	63UL
 #define MULTI_FACTOR 		(1UL << 10)
 #define BTS_DMA_MAX			4
+/* MIF DVFS switch latency, and how long lower needs hold before a drop */
+#define BTS_RAMP_US_DEFAULT	1000
+#define BTS_DROP_MS_DEFAULT	100
 
 
 u64 dpu_bts_calc_aclk_disp(struct decon_device *decon,
@@ -47,6 +50,15 @@ u64 dpu_bts_calc_aclk_disp(struct decon_device *decon,
 /* bus utilization 75% */
 #define BUS_UTIL	75
 
+/* the margin of LCD_REFRESH_RATE kept at the rate the panel runs at now */
+static u64 dpu_bts_op_fps(struct decon_device *decon)
+{
+	if (!decon->lcd_info->fps)
+		return LCD_REFRESH_RATE;
+
+	return LCD_REFRESH_RATE * decon_get_fps(decon) / decon->lcd_info->fps;
+}
+
 static void dpu_bts_find_max_disp_freq(struct decon_device *decon,
 		struct decon_reg_data *regs)
 {
@@ -55,7 +67,7 @@ static void dpu_bts_find_max_disp_freq(struct decon_device *decon,
 	u32 max_disp_ch_bw;
 	u32 disp_op_freq = 0, freq = 0;
 	u64 resol_clock;
-	u64 op_fps = LCD_REFRESH_RATE;
+	u64 op_fps = dpu_bts_op_fps(decon);
 	struct decon_win_config *config = regs->dpp_config;
 
 	/* # of DMA of Katmai : 4 */
@@ -99,41 +111,47 @@ static void dpu_bts_find_max_disp_freq(struct decon_device *decon,
 	DPU_DEBUG_BTS("MAX DISP CH FREQ = %d\n", decon->bts.max_disp_freq);
 }
 
-void dpu_bts_calc_bw(struct decon_device *decon, struct decon_reg_data *regs)
+static void dpu_bts_fill_info(struct decon_device *decon,
+		struct decon_win_config *config, struct bts_decon_info *bts_info)
 {
-
-	struct decon_win_config *config = regs->dpp_config;
-	struct bts_decon_info bts_info;
 	int idx, i;
 
-	memset(&bts_info, 0, sizeof(struct bts_decon_info));
+	memset(bts_info, 0, sizeof(struct bts_decon_info));
 	for (i = 0; i < MAX_DECON_WIN; ++i) {
 		if (config[i].state != DECON_WIN_STATE_BUFFER)
 			continue;
 
 		idx = config[i].idma_type;
-		bts_info.dpp[idx].used = true;
-		bts_info.dpp[idx].idma_type = idx;
-		bts_info.dpp[idx].bpp = dpu_get_bpp(config[i].format);
-		bts_info.dpp[idx].src_w = config[i].src.w;
-		bts_info.dpp[idx].src_h = config[i].src.h;
-		bts_info.dpp[idx].dst.x1 = config[i].dst.x;
-		bts_info.dpp[idx].dst.x2 = config[i].dst.x + config[i].dst.w;
-		bts_info.dpp[idx].dst.y1 = config[i].dst.y;
-		bts_info.dpp[idx].dst.y2 = config[i].dst.y + config[i].dst.h;
+		bts_info->dpp[idx].used = true;
+		bts_info->dpp[idx].idma_type = idx;
+		bts_info->dpp[idx].bpp = dpu_get_bpp(config[i].format);
+		bts_info->dpp[idx].src_w = config[i].src.w;
+		bts_info->dpp[idx].src_h = config[i].src.h;
+		bts_info->dpp[idx].dst.x1 = config[i].dst.x;
+		bts_info->dpp[idx].dst.x2 = config[i].dst.x + config[i].dst.w;
+		bts_info->dpp[idx].dst.y1 = config[i].dst.y;
+		bts_info->dpp[idx].dst.y2 = config[i].dst.y + config[i].dst.h;
 
 		DPU_DEBUG_BTS("%s:used(%d), bpp(%d), src_w(%d), src_h(%d)\n",
 				__func__,
-				bts_info.dpp[idx].used, bts_info.dpp[idx].bpp,
-				bts_info.dpp[idx].src_w, bts_info.dpp[idx].src_h);
+				bts_info->dpp[idx].used, bts_info->dpp[idx].bpp,
+				bts_info->dpp[idx].src_w, bts_info->dpp[idx].src_h);
 		DPU_DEBUG_BTS("\t\t\t\tdst x(%d), right(%d), y(%d), bottom(%d)\n",
-				bts_info.dpp[idx].dst.x1, bts_info.dpp[idx].dst.x2,
-				bts_info.dpp[idx].dst.y1, bts_info.dpp[idx].dst.y2);
+				bts_info->dpp[idx].dst.x1, bts_info->dpp[idx].dst.x2,
+				bts_info->dpp[idx].dst.y1, bts_info->dpp[idx].dst.y2);
 	}
 
-	bts_info.vclk = decon->bts.resol_clk;
-	bts_info.lcd_w = decon->lcd_info->xres;
-	bts_info.lcd_h = decon->lcd_info->yres;
+	bts_info->vclk = decon->bts.resol_clk;
+	bts_info->lcd_w = decon->lcd_info->xres;
+	bts_info->lcd_h = decon->lcd_info->yres;
+}
+
+void dpu_bts_calc_bw(struct decon_device *decon, struct decon_reg_data *regs)
+{
+	struct bts_decon_info bts_info;
+	int i;
+
+	dpu_bts_fill_info(decon, regs->dpp_config, &bts_info);
 	decon->bts.total_bw = bts_calc_bw(decon->bts.type, &bts_info); /* total bandwidth */
 	memcpy(&decon->bts.bts_info, &bts_info, sizeof(struct bts_decon_info));
 
@@ -169,46 +187,219 @@ static void dpu_bts_log_info_output(struct decon_device *decon, struct decon_reg
 		decon->id, decon->bts.peak, decon->bts.total_bw);
 }
 
-void dpu_bts_update_bw(struct decon_device *decon, struct decon_reg_data *regs,
-		u32 is_after)
+/* called with bts.lock held, before the vote or the frame on screen changes */
+static void dpu_bts_account(struct decon_device *decon)
+{
+	u64 now = ktime_get_ns();
+
+	if (decon->bts.stat_ns && decon->bts.prev_total_bw > decon->bts.need_bw)
+		decon->bts.over_ns += now - decon->bts.stat_ns;
+	decon->bts.stat_ns = now;
+}
+
+/* DSIM counts underruns, each costs about a frame */
+static void dpu_bts_account_underrun(struct decon_device *decon)
+{
+	struct dsim_device *dsim;
+	u32 cnt, fps;
+
+	if (decon->dt.out_type != DECON_OUT_DSI)
+		return;
+
+	dsim = get_dsim_drvdata(decon->id);
+	if (!dsim)
+		return;
+
+	cnt = dsim->total_underrun_cnt;
+	fps = decon_get_fps(decon);
+	if (cnt > decon->bts.last_underrun_cnt && fps)
+		decon->bts.underrun_ns += (u64)(cnt - decon->bts.last_underrun_cnt) *
+			NSEC_PER_SEC / fps;
+	decon->bts.last_underrun_cnt = cnt;
+}
+
+static void dpu_bts_vote(struct decon_device *decon, u32 total_bw, u32 peak,
+		u32 disp_freq)
 {
 	struct bts_bw bw = { 0, };
 
-	DPU_DEBUG_BTS("%s +\n", __func__);
+	if (total_bw != decon->bts.prev_total_bw) {
+		bw.peak = total_bw ? peak : 0;
+		bw.read = total_bw;
+		dpu_bts_account(decon);
+		bts_update_bw(decon->bts.type, bw);
+		decon->bts.prev_total_bw = total_bw;
+	}
 
-	/* update peak & read bandwidth per DPU port */
-	bw.peak = decon->bts.peak;
-	bw.read = decon->bts.total_bw;
-	DPU_DEBUG_BTS("peak=%d, read=%d\n", bw.peak, bw.read);
+	if (disp_freq != decon->bts.prev_max_disp_freq) {
+		pm_qos_update_request(&decon->bts.disp_qos, disp_freq);
+		decon->bts.prev_max_disp_freq = disp_freq;
+	}
+}
 
-	if (bw.read == 0)
-		bw.peak = 0;
+static void dpu_bts_hold(struct decon_device *decon, u32 total_bw, u32 peak,
+		u32 disp_freq)
+{
+	decon->bts.hold_bw = max(decon->bts.hold_bw, total_bw);
+	decon->bts.hold_peak = max(decon->bts.hold_peak, peak);
+	decon->bts.hold_disp_freq = max(decon->bts.hold_disp_freq, disp_freq);
+}
 
-	if (is_after) { /* after DECON h/w configuration */
-		if (decon->bts.total_bw <= decon->bts.prev_total_bw)
-			bts_update_bw(decon->bts.type, bw);
+/*
+ * Called from set_win_config, a fence wait and a vsync or more before the
+ * frame is applied. Raising the vote here gives MIF that long to switch,
+ * where raising it right before the registers are written often did not.
+ */
+void dpu_bts_predict_bw(struct decon_device *decon, struct decon_reg_data *regs)
+{
+	struct decon_win_config *config = regs->dpp_config;
+	struct bts_decon_info bts_info;
+	u32 total_bw, peak = 0, disp_freq, freq;
+	int i;
 
-		if (decon->bts.max_disp_freq <= decon->bts.prev_max_disp_freq)
-			pm_qos_update_request(&decon->bts.disp_qos,
-					decon->bts.max_disp_freq);
+	dpu_bts_fill_info(decon, config, &bts_info);
+	total_bw = bts_calc_bw(decon->bts.type, &bts_info);
+	for (i = 0; i < BTS_DMA_MAX; ++i)
+		peak += bts_info.dpp[i].bw;
 
-		decon->bts.prev_total_bw = decon->bts.total_bw;
-		decon->bts.prev_max_disp_freq = decon->bts.max_disp_freq;
-	} else {
-		if (decon->bts.total_bw > decon->bts.prev_total_bw)
-			bts_update_bw(decon->bts.type, bw);
+	/* as dpu_bts_find_max_disp_freq() does */
+	disp_freq = peak * 100 / (16 * BUS_UTIL) + 1;
+	for (i = 0; i < MAX_DECON_WIN; ++i) {
+		if (config[i].state != DECON_WIN_STATE_BUFFER)
+			continue;
+
+		freq = dpu_bts_calc_aclk_disp(decon, &config[i],
+				decon->bts.resol_clk);
+		disp_freq = max(disp_freq, freq);
+	}
+	disp_freq = max(disp_freq, decon->bts.disp_freq_minlock);
+
+	mutex_lock(&decon->bts.lock);
+	/* a drop scheduled meanwhile must not undercut this frame */
+	dpu_bts_hold(decon, total_bw, peak, disp_freq);
+	if (total_bw > decon->bts.prev_total_bw ||
+			disp_freq > decon->bts.prev_max_disp_freq) {
+		dpu_bts_vote(decon, max(total_bw, decon->bts.prev_total_bw),
+				max(peak, decon->bts.peak),
+				max(disp_freq, decon->bts.prev_max_disp_freq));
+		regs->bts_vote_ns = ktime_get_ns();
+	}
+	mutex_unlock(&decon->bts.lock);
 
-		if (decon->bts.max_disp_freq > decon->bts.prev_max_disp_freq)
-			pm_qos_update_request(&decon->bts.disp_qos,
-					decon->bts.max_disp_freq);
+	DPU_DEBUG_BTS("%s: predicted peak=%d, read=%d, disp=%d\n", __func__,
+			peak, total_bw, disp_freq);
+}
+
+static void dpu_bts_drop_work(struct work_struct *work)
+{
+	struct decon_device *decon = container_of(to_delayed_work(work),
+			struct decon_device, bts.drop_work);
+
+	mutex_lock(&decon->bts.lock);
+	if (decon->bts.prev_total_bw)
+		dpu_bts_vote(decon,
+				min(decon->bts.hold_bw, decon->bts.prev_total_bw),
+				decon->bts.hold_peak,
+				min(decon->bts.hold_disp_freq,
+					decon->bts.prev_max_disp_freq));
+	mutex_unlock(&decon->bts.lock);
+
+	DPU_DEBUG_BTS("%s: read=%d, disp=%d\n", __func__,
+			decon->bts.prev_total_bw, decon->bts.prev_max_disp_freq);
+}
+
+void dpu_bts_update_bw(struct decon_device *decon, struct decon_reg_data *regs,
+		u32 is_after)
+{
+	u32 total_bw = decon->bts.total_bw;
+	u32 peak = decon->bts.peak;
+	u32 disp_freq = decon->bts.max_disp_freq;
+
+	DPU_DEBUG_BTS("%s +\n", __func__);
+	DPU_DEBUG_BTS("peak=%d, read=%d\n", peak, total_bw);
+
+	mutex_lock(&decon->bts.lock);
+	if (is_after) { /* after DECON h/w configuration */
+		dpu_bts_account(decon);
+		dpu_bts_account_underrun(decon);
+		decon->bts.need_bw = total_bw;
+
+		/* lower needs have to hold for drop_ms before the vote follows */
+		if (total_bw < decon->bts.prev_total_bw ||
+				disp_freq < decon->bts.prev_max_disp_freq) {
+			if (!delayed_work_pending(&decon->bts.drop_work)) {
+				decon->bts.hold_bw = 0;
+				decon->bts.hold_peak = 0;
+				decon->bts.hold_disp_freq = 0;
+				schedule_delayed_work(&decon->bts.drop_work,
+					msecs_to_jiffies(decon->bts.drop_ms));
+			}
+			dpu_bts_hold(decon, total_bw, peak, disp_freq);
+		}
+	} else {
+		dpu_bts_hold(decon, total_bw, peak, disp_freq);
+
+		/* the raise in set_win_config missed this frame, or was short */
+		if (total_bw > decon->bts.prev_total_bw ||
+				disp_freq > decon->bts.prev_max_disp_freq) {
+			dpu_bts_vote(decon, max(total_bw, decon->bts.prev_total_bw),
+					peak, max(disp_freq,
+						decon->bts.prev_max_disp_freq));
+			decon->bts.late_cnt++;
+		} else if (regs->bts_vote_ns) {
+			if (ktime_get_ns() - regs->bts_vote_ns <
+					(u64)decon->bts.ramp_us * NSEC_PER_USEC)
+				decon->bts.late_cnt++;
+			else
+				decon->bts.early_cnt++;
+		}
 
 		if (dpu_bts_log_level >= 7)
 			dpu_bts_log_info_output(decon, regs);
 	}
+	mutex_unlock(&decon->bts.lock);
 
 	DPU_DEBUG_BTS("%s -\n", __func__);
 }
 
+/*
+ * The refresh rate changed without a frame update. The bandwidth of the
+ * windows last configured is voted again for the new rate, the DISP clock
+ * follows at the next frame update.
+ */
+void dpu_bts_update_fps(struct decon_device *decon)
+{
+	struct bts_decon_info *bts_info = &decon->bts.bts_info;
+	struct bts_bw bw = { 0, };
+	int i;
+
+	if (!decon->bts.prev_total_bw)
+		return;
+
+	decon->bts.resol_clk = decon->lcd_info->xres * decon->lcd_info->yres *
+		dpu_bts_op_fps(decon) * 11 / 10 / 1000 + 1;
+	bts_info->vclk = decon->bts.resol_clk;
+	decon->bts.total_bw = bts_calc_bw(decon->bts.type, bts_info);
+
+	decon->bts.peak = 0;
+	for (i = 0; i < BTS_DMA_MAX; ++i) {
+		decon->bts.bw[i] = bts_info->dpp[i].bw;
+		decon->bts.peak += decon->bts.bw[i];
+	}
+
+	bw.peak = decon->bts.peak;
+	bw.read = decon->bts.total_bw;
+	mutex_lock(&decon->bts.lock);
+	dpu_bts_account(decon);
+	bts_update_bw(decon->bts.type, bw);
+	decon->bts.prev_total_bw = decon->bts.total_bw;
+	decon->bts.need_bw = decon->bts.total_bw;
+	mutex_unlock(&decon->bts.lock);
+
+	DPU_DEBUG_BTS("%s: fps(%d) peak=%d, read=%d\n", __func__,
+			decon_get_fps(decon), bw.peak, bw.read);
+}
+
 void dpu_bts_update_qos_mif(struct decon_device *decon, u32 mif_freq)
 {
 	if (pm_qos_request_active(&decon->bts.mif_qos))
@@ -247,10 +438,16 @@ void dpu_bts_release_bw(struct decon_device *decon)
 	struct bts_bw bw = { 0, };
 	DPU_DEBUG_BTS("%s +\n", __func__);
 
+	cancel_delayed_work_sync(&decon->bts.drop_work);
+
+	mutex_lock(&decon->bts.lock);
+	dpu_bts_account(decon);
 	bts_update_bw(decon->bts.type, bw);
 	decon->bts.prev_total_bw = 0;
 	pm_qos_update_request(&decon->bts.disp_qos, 0);
 	decon->bts.prev_max_disp_freq = 0;
+	decon->bts.need_bw = 0;
+	mutex_unlock(&decon->bts.lock);
 
 	DPU_DEBUG_BTS("%s -\n", __func__);
 }
@@ -285,11 +482,17 @@ void dpu_bts_init(struct decon_device *decon)
 	pm_qos_add_request(&decon->bts.int_qos, PM_QOS_DEVICE_THROUGHPUT, 0);
 	pm_qos_add_request(&decon->bts.disp_qos, PM_QOS_DISPLAY_THROUGHPUT, 0);
 	decon->bts.disp_freq_minlock = 0;
+
+	mutex_init(&decon->bts.lock);
+	INIT_DELAYED_WORK(&decon->bts.drop_work, dpu_bts_drop_work);
+	decon->bts.ramp_us = BTS_RAMP_US_DEFAULT;
+	decon->bts.drop_ms = BTS_DROP_MS_DEFAULT;
 }
 
 void dpu_bts_deinit(struct decon_device *decon)
 {
 	DPU_DEBUG_BTS("%s +\n", __func__);
+	cancel_delayed_work_sync(&decon->bts.drop_work);
 	pm_qos_remove_request(&decon->bts.disp_qos);
 	pm_qos_remove_request(&decon->bts.int_qos);
 	pm_qos_remove_request(&decon->bts.mif_qos);
@@ -299,7 +502,9 @@ void dpu_bts_deinit(struct decon_device *decon)
 struct decon_bts_ops decon_bts_control = {
 	.bts_init		= dpu_bts_init,
 	.bts_calc_bw		= dpu_bts_calc_bw,
+	.bts_predict_bw		= dpu_bts_predict_bw,
 	.bts_update_bw		= dpu_bts_update_bw,
+	.bts_update_fps		= dpu_bts_update_fps,
 	.bts_release_bw		= dpu_bts_release_bw,
 	.bts_update_qos_mif	= dpu_bts_update_qos_mif,
 	.bts_update_qos_int	= dpu_bts_update_qos_int,
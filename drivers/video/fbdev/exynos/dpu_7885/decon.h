@@ -23,6 +23,8 @@
 #include <linux/delay.h>
 #include <linux/seq_file.h>
 #include <linux/platform_device.h>
+#include <linux/input.h>
+#include <linux/workqueue.h>
 #include <media/v4l2-device.h>
 #include <media/videobuf2-core.h>
 #include <soc/samsung/bts.h>
@@ -700,6 +702,10 @@ struct decon_reg_data {
 	bool protection[MAX_DECON_WIN];
 	/* release fence*/
 	struct sync_pt *pt;
+	/* target of userspace in ns, 0 if none */
+	u64 present_time;
+	/* when set_win_config raised the bus vote for this frame, 0 if not */
+	u64 bts_vote_ns;
 
 #if defined(CONFIG_SUPPORT_MASK_LAYER)
 	bool mask_layer;
@@ -708,9 +714,25 @@ struct decon_reg_data {
 
 struct decon_win_config_extra {
 	int remained_frames;
-	u32 reserved[7];
+	/*
+	 * CLOCK_MONOTONIC time in ns the frame is meant to be shown at, split
+	 * to keep the layout of the 32bit ABI. 0 shows it at the next vsync.
+	 */
+	u32 present_time_lo;
+	u32 present_time_hi;
+	/* DECON_WIN_EXTRA_* */
+	u32 flags;
+	u32 reserved[4];
 };
 
+/*
+ * transparent_area of every buffer window holds the part of it changed
+ * since the last frame, in display coordinates, and an empty one means
+ * unchanged. The update region is then computed by the kernel unless
+ * DECON_WIN_UPDATE_IDX already carries one.
+ */
+#define DECON_WIN_EXTRA_DAMAGE		(1 << 0)
+
 struct decon_win_config_data_old {
 	int	fence;
 	int	fd_odma;
@@ -1005,6 +1027,26 @@ struct decon_update_regs {
 	struct kthread_worker worker;
 	struct kthread_work work;
 	atomic_t remaining_frame;
+
+	/* frames given a present time, vsyncs they were held for, late ones */
+	u32 present_cnt;
+	u32 present_held_vsyncs;
+	u32 present_late_cnt;
+};
+
+/*
+ * Command mode panels keep showing the last frame from their own memory,
+ * so a frame of the same windows on the same buffers is not sent again.
+ */
+struct decon_static_scene {
+	/* windows of the frame on the panel, with fds cleared */
+	struct decon_win_config config[MAX_DECON_WIN];
+	bool valid;
+	/* frames not sent, bytes they would have read, time on the panel */
+	u32 skip_cnt;
+	u64 saved_bytes;
+	u64 since;
+	u64 residency_ns;
 };
 
 struct decon_vsync {
@@ -1034,13 +1076,26 @@ struct decon_win_update {
 	u32 verti_cnt;
 	/* previous update region */
 	struct decon_rect prev_up_region;
+	/* windows of the previous frame, to damage what moved or went away */
+	u32 prev_state[MAX_DECON_WIN];
+	struct decon_frame prev_dst[MAX_DECON_WIN];
+	/* partial updates covering more of the LCD than this are sent full */
+	u32 max_pct;
+	/* frames sent partial and full, and the DSI bytes they saved */
+	u32 partial_cnt;
+	u32 full_cnt;
+	u32 damage_cnt;
+	u64 saved_bytes;
+	u64 full_bytes;
 };
 
 struct decon_bts_ops {
 	void (*bts_init)(struct decon_device *decon);
 	void (*bts_calc_bw)(struct decon_device *decon, struct decon_reg_data *regs);
+	void (*bts_predict_bw)(struct decon_device *decon, struct decon_reg_data *regs);
 	void (*bts_update_bw)(struct decon_device *decon, struct decon_reg_data *regs,
 			u32 is_after);
+	void (*bts_update_fps)(struct decon_device *decon);
 	void (*bts_release_bw)(struct decon_device *decon);
 	void (*bts_update_qos_mif)(struct decon_device *decon, u32 mif_freq);
 	void (*bts_update_qos_int)(struct decon_device *decon, u32 int_freq);
@@ -1048,6 +1103,36 @@ struct decon_bts_ops {
 	void (*bts_deinit)(struct decon_device *decon);
 };
 
+#if defined(CONFIG_EXYNOS_DECON_DFR)
+#define DECON_DFR_MAX_FPS	4
+
+/*
+ * Dynamic frame rate of a video mode panel. fps[] lists the rates the
+ * panel is known to run at, fastest first, and hfp[] the horizontal front
+ * porch stretching a line so that a frame takes as long as at that rate.
+ * Indexes go up as the rate goes down. Protected by decon->lock.
+ */
+struct decon_dfr {
+	bool supported;
+	bool active;
+	int nr_fps;
+	u32 fps[DECON_DFR_MAX_FPS];
+	u32 hfp[DECON_DFR_MAX_FPS];
+	int cur;
+	/* rate matching the content userspace hinted at, 0 without a hint */
+	int content;
+	u32 content_fps;
+	u32 idle_ms;
+	/* jiffies until which the last touch keeps the fastest rate */
+	unsigned long touch_until;
+	struct delayed_work idle_work;
+	struct work_struct boost_work;
+	struct input_handler input_handler;
+	ktime_t since;
+	u64 residency_ns[DECON_DFR_MAX_FPS];
+};
+#endif
+
 struct decon_bts {
 	u32 resol_clk;
 	u32 bw[BTS_DPP_MAX];
@@ -1065,6 +1150,27 @@ struct decon_bts {
 	struct pm_qos_request int_qos;
 	struct pm_qos_request disp_qos;
 	u32 disp_freq_minlock;
+
+	/*
+	 * Votes are raised when a frame is submitted, ramp_us being what MIF
+	 * needs to follow, and dropped only when lower needs held for drop_ms.
+	 * hold_* are the highest needs seen since a drop was scheduled.
+	 */
+	struct mutex lock;
+	struct delayed_work drop_work;
+	u32 ramp_us;
+	u32 drop_ms;
+	u32 hold_bw;
+	u32 hold_peak;
+	u32 hold_disp_freq;
+	/* stats: bandwidth of the frame on screen, and time above or below */
+	u32 need_bw;
+	u32 last_underrun_cnt;
+	u32 early_cnt;
+	u32 late_cnt;
+	u64 stat_ns;
+	u64 over_ns;
+	u64 underrun_ns;
 };
 
 struct decon_device {
@@ -1079,6 +1185,9 @@ struct decon_device {
 #if defined(CONFIG_EXYNOS_DOZE)
 	unsigned int doze_state;
 #endif
+#if defined(CONFIG_EXYNOS_DECON_DFR)
+	struct decon_dfr dfr;
+#endif
 
 #if defined(CONFIG_SUPPORT_MASK_LAYER)
 	bool current_mask_layer;
@@ -1113,6 +1222,7 @@ struct decon_device {
 	struct decon_resources res;
 	struct decon_debug d;
 	struct decon_update_regs up;
+	struct decon_static_scene static_scene;
 	struct decon_vsync vsync;
 	struct decon_lcd *lcd_info;
 	struct decon_win_update win_up;
@@ -1503,6 +1613,25 @@ enum doze_state {
 
 #define IS_DOZE(doze_state)		(doze_state == DOZE_STATE_DOZE || doze_state == DOZE_STATE_DOZE_SUSPEND)
 #endif
+
+#if defined(CONFIG_EXYNOS_DECON_DFR)
+int decon_dfr_init(struct decon_device *decon);
+void decon_dfr_deinit(struct decon_device *decon);
+void decon_dfr_start(struct decon_device *decon);
+void decon_dfr_stop(struct decon_device *decon);
+void decon_dfr_frame_update(struct decon_device *decon);
+u32 decon_get_fps(struct decon_device *decon);
+#else
+static inline int decon_dfr_init(struct decon_device *decon) { return 0; }
+static inline void decon_dfr_deinit(struct decon_device *decon) { }
+static inline void decon_dfr_start(struct decon_device *decon) { }
+static inline void decon_dfr_stop(struct decon_device *decon) { }
+static inline void decon_dfr_frame_update(struct decon_device *decon) { }
+static inline u32 decon_get_fps(struct decon_device *decon)
+{
+	return decon->lcd_info->fps;
+}
+#endif
 /* IOCTL commands */
 #define S3CFB_SET_VSYNC_INT		_IOW('F', 206, __u32)
 #define S3CFB_WIN_CONFIG_OLD		_IOW('F', 209, \
@@ -412,6 +412,8 @@ int decon_tui_protection(bool tui_en)
 		}
 
 		decon->state = DECON_STATE_TUI;
+		/* the secure world draws on the panel from now on */
+		decon->static_scene.valid = false;
 		aclk_khz = clk_get_rate(decon->res.aclk) / 1000U;
 		decon_info("%s:DPU_ACLK(%ld khz)\n", __func__, aclk_khz);
 		decon_info("MIF(%lu), INT(%lu), DISP(%lu), total bw(%u, %u)\n",
@@ -461,6 +463,7 @@ static int decon_enable(struct decon_device *decon)
 				(decon->state == DECON_STATE_INIT)) {
 		decon_info("decon%d init state\n", decon->id);
 		decon->state = DECON_STATE_ON;
+		decon_dfr_start(decon);
 		ret = -EBUSY;
 		goto err;
 	}
@@ -557,6 +560,9 @@ static int decon_enable(struct decon_device *decon)
 	 * DECON, DSIM and Panel are initialized as FULL size during UNBLANK
 	 */
 	DPU_FULL_RECT(&decon->win_up.prev_up_region, decon->lcd_info);
+	/* and the panel lost its contents, the first damage is all of it */
+	memset(decon->win_up.prev_state, 0, sizeof(decon->win_up.prev_state));
+	decon->static_scene.valid = false;
 
 	if (!decon->id && !decon->eint_status) {
 		enable_irq(decon->res.irq);
@@ -565,6 +571,7 @@ static int decon_enable(struct decon_device *decon)
 
 	decon->state = DECON_STATE_ON;
 	decon_reg_set_int(decon->id, &psr, 1);
+	decon_dfr_start(decon);
 #if defined(CONFIG_EXYNOS_DOZE)
 	decon_info("%s: doze_state: %d\n", __func__, decon->doze_state);
 	decon->doze_state = DOZE_STATE_NORMAL;
@@ -598,6 +605,7 @@ static int decon_disable(struct decon_device *decon)
 	}
 
 	kthread_flush_worker(&decon->up.worker);
+	decon_dfr_stop(decon);
 
 #if defined(CONFIG_SEC_INCELL)
 	if (decon->esd_recovery) {
@@ -1564,6 +1572,154 @@ static void decon_release_old_bufs(struct decon_device *decon,
 	}
 }
 
+/* time of the next vsync, from the phase of the last one */
+static u64 decon_next_vsync_ns(struct decon_device *decon, u32 period)
+{
+	u64 now = ktime_get_ns();
+	u64 last = ktime_to_ns(decon->vsync.timestamp);
+	u64 elapsed;
+
+	if (!last || last > now)
+		return now + period;
+
+	elapsed = now - last;
+	return now + period - do_div(elapsed, period);
+}
+
+/*
+ * A frame given a present time is held until the vsync closest to it is the
+ * next one, it then goes out as any other frame. Holding stops after a
+ * second, in case userspace gave a time nowhere near now.
+ */
+static void decon_wait_for_present_time(struct decon_device *decon,
+		struct decon_reg_data *regs)
+{
+	u32 fps = decon_get_fps(decon);
+	u32 period;
+	u32 held = 0;
+
+	if (!regs->present_time || !fps || decon->dt.out_type != DECON_OUT_DSI)
+		return;
+
+	period = NSEC_PER_SEC / fps;
+
+	while (held < fps &&
+		decon_next_vsync_ns(decon, period) + period / 2 < regs->present_time) {
+		if (decon_wait_for_vsync(decon, VSYNC_TIMEOUT_MSEC))
+			break;
+		held++;
+	}
+
+	decon->up.present_cnt++;
+	decon->up.present_held_vsyncs += held;
+	if (decon_next_vsync_ns(decon, period) > regs->present_time + period / 2) {
+		decon->up.present_late_cnt++;
+		decon_dbg("decon%d late present(%llu)\n", decon->id,
+				regs->present_time);
+	}
+}
+
+/* the parts of a window that make what it shows, fds being dups */
+static void decon_static_key(struct decon_win_config *key,
+		struct decon_win_config *config)
+{
+	memcpy(key, config, sizeof(struct decon_win_config));
+	if (key->state == DECON_WIN_STATE_BUFFER) {
+		memset(key->fd_idma, 0, sizeof(key->fd_idma));
+		key->fence_fd = 0;
+#if defined(CONFIG_DPU_20)
+		key->rel_fence = 0;
+#endif
+	}
+}
+
+static bool decon_static_frame(struct decon_device *decon,
+		struct decon_reg_data *regs)
+{
+	struct decon_static_scene *scene = &decon->static_scene;
+	struct decon_win_config key;
+	u64 bytes = 0;
+	int i, j;
+
+	if (!scene->valid || !regs->num_of_window || regs->need_update)
+		goto not_static;
+#if defined(CONFIG_SUPPORT_MASK_LAYER)
+	if (regs->mask_layer)
+		goto not_static;
+#endif
+
+	for (i = 0; i < decon->dt.max_win; i++) {
+		decon_static_key(&key, &regs->dpp_config[i]);
+		if (memcmp(&key, &scene->config[i], sizeof(key)))
+			goto not_static;
+
+		if (regs->plane_cnt[i] != decon->win[i]->plane_cnt)
+			goto not_static;
+
+		for (j = 0; j < regs->plane_cnt[i]; ++j)
+			if (regs->dma_buf_data[i][j].dma_buf !=
+					decon->win[i]->dma_buf_data[j].dma_buf)
+				goto not_static;
+
+		if (key.state == DECON_WIN_STATE_BUFFER)
+			bytes += (u64)key.src.w * key.src.h *
+				dpu_get_bpp(key.format) / 8;
+	}
+
+	scene->skip_cnt++;
+	scene->saved_bytes += bytes;
+	if (!scene->since)
+		scene->since = ktime_get_ns();
+
+	return true;
+
+not_static:
+	if (scene->since) {
+		scene->residency_ns += ktime_get_ns() - scene->since;
+		scene->since = 0;
+	}
+
+	return false;
+}
+
+/* called once a frame was sent, to tell the next ones repeating it */
+static void decon_static_update(struct decon_device *decon,
+		struct decon_reg_data *regs)
+{
+	struct decon_static_scene *scene = &decon->static_scene;
+	int i;
+
+	if (decon->dt.out_type != DECON_OUT_DSI ||
+			decon->dt.psr_mode != DECON_MIPI_COMMAND_MODE)
+		return;
+
+	scene->valid = regs->num_of_window && !decon->esd_recovery;
+	for (i = 0; i < decon->dt.max_win; i++)
+		decon_static_key(&scene->config[i], &regs->dpp_config[i]);
+}
+
+/*
+ * An unchanged frame holds references to the buffers already configured.
+ * Those are dropped instead of the old ones and the hardware, hibernating
+ * or not, is left alone.
+ */
+static void decon_skip_static_frame(struct decon_device *decon,
+		struct decon_reg_data *regs)
+{
+	int i, j;
+
+	for (i = 0; i < decon->dt.max_win; i++) {
+		if (regs->dma_buf_data[i][0].fence)
+			decon_wait_fence(regs->dma_buf_data[i][0].fence);
+
+		for (j = 0; j < regs->plane_cnt[i]; ++j)
+			decon_free_dma_buf(decon, &regs->dma_buf_data[i][j]);
+	}
+
+	decon_signal_fence(decon);
+	DPU_EVENT_LOG_FENCE(&decon->sd, regs, DPU_EVT_RELEASE_FENCE);
+}
+
 static void decon_update_regs(struct decon_device *decon,
 		struct decon_reg_data *regs)
 {
@@ -1579,6 +1735,11 @@ static void decon_update_regs(struct decon_device *decon,
 		video_emul = true;
 	}
 #endif
+	if (!video_emul && decon_static_frame(decon, regs)) {
+		decon_skip_static_frame(decon, regs);
+		return;
+	}
+
 	decon_exit_hiber(decon);
 
 	decon_acquire_old_bufs(decon, regs, old_dma_bufs, old_plane_cnt);
@@ -1592,6 +1753,8 @@ static void decon_update_regs(struct decon_device *decon,
 		}
 	}
 
+	decon_wait_for_present_time(decon, regs);
+
 	decon_check_used_dpp(decon, regs);
 
 	/* add calc and update bw : cur > prev */
@@ -1656,6 +1819,8 @@ static void decon_update_regs(struct decon_device *decon,
 end:
 	DPU_EVENT_LOG(DPU_EVT_TRIG_MASK, &decon->sd, ktime_set(0, 0));
 
+	decon_static_update(decon, regs);
+
 	decon_release_old_bufs(decon, regs, old_dma_bufs, old_plane_cnt);
 	/* signal to acquire fence */
 	decon_signal_fence(decon);
@@ -1884,12 +2049,20 @@ static int decon_set_win_config(struct decon_device *decon,
 		win_data->fence = -1;
 	}
 
+	regs->present_time = ((u64)win_data->extra.present_time_hi << 32) |
+		win_data->extra.present_time_lo;
+
+	decon_dfr_frame_update(decon);
+
 	dpu_prepare_win_update_config(decon, win_data, regs);
 
 	ret = decon_prepare_win_config(decon, win_data, regs);
 	if (ret)
 		goto err_prepare;
 
+	/* raise bus votes now, the frame is applied a fence wait later */
+	decon->bts.ops->bts_predict_bw(decon, regs);
+
 	if (win_data->fence >= 0) {
 #if defined(CONFIG_DPU_20)
 		decon_create_release_fences(decon, win_data, fence);
@@ -2005,6 +2178,8 @@ static int decon_ioctl(struct fb_info *info, unsigned int cmd,
 
 	case S3CFB_WIN_CONFIG_OLD:
 	case S3CFB_WIN_CONFIG:
+		/* the old layout has no extra to copy */
+		memset(&win_data.extra, 0, sizeof(win_data.extra));
 		if (copy_from_user(&win_data, (void __user *)arg, _IOC_SIZE(cmd))) {
 			ret = -EFAULT;
 			break;
@@ -3034,6 +3209,10 @@ static int decon_probe(struct platform_device *pdev)
 	decon->bts.ops = &decon_bts_control;
 	decon->bts.ops->bts_init(decon);
 
+	ret = decon_dfr_init(decon);
+	if (ret)
+		decon_warn("decon%d runs at a fixed frame rate\n", decon->id);
+
 	platform_set_drvdata(pdev, decon);
 	pm_runtime_enable(dev);
 
@@ -3110,6 +3289,7 @@ static int decon_remove(struct platform_device *pdev)
 	struct decon_device *decon = platform_get_drvdata(pdev);
 	int i;
 
+	decon_dfr_deinit(decon);
 	decon->bts.ops->bts_deinit(decon);
 
 	pm_runtime_disable(&pdev->dev);
@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2016 Samsung Electronics Co., Ltd.
+ *		http://www.samsung.com
+ *
+ * decon dynamic frame rate file for Samsung EXYNOS DPU driver
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+/*
+ * A video mode panel is refreshed whether the screen changes or not. When
+ * no frame was updated for idle_ms, the panel steps down one rate of the
+ * "dfr_fps" list of the decon node, and so on down to the slowest one. The
+ * next frame update steps it straight back to the fastest rate, and so does
+ * a touch, ahead of the frames it is going to cause.
+ *
+ * Userspace playing a video can hint its frame rate in dfr_content_fps, the
+ * panel then runs at the slowest listed rate that is a multiple of it while
+ * frames come in.
+ *
+ * The rate is changed by stretching the horizontal front porch, so that
+ * every line, and the frame, takes longer with the same DSI clock. Only the
+ * rates whose porch fits DSIM_HPORCH are kept.
+ */
+
+#include <linux/input.h>
+#include <linux/of.h>
+#include <linux/slab.h>
+
+#include "decon.h"
+#include "dsim.h"
+
+#define DECON_DFR_IDLE_MS	100
+
+static void decon_dfr_set(struct decon_device *decon, int idx)
+{
+	struct decon_dfr *dfr = &decon->dfr;
+	ktime_t now;
+	int ret;
+
+	if (idx == dfr->cur || decon->state != DECON_STATE_ON)
+		return;
+
+	ret = v4l2_subdev_call(decon->out_sd[0], core, ioctl, DSIM_IOC_SET_HFP,
+			(void *)(unsigned long)dfr->hfp[idx]);
+	if (ret) {
+		decon_err("decon%d failed to set %dfps(%d)\n", decon->id,
+				dfr->fps[idx], ret);
+		return;
+	}
+
+	now = ktime_get();
+	dfr->residency_ns[dfr->cur] += ktime_to_ns(ktime_sub(now, dfr->since));
+	dfr->since = now;
+
+	decon_dbg("decon%d %dfps -> %dfps\n", decon->id, dfr->fps[dfr->cur],
+			dfr->fps[idx]);
+	dfr->cur = idx;
+
+	decon->bts.ops->bts_update_fps(decon);
+}
+
+static void decon_dfr_idle_work(struct work_struct *work)
+{
+	struct decon_dfr *dfr = container_of(to_delayed_work(work),
+			struct decon_dfr, idle_work);
+	struct decon_device *decon = container_of(dfr, struct decon_device, dfr);
+
+	mutex_lock(&decon->lock);
+
+	if (!dfr->active)
+		goto out;
+
+	if (time_before(jiffies, dfr->touch_until)) {
+		mod_delayed_work(system_wq, &dfr->idle_work,
+				dfr->touch_until - jiffies);
+		goto out;
+	}
+
+	if (dfr->cur < dfr->nr_fps - 1) {
+		decon_dfr_set(decon, dfr->cur + 1);
+		if (dfr->cur < dfr->nr_fps - 1)
+			mod_delayed_work(system_wq, &dfr->idle_work,
+					msecs_to_jiffies(dfr->idle_ms));
+	}
+
+out:
+	mutex_unlock(&decon->lock);
+}
+
+static void decon_dfr_boost_work(struct work_struct *work)
+{
+	struct decon_dfr *dfr = container_of(work, struct decon_dfr, boost_work);
+	struct decon_device *decon = container_of(dfr, struct decon_device, dfr);
+
+	mutex_lock(&decon->lock);
+	if (dfr->active) {
+		decon_dfr_set(decon, 0);
+		mod_delayed_work(system_wq, &dfr->idle_work,
+				msecs_to_jiffies(dfr->idle_ms));
+	}
+	mutex_unlock(&decon->lock);
+}
+
+/* called with decon->lock held, for every win_config */
+void decon_dfr_frame_update(struct decon_device *decon)
+{
+	struct decon_dfr *dfr = &decon->dfr;
+	int idx;
+
+	if (!dfr->active)
+		return;
+
+	idx = time_before(jiffies, dfr->touch_until) ? 0 : dfr->content;
+	if (idx < dfr->cur || dfr->content_fps)
+		decon_dfr_set(decon, idx);
+
+	mod_delayed_work(system_wq, &dfr->idle_work,
+			msecs_to_jiffies(dfr->idle_ms));
+}
+
+/* called with decon->lock held, once the panel runs at its own timing */
+void decon_dfr_start(struct decon_device *decon)
+{
+	struct decon_dfr *dfr = &decon->dfr;
+
+	if (!dfr->supported)
+		return;
+
+	dfr->cur = 0;
+	dfr->since = ktime_get();
+	dfr->active = true;
+	mod_delayed_work(system_wq, &dfr->idle_work,
+			msecs_to_jiffies(dfr->idle_ms));
+}
+
+/* called with decon->lock held, the works see active cleared and bail out */
+void decon_dfr_stop(struct decon_device *decon)
+{
+	struct decon_dfr *dfr = &decon->dfr;
+
+	if (!dfr->active)
+		return;
+
+	dfr->residency_ns[dfr->cur] +=
+		ktime_to_ns(ktime_sub(ktime_get(), dfr->since));
+	dfr->active = false;
+	cancel_delayed_work(&dfr->idle_work);
+}
+
+u32 decon_get_fps(struct decon_device *decon)
+{
+	struct decon_dfr *dfr = &decon->dfr;
+
+	if (!dfr->active)
+		return decon->lcd_info->fps;
+
+	return dfr->fps[dfr->cur];
+}
+
+static void decon_dfr_input_event(struct input_handle *handle,
+		unsigned int type, unsigned int code, int value)
+{
+	struct decon_device *decon = handle->handler->private;
+	struct decon_dfr *dfr = &decon->dfr;
+
+	if (type != EV_ABS)
+		return;
+
+	WRITE_ONCE(dfr->touch_until, jiffies + msecs_to_jiffies(dfr->idle_ms));
+	if (READ_ONCE(dfr->cur))
+		schedule_work(&dfr->boost_work);
+}
+
+static int decon_dfr_input_connect(struct input_handler *handler,
+		struct input_dev *dev, const struct input_device_id *id)
+{
+	struct input_handle *handle;
+	int ret;
+
+	handle = kzalloc(sizeof(*handle), GFP_KERNEL);
+	if (!handle)
+		return -ENOMEM;
+
+	handle->dev = dev;
+	handle->handler = handler;
+	handle->name = "decon_dfr";
+
+	ret = input_register_handle(handle);
+	if (ret)
+		goto err_register;
+
+	ret = input_open_device(handle);
+	if (ret)
+		goto err_open;
+
+	return 0;
+
+err_open:
+	input_unregister_handle(handle);
+err_register:
+	kfree(handle);
+	return ret;
+}
+
+static void decon_dfr_input_disconnect(struct input_handle *handle)
+{
+	input_close_device(handle);
+	input_unregister_handle(handle);
+	kfree(handle);
+}
+
+static const struct input_device_id decon_dfr_input_ids[] = {
+	{
+		.flags = INPUT_DEVICE_ID_MATCH_EVBIT |
+			 INPUT_DEVICE_ID_MATCH_ABSBIT,
+		.evbit = { BIT_MASK(EV_ABS) },
+		.absbit = { [BIT_WORD(ABS_MT_POSITION_X)] =
+			    BIT_MASK(ABS_MT_POSITION_X) },
+	},
+	{ },
+};
+
+static ssize_t dfr_residency_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct decon_device *decon = dev_get_drvdata(dev);
+	struct decon_dfr *dfr = &decon->dfr;
+	u64 residency_ns[DECON_DFR_MAX_FPS];
+	ssize_t len = 0;
+	int i;
+
+	mutex_lock(&decon->lock);
+	memcpy(residency_ns, dfr->residency_ns, sizeof(residency_ns));
+	if (dfr->active)
+		residency_ns[dfr->cur] +=
+			ktime_to_ns(ktime_sub(ktime_get(), dfr->since));
+	mutex_unlock(&decon->lock);
+
+	for (i = 0; i < dfr->nr_fps; i++)
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%u: %llu\n",
+				dfr->fps[i], div_u64(residency_ns[i], NSEC_PER_MSEC));
+
+	return len;
+}
+static DEVICE_ATTR_RO(dfr_residency);
+
+static ssize_t dfr_content_fps_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct decon_device *decon = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", decon->dfr.content_fps);
+}
+
+static ssize_t dfr_content_fps_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct decon_device *decon = dev_get_drvdata(dev);
+	struct decon_dfr *dfr = &decon->dfr;
+	u32 content_fps;
+	int i;
+
+	if (kstrtou32(buf, 0, &content_fps))
+		return -EINVAL;
+
+	mutex_lock(&decon->lock);
+	dfr->content_fps = content_fps;
+	dfr->content = 0;
+	for (i = dfr->nr_fps - 1; content_fps && i > 0; i--) {
+		if (!(dfr->fps[i] % content_fps)) {
+			dfr->content = i;
+			break;
+		}
+	}
+	mutex_unlock(&decon->lock);
+
+	return count;
+}
+static DEVICE_ATTR_RW(dfr_content_fps);
+
+static ssize_t dfr_idle_ms_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct decon_device *decon = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", decon->dfr.idle_ms);
+}
+
+static ssize_t dfr_idle_ms_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct decon_device *decon = dev_get_drvdata(dev);
+	u32 idle_ms;
+
+	if (kstrtou32(buf, 0, &idle_ms) || !idle_ms)
+		return -EINVAL;
+
+	decon->dfr.idle_ms = idle_ms;
+
+	return count;
+}
+static DEVICE_ATTR_RW(dfr_idle_ms);
+
+static struct attribute *decon_dfr_attrs[] = {
+	&dev_attr_dfr_residency.attr,
+	&dev_attr_dfr_content_fps.attr,
+	&dev_attr_dfr_idle_ms.attr,
+	NULL,
+};
+
+static const struct attribute_group decon_dfr_attr_group = {
+	.attrs = decon_dfr_attrs,
+};
+
+static int decon_dfr_parse_dt(struct decon_device *decon)
+{
+	struct decon_dfr *dfr = &decon->dfr;
+	struct decon_lcd *lcd = decon->lcd_info;
+	u32 fps[DECON_DFR_MAX_FPS];
+	u32 htotal, hfp;
+	int i, cnt;
+
+	cnt = of_property_count_u32_elems(decon->dev->of_node, "dfr_fps");
+	if (cnt <= 0)
+		return -ENOENT;
+
+	if (cnt > DECON_DFR_MAX_FPS)
+		cnt = DECON_DFR_MAX_FPS;
+
+	if (of_property_read_u32_array(decon->dev->of_node, "dfr_fps", fps, cnt))
+		return -EINVAL;
+
+	if (fps[0] != lcd->fps) {
+		decon_err("decon%d dfr_fps must start at %dfps\n", decon->id,
+				lcd->fps);
+		return -EINVAL;
+	}
+
+	htotal = lcd->hsa + lcd->hbp + lcd->xres + lcd->hfp;
+	dfr->nr_fps = 0;
+	for (i = 0; i < cnt; i++) {
+		if (!fps[i] || fps[i] > lcd->fps ||
+				(i && fps[i] >= dfr->fps[dfr->nr_fps - 1]))
+			continue;
+
+		hfp = htotal * lcd->fps / fps[i] - (htotal - lcd->hfp);
+		if (hfp > (DSIM_HPORCH_HFP_MASK >> 16)) {
+			decon_warn("decon%d %dfps needs too long a porch(%d)\n",
+					decon->id, fps[i], hfp);
+			continue;
+		}
+
+		dfr->fps[dfr->nr_fps] = fps[i];
+		dfr->hfp[dfr->nr_fps] = hfp;
+		dfr->nr_fps++;
+	}
+
+	return dfr->nr_fps > 1 ? 0 : -EINVAL;
+}
+
+int decon_dfr_init(struct decon_device *decon)
+{
+	struct decon_dfr *dfr = &decon->dfr;
+	int i, ret;
+
+	if (decon->id || decon->dt.out_type != DECON_OUT_DSI ||
+			decon->dt.psr_mode != DECON_VIDEO_MODE ||
+			decon->dt.dsi_mode == DSI_MODE_DUAL_DSI ||
+			decon->lcd_info->dsc_enabled)
+		return 0;
+
+	if (decon_dfr_parse_dt(decon))
+		return 0;
+
+	dfr->idle_ms = DECON_DFR_IDLE_MS;
+	INIT_DELAYED_WORK(&dfr->idle_work, decon_dfr_idle_work);
+	INIT_WORK(&dfr->boost_work, decon_dfr_boost_work);
+
+	ret = sysfs_create_group(&decon->dev->kobj, &decon_dfr_attr_group);
+	if (ret) {
+		decon_err("decon%d failed to create dfr files(%d)\n",
+				decon->id, ret);
+		return ret;
+	}
+
+	dfr->input_handler.event = decon_dfr_input_event;
+	dfr->input_handler.connect = decon_dfr_input_connect;
+	dfr->input_handler.disconnect = decon_dfr_input_disconnect;
+	dfr->input_handler.name = "decon_dfr";
+	dfr->input_handler.id_table = decon_dfr_input_ids;
+	dfr->input_handler.private = decon;
+	if (input_register_handler(&dfr->input_handler)) {
+		decon_warn("decon%d touch does not raise the frame rate\n",
+				decon->id);
+		dfr->input_handler.private = NULL;
+	}
+
+	dfr->supported = true;
+	for (i = 0; i < dfr->nr_fps; i++)
+		decon_info("decon%d dfr %dfps hfp(%d)\n", decon->id,
+				dfr->fps[i], dfr->hfp[i]);
+
+	return 0;
+}
+
+void decon_dfr_deinit(struct decon_device *decon)
+{
+	struct decon_dfr *dfr = &decon->dfr;
+
+	if (!dfr->supported)
+		return;
+
+	if (dfr->input_handler.private)
+		input_unregister_handler(&dfr->input_handler);
+	sysfs_remove_group(&decon->dev->kobj, &decon_dfr_attr_group);
+
+	mutex_lock(&decon->lock);
+	decon_dfr_stop(decon);
+	dfr->supported = false;
+	mutex_unlock(&decon->lock);
+
+	cancel_delayed_work_sync(&dfr->idle_work);
+	cancel_work_sync(&dfr->boost_work);
+}
@@ -116,6 +116,8 @@ static int decon_set_doze(struct decon_device *decon)
 	 * DECON, DSIM and Panel are initialized as FULL size during UNBLANK
 	 */
 	DPU_FULL_RECT(&decon->win_up.prev_up_region, decon->lcd_info);
+	/* and the panel lost its contents, the first damage is all of it */
+	memset(decon->win_up.prev_state, 0, sizeof(decon->win_up.prev_state));
 
 	if (!decon->id && !decon->eint_status) {
 		enable_irq(decon->res.irq);
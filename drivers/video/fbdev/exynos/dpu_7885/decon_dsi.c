@@ -23,6 +23,7 @@
 #include "decon.h"
 #include "dsim.h"
 #include "dpp.h"
+#include "decon_notify.h"
 #include "../../../../soc/samsung/pwrcal/pwrcal.h"
 #include "../../../../soc/samsung/pwrcal/S5E8890/S5E8890-vclk.h"
 #include "../../../../../kernel/irq/internals.h"
@@ -49,6 +50,9 @@ static irqreturn_t decon_irq_handler(int irq, void *dev_data)
 		/* VSYNC interrupt, accept it */
 		decon->frame_cnt++;
 		wake_up_interruptible_all(&decon->wait_vstatus);
+		/* video mode panels have no TE, the frame start is the vsync */
+		if (!decon->id && decon->dt.psr_mode == DECON_VIDEO_MODE)
+			decon_vsync_notifier_call_chain(ktime_get());
 		if (decon->state == DECON_STATE_TUI)
 			decon_info("%s:%d TUI Frame Start\n", __func__, __LINE__);
 	}
@@ -292,6 +296,9 @@ static irqreturn_t decon_ext_irq_handler(int irq, void *dev_id)
 	wake_up_interruptible_all(&decon->vsync.wait);
 
 	spin_unlock(&decon->slock);
+
+	if (!decon->id)
+		decon_vsync_notifier_call_chain(timestamp);
 #ifdef CONFIG_EXYNOS_WD_DVFS
 	if (devfreq_change_task)
 		wake_up_process(devfreq_change_task);
@@ -354,6 +361,34 @@ static ssize_t decon_show_vsync(struct device *dev,
 }
 static DEVICE_ATTR(vsync, S_IRUGO, decon_show_vsync, NULL);
 
+static ssize_t decon_show_present_stat(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct decon_device *decon = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE, "presents: %u\nheld_vsyncs: %u\nlate: %u\n",
+			decon->up.present_cnt, decon->up.present_held_vsyncs,
+			decon->up.present_late_cnt);
+}
+static DEVICE_ATTR(present_stat, S_IRUGO, decon_show_present_stat, NULL);
+
+static ssize_t decon_show_static_stat(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct decon_device *decon = dev_get_drvdata(dev);
+	struct decon_static_scene *scene = &decon->static_scene;
+	u64 residency = scene->residency_ns;
+
+	if (scene->since)
+		residency += ktime_get_ns() - scene->since;
+
+	return scnprintf(buf, PAGE_SIZE,
+			"skipped: %u\nsaved_kbytes: %llu\nresidency_ms: %llu\n",
+			scene->skip_cnt, scene->saved_bytes >> 10,
+			div_u64(residency, NSEC_PER_MSEC));
+}
+static DEVICE_ATTR(static_stat, S_IRUGO, decon_show_static_stat, NULL);
+
 static int decon_vsync_thread(void *data)
 {
 	struct decon_device *decon = data;
@@ -388,6 +423,12 @@ int decon_create_vsync_thread(struct decon_device *decon)
 		return ret;
 	}
 
+	if (device_create_file(decon->dev, &dev_attr_present_stat))
+		decon_warn("failed to create present_stat file\n");
+
+	if (device_create_file(decon->dev, &dev_attr_static_stat))
+		decon_warn("failed to create static_stat file\n");
+
 	sprintf(name, "decon%d-vsync", decon->id);
 	decon->vsync.thread = kthread_run_perf_critical(decon_vsync_thread, decon, name);
 	if (IS_ERR_OR_NULL(decon->vsync.thread)) {
@@ -401,12 +442,16 @@ int decon_create_vsync_thread(struct decon_device *decon)
 	return 0;
 
 err:
+	device_remove_file(decon->dev, &dev_attr_present_stat);
+	device_remove_file(decon->dev, &dev_attr_static_stat);
 	device_remove_file(decon->dev, &dev_attr_vsync);
 	return ret;
 }
 
 void decon_destroy_vsync_thread(struct decon_device *decon)
 {
+	device_remove_file(decon->dev, &dev_attr_present_stat);
+	device_remove_file(decon->dev, &dev_attr_static_stat);
 	device_remove_file(decon->dev, &dev_attr_vsync);
 
 	if (decon->vsync.thread)
@@ -44,6 +44,7 @@ static u32 EVENT_TO_STAMP[EVENT_MAX] = {
 };
 
 static BLOCKING_NOTIFIER_HEAD(decon_notifier_list);
+static ATOMIC_NOTIFIER_HEAD(decon_vsync_notifier_list);
 
 int decon_register_notifier(struct notifier_block *nb)
 {
@@ -137,6 +138,24 @@ int decon_simple_notifier_call_chain(unsigned long val, int blank)
 }
 EXPORT_SYMBOL(decon_simple_notifier_call_chain);
 
+int decon_register_vsync_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_register(&decon_vsync_notifier_list, nb);
+}
+EXPORT_SYMBOL(decon_register_vsync_notifier);
+
+int decon_unregister_vsync_notifier(struct notifier_block *nb)
+{
+	return atomic_notifier_chain_unregister(&decon_vsync_notifier_list, nb);
+}
+EXPORT_SYMBOL(decon_unregister_vsync_notifier);
+
+void decon_vsync_notifier_call_chain(ktime_t timestamp)
+{
+	atomic_notifier_call_chain(&decon_vsync_notifier_list, 0, &timestamp);
+}
+EXPORT_SYMBOL(decon_vsync_notifier_call_chain);
+
 struct notifier_block decon_nb_priority_max = {
 	.priority = INT_MAX,
 };
@@ -10,6 +10,7 @@
 #ifndef __DECON_NOTIFY_H__
 #define __DECON_NOTIFY_H__
 
+#include <linux/ktime.h>
 #include <linux/notifier.h>
 
 #define EVENT_LIST	\
@@ -73,5 +74,10 @@ extern int decon_unregister_notifier(struct notifier_block *nb);
 extern int decon_notifier_call_chain(unsigned long val, void *v);
 extern int decon_simple_notifier_call_chain(unsigned long val, int blank);
 
+/* called from the vsync interrupt of decon0 with the ktime_t of the vsync */
+extern int decon_register_vsync_notifier(struct notifier_block *nb);
+extern int decon_unregister_vsync_notifier(struct notifier_block *nb);
+extern void decon_vsync_notifier_call_chain(ktime_t timestamp);
+
 #endif
 
@@ -356,6 +356,7 @@ u32 dsim_reg_payload_fifo_is_empty(u32 id);
 void dsim_reg_clear_int(u32 id, u32 int_src);
 void dsim_reg_set_fifo_ctrl(u32 id, u32 cfg);
 void dsim_reg_enable_shadow_read(u32 id, u32 en);
+void dsim_reg_set_hfp(u32 id, u32 hfp);
 bool dsim_reg_is_writable_ph_fifo_state(u32 id, struct decon_lcd *lcd_info);
 void dsim_reg_wr_tx_header(u32 id, u32 data_id, unsigned long data0, u32 data1, u32 bta_type);
 void dsim_set_bist(u32 id, u32 en);
@@ -383,4 +384,5 @@ void dphy_power_on(struct dsim_device *dsim, int on);
 #define DSIM_IOC_GET_WCLK		_IOW('D', 9, u32)
 #define DSIM_IOC_DOZE			_IOW('D', 10, u32)
 #define DSIM_IOC_DOZE_SUSPEND		_IOW('D', 11, u32)
+#define DSIM_IOC_SET_HFP		_IOW('D', 12, u32)
 #endif /* __SAMSUNG_DSIM_H__ */
@@ -1075,6 +1075,15 @@ static long dsim_ioctl(struct v4l2_subdev *sd, unsigned int cmd, void *arg)
 			dsim_err("DSIM:ERR:%s:failed to doze suspend\n", __func__);
 		break;
 #endif
+	case DSIM_IOC_SET_HFP:
+		/* shadowed, the new porch is used from the next frame */
+		if (dsim->state != DSIM_STATE_ON) {
+			ret = -EBUSY;
+			break;
+		}
+		dsim_reg_set_hfp(dsim->id, (u32)(unsigned long)arg);
+		break;
+
 	default:
 		dsim_err("unsupported ioctl");
 		ret = -EINVAL;
@@ -723,6 +723,36 @@ static const struct file_operations decon_bts_fops = {
 	.release = seq_release,
 };
 
+static int decon_debug_bts_stat_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+	struct decon_bts *bts = &decon->bts;
+
+	mutex_lock(&bts->lock);
+	seq_printf(s, "voted: %u\nneeded: %u\n", bts->prev_total_bw,
+			bts->need_bw);
+	seq_printf(s, "early_raises: %u\nlate_raises: %u\n",
+			bts->early_cnt, bts->late_cnt);
+	seq_printf(s, "over_ms: %llu\nunderrun_ms: %llu\n",
+			div_u64(bts->over_ns, NSEC_PER_MSEC),
+			div_u64(bts->underrun_ns, NSEC_PER_MSEC));
+	mutex_unlock(&bts->lock);
+
+	return 0;
+}
+
+static int decon_debug_bts_stat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, decon_debug_bts_stat_show, inode->i_private);
+}
+
+static const struct file_operations decon_bts_stat_fops = {
+	.open = decon_debug_bts_stat_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 static int decon_debug_win_show(struct seq_file *s, void *unused)
 {
 	seq_printf(s, "%u\n", win_update_log_level);
@@ -766,6 +796,32 @@ static const struct file_operations decon_win_fops = {
 	.release = seq_release,
 };
 
+static int decon_debug_win_stat_show(struct seq_file *s, void *unused)
+{
+	struct decon_device *decon = s->private;
+	struct decon_win_update *win_up = &decon->win_up;
+
+	seq_printf(s, "partial: %u\nfull: %u\nfrom_damage: %u\n",
+			win_up->partial_cnt, win_up->full_cnt, win_up->damage_cnt);
+	seq_printf(s, "link_kbytes: %llu\nsaved_kbytes: %llu\n",
+			(win_up->full_bytes - win_up->saved_bytes) >> 10,
+			win_up->saved_bytes >> 10);
+
+	return 0;
+}
+
+static int decon_debug_win_stat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, decon_debug_win_stat_show, inode->i_private);
+}
+
+static const struct file_operations decon_win_stat_fops = {
+	.open = decon_debug_win_stat_open,
+	.read = seq_read,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
 /*
  *------------------------------------------------------------
  * AFBC Recovery count check
@@ -854,6 +910,18 @@ int decon_create_debugfs(struct decon_device *decon)
 			ret = -ENOENT;
 			goto err_debugfs;
 		}
+		if (!debugfs_create_file("bts_stat", 0444,
+				decon->d.debug_root, decon, &decon_bts_stat_fops))
+			decon_warn("failed to create bts stat file\n");
+		debugfs_create_u32("bts_ramp_us", 0644,
+				decon->d.debug_root, &decon->bts.ramp_us);
+		debugfs_create_u32("bts_drop_ms", 0644,
+				decon->d.debug_root, &decon->bts.drop_ms);
+		if (!debugfs_create_file("win_update_stat", 0444,
+				decon->d.debug_root, decon, &decon_win_stat_fops))
+			decon_warn("failed to create win update stat file\n");
+		debugfs_create_u32("win_update_max_pct", 0644,
+				decon->d.debug_root, &decon->win_up.max_pct);
 	}
 
 	snprintf(name, MAX_NAME_SIZE, "afbc_rcv%d", decon->id);
@@ -15,6 +15,162 @@
 #include "dpp.h"
 #include "dsim.h"
 
+/* partial updates covering more of the LCD are not worth their commands */
+#define WIN_UPDATE_MAX_PCT_DEFAULT	80
+
+static void win_update_add_damage(struct decon_rect *damage, bool *damaged,
+		int x, int y, int w, int h)
+{
+	if (w <= 0 || h <= 0)
+		return;
+
+	if (!*damaged) {
+		damage->left = x;
+		damage->top = y;
+		damage->right = x + w - 1;
+		damage->bottom = y + h - 1;
+		*damaged = true;
+		return;
+	}
+
+	damage->left = min(damage->left, x);
+	damage->top = min(damage->top, y);
+	damage->right = max(damage->right, x + w - 1);
+	damage->bottom = max(damage->bottom, y + h - 1);
+}
+
+/*
+ * Fill the update region from the damage of each window, for userspace
+ * that does not compute one itself. Windows that appeared, went away or
+ * moved since the last frame damage both their old and new place.
+ */
+static void win_update_collect_damage(struct decon_device *decon,
+		struct decon_win_config_data *win_data)
+{
+	struct decon_win_config *win_config = win_data->config;
+	struct decon_win_config *update_config = &win_config[DECON_WIN_UPDATE_IDX];
+	struct decon_win_config *config;
+	struct decon_frame *prev;
+	struct decon_win_rect *dmg;
+	struct decon_rect damage;
+	bool damaged = false;
+	int i, x, y, r, b;
+
+	if (!(win_data->extra.flags & DECON_WIN_EXTRA_DAMAGE))
+		return;
+
+	if (update_config->state == DECON_WIN_STATE_UPDATE)
+		return;
+
+	for (i = 0; i < decon->dt.max_win; i++) {
+		config = &win_config[i];
+		prev = &decon->win_up.prev_dst[i];
+
+		if (config->state != decon->win_up.prev_state[i] ||
+				memcmp(&config->dst, prev, sizeof(*prev))) {
+			if (decon->win_up.prev_state[i] != DECON_WIN_STATE_DISABLED)
+				win_update_add_damage(&damage, &damaged,
+						prev->x, prev->y, prev->w, prev->h);
+			if (config->state != DECON_WIN_STATE_DISABLED)
+				win_update_add_damage(&damage, &damaged,
+						config->dst.x, config->dst.y,
+						config->dst.w, config->dst.h);
+			continue;
+		}
+
+		if (config->state != DECON_WIN_STATE_BUFFER)
+			continue;
+
+		/* clipped to the window, the rest of it did not change */
+		dmg = &config->transparent_area;
+		x = max_t(int, dmg->x, config->dst.x);
+		y = max_t(int, dmg->y, config->dst.y);
+		r = min_t(int, dmg->x + dmg->w, config->dst.x + config->dst.w);
+		b = min_t(int, dmg->y + dmg->h, config->dst.y + config->dst.h);
+		win_update_add_damage(&damage, &damaged, x, y, r - x, b - y);
+	}
+
+	/* nothing changed: leave it to a full update */
+	if (!damaged)
+		return;
+
+	damage.left = max(damage.left, 0);
+	damage.top = max(damage.top, 0);
+	damage.right = min_t(int, damage.right, decon->lcd_info->xres - 1);
+	damage.bottom = min_t(int, damage.bottom, decon->lcd_info->yres - 1);
+	if (damage.left > damage.right || damage.top > damage.bottom)
+		return;
+
+	memset(update_config, 0, sizeof(struct decon_win_config));
+	update_config->state = DECON_WIN_STATE_UPDATE;
+	update_config->dst.x = damage.left;
+	update_config->dst.y = damage.top;
+	update_config->dst.w = damage.right - damage.left + 1;
+	update_config->dst.h = damage.bottom - damage.top + 1;
+	decon->win_up.damage_cnt++;
+
+	DPU_DEBUG_WIN("damage region[%d %d %d %d]\n",
+			update_config->dst.x, update_config->dst.y,
+			update_config->dst.w, update_config->dst.h);
+}
+
+static void win_update_save_windows(struct decon_device *decon,
+		struct decon_win_config *win_config)
+{
+	int i;
+
+	for (i = 0; i < decon->dt.max_win; i++) {
+		decon->win_up.prev_state[i] = win_config[i].state;
+		memcpy(&decon->win_up.prev_dst[i], &win_config[i].dst,
+				sizeof(struct decon_frame));
+	}
+}
+
+/* bytes a frame of @r takes on the DSI link, RGB888 or a third with DSC */
+static u64 win_update_link_bytes(struct decon_device *decon,
+		struct decon_rect *r)
+{
+	u64 bytes = (u64)(r->right - r->left + 1) * (r->bottom - r->top + 1) * 3;
+
+	if (decon->lcd_info->dsc_enabled)
+		bytes = div_u64(bytes, 3);
+
+	return bytes;
+}
+
+/*
+ * A partial update costs the column and page commands and, when its size
+ * changes, reprogramming DECON and DSIM. Close to the full size that is
+ * more than the transfer it saves.
+ */
+static void win_update_check_bandwidth(struct decon_device *decon,
+		struct decon_reg_data *regs)
+{
+	struct decon_rect full;
+	u64 full_bytes, bytes;
+
+	DPU_FULL_RECT(&full, decon->lcd_info);
+	full_bytes = win_update_link_bytes(decon, &full);
+
+	if (is_decon_rect_differ(&regs->up_region, &full)) {
+		bytes = win_update_link_bytes(decon, &regs->up_region);
+		if (bytes * 100 > full_bytes * decon->win_up.max_pct) {
+			DPU_DEBUG_WIN("changed full: %llu of %llu bytes\n",
+					bytes, full_bytes);
+			DPU_FULL_RECT(&regs->up_region, decon->lcd_info);
+		}
+	}
+
+	decon->win_up.full_bytes += full_bytes;
+	if (is_decon_rect_differ(&regs->up_region, &full)) {
+		decon->win_up.partial_cnt++;
+		decon->win_up.saved_bytes += full_bytes -
+			win_update_link_bytes(decon, &regs->up_region);
+	} else {
+		decon->win_up.full_cnt++;
+	}
+}
+
 static void win_update_adjust_region(struct decon_device *decon,
 		struct decon_win_config *win_config,
 		struct decon_reg_data *regs)
@@ -251,12 +407,19 @@ void dpu_prepare_win_update_config(struct decon_device *decon,
 
 	decon_dbg("%s +\n", __func__);
 
+	/* compute update region from per window damage, if given */
+	win_update_collect_damage(decon, win_data);
+	win_update_save_windows(decon, win_config);
+
 	/* find adjusted update region on LCD */
 	win_update_adjust_region(decon, win_config, regs);
 
 	/* check DPP hw limitation if violated, update region is changed to full */
 	win_update_check_limitation(decon, win_config, regs);
 
+	/* fall back to full if partial would not save enough */
+	win_update_check_bandwidth(decon, regs);
+
 	/*
 	 * If update region is changed, need_update flag is set.
 	 * That means hw configuration is needed
@@ -468,6 +631,7 @@ void dpu_init_win_update(struct decon_device *decon)
 	}
 
 	DPU_FULL_RECT(&decon->win_up.prev_up_region, lcd);
+	decon->win_up.max_pct = WIN_UPDATE_MAX_PCT_DEFAULT;
 
 	decon->win_up.hori_cnt = decon->lcd_info->xres / decon->win_up.rect_w;
 	if (lcd->dsc_enabled) {
@@ -11,6 +11,7 @@
 #include <linux/module.h>
 #include <linux/platform_device.h>
 #include <linux/of.h>
+#include <linux/dma-buf.h>
 #include <linux/slab.h>
 #include <linux/exynos_iovmm.h>
 #include <linux/pm_runtime.h>
@@ -38,6 +39,10 @@ int score_buftracker_init(struct score_buftracker *buftracker)
 	buftracker->userptr_cnt = 0;
 	INIT_LIST_HEAD(&buftracker->userptr_list);
 	spin_lock_init(&buftracker->userptr_lock);
+
+	buftracker->map_cnt = 0;
+	buftracker->reuse_cnt = 0;
+	buftracker->stale_cnt = 0;
 #ifdef TEST_BUFTRACKER
 	test_buftracker.buf_cnt = 0;
 	INIT_LIST_HEAD(&test_buftracker.buf_list);
@@ -118,100 +123,143 @@ exit:
 	return ret;
 }
 
+static struct score_memory_buffer *__score_buftracker_find(
+		struct score_buftracker *buftracker, int fd)
+{
+	unsigned long flag;
+	struct score_memory_buffer *target_buf, *found_buf = NULL;
+
+	spin_lock_irqsave(&buftracker->buf_lock, flag);
+	list_for_each_entry(target_buf, &buftracker->buf_list, list) {
+		if (target_buf->m.fd == fd) {
+			found_buf = target_buf;
+			break;
+		}
+	}
+	spin_unlock_irqrestore(&buftracker->buf_lock, flag);
+
+	return found_buf;
+}
+
+/*
+ * DMABUF mappings are kept from the first task using them until the vertex
+ * is stopped. The fd alone does not tell the buffer, userspace may close it
+ * and be given the same number for another one, so a mapping is only reused
+ * while the fd still refers to the dma-buf that was mapped.
+ */
+static int __score_buftracker_lookup(struct score_buftracker *buftracker,
+		struct score_memory_buffer *buffer,
+		struct score_memory_buffer **slot)
+{
+	struct score_memory_buffer *cached_buf;
+	struct dma_buf *dbuf;
+
+	cached_buf = __score_buftracker_find(buftracker, buffer->m.fd);
+	if (!cached_buf)
+		return SCORE_BUFTRACKER_SEARCH_STATE_NEW;
+
+	*slot = cached_buf;
+
+	dbuf = dma_buf_get(buffer->m.fd);
+	if (IS_ERR_OR_NULL(dbuf))
+		return SCORE_BUFTRACKER_SEARCH_STATE_STALE;
+
+	/* the cached mapping holds a reference, so dbuf can be compared */
+	dma_buf_put(dbuf);
+	if (dbuf != cached_buf->dbuf || cached_buf->size < buffer->size)
+		return SCORE_BUFTRACKER_SEARCH_STATE_STALE;
+
+	return SCORE_BUFTRACKER_SEARCH_STATE_ALREADY_REGISTERED;
+}
+
+static void __score_buftracker_copy_map(struct score_memory_buffer *dst,
+		struct score_memory_buffer *src)
+{
+	dst->dvaddr = src->dvaddr;
+	dst->kvaddr = src->kvaddr;
+	dst->mem_priv = src->mem_priv;
+	dst->cookie = src->cookie;
+	dst->dbuf = src->dbuf;
+	dst->size = src->size;
+}
+
 int score_buftracker_add(struct score_buftracker *buftracker,
 		struct score_memory_buffer *buffer)
 {
 	int ret = 0;
-	int buf_ret = 0;
+	int buf_ret = SCORE_BUFTRACKER_SEARCH_STATE_NEW;
 	struct score_vertex_ctx *vctx;
 	struct score_memory *memory;
+	struct score_memory_buffer *slot = NULL;
 
 	vctx = container_of(buftracker, struct score_vertex_ctx, buftracker);
 	memory = (struct score_memory *)&vctx->memory;
 
-	/* copy buffer infomations */
-#if 1
-	memcpy((void *)&buftracker->buffer_slot[buftracker->pos],
-			(void *)buffer,
-			sizeof(struct score_memory_buffer));
-#else
-	buftracker->buffer_slot[buftracker->pos].m.fd = buffer->m.fd;
-	buftracker->buffer_slot[buftracker->pos].dvaddr = buffer->dvaddr;
-	buftracker->buffer_slot[buftracker->pos].kvaddr = buffer->kvaddr;
-	buftracker->buffer_slot[buftracker->pos].mem_priv = buffer->mem_priv;
-	buftracker->buffer_slot[buftracker->pos].cookie = buffer->cookie;
-	buftracker->buffer_slot[buftracker->pos].dbuf = buffer->dbuf;
-	buftracker->buffer_slot[buftracker->pos].size = buffer->size;
-#endif
-	/* add list to compare */
-	buf_ret = score_buftracker_add_list(buftracker,
-			&buftracker->buffer_slot[buftracker->pos]);
-
-	/* if not exist buffer in list, completing this job */
-	if ((buf_ret == SCORE_BUFTRACKER_SEARCH_STATE_NEW) ||
-			(buf_ret == SCORE_BUFTRACKER_SEARCH_STATE_INSERT)) {
-		switch (buffer->memory) {
-		case VS4L_MEMORY_DMABUF:
-			ret = score_memory_map(memory, buffer);
-			break;
-		case VS4L_MEMORY_USERPTR:
-			ret = score_memory_map_userptr(memory, buffer);
-			break;
-		default:
-			score_err("memory type is invalid (%d) \n", buffer->memory);
-			break;
-		}
-
-		if (ret) {
-			struct score_memory_buffer *target_buf, *temp_buf;
-			score_err("score_memory_map is fail (%d) \n", ret);
-			/* score_memory_unmap(memory, &score_buffer); */
+	if (buffer->memory == VS4L_MEMORY_DMABUF)
+		buf_ret = __score_buftracker_lookup(buftracker, buffer, &slot);
 
-			switch (buffer->memory) {
-			case VS4L_MEMORY_DMABUF:
-				score_memory_unmap(memory, buffer);
-				break;
-			case VS4L_MEMORY_USERPTR:
-				score_memory_unmap_userptr(memory, buffer);
-				break;
-			default:
-				score_err("memory type is invalid (%d) \n", buffer->memory);
-				break;
-			}
-
-			list_for_each_entry_safe(target_buf, temp_buf,
-					&buftracker->buf_list, list) {
-				if (target_buf->m.fd == buffer->m.fd) {
-					list_del(&buffer->list);
+	if (buf_ret == SCORE_BUFTRACKER_SEARCH_STATE_ALREADY_REGISTERED) {
+		__score_buftracker_copy_map(buffer, slot);
+		buftracker->reuse_cnt++;
+		return 0;
+	}
 
-					break;
-				}
-			}
+	if (buf_ret == SCORE_BUFTRACKER_SEARCH_STATE_STALE) {
+		/* remapped in place, the slot keeps its position in the list */
+		score_note("STALE:fd(%d) dbuf(%p) \n", buffer->m.fd, slot->dbuf);
+		score_memory_unmap(memory, slot);
+		buftracker->stale_cnt++;
+	} else {
+		if (buftracker->pos >= BUF_MAX_COUNT) {
+			score_err("buffer slot is full (%d) fd(%d) \n",
+					buftracker->pos, buffer->m.fd);
+			return -ENOMEM;
+		}
+		slot = &buftracker->buffer_slot[buftracker->pos];
+	}
 
-			memset(&buftracker->buffer_slot[buftracker->pos],
-					0x0,
-					sizeof(struct score_memory_buffer));
+	slot->m = buffer->m;
+	slot->memory = buffer->memory;
+	slot->size = buffer->size;
+	slot->dvaddr = 0;
+	slot->kvaddr = NULL;
+	slot->mem_priv = NULL;
+	slot->cookie = NULL;
+	slot->dbuf = NULL;
+
+	switch (slot->memory) {
+	case VS4L_MEMORY_DMABUF:
+		ret = score_memory_map(memory, slot);
+		break;
+	case VS4L_MEMORY_USERPTR:
+		ret = score_memory_map_userptr(memory, slot);
+		break;
+	default:
+		score_err("memory type is invalid (%d) \n", slot->memory);
+		ret = -EINVAL;
+		break;
+	}
 
-			goto p_err;
-		}
+	if (ret) {
+		score_err("score_memory_map is fail (%d) \n", ret);
+		/*
+		 * score_memory_map() released what it got, a stale slot stays
+		 * in the list with an fd nothing is looked up with and no
+		 * mapping, for score_buftracker_remove_all() to skip.
+		 */
+		slot->m.fd = -1;
+		slot->dvaddr = 0;
+		slot->mem_priv = NULL;
+		slot->dbuf = NULL;
+		goto p_err;
+	}
 
-		buftracker->buffer_slot[buftracker->pos].m.fd = buffer->m.fd;
-		buftracker->buffer_slot[buftracker->pos].dvaddr = buffer->dvaddr;
-		buftracker->buffer_slot[buftracker->pos].mem_priv = buffer->mem_priv;
-		buftracker->buffer_slot[buftracker->pos].cookie = buffer->cookie;
-		buftracker->buffer_slot[buftracker->pos].dbuf = buffer->dbuf;
-		buftracker->buffer_slot[buftracker->pos].size = buffer->size;
-#ifdef BUF_MAP_KVADDR
-		buftracker->buffer_slot[buftracker->pos].kvaddr = buffer->kvaddr;
-#endif
-		buftracker->pos ++;
+	buftracker->map_cnt++;
+	__score_buftracker_copy_map(buffer, slot);
 
-		/* score_buftracker_dump_list(buftracker); */
-	} else {
-		/* removed canditated buffer infomation to use next time */
-		memset(&buftracker->buffer_slot[buftracker->pos],
-				0x0,
-				sizeof(struct score_memory_buffer));
+	if (buf_ret == SCORE_BUFTRACKER_SEARCH_STATE_NEW) {
+		score_buftracker_add_list(buftracker, slot);
+		buftracker->pos++;
 	}
 
 	/* score_buftracker_dump_list(buftracker); */
@@ -235,6 +283,10 @@ int score_buftracker_dump(struct score_buftracker *buftracker)
 {
 	int loop, ret = 0;
 
+	score_info("buffer map(%u) reuse(%u) stale(%u) \n",
+			buftracker->map_cnt, buftracker->reuse_cnt,
+			buftracker->stale_cnt);
+
 	for (loop = 0; loop < buftracker->pos; loop ++) {
 #ifdef BUF_MAP_KVADDR
 		score_info("(%d) fd(%d) dvaddr(0x%llx) (%p, %p, %p, %p) size(%ld) \n",
@@ -274,11 +326,15 @@ int score_buftracker_remove_all(struct score_buftracker *buftracker)
 	int ret = 0;
 	struct score_vertex_ctx *vctx;
 	struct score_memory *memory;
+	unsigned long flag;
 
 	vctx = container_of(buftracker, struct score_vertex_ctx, buftracker);
 	memory = (struct score_memory *)&vctx->memory;
 
 	score_note("memory %p pos(%d) \n", memory, buftracker->pos);
+	score_info("buffer map(%u) reuse(%u) stale(%u) \n",
+			buftracker->map_cnt, buftracker->reuse_cnt,
+			buftracker->stale_cnt);
 	/* score_buftracker_dump_list(buftracker); */
 	/* score_buftracker_dump(buftracker); */
 
@@ -287,6 +343,9 @@ int score_buftracker_remove_all(struct score_buftracker *buftracker)
 	while (buftracker->pos > 0) {
 		switch (buftracker->buffer_slot[buftracker->pos -1].memory) {
 		case VS4L_MEMORY_DMABUF:
+			/* a slot whose remap failed has nothing mapped */
+			if (!buftracker->buffer_slot[buftracker->pos - 1].dbuf)
+				break;
 			ret = score_memory_unmap(memory,
 					&buftracker->buffer_slot[buftracker->pos - 1]);
 			break;
@@ -305,6 +364,13 @@ int score_buftracker_remove_all(struct score_buftracker *buftracker)
 		buftracker->pos --;
 	}
 
+	/* the slots are reused from the start, so is the lookup list */
+	spin_lock_irqsave(&buftracker->buf_lock, flag);
+	INIT_LIST_HEAD(&buftracker->buf_list);
+	buftracker->buf_cnt = 0;
+	spin_unlock_irqrestore(&buftracker->buf_lock, flag);
+	memset(buftracker->buffer_slot, 0x0, sizeof(buftracker->buffer_slot));
+
 	return ret;
 }
 
@@ -20,6 +20,7 @@ enum score_buftracker_search_state {
 	SCORE_BUFTRACKER_SEARCH_STATE_NEW			= 1,
 	SCORE_BUFTRACKER_SEARCH_STATE_INSERT			= 2,
 	SCORE_BUFTRACKER_SEARCH_STATE_ALREADY_REGISTERED	= 3,
+	SCORE_BUFTRACKER_SEARCH_STATE_STALE			= 4,
 	SCORE_BUFTRACKER_SEARCH_STATE_NONE
 };
 
@@ -39,6 +40,11 @@ struct score_buftracker {
 	struct list_head		userptr_list;
 	u32				userptr_cnt;
 	spinlock_t			userptr_lock;
+
+	/* DMABUF mappings made, reused from an earlier task and redone */
+	u32				map_cnt;
+	u32				reuse_cnt;
+	u32				stale_cnt;
 };
 
 int score_buftracker_init(struct score_buftracker *buftracker);
@@ -36,6 +36,8 @@
 #include <linux/coredump.h>
 #include <linux/sched.h>
 #include <linux/dax.h>
+#include <linux/xattr.h>
+#include <linux/ctype.h>
 #include <asm/uaccess.h>
 #include <asm/param.h>
 #include <asm/page.h>
@@ -666,6 +668,155 @@ static unsigned long randomize_stack_top(unsigned long stack_top)
 #endif
 }
 
+/*
+ * Hot binaries get their read-only PT_LOAD segments (text and rodata)
+ * read ahead and mapped in at exec, instead of taking a fault for each
+ * page once they start running. A binary is hot if its path is listed
+ * in the prefault_paths parameter or it carries the XATTR_ELF_PREFAULT
+ * xattr; the interpreter is then prefaulted along with it.
+ */
+#define XATTR_ELF_PREFAULT	XATTR_TRUSTED_PREFIX "elf_prefault"
+#define ELF_PREFAULT_PATHS_LEN	1024
+
+static char *elf_prefault_paths;
+static DEFINE_SPINLOCK(elf_prefault_lock);
+static atomic_long_t elf_prefault_execs;
+static atomic_long_t elf_prefault_pages;
+
+static int elf_prefault_paths_set(const char *val,
+				  const struct kernel_param *kp)
+{
+	char *paths = NULL, *old;
+
+	if (strlen(val) >= ELF_PREFAULT_PATHS_LEN)
+		return -ENOSPC;
+
+	if (*val && *val != '\n') {
+		paths = kstrdup(val, GFP_KERNEL);
+		if (!paths)
+			return -ENOMEM;
+	}
+
+	spin_lock(&elf_prefault_lock);
+	old = elf_prefault_paths;
+	elf_prefault_paths = paths;
+	spin_unlock(&elf_prefault_lock);
+	kfree(old);
+
+	return 0;
+}
+
+static int elf_prefault_paths_get(char *buffer, const struct kernel_param *kp)
+{
+	int len;
+
+	spin_lock(&elf_prefault_lock);
+	len = scnprintf(buffer, PAGE_SIZE, "%s",
+			elf_prefault_paths ? elf_prefault_paths : "");
+	spin_unlock(&elf_prefault_lock);
+
+	return len;
+}
+
+static const struct kernel_param_ops elf_prefault_paths_ops = {
+	.set = elf_prefault_paths_set,
+	.get = elf_prefault_paths_get,
+};
+module_param_cb(prefault_paths, &elf_prefault_paths_ops, NULL, 0644);
+
+static int elf_prefault_stats_get(char *buffer, const struct kernel_param *kp)
+{
+	return scnprintf(buffer, PAGE_SIZE, "execs %ld\npages %ld\n",
+			 atomic_long_read(&elf_prefault_execs),
+			 atomic_long_read(&elf_prefault_pages));
+}
+
+static const struct kernel_param_ops elf_prefault_stats_ops = {
+	.get = elf_prefault_stats_get,
+};
+module_param_cb(prefault_stats, &elf_prefault_stats_ops, NULL, 0444);
+
+/* prefault_paths holds absolute paths separated by spaces or newlines */
+static bool elf_prefault_listed(const char *path)
+{
+	size_t len = strlen(path);
+	bool listed = false;
+	const char *p;
+
+	spin_lock(&elf_prefault_lock);
+	for (p = elf_prefault_paths; p && *p; p += strcspn(p, " \n")) {
+		p += strspn(p, " \n");
+		if (!strncmp(p, path, len) && (!p[len] || isspace(p[len]))) {
+			listed = true;
+			break;
+		}
+	}
+	spin_unlock(&elf_prefault_lock);
+
+	return listed;
+}
+
+static bool elf_prefault_wanted(struct file *file)
+{
+	struct dentry *dentry = file->f_path.dentry;
+	struct inode *inode = d_inode(dentry);
+	bool wanted = false;
+	char *buf, *path;
+
+	if (inode->i_op->getxattr &&
+	    inode->i_op->getxattr(dentry, XATTR_ELF_PREFAULT, NULL, 0) >= 0)
+		return true;
+
+	if (!READ_ONCE(elf_prefault_paths))
+		return false;
+
+	buf = (char *)__get_free_page(GFP_KERNEL);
+	if (!buf)
+		return false;
+
+	path = file_path(file, buf, PAGE_SIZE);
+	if (!IS_ERR(path))
+		wanted = elf_prefault_listed(path);
+	free_page((unsigned long)buf);
+
+	return wanted;
+}
+
+/*
+ * Start readahead on every read-only segment first so the I/O for all
+ * of them is in flight together, then populate the page tables.
+ */
+static void elf_prefault(struct file *file, struct elf_phdr *phdata,
+			 int nr, unsigned long bias)
+{
+	struct elf_phdr *eppnt;
+	unsigned long start, end, pages = 0;
+	int i;
+
+	for (i = 0, eppnt = phdata; i < nr; i++, eppnt++) {
+		if (eppnt->p_type != PT_LOAD || (eppnt->p_flags & PF_W) ||
+		    !eppnt->p_filesz)
+			continue;
+		start = ELF_PAGESTART(eppnt->p_offset);
+		end = ELF_PAGEALIGN(eppnt->p_offset + eppnt->p_filesz);
+		force_page_cache_readahead(file->f_mapping, file,
+					   start >> PAGE_SHIFT,
+					   (end - start) >> PAGE_SHIFT);
+	}
+
+	for (i = 0, eppnt = phdata; i < nr; i++, eppnt++) {
+		if (eppnt->p_type != PT_LOAD || (eppnt->p_flags & PF_W) ||
+		    !eppnt->p_filesz)
+			continue;
+		start = ELF_PAGESTART(bias + eppnt->p_vaddr);
+		end = ELF_PAGEALIGN(bias + eppnt->p_vaddr + eppnt->p_filesz);
+		mm_populate(start, end - start);
+		pages += (end - start) >> PAGE_SHIFT;
+	}
+
+	atomic_long_add(pages, &elf_prefault_pages);
+}
+
 static int load_elf_binary(struct linux_binprm *bprm)
 {
 	struct file *interpreter = NULL; /* to shut gcc up */
@@ -681,6 +832,7 @@ static int load_elf_binary(struct linux_binprm *bprm)
 	unsigned long start_code, end_code, start_data, end_data;
 	unsigned long reloc_func_desc __maybe_unused = 0;
 	int executable_stack = EXSTACK_DEFAULT;
+	bool prefault;
 	struct pt_regs *regs = current_pt_regs();
 	struct {
 		struct elfhdr elf_ex;
@@ -1045,6 +1197,13 @@ static int load_elf_binary(struct linux_binprm *bprm)
 		goto out_free_dentry;
 	}
 
+	prefault = elf_prefault_wanted(bprm->file);
+	if (prefault) {
+		atomic_long_inc(&elf_prefault_execs);
+		elf_prefault(bprm->file, elf_phdata, loc->elf_ex.e_phnum,
+			     load_bias);
+	}
+
 	if (elf_interpreter) {
 		unsigned long interp_map_addr = 0;
 
@@ -1067,6 +1226,11 @@ static int load_elf_binary(struct linux_binprm *bprm)
 		}
 		reloc_func_desc = interp_load_addr;
 
+		if (prefault)
+			elf_prefault(interpreter, interp_elf_phdata,
+				     loc->interp_elf_ex.e_phnum,
+				     interp_load_addr);
+
 		allow_write_access(interpreter);
 		fput(interpreter);
 		kfree(elf_interpreter);
@@ -25,13 +25,59 @@
 #include <linux/namei.h>
 #include "fscrypt_private.h"
 
-static void __fscrypt_decrypt_bio(struct bio *bio, bool done)
+/*
+ * Read bios of at least parallel_min_bytes are split in parts of at least
+ * parallel_chunk_pages pages, decrypted concurrently by the cpus. The bio
+ * completes once all its parts are done, as before, so the order in which
+ * its pages become uptodate towards the filesystem does not change.
+ */
+#define FSCRYPT_MAX_DECRYPT_CHUNKS	8
+
+static unsigned int parallel_min_bytes = 128 * 1024;
+module_param(parallel_min_bytes, uint, 0644);
+MODULE_PARM_DESC(parallel_min_bytes,
+		"Smallest read bio decrypted by several CPUs, 0 for never");
+
+static unsigned int parallel_chunk_pages = 16;
+module_param(parallel_chunk_pages, uint, 0644);
+MODULE_PARM_DESC(parallel_chunk_pages,
+		"Fewest pages decrypted by each CPU of a split bio");
+
+static atomic64_t decrypt_bios = ATOMIC64_INIT(0);
+static atomic64_t decrypt_parallel_bios = ATOMIC64_INIT(0);
+static atomic64_t decrypt_chunks = ATOMIC64_INIT(0);
+
+static int parallel_stats_get(char *buffer, const struct kernel_param *kp)
+{
+	return scnprintf(buffer, PAGE_SIZE, "bios %llu parallel %llu chunks %llu\n",
+		(unsigned long long)atomic64_read(&decrypt_bios),
+		(unsigned long long)atomic64_read(&decrypt_parallel_bios),
+		(unsigned long long)atomic64_read(&decrypt_chunks));
+}
+
+static const struct kernel_param_ops parallel_stats_ops = {
+	.get = parallel_stats_get,
+};
+module_param_cb(parallel_stats, &parallel_stats_ops, NULL, 0444);
+MODULE_PARM_DESC(parallel_stats, "Decrypted read bios, split ones and parts");
+
+struct fscrypt_decrypt_chunk {
+	struct work_struct work;
+	struct bio *bio;
+	int start;
+	int end;
+	bool done;
+	atomic_t *pending;
+	struct completion *finished;
+};
+
+static void fscrypt_decrypt_bvecs(struct bio *bio, int start, int end,
+				  bool done)
 {
-	struct bio_vec *bv;
 	int i;
 
-	bio_for_each_segment_all(bv, bio, i) {
-		struct page *page = bv->bv_page;
+	for (i = start; i < end; i++) {
+		struct page *page = bio->bi_io_vec[i].bv_page;
 		int ret = fscrypt_decrypt_page(page->mapping->host, page,
 				PAGE_SIZE, 0, page->index);
 
@@ -46,6 +92,65 @@ static void __fscrypt_decrypt_bio(struct bio *bio, bool done)
 	}
 }
 
+static void fscrypt_decrypt_chunk_work(struct work_struct *work)
+{
+	struct fscrypt_decrypt_chunk *chunk =
+		container_of(work, struct fscrypt_decrypt_chunk, work);
+
+	fscrypt_decrypt_bvecs(chunk->bio, chunk->start, chunk->end,
+			      chunk->done);
+	if (atomic_dec_and_test(chunk->pending))
+		complete(chunk->finished);
+}
+
+static void __fscrypt_decrypt_bio(struct bio *bio, bool done)
+{
+	struct fscrypt_decrypt_chunk chunks[FSCRYPT_MAX_DECRYPT_CHUNKS];
+	DECLARE_COMPLETION_ONSTACK(finished);
+	unsigned int min_bytes = READ_ONCE(parallel_min_bytes);
+	unsigned int chunk_pages = max(READ_ONCE(parallel_chunk_pages), 1U);
+	int nr = bio->bi_vcnt;
+	int nr_chunks, per_chunk, i;
+	atomic_t pending;
+
+	atomic64_inc(&decrypt_bios);
+
+	/* bi_iter has been consumed by the completion, go by the vectors */
+	nr_chunks = min_t(unsigned int, num_online_cpus(), nr / chunk_pages);
+	nr_chunks = min(nr_chunks, FSCRYPT_MAX_DECRYPT_CHUNKS);
+	if (!min_bytes || (u64)nr * PAGE_SIZE < min_bytes || nr_chunks < 2) {
+		fscrypt_decrypt_bvecs(bio, 0, nr, done);
+		return;
+	}
+
+	per_chunk = DIV_ROUND_UP(nr, nr_chunks);
+	nr_chunks = DIV_ROUND_UP(nr, per_chunk);
+	atomic_set(&pending, nr_chunks - 1);
+
+	for (i = 1; i < nr_chunks; i++) {
+		struct fscrypt_decrypt_chunk *chunk = &chunks[i];
+
+		INIT_WORK_ONSTACK(&chunk->work, fscrypt_decrypt_chunk_work);
+		chunk->bio = bio;
+		chunk->start = i * per_chunk;
+		chunk->end = min(chunk->start + per_chunk, nr);
+		chunk->done = done;
+		chunk->pending = &pending;
+		chunk->finished = &finished;
+		fscrypt_enqueue_decrypt_chunk(&chunk->work);
+	}
+
+	/* the first part is ours */
+	fscrypt_decrypt_bvecs(bio, 0, per_chunk, done);
+
+	wait_for_completion(&finished);
+	for (i = 1; i < nr_chunks; i++)
+		destroy_work_on_stack(&chunks[i].work);
+
+	atomic64_inc(&decrypt_parallel_bios);
+	atomic64_add(nr_chunks, &decrypt_chunks);
+}
+
 void fscrypt_decrypt_bio(struct bio *bio)
 {
 	__fscrypt_decrypt_bio(bio, false);
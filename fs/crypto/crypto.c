@@ -46,6 +46,7 @@ static LIST_HEAD(fscrypt_free_ctxs);
 static DEFINE_SPINLOCK(fscrypt_ctx_lock);
 
 static struct workqueue_struct *fscrypt_read_workqueue;
+static struct workqueue_struct *fscrypt_chunk_workqueue;
 static DEFINE_MUTEX(fscrypt_init_mutex);
 
 static struct kmem_cache *fscrypt_ctx_cachep;
@@ -57,6 +58,15 @@ void fscrypt_enqueue_decrypt_work(struct work_struct *work)
 }
 EXPORT_SYMBOL(fscrypt_enqueue_decrypt_work);
 
+/*
+ * Parts of a bio being decrypted from fscrypt_read_workqueue go to their
+ * own queue, so that they never wait behind the works waiting for them.
+ */
+void fscrypt_enqueue_decrypt_chunk(struct work_struct *work)
+{
+	queue_work(fscrypt_chunk_workqueue, work);
+}
+
 /**
  * fscrypt_release_ctx() - Releases an encryption context
  * @ctx: The encryption context to release.
@@ -463,9 +473,14 @@ static int __init fscrypt_init(void)
 	if (!fscrypt_read_workqueue)
 		goto fail;
 
+	fscrypt_chunk_workqueue = alloc_workqueue("fscrypt_chunk_queue",
+						  WQ_UNBOUND | WQ_HIGHPRI, 0);
+	if (!fscrypt_chunk_workqueue)
+		goto fail_free_queue;
+
 	fscrypt_ctx_cachep = KMEM_CACHE(fscrypt_ctx, SLAB_RECLAIM_ACCOUNT);
 	if (!fscrypt_ctx_cachep)
-		goto fail_free_queue;
+		goto fail_free_chunk_queue;
 
 	fscrypt_info_cachep = KMEM_CACHE(fscrypt_info, SLAB_RECLAIM_ACCOUNT);
 	if (!fscrypt_info_cachep)
@@ -475,6 +490,8 @@ static int __init fscrypt_init(void)
 
 fail_free_ctx:
 	kmem_cache_destroy(fscrypt_ctx_cachep);
+fail_free_chunk_queue:
+	destroy_workqueue(fscrypt_chunk_workqueue);
 fail_free_queue:
 	destroy_workqueue(fscrypt_read_workqueue);
 fail:
@@ -491,6 +508,8 @@ static void __exit fscrypt_exit(void)
 
 	if (fscrypt_read_workqueue)
 		destroy_workqueue(fscrypt_read_workqueue);
+	if (fscrypt_chunk_workqueue)
+		destroy_workqueue(fscrypt_chunk_workqueue);
 	kmem_cache_destroy(fscrypt_ctx_cachep);
 	kmem_cache_destroy(fscrypt_info_cachep);
 
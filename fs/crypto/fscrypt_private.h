@@ -58,6 +58,7 @@ struct fscrypt_info {
 	u8 ci_data_mode;
 	u8 ci_filename_mode;
 	u8 ci_flags;
+	bool ci_inline;			/* contents done by the storage */
 	struct crypto_skcipher *ci_ctfm;
 	struct crypto_cipher *ci_essiv_tfm;
 	u8 ci_master_key[FS_KEY_DESCRIPTOR_SIZE];
@@ -111,6 +112,7 @@ extern int fscrypt_do_page_crypto(const struct inode *inode,
 				  gfp_t gfp_flags);
 extern struct page *fscrypt_alloc_bounce_page(struct fscrypt_ctx *ctx,
 					      gfp_t gfp_flags);
+extern void fscrypt_enqueue_decrypt_chunk(struct work_struct *work);
 extern const struct dentry_operations fscrypt_d_ops;
 
 extern void __printf(3, 4) __cold
@@ -131,4 +133,24 @@ extern bool fscrypt_fname_encrypted_size(const struct inode *inode,
 /* keyinfo.c */
 extern void __exit fscrypt_essiv_cleanup(void);
 
+/* inline.c */
+#ifdef CONFIG_FS_ENCRYPTION_INLINE_CRYPT
+extern bool fscrypt_inline_setup_key(struct inode *inode,
+				     struct fscrypt_info *ci,
+				     const u8 *raw_key, unsigned int keysize);
+extern void fscrypt_inline_clear_key(struct inode *inode);
+#else
+static inline bool fscrypt_inline_setup_key(struct inode *inode,
+					    struct fscrypt_info *ci,
+					    const u8 *raw_key,
+					    unsigned int keysize)
+{
+	return false;
+}
+
+static inline void fscrypt_inline_clear_key(struct inode *inode)
+{
+}
+#endif
+
 #endif /* _FSCRYPT_PRIVATE_H */
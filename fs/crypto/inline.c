@@ -0,0 +1,57 @@
+/*
+ * Inline encryption of file contents
+ *
+ * Storage controllers that en/decrypt data on its way to and from the
+ * device, like the Exynos FMP, register here. The contents key of a
+ * regular file whose mode the controller supports is then handed to it
+ * when the file's key is set up, and the filesystem submits page cache
+ * pages as they are, with no bounce page on write and no decryption
+ * after read. The ciphertext on disk is the same the software path
+ * writes, so files move freely between the two.
+ *
+ * The software transform is still set up, it serves as the fallback.
+ */
+
+#include <linux/spinlock.h>
+#include "fscrypt_private.h"
+
+static DEFINE_SPINLOCK(inline_crypt_lock);
+static const struct fscrypt_inline_ops *inline_crypt_ops;
+
+int fscrypt_register_inline_crypt(const struct fscrypt_inline_ops *ops)
+{
+	int err = 0;
+
+	spin_lock(&inline_crypt_lock);
+	if (inline_crypt_ops)
+		err = -EBUSY;
+	else
+		WRITE_ONCE(inline_crypt_ops, ops);
+	spin_unlock(&inline_crypt_lock);
+
+	if (!err)
+		pr_info("fscrypt: inline encryption by %s\n", ops->name);
+	return err;
+}
+EXPORT_SYMBOL_GPL(fscrypt_register_inline_crypt);
+
+/* true if the storage takes over the contents encryption of @inode */
+bool fscrypt_inline_setup_key(struct inode *inode, struct fscrypt_info *ci,
+			      const u8 *raw_key, unsigned int keysize)
+{
+	const struct fscrypt_inline_ops *ops = READ_ONCE(inline_crypt_ops);
+
+	if (!ops || !S_ISREG(inode->i_mode))
+		return false;
+
+	return ops->setup_key(inode->i_mapping, ci->ci_data_mode,
+			      raw_key, keysize) == 0;
+}
+
+void fscrypt_inline_clear_key(struct inode *inode)
+{
+	const struct fscrypt_inline_ops *ops = READ_ONCE(inline_crypt_ops);
+
+	if (ops && fscrypt_inline_encrypted(inode))
+		ops->clear_key(inode->i_mapping);
+}
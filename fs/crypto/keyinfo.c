@@ -326,6 +326,7 @@ int fscrypt_get_encryption_info(struct inode *inode)
 		return -ENOMEM;
 
 	crypt_info->ci_flags = ctx.flags;
+	crypt_info->ci_inline = false;
 	crypt_info->ci_data_mode = ctx.contents_encryption_mode;
 	crypt_info->ci_filename_mode = ctx.filenames_encryption_mode;
 	crypt_info->ci_ctfm = NULL;
@@ -389,6 +390,11 @@ int fscrypt_get_encryption_info(struct inode *inode)
 			goto out;
 		}
 	}
+
+	/* racing setups of the same inode hand over the same key */
+	crypt_info->ci_inline = fscrypt_inline_setup_key(inode, crypt_info,
+							 raw_key, mode->keysize);
+
 	if (cmpxchg(&inode->i_crypt_info, NULL, crypt_info) == NULL)
 		crypt_info = NULL;
 out:
@@ -413,6 +419,8 @@ void fscrypt_put_encryption_info(struct inode *inode, struct fscrypt_info *ci)
 	if (prev != ci)
 		return;
 
+	if (ci->ci_inline)
+		fscrypt_inline_clear_key(inode);
 	put_crypt_info(ci);
 }
 EXPORT_SYMBOL(fscrypt_put_encryption_info);
@@ -13,6 +13,7 @@
 #include <linux/f2fs_fs.h>
 #include <linux/pagevec.h>
 #include <linux/swap.h>
+#include <linux/ktime.h>
 
 #include "f2fs.h"
 #include "node.h"
@@ -1245,6 +1246,44 @@ out:
 	return err;
 }
 
+/*
+ * Start writing out node and summary pages before operations are
+ * blocked, so block_operations() and do_checkpoint() only have what got
+ * dirty in the meantime left to write while everybody waits.
+ */
+static void prepare_checkpoint(struct f2fs_sb_info *sbi)
+{
+	struct writeback_control wbc = {
+		.sync_mode = WB_SYNC_NONE,
+		.nr_to_write = LONG_MAX,
+		.for_reclaim = 0,
+	};
+	struct blk_plug plug;
+
+	if (!get_pages(sbi, F2FS_DIRTY_NODES) &&
+			!get_pages(sbi, F2FS_DIRTY_META))
+		return;
+
+	blk_start_plug(&plug);
+	if (get_pages(sbi, F2FS_DIRTY_NODES))
+		f2fs_sync_node_pages(sbi, &wbc, false, FS_CP_NODE_IO);
+	if (get_pages(sbi, F2FS_DIRTY_META))
+		f2fs_sync_meta_pages(sbi, META, LONG_MAX, FS_CP_META_IO);
+	blk_finish_plug(&plug);
+}
+
+static void account_cp_phase(struct f2fs_sb_info *sbi, int phase,
+							ktime_t *start)
+{
+	ktime_t now = ktime_get();
+	unsigned int us = ktime_us_delta(now, *start);
+
+	sbi->cp_phase_us[phase] = us;
+	if (us > sbi->cp_phase_max_us[phase])
+		sbi->cp_phase_max_us[phase] = us;
+	*start = now;
+}
+
 static void unblock_operations(struct f2fs_sb_info *sbi)
 {
 	up_write(&sbi->node_write);
@@ -1383,10 +1422,11 @@ static int do_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 	u64 kbytes_written;
 	int err;
 
-	/* Flush all the NAT/SIT pages */
-	f2fs_sync_meta_pages(sbi, META, LONG_MAX, FS_CP_META_IO);
-	f2fs_bug_on(sbi, get_pages(sbi, F2FS_DIRTY_META) &&
-					!f2fs_cp_error(sbi));
+	/*
+	 * NAT/SIT pages go out below, along with the CP pack, in a single
+	 * pass over the meta mapping in block order, i.e. in as few merged
+	 * bios as the layout allows.
+	 */
 
 	/*
 	 * modify checkpoint
@@ -1492,7 +1532,7 @@ static int do_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 	sbi->last_valid_block_count = sbi->total_valid_block_count;
 	percpu_counter_set(&sbi->alloc_valid_block_count, 0);
 
-	/* Here, we have one bio having CP pack except cp pack 2 page */
+	/* Here, we have NAT/SIT and CP pack except cp pack 2 page */
 	f2fs_sync_meta_pages(sbi, META, LONG_MAX, FS_CP_META_IO);
 	f2fs_bug_on(sbi, get_pages(sbi, F2FS_DIRTY_META) &&
 					!f2fs_cp_error(sbi));
@@ -1551,6 +1591,8 @@ int f2fs_write_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 {
 	struct f2fs_checkpoint *ckpt = F2FS_CKPT(sbi);
 	unsigned long long ckpt_ver;
+	ktime_t phase_start, blocked_start;
+	unsigned int blocked_us;
 	int err = 0;
 
 	if (f2fs_readonly(sbi->sb) || f2fs_hw_is_readonly(sbi))
@@ -1572,13 +1614,20 @@ int f2fs_write_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 		goto out;
 	}
 
+	phase_start = ktime_get();
+	if (!(cpc->reason & CP_DISCARD))
+		prepare_checkpoint(sbi);
+	account_cp_phase(sbi, CP_PHASE_PREPARE, &phase_start);
+
 	trace_f2fs_write_checkpoint(sbi->sb, cpc->reason, "start block_ops");
 
+	blocked_start = phase_start;
 	err = block_operations(sbi);
 	if (err)
 		goto out;
 
 	trace_f2fs_write_checkpoint(sbi->sb, cpc->reason, "finish block_ops");
+	account_cp_phase(sbi, CP_PHASE_BLOCK_OPS, &phase_start);
 
 	f2fs_flush_merged_writes(sbi);
 
@@ -1613,6 +1662,7 @@ int f2fs_write_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 		goto stop;
 
 	f2fs_flush_sit_entries(sbi, cpc);
+	account_cp_phase(sbi, CP_PHASE_FLUSH_NAT_SIT, &phase_start);
 
 	/* unlock all the fs_lock[] in do_checkpoint() */
 	err = do_checkpoint(sbi, cpc);
@@ -1620,10 +1670,16 @@ int f2fs_write_checkpoint(struct f2fs_sb_info *sbi, struct cp_control *cpc)
 		f2fs_release_discard_addrs(sbi);
 	else
 		f2fs_clear_prefree_segments(sbi, cpc);
+	account_cp_phase(sbi, CP_PHASE_COMMIT, &phase_start);
 stop:
 	unblock_operations(sbi);
 	stat_inc_cp_count(sbi->stat_info);
 
+	/* roughly, block_operations() takes cp_rwsem early on */
+	blocked_us = ktime_us_delta(ktime_get(), blocked_start);
+	if (blocked_us > sbi->cp_blocked_max_us)
+		sbi->cp_blocked_max_us = blocked_us;
+
 	if (cpc->reason & CP_RECOVERY)
 		f2fs_notice(sbi, "checkpoint: version = %llx", ckpt_ver);
 
@@ -208,6 +208,8 @@ static struct extent_node *__attach_extent_node(struct f2fs_sb_info *sbi,
 	rb_insert_color(&en->rb_node, &et->root);
 	atomic_inc(&et->node_cnt);
 	atomic_inc(&sbi->total_ext_node);
+	if (et->hot)
+		atomic_inc(&sbi->total_hot_ext_node);
 	return en;
 }
 
@@ -217,6 +219,8 @@ static void __detach_extent_node(struct f2fs_sb_info *sbi,
 	rb_erase(&en->rb_node, &et->root);
 	atomic_dec(&et->node_cnt);
 	atomic_dec(&sbi->total_ext_node);
+	if (et->hot)
+		atomic_dec(&sbi->total_hot_ext_node);
 
 	if (et->cached_en == en)
 		et->cached_en = NULL;
@@ -255,6 +259,8 @@ static struct extent_tree *__grab_extent_tree(struct inode *inode)
 		et->ino = ino;
 		et->root = RB_ROOT;
 		et->cached_en = NULL;
+		et->hot = false;
+		et->read_miss = 0;
 		rwlock_init(&et->lock);
 		INIT_LIST_HEAD(&et->list);
 		atomic_set(&et->node_cnt, 0);
@@ -363,6 +369,48 @@ bool f2fs_init_extent_tree(struct inode *inode, struct f2fs_extent *i_ext)
 	return ret;
 }
 
+/*
+ * Files read a lot, those in the hot extension list or missing the extent
+ * cache often, keep all their extents, including those found by reads,
+ * and the shrinker leaves them alone while under hot_extent_max_nodes.
+ * This saves the node page lookups of fragmented files like APKs.
+ */
+static bool __hot_extent_below_cap(struct f2fs_sb_info *sbi)
+{
+	return atomic_read(&sbi->total_hot_ext_node) <
+				READ_ONCE(sbi->hot_extent_max_nodes);
+}
+
+static void __try_make_extent_tree_hot(struct inode *inode,
+						struct extent_tree *et)
+{
+	struct f2fs_sb_info *sbi = F2FS_I_SB(inode);
+
+	if (!__hot_extent_below_cap(sbi))
+		return;
+	if (!file_is_hot(inode) &&
+			++et->read_miss < sbi->hot_extent_miss_thresh)
+		return;
+
+	write_lock(&et->lock);
+	if (!et->hot) {
+		et->hot = true;
+		atomic_add(atomic_read(&et->node_cnt),
+					&sbi->total_hot_ext_node);
+	}
+	write_unlock(&et->lock);
+}
+
+bool f2fs_want_read_extent(struct inode *inode)
+{
+	struct extent_tree *et = F2FS_I(inode)->extent_tree;
+
+	if (!f2fs_may_extent_tree(inode) || !et || !et->hot)
+		return false;
+
+	return __hot_extent_below_cap(F2FS_I_SB(inode));
+}
+
 static bool f2fs_lookup_extent_tree(struct inode *inode, pgoff_t pgofs,
 							struct extent_info *ei)
 {
@@ -406,8 +454,14 @@ static bool f2fs_lookup_extent_tree(struct inode *inode, pgoff_t pgofs,
 	ret = true;
 out:
 	stat_inc_total_hit(sbi);
+	if (et->hot)
+		atomic64_inc(ret ? &sbi->hot_extent_hit :
+					&sbi->hot_extent_miss);
 	read_unlock(&et->lock);
 
+	if (!ret && !et->hot)
+		__try_make_extent_tree_hot(inode, et);
+
 	trace_f2fs_lookup_extent_tree_end(inode, pgofs, ei);
 	return ret;
 }
@@ -664,7 +718,8 @@ free_node:
 		en = list_first_entry(&sbi->extent_list,
 					struct extent_node, list);
 		et = en->et;
-		if (!write_trylock(&et->lock)) {
+		if ((et->hot && __hot_extent_below_cap(sbi)) ||
+					!write_trylock(&et->lock)) {
 			/* refresh this extent node's position in extent list */
 			list_move_tail(&en->list, &sbi->extent_list);
 			continue;
@@ -808,6 +863,12 @@ void f2fs_init_extent_cache_info(struct f2fs_sb_info *sbi)
 	INIT_LIST_HEAD(&sbi->zombie_list);
 	atomic_set(&sbi->total_zombie_tree, 0);
 	atomic_set(&sbi->total_ext_node, 0);
+
+	sbi->hot_extent_max_nodes = 0;
+	sbi->hot_extent_miss_thresh = DEF_HOT_EXTENT_MISS_THRESH;
+	atomic_set(&sbi->total_hot_ext_node, 0);
+	atomic64_set(&sbi->hot_extent_hit, 0);
+	atomic64_set(&sbi->hot_extent_miss, 0);
 }
 
 int __init f2fs_create_extent_cache(void)
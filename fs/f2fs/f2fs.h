@@ -21,6 +21,8 @@
 #include <linux/vmalloc.h>
 #include <linux/bio.h>
 #include <linux/blkdev.h>
+#include <linux/blk-boost.h>
+#include <linux/power_supply.h>
 #include <linux/quotaops.h>
 #include <crypto/hash.h>
 #include <linux/writeback.h>
@@ -576,6 +578,9 @@ enum {
 /* number of extent info in extent cache we try to shrink */
 #define EXTENT_CACHE_SHRINK_NUMBER	128
 
+/* extent cache misses after which a file's whole extent tree is kept */
+#define DEF_HOT_EXTENT_MISS_THRESH	32
+
 struct rb_entry {
 	struct rb_node rb_node;		/* rb node located in rb-tree */
 	unsigned int ofs;		/* start offset of the entry */
@@ -604,6 +609,8 @@ struct extent_tree {
 	rwlock_t lock;			/* protect extent info rb-tree */
 	atomic_t node_cnt;		/* # of extent node in rb-tree*/
 	bool largest_updated;		/* largest extent updated */
+	bool hot;			/* keep all extents, read side too */
+	unsigned int read_miss;		/* lookup misses, racy */
 };
 
 /*
@@ -1148,6 +1155,15 @@ enum {
 	MAX_TIME,
 };
 
+/* checkpoint phases, timed in f2fs_write_checkpoint() */
+enum {
+	CP_PHASE_PREPARE,	/* writeback while operations are admitted */
+	CP_PHASE_BLOCK_OPS,	/* quiescing, flushing the remaining nodes */
+	CP_PHASE_FLUSH_NAT_SIT,	/* NAT/SIT entries into meta pages */
+	CP_PHASE_COMMIT,	/* meta writeback and the commit block */
+	NR_CP_PHASE,
+};
+
 enum {
 	GC_NORMAL,
 	GC_IDLE_CB,
@@ -1216,6 +1232,9 @@ struct f2fs_sb_info {
 	struct rw_semaphore node_write;		/* locking node writes */
 	struct rw_semaphore node_change;	/* locking node change */
 	wait_queue_head_t cp_wait;
+	unsigned int cp_phase_us[NR_CP_PHASE];	/* last checkpoint, in us */
+	unsigned int cp_phase_max_us[NR_CP_PHASE];	/* worst so far */
+	unsigned int cp_blocked_max_us;		/* longest operation stall */
 	unsigned long last_time[MAX_TIME];	/* to store time in jiffies */
 	long interval_time[MAX_TIME];		/* to store thresholds */
 
@@ -1244,6 +1263,13 @@ struct f2fs_sb_info {
 	atomic_t total_zombie_tree;		/* extent zombie tree count */
 	atomic_t total_ext_node;		/* extent info count */
 
+	/* for extent trees kept whole for hot read-mostly files */
+	unsigned int hot_extent_max_nodes;	/* memory cap, 0 disables */
+	unsigned int hot_extent_miss_thresh;	/* misses to become hot */
+	atomic_t total_hot_ext_node;		/* extent info in hot trees */
+	atomic64_t hot_extent_hit;		/* lookups hit in hot trees */
+	atomic64_t hot_extent_miss;		/* lookups missed in hot trees */
+
 	/* basic filesystem units */
 	unsigned int log_sectors_per_block;	/* log2 sectors per block */
 	unsigned int log_blocksize;		/* log2 block size */
@@ -1307,6 +1333,11 @@ struct f2fs_sb_info {
 	/* migration granularity of garbage collection, unit: segment */
 	unsigned int migration_granularity;
 
+	/* keep background GC and discard to device idle time */
+	unsigned int idle_aware;
+	/* # of background GC rounds in a row while deeply idle */
+	unsigned int idle_gc_batch;
+
 	/*
 	 * for stat information.
 	 * one is for the LFS mode, and the other is for the SSR mode.
@@ -2257,6 +2288,26 @@ static inline bool is_idle(struct f2fs_sb_info *sbi, int type)
 	return f2fs_time_over(sbi, type);
 }
 
+/*
+ * With idle_aware set, background GC and discard stay off while the user
+ * waits on the foreground, that is while an I/O boost is active, and drain
+ * their backlog in batches once the device is deeply idle: idle for @type,
+ * with the screen off or a charger connected.
+ */
+static inline bool f2fs_fg_critical(struct f2fs_sb_info *sbi)
+{
+	return sbi->idle_aware && sbi->gc_mode != GC_URGENT &&
+						blk_boost_active();
+}
+
+static inline bool f2fs_deep_idle(struct f2fs_sb_info *sbi, int type)
+{
+	if (!sbi->idle_aware || f2fs_fg_critical(sbi) || !is_idle(sbi, type))
+		return false;
+
+	return blk_boost_screen_off() || power_supply_is_system_supplied() > 0;
+}
+
 static inline void f2fs_radix_tree_insert(struct radix_tree_root *root,
 				unsigned long index, void *item)
 {
@@ -3528,6 +3579,7 @@ bool f2fs_lookup_extent_cache(struct inode *inode, pgoff_t pgofs,
 void f2fs_update_extent_cache(struct dnode_of_data *dn);
 void f2fs_update_extent_cache_range(struct dnode_of_data *dn,
 			pgoff_t fofs, block_t blkaddr, unsigned int len);
+bool f2fs_want_read_extent(struct inode *inode);
 void f2fs_init_extent_cache_info(struct f2fs_sb_info *sbi);
 int __init f2fs_create_extent_cache(void);
 void f2fs_destroy_extent_cache(void);
@@ -26,6 +26,7 @@ static int gc_thread_func(void *data)
 	struct f2fs_gc_kthread *gc_th = sbi->gc_thread;
 	wait_queue_head_t *wq = &sbi->gc_thread->gc_wait_queue_head;
 	unsigned int wait_ms;
+	unsigned int i;
 
 	wait_ms = gc_th->min_sleep_time;
 
@@ -82,6 +83,12 @@ static int gc_thread_func(void *data)
 			goto do_gc;
 		}
 
+		if (f2fs_fg_critical(sbi)) {
+			wait_ms = gc_th->max_sleep_time;
+			stat_io_skip_bggc_count(sbi);
+			goto next;
+		}
+
 		if (!mutex_trylock(&sbi->gc_mutex)) {
 			stat_other_skip_bggc_count(sbi);
 			goto next;
@@ -102,8 +109,25 @@ do_gc:
 		stat_inc_bggc_count(sbi);
 
 		/* if return value is not zero, no victim was selected */
-		if (f2fs_gc(sbi, test_opt(sbi, FORCE_FG_GC), true, NULL_SEGNO))
+		if (f2fs_gc(sbi, test_opt(sbi, FORCE_FG_GC), true, NULL_SEGNO)) {
 			wait_ms = gc_th->no_gc_sleep_time;
+			goto gc_done;
+		}
+
+		/* drain the backlog while the device stays deeply idle */
+		for (i = 1; i < sbi->idle_gc_batch; i++) {
+			if (!f2fs_deep_idle(sbi, GC_TIME) ||
+					!has_enough_invalid_blocks(sbi))
+				break;
+			if (!mutex_trylock(&sbi->gc_mutex))
+				break;
+			stat_inc_bggc_count(sbi);
+			if (f2fs_gc(sbi, test_opt(sbi, FORCE_FG_GC), true,
+							NULL_SEGNO))
+				break;
+			wait_ms = gc_th->min_sleep_time;
+		}
+gc_done:
 
 		trace_f2fs_background_gc(sbi->sb, wait_ms,
 				prefree_segments(sbi), free_segments(sbi));
@@ -239,6 +263,19 @@ static unsigned int check_bg_victims(struct f2fs_sb_info *sbi)
 	return NULL_SEGNO;
 }
 
+/* cost of a section with utilization @u and age @age, both in percent */
+static inline unsigned int cb_cost(unsigned char u, unsigned char age)
+{
+	return UINT_MAX - ((100 * (100 - u) * age) / (100 + u));
+}
+
+static inline unsigned char cb_utilization(struct f2fs_sb_info *sbi,
+						unsigned int vblocks)
+{
+	vblocks = div_u64(vblocks, sbi->segs_per_sec);
+	return (vblocks * 100) >> sbi->log_blocks_per_seg;
+}
+
 static unsigned int get_cb_cost(struct f2fs_sb_info *sbi, unsigned int segno)
 {
 	struct sit_info *sit_i = SIT_I(sbi);
@@ -255,9 +292,7 @@ static unsigned int get_cb_cost(struct f2fs_sb_info *sbi, unsigned int segno)
 	vblocks = get_valid_blocks(sbi, segno, true);
 
 	mtime = div_u64(mtime, sbi->segs_per_sec);
-	vblocks = div_u64(vblocks, sbi->segs_per_sec);
-
-	u = (vblocks * 100) >> sbi->log_blocks_per_seg;
+	u = cb_utilization(sbi, vblocks);
 
 	/* Handle if the system time has changed by the user */
 	if (mtime < sit_i->min_mtime)
@@ -268,7 +303,7 @@ static unsigned int get_cb_cost(struct f2fs_sb_info *sbi, unsigned int segno)
 		age = 100 - div64_u64(100 * (mtime - sit_i->min_mtime),
 				sit_i->max_mtime - sit_i->min_mtime);
 
-	return UINT_MAX - ((100 * (100 - u) * age) / (100 + u));
+	return cb_cost(u, age);
 }
 
 static inline unsigned int get_gc_cost(struct f2fs_sb_info *sbi,
@@ -296,6 +331,55 @@ static unsigned int count_bits(const unsigned long *addr,
 	return sum;
 }
 
+/*
+ * LFS victims are looked up in the index of dirty sections by valid blocks,
+ * from the emptiest bucket on. Greedy takes the first usable section of the
+ * first bucket that has one. Cost-benefit stops at the first bucket whose
+ * sections can't beat the victim so far even at the oldest age.
+ */
+static void get_victim_from_index(struct f2fs_sb_info *sbi,
+			struct victim_sel_policy *p, int gc_type)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int nr_buckets = BLKS_PER_SEC(sbi) + 1;
+	unsigned int nsearched = 0;
+	unsigned int vblocks;
+	struct victim_entry *ve;
+
+	for_each_set_bit(vblocks, dirty_i->victim_bucket_map, nr_buckets) {
+		if (p->min_segno != NULL_SEGNO &&
+			(p->gc_mode == GC_GREEDY ||
+			 cb_cost(cb_utilization(sbi, vblocks), 100) >=
+							p->min_cost))
+			return;
+
+		list_for_each_entry(ve, &dirty_i->victim_bucket[vblocks], list) {
+			unsigned int secno = ve - dirty_i->victim_entry;
+			unsigned int segno = GET_SEG_FROM_SEC(sbi, secno);
+			unsigned long cost;
+
+			if (nsearched++ >= p->max_search)
+				return;
+
+			if (sec_usage_check(sbi, secno))
+				continue;
+			/* Don't touch checkpointed data */
+			if (unlikely(is_sbi_flag_set(sbi, SBI_CP_DISABLED) &&
+					get_ckpt_valid_blocks(sbi, segno)))
+				continue;
+			if (gc_type == BG_GC &&
+					test_bit(secno, dirty_i->victim_secmap))
+				continue;
+
+			cost = get_gc_cost(sbi, segno, p);
+			if (p->min_cost > cost) {
+				p->min_segno = segno;
+				p->min_cost = cost;
+			}
+		}
+	}
+}
+
 /*
  * This function is called from two paths.
  * One is garbage collection and the other is SSR segment selection.
@@ -356,6 +440,11 @@ static int get_victim_by_default(struct f2fs_sb_info *sbi,
 			goto got_it;
 	}
 
+	if (p.alloc_mode == LFS) {
+		get_victim_from_index(sbi, &p, gc_type);
+		goto search_done;
+	}
+
 	while (1) {
 		unsigned long cost;
 		unsigned int segno;
@@ -411,6 +500,7 @@ next:
 			break;
 		}
 	}
+search_done:
 	if (p.min_segno != NULL_SEGNO) {
 got_it:
 		*result = (p.min_segno / p.ofs_unit) * p.ofs_unit;
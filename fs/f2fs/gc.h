@@ -21,6 +21,7 @@
 
 /* Search max. number of dirty segments to select a victim segment */
 #define DEF_MAX_VICTIM_SEARCH 4096 /* covers 8GB */
+#define DEF_IDLE_GC_BATCH	8	/* GC rounds per wakeup when deeply idle */
 
 struct f2fs_gc_kthread {
 	struct task_struct *f2fs_gc_task;
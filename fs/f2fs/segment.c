@@ -777,6 +777,36 @@ int f2fs_flush_device_cache(struct f2fs_sb_info *sbi)
 	return ret;
 }
 
+/*
+ * File the section of @segno in the victim index under its valid blocks,
+ * or take it out when none of its segments is dirty any more.
+ * Must hold seglist_lock.
+ */
+static void __update_victim_index(struct f2fs_sb_info *sbi, unsigned int segno)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int secno = GET_SEC_FROM_SEG(sbi, segno);
+	unsigned int start = GET_SEG_FROM_SEC(sbi, secno);
+	unsigned int end = start + sbi->segs_per_sec;
+	struct victim_entry *ve = &dirty_i->victim_entry[secno];
+	unsigned int vblocks;
+
+	if (!list_empty(&ve->list)) {
+		list_del_init(&ve->list);
+		if (list_empty(&dirty_i->victim_bucket[ve->vblocks]))
+			clear_bit(ve->vblocks, dirty_i->victim_bucket_map);
+	}
+
+	if (find_next_bit(dirty_i->dirty_segmap[DIRTY], end, start) >= end)
+		return;
+
+	vblocks = min_t(unsigned int, get_valid_blocks(sbi, segno, true),
+			BLKS_PER_SEC(sbi));
+	ve->vblocks = vblocks;
+	list_add_tail(&ve->list, &dirty_i->victim_bucket[vblocks]);
+	set_bit(vblocks, dirty_i->victim_bucket_map);
+}
+
 static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		enum dirty_type dirty_type)
 {
@@ -799,6 +829,9 @@ static void __locate_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		}
 		if (!test_and_set_bit(segno, dirty_i->dirty_segmap[t]))
 			dirty_i->nr_dirty[t]++;
+
+		/* even if already dirty, its valid blocks may have changed */
+		__update_victim_index(sbi, segno);
 	}
 }
 
@@ -820,6 +853,8 @@ static void __remove_dirty_segment(struct f2fs_sb_info *sbi, unsigned int segno,
 		if (get_valid_blocks(sbi, segno, true) == 0)
 			clear_bit(GET_SEC_FROM_SEG(sbi, segno),
 						dirty_i->victim_secmap);
+
+		__update_victim_index(sbi, segno);
 	}
 }
 
@@ -1721,8 +1756,18 @@ static int issue_discard_thread(void *data)
 			continue;
 		}
 
-		if (sbi->gc_mode == GC_URGENT)
+		if (f2fs_fg_critical(sbi)) {
+			wait_ms = dpolicy.max_interval;
+			continue;
+		}
+
+		if (sbi->gc_mode == GC_URGENT) {
 			__init_discard_policy(sbi, &dpolicy, DPOLICY_FORCE, 1);
+		} else if (f2fs_deep_idle(sbi, DISCARD_TIME)) {
+			/* drain small discards too, in larger batches */
+			__init_discard_policy(sbi, &dpolicy, DPOLICY_BG, 1);
+			dpolicy.max_requests *= sbi->idle_gc_batch;
+		}
 
 		sb_start_intwrite(sbi->sb);
 
@@ -4262,6 +4307,31 @@ static int init_victim_secmap(struct f2fs_sb_info *sbi)
 	return 0;
 }
 
+static int init_victim_index(struct f2fs_sb_info *sbi)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+	unsigned int nr_buckets = BLKS_PER_SEC(sbi) + 1;
+	unsigned int i;
+
+	dirty_i->victim_entry = f2fs_kvzalloc(sbi,
+			array_size(MAIN_SECS(sbi), sizeof(struct victim_entry)),
+			GFP_KERNEL);
+	dirty_i->victim_bucket = f2fs_kvzalloc(sbi,
+			array_size(nr_buckets, sizeof(struct list_head)),
+			GFP_KERNEL);
+	dirty_i->victim_bucket_map = f2fs_kvzalloc(sbi,
+			f2fs_bitmap_size(nr_buckets), GFP_KERNEL);
+	if (!dirty_i->victim_entry || !dirty_i->victim_bucket ||
+					!dirty_i->victim_bucket_map)
+		return -ENOMEM;
+
+	for (i = 0; i < MAIN_SECS(sbi); i++)
+		INIT_LIST_HEAD(&dirty_i->victim_entry[i].list);
+	for (i = 0; i < nr_buckets; i++)
+		INIT_LIST_HEAD(&dirty_i->victim_bucket[i]);
+	return 0;
+}
+
 static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i;
@@ -4285,6 +4355,9 @@ static int build_dirty_segmap(struct f2fs_sb_info *sbi)
 			return -ENOMEM;
 	}
 
+	if (init_victim_index(sbi))
+		return -ENOMEM;
+
 	init_dirty_segmap(sbi);
 	return init_victim_secmap(sbi);
 }
@@ -4442,6 +4515,15 @@ static void destroy_victim_secmap(struct f2fs_sb_info *sbi)
 	kvfree(dirty_i->victim_secmap);
 }
 
+static void destroy_victim_index(struct f2fs_sb_info *sbi)
+{
+	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
+
+	kvfree(dirty_i->victim_entry);
+	kvfree(dirty_i->victim_bucket);
+	kvfree(dirty_i->victim_bucket_map);
+}
+
 static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
 {
 	struct dirty_seglist_info *dirty_i = DIRTY_I(sbi);
@@ -4455,6 +4537,7 @@ static void destroy_dirty_segmap(struct f2fs_sb_info *sbi)
 		discard_dirty_segmap(sbi, i);
 
 	destroy_victim_secmap(sbi);
+	destroy_victim_index(sbi);
 	SM_I(sbi)->dirty_info = NULL;
 	kvfree(dirty_i);
 }
@@ -271,12 +271,23 @@ enum dirty_type {
 	NR_DIRTY_TYPE
 };
 
+/* dirty section filed in the victim index */
+struct victim_entry {
+	struct list_head list;			/* on victim_bucket[vblocks] */
+	unsigned int vblocks;			/* valid blocks when filed */
+};
+
 struct dirty_seglist_info {
 	const struct victim_selection *v_ops;	/* victim selction operation */
 	unsigned long *dirty_segmap[NR_DIRTY_TYPE];
 	struct mutex seglist_lock;		/* lock for segment bitmaps */
 	int nr_dirty[NR_DIRTY_TYPE];		/* # of dirty segments */
 	unsigned long *victim_secmap;		/* background GC victims */
+
+	/* dirty sections by valid blocks, for LFS victim selection */
+	struct victim_entry *victim_entry;	/* one per section */
+	struct list_head *victim_bucket;	/* one per valid block count */
+	unsigned long *victim_bucket_map;	/* non-empty buckets */
 };
 
 /* victim selection function for cleaning and SSR */
@@ -95,6 +95,49 @@ static ssize_t lifetime_write_kbytes_show(struct f2fs_attr *a,
 			BD_PART_WRITTEN(sbi)));
 }
 
+static ssize_t hot_extent_nodes_show(struct f2fs_attr *a,
+		struct f2fs_sb_info *sbi, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%d\n",
+		atomic_read(&sbi->total_hot_ext_node));
+}
+
+static ssize_t hot_extent_hits_show(struct f2fs_attr *a,
+		struct f2fs_sb_info *sbi, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%lld\n",
+		(long long)atomic64_read(&sbi->hot_extent_hit));
+}
+
+static ssize_t hot_extent_misses_show(struct f2fs_attr *a,
+		struct f2fs_sb_info *sbi, char *buf)
+{
+	return snprintf(buf, PAGE_SIZE, "%lld\n",
+		(long long)atomic64_read(&sbi->hot_extent_miss));
+}
+
+static ssize_t cp_phase_us_show(struct f2fs_attr *a,
+		struct f2fs_sb_info *sbi, char *buf)
+{
+	static const char * const name[NR_CP_PHASE] = {
+		[CP_PHASE_PREPARE]	= "prepare",
+		[CP_PHASE_BLOCK_OPS]	= "block_ops",
+		[CP_PHASE_FLUSH_NAT_SIT] = "flush_nat_sit",
+		[CP_PHASE_COMMIT]	= "commit",
+	};
+	int len = 0, i;
+
+	len += snprintf(buf + len, PAGE_SIZE - len, "%-16s %10s %10s\n",
+				"phase", "last", "max");
+	for (i = 0; i < NR_CP_PHASE; i++)
+		len += snprintf(buf + len, PAGE_SIZE - len, "%-16s %10u %10u\n",
+				name[i], sbi->cp_phase_us[i],
+				sbi->cp_phase_max_us[i]);
+	len += snprintf(buf + len, PAGE_SIZE - len, "%-16s %10s %10u\n",
+				"blocked", "-", sbi->cp_blocked_max_us);
+	return len;
+}
+
 static ssize_t features_show(struct f2fs_attr *a,
 		struct f2fs_sb_info *sbi, char *buf)
 {
@@ -270,6 +313,9 @@ out:
 	if (!strcmp(a->attr.name, "trim_sections"))
 		return -EINVAL;
 
+	if (!strcmp(a->attr.name, "idle_gc_batch") && t == 0)
+		return -EINVAL;
+
 	if (!strcmp(a->attr.name, "gc_urgent")) {
 		if (t >= 1) {
 			sbi->gc_mode = GC_URGENT;
@@ -432,6 +478,11 @@ F2FS_RW_ATTR(NM_INFO, f2fs_nm_info, ra_nid_pages, ra_nid_pages);
 F2FS_RW_ATTR(NM_INFO, f2fs_nm_info, dirty_nats_ratio, dirty_nats_ratio);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, max_victim_search, max_victim_search);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, migration_granularity, migration_granularity);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, idle_aware, idle_aware);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, idle_gc_batch, idle_gc_batch);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, hot_extent_max_nodes, hot_extent_max_nodes);
+F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, hot_extent_miss_thresh,
+					hot_extent_miss_thresh);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, dir_level, dir_level);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, cp_interval, interval_time[CP_TIME]);
 F2FS_RW_ATTR(F2FS_SBI, f2fs_sb_info, idle_interval, interval_time[REQ_TIME]);
@@ -453,6 +504,10 @@ F2FS_GENERAL_RO_ATTR(lifetime_write_kbytes);
 F2FS_GENERAL_RO_ATTR(features);
 F2FS_GENERAL_RO_ATTR(current_reserved_blocks);
 F2FS_GENERAL_RO_ATTR(unusable);
+F2FS_GENERAL_RO_ATTR(hot_extent_nodes);
+F2FS_GENERAL_RO_ATTR(hot_extent_hits);
+F2FS_GENERAL_RO_ATTR(hot_extent_misses);
+F2FS_GENERAL_RO_ATTR(cp_phase_us);
 
 #ifdef CONFIG_F2FS_FS_ENCRYPTION
 F2FS_FEATURE_RO_ATTR(encryption, FEAT_CRYPTO);
@@ -489,6 +544,10 @@ static struct attribute *f2fs_attrs[] = {
 	ATTR_LIST(min_ssr_sections),
 	ATTR_LIST(max_victim_search),
 	ATTR_LIST(migration_granularity),
+	ATTR_LIST(idle_aware),
+	ATTR_LIST(idle_gc_batch),
+	ATTR_LIST(hot_extent_max_nodes),
+	ATTR_LIST(hot_extent_miss_thresh),
 	ATTR_LIST(dir_level),
 	ATTR_LIST(ram_thresh),
 	ATTR_LIST(ra_nid_pages),
@@ -508,6 +567,10 @@ static struct attribute *f2fs_attrs[] = {
 #endif
 	ATTR_LIST(dirty_segments),
 	ATTR_LIST(unusable),
+	ATTR_LIST(hot_extent_nodes),
+	ATTR_LIST(hot_extent_hits),
+	ATTR_LIST(hot_extent_misses),
+	ATTR_LIST(cp_phase_us),
 	ATTR_LIST(lifetime_write_kbytes),
 	ATTR_LIST(features),
 	ATTR_LIST(reserved_blocks),
@@ -28,6 +28,7 @@
 #include <linux/tracepoint.h>
 #include <linux/device.h>
 #include <linux/memcontrol.h>
+#include <linux/blk-boost.h>
 #include "internal.h"
 
 /*
@@ -1884,6 +1885,13 @@ static long wb_check_old_data_flush(struct bdi_writeback *wb)
 	if (!dirty_writeback_interval)
 		return 0;
 
+	/*
+	 * Leave the device to the foreground while it is boosted, the
+	 * next wakeup after the boost ends flushes what has expired since.
+	 */
+	if (blk_boost_active())
+		return 0;
+
 	expired = wb->last_old_flush +
 			msecs_to_jiffies(dirty_writeback_interval * 10);
 	if (time_before(jiffies, expired))
@@ -10,6 +10,7 @@
 
 #include <linux/init.h>
 #include <linux/module.h>
+#include <linux/slab.h>
 
 #define FUSE_CTL_SUPER_MAGIC 0x65735543
 
@@ -170,6 +171,67 @@ static ssize_t fuse_conn_congestion_threshold_write(struct file *file,
 	return ret;
 }
 
+static size_t fuse_conn_iqueue_stat(struct fuse_iqueue *fiq, char *buf,
+				    size_t size, const char *name)
+{
+	unsigned readers;
+	unsigned long queued, read;
+
+	spin_lock(&fiq->waitq.lock);
+	readers = fiq->readers;
+	queued = fiq->nr_queued;
+	read = fiq->nr_read;
+	spin_unlock(&fiq->waitq.lock);
+
+	return scnprintf(buf, size, "%-6s %7u %12lu %12lu\n", name, readers,
+			 queued, read);
+}
+
+/* requests queued and read per input queue, main first then each channel */
+static ssize_t fuse_conn_channels_read(struct file *file, char __user *buf,
+				       size_t len, loff_t *ppos)
+{
+	struct fuse_conn *fc;
+	char name[16];
+	char *tmp;
+	size_t size;
+	ssize_t ret;
+	int cpu;
+
+	fc = fuse_ctl_file_conn_get(file);
+	if (!fc)
+		return 0;
+
+	ret = -ENOMEM;
+	tmp = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!tmp)
+		goto out;
+
+	size = scnprintf(tmp, PAGE_SIZE, "%-6s %7s %12s %12s\n", "queue",
+			 "readers", "queued", "read");
+	size += fuse_conn_iqueue_stat(&fc->iq, tmp + size, PAGE_SIZE - size,
+				      "main");
+
+	spin_lock(&fc->lock);
+	if (fc->channels) {
+		for_each_possible_cpu(cpu) {
+			if (!fc->channels[cpu])
+				continue;
+			snprintf(name, sizeof(name), "cpu%d", cpu);
+			size += fuse_conn_iqueue_stat(fc->channels[cpu],
+						      tmp + size,
+						      PAGE_SIZE - size, name);
+		}
+	}
+	spin_unlock(&fc->lock);
+
+	ret = simple_read_from_buffer(buf, len, ppos, tmp, size);
+	kfree(tmp);
+out:
+	fuse_conn_put(fc);
+	return ret;
+}
+
 static const struct file_operations fuse_ctl_abort_ops = {
 	.open = nonseekable_open,
 	.write = fuse_conn_abort_write,
@@ -182,6 +244,12 @@ static const struct file_operations fuse_ctl_waiting_ops = {
 	.llseek = no_llseek,
 };
 
+static const struct file_operations fuse_ctl_channels_ops = {
+	.open = nonseekable_open,
+	.read = fuse_conn_channels_read,
+	.llseek = no_llseek,
+};
+
 static const struct file_operations fuse_conn_max_background_ops = {
 	.open = nonseekable_open,
 	.read = fuse_conn_max_background_read,
@@ -264,7 +332,9 @@ int fuse_ctl_add_conn(struct fuse_conn *fc)
 				 1, NULL, &fuse_conn_max_background_ops) ||
 	    !fuse_ctl_add_dentry(parent, fc, "congestion_threshold",
 				 S_IFREG | 0600, 1, NULL,
-				 &fuse_conn_congestion_threshold_ops))
+				 &fuse_conn_congestion_threshold_ops) ||
+	    !fuse_ctl_add_dentry(parent, fc, "channels", S_IFREG | 0400, 1,
+				 NULL, &fuse_ctl_channels_ops))
 		goto err;
 
 	return 0;
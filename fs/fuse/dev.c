@@ -94,6 +94,9 @@ struct fuse_req *fuse_request_alloc_nofs(unsigned npages)
 
 void fuse_request_free(struct fuse_req *req)
 {
+	/* not picked up by the opener, e.g. after an interrupted open */
+	if (req->passthrough_filp)
+		fput(req->passthrough_filp);
 	if (req->pages != req->inline_pages) {
 		kfree(req->pages);
 		kfree(req->page_descs);
@@ -345,10 +348,54 @@ static void queue_request(struct fuse_iqueue *fiq, struct fuse_req *req)
 	req->in.h.len = sizeof(struct fuse_in_header) +
 		len_args(req->in.numargs, (struct fuse_arg *) req->in.args);
 	list_add_tail(&req->list, &fiq->pending);
+	req->fiq = fiq;
+	fiq->nr_queued++;
 	wake_up_locked(&fiq->waitq);
 	kill_fasync(&fiq->fasync, SIGIO, POLL_IN);
 }
 
+/*
+ * Lock the input queue for a new request: the channel of the submitting CPU
+ * if a device is bound to it, fc->iq otherwise.
+ */
+static struct fuse_iqueue *fuse_lock_iqueue(struct fuse_conn *fc)
+{
+	struct fuse_iqueue **channels = READ_ONCE(fc->channels);
+	struct fuse_iqueue *fiq;
+
+	if (channels) {
+		fiq = READ_ONCE(channels[raw_smp_processor_id()]);
+		if (fiq) {
+			spin_lock(&fiq->waitq.lock);
+			if (fiq->readers)
+				return fiq;
+			spin_unlock(&fiq->waitq.lock);
+		}
+	}
+
+	fiq = &fc->iq;
+	spin_lock(&fiq->waitq.lock);
+	return fiq;
+}
+
+/*
+ * Lock the input queue @req was queued on.  Requests still queued on a
+ * channel move to fc->iq when its last device goes away.
+ */
+static struct fuse_iqueue *fuse_lock_req_iqueue(struct fuse_conn *fc,
+						 struct fuse_req *req)
+{
+	struct fuse_iqueue *fiq;
+
+	for (;;) {
+		fiq = READ_ONCE(req->fiq) ?: &fc->iq;
+		spin_lock(&fiq->waitq.lock);
+		if (fiq == (req->fiq ?: &fc->iq))
+			return fiq;
+		spin_unlock(&fiq->waitq.lock);
+	}
+}
+
 void fuse_queue_forget(struct fuse_conn *fc, struct fuse_forget_link *forget,
 		       u64 nodeid, u64 nlookup)
 {
@@ -374,12 +421,12 @@ static void flush_bg_queue(struct fuse_conn *fc)
 	while (fc->active_background < fc->max_background &&
 	       !list_empty(&fc->bg_queue)) {
 		struct fuse_req *req;
-		struct fuse_iqueue *fiq = &fc->iq;
+		struct fuse_iqueue *fiq;
 
 		req = list_entry(fc->bg_queue.next, struct fuse_req, list);
 		list_del(&req->list);
 		fc->active_background++;
-		spin_lock(&fiq->waitq.lock);
+		fiq = fuse_lock_iqueue(fc);
 		req->in.h.unique = fuse_get_unique(fiq);
 		queue_request(fiq, req);
 		spin_unlock(&fiq->waitq.lock);
@@ -396,12 +443,12 @@ static void flush_bg_queue(struct fuse_conn *fc)
  */
 static void request_end(struct fuse_conn *fc, struct fuse_req *req)
 {
-	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_iqueue *fiq;
 
 	if (test_and_set_bit(FR_FINISHED, &req->flags))
 		goto put_request;
 
-	spin_lock(&fiq->waitq.lock);
+	fiq = fuse_lock_req_iqueue(fc, req);
 	list_del_init(&req->intr_entry);
 	spin_unlock(&fiq->waitq.lock);
 	WARN_ON(test_bit(FR_PENDING, &req->flags));
@@ -440,9 +487,10 @@ put_request:
 	fuse_put_request(fc, req);
 }
 
-static void queue_interrupt(struct fuse_iqueue *fiq, struct fuse_req *req)
+static void queue_interrupt(struct fuse_conn *fc, struct fuse_req *req)
 {
-	spin_lock(&fiq->waitq.lock);
+	struct fuse_iqueue *fiq = fuse_lock_req_iqueue(fc, req);
+
 	if (test_bit(FR_FINISHED, &req->flags)) {
 		spin_unlock(&fiq->waitq.lock);
 		return;
@@ -457,7 +505,7 @@ static void queue_interrupt(struct fuse_iqueue *fiq, struct fuse_req *req)
 
 static void request_wait_answer(struct fuse_conn *fc, struct fuse_req *req)
 {
-	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_iqueue *fiq;
 	int err;
 
 	if (!fc->no_interrupt) {
@@ -471,7 +519,7 @@ static void request_wait_answer(struct fuse_conn *fc, struct fuse_req *req)
 		/* matches barrier in fuse_dev_do_read() */
 		smp_mb__after_atomic();
 		if (test_bit(FR_SENT, &req->flags))
-			queue_interrupt(fiq, req);
+			queue_interrupt(fc, req);
 	}
 
 	if (!test_bit(FR_FORCE, &req->flags)) {
@@ -486,7 +534,7 @@ static void request_wait_answer(struct fuse_conn *fc, struct fuse_req *req)
 		if (!err)
 			return;
 
-		spin_lock(&fiq->waitq.lock);
+		fiq = fuse_lock_req_iqueue(fc, req);
 		/* Request is not yet in userspace, bail out */
 		if (test_bit(FR_PENDING, &req->flags)) {
 			list_del(&req->list);
@@ -509,10 +557,10 @@ static void request_wait_answer(struct fuse_conn *fc, struct fuse_req *req)
 
 static void __fuse_request_send(struct fuse_conn *fc, struct fuse_req *req)
 {
-	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_iqueue *fiq;
 
 	BUG_ON(test_bit(FR_BACKGROUND, &req->flags));
-	spin_lock(&fiq->waitq.lock);
+	fiq = fuse_lock_iqueue(fc);
 	if (!fiq->connected) {
 		spin_unlock(&fiq->waitq.lock);
 		req->out.h.error = -ENOTCONN;
@@ -601,6 +649,10 @@ ssize_t fuse_simple_request(struct fuse_conn *fc, struct fuse_args *args)
 		BUG_ON(args->out.numargs != 1);
 		ret = req->out.args[0].size;
 	}
+	if (!ret) {
+		args->out.passthrough_filp = req->passthrough_filp;
+		req->passthrough_filp = NULL;
+	}
 	fuse_put_request(fc, req);
 
 	return ret;
@@ -1284,7 +1336,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 {
 	ssize_t err;
 	struct fuse_conn *fc = fud->fc;
-	struct fuse_iqueue *fiq = &fc->iq;
+	struct fuse_iqueue *fiq = fud->iq;
 	struct fuse_pqueue *fpq = &fud->pq;
 	struct fuse_req *req;
 	struct fuse_in *in;
@@ -1330,6 +1382,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 	req = list_entry(fiq->pending.next, struct fuse_req, list);
 	clear_bit(FR_PENDING, &req->flags);
 	list_del_init(&req->list);
+	fiq->nr_read++;
 	spin_unlock(&fiq->waitq.lock);
 
 	in = &req->in;
@@ -1382,7 +1435,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 	/* matches barrier in request_wait_answer() */
 	smp_mb__after_atomic();
 	if (test_bit(FR_INTERRUPTED, &req->flags))
-		queue_interrupt(fiq, req);
+		queue_interrupt(fc, req);
 	fuse_put_request(fc, req);
 
 	return reqsize;
@@ -1986,7 +2039,7 @@ static ssize_t fuse_dev_do_write(struct fuse_dev *fud,
 		if (oh.error == -ENOSYS)
 			fc->no_interrupt = 1;
 		else if (oh.error == -EAGAIN)
-			queue_interrupt(&fc->iq, req);
+			queue_interrupt(fc, req);
 		fuse_put_request(fc, req);
 
 		fuse_copy_finish(cs);
@@ -2009,6 +2062,10 @@ static ssize_t fuse_dev_do_write(struct fuse_dev *fud,
 		path[req->out.args[0].size - 1] = 0;
 		req->out.h.error = kern_path(path, 0, req->canonical_path);
 	}
+	/* the backing fd is only meaningful in the daemon's file table */
+	if (!err && !req->out.h.error &&
+	    (req->in.h.opcode == FUSE_OPEN || req->in.h.opcode == FUSE_CREATE))
+		fuse_passthrough_setup(fc, req);
 	fuse_copy_finish(cs);
 
 	spin_lock(&fpq->lock);
@@ -2143,7 +2200,7 @@ static unsigned fuse_dev_poll(struct file *file, poll_table *wait)
 	if (!fud)
 		return POLLERR;
 
-	fiq = &fud->fc->iq;
+	fiq = fud->iq;
 	poll_wait(file, &fiq->waitq, wait);
 
 	spin_lock(&fiq->waitq.lock);
@@ -2246,6 +2303,23 @@ void fuse_abort_conn(struct fuse_conn *fc)
 		fc->max_background = UINT_MAX;
 		flush_bg_queue(fc);
 
+		if (fc->channels) {
+			int cpu;
+
+			for_each_possible_cpu(cpu) {
+				struct fuse_iqueue *chan = fc->channels[cpu];
+
+				if (!chan)
+					continue;
+				spin_lock(&chan->waitq.lock);
+				chan->connected = 0;
+				list_splice_tail_init(&chan->pending, &to_end2);
+				wake_up_all_locked(&chan->waitq);
+				spin_unlock(&chan->waitq.lock);
+				kill_fasync(&chan->fasync, SIGIO, POLL_IN);
+			}
+		}
+
 		spin_lock(&fiq->waitq.lock);
 		fiq->connected = 0;
 		list_splice_init(&fiq->pending, &to_end2);
@@ -2279,6 +2353,36 @@ void fuse_wait_aborted(struct fuse_conn *fc)
 	fuse_wait_event(fc->blocked_waitq, atomic_read(&fc->num_waiting) == 0);
 }
 
+/*
+ * Drop @fud from its channel.  Whatever the last device of a channel leaves
+ * queued is moved over to fc->iq.
+ */
+static void fuse_device_unbind_channel(struct fuse_dev *fud)
+{
+	struct fuse_iqueue *fiq = &fud->fc->iq;
+	struct fuse_iqueue *chan = fud->iq;
+	struct fuse_req *req;
+
+	if (chan == fiq)
+		return;
+
+	spin_lock(&chan->waitq.lock);
+	if (!--chan->readers) {
+		spin_lock_nested(&fiq->waitq.lock, SINGLE_DEPTH_NESTING);
+		list_for_each_entry(req, &chan->pending, list)
+			req->fiq = fiq;
+		list_for_each_entry(req, &chan->interrupts, intr_entry)
+			req->fiq = fiq;
+		list_splice_tail_init(&chan->pending, &fiq->pending);
+		list_splice_tail_init(&chan->interrupts, &fiq->interrupts);
+		if (request_pending(fiq))
+			wake_up_locked(&fiq->waitq);
+		spin_unlock(&fiq->waitq.lock);
+	}
+	spin_unlock(&chan->waitq.lock);
+	fud->iq = fiq;
+}
+
 int fuse_dev_release(struct inode *inode, struct file *file)
 {
 	struct fuse_dev *fud = fuse_get_dev(file);
@@ -2294,6 +2398,7 @@ int fuse_dev_release(struct inode *inode, struct file *file)
 		spin_unlock(&fpq->lock);
 
 		end_requests(fc, &to_end);
+		fuse_device_unbind_channel(fud);
 
 		/* Are we the last open device? */
 		if (atomic_dec_and_test(&fc->dev_count)) {
@@ -2314,7 +2419,7 @@ static int fuse_dev_fasync(int fd, struct file *file, int on)
 		return -EPERM;
 
 	/* No locking - fasync_helper does its own locking */
-	return fasync_helper(fd, file, on, &fud->fc->iq.fasync);
+	return fasync_helper(fd, file, on, &fud->iq->fasync);
 }
 
 static int fuse_device_clone(struct fuse_conn *fc, struct file *new)
@@ -2334,11 +2439,86 @@ static int fuse_device_clone(struct fuse_conn *fc, struct file *new)
 	return 0;
 }
 
+static int fuse_device_bind_channel(struct fuse_dev *fud, struct file *file,
+				    unsigned int cpu)
+{
+	struct fuse_conn *fc = fud->fc;
+	struct fuse_iqueue **channels = NULL;
+	struct fuse_iqueue *fiq = NULL;
+	struct fuse_iqueue *chan;
+	int err;
+
+	if (cpu >= nr_cpu_ids || !cpu_possible(cpu))
+		return -EINVAL;
+
+	/* fasync is registered on the queue the device reads from */
+	if (fud->iq != &fc->iq || (file->f_flags & FASYNC))
+		return -EBUSY;
+
+	err = -ENOMEM;
+	if (!READ_ONCE(fc->channels)) {
+		channels = kcalloc(nr_cpu_ids, sizeof(*channels), GFP_KERNEL);
+		if (!channels)
+			goto out;
+	}
+	fiq = kmalloc(sizeof(*fiq), GFP_KERNEL);
+	if (!fiq)
+		goto out;
+	fuse_iqueue_init(fiq);
+	/* keep unique ids apart from those of other queues */
+	fiq->reqctr = (u64)(cpu + 1) << 48;
+
+	spin_lock(&fc->lock);
+	err = -ENODEV;
+	if (!fc->connected)
+		goto out_unlock;
+
+	if (!fc->channels) {
+		smp_store_release(&fc->channels, channels);
+		channels = NULL;
+	}
+	if (!fc->channels[cpu]) {
+		smp_store_release(&fc->channels[cpu], fiq);
+		fiq = NULL;
+	}
+	chan = fc->channels[cpu];
+
+	spin_lock(&chan->waitq.lock);
+	chan->readers++;
+	spin_unlock(&chan->waitq.lock);
+	fud->iq = chan;
+	err = 0;
+out_unlock:
+	spin_unlock(&fc->lock);
+out:
+	kfree(channels);
+	kfree(fiq);
+	return err;
+}
+
 static long fuse_dev_ioctl(struct file *file, unsigned int cmd,
 			   unsigned long arg)
 {
 	int err = -ENOTTY;
 
+	if (cmd == FUSE_DEV_IOC_CHANNEL) {
+		struct fuse_dev *fud = fuse_get_dev(file);
+		u32 cpu;
+
+		err = -EINVAL;
+		/* CUSE uses the same ioctl handler */
+		if (!fud || file->f_op != &fuse_dev_operations)
+			return err;
+
+		err = -EFAULT;
+		if (!get_user(cpu, (__u32 __user *) arg)) {
+			mutex_lock(&fuse_mutex);
+			err = fuse_device_bind_channel(fud, file, cpu);
+			mutex_unlock(&fuse_mutex);
+		}
+		return err;
+	}
+
 	if (cmd == FUSE_DEV_IOC_CLONE) {
 		int oldfd;
 
@@ -0,0 +1,166 @@
+/*
+  FUSE: Filesystem in Userspace
+  Passthrough of data I/O to a backing file
+
+  This program can be distributed under the terms of the GNU GPL.
+  See the file COPYING.
+*/
+
+/*
+ * When the daemon sets FOPEN_PASSTHROUGH in its reply to an open or create,
+ * passthrough_fd names a file it has open on the lower filesystem. Reads,
+ * writes and mmap of the FUSE file then go straight to that file, with the
+ * credentials it was opened with, instead of being copied to the daemon and
+ * back. Everything else, lookups, open itself, permissions, attributes and
+ * release, still goes through the daemon.
+ */
+
+#include "fuse_i.h"
+
+#include <linux/file.h>
+#include <linux/fs_stack.h>
+#include <linux/mm.h>
+#include <linux/uio.h>
+
+/*
+ * Called in the daemon's context while it writes the reply, the only time
+ * its file table can be looked at.
+ */
+void fuse_passthrough_setup(struct fuse_conn *fc, struct fuse_req *req)
+{
+	struct fuse_arg *arg = &req->out.args[req->out.numargs - 1];
+	struct fuse_open_out *outarg = arg->value;
+	struct file *filp;
+	struct inode *inode;
+
+	if (arg->size != sizeof(*outarg) ||
+	    !(outarg->open_flags & FOPEN_PASSTHROUGH))
+		return;
+
+	/* set again below if the backing file turns out usable */
+	outarg->open_flags &= ~FOPEN_PASSTHROUGH;
+	if (!fc->passthrough)
+		return;
+
+	filp = fget(outarg->passthrough_fd);
+	if (!filp) {
+		pr_warn_ratelimited("fuse: bad passthrough fd %u\n",
+				    outarg->passthrough_fd);
+		return;
+	}
+
+	inode = file_inode(filp);
+	if (!S_ISREG(inode->i_mode) || !filp->f_op->read_iter ||
+	    !filp->f_op->write_iter ||
+	    /* no stacking of FUSE mounts on each other */
+	    inode->i_sb->s_magic == FUSE_SUPER_MAGIC) {
+		pr_warn_ratelimited("fuse: unsupported passthrough file\n");
+		fput(filp);
+		return;
+	}
+
+	outarg->open_flags |= FOPEN_PASSTHROUGH;
+	req->passthrough_filp = filp;
+}
+
+void fuse_passthrough_release(struct fuse_file *ff)
+{
+	if (ff->passthrough_filp) {
+		fput(ff->passthrough_filp);
+		ff->passthrough_filp = NULL;
+	}
+}
+
+ssize_t fuse_passthrough_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct file *file = iocb->ki_filp;
+	struct fuse_file *ff = file->private_data;
+	struct file *lower = ff->passthrough_filp;
+	const struct cred *old_cred;
+	ssize_t ret;
+
+	if (!iov_iter_count(to))
+		return 0;
+
+	old_cred = override_creds(lower->f_cred);
+	ret = vfs_iter_read(lower, to, &iocb->ki_pos);
+	revert_creds(old_cred);
+
+	if (ret >= 0)
+		fsstack_copy_attr_atime(file_inode(file), file_inode(lower));
+
+	return ret;
+}
+
+ssize_t fuse_passthrough_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct file *file = iocb->ki_filp;
+	struct fuse_file *ff = file->private_data;
+	struct file *lower = ff->passthrough_filp;
+	struct inode *inode = file_inode(file);
+	const struct cred *old_cred;
+	loff_t pos;
+	ssize_t ret;
+
+	if (!iov_iter_count(from))
+		return 0;
+
+	mutex_lock(&inode->i_mutex);
+
+	/* the backing file was opened by the daemon, with its own flags */
+	if (iocb->ki_flags & IOCB_APPEND)
+		iocb->ki_pos = i_size_read(file_inode(lower));
+	pos = iocb->ki_pos;
+
+	old_cred = override_creds(lower->f_cred);
+	file_start_write(lower);
+	ret = vfs_iter_write(lower, from, &iocb->ki_pos);
+	file_end_write(lower);
+	if (ret > 0 && ((file->f_flags & O_DSYNC) || IS_SYNC(inode))) {
+		int err = vfs_fsync_range(lower, pos, pos + ret - 1,
+					  !(file->f_flags & __O_SYNC));
+		if (err)
+			ret = err;
+	}
+	revert_creds(old_cred);
+
+	if (ret > 0) {
+		fuse_write_update_size(inode, iocb->ki_pos);
+		fsstack_copy_attr_times(inode, file_inode(lower));
+		fuse_invalidate_attr(inode);
+	}
+
+	mutex_unlock(&inode->i_mutex);
+
+	return ret;
+}
+
+int fuse_passthrough_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct fuse_file *ff = file->private_data;
+	struct file *lower = ff->passthrough_filp;
+	const struct cred *old_cred;
+	int ret;
+
+	if (!lower->f_op->mmap)
+		return -ENODEV;
+
+	if (WARN_ON(file != vma->vm_file))
+		return -EIO;
+
+	/* the mapping is of the lower file's pages */
+	vma->vm_file = get_file(lower);
+
+	old_cred = override_creds(lower->f_cred);
+	ret = lower->f_op->mmap(lower, vma);
+	revert_creds(old_cred);
+
+	if (ret) {
+		fput(lower);
+	} else {
+		file_accessed(file);
+		fput(file);
+	}
+
+	return ret;
+}
@@ -2355,5 +2355,41 @@ const struct file_operations proc_pid_io_record_operations = {
 	.write		= pid_io_record_write,
 	.llseek		= noop_llseek,
 };
+
+/* write a trace read from io_record_control to prefetch it, read for stats */
+static int pid_io_replay_open(struct inode *inode, struct file *file)
+{
+	if (file->f_mode & FMODE_WRITE)
+		return open_replay();
+	return 0;
+}
+
+static ssize_t pid_io_replay_read(struct file *file, char __user *buf,
+			size_t count, loff_t *ppos)
+{
+	return read_replay(buf, count, ppos);
+}
+
+static ssize_t pid_io_replay_write(struct file *file,
+					       const char __user *buf,
+					       size_t count, loff_t *ppos)
+{
+	return write_replay(buf, count, ppos);
+}
+
+static int pid_io_replay_release(struct inode *inode, struct file *file)
+{
+	if (file->f_mode & FMODE_WRITE)
+		start_replay();
+	return 0;
+}
+
+const struct file_operations proc_pid_io_replay_operations = {
+	.open		= pid_io_replay_open,
+	.read		= pid_io_replay_read,
+	.write		= pid_io_replay_write,
+	.release	= pid_io_replay_release,
+	.llseek		= noop_llseek,
+};
 #endif
 #endif
@@ -26,6 +26,61 @@ extern
 int __fscrypt_sdp_d_delete(const struct dentry *dentry, int dek_is_locked);
 #endif
 
+DEFINE_PER_CPU(unsigned long, sdcardfs_rcu_walk_hit);
+DEFINE_PER_CPU(unsigned long, sdcardfs_rcu_walk_fallback);
+
+/*
+ * The checks of sdcardfs_d_revalidate that can be made without references,
+ * locks or sleeping. Anything that looks changed returns -ECHILD, so that
+ * ref-walk takes the decision. So do obb dentries, whose check needs
+ * d_path, and lower filesystems that revalidate themselves.
+ */
+static int sdcardfs_d_revalidate_rcu(struct dentry *dentry)
+{
+	struct sdcardfs_dentry_info *di = READ_ONCE(dentry->d_fsdata);
+	struct sdcardfs_dentry_info *pdi;
+	struct dentry *parent, *lower;
+	struct inode *inode, *parent_inode;
+	struct sdcardfs_inode_data *top;
+	unsigned int seq;
+
+	if (IS_ROOT(dentry))
+		return 1;
+	if (!di || READ_ONCE(di->orig_path.dentry))
+		return -ECHILD;
+
+	lower = READ_ONCE(di->lower_path.dentry);
+	if (!lower || (lower->d_flags & DCACHE_OP_REVALIDATE))
+		return -ECHILD;
+
+	parent = READ_ONCE(dentry->d_parent);
+	pdi = READ_ONCE(parent->d_fsdata);
+	if (!pdi)
+		return -ECHILD;
+
+	seq = raw_seqcount_begin(&lower->d_seq);
+	if (d_unhashed(lower) ||
+	    READ_ONCE(lower->d_parent) != READ_ONCE(pdi->lower_path.dentry) ||
+	    !qstr_case_eq(&dentry->d_name, &lower->d_name) ||
+	    read_seqcount_retry(&lower->d_seq, seq))
+		return -ECHILD;
+
+	inode = d_inode_rcu(dentry);
+	if (!inode)
+		return 1;
+
+	top = READ_ONCE(SDCARDFS_I(inode)->top_data);
+	if (!top || READ_ONCE(top->abandoned))
+		return -ECHILD;
+
+	parent_inode = d_inode_rcu(parent);
+	if (!parent_inode ||
+	    !derived_permission_current_rcu(parent_inode, inode))
+		return -ECHILD;
+
+	return 1;
+}
+
 /*
  * returns: -ERRNO if error (returned to user)
  *          0: tell VFS to invalidate dentry
@@ -42,8 +97,14 @@ static int sdcardfs_d_revalidate(struct dentry *dentry, unsigned int flags)
 	struct inode *inode;
 	struct sdcardfs_inode_data *data;
 
-	if (flags & LOOKUP_RCU)
-		return -ECHILD;
+	if (flags & LOOKUP_RCU) {
+		err = sdcardfs_d_revalidate_rcu(dentry);
+		if (err > 0)
+			this_cpu_inc(sdcardfs_rcu_walk_hit);
+		else
+			this_cpu_inc(sdcardfs_rcu_walk_fallback);
+		return err;
+	}
 
 	spin_lock(&dentry->d_lock);
 	if (IS_ROOT(dentry)) {
@@ -120,6 +181,9 @@ static int sdcardfs_d_revalidate(struct dentry *dentry, unsigned int flags)
 		iput(inode);
 	}
 
+	if (err > 0 && d_inode(dentry))
+		revalidate_derived_permission(parent_dentry, dentry);
+
 out:
 	dput(parent_dentry);
 	dput(lower_cur_parent_dentry);
@@ -91,6 +91,8 @@ void get_derived_permission_new(struct dentry *parent, struct dentry *dentry,
 	 */
 
 	inherit_derived_state(d_inode(parent), d_inode(dentry));
+	/* read before the package list is, a change in between is caught later */
+	info->data->pkg_gen = packagelist_generation();
 
 	/* Files don't get special labels */
 	if (!S_ISDIR(d_inode(dentry)->i_mode))
@@ -325,16 +327,8 @@ retry_deleg:
 	sdcardfs_put_lower_path(dentry, &path);
 }
 
-static int descendant_may_need_fixup(struct sdcardfs_inode_data *data,
-		struct limit_search *limit)
-{
-	if (data->perm == PERM_ROOT)
-		return (limit->flags & BY_USERID) ?
-				data->userid == limit->userid : 1;
-	if (data->perm == PERM_PRE_ROOT || data->perm == PERM_ANDROID)
-		return 1;
-	return 0;
-}
+atomic_long_t sdcardfs_perm_checked = ATOMIC_LONG_INIT(0);
+atomic_long_t sdcardfs_perm_revalidated = ATOMIC_LONG_INIT(0);
 
 static int needs_fixup(perm_t perm)
 {
@@ -344,48 +338,46 @@ static int needs_fixup(perm_t perm)
 	return 0;
 }
 
-static void __fixup_perms_recursive(struct dentry *dentry, struct limit_search *limit, int depth)
+/*
+ * The owner of a package directory comes from the package list. Instead of
+ * walking every tree when the list changes, the derived state is stamped
+ * with the list's generation and derived again when the directory is next
+ * revalidated with a different one. Everything below a package directory
+ * takes its owner from there, through top_data.
+ */
+void revalidate_derived_permission(struct dentry *parent, struct dentry *dentry)
 {
-	struct dentry *child;
-	struct sdcardfs_inode_info *info;
+	struct sdcardfs_inode_info *info = SDCARDFS_I(d_inode(dentry));
 
-	/*
-	 * All paths will terminate their recursion on hitting PERM_ANDROID_OBB,
-	 * PERM_ANDROID_MEDIA, or PERM_ANDROID_DATA. This happens at a depth of
-	 * at most 3.
-	 */
-	WARN(depth > 3, "%s: Max expected depth exceeded!\n", __func__);
-	spin_lock_nested(&dentry->d_lock, depth);
-	if (!d_inode(dentry)) {
-		spin_unlock(&dentry->d_lock);
+	if (!needs_fixup(SDCARDFS_I(d_inode(parent))->data->perm))
 		return;
-	}
-	info = SDCARDFS_I(d_inode(dentry));
 
-	if (needs_fixup(info->data->perm)) {
-		list_for_each_entry(child, &dentry->d_subdirs, d_child) {
-			spin_lock_nested(&child->d_lock, depth + 1);
-			if (!(limit->flags & BY_NAME) || qstr_case_eq(&child->d_name, &limit->name)) {
-				if (d_inode(child)) {
-					get_derived_permission(dentry, child);
-					fixup_tmp_permissions(d_inode(child));
-					spin_unlock(&child->d_lock);
-					break;
-				}
-			}
-			spin_unlock(&child->d_lock);
-		}
-	} else if (descendant_may_need_fixup(info->data, limit)) {
-		list_for_each_entry(child, &dentry->d_subdirs, d_child) {
-			__fixup_perms_recursive(child, limit, depth + 1);
-		}
-	}
+	atomic_long_inc(&sdcardfs_perm_checked);
+	if (READ_ONCE(info->data->pkg_gen) == packagelist_generation())
+		return;
+
+	spin_lock(&dentry->d_lock);
+	get_derived_permission(parent, dentry);
+	fixup_tmp_permissions(d_inode(dentry));
 	spin_unlock(&dentry->d_lock);
+	atomic_long_inc(&sdcardfs_perm_revalidated);
 }
 
-void fixup_perms_recursive(struct dentry *dentry, struct limit_search *limit)
+/*
+ * Whether revalidate_derived_permission would leave @inode alone, checked
+ * without locks for RCU-walk. Both inodes are only read; their data is
+ * freed after a grace period.
+ */
+bool derived_permission_current_rcu(struct inode *parent, struct inode *inode)
 {
-	__fixup_perms_recursive(dentry, limit, 0);
+	struct sdcardfs_inode_data *pdata = READ_ONCE(SDCARDFS_I(parent)->data);
+	struct sdcardfs_inode_data *data = READ_ONCE(SDCARDFS_I(inode)->data);
+
+	if (!pdata || !data)
+		return false;
+	if (!needs_fixup(pdata->perm))
+		return true;
+	return READ_ONCE(data->pkg_gen) == packagelist_generation();
 }
 
 /* main function for updating derived permission */
@@ -36,13 +36,24 @@ int sdcardfs_init_dentry_cache(void)
 
 void sdcardfs_destroy_dentry_cache(void)
 {
+	rcu_barrier();
 	kmem_cache_destroy(sdcardfs_dentry_cachep);
 }
 
+static void dentry_private_data_free_rcu(struct rcu_head *head)
+{
+	struct sdcardfs_dentry_info *info =
+		container_of(head, struct sdcardfs_dentry_info, rcu);
+
+	kmem_cache_free(sdcardfs_dentry_cachep, info);
+}
+
 void free_dentry_private_data(struct dentry *dentry)
 {
-	kmem_cache_free(sdcardfs_dentry_cachep, dentry->d_fsdata);
-	dentry->d_fsdata = NULL;
+	struct sdcardfs_dentry_info *info = dentry->d_fsdata;
+
+	WRITE_ONCE(dentry->d_fsdata, NULL);
+	call_rcu(&info->rcu, dentry_private_data_free_rcu);
 }
 
 /* allocate new dentry private data */
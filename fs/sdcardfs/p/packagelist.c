@@ -249,44 +249,20 @@ static int insert_userid_exclude_entry_locked(const struct qstr *key, userid_t v
 	return 0;
 }
 
-static void fixup_all_perms_name(const struct qstr *key)
-{
-	struct sdcardfs_sb_info *sbinfo;
-	struct limit_search limit = {
-		.flags = BY_NAME,
-		.name = QSTR_INIT(key->name, key->len),
-	};
-	list_for_each_entry(sbinfo, &sdcardfs_super_list, list) {
-		if (sbinfo_has_sdcard_magic(sbinfo))
-			fixup_perms_recursive(sbinfo->sb->s_root, &limit);
-	}
-}
+/*
+ * Bumped on every change that may give a package directory another owner,
+ * see revalidate_derived_permission().
+ */
+static atomic_t packagelist_gen = ATOMIC_INIT(0);
 
-static void fixup_all_perms_name_userid(const struct qstr *key, userid_t userid)
+unsigned int packagelist_generation(void)
 {
-	struct sdcardfs_sb_info *sbinfo;
-	struct limit_search limit = {
-		.flags = BY_NAME | BY_USERID,
-		.name = QSTR_INIT(key->name, key->len),
-		.userid = userid,
-	};
-	list_for_each_entry(sbinfo, &sdcardfs_super_list, list) {
-		if (sbinfo_has_sdcard_magic(sbinfo))
-			fixup_perms_recursive(sbinfo->sb->s_root, &limit);
-	}
+	return atomic_read(&packagelist_gen);
 }
 
-static void fixup_all_perms_userid(userid_t userid)
+static void packagelist_changed(void)
 {
-	struct sdcardfs_sb_info *sbinfo;
-	struct limit_search limit = {
-		.flags = BY_USERID,
-		.userid = userid,
-	};
-	list_for_each_entry(sbinfo, &sdcardfs_super_list, list) {
-		if (sbinfo_has_sdcard_magic(sbinfo))
-			fixup_perms_recursive(sbinfo->sb->s_root, &limit);
-	}
+	atomic_inc(&packagelist_gen);
 }
 
 static int insert_packagelist_entry(const struct qstr *key, appid_t value)
@@ -296,7 +272,7 @@ static int insert_packagelist_entry(const struct qstr *key, appid_t value)
 	mutex_lock(&sdcardfs_super_list_lock);
 	err = insert_packagelist_appid_entry_locked(key, value);
 	if (!err)
-		fixup_all_perms_name(key);
+		packagelist_changed();
 	mutex_unlock(&sdcardfs_super_list_lock);
 
 	return err;
@@ -320,7 +296,7 @@ static int insert_userid_exclude_entry(const struct qstr *key, userid_t value)
 	mutex_lock(&sdcardfs_super_list_lock);
 	err = insert_userid_exclude_entry_locked(key, value);
 	if (!err)
-		fixup_all_perms_name_userid(key, value);
+		packagelist_changed();
 	mutex_unlock(&sdcardfs_super_list_lock);
 
 	return err;
@@ -361,7 +337,7 @@ static void remove_packagelist_entry(const struct qstr *key)
 {
 	mutex_lock(&sdcardfs_super_list_lock);
 	remove_packagelist_entry_locked(key);
-	fixup_all_perms_name(key);
+	packagelist_changed();
 	mutex_unlock(&sdcardfs_super_list_lock);
 }
 
@@ -410,7 +386,7 @@ static void remove_userid_all_entry(userid_t userid)
 {
 	mutex_lock(&sdcardfs_super_list_lock);
 	remove_userid_all_entry_locked(userid);
-	fixup_all_perms_userid(userid);
+	packagelist_changed();
 	mutex_unlock(&sdcardfs_super_list_lock);
 }
 
@@ -434,7 +410,7 @@ static void remove_userid_exclude_entry(const struct qstr *key, userid_t userid)
 {
 	mutex_lock(&sdcardfs_super_list_lock);
 	remove_userid_exclude_entry_locked(key, userid);
-	fixup_all_perms_name_userid(key, userid);
+	packagelist_changed();
 	mutex_unlock(&sdcardfs_super_list_lock);
 }
 
@@ -792,6 +768,32 @@ static ssize_t packages_remove_userid_store(struct config_item *item,
 	return count;
 }
 
+static ssize_t packages_perm_cache_show(struct config_item *item, char *page)
+{
+	return scnprintf(page, PAGE_SIZE,
+			 "generation: %u\nchecked: %ld\nrevalidated: %ld\n",
+			 packagelist_generation(),
+			 atomic_long_read(&sdcardfs_perm_checked),
+			 atomic_long_read(&sdcardfs_perm_revalidated));
+}
+
+static unsigned long sdcardfs_sum_percpu(unsigned long __percpu *counter)
+{
+	unsigned long sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += *per_cpu_ptr(counter, cpu);
+	return sum;
+}
+
+static ssize_t packages_rcu_walk_show(struct config_item *item, char *page)
+{
+	return scnprintf(page, PAGE_SIZE, "hit: %lu\nfallback: %lu\n",
+			 sdcardfs_sum_percpu(&sdcardfs_rcu_walk_hit),
+			 sdcardfs_sum_percpu(&sdcardfs_rcu_walk_fallback));
+}
+
 static struct configfs_attribute packages_attr_packages_gid_list = {
 	.ca_name	= "packages_gid.list",
 	.ca_mode	= S_IRUGO,
@@ -800,10 +802,14 @@ static struct configfs_attribute packages_attr_packages_gid_list = {
 };
 
 SDCARDFS_CONFIGFS_ATTR_WO(packages_, remove_userid);
+SDCARDFS_CONFIGFS_ATTR_RO(packages_, perm_cache);
+SDCARDFS_CONFIGFS_ATTR_RO(packages_, rcu_walk);
 
 static struct configfs_attribute *packages_attrs[] = {
 	&packages_attr_packages_gid_list,
 	&packages_attr_remove_userid,
+	&packages_attr_perm_cache,
+	&packages_attr_rcu_walk,
 	NULL,
 };
 
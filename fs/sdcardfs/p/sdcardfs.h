@@ -46,6 +46,7 @@
 #include <linux/string.h>
 #include <linux/list.h>
 #include <linux/ratelimit.h>
+#include <linux/percpu.h>
 #include "multiuser.h"
 
 /* the file system name */
@@ -196,6 +197,9 @@ struct sdcardfs_inode_data {
 #if defined(CONFIG_SDCARD_FS_SUPPORT_KNOX)
 	bool under_knox;
 #endif
+	/* package list generation the state was derived at */
+	unsigned int pkg_gen;
+	struct rcu_head rcu;	/* freed after RCU-walk is done with it */
 };
 
 /* sdcardfs inode data in memory */
@@ -216,6 +220,7 @@ struct sdcardfs_dentry_info {
 	spinlock_t lock;	/* protects lower_path */
 	struct path lower_path;
 	struct path orig_path;
+	struct rcu_head rcu;	/* freed after RCU-walk is done with it */
 };
 
 struct sdcardfs_mount_options {
@@ -531,24 +536,26 @@ extern appid_t get_appid(const char *app_name);
 extern appid_t get_ext_gid(const char *app_name);
 extern appid_t is_excluded(const char *app_name, userid_t userid);
 extern int check_caller_access_to_name(struct inode *parent_node, const struct qstr *name);
+extern unsigned int packagelist_generation(void);
 extern int packagelist_init(void);
 extern void packagelist_exit(void);
 
 /* for derived_perm.c */
-#define BY_NAME		(1 << 0)
-#define BY_USERID	(1 << 1)
-struct limit_search {
-	unsigned int flags;
-	struct qstr name;
-	userid_t userid;
-};
+extern atomic_long_t sdcardfs_perm_checked;
+extern atomic_long_t sdcardfs_perm_revalidated;
+
+/* for dentry.c */
+DECLARE_PER_CPU(unsigned long, sdcardfs_rcu_walk_hit);
+DECLARE_PER_CPU(unsigned long, sdcardfs_rcu_walk_fallback);
 
 extern void setup_derived_state(struct inode *inode, perm_t perm,
 		userid_t userid, uid_t uid, bool under_android,
 		struct sdcardfs_inode_data *top);
 extern void get_derived_permission(struct dentry *parent, struct dentry *dentry);
 extern void get_derived_permission_new(struct dentry *parent, struct dentry *dentry, const struct qstr *name);
-extern void fixup_perms_recursive(struct dentry *dentry, struct limit_search *limit);
+extern void revalidate_derived_permission(struct dentry *parent, struct dentry *dentry);
+extern bool derived_permission_current_rcu(struct inode *parent,
+		struct inode *inode);
 
 extern void update_derived_permission_lock(struct dentry *dentry);
 void fixup_lower_ownership(struct dentry *dentry, const char *name);
@@ -282,6 +282,7 @@ typedef struct __FS_INFO_T {
 	u32      map_clu;                // allocation bitmap start cluster
 	u32      map_sectors;            // num of allocation bitmap sectors
 	struct buffer_head **vol_amap;      // allocation bitmap
+	u16      *vol_amap_free;         // free clusters per bitmap sector
 
 	u16      **vol_utbl;               // upcase table
 
@@ -1040,6 +1040,31 @@ static s32 exfat_check_max_dentries(FILE_ID_T *fid)
 /*
  *  Allocation Bitmap Management Functions
  */
+
+/*
+ * Count the free clusters covered by each bitmap sector, so allocation can
+ * step over full sectors and used clusters are counted without a scan.
+ * A sector covers at most 32768 clusters (4KB), which fits in a u16.
+ * Nothing depends on it being there, it is skipped if memory is short.
+ */
+static void build_alloc_bmp_index(struct super_block *sb)
+{
+	u32 i, nbits, used;
+	u32 bits_per_sect = (u32)sb->s_blocksize << 3;
+	FS_INFO_T *fsi = &(SDFAT_SB(sb)->fsi);
+	u32 total_clus = fsi->num_clusters - CLUS_BASE;
+
+	fsi->vol_amap_free = kmalloc((sizeof(u16) * fsi->map_sectors), GFP_KERNEL);
+	if (!fsi->vol_amap_free)
+		return;
+
+	for (i = 0; i < fsi->map_sectors; i++) {
+		nbits = min(bits_per_sect, total_clus - (i * bits_per_sect));
+		used = bitmap_weight((unsigned long *)(fsi->vol_amap[i]->b_data), nbits);
+		fsi->vol_amap_free[i] = (u16)(nbits - used);
+	}
+}
+
 s32 load_alloc_bmp(struct super_block *sb)
 {
 	s32 ret;
@@ -1086,6 +1111,9 @@ s32 load_alloc_bmp(struct super_block *sb)
 
 				sector = CLUS_TO_SECT(fsi, fsi->map_clu);
 
+				/* have the whole bitmap in flight, not a sector at a time */
+				bdev_readahead(sb, sector, (u64)fsi->map_sectors);
+
 				for (j = 0; j < fsi->map_sectors; j++) {
 					fsi->vol_amap[j] = NULL;
 					ret = read_sect(sb, sector+j, &(fsi->vol_amap[j]), 1);
@@ -1102,6 +1130,8 @@ s32 load_alloc_bmp(struct super_block *sb)
 					}
 				}
 
+				build_alloc_bmp_index(sb);
+
 				fsi->pbr_bh = NULL;
 				return 0;
 			}
@@ -1127,6 +1157,8 @@ void free_alloc_bmp(struct super_block *sb)
 	/* kfree(NULL) is safe */
 	kfree(fsi->vol_amap);
 	fsi->vol_amap = NULL;
+	kfree(fsi->vol_amap_free);
+	fsi->vol_amap_free = NULL;
 }
 
 /* WARN :
@@ -1143,6 +1175,9 @@ static s32 set_alloc_bitmap(struct super_block *sb, u32 clu)
 	b = clu & (u32)((sb->s_blocksize << 3) - 1);
 
 	sector = CLUS_TO_SECT(fsi, fsi->map_clu) + i;
+	if (fsi->vol_amap_free &&
+	    !test_bit(b, (unsigned long *)(fsi->vol_amap[i]->b_data)))
+		fsi->vol_amap_free[i]--;
 	bitmap_set((unsigned long *)(fsi->vol_amap[i]->b_data), b, 1);
 
 	return write_sect(sb, sector, fsi->vol_amap[i], 0);
@@ -1166,6 +1201,9 @@ static s32 clr_alloc_bitmap(struct super_block *sb, u32 clu)
 
 	sector = CLUS_TO_SECT(fsi, fsi->map_clu) + i;
 
+	if (fsi->vol_amap_free &&
+	    test_bit(b, (unsigned long *)(fsi->vol_amap[i]->b_data)))
+		fsi->vol_amap_free[i]++;
 	bitmap_clear((unsigned long *)(fsi->vol_amap[i]->b_data), b, 1);
 
 	ret = write_sect(sb, sector, fsi->vol_amap[i], 0);
@@ -1205,6 +1243,18 @@ static u32 test_alloc_bitmap(struct super_block *sb, u32 clu)
 	map_b = (clu >> 3) & (u32)(sb->s_blocksize - 1);
 
 	for (i = 2; i < fsi->num_clusters; i += 8) {
+		if (!map_b && fsi->vol_amap_free && !fsi->vol_amap_free[map_i]) {
+			/* nothing free in this bitmap sector, step over it */
+			clu_base += ((u32)sb->s_blocksize << 3);
+			i += ((u32)sb->s_blocksize << 3) - 8;
+			clu_mask = 0;
+			if ((++map_i) >= fsi->map_sectors) {
+				clu_base = 2;
+				map_i = 0;
+			}
+			continue;
+		}
+
 		k = *(((u8 *) fsi->vol_amap[map_i]->b_data) + map_b);
 		if (clu_mask > 0) {
 			k |= clu_mask;
@@ -1462,6 +1512,13 @@ static s32 exfat_count_used_clusters(struct super_block *sb, u32 *ret_count)
 	FS_INFO_T *fsi = &(SDFAT_SB(sb)->fsi);
 	u32 total_clus = fsi->num_clusters - 2;
 
+	if (fsi->vol_amap_free) {
+		for (i = 0; i < fsi->map_sectors; i++)
+			count += fsi->vol_amap_free[i];
+		*ret_count = total_clus - min(count, total_clus);
+		return 0;
+	}
+
 	map_i = map_b = 0;
 
 	for (i = 0; i < total_clus; i += 8) {
@@ -3177,6 +3177,65 @@ static const struct inode_operations sdfat_file_inode_operations = {
 #define BMAP_ADD_BLOCK				1
 #define BMAP_ADD_CLUSTER			2
 #define BLOCK_ADDED(bmap_ops)	(bmap_ops)
+/*
+ * With delayed allocation, clusters are reserved at write time and only
+ * allocated at writeback, one at a time as pages get there. Allocate the
+ * ones reserved past the cluster being written back along with it, as a
+ * single run, so a file written in large chunks gets contiguous clusters
+ * and one FAT chain update instead of being interleaved with others.
+ * Returns how many clusters past @clu_offset to allocate.
+ */
+static u32 sdfat_da_alloc_ahead(struct inode *inode, u32 clu_offset)
+{
+	struct super_block *sb = inode->i_sb;
+	FS_INFO_T *fsi = &(SDFAT_SB(sb)->fsi);
+	struct sdfat_inode_info *ei = SDFAT_I(inode);
+	u32 num_alloced = 0, num_reserved;
+
+	if (!(SDFAT_SB(sb)->options.improved_allocation & SDFAT_ALLOC_DELAY))
+		return 0;
+
+	/* only when appending, the same count fscore_map_clus() uses */
+	if (ei->i_size_ondisk > 0)
+		num_alloced = (u32)((ei->i_size_ondisk - 1) >> fsi->cluster_size_bits) + 1;
+	if (clu_offset != num_alloced || ei->i_size_aligned <= 0)
+		return 0;
+
+	num_reserved = (u32)(inode->i_blocks >>
+			(fsi->cluster_size_bits - sb->s_blocksize_bits));
+	num_reserved = min(num_reserved,
+		(u32)((ei->i_size_aligned - 1) >> fsi->cluster_size_bits) + 1);
+	if (num_reserved <= clu_offset + 1)
+		return 0;
+
+	return min_t(u32, num_reserved - clu_offset - 1, SDFAT_DA_MAX_RUN - 1);
+}
+
+static int sdfat_da_map_run(struct inode *inode, u32 clu_offset, u32 *clu)
+{
+	struct sdfat_sb_info *sbi = SDFAT_SB(inode->i_sb);
+	FS_INFO_T *fsi = &(sbi->fsi);
+	struct sdfat_inode_info *ei = SDFAT_I(inode);
+	u32 ahead = sdfat_da_alloc_ahead(inode, clu_offset);
+	loff_t end;
+	int err;
+
+	err = fsapi_map_clus(inode, clu_offset + ahead, clu, 1);
+	if (err)
+		return err;
+
+	sbi->da_alloc_runs++;
+	sbi->da_alloc_clus += ahead + 1;
+	if (!ahead)
+		return 0;
+
+	/* the run is allocated, so truncate frees it and it's not allocated twice */
+	end = (loff_t)(clu_offset + ahead + 1) << fsi->cluster_size_bits;
+	ei->i_size_ondisk = min(end, ei->i_size_aligned);
+
+	return fsapi_map_clus(inode, clu_offset, clu, ALLOC_NOWHERE);
+}
+
 static int sdfat_bmap(struct inode *inode, sector_t sector, sector_t *phys,
 				  unsigned long *mapped_blocks, int *create)
 {
@@ -3225,7 +3284,7 @@ static int sdfat_bmap(struct inode *inode, sector_t sector, sector_t *phys,
 		err = __do_dfr_map_cluster(inode, clu_offset, &cluster);
 	} else {
 		if (*create & BMAP_ADD_CLUSTER)
-			err = fsapi_map_clus(inode, clu_offset, &cluster, 1);
+			err = sdfat_da_map_run(inode, clu_offset, &cluster);
 		else
 			err = fsapi_map_clus(inode, clu_offset, &cluster, ALLOC_NOWHERE);
 	}
@@ -4575,6 +4634,21 @@ static ssize_t fullau_show(struct sdfat_sb_info *sbi, char *buf)
 }
 SDFAT_ATTR(fullau, 0444, fullau_show, NULL);
 
+/* allocations made at writeback and the clusters they got, with DA */
+static ssize_t darun_show(struct sdfat_sb_info *sbi, char *buf)
+{
+	unsigned long runs, clus;
+
+	__lock_super(sbi->host_sb);
+	runs = sbi->da_alloc_runs;
+	clus = sbi->da_alloc_clus;
+	__unlock_super(sbi->host_sb);
+
+	return snprintf(buf, PAGE_SIZE, "runs: %lu\nclusters: %lu\navg: %lu\n",
+			runs, clus, runs ? clus / runs : 0);
+}
+SDFAT_ATTR(darun, 0444, darun_show, NULL);
+
 static struct attribute *sdfat_attrs[] = {
 	&sdfat_attr_type.attr,
 	&sdfat_attr_eio.attr,
@@ -4582,6 +4656,7 @@ static struct attribute *sdfat_attrs[] = {
 	&sdfat_attr_totalau.attr,
 	&sdfat_attr_cleanau.attr,
 	&sdfat_attr_fullau.attr,
+	&sdfat_attr_darun.attr,
 	NULL,
 };
 
@@ -44,6 +44,7 @@
  * sdfat allocator flags
  */
 #define SDFAT_ALLOC_DELAY	(1)    /* Delayed allocation */
+#define SDFAT_DA_MAX_RUN	(256)  /* max # of clusters allocated at once */
 #define SDFAT_ALLOC_SMART	(2)    /* Smart allocation */
 
 /*
@@ -190,6 +191,10 @@ struct sdfat_sb_info {
 	unsigned int stat_n_pages_confused;
 #endif
 	atomic_t stat_n_pages_queued;	/* # of pages in the request queue (approx.) */
+
+	/* delayed allocation runs, protected by s_lock */
+	unsigned long da_alloc_runs;		/* # of allocations at writeback */
+	unsigned long da_alloc_clus;		/* # of clusters they allocated */
 };
 
 /*
@@ -31,6 +31,7 @@
 #include <linux/slab.h>
 #include <linux/string.h>
 #include <linux/buffer_head.h>
+#include <linux/ktime.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -168,10 +169,16 @@ int squashfs_read_data(struct super_block *sb, u64 index, int length,
 	if (compressed) {
 		if (!msblk->stream)
 			goto read_failure;
-		length = squashfs_decompress(msblk, bh, b, offset, length,
-			output);
+		u64 start = ktime_get_ns();
+
+		length = msblk->thread_ops->decompress(msblk, bh, b, offset,
+			length, output);
 		if (length < 0)
 			goto read_failure;
+
+		atomic64_inc(&msblk->decomp_blocks);
+		atomic64_add(length, &msblk->decomp_bytes);
+		atomic64_add(ktime_get_ns() - start, &msblk->decomp_ns);
 	} else {
 		/*
 		 * Block is uncompressed.
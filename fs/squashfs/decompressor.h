@@ -35,6 +35,37 @@ struct squashfs_decompressor {
 	int	supported;
 };
 
+/*
+ * How decompression is parallelised, see decompressor_single.c,
+ * decompressor_multi.c and decompressor_multi_percpu.c
+ */
+struct squashfs_decompressor_thread_ops {
+	void	*(*create)(struct squashfs_sb_info *, void *);
+	void	(*destroy)(struct squashfs_sb_info *);
+	int	(*decompress)(struct squashfs_sb_info *, struct buffer_head **,
+		int, int, int, struct squashfs_page_actor *);
+	int	(*max_decompressors)(void);
+	char	*name;
+};
+
+#if defined(CONFIG_SQUASHFS_DECOMP_SINGLE) || \
+	defined(CONFIG_SQUASHFS_DECOMP_BY_MOUNT)
+extern const struct squashfs_decompressor_thread_ops
+	squashfs_decompressor_single;
+#endif
+
+#if defined(CONFIG_SQUASHFS_DECOMP_MULTI) || \
+	defined(CONFIG_SQUASHFS_DECOMP_BY_MOUNT)
+extern const struct squashfs_decompressor_thread_ops
+	squashfs_decompressor_multi;
+#endif
+
+#if defined(CONFIG_SQUASHFS_DECOMP_MULTI_PERCPU) || \
+	defined(CONFIG_SQUASHFS_DECOMP_BY_MOUNT)
+extern const struct squashfs_decompressor_thread_ops
+	squashfs_decompressor_percpu;
+#endif
+
 static inline void *squashfs_comp_opts(struct squashfs_sb_info *msblk,
 							void *buff, int length)
 {
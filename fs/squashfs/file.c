@@ -47,6 +47,8 @@
 #include <linux/string.h>
 #include <linux/pagemap.h>
 #include <linux/mutex.h>
+#include <linux/module.h>
+#include <linux/workqueue.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -501,7 +503,117 @@ out:
 	return 0;
 }
 
+#ifdef CONFIG_SQUASHFS_READAHEAD_THREADS
+static bool readahead_threads = true;
+module_param(readahead_threads, bool, 0644);
+MODULE_PARM_DESC(readahead_threads, "Decompress readahead blocks in parallel");
+
+static struct workqueue_struct *squashfs_read_wq;
+
+struct squashfs_readahead_work {
+	struct work_struct	work;
+	struct page		*page;
+};
+
+static void squashfs_readahead_worker(struct work_struct *work)
+{
+	struct squashfs_readahead_work *ra = container_of(work,
+		struct squashfs_readahead_work, work);
+
+	squashfs_readpage(NULL, ra->page);
+	page_cache_release(ra->page);
+	kfree(ra);
+}
+
+/*
+ * Readahead is done a datablock at a time.  Only one page of each block in
+ * the window is added to the page cache: reading it fills the rest of the
+ * block, the other pages being grabbed from the page cache as the block is
+ * decompressed, so the pages of the window not first in their block are
+ * released here.  The blocks past the first are handed to the workers to
+ * read concurrently, while the caller reads the first.
+ */
+static int squashfs_readpages(struct file *file, struct address_space *mapping,
+	struct list_head *pages, unsigned nr_pages)
+{
+	struct inode *inode = mapping->host;
+	struct squashfs_sb_info *msblk = inode->i_sb->s_fs_info;
+	int shift = msblk->block_log - PAGE_CACHE_SHIFT;
+	bool async = READ_ONCE(readahead_threads) &&
+		msblk->thread_ops->max_decompressors() > 1;
+	pgoff_t last = ULONG_MAX;
+	struct page *first = NULL;
+	unsigned int i;
+
+	for (i = 0; i < nr_pages; i++) {
+		struct page *page = list_entry(pages->prev, struct page, lru);
+		struct squashfs_readahead_work *ra;
+		pgoff_t block = page->index >> shift;
+
+		list_del(&page->lru);
+		if (block == last ||
+		    add_to_page_cache_lru(page, mapping, page->index,
+				mapping_gfp_constraint(mapping, GFP_KERNEL))) {
+			page_cache_release(page);
+			last = block;
+			continue;
+		}
+		last = block;
+		atomic64_inc(&msblk->readahead_blocks);
+
+		if (async && !first) {
+			first = page;
+			continue;
+		}
+
+		ra = async ? kmalloc(sizeof(*ra), GFP_NOFS) : NULL;
+		if (!ra) {
+			squashfs_readpage(file, page);
+			page_cache_release(page);
+			continue;
+		}
+
+		INIT_WORK(&ra->work, squashfs_readahead_worker);
+		ra->page = page;
+		queue_work(squashfs_read_wq, &ra->work);
+		atomic64_inc(&msblk->readahead_async);
+	}
+
+	if (first) {
+		squashfs_readpage(file, first);
+		page_cache_release(first);
+	}
+
+	return 0;
+}
+
+int __init squashfs_readahead_init(void)
+{
+	squashfs_read_wq = alloc_workqueue("squashfs_read",
+		WQ_UNBOUND | WQ_HIGHPRI | WQ_MEM_RECLAIM, 0);
+
+	return squashfs_read_wq ? 0 : -ENOMEM;
+}
+
+void squashfs_readahead_destroy(void)
+{
+	destroy_workqueue(squashfs_read_wq);
+}
+#else
+int __init squashfs_readahead_init(void)
+{
+	return 0;
+}
+
+void squashfs_readahead_destroy(void)
+{
+}
+#endif
+
 
 const struct address_space_operations squashfs_aops = {
-	.readpage = squashfs_readpage
+	.readpage = squashfs_readpage,
+#ifdef CONFIG_SQUASHFS_READAHEAD_THREADS
+	.readpages = squashfs_readpages
+#endif
 };
@@ -55,6 +55,7 @@ struct squashfs_cache_entry {
 
 struct squashfs_sb_info {
 	const struct squashfs_decompressor	*decompressor;
+	const struct squashfs_decompressor_thread_ops	*thread_ops;
 	int					devblksize;
 	int					devblksize_log2;
 	struct squashfs_cache			*block_cache;
@@ -78,5 +79,11 @@ struct squashfs_sb_info {
 	unsigned int				fragments;
 	int					xattr_ids;
 	unsigned int				ids;
+	/* decompression statistics, shown in /proc/<pid>/mountstats */
+	atomic64_t				decomp_blocks;
+	atomic64_t				decomp_bytes;
+	atomic64_t				decomp_ns;
+	atomic64_t				readahead_blocks;
+	atomic64_t				readahead_async;
 };
 #endif
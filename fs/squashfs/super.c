@@ -38,6 +38,8 @@
 #include <linux/module.h>
 #include <linux/magic.h>
 #include <linux/xattr.h>
+#include <linux/parser.h>
+#include <linux/seq_file.h>
 
 #include "squashfs_fs.h"
 #include "squashfs_fs_sb.h"
@@ -49,6 +51,69 @@
 static struct file_system_type squashfs_fs_type;
 static const struct super_operations squashfs_super_ops;
 
+#if defined(CONFIG_SQUASHFS_DECOMP_SINGLE)
+#define SQUASHFS_DEFAULT_THREAD_OPS	(&squashfs_decompressor_single)
+#elif defined(CONFIG_SQUASHFS_DECOMP_MULTI)
+#define SQUASHFS_DEFAULT_THREAD_OPS	(&squashfs_decompressor_multi)
+#else
+#define SQUASHFS_DEFAULT_THREAD_OPS	(&squashfs_decompressor_percpu)
+#endif
+
+#ifdef CONFIG_SQUASHFS_DECOMP_BY_MOUNT
+enum { Opt_threads, Opt_err };
+
+static const match_table_t squashfs_tokens = {
+	{Opt_threads, "threads=%s"},
+	{Opt_err, NULL}
+};
+
+/*
+ * Pick the decompressor parallelisation from the "threads=single",
+ * "threads=multi" or "threads=percpu" mount option.  Squashfs has always
+ * ignored mount options, other options are ignored still.
+ */
+static int squashfs_parse_options(struct squashfs_sb_info *msblk, char *data)
+{
+	substring_t args[MAX_OPT_ARGS];
+	char *p;
+
+	while ((p = strsep(&data, ",")) != NULL) {
+		if (!*p)
+			continue;
+
+		if (match_token(p, squashfs_tokens, args) != Opt_threads)
+			continue;
+
+		if (!match_strlcmp(&args[0], "single"))
+			msblk->thread_ops = &squashfs_decompressor_single;
+		else if (!match_strlcmp(&args[0], "multi"))
+			msblk->thread_ops = &squashfs_decompressor_multi;
+		else if (!match_strlcmp(&args[0], "percpu"))
+			msblk->thread_ops = &squashfs_decompressor_percpu;
+		else {
+			ERROR("Invalid threads option \"%s\"\n", p);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static int squashfs_show_options(struct seq_file *seq, struct dentry *root)
+{
+	struct squashfs_sb_info *msblk = root->d_sb->s_fs_info;
+
+	seq_printf(seq, ",threads=%s", msblk->thread_ops->name);
+	return 0;
+}
+#else
+static inline int squashfs_parse_options(struct squashfs_sb_info *msblk,
+	char *data)
+{
+	return 0;
+}
+#endif
+
 static const struct squashfs_decompressor *supported_squashfs_filesystem(short
 	major, short minor, short id)
 {
@@ -102,6 +167,14 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 
 	mutex_init(&msblk->meta_index_mutex);
 
+	msblk->thread_ops = SQUASHFS_DEFAULT_THREAD_OPS;
+	err = squashfs_parse_options(msblk, data);
+	if (err) {
+		kfree(msblk);
+		sb->s_fs_info = NULL;
+		return err;
+	}
+
 	/*
 	 * msblk->bytes_used is checked in squashfs_read_table to ensure reads
 	 * are not beyond filesystem end.  But as we're using
@@ -210,7 +283,7 @@ static int squashfs_fill_super(struct super_block *sb, void *data, int silent)
 
 	/* Allocate read_page block */
 	msblk->read_page = squashfs_cache_init("data",
-		squashfs_max_decompressors(), msblk->block_size);
+		msblk->thread_ops->max_decompressors(), msblk->block_size);
 	if (msblk->read_page == NULL) {
 		ERROR("Failed to allocate read_page block\n");
 		goto failed_mount;
@@ -339,7 +412,7 @@ failed_mount:
 	squashfs_cache_delete(msblk->block_cache);
 	squashfs_cache_delete(msblk->fragment_cache);
 	squashfs_cache_delete(msblk->read_page);
-	squashfs_decompressor_destroy(msblk);
+	msblk->thread_ops->destroy(msblk);
 	kfree(msblk->inode_lookup_table);
 	kfree(msblk->fragment_index);
 	kfree(msblk->id_table);
@@ -371,6 +444,27 @@ static int squashfs_statfs(struct dentry *dentry, struct kstatfs *buf)
 }
 
 
+/*
+ * Decompression throughput, and how much of the readahead was spread over
+ * the other cpus
+ */
+static int squashfs_show_stats(struct seq_file *seq, struct dentry *root)
+{
+	struct squashfs_sb_info *msblk = root->d_sb->s_fs_info;
+	u64 bytes = atomic64_read(&msblk->decomp_bytes);
+	u64 ns = atomic64_read(&msblk->decomp_ns);
+
+	seq_printf(seq, " threads=%s decomp_blocks=%lld decomp_bytes=%llu"
+		" decomp_ns=%llu decomp_kbps=%llu readahead_blocks=%lld"
+		" readahead_async=%lld", msblk->thread_ops->name,
+		(long long) atomic64_read(&msblk->decomp_blocks), bytes, ns,
+		ns ? div64_u64(bytes * (NSEC_PER_SEC >> 10), ns) : 0,
+		(long long) atomic64_read(&msblk->readahead_blocks),
+		(long long) atomic64_read(&msblk->readahead_async));
+	return 0;
+}
+
+
 static int squashfs_remount(struct super_block *sb, int *flags, char *data)
 {
 	sync_filesystem(sb);
@@ -386,7 +480,7 @@ static void squashfs_put_super(struct super_block *sb)
 		squashfs_cache_delete(sbi->block_cache);
 		squashfs_cache_delete(sbi->fragment_cache);
 		squashfs_cache_delete(sbi->read_page);
-		squashfs_decompressor_destroy(sbi);
+		sbi->thread_ops->destroy(sbi);
 		kfree(sbi->id_table);
 		kfree(sbi->fragment_index);
 		kfree(sbi->meta_index);
@@ -444,8 +538,15 @@ static int __init init_squashfs_fs(void)
 	if (err)
 		return err;
 
+	err = squashfs_readahead_init();
+	if (err) {
+		destroy_inodecache();
+		return err;
+	}
+
 	err = register_filesystem(&squashfs_fs_type);
 	if (err) {
+		squashfs_readahead_destroy();
 		destroy_inodecache();
 		return err;
 	}
@@ -459,6 +560,7 @@ static int __init init_squashfs_fs(void)
 static void __exit exit_squashfs_fs(void)
 {
 	unregister_filesystem(&squashfs_fs_type);
+	squashfs_readahead_destroy();
 	destroy_inodecache();
 }
 
@@ -498,7 +600,11 @@ static const struct super_operations squashfs_super_ops = {
 	.destroy_inode = squashfs_destroy_inode,
 	.statfs = squashfs_statfs,
 	.put_super = squashfs_put_super,
-	.remount_fs = squashfs_remount
+	.remount_fs = squashfs_remount,
+#ifdef CONFIG_SQUASHFS_DECOMP_BY_MOUNT
+	.show_options = squashfs_show_options,
+#endif
+	.show_stats = squashfs_show_stats
 };
 
 module_init(init_squashfs_fs);
@@ -1,6 +1,7 @@
 #ifndef __LINUX_BACKING_DEV_DEFS_H
 #define __LINUX_BACKING_DEV_DEFS_H
 
+#include <linux/average.h>
 #include <linux/list.h>
 #include <linux/radix-tree.h>
 #include <linux/rbtree.h>
@@ -15,6 +16,23 @@ struct page;
 struct device;
 struct dentry;
 
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+DECLARE_EWMA(bdi_ra, 16, 8)
+
+/*
+ * Read completion samples, split into small and large requests, from
+ * which the fixed per request overhead and the bandwidth of the device
+ * are estimated.
+ */
+struct bdi_ra_model {
+	spinlock_t lock;
+	struct ewma_bdi_ra small_kb, small_us;
+	struct ewma_bdi_ra large_kb, large_us;
+	unsigned int nr_small, nr_large;
+	unsigned int nr_samples;
+};
+#endif
+
 /*
  * Bits in bdi_writeback.state
  */
@@ -137,6 +155,13 @@ struct backing_dev_info {
 	struct list_head bdi_list;
 	unsigned long ra_pages;	/* max readahead in PAGE_CACHE_SIZE units */
 	unsigned long io_pages;	/* max allowed IO size */
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+	unsigned int ra_adaptive;	/* size windows from ra_model */
+	unsigned int ra_target;		/* % of the bandwidth to aim for */
+	unsigned long ra_init_pages;	/* chosen windows, 0 until known */
+	unsigned long ra_max_pages;
+	struct bdi_ra_model ra_model;
+#endif
 	unsigned int capabilities; /* Device capabilities */
 	congested_fn *congested_fn; /* Function pointer if device is md/dm */
 	void *congested_data;	/* Pointer to aux data for congested func */
@@ -19,6 +19,9 @@
 #include <linux/slab.h>
 
 int __must_check bdi_init(struct backing_dev_info *bdi);
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+void bdi_ra_sample(struct backing_dev_info *bdi, unsigned int bytes, u64 ns);
+#endif
 void bdi_exit(struct backing_dev_info *bdi);
 
 __printf(3, 4)
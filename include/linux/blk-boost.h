@@ -0,0 +1,49 @@
+#ifndef _LINUX_BLK_BOOST_H
+#define _LINUX_BLK_BOOST_H
+
+#include <linux/compiler.h>
+#include <linux/notifier.h>
+
+struct bio;
+
+/* what the foreground is doing while its I/O is boosted */
+enum blk_boost_reason {
+	BLK_BOOST_APP_LAUNCH,
+	BLK_BOOST_SCREEN_ON,
+	BLK_BOOST_NR_REASONS,
+};
+
+#ifdef CONFIG_BLK_BOOST
+extern unsigned long blk_boost_reasons;
+
+extern void blk_boost_start(enum blk_boost_reason reason);
+extern void blk_boost_stop(enum blk_boost_reason reason);
+extern void blk_boost_kick(enum blk_boost_reason reason, unsigned int ms);
+extern void __blk_boost_bio(struct bio *bio);
+extern bool blk_boost_screen_off(void);
+
+/* called with 1 when a boost starts and 0 when it ends, in atomic context */
+extern int blk_boost_register_notifier(struct notifier_block *nb);
+extern int blk_boost_unregister_notifier(struct notifier_block *nb);
+
+static inline bool blk_boost_active(void)
+{
+	return READ_ONCE(blk_boost_reasons) != 0;
+}
+
+static inline void blk_boost_bio(struct bio *bio)
+{
+	if (blk_boost_active())
+		__blk_boost_bio(bio);
+}
+#else
+static inline void blk_boost_start(enum blk_boost_reason reason) { }
+static inline void blk_boost_stop(enum blk_boost_reason reason) { }
+static inline void blk_boost_kick(enum blk_boost_reason reason,
+				  unsigned int ms) { }
+static inline bool blk_boost_active(void) { return false; }
+static inline void blk_boost_bio(struct bio *bio) { }
+static inline bool blk_boost_screen_off(void) { return false; }
+#endif
+
+#endif /* _LINUX_BLK_BOOST_H */
@@ -62,6 +62,8 @@ struct blk_mq_hw_ctx {
 
 	unsigned long		poll_invoked;
 	unsigned long		poll_success;
+	unsigned long		poll_sleep;	/* hybrid sleeps before spinning */
+	unsigned long		poll_irq;	/* polls left to the interrupt */
 };
 
 struct blk_mq_tag_set {
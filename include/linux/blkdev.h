@@ -48,7 +48,7 @@ struct pr_ops;
  * Maximum number of blkcg policies allowed to be registered concurrently.
  * Defined here to simplify include dependency.
  */
-#define BLKCG_MAX_POLS		2
+#define BLKCG_MAX_POLS		4
 
 struct request;
 typedef void (rq_end_io_fn)(struct request *, int);
@@ -165,6 +165,18 @@ struct request {
 	struct gendisk *rq_disk;
 	struct hd_struct *part;
 	unsigned long start_time;
+	u64 poll_start_ns;		/* issue time, on polled blk-mq queues */
+#ifdef CONFIG_BLK_LATENCY_HIST
+	/* stage timestamps for the queue's latency_hist, 0 when unused */
+	u64 lat_alloc_ns;
+	u64 lat_insert_ns;
+	u64 lat_dispatch_ns;
+	u64 lat_issue_ns;
+#endif
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+	u64 ra_start_ns;		/* read sampled for bdi->ra_model */
+	unsigned int ra_bytes;
+#endif
 #ifdef CONFIG_BLK_CGROUP
 	struct request_list *rl;		/* rl this rq is alloced from */
 	unsigned long long start_time_ns;
@@ -489,6 +501,23 @@ struct request_queue {
 	struct bio_set		*bio_split;
 
 	bool			mq_sysfs_init_done;
+
+	/*
+	 * Hybrid polling: sleep for poll_nsec before spinning, or for half
+	 * the mean read completion time if 0, or not at all if -1
+	 */
+	int			poll_nsec;
+	u64			poll_mean_ns;
+
+#ifdef CONFIG_BLK_LATENCY_HIST
+	struct blk_lat_hist	*lat_hist;
+#endif
+
+#ifdef CONFIG_SMP
+	/* completions steered to the submitter's cluster, and IPIs sent */
+	atomic_long_t		nr_cluster_comps;
+	atomic_long_t		nr_cluster_ipis;
+#endif
 };
 
 #define QUEUE_FLAG_QUEUED	1	/* uses generic tag queueing */
@@ -514,6 +543,7 @@ struct request_queue {
 #define QUEUE_FLAG_INIT_DONE   20	/* queue is initialized */
 #define QUEUE_FLAG_NO_SG_MERGE 21	/* don't attempt to merge SG segments*/
 #define QUEUE_FLAG_POLL	       22	/* IO polling enabled if set */
+#define QUEUE_FLAG_SAME_CLUSTER 23	/* complete on submitter's cluster */
 
 #define QUEUE_FLAG_DEFAULT	((1 << QUEUE_FLAG_STACKABLE)	|	\
 				 (1 << QUEUE_FLAG_SAME_COMP)	|	\
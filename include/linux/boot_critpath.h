@@ -0,0 +1,41 @@
+#ifndef _LINUX_BOOT_CRITPATH_H
+#define _LINUX_BOOT_CRITPATH_H
+
+#include <linux/init.h>
+#include <linux/types.h>
+#include <linux/ktime.h>
+
+struct device;
+struct device_driver;
+
+#ifdef CONFIG_BOOT_CRITPATH
+/*
+ * Boot critical path recording: initcalls, driver probes and the async
+ * barriers between initcall levels are timed until userspace is started,
+ * then /sys/kernel/debug/boot_critpath walks them back from the end of
+ * boot to show what boot actually waited on.
+ */
+extern bool boot_critpath_recording;
+
+static inline u64 boot_critpath_start(void)
+{
+	return boot_critpath_recording ? ktime_get_ns() : 0;
+}
+
+extern void boot_critpath_set_level(int level);
+extern void boot_critpath_initcall(initcall_t fn, u64 start);
+extern void boot_critpath_probe(struct device *dev, struct device_driver *drv,
+				u64 start);
+extern void boot_critpath_barrier(int level, u64 start);
+extern void boot_critpath_done(void);
+#else
+static inline u64 boot_critpath_start(void) { return 0; }
+static inline void boot_critpath_set_level(int level) { }
+static inline void boot_critpath_initcall(initcall_t fn, u64 start) { }
+static inline void boot_critpath_probe(struct device *dev,
+				       struct device_driver *drv, u64 start) { }
+static inline void boot_critpath_barrier(int level, u64 start) { }
+static inline void boot_critpath_done(void) { }
+#endif
+
+#endif /* _LINUX_BOOT_CRITPATH_H */
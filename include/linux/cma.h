@@ -44,4 +44,7 @@ static inline int cma_init_reserved_mem(phys_addr_t base, phys_addr_t size,
 }
 extern struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align);
 extern bool cma_release(struct cma *cma, const struct page *pages, unsigned int count);
+extern void cma_set_drain_target(struct cma *cma, unsigned long pages);
+extern unsigned long cma_get_drain_target(struct cma *cma);
+extern void cma_drain_kick(struct cma *cma);
 #endif
@@ -77,6 +77,11 @@ struct cpufreq_cooling_device {
 	int *asv_coeff;
 	unsigned int var_volt_size;
 	unsigned int var_temp_size;
+	/* capacity of a cpu at the top frequency, for budget allocation */
+	unsigned long capacity;
+	u32 requested_power;
+	u32 granted_power;
+	unsigned long budget_state;
 };
 
 #ifdef CONFIG_CPU_THERMAL
@@ -131,6 +136,7 @@ of_cpufreq_power_cooling_register(struct device_node *np,
 void cpufreq_cooling_unregister(struct thermal_cooling_device *cdev);
 
 unsigned long cpufreq_cooling_get_level(unsigned int cpu, unsigned int freq);
+u32 cpufreq_cooling_power_budget(unsigned int *bias);
 #else /* !CONFIG_CPU_THERMAL */
 static inline struct thermal_cooling_device *
 cpufreq_cooling_register(const struct cpumask *clip_cpus)
@@ -170,6 +176,12 @@ unsigned long cpufreq_cooling_get_level(unsigned int cpu, unsigned int freq)
 {
 	return THERMAL_CSTATE_INVALID;
 }
+static inline u32 cpufreq_cooling_power_budget(unsigned int *bias)
+{
+	if (bias)
+		*bias = 0;
+	return 0;
+}
 #endif	/* CONFIG_CPU_THERMAL */
 
 #endif /* __CPU_COOLING_H__ */
@@ -280,6 +280,18 @@ struct cpufreq_driver {
 	int		(*target_intermediate)(struct cpufreq_policy *policy,
 					       unsigned int index);
 
+	/*
+	 * Only for drivers that can switch frequency from any context
+	 * without sleeping, like a DVFS request posted to a power management
+	 * firmware without waiting for its response. Called with target_freq
+	 * within the policy limits; returns the frequency set or
+	 * CPUFREQ_ENTRY_INVALID. No notifications are sent for it. This
+	 * runs in scheduler context with a raw spinlock held, so it must not
+	 * take a spinlock_t either on PREEMPT_RT_FULL.
+	 */
+	unsigned int	(*fast_switch)(struct cpufreq_policy *policy,
+				       unsigned int target_freq);
+
 	/* should be defined, if possible */
 	unsigned int	(*get)(unsigned int cpu);
 
@@ -511,6 +523,10 @@ int __cpufreq_driver_target(struct cpufreq_policy *policy,
 				   unsigned int relation);
 unsigned int cpufreq_driver_resolve_freq(struct cpufreq_policy *policy,
                                         unsigned int target_freq);
+unsigned int cpufreq_driver_fast_switch(struct cpufreq_policy *policy,
+					unsigned int target_freq);
+void cpufreq_enable_fast_switch(struct cpufreq_policy *policy);
+void cpufreq_disable_fast_switch(struct cpufreq_policy *policy);
 int cpufreq_register_governor(struct cpufreq_governor *governor);
 void cpufreq_unregister_governor(struct cpufreq_governor *governor);
 
@@ -33,6 +33,10 @@ struct cpuidle_state_usage {
 	unsigned long long	disable;
 	unsigned long long	usage;
 	unsigned long long	time; /* in US */
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	unsigned long long	hint_veto; /* skipped for an expected wakeup */
+	unsigned long long	hint_miss; /* ... that did not come in time */
+#endif
 };
 
 struct cpuidle_state {
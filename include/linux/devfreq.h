@@ -22,6 +22,7 @@
 #define DEVFREQ_NAME_LEN 16
 
 struct devfreq;
+struct memory_state_update_block;
 
 /**
  * struct devfreq_dev_status - Data given from devfreq user device to
@@ -230,7 +231,7 @@ static inline int devfreq_update_stats(struct devfreq *df)
 	return df->profile->get_dev_status(df->dev.parent, &df->last_status);
 }
 #if IS_ENABLED(CONFIG_DEVFREQ_GOV_SIMPLE_ONDEMAND) || IS_ENABLED(CONFIG_DEVFREQ_GOV_SIMPLE_USAGE)\
-	|| IS_ENABLED(CONFIG_DEVFREQ_GOV_SIMPLE_INTERACTIVE)
+	|| IS_ENABLED(CONFIG_DEVFREQ_GOV_SIMPLE_INTERACTIVE) || IS_ENABLED(CONFIG_DEVFREQ_GOV_PPMU_BW)
 struct devfreq_notifier_block {
 	struct notifier_block nb;
 	struct devfreq *df;
@@ -346,6 +347,63 @@ struct devfreq_simple_interactive_data {
 };
 #endif
 
+#if IS_ENABLED(CONFIG_DEVFREQ_GOV_PPMU_BW)
+struct devfreq_event_dev;
+
+/**
+ * struct devfreq_ppmu_bw_map - calibrated bandwidth of a bus frequency
+ * @freq:	bus frequency in kHz
+ * @bw:		bandwidth in MB/s measured to be sustained at @freq
+ */
+struct devfreq_ppmu_bw_map {
+	unsigned int freq;
+	unsigned int bw;
+};
+
+/**
+ * struct devfreq_ppmu_bw_data - void *data fed to struct devfreq
+ *	and devfreq_add_device
+ * @edev:	PPMU read/write data count events, one per bus master
+ * @num_edev:	number of @edev
+ * @beat_bytes:	bytes transferred per PPMU data count
+ * @map:	calibrated bandwidth of each frequency, in ascending order. If
+ *		NULL, the bus is taken to move @beat_bytes per cycle.
+ * @map_size:	number of entries in @map
+ * @headroom:	bandwidth in % to provision above the measured demand.
+ *		If 0, 25 is used.
+ * @pm_qos_class:	PM QoS class of the client floor votes, 0 for none
+ * @pm_qos_class_max:	PM QoS class of the ceiling votes, 0 for none
+ * @memory_state:	report the frequency and the bandwidth of each master
+ *		to memory_state_time, for the DRAM bus
+ *
+ * The fields below are maintained by the governor.
+ */
+struct devfreq_ppmu_bw_data {
+	struct devfreq_event_dev **edev;
+	unsigned int num_edev;
+	unsigned int beat_bytes;
+	const struct devfreq_ppmu_bw_map *map;
+	unsigned int map_size;
+	unsigned int headroom;
+	int pm_qos_class;
+	int pm_qos_class_max;
+	bool memory_state;
+	struct devfreq_notifier_block nb;
+	struct devfreq_notifier_block nb_max;
+
+	ktime_t last_sample;
+	ktime_t last_stat;
+	unsigned long *master_bw;
+	unsigned long bw;
+	unsigned long target_bw;
+	unsigned int efficiency;
+	u64 *time_in_state;
+	struct memory_state_update_block *ms_freq;
+	struct memory_state_update_block **ms_bw;
+	unsigned long ms_last_freq;
+};
+#endif
+
 /* Caution: devfreq->lock must be locked before calling update_devfreq */
 extern int update_devfreq(struct devfreq *devfreq);
 
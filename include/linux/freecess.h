@@ -16,7 +16,8 @@
 #define MOD_SIG                2
 #define MOD_PKG                3
 #define MOD_CFB                4
-#define MOD_END                5
+#define MOD_FREEZER            5
+#define MOD_END                6
 #define INTERFACETOKEN_BUFF_SIZE 100
 
 typedef enum {
@@ -30,6 +31,14 @@ typedef struct {
 	uid_t uid;
 }pkg_info_t;
 
+/*
+ * MOD_FREEZER: userspace sends target_uid with flag FREEZER_FREEZE or
+ * FREEZER_THAW, and gets back in flag the number of processes moved, or
+ * a negative errno.
+ */
+#define FREEZER_THAW           0
+#define FREEZER_FREEZE         1
+
 
 /*
  *  Freecess version management
@@ -83,6 +92,9 @@ int sig_report(struct task_struct *p);
 int binder_report(struct task_struct *p, int code, const char *str, int flag);
 int pkg_report(int target_uid);
 int cfb_report(int target_uid, const char *reason);
+int freecess_freeze_uid(uid_t uid);
+int freecess_thaw_uid(uid_t uid);
+int freecess_binder_thaw(struct task_struct *p);
 int register_kfreecess_hook(int mod, freecess_hook hook);
 int unregister_kfreecess_hook(int mod);
 int thread_group_is_frozen(struct task_struct* task);
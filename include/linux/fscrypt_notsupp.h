@@ -227,4 +227,9 @@ static inline void *fscrypt_get_symlink(struct inode *inode,
 	return ERR_PTR(-EOPNOTSUPP);
 }
 
+static inline bool fscrypt_inline_encrypted(const struct inode *inode)
+{
+	return false;
+}
+
 #endif	/* _LINUX_FSCRYPT_NOTSUPP_H */
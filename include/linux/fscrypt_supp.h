@@ -199,4 +199,37 @@ extern int __fscrypt_encrypt_symlink(struct inode *inode, const char *target,
 extern void *fscrypt_get_symlink(struct inode *inode, const void *caddr,
 				       unsigned int max_size);
 
+/* inline.c */
+struct fscrypt_inline_ops {
+	const char *name;
+	/* 0 if the storage will en/decrypt @mapping's pages with @key */
+	int (*setup_key)(struct address_space *mapping, u8 mode,
+			 const u8 *key, unsigned int keysize);
+	void (*clear_key)(struct address_space *mapping);
+};
+
+#ifdef CONFIG_FS_ENCRYPTION_INLINE_CRYPT
+extern int fscrypt_register_inline_crypt(const struct fscrypt_inline_ops *ops);
+
+/*
+ * Pages of such a file go to the storage as they are, without bounce
+ * pages, and they need no decryption after read.
+ */
+static inline bool fscrypt_inline_encrypted(const struct inode *inode)
+{
+	return inode->i_mapping->private_enc_mode != 0;
+}
+#else
+static inline int fscrypt_register_inline_crypt(
+				const struct fscrypt_inline_ops *ops)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline bool fscrypt_inline_encrypted(const struct inode *inode)
+{
+	return false;
+}
+#endif
+
 #endif	/* _LINUX_FSCRYPT_SUPP_H */
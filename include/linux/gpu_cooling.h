@@ -136,6 +136,7 @@ extern int gpu_dvfs_get_voltage(int clock);
 extern int gpu_dvfs_get_step(void);
 extern int gpu_dvfs_get_cur_clock(void);
 extern int gpu_dvfs_get_utilization(void);
+extern int gpu_dvfs_get_busy_power(int clock, u32 *power);
 extern int gpu_dvfs_get_max_freq(void);
 #else
 static inline int gpu_dvfs_get_clock(int level) { return 0; }
@@ -143,6 +144,7 @@ static inline int gpu_dvfs_get_voltage(int clock) { return 0; }
 static inline int gpu_dvfs_get_step(void) { return 0; }
 static inline int gpu_dvfs_get_cur_clock(void) { return 0; }
 static inline int gpu_dvfs_get_utilization(void) { return 0; }
+static inline int gpu_dvfs_get_busy_power(int clock, u32 *power) { return -ENODEV; }
 static inline int gpu_dvfs_get_max_freq(void) { return 0; }
 #endif
 #endif /* __GPU_COOLING_H__ */
@@ -227,6 +227,17 @@ alloc_zeroed_user_highpage_movable(struct vm_area_struct *vma,
 	return __alloc_zeroed_user_highpage(__GFP_MOVABLE, vma, vaddr);
 }
 
+#ifndef __HAVE_ARCH_CLEAR_PAGES
+/* @to must be a directly mapped range of @nr pages */
+static inline void clear_pages(void *to, unsigned long nr)
+{
+	while (nr--) {
+		clear_page(to);
+		to += PAGE_SIZE;
+	}
+}
+#endif
+
 static inline void clear_highpage(struct page *page)
 {
 	void *kaddr = kmap_atomic(page);
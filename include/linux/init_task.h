@@ -204,6 +204,13 @@ extern struct task_group root_task_group;
 # define INIT_NUMA_BALANCING(tsk)
 #endif
 
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_TASK_INDEX
+# define INIT_LMK_INDEX(tsk)						\
+	.lmk_node	= LIST_HEAD_INIT(tsk.lmk_node),
+#else
+# define INIT_LMK_INDEX(tsk)
+#endif
+
 #ifdef CONFIG_KASAN
 # define INIT_KASAN(tsk)						\
 	.kasan_depth = 1,
@@ -297,6 +304,7 @@ extern struct task_group root_task_group;
 	INIT_VTIME(tsk)							\
 	INIT_NUMA_BALANCING(tsk)					\
 	INIT_KASAN(tsk)							\
+	INIT_LMK_INDEX(tsk)						\
 	INIT_INTEGRITY(tsk)						\
 }
 
@@ -536,4 +536,10 @@ int input_ff_flush(struct input_dev *dev, struct file *file);
 int input_ff_create_memless(struct input_dev *dev, void *data,
 		int (*play_effect)(struct input_dev *, void *, struct ff_effect *));
 
+#if !defined(CONFIG_INPUT_BOOSTER) // Input Booster +
+void input_booster_irq_hint(void);
+#else
+static inline void input_booster_irq_hint(void) { }
+#endif // Input Booster -
+
 #endif
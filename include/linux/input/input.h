@@ -4,6 +4,8 @@
 
 #include <linux/pm_qos.h>
 #include <linux/of.h>
+#include <linux/hrtimer.h>
+#include <linux/notifier.h>
 
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
 #define USE_HMP_SELECTIVE_BOOST
@@ -65,25 +67,21 @@
 #endif
 
 #if defined(CONFIG_ARCH_EXYNOS) //______________________________________________________________________________
-#define SET_BOOSTER  { \
-	set_hmp(_this->param[_this->index].hmp_boost); \
-	set_qos(&_this->cpu_qos, PM_QOS_CLUSTER1_FREQ_MIN/*PM_QOS_CPU_FREQ_MIN*/, _this->param[_this->index].cpu_freq);  \
-	set_qos(&_this->kfc_qos, PM_QOS_CLUSTER0_FREQ_MIN/*PM_QOS_KFC_FREQ_MIN*/, _this->param[_this->index].kfc_freq);  \
-	set_qos(&_this->mif_qos, PM_QOS_BUS_THROUGHPUT, _this->param[_this->index].mif_freq);  \
-	set_qos(&_this->int_qos, PM_QOS_DEVICE_THROUGHPUT, _this->param[_this->index].int_freq);  \
-}
-#define REMOVE_BOOSTER  { \
-	set_hmp(0);  \
-	remove_qos(&_this->cpu_qos);  \
-	remove_qos(&_this->kfc_qos);  \
-	remove_qos(&_this->mif_qos);  \
-	remove_qos(&_this->int_qos);  \
+/* the sum of all boosters, applied by the arbiter only */
+#define SET_BOOSTER(_param_)  { \
+	set_hmp((_param_).hmp_boost); \
+	set_qos(&input_booster_arbiter.cpu_qos, PM_QOS_CLUSTER1_FREQ_MIN/*PM_QOS_CPU_FREQ_MIN*/, (_param_).cpu_freq);  \
+	set_qos(&input_booster_arbiter.kfc_qos, PM_QOS_CLUSTER0_FREQ_MIN/*PM_QOS_KFC_FREQ_MIN*/, (_param_).kfc_freq);  \
+	set_qos(&input_booster_arbiter.mif_qos, PM_QOS_BUS_THROUGHPUT, (_param_).mif_freq);  \
+	set_qos(&input_booster_arbiter.int_qos, PM_QOS_DEVICE_THROUGHPUT, (_param_).int_freq);  \
+	set_qos(&input_booster_arbiter.gpu_qos, PM_QOS_GPU_THROUGHPUT_MIN, (_param_).gpu_freq);  \
 }
 #define PROPERTY_BOOSTER(_device_param_, _dt_param_, _time_)  { \
 	_device_param_.cpu_freq = _dt_param_.cpu_freq; \
 	_device_param_.kfc_freq = _dt_param_.kfc_freq; \
 	_device_param_.mif_freq = _dt_param_.mif_freq; \
 	_device_param_.int_freq = _dt_param_.int_freq; \
+	_device_param_.gpu_freq = _dt_param_.gpu_freq; \
 	_device_param_.time = _dt_param_._time_; \
 	_device_param_.hmp_boost = _dt_param_.hmp_boost; \
 }
@@ -131,12 +129,10 @@
 
 #define INIT_BOOSTER(_DEVICE_) { \
 	_DEVICE_##_booster.input_booster_state = input_booster_idle_state; \
-	INIT_DELAYED_WORK(&_DEVICE_##_booster.input_booster_timeout_work[0], TIMEOUT_FUNC(_DEVICE_)); \
-	INIT_DELAYED_WORK(&_DEVICE_##_booster.input_booster_timeout_work[1], TIMEOUT_FUNC(_DEVICE_)); \
+	_DEVICE_##_booster.source = input_booster_add_source(#_DEVICE_); \
 	INIT_WORK(&_DEVICE_##_booster.input_booster_set_booster_work, SET_BOOSTER_FUNC(_DEVICE_)); \
 	INIT_WORK(&_DEVICE_##_booster.input_booster_reset_booster_work, RESET_BOOSTER_FUNC(_DEVICE_)); \
 	mutex_init(&_DEVICE_##_booster.lock); \
-	_DEVICE_##_booster.change_on_release = 0; \
 	_DEVICE_##_booster.multi_events = 0; \
 	{ \
 		int i; \
@@ -152,47 +148,6 @@
 	} \
 }
 
-#define TIMEOUT_FUNC(_DEVICE_) input_booster_##_DEVICE_##_timeout_work_func
-
-#define DECLARE_TIMEOUT_FUNC(_DEVICE_) \
-static void input_booster_##_DEVICE_##_timeout_work_func(struct work_struct *work)  \
-{ \
-	struct t_input_booster *_this = &_DEVICE_##_booster; \
-	int param_max = sizeof(_this->param)/sizeof(struct t_input_booster_param), temp_index = -1;  \
-	mutex_lock(&_this->lock); \
-	pr_debug("[Input Booster] %s           Timeout : changed  index : %d (%s)\n", HEADGAGE, _this->index , __FUNCTION__); \
-	if(_this->index >= 2 && delayed_work_pending(&_this->input_booster_timeout_work[_this->index-2])) { \
-		mutex_unlock(&_this->lock); \
-		return; \
-	}\
-	if(_this->index == param_max && delayed_work_pending(&_this->input_booster_timeout_work[_this->index-1])) { \
-		temp_index = _this->index; \
-		_this->index = (_this->index) ? _this->index-1 : 0; \
-	} \
-	pr_debug("[Input Booster] %s           Timeout : changed  index : %d (%s)\n", HEADGAGE, _this->index , __FUNCTION__); \
-	if(_this->index < param_max) { \
-		pr_debug("[Input Booster] %s           Timeout : changed  index : %d, time : %d (%s)\n", HEADGAGE, _this->index, _this->param[_this->index].time, __FUNCTION__); \
-		pr_debug("[Input Booster] %s           hmp : %d  cpu : %d (%s)\n", TAILGAGE, _this->param[_this->index].hmp_boost, _this->param[_this->index].cpu_freq, __FUNCTION__); \
-		if(_this->param[(_this->index) ? _this->index-1 : 0].time > 0) { \
-			SET_BOOSTER; \
-			if(_this->change_on_release) { \
-				schedule_delayed_work(&_this->input_booster_timeout_work[_this->index], msecs_to_jiffies(_this->param[_this->index].time)); \
-				_this->index++; \
-				CHANGE_STATE_TO(idle); \
-			}\
-		}\
-		_this->index = (temp_index >= 0) ? temp_index : _this->index; \
-	} else { \
-		pr_debug("[Input Booster] Timeout : completed   param_max : %d (%s)\n", param_max, __FUNCTION__); \
-		pr_debug("[Input Booster]\n"); \
-		REMOVE_BOOSTER; \
-		_this->index = 0; \
-		_this->multi_events = (_this->multi_events > 0) ? 0 : _this->multi_events; \
-		CHANGE_STATE_TO(idle); \
-	} \
-	mutex_unlock(&_this->lock); \
-}
-
 #define SET_BOOSTER_FUNC(_DEVICE_) input_booster_##_DEVICE_##_set_booster_work_func
 
 #define DECLARE_SET_BOOSTER_FUNC(_DEVICE_) \
@@ -210,18 +165,10 @@ static void input_booster_##_DEVICE_##_set_booster_work_func(struct work_struct
 static void input_booster_##_DEVICE_##_reset_booster_work_func(struct work_struct *work)  \
 { \
 	struct t_input_booster *_this = (struct t_input_booster *)(&_DEVICE_##_booster); \
-	int i; \
 	mutex_lock(&_this->lock); \
 	_this->multi_events = 0; \
-	_this->index=0; \
-	for(i=0;i<2;i++) { \
-		if(delayed_work_pending(&_this->input_booster_timeout_work[i])) { \
-			pr_debug("[Input Booster] ****             cancel the pending workqueue for reset\n"); \
-			cancel_delayed_work(&_this->input_booster_timeout_work[i]); \
-		} \
-	} \
 	CHANGE_STATE_TO(idle); \
-	REMOVE_BOOSTER; \
+	input_booster_arbiter_release(_this->source); \
 	mutex_unlock(&_this->lock); \
 }
 
@@ -430,6 +377,7 @@ struct t_input_booster_param {
 	u32 kfc_freq;
 	u32 mif_freq;
 	u32 int_freq;
+	u32 gpu_freq;
 
 	u16 time;
 
@@ -441,23 +389,65 @@ struct t_input_booster {
 	struct mutex lock;
 	struct t_input_booster_param param[2];
 
-	struct pm_qos_request	cpu_qos;
-	struct pm_qos_request	kfc_qos;
-	struct pm_qos_request	mif_qos;
-	struct pm_qos_request	int_qos;
-
-	struct delayed_work     input_booster_timeout_work[2];
 	struct work_struct      input_booster_set_booster_work;
 	struct work_struct      input_booster_reset_booster_work;
 
-	int index;
+	int source;
 	int multi_events;
 	int event_type;
-	int change_on_release;
 
 	void (*input_booster_state)(void *__this, int input_booster_event);
 };
 
+//+++++++++++++++++++++++++++++++++++++++++++++++  STRUCT & VARIABLE FOR ARBITER  +++++++++++++++++++++++++++++++++++++++++++++++//
+/*
+ * Every booster, and hints like app launch, is a source holding a head and a
+ * tail request. The arbiter applies the highest of each frequency asked by
+ * any live request through one set of PM QoS requests, and drops requests at
+ * their deadline from an hrtimer, so boosters no longer undo each other.
+ */
+#define INPUT_BOOSTER_MAX_SOURCES	16
+
+enum {
+	INPUT_BOOSTER_SLOT_HEAD = 0,
+	INPUT_BOOSTER_SLOT_TAIL,
+	INPUT_BOOSTER_SLOTS,
+};
+
+/* deadline of a request held until it is changed or released */
+#define INPUT_BOOSTER_HOLD	(-1)
+
+struct t_input_booster_request {
+	struct t_input_booster_param param;
+	ktime_t deadline;
+	bool held;
+	bool active;
+};
+
+struct t_input_booster_source {
+	const char *name;
+	struct t_input_booster_request req[INPUT_BOOSTER_SLOTS];
+	ktime_t active_since;
+	u64 residency_ns;
+	unsigned long count;
+};
+
+struct t_input_booster_arbiter {
+	spinlock_t lock;
+	struct t_input_booster_source source[INPUT_BOOSTER_MAX_SOURCES];
+	int nsources;
+
+	struct hrtimer release_timer;
+	struct work_struct apply_work;
+
+	struct pm_qos_request	cpu_qos;
+	struct pm_qos_request	kfc_qos;
+	struct pm_qos_request	mif_qos;
+	struct pm_qos_request	int_qos;
+	struct pm_qos_request	gpu_qos;
+};
+//----------------------------------------------  STRUCT & VARIABLE FOR ARBITER  ----------------------------------------------//
+
 //+++++++++++++++++++++++++++++++++++++++++++++++  STRUCT & VARIABLE FOR DEVICE TREE  +++++++++++++++++++++++++++++++++++++++++++++++//
 struct t_input_booster_device_tree_param {
 	u8      ilevels;
@@ -472,6 +462,7 @@ struct t_input_booster_device_tree_param {
 	u32     kfc_freq;
 	u32     mif_freq;
 	u32     int_freq;
+	u32     gpu_freq;
 };
 
 struct t_input_booster_device_tree_infor {
@@ -567,10 +558,19 @@ struct t_input_booster	hover_booster;
 struct t_input_booster	gamepad_booster;
 struct t_input_booster	key_two_booster;
 
+struct t_input_booster_arbiter input_booster_arbiter;
+int launch_booster_source;
+unsigned int launch_booster_max_ms = 3000;
+int irq_booster_source = -1;
+
 int input_count = 0, key_back = 0, key_home = 0, key_recent = 0;
 
 void input_booster_idle_state(void *__this, int input_booster_event);
 void input_booster_press_state(void *__this, int input_booster_event);
+int input_booster_add_source(const char *name);
+void input_booster_arbiter_set(int source, int slot,
+			       const struct t_input_booster_param *param, int ms);
+void input_booster_arbiter_release(int source);
 void input_booster(struct input_dev *dev);
 void input_booster_init(void);
 #endif
@@ -0,0 +1,66 @@
+/*
+ * Low latency interrupt handling for touch controllers
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License version 2 as published by
+ * the Free Software Foundation.
+ */
+#ifndef _TOUCH_FASTPATH_H
+#define _TOUCH_FASTPATH_H
+
+#include <linux/interrupt.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/spinlock.h>
+
+/* buckets of IRQ to input_sync latency, in powers of two microseconds */
+#define TOUCH_FASTPATH_BUCKETS	16
+
+struct touch_fastpath {
+#ifdef CONFIG_TOUCHSCREEN_FASTPATH
+	const char *name;
+	unsigned int irq;
+	irq_handler_t thread_fn;
+	void *dev_id;
+	struct list_head list;
+
+	/* hard IRQ time of the report being handled, 0 once synced */
+	ktime_t irq_time;
+	/* settings generation the IRQ thread last applied */
+	unsigned int applied;
+
+	spinlock_t lock;
+	unsigned long hist[TOUCH_FASTPATH_BUCKETS];
+	unsigned long count;
+	u64 total_us;
+	u32 max_us;
+#endif
+};
+
+#ifdef CONFIG_TOUCHSCREEN_FASTPATH
+int touch_fastpath_request_irq(struct touch_fastpath *fp, unsigned int irq,
+			       irq_handler_t thread_fn, unsigned long flags,
+			       const char *name, void *dev_id);
+void touch_fastpath_free_irq(struct touch_fastpath *fp, unsigned int irq,
+			     void *dev_id);
+void touch_fastpath_sync(struct touch_fastpath *fp);
+#else
+static inline int touch_fastpath_request_irq(struct touch_fastpath *fp,
+		unsigned int irq, irq_handler_t thread_fn, unsigned long flags,
+		const char *name, void *dev_id)
+{
+	return request_threaded_irq(irq, NULL, thread_fn, flags, name, dev_id);
+}
+
+static inline void touch_fastpath_free_irq(struct touch_fastpath *fp,
+					   unsigned int irq, void *dev_id)
+{
+	free_irq(irq, dev_id);
+}
+
+static inline void touch_fastpath_sync(struct touch_fastpath *fp)
+{
+}
+#endif
+
+#endif /* _TOUCH_FASTPATH_H */
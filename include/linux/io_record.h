@@ -17,6 +17,11 @@ bool forced_init_record(void);
 
 ssize_t read_record(char __user *buf, size_t count, loff_t *ppos);
 
+int open_replay(void);
+ssize_t write_replay(const char __user *buf, size_t count, loff_t *ppos);
+void start_replay(void);
+ssize_t read_replay(char __user *buf, size_t count, loff_t *ppos);
+
 void record_io_info(struct file *file, pgoff_t offset,
 		    unsigned long req_size);
 
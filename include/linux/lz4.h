@@ -346,6 +346,25 @@ int LZ4_decompress_safe(const char *source, char *dest, int compressedSize,
 int LZ4_decompress_safe_partial(const char *source, char *dest,
 	int compressedSize, int targetOutputSize, int maxDecompressedSize);
 
+/**
+ * LZ4_decompress_safe_withPrefix() - Resume decoding a block
+ * @source: address of the next sequence of the compressed block
+ * @dest: output position matching 'source'
+ * @compressedSize: number of compressed bytes left in the block
+ * @maxDecompressedSize: space left in the destination buffer
+ * @prefixSize: number of bytes already decoded in front of 'dest'
+ *
+ * Same as LZ4_decompress_safe(), for callers that decoded the first
+ * sequences of a block themselves, e.g. an architecture specific fast
+ * path, and stopped at a sequence boundary. Matches may refer up to
+ * 'prefixSize' bytes before 'dest', never further.
+ *
+ * Return: number of bytes decompressed into 'dest', not counting the
+ *	prefix, or a negative result in case of error
+ */
+int LZ4_decompress_safe_withPrefix(const char *source, char *dest,
+	int compressedSize, int maxDecompressedSize, size_t prefixSize);
+
 /*
  * lz4_decompress_unknownoutputsize() - For backwards compatibility,
  *	see LZ4_decompress_safe
@@ -44,6 +44,7 @@ int mbox_request_irq(enum mcu_ipc_region id, u32 int_num,
 int mbox_enable_irq(enum mcu_ipc_region id, u32 int_num);
 int mbox_check_irq(enum mcu_ipc_region id, u32 int_num);
 int mbox_disable_irq(enum mcu_ipc_region id, u32 int_num);
+int mbox_poll_irq(enum mcu_ipc_region id, u32 int_num, unsigned int timeout_us);
 int mcu_ipc_unregister_handler(enum mcu_ipc_region id, u32 int_num,
 		void (*handler)(void *));
 void mbox_set_interrupt(enum mcu_ipc_region id, u32 int_num);
@@ -218,6 +218,8 @@ struct mem_cgroup {
 	int		under_oom;
 
 	int	swappiness;
+	/* global reclaim passes to skip, see mem_cgroup_reclaim_deferred() */
+	int	reclaim_priority;
 	/* OOM-Killer disable */
 	int		oom_kill_disable;
 
@@ -300,6 +302,7 @@ static inline void mem_cgroup_events(struct mem_cgroup *memcg,
 }
 
 bool mem_cgroup_low(struct mem_cgroup *root, struct mem_cgroup *memcg);
+bool mem_cgroup_reclaim_deferred(struct mem_cgroup *memcg, int priority);
 
 int mem_cgroup_try_charge(struct page *page, struct mm_struct *mm,
 			  gfp_t gfp_mask, struct mem_cgroup **memcgp);
@@ -519,6 +522,12 @@ static inline bool mem_cgroup_low(struct mem_cgroup *root,
 	return false;
 }
 
+static inline bool mem_cgroup_reclaim_deferred(struct mem_cgroup *memcg,
+					       int priority)
+{
+	return false;
+}
+
 static inline int mem_cgroup_try_charge(struct page *page, struct mm_struct *mm,
 					gfp_t gfp_mask,
 					struct mem_cgroup **memcgp)
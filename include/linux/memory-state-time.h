@@ -13,6 +13,9 @@
  *
  */
 
+#ifndef _LINUX_MEMORY_STATE_TIME_H
+#define _LINUX_MEMORY_STATE_TIME_H
+
 #include <linux/workqueue.h>
 
 #define UPDATE_MEMORY_STATE(BLOCK, VALUE) BLOCK->update_call(BLOCK, VALUE)
@@ -31,6 +34,7 @@ struct memory_state_update_block {
 	int id;
 };
 
+#if IS_REACHABLE(CONFIG_MEMORY_STATE_TIME)
 /* Register a frequency struct memory_state_update_block to provide updates to
  * memory_state_time about frequency changes using its update_call function.
  */
@@ -40,3 +44,30 @@ struct memory_state_update_block *memory_state_register_frequency_source(void);
  * memory_state_time about bandwidth changes using its update_call function.
  */
 struct memory_state_update_block *memory_state_register_bandwidth_source(void);
+
+/* As memory_state_register_bandwidth_source, with @name shown for the
+ * source in the per-master statistics.
+ */
+struct memory_state_update_block *
+memory_state_register_named_bandwidth_source(const char *name);
+#else
+static inline struct memory_state_update_block *
+memory_state_register_frequency_source(void)
+{
+	return NULL;
+}
+
+static inline struct memory_state_update_block *
+memory_state_register_bandwidth_source(void)
+{
+	return NULL;
+}
+
+static inline struct memory_state_update_block *
+memory_state_register_named_bandwidth_source(const char *name)
+{
+	return NULL;
+}
+#endif
+
+#endif /* _LINUX_MEMORY_STATE_TIME_H */
@@ -115,6 +115,20 @@ static inline bool task_will_free_mem(struct task_struct *task)
 
 extern void dump_tasks(struct mem_cgroup *memcg, const nodemask_t *nodemask);
 
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_TASK_INDEX
+extern void lowmem_index_add(struct task_struct *p);
+extern void lowmem_index_remove(struct task_struct *p);
+extern void lowmem_index_replace(struct task_struct *old,
+				 struct task_struct *new);
+extern void lowmem_index_update(struct task_struct *task);
+#else
+static inline void lowmem_index_add(struct task_struct *p) {}
+static inline void lowmem_index_remove(struct task_struct *p) {}
+static inline void lowmem_index_replace(struct task_struct *old,
+					struct task_struct *new) {}
+static inline void lowmem_index_update(struct task_struct *task) {}
+#endif
+
 /* sysctls */
 extern int sysctl_oom_dump_tasks;
 extern int sysctl_oom_kill_allocating_task;
@@ -713,6 +713,11 @@ extern void __suspend_report_result(const char *function, void *fn, int ret);
 	} while (0)
 
 extern int device_pm_wait_for_dev(struct device *sub, struct device *dev);
+extern int device_pm_add_resume_dep(struct device *dev, struct device *supplier);
+extern int of_device_pm_add_resume_deps(struct device *dev);
+extern void device_pm_remove_resume_deps(struct device *dev);
+extern int device_pm_wait_resume_deps(struct device *dev);
+extern int device_pm_wait_suspend_deps(struct device *dev);
 extern void dpm_for_each_dev(void *data, void (*fn)(struct device *, void *));
 
 extern int pm_generic_prepare(struct device *dev);
@@ -754,6 +759,31 @@ static inline int device_pm_wait_for_dev(struct device *a, struct device *b)
 	return 0;
 }
 
+static inline int device_pm_add_resume_dep(struct device *dev,
+					   struct device *supplier)
+{
+	return 0;
+}
+
+static inline int of_device_pm_add_resume_deps(struct device *dev)
+{
+	return 0;
+}
+
+static inline void device_pm_remove_resume_deps(struct device *dev)
+{
+}
+
+static inline int device_pm_wait_resume_deps(struct device *dev)
+{
+	return 0;
+}
+
+static inline int device_pm_wait_suspend_deps(struct device *dev)
+{
+	return 0;
+}
+
 static inline void dpm_for_each_dev(void *data, void (*fn)(struct device *, void *))
 {
 }
@@ -42,6 +42,8 @@ enum {
 	PM_QOS_AUD_THROUGHPUT_MAX,
 	PM_QOS_FSYS_THROUGHPUT_MAX,
 #endif
+	PM_QOS_GPU_THROUGHPUT_MIN,
+	PM_QOS_GPU_THROUGHPUT_MAX,
 
 	/* insert new class ID */
 	PM_QOS_NUM_CLASSES,
@@ -78,6 +80,8 @@ enum pm_qos_flags_status {
 #define PM_QOS_AUD_THROUGHPUT_MAX_DEFAULT_VALUE INT_MAX
 #define PM_QOS_FSYS_THROUGHPUT_MAX_DEFAULT_VALUE INT_MAX
 #endif
+#define PM_QOS_GPU_THROUGHPUT_MIN_DEFAULT_VALUE	0
+#define PM_QOS_GPU_THROUGHPUT_MAX_DEFAULT_VALUE	INT_MAX
 #define PM_QOS_NETWORK_THROUGHPUT_DEFAULT_VALUE	0
 #define PM_QOS_MEMORY_BANDWIDTH_DEFAULT_VALUE	0
 #define PM_QOS_RESUME_LATENCY_DEFAULT_VALUE	0
@@ -0,0 +1,30 @@
+#ifndef _LINUX_PREZERO_H
+#define _LINUX_PREZERO_H
+
+#include <linux/highmem.h>
+
+struct page;
+
+#ifdef CONFIG_PREZERO_PAGE_POOL
+struct page *prezero_page_get(void);
+#else
+static inline struct page *prezero_page_get(void)
+{
+	return NULL;
+}
+#endif
+
+/* alloc_zeroed_user_highpage_movable(), from the pre-zeroed pool if any */
+static inline struct page *
+alloc_prezeroed_user_highpage_movable(struct vm_area_struct *vma,
+				      unsigned long vaddr)
+{
+	struct page *page = prezero_page_get();
+
+	if (page)
+		return page;
+
+	return alloc_zeroed_user_highpage_movable(vma, vaddr);
+}
+
+#endif /* _LINUX_PREZERO_H */
@@ -139,4 +139,10 @@ long reservation_object_wait_timeout_rcu(struct reservation_object *obj,
 bool reservation_object_test_signaled_rcu(struct reservation_object *obj,
 					  bool test_all);
 
+struct fence *reservation_object_merge_fences_rcu(struct reservation_object **objs,
+						  unsigned count, bool wait_all);
+
+struct seq_file;
+int reservation_object_stats_show(struct seq_file *s);
+
 #endif /* _LINUX_RESERVATION_H */
@@ -65,6 +65,7 @@ struct sched_param {
 #include <asm/processor.h>
 
 #define SCHED_ATTR_SIZE_VER0	48	/* sizeof first published struct */
+#define SCHED_ATTR_SIZE_VER1	56	/* add: util_{min,max} */
 
 /*
  * Extended scheduling parameters data structure.
@@ -101,6 +102,8 @@ struct sched_param {
  *  @sched_deadline	representative of the task's deadline
  *  @sched_runtime	representative of the task's runtime
  *  @sched_period	representative of the task's period
+ *  @sched_util_min	minimum utilization the task is accounted with
+ *  @sched_util_max	maximum utilization the task is accounted with
  *
  * Given this task model, there are a multiplicity of scheduling algorithms
  * and policies, that can be used to ensure all the tasks will make their
@@ -126,6 +129,17 @@ struct sched_attr {
 	u64 sched_runtime;
 	u64 sched_deadline;
 	u64 sched_period;
+
+	/* Utilization hints, see SCHED_FLAG_UTIL_CLAMP_{MIN,MAX} */
+	u32 sched_util_min;
+	u32 sched_util_max;
+};
+
+/* Utilization clamps, in SCHED_CAPACITY_SCALE units */
+enum uclamp_id {
+	UCLAMP_MIN = 0,
+	UCLAMP_MAX,
+	UCLAMP_CNT
 };
 
 struct futex_pi_state;
@@ -1290,6 +1304,8 @@ extern int get_hmp_boost(void);
 extern int get_hmp_semiboost(void);
 extern int set_hmp_up_threshold(int value);
 extern int set_hmp_down_threshold(int value);
+extern int set_hmp_thermal_bias(unsigned int bias);
+extern unsigned int get_hmp_thermal_bias(void);
 extern int set_active_down_migration(int enable);
 extern int set_hmp_aggressive_up_migration(int enable);
 extern int set_hmp_aggressive_yield(int enable);
@@ -1430,6 +1446,7 @@ struct sched_statistics {
 
 #ifdef CONFIG_SCHED_WALT
 #define RAVG_HIST_SIZE_MAX  5
+#define NUM_BUSY_BUCKETS  10
 
 /* ravg represents frequency scaled cpu-demand of tasks */
 struct ravg {
@@ -1454,12 +1471,18 @@ struct ravg {
 	 *
 	 * 'prev_window' represents task's contribution to cpu busy time
 	 * statistics (rq->prev_runnable_sum) in previous window
+	 *
+	 * 'pred_demand' represents the busy time forecast for the current
+	 * window from 'busy_buckets', a decaying histogram of the busy time
+	 * seen in previous windows, when walt_pred_demand is enabled
 	 */
 	u64 mark_start;
 	u32 sum, demand;
 	u32 sum_history[RAVG_HIST_SIZE_MAX];
 	u32 curr_window, prev_window;
 	u16 active_windows;
+	u32 pred_demand;
+	u8 busy_buckets[NUM_BUSY_BUCKETS];
 };
 #endif
 
@@ -1476,6 +1499,12 @@ struct sched_entity {
 
 	u64			nr_migrations;
 
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	/* when the task last went to sleep and its average sleep, in ns */
+	u64			sleep_start;
+	u64			avg_sleep;
+#endif
+
 #ifdef CONFIG_SCHEDSTATS
 	struct sched_statistics statistics;
 #endif
@@ -1652,6 +1681,20 @@ struct task_struct {
 #endif
 	struct sched_dl_entity dl;
 
+#ifdef CONFIG_CGROUP_SCHEDTUNE
+	/* contribution to the demand of a schedtune colocation group */
+	int colocate_idx;
+	unsigned long colocate_demand;
+	/* boost lent by a caller this task serves, e.g. through binder */
+	int inherited_boost;
+#endif
+
+#ifdef CONFIG_UCLAMP_TASK
+	/* clamps asked for by sched_setattr() and the ones on the rq */
+	unsigned int uclamp_req[UCLAMP_CNT];
+	unsigned int uclamp_active[UCLAMP_CNT];
+#endif
+
 #ifdef CONFIG_PREEMPT_NOTIFIERS
 	/* list of struct preempt_notifier: */
 	struct hlist_head preempt_notifiers;
@@ -1688,8 +1731,17 @@ struct task_struct {
 #ifdef CONFIG_SCHED_INFO
 	struct sched_info sched_info;
 #endif
+#ifdef CONFIG_SCHED_WAKELAT
+	u64 wakelat_ts;		/* rq clock at wakeup, 0 once running */
+#endif
 
 	struct list_head tasks;
+#ifdef CONFIG_ANDROID_LOW_MEMORY_KILLER_TASK_INDEX
+	/* thread group leaders only, see lowmemorykiller.c */
+	struct list_head lmk_node;
+	unsigned long lmk_rss;
+	short lmk_adj;
+#endif
 #ifdef CONFIG_SMP
 	struct plist_node pushable_tasks;
 	struct rb_node pushable_dl_tasks;
@@ -2745,6 +2797,39 @@ static inline int task_nice(const struct task_struct *p)
 extern int can_nice(const struct task_struct *p, const int nice);
 extern int task_curr(const struct task_struct *p);
 extern int idle_cpu(int cpu);
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+extern u64 sched_cpu_wake_hint(int cpu);
+#endif
+#ifdef CONFIG_CGROUP_SCHEDTUNE
+extern bool schedtune_task_top_app(struct task_struct *p);
+extern int schedtune_task_boost(struct task_struct *p);
+
+static inline int schedtune_inherited_boost(struct task_struct *p)
+{
+	return READ_ONCE(p->inherited_boost);
+}
+
+static inline void schedtune_set_inherited_boost(struct task_struct *p,
+						 int boost)
+{
+	WRITE_ONCE(p->inherited_boost, boost);
+}
+#else
+static inline bool schedtune_task_top_app(struct task_struct *p)
+{
+	return false;
+}
+
+static inline int schedtune_inherited_boost(struct task_struct *p)
+{
+	return 0;
+}
+
+static inline void schedtune_set_inherited_boost(struct task_struct *p,
+						 int boost)
+{
+}
+#endif
 extern int sched_setscheduler(struct task_struct *, int,
 			      const struct sched_param *);
 extern int sched_setscheduler_nocheck(struct task_struct *, int,
@@ -0,0 +1,17 @@
+#ifndef _LINUX_SKB_RX_POOL_H
+#define _LINUX_SKB_RX_POOL_H
+
+#include <linux/skbuff.h>
+
+/*
+ * Per cpu pools of receive pages for drivers that copy frames out of
+ * shared memory into freshly allocated skbs. See net/core/skb_rx_pool.c.
+ */
+struct skb_rx_pool;
+
+struct skb_rx_pool *skb_rx_pool_create(const char *name, unsigned int pages);
+void skb_rx_pool_destroy(struct skb_rx_pool *pool);
+struct sk_buff *skb_rx_pool_alloc(struct skb_rx_pool *pool, unsigned int len,
+				  gfp_t gfp_mask);
+
+#endif /* _LINUX_SKB_RX_POOL_H */
@@ -415,6 +415,8 @@ enum {
 	SKB_GSO_UDP_TUNNEL_CSUM = 1 << 11,
 
 	SKB_GSO_TUNNEL_REMCSUM = 1 << 12,
+
+	SKB_GSO_UDP_L4 = 1 << 13,
 };
 
 #if BITS_PER_LONG > 32
@@ -2417,6 +2419,11 @@ static inline void skb_free_frag(void *addr)
 	__free_page_frag(addr);
 }
 
+#ifdef CONFIG_CP_ZEROCOPY
+/* returns a head built on a modem zerocopy buffer to its pool */
+bool __skb_free_head_cp_zerocopy(struct sk_buff *skb);
+#endif
+
 void *napi_alloc_frag(unsigned int fragsz);
 struct sk_buff *__napi_alloc_skb(struct napi_struct *napi,
 				 unsigned int length, gfp_t gfp_mask);
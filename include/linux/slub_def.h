@@ -35,8 +35,15 @@ enum stat_item {
 	CPU_PARTIAL_FREE,	/* Refill cpu partial on free */
 	CPU_PARTIAL_NODE,	/* Refill cpu partial from node partial */
 	CPU_PARTIAL_DRAIN,	/* Drain cpu partial to node partial */
+	MAGAZINE_ALLOC,		/* Allocation from cpu magazine */
+	MAGAZINE_FREE,		/* Free into cpu magazine */
+	MAGAZINE_REFILL,	/* Batch allocated to refill cpu magazine */
+	MAGAZINE_FLUSH,		/* Batch freed from a full cpu magazine */
 	NR_SLUB_STAT_ITEMS };
 
+/* Allocation latency, in log2 ns buckets from below 256ns upwards */
+#define SLUB_ALLOC_LAT_BUCKETS	10
+
 struct kmem_cache_cpu {
 	void **freelist;	/* Pointer to next available object */
 	unsigned long tid;	/* Globally unique transaction id */
@@ -44,9 +51,12 @@ struct kmem_cache_cpu {
 	struct page *partial;	/* Partially allocated frozen slabs */
 #ifdef CONFIG_SLUB_STATS
 	unsigned stat[NR_SLUB_STAT_ITEMS];
+	unsigned alloc_lat[SLUB_ALLOC_LAT_BUCKETS];
 #endif
 };
 
+struct slub_magazine;
+
 /*
  * Word size structure that can be atomically updated or read and that
  * contains both the order and the number of objects that a slab of the
@@ -105,6 +115,16 @@ struct kmem_cache {
 	struct kasan_cache kasan_info;
 #endif
 
+#ifdef CONFIG_SLUB_MAGAZINE
+	/* Per cpu object stacks in front of the cpu slab, if size is set */
+	struct slub_magazine __percpu *magazine;
+	unsigned int magazine_size;
+	unsigned int magazine_batch;
+#endif
+#ifdef CONFIG_SLUB_STATS
+	int alloc_latency;	/* Fill kmem_cache_cpu->alloc_lat */
+#endif
+
 	struct kmem_cache_node *node[MAX_NUMNODES];
 };
 
@@ -252,8 +252,22 @@ struct swap_info_struct {
 
 /* linux/mm/workingset.c */
 void *workingset_eviction(struct address_space *mapping, struct page *page);
-bool workingset_refault(void *shadow);
+bool workingset_refault(struct address_space *mapping, void *shadow);
 void workingset_activation(struct page *page);
+#ifdef CONFIG_WORKINGSET_FILE_STATS
+/* refault distances below 256 pages, 1k, 4k, 16k, 64k, 256k and beyond */
+#define WORKINGSET_REFAULT_BUCKETS	7
+
+struct workingset_file_stat {
+	dev_t dev;
+	unsigned long ino;
+	unsigned long refaults;
+	unsigned long activations;
+	unsigned long hist[WORKINGSET_REFAULT_BUCKETS];
+};
+
+int workingset_hot_files(struct workingset_file_stat *stats, int nr);
+#endif
 extern struct list_lru __workingset_shadow_nodes;
 DECLARE_LOCAL_IRQ_LOCK(workingset_shadow_lock);
 
@@ -335,6 +349,10 @@ extern unsigned long mem_cgroup_shrink_node_zone(struct mem_cgroup *mem,
 						unsigned long *nr_scanned);
 extern unsigned long shrink_all_memory(unsigned long nr_pages);
 extern int vm_swappiness;
+#ifdef CONFIG_RECLAIM_COST_MODEL
+extern int vm_reclaim_cost_model;
+extern int vm_refault_cost_us;
+#endif
 extern int remove_mapping(struct address_space *mapping, struct page *page);
 extern unsigned long vm_total_pages;
 
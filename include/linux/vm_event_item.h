@@ -88,6 +88,12 @@ enum vm_event_item { PGPGIN, PGPGOUT, PSWPIN, PSWPOUT,
 #ifdef CONFIG_DEBUG_VM_VMACACHE
 		VMACACHE_FIND_CALLS,
 		VMACACHE_FIND_HITS,
+#endif
+#ifdef CONFIG_RECLAIM_COST_MODEL
+		RECLAIM_COST_ANON_NS,
+		RECLAIM_COST_FILE_NS,
+		RECLAIM_COST_DECISIONS,
+		RECLAIM_COST_ANON_PRIO,
 #endif
 		NR_VM_EVENT_ITEMS
 };
@@ -46,4 +46,16 @@ static inline void vmpressure(gfp_t gfp, struct mem_cgroup *memcg,
 static inline void vmpressure_prio(gfp_t gfp, struct mem_cgroup *memcg,
 				   int prio) {}
 #endif /* CONFIG_MEMCG */
+
+#ifdef CONFIG_VMPRESSURE_STALL
+extern u64 vmpressure_stall_enter(void);
+extern void vmpressure_stall_exit(u64 start);
+extern unsigned int vmpressure_stall_pct(void);
+extern unsigned int vmpressure_stall_window_ms(void);
+#else
+static inline u64 vmpressure_stall_enter(void) { return 0; }
+static inline void vmpressure_stall_exit(u64 start) {}
+static inline unsigned int vmpressure_stall_pct(void) { return 0; }
+static inline unsigned int vmpressure_stall_window_ms(void) { return 0; }
+#endif /* CONFIG_VMPRESSURE_STALL */
 #endif /* __LINUX_VMPRESSURE_H */
@@ -134,6 +134,14 @@ struct workqueue_attrs {
 	bool			no_numa;	/* disable NUMA affinity */
 };
 
+/* CPU cluster the workers of an unbound workqueue are kept on */
+enum wq_cluster {
+	WQ_CLUSTER_ALL,		/* no restriction */
+	WQ_CLUSTER_LITTLE,	/* the boot CPU's cluster */
+	WQ_CLUSTER_BIG,		/* every other CPU */
+	WQ_CLUSTER_AUTO,	/* big for WQ_HIGHPRI, little otherwise */
+};
+
 static inline struct delayed_work *to_delayed_work(struct work_struct *work)
 {
 	return container_of(work, struct delayed_work, work);
@@ -441,6 +449,8 @@ struct workqueue_attrs *alloc_workqueue_attrs(gfp_t gfp_mask);
 void free_workqueue_attrs(struct workqueue_attrs *attrs);
 int apply_workqueue_attrs(struct workqueue_struct *wq,
 			  const struct workqueue_attrs *attrs);
+int workqueue_set_cluster(struct workqueue_struct *wq,
+			  enum wq_cluster cluster);
 int workqueue_set_unbound_cpumask(cpumask_var_t cpumask);
 
 extern bool queue_work_on(int cpu, struct workqueue_struct *wq,
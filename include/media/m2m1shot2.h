@@ -234,6 +234,10 @@ struct m2m1shot2_devops {
  * @timer : timeout that the acquire fence can't receive the signal
  *			for some time.
  * @release_fence : release fence of ctx. It is only used for debugging.
+ * @num_batch	: the number of effective elements in @batch
+ * @batch	: contexts created to carry the tasks of
+ *		  M2M1SHOT2_IOC_PROCESS_BATCH, one for each task of the
+ *		  largest batch so far. Destroyed along with the context.
  */
 struct m2m1shot2_context {
 	struct list_head		node;
@@ -260,6 +264,9 @@ struct m2m1shot2_context {
 	struct timer_list		timer;
 	struct sync_fence		*release_fence;
 	spinlock_t			fence_timeout_lock;
+
+	unsigned int			num_batch;
+	struct m2m1shot2_context	*batch[M2M1SHOT2_MAX_BATCH];
 };
 
 #define M2M1SHOT2_DEVATTR_COHERENT		(1 << 0)
@@ -283,8 +290,11 @@ struct m2m1shot2_context {
  * @current_task: indicate the context that is currently being processed
  *		  - a value set in m2m1shot2_schedule()
  *		  - NULL is set in __m2m1shot2_finish_context().
- * @lock_ctx	: lock to protect the consistency of @contexts, @active_contexts
- *		  and @current_task.
+ * @merged_ctx	: the context processed in the same H/W run with @current_task
+ *		  - a value set in m2m1shot2_merge_next_context()
+ *		  - NULL is set in __m2m1shot2_finish_context().
+ * @lock_ctx	: lock to protect the consistency of @contexts, @active_contexts,
+ *		  @current_task and @merged_ctx.
  * @ops		: callback functions that the client device driver must
  *                implement according to the events.
  * @schedule_workqueue: queue of work to schedule a image processing task.
@@ -306,6 +316,7 @@ struct m2m1shot2_device {
 	struct list_head		contexts;
 	struct list_head		active_contexts;
 	struct m2m1shot2_context	*current_ctx;
+	struct m2m1shot2_context	*merged_ctx;
 	spinlock_t			lock_ctx;
 	spinlock_t			lock_priority;
 	const struct m2m1shot2_devops	*ops;
@@ -325,6 +336,10 @@ struct m2m1shot2_device *m2m1shot2_create_device(struct device *dev,
 void m2m1shot2_destroy_device(struct m2m1shot2_device *m21dev);
 void m2m1shot2_finish_context(struct m2m1shot2_context *ctx, bool success);
 void m2m1shot2_schedule(struct m2m1shot2_device *m21dev);
+struct m2m1shot2_context *m2m1shot2_merge_next_context(
+		struct m2m1shot2_device *m21dev,
+		bool (*merge)(struct m2m1shot2_context *cur,
+			      struct m2m1shot2_context *next));
 
 static inline u32 m2m1shot2_get_payload(struct m2m1shot2_context *ctx,
 					unsigned int index, unsigned int plane)
@@ -392,6 +407,7 @@ static inline struct m2m1shot2_device *m2m1shot2_create_device(
 }
 #define m2m1shot2_destroy_device(m21dev)		do { } while (0)
 #define m2m1shot2_finish_context(ctx, success)		do { } while (0)
+#define m2m1shot2_merge_next_context(m21dev, merge)	NULL
 static inline u32 m2m1shot2_get_payload(struct m2m1shot2_context *ctx,
 					unsigned int index, unsigned int plane)
 {
@@ -839,7 +839,8 @@ struct sk_buff *ip6_make_skb(struct sock *sk,
 			     void *from, int length, int transhdrlen,
 			     int hlimit, int tclass, struct ipv6_txoptions *opt,
 			     struct flowi6 *fl6, struct rt6_info *rt,
-			     unsigned int flags, int dontfrag);
+			     struct inet_cork_full *cork, unsigned int flags,
+			     int dontfrag);
 
 static inline struct sk_buff *ip6_finish_skb(struct sock *sk)
 {
@@ -314,6 +314,9 @@ extern int sysctl_tcp_invalid_ratelimit;
 extern int sysctl_tcp_pacing_ss_ratio;
 extern int sysctl_tcp_pacing_ca_ratio;
 extern int sysctl_tcp_default_init_rwnd;
+extern int sysctl_tcp_ack_thin_segs;
+extern int sysctl_tcp_ack_thin_rtt_us;
+extern int sysctl_tcp_ack_thin_delay_us;
 #ifdef CONFIG_CLTCP
 extern int sysctl_tcp_cltcp[4]; 
 extern unsigned long long sysctl_tcp_cltcp_ifdevs;
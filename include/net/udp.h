@@ -161,6 +161,15 @@ void udp_set_csum(bool nocheck, struct sk_buff *skb,
 struct sk_buff **udp_gro_receive(struct sk_buff **head, struct sk_buff *skb,
 				 struct udphdr *uh);
 int udp_gro_complete(struct sk_buff *skb, int nhoff);
+struct sk_buff **udp_gro_receive_segment(struct sk_buff **head,
+					 struct sk_buff *skb,
+					 struct udphdr *uh);
+int udp_gro_complete_segment(struct sk_buff *skb, int nhoff);
+struct sk_buff *__udp_gso_segment(struct sk_buff *gso_skb,
+				  netdev_features_t features);
+
+/* Enabled once a socket sets UDP_GRO, until then GRO skips the lookup */
+extern struct static_key udp_gro_needed;
 
 static inline struct udphdr *udp_gro_udphdr(struct sk_buff *skb)
 {
@@ -256,6 +265,8 @@ int udp_lib_getsockopt(struct sock *sk, int level, int optname,
 int udp_lib_setsockopt(struct sock *sk, int level, int optname,
 		       char __user *optval, unsigned int optlen,
 		       int (*push_pending_frames)(struct sock *));
+int udp_cmsg_send(struct sock *sk, struct msghdr *msg, u16 *gso_size);
+void udp_cmsg_recv(struct msghdr *msg, struct sock *sk, struct sk_buff *skb);
 struct sock *udp4_lib_lookup(struct net *net, __be32 saddr, __be16 sport,
 			     __be32 daddr, __be16 dport, int dif);
 struct sock *__udp4_lib_lookup(struct net *net, __be32 saddr, __be16 sport,
@@ -302,6 +313,44 @@ do {									\
 #define UDPX_INC_STATS_BH(sk, field) UDP_INC_STATS_BH(sock_net(sk), field, 0)
 #endif
 
+static inline struct udp_mib __percpu *udp_mib_for_sk(struct sock *sk)
+{
+#if IS_ENABLED(CONFIG_IPV6)
+	if (sk->sk_family == AF_INET6)
+		return sock_net(sk)->mib.udp_stats_in6;
+#endif
+	return sock_net(sk)->mib.udp_statistics;
+}
+
+/* A UDP GSO packet from GRO for a socket that did not ask for them */
+static inline bool udp_unexpected_gso(struct sock *sk, struct sk_buff *skb)
+{
+	return !udp_sk(sk)->gro_enabled && skb_is_gso(skb) &&
+	       skb_shinfo(skb)->gso_type & SKB_GSO_UDP_L4;
+}
+
+static inline struct sk_buff *udp_rcv_segment(struct sock *sk,
+					      struct sk_buff *skb)
+{
+	struct sk_buff *segs;
+
+	/* the GSO CB lays after the UDP one, no need to save and restore
+	 * any CB fragment
+	 */
+	segs = __skb_gso_segment(skb, NETIF_F_SG, false);
+	if (unlikely(IS_ERR_OR_NULL(segs))) {
+		int segs_nr = skb_shinfo(skb)->gso_segs;
+
+		atomic_add(segs_nr, &sk->sk_drops);
+		SNMP_ADD_STATS_BH(udp_mib_for_sk(sk), UDP_MIB_INERRORS, segs_nr);
+		kfree_skb(skb);
+		return NULL;
+	}
+
+	consume_skb(skb);
+	return segs;
+}
+
 /* /proc */
 int udp_seq_open(struct inode *inode, struct file *file);
 
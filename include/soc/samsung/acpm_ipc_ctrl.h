@@ -1,6 +1,10 @@
 #ifndef __ACPM_IPC_CTRL_H__
 #define __ACPM_IPC_CTRL_H__
 
+#include <linux/errno.h>
+#include <linux/list.h>
+#include <linux/types.h>
+
 typedef void (*ipc_callback)(unsigned int *cmd, unsigned int size);
 
 struct ipc_config {
@@ -23,6 +27,26 @@ struct ipc_config {
 #define ACPM_IPC_PROTOCOL_STOP			(22)
 #define ACPM_IPC_PROTOCOL_SEQ_NUM		(16)
 
+struct acpm_ipc_async;
+typedef void (*acpm_ipc_async_done)(struct acpm_ipc_async *req, int err);
+
+/*
+ * An asynchronous request, see acpm_ipc_send_batch(). cfg.cmd holds the
+ * command, and the response once done is called. done runs from the ACPM
+ * IPC interrupt thread, or before acpm_ipc_send_batch() returns on polling
+ * channels, and may send again.
+ */
+struct acpm_ipc_async {
+	struct ipc_config cfg;
+	acpm_ipc_async_done done;
+	void *data;
+
+	/* private to the ACPM IPC driver */
+	struct list_head list;
+	unsigned int seq;
+	u64 start;
+};
+
 #ifdef CONFIG_EXYNOS_ACPM
 unsigned int acpm_ipc_request_channel(struct device_node *np, ipc_callback handler,
 		unsigned int *id, unsigned int *size);
@@ -30,6 +54,8 @@ unsigned int acpm_ipc_release_channel(struct device_node *np, unsigned int chann
 int acpm_ipc_send_data(unsigned int channel_id, struct ipc_config *cfg);
 int acpm_ipc_send_data_sync(unsigned int channel_id, struct ipc_config *cfg);
 int acpm_ipc_set_ch_mode(struct device_node *np, bool polling);
+int acpm_ipc_send_batch(unsigned int channel_id, struct acpm_ipc_async *reqs,
+		unsigned int nr);
 void exynos_acpm_reboot(void);
 void acpm_stop_log(void);
 #else
@@ -60,6 +86,12 @@ static inline int acpm_ipc_set_ch_mode(struct device_node *np, bool polling)
 	return 0;
 }
 
+static inline int acpm_ipc_send_batch(unsigned int channel_id,
+		struct acpm_ipc_async *reqs, unsigned int nr)
+{
+	return -ENODEV;
+}
+
 static inline void exynos_acpm_reboot(void)
 {
 	return;
@@ -191,6 +191,21 @@ struct input_keymap_entry {
 	__u8  scancode[32];
 };
 
+/**
+ * struct input_coalesce - wakeup coalescing of an evdev client
+ * @interval_us: wake the reader at most once per interval, on multiples of
+ *	it in CLOCK_MONOTONIC time; 0 wakes it on every report
+ * @max_packets: wake the reader early once this many reports are queued,
+ *	0 for no limit
+ *
+ * Reports carrying EV_KEY or EV_SW events, such as the first touch down,
+ * always wake the reader at once.
+ */
+struct input_coalesce {
+	__u32 interval_us;
+	__u32 max_packets;
+};
+
 struct input_mask {
 	__u32 type;
 	__u32 codes_size;
@@ -309,6 +324,7 @@ struct input_mask {
 #define EVIOCSMASK		_IOW('E', 0x93, struct input_mask)	/* Set event-masks */
 
 #define EVIOCSCLOCKID		_IOW('E', 0xa0, int)			/* Set clockid to be used for timestamps */
+#define EVIOCSCOALESCE		_IOW('E', 0xa1, struct input_coalesce)	/* Set wakeup coalescing */
 
 /*
  * IDs.
@@ -388,4 +388,30 @@ struct m2m1shot2_performance_data {
 #define M2M1SHOT2_IOC_REQUEST_PERF	_IOR('M', 7, struct m2m1shot2_performance_data)
 #define M2M1SHOT2_IOC_CUSTOM		_IOR('M', 8, struct m2m1shot2_custom_data)
 
+#define M2M1SHOT2_MAX_BATCH 16
+
+/* struct m2m1shot2_batch - a number of image processing tasks at once
+ *
+ * @jobs	: the descriptions of the tasks. Every task should have
+ *		  M2M1SHOT2_FLAG_NONBLOCK set and the release fences of its
+ *		  images are returned in each task as M2M1SHOT2_IOC_PROCESS does.
+ * @num_jobs	: the number of valid elements in @jobs, M2M1SHOT2_MAX_BATCH
+ *		  at most.
+ * @num_queued	: set by the framework to the number of tasks from the head
+ *		  of @jobs that are queued to the H/W. It is less than
+ *		  @num_jobs if an error occurred on the next task.
+ * @reserved	: reserved for later use.
+ *
+ * The tasks are processed back to back in the order of @jobs without
+ * returning to the user between them.
+ */
+struct m2m1shot2_batch {
+	struct m2m1shot2	*jobs;
+	__u32			num_jobs;
+	__u32			num_queued;
+	__u32			reserved[2];
+};
+
+#define M2M1SHOT2_IOC_PROCESS_BATCH	_IOWR('M', 9, struct m2m1shot2_batch)
+
 #endif /* _UAPI__M2M1SHOT2_H_ */
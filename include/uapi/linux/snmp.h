@@ -284,6 +284,7 @@ enum
 	LINUX_MIB_TCPWQUEUETOOBIG,		/* TCPWqueueTooBig */
 	LINUX_MIB_TCPRACECNDREQSK,		/* TCPRaceCondInReqsk */
 	LINUX_MIB_TCPRACECNDREQSKDROP,		/* TCPRaceCondInReqskDrop */
+	LINUX_MIB_TCPACKTHINNED,		/* TCPAckThinned */
 	__LINUX_MIB_MAX
 };
 
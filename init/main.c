@@ -65,6 +65,7 @@
 #include <linux/kgdb.h>
 #include <linux/ftrace.h>
 #include <linux/async.h>
+#include <linux/boot_critpath.h>
 #include <linux/kmemcheck.h>
 #include <linux/sfi.h>
 #include <linux/shmem_fs.h>
@@ -981,10 +982,12 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	int count = preempt_count();
 	int ret;
 	char msgbuf[64];
+	u64 start;
 
 	if (initcall_blacklisted(fn))
 		return -EPERM;
 
+	start = boot_critpath_start();
 #ifdef CONFIG_SEC_INITCALL_DEBUG
 	ret = do_one_initcall_debug(fn);
 #else
@@ -993,6 +996,7 @@ int __init_or_module do_one_initcall(initcall_t fn)
 	else
 		ret = fn();
 #endif
+	boot_critpath_initcall(fn, start);
 
 	msgbuf[0] = 0;
 
@@ -1056,6 +1060,7 @@ static void __init do_initcall_level(int level)
 		   level, level,
 		   NULL, &repair_env_string);
 
+	boot_critpath_set_level(level);
 	for (fn = initcall_levels[level]; fn < initcall_levels[level+1]; fn++)
 		do_one_initcall(*fn);
 
@@ -1067,11 +1072,14 @@ static void __init do_initcall_level(int level)
 static void __init do_initcalls(void)
 {
 	int level;
+	u64 start;
 
 	for (level = 0; level < ARRAY_SIZE(initcall_levels) - 1; level++) {
 		do_initcall_level(level);
 		/* finish all async calls before going into next level */
+		start = boot_critpath_start();
 		async_synchronize_full();
+		boot_critpath_barrier(level, start);
 	}
 }
 
@@ -1179,6 +1187,7 @@ static int __ref kernel_init(void *unused)
 #endif
 	/* need to finish all async __init code before freeing the memory */
 	async_synchronize_full();
+	boot_critpath_done();
 	free_initmem();
 	mark_readonly();
 
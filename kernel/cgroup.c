@@ -3076,6 +3076,85 @@ int cgroup_attach_task_all(struct task_struct *from, struct task_struct *tsk)
 }
 EXPORT_SYMBOL_GPL(cgroup_attach_task_all);
 
+/* the next process of @uid not in @dst_cgrp yet, called under rcu */
+static struct task_struct *cgroup_next_uid_process(struct cgroup *dst_cgrp,
+						    int ssid, kuid_t uid)
+{
+	struct task_struct *p;
+
+	for_each_process(p) {
+		if (!uid_eq(task_uid(p), uid) ||
+		    (p->flags & (PF_EXITING | PF_KTHREAD | PF_NO_SETAFFINITY)) ||
+		    p->no_cgroup_migration)
+			continue;
+		if (task_css(p, ssid)->cgroup != dst_cgrp)
+			return p;
+	}
+
+	return NULL;
+}
+
+/**
+ * cgroup_attach_uid - attach all processes of a user to a cgroup
+ * @ss: the subsystem whose hierarchy @name is in
+ * @name: name of the cgroup, a child of the hierarchy's root
+ * @uid: the user
+ *
+ * Does for every process of @uid what writing its pid to cgroup.procs of
+ * @name would, taking the locks once for all of them, for callers moving
+ * a whole app at once. Returns the number of processes attached.
+ */
+int cgroup_attach_uid(struct cgroup_subsys *ss, const char *name, kuid_t uid)
+{
+	struct cgroup_subsys *post_ss;
+	struct kernfs_node *kn;
+	struct task_struct *tsk;
+	struct cgroup *cgrp;
+	int ssid, ret = 0, nr = 0;
+
+	kn = kernfs_find_and_get(ss->root->cgrp.kn, name);
+	if (!kn)
+		return -ENOENT;
+	if (kernfs_type(kn) != KERNFS_DIR) {
+		kernfs_put(kn);
+		return -ENOTDIR;
+	}
+	cgrp = kn->priv;
+
+	mutex_lock(&cgroup_mutex);
+	if (cgroup_is_dead(cgrp)) {
+		ret = -ENODEV;
+		goto out_unlock;
+	}
+
+	percpu_down_write(&cgroup_threadgroup_rwsem);
+	while (true) {
+		rcu_read_lock();
+		tsk = cgroup_next_uid_process(cgrp, ss->id, uid);
+		if (tsk)
+			get_task_struct(tsk);
+		rcu_read_unlock();
+		if (!tsk)
+			break;
+
+		ret = cgroup_attach_task(cgrp, tsk, true);
+		put_task_struct(tsk);
+		if (ret)
+			break;
+		nr++;
+	}
+	percpu_up_write(&cgroup_threadgroup_rwsem);
+	for_each_subsys(post_ss, ssid)
+		if (post_ss->post_attach)
+			post_ss->post_attach();
+
+out_unlock:
+	mutex_unlock(&cgroup_mutex);
+	kernfs_put(kn);
+	return ret ?: nr;
+}
+EXPORT_SYMBOL_GPL(cgroup_attach_uid);
+
 static ssize_t cgroup_tasks_write(struct kernfs_open_file *of,
 				  char *buf, size_t nbytes, loff_t off)
 {
@@ -131,6 +131,9 @@ struct cpuset {
 
 	/* for custom sched domain */
 	int relax_domain_level;
+
+	/* minimum timer slack of the tasks, 0 leaves it to them */
+	u64 timer_slack_ns;
 };
 
 static struct cpuset *display_cpuset;
@@ -433,6 +436,21 @@ static void cpuset_update_task_spread_flag(struct cpuset *cs,
 		task_clear_spread_slab(tsk);
 }
 
+/*
+ * Raise task's timer slack to the cpuset's, so that the timers of background
+ * groups expire together with wakeups that are due anyway instead of pulling
+ * their cpu out of idle on their own. Tasks return to their default slack
+ * when the cpuset has none.
+ *
+ * Call with cpuset_mutex held.
+ */
+static void cpuset_update_task_timer_slack(struct cpuset *cs,
+					   struct task_struct *tsk)
+{
+	tsk->timer_slack_ns = max_t(u64, tsk->default_timer_slack_ns,
+				    cs->timer_slack_ns);
+}
+
 /*
  * is_cpuset_subset(p, q) - Is cpuset p a subset of cpuset q?
  *
@@ -1364,6 +1382,19 @@ static void update_tasks_flags(struct cpuset *cs)
 	css_task_iter_end(&it);
 }
 
+static void update_tasks_timer_slack(struct cpuset *cs, u64 slack_ns)
+{
+	struct css_task_iter it;
+	struct task_struct *task;
+
+	cs->timer_slack_ns = slack_ns;
+
+	css_task_iter_start(&cs->css, &it);
+	while ((task = css_task_iter_next(&it)))
+		cpuset_update_task_timer_slack(cs, task);
+	css_task_iter_end(&it);
+}
+
 /*
  * update_flag - read a 0 or a 1 in a file and update associated flag
  * bit:		the bit to update (see cpuset_flagbits_t)
@@ -1630,6 +1661,7 @@ static void cpuset_attach(struct cgroup_taskset *tset)
 
 		cpuset_change_task_nodemask(task, &cpuset_attach_nodemask_to);
 		cpuset_update_task_spread_flag(cs, task);
+		cpuset_update_task_timer_slack(cs, task);
 	}
 
 	/*
@@ -1687,6 +1719,7 @@ typedef enum {
 	FILE_SPREAD_SLAB,
 	FILE_SELECTIVE_BOOST,
 	FILE_PRIO_PINNING,
+	FILE_TIMER_SLACK,
 } cpuset_filetype_t;
 
 static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
@@ -1733,6 +1766,9 @@ static int cpuset_write_u64(struct cgroup_subsys_state *css, struct cftype *cft,
 	case FILE_PRIO_PINNING:
 		retval = update_flag(CS_PRIO_PINNING, cs, val);
 		break;
+	case FILE_TIMER_SLACK:
+		update_tasks_timer_slack(cs, val);
+		break;
 	default:
 		retval = -EINVAL;
 		break;
@@ -1896,6 +1932,8 @@ static u64 cpuset_read_u64(struct cgroup_subsys_state *css, struct cftype *cft)
 		return is_selective_boost_enabled(cs);
 	case FILE_PRIO_PINNING:
 		return is_prio_pinning_enabled(cs);
+	case FILE_TIMER_SLACK:
+		return cs->timer_slack_ns;
 	default:
 		BUG();
 	}
@@ -2037,6 +2075,14 @@ static struct cftype files[] = {
 		.private = FILE_PRIO_PINNING,
 	},
 
+	{
+		.name = "timer_slack_ns",
+		.flags = CFTYPE_NOT_ON_ROOT,
+		.read_u64 = cpuset_read_u64,
+		.write_u64 = cpuset_write_u64,
+		.private = FILE_TIMER_SLACK,
+	},
+
 	{ }	/* terminate */
 };
 
@@ -2101,6 +2147,7 @@ static int cpuset_css_online(struct cgroup_subsys_state *css)
 		set_bit(CS_SPREAD_PAGE, &cs->flags);
 	if (is_spread_slab(parent))
 		set_bit(CS_SPREAD_SLAB, &cs->flags);
+	cs->timer_slack_ns = parent->timer_slack_ns;
 
 	cpuset_inc();
 
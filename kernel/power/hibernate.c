@@ -35,6 +35,8 @@
 
 
 static int nocompress;
+/* lz4 on all cpus, and clean page cache left out of the image */
+bool hibernate_fast_restore;
 static int noresume;
 static int nohibernate;
 static int resume_wait;
@@ -705,6 +707,8 @@ int hibernate(void)
 			flags |= SF_NOCOMPRESS_MODE;
 		else
 		        flags |= SF_CRC32_MODE;
+		if (!nocompress && hibernate_fast_restore)
+			flags |= SF_LZ4_MODE;
 
 		pr_debug("PM: writing image.\n");
 		error = swsusp_write(flags);
@@ -1072,11 +1076,42 @@ static ssize_t reserved_size_store(struct kobject *kobj,
 
 power_attr(reserved_size);
 
+static ssize_t fast_restore_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%d\n", hibernate_fast_restore);
+}
+
+static ssize_t fast_restore_store(struct kobject *kobj,
+				  struct kobj_attribute *attr,
+				  const char *buf, size_t n)
+{
+	bool val;
+
+	if (strtobool(buf, &val))
+		return -EINVAL;
+
+	hibernate_fast_restore = val;
+	return n;
+}
+
+power_attr(fast_restore);
+
+static ssize_t restore_stats_show(struct kobject *kobj,
+				  struct kobj_attribute *attr, char *buf)
+{
+	return swsusp_restore_stats_show(buf);
+}
+
+power_attr_ro(restore_stats);
+
 static struct attribute * g[] = {
 	&disk_attr.attr,
 	&resume_attr.attr,
 	&image_size_attr.attr,
 	&reserved_size_attr.attr,
+	&fast_restore_attr.attr,
+	&restore_stats_attr.attr,
 	NULL,
 };
 
@@ -1122,6 +1157,8 @@ static int __init hibernate_setup(char *str)
 		noresume = 1;
 	} else if (!strncmp(str, "nocompress", 10)) {
 		nocompress = 1;
+	} else if (!strncmp(str, "fast", 4)) {
+		hibernate_fast_restore = true;
 	} else if (!strncmp(str, "no", 2)) {
 		noresume = 1;
 		nohibernate = 1;
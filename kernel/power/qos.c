@@ -44,6 +44,9 @@
 #include <linux/debugfs.h>
 #include <linux/seq_file.h>
 #include <linux/cpumask.h>
+#include <linux/moduleparam.h>
+#include <linux/seqlock.h>
+#include <linux/workqueue.h>
 
 #include <linux/uaccess.h>
 #include <linux/export.h>
@@ -52,7 +55,8 @@
 /*
  * locking rule: all changes to constraints or notifiers lists
  * or pm_qos_object list and pm_qos_objects need to happen with pm_qos_lock
- * held, taken with _irqsave.  One lock to rule them all
+ * held, taken with _irqsave.  The classes of pm_qos_array are the exception:
+ * their requests are changed under the lock of their pm_qos_class_state.
  */
 struct pm_qos_object {
 	struct pm_qos_constraints *constraints;
@@ -62,6 +66,55 @@ struct pm_qos_object {
 
 static DEFINE_SPINLOCK(pm_qos_lock);
 
+/*
+ * struct pm_qos_class_state - per class locking, notification and statistics
+ * @lock: protects the requests list of the class, taken with _irqsave
+ * @seq: lets the aggregated values be read without @lock
+ * @notify_work: dispatches the notifications held back in a window
+ * @window_end: end, in jiffies, of the current coalescing window
+ * @pending: a notification is held back until @window_end
+ * @class: passed to the notifiers of coalesced updates
+ *
+ * The rest are statistics, found in debugfs pm_qos/stats.
+ */
+struct pm_qos_class_state {
+	spinlock_t lock;
+	seqcount_t seq;
+
+	struct delayed_work notify_work;
+	unsigned long window_end;
+	bool pending;
+	int class;
+
+	unsigned long updates;
+	unsigned long rate;
+	unsigned long rate_count;
+	unsigned long rate_start;
+	unsigned long notifies;
+	unsigned long coalesced;
+	u64 notify_ns;
+	u64 notify_max_ns;
+};
+
+static struct pm_qos_class_state pm_qos_state[PM_QOS_NUM_CLASSES] = {
+	[0 ... PM_QOS_NUM_CLASSES - 1] = {
+		.lock = __SPIN_LOCK_UNLOCKED(pm_qos_state.lock),
+		.seq = SEQCNT_ZERO(pm_qos_state.seq),
+	},
+};
+
+/* the notify works can be used, from core_initcall on */
+static bool pm_qos_notify_ready;
+
+/*
+ * Notifications of a class closer than this to the previous one are held
+ * back and sent once at the end of the window, with the value then current.
+ * Isolated updates are notified right away whatever the window. 0 is off.
+ */
+static unsigned int notify_coalesce_ms;
+module_param(notify_coalesce_ms, uint, 0644);
+MODULE_PARM_DESC(notify_coalesce_ms, "Window to coalesce notifications in");
+
 static struct pm_qos_object null_pm_qos;
 
 static BLOCKING_NOTIFIER_HEAD(cpu_dma_lat_notifier);
@@ -395,6 +448,32 @@ static struct pm_qos_object fsys_throughput_max_pm_qos = {
 };
 #endif
 
+static BLOCKING_NOTIFIER_HEAD(gpu_throughput_min_notifier);
+static struct pm_qos_constraints gpu_tput_min_constraints = {
+	.list = PLIST_HEAD_INIT(gpu_tput_min_constraints.list),
+	.target_value = PM_QOS_GPU_THROUGHPUT_MIN_DEFAULT_VALUE,
+	.default_value = PM_QOS_GPU_THROUGHPUT_MIN_DEFAULT_VALUE,
+	.type = PM_QOS_MAX,
+	.notifiers = &gpu_throughput_min_notifier,
+};
+static struct pm_qos_object gpu_throughput_min_pm_qos = {
+	.constraints = &gpu_tput_min_constraints,
+	.name = "gpu_throughput_min",
+};
+
+static BLOCKING_NOTIFIER_HEAD(gpu_throughput_max_notifier);
+static struct pm_qos_constraints gpu_tput_max_constraints = {
+	.list = PLIST_HEAD_INIT(gpu_tput_max_constraints.list),
+	.target_value = PM_QOS_GPU_THROUGHPUT_MAX_DEFAULT_VALUE,
+	.default_value = PM_QOS_GPU_THROUGHPUT_MAX_DEFAULT_VALUE,
+	.type = PM_QOS_MIN,
+	.notifiers = &gpu_throughput_max_notifier,
+};
+static struct pm_qos_object gpu_throughput_max_pm_qos = {
+	.constraints = &gpu_tput_max_constraints,
+	.name = "gpu_throughput_max",
+};
+
 static struct pm_qos_object *pm_qos_array[] = {
 	&null_pm_qos,
 	&cpu_dma_pm_qos,
@@ -427,6 +506,8 @@ static struct pm_qos_object *pm_qos_array[] = {
 	&aud_throughput_max_pm_qos,
 	&fsys_throughput_max_pm_qos,
 #endif
+	&gpu_throughput_min_pm_qos,
+	&gpu_throughput_max_pm_qos,
 };
 
 static ssize_t pm_qos_power_write(struct file *filp, const char __user *buf,
@@ -485,9 +566,22 @@ static inline void pm_qos_set_value(struct pm_qos_constraints *c, s32 value)
 }
 
 static inline int pm_qos_get_value(struct pm_qos_constraints *c);
+
+static struct pm_qos_class_state *pm_qos_object_state(struct pm_qos_object *qos)
+{
+	int i;
+
+	for (i = 0; i < PM_QOS_NUM_CLASSES; i++)
+		if (pm_qos_array[i] == qos)
+			return &pm_qos_state[i];
+
+	return NULL;
+}
+
 static int pm_qos_dbg_show_requests(struct seq_file *s, void *unused)
 {
 	struct pm_qos_object *qos = (struct pm_qos_object *)s->private;
+	struct pm_qos_class_state *st;
 	struct pm_qos_constraints *c;
 	struct pm_qos_request *req;
 	char *type;
@@ -504,9 +598,12 @@ static int pm_qos_dbg_show_requests(struct seq_file *s, void *unused)
 		pr_err("%s: Bad constraints on qos?\n", __func__);
 		return -EINVAL;
 	}
+	st = pm_qos_object_state(qos);
+	if (!st)
+		return -EINVAL;
 
 	/* Lock to ensure we have a snapshot */
-	spin_lock_irqsave(&pm_qos_lock, flags);
+	spin_lock_irqsave(&st->lock, flags);
 	if (plist_head_empty(&c->list)) {
 		seq_puts(s, "Empty!\n");
 		goto out;
@@ -544,7 +641,7 @@ static int pm_qos_dbg_show_requests(struct seq_file *s, void *unused)
 		   type, pm_qos_get_value(c), active_reqs, tot_reqs);
 
 out:
-	spin_unlock_irqrestore(&pm_qos_lock, flags);
+	spin_unlock_irqrestore(&st->lock, flags);
 	return 0;
 }
 
@@ -561,6 +658,51 @@ static const struct file_operations pm_qos_debug_fops = {
 	.release        = single_release,
 };
 
+static int pm_qos_stats_show(struct seq_file *s, void *unused)
+{
+	struct pm_qos_class_state *st;
+	unsigned long updates, rate, notifies, coalesced;
+	u64 notify_ns, notify_max_ns;
+	unsigned long flags;
+	int i;
+
+	seq_puts(s, "class updates updates/s notifies coalesced notify_avg_us notify_max_us\n");
+	for (i = PM_QOS_CPU_DMA_LATENCY; i < PM_QOS_NUM_CLASSES; i++) {
+		st = &pm_qos_state[i];
+		spin_lock_irqsave(&st->lock, flags);
+		updates = st->updates;
+		/* the last full second, if there were updates since */
+		rate = time_before(jiffies, st->rate_start + 2 * HZ) ?
+		       st->rate : 0;
+		notifies = st->notifies;
+		coalesced = st->coalesced;
+		notify_ns = st->notify_ns;
+		notify_max_ns = st->notify_max_ns;
+		spin_unlock_irqrestore(&st->lock, flags);
+
+		seq_printf(s, "%s %lu %lu %lu %lu %llu %llu\n",
+			   pm_qos_array[i]->name, updates, rate, notifies,
+			   coalesced,
+			   notifies ?
+			   div64_u64(notify_ns, notifies) / NSEC_PER_USEC : 0,
+			   div64_u64(notify_max_ns, NSEC_PER_USEC));
+	}
+
+	return 0;
+}
+
+static int pm_qos_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, pm_qos_stats_show, NULL);
+}
+
+static const struct file_operations pm_qos_stats_fops = {
+	.open           = pm_qos_stats_open,
+	.read           = seq_read,
+	.llseek         = seq_lseek,
+	.release        = single_release,
+};
+
 static inline void pm_qos_set_value_for_cpus(struct pm_qos_constraints *c,
 		struct cpumask *cpus)
 {
@@ -607,17 +749,12 @@ static inline void pm_qos_set_value_for_cpus(struct pm_qos_constraints *c,
  * This function returns 1 if the aggregated constraint value has changed, 0
  *  otherwise.
  */
-int pm_qos_update_target(struct pm_qos_constraints *c, struct plist_node *node,
-			 enum pm_qos_req_action action, int value, void *notify_param)
+static void pm_qos_apply_req(struct pm_qos_constraints *c,
+			     struct plist_node *node,
+			     enum pm_qos_req_action action, int value)
 {
-	unsigned long flags;
-	int prev_value, curr_value, new_value;
-	struct pm_qos_request *req;
-	int ret;
-
-	spin_lock_irqsave(&pm_qos_lock, flags);
+	int new_value;
 
-	prev_value = pm_qos_get_value(c);
 	if (value == PM_QOS_DEFAULT_VALUE)
 		new_value = c->default_value;
 	else
@@ -642,7 +779,20 @@ int pm_qos_update_target(struct pm_qos_constraints *c, struct plist_node *node,
 		/* no action */
 		;
 	}
+}
+
+int pm_qos_update_target(struct pm_qos_constraints *c, struct plist_node *node,
+			 enum pm_qos_req_action action, int value, void *notify_param)
+{
+	unsigned long flags;
+	int prev_value, curr_value;
+	struct pm_qos_request *req;
+	int ret;
+
+	spin_lock_irqsave(&pm_qos_lock, flags);
 
+	prev_value = pm_qos_get_value(c);
+	pm_qos_apply_req(c, node, action, value);
 	curr_value = pm_qos_get_value(c);
 	pm_qos_set_value(c, curr_value);
 
@@ -677,6 +827,120 @@ int pm_qos_update_target(struct pm_qos_constraints *c, struct plist_node *node,
 	return ret;
 }
 
+static void pm_qos_call_notifiers(struct pm_qos_class_state *st,
+				  struct pm_qos_constraints *c, s32 value,
+				  void *notify_param)
+{
+	unsigned long flags;
+	ktime_t start = ktime_get();
+	u64 ns;
+
+	blocking_notifier_call_chain(c->notifiers, (unsigned long)value,
+				     notify_param);
+
+	ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+	spin_lock_irqsave(&st->lock, flags);
+	st->notifies++;
+	st->notify_ns += ns;
+	st->notify_max_ns = max(st->notify_max_ns, ns);
+	spin_unlock_irqrestore(&st->lock, flags);
+}
+
+static void pm_qos_notify_work_fn(struct work_struct *work)
+{
+	struct pm_qos_class_state *st = container_of(to_delayed_work(work),
+						     struct pm_qos_class_state,
+						     notify_work);
+	struct pm_qos_constraints *c = pm_qos_array[st->class]->constraints;
+	unsigned long flags;
+
+	spin_lock_irqsave(&st->lock, flags);
+	st->pending = false;
+	st->window_end = jiffies + msecs_to_jiffies(notify_coalesce_ms);
+	spin_unlock_irqrestore(&st->lock, flags);
+
+	pm_qos_call_notifiers(st, c, READ_ONCE(c->target_value), &st->class);
+}
+
+/*
+ * Notify a change of the class value, or hold it back when it comes within
+ * the coalescing window of the previous one. Only notifications with the
+ * default parameter, the class, are coalesced: callers passing their own
+ * expect notifiers to see it.
+ */
+static void pm_qos_class_notify(int pm_qos_class, s32 value,
+				void *notify_param)
+{
+	struct pm_qos_class_state *st = &pm_qos_state[pm_qos_class];
+	struct pm_qos_constraints *c = pm_qos_array[pm_qos_class]->constraints;
+	unsigned int window = READ_ONCE(notify_coalesce_ms);
+	unsigned long flags;
+
+	if (window && !notify_param && READ_ONCE(pm_qos_notify_ready)) {
+		spin_lock_irqsave(&st->lock, flags);
+		if (time_before(jiffies, st->window_end)) {
+			st->coalesced++;
+			if (!st->pending) {
+				st->pending = true;
+				schedule_delayed_work(&st->notify_work,
+						      st->window_end - jiffies);
+			}
+			spin_unlock_irqrestore(&st->lock, flags);
+			return;
+		}
+		st->window_end = jiffies + msecs_to_jiffies(window);
+		spin_unlock_irqrestore(&st->lock, flags);
+	}
+
+	if (!notify_param)
+		notify_param = &st->class;
+	pm_qos_call_notifiers(st, c, value, notify_param);
+}
+
+/*
+ * pm_qos_update_target() for the classes of pm_qos_array, under their own
+ * lock, and with the notifications going through pm_qos_class_notify().
+ */
+static int pm_qos_update_class(int pm_qos_class, struct plist_node *node,
+			       enum pm_qos_req_action action, int value,
+			       void *notify_param)
+{
+	struct pm_qos_class_state *st = &pm_qos_state[pm_qos_class];
+	struct pm_qos_constraints *c = pm_qos_array[pm_qos_class]->constraints;
+	unsigned long flags;
+	int prev_value, curr_value;
+
+	spin_lock_irqsave(&st->lock, flags);
+	write_seqcount_begin(&st->seq);
+
+	prev_value = pm_qos_get_value(c);
+	pm_qos_apply_req(c, node, action, value);
+	curr_value = pm_qos_get_value(c);
+	pm_qos_set_value(c, curr_value);
+
+	write_seqcount_end(&st->seq);
+
+	st->updates++;
+	if (time_after_eq(jiffies, st->rate_start + HZ)) {
+		st->rate = time_before(jiffies, st->rate_start + 2 * HZ) ?
+			   st->rate_count : 0;
+		st->rate_count = 0;
+		st->rate_start = jiffies;
+	}
+	st->rate_count++;
+
+	spin_unlock_irqrestore(&st->lock, flags);
+
+	trace_pm_qos_update_target(action, prev_value, curr_value);
+
+	if (c->type != PM_QOS_FORCE_MAX && prev_value == curr_value)
+		return 0;
+
+	if (c->notifiers)
+		pm_qos_class_notify(pm_qos_class, curr_value, notify_param);
+	return 1;
+}
+
 /**
  * pm_qos_update_constraints - update new constraints attributes
  * @pm_qos_class: identification of which qos value is requested
@@ -794,19 +1058,20 @@ bool pm_qos_update_flags(struct pm_qos_flags *pqf,
  */
 int pm_qos_read_req_value(int pm_qos_class, struct pm_qos_request *req)
 {
+	struct pm_qos_class_state *st = &pm_qos_state[pm_qos_class];
 	struct plist_node *p;
 	unsigned long flags;
 
-	spin_lock_irqsave(&pm_qos_lock, flags);
+	spin_lock_irqsave(&st->lock, flags);
 
 	plist_for_each(p, &pm_qos_array[pm_qos_class]->constraints->list) {
 		if (req == container_of(p, struct pm_qos_request, node)) {
-			spin_unlock_irqrestore(&pm_qos_lock, flags);
+			spin_unlock_irqrestore(&st->lock, flags);
 			return p->prio;
 		}
 	}
 
-	spin_unlock_irqrestore(&pm_qos_lock, flags);
+	spin_unlock_irqrestore(&st->lock, flags);
 
 	return -ENODATA;
 }
@@ -841,12 +1106,14 @@ EXPORT_SYMBOL_GPL(pm_qos_request_active);
 
 int pm_qos_request_for_cpumask(int pm_qos_class, struct cpumask *mask)
 {
-	unsigned long irqflags;
+	struct pm_qos_class_state *st = &pm_qos_state[pm_qos_class];
+	unsigned int seq;
 	int cpu;
 	struct pm_qos_constraints *c = NULL;
 	int val;
-	spin_lock_irqsave(&pm_qos_lock, irqflags);
 	c = pm_qos_array[pm_qos_class]->constraints;
+retry:
+	seq = read_seqcount_begin(&st->seq);
 	val = c->default_value;
 
 	for_each_cpu(cpu, mask) {
@@ -868,7 +1135,8 @@ int pm_qos_request_for_cpumask(int pm_qos_class, struct cpumask *mask)
 			break;
 		}
 	}
-	spin_unlock_irqrestore(&pm_qos_lock, irqflags);
+	if (read_seqcount_retry(&st->seq, seq))
+		goto retry;
 	return val;
 }
 EXPORT_SYMBOL(pm_qos_request_for_cpumask);
@@ -879,9 +1147,8 @@ static void __pm_qos_update_request(struct pm_qos_request *req,
 	trace_pm_qos_update_request(req->pm_qos_class, new_value);
 
 	if (new_value != req->node.prio)
-		pm_qos_update_target(
-			pm_qos_array[req->pm_qos_class]->constraints,
-			&req->node, PM_QOS_UPDATE_REQ, new_value, notify_param);
+		pm_qos_update_class(req->pm_qos_class, &req->node,
+				    PM_QOS_UPDATE_REQ, new_value, notify_param);
 }
 
 /**
@@ -928,8 +1195,8 @@ void pm_qos_add_request_trace(char *func, unsigned int line,
 	req->line = line;
 	INIT_DELAYED_WORK(&req->work, pm_qos_work_fn);
 	trace_pm_qos_add_request(pm_qos_class, value);
-	pm_qos_update_target(pm_qos_array[pm_qos_class]->constraints,
-			     &req->node, PM_QOS_ADD_REQ, value, NULL);
+	pm_qos_update_class(pm_qos_class, &req->node, PM_QOS_ADD_REQ, value,
+			    NULL);
 }
 EXPORT_SYMBOL_GPL(pm_qos_add_request_trace);
 
@@ -1013,9 +1280,8 @@ void pm_qos_update_request_timeout(struct pm_qos_request *req, s32 new_value,
 	trace_pm_qos_update_request_timeout(req->pm_qos_class,
 					    new_value, timeout_us);
 	if (new_value != req->node.prio)
-		pm_qos_update_target(
-			pm_qos_array[req->pm_qos_class]->constraints,
-			&req->node, PM_QOS_UPDATE_REQ, new_value, NULL);
+		pm_qos_update_class(req->pm_qos_class, &req->node,
+				    PM_QOS_UPDATE_REQ, new_value, NULL);
 
 	schedule_delayed_work(&req->work, usecs_to_jiffies(timeout_us));
 }
@@ -1043,9 +1309,8 @@ void pm_qos_remove_request(struct pm_qos_request *req)
 		cancel_delayed_work_sync(&req->work);
 
 	trace_pm_qos_remove_request(req->pm_qos_class, PM_QOS_DEFAULT_VALUE);
-	pm_qos_update_target(pm_qos_array[req->pm_qos_class]->constraints,
-			     &req->node, PM_QOS_REMOVE_REQ,
-			     PM_QOS_DEFAULT_VALUE, NULL);
+	pm_qos_update_class(req->pm_qos_class, &req->node, PM_QOS_REMOVE_REQ,
+			    PM_QOS_DEFAULT_VALUE, NULL);
 	memset(req, 0, sizeof(*req));
 }
 EXPORT_SYMBOL_GPL(pm_qos_remove_request);
@@ -1152,7 +1417,6 @@ static ssize_t pm_qos_power_read(struct file *filp, char __user *buf,
 		size_t count, loff_t *f_pos)
 {
 	s32 value;
-	unsigned long flags;
 	struct pm_qos_request *req = filp->private_data;
 
 	if (!req)
@@ -1160,9 +1424,8 @@ static ssize_t pm_qos_power_read(struct file *filp, char __user *buf,
 	if (!pm_qos_request_active(req))
 		return -EINVAL;
 
-	spin_lock_irqsave(&pm_qos_lock, flags);
-	value = pm_qos_get_value(pm_qos_array[req->pm_qos_class]->constraints);
-	spin_unlock_irqrestore(&pm_qos_lock, flags);
+	/* kept equal to pm_qos_get_value() by every update */
+	value = pm_qos_request(req->pm_qos_class);
 
 	return simple_read_from_buffer(buf, count, f_pos, &value, sizeof(s32));
 }
@@ -1201,12 +1464,15 @@ static int __init pm_qos_power_init(void)
 
 	BUILD_BUG_ON(ARRAY_SIZE(pm_qos_array) != PM_QOS_NUM_CLASSES);
 
-	/* Don't let userspace impose restrictions on CPU idle levels */
-	return 0;
-
 	d = debugfs_create_dir("pm_qos", NULL);
 	if (IS_ERR_OR_NULL(d))
 		d = NULL;
+	else
+		debugfs_create_file("stats", S_IRUGO, d, NULL,
+				    &pm_qos_stats_fops);
+
+	/* Don't let userspace impose restrictions on CPU idle levels */
+	return 0;
 
 	for (i = PM_QOS_CPU_DMA_LATENCY; i < PM_QOS_NUM_CLASSES; i++) {
 		ret = register_pm_qos_misc(pm_qos_array[i], d);
@@ -1221,3 +1487,18 @@ static int __init pm_qos_power_init(void)
 }
 
 late_initcall(pm_qos_power_init);
+
+static int __init pm_qos_state_init(void)
+{
+	int i;
+
+	for (i = 0; i < PM_QOS_NUM_CLASSES; i++) {
+		pm_qos_state[i].class = i;
+		INIT_DELAYED_WORK(&pm_qos_state[i].notify_work,
+				  pm_qos_notify_work_fn);
+	}
+	WRITE_ONCE(pm_qos_notify_ready, true);
+
+	return 0;
+}
+core_initcall(pm_qos_state_init);
@@ -0,0 +1,473 @@
+/*
+ * kernel/power/resume_deps.c - explicit ordering of async device resume,
+ * and a report of where the resume time goes
+ *
+ * Devices marked async by device_enable_async_suspend() are resumed from
+ * their own thread as soon as their parent is. That is only safe for a
+ * device needing nothing but its parent; one also needing, say, a PHY or a
+ * clock provider elsewhere in the tree has so far had to stay synchronous,
+ * and with it everything behind it in dpm_list. Drivers record such needs
+ * with device_pm_add_resume_dep(), which also marks the device async, and
+ * wait for them from their callbacks:
+ *
+ *	resume:  device_pm_wait_resume_deps(dev) before touching a supplier
+ *	suspend: device_pm_wait_suspend_deps(dev) in the supplier, before
+ *		 going down under a consumer that may still be suspending
+ *
+ * Both are based on device_pm_wait_for_dev(), so they do nothing unless
+ * async suspend is in use.
+ *
+ * The time of every device's resume callbacks is recorded from the
+ * device_pm_callback_* tracepoints and reported in debugfs, in
+ * pm_resume_report, ordered by the time spent and with the devices on the
+ * critical path, the chain of callbacks each waiting for the previous one,
+ * marked with a '*'.
+ *
+ * This file is released under the GPLv2.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/device.h>
+#include <linux/hashtable.h>
+#include <linux/init.h>
+#include <linux/ktime.h>
+#include <linux/of.h>
+#include <linux/of_platform.h>
+#include <linux/pm.h>
+#include <linux/rwsem.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/spinlock.h>
+#include <linux/suspend.h>
+#include <linux/vmalloc.h>
+#include <trace/events/power.h>
+
+struct resume_dep {
+	struct list_head node;
+	struct device *dev;
+	struct device *supplier;
+};
+
+static LIST_HEAD(resume_deps);
+static DECLARE_RWSEM(resume_deps_rwsem);
+
+/* whether @dev needs @supplier, directly or through other suppliers */
+static bool resume_dep_needs(struct device *dev, struct device *supplier,
+			     int depth)
+{
+	struct resume_dep *dep;
+
+	if (dev == supplier)
+		return true;
+	/* chains that long are refused as if they looped */
+	if (depth > 8)
+		return true;
+
+	list_for_each_entry(dep, &resume_deps, node)
+		if (dep->dev == dev &&
+		    resume_dep_needs(dep->supplier, supplier, depth + 1))
+			return true;
+
+	return false;
+}
+
+/**
+ * device_pm_add_resume_dep - make a device resume after another one
+ * @dev: device whose resume needs @supplier
+ * @supplier: device to be resumed first, and suspended last
+ *
+ * Marks @dev for async suspend and resume. The dependency is kept until
+ * device_pm_remove_resume_deps() is called for either device, which the
+ * driver of @dev is to do before it is unbound.
+ *
+ * Return: 0, -EINVAL if @supplier already needs @dev, or -ENOMEM.
+ */
+int device_pm_add_resume_dep(struct device *dev, struct device *supplier)
+{
+	struct resume_dep *dep;
+	int ret = 0;
+
+	dep = kzalloc(sizeof(*dep), GFP_KERNEL);
+	if (!dep)
+		return -ENOMEM;
+
+	down_write(&resume_deps_rwsem);
+	if (resume_dep_needs(supplier, dev, 0)) {
+		dev_warn(dev, "%s already depends on it for resume\n",
+			 dev_name(supplier));
+		kfree(dep);
+		ret = -EINVAL;
+		goto out;
+	}
+
+	dep->dev = get_device(dev);
+	dep->supplier = get_device(supplier);
+	list_add_tail(&dep->node, &resume_deps);
+	device_enable_async_suspend(dev);
+out:
+	up_write(&resume_deps_rwsem);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(device_pm_add_resume_dep);
+
+/**
+ * device_pm_remove_resume_deps - drop the dependencies of and on a device
+ * @dev: device going away
+ */
+void device_pm_remove_resume_deps(struct device *dev)
+{
+	struct resume_dep *dep, *tmp;
+
+	down_write(&resume_deps_rwsem);
+	list_for_each_entry_safe(dep, tmp, &resume_deps, node) {
+		if (dep->dev != dev && dep->supplier != dev)
+			continue;
+
+		list_del(&dep->node);
+		put_device(dep->supplier);
+		put_device(dep->dev);
+		kfree(dep);
+	}
+	up_write(&resume_deps_rwsem);
+}
+EXPORT_SYMBOL_GPL(device_pm_remove_resume_deps);
+
+/**
+ * of_device_pm_add_resume_deps - add the dependencies listed in DT
+ * @dev: device with an "samsung,resume-depends" list of phandles
+ *
+ * Return: 0 or the error of the first dependency that could not be added;
+ * -EPROBE_DEFER if a supplier has no device yet.
+ */
+int of_device_pm_add_resume_deps(struct device *dev)
+{
+	struct platform_device *pdev;
+	struct device_node *np;
+	int i, ret = 0;
+
+	if (!dev->of_node)
+		return 0;
+
+	for (i = 0; !ret; i++) {
+		np = of_parse_phandle(dev->of_node, "samsung,resume-depends", i);
+		if (!np)
+			break;
+
+		pdev = of_find_device_by_node(np);
+		of_node_put(np);
+		if (!pdev) {
+			ret = -EPROBE_DEFER;
+			break;
+		}
+
+		ret = device_pm_add_resume_dep(dev, &pdev->dev);
+		put_device(&pdev->dev);
+	}
+
+	if (ret)
+		device_pm_remove_resume_deps(dev);
+	return ret;
+}
+EXPORT_SYMBOL_GPL(of_device_pm_add_resume_deps);
+
+static void resume_report_waited(struct device *dev, s64 us);
+
+/**
+ * device_pm_wait_resume_deps - wait for the suppliers of a device to resume
+ * @dev: device being resumed
+ *
+ * Return: 0 or the error of a supplier's resume.
+ */
+int device_pm_wait_resume_deps(struct device *dev)
+{
+	struct resume_dep *dep;
+	ktime_t start = ktime_get();
+	int ret = 0;
+
+	down_read(&resume_deps_rwsem);
+	list_for_each_entry(dep, &resume_deps, node)
+		if (dep->dev == dev && !ret)
+			ret = device_pm_wait_for_dev(dev, dep->supplier);
+	up_read(&resume_deps_rwsem);
+
+	resume_report_waited(dev, ktime_us_delta(ktime_get(), start));
+	return ret;
+}
+EXPORT_SYMBOL_GPL(device_pm_wait_resume_deps);
+
+/**
+ * device_pm_wait_suspend_deps - wait for the consumers of a device to suspend
+ * @dev: supplier being suspended
+ *
+ * Return: 0 or the error of a consumer's suspend.
+ */
+int device_pm_wait_suspend_deps(struct device *dev)
+{
+	struct resume_dep *dep;
+	int ret = 0;
+
+	down_read(&resume_deps_rwsem);
+	list_for_each_entry(dep, &resume_deps, node)
+		if (dep->supplier == dev && !ret)
+			ret = device_pm_wait_for_dev(dev, dep->dev);
+	up_read(&resume_deps_rwsem);
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(device_pm_wait_suspend_deps);
+
+/*
+ * Resume time report
+ */
+
+#define RESUME_REPORT_MAX	512
+#define RESUME_REPORT_HASH_BITS	7
+
+struct resume_record {
+	struct hlist_node hnode;
+	/* for lookups only, never dereferenced */
+	const struct device *dev;
+	const struct device *parent;
+	char name[32];
+	char driver[24];
+	bool async;
+	ktime_t cur;
+	ktime_t first;
+	ktime_t last;
+	s64 total_us;
+	s64 wait_us;
+	bool critical;
+};
+
+static struct resume_record resume_records[RESUME_REPORT_MAX];
+static unsigned int resume_nr_records;
+static unsigned int resume_dropped;
+static DEFINE_HASHTABLE(resume_hash, RESUME_REPORT_HASH_BITS);
+static DEFINE_SPINLOCK(resume_report_lock);
+static ktime_t resume_end;
+
+static struct resume_record *resume_record_find(const struct device *dev)
+{
+	struct resume_record *rec;
+
+	hash_for_each_possible(resume_hash, rec, hnode, (unsigned long)dev)
+		if (rec->dev == dev)
+			return rec;
+
+	return NULL;
+}
+
+static void resume_report_start(void *ignore, struct device *dev,
+				const char *pm_ops, int event)
+{
+	struct resume_record *rec;
+	unsigned long flags;
+
+	if (event != PM_EVENT_RESUME)
+		return;
+
+	spin_lock_irqsave(&resume_report_lock, flags);
+	rec = resume_record_find(dev);
+	if (!rec) {
+		if (resume_nr_records == RESUME_REPORT_MAX) {
+			resume_dropped++;
+			goto out;
+		}
+
+		rec = &resume_records[resume_nr_records++];
+		rec->dev = dev;
+		rec->parent = dev->parent;
+		strlcpy(rec->name, dev_name(dev), sizeof(rec->name));
+		strlcpy(rec->driver, dev_driver_string(dev),
+			sizeof(rec->driver));
+		rec->async = device_async_suspend_enabled(dev);
+		rec->first = ktime_get();
+		hash_add(resume_hash, &rec->hnode, (unsigned long)dev);
+	}
+	rec->cur = ktime_get();
+out:
+	spin_unlock_irqrestore(&resume_report_lock, flags);
+}
+
+static void resume_report_end(void *ignore, struct device *dev, int error)
+{
+	struct resume_record *rec;
+	unsigned long flags;
+
+	spin_lock_irqsave(&resume_report_lock, flags);
+	rec = resume_record_find(dev);
+	if (rec && rec->cur.tv64) {
+		rec->last = ktime_get();
+		rec->total_us += ktime_us_delta(rec->last, rec->cur);
+		rec->cur.tv64 = 0;
+	}
+	spin_unlock_irqrestore(&resume_report_lock, flags);
+}
+
+static void resume_report_waited(struct device *dev, s64 us)
+{
+	struct resume_record *rec;
+	unsigned long flags;
+
+	spin_lock_irqsave(&resume_report_lock, flags);
+	rec = resume_record_find(dev);
+	if (rec)
+		rec->wait_us += us;
+	spin_unlock_irqrestore(&resume_report_lock, flags);
+}
+
+static int resume_report_pm_notifier(struct notifier_block *nb,
+				     unsigned long event, void *unused)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&resume_report_lock, flags);
+	switch (event) {
+	case PM_SUSPEND_PREPARE:
+		hash_init(resume_hash);
+		memset(resume_records, 0, sizeof(resume_records));
+		resume_nr_records = 0;
+		resume_dropped = 0;
+		resume_end.tv64 = 0;
+		break;
+	case PM_POST_SUSPEND:
+		resume_end = ktime_get();
+		break;
+	}
+	spin_unlock_irqrestore(&resume_report_lock, flags);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block resume_report_nb = {
+	.notifier_call = resume_report_pm_notifier,
+};
+
+/*
+ * The record a device waited for last: the latest ending among its parent
+ * and suppliers that ended before it started, or, for a synchronous one,
+ * among all the devices.
+ */
+static struct resume_record *resume_record_pred(struct resume_record *rec,
+						struct resume_record *recs,
+						unsigned int nr)
+{
+	struct resume_record *best = NULL, *it;
+	struct resume_dep *dep;
+	unsigned int i;
+
+	for (i = 0; i < nr; i++) {
+		bool linked;
+
+		it = &recs[i];
+		if (it == rec || !it->last.tv64 ||
+		    ktime_after(it->last, rec->first))
+			continue;
+
+		linked = !rec->async || it->dev == rec->parent;
+		list_for_each_entry(dep, &resume_deps, node)
+			if (dep->dev == rec->dev && dep->supplier == it->dev)
+				linked = true;
+		if (!linked)
+			continue;
+
+		if (!best || ktime_after(it->last, best->last))
+			best = it;
+	}
+
+	return best;
+}
+
+static int resume_record_cmp(const void *a, const void *b)
+{
+	const struct resume_record *ra = a, *rb = b;
+
+	if (ra->total_us == rb->total_us)
+		return 0;
+	return ra->total_us < rb->total_us ? 1 : -1;
+}
+
+static int resume_report_show(struct seq_file *s, void *unused)
+{
+	struct resume_record *recs, *rec, *last = NULL;
+	unsigned int nr, dropped, i;
+	ktime_t first = { .tv64 = 0 }, end;
+	unsigned long flags;
+
+	recs = vmalloc(sizeof(resume_records));
+	if (!recs)
+		return -ENOMEM;
+
+	spin_lock_irqsave(&resume_report_lock, flags);
+	nr = resume_nr_records;
+	dropped = resume_dropped;
+	end = resume_end;
+	memcpy(recs, resume_records, nr * sizeof(*recs));
+	spin_unlock_irqrestore(&resume_report_lock, flags);
+
+	for (i = 0; i < nr; i++) {
+		if (!first.tv64 || ktime_before(recs[i].first, first))
+			first = recs[i].first;
+		if (!last || ktime_after(recs[i].last, last->last))
+			last = &recs[i];
+	}
+
+	/* walk back from the callback ending last */
+	down_read(&resume_deps_rwsem);
+	for (rec = last; rec && !rec->critical;
+	     rec = resume_record_pred(rec, recs, nr))
+		rec->critical = true;
+	up_read(&resume_deps_rwsem);
+
+	sort(recs, nr, sizeof(*recs), resume_record_cmp, NULL);
+
+	seq_printf(s, "devices: %u dropped: %u resume_us: %lld\n", nr, dropped,
+		   first.tv64 && end.tv64 ? ktime_us_delta(end, first) : 0);
+	seq_printf(s, "  %-32s %-24s %5s %10s %10s %10s %10s\n", "device",
+		   "driver", "async", "start_us", "end_us", "time_us",
+		   "wait_us");
+
+	for (i = 0; i < nr; i++) {
+		rec = &recs[i];
+		seq_printf(s, "%c %-32s %-24s %5s %10lld %10lld %10lld %10lld\n",
+			   rec->critical ? '*' : ' ', rec->name, rec->driver,
+			   rec->async ? "yes" : "no",
+			   ktime_us_delta(rec->first, first),
+			   rec->last.tv64 ? ktime_us_delta(rec->last, first) : -1,
+			   rec->total_us, rec->wait_us);
+	}
+
+	vfree(recs);
+	return 0;
+}
+
+static int resume_report_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, resume_report_show, NULL);
+}
+
+static const struct file_operations resume_report_fops = {
+	.open		= resume_report_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init resume_report_init(void)
+{
+	if (register_trace_device_pm_callback_start(resume_report_start, NULL))
+		return 0;
+	if (register_trace_device_pm_callback_end(resume_report_end, NULL)) {
+		unregister_trace_device_pm_callback_start(resume_report_start,
+							  NULL);
+		return 0;
+	}
+
+	register_pm_notifier(&resume_report_nb);
+	debugfs_create_file("pm_resume_report", S_IRUGO, NULL, NULL,
+			    &resume_report_fops);
+
+	return 0;
+}
+late_initcall(resume_report_init);
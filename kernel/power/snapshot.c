@@ -1609,6 +1609,23 @@ static unsigned long minimum_image_size(unsigned long saveable)
 	return saveable <= size ? 0 : saveable - size;
 }
 
+/*
+ * Page cache that is neither mapped nor dirty, which the restored system can
+ * read back from storage when it needs it rather than from the image.
+ */
+static unsigned long clean_cache_pages(void)
+{
+	long size;
+
+	size = global_page_state(NR_ACTIVE_FILE)
+		+ global_page_state(NR_INACTIVE_FILE)
+		- global_page_state(NR_FILE_MAPPED)
+		- global_page_state(NR_FILE_DIRTY)
+		- global_page_state(NR_WRITEBACK);
+
+	return size > 0 ? size : 0;
+}
+
 /**
  * hibernate_preallocate_memory - Preallocate memory for hibernation image
  *
@@ -1686,6 +1703,9 @@ int hibernate_preallocate_memory(void)
 	size = DIV_ROUND_UP(image_size, PAGE_SIZE);
 	if (size > max_size)
 		size = max_size;
+	/* For a fast restore, the clean page cache is left out of the image. */
+	if (hibernate_fast_restore)
+		size = min(size, saveable - min(saveable, clean_cache_pages()));
 	/*
 	 * If the desired number of image pages is at least as large as the
 	 * current number of saveable pages in memory, allocate page frames for
@@ -25,6 +25,7 @@
 #include <linux/pm.h>
 #include <linux/slab.h>
 #include <linux/lzo.h>
+#include <linux/lz4.h>
 #include <linux/vmalloc.h>
 #include <linux/cpumask.h>
 #include <linux/atomic.h>
@@ -516,6 +517,49 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 #define LZO_MIN_RD_PAGES	1024
 #define LZO_MAX_RD_PAGES	8192
 
+/*
+ * LZ4, used for fast restore images, runs a thread on every cpu but one and
+ * decompresses fast enough for much larger reads to keep it busy. Its chunks
+ * are laid out as LZO ones, as the worst case of LZ4 is the smaller.
+ */
+#define LZ4_THREADS		8
+#define LZ4_MAX_RD_PAGES	32768
+
+#define CMP_MAX_THREADS		LZ4_THREADS
+#define CMP_WRK_SIZE		(LZO1X_1_MEM_COMPRESS > LZ4_MEM_COMPRESS ? \
+				 LZO1X_1_MEM_COMPRESS : LZ4_MEM_COMPRESS)
+
+/*
+ * Time spent in each stage of the last image load. Kept out of the image, so
+ * that the restored kernel finds what the boot kernel recorded.
+ */
+static struct {
+	bool lz4;
+	unsigned int threads;
+	unsigned int pages;
+	u64 cmp_bytes;
+	s64 total_us;
+	s64 io_wait_us;
+	s64 decompress_us;
+	s64 copy_us;
+	s64 crc_wait_us;
+} restore_stats __nosavedata;
+
+ssize_t swsusp_restore_stats_show(char *buf)
+{
+	return sprintf(buf,
+		       "algorithm: %s\nthreads: %u\npages: %u\n"
+		       "compressed_bytes: %llu\ntotal_us: %lld\n"
+		       "io_wait_us: %lld\ndecompress_us: %lld\n"
+		       "copy_us: %lld\ncrc_wait_us: %lld\n",
+		       restore_stats.threads ?
+				(restore_stats.lz4 ? "lz4" : "lzo") : "none",
+		       restore_stats.threads, restore_stats.pages,
+		       restore_stats.cmp_bytes, restore_stats.total_us,
+		       restore_stats.io_wait_us, restore_stats.decompress_us,
+		       restore_stats.copy_us, restore_stats.crc_wait_us);
+}
+
 
 /**
  *	save_image - save the suspend image data
@@ -575,8 +619,8 @@ struct crc_data {
 	wait_queue_head_t go;                     /* start crc update */
 	wait_queue_head_t done;                   /* crc update done */
 	u32 *crc32;                               /* points to handle's crc32 */
-	size_t *unc_len[LZO_THREADS];             /* uncompressed lengths */
-	unsigned char *unc[LZO_THREADS];          /* uncompressed data */
+	size_t *unc_len[CMP_MAX_THREADS];         /* uncompressed lengths */
+	unsigned char *unc[CMP_MAX_THREADS];      /* uncompressed data */
 };
 
 /**
@@ -607,20 +651,21 @@ static int crc32_threadfn(void *data)
 	return 0;
 }
 /**
- * Structure used for LZO data compression.
+ * Structure used for LZO/LZ4 data compression.
  */
 struct cmp_data {
 	struct task_struct *thr;                  /* thread */
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
+	bool lz4;                                 /* LZ4 instead of LZO */
 	wait_queue_head_t go;                     /* start compression */
 	wait_queue_head_t done;                   /* compression done */
 	size_t unc_len;                           /* uncompressed length */
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
-	unsigned char wrk[LZO1X_1_MEM_COMPRESS];  /* compression workspace */
+	unsigned char wrk[CMP_WRK_SIZE];          /* compression workspace */
 };
 
 /**
@@ -642,9 +687,18 @@ static int lzo_compress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->ret = lzo1x_1_compress(d->unc, d->unc_len,
-		                          d->cmp + LZO_HEADER, &d->cmp_len,
-		                          d->wrk);
+		if (d->lz4) {
+			int len = LZ4_compress_default((const char *)d->unc,
+					(char *)d->cmp + LZO_HEADER, d->unc_len,
+					LZO_CMP_SIZE - LZO_HEADER, d->wrk);
+
+			d->cmp_len = len > 0 ? len : 0;
+			d->ret = len > 0 ? 0 : -1;
+		} else {
+			d->ret = lzo1x_1_compress(d->unc, d->unc_len,
+			                          d->cmp + LZO_HEADER,
+			                          &d->cmp_len, d->wrk);
+		}
 		atomic_set(&d->stop, 1);
 		wake_up(&d->done);
 	}
@@ -652,14 +706,15 @@ static int lzo_compress_threadfn(void *data)
 }
 
 /**
- * save_image_lzo - Save the suspend image data compressed with LZO.
+ * save_image_lzo - Save the suspend image data compressed with LZO or LZ4.
  * @handle: Swap map handle to use for saving the image.
  * @snapshot: Image to read data from.
  * @nr_to_write: Number of pages to save.
+ * @lz4: Compress with LZ4 on all cpus rather than with LZO.
  */
 static int save_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_write)
+                          unsigned int nr_to_write, bool lz4)
 {
 	unsigned int m;
 	int ret = 0;
@@ -680,8 +735,10 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	 * We'll limit the number of threads for compression to limit memory
 	 * footprint.
 	 */
+	BUILD_BUG_ON(LZ4_COMPRESSBOUND(LZO_UNC_SIZE) >
+		     lzo1x_worst_compress(LZO_UNC_SIZE));
 	nr_threads = num_online_cpus() - 1;
-	nr_threads = clamp_val(nr_threads, 1, LZO_THREADS);
+	nr_threads = clamp_val(nr_threads, 1, lz4 ? LZ4_THREADS : LZO_THREADS);
 
 	page = (void *)__get_free_page(__GFP_RECLAIM | __GFP_HIGH);
 	if (!page) {
@@ -696,8 +753,10 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct cmp_data, go));
+		data[thr].lz4 = lz4;
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -754,9 +813,9 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	handle->reqd_free_pages = reqd_free_pages();
 
 	printk(KERN_INFO
-		"PM: Using %u thread(s) for compression.\n"
+		"PM: Using %u thread(s) for %s compression.\n"
 		"PM: Compressing and saving image data (%u pages)...\n",
-		nr_threads, nr_to_write);
+		nr_threads, lz4 ? "LZ4" : "LZO", nr_to_write);
 	m = nr_to_write / 10;
 	if (!m)
 		m = 1;
@@ -806,7 +865,8 @@ static int save_image_lzo(struct swap_map_handle *handle,
 			ret = data[thr].ret;
 
 			if (ret < 0) {
-				printk(KERN_ERR "PM: LZO compression failed\n");
+				printk(KERN_ERR "PM: %s compression failed\n",
+				       lz4 ? "LZ4" : "LZO");
 				goto out_finish;
 			}
 
@@ -931,7 +991,8 @@ int swsusp_write(unsigned int flags)
 	if (!error) {
 		error = (flags & SF_NOCOMPRESS_MODE) ?
 			save_image(&handle, &snapshot, pages - 1) :
-			save_image_lzo(&handle, &snapshot, pages - 1);
+			save_image_lzo(&handle, &snapshot, pages - 1,
+				       flags & SF_LZ4_MODE);
 	}
 out_finish:
 	error = swap_writer_finish(&handle, flags, error);
@@ -1099,13 +1160,15 @@ static int load_image(struct swap_map_handle *handle,
 }
 
 /**
- * Structure used for LZO data decompression.
+ * Structure used for LZO/LZ4 data decompression.
  */
 struct dec_data {
 	struct task_struct *thr;                  /* thread */
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
+	bool lz4;                                 /* LZ4 instead of LZO */
+	s64 busy_us;                              /* time decompressing */
 	wait_queue_head_t go;                     /* start decompression */
 	wait_queue_head_t done;                   /* decompression done */
 	size_t unc_len;                           /* uncompressed length */
@@ -1120,6 +1183,7 @@ struct dec_data {
 static int lzo_decompress_threadfn(void *data)
 {
 	struct dec_data *d = data;
+	ktime_t start;
 
 	while (1) {
 		wait_event(d->go, atomic_read(&d->ready) ||
@@ -1133,12 +1197,25 @@ static int lzo_decompress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
+		start = ktime_get();
 		d->unc_len = LZO_UNC_SIZE;
-		d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER, d->cmp_len,
-		                               d->unc, &d->unc_len);
+		if (d->lz4) {
+			int len = LZ4_decompress_safe(
+					(const char *)d->cmp + LZO_HEADER,
+					(char *)d->unc, d->cmp_len,
+						      LZO_UNC_SIZE);
+
+			d->unc_len = len > 0 ? len : 0;
+			d->ret = len > 0 ? 0 : -1;
+		} else {
+			d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER,
+			                               d->cmp_len, d->unc,
+			                               &d->unc_len);
+		}
 		if (clean_pages_on_decompress)
 			flush_icache_range((unsigned long)d->unc,
 					   (unsigned long)d->unc + d->unc_len);
+		d->busy_us += ktime_us_delta(ktime_get(), start);
 
 		atomic_set(&d->stop, 1);
 		wake_up(&d->done);
@@ -1147,14 +1224,16 @@ static int lzo_decompress_threadfn(void *data)
 }
 
 /**
- * load_image_lzo - Load compressed image data and decompress them with LZO.
+ * load_image_lzo - Load compressed image data and decompress them with LZO
+ * or LZ4.
  * @handle: Swap map handle to use for loading data.
  * @snapshot: Image to copy uncompressed data into.
  * @nr_to_read: Number of pages to load.
+ * @lz4: The image was compressed with LZ4 rather than with LZO.
  */
 static int load_image_lzo(struct swap_map_handle *handle,
                           struct snapshot_handle *snapshot,
-                          unsigned int nr_to_read)
+                          unsigned int nr_to_read, bool lz4)
 {
 	unsigned int m;
 	int ret = 0;
@@ -1167,21 +1246,24 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	unsigned i, thr, run_threads, nr_threads;
 	unsigned ring = 0, pg = 0, ring_size = 0,
 	         have = 0, want, need, asked = 0;
-	unsigned long read_pages = 0;
+	unsigned long read_pages = 0, max_rd_pages;
 	unsigned char **page = NULL;
 	struct dec_data *data = NULL;
 	struct crc_data *crc = NULL;
+	ktime_t t;
 
 	hib_init_batch(&hb);
+	memset(&restore_stats, 0, sizeof(restore_stats));
 
 	/*
 	 * We'll limit the number of threads for decompression to limit memory
 	 * footprint.
 	 */
 	nr_threads = num_online_cpus() - 1;
-	nr_threads = clamp_val(nr_threads, 1, LZO_THREADS);
+	nr_threads = clamp_val(nr_threads, 1, lz4 ? LZ4_THREADS : LZO_THREADS);
+	max_rd_pages = lz4 ? LZ4_MAX_RD_PAGES : LZO_MAX_RD_PAGES;
 
-	page = vmalloc(sizeof(*page) * LZO_MAX_RD_PAGES);
+	page = vmalloc(sizeof(*page) * max_rd_pages);
 	if (!page) {
 		printk(KERN_ERR "PM: Failed to allocate LZO page\n");
 		ret = -ENOMEM;
@@ -1194,8 +1276,10 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		ret = -ENOMEM;
 		goto out_clean;
 	}
-	for (thr = 0; thr < nr_threads; thr++)
+	for (thr = 0; thr < nr_threads; thr++) {
 		memset(&data[thr], 0, offsetof(struct dec_data, go));
+		data[thr].lz4 = lz4;
+	}
 
 	crc = kmalloc(sizeof(*crc), GFP_KERNEL);
 	if (!crc) {
@@ -1256,7 +1340,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	 */
 	if (low_free_pages() > snapshot_get_image_size())
 		read_pages = (low_free_pages() - snapshot_get_image_size()) / 2;
-	read_pages = clamp_val(read_pages, LZO_MIN_RD_PAGES, LZO_MAX_RD_PAGES);
+	read_pages = clamp_val(read_pages, LZO_MIN_RD_PAGES, max_rd_pages);
 
 	for (i = 0; i < read_pages; i++) {
 		page[i] = (void *)__get_free_page(i < LZO_CMP_PAGES ?
@@ -1279,9 +1363,9 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	want = ring_size = i;
 
 	printk(KERN_INFO
-		"PM: Using %u thread(s) for decompression.\n"
+		"PM: Using %u thread(s) for %s decompression.\n"
 		"PM: Loading and decompressing image data (%u pages)...\n",
-		nr_threads, nr_to_read);
+		nr_threads, lz4 ? "LZ4" : "LZO", nr_to_read);
 	m = nr_to_read / 10;
 	if (!m)
 		m = 1;
@@ -1321,7 +1405,9 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			if (!asked)
 				break;
 
+			t = ktime_get();
 			ret = hib_wait_io(&hb);
+			restore_stats.io_wait_us += ktime_us_delta(ktime_get(), t);
 			if (ret)
 				goto out_finish;
 			have += asked;
@@ -1331,7 +1417,10 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		}
 
 		if (crc->run_threads) {
+			t = ktime_get();
 			wait_event(crc->done, atomic_read(&crc->stop));
+			restore_stats.crc_wait_us +=
+				ktime_us_delta(ktime_get(), t);
 			atomic_set(&crc->stop, 0);
 			crc->run_threads = 0;
 		}
@@ -1349,6 +1438,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 
 			need = DIV_ROUND_UP(data[thr].cmp_len + LZO_HEADER,
 			                    PAGE_SIZE);
+			restore_stats.cmp_bytes += data[thr].cmp_len;
 			if (need > have) {
 				if (eof > 1) {
 					ret = -1;
@@ -1376,7 +1466,9 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		 * Wait for more data while we are decompressing.
 		 */
 		if (have < LZO_CMP_PAGES && asked) {
+			t = ktime_get();
 			ret = hib_wait_io(&hb);
+			restore_stats.io_wait_us += ktime_us_delta(ktime_get(), t);
 			if (ret)
 				goto out_finish;
 			have += asked;
@@ -1394,7 +1486,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 
 			if (ret < 0) {
 				printk(KERN_ERR
-				       "PM: LZO decompression failed\n");
+				       "PM: %s decompression failed\n",
+				       lz4 ? "LZ4" : "LZO");
 				goto out_finish;
 			}
 
@@ -1407,6 +1500,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 				goto out_finish;
 			}
 
+			t = ktime_get();
 			for (off = 0;
 			     off < data[thr].unc_len; off += PAGE_SIZE) {
 				memcpy(data_of(*snapshot),
@@ -1427,6 +1521,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 					goto out_finish;
 				}
 			}
+			restore_stats.copy_us += ktime_us_delta(ktime_get(), t);
 		}
 
 		crc->run_threads = thr;
@@ -1456,6 +1551,12 @@ out_finish:
 		}
 	}
 	swsusp_show_speed(start, stop, nr_to_read, "Read");
+	restore_stats.lz4 = lz4;
+	restore_stats.threads = nr_threads;
+	restore_stats.pages = nr_pages;
+	restore_stats.total_us = ktime_us_delta(stop, start);
+	for (thr = 0; thr < nr_threads; thr++)
+		restore_stats.decompress_us += data[thr].busy_us;
 out_clean:
 	for (i = 0; i < ring_size; i++)
 		free_page((unsigned long)page[i]);
@@ -1501,7 +1602,8 @@ int swsusp_read(unsigned int *flags_p)
 	if (!error) {
 		error = (*flags_p & SF_NOCOMPRESS_MODE) ?
 			load_image(&handle, &snapshot, header->pages - 1) :
-			load_image_lzo(&handle, &snapshot, header->pages - 1);
+			load_image_lzo(&handle, &snapshot, header->pages - 1,
+				       *flags_p & SF_LZ4_MODE);
 	}
 	swap_reader_finish(&handle);
 end:
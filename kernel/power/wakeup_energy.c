@@ -0,0 +1,372 @@
+/*
+ * kernel/power/wakeup_energy.c
+ *
+ * Estimates the cpu energy spent while each wakeup source is held, to tell
+ * the wakelocks costing battery from those merely held long.
+ *
+ * Activations and deactivations are accounted from the wakeup_source_*
+ * tracepoints into per-cpu slots without any shared lock: an activation
+ * subtracts the current time and energy clock where a deactivation adds
+ * them, possibly on another cpu, so that summing the slots of all cpus when
+ * the report is read gives the hold time and energy of every source. The
+ * energy clock integrates a power estimate made from the frequency of each
+ * cluster and the recent busy residency of its cpus, and only changes on
+ * frequency changes and residency samples.
+ *
+ * The power model is rough: a cpu is taken to draw max_power_mw scaled by
+ * its capacity, by the cube of its frequency over its maximum one and by
+ * its busy residency. The results are meant for comparing sources, not for
+ * an absolute figure.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/debugfs.h>
+#include <linux/hash.h>
+#include <linux/init.h>
+#include <linux/ktime.h>
+#include <linux/moduleparam.h>
+#include <linux/percpu.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/seqlock.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/tick.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <trace/events/power.h>
+
+#define WS_ENERGY_SLOT_BITS	6
+#define WS_ENERGY_SLOTS		(1 << WS_ENERGY_SLOT_BITS)
+#define WS_ENERGY_NAME_LEN	32
+#define RESIDENCY_PERIOD_MS	200
+
+static unsigned int max_power_mw = 1000;
+module_param(max_power_mw, uint, 0644);
+MODULE_PARM_DESC(max_power_mw, "Power of the biggest cpu fully busy at its top frequency");
+
+struct ws_energy_slot {
+	const char *key;
+	char name[WS_ENERGY_NAME_LEN];
+	s64 hold_ns;
+	s64 energy;
+	int active;
+	unsigned int count;
+};
+
+struct ws_energy_cpu {
+	struct ws_energy_slot slot[WS_ENERGY_SLOTS];
+	unsigned int dropped;
+};
+
+static DEFINE_PER_CPU(struct ws_energy_cpu, ws_energy);
+
+/* frequency and busy residency, in permille, as last seen for each cpu */
+static DEFINE_PER_CPU(unsigned int, ws_energy_freq);
+static DEFINE_PER_CPU(unsigned int, ws_energy_max_freq);
+static DEFINE_PER_CPU(unsigned int, ws_energy_busy);
+static DEFINE_PER_CPU(u64, ws_energy_idle_us);
+static DEFINE_PER_CPU(u64, ws_energy_wall_us);
+
+/* energy clock, in nJ: energy at stamp, then power mW from there on */
+static struct {
+	seqcount_t seq;
+	u64 stamp_ns;
+	u64 energy;
+	u64 power;
+} ws_clock;
+static DEFINE_SPINLOCK(ws_clock_lock);
+
+static u64 ws_clock_read(u64 now)
+{
+	unsigned int seq;
+	u64 energy;
+
+	do {
+		seq = read_seqcount_begin(&ws_clock.seq);
+		energy = ws_clock.energy;
+		if (now > ws_clock.stamp_ns)
+			energy += div_u64((now - ws_clock.stamp_ns) *
+					  ws_clock.power, NSEC_PER_USEC);
+	} while (read_seqcount_retry(&ws_clock.seq, seq));
+
+	return energy;
+}
+
+static u64 ws_cpu_power(int cpu)
+{
+	unsigned int freq = per_cpu(ws_energy_freq, cpu);
+	unsigned int max = per_cpu(ws_energy_max_freq, cpu);
+	u64 power;
+
+	if (!freq || !max)
+		return 0;
+
+	/* max_power_mw * capacity * (freq / max)^3 * busy */
+	power = (u64)max_power_mw * arch_scale_cpu_capacity(NULL, cpu);
+	power = div_u64(power * freq, max);
+	power = div_u64(power * freq, max);
+	power = div_u64(power * freq, max);
+	power = power * per_cpu(ws_energy_busy, cpu) / 1000;
+
+	return power >> SCHED_CAPACITY_SHIFT;
+}
+
+/* restart the energy clock at the current power estimate */
+static void ws_clock_update(void)
+{
+	u64 now = ktime_get_ns(), power = 0;
+	unsigned long flags;
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		power += ws_cpu_power(cpu);
+
+	spin_lock_irqsave(&ws_clock_lock, flags);
+	write_seqcount_begin(&ws_clock.seq);
+	ws_clock.energy += div_u64((now - ws_clock.stamp_ns) * ws_clock.power,
+				   NSEC_PER_USEC);
+	ws_clock.stamp_ns = now;
+	ws_clock.power = power;
+	write_seqcount_end(&ws_clock.seq);
+	spin_unlock_irqrestore(&ws_clock_lock, flags);
+}
+
+static int ws_energy_cpufreq_notifier(struct notifier_block *nb,
+				      unsigned long val, void *data)
+{
+	struct cpufreq_freqs *freqs = data;
+
+	if (val != CPUFREQ_POSTCHANGE)
+		return NOTIFY_DONE;
+
+	if (!per_cpu(ws_energy_max_freq, freqs->cpu))
+		per_cpu(ws_energy_max_freq, freqs->cpu) =
+			cpufreq_quick_get_max(freqs->cpu);
+	per_cpu(ws_energy_freq, freqs->cpu) = freqs->new;
+	ws_clock_update();
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block ws_energy_cpufreq_nb = {
+	.notifier_call = ws_energy_cpufreq_notifier,
+};
+
+static void ws_energy_residency(struct work_struct *work);
+static DECLARE_DEFERRABLE_WORK(ws_energy_work, ws_energy_residency);
+
+static void ws_energy_residency(struct work_struct *work)
+{
+	int cpu;
+
+	get_online_cpus();
+	for_each_online_cpu(cpu) {
+		u64 wall, idle = get_cpu_idle_time_us(cpu, &wall);
+		u64 d_wall = wall - per_cpu(ws_energy_wall_us, cpu);
+		u64 d_idle = idle - per_cpu(ws_energy_idle_us, cpu);
+
+		if (idle == -1ULL)
+			continue;
+
+		per_cpu(ws_energy_wall_us, cpu) = wall;
+		per_cpu(ws_energy_idle_us, cpu) = idle;
+		per_cpu(ws_energy_busy, cpu) = d_wall && d_idle < d_wall ?
+			div64_u64((d_wall - d_idle) * 1000, d_wall) : 0;
+
+		if (!per_cpu(ws_energy_freq, cpu)) {
+			per_cpu(ws_energy_freq, cpu) = cpufreq_quick_get(cpu);
+			per_cpu(ws_energy_max_freq, cpu) =
+				cpufreq_quick_get_max(cpu);
+		}
+	}
+	put_online_cpus();
+
+	ws_clock_update();
+	schedule_delayed_work(&ws_energy_work,
+			      msecs_to_jiffies(RESIDENCY_PERIOD_MS));
+}
+
+/* called with irqs off */
+static struct ws_energy_slot *ws_energy_slot(const char *name)
+{
+	struct ws_energy_cpu *wc = this_cpu_ptr(&ws_energy);
+	unsigned int i, h = hash_ptr((void *)name, WS_ENERGY_SLOT_BITS);
+
+	for (i = 0; i < WS_ENERGY_SLOTS; i++) {
+		struct ws_energy_slot *slot =
+			&wc->slot[(h + i) & (WS_ENERGY_SLOTS - 1)];
+
+		if (slot->key == name)
+			return slot;
+		if (!slot->key) {
+			slot->key = name;
+			strlcpy(slot->name, name, sizeof(slot->name));
+			return slot;
+		}
+	}
+
+	wc->dropped++;
+	return NULL;
+}
+
+static void ws_energy_activate(void *ignore, const char *name,
+			       unsigned int state)
+{
+	struct ws_energy_slot *slot;
+	u64 now = ktime_get_ns();
+	u64 energy = ws_clock_read(now);
+	unsigned long flags;
+
+	local_irq_save(flags);
+	slot = ws_energy_slot(name);
+	if (slot) {
+		slot->hold_ns -= now;
+		slot->energy -= energy;
+		slot->active++;
+		slot->count++;
+	}
+	local_irq_restore(flags);
+}
+
+static void ws_energy_deactivate(void *ignore, const char *name,
+				 unsigned int state)
+{
+	struct ws_energy_slot *slot;
+	u64 now = ktime_get_ns();
+	u64 energy = ws_clock_read(now);
+	unsigned long flags;
+
+	local_irq_save(flags);
+	slot = ws_energy_slot(name);
+	if (slot) {
+		slot->hold_ns += now;
+		slot->energy += energy;
+		slot->active--;
+	}
+	local_irq_restore(flags);
+}
+
+/*
+ * debugfs parts below
+ */
+
+static int ws_energy_cmp(const void *a, const void *b)
+{
+	const struct ws_energy_slot *sa = a, *sb = b;
+
+	if (sa->energy == sb->energy)
+		return 0;
+	return sa->energy < sb->energy ? 1 : -1;
+}
+
+static int ws_energy_show(struct seq_file *s, void *unused)
+{
+	unsigned int max = WS_ENERGY_SLOTS * num_possible_cpus();
+	struct ws_energy_slot *sum;
+	u64 now = ktime_get_ns(), energy = ws_clock_read(now);
+	unsigned int nr = 0, dropped = 0, i, j;
+	int cpu;
+
+	sum = vzalloc(max * sizeof(*sum));
+	if (!sum)
+		return -ENOMEM;
+
+	for_each_possible_cpu(cpu) {
+		struct ws_energy_cpu *wc = per_cpu_ptr(&ws_energy, cpu);
+
+		dropped += READ_ONCE(wc->dropped);
+		for (i = 0; i < WS_ENERGY_SLOTS; i++) {
+			struct ws_energy_slot *slot = &wc->slot[i];
+			const char *key = READ_ONCE(slot->key);
+
+			if (!key)
+				continue;
+
+			for (j = 0; j < nr; j++)
+				if (sum[j].key == key)
+					break;
+			if (j == nr) {
+				sum[nr].key = key;
+				memcpy(sum[nr].name, slot->name,
+				       sizeof(sum[nr].name));
+				nr++;
+			}
+
+			sum[j].hold_ns += READ_ONCE(slot->hold_ns);
+			sum[j].energy += READ_ONCE(slot->energy);
+			sum[j].active += READ_ONCE(slot->active);
+			sum[j].count += READ_ONCE(slot->count);
+		}
+	}
+
+	/* sources still held are accounted up to now */
+	for (j = 0; j < nr; j++) {
+		sum[j].hold_ns += (s64)sum[j].active * now;
+		sum[j].energy += (s64)sum[j].active * energy;
+	}
+
+	sort(sum, nr, sizeof(*sum), ws_energy_cmp, NULL);
+
+	seq_printf(s, "power_mw: %llu dropped: %u\n",
+		   READ_ONCE(ws_clock.power), dropped);
+	seq_printf(s, "%-32s %8s %6s %12s %12s\n", "name", "count", "active",
+		   "hold_ms", "energy_mj");
+	for (j = 0; j < nr; j++)
+		seq_printf(s, "%-32s %8u %6d %12lld %12lld\n", sum[j].name,
+			   sum[j].count, sum[j].active,
+			   div_s64(sum[j].hold_ns, NSEC_PER_MSEC),
+			   div_s64(sum[j].energy, 1000000));
+
+	vfree(sum);
+	return 0;
+}
+
+static int ws_energy_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, ws_energy_show, NULL);
+}
+
+static const struct file_operations ws_energy_fops = {
+	.open		= ws_energy_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+/* early, so that few sources are already held when accounting starts */
+static int __init wakeup_energy_init(void)
+{
+	seqcount_init(&ws_clock.seq);
+	ws_clock.stamp_ns = ktime_get_ns();
+
+	if (register_trace_wakeup_source_activate(ws_energy_activate, NULL))
+		return 0;
+	if (register_trace_wakeup_source_deactivate(ws_energy_deactivate,
+						    NULL)) {
+		unregister_trace_wakeup_source_activate(ws_energy_activate,
+							NULL);
+		return 0;
+	}
+
+	cpufreq_register_notifier(&ws_energy_cpufreq_nb,
+				  CPUFREQ_TRANSITION_NOTIFIER);
+	schedule_delayed_work(&ws_energy_work, 0);
+
+	return 0;
+}
+core_initcall(wakeup_energy_init);
+
+static int __init wakeup_energy_debugfs_init(void)
+{
+	debugfs_create_file("wakeup_energy", S_IRUGO, NULL, NULL,
+			    &ws_energy_fops);
+
+	return 0;
+}
+late_initcall(wakeup_energy_debugfs_init);
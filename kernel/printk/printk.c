@@ -43,6 +43,7 @@
 #include <linux/rculist.h>
 #include <linux/poll.h>
 #include <linux/irq_work.h>
+#include <linux/kthread.h>
 #include <linux/utsname.h>
 #include <linux/ctype.h>
 #include <linux/uio.h>
@@ -1923,6 +1924,81 @@ static size_t cont_print_text(char *text, size_t size)
 	return textlen;
 }
 
+/*
+ * Async console mode: vprintk_emit() only stores the message and wakes
+ * printk_kthread, which writes it to the consoles at low priority.
+ */
+static bool printk_async = IS_ENABLED(CONFIG_PRINTK_ASYNC);
+module_param_named(async, printk_async, bool, S_IRUGO | S_IWUSR);
+
+/* wake to flush latency of the last and the slowest async flush */
+static unsigned int async_flush_last_us;
+module_param(async_flush_last_us, uint, S_IRUGO);
+static unsigned int async_flush_max_us;
+module_param(async_flush_max_us, uint, S_IRUGO);
+static unsigned long async_flushes;
+module_param(async_flushes, ulong, S_IRUGO);
+
+static struct task_struct *printk_kthread;
+static atomic64_t printk_kthread_woken;
+
+static bool printk_use_kthread(int level)
+{
+	if (!printk_async || !printk_kthread)
+		return false;
+
+	/* get the last words out before the machine goes away */
+	return !oops_in_progress && system_state == SYSTEM_RUNNING &&
+	       level != LOGLEVEL_EMERG;
+}
+
+static void printk_kthread_wake(void)
+{
+	if (atomic64_cmpxchg(&printk_kthread_woken, 0, ktime_get_ns()) == 0)
+		wake_up_process(printk_kthread);
+}
+
+static int printk_kthread_func(void *data)
+{
+	u64 woken, us;
+
+	while (!kthread_should_stop()) {
+		set_current_state(TASK_INTERRUPTIBLE);
+		if (!atomic64_read(&printk_kthread_woken))
+			schedule();
+		__set_current_state(TASK_RUNNING);
+
+		woken = atomic64_xchg(&printk_kthread_woken, 0);
+		if (!woken)
+			continue;
+
+		console_lock();
+		console_unlock();
+
+		us = div_u64(ktime_get_ns() - woken, NSEC_PER_USEC);
+		async_flush_last_us = us;
+		if (us > async_flush_max_us)
+			async_flush_max_us = us;
+		async_flushes++;
+	}
+	return 0;
+}
+
+static int __init printk_kthread_init(void)
+{
+	struct task_struct *t;
+
+	t = kthread_run(printk_kthread_func, NULL, "printk");
+	if (IS_ERR(t)) {
+		pr_err("printk: unable to create printing thread\n");
+		return PTR_ERR(t);
+	}
+	set_user_nice(t, MAX_NICE / 2);
+	printk_kthread = t;
+	return 0;
+}
+late_initcall(printk_kthread_init);
+
 asmlinkage int vprintk_emit(int facility, int level,
 			    const char *dict, size_t dictlen,
 			    const char *fmt, va_list args)
@@ -2091,7 +2167,9 @@ asmlinkage int vprintk_emit(int facility, int level,
 	local_irq_restore(flags);
 
 	/* If called from the scheduler, we can not call up(). */
-	if (!in_sched) {
+	if (!in_sched && printk_use_kthread(level)) {
+		printk_kthread_wake();
+	} else if (!in_sched) {
 		lockdep_off();
 		/*
 		 * Disable preemption to avoid being preempted while holding
@@ -2504,6 +2582,10 @@ out:
 	raw_spin_unlock_irqrestore(&logbuf_lock, flags);
 }
 
+/* messages overwritten in the log buffer before reaching the consoles */
+static unsigned long console_drops;
+module_param(console_drops, ulong, S_IRUGO);
+
 /**
  * console_unlock - unlock the console system
  *
@@ -2565,6 +2647,7 @@ again:
 		if (console_seq < log_first_seq) {
 			len = sprintf(text, "** %u printk messages dropped ** ",
 				      (unsigned)(log_first_seq - console_seq));
+			console_drops += log_first_seq - console_seq;
 
 			/* messages are gone, move to first one */
 			console_seq = log_first_seq;
@@ -104,6 +104,7 @@
 #endif
 
 #include "sched.h"
+#include "tune.h"
 #include "../workqueue_internal.h"
 #include "../smpboot.h"
 
@@ -886,11 +887,176 @@ static void set_load_weight(struct task_struct *p)
 	load->inv_weight = prio_to_wmult[prio];
 }
 
+#ifdef CONFIG_UCLAMP_TASK
+/*
+ * Utilization clamping
+ *
+ * The clamps of a task are the ones it asked for with sched_setattr(),
+ * narrowed by those of its schedtune group: the larger of the minimums and
+ * the smaller of the maximums, the maximum winning if they cross. A task is
+ * accounted on its rq with the values it was enqueued with, which are kept
+ * in uclamp_active so that dequeue finds the same buckets even if either
+ * request changed in the meantime.
+ */
+static void uclamp_get(struct task_struct *p, unsigned int *umin,
+		       unsigned int *umax)
+{
+	*umin = max(p->uclamp_req[UCLAMP_MIN],
+		    schedtune_task_uclamp(p, UCLAMP_MIN));
+	*umax = min(p->uclamp_req[UCLAMP_MAX],
+		    schedtune_task_uclamp(p, UCLAMP_MAX));
+	*umin = min(*umin, *umax);
+}
+
+unsigned int uclamp_eff(struct task_struct *p, int clamp_id)
+{
+	unsigned int umin, umax;
+
+	uclamp_get(p, &umin, &umax);
+
+	return clamp_id == UCLAMP_MIN ? umin : umax;
+}
+
+unsigned long uclamp_task_util(struct task_struct *p, unsigned long util)
+{
+	unsigned int umin, umax;
+
+	uclamp_get(p, &umin, &umax);
+
+	return clamp(util, (unsigned long)umin, (unsigned long)umax);
+}
+
+static inline struct uclamp_bucket *
+uclamp_bucket(struct rq *rq, int clamp_id, unsigned int value)
+{
+	unsigned int idx = min_t(unsigned int, value / UCLAMP_BUCKET_DELTA,
+				 UCLAMP_BUCKETS - 1);
+
+	return &rq->uclamp[clamp_id].bucket[idx];
+}
+
+static void uclamp_rq_update(struct rq *rq, int clamp_id)
+{
+	struct uclamp_rq *uc_rq = &rq->uclamp[clamp_id];
+	int idx;
+
+	for (idx = UCLAMP_BUCKETS - 1; idx >= 0; idx--) {
+		if (uc_rq->bucket[idx].tasks) {
+			WRITE_ONCE(uc_rq->value, uc_rq->bucket[idx].value);
+			return;
+		}
+	}
+
+	WRITE_ONCE(uc_rq->value, uclamp_none(clamp_id));
+}
+
+static inline void uclamp_rq_inc(struct rq *rq, struct task_struct *p)
+{
+	struct uclamp_bucket *bucket;
+	int clamp_id;
+
+	uclamp_get(p, &p->uclamp_active[UCLAMP_MIN],
+		   &p->uclamp_active[UCLAMP_MAX]);
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		unsigned int value = p->uclamp_active[clamp_id];
+
+		bucket = uclamp_bucket(rq, clamp_id, value);
+		if (!bucket->tasks++ || value > bucket->value)
+			bucket->value = value;
+		uclamp_rq_update(rq, clamp_id);
+	}
+}
+
+static inline void uclamp_rq_dec(struct rq *rq, struct task_struct *p)
+{
+	struct uclamp_bucket *bucket;
+	int clamp_id;
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++) {
+		bucket = uclamp_bucket(rq, clamp_id, p->uclamp_active[clamp_id]);
+		if (!WARN_ON_ONCE(!bucket->tasks))
+			bucket->tasks--;
+		uclamp_rq_update(rq, clamp_id);
+	}
+}
+
+static int uclamp_validate(struct task_struct *p,
+			   const struct sched_attr *attr, bool user)
+{
+	unsigned int umin = p->uclamp_req[UCLAMP_MIN];
+	unsigned int umax = p->uclamp_req[UCLAMP_MAX];
+
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP_MIN)
+		umin = attr->sched_util_min;
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP_MAX)
+		umax = attr->sched_util_max;
+
+	if (umin > umax || umax > SCHED_CAPACITY_SCALE)
+		return -EINVAL;
+
+	/* like a negative nice, raising the floor is privileged */
+	if (user && umin > p->uclamp_req[UCLAMP_MIN] &&
+	    !capable(CAP_SYS_NICE))
+		return -EPERM;
+
+	return 0;
+}
+
+static void __setscheduler_uclamp(struct task_struct *p,
+				  const struct sched_attr *attr)
+{
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP_MIN)
+		p->uclamp_req[UCLAMP_MIN] = attr->sched_util_min;
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP_MAX)
+		p->uclamp_req[UCLAMP_MAX] = attr->sched_util_max;
+}
+
+static void uclamp_fork(struct task_struct *p)
+{
+	int clamp_id;
+
+	if (unlikely(p->sched_reset_on_fork)) {
+		for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++)
+			p->uclamp_req[clamp_id] = uclamp_none(clamp_id);
+	}
+}
+
+static void __init init_uclamp(void)
+{
+	int cpu, clamp_id;
+
+	for_each_possible_cpu(cpu) {
+		for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++)
+			cpu_rq(cpu)->uclamp[clamp_id].value =
+				uclamp_none(clamp_id);
+	}
+
+	for (clamp_id = 0; clamp_id < UCLAMP_CNT; clamp_id++)
+		init_task.uclamp_req[clamp_id] = uclamp_none(clamp_id);
+}
+#else
+static inline void uclamp_rq_inc(struct rq *rq, struct task_struct *p) {}
+static inline void uclamp_rq_dec(struct rq *rq, struct task_struct *p) {}
+
+static inline int uclamp_validate(struct task_struct *p,
+				  const struct sched_attr *attr, bool user)
+{
+	return -EOPNOTSUPP;
+}
+
+static inline void __setscheduler_uclamp(struct task_struct *p,
+					 const struct sched_attr *attr) {}
+static inline void uclamp_fork(struct task_struct *p) {}
+static inline void init_uclamp(void) {}
+#endif /* CONFIG_UCLAMP_TASK */
+
 static inline void enqueue_task(struct rq *rq, struct task_struct *p, int flags)
 {
 	update_rq_clock(rq);
 	if (!(flags & ENQUEUE_RESTORE))
 		sched_info_queued(rq, p);
+	uclamp_rq_inc(rq, p);
 	p->sched_class->enqueue_task(rq, p, flags);
 }
 
@@ -899,6 +1065,7 @@ static inline void dequeue_task(struct rq *rq, struct task_struct *p, int flags)
 	update_rq_clock(rq);
 	if (!(flags & DEQUEUE_SAVE))
 		sched_info_dequeued(rq, p);
+	uclamp_rq_dec(rq, p);
 	p->sched_class->dequeue_task(rq, p, flags);
 }
 
@@ -1924,6 +2091,7 @@ ttwu_do_wakeup(struct rq *rq, struct task_struct *p, int wake_flags)
 	check_preempt_curr(rq, p, wake_flags);
 	p->state = TASK_RUNNING;
 	trace_sched_wakeup(p);
+	wakelat_wakeup(rq, p);
 
 #ifdef CONFIG_SMP
 	if (p->sched_class->task_woken) {
@@ -2323,6 +2491,16 @@ static void __sched_fork(unsigned long clone_flags, struct task_struct *p)
 	p->se.nr_migrations		= 0;
 	p->se.vruntime			= 0;
 	INIT_LIST_HEAD(&p->se.group_node);
+
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	p->se.sleep_start		= 0;
+	p->se.avg_sleep			= 0;
+#endif
+
+#ifdef CONFIG_CGROUP_SCHEDTUNE
+	p->colocate_demand		= 0;
+	p->inherited_boost		= 0;
+#endif
 /*
  * Load-tracking only depends on SMP, FAIR_GROUP_SCHED dependency below may be
  * removed when useful for applications beyond shares distribution (e.g.
@@ -2441,6 +2619,8 @@ int sched_fork(unsigned long clone_flags, struct task_struct *p)
 	 */
 	p->prio = current->normal_prio;
 
+	uclamp_fork(p);
+
 	/*
 	 * Revert to default priority/policy on fork if requested.
 	 */
@@ -2820,6 +3000,7 @@ static struct rq *finish_task_switch(struct task_struct *prev)
 	vtime_task_switch(prev);
 	perf_event_task_sched_in(prev, current);
 	tick_nohz_task_switch();
+	wakelat_switch_in(rq, current);
 	finish_lock_switch(rq, prev);
 	finish_arch_post_lock_switch();
 
@@ -4099,6 +4280,8 @@ static void __setscheduler_params(struct task_struct *p,
 	p->rt_priority = attr->sched_priority;
 	p->normal_prio = normal_prio(p);
 	set_load_weight(p);
+
+	__setscheduler_uclamp(p, attr);
 }
 
 #ifdef CONFIG_SCHED_HMP
@@ -4242,9 +4425,16 @@ recheck:
 			return -EINVAL;
 	}
 
-	if (attr->sched_flags & ~(SCHED_FLAG_RESET_ON_FORK))
+	if (attr->sched_flags &
+	    ~(SCHED_FLAG_RESET_ON_FORK | SCHED_FLAG_UTIL_CLAMP))
 		return -EINVAL;
 
+	if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP) {
+		retval = uclamp_validate(p, attr, user);
+		if (retval)
+			return retval;
+	}
+
 	/*
 	 * Valid priorities for SCHED_FIFO and SCHED_RR are
 	 * 1..MAX_USER_RT_PRIO-1, valid priority for SCHED_NORMAL,
@@ -4342,6 +4532,8 @@ recheck:
 			goto change;
 		if (dl_policy(policy) && dl_param_changed(p, attr))
 			goto change;
+		if (attr->sched_flags & SCHED_FLAG_UTIL_CLAMP)
+			goto change;
 
 		p->sched_reset_on_fork = reset_on_fork;
 		task_rq_unlock(rq, p, &flags);
@@ -4820,6 +5012,14 @@ SYSCALL_DEFINE4(sched_getattr, pid_t, pid, struct sched_attr __user *, uattr,
 	else
 		attr.sched_nice = task_nice(p);
 
+#ifdef CONFIG_UCLAMP_TASK
+	/* older callers would see an unknown, non-zero field otherwise */
+	if (size >= SCHED_ATTR_SIZE_VER1) {
+		attr.sched_util_min = p->uclamp_req[UCLAMP_MIN];
+		attr.sched_util_max = p->uclamp_req[UCLAMP_MAX];
+	}
+#endif
+
 	rcu_read_unlock();
 
 	retval = sched_read_attr(uattr, &attr, size);
@@ -8046,6 +8246,7 @@ void __init sched_init(void)
 	}
 
 	set_load_weight(&init_task);
+	init_uclamp();
 
 #ifdef CONFIG_PREEMPT_NOTIFIERS
 	INIT_HLIST_HEAD(&init_task.preempt_notifiers);
@@ -20,9 +20,14 @@
 #include "sched.h"
 #include "tune.h"
 
+#define IOWAIT_BOOST_MIN_SHIFT	3		/* 1/8 of the capacity */
+#define IOWAIT_BOOST_DECAY_NS	(2 * NSEC_PER_MSEC)
+
 struct sugov_tunables {
 	struct gov_attr_set attr_set;
-	unsigned int rate_limit_us;
+	unsigned int up_rate_limit_us;
+	unsigned int down_rate_limit_us;
+	bool iowait_boost_enable;
 #ifdef CONFIG_FREQVAR_SCHEDTUNE
 	struct freqvar_boost_data freqvar_boost;
 #endif
@@ -36,7 +41,9 @@ struct sugov_policy {
 
 	raw_spinlock_t update_lock;  /* For shared policies */
 	u64 last_freq_update_time;
-	s64 freq_update_delay_ns;
+	s64 freq_update_delay_ns;	/* the smaller of the two below */
+	s64 up_rate_delay_ns;
+	s64 down_rate_delay_ns;
 	unsigned int next_freq;
 	unsigned int max_util;
 	bool pending;
@@ -48,12 +55,25 @@ struct sugov_policy {
 	bool work_in_progress;
 
 	bool need_freq_update;
+
+	/* Transition statistics, see trans_stats */
+	struct {
+		u64 up;
+		u64 down;
+		u64 up_limited;		/* raises held back by up_rate_limit_us */
+		u64 down_limited;	/* drops held back by down_rate_limit_us */
+		u64 iowait_boosts;
+	} stats;
 };
 
 struct sugov_cpu {
 	struct update_util_data update_util;
 	struct sugov_policy *sg_policy;
 
+	/* iowait boost as of iowait_boost_time, in utilization units */
+	unsigned long iowait_boost;
+	u64 iowait_boost_time;
+
 	/* The fields below are only needed when sharing a policy. */
 	unsigned long util;
 	unsigned long max;
@@ -113,12 +133,72 @@ static int sugov_select_scaling_cpu(void)
 	return cpumask_weight(&mask) - 1;
 }
 
+/*
+ * Frequency raises and drops have their own rate limits, so that a ramp on
+ * touch input is not held back by the limit that keeps frequency from
+ * collapsing between two frames.
+ */
+static bool sugov_up_down_rate_limit(struct sugov_policy *sg_policy, u64 time,
+				     unsigned int next_freq)
+{
+	s64 delta_ns = time - sg_policy->last_freq_update_time;
+
+	/* nothing to hold back after the limits changed */
+	if (sg_policy->next_freq == UINT_MAX)
+		return false;
+
+	if (next_freq > sg_policy->next_freq &&
+	    delta_ns < sg_policy->up_rate_delay_ns) {
+		sg_policy->stats.up_limited++;
+		return true;
+	}
+
+	if (next_freq < sg_policy->next_freq &&
+	    delta_ns < sg_policy->down_rate_delay_ns) {
+		sg_policy->stats.down_limited++;
+		return true;
+	}
+
+	return false;
+}
+
 static void sugov_update_commit(struct sugov_policy *sg_policy, u64 time,
 				unsigned int next_freq)
 {
+	struct cpufreq_policy *policy = sg_policy->policy;
+
+	if (sugov_up_down_rate_limit(sg_policy, time, next_freq))
+		return;
+
 	sg_policy->last_freq_update_time = time;
 
-	if (sg_policy->next_freq != next_freq) {
+	if (sg_policy->next_freq != UINT_MAX &&
+	    sg_policy->next_freq != next_freq) {
+		if (next_freq > sg_policy->next_freq)
+			sg_policy->stats.up++;
+		else
+			sg_policy->stats.down++;
+	}
+
+	/*
+	 * A driver that can switch without sleeping is called right here,
+	 * which saves the irq_work, the worker wake up and its context switch
+	 * on every ramp.
+	 */
+	if (policy->fast_switch_enabled) {
+		if (sg_policy->next_freq == next_freq)
+			return;
+
+		sg_policy->next_freq = next_freq;
+		next_freq = cpufreq_driver_fast_switch(policy, next_freq);
+		if (next_freq == CPUFREQ_ENTRY_INVALID)
+			return;
+
+		policy->cur = next_freq;
+		/* no transition notifier is sent for a fast switch */
+		schedtune_freqvar_fast_switch(policy, next_freq);
+		trace_cpu_frequency(next_freq, smp_processor_id());
+	} else if (sg_policy->next_freq != next_freq) {
 		sg_policy->next_freq = next_freq;
 		sg_policy->work_in_progress = true;
 		irq_work_queue_on(&sg_policy->irq_work,
@@ -153,6 +233,48 @@ static unsigned int get_next_freq(struct cpufreq_policy *policy,
 	return (freq + (freq >> 2)) * util / max;
 }
 
+/*
+ * Iowait boost
+ *
+ * Every wakeup from iowait on a cpu doubles its boost, starting from an
+ * eighth of its capacity, and the boost halves every IOWAIT_BOOST_DECAY_NS
+ * after the last one. A phase of back-to-back synchronous I/O ramps up
+ * within a few requests while a stray wait costs little. The boost is a
+ * floor for the utilization of the cpu.
+ */
+static unsigned long sugov_iowait_boost(struct sugov_cpu *sg_cpu, u64 time,
+					unsigned long util, unsigned long max)
+{
+	struct sugov_policy *sg_policy = sg_cpu->sg_policy;
+	struct rq *rq = this_rq();
+	unsigned long boost_min = max >> IOWAIT_BOOST_MIN_SHIFT;
+	unsigned long boost = sg_cpu->iowait_boost;
+	u64 periods;
+
+	if (boost) {
+		periods = div64_u64(time - sg_cpu->iowait_boost_time,
+				    IOWAIT_BOOST_DECAY_NS);
+		boost = periods < BITS_PER_LONG ? boost >> periods : 0;
+		if (boost < boost_min)
+			boost = 0;
+	}
+
+	if (rq->cpufreq_iowait) {
+		rq->cpufreq_iowait = false;
+		if (sg_policy->tunables->iowait_boost_enable) {
+			boost = boost ? min(boost << 1, max) : boost_min;
+			sg_cpu->iowait_boost = boost;
+			sg_cpu->iowait_boost_time = time;
+			sg_policy->stats.iowait_boosts++;
+		}
+	}
+
+	if (!boost)
+		sg_cpu->iowait_boost = 0;
+
+	return max(util, boost);
+}
+
 static void sugov_update_single(struct update_util_data *hook, u64 time,
 				unsigned long util, unsigned long max)
 {
@@ -168,11 +290,15 @@ static void sugov_update_single(struct update_util_data *hook, u64 time,
 	if (sg_policy->work_in_progress)
 		return;
 
+	if (util != ULONG_MAX)
+		util = sugov_iowait_boost(sg_cpu, time, util, max);
+
 	if (!sugov_should_update_freq(sg_policy, time))
 		return;
 
 	next_f = util == ULONG_MAX ? policy->cpuinfo.max_freq :
-			get_next_freq(policy, util, max);
+			get_next_freq(policy,
+				uclamp_rq_util(this_rq(), util), max);
 
 	trace_sched_freq_commit(time, util, max, next_f);
 
@@ -190,6 +316,8 @@ static unsigned int sugov_next_freq_shared(struct sugov_policy *sg_policy,
 	if (util == ULONG_MAX)
 		goto return_max;
 
+	util = uclamp_rq_util(this_rq(), util);
+
 	for_each_cpu(j, policy->cpus) {
 		struct sugov_cpu *j_sg_cpu;
 		unsigned long j_util, j_max;
@@ -214,6 +342,8 @@ static unsigned int sugov_next_freq_shared(struct sugov_policy *sg_policy,
 		if (j_util == ULONG_MAX)
 			goto return_max;
 
+		j_util = uclamp_rq_util(cpu_rq(j), j_util);
+
 		j_max = j_sg_cpu->max;
 		if (j_util * max > j_max * util) {
 			util = j_util;
@@ -239,6 +369,9 @@ static void sugov_update_shared(struct update_util_data *hook, u64 time,
 
 	raw_spin_lock(&sg_policy->update_lock);
 
+	if (util != ULONG_MAX)
+		util = sugov_iowait_boost(sg_cpu, time, util, max);
+
 	sg_cpu->util = util;
 	sg_cpu->max = max;
 	sg_cpu->last_update = time;
@@ -306,15 +439,20 @@ static inline struct sugov_tunables *to_sugov_tunables(struct gov_attr_set *attr
 	return container_of(attr_set, struct sugov_tunables, attr_set);
 }
 
-static ssize_t rate_limit_us_show(struct gov_attr_set *attr_set, char *buf)
+static void sugov_update_rate_limits(struct sugov_tunables *tunables,
+				     struct sugov_policy *sg_policy)
 {
-	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
-
-	return sprintf(buf, "%u\n", tunables->rate_limit_us);
+	sg_policy->up_rate_delay_ns =
+		tunables->up_rate_limit_us * NSEC_PER_USEC;
+	sg_policy->down_rate_delay_ns =
+		tunables->down_rate_limit_us * NSEC_PER_USEC;
+	sg_policy->freq_update_delay_ns = min(sg_policy->up_rate_delay_ns,
+					      sg_policy->down_rate_delay_ns);
 }
 
-static ssize_t rate_limit_us_store(struct gov_attr_set *attr_set, const char *buf,
-				   size_t count)
+static ssize_t sugov_store_rate_limits(struct gov_attr_set *attr_set,
+				       const char *buf, size_t count,
+				       bool up, bool down)
 {
 	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
 	struct sugov_policy *sg_policy;
@@ -323,13 +461,96 @@ static ssize_t rate_limit_us_store(struct gov_attr_set *attr_set, const char *bu
 	if (kstrtouint(buf, 10, &rate_limit_us))
 		return -EINVAL;
 
-	tunables->rate_limit_us = rate_limit_us;
+	if (up)
+		tunables->up_rate_limit_us = rate_limit_us;
+	if (down)
+		tunables->down_rate_limit_us = rate_limit_us;
 
 	list_for_each_entry(sg_policy, &attr_set->policy_list, tunables_hook)
-		sg_policy->freq_update_delay_ns = rate_limit_us * NSEC_PER_USEC;
+		sugov_update_rate_limits(tunables, sg_policy);
 
 	return count;
 }
+
+static ssize_t up_rate_limit_us_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->up_rate_limit_us);
+}
+
+static ssize_t up_rate_limit_us_store(struct gov_attr_set *attr_set,
+				      const char *buf, size_t count)
+{
+	return sugov_store_rate_limits(attr_set, buf, count, true, false);
+}
+
+static ssize_t down_rate_limit_us_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->down_rate_limit_us);
+}
+
+static ssize_t down_rate_limit_us_store(struct gov_attr_set *attr_set,
+					const char *buf, size_t count)
+{
+	return sugov_store_rate_limits(attr_set, buf, count, false, true);
+}
+
+/* Kept for existing users: shows the up limit and sets both */
+static ssize_t rate_limit_us_show(struct gov_attr_set *attr_set, char *buf)
+{
+	return up_rate_limit_us_show(attr_set, buf);
+}
+
+static ssize_t rate_limit_us_store(struct gov_attr_set *attr_set, const char *buf,
+				   size_t count)
+{
+	return sugov_store_rate_limits(attr_set, buf, count, true, true);
+}
+
+static ssize_t iowait_boost_enable_show(struct gov_attr_set *attr_set,
+					char *buf)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+
+	return sprintf(buf, "%u\n", tunables->iowait_boost_enable);
+}
+
+static ssize_t iowait_boost_enable_store(struct gov_attr_set *attr_set,
+					 const char *buf, size_t count)
+{
+	struct sugov_tunables *tunables = to_sugov_tunables(attr_set);
+	bool enable;
+
+	if (kstrtobool(buf, &enable))
+		return -EINVAL;
+
+	tunables->iowait_boost_enable = enable;
+	return count;
+}
+
+/* One line per policy sharing these tunables */
+static ssize_t trans_stats_show(struct gov_attr_set *attr_set, char *buf)
+{
+	struct sugov_policy *sg_policy;
+	ssize_t ret = 0;
+
+	ret += scnprintf(buf + ret, PAGE_SIZE - ret,
+			 "cpu up down up_limited down_limited iowait_boosts\n");
+
+	list_for_each_entry(sg_policy, &attr_set->policy_list, tunables_hook)
+		ret += scnprintf(buf + ret, PAGE_SIZE - ret,
+				 "%u %llu %llu %llu %llu %llu\n",
+				 sg_policy->policy->cpu,
+				 sg_policy->stats.up, sg_policy->stats.down,
+				 sg_policy->stats.up_limited,
+				 sg_policy->stats.down_limited,
+				 sg_policy->stats.iowait_boosts);
+
+	return ret;
+}
 #ifdef CONFIG_FREQVAR_SCHEDTUNE
 static unsigned int *get_tokenized_data(const char *buf, int *num_tokens)
 {
@@ -413,9 +634,17 @@ static struct governor_attr freqvar_boost = __ATTR_WO(freqvar_boost);
 #endif /* CONFIG_FREQVAR_SCHEDTUNE */
 
 static struct governor_attr rate_limit_us = __ATTR_RW(rate_limit_us);
+static struct governor_attr up_rate_limit_us = __ATTR_RW(up_rate_limit_us);
+static struct governor_attr down_rate_limit_us = __ATTR_RW(down_rate_limit_us);
+static struct governor_attr iowait_boost_enable = __ATTR_RW(iowait_boost_enable);
+static struct governor_attr trans_stats = __ATTR_RO(trans_stats);
 
 static struct attribute *sugov_attributes[] = {
 	&rate_limit_us.attr,
+	&up_rate_limit_us.attr,
+	&down_rate_limit_us.attr,
+	&iowait_boost_enable.attr,
+	&trans_stats.attr,
 #ifdef CONFIG_FREQVAR_SCHEDTUNE
 	&freqvar_boost.attr,
 #endif
@@ -509,10 +738,12 @@ static int sugov_init(struct cpufreq_policy *policy)
 		goto free_sg_policy;
 	}
 
-	tunables->rate_limit_us = DEFAULT_LATENCY_MULTIPLIER;
+	tunables->up_rate_limit_us = DEFAULT_LATENCY_MULTIPLIER;
 	lat = policy->cpuinfo.transition_latency / NSEC_PER_USEC;
 	if (lat)
-		tunables->rate_limit_us *= lat;
+		tunables->up_rate_limit_us *= lat;
+	tunables->down_rate_limit_us = tunables->up_rate_limit_us;
+	tunables->iowait_boost_enable = true;
 
 	/* init freqvar_boost */
 	schedtune_freqvar_boost_init(policy, &tunables->freqvar_boost);
@@ -529,6 +760,7 @@ static int sugov_init(struct cpufreq_policy *policy)
  out:
 	mutex_unlock(&global_tunables_lock);
 
+	cpufreq_enable_fast_switch(policy);
 	return 0;
 
  fail:
@@ -550,6 +782,8 @@ static int sugov_exit(struct cpufreq_policy *policy)
 	struct sugov_tunables *tunables = sg_policy->tunables;
 	unsigned int count;
 
+	cpufreq_disable_fast_switch(policy);
+
 	mutex_lock(&global_tunables_lock);
 
 	count = gov_attr_set_put(&tunables->attr_set, &sg_policy->tunables_hook);
@@ -570,7 +804,7 @@ static int sugov_start(struct cpufreq_policy *policy)
 	struct sugov_policy *sg_policy = policy->governor_data;
 	unsigned int cpu;
 
-	sg_policy->freq_update_delay_ns = sg_policy->tunables->rate_limit_us * NSEC_PER_USEC;
+	sugov_update_rate_limits(sg_policy->tunables, sg_policy);
 	sg_policy->last_freq_update_time = 0;
 	sg_policy->next_freq = UINT_MAX;
 	sg_policy->max_util = 0;
@@ -582,6 +816,7 @@ static int sugov_start(struct cpufreq_policy *policy)
 		struct sugov_cpu *sg_cpu = &per_cpu(sugov_cpu, cpu);
 
 		sg_cpu->sg_policy = sg_policy;
+		sg_cpu->iowait_boost = 0;
 		if (policy_is_shared(policy)) {
 			sg_cpu->util = 0;
 			sg_cpu->max = 0;
@@ -606,8 +841,10 @@ static int sugov_stop(struct cpufreq_policy *policy)
 
 	synchronize_sched();
 
-	irq_work_sync(&sg_policy->irq_work);
-	cancel_work_sync(&sg_policy->work);
+	if (!policy->fast_switch_enabled) {
+		irq_work_sync(&sg_policy->irq_work);
+		cancel_work_sync(&sg_policy->work);
+	}
 	return 0;
 }
 
@@ -615,16 +852,19 @@ static int sugov_limits(struct cpufreq_policy *policy)
 {
 	struct sugov_policy *sg_policy = policy->governor_data;
 
-	mutex_lock(&sg_policy->work_lock);
+	/* with fast switching the next update applies the new limits */
+	if (!policy->fast_switch_enabled) {
+		mutex_lock(&sg_policy->work_lock);
 
-	if (policy->max < policy->cur)
-		__cpufreq_driver_target(policy, policy->max,
-					CPUFREQ_RELATION_H);
-	else if (policy->min > policy->cur)
-		__cpufreq_driver_target(policy, policy->min,
-					CPUFREQ_RELATION_L);
+		if (policy->max < policy->cur)
+			__cpufreq_driver_target(policy, policy->max,
+						CPUFREQ_RELATION_H);
+		else if (policy->min > policy->cur)
+			__cpufreq_driver_target(policy, policy->min,
+						CPUFREQ_RELATION_L);
 
-	mutex_unlock(&sg_policy->work_lock);
+		mutex_unlock(&sg_policy->work_lock);
+	}
 
 	sg_policy->need_freq_update = true;
 	return 0;
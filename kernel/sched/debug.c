@@ -18,6 +18,7 @@
 #include <linux/mempolicy.h>
 
 #include "sched.h"
+#include "walt.h"
 
 static DEFINE_SPINLOCK(sched_debug_lock);
 
@@ -328,9 +329,33 @@ do {									\
 
 	P(ttwu_count);
 	P(ttwu_local);
+#ifdef CONFIG_SMP
+	P(rt_place_fit);
+	P(rt_place_fit_idle);
+	P(rt_place_nofit);
+	P(rt_wake_misfit);
+#endif
 
 #undef P
 #undef P64
+#endif
+#ifdef CONFIG_SCHED_WALT
+	{
+		struct walt_pred_stats ps;
+
+		if (walt_get_pred_stats(cpu, &ps)) {
+			SEQ_printf(m, "  .%-30s: %Ld\n", "walt_pred_windows",
+				   ps.windows);
+			SEQ_printf(m, "  .%-30s: %Ld\n", "walt_pred_hits",
+				   ps.hits);
+			SEQ_printf(m, "  .%-30s: %Ld\n", "walt_pred_under",
+				   ps.under);
+			SEQ_printf(m, "  .%-30s: %Ld.%06ld\n",
+				   "walt_pred_avg_err",
+				   SPLIT_NS(div64_u64(ps.err_sum,
+						      max(ps.windows, 1ULL))));
+		}
+	}
 #endif
 	spin_lock_irqsave(&sched_debug_lock, flags);
 	print_cfs_stats(m, cpu);
@@ -41,6 +41,7 @@ static void free_resources(void)
 				kfree(sge->cap_states);
 				kfree(sge->idle_states);
 				kfree(sge);
+				sge_array[cpu][sd_level] = NULL;
 			}
 		}
 	}
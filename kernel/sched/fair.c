@@ -44,6 +44,7 @@
  * frequency scaling can track the current CPU frequency and limits.
  */
 #include <linux/cpufreq.h>
+#include <linux/sched_energy.h>
 //#include <linux/ipa.h>
 #endif /* CONFIG_HMP_FREQUENCY_INVARIANT_SCALE */
 #endif /* CONFIG_HMP_VARIABLE_SCALE */
@@ -2618,29 +2619,29 @@ struct hmp_global_attr {
 #ifdef CONFIG_HMP_FREQUENCY_INVARIANT_SCALE
 #ifdef CONFIG_SCHED_HMP_TASK_BASED_SOFTLANDING
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
-#define HMP_DATA_SYSFS_MAX 23
+#define HMP_DATA_SYSFS_MAX 25
 #else
-#define HMP_DATA_SYSFS_MAX 22
+#define HMP_DATA_SYSFS_MAX 24
 #endif
 #else
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
-#define HMP_DATA_SYSFS_MAX 17
+#define HMP_DATA_SYSFS_MAX 19
 #else
-#define HMP_DATA_SYSFS_MAX 16
+#define HMP_DATA_SYSFS_MAX 18
 #endif
 #endif
 #else
 #ifdef CONFIG_SCHED_HMP_TASK_BASED_SOFTLANDING
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
-#define HMP_DATA_SYSFS_MAX 22
+#define HMP_DATA_SYSFS_MAX 24
 #else
-#define HMP_DATA_SYSFS_MAX 21
+#define HMP_DATA_SYSFS_MAX 23
 #endif
 #else
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
-#define HMP_DATA_SYSFS_MAX 16
+#define HMP_DATA_SYSFS_MAX 18
 #else
-#define HMP_DATA_SYSFS_MAX 15
+#define HMP_DATA_SYSFS_MAX 17
 #endif
 #endif
 #endif
@@ -2756,6 +2757,34 @@ u64 hmp_down_compst_ratio = 2048; /* HMP DOWN COMPENSATION RATIO */
 unsigned int hmp_packing_enabled = 1;
 unsigned int hmp_packing_threshold = 460;	/* 45% of the NICE_0_LOAD */
 
+/*
+ * hmp_energy_aware: decide up and down migrations from the energy model
+ * instead of hmp_up_threshold/hmp_down_threshold, where one is available
+ * hmp_energy_margin: capacity headroom in % a domain must leave a task
+ */
+unsigned int hmp_energy_aware;
+unsigned int hmp_energy_margin = 25;
+
+/*
+ * hmp_thermal_bias: load added to both migration thresholds by the cpu
+ * cooling devices when they spend part of the power budget moving tasks
+ * to the slower domain rather than capping the faster one's frequency
+ */
+static unsigned int hmp_thermal_bias;
+
+static inline unsigned int hmp_thermal_up(unsigned int threshold)
+{
+	return min_t(unsigned int, threshold + READ_ONCE(hmp_thermal_bias),
+		     SCHED_CAPACITY_SCALE);
+}
+
+static inline unsigned int hmp_thermal_down(unsigned int threshold,
+					    unsigned int up_threshold)
+{
+	return min(threshold + READ_ONCE(hmp_thermal_bias),
+		   hmp_thermal_up(up_threshold));
+}
+
 #ifdef CONFIG_SCHED_HMP_TASK_BASED_SOFTLANDING
 #include <linux/pm_qos.h>
 #include <linux/irq_work.h>
@@ -2898,7 +2927,7 @@ boosted_task_util(struct task_struct *task)
 	unsigned long util = task_util(task);
 	unsigned long margin = schedtune_task_margin(task);
 
-	return util + margin;
+	return uclamp_task_util(task, util + margin);
 }
 
 /*
@@ -3187,6 +3216,9 @@ static inline void cfs_rq_util_change(struct cfs_rq *cfs_rq)
 		unsigned long max = rq->cpu_capacity_orig;
 		unsigned long req_cap = boosted_cpu_util(cfs_rq->avg.util_avg, cpu);
 
+		/* a colocation group asks for its total wherever it runs */
+		req_cap = max(req_cap, schedtune_cpu_colocate_util(cpu));
+
 		/*
 		 * There are a few boundary cases this might miss but it should
 		 * get called often enough that that should (hopefully) not be
@@ -4756,12 +4788,91 @@ static inline void hrtick_update(struct rq *rq)
  * increased. Here we update the fair scheduling stats and
  * then put the task into the rbtree:
  */
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+/*
+ * Idle wakeup hint
+ *
+ * Each task keeps an average of how long it sleeps. When one goes to sleep,
+ * the time it is expected back becomes the wakeup hint of its CPU unless a
+ * task expected earlier is already pending there. cpuidle adds this to the
+ * next timer event, which only covers wakeups the kernel has armed itself,
+ * so that a frame pipeline or an I/O loop does not make the CPU go through
+ * a cluster power-down it leaves again right away.
+ */
+#define IDLE_HINT_AVG_SHIFT	2
+
+static void idle_hint_task_sleep(struct rq *rq, struct task_struct *p)
+{
+	u64 now = rq_clock(rq);
+	u64 wake;
+
+	p->se.sleep_start = now;
+	if (!p->se.avg_sleep)
+		return;
+
+	wake = now + p->se.avg_sleep;
+	if (rq->wake_hint <= now || wake < rq->wake_hint) {
+		WRITE_ONCE(rq->wake_hint, wake);
+		rq->wake_hint_task = p;
+	}
+}
+
+static void idle_hint_task_wake(struct rq *rq, struct task_struct *p)
+{
+	u64 now = rq_clock(rq);
+	s64 delta;
+
+	if (!p->se.sleep_start)
+		return;
+
+	/* the clocks of two CPUs are close enough for an average */
+	delta = max_t(s64, now - p->se.sleep_start, 0);
+	p->se.sleep_start = 0;
+	if (p->se.avg_sleep)
+		p->se.avg_sleep += (delta - (s64)p->se.avg_sleep) >>
+				   IDLE_HINT_AVG_SHIFT;
+	else
+		p->se.avg_sleep = delta;
+
+	if (task_rq(p) == rq && rq->wake_hint_task == p) {
+		WRITE_ONCE(rq->wake_hint, 0);
+		rq->wake_hint_task = NULL;
+	}
+}
+
+/*
+ * Nanoseconds until the next task wakeup expected on @cpu, U64_MAX if there
+ * is none. Only meaningful when called on @cpu itself, the idle governor
+ * does so before picking a state.
+ */
+u64 sched_cpu_wake_hint(int cpu)
+{
+	u64 wake = READ_ONCE(cpu_rq(cpu)->wake_hint);
+	u64 now = sched_clock_cpu(cpu);
+
+	if (wake <= now)
+		return U64_MAX;
+
+	return wake - now;
+}
+#else
+static inline void idle_hint_task_sleep(struct rq *rq, struct task_struct *p) { }
+static inline void idle_hint_task_wake(struct rq *rq, struct task_struct *p) { }
+#endif
+
 static void
 enqueue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 {
 	struct cfs_rq *cfs_rq;
 	struct sched_entity *se = &p->se;
 
+	/* picked up by the cpufreq update the enqueue below triggers */
+	if (p->in_iowait)
+		cpufreq_mark_iowait(rq);
+
+	if (flags & ENQUEUE_WAKEUP)
+		idle_hint_task_wake(rq, p);
+
 	for_each_sched_entity(se) {
 		if (se->on_rq)
 			break;
@@ -4813,6 +4924,9 @@ static void dequeue_task_fair(struct rq *rq, struct task_struct *p, int flags)
 	struct sched_entity *se = &p->se;
 	int task_sleep = flags & DEQUEUE_SLEEP;
 
+	if (task_sleep)
+		idle_hint_task_sleep(rq, p);
+
 	for_each_sched_entity(se) {
 		cfs_rq = cfs_rq_of(se);
 		dequeue_entity(cfs_rq, se, flags);
@@ -5541,6 +5655,36 @@ find_idlest_cpu(struct sched_group *group, struct task_struct *p, int this_cpu)
 /*
  * Try and locate an idle CPU in the sched_domain.
  */
+struct cpumask idle_cpus_mask;
+
+/*
+ * Find an idle cpu sharing the LLC of @target from idle_cpus_mask, which is
+ * updated as each cpu switches to and from its idle task. Only cpus that are
+ * idle are visited, so a wakeup storm on a busy system no longer walks every
+ * group of the domain. With HMP, the idle cpu has to be in the hmp_domain of
+ * @target: moving between domains is up to the HMP migration code.
+ */
+static int select_idle_cpu_cached(struct task_struct *p,
+				  struct sched_domain *sd, int target)
+{
+	int i;
+
+	for_each_cpu_and(i, &idle_cpus_mask, sched_domain_span(sd)) {
+		if (!cpumask_test_cpu(i, tsk_cpus_allowed(p)))
+			continue;
+#ifdef CONFIG_SCHED_HMP
+		if (hmp_cpu_domain(target) &&
+		    !cpumask_test_cpu(i, &hmp_cpu_domain(target)->cpus))
+			continue;
+#endif
+		/* the mask may lag behind a wakeup already queued there */
+		if (idle_cpu(i))
+			return i;
+	}
+
+	return target;
+}
+
 static int select_idle_sibling(struct task_struct *p, int target)
 {
 	struct sched_domain *sd;
@@ -5556,10 +5700,13 @@ static int select_idle_sibling(struct task_struct *p, int target)
 	if (i != target && cpus_share_cache(i, target) && idle_cpu(i))
 		return i;
 
+	sd = rcu_dereference(per_cpu(sd_llc, target));
+	if (sched_feat(IDLE_CPUS_MASK) && sd)
+		return select_idle_cpu_cached(p, sd, target);
+
 	/*
 	 * Otherwise, iterate the domains and find an elegible idle cpu.
 	 */
-	sd = rcu_dereference(per_cpu(sd_llc, target));
 	for_each_lower_domain(sd) {
 		sg = sd->groups;
 		do {
@@ -6439,6 +6586,20 @@ int set_hmp_down_threshold(int value)
 {
 	return hmp_down_threshold_from_sysfs(value);
 }
+
+int set_hmp_thermal_bias(unsigned int bias)
+{
+	if (bias > SCHED_CAPACITY_SCALE)
+		return -EINVAL;
+
+	WRITE_ONCE(hmp_thermal_bias, bias);
+	return 0;
+}
+
+unsigned int get_hmp_thermal_bias(void)
+{
+	return READ_ONCE(hmp_thermal_bias);
+}
 /* packing value must be non-negative */
 static int hmp_packing_enable_from_sysfs(int value)
 {
@@ -6458,6 +6619,24 @@ static int hmp_packing_threshold_from_sysfs(int value)
 	return value;
 }
 
+static int hmp_energy_aware_from_sysfs(int value)
+{
+	if (value < 0 || value > 1)
+		return -1;
+
+	hmp_energy_aware = value;
+	return value;
+}
+
+static int hmp_energy_margin_from_sysfs(int value)
+{
+	if (value < 0 || value > 100)
+		return -1;
+
+	hmp_energy_margin = value;
+	return value;
+}
+
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
 int set_hmp_selective_boost(int enable)
 {
@@ -6615,6 +6794,15 @@ static int hmp_attr_init(void)
 		NULL,
 		hmp_packing_threshold_from_sysfs);
 
+	hmp_attr_add("energy_aware",
+		&hmp_energy_aware,
+		NULL,
+		hmp_energy_aware_from_sysfs);
+	hmp_attr_add("energy_margin",
+		&hmp_energy_margin,
+		NULL,
+		hmp_energy_margin_from_sysfs);
+
 #ifdef CONFIG_HMP_FREQUENCY_INVARIANT_SCALE
 	/* default frequency-invariant scaling ON */
 	hmp_data.freqinvar_load_scale_enabled = 1;
@@ -10140,6 +10328,28 @@ static void nohz_idle_balance(struct rq *this_rq, enum cpu_idle_type idle) { }
 static struct hmp_domain firstboost, secondboost;
 static struct hmp_domain logical_nonboost, logical_boost;
 
+/*
+ * The members of a schedtune colocation group migrate as one: up as soon as
+ * the demand of the whole group no longer fits the domain of @cpu, and down
+ * to it only once it does. Returns -1 for a task that is not in such a group.
+ */
+static int hmp_colocate_fits(int cpu, struct task_struct *p)
+{
+	unsigned long demand;
+
+	if (!schedtune_colocate_demand(p, &demand))
+		return -1;
+
+	return demand * SCHED_CAPACITY_SCALE <
+		capacity_orig_of(cpu) * hmp_up_threshold;
+}
+
+/* hmp_load_avg of a task, within its utilization clamps */
+static inline unsigned long hmp_task_load(struct sched_entity *se)
+{
+	return uclamp_task_util(task_of(se), se->avg.hmp_load_avg);
+}
+
 static int hmp_selective_migration(int prev_cpu, struct sched_entity *se)
 {
 	int new_cpu = NR_CPUS;
@@ -10148,7 +10358,8 @@ static int hmp_selective_migration(int prev_cpu, struct sched_entity *se)
 	struct task_struct *p;
 
 	p = container_of(se, struct task_struct, se);
-	is_boosted_task = cpuset_task_is_boosted(p);
+	is_boosted_task = cpuset_task_is_boosted(p) ||
+		uclamp_eff(p, UCLAMP_MIN) >= hmp_up_threshold;
 
 	/*
 	 * NITP (non-important task packing)
@@ -10181,6 +10392,90 @@ static int hmp_selective_migration(int prev_cpu, struct sched_entity *se)
 }
 #endif
 
+/*
+ * Energy-aware migration
+ *
+ * The demand of a task is its hmp_load_avg, which is frequency invariant,
+ * scaled to the top capacity of the cpu it runs on, so that it is in the
+ * capacity units of the energy model. On a given domain the task needs the
+ * lowest OPP leaving it hmp_energy_margin of headroom, which stands for the
+ * latency budget, and costs the busy power of the core and the cluster at
+ * that OPP for the share of time it keeps them busy. Idle power is left
+ * out as the cpus we compare are idle otherwise either way.
+ *
+ * Up migration uses half the margin and down migration the whole of it so
+ * that a task does not bounce between domains at the boundary.
+ */
+static bool hmp_energy_enabled(int cpu)
+{
+	if (!hmp_energy_aware || hmp_semiboost())
+		return false;
+
+	return sge_array[cpu][SD_LEVEL0] != NULL;
+}
+
+static unsigned long hmp_task_demand(int cpu, struct sched_entity *se)
+{
+	const struct sched_group_energy *sge = sge_array[cpu][SD_LEVEL0];
+	unsigned long max_cap = sge->cap_states[sge->nr_cap_states - 1].cap;
+
+	return (hmp_task_load(se) * max_cap) >> SCHED_CAPACITY_SHIFT;
+}
+
+/* busy energy rate of @demand on the domain of @cpu, ULONG_MAX if too big */
+static unsigned long hmp_energy_cost(int cpu, unsigned long demand,
+				     unsigned int margin)
+{
+	const struct sched_group_energy *core = sge_array[cpu][SD_LEVEL0];
+	const struct sched_group_energy *cluster = sge_array[cpu][SD_LEVEL1];
+	unsigned long need = demand * (100 + margin) / 100;
+	int i;
+
+	if (!core)
+		return ULONG_MAX;
+
+	for (i = 0; i < core->nr_cap_states; i++) {
+		unsigned long cap = core->cap_states[i].cap;
+		unsigned long power = core->cap_states[i].power;
+
+		if (cap < need || !cap)
+			continue;
+
+		if (cluster && i < cluster->nr_cap_states)
+			power += cluster->cap_states[i].power;
+
+		return power * max(demand, 1UL) / cap;
+	}
+
+	return ULONG_MAX;
+}
+
+static bool hmp_energy_up(int cpu, struct sched_entity *se)
+{
+	int fast = cpumask_first(&hmp_faster_domain(cpu)->cpus);
+	unsigned long demand = hmp_task_demand(cpu, se);
+	unsigned int margin = hmp_energy_margin / 2;
+	unsigned long here = hmp_energy_cost(cpu, demand, margin);
+
+	/* out of headroom here: the latency budget comes first */
+	if (here == ULONG_MAX)
+		return true;
+
+	return hmp_energy_cost(fast, demand, margin) < here;
+}
+
+static bool hmp_energy_down(int cpu, struct sched_entity *se)
+{
+	int slow = cpumask_first(&hmp_slower_domain(cpu)->cpus);
+	unsigned long demand = hmp_task_demand(cpu, se);
+	unsigned long there = hmp_energy_cost(slow, demand, hmp_energy_margin);
+
+	if (there == ULONG_MAX)
+		return false;
+
+	return there <= hmp_energy_cost(cpu, demand, hmp_energy_margin / 2);
+}
+
 /* Check if task should migrate to a faster cpu */
 static unsigned int hmp_up_migration(int cpu, int *target_cpu, struct sched_entity *se)
 {
@@ -10201,12 +10496,21 @@ static unsigned int hmp_up_migration(int cpu, int *target_cpu, struct sched_enti
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
 		if (!hmp_selective_boost() || !is_boosted_task) {
 #endif
+			int colocate = hmp_colocate_fits(cpu, p);
+
 			if (hmp_semiboost())
 				up_threshold = hmp_semiboost_up_threshold;
 			else
 				up_threshold = hmp_up_threshold;
-
-			if (se->avg.hmp_load_avg < up_threshold)
+			up_threshold = hmp_thermal_up(up_threshold);
+
+			if (colocate >= 0) {
+				if (colocate)
+					return 0;
+			} else if (hmp_energy_enabled(cpu)) {
+				if (!hmp_energy_up(cpu, se))
+					return 0;
+			} else if (hmp_task_load(se) < up_threshold)
 				return 0;
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
 		}
@@ -10282,13 +10586,25 @@ static unsigned int hmp_down_migration(int cpu, struct sched_entity *se)
 	if (cpumask_intersects(&hmp_slower_domain(cpu)->cpus,
 					tsk_cpus_allowed(p))) {
 		unsigned int down_threshold;
+		int colocate;
+
+		colocate = hmp_colocate_fits(
+				cpumask_first(&hmp_slower_domain(cpu)->cpus), p);
+		if (colocate >= 0)
+			return colocate;
 
 		if (hmp_semiboost())
-			down_threshold = hmp_semiboost_down_threshold;
+			down_threshold = hmp_thermal_down(
+					hmp_semiboost_down_threshold,
+					hmp_semiboost_up_threshold);
 		else
-			down_threshold = hmp_down_threshold;
+			down_threshold = hmp_thermal_down(hmp_down_threshold,
+							  hmp_up_threshold);
+
+		if (hmp_energy_enabled(cpu))
+			return hmp_energy_down(cpu, se);
 
-		if (se->avg.hmp_load_avg < down_threshold)
+		if (hmp_task_load(se) < down_threshold)
 			return 1;
 	}
 	return 0;
@@ -10754,6 +11070,7 @@ static unsigned int hmp_idle_pull(int this_cpu)
 			up_threshold = hmp_semiboost_up_threshold;
 		else
 			up_threshold = hmp_up_threshold;
+		up_threshold = hmp_thermal_up(up_threshold);
 #ifdef CONFIG_SCHED_HMP_SELECTIVE_BOOST_WITH_NITP
 		if (p != NULL)
 			is_boosted_task = cpuset_task_is_boosted(p);
@@ -64,6 +64,12 @@ SCHED_FEAT(TTWU_QUEUE, false)
 SCHED_FEAT(RT_PUSH_IPI, true)
 #endif
 
+/*
+ * On asymmetric capacity systems, place RT tasks on the smallest cpus that
+ * can serve their recent demand, and move them off cpus that can't.
+ */
+SCHED_FEAT(RT_CAPACITY_AWARE, true)
+
 SCHED_FEAT(FORCE_SD_OVERLAP, false)
 SCHED_FEAT(RT_RUNTIME_SHARE, false)
 SCHED_FEAT(LB_MIN, false)
@@ -79,5 +85,11 @@ SCHED_FEAT(ENERGY_AWARE, true)
 SCHED_FEAT(ENERGY_AWARE, false)
 #endif
 
+/*
+ * Pick the idle sibling of a wakeup from idle_cpus_mask rather than by
+ * scanning the sched groups of the LLC domain.
+ */
+SCHED_FEAT(IDLE_CPUS_MASK, true)
+
 SCHED_FEAT(ALT_PERIOD, true)
 SCHED_FEAT(BASE_SLICE, true)
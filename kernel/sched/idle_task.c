@@ -27,6 +27,7 @@ static struct task_struct *
 pick_next_task_idle(struct rq *rq, struct task_struct *prev)
 {
 	put_prev_task(rq, prev);
+	idle_cpus_mask_update(rq, true);
 
 	schedstat_inc(rq, sched_goidle);
 	return rq->idle;
@@ -47,6 +48,7 @@ dequeue_task_idle(struct rq *rq, struct task_struct *p, int flags)
 
 static void put_prev_task_idle(struct rq *rq, struct task_struct *prev)
 {
+	idle_cpus_mask_update(rq, false);
 	idle_exit_fair(rq);
 	rq_last_tick_reset(rq);
 }
@@ -4,6 +4,7 @@
  */
 
 #include "sched.h"
+#include "walt.h"
 
 #include <linux/slab.h>
 #include <linux/irq_work.h>
@@ -1661,6 +1662,134 @@ static void yield_task_rt(struct rq *rq)
 #ifdef CONFIG_SMP
 static int find_lowest_rq(struct task_struct *task);
 
+/* a cpu fits a task that leaves it ~20% headroom */
+#define RT_CAPACITY_MARGIN	1280
+
+/* recent demand of @p in capacity units: WALT when on, PELT otherwise */
+static unsigned long rt_task_util(struct task_struct *p)
+{
+#ifdef CONFIG_SCHED_WALT
+	if (!walt_disabled)
+		return div64_u64((u64)p->ravg.demand << SCHED_CAPACITY_SHIFT,
+				 walt_ravg_window);
+#endif
+	return p->rt.avg.util_avg;
+}
+
+static inline bool rt_util_fits_capacity(unsigned long util,
+					 unsigned long capacity)
+{
+	return util * RT_CAPACITY_MARGIN < capacity * SCHED_CAPACITY_SCALE;
+}
+
+/* the biggest cpus have SCHED_CAPACITY_SCALE and fit anything */
+static inline bool rt_task_fits_cpu(struct task_struct *p, int cpu)
+{
+	unsigned long cap = arch_scale_cpu_capacity(NULL, cpu);
+
+	if (!sched_feat(RT_CAPACITY_AWARE) || cap >= SCHED_CAPACITY_SCALE)
+		return true;
+
+	return rt_util_fits_capacity(rt_task_util(p), cap);
+}
+
+/*
+ * A fitting cpu outside the lowest priority class: the smallest one whose
+ * highest queued priority is lower than @task's, the least busy with RT
+ * work first.
+ */
+static int find_fit_preemptible_cpu(struct task_struct *task,
+				    unsigned long util)
+{
+	unsigned long best_cap = ULONG_MAX;
+	int best_prio = task->prio;
+	int best_cpu = -1;
+	int cpu;
+
+	for_each_cpu_and(cpu, tsk_cpus_allowed(task), cpu_active_mask) {
+		unsigned long cap = arch_scale_cpu_capacity(NULL, cpu);
+		int prio = READ_ONCE(cpu_rq(cpu)->rt.highest_prio.curr);
+
+		if (!rt_util_fits_capacity(util, cap))
+			continue;
+
+		if (prio > best_prio || (prio == best_prio && cap < best_cap)) {
+			best_prio = prio;
+			best_cap = cap;
+			best_cpu = cpu;
+		}
+	}
+
+	return best_cpu;
+}
+
+/*
+ * Pick from @lowest_mask the cpus of the smallest capacity that fits @task,
+ * preferring an idle one, then the cpu the task last ran on. If none fits,
+ * a bigger cpu running lower priority work is preempted, or else the
+ * biggest cpu of the mask is taken, again idle ones first.
+ * Returns -1 to leave the choice to the topology when capacity does not
+ * tell the cpus of the mask apart.
+ */
+static int find_lowest_rq_capacity(struct task_struct *task,
+				   struct cpumask *lowest_mask)
+{
+	unsigned long util = rt_task_util(task);
+	unsigned long min_cap = ULONG_MAX, max_cap = 0;
+	unsigned long fit_cap = ULONG_MAX, big_cap = 0;
+	int fit_cpu = -1, big_cpu = -1;
+	bool fit_idle = false, big_idle = false;
+	int prev_cpu = task_cpu(task);
+	int cpu;
+
+	for_each_cpu(cpu, lowest_mask) {
+		unsigned long cap = arch_scale_cpu_capacity(NULL, cpu);
+		bool idle = idle_cpu(cpu);
+
+		min_cap = min(min_cap, cap);
+		max_cap = max(max_cap, cap);
+
+		if (rt_util_fits_capacity(util, cap) &&
+		    (cap < fit_cap ||
+		     (cap == fit_cap && idle && !fit_idle) ||
+		     (cap == fit_cap && idle == fit_idle && cpu == prev_cpu))) {
+			fit_cap = cap;
+			fit_cpu = cpu;
+			fit_idle = idle;
+		}
+
+		if (cap > big_cap ||
+		    (cap == big_cap && idle && !big_idle) ||
+		    (cap == big_cap && idle == big_idle && cpu == prev_cpu)) {
+			big_cap = cap;
+			big_cpu = cpu;
+			big_idle = idle;
+		}
+	}
+
+	if (fit_cpu != -1) {
+		if (min_cap == max_cap)
+			return -1;
+
+		schedstat_inc(this_rq(), rt_place_fit);
+		if (fit_idle)
+			schedstat_inc(this_rq(), rt_place_fit_idle);
+		return fit_cpu;
+	}
+
+	cpu = find_fit_preemptible_cpu(task, util);
+	if (cpu != -1) {
+		schedstat_inc(this_rq(), rt_place_fit);
+		return cpu;
+	}
+
+	if (min_cap == max_cap)
+		return -1;
+
+	schedstat_inc(this_rq(), rt_place_nofit);
+	return big_cpu;
+}
+
 #ifdef CONFIG_SCHED_USE_FLUID_RT
 static int
 select_task_rq_rt_fluid(struct task_struct *p, int cpu, int sd_flag, int flags)
@@ -1700,6 +1829,7 @@ select_task_rq_rt(struct task_struct *p, int cpu, int sd_flag, int flags)
 {
 	struct task_struct *curr;
 	struct rq *rq;
+	bool misfit;
 
 	/* For anything but wake ups, just return the task_cpu */
 	if (sd_flag != SD_BALANCE_WAKE && sd_flag != SD_BALANCE_FORK)
@@ -1731,10 +1861,17 @@ select_task_rq_rt(struct task_struct *p, int cpu, int sd_flag, int flags)
 	 *
 	 * This test is optimistic, if we get it wrong the load-balancer
 	 * will have to sort it out.
+	 *
+	 * A task whose recent demand does not fit the capacity of this
+	 * cpu looks for a bigger one as well.
 	 */
-	if (curr && unlikely(rt_task(curr)) &&
-	    (tsk_nr_cpus_allowed(curr) < 2 ||
-	     curr->prio <= p->prio)) {
+	misfit = !rt_task_fits_cpu(p, cpu);
+	if (misfit)
+		schedstat_inc(this_rq(), rt_wake_misfit);
+
+	if ((curr && unlikely(rt_task(curr)) &&
+	     (tsk_nr_cpus_allowed(curr) < 2 ||
+	      curr->prio <= p->prio)) || misfit) {
 		int target = find_lowest_rq(p);
 
 		/*
@@ -2500,8 +2637,19 @@ static int find_lowest_rq(struct task_struct *task)
 
 	/*
 	 * At this point we have built a mask of cpus representing the
-	 * lowest priority tasks in the system.  Now we want to elect
-	 * the best one based on our affinity and topology.
+	 * lowest priority tasks in the system.  On big.LITTLE the capacity
+	 * the task needs decides first.
+	 */
+	if (sched_feat(RT_CAPACITY_AWARE)) {
+		int best_cpu = find_lowest_rq_capacity(task, lowest_mask);
+
+		if (best_cpu != -1)
+			return best_cpu;
+	}
+
+	/*
+	 * Otherwise we want to elect the best one based on our affinity
+	 * and topology.
 	 *
 	 * We prioritize the last cpu that the task executed on since
 	 * it is most likely cache-hot in that location.
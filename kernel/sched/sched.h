@@ -605,6 +605,26 @@ extern void rto_push_irq_work_func(struct irq_work *work);
  * (such as the load balancing or the thread migration code), lock
  * acquire operations must be ordered by ascending &runqueue.
  */
+#ifdef CONFIG_UCLAMP_TASK
+#define UCLAMP_BUCKETS		5
+#define UCLAMP_BUCKET_DELTA	DIV_ROUND_CLOSEST(SCHED_CAPACITY_SCALE, UCLAMP_BUCKETS)
+
+/*
+ * Runnable tasks are counted in buckets of clamp values. A bucket keeps the
+ * largest value it has seen since it was last empty and the clamp of the rq
+ * is the one of its highest non-empty bucket.
+ */
+struct uclamp_bucket {
+	unsigned int value;
+	unsigned int tasks;
+};
+
+struct uclamp_rq {
+	unsigned int value;
+	struct uclamp_bucket bucket[UCLAMP_BUCKETS];
+};
+#endif
+
 struct rq {
 	/* runqueue lock: */
 	raw_spinlock_t lock;
@@ -637,6 +657,10 @@ struct rq {
 	struct rt_rq rt;
 	struct dl_rq dl;
 
+#ifdef CONFIG_UCLAMP_TASK
+	struct uclamp_rq uclamp[UCLAMP_CNT];
+#endif
+
 #ifdef CONFIG_FAIR_GROUP_SCHED
 	/* list of leaf cfs_rq on this cpu: */
 	struct list_head leaf_cfs_rq_list;
@@ -659,6 +683,10 @@ struct rq {
 	u64 clock_task;
 
 	atomic_t nr_iowait;
+#ifdef CONFIG_CPU_FREQ
+	/* a task woke up from iowait since the last cpufreq update */
+	bool cpufreq_iowait;
+#endif
 
 #ifdef CONFIG_SMP
 	struct root_domain *rd;
@@ -734,6 +762,14 @@ struct rq {
 	/* try_to_wake_up() stats */
 	unsigned int ttwu_count;
 	unsigned int ttwu_local;
+
+#ifdef CONFIG_SMP
+	/* capacity-aware RT placement decided on this cpu */
+	unsigned int rt_place_fit;
+	unsigned int rt_place_fit_idle;
+	unsigned int rt_place_nofit;
+	unsigned int rt_wake_misfit;
+#endif
 #endif
 
 #ifdef CONFIG_SMP
@@ -744,6 +780,12 @@ struct rq {
 	/* Must be inspected within a rcu lock section */
 	struct cpuidle_state *idle_state;
 #endif
+
+#ifdef CONFIG_CPU_IDLE_SCHED_HINT
+	/* rq_clock at which wake_hint_task is expected to wake up again */
+	u64 wake_hint;
+	struct task_struct *wake_hint_task;
+#endif
 };
 
 #ifdef CONFIG_FAIR_GROUP_SCHED
@@ -1141,6 +1183,28 @@ static inline int task_on_rq_migrating(struct task_struct *p)
 	return p->on_rq == TASK_ON_RQ_MIGRATING;
 }
 
+#ifdef CONFIG_SCHED_WAKELAT
+#define WAKELAT_BUCKETS		16
+
+extern void wakelat_record(struct rq *rq, struct task_struct *p);
+
+/* a task woken while still on its CPU has nothing to wait for */
+static inline void wakelat_wakeup(struct rq *rq, struct task_struct *p)
+{
+	if (!task_running(rq, p))
+		p->wakelat_ts = rq_clock(rq);
+}
+
+static inline void wakelat_switch_in(struct rq *rq, struct task_struct *p)
+{
+	if (p->wakelat_ts)
+		wakelat_record(rq, p);
+}
+#else
+static inline void wakelat_wakeup(struct rq *rq, struct task_struct *p) { }
+static inline void wakelat_switch_in(struct rq *rq, struct task_struct *p) { }
+#endif
+
 #ifndef prepare_arch_switch
 # define prepare_arch_switch(next)	do { } while (0)
 #endif
@@ -1371,10 +1435,22 @@ extern void idle_exit_fair(struct rq *this_rq);
 
 extern void set_cpus_allowed_common(struct task_struct *p, const struct cpumask *new_mask);
 
+/* CPUs currently running their idle task, see select_idle_sibling() */
+extern struct cpumask idle_cpus_mask;
+
+static inline void idle_cpus_mask_update(struct rq *rq, bool idle)
+{
+	if (idle)
+		cpumask_set_cpu(cpu_of(rq), &idle_cpus_mask);
+	else
+		cpumask_clear_cpu(cpu_of(rq), &idle_cpus_mask);
+}
+
 #else
 
 static inline void idle_enter_fair(struct rq *rq) { }
 static inline void idle_exit_fair(struct rq *rq) { }
+static inline void idle_cpus_mask_update(struct rq *rq, bool idle) { }
 
 #endif
 
@@ -1899,6 +1975,42 @@ static inline u64 irq_time_read(int cpu)
 #endif /* CONFIG_64BIT */
 #endif /* CONFIG_IRQ_TIME_ACCOUNTING */
 
+static inline unsigned int uclamp_none(int clamp_id)
+{
+	return clamp_id == UCLAMP_MIN ? 0 : SCHED_CAPACITY_SCALE;
+}
+
+#ifdef CONFIG_UCLAMP_TASK
+unsigned int uclamp_eff(struct task_struct *p, int clamp_id);
+unsigned long uclamp_task_util(struct task_struct *p, unsigned long util);
+
+/* @util of a cpu within the clamps of the tasks runnable on it */
+static inline unsigned long uclamp_rq_util(struct rq *rq, unsigned long util)
+{
+	unsigned long umin = READ_ONCE(rq->uclamp[UCLAMP_MIN].value);
+	unsigned long umax = READ_ONCE(rq->uclamp[UCLAMP_MAX].value);
+
+	/* one task's floor wins over another one's cap */
+	return clamp(util, umin, max(umin, umax));
+}
+#else
+static inline unsigned int uclamp_eff(struct task_struct *p, int clamp_id)
+{
+	return uclamp_none(clamp_id);
+}
+
+static inline unsigned long uclamp_task_util(struct task_struct *p,
+					     unsigned long util)
+{
+	return util;
+}
+
+static inline unsigned long uclamp_rq_util(struct rq *rq, unsigned long util)
+{
+	return util;
+}
+#endif
+
 #ifdef CONFIG_CPU_FREQ
 
 /**
@@ -1952,9 +2064,16 @@ static inline void cpufreq_trigger_update(u64 time)
 #else
 static inline void cpufreq_trigger_update(u64 time) {}
 #endif
+
+/* Let the next cpufreq_update_util() on @rq know about an iowait wakeup */
+static inline void cpufreq_mark_iowait(struct rq *rq)
+{
+	rq->cpufreq_iowait = true;
+}
 #else
 static inline void cpufreq_update_util(u64 time, unsigned long util, unsigned long max) {}
 static inline void cpufreq_trigger_update(u64 time) {}
+static inline void cpufreq_mark_iowait(struct rq *rq) {}
 #endif /* CONFIG_CPU_FREQ */
 
 #ifdef arch_scale_freq_capacity
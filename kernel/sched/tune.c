@@ -3,6 +3,7 @@
 #include <linux/percpu.h>
 #include <linux/printk.h>
 #include <linux/rcupdate.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 
 #include "sched.h"
@@ -10,6 +11,10 @@
 
 unsigned int sysctl_sched_cfs_boost __read_mostly;
 
+#ifdef CONFIG_FREQVAR_SCHEDTUNE
+static struct freqvar_boost_state freqvar_boost_state[CONFIG_NR_CPUS];
+#endif
+
 #ifdef CONFIG_CGROUP_SCHEDTUNE
 
 bool schedtune_initialized = false;
@@ -29,6 +34,11 @@ struct schedtune {
 	/* Boost value for tasks on that SchedTune CGroup */
 	int boost;
 
+#ifdef CONFIG_UCLAMP_TASK
+	/* Utilization clamps for tasks on that SchedTune CGroup */
+	unsigned int util_min;
+	unsigned int util_max;
+#endif
 };
 
 static inline struct schedtune *css_st(struct cgroup_subsys_state *css)
@@ -58,6 +68,10 @@ static inline struct schedtune *parent_st(struct schedtune *st)
 static struct schedtune
 root_schedtune = {
 	.boost	= 0,
+#ifdef CONFIG_UCLAMP_TASK
+	.util_min = 0,
+	.util_max = SCHED_CAPACITY_SCALE,
+#endif
 };
 
 /*
@@ -101,6 +115,90 @@ struct boost_groups {
 /* Boost groups affecting each CPU in the system */
 DEFINE_PER_CPU(struct boost_groups, cpu_boost_groups);
 
+/* SchedTune colocation groups
+ * The tasks of a boost group with "colocate" set form a related thread
+ * group, like the stages of a frame pipeline, that each look light but
+ * together have to finish within a deadline. Every member contributes its
+ * utilization as of its last enqueue or dequeue, so that sleeping stages
+ * still count, and the whole sum is what the group asks for: as frequency
+ * on every CPU one of its members is RUNNABLE on, and as the capacity the
+ * cluster running all of them must have.
+ */
+static struct {
+	bool enabled;
+	/* Sum of member contributions, in capacity units */
+	atomic_long_t demand;
+} colocate_group[BOOSTGROUPS_COUNT];
+
+static atomic_t nr_colocate_groups = ATOMIC_INIT(0);
+
+static inline unsigned long colocate_group_demand(int idx)
+{
+	return max(atomic_long_read(&colocate_group[idx].demand), 0L);
+}
+
+/*
+ * Move the contribution of @p to group @idx. A task leaving a group, or a
+ * group being disabled, only drains at the next update of each member.
+ */
+static void
+schedtune_colocate_update(struct task_struct *p, int idx, bool exiting)
+{
+	unsigned long demand;
+
+	if (p->colocate_demand)
+		atomic_long_sub(p->colocate_demand,
+				&colocate_group[p->colocate_idx].demand);
+	p->colocate_demand = 0;
+
+	if (exiting || !READ_ONCE(colocate_group[idx].enabled))
+		return;
+
+	demand = max(READ_ONCE(p->se.avg.util_avg), 1UL);
+	p->colocate_idx = idx;
+	p->colocate_demand = demand;
+	atomic_long_add(demand, &colocate_group[idx].demand);
+}
+
+unsigned long schedtune_cpu_colocate_util(int cpu)
+{
+	struct boost_groups *bg;
+	unsigned long util = 0;
+	int idx;
+
+	if (!atomic_read(&nr_colocate_groups))
+		return 0;
+
+	bg = &per_cpu(cpu_boost_groups, cpu);
+	for (idx = 1; idx < BOOSTGROUPS_COUNT; ++idx) {
+		if (!bg->group[idx].tasks || !READ_ONCE(colocate_group[idx].enabled))
+			continue;
+		util = max(util, colocate_group_demand(idx));
+	}
+
+	return util;
+}
+
+/* Demand of the colocation group of @p, false if it is not in one */
+bool schedtune_colocate_demand(struct task_struct *p, unsigned long *demand)
+{
+	int idx;
+
+	if (!unlikely(schedtune_initialized) ||
+	    !atomic_read(&nr_colocate_groups))
+		return false;
+
+	rcu_read_lock();
+	idx = task_schedtune(p)->idx;
+	rcu_read_unlock();
+
+	if (!READ_ONCE(colocate_group[idx].enabled))
+		return false;
+
+	*demand = colocate_group_demand(idx);
+	return true;
+}
+
 static void
 schedtune_cpu_update(int cpu)
 {
@@ -211,6 +309,7 @@ void schedtune_enqueue_task(struct task_struct *p, int cpu)
 	idx = st->idx;
 	rcu_read_unlock();
 
+	schedtune_colocate_update(p, idx, false);
 	schedtune_tasks_update(p, cpu, idx, ENQUEUE_TASK);
 }
 
@@ -241,6 +340,7 @@ void schedtune_dequeue_task(struct task_struct *p, int cpu)
 	idx = st->idx;
 	rcu_read_unlock();
 
+	schedtune_colocate_update(p, idx, false);
 	schedtune_tasks_update(p, cpu, idx, -1);
 }
 
@@ -261,17 +361,172 @@ void schedtune_exit_task(struct task_struct *tsk)
 	cpu = cpu_of(rq);
 	st = task_schedtune(tsk);
 	idx = st->idx;
+	schedtune_colocate_update(tsk, idx, true);
 	schedtune_tasks_update(tsk, cpu, idx, DEQUEUE_TASK);
 
 	rcu_read_unlock();
 	unlock_rq_of(rq, tsk, &irq_flags);
 }
 
+#ifdef CONFIG_FREQVAR_SCHEDTUNE
+/* SchedTune frequency-variant boost groups
+ * A boost group can have its own boost vs frequency curve, so that for
+ * example top-app gets boosted the most while its CPUs are still slow and
+ * background only once there is headroom left. The curve is parsed from
+ * the same "boost freq boost freq ... boost" format as the DT table, with
+ * frequencies in ascending order: each boost applies up to and including
+ * the frequency that follows it, and the last one above all of them. On a
+ * CPU the group boosts by the larger of its static boost and the curve at
+ * the current frequency of that CPU.
+ */
+#define FREQVAR_GROUP_ENTRIES	16
+
+struct freqvar_group_table {
+	struct rcu_head rcu;
+	int nr_entries;
+	/* ascending frequency, the last one is INT_MAX */
+	struct freqvar_boost_table entry[FREQVAR_GROUP_ENTRIES];
+};
+
+static struct freqvar_group_table __rcu *freqvar_group[BOOSTGROUPS_COUNT];
+static atomic_t nr_freqvar_groups = ATOMIC_INIT(0);
+static DEFINE_MUTEX(freqvar_group_mutex);
+
+static int freqvar_group_boost(struct freqvar_group_table *table, int freq)
+{
+	int i;
+
+	for (i = 0; i < table->nr_entries - 1; i++)
+		if (freq <= table->entry[i].frequency)
+			break;
+
+	return table->entry[i].boost;
+}
+
+static int schedtune_freqvar_cpu_boost(int cpu, struct boost_groups *bg)
+{
+	struct freqvar_group_table *table;
+	int freq = READ_ONCE(freqvar_boost_state[cpu].cur_freq);
+	int boost_max = bg->boost_max;
+	int idx;
+
+	/* no transition seen yet */
+	if (!freq)
+		return boost_max;
+
+	rcu_read_lock();
+	for (idx = 0; idx < BOOSTGROUPS_COUNT; ++idx) {
+		/* The root boost group is always active */
+		if (idx && !bg->group[idx].tasks)
+			continue;
+		table = rcu_dereference(freqvar_group[idx]);
+		if (table)
+			boost_max = max(boost_max, freqvar_group_boost(table, freq));
+	}
+	rcu_read_unlock();
+
+	return boost_max;
+}
+
+static void schedtune_freqvar_group_set(int idx,
+					struct freqvar_group_table *table)
+{
+	struct freqvar_group_table *old;
+
+	mutex_lock(&freqvar_group_mutex);
+	old = rcu_dereference_protected(freqvar_group[idx],
+			lockdep_is_held(&freqvar_group_mutex));
+	rcu_assign_pointer(freqvar_group[idx], table);
+	mutex_unlock(&freqvar_group_mutex);
+
+	if (!old != !table)
+		atomic_add(table ? 1 : -1, &nr_freqvar_groups);
+	if (old)
+		kfree_rcu(old, rcu);
+}
+
+static int freqvar_boost_show(struct seq_file *sf, void *v)
+{
+	struct schedtune *st = css_st(seq_css(sf));
+	struct freqvar_group_table *table;
+	int i;
+
+	rcu_read_lock();
+	table = rcu_dereference(freqvar_group[st->idx]);
+	for (i = 0; table && i < table->nr_entries; i++) {
+		seq_printf(sf, "%d", table->entry[i].boost);
+		if (i < table->nr_entries - 1)
+			seq_printf(sf, " %d ", table->entry[i].frequency);
+	}
+	rcu_read_unlock();
+	seq_putc(sf, '\n');
+
+	return 0;
+}
+
+/* An empty write drops the group table */
+static ssize_t freqvar_boost_write(struct kernfs_open_file *of,
+				   char *buf, size_t nbytes, loff_t off)
+{
+	struct schedtune *st = css_st(of_css(of));
+	struct freqvar_group_table *table;
+	char *tok;
+	int n = 0, val, prev_freq = 0;
+
+	buf = strstrip(buf);
+	if (!*buf) {
+		schedtune_freqvar_group_set(st->idx, NULL);
+		return nbytes;
+	}
+
+	table = kzalloc(sizeof(*table), GFP_KERNEL);
+	if (!table)
+		return -ENOMEM;
+
+	/* even tokens are boost values, odd ones frequencies */
+	while ((tok = strsep(&buf, " :")) != NULL) {
+		if (!*tok)
+			continue;
+		if (kstrtoint(tok, 10, &val) || val < 0)
+			goto invalid;
+
+		if (!(n & 1)) {
+			if (n / 2 >= FREQVAR_GROUP_ENTRIES || val > 100)
+				goto invalid;
+			table->entry[n / 2].boost = val;
+		} else {
+			if (val <= prev_freq)
+				goto invalid;
+			table->entry[n / 2].frequency = prev_freq = val;
+		}
+		n++;
+	}
+
+	/* it has to end with the boost above the last frequency */
+	if (!(n & 1))
+		goto invalid;
+
+	table->nr_entries = n / 2 + 1;
+	table->entry[n / 2].frequency = INT_MAX;
+	schedtune_freqvar_group_set(st->idx, table);
+
+	return nbytes;
+
+invalid:
+	kfree(table);
+	return -EINVAL;
+}
+#endif /* CONFIG_FREQVAR_SCHEDTUNE */
+
 int schedtune_cpu_boost(int cpu)
 {
 	struct boost_groups *bg;
 
 	bg = &per_cpu(cpu_boost_groups, cpu);
+#ifdef CONFIG_FREQVAR_SCHEDTUNE
+	if (atomic_read(&nr_freqvar_groups))
+		return schedtune_freqvar_cpu_boost(cpu, bg);
+#endif
 	return bg->boost_max;
 }
 
@@ -313,9 +568,63 @@ int schedtune_task_boost(struct task_struct *p)
 	task_boost = max(st->boost, schedtune_adj_ta(p));
 	rcu_read_unlock();
 
-	return task_boost;
+	return max(task_boost, READ_ONCE(p->inherited_boost));
+}
+
+#ifdef CONFIG_UCLAMP_TASK
+unsigned int schedtune_task_uclamp(struct task_struct *p, int clamp_id)
+{
+	struct schedtune *st;
+	unsigned int value;
+
+	if (!unlikely(schedtune_initialized))
+		return uclamp_none(clamp_id);
+
+	rcu_read_lock();
+	st = task_schedtune(p);
+	value = clamp_id == UCLAMP_MIN ? st->util_min : st->util_max;
+	rcu_read_unlock();
+
+	return value;
+}
+
+/*
+ * A new value is picked up by each task the next time it is enqueued, which
+ * for a runnable task is at the latest its next tick preemption.
+ */
+static u64 util_min_read(struct cgroup_subsys_state *css,
+			 struct cftype *cft)
+{
+	return css_st(css)->util_min;
+}
+
+static int util_min_write(struct cgroup_subsys_state *css,
+			  struct cftype *cft, u64 util_min)
+{
+	if (util_min > SCHED_CAPACITY_SCALE)
+		return -EINVAL;
+
+	css_st(css)->util_min = util_min;
+	return 0;
+}
+
+static u64 util_max_read(struct cgroup_subsys_state *css,
+			 struct cftype *cft)
+{
+	return css_st(css)->util_max;
 }
 
+static int util_max_write(struct cgroup_subsys_state *css,
+			  struct cftype *cft, u64 util_max)
+{
+	if (util_max > SCHED_CAPACITY_SCALE)
+		return -EINVAL;
+
+	css_st(css)->util_max = util_max;
+	return 0;
+}
+#endif
+
 static u64
 boost_read(struct cgroup_subsys_state *css, struct cftype *cft)
 {
@@ -343,6 +652,27 @@ boost_write(struct cgroup_subsys_state *css, struct cftype *cft,
 	return 0;
 }
 
+static u64 colocate_read(struct cgroup_subsys_state *css,
+			 struct cftype *cft)
+{
+	return colocate_group[css_st(css)->idx].enabled;
+}
+
+static int colocate_write(struct cgroup_subsys_state *css,
+			  struct cftype *cft, u64 colocate)
+{
+	struct schedtune *st = css_st(css);
+
+	/* the root group holds every task, there is nothing to relate */
+	if (colocate > 1 || css == &root_schedtune.css)
+		return -EINVAL;
+
+	if (xchg(&colocate_group[st->idx].enabled, !!colocate) != !!colocate)
+		atomic_add(colocate ? 1 : -1, &nr_colocate_groups);
+
+	return 0;
+}
+
 static u64 prefer_high_cap_read(struct cgroup_subsys_state *css,
 				struct cftype *cft)
 {
@@ -361,11 +691,35 @@ static struct cftype files[] = {
 		.read_u64 = boost_read,
 		.write_u64 = boost_write,
 	},
+	{
+		.name = "colocate",
+		.read_u64 = colocate_read,
+		.write_u64 = colocate_write,
+	},
 	{
 		.name = "prefer_high_cap",
 		.read_u64 = prefer_high_cap_read,
 		.write_u64 = prefer_high_cap_write,
 	},
+#ifdef CONFIG_UCLAMP_TASK
+	{
+		.name = "util_min",
+		.read_u64 = util_min_read,
+		.write_u64 = util_min_write,
+	},
+	{
+		.name = "util_max",
+		.read_u64 = util_max_read,
+		.write_u64 = util_max_write,
+	},
+#endif
+#ifdef CONFIG_FREQVAR_SCHEDTUNE
+	{
+		.name = "freqvar_boost",
+		.seq_show = freqvar_boost_show,
+		.write = freqvar_boost_write,
+	},
+#endif
 	{ }	/* terminate */
 };
 
@@ -439,6 +793,10 @@ schedtune_css_alloc(struct cgroup_subsys_state *parent_css)
 	if (!st)
 		goto out;
 
+#ifdef CONFIG_UCLAMP_TASK
+	st->util_max = SCHED_CAPACITY_SCALE;
+#endif
+
 	/* Initialize per CPUs boost group support */
 	st->idx = idx;
 	if (schedtune_boostgroup_init(st))
@@ -452,11 +810,56 @@ out:
 	return ERR_PTR(-ENOMEM);
 }
 
+/* Boost group of the "top-app" cgroup, 0 when there is none */
+static int top_app_idx;
+
+bool schedtune_task_top_app(struct task_struct *p)
+{
+	int idx, top_idx = READ_ONCE(top_app_idx);
+
+	if (!top_idx)
+		return false;
+
+	rcu_read_lock();
+	idx = task_schedtune(p)->idx;
+	rcu_read_unlock();
+
+	return idx == top_idx;
+}
+
+static int
+schedtune_css_online(struct cgroup_subsys_state *css)
+{
+	struct schedtune *st = css_st(css);
+	char name[16];
+
+	if (st != &root_schedtune &&
+	    cgroup_name(css->cgroup, name, sizeof(name)) > 0 &&
+	    !strcmp(name, "top-app"))
+		WRITE_ONCE(top_app_idx, st->idx);
+
+	return 0;
+}
+
+static void
+schedtune_css_offline(struct cgroup_subsys_state *css)
+{
+	struct schedtune *st = css_st(css);
+
+	if (READ_ONCE(top_app_idx) == st->idx)
+		WRITE_ONCE(top_app_idx, 0);
+}
+
 static void
 schedtune_boostgroup_release(struct schedtune *st)
 {
 	/* Reset this boost group */
 	schedtune_boostgroup_update(st->idx, 0);
+	if (xchg(&colocate_group[st->idx].enabled, false))
+		atomic_dec(&nr_colocate_groups);
+#ifdef CONFIG_FREQVAR_SCHEDTUNE
+	schedtune_freqvar_group_set(st->idx, NULL);
+#endif
 
 	/* Keep track of allocated boost groups */
 	allocated_group[st->idx] = NULL;
@@ -473,6 +876,8 @@ schedtune_css_free(struct cgroup_subsys_state *css)
 
 struct cgroup_subsys schedtune_cgrp_subsys = {
 	.css_alloc	= schedtune_css_alloc,
+	.css_online	= schedtune_css_online,
+	.css_offline	= schedtune_css_offline,
 	.css_free	= schedtune_css_free,
 	.legacy_cftypes	= files,
 	.early_init	= 1,
@@ -481,8 +886,6 @@ struct cgroup_subsys schedtune_cgrp_subsys = {
 #endif /* CONFIG_CGROUP_SCHEDTUNE */
 
 #ifdef CONFIG_FREQVAR_SCHEDTUNE
-static struct freqvar_boost_state freqvar_boost_state[CONFIG_NR_CPUS];
-
 int schedtune_freqvar_boost(int cpu)
 {
 	if (!freqvar_boost_state[cpu].enabled)
@@ -517,12 +920,26 @@ static int schedtune_freqvar_cpufreq_callback(struct notifier_block *nb,
 	if (val != CPUFREQ_POSTCHANGE)
 		return NOTIFY_OK;
 
+	WRITE_ONCE(freqvar_boost_state[freq->cpu].cur_freq, freq->new);
 	if (freqvar_boost_state[freq->cpu].enabled)
 		schedtune_freqvar_update_boost_ratio(freq->cpu, freq->new);
 
 	return 0;
 }
 
+/* fast switching drivers do not send transition notifications */
+void schedtune_freqvar_fast_switch(struct cpufreq_policy *policy,
+					unsigned int new_freq)
+{
+	int cpu;
+
+	for_each_cpu(cpu, policy->cpus) {
+		WRITE_ONCE(freqvar_boost_state[cpu].cur_freq, new_freq);
+		if (freqvar_boost_state[cpu].enabled)
+			schedtune_freqvar_update_boost_ratio(cpu, new_freq);
+	}
+}
+
 static int schedtune_freqvar_find_node(struct device_node **dn,
 					struct cpufreq_policy *policy)
 {
@@ -12,6 +12,7 @@ struct freqvar_boost_state {
 	struct freqvar_boost_table *table;
 	bool enabled;	/* boost enabled */
 	int ratio;	/* current boost ratio */
+	int cur_freq;	/* current frequency, for boost group tables */
 };
 
 struct freqvar_boost_table {
@@ -28,8 +29,12 @@ int schedtune_freqvar_boost_init(struct cpufreq_policy *policy, struct freqvar_b
 int schedtune_freqvar_boost_exit(struct cpufreq_policy *policy, struct freqvar_boost_data *data);
 int schedtune_freqvar_update_table(unsigned int *src, int src_size,
 					struct freqvar_boost_table *dst);
+void schedtune_freqvar_fast_switch(struct cpufreq_policy *policy,
+					unsigned int new_freq);
 #else
 static inline int schedtune_freqvar_boost(int cpu) { return 0; }
+static inline void schedtune_freqvar_fast_switch(struct cpufreq_policy *policy,
+						unsigned int new_freq) { }
 static inline int schedtune_freqvar_boost_init(struct cpufreq_policy *policy,
 						struct freqvar_boost_data *data) { return 0; };
 static inline int schedtune_freqvar_boost_exit(struct cpufreq_policy *policy,
@@ -53,6 +58,10 @@ int schedtune_cpu_boost(int cpu);
 int schedtune_task_boost(struct task_struct *tsk);
 
 int schedtune_prefer_idle(struct task_struct *tsk);
+unsigned int schedtune_task_uclamp(struct task_struct *tsk, int clamp_id);
+
+unsigned long schedtune_cpu_colocate_util(int cpu);
+bool schedtune_colocate_demand(struct task_struct *tsk, unsigned long *demand);
 
 void schedtune_exit_task(struct task_struct *tsk);
 
@@ -63,6 +72,10 @@ void schedtune_dequeue_task(struct task_struct *p, int cpu);
 
 #define schedtune_cpu_boost(cpu)  get_sysctl_sched_cfs_boost()
 #define schedtune_task_boost(tsk) get_sysctl_sched_cfs_boost()
+#define schedtune_task_uclamp(tsk, clamp_id) uclamp_none(clamp_id)
+
+#define schedtune_cpu_colocate_util(cpu) 0UL
+#define schedtune_colocate_demand(tsk, demand) false
 
 #define schedtune_exit_task(task) do { } while (0)
 
@@ -79,6 +92,10 @@ int schedtune_accept_deltas(int nrg_delta, int cap_delta,
 
 #define schedtune_cpu_boost(cpu)  0
 #define schedtune_task_boost(tsk) 0
+#define schedtune_task_uclamp(tsk, clamp_id) uclamp_none(clamp_id)
+
+#define schedtune_cpu_colocate_util(cpu) 0UL
+#define schedtune_colocate_demand(tsk, demand) false
 
 #define schedtune_exit_task(task) do { } while (0)
 
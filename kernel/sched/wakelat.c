@@ -0,0 +1,155 @@
+
+#include <linux/slab.h>
+#include <linux/fs.h>
+#include <linux/seq_file.h>
+#include <linux/proc_fs.h>
+#include <linux/topology.h>
+
+#include "sched.h"
+
+/*
+ * Wakeup to run latency, per CPU and task class, in log2 buckets of
+ * microseconds: bucket 0 is < 1us, bucket n is [2^(n-1), 2^n) us and the
+ * last one holds everything longer. Reading /proc/sched_wakelat returns
+ * the counts since the previous read.
+ */
+#define WAKELAT_VERSION		1
+
+enum {
+	WAKELAT_RT,
+	WAKELAT_TOP_APP,
+	WAKELAT_BACKGROUND,
+	NR_WAKELAT_CLASSES,
+};
+
+static const char * const wakelat_class_names[] = {
+	[WAKELAT_RT]		= "rt",
+	[WAKELAT_TOP_APP]	= "top-app",
+	[WAKELAT_BACKGROUND]	= "background",
+};
+
+struct wakelat_hist {
+	atomic_long_t buckets[NR_WAKELAT_CLASSES][WAKELAT_BUCKETS];
+};
+
+static DEFINE_PER_CPU(struct wakelat_hist, wakelat_hist);
+
+void wakelat_record(struct rq *rq, struct task_struct *p)
+{
+	s64 delta = rq_clock(rq) - p->wakelat_ts;
+	int class, bucket;
+
+	p->wakelat_ts = 0;
+
+	if (rt_prio(p->prio) || dl_prio(p->prio))
+		class = WAKELAT_RT;
+	else if (schedtune_task_top_app(p))
+		class = WAKELAT_TOP_APP;
+	else
+		class = WAKELAT_BACKGROUND;
+
+	bucket = delta > 0 ? fls64(div_u64(delta, NSEC_PER_USEC)) : 0;
+	if (bucket >= WAKELAT_BUCKETS)
+		bucket = WAKELAT_BUCKETS - 1;
+
+	atomic_long_inc(&this_cpu_ptr(&wakelat_hist)->buckets[class][bucket]);
+}
+
+/* counts taken from every CPU when the file is opened */
+struct wakelat_snap {
+	unsigned long buckets[NR_WAKELAT_CLASSES][WAKELAT_BUCKETS];
+};
+
+static void wakelat_show_row(struct seq_file *m, const char *unit, int id,
+			     int class, unsigned long *buckets)
+{
+	int i;
+
+	seq_printf(m, "%s%d %s", unit, id, wakelat_class_names[class]);
+	for (i = 0; i < WAKELAT_BUCKETS; i++)
+		seq_printf(m, " %lu", buckets[i]);
+	seq_putc(m, '\n');
+}
+
+static int wakelat_show(struct seq_file *m, void *v)
+{
+	struct wakelat_snap *snap = m->private;
+	struct wakelat_snap cluster;
+	int cpu, c, i, id, max_id = -1;
+
+	seq_printf(m, "version %d\n", WAKELAT_VERSION);
+	seq_puts(m, "bucket_us <1");
+	for (i = 1; i < WAKELAT_BUCKETS - 1; i++)
+		seq_printf(m, " <%lu", 1UL << i);
+	seq_printf(m, " >=%lu\n", 1UL << (WAKELAT_BUCKETS - 2));
+
+	for_each_possible_cpu(cpu) {
+		for (c = 0; c < NR_WAKELAT_CLASSES; c++)
+			wakelat_show_row(m, "cpu", cpu, c,
+					 snap[cpu].buckets[c]);
+		max_id = max(max_id, topology_physical_package_id(cpu));
+	}
+
+	for (id = 0; id <= max_id; id++) {
+		memset(&cluster, 0, sizeof(cluster));
+		for_each_possible_cpu(cpu) {
+			if (topology_physical_package_id(cpu) != id)
+				continue;
+			for (c = 0; c < NR_WAKELAT_CLASSES; c++)
+				for (i = 0; i < WAKELAT_BUCKETS; i++)
+					cluster.buckets[c][i] +=
+						snap[cpu].buckets[c][i];
+		}
+		for (c = 0; c < NR_WAKELAT_CLASSES; c++)
+			wakelat_show_row(m, "cluster", id, c,
+					 cluster.buckets[c]);
+	}
+	return 0;
+}
+
+static int wakelat_open(struct inode *inode, struct file *file)
+{
+	struct wakelat_snap *snap;
+	struct wakelat_hist *hist;
+	int cpu, c, i, ret;
+
+	snap = kcalloc(nr_cpu_ids, sizeof(*snap), GFP_KERNEL);
+	if (!snap)
+		return -ENOMEM;
+
+	/* each count is read and cleared in one step, none is lost */
+	for_each_possible_cpu(cpu) {
+		hist = per_cpu_ptr(&wakelat_hist, cpu);
+		for (c = 0; c < NR_WAKELAT_CLASSES; c++)
+			for (i = 0; i < WAKELAT_BUCKETS; i++)
+				snap[cpu].buckets[c][i] =
+					atomic_long_xchg(&hist->buckets[c][i], 0);
+	}
+
+	ret = single_open(file, wakelat_show, snap);
+	if (ret)
+		kfree(snap);
+	return ret;
+}
+
+static int wakelat_release(struct inode *inode, struct file *file)
+{
+	struct seq_file *m = file->private_data;
+
+	kfree(m->private);
+	return single_release(inode, file);
+}
+
+static const struct file_operations proc_wakelat_operations = {
+	.open    = wakelat_open,
+	.read    = seq_read,
+	.llseek  = seq_lseek,
+	.release = wakelat_release,
+};
+
+static int __init proc_wakelat_init(void)
+{
+	proc_create("sched_wakelat", 0400, NULL, &proc_wakelat_operations);
+	return 0;
+}
+subsys_initcall(proc_wakelat_init);
@@ -57,8 +57,41 @@ static unsigned int sync_cpu;
 static ktime_t ktime_last;
 static bool walt_ktime_suspended;
 
+/*
+ * Predictive demand
+ *
+ * The demand taken from sum_history lags a change in behaviour by at least
+ * one window. With walt_pred_demand set on the command line each task also
+ * keeps busy_buckets, a histogram of how busy its recent windows were in
+ * tenths of a window, where every window decays all buckets by a quarter.
+ * The forecast for the next window is the middle of the busiest bucket that
+ * recurs at least half as often as the most common one, and the task is
+ * accounted with the larger of the forecast and its regular demand. A task
+ * that is periodically busier, like a frame workload whose period does not
+ * divide the window, then asks for its peak at the start of the window and
+ * not one window after it.
+ *
+ * This is a boot time switch because a task must leave the runqueue with
+ * the same load it was enqueued with.
+ */
+static __read_mostly bool walt_pred_demand;
+
+#define BUSY_BUCKET_INC		64
+
+static DEFINE_PER_CPU(struct walt_pred_stats, walt_pred_stats);
+
+static int __init set_walt_pred_demand(char *str)
+{
+	return strtobool(str, &walt_pred_demand);
+}
+
+early_param("walt_pred_demand", set_walt_pred_demand);
+
 static unsigned int task_load(struct task_struct *p)
 {
+	if (walt_pred_demand)
+		return max(p->ravg.demand, p->ravg.pred_demand);
+
 	return p->ravg.demand;
 }
 
@@ -73,7 +106,7 @@ void
 walt_inc_cumulative_runnable_avg(struct rq *rq,
 				 struct task_struct *p)
 {
-	rq->cumulative_runnable_avg += p->ravg.demand;
+	rq->cumulative_runnable_avg += task_load(p);
 
 	/*
 	 * Add a task's contribution to the cumulative window demand when
@@ -83,14 +116,14 @@ walt_inc_cumulative_runnable_avg(struct rq *rq,
 	 * (2) task is waking for the first time in this window.
 	 */
 	if (p->on_rq || (p->last_sleep_ts < rq->window_start))
-		fixup_cum_window_demand(rq, p->ravg.demand);
+		fixup_cum_window_demand(rq, task_load(p));
 }
 
 void
 walt_dec_cumulative_runnable_avg(struct rq *rq,
 				 struct task_struct *p)
 {
-	rq->cumulative_runnable_avg -= p->ravg.demand;
+	rq->cumulative_runnable_avg -= task_load(p);
 	BUG_ON((s64)rq->cumulative_runnable_avg < 0);
 
 	/*
@@ -99,7 +132,7 @@ walt_dec_cumulative_runnable_avg(struct rq *rq,
 	 * prio/cgroup/class.
 	 */
 	if (task_on_rq_migrating(p) || p->state == TASK_RUNNING)
-		fixup_cum_window_demand(rq, -(s64)p->ravg.demand);
+		fixup_cum_window_demand(rq, -(s64)task_load(p));
 }
 
 static void
@@ -554,6 +587,70 @@ static int account_busy_for_task_demand(struct task_struct *p, int event)
 	return 1;
 }
 
+static inline int busy_to_bucket(u32 busy)
+{
+	u64 idx = div64_u64((u64)busy * NUM_BUSY_BUCKETS, walt_ravg_window);
+
+	return min_t(u64, idx, NUM_BUSY_BUCKETS - 1);
+}
+
+static void update_busy_buckets(struct task_struct *p, u32 runtime)
+{
+	u8 *bb = p->ravg.busy_buckets;
+	int i, idx = busy_to_bucket(runtime);
+
+	for (i = 0; i < NUM_BUSY_BUCKETS; i++)
+		bb[i] = bb[i] > 3 ? bb[i] - (bb[i] >> 2) : 0;
+
+	bb[idx] = min_t(unsigned int, bb[idx] + BUSY_BUCKET_INC, U8_MAX);
+}
+
+static u32 predict_busy(struct task_struct *p)
+{
+	u8 *bb = p->ravg.busy_buckets;
+	unsigned int top = 0;
+	int i;
+
+	for (i = 0; i < NUM_BUSY_BUCKETS; i++)
+		top = max_t(unsigned int, top, bb[i]);
+
+	if (!top)
+		return 0;
+
+	for (i = NUM_BUSY_BUCKETS - 1; bb[i] * 2 < top; i--)
+		;
+
+	return div64_u64((u64)(2 * i + 1) * walt_ravg_window,
+			 2 * NUM_BUSY_BUCKETS);
+}
+
+/* Score the forecast made for the window that just ended */
+static void account_pred_demand(struct rq *rq, struct task_struct *p,
+				u32 runtime)
+{
+	struct walt_pred_stats *stats = &per_cpu(walt_pred_stats, cpu_of(rq));
+	u32 pred = p->ravg.pred_demand;
+
+	if (!pred)
+		return;
+
+	stats->windows++;
+	if (busy_to_bucket(pred) == busy_to_bucket(runtime))
+		stats->hits++;
+	else if (pred < runtime)
+		stats->under++;
+	stats->err_sum += pred > runtime ? pred - runtime : runtime - pred;
+}
+
+bool walt_get_pred_stats(int cpu, struct walt_pred_stats *stats)
+{
+	if (!walt_pred_demand)
+		return false;
+
+	*stats = per_cpu(walt_pred_stats, cpu);
+	return true;
+}
+
 /*
  * Called when new window is starting for a task, to record cpu usage over
  * recently concluded window(s). Normally 'samples' should be 1. It can be > 1
@@ -565,7 +662,7 @@ static void update_history(struct rq *rq, struct task_struct *p,
 {
 	u32 *hist = &p->ravg.sum_history[0];
 	int ridx, widx;
-	u32 max = 0, avg, demand;
+	u32 max = 0, avg, demand, pred_demand = 0, load;
 	u64 sum = 0;
 
 	/* Ignore windows where task had no activity */
@@ -603,6 +700,15 @@ static void update_history(struct rq *rq, struct task_struct *p,
 			demand = max(avg, runtime);
 	}
 
+	if (walt_pred_demand) {
+		account_pred_demand(rq, p, runtime);
+		update_busy_buckets(p, runtime);
+		pred_demand = predict_busy(p);
+		load = max(demand, pred_demand);
+	} else {
+		load = demand;
+	}
+
 	/*
 	 * A throttled deadline sched class task gets dequeued without
 	 * changing p->on_rq. Since the dequeue decrements hmp stats
@@ -617,12 +723,13 @@ static void update_history(struct rq *rq, struct task_struct *p,
 	 */
 	if (!task_has_dl_policy(p) || !p->dl.dl_throttled) {
 		if (task_on_rq_queued(p))
-			fixup_cumulative_runnable_avg(rq, p, demand);
+			fixup_cumulative_runnable_avg(rq, p, load);
 		else if (rq->curr == p)
-			fixup_cum_window_demand(rq, demand);
+			fixup_cum_window_demand(rq, load);
 	}
 
 	p->ravg.demand = demand;
+	p->ravg.pred_demand = pred_demand;
 
 done:
 	trace_walt_update_history(rq, p, runtime, samples, event);
@@ -848,8 +955,8 @@ void walt_fixup_busy_time(struct task_struct *p, int new_cpu)
 	 */
 	if (p->state == TASK_WAKING &&
 	    p->last_sleep_ts >= src_rq->window_start) {
-		fixup_cum_window_demand(src_rq, -(s64)p->ravg.demand);
-		fixup_cum_window_demand(dest_rq, p->ravg.demand);
+		fixup_cum_window_demand(src_rq, -(s64)task_load(p));
+		fixup_cum_window_demand(dest_rq, task_load(p));
 	}
 
 	if (p->ravg.curr_window) {
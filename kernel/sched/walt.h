@@ -16,6 +16,14 @@
 
 #ifdef CONFIG_SCHED_WALT
 
+/* How the busy time forecast of finished windows compared with the outcome */
+struct walt_pred_stats {
+	u64 windows;		/* windows that had a forecast */
+	u64 hits;		/* forecast in the same bucket as the outcome */
+	u64 under;		/* outcome in a higher bucket */
+	u64 err_sum;		/* sum of |forecast - outcome|, in ns */
+};
+
 void walt_update_task_ravg(struct task_struct *p, struct rq *rq, int event,
 		u64 wallclock, u64 irqtime);
 void walt_inc_cumulative_runnable_avg(struct rq *rq, struct task_struct *p);
@@ -36,6 +44,9 @@ void walt_account_irqtime(int cpu, struct task_struct *curr, u64 delta,
 
 u64 walt_irqload(int cpu);
 int walt_cpu_high_irqload(int cpu);
+bool walt_get_pred_stats(int cpu, struct walt_pred_stats *stats);
+
+extern unsigned int walt_ravg_window;
 
 #else /* CONFIG_SCHED_WALT */
 
@@ -1416,6 +1416,25 @@ static struct ctl_table vm_table[] = {
 		.mode           = 0444 /* read-only */,
 		.proc_handler   = pdflush_proc_obsolete,
 	},
+#ifdef CONFIG_RECLAIM_COST_MODEL
+	{
+		.procname	= "reclaim_cost_model",
+		.data		= &vm_reclaim_cost_model,
+		.maxlen		= sizeof(vm_reclaim_cost_model),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+		.extra2		= &one,
+	},
+	{
+		.procname	= "refault_cost_us",
+		.data		= &vm_refault_cost_us,
+		.maxlen		= sizeof(vm_refault_cost_us),
+		.mode		= 0644,
+		.proc_handler	= proc_dointvec_minmax,
+		.extra1		= &zero,
+	},
+#endif
 	{
 		.procname	= "swappiness",
 		.data		= &vm_swappiness,
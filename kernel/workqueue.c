@@ -50,6 +50,7 @@
 #include <linux/uaccess.h>
 #include <linux/locallock.h>
 #include <linux/delay.h>
+#include <linux/topology.h>
 #include <linux/exynos-ss.h>
 
 #include "workqueue_internal.h"
@@ -183,6 +184,9 @@ struct worker_pool {
 	struct hlist_node	hash_node;	/* PL: unbound_pool_hash node */
 	int			refcnt;		/* PL: refcnt for unbound pools */
 
+	/* time spent running work items, unbound pools only */
+	u64			cluster_busy_ns[2]; /* L: little, big */
+
 	/*
 	 * The current concurrency level.  As it's likely to be accessed
 	 * from other CPUs during try_to_wake_up(), put it in a separate
@@ -262,6 +266,7 @@ struct workqueue_struct {
 
 	struct workqueue_attrs	*unbound_attrs;	/* PW: only for unbound wqs */
 	struct pool_workqueue	*dfl_pwq;	/* PW: only for unbound wqs */
+	enum wq_cluster		cluster;	/* PW: only for unbound wqs */
 
 #ifdef CONFIG_SYSFS
 	struct wq_device	*wq_dev;	/* I: for sysfs interface */
@@ -2055,6 +2060,12 @@ static bool manage_workers(struct worker *worker)
  * CONTEXT:
  * spin_lock_irq(pool->lock) which is released and regrabbed.
  */
+/* little is the boot CPU's cluster, big every other CPU */
+static bool wq_cpu_is_big(int cpu)
+{
+	return !cpumask_test_cpu(cpu, topology_core_cpumask(0));
+}
+
 static void process_one_work(struct worker *worker, struct work_struct *work)
 __releases(&pool->lock)
 __acquires(&pool->lock)
@@ -2064,6 +2075,7 @@ __acquires(&pool->lock)
 	bool cpu_intensive = pwq->wq->flags & WQ_CPU_INTENSIVE;
 	int work_color;
 	struct worker *collision;
+	u64 start = 0;
 #ifdef CONFIG_LOCKDEP
 	/*
 	 * It is permissible to free the struct work_struct from
@@ -2134,6 +2146,8 @@ __acquires(&pool->lock)
 	lock_map_acquire_read(&pwq->wq->lockdep_map);
 	lock_map_acquire(&lockdep_map);
 	trace_workqueue_execute_start(work);
+	if (pool->cpu < 0)
+		start = local_clock();
 	exynos_ss_work(worker, worker->task, worker->current_func, ESS_FLAG_IN);
 	worker->current_func(work);
 	exynos_ss_work(worker, worker->task, worker->current_func, ESS_FLAG_OUT);
@@ -2166,6 +2180,10 @@ __acquires(&pool->lock)
 
 	spin_lock_irq(&pool->lock);
 
+	if (start)
+		pool->cluster_busy_ns[wq_cpu_is_big(smp_processor_id())] +=
+			local_clock() - start;
+
 	/* clear cpu intensive status */
 	if (unlikely(cpu_intensive))
 		worker_clr_flags(worker, WORKER_CPU_INTENSIVE);
@@ -3786,6 +3804,77 @@ int apply_workqueue_attrs(struct workqueue_struct *wq,
 	return ret;
 }
 
+static int wq_cluster_cpumask(struct workqueue_struct *wq,
+			      enum wq_cluster cluster, struct cpumask *mask)
+{
+	if (cluster == WQ_CLUSTER_AUTO)
+		cluster = (wq->flags & WQ_HIGHPRI) ? WQ_CLUSTER_BIG :
+						     WQ_CLUSTER_LITTLE;
+
+	switch (cluster) {
+	case WQ_CLUSTER_LITTLE:
+		cpumask_and(mask, cpu_possible_mask, topology_core_cpumask(0));
+		break;
+	case WQ_CLUSTER_BIG:
+		cpumask_andnot(mask, cpu_possible_mask,
+			       topology_core_cpumask(0));
+		break;
+	default:
+		cpumask_copy(mask, cpu_possible_mask);
+		break;
+	}
+
+	return cpumask_empty(mask) ? -ENODEV : 0;
+}
+
+static int workqueue_set_cluster_locked(struct workqueue_struct *wq,
+					enum wq_cluster cluster)
+{
+	struct workqueue_attrs *attrs;
+	int ret;
+
+	lockdep_assert_held(&wq_pool_mutex);
+
+	attrs = alloc_workqueue_attrs(GFP_KERNEL);
+	if (!attrs)
+		return -ENOMEM;
+
+	copy_workqueue_attrs(attrs, wq->unbound_attrs);
+	ret = wq_cluster_cpumask(wq, cluster, attrs->cpumask);
+	if (!ret)
+		ret = apply_workqueue_attrs_locked(wq, attrs);
+	if (!ret)
+		wq->cluster = cluster;
+
+	free_workqueue_attrs(attrs);
+	return ret;
+}
+
+/**
+ * workqueue_set_cluster - keep an unbound workqueue on one CPU cluster
+ * @wq: the target workqueue
+ * @cluster: the cluster, see enum wq_cluster
+ *
+ * Replaces the cpumask of @wq so that background work does not wake the
+ * big cores and latency critical work does not wait on the little ones.
+ * %WQ_CLUSTER_AUTO picks the cluster from %WQ_HIGHPRI.
+ *
+ * Return: 0 on success, -ENODEV if the cluster has no CPUs and -errno
+ * on other failures.
+ */
+int workqueue_set_cluster(struct workqueue_struct *wq,
+			  enum wq_cluster cluster)
+{
+	int ret;
+
+	apply_wqattrs_lock();
+	ret = workqueue_set_cluster_locked(wq, cluster);
+	apply_wqattrs_unlock();
+
+	return ret;
+}
+EXPORT_SYMBOL_GPL(workqueue_set_cluster);
+
 /**
  * wq_update_unbound_numa - update NUMA affinity of a wq for CPU hot[un]plug
  * @wq: the target workqueue
@@ -5163,6 +5252,8 @@ static ssize_t wq_cpumask_store(struct device *dev,
 	ret = cpumask_parse(buf, attrs->cpumask);
 	if (!ret)
 		ret = apply_workqueue_attrs_locked(wq, attrs);
+	if (!ret)
+		wq->cluster = WQ_CLUSTER_ALL;
 
 out_unlock:
 	apply_wqattrs_unlock();
@@ -5209,11 +5300,77 @@ out_unlock:
 	return ret ?: count;
 }
 
+static const char * const wq_cluster_names[] = {
+	[WQ_CLUSTER_ALL]	= "all",
+	[WQ_CLUSTER_LITTLE]	= "little",
+	[WQ_CLUSTER_BIG]	= "big",
+	[WQ_CLUSTER_AUTO]	= "auto",
+};
+
+static ssize_t wq_cluster_show(struct device *dev,
+			       struct device_attribute *attr, char *buf)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	int written;
+
+	mutex_lock(&wq->mutex);
+	written = scnprintf(buf, PAGE_SIZE, "%s\n",
+			    wq_cluster_names[wq->cluster]);
+	mutex_unlock(&wq->mutex);
+
+	return written;
+}
+
+static ssize_t wq_cluster_store(struct device *dev,
+				struct device_attribute *attr,
+				const char *buf, size_t count)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	int i, ret = -EINVAL;
+
+	for (i = 0; i < ARRAY_SIZE(wq_cluster_names); i++) {
+		if (sysfs_streq(buf, wq_cluster_names[i])) {
+			ret = workqueue_set_cluster(wq, i);
+			break;
+		}
+	}
+
+	return ret ?: count;
+}
+
+static ssize_t wq_cluster_busy_show(struct device *dev,
+				    struct device_attribute *attr, char *buf)
+{
+	struct workqueue_struct *wq = dev_to_wq(dev);
+	struct worker_pool *pool;
+	const char *delim = "";
+	int node, written = 0;
+
+	get_online_cpus();
+	rcu_read_lock();
+	for_each_node(node) {
+		pool = unbound_pwq_by_node(wq, node)->pool;
+		written += scnprintf(buf + written, PAGE_SIZE - written,
+				     "%s%d:%d little_ms=%llu big_ms=%llu",
+				     delim, node, pool->id,
+				     div_u64(pool->cluster_busy_ns[0], NSEC_PER_MSEC),
+				     div_u64(pool->cluster_busy_ns[1], NSEC_PER_MSEC));
+		delim = " ";
+	}
+	written += scnprintf(buf + written, PAGE_SIZE - written, "\n");
+	rcu_read_unlock();
+	put_online_cpus();
+
+	return written;
+}
+
 static struct device_attribute wq_sysfs_unbound_attrs[] = {
 	__ATTR(pool_ids, 0444, wq_pool_ids_show, NULL),
 	__ATTR(nice, 0644, wq_nice_show, wq_nice_store),
 	__ATTR(cpumask, 0644, wq_cpumask_show, wq_cpumask_store),
 	__ATTR(numa, 0644, wq_numa_show, wq_numa_store),
+	__ATTR(cluster, 0644, wq_cluster_show, wq_cluster_store),
+	__ATTR(cluster_busy, 0444, wq_cluster_busy_show, NULL),
 	__ATTR_NULL,
 };
 
@@ -0,0 +1,640 @@
+/*
+ * Microbenchmarks for Exynos hot paths
+ *
+ * Reading /sys/kernel/debug/exynos_bench runs every enabled benchmark in
+ * the context of the reader and prints one line per result:
+ *
+ *   <bench> <arg> iters=<n> min_ns=<ns> avg_ns=<ns> max_ns=<ns> mb_s=<MB/s> status=<err>
+ *
+ * mb_s is 0 for benchmarks that move no data. A benchmark that cannot run
+ * prints iters=0 and a negative status. The first line carries the format
+ * version and is only bumped when a field changes meaning. On arm64 the
+ * copies are repeated as copy.*.generic with the per-CPU copy loop
+ * selection turned off. Pin the reader with taskset to compare clusters.
+ *
+ * This software is licensed under the terms of the GNU General Public
+ * License version 2, as published by the Free Software Foundation, and
+ * may be copied, distributed, and modified under those terms.
+ */
+
+#define pr_fmt(fmt) KBUILD_MODNAME ": " fmt
+
+#include <linux/crypto.h>
+#include <linux/debugfs.h>
+#include <linux/device.h>
+#include <linux/highmem.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/mman.h>
+#include <linux/module.h>
+#include <linux/platform_device.h>
+#include <linux/pm_qos.h>
+#include <linux/random.h>
+#include <linux/sched.h>
+#include <linux/scatterlist.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#ifdef CONFIG_ION_EXYNOS
+#include <linux/ion.h>
+#include <linux/exynos_ion.h>
+#endif
+#ifdef CONFIG_EXYNOS_IOVMM
+#include <linux/iommu.h>
+#include <linux/exynos_iovmm.h>
+#endif
+#ifdef CONFIG_EXYNOS_ACPM
+#include <soc/samsung/acpm_mfd.h>
+#endif
+#ifdef CONFIG_ARM64
+#include <asm/copy_profile.h>
+#endif
+
+#define BENCH_FORMAT_VERSION	1
+#define BENCH_COPY_MAX		SZ_1M
+#define BENCH_ZERO_MAX		SZ_4M
+
+static unsigned int iters = 1000;
+module_param(iters, uint, 0644);
+MODULE_PARM_DESC(iters, "Iterations per benchmark (default: 1000)");
+
+/* comma separated list of benchmark groups, all when empty */
+static char *filter = "";
+module_param(filter, charp, 0644);
+MODULE_PARM_DESC(filter, "Benchmark groups to run: zcomp,ion,iovmm,binder,pm_qos,acpm,copy,zero");
+
+static char *zcomp_algs = "lzo,lz4,lz4hc,deflate";
+module_param(zcomp_algs, charp, 0644);
+MODULE_PARM_DESC(zcomp_algs, "Compression algorithms timed as zram would use them");
+
+struct bench_stat {
+	u64 min;
+	u64 max;
+	u64 total;
+	u64 bytes;
+	unsigned int n;
+};
+
+static void bench_init(struct bench_stat *st)
+{
+	memset(st, 0, sizeof(*st));
+	st->min = U64_MAX;
+}
+
+static void bench_add(struct bench_stat *st, u64 start, size_t bytes)
+{
+	u64 ns = ktime_get_ns() - start;
+
+	if (ns < st->min)
+		st->min = ns;
+	if (ns > st->max)
+		st->max = ns;
+	st->total += ns;
+	st->bytes += bytes;
+	st->n++;
+}
+
+static void bench_report(struct seq_file *m, const char *name,
+			 const char *arg, struct bench_stat *st, int err)
+{
+	u64 mb_s = 0;
+
+	if (!st || !st->n) {
+		seq_printf(m, "%s %s iters=0 min_ns=0 avg_ns=0 max_ns=0 mb_s=0 status=%d\n",
+			   name, arg, err ? err : -ENODATA);
+		return;
+	}
+
+	/* bytes per ns to MB/s */
+	if (st->bytes && st->total)
+		mb_s = div64_u64(st->bytes * 1000, st->total);
+
+	seq_printf(m, "%s %s iters=%u min_ns=%llu avg_ns=%llu max_ns=%llu mb_s=%llu status=%d\n",
+		   name, arg, st->n, st->min, div_u64(st->total, st->n),
+		   st->max, mb_s, err);
+}
+
+static bool bench_enabled(const char *group)
+{
+	size_t len = strlen(group);
+	const char *p = filter;
+
+	if (!p || !*p)
+		return true;
+
+	while ((p = strstr(p, group))) {
+		if ((p == filter || p[-1] == ',') &&
+		    (p[len] == '\0' || p[len] == ',' || p[len] == '\n'))
+			return true;
+		p += len;
+	}
+	return false;
+}
+
+/* Half random, half repeated text: compresses roughly like anon pages */
+static void bench_fill_page(u8 *page)
+{
+	static const char text[] = "exynos_bench zram page ";
+	int i;
+
+	get_random_bytes(page, PAGE_SIZE / 2);
+	for (i = PAGE_SIZE / 2; i < PAGE_SIZE; i++)
+		page[i] = text[i % (sizeof(text) - 1)];
+}
+
+static void bench_zcomp_one(struct seq_file *m, const char *alg, u8 *src,
+			    u8 *dst, u8 *out)
+{
+	struct bench_stat comp, decomp;
+	struct crypto_comp *tfm;
+	unsigned int dlen = 0, olen;
+	unsigned int i;
+	u64 start;
+	int err = 0;
+
+	bench_init(&comp);
+	bench_init(&decomp);
+
+	tfm = crypto_alloc_comp(alg, 0, 0);
+	if (IS_ERR(tfm)) {
+		bench_report(m, "zcomp.compress", alg, NULL, PTR_ERR(tfm));
+		bench_report(m, "zcomp.decompress", alg, NULL, PTR_ERR(tfm));
+		return;
+	}
+
+	for (i = 0; i < iters && !err; i++) {
+		dlen = PAGE_SIZE * 2;
+		start = ktime_get_ns();
+		err = crypto_comp_compress(tfm, src, PAGE_SIZE, dst, &dlen);
+		bench_add(&comp, start, PAGE_SIZE);
+	}
+	bench_report(m, "zcomp.compress", alg, &comp, err);
+
+	for (i = 0; i < iters && !err; i++) {
+		olen = PAGE_SIZE;
+		start = ktime_get_ns();
+		err = crypto_comp_decompress(tfm, dst, dlen, out, &olen);
+		bench_add(&decomp, start, PAGE_SIZE);
+	}
+	if (!err && memcmp(src, out, PAGE_SIZE))
+		err = -EILSEQ;
+	bench_report(m, "zcomp.decompress", alg, &decomp, err);
+
+	crypto_free_comp(tfm);
+}
+
+static void bench_zcomp(struct seq_file *m)
+{
+	char *algs, *p, *alg;
+	u8 *src, *dst, *out;
+
+	algs = kstrdup(zcomp_algs, GFP_KERNEL);
+	src = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	dst = kmalloc(PAGE_SIZE * 2, GFP_KERNEL);
+	out = kmalloc(PAGE_SIZE, GFP_KERNEL);
+	if (!algs || !src || !dst || !out) {
+		bench_report(m, "zcomp.compress", "-", NULL, -ENOMEM);
+		goto out;
+	}
+
+	bench_fill_page(src);
+	p = algs;
+	while ((alg = strsep(&p, ",")) != NULL) {
+		if (*alg)
+			bench_zcomp_one(m, strim(alg), src, dst, out);
+	}
+out:
+	kfree(out);
+	kfree(dst);
+	kfree(src);
+	kfree(algs);
+}
+
+#ifdef CONFIG_ION_EXYNOS
+/* the system heap and, when HPA is built, the video frame HPA heap */
+#ifdef CONFIG_HPA
+static unsigned int ion_heap_mask = EXYNOS_ION_HEAP_SYSTEM_MASK |
+				    EXYNOS_ION_HEAP_VIDEO_FRAME_MASK;
+#else
+static unsigned int ion_heap_mask = EXYNOS_ION_HEAP_SYSTEM_MASK;
+#endif
+module_param(ion_heap_mask, uint, 0644);
+MODULE_PARM_DESC(ion_heap_mask, "ION heap ids timed one at a time");
+
+static unsigned int ion_size = SZ_1M;
+module_param(ion_size, uint, 0644);
+MODULE_PARM_DESC(ion_size, "ION allocation size in bytes");
+
+static void bench_ion(struct seq_file *m)
+{
+	struct ion_client *client;
+	struct bench_stat alloc, release;
+	struct ion_handle *handle;
+	char arg[16];
+	unsigned int id, i;
+	u64 start;
+	int err;
+
+	client = exynos_ion_client_create("exynos_bench");
+	if (IS_ERR_OR_NULL(client)) {
+		bench_report(m, "ion.alloc", "-", NULL,
+			     client ? PTR_ERR(client) : -ENODEV);
+		return;
+	}
+
+	for (id = 0; id < 32; id++) {
+		if (!(ion_heap_mask & (1 << id)))
+			continue;
+
+		snprintf(arg, sizeof(arg), "heap%u", id);
+		bench_init(&alloc);
+		bench_init(&release);
+		err = 0;
+
+		for (i = 0; i < iters; i++) {
+			start = ktime_get_ns();
+			handle = ion_alloc(client, ion_size, 0, 1 << id, 0);
+			if (IS_ERR(handle)) {
+				err = PTR_ERR(handle);
+				break;
+			}
+			bench_add(&alloc, start, 0);
+
+			start = ktime_get_ns();
+			ion_free(client, handle);
+			bench_add(&release, start, 0);
+		}
+		bench_report(m, "ion.alloc", arg, &alloc, err);
+		bench_report(m, "ion.free", arg, &release, err);
+	}
+
+	ion_client_destroy(client);
+}
+#else
+static void bench_ion(struct seq_file *m)
+{
+	bench_report(m, "ion.alloc", "-", NULL, -ENOSYS);
+}
+#endif
+
+#ifdef CONFIG_EXYNOS_IOVMM
+static char *iovmm_dev = "";
+module_param(iovmm_dev, charp, 0644);
+MODULE_PARM_DESC(iovmm_dev, "Platform device whose System MMU is timed");
+
+static unsigned int iovmm_size = SZ_1M;
+module_param(iovmm_size, uint, 0644);
+MODULE_PARM_DESC(iovmm_size, "Size mapped by each iovmm_map in bytes");
+
+static void bench_iovmm(struct seq_file *m)
+{
+	struct bench_stat map, unmap;
+	struct sg_table sgt;
+	struct scatterlist *sg;
+	struct device *dev;
+	unsigned int nents = DIV_ROUND_UP(iovmm_size, PAGE_SIZE);
+	dma_addr_t iova;
+	unsigned int i;
+	u64 start;
+	int err = 0;
+
+	if (!*iovmm_dev) {
+		bench_report(m, "iovmm.map", "-", NULL, -ENODEV);
+		return;
+	}
+
+	dev = bus_find_device_by_name(&platform_bus_type, NULL, iovmm_dev);
+	if (!dev) {
+		bench_report(m, "iovmm.map", iovmm_dev, NULL, -ENODEV);
+		return;
+	}
+
+	if (sg_alloc_table(&sgt, nents, GFP_KERNEL)) {
+		bench_report(m, "iovmm.map", iovmm_dev, NULL, -ENOMEM);
+		goto out;
+	}
+
+	for_each_sg(sgt.sgl, sg, nents, i) {
+		struct page *page = alloc_page(GFP_KERNEL);
+
+		if (!page) {
+			bench_report(m, "iovmm.map", iovmm_dev, NULL, -ENOMEM);
+			goto free;
+		}
+		sg_set_page(sg, page, PAGE_SIZE, 0);
+	}
+
+	bench_init(&map);
+	bench_init(&unmap);
+	for (i = 0; i < iters; i++) {
+		start = ktime_get_ns();
+		iova = iovmm_map(dev, sgt.sgl, 0, nents * PAGE_SIZE,
+				 DMA_TO_DEVICE, IOMMU_READ);
+		if (IS_ERR_VALUE(iova)) {
+			err = (int)iova;
+			break;
+		}
+		bench_add(&map, start, 0);
+
+		start = ktime_get_ns();
+		iovmm_unmap(dev, iova);
+		bench_add(&unmap, start, 0);
+	}
+	bench_report(m, "iovmm.map", iovmm_dev, &map, err);
+	bench_report(m, "iovmm.unmap", iovmm_dev, &unmap, err);
+free:
+	for_each_sg(sgt.sgl, sg, nents, i)
+		if (sg_page(sg))
+			__free_page(sg_page(sg));
+	sg_free_table(&sgt);
+out:
+	put_device(dev);
+}
+#else
+static void bench_iovmm(struct seq_file *m)
+{
+	bench_report(m, "iovmm.map", "-", NULL, -ENOSYS);
+}
+#endif
+
+/*
+ * A binder round trip needs a context manager and a second process, so it
+ * cannot be driven from here. It is reported as not supported to keep the
+ * line present for the parsers; time it from userspace instead.
+ */
+static void bench_binder(struct seq_file *m)
+{
+	bench_report(m, "binder.roundtrip", "-", NULL, -EOPNOTSUPP);
+}
+
+static void bench_pm_qos(struct seq_file *m)
+{
+	struct pm_qos_request req = { };
+	struct bench_stat update;
+	unsigned int i;
+	u64 start;
+
+	/* a bound this close to the default leaves idle state selection alone */
+	pm_qos_add_request(&req, PM_QOS_CPU_DMA_LATENCY,
+			   PM_QOS_CPU_DMA_LAT_DEFAULT_VALUE);
+
+	bench_init(&update);
+	for (i = 0; i < iters; i++) {
+		start = ktime_get_ns();
+		pm_qos_update_request(&req, (i & 1) ?
+				      PM_QOS_CPU_DMA_LAT_DEFAULT_VALUE :
+				      PM_QOS_CPU_DMA_LAT_DEFAULT_VALUE - 1);
+		bench_add(&update, start, 0);
+	}
+	bench_report(m, "pm_qos.update", "cpu_dma_latency", &update, 0);
+
+	pm_qos_remove_request(&req);
+}
+
+#ifdef CONFIG_EXYNOS_ACPM
+static unsigned int acpm_pmic_type;
+module_param(acpm_pmic_type, uint, 0644);
+MODULE_PARM_DESC(acpm_pmic_type, "PMIC register block read through ACPM");
+
+static void bench_acpm(struct seq_file *m)
+{
+	struct bench_stat rt;
+	char arg[16];
+	unsigned int i;
+	u64 start;
+	u8 val;
+	int err = 0;
+
+	snprintf(arg, sizeof(arg), "pmic%u", acpm_pmic_type);
+	bench_init(&rt);
+	for (i = 0; i < iters; i++) {
+		/* register 0 is the PMIC id, reading it has no side effect */
+		start = ktime_get_ns();
+		err = exynos_acpm_read_reg(acpm_pmic_type, 0, &val);
+		if (err)
+			break;
+		bench_add(&rt, start, 0);
+	}
+	bench_report(m, "acpm.roundtrip", arg, &rt, err);
+}
+#else
+static void bench_acpm(struct seq_file *m)
+{
+	bench_report(m, "acpm.roundtrip", "-", NULL, -ENOSYS);
+}
+#endif
+
+static const size_t bench_copy_sizes[] = { 256, SZ_4K, SZ_64K, SZ_1M };
+
+/* the user buffer lives in the reader's address space */
+static void bench_copy_run(struct seq_file *m, const char *variant, u8 *src,
+			   u8 *dst, char __user *umem)
+{
+	struct bench_stat st;
+	char name[32];
+	char arg[16];
+	unsigned int i, s;
+	size_t size;
+	u64 start;
+	int err = 0;
+
+	for (s = 0; s < ARRAY_SIZE(bench_copy_sizes); s++) {
+		size = bench_copy_sizes[s];
+		snprintf(arg, sizeof(arg), "%zu", size);
+
+		snprintf(name, sizeof(name), "copy.memcpy%s", variant);
+		bench_init(&st);
+		for (i = 0; i < iters; i++) {
+			start = ktime_get_ns();
+			memcpy(dst, src, size);
+			bench_add(&st, start, size);
+		}
+		bench_report(m, name, arg, &st, 0);
+
+		snprintf(name, sizeof(name), "copy.to_user%s", variant);
+		bench_init(&st);
+		for (i = 0; i < iters && !err; i++) {
+			start = ktime_get_ns();
+			if (copy_to_user(umem, src, size))
+				err = -EFAULT;
+			bench_add(&st, start, size);
+		}
+		bench_report(m, name, arg, &st, err);
+
+		snprintf(name, sizeof(name), "copy.from_user%s", variant);
+		bench_init(&st);
+		for (i = 0; i < iters && !err; i++) {
+			start = ktime_get_ns();
+			if (copy_from_user(dst, umem, size))
+				err = -EFAULT;
+			bench_add(&st, start, size);
+		}
+		bench_report(m, name, arg, &st, err);
+	}
+}
+
+static void bench_copy(struct seq_file *m)
+{
+	unsigned long user_addr;
+	char __user *umem;
+	u8 *src, *dst;
+
+	src = vmalloc(BENCH_COPY_MAX);
+	dst = vmalloc(BENCH_COPY_MAX);
+	if (!src || !dst) {
+		bench_report(m, "copy.memcpy", "-", NULL, -ENOMEM);
+		goto out;
+	}
+	memset(src, 0x5a, BENCH_COPY_MAX);
+	memset(dst, 0, BENCH_COPY_MAX);
+
+	user_addr = vm_mmap(NULL, 0, BENCH_COPY_MAX, PROT_READ | PROT_WRITE,
+			    MAP_ANONYMOUS | MAP_PRIVATE, 0);
+	if (user_addr >= (unsigned long)(TASK_SIZE)) {
+		bench_report(m, "copy.memcpy", "-", NULL, -ENOMEM);
+		goto out;
+	}
+	umem = (char __user *)user_addr;
+
+	/* fault the pages in outside the timed loops */
+	if (copy_to_user(umem, src, BENCH_COPY_MAX)) {
+		bench_report(m, "copy.to_user", "-", NULL, -EFAULT);
+		goto unmap;
+	}
+
+	bench_copy_run(m, "", src, dst, umem);
+#ifdef CONFIG_ARM64
+	/*
+	 * The same copies through the loop every core type used before the
+	 * per-CPU selection, for comparison. Other CPUs copying meanwhile
+	 * drop to it as well.
+	 */
+	if (arm64_copy_tuned) {
+		WRITE_ONCE(arm64_copy_tuned, 0);
+		bench_copy_run(m, ".generic", src, dst, umem);
+		WRITE_ONCE(arm64_copy_tuned, 1);
+	}
+#endif
+unmap:
+	vm_munmap(user_addr, BENCH_COPY_MAX);
+out:
+	vfree(dst);
+	vfree(src);
+}
+
+static const size_t bench_zero_sizes[] = { SZ_4K, SZ_64K, SZ_1M, SZ_4M };
+
+/* clear_pages() over a range against clearing it one page at a time */
+static void bench_zero(struct seq_file *m)
+{
+	struct bench_stat st;
+	char arg[16];
+	unsigned int i, s;
+	unsigned long p, nr;
+	size_t size;
+	u8 *buf;
+	u64 start;
+
+	buf = vmalloc(BENCH_ZERO_MAX);
+	if (!buf) {
+		bench_report(m, "zero.clear_pages", "-", NULL, -ENOMEM);
+		return;
+	}
+	memset(buf, 0x5a, BENCH_ZERO_MAX);
+
+	for (s = 0; s < ARRAY_SIZE(bench_zero_sizes); s++) {
+		size = bench_zero_sizes[s];
+		nr = size >> PAGE_SHIFT;
+		snprintf(arg, sizeof(arg), "%zu", size);
+
+		bench_init(&st);
+		for (i = 0; i < iters; i++) {
+			start = ktime_get_ns();
+			clear_pages(buf, nr);
+			bench_add(&st, start, size);
+		}
+		bench_report(m, "zero.clear_pages", arg, &st, 0);
+
+		bench_init(&st);
+		for (i = 0; i < iters; i++) {
+			start = ktime_get_ns();
+			for (p = 0; p < nr; p++)
+				clear_page(buf + p * PAGE_SIZE);
+			bench_add(&st, start, size);
+		}
+		bench_report(m, "zero.clear_page", arg, &st, 0);
+		cond_resched();
+	}
+
+	vfree(buf);
+}
+
+static const struct {
+	const char *group;
+	void (*run)(struct seq_file *m);
+} benches[] = {
+	{ "zcomp",	bench_zcomp },
+	{ "ion",	bench_ion },
+	{ "iovmm",	bench_iovmm },
+	{ "binder",	bench_binder },
+	{ "pm_qos",	bench_pm_qos },
+	{ "acpm",	bench_acpm },
+	{ "copy",	bench_copy },
+	{ "zero",	bench_zero },
+};
+
+static int exynos_bench_show(struct seq_file *m, void *v)
+{
+	int i;
+
+	seq_printf(m, "# exynos_bench format=%d iters=%u cpu=%d\n",
+		   BENCH_FORMAT_VERSION, iters, raw_smp_processor_id());
+
+	for (i = 0; i < ARRAY_SIZE(benches); i++) {
+		if (!bench_enabled(benches[i].group))
+			continue;
+		benches[i].run(m);
+		cond_resched();
+	}
+	return 0;
+}
+
+static int exynos_bench_open(struct inode *inode, struct file *file)
+{
+	/*
+	 * Sized for every result at once: seq_read would run the whole set
+	 * again if the buffer had to grow.
+	 */
+	return single_open_size(file, exynos_bench_show, NULL, SZ_32K);
+}
+
+static const struct file_operations exynos_bench_fops = {
+	.open		= exynos_bench_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static struct dentry *exynos_bench_dentry;
+
+static int __init exynos_bench_init(void)
+{
+	exynos_bench_dentry = debugfs_create_file("exynos_bench", 0400, NULL,
+						  NULL, &exynos_bench_fops);
+	if (!exynos_bench_dentry)
+		return -ENOMEM;
+
+	return 0;
+}
+module_init(exynos_bench_init);
+
+static void __exit exynos_bench_exit(void)
+{
+	debugfs_remove(exynos_bench_dentry);
+}
+module_exit(exynos_bench_exit);
+
+MODULE_DESCRIPTION("Microbenchmarks for Exynos hot paths");
+MODULE_LICENSE("GPL");
@@ -221,11 +221,65 @@ static ssize_t stable_pages_required_show(struct device *dev,
 }
 static DEVICE_ATTR_RO(stable_pages_required);
 
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+static ssize_t ra_adaptive_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	bool enable;
+	ssize_t ret;
+
+	ret = strtobool(buf, &enable);
+	if (ret < 0)
+		return ret;
+
+	WRITE_ONCE(bdi->ra_adaptive, enable);
+
+	return count;
+}
+BDI_SHOW(ra_adaptive, bdi->ra_adaptive)
+
+static ssize_t ra_target_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+	unsigned int target;
+	ssize_t ret;
+
+	ret = kstrtouint(buf, 10, &target);
+	if (ret < 0)
+		return ret;
+	if (target < 10 || target > 95)
+		return -EINVAL;
+
+	WRITE_ONCE(bdi->ra_target, target);
+
+	return count;
+}
+BDI_SHOW(ra_target, bdi->ra_target)
+
+static ssize_t ra_window_kb_show(struct device *dev,
+				 struct device_attribute *attr, char *page)
+{
+	struct backing_dev_info *bdi = dev_get_drvdata(dev);
+
+	return snprintf(page, PAGE_SIZE-1, "%lu %lu\n",
+			K(READ_ONCE(bdi->ra_init_pages)),
+			K(READ_ONCE(bdi->ra_max_pages)));
+}
+static DEVICE_ATTR_RO(ra_window_kb);
+#endif
+
 static struct attribute *bdi_dev_attrs[] = {
 	&dev_attr_read_ahead_kb.attr,
 	&dev_attr_min_ratio.attr,
 	&dev_attr_max_ratio.attr,
 	&dev_attr_stable_pages_required.attr,
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+	&dev_attr_ra_adaptive.attr,
+	&dev_attr_ra_target.attr,
+	&dev_attr_ra_window_kb.attr,
+#endif
 	NULL,
 };
 ATTRIBUTE_GROUPS(bdi_dev);
@@ -790,6 +844,15 @@ int bdi_init(struct backing_dev_info *bdi)
 	bdi->last_nr_dirty = 0;
 	bdi->paused_total = 0;
 
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+	bdi->ra_adaptive = 0;
+	bdi->ra_target = 80;
+	bdi->ra_init_pages = 0;
+	bdi->ra_max_pages = 0;
+	memset(&bdi->ra_model, 0, sizeof(bdi->ra_model));
+	spin_lock_init(&bdi->ra_model.lock);
+#endif
+
 	INIT_LIST_HEAD(&bdi->bdi_list);
 	INIT_LIST_HEAD(&bdi->wb_list);
 	init_waitqueue_head(&bdi->wb_waitq);
@@ -35,6 +35,9 @@
 #include <linux/cma.h>
 #include <linux/highmem.h>
 #include <linux/io.h>
+#include <linux/ktime.h>
+#include <linux/swap.h>
+#include <linux/vmstat.h>
 #include <trace/events/cma.h>
 
 #include "cma.h"
@@ -43,6 +46,20 @@ struct cma cma_areas[MAX_CMA_AREAS];
 unsigned cma_area_count;
 static DEFINE_MUTEX(cma_mutex);
 
+/*
+ * Allocations drain their range of movable pages synchronously, which is
+ * what makes a large cma_alloc() slow. Each area may keep drain_target pages
+ * drained ahead of time instead: the drain worker takes pageblocks out of
+ * the page allocator while nothing waits on them, and cma_alloc() serves a
+ * request from those without migrating anything if they hold a fitting run.
+ * The worker refills the pool CMA_DRAIN_DELAY after it was used, a few
+ * pageblocks at a time on a deferrable timer.
+ */
+#define CMA_DRAIN_DELAY		(5 * HZ)
+#define CMA_DRAIN_BATCH		4
+
+static void cma_drain_work(struct work_struct *work);
+
 phys_addr_t cma_get_base(const struct cma *cma)
 {
 	return PFN_PHYS(cma->base_pfn);
@@ -99,11 +116,16 @@ static int __init cma_activate_area(struct cma *cma)
 	struct zone *zone;
 
 	cma->bitmap = kzalloc(bitmap_size, GFP_KERNEL);
+	cma->drain_bitmap = kmalloc(bitmap_size, GFP_KERNEL);
 
-	if (!cma->bitmap) {
+	if (!cma->bitmap || !cma->drain_bitmap) {
+		kfree(cma->bitmap);
+		kfree(cma->drain_bitmap);
 		cma->count = 0;
 		return -ENOMEM;
 	}
+	bitmap_fill(cma->drain_bitmap, cma_bitmap_maxno(cma));
+	INIT_DEFERRABLE_WORK(&cma->drain_work, cma_drain_work);
 
 	WARN_ON_ONCE(!pfn_valid(pfn));
 	zone = page_zone(pfn_to_page(pfn));
@@ -137,6 +159,7 @@ static int __init cma_activate_area(struct cma *cma)
 
 err:
 	kfree(cma->bitmap);
+	kfree(cma->drain_bitmap);
 	cma->count = 0;
 	return -EINVAL;
 }
@@ -373,6 +396,182 @@ err:
 	return ret;
 }
 
+/*
+ * Give the drained units of @cma back to the page allocator.
+ * Call with cma->lock held.
+ */
+static void cma_drain_release(struct cma *cma)
+{
+	unsigned long bitmap_maxno = cma_bitmap_maxno(cma);
+	unsigned long start, end = 0;
+
+	while (cma->drained) {
+		start = find_next_zero_bit(cma->drain_bitmap, bitmap_maxno, end);
+		if (start >= bitmap_maxno)
+			break;
+		end = find_next_bit(cma->drain_bitmap, bitmap_maxno, start);
+
+		free_contig_range(cma->base_pfn + (start << cma->order_per_bit),
+				  (end - start) << cma->order_per_bit);
+		bitmap_set(cma->drain_bitmap, start, end - start);
+		bitmap_clear(cma->bitmap, start, end - start);
+		cma->drained -= end - start;
+	}
+}
+
+/*
+ * Take one pageblock of @cma out of the page allocator for the drained pool.
+ * Returns false when the pool is full, nothing is left to drain or memory
+ * outside CMA is too short to migrate into.
+ */
+static bool cma_drain_one(struct cma *cma)
+{
+	unsigned long count = pageblock_nr_pages;
+	unsigned long mask = cma_bitmap_aligned_mask(cma, pageblock_order);
+	unsigned long offset = cma_bitmap_aligned_offset(cma, pageblock_order);
+	unsigned long bitmap_maxno = cma_bitmap_maxno(cma);
+	unsigned long bitmap_count = cma_bitmap_pages_to_bits(cma, count);
+	unsigned long bitmap_no, pfn, start = 0;
+	int ret;
+
+	for (;;) {
+		if (global_page_state(NR_FREE_PAGES) -
+		    global_page_state(NR_FREE_CMA_PAGES) <
+		    totalreserve_pages + count)
+			return false;
+
+		mutex_lock(&cma->lock);
+		if ((cma->drained << cma->order_per_bit) >= cma->drain_target) {
+			mutex_unlock(&cma->lock);
+			return false;
+		}
+		bitmap_no = bitmap_find_next_zero_area_off(cma->bitmap,
+				bitmap_maxno, start, bitmap_count, mask,
+				offset);
+		if (bitmap_no >= bitmap_maxno) {
+			mutex_unlock(&cma->lock);
+			return false;
+		}
+		bitmap_set(cma->bitmap, bitmap_no, bitmap_count);
+		mutex_unlock(&cma->lock);
+
+		pfn = cma->base_pfn + (bitmap_no << cma->order_per_bit);
+		mutex_lock(&cma_mutex);
+		ret = alloc_contig_range(pfn, pfn + count, MIGRATE_CMA);
+		mutex_unlock(&cma_mutex);
+		if (ret == 0) {
+			mutex_lock(&cma->lock);
+			bitmap_clear(cma->drain_bitmap, bitmap_no, bitmap_count);
+			cma->drained += bitmap_count;
+			mutex_unlock(&cma->lock);
+			return true;
+		}
+
+		cma_clear_bitmap(cma, pfn, count);
+		if (ret != -EBUSY)
+			return false;
+
+		start = bitmap_no + mask + 1;
+	}
+}
+
+static void cma_drain_work(struct work_struct *work)
+{
+	struct cma *cma = container_of(to_delayed_work(work), struct cma,
+				       drain_work);
+	int i;
+
+	for (i = 0; i < CMA_DRAIN_BATCH; i++)
+		if (!cma_drain_one(cma))
+			return;
+
+	queue_delayed_work(system_freezable_power_efficient_wq,
+			   &cma->drain_work, 1);
+}
+
+/**
+ * cma_set_drain_target() - set how much of an area to keep drained
+ * @cma:   Contiguous memory region.
+ * @pages: Number of pages to keep free of movable pages, 0 to stop.
+ *
+ * Drained pages are not available to the page allocator until cma_alloc()
+ * hands them out, so this trades memory for cma_alloc() latency.
+ */
+void cma_set_drain_target(struct cma *cma, unsigned long pages)
+{
+	if (!cma || !cma->count)
+		return;
+
+	mutex_lock(&cma->lock);
+	cma->drain_target = min(pages, cma->count);
+	if ((cma->drained << cma->order_per_bit) > cma->drain_target)
+		cma_drain_release(cma);
+	mutex_unlock(&cma->lock);
+
+	cma_drain_kick(cma);
+}
+EXPORT_SYMBOL(cma_set_drain_target);
+
+unsigned long cma_get_drain_target(struct cma *cma)
+{
+	return cma ? cma->drain_target : 0;
+}
+EXPORT_SYMBOL(cma_get_drain_target);
+
+/**
+ * cma_drain_kick() - refill the drained pool of an area now
+ * @cma:   Contiguous memory region.
+ *
+ * For users that know an allocation is coming, like a camera being opened.
+ */
+void cma_drain_kick(struct cma *cma)
+{
+	if (!cma || !cma->count || !cma->drain_target)
+		return;
+
+	mod_delayed_work(system_freezable_power_efficient_wq,
+			 &cma->drain_work, 0);
+}
+EXPORT_SYMBOL(cma_drain_kick);
+
+/* Serve @count pages from the drained pool, or return NULL. */
+static struct page *cma_alloc_drained(struct cma *cma, size_t count,
+				      unsigned long bitmap_count,
+				      unsigned long mask, unsigned long offset)
+{
+	unsigned long bitmap_maxno = cma_bitmap_maxno(cma);
+	unsigned long bitmap_no, pfn;
+	struct page *page = NULL;
+
+	mutex_lock(&cma->lock);
+	if (cma->drained >= bitmap_count) {
+		bitmap_no = bitmap_find_next_zero_area_off(cma->drain_bitmap,
+				bitmap_maxno, 0, bitmap_count, mask, offset);
+		if (bitmap_no < bitmap_maxno) {
+			bitmap_set(cma->drain_bitmap, bitmap_no, bitmap_count);
+			cma->drained -= bitmap_count;
+			pfn = cma->base_pfn + (bitmap_no << cma->order_per_bit);
+			page = pfn_to_page(pfn);
+			/* like alloc_contig_range(), leave the unit's tail free */
+			if ((bitmap_count << cma->order_per_bit) > count)
+				free_contig_range(pfn + count,
+					(bitmap_count << cma->order_per_bit) -
+					count);
+		}
+	}
+	mutex_unlock(&cma->lock);
+
+	return page;
+}
+
+static void cma_account_latency(struct cma *cma, ktime_t start)
+{
+	s64 ms = ktime_ms_delta(ktime_get(), start);
+	int bucket = ms > 0 ? fls_long(ms) : 0;
+
+	atomic_long_inc(&cma->alloc_lat[min(bucket, CMA_LAT_BUCKETS - 1)]);
+}
+
 /**
  * cma_alloc() - allocate pages from contiguous area
  * @cma:   Contiguous memory region for which the allocation is performed.
@@ -389,6 +588,8 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 	unsigned long start = 0;
 	unsigned long bitmap_maxno, bitmap_no, bitmap_count;
 	struct page *page = NULL;
+	ktime_t start_time = ktime_get();
+	bool released = false;
 	int ret;
 
 	if (!cma || !cma->count)
@@ -405,11 +606,26 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 	bitmap_maxno = cma_bitmap_maxno(cma);
 	bitmap_count = cma_bitmap_pages_to_bits(cma, count);
 
+	page = cma_alloc_drained(cma, count, bitmap_count, mask, offset);
+	if (page) {
+		pfn = page_to_pfn(page);
+		atomic_long_inc(&cma->alloc_fast);
+		goto out;
+	}
+
 	for (;;) {
 		mutex_lock(&cma->lock);
 		bitmap_no = bitmap_find_next_zero_area_off(cma->bitmap,
 				bitmap_maxno, start, bitmap_count, mask,
 				offset);
+		if (bitmap_no >= bitmap_maxno && cma->drained && !released) {
+			/* the drained pool may be what is in the way */
+			cma_drain_release(cma);
+			released = true;
+			mutex_unlock(&cma->lock);
+			start = 0;
+			continue;
+		}
 		if (bitmap_no >= bitmap_maxno) {
 			mutex_unlock(&cma->lock);
 			break;
@@ -441,6 +657,12 @@ struct page *cma_alloc(struct cma *cma, size_t count, unsigned int align)
 		start = bitmap_no + mask + 1;
 	}
 
+out:
+	cma_account_latency(cma, start_time);
+	if (cma->drain_target)
+		queue_delayed_work(system_freezable_power_efficient_wq,
+				   &cma->drain_work, CMA_DRAIN_DELAY);
+
 	trace_cma_alloc(pfn, page, count, align);
 
 	pr_debug("%s(): returned %p\n", __func__, page);
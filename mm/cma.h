@@ -1,12 +1,27 @@
 #ifndef __MM_CMA_H__
 #define __MM_CMA_H__
 
+#include <linux/workqueue.h>
+
+/* allocation latency buckets: < 1ms, < 2ms, < 4ms, ... and >= 512ms */
+#define CMA_LAT_BUCKETS	11
+
 struct cma {
 	unsigned long   base_pfn;
 	unsigned long   count;
 	unsigned long   *bitmap;
 	unsigned int order_per_bit; /* Order of pages represented by one bit */
 	struct mutex    lock;
+	/*
+	 * Units taken out of the page allocator ahead of time are set in
+	 * bitmap and clear in drain_bitmap until cma_alloc() hands them out.
+	 */
+	unsigned long	*drain_bitmap;
+	unsigned long	drained;	/* clear bits in drain_bitmap */
+	unsigned long	drain_target;	/* pages to keep drained */
+	struct delayed_work drain_work;
+	atomic_long_t	alloc_fast;	/* served from drained units */
+	atomic_long_t	alloc_lat[CMA_LAT_BUCKETS];
 #ifdef CONFIG_CMA_DEBUGFS
 	const char	*name;
 	struct hlist_head mem_head;
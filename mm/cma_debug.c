@@ -9,6 +9,7 @@
 #include <linux/cma.h>
 #include <linux/list.h>
 #include <linux/kernel.h>
+#include <linux/seq_file.h>
 #include <linux/slab.h>
 #include <linux/mm_types.h>
 
@@ -69,6 +70,61 @@ static int cma_maxchunk_get(void *data, u64 *val)
 }
 DEFINE_SIMPLE_ATTRIBUTE(cma_maxchunk_fops, cma_maxchunk_get, NULL, "%llu\n");
 
+static int cma_drain_target_get(void *data, u64 *val)
+{
+	*val = cma_get_drain_target(data);
+
+	return 0;
+}
+
+static int cma_drain_target_set(void *data, u64 val)
+{
+	cma_set_drain_target(data, val);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(cma_drain_target_fops, cma_drain_target_get,
+			cma_drain_target_set, "%llu\n");
+
+static int cma_drained_get(void *data, u64 *val)
+{
+	struct cma *cma = data;
+
+	mutex_lock(&cma->lock);
+	*val = (u64)cma->drained << cma->order_per_bit;
+	mutex_unlock(&cma->lock);
+
+	return 0;
+}
+DEFINE_SIMPLE_ATTRIBUTE(cma_drained_fops, cma_drained_get, NULL, "%llu\n");
+
+static int cma_alloc_latency_show(struct seq_file *m, void *v)
+{
+	struct cma *cma = m->private;
+	int i;
+
+	seq_printf(m, "fast %ld\n", atomic_long_read(&cma->alloc_fast));
+	for (i = 0; i < CMA_LAT_BUCKETS - 1; i++)
+		seq_printf(m, "<%ums %ld\n", 1U << i,
+			   atomic_long_read(&cma->alloc_lat[i]));
+	seq_printf(m, ">=%ums %ld\n", 1U << (CMA_LAT_BUCKETS - 2),
+		   atomic_long_read(&cma->alloc_lat[i]));
+
+	return 0;
+}
+
+static int cma_alloc_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, cma_alloc_latency_show, inode->i_private);
+}
+
+static const struct file_operations cma_alloc_latency_fops = {
+	.open		= cma_alloc_latency_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
 static void cma_add_to_cma_mem_list(struct cma *cma, struct cma_mem *mem)
 {
 	spin_lock(&cma->mem_head_lock);
@@ -189,6 +245,11 @@ static void cma_debugfs_add_one(struct cma *cma, int idx)
 				&cma->order_per_bit, &cma_debugfs_fops);
 	debugfs_create_file("used", S_IRUGO, tmp, cma, &cma_used_fops);
 	debugfs_create_file("maxchunk", S_IRUGO, tmp, cma, &cma_maxchunk_fops);
+	debugfs_create_file("drain_target", S_IRUGO | S_IWUSR, tmp, cma,
+				&cma_drain_target_fops);
+	debugfs_create_file("drained", S_IRUGO, tmp, cma, &cma_drained_fops);
+	debugfs_create_file("alloc_latency", S_IRUGO, tmp, cma,
+				&cma_alloc_latency_fops);
 
 	u32s = DIV_ROUND_UP(cma_bitmap_maxno(cma), BITS_PER_BYTE * sizeof(u32));
 	debugfs_create_u32_array("bitmap", S_IRUGO, tmp, (u32*)cma->bitmap, u32s);
@@ -29,6 +29,10 @@
 #include <linux/dma-contiguous.h>
 #include <linux/oom.h>
 #include <linux/pm_qos.h>
+#include <linux/kthread.h>
+#include <linux/freezer.h>
+#include <linux/shrinker.h>
+#include <linux/moduleparam.h>
 
 #include "internal.h"
 
@@ -220,37 +224,23 @@ static void prep_highorder_pages(unsigned long start_pfn, int order)
 		set_page_count(pfn_to_page(pfn), 0);
 }
 
-int alloc_pages_highorder(int order, struct page **pages,
-		int nents, unsigned long start_pfn, unsigned long end_pfn)
+/*
+ * Migrate movable chunks of @order in [start_pfn, end_pfn) away into @pages
+ * from *@p on, scanning at most @max_scan pages from *@scan_pfn, where the
+ * scan stops. Returns the number of chunks still missing out of @remained.
+ */
+static int alloc_movable_chunks(int order, struct page **pages, int *p,
+			int remained, unsigned long start_pfn,
+			unsigned long end_pfn, unsigned long *scan_pfn,
+			unsigned long max_scan)
 {
-	struct zone *zone;
 	unsigned int nr_pages = 1 << order;
 	unsigned long total_scanned = 0;
 	unsigned long pfn, tmp;
-	int p = 0;
-	int remained = nents;
 	int ret;
-	int retry_count = 0;
-
-	cached_scan_pfn = max_t(u64, start_pfn, cached_scan_pfn);
-	cached_scan_pfn = min_t(u64, end_pfn, cached_scan_pfn);
-
-retry:
-	for_each_zone(zone) {
-		if (zone->spanned_pages == 0)
-			continue;
-		remained = alloc_freepages_range(zone, order, pages,
-			&p, remained, start_pfn, end_pfn);
-	}
 
-	if (remained == 0)
-		return 0;
-
-	migrate_prep();
-
-	for (pfn = ALIGN(cached_scan_pfn, nr_pages);
-			(total_scanned < (end_pfn - start_pfn) * MAX_SCAN_TRY)
-			&& (remained > 0);
+	for (pfn = ALIGN(*scan_pfn, nr_pages);
+			(total_scanned < max_scan) && (remained > 0);
 			pfn += nr_pages, total_scanned += nr_pages) {
 		int mt;
 
@@ -289,12 +279,267 @@ retry:
 		else
 			continue;
 
-		pages[p++] = pfn_to_page(pfn);
+		pages[(*p)++] = pfn_to_page(pfn);
 		remained--;
 	}
 
 	/* save latest scanned pfn */
-	cached_scan_pfn = pfn;
+	*scan_pfn = pfn;
+
+	return remained;
+}
+
+/*
+ * Background pool
+ *
+ * Allocating chunks on demand means migrating pages out of the way, which
+ * can take hundreds of milliseconds when e.g. secure video playback starts.
+ * Keep up to hpa_pool_chunks chunks of hpa_pool_order allocated ahead of
+ * time instead. They are taken by khpad while memory is plentiful, from free
+ * chunks first and by migration otherwise, and are handed back to the page
+ * allocator through a shrinker as soon as reclaim needs memory, after which
+ * refilling is held off for HPA_POOL_BACKOFF.
+ */
+#define HPA_POOL_BATCH		8
+#define HPA_POOL_RETRY		(5 * HZ)
+#define HPA_POOL_BACKOFF	(10 * HZ)
+
+static int hpa_pool_order = 5; /* ION_HPA_DEFAULT_ORDER */
+module_param_named(pool_order, hpa_pool_order, int, 0444);
+static unsigned int hpa_pool_chunks;
+static unsigned long hpa_pool_hits;
+module_param_named(pool_hits, hpa_pool_hits, ulong, 0444);
+
+static LIST_HEAD(hpa_pool);
+static unsigned int hpa_pool_size;
+static DEFINE_SPINLOCK(hpa_pool_lock); /* protects the above */
+static unsigned long hpa_pool_scan_pfn;
+static unsigned long hpa_pool_next_fill; /* jiffies */
+static DECLARE_WAIT_QUEUE_HEAD(hpa_pool_wait);
+static struct task_struct *hpa_pool_task;
+
+static int hpa_pool_deficit(void)
+{
+	return (int)READ_ONCE(hpa_pool_chunks) - (int)READ_ONCE(hpa_pool_size);
+}
+
+/* copy pooled chunks within [start_pfn, end_pfn] to @pages */
+static int hpa_pool_take(int order, struct page **pages, int nents,
+			 unsigned long start_pfn, unsigned long end_pfn)
+{
+	struct page *page, *tmp;
+	int p = 0;
+
+	if (order != hpa_pool_order || !READ_ONCE(hpa_pool_size))
+		return 0;
+
+	spin_lock(&hpa_pool_lock);
+	list_for_each_entry_safe(page, tmp, &hpa_pool, lru) {
+		unsigned long pfn = page_to_pfn(page);
+
+		if (p == nents)
+			break;
+		if (pfn < start_pfn || pfn + (1 << order) - 1 > end_pfn)
+			continue;
+
+		list_del(&page->lru);
+		hpa_pool_size--;
+		pages[p++] = page;
+	}
+	hpa_pool_hits += p;
+	spin_unlock(&hpa_pool_lock);
+
+	if (p)
+		wake_up(&hpa_pool_wait);
+
+	return p;
+}
+
+/* decline to fill while any reclaim is going on */
+static bool hpa_pool_can_fill(void)
+{
+	struct zone *zone;
+	unsigned long mark;
+
+	if (time_before(jiffies, hpa_pool_next_fill))
+		return false;
+
+	for_each_populated_zone(zone) {
+		mark = high_wmark_pages(zone) + (HPA_POOL_BATCH << hpa_pool_order);
+		if (!zone_watermark_ok(zone, 0, mark, 0, 0))
+			return false;
+	}
+
+	return true;
+}
+
+/* returns the number of chunks added to the pool */
+static int hpa_pool_fill(void)
+{
+	struct page *pages[HPA_POOL_BATCH];
+	unsigned long start_pfn = __phys_to_pfn(memblock_start_of_DRAM());
+	unsigned long end_pfn = max_pfn;
+	struct zone *zone;
+	int order = hpa_pool_order;
+	int nents = min(hpa_pool_deficit(), HPA_POOL_BATCH);
+	int remained = nents;
+	int i, p = 0;
+
+	if (nents <= 0)
+		return 0;
+
+	for_each_zone(zone) {
+		if (zone->spanned_pages == 0)
+			continue;
+		remained = alloc_freepages_range(zone, order, pages,
+			&p, remained, start_pfn, end_pfn);
+	}
+
+	if (remained) {
+		migrate_prep();
+		hpa_pool_scan_pfn = clamp(hpa_pool_scan_pfn, start_pfn,
+					  end_pfn);
+		/* one pass over the memory, and no killing: this can wait */
+		remained = alloc_movable_chunks(order, pages, &p, remained,
+				start_pfn, end_pfn, &hpa_pool_scan_pfn,
+				end_pfn - start_pfn);
+	}
+
+	spin_lock(&hpa_pool_lock);
+	for (i = 0; i < p; i++) {
+		list_add(&pages[i]->lru, &hpa_pool);
+		hpa_pool_size++;
+	}
+	spin_unlock(&hpa_pool_lock);
+
+	return p;
+}
+
+static int hpa_pool_thread(void *data)
+{
+	set_freezable();
+	set_user_nice(current, MAX_NICE);
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(hpa_pool_wait,
+				hpa_pool_deficit() > 0 || kthread_should_stop());
+
+		if (!hpa_pool_can_fill() || !hpa_pool_fill())
+			freezable_schedule_timeout_interruptible(HPA_POOL_RETRY);
+		cond_resched();
+	}
+
+	return 0;
+}
+
+/* give chunks beyond @keep back to the page allocator */
+static unsigned long hpa_pool_drain(unsigned int keep, unsigned long nr_pages)
+{
+	struct page *page;
+	unsigned long freed = 0;
+
+	while (freed < nr_pages) {
+		spin_lock(&hpa_pool_lock);
+		if (hpa_pool_size <= keep) {
+			spin_unlock(&hpa_pool_lock);
+			break;
+		}
+		page = list_first_entry(&hpa_pool, struct page, lru);
+		list_del(&page->lru);
+		hpa_pool_size--;
+		spin_unlock(&hpa_pool_lock);
+
+		__free_pages(page, hpa_pool_order);
+		freed += 1 << hpa_pool_order;
+	}
+
+	return freed;
+}
+
+static unsigned long hpa_pool_count(struct shrinker *s,
+				    struct shrink_control *sc)
+{
+	return (unsigned long)READ_ONCE(hpa_pool_size) << hpa_pool_order;
+}
+
+static unsigned long hpa_pool_scan(struct shrinker *s,
+				   struct shrink_control *sc)
+{
+	unsigned long freed;
+
+	hpa_pool_next_fill = jiffies + HPA_POOL_BACKOFF;
+	freed = hpa_pool_drain(0, sc->nr_to_scan);
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker hpa_pool_shrinker = {
+	.count_objects = hpa_pool_count,
+	.scan_objects = hpa_pool_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static int hpa_pool_chunks_set(const char *val, const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	if (ret)
+		return ret;
+
+	hpa_pool_drain(hpa_pool_chunks, ULONG_MAX);
+	wake_up(&hpa_pool_wait);
+	return 0;
+}
+
+static const struct kernel_param_ops hpa_pool_chunks_ops = {
+	.set = hpa_pool_chunks_set,
+	.get = param_get_uint,
+};
+module_param_cb(pool_chunks, &hpa_pool_chunks_ops, &hpa_pool_chunks, 0644);
+
+static int hpa_pool_size_get(char *buf, const struct kernel_param *kp)
+{
+	return sprintf(buf, "%u\n", READ_ONCE(hpa_pool_size));
+}
+
+static const struct kernel_param_ops hpa_pool_size_ops = {
+	.get = hpa_pool_size_get,
+};
+module_param_cb(pool_size, &hpa_pool_size_ops, NULL, 0444);
+
+int alloc_pages_highorder(int order, struct page **pages,
+		int nents, unsigned long start_pfn, unsigned long end_pfn)
+{
+	struct zone *zone;
+	int p = 0;
+	int remained = nents;
+	int ret;
+	int retry_count = 0;
+
+	cached_scan_pfn = max_t(u64, start_pfn, cached_scan_pfn);
+	cached_scan_pfn = min_t(u64, end_pfn, cached_scan_pfn);
+
+	p = hpa_pool_take(order, pages, nents, start_pfn, end_pfn);
+	remained = nents - p;
+	if (remained == 0)
+		return 0;
+
+retry:
+	for_each_zone(zone) {
+		if (zone->spanned_pages == 0)
+			continue;
+		remained = alloc_freepages_range(zone, order, pages,
+			&p, remained, start_pfn, end_pfn);
+	}
+
+	if (remained == 0)
+		return 0;
+
+	migrate_prep();
+
+	remained = alloc_movable_chunks(order, pages, &p, remained,
+			start_pfn, end_pfn, &cached_scan_pfn,
+			(end_pfn - start_pfn) * MAX_SCAN_TRY);
 
 	if (remained) {
 		int i;
@@ -303,7 +548,6 @@ retry:
 		count_vm_event(DROP_SLAB);
 		ret = hpa_killer();
 		if (ret == 0) {
-			total_scanned = 0;
 			pr_info("HPA: drop_slab and killer retry %d count\n",
 				retry_count++);
 			goto retry;
@@ -315,10 +559,10 @@ retry:
 		pr_info("%s: remained=%d / %d, not enough memory in order %d\n",
 				 __func__, remained, nents, order);
 
-		ret = -ENOMEM;
+		return -ENOMEM;
 	}
 
-	return ret;
+	return 0;
 }
 
 int free_pages_highorder(int order, struct page **pages, int nents)
@@ -334,6 +578,20 @@ int free_pages_highorder(int order, struct page **pages, int nents)
 static int __init init_highorder_pages_allocator(void)
 {
 	cached_scan_pfn = __phys_to_pfn(memblock_start_of_DRAM());
+	hpa_pool_scan_pfn = cached_scan_pfn;
+
+	if (hpa_pool_order < 0 || hpa_pool_order >= MAX_ORDER) {
+		pr_err("HPA: invalid pool order %d\n", hpa_pool_order);
+		return 0;
+	}
+
+	hpa_pool_task = kthread_run(hpa_pool_thread, NULL, "khpad");
+	if (IS_ERR(hpa_pool_task)) {
+		pr_err("HPA: failed to start the pool thread\n");
+		hpa_pool_task = NULL;
+		return 0;
+	}
+	register_shrinker(&hpa_pool_shrinker);
 
 	return 0;
 }
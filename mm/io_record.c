@@ -26,6 +26,10 @@
 #include <linux/cleancache.h>
 #include <linux/rmap.h>
 #include <linux/module.h>
+#include <linux/kthread.h>
+#include <linux/cred.h>
+#include <linux/ktime.h>
+#include <linux/kdev_t.h>
 #include <linux/io_record.h>
 #include "internal.h"
 
@@ -49,9 +53,42 @@ void *result_buf; /* buffer used for post processing result */
  * <"path" string, (size = A)>
  * <tuple array, (size = B * sizeof(int) * 2>
  * <end MAGIC, (val = -1, size = sizeof(int) * 2>
+ *
+ * after the last magic (val = -1, size = sizeof(int)), if it fits:
+ * <PIN MAGIC, (size = sizeof(int))>
+ * <C = # of pins, (size = sizeof(int))>
+ * <pin array, one per file in the order above, (size = C * 16)>
+ *
+ * Readers that stop at the last magic are not affected by the pins.
  */
 #define MAX_FILEPATH_LEN 256
 
+#define RESULT_BUF_PIN_MAGIC 0x4e50494f /* "OIPN" */
+#define NUM_PINS_IN_BUF 2048
+
+/* identifies the inode a path referred to when the trace was taken */
+struct io_record_pin {
+	u64 ino;
+	u32 generation;
+	u32 dev;
+};
+
+struct io_record_pin *record_pins; /* filled by post processing */
+int nr_record_pins;
+
+static void record_pin(struct inode *inode)
+{
+	struct io_record_pin *pin;
+
+	if (nr_record_pins >= NUM_PINS_IN_BUF)
+		return;
+
+	pin = record_pins + nr_record_pins++;
+	pin->ino = inode->i_ino;
+	pin->generation = inode->i_generation;
+	pin->dev = new_encode_dev(inode->i_sb->s_dev);
+}
+
 /* return bytes written to the path. if buffer full, return < 0 */
 void *result_buf_cursor; /* this is touched by post processing only */
 void write_to_result_buf(void *src, int size)
@@ -133,42 +170,69 @@ int fill_result_buf(int start_idx, int end_idx)
 	write_to_result_buf(&prev_offset, sizeof(int));
 	write_to_result_buf(&max_size, sizeof(int));
 
+	record_pin(file_inode(file));
+
 	/* return # of bytes written to result buf */
 	ret = result_buf_cursor - buf_start;
 out:
 	return ret;
 }
 
-/* idx record_buf_cursor of the array (record_buf) */
-static atomic_t record_buf_cursor = ATOMIC_INIT(-1);
+/*
+ * record_buf is split in one segment of record_seg_size entries per CPU, each
+ * only appended to by its own CPU with preemption disabled, so recording
+ * shares no cache line between CPUs. Writers are fenced off by clearing
+ * record_enable and waiting for synchronize_sched(), after which
+ * merge_records() makes the segments contiguous for post processing.
+ */
+static int record_seg_size;
+static DEFINE_PER_CPU(int, record_cursor); /* used entries of the segment */
+static DEFINE_PER_CPU(unsigned long, record_dropped); /* segment was full */
+static int nr_merged_records = -1; /* -1 while not merged */
 
-static DEFINE_RWLOCK(record_rwlock);
 int record_target; /* pid # of group leader */
 bool record_enable;
 
 static DEFINE_MUTEX(status_lock);
 enum  io_record_cmd_types current_status = IO_RECORD_INIT;
 
+/* the caller must hold status_lock */
 static inline void set_record_status(bool enable)
 {
-	write_lock(&record_rwlock);
-	record_enable = enable;
-	write_unlock(&record_rwlock);
+	WRITE_ONCE(record_enable, enable);
+	/* wait for writers that still saw it enabled */
+	if (!enable)
+		synchronize_sched();
 }
 
-/* assume caller has read lock of record_rwlock */
-static inline bool __get_record_status(void)
+static inline void set_record_target(int pid)
 {
-	return record_enable;
+	WRITE_ONCE(record_target, pid);
 }
 
-static inline void set_record_target(int pid)
+static unsigned long dropped_records(void)
+{
+	unsigned long sum = 0;
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		sum += per_cpu(record_dropped, cpu);
+
+	return sum;
+}
+
+static int dropped_records_get(char *buf, const struct kernel_param *kp)
 {
-	write_lock(&record_rwlock);
-	record_target = pid;
-	write_unlock(&record_rwlock);
+	return sprintf(buf, "%lu\n", dropped_records());
 }
 
+static const struct kernel_param_ops dropped_records_ops = {
+	.get = dropped_records_get,
+};
+module_param_cb(dropped_records, &dropped_records_ops, NULL, 0444);
+MODULE_PARM_DESC(dropped_records,
+		 "Records lost to a full per-CPU segment since the last init");
+
 void release_records(void);
 
 /* change the current status, and do the init jobs for the status */
@@ -179,8 +243,8 @@ static void change_current_status(enum io_record_cmd_types status)
 		set_record_status(false);
 		set_record_target(-1);
 		release_records();
-		atomic_set(&record_buf_cursor, 0);
 		result_buf_cursor = result_buf;
+		nr_record_pins = 0;
 		break;
 	case IO_RECORD_START:
 		set_record_status(true);
@@ -293,10 +357,46 @@ static int io_info_compare(const void *lhs, const void *rhs)
 	}
 }
 
+/* move the per-CPU segments together, returns the # of records */
+static int merge_records(void)
+{
+	int cpu, cnt, nr = 0;
+
+	for_each_possible_cpu(cpu) {
+		cnt = per_cpu(record_cursor, cpu);
+		/* the destination never overlaps a later segment */
+		if (cnt && nr != cpu * record_seg_size)
+			memmove(record_buf + nr,
+				record_buf + cpu * record_seg_size,
+				sizeof(struct io_info) * cnt);
+		nr += cnt;
+	}
+	nr_merged_records = nr;
+
+	return nr;
+}
+
+/* append as many pins as fit after the last magic */
+static void write_pins_to_result_buf(void)
+{
+	int magic = RESULT_BUF_PIN_MAGIC;
+	int room = RESULT_BUF_SIZE_IN_BYTES - (result_buf_cursor - result_buf);
+	int nr;
+
+	room -= sizeof(int) * 2;
+	if (room < (int)sizeof(struct io_record_pin))
+		return;
+
+	nr = min_t(int, nr_record_pins, room / sizeof(struct io_record_pin));
+	write_to_result_buf(&magic, sizeof(int));
+	write_to_result_buf(&nr, sizeof(int));
+	write_to_result_buf(record_pins, nr * sizeof(struct io_record_pin));
+}
+
 bool post_processing_records(void)
 {
 	bool ret = false;
-	int i;
+	int i, nr_records;
 	struct inode *prev_inode = NULL;
 	int start_idx = -1, end_idx = -1;
 	int last_magic = RESULT_BUF_END_MAGIC;
@@ -306,12 +406,17 @@ bool post_processing_records(void)
 		goto out;
 
 	/* From this point, we assume that no one touches record buf */
+	nr_records = merge_records();
+	if (dropped_records())
+		pr_info("%s: %lu records dropped\n", __func__,
+			dropped_records());
+
 	/* sort based on inode pointer address */
-	sort(record_buf, atomic_read(&record_buf_cursor),
+	sort(record_buf, nr_records,
 	     sizeof(struct io_info), &io_info_compare, &io_info_swap);
 
 	/* fill the result buf per inode */
-	for (i = 0; i < atomic_read(&record_buf_cursor); i++) {
+	for (i = 0; i < nr_records; i++) {
 		if (prev_inode != record_buf[i].inode) {
 			end_idx = i;
 			if (prev_inode && (fill_result_buf(start_idx,
@@ -329,6 +434,8 @@ bool post_processing_records(void)
 	/* fill the last magic to indicate end of result */
 	write_to_result_buf(&last_magic, sizeof(int));
 
+	write_pins_to_result_buf();
+
 	if (!change_status_if_valid(IO_RECORD_POST_PROCESSING_DONE))
 		BUG_ON(1); /* this is the case not in consideration */
 
@@ -409,57 +516,433 @@ void record_io_info(struct file *file, pgoff_t offset,
 		    unsigned long req_size)
 {
 	struct io_info *info;
-	int cnt;
+	int *cursor;
 
 	/* check without lock */
-	if ((int)task_tgid_nr(current) != record_target)
+	if ((int)task_tgid_nr(current) != READ_ONCE(record_target))
 		return;
 
 	if (offset >= INT_MAX || req_size >= INT_MAX)
 		return;
 
-	cnt = atomic_read(&record_buf_cursor);
-	if (cnt < 0 || cnt >= NUM_IO_INFO_IN_BUF || !file || req_size == 0)
-		return;
-
-	if (!read_trylock(&record_rwlock))
+	if (!file || req_size == 0 || !record_seg_size)
 		return;
 
-	if (!__get_record_status())
+	/* pairs with synchronize_sched() in set_record_status() */
+	preempt_disable();
+	if (!READ_ONCE(record_enable))
 		goto out;
 
 	/* strict check */
-	if ((int)task_tgid_nr(current) != record_target)
+	if ((int)task_tgid_nr(current) != READ_ONCE(record_target))
 		goto out;
 
-	cnt = atomic_inc_return(&record_buf_cursor) - 1;
+	cursor = this_cpu_ptr(&record_cursor);
 
-	/* buffer is full */
-	if (cnt >= NUM_IO_INFO_IN_BUF) {
-		atomic_dec(&record_buf_cursor);
+	/* segment is full */
+	if (*cursor >= record_seg_size) {
+		this_cpu_inc(record_dropped);
 		goto out;
 	}
 
-	info = record_buf + cnt;
+	info = record_buf + smp_processor_id() * record_seg_size + *cursor;
 
 	get_file(file); /* will be put in release_records */
 	info->file = file;
 	info->inode = file_inode(file);
 	info->offset = (int)offset;
 	info->nr_pages = (int)req_size;
+	(*cursor)++;
 out:
-	read_unlock(&record_rwlock);
+	preempt_enable();
 }
 
+/* assume recording is disabled, see set_record_status() */
 void release_records(void)
 {
-	int i;
+	int i, cpu, cnt;
 	struct io_info *info;
 
-	for (i = 0; i < atomic_read(&record_buf_cursor); i++) {
-		info = record_buf + i;
-		fput(info->file);
+	for (i = 0; i < nr_merged_records; i++)
+		fput(record_buf[i].file);
+
+	for_each_possible_cpu(cpu) {
+		cnt = nr_merged_records < 0 ? per_cpu(record_cursor, cpu) : 0;
+		info = record_buf + cpu * record_seg_size;
+		for (i = 0; i < cnt; i++)
+			fput(info[i].file);
+		per_cpu(record_cursor, cpu) = 0;
+		per_cpu(record_dropped, cpu) = 0;
 	}
+	nr_merged_records = -1;
+}
+
+/*
+ * Replay of a saved trace
+ *
+ * A result read out through read_record() can be written back later, e.g.
+ * right before the app it was recorded for is launched again. A kthread then
+ * opens each file and reads its ranges ahead in offset order, which saves the
+ * launcher a path lookup and a syscall round trip per file. Files whose pin
+ * no longer matches have been replaced since the trace was taken, typically
+ * by an app update, and are skipped as stale.
+ *
+ * The kthread runs at the lowest priority with the credentials of the writer,
+ * so it can prefetch nothing the writer could not read itself.
+ */
+struct io_replay_range {
+	int offset;
+	int nr_pages;
+};
+
+struct io_replay_stat {
+	unsigned long files;		/* read ahead */
+	unsigned long stale;		/* pin mismatch */
+	unsigned long missing;		/* could not be opened */
+	unsigned long ranges;		/* after merging */
+	unsigned long hit_pages;	/* already in the page cache */
+	unsigned long miss_pages;	/* read ahead by the replay */
+	u64 elapsed_ns;
+};
+
+static DEFINE_MUTEX(replay_lock); /* protects the below */
+static bool replay_busy; /* the buffer is being written or replayed */
+static void *replay_buf;
+static size_t replay_size;
+static struct io_replay_stat replay_stat;
+
+/* the replay_buf accessors below are only used by the replay kthread */
+static bool replay_get_int(size_t *pos, int *val)
+{
+	if (replay_size - *pos < sizeof(int))
+		return false;
+
+	memcpy(val, replay_buf + *pos, sizeof(int));
+	*pos += sizeof(int);
+	return true;
+}
+
+/*
+ * Validate the file list and find the largest range array in it. On success,
+ * *pos is left just past the last magic.
+ */
+static bool replay_scan(size_t *pos, int *nr_files, int *max_ranges)
+{
+	int len, offset, nr_pages, n;
+
+	*nr_files = 0;
+	*max_ranges = 0;
+	for (;;) {
+		if (!replay_get_int(pos, &len))
+			return false;
+		if (len == RESULT_BUF_END_MAGIC)
+			return true;
+		if (len <= 0 || len >= MAX_FILEPATH_LEN ||
+		    replay_size - *pos < len)
+			return false;
+		*pos += len;
+
+		for (n = 0; ; n++) {
+			if (!replay_get_int(pos, &offset) ||
+			    !replay_get_int(pos, &nr_pages))
+				return false;
+			if (offset == RESULT_BUF_END_MAGIC &&
+			    nr_pages == RESULT_BUF_END_MAGIC)
+				break;
+		}
+		(*nr_files)++;
+		*max_ranges = max(*max_ranges, n);
+	}
+}
+
+static int io_replay_range_compare(const void *lhs, const void *rhs)
+{
+	const struct io_replay_range *lrange = lhs;
+	const struct io_replay_range *rrange = rhs;
+
+	if (lrange->offset > rrange->offset)
+		return 1;
+	else if (lrange->offset < rrange->offset)
+		return -1;
+	return 0;
+}
+
+/* sort and merge overlapping or adjacent ranges, returns the new count */
+static int replay_merge_ranges(struct io_replay_range *ranges, int n)
+{
+	int i, j = 0;
+
+	if (!n)
+		return 0;
+
+	sort(ranges, n, sizeof(*ranges), io_replay_range_compare, NULL);
+	for (i = 1; i < n; i++) {
+		int end = ranges[j].offset + ranges[j].nr_pages;
+
+		if (ranges[i].offset <= end) {
+			end = max(end, ranges[i].offset + ranges[i].nr_pages);
+			ranges[j].nr_pages = end - ranges[j].offset;
+		} else {
+			ranges[++j] = ranges[i];
+		}
+	}
+
+	return j + 1;
+}
+
+static unsigned long replay_cached_pages(struct address_space *mapping,
+					 pgoff_t start, unsigned long nr)
+{
+	unsigned long i, cached = 0;
+	void *entry;
+
+	rcu_read_lock();
+	for (i = 0; i < nr; i++) {
+		entry = radix_tree_lookup(&mapping->page_tree, start + i);
+		if (entry && !radix_tree_exceptional_entry(entry))
+			cached++;
+	}
+	rcu_read_unlock();
+
+	return cached;
+}
+
+static void replay_file(const char *path, const struct io_record_pin *pin,
+			struct io_replay_range *ranges, int n,
+			struct io_replay_stat *stat)
+{
+	struct address_space *mapping;
+	struct inode *inode;
+	struct file *file;
+	unsigned long chunk;
+	pgoff_t end_index;
+	int i;
+
+	file = filp_open(path, O_RDONLY | O_LARGEFILE, 0);
+	if (IS_ERR(file)) {
+		stat->missing++;
+		return;
+	}
+
+	inode = file_inode(file);
+	if (!S_ISREG(inode->i_mode)) {
+		stat->missing++;
+		goto out;
+	}
+
+	if (pin && (inode->i_ino != pin->ino ||
+		    inode->i_generation != pin->generation ||
+		    new_encode_dev(inode->i_sb->s_dev) != pin->dev)) {
+		stat->stale++;
+		goto out;
+	}
+
+	/* force_page_cache_readahead() reads at most this much per call */
+	mapping = file->f_mapping;
+	chunk = max_t(unsigned long, inode_to_bdi(inode)->io_pages,
+		      file->f_ra.ra_pages);
+	chunk = max(chunk, 1UL);
+	end_index = DIV_ROUND_UP(i_size_read(inode), PAGE_SIZE);
+
+	n = replay_merge_ranges(ranges, n);
+	for (i = 0; i < n; i++) {
+		pgoff_t index = ranges[i].offset;
+		unsigned long nr = ranges[i].nr_pages;
+		unsigned long cached;
+
+		if (index >= end_index)
+			break;
+		nr = min_t(unsigned long, nr, end_index - index);
+
+		cached = replay_cached_pages(mapping, index, nr);
+		stat->hit_pages += cached;
+		stat->miss_pages += nr - cached;
+		if (cached == nr)
+			continue;
+
+		while (nr) {
+			unsigned long this_chunk = min(nr, chunk);
+
+			if (force_page_cache_readahead(mapping, file, index,
+						       this_chunk) < 0)
+				break;
+			index += this_chunk;
+			nr -= this_chunk;
+		}
+	}
+	stat->files++;
+	stat->ranges += n;
+out:
+	filp_close(file, NULL);
+}
+
+static int io_replay_thread(void *data)
+{
+	const struct cred *old_cred, *cred = data;
+	struct io_replay_stat stat = {};
+	struct io_replay_range *ranges = NULL;
+	struct io_record_pin pin;
+	char path[MAX_FILEPATH_LEN];
+	size_t pos = 0, pins_pos = 0;
+	int nr_files, max_ranges, nr_pins = 0, magic;
+	int i, n, len;
+	u64 start = ktime_get_ns();
+
+	set_user_nice(current, MAX_NICE);
+	old_cred = override_creds(cred);
+
+	if (!replay_scan(&pos, &nr_files, &max_ranges)) {
+		pr_err("%s: malformed trace\n", __func__);
+		goto out;
+	}
+
+	/* pins are optional, and may cover only the first files */
+	if (replay_get_int(&pos, &magic) && magic == RESULT_BUF_PIN_MAGIC &&
+	    replay_get_int(&pos, &nr_pins) && nr_pins >= 0 &&
+	    (replay_size - pos) / sizeof(pin) >= nr_pins)
+		pins_pos = pos;
+	else
+		nr_pins = 0;
+
+	ranges = vmalloc(max(max_ranges, 1) * sizeof(*ranges));
+	if (!ranges)
+		goto out;
+
+	/* the layout has been validated by replay_scan() */
+	pos = 0;
+	for (i = 0; i < nr_files; i++) {
+		replay_get_int(&pos, &len);
+		memcpy(path, replay_buf + pos, len);
+		path[len] = '\0';
+		pos += len;
+
+		for (n = 0; ; ) {
+			struct io_replay_range range;
+
+			replay_get_int(&pos, &range.offset);
+			replay_get_int(&pos, &range.nr_pages);
+			if (range.offset == RESULT_BUF_END_MAGIC &&
+			    range.nr_pages == RESULT_BUF_END_MAGIC)
+				break;
+			if (range.offset >= 0 && range.nr_pages > 0 &&
+			    range.nr_pages <= INT_MAX - range.offset)
+				ranges[n++] = range;
+		}
+
+		if (i < nr_pins)
+			memcpy(&pin, replay_buf + pins_pos + i * sizeof(pin),
+			       sizeof(pin));
+		replay_file(path, i < nr_pins ? &pin : NULL, ranges, n, &stat);
+		cond_resched();
+	}
+	vfree(ranges);
+out:
+	revert_creds(old_cred);
+	put_cred(cred);
+	stat.elapsed_ns = ktime_get_ns() - start;
+
+	mutex_lock(&replay_lock);
+	replay_stat = stat;
+	vfree(replay_buf);
+	replay_buf = NULL;
+	replay_size = 0;
+	replay_busy = false;
+	mutex_unlock(&replay_lock);
+	return 0;
+}
+
+/* claim the replay buffer for a writer, only one at a time */
+int open_replay(void)
+{
+	int ret = 0;
+
+	mutex_lock(&replay_lock);
+	if (replay_busy) {
+		ret = -EBUSY;
+		goto out;
+	}
+
+	replay_buf = vmalloc(RESULT_BUF_SIZE_IN_BYTES);
+	if (!replay_buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	replay_size = 0;
+	replay_busy = true;
+out:
+	mutex_unlock(&replay_lock);
+	return ret;
+}
+
+ssize_t write_replay(const char __user *buf, size_t count, loff_t *ppos)
+{
+	ssize_t ret;
+
+	mutex_lock(&replay_lock);
+	if (*ppos >= RESULT_BUF_SIZE_IN_BYTES) {
+		ret = -ENOSPC;
+		goto out;
+	}
+
+	ret = min_t(size_t, count, RESULT_BUF_SIZE_IN_BYTES - *ppos);
+	if (copy_from_user(replay_buf + *ppos, buf, ret)) {
+		ret = -EFAULT;
+		goto out;
+	}
+
+	*ppos = *ppos + ret;
+	replay_size = max_t(size_t, replay_size, *ppos);
+out:
+	mutex_unlock(&replay_lock);
+	return ret;
+}
+
+/* called when the writer closes the file: replay what has been written */
+void start_replay(void)
+{
+	const struct cred *cred = get_current_cred();
+	struct task_struct *task;
+
+	mutex_lock(&replay_lock);
+	if (!replay_size)
+		goto fail;
+
+	task = kthread_run(io_replay_thread, (void *)cred, "io_replay");
+	if (IS_ERR(task))
+		goto fail;
+
+	mutex_unlock(&replay_lock);
+	return;
+fail:
+	vfree(replay_buf);
+	replay_buf = NULL;
+	replay_busy = false;
+	mutex_unlock(&replay_lock);
+	put_cred(cred);
+}
+
+/* statistics of the last completed replay */
+ssize_t read_replay(char __user *buf, size_t count, loff_t *ppos)
+{
+	struct io_replay_stat stat;
+	char kbuf[256];
+	bool busy;
+	int len;
+
+	mutex_lock(&replay_lock);
+	stat = replay_stat;
+	busy = replay_busy;
+	mutex_unlock(&replay_lock);
+
+	len = scnprintf(kbuf, sizeof(kbuf),
+			"running %d\nfiles %lu\nstale %lu\nmissing %lu\n"
+			"ranges %lu\nhit_pages %lu\nmiss_pages %lu\n"
+			"elapsed_us %llu\n",
+			busy, stat.files, stat.stale, stat.missing,
+			stat.ranges, stat.hit_pages, stat.miss_pages,
+			div_u64(stat.elapsed_ns, NSEC_PER_USEC));
+
+	return simple_read_from_buffer(buf, count, ppos, kbuf, len);
 }
 
 static int __init io_record_init(void)
@@ -467,17 +950,24 @@ static int __init io_record_init(void)
 	record_buf = vzalloc(sizeof(struct io_info) * NUM_IO_INFO_IN_BUF);
 	if (!record_buf)
 		goto record_buf_fail;
+	record_seg_size = NUM_IO_INFO_IN_BUF / nr_cpu_ids;
 
 	result_buf = vzalloc(RESULT_BUF_SIZE_IN_BYTES);
 	if (!result_buf)
 		goto result_buf_fail;
 
+	record_pins = vzalloc(sizeof(struct io_record_pin) * NUM_PINS_IN_BUF);
+	if (!record_pins)
+		goto record_pins_fail;
+
 	mutex_lock(&status_lock);
 	if (!change_status_if_valid(IO_RECORD_INIT))
 		BUG_ON(1); /* should success at boot time */
 
 	mutex_unlock(&status_lock);
 	return 0;
+record_pins_fail:
+	vfree(result_buf);
 result_buf_fail:
 	vfree(record_buf);
 record_buf_fail:
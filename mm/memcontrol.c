@@ -1869,12 +1869,28 @@ EXPORT_SYMBOL(mem_cgroup_end_page_stat);
 
 /*
  * size of first charge trial. "32" comes from vmscan.c's magic value.
- * TODO: maybe necessary to use big numbers in big irons.
+ * A cpu that keeps running its stock dry for the same memcg doubles the
+ * refill for that memcg, up to CHARGE_BATCH_MAX.
  */
 #define CHARGE_BATCH	32U
-struct memcg_stock_pcp {
+#define CHARGE_BATCH_MAX	(CHARGE_BATCH * 8)
+
+/*
+ * Each cpu keeps stock for a few memcgs at once, so that tasks of different
+ * per-app groups sharing a cpu don't flush each other's stock on every
+ * context switch.
+ */
+#define MEMCG_STOCK_SLOTS	4
+
+struct memcg_stock_slot {
 	struct mem_cgroup *cached; /* this never be root cgroup */
 	unsigned int nr_pages;
+	unsigned int batch;	/* pages to charge at the next refill */
+};
+
+struct memcg_stock_pcp {
+	struct memcg_stock_slot slots[MEMCG_STOCK_SLOTS];
+	unsigned int next_evict;
 	struct work_struct work;
 	unsigned long flags;
 #define FLUSHING_CACHED_CHARGE	0
@@ -1882,49 +1898,116 @@ struct memcg_stock_pcp {
 static DEFINE_PER_CPU(struct memcg_stock_pcp, memcg_stock);
 static DEFINE_MUTEX(percpu_charge_mutex);
 
+enum memcg_charge_stat_item {
+	MEMCG_CHARGE_STOCK_HIT,
+	MEMCG_CHARGE_STOCK_MISS,
+	MEMCG_CHARGE_COUNTER,		/* charges to the page counters */
+	MEMCG_CHARGE_BATCH_GROW,
+	MEMCG_CHARGE_SLOT_EVICT,
+	MEMCG_CHARGE_DRAIN_ALL,
+	MEMCG_CHARGE_RECLAIM_DEFERRED,
+	MEMCG_CHARGE_NSTATS,
+};
+
+static const char * const memcg_charge_stat_names[] = {
+	"stock_hit",
+	"stock_miss",
+	"counter_charge",
+	"batch_grow",
+	"slot_evict",
+	"drain_all",
+	"reclaim_deferred",
+};
+
+struct memcg_charge_stat {
+	unsigned long count[MEMCG_CHARGE_NSTATS];
+};
+static DEFINE_PER_CPU(struct memcg_charge_stat, memcg_charge_stat);
+
+static inline void memcg_charge_stat_inc(enum memcg_charge_stat_item item)
+{
+	this_cpu_inc(memcg_charge_stat.count[item]);
+}
+
+static struct memcg_stock_slot *stock_slot(struct memcg_stock_pcp *stock,
+					   struct mem_cgroup *memcg)
+{
+	int i;
+
+	for (i = 0; i < MEMCG_STOCK_SLOTS; i++)
+		if (stock->slots[i].cached == memcg)
+			return &stock->slots[i];
+	return NULL;
+}
+
 /**
  * consume_stock: Try to consume stocked charge on this cpu.
  * @memcg: memcg to consume from.
  * @nr_pages: how many pages to charge.
+ * @batch: set to how many pages to charge for @memcg if this fails.
  *
- * The charges will only happen if @memcg matches the current cpu's memcg
- * stock, and at least @nr_pages are available in that stock.  Failure to
+ * The charges will only happen if @memcg has a stock slot on the current
+ * cpu, and at least @nr_pages are available in that slot.  Failure to
  * service an allocation will refill the stock.
  *
  * returns true if successful, false otherwise.
  */
-static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
+static bool consume_stock(struct mem_cgroup *memcg, unsigned int nr_pages,
+			  unsigned int *batch)
 {
 	struct memcg_stock_pcp *stock;
+	struct memcg_stock_slot *slot;
 	bool ret = false;
 
-	if (nr_pages > CHARGE_BATCH)
+	*batch = CHARGE_BATCH;
+	if (nr_pages > CHARGE_BATCH_MAX)
 		return ret;
 
 	stock = &get_cpu_var(memcg_stock);
-	if (memcg == stock->cached && stock->nr_pages >= nr_pages) {
-		stock->nr_pages -= nr_pages;
-		ret = true;
+	slot = stock_slot(stock, memcg);
+	if (slot) {
+		if (slot->nr_pages >= nr_pages) {
+			slot->nr_pages -= nr_pages;
+			ret = true;
+		} else if (slot->batch < CHARGE_BATCH_MAX) {
+			slot->batch *= 2;
+			memcg_charge_stat_inc(MEMCG_CHARGE_BATCH_GROW);
+		}
+		*batch = slot->batch;
 	}
+	memcg_charge_stat_inc(ret ? MEMCG_CHARGE_STOCK_HIT :
+			      MEMCG_CHARGE_STOCK_MISS);
 	put_cpu_var(memcg_stock);
 	return ret;
 }
 
 /*
- * Returns stocks cached in percpu and reset cached information.
+ * Returns the charge cached in a stock slot and frees the slot.
  */
-static void drain_stock(struct memcg_stock_pcp *stock)
+static void drain_stock_slot(struct memcg_stock_slot *slot)
 {
-	struct mem_cgroup *old = stock->cached;
+	struct mem_cgroup *old = slot->cached;
 
-	if (stock->nr_pages) {
-		page_counter_uncharge(&old->memory, stock->nr_pages);
+	if (slot->nr_pages) {
+		page_counter_uncharge(&old->memory, slot->nr_pages);
 		if (do_swap_account)
-			page_counter_uncharge(&old->memsw, stock->nr_pages);
-		css_put_many(&old->css, stock->nr_pages);
-		stock->nr_pages = 0;
+			page_counter_uncharge(&old->memsw, slot->nr_pages);
+		css_put_many(&old->css, slot->nr_pages);
+		slot->nr_pages = 0;
 	}
-	stock->cached = NULL;
+	slot->cached = NULL;
+	slot->batch = CHARGE_BATCH;
+}
+
+/*
+ * Returns stocks cached in percpu and reset cached information.
+ */
+static void drain_stock(struct memcg_stock_pcp *stock)
+{
+	int i;
+
+	for (i = 0; i < MEMCG_STOCK_SLOTS; i++)
+		drain_stock_slot(&stock->slots[i]);
 }
 
 /*
@@ -1945,12 +2028,21 @@ static void drain_local_stock(struct work_struct *dummy)
 static void refill_stock(struct mem_cgroup *memcg, unsigned int nr_pages)
 {
 	struct memcg_stock_pcp *stock = &get_cpu_var(memcg_stock);
-
-	if (stock->cached != memcg) { /* reset if necessary */
-		drain_stock(stock);
-		stock->cached = memcg;
+	struct memcg_stock_slot *slot;
+
+	slot = stock_slot(stock, memcg);
+	if (!slot) {
+		slot = stock_slot(stock, NULL);
+		if (!slot) {
+			slot = &stock->slots[stock->next_evict++ %
+					     MEMCG_STOCK_SLOTS];
+			drain_stock_slot(slot);
+			memcg_charge_stat_inc(MEMCG_CHARGE_SLOT_EVICT);
+		}
+		slot->cached = memcg;
+		slot->batch = CHARGE_BATCH;
 	}
-	stock->nr_pages += nr_pages;
+	slot->nr_pages += nr_pages;
 	put_cpu_var(memcg_stock);
 }
 
@@ -1965,17 +2057,22 @@ static void drain_all_stock(struct mem_cgroup *root_memcg)
 	/* If someone's already draining, avoid adding running more workers. */
 	if (!mutex_trylock(&percpu_charge_mutex))
 		return;
+	memcg_charge_stat_inc(MEMCG_CHARGE_DRAIN_ALL);
 	/* Notify other cpus that system-wide "drain" is running */
 	get_online_cpus();
 	curcpu = get_cpu_light();
 	for_each_online_cpu(cpu) {
 		struct memcg_stock_pcp *stock = &per_cpu(memcg_stock, cpu);
 		struct mem_cgroup *memcg;
+		int i;
 
-		memcg = stock->cached;
-		if (!memcg || !stock->nr_pages)
-			continue;
-		if (!mem_cgroup_is_descendant(memcg, root_memcg))
+		for (i = 0; i < MEMCG_STOCK_SLOTS; i++) {
+			memcg = stock->slots[i].cached;
+			if (memcg && stock->slots[i].nr_pages &&
+			    mem_cgroup_is_descendant(memcg, root_memcg))
+				break;
+		}
+		if (i == MEMCG_STOCK_SLOTS)
 			continue;
 		if (!test_and_set_bit(FLUSHING_CACHED_CHARGE, &stock->flags)) {
 			if (cpu == curcpu)
@@ -2035,7 +2132,7 @@ void mem_cgroup_handle_over_high(void)
 static int try_charge(struct mem_cgroup *memcg, gfp_t gfp_mask,
 		      unsigned int nr_pages)
 {
-	unsigned int batch = max(CHARGE_BATCH, nr_pages);
+	unsigned int batch = 0, stock_batch;
 	int nr_retries = MEM_CGROUP_RECLAIM_RETRIES;
 	struct mem_cgroup *mem_over_limit;
 	struct page_counter *counter;
@@ -2046,9 +2143,18 @@ static int try_charge(struct mem_cgroup *memcg, gfp_t gfp_mask,
 	if (mem_cgroup_is_root(memcg))
 		return 0;
 retry:
-	if (consume_stock(memcg, nr_pages))
+	if (consume_stock(memcg, nr_pages, &stock_batch))
 		return 0;
 
+	if (!batch) {
+		batch = stock_batch;
+		/* close to the limit a big stock only steals from other cpus */
+		if (batch > CHARGE_BATCH &&
+		    mem_cgroup_margin(memcg) < batch * num_online_cpus())
+			batch = CHARGE_BATCH;
+		batch = max(batch, nr_pages);
+	}
+
 	if (!do_swap_account ||
 	    page_counter_try_charge(&memcg->memsw, batch, &counter)) {
 		if (page_counter_try_charge(&memcg->memory, batch, &counter))
@@ -2148,6 +2254,7 @@ force:
 	 * being freed very soon.  Allow memory usage go over the limit
 	 * temporarily by force charging it.
 	 */
+	memcg_charge_stat_inc(MEMCG_CHARGE_COUNTER);
 	page_counter_charge(&memcg->memory, nr_pages);
 	if (do_swap_account)
 		page_counter_charge(&memcg->memsw, nr_pages);
@@ -2156,6 +2263,7 @@ force:
 	return 0;
 
 done_restock:
+	memcg_charge_stat_inc(MEMCG_CHARGE_COUNTER);
 	css_get_many(&memcg->css, batch);
 	if (batch > nr_pages)
 		refill_stock(memcg, batch - nr_pages);
@@ -3296,6 +3404,46 @@ static int mem_cgroup_swappiness_write(struct cgroup_subsys_state *css,
 	return 0;
 }
 
+static u64 mem_cgroup_reclaim_priority_read(struct cgroup_subsys_state *css,
+					     struct cftype *cft)
+{
+	return mem_cgroup_from_css(css)->reclaim_priority;
+}
+
+static int mem_cgroup_reclaim_priority_write(struct cgroup_subsys_state *css,
+					     struct cftype *cft, u64 val)
+{
+	if (val > DEF_PRIORITY)
+		return -EINVAL;
+
+	WRITE_ONCE(mem_cgroup_from_css(css)->reclaim_priority, val);
+	return 0;
+}
+
+static int memcg_charge_stat_show(struct seq_file *m, void *v)
+{
+	unsigned long stocked = 0;
+	int cpu, i;
+
+	for (i = 0; i < MEMCG_CHARGE_NSTATS; i++) {
+		unsigned long val = 0;
+
+		for_each_possible_cpu(cpu)
+			val += per_cpu(memcg_charge_stat, cpu).count[i];
+		seq_printf(m, "%s %lu\n", memcg_charge_stat_names[i], val);
+	}
+
+	for_each_online_cpu(cpu) {
+		struct memcg_stock_pcp *stock = &per_cpu(memcg_stock, cpu);
+
+		for (i = 0; i < MEMCG_STOCK_SLOTS; i++)
+			stocked += READ_ONCE(stock->slots[i].nr_pages);
+	}
+	seq_printf(m, "stock_pages %lu\n", stocked);
+
+	return 0;
+}
+
 static void __mem_cgroup_threshold(struct mem_cgroup *memcg, bool swap)
 {
 	struct mem_cgroup_threshold_ary *t;
@@ -4100,6 +4248,17 @@ static struct cftype mem_cgroup_legacy_files[] = {
 		.read_u64 = mem_cgroup_swappiness_read,
 		.write_u64 = mem_cgroup_swappiness_write,
 	},
+	{
+		.name = "reclaim_priority",
+		.read_u64 = mem_cgroup_reclaim_priority_read,
+		.write_u64 = mem_cgroup_reclaim_priority_write,
+		.flags = CFTYPE_NOT_ON_ROOT,
+	},
+	{
+		.name = "charge_stat",
+		.seq_show = memcg_charge_stat_show,
+		.flags = CFTYPE_ONLY_ON_ROOT,
+	},
 	{
 		.name = "move_charge_at_immigrate",
 		.read_u64 = mem_cgroup_move_charge_read,
@@ -5383,6 +5542,32 @@ struct cgroup_subsys memory_cgrp_subsys = {
 	.early_init = 0,
 };
 
+/**
+ * mem_cgroup_reclaim_deferred - check if global reclaim should pass a group by
+ * @memcg: the memory cgroup to check
+ * @priority: the scan priority of the reclaimer
+ *
+ * A group whose memory.reclaim_priority, or that of one of its ancestors, is
+ * N is left alone by the first N priority levels of global reclaim, so that
+ * background groups are scanned before the foreground app loses its pages.
+ */
+bool mem_cgroup_reclaim_deferred(struct mem_cgroup *memcg, int priority)
+{
+	int passes = DEF_PRIORITY - priority;
+
+	if (mem_cgroup_disabled())
+		return false;
+
+	for (; memcg && memcg != root_mem_cgroup;
+	     memcg = parent_mem_cgroup(memcg)) {
+		if (READ_ONCE(memcg->reclaim_priority) > passes) {
+			memcg_charge_stat_inc(MEMCG_CHARGE_RECLAIM_DEFERRED);
+			return true;
+		}
+	}
+	return false;
+}
+
 /**
  * mem_cgroup_low - check if memory consumption is below the normal range
  * @root: the highest ancestor to consider
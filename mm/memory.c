@@ -62,6 +62,7 @@
 #include <linux/dma-debug.h>
 #include <linux/debugfs.h>
 #include <linux/userfaultfd_k.h>
+#include <linux/prezero.h>
 
 #include <asm/io.h>
 #include <asm/pgalloc.h>
@@ -2199,7 +2200,7 @@ static int wp_page_copy(struct mm_struct *mm, struct vm_area_struct *vma,
 		goto oom;
 
 	if (is_zero_pfn(pte_pfn(orig_pte))) {
-		new_page = alloc_zeroed_user_highpage_movable(vma, address);
+		new_page = alloc_prezeroed_user_highpage_movable(vma, address);
 		if (!new_page)
 			goto oom;
 		uksm_cow_pte(vma, orig_pte);
@@ -2789,7 +2790,7 @@ static int do_anonymous_page(struct mm_struct *mm, struct vm_area_struct *vma,
 	/* Allocate our own private page. */
 	if (unlikely(anon_vma_prepare(vma)))
 		goto oom;
-	page = alloc_zeroed_user_highpage_movable(vma, address);
+	page = alloc_prezeroed_user_highpage_movable(vma, address);
 	if (!page)
 		goto oom;
 
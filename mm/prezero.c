@@ -0,0 +1,261 @@
+/*
+ * linux/mm/prezero.c
+ *
+ * Pool of pre-zeroed pages
+ *
+ * Anonymous faults clear the page they allocate on the faulting cpu, which
+ * is often an app's UI thread. Keep up to pool_pages order-0 pages cleared
+ * ahead of time instead, by a SCHED_IDLE kthread bound to the cluster of
+ * cpu0, which is the LITTLE one on our big.LITTLE parts. The thread starts
+ * refilling once the pool drops below low_pages, only while every zone is
+ * above its high watermark, and pooled pages are handed back through a
+ * shrinker as soon as reclaim needs memory, after which refilling is held
+ * off for PREZERO_BACKOFF.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#include <linux/freezer.h>
+#include <linux/gfp.h>
+#include <linux/highmem.h>
+#include <linux/kthread.h>
+#include <linux/mm.h>
+#include <linux/mmzone.h>
+#include <linux/moduleparam.h>
+#include <linux/prezero.h>
+#include <linux/sched.h>
+#include <linux/shrinker.h>
+#include <linux/topology.h>
+
+#define PREZERO_BATCH		32
+#define PREZERO_RETRY		(5 * HZ)
+#define PREZERO_BACKOFF		(10 * HZ)
+
+/*
+ * Pooled pages are not on the LRU and cannot be migrated, so keep them out
+ * of CMA areas, and do not reclaim for them.
+ */
+#define PREZERO_GFP	((GFP_HIGHUSER_MOVABLE & ~(__GFP_CMA | __GFP_RECLAIM)) | \
+			 __GFP_NOWARN)
+
+static unsigned int prezero_pool_pages;
+static unsigned int prezero_low_pages;
+module_param_named(low_pages, prezero_low_pages, uint, 0644);
+static unsigned long prezero_hits;
+module_param_named(hits, prezero_hits, ulong, 0444);
+static unsigned long prezero_misses;
+module_param_named(misses, prezero_misses, ulong, 0444);
+
+static LIST_HEAD(prezero_pool);
+static unsigned int prezero_pool_size;
+static DEFINE_SPINLOCK(prezero_pool_lock); /* protects the above */
+static unsigned long prezero_next_fill; /* jiffies */
+static DECLARE_WAIT_QUEUE_HEAD(prezero_wait);
+
+static bool prezero_want_fill(void)
+{
+	unsigned int size = READ_ONCE(prezero_pool_size);
+
+	return size < READ_ONCE(prezero_pool_pages) &&
+	       size <= READ_ONCE(prezero_low_pages);
+}
+
+/**
+ * prezero_page_get - take a zeroed order-0 page from the pool
+ *
+ * Returns a page as alloc_page() would, or NULL if the pool is empty.
+ */
+struct page *prezero_page_get(void)
+{
+	struct page *page = NULL;
+
+	if (!READ_ONCE(prezero_pool_pages))
+		return NULL;
+
+	spin_lock(&prezero_pool_lock);
+	if (prezero_pool_size) {
+		page = list_first_entry(&prezero_pool, struct page, lru);
+		list_del(&page->lru);
+		prezero_pool_size--;
+		prezero_hits++;
+	} else {
+		prezero_misses++;
+	}
+	spin_unlock(&prezero_pool_lock);
+
+	if (prezero_want_fill() && waitqueue_active(&prezero_wait))
+		wake_up(&prezero_wait);
+
+	return page;
+}
+EXPORT_SYMBOL_GPL(prezero_page_get);
+
+/* decline to fill while any reclaim is going on */
+static bool prezero_can_fill(void)
+{
+	struct zone *zone;
+	unsigned long mark;
+
+	if (time_before(jiffies, prezero_next_fill))
+		return false;
+
+	for_each_populated_zone(zone) {
+		mark = high_wmark_pages(zone) + PREZERO_BATCH;
+		if (!zone_watermark_ok(zone, 0, mark, 0, 0))
+			return false;
+	}
+
+	return true;
+}
+
+/* returns the number of pages added to the pool */
+static int prezero_fill(void)
+{
+	LIST_HEAD(pages);
+	int nr = (int)READ_ONCE(prezero_pool_pages) -
+		 (int)READ_ONCE(prezero_pool_size);
+	int i;
+
+	nr = min(nr, PREZERO_BATCH);
+	for (i = 0; i < nr; i++) {
+		struct page *page = alloc_page(PREZERO_GFP);
+
+		if (!page)
+			break;
+		clear_highpage(page);
+		list_add(&page->lru, &pages);
+		cond_resched();
+	}
+
+	if (i) {
+		spin_lock(&prezero_pool_lock);
+		list_splice(&pages, &prezero_pool);
+		prezero_pool_size += i;
+		spin_unlock(&prezero_pool_lock);
+	}
+
+	return i;
+}
+
+static int prezero_thread(void *data)
+{
+	struct sched_param param = { .sched_priority = 0 };
+
+	set_freezable();
+	sched_setscheduler_nocheck(current, SCHED_IDLE, &param);
+	set_cpus_allowed_ptr(current, cpu_coregroup_mask(0));
+
+	while (!kthread_should_stop()) {
+		wait_event_freezable(prezero_wait,
+				prezero_want_fill() || kthread_should_stop());
+
+		/* once started, top the pool up rather than to low_pages */
+		while (READ_ONCE(prezero_pool_size) <
+		       READ_ONCE(prezero_pool_pages) &&
+		       !kthread_should_stop()) {
+			if (!prezero_can_fill() || !prezero_fill()) {
+				freezable_schedule_timeout_interruptible(
+							PREZERO_RETRY);
+				break;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* give pages beyond @keep back to the page allocator */
+static unsigned long prezero_drain(unsigned int keep, unsigned long nr_pages)
+{
+	struct page *page;
+	unsigned long freed = 0;
+
+	while (freed < nr_pages) {
+		spin_lock(&prezero_pool_lock);
+		if (prezero_pool_size <= keep) {
+			spin_unlock(&prezero_pool_lock);
+			break;
+		}
+		page = list_first_entry(&prezero_pool, struct page, lru);
+		list_del(&page->lru);
+		prezero_pool_size--;
+		spin_unlock(&prezero_pool_lock);
+
+		__free_page(page);
+		freed++;
+	}
+
+	return freed;
+}
+
+static unsigned long prezero_count(struct shrinker *s,
+				   struct shrink_control *sc)
+{
+	return READ_ONCE(prezero_pool_size);
+}
+
+static unsigned long prezero_scan(struct shrinker *s,
+				  struct shrink_control *sc)
+{
+	unsigned long freed;
+
+	prezero_next_fill = jiffies + PREZERO_BACKOFF;
+	freed = prezero_drain(0, sc->nr_to_scan);
+
+	return freed ? freed : SHRINK_STOP;
+}
+
+static struct shrinker prezero_shrinker = {
+	.count_objects = prezero_count,
+	.scan_objects = prezero_scan,
+	.seeks = DEFAULT_SEEKS,
+};
+
+static int prezero_pool_pages_set(const char *val,
+				  const struct kernel_param *kp)
+{
+	int ret = param_set_uint(val, kp);
+
+	if (ret)
+		return ret;
+
+	prezero_drain(prezero_pool_pages, ULONG_MAX);
+	wake_up(&prezero_wait);
+	return 0;
+}
+
+static const struct kernel_param_ops prezero_pool_pages_ops = {
+	.set = prezero_pool_pages_set,
+	.get = param_get_uint,
+};
+module_param_cb(pool_pages, &prezero_pool_pages_ops, &prezero_pool_pages,
+		0644);
+
+static int prezero_pool_size_get(char *buf, const struct kernel_param *kp)
+{
+	return sprintf(buf, "%u\n", READ_ONCE(prezero_pool_size));
+}
+
+static const struct kernel_param_ops prezero_pool_size_ops = {
+	.get = prezero_pool_size_get,
+};
+module_param_cb(pool_size, &prezero_pool_size_ops, NULL, 0444);
+
+static int __init prezero_init(void)
+{
+	struct task_struct *task;
+
+	task = kthread_run(prezero_thread, NULL, "kprezerod");
+	if (IS_ERR(task)) {
+		pr_err("prezero: failed to start kprezerod (%ld)\n",
+		       PTR_ERR(task));
+		return 0;
+	}
+
+	register_shrinker(&prezero_shrinker);
+	return 0;
+}
+late_initcall(prezero_init);
@@ -376,6 +376,85 @@ static int try_context_readahead(struct address_space *mapping,
 	return 1;
 }
 
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+#define RA_SMALL_KB		16	/* requests up to this size are small */
+#define RA_LARGE_KB		64	/* and from this size large */
+#define RA_MIN_SAMPLES		8	/* of each before trusting the model */
+#define RA_UPDATE_SAMPLES	32	/* resize windows every so many reads */
+#define RA_ADAPTIVE_MIN_KB	32
+#define RA_ADAPTIVE_MAX_KB	2048
+
+/*
+ * With a request costing overhead + size / bandwidth, readahead of size
+ * W reaches W / (W + O) of the bandwidth, O being the amount of data the
+ * device could have transferred during the overhead. Aim the maximum
+ * window at ra_target percent, and start at O, half the bandwidth.
+ */
+static void bdi_ra_update(struct backing_dev_info *bdi)
+{
+	struct bdi_ra_model *m = &bdi->ra_model;
+	long sk, su, lk, lu, over_kb, max_kb, init_kb;
+	unsigned int target = READ_ONCE(bdi->ra_target);
+
+	if (m->nr_small < RA_MIN_SAMPLES || m->nr_large < RA_MIN_SAMPLES)
+		return;
+
+	sk = ewma_bdi_ra_read(&m->small_kb);
+	su = ewma_bdi_ra_read(&m->small_us);
+	lk = ewma_bdi_ra_read(&m->large_kb);
+	lu = ewma_bdi_ra_read(&m->large_us);
+	if (lk <= sk || lu <= su)
+		return;
+
+	over_kb = (su * (lk - sk) - (lu - su) * sk) / (lu - su);
+	over_kb = max(over_kb, 1L);
+	max_kb = over_kb * target / (100 - target);
+	max_kb = clamp(max_kb, (long)RA_ADAPTIVE_MIN_KB,
+		       (long)RA_ADAPTIVE_MAX_KB);
+	init_kb = clamp(over_kb, (long)RA_ADAPTIVE_MIN_KB, max_kb);
+
+	WRITE_ONCE(bdi->ra_max_pages, max_kb >> (PAGE_SHIFT - 10));
+	WRITE_ONCE(bdi->ra_init_pages, init_kb >> (PAGE_SHIFT - 10));
+}
+
+/**
+ * bdi_ra_sample - account a completed read for the readahead model
+ * @bdi: backing device the read was for
+ * @bytes: size of the read
+ * @ns: time from dispatch to completion
+ *
+ * May be called from interrupt context.
+ */
+void bdi_ra_sample(struct backing_dev_info *bdi, unsigned int bytes, u64 ns)
+{
+	struct bdi_ra_model *m = &bdi->ra_model;
+	unsigned long kb = bytes >> 10;
+	unsigned long us = div_u64(ns, NSEC_PER_USEC);
+	unsigned long flags;
+
+	if (kb > RA_SMALL_KB && kb < RA_LARGE_KB)
+		return;
+
+	spin_lock_irqsave(&m->lock, flags);
+	if (kb <= RA_SMALL_KB) {
+		ewma_bdi_ra_add(&m->small_kb, kb);
+		ewma_bdi_ra_add(&m->small_us, us);
+		if (m->nr_small < RA_MIN_SAMPLES)
+			m->nr_small++;
+	} else {
+		ewma_bdi_ra_add(&m->large_kb, kb);
+		ewma_bdi_ra_add(&m->large_us, us);
+		if (m->nr_large < RA_MIN_SAMPLES)
+			m->nr_large++;
+	}
+	if (++m->nr_samples >= RA_UPDATE_SAMPLES) {
+		m->nr_samples = 0;
+		bdi_ra_update(bdi);
+	}
+	spin_unlock_irqrestore(&m->lock, flags);
+}
+#endif
+
 /*
  * A minimal readahead algorithm for trivial sequential/random reads.
  */
@@ -387,9 +466,19 @@ ondemand_readahead(struct address_space *mapping,
 {
 	struct backing_dev_info *bdi = inode_to_bdi(mapping->host);
 	unsigned long max_pages = ra->ra_pages;
+	unsigned long init_pages = 0;
 	unsigned long add_pages;
 	pgoff_t prev_offset;
 
+#ifdef CONFIG_READAHEAD_ADAPTIVE
+	/* windows not set up through fadvise follow the device */
+	if (READ_ONCE(bdi->ra_adaptive) && ra->ra_pages == bdi->ra_pages &&
+	    READ_ONCE(bdi->ra_max_pages)) {
+		max_pages = READ_ONCE(bdi->ra_max_pages);
+		init_pages = min(READ_ONCE(bdi->ra_init_pages), max_pages);
+	}
+#endif
+
 	/*
 	 * If the request exceeds the readahead window, allow the read to
 	 * be up to the optimal hardware IO size
@@ -469,7 +558,7 @@ ondemand_readahead(struct address_space *mapping,
 
 initial_readahead:
 	ra->start = offset;
-	ra->size = get_init_ra_size(req_size, max_pages);
+	ra->size = max(get_init_ra_size(req_size, max_pages), init_pages);
 	ra->async_size = ra->size > req_size ? ra->size - req_size : ra->size;
 
 readit:
@@ -34,6 +34,7 @@
 #include <linux/stacktrace.h>
 #include <linux/prefetch.h>
 #include <linux/memcontrol.h>
+#include <linux/sched.h>
 #ifdef CONFIG_SEC_DEBUG_AUTO_SUMMARY
 #include <linux/sec_debug.h>
 #endif
@@ -2814,6 +2815,212 @@ static void *__slab_alloc(struct kmem_cache *s, gfp_t gfpflags, int node,
 	return p;
 }
 
+/*
+ * Allocate up to @size objects without the alloc hooks, which are the
+ * caller's business. Returns how many were allocated.
+ */
+static int slab_alloc_batch(struct kmem_cache *s, gfp_t flags, size_t size,
+			    void **p)
+{
+	struct kmem_cache_cpu *c;
+	unsigned long irqflags;
+	LIST_HEAD(to_free);
+	int i;
+
+	/*
+	 * Drain objects in the per cpu slab, while disabling local
+	 * IRQs, which protects against PREEMPT and interrupts
+	 * handlers invoking normal fastpath.
+	 */
+	local_irq_save(irqflags);
+	c = this_cpu_ptr(s->cpu_slab);
+
+	for (i = 0; i < size; i++) {
+		void *object = c->freelist;
+
+		if (unlikely(!object)) {
+			/*
+			 * We may have removed an object from c->freelist using
+			 * the fastpath in the previous iteration; in that case,
+			 * c->tid has not been bumped yet.
+			 * Since ___slab_alloc() may reenable interrupts while
+			 * allocating memory, we should bump c->tid now.
+			 */
+			c->tid = next_tid(c->tid);
+
+			/*
+			 * Invoking slow path likely have side-effect
+			 * of re-populating per CPU c->freelist
+			 */
+			p[i] = ___slab_alloc(s, flags, NUMA_NO_NODE,
+					    _RET_IP_, c, &to_free);
+			if (unlikely(!p[i]))
+				goto out;
+
+			c = this_cpu_ptr(s->cpu_slab);
+			continue; /* goto for-loop */
+		}
+		c->freelist = get_freepointer(s, object);
+		p[i] = object;
+	}
+	c->tid = next_tid(c->tid);
+out:
+	local_irq_restore(irqflags);
+	free_delayed(&to_free);
+
+	return i;
+}
+
+#ifdef CONFIG_SLUB_MAGAZINE
+#define SLUB_MAGAZINE_MAX	64
+#define SLUB_MAGAZINE_BATCH_MAX	16
+
+/*
+ * A magazine holds objects that are free as far as the cache users are
+ * concerned, but allocated as far as the slabs are: they have been through
+ * the free hooks and will go through the alloc hooks again when handed out.
+ * It is only accessed by its cpu with interrupts disabled.
+ */
+struct slub_magazine {
+	unsigned int count;
+	void *objects[SLUB_MAGAZINE_MAX];
+};
+
+static void magazine_flush(struct kmem_cache *s, void **objects, int nr);
+
+static void *magazine_alloc(struct kmem_cache *s, gfp_t gfpflags)
+{
+	void *batch[SLUB_MAGAZINE_BATCH_MAX];
+	struct slub_magazine *m;
+	unsigned long flags;
+	void *object;
+	int nr, room;
+
+	local_irq_save(flags);
+	m = this_cpu_ptr(s->magazine);
+	if (likely(m->count)) {
+		object = m->objects[--m->count];
+		local_irq_restore(flags);
+		stat(s, MAGAZINE_ALLOC);
+		return object;
+	}
+	local_irq_restore(flags);
+
+	nr = slab_alloc_batch(s, gfpflags, READ_ONCE(s->magazine_batch), batch);
+	if (!nr)
+		return NULL;
+	stat(s, MAGAZINE_REFILL);
+	object = batch[--nr];
+
+	/* we may have been moved or interrupted while allocating */
+	local_irq_save(flags);
+	m = this_cpu_ptr(s->magazine);
+	room = (int)READ_ONCE(s->magazine_size) - (int)m->count;
+	room = clamp(room, 0, nr);
+	memcpy(&m->objects[m->count], batch, room * sizeof(void *));
+	m->count += room;
+	local_irq_restore(flags);
+
+	if (unlikely(room < nr))
+		magazine_flush(s, batch + room, nr - room);
+
+	return object;
+}
+
+static bool magazine_free(struct kmem_cache *s, void *object)
+{
+	void *batch[SLUB_MAGAZINE_BATCH_MAX];
+	struct slub_magazine *m;
+	unsigned long flags;
+	unsigned int size;
+	int nr = 0;
+
+	local_irq_save(flags);
+	size = READ_ONCE(s->magazine_size);
+	if (unlikely(!size)) {
+		local_irq_restore(flags);
+		return false;
+	}
+
+	m = this_cpu_ptr(s->magazine);
+	if (unlikely(m->count >= size)) {
+		nr = min(READ_ONCE(s->magazine_batch), m->count);
+		m->count -= nr;
+		memcpy(batch, &m->objects[m->count], nr * sizeof(void *));
+	}
+	m->objects[m->count++] = object;
+	local_irq_restore(flags);
+
+	stat(s, MAGAZINE_FREE);
+	if (nr) {
+		stat(s, MAGAZINE_FLUSH);
+		magazine_flush(s, batch, nr);
+	}
+
+	return true;
+}
+
+/* Called with interrupts disabled, on @cpu or after it went offline */
+static void magazine_drain_cpu(struct kmem_cache *s, int cpu)
+{
+	struct slub_magazine *m;
+
+	if (!s->magazine)
+		return;
+
+	m = per_cpu_ptr(s->magazine, cpu);
+	magazine_flush(s, m->objects, m->count);
+	m->count = 0;
+}
+
+static void magazine_drain_local(void *d)
+{
+	magazine_drain_cpu(d, smp_processor_id());
+}
+
+static void magazine_drain(struct kmem_cache *s)
+{
+	if (s->magazine)
+		on_each_cpu(magazine_drain_local, s, 1);
+}
+
+static void magazine_release(struct kmem_cache *s)
+{
+	free_percpu(s->magazine);
+	s->magazine = NULL;
+}
+#else
+static inline void magazine_drain_cpu(struct kmem_cache *s, int cpu) { }
+static inline void magazine_drain(struct kmem_cache *s) { }
+static inline void magazine_release(struct kmem_cache *s) { }
+#endif /* CONFIG_SLUB_MAGAZINE */
+
+#ifdef CONFIG_SLUB_STATS
+static inline u64 alloc_latency_start(struct kmem_cache *s)
+{
+	return unlikely(READ_ONCE(s->alloc_latency)) ? local_clock() : 0;
+}
+
+static inline void alloc_latency_end(struct kmem_cache *s, u64 start)
+{
+	int bucket;
+
+	if (likely(!start))
+		return;
+
+	bucket = ilog2((local_clock() - start) | 1) - 7;
+	bucket = clamp(bucket, 0, SLUB_ALLOC_LAT_BUCKETS - 1);
+	raw_cpu_inc(s->cpu_slab->alloc_lat[bucket]);
+}
+#else
+static inline u64 alloc_latency_start(struct kmem_cache *s)
+{
+	return 0;
+}
+
+static inline void alloc_latency_end(struct kmem_cache *s, u64 start) { }
+#endif
+
 /*
  * Inlined fastpath so that allocation functions (kmalloc, kmem_cache_alloc)
  * have the fastpath folded into their functions. So no function call
@@ -2831,10 +3038,19 @@ static __always_inline void *slab_alloc_node(struct kmem_cache *s,
 	struct kmem_cache_cpu *c;
 	struct page *page;
 	unsigned long tid;
+	u64 start;
 
 	s = slab_pre_alloc_hook(s, gfpflags);
 	if (!s)
 		return NULL;
+	start = alloc_latency_start(s);
+#ifdef CONFIG_SLUB_MAGAZINE
+	if (READ_ONCE(s->magazine_size) && node == NUMA_NO_NODE) {
+		object = magazine_alloc(s, gfpflags);
+		if (likely(object))
+			goto out;
+	}
+#endif
 redo:
 	/*
 	 * Must read kmem_cache cpu data via this cpu ptr. Preemption is
@@ -2902,6 +3118,10 @@ redo:
 		prefetch_freepointer(s, next_object);
 		stat(s, ALLOC_FASTPATH);
 	}
+#ifdef CONFIG_SLUB_MAGAZINE
+out:
+#endif
+	alloc_latency_end(s, start);
 
 	if (unlikely(gfpflags & __GFP_ZERO) && object)
 		memset(object, 0, s->object_size);
@@ -3160,9 +3380,24 @@ static __always_inline void slab_free(struct kmem_cache *s, struct page *page,
 	 */
 	if (s->flags & SLAB_KASAN && !(s->flags & SLAB_DESTROY_BY_RCU))
 		return;
+#ifdef CONFIG_SLUB_MAGAZINE
+	if (!tail && READ_ONCE(s->magazine_size) && magazine_free(s, head))
+		return;
+#endif
 	do_slab_free(s, page, head, tail, cnt, addr);
 }
 
+#ifdef CONFIG_SLUB_MAGAZINE
+static void magazine_flush(struct kmem_cache *s, void **objects, int nr)
+{
+	int i;
+
+	for (i = 0; i < nr; i++)
+		do_slab_free(s, virt_to_head_page(objects[i]), objects[i],
+			     NULL, 1, _RET_IP_);
+}
+#endif
+
 #ifdef CONFIG_KASAN
 void ___cache_free(struct kmem_cache *cache, void *x, unsigned long addr)
 {
@@ -3278,53 +3513,16 @@ EXPORT_SYMBOL(kmem_cache_free_bulk);
 int kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
 			  void **p)
 {
-	struct kmem_cache_cpu *c;
-	LIST_HEAD(to_free);
 	int i;
 
 	/* memcg and kmem_cache debug support */
 	s = slab_pre_alloc_hook(s, flags);
 	if (unlikely(!s))
 		return false;
-	/*
-	 * Drain objects in the per cpu slab, while disabling local
-	 * IRQs, which protects against PREEMPT and interrupts
-	 * handlers invoking normal fastpath.
-	 */
-	local_irq_disable();
-	c = this_cpu_ptr(s->cpu_slab);
-
-	for (i = 0; i < size; i++) {
-		void *object = c->freelist;
-
-		if (unlikely(!object)) {
-			/*
-			 * We may have removed an object from c->freelist using
-			 * the fastpath in the previous iteration; in that case,
-			 * c->tid has not been bumped yet.
-			 * Since ___slab_alloc() may reenable interrupts while
-			 * allocating memory, we should bump c->tid now.
-			 */
-			c->tid = next_tid(c->tid);
-
-			/*
-			 * Invoking slow path likely have side-effect
-			 * of re-populating per CPU c->freelist
-			 */
-			p[i] = ___slab_alloc(s, flags, NUMA_NO_NODE,
-					    _RET_IP_, c, &to_free);
-			if (unlikely(!p[i]))
-				goto error;
 
-			c = this_cpu_ptr(s->cpu_slab);
-			continue; /* goto for-loop */
-		}
-		c->freelist = get_freepointer(s, object);
-		p[i] = object;
-	}
-	c->tid = next_tid(c->tid);
-	local_irq_enable();
-	free_delayed(&to_free);
+	i = slab_alloc_batch(s, flags, size, p);
+	if (unlikely(i < size))
+		goto error;
 
 	/* Clear memory outside IRQ disabled fastpath loop */
 	if (unlikely(flags & __GFP_ZERO)) {
@@ -3338,8 +3536,6 @@ int kmem_cache_alloc_bulk(struct kmem_cache *s, gfp_t flags, size_t size,
 	slab_post_alloc_hook(s, flags, size, p);
 	return i;
 error:
-	local_irq_enable();
-	free_delayed(&to_free);
 	slab_post_alloc_hook(s, flags, i, p);
 	__kmem_cache_free_bulk(s, i, p);
 	return 0;
@@ -3853,6 +4049,7 @@ static inline int kmem_cache_close(struct kmem_cache *s)
 	int node;
 	struct kmem_cache_node *n;
 
+	magazine_drain(s);
 	flush_all(s);
 	/* Attempt to free all objects */
 	for_each_kmem_cache_node(s, node, n) {
@@ -3860,6 +4057,7 @@ static inline int kmem_cache_close(struct kmem_cache *s)
 		if (n->nr_partial || slabs_node(s, node))
 			return 1;
 	}
+	magazine_release(s);
 	free_percpu(s->cpu_slab);
 	free_kmem_cache_nodes(s);
 	return 0;
@@ -4082,6 +4280,7 @@ int __kmem_cache_shrink(struct kmem_cache *s, bool deactivate)
 	unsigned long flags;
 	int ret = 0;
 
+	magazine_drain(s);
 	if (deactivate) {
 		/*
 		 * Disable empty slabs caching. Used to avoid pinning offline
@@ -4437,6 +4636,7 @@ static int slab_cpuup_callback(struct notifier_block *nfb,
 		mutex_lock(&slab_mutex);
 		list_for_each_entry(s, &slab_caches, list) {
 			local_irq_save(flags);
+			magazine_drain_cpu(s, cpu);
 			__flush_cpu_slab(s, cpu);
 			local_irq_restore(flags);
 		}
@@ -5132,6 +5332,68 @@ static ssize_t cpu_partial_store(struct kmem_cache *s, const char *buf,
 }
 SLAB_ATTR(cpu_partial);
 
+#ifdef CONFIG_SLUB_MAGAZINE
+static ssize_t magazine_size_show(struct kmem_cache *s, char *buf)
+{
+	return sprintf(buf, "%u\n", s->magazine_size);
+}
+
+static ssize_t magazine_size_store(struct kmem_cache *s, const char *buf,
+				   size_t length)
+{
+	unsigned int size;
+	int err;
+
+	err = kstrtouint(buf, 10, &size);
+	if (err)
+		return err;
+	if (size > SLUB_MAGAZINE_MAX)
+		return -EINVAL;
+	if (size && (kmem_cache_debug(s) || s->flags & SLAB_DESTROY_BY_RCU))
+		return -EINVAL;
+
+	if (size && !s->magazine) {
+		struct slub_magazine __percpu *m;
+
+		m = alloc_percpu(struct slub_magazine);
+		if (!m)
+			return -ENOMEM;
+		/* published before any size that makes it used */
+		if (cmpxchg(&s->magazine, NULL, m))
+			free_percpu(m);
+	}
+	if (!s->magazine_batch)
+		s->magazine_batch = SLUB_MAGAZINE_BATCH_MAX / 2;
+
+	WRITE_ONCE(s->magazine_size, size);
+	magazine_drain(s);
+	return length;
+}
+SLAB_ATTR(magazine_size);
+
+static ssize_t magazine_batch_show(struct kmem_cache *s, char *buf)
+{
+	return sprintf(buf, "%u\n", s->magazine_batch);
+}
+
+static ssize_t magazine_batch_store(struct kmem_cache *s, const char *buf,
+				    size_t length)
+{
+	unsigned int batch;
+	int err;
+
+	err = kstrtouint(buf, 10, &batch);
+	if (err)
+		return err;
+	if (!batch || batch > SLUB_MAGAZINE_BATCH_MAX)
+		return -EINVAL;
+
+	WRITE_ONCE(s->magazine_batch, batch);
+	return length;
+}
+SLAB_ATTR(magazine_batch);
+#endif
+
 static ssize_t ctor_show(struct kmem_cache *s, char *buf)
 {
 	if (!s->ctor)
@@ -5535,6 +5797,46 @@ STAT_ATTR(CPU_PARTIAL_ALLOC, cpu_partial_alloc);
 STAT_ATTR(CPU_PARTIAL_FREE, cpu_partial_free);
 STAT_ATTR(CPU_PARTIAL_NODE, cpu_partial_node);
 STAT_ATTR(CPU_PARTIAL_DRAIN, cpu_partial_drain);
+STAT_ATTR(MAGAZINE_ALLOC, magazine_alloc);
+STAT_ATTR(MAGAZINE_FREE, magazine_free);
+STAT_ATTR(MAGAZINE_REFILL, magazine_refill);
+STAT_ATTR(MAGAZINE_FLUSH, magazine_flush);
+
+static ssize_t alloc_latency_show(struct kmem_cache *s, char *buf)
+{
+	int cpu, i, len = 0;
+
+	for (i = 0; i < SLUB_ALLOC_LAT_BUCKETS; i++) {
+		unsigned long sum = 0;
+
+		for_each_online_cpu(cpu)
+			sum += per_cpu_ptr(s->cpu_slab, cpu)->alloc_lat[i];
+		len += sprintf(buf + len, "%s%lu", i ? " " : "", sum);
+	}
+
+	return len + sprintf(buf + len, "\n");
+}
+
+/* 1 clears the histogram and starts filling it, 0 stops */
+static ssize_t alloc_latency_store(struct kmem_cache *s, const char *buf,
+				   size_t length)
+{
+	int cpu, enable, err;
+
+	err = kstrtoint(buf, 10, &enable);
+	if (err)
+		return err;
+
+	WRITE_ONCE(s->alloc_latency, 0);
+	if (enable) {
+		for_each_online_cpu(cpu)
+			memset(per_cpu_ptr(s->cpu_slab, cpu)->alloc_lat, 0,
+			       sizeof(s->cpu_slab->alloc_lat));
+		WRITE_ONCE(s->alloc_latency, 1);
+	}
+	return length;
+}
+SLAB_ATTR(alloc_latency);
 #endif
 
 static struct attribute *slab_attrs[] = {
@@ -5557,6 +5859,10 @@ static struct attribute *slab_attrs[] = {
 	&shrink_attr.attr,
 	&reserved_attr.attr,
 	&slabs_cpu_partial_attr.attr,
+#ifdef CONFIG_SLUB_MAGAZINE
+	&magazine_size_attr.attr,
+	&magazine_batch_attr.attr,
+#endif
 #ifdef CONFIG_SLUB_DEBUG
 	&total_objects_attr.attr,
 	&slabs_attr.attr,
@@ -5602,6 +5908,11 @@ static struct attribute *slab_attrs[] = {
 	&cpu_partial_free_attr.attr,
 	&cpu_partial_node_attr.attr,
 	&cpu_partial_drain_attr.attr,
+	&magazine_alloc_attr.attr,
+	&magazine_free_attr.attr,
+	&magazine_refill_attr.attr,
+	&magazine_flush_attr.attr,
+	&alloc_latency_attr.attr,
 #endif
 #ifdef CONFIG_FAILSLAB
 	&failslab_attr.attr,
@@ -69,6 +69,8 @@
 #include <linux/gcd.h>
 #include <linux/freezer.h>
 #include <linux/sradix-tree.h>
+#include <linux/cpumask.h>
+#include <linux/fb.h>
 
 #include <asm/tlbflush.h>
 #include "internal.h"
@@ -516,6 +518,27 @@ static unsigned int uksm_sleep_saved;
 /* Max percentage of cpu utilization ksmd can take to scan in one batch */
 static unsigned int uksm_max_cpu_percentage;
 
+/*
+ * On top of the ladder's cpu ratios, uksmd scans for at most
+ * uksm_cpu_budget_msecs of cpu time in each second, 0 for no budget.
+ */
+static unsigned int uksm_cpu_budget_msecs;
+static unsigned long uksm_budget_start;	/* jiffies the second began */
+static u64 uksm_budget_used;		/* ns scanned in that second */
+
+/* cpus uksmd may run on */
+static struct cpumask uksm_cpus;
+
+/* with uksm_idle_only set, uksmd only scans while the display is off */
+static bool uksm_idle_only;
+static bool uksm_display_on = true;
+
+/* cpu time spent scanning and the pages merged meanwhile */
+static u64 uksm_scan_cpu_ns;
+static unsigned long uksm_pages_merged;
+
+static struct task_struct *uksm_thread;
+
 static int uksm_cpu_governor;
 
 static char *uksm_cpu_governor_str[4] = { "full", "medium", "low", "quiet" };
@@ -2522,6 +2545,7 @@ static void stable_tree_append(struct rmap_item *rmap_item,
 		goto node_vma_new;
 	} else {
 		uksm_pages_sharing++;
+		uksm_pages_merged++;
 	}
 
 	hlist_for_each_entry(node_vma, &stable_node->hlist, hlist) {
@@ -4615,25 +4639,57 @@ rm_slot:
 
 static int ksmd_should_run(void)
 {
+	if (uksm_idle_only && READ_ONCE(uksm_display_on))
+		return 0;
+
 	return uksm_run & UKSM_RUN_MERGE;
 }
 
+static void uksm_account_scan(u64 ns)
+{
+	uksm_scan_cpu_ns += ns;
+
+	if (time_after_eq(jiffies, uksm_budget_start + HZ)) {
+		uksm_budget_start = jiffies;
+		uksm_budget_used = 0;
+	}
+	uksm_budget_used += ns;
+}
+
+/* the ladder's sleep, stretched to the end of the second once over budget */
+static unsigned long uksm_next_sleep(void)
+{
+	unsigned long sleep = uksm_sleep_real;
+	unsigned long budget_end = uksm_budget_start + HZ;
+
+	if (uksm_cpu_budget_msecs &&
+	    uksm_budget_used >= (u64)uksm_cpu_budget_msecs * NSEC_PER_MSEC &&
+	    time_before(jiffies + sleep, budget_end))
+		sleep = budget_end - jiffies;
+
+	return sleep;
+}
+
 static int uksm_scan_thread(void *nothing)
 {
+	u64 start;
+
 	set_freezable();
 	set_user_nice(current, 5);
 
 	while (!kthread_should_stop()) {
 		mutex_lock(&uksm_thread_mutex);
 		if (ksmd_should_run()) {
+			start = task_sched_runtime(current);
 			uksm_do_scan();
+			uksm_account_scan(task_sched_runtime(current) - start);
 		}
 		mutex_unlock(&uksm_thread_mutex);
 
 		try_to_freeze();
 
 		if (ksmd_should_run()) {
-			schedule_timeout_interruptible(uksm_sleep_real);
+			schedule_timeout_interruptible(uksm_next_sleep());
 			uksm_sleep_times++;
 		} else {
 			wait_event_freezable(uksm_thread_wait,
@@ -5190,6 +5246,111 @@ static ssize_t sleep_times_show(struct kobject *kobj,
 }
 UKSM_ATTR_RO(sleep_times);
 
+static ssize_t cpu_budget_msecs_show(struct kobject *kobj,
+				     struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", uksm_cpu_budget_msecs);
+}
+
+static ssize_t cpu_budget_msecs_store(struct kobject *kobj,
+				      struct kobj_attribute *attr,
+				      const char *buf, size_t count)
+{
+	unsigned long msecs;
+	int err;
+
+	err = kstrtoul(buf, 10, &msecs);
+	if (err || msecs > MSEC_PER_SEC)
+		return -EINVAL;
+
+	uksm_cpu_budget_msecs = msecs;
+
+	return count;
+}
+UKSM_ATTR(cpu_budget_msecs);
+
+static ssize_t cpus_show(struct kobject *kobj,
+			 struct kobj_attribute *attr, char *buf)
+{
+	return cpumap_print_to_pagebuf(true, buf, &uksm_cpus);
+}
+
+static ssize_t cpus_store(struct kobject *kobj, struct kobj_attribute *attr,
+			  const char *buf, size_t count)
+{
+	struct cpumask cpus;
+	int err;
+
+	err = cpulist_parse(buf, &cpus);
+	if (err)
+		return err;
+
+	cpumask_and(&cpus, &cpus, cpu_possible_mask);
+	if (cpumask_empty(&cpus))
+		return -EINVAL;
+
+	err = set_cpus_allowed_ptr(uksm_thread, &cpus);
+	if (err)
+		return err;
+
+	cpumask_copy(&uksm_cpus, &cpus);
+
+	return count;
+}
+UKSM_ATTR(cpus);
+
+static ssize_t idle_only_show(struct kobject *kobj,
+			      struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", uksm_idle_only);
+}
+
+static ssize_t idle_only_store(struct kobject *kobj,
+			       struct kobj_attribute *attr,
+			       const char *buf, size_t count)
+{
+	bool idle_only;
+	int err;
+
+	err = strtobool(buf, &idle_only);
+	if (err)
+		return -EINVAL;
+
+	uksm_idle_only = idle_only;
+	wake_up_interruptible(&uksm_thread_wait);
+
+	return count;
+}
+UKSM_ATTR(idle_only);
+
+static ssize_t scan_cpu_msecs_show(struct kobject *kobj,
+				   struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%llu\n", div_u64(uksm_scan_cpu_ns, NSEC_PER_MSEC));
+}
+UKSM_ATTR_RO(scan_cpu_msecs);
+
+static ssize_t pages_merged_show(struct kobject *kobj,
+				 struct kobj_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%lu\n", uksm_pages_merged);
+}
+UKSM_ATTR_RO(pages_merged);
+
+/* pages merged per second of cpu time spent scanning */
+static ssize_t merged_per_cpu_sec_show(struct kobject *kobj,
+				       struct kobj_attribute *attr, char *buf)
+{
+	u64 msecs = div_u64(uksm_scan_cpu_ns, NSEC_PER_MSEC);
+
+	if (!msecs)
+		return sprintf(buf, "0\n");
+
+	return sprintf(buf, "%llu\n",
+		       div64_u64((u64)uksm_pages_merged * MSEC_PER_SEC, msecs));
+}
+UKSM_ATTR_RO(merged_per_cpu_sec);
+
 
 static struct attribute *uksm_attrs[] = {
 	&max_cpu_percentage_attr.attr,
@@ -5208,6 +5369,12 @@ static struct attribute *uksm_attrs[] = {
 	&abundant_threshold_attr.attr,
 	&cpu_ratios_attr.attr,
 	&eval_intervals_attr.attr,
+	&cpu_budget_msecs_attr.attr,
+	&cpus_attr.attr,
+	&idle_only_attr.attr,
+	&scan_cpu_msecs_attr.attr,
+	&pages_merged_attr.attr,
+	&merged_per_cpu_sec_attr.attr,
 	NULL,
 };
 
@@ -5440,9 +5607,31 @@ struct page *ksm_might_need_to_copy(struct page *page,
 	return new_page;
 }
 
+#ifdef CONFIG_FB
+static int uksm_fb_notifier_call(struct notifier_block *nb,
+				 unsigned long event, void *data)
+{
+	struct fb_event *evdata = data;
+	bool on;
+
+	if (event != FB_EVENT_BLANK || !evdata || !evdata->data)
+		return NOTIFY_DONE;
+
+	on = *(int *)evdata->data == FB_BLANK_UNBLANK;
+	WRITE_ONCE(uksm_display_on, on);
+	if (!on)
+		wake_up_interruptible(&uksm_thread_wait);
+
+	return NOTIFY_OK;
+}
+
+static struct notifier_block uksm_fb_notifier = {
+	.notifier_call = uksm_fb_notifier_call,
+};
+#endif
+
 static int __init uksm_init(void)
 {
-	struct task_struct *uksm_thread;
 	int err;
 
 	uksm_sleep_jiffies = msecs_to_jiffies(100);
@@ -5470,6 +5659,7 @@ static int __init uksm_init(void)
 		err = PTR_ERR(uksm_thread);
 		goto out_free;
 	}
+	cpumask_copy(&uksm_cpus, cpu_possible_mask);
 
 #ifdef CONFIG_SYSFS
 	err = sysfs_create_group(mm_kobj, &uksm_attr_group);
@@ -5489,6 +5679,9 @@ static int __init uksm_init(void)
 	 * later callbacks could only be taking locks which nest within that.
 	 */
 	hotplug_memory_notifier(uksm_memory_callback, 100);
+#endif
+#ifdef CONFIG_FB
+	fb_register_client(&uksm_fb_notifier);
 #endif
 	return 0;
 
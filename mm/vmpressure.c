@@ -22,6 +22,11 @@
 #include <linux/slab.h>
 #include <linux/swap.h>
 #include <linux/printk.h>
+#include <linux/ktime.h>
+#include <linux/math64.h>
+#include <linux/moduleparam.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
 #include <linux/vmpressure.h>
 
 /*
@@ -389,3 +394,180 @@ void vmpressure_cleanup(struct vmpressure *vmpr)
 	 */
 	flush_work(&vmpr->work);
 }
+
+#ifdef CONFIG_VMPRESSURE_STALL
+/*
+ * Direct reclaim stall accounting
+ *
+ * Independently of the scanned/reclaimed ratio above, account the time
+ * during which at least one task is stalled in direct reclaim, which is what
+ * the user actually perceives, as well as that time summed over all stalled
+ * tasks. The stalled share of the last stall_window_ms is kept in
+ * VMSTALL_SLOTS slots that are rotated on every update, so that readers get
+ * a sliding window without running a timer.
+ */
+#define VMSTALL_SLOTS	8
+
+static unsigned int vmstall_window_ms = 1000;
+module_param_named(stall_window_ms, vmstall_window_ms, uint, 0644);
+
+static struct {
+	spinlock_t lock;
+	int nr_stalled;
+	u64 some_start;			/* nr_stalled became non zero */
+	u64 some_total;			/* ns with nr_stalled > 0 */
+	u64 task_total;			/* ns summed over stalled tasks */
+	unsigned long entries;
+	u64 slot_ns[VMSTALL_SLOTS];	/* stalled ns in each slot */
+	u64 clock;			/* index of the current slot */
+	u64 last;			/* slots accounted up to here */
+} vmstall = {
+	.lock = __SPIN_LOCK_UNLOCKED(vmstall.lock),
+};
+
+static u64 vmstall_slot_ns(void)
+{
+	return max_t(u64, (u64)vmstall_window_ms * NSEC_PER_MSEC /
+		     VMSTALL_SLOTS, 1);
+}
+
+/* account the stall time since the last update, under vmstall.lock */
+static void vmstall_update(u64 now)
+{
+	u64 len = vmstall_slot_ns();
+	u64 cur = div64_u64(now, len);
+	u64 t = vmstall.last;
+	int i;
+
+	/* also catches a window that was made larger */
+	if (cur - vmstall.clock >= VMSTALL_SLOTS) {
+		for (i = 0; i < VMSTALL_SLOTS; i++)
+			vmstall.slot_ns[i] = 0;
+		vmstall.clock = cur;
+		t = max(t, cur * len);
+	}
+
+	while (vmstall.clock < cur) {
+		u64 end = (vmstall.clock + 1) * len;
+
+		if (vmstall.nr_stalled && t < end) {
+			vmstall.slot_ns[vmstall.clock % VMSTALL_SLOTS] +=
+				end - t;
+			t = end;
+		}
+		vmstall.clock++;
+		vmstall.slot_ns[vmstall.clock % VMSTALL_SLOTS] = 0;
+	}
+
+	if (vmstall.nr_stalled && now > t)
+		vmstall.slot_ns[cur % VMSTALL_SLOTS] += now - t;
+	vmstall.last = now;
+}
+
+/**
+ * vmpressure_stall_enter() - Account a task entering direct reclaim
+ *
+ * Returns the time stamp to be passed to vmpressure_stall_exit().
+ */
+u64 vmpressure_stall_enter(void)
+{
+	u64 now = ktime_get_ns();
+
+	spin_lock(&vmstall.lock);
+	vmstall_update(now);
+	if (!vmstall.nr_stalled++)
+		vmstall.some_start = now;
+	vmstall.entries++;
+	spin_unlock(&vmstall.lock);
+
+	return now;
+}
+
+/**
+ * vmpressure_stall_exit() - Account a task leaving direct reclaim
+ * @start:	Value returned by the matching vmpressure_stall_enter()
+ */
+void vmpressure_stall_exit(u64 start)
+{
+	u64 now = ktime_get_ns();
+
+	spin_lock(&vmstall.lock);
+	vmstall_update(now);
+	vmstall.task_total += now - start;
+	if (!--vmstall.nr_stalled)
+		vmstall.some_total += now - vmstall.some_start;
+	spin_unlock(&vmstall.lock);
+}
+
+/**
+ * vmpressure_stall_pct() - Share of time stalled in direct reclaim
+ *
+ * Returns the percentage of the last vmpressure_stall_window_ms() during
+ * which at least one task was stalled in direct reclaim.
+ */
+unsigned int vmpressure_stall_pct(void)
+{
+	u64 now = ktime_get_ns();
+	u64 len, span, sum = 0;
+	int i;
+
+	spin_lock(&vmstall.lock);
+	vmstall_update(now);
+	for (i = 0; i < VMSTALL_SLOTS; i++)
+		sum += vmstall.slot_ns[i];
+	len = vmstall_slot_ns();
+	/* the current slot is only partly over */
+	span = (VMSTALL_SLOTS - 1) * len + now - vmstall.clock * len;
+	spin_unlock(&vmstall.lock);
+
+	return min_t(u64, div64_u64(sum * 100, span), 100);
+}
+
+unsigned int vmpressure_stall_window_ms(void)
+{
+	return vmstall_window_ms;
+}
+
+static int vmstall_proc_show(struct seq_file *m, void *v)
+{
+	unsigned int pct = vmpressure_stall_pct();
+	u64 now = ktime_get_ns();
+	u64 some, tasks;
+	unsigned long entries;
+	int stalled;
+
+	spin_lock(&vmstall.lock);
+	stalled = vmstall.nr_stalled;
+	some = vmstall.some_total;
+	if (stalled)
+		some += now - vmstall.some_start;
+	tasks = vmstall.task_total;
+	entries = vmstall.entries;
+	spin_unlock(&vmstall.lock);
+
+	seq_printf(m, "some avg%u=%u total=%llu\n", vmstall_window_ms, pct,
+		   div_u64(some, NSEC_PER_USEC));
+	seq_printf(m, "tasks total=%llu entries=%lu stalled=%d\n",
+		   div_u64(tasks, NSEC_PER_USEC), entries, stalled);
+	return 0;
+}
+
+static int vmstall_proc_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, vmstall_proc_show, NULL);
+}
+
+static const struct file_operations vmstall_proc_fops = {
+	.open		= vmstall_proc_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init vmpressure_stall_init(void)
+{
+	proc_create("vmstall", S_IRUGO, NULL, &vmstall_proc_fops);
+	return 0;
+}
+module_init(vmpressure_stall_init);
+#endif /* CONFIG_VMPRESSURE_STALL */
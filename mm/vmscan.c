@@ -147,6 +147,11 @@ struct scan_control {
  * From 0 .. 100.  Higher means more swappy.
  */
 int vm_swappiness = 100;
+#ifdef CONFIG_RECLAIM_COST_MODEL
+int vm_reclaim_cost_model;
+/* estimated cost of reading back a page cache page that was a refault */
+int vm_refault_cost_us = 50;
+#endif
 /*
  * The total number of pages which are beyond the high watermark within all
  * zones.
@@ -2034,6 +2039,79 @@ static unsigned long shrink_list(enum lru_list lru, unsigned long nr_to_scan,
 	return shrink_inactive_list(nr_to_scan, lruvec, sc, lru);
 }
 
+#ifdef CONFIG_RECLAIM_COST_MODEL
+/*
+ * With swap on zram, reclaiming an anon page costs the CPU time to compress
+ * it and, if it is faulted back, to decompress it, while reclaiming a page
+ * cache page only costs something when it refaults. Both are accumulated in
+ * vm events; keep an average decaying by half every second and use it to
+ * skew swappiness towards the cheaper side, as the IO cost that swappiness
+ * stands for is mostly CPU time here.
+ */
+static struct {
+	spinlock_t lock;
+	unsigned long stamp;
+	unsigned long last[2];
+	u64 avg[2];
+} reclaim_cost = {
+	.lock = __SPIN_LOCK_UNLOCKED(reclaim_cost.lock),
+};
+
+static unsigned long reclaim_cost_events(enum vm_event_item item)
+{
+	unsigned long sum = 0;
+	int cpu;
+
+	for_each_online_cpu(cpu)
+		sum += per_cpu(vm_event_states, cpu).event[item];
+
+	return sum;
+}
+
+static void reclaim_cost_prio(int swappiness, unsigned long *anon_prio,
+			      unsigned long *file_prio)
+{
+	static const enum vm_event_item items[2] = {
+		RECLAIM_COST_ANON_NS, RECLAIM_COST_FILE_NS,
+	};
+	u64 cost[2], total, ap, fp;
+	int i;
+
+	spin_lock(&reclaim_cost.lock);
+	if (time_after_eq(jiffies, reclaim_cost.stamp + HZ)) {
+		for (i = 0; i < 2; i++) {
+			unsigned long now = reclaim_cost_events(items[i]);
+
+			reclaim_cost.avg[i] = reclaim_cost.avg[i] / 2 +
+					      (now - reclaim_cost.last[i]);
+			reclaim_cost.last[i] = now;
+		}
+		reclaim_cost.stamp = jiffies;
+	}
+	cost[0] = reclaim_cost.avg[0];
+	cost[1] = reclaim_cost.avg[1];
+	spin_unlock(&reclaim_cost.lock);
+
+	/*
+	 * Each side is charged its own cost plus the total so that a side
+	 * which has not been reclaimed from lately is not seen as free.
+	 */
+	total = cost[0] + cost[1] + 1;
+	cost[0] += total;
+	cost[1] += total;
+
+	swappiness = min(swappiness, 200);
+	ap = div64_u64((u64)swappiness * (cost[0] + cost[1]), cost[0]);
+	fp = div64_u64((u64)(200 - swappiness) * (cost[0] + cost[1]), cost[1]);
+
+	*anon_prio = div64_u64(200 * ap, ap + fp);
+	*file_prio = 200 - *anon_prio;
+
+	count_vm_event(RECLAIM_COST_DECISIONS);
+	count_vm_events(RECLAIM_COST_ANON_PRIO, *anon_prio);
+}
+#endif
+
 enum scan_balance {
 	SCAN_EQUAL,
 	SCAN_FRACT,
@@ -2373,6 +2451,10 @@ static void get_scan_count(struct lruvec *lruvec, int swappiness,
 	 */
 	anon_prio = swappiness;
 	file_prio = 200 - anon_prio;
+#ifdef CONFIG_RECLAIM_COST_MODEL
+	if (vm_reclaim_cost_model)
+		reclaim_cost_prio(swappiness, &anon_prio, &file_prio);
+#endif
 
 	/*
 	 * OK, so we have swap space and a fair amount of page cache
@@ -2698,6 +2780,10 @@ static bool shrink_zone(struct zone *zone, struct scan_control *sc,
 				mem_cgroup_events(memcg, MEMCG_LOW, 1);
 			}
 
+			if (global_reclaim(sc) &&
+			    mem_cgroup_reclaim_deferred(memcg, sc->priority))
+				continue;
+
 			lruvec = mem_cgroup_zone_lruvec(zone, memcg);
 			swappiness = mem_cgroup_swappiness(memcg);
 			scanned = sc->nr_scanned;
@@ -3140,17 +3226,24 @@ unsigned long try_to_free_pages(struct zonelist *zonelist, int order,
 
 	unsigned long pgdatfile = global_page_state(NR_ACTIVE_FILE) +
 				global_page_state(NR_INACTIVE_FILE);
+	u64 stall;
+
 	if (pgdatfile <= 12800) {
 		sc.may_swap = 1;
 	}
 
+	/* being throttled counts as a stall as well */
+	stall = vmpressure_stall_enter();
+
 	/*
 	 * Do not enter reclaim if fatal signal was delivered while throttled.
 	 * 1 is returned so that the page allocator does not OOM kill at this
 	 * point.
 	 */
-	if (throttle_direct_reclaim(gfp_mask, zonelist, nodemask))
+	if (throttle_direct_reclaim(gfp_mask, zonelist, nodemask)) {
+		vmpressure_stall_exit(stall);
 		return 1;
+	}
 
 	trace_mm_vmscan_direct_reclaim_begin(order,
 				sc.may_writepage,
@@ -3159,6 +3252,7 @@ unsigned long try_to_free_pages(struct zonelist *zonelist, int order,
 	nr_reclaimed = do_try_to_free_pages(zonelist, &sc);
 
 	trace_mm_vmscan_direct_reclaim_end(nr_reclaimed);
+	vmpressure_stall_exit(stall);
 
 	return nr_reclaimed;
 }
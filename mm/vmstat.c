@@ -877,6 +877,12 @@ const char * const vmstat_text[] = {
 	"vmacache_find_calls",
 	"vmacache_find_hits",
 #endif
+#ifdef CONFIG_RECLAIM_COST_MODEL
+	"reclaim_cost_anon_ns",
+	"reclaim_cost_file_ns",
+	"reclaim_cost_decisions",
+	"reclaim_cost_anon_prio",
+#endif
 #endif /* CONFIG_VM_EVENTS_COUNTERS */
 };
 #endif /* CONFIG_PROC_FS || CONFIG_SYSFS || CONFIG_NUMA */
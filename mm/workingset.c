@@ -12,6 +12,13 @@
 #include <linux/swap.h>
 #include <linux/fs.h>
 #include <linux/mm.h>
+#ifdef CONFIG_WORKINGSET_FILE_STATS
+#include <linux/debugfs.h>
+#include <linux/hashtable.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#endif
 
 /*
  *		Double CLOCK lists
@@ -219,8 +226,196 @@ void *workingset_eviction(struct address_space *mapping, struct page *page)
 	return pack_shadow(eviction, zone);
 }
 
+#ifdef CONFIG_WORKINGSET_FILE_STATS
+/*
+ * Refaults per file, for the files that refaulted most recently. Inodes
+ * are not pinned: entries are keyed by device and inode number and the
+ * least recently refaulting one is recycled when the table is full.
+ */
+#define REFAULT_FILES		128
+#define REFAULT_FILES_HASH_BITS	6
+
+struct refault_file {
+	struct hlist_node hash;
+	struct list_head lru;
+	struct workingset_file_stat stat;
+};
+
+static struct refault_file refault_files[REFAULT_FILES];
+static DEFINE_HASHTABLE(refault_file_hash, REFAULT_FILES_HASH_BITS);
+static LIST_HEAD(refault_file_lru);
+static DEFINE_SPINLOCK(refault_file_lock);
+
+static int refault_bucket(unsigned long distance)
+{
+	int bucket = 0;
+
+	if (distance >= 256)
+		bucket = (ilog2(distance) - 8) / 2 + 1;
+
+	return min(bucket, WORKINGSET_REFAULT_BUCKETS - 1);
+}
+
+static void refault_file_account(struct address_space *mapping,
+				 unsigned long distance, bool activate)
+{
+	struct inode *inode = mapping->host;
+	struct refault_file *rf;
+	unsigned long key;
+	dev_t dev;
+
+	if (!inode)
+		return;
+
+	dev = inode->i_sb->s_dev;
+	key = inode->i_ino ^ ((unsigned long)dev << 20);
+
+	spin_lock(&refault_file_lock);
+	hash_for_each_possible(refault_file_hash, rf, hash, key) {
+		if (rf->stat.ino == inode->i_ino && rf->stat.dev == dev)
+			goto found;
+	}
+
+	rf = list_last_entry(&refault_file_lru, struct refault_file, lru);
+	hash_del(&rf->hash);
+	memset(&rf->stat, 0, sizeof(rf->stat));
+	rf->stat.dev = dev;
+	rf->stat.ino = inode->i_ino;
+	hash_add(refault_file_hash, &rf->hash, key);
+found:
+	list_move(&rf->lru, &refault_file_lru);
+	rf->stat.refaults++;
+	if (activate)
+		rf->stat.activations++;
+	rf->stat.hist[refault_bucket(distance)]++;
+	spin_unlock(&refault_file_lock);
+}
+
+static int refault_file_cmp(const void *a, const void *b)
+{
+	const struct workingset_file_stat *x = a, *y = b;
+
+	if (x->refaults == y->refaults)
+		return 0;
+	return x->refaults < y->refaults ? 1 : -1;
+}
+
+/**
+ * workingset_hot_files - list the files refaulting the most
+ * @stats: array to fill
+ * @nr: size of @stats
+ *
+ * Returns the number of entries filled, most refaulting first.
+ */
+int workingset_hot_files(struct workingset_file_stat *stats, int nr)
+{
+	struct workingset_file_stat *all;
+	struct refault_file *rf;
+	int n = 0;
+
+	all = kmalloc_array(REFAULT_FILES, sizeof(*all), GFP_KERNEL);
+	if (!all)
+		return -ENOMEM;
+
+	spin_lock(&refault_file_lock);
+	list_for_each_entry(rf, &refault_file_lru, lru) {
+		if (!rf->stat.refaults)
+			break;
+		all[n++] = rf->stat;
+	}
+	spin_unlock(&refault_file_lock);
+
+	sort(all, n, sizeof(*all), refault_file_cmp, NULL);
+	n = min(n, nr);
+	memcpy(stats, all, n * sizeof(*all));
+	kfree(all);
+
+	return n;
+}
+EXPORT_SYMBOL_GPL(workingset_hot_files);
+
+static int refault_files_show(struct seq_file *m, void *v)
+{
+	struct workingset_file_stat *stats;
+	int i, j, n;
+
+	stats = kmalloc_array(REFAULT_FILES, sizeof(*stats), GFP_KERNEL);
+	if (!stats)
+		return -ENOMEM;
+
+	n = workingset_hot_files(stats, REFAULT_FILES);
+	seq_puts(m, "# dev ino refaults activations <256 <1k <4k <16k <64k <256k more\n");
+	for (i = 0; i < n; i++) {
+		seq_printf(m, "%u:%u %lu %lu %lu", MAJOR(stats[i].dev),
+			   MINOR(stats[i].dev), stats[i].ino,
+			   stats[i].refaults, stats[i].activations);
+		for (j = 0; j < WORKINGSET_REFAULT_BUCKETS; j++)
+			seq_printf(m, " %lu", stats[i].hist[j]);
+		seq_putc(m, '\n');
+	}
+	kfree(stats);
+
+	return 0;
+}
+
+static int refault_files_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, refault_files_show, NULL);
+}
+
+/* any write clears the table */
+static ssize_t refault_files_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	int i;
+
+	spin_lock(&refault_file_lock);
+	for (i = 0; i < REFAULT_FILES; i++) {
+		hash_del(&refault_files[i].hash);
+		memset(&refault_files[i].stat, 0, sizeof(refault_files[i].stat));
+	}
+	spin_unlock(&refault_file_lock);
+
+	return count;
+}
+
+static const struct file_operations refault_files_fops = {
+	.open		= refault_files_open,
+	.read		= seq_read,
+	.write		= refault_files_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void __init refault_files_init(void)
+{
+	struct dentry *root;
+	int i;
+
+	for (i = 0; i < REFAULT_FILES; i++) {
+		INIT_HLIST_NODE(&refault_files[i].hash);
+		list_add(&refault_files[i].lru, &refault_file_lru);
+	}
+
+	root = debugfs_create_dir("workingset", NULL);
+	if (root)
+		debugfs_create_file("refault_files", 0600, root, NULL,
+				    &refault_files_fops);
+}
+#else
+static inline void refault_file_account(struct address_space *mapping,
+					unsigned long distance, bool activate)
+{
+}
+
+static inline void refault_files_init(void)
+{
+}
+#endif /* CONFIG_WORKINGSET_FILE_STATS */
+
 /**
  * workingset_refault - evaluate the refault of a previously evicted page
+ * @mapping: address space the page is faulted back into
  * @shadow: shadow entry of the evicted page
  *
  * Calculates and evaluates the refault distance of the previously
@@ -228,16 +423,26 @@ void *workingset_eviction(struct address_space *mapping, struct page *page)
  *
  * Returns %true if the page should be activated, %false otherwise.
  */
-bool workingset_refault(void *shadow)
+bool workingset_refault(struct address_space *mapping, void *shadow)
 {
 	unsigned long refault_distance;
 	struct zone *zone;
+	bool activate;
 
 	unpack_shadow(shadow, &zone, &refault_distance);
 	inc_zone_state(zone, WORKINGSET_REFAULT);
 
-	if (refault_distance <= zone_page_state(zone, NR_ACTIVE_FILE)) {
+	activate = refault_distance <= zone_page_state(zone, NR_ACTIVE_FILE);
+	refault_file_account(mapping, refault_distance, activate);
+
+	if (activate) {
 		inc_zone_state(zone, WORKINGSET_ACTIVATE);
+#ifdef CONFIG_RECLAIM_COST_MODEL
+		/* the page is read back in and was reclaimed for nothing */
+		count_vm_events(RECLAIM_COST_FILE_NS,
+				(unsigned long)READ_ONCE(vm_refault_cost_us) *
+				NSEC_PER_USEC);
+#endif
 		return true;
 	}
 	return false;
@@ -405,6 +610,7 @@ static int __init workingset_init(void)
 	ret = register_shrinker(&workingset_shadow_shrinker);
 	if (ret)
 		goto err_list_lru;
+	refault_files_init();
 	return 0;
 err_list_lru:
 	list_lru_destroy(&__workingset_shadow_nodes);
@@ -53,6 +53,8 @@
 #include <linux/pagemap.h>
 #include <linux/swap.h>
 #include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
 
 #define ZSPAGE_MAGIC	0x58
 
@@ -174,6 +176,23 @@ static struct vfsmount *zsmalloc_mnt;
 
 static int zs_page_migration_enabled = 1;
 
+/*
+ * Background compaction starts once this percentage of the pool's pages
+ * is not covered by live objects, and spends at most bg_compact_budget_ms
+ * per run before yielding for ZS_BG_COMPACT_DELAY. A threshold of 0
+ * disables it.
+ */
+static unsigned int zs_bg_compact_threshold = 25;
+module_param_named(bg_compact_threshold, zs_bg_compact_threshold, uint, 0644);
+static unsigned int zs_bg_compact_budget_ms = 2;
+module_param_named(bg_compact_budget_ms, zs_bg_compact_budget_ms, uint, 0644);
+
+/* frees between two looks at the pool's fragmentation */
+#define ZS_BG_COMPACT_CHECK	1024
+#define ZS_BG_COMPACT_DELAY	(HZ / 10)
+/* not worth the trouble below this many pages */
+#define ZS_BG_COMPACT_MIN_PAGES	256
+
 /*
  * number of size_classes
  */
@@ -273,6 +292,11 @@ struct zs_pool {
 	struct inode *inode;
 	struct work_struct free_work;
 #endif
+	/* background compaction */
+	struct delayed_work bg_compact_work;
+	atomic_t bg_compact_frees;
+	int bg_compact_next;		/* class to resume at, -1 if idle */
+	unsigned long bg_compact_runs;
 };
 
 /*
@@ -688,6 +712,77 @@ static const struct file_operations zs_stat_size_ops = {
 	.release        = single_release,
 };
 
+#define ZS_FRAG_BUCKETS	10
+
+/*
+ * Per class, the share of its pages not covered by live objects and a
+ * histogram of its zspages by how full they are, in 10% steps.
+ */
+static int zs_stats_frag_show(struct seq_file *s, void *v)
+{
+	struct zs_pool *pool = s->private;
+	unsigned long hist[ZS_FRAG_BUCKETS];
+	struct size_class *class;
+	struct zspage *zspage;
+	unsigned long obj_used, pages_used;
+	int i, fg, b;
+
+	seq_printf(s, " %5s %5s %10s %6s", "class", "size", "pages_used",
+			"waste%");
+	for (b = 0; b < ZS_FRAG_BUCKETS; b++)
+		seq_printf(s, " %5d%%", (b + 1) * 100 / ZS_FRAG_BUCKETS);
+	seq_puts(s, "\n");
+
+	for (i = 0; i < zs_size_classes; i++) {
+		class = pool->size_class[i];
+
+		if (class->index != i)
+			continue;
+
+		memset(hist, 0, sizeof(hist));
+		spin_lock(&class->lock);
+		obj_used = zs_stat_get(class, OBJ_USED);
+		pages_used = zs_stat_get(class, OBJ_ALLOCATED) /
+				class->objs_per_zspage * class->pages_per_zspage;
+		for (fg = ZS_EMPTY; fg < NR_ZS_FULLNESS; fg++) {
+			list_for_each_entry(zspage, &class->fullness_list[fg],
+					    list) {
+				b = get_zspage_inuse(zspage) * ZS_FRAG_BUCKETS /
+					class->objs_per_zspage;
+				hist[min(b, ZS_FRAG_BUCKETS - 1)]++;
+			}
+		}
+		spin_unlock(&class->lock);
+
+		if (!pages_used)
+			continue;
+
+		seq_printf(s, " %5u %5u %10lu %6lu", i, class->size,
+			   pages_used, 100 - obj_used * class->size * 100 /
+			   (pages_used * PAGE_SIZE));
+		for (b = 0; b < ZS_FRAG_BUCKETS; b++)
+			seq_printf(s, " %6lu", hist[b]);
+		seq_puts(s, "\n");
+	}
+
+	seq_printf(s, "\nbackground compaction runs: %lu, pages compacted: %lu\n",
+		   pool->bg_compact_runs, pool->stats.pages_compacted);
+
+	return 0;
+}
+
+static int zs_stats_frag_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, zs_stats_frag_show, inode->i_private);
+}
+
+static const struct file_operations zs_stat_frag_ops = {
+	.open           = zs_stats_frag_open,
+	.read           = seq_read,
+	.llseek         = seq_lseek,
+	.release        = single_release,
+};
+
 static int zs_pool_stat_create(struct zs_pool *pool, const char *name)
 {
 	struct dentry *entry;
@@ -710,6 +805,14 @@ static int zs_pool_stat_create(struct zs_pool *pool, const char *name)
 		return -ENOMEM;
 	}
 
+	entry = debugfs_create_file("fragmentation", S_IFREG | S_IRUGO,
+			pool->stat_dentry, pool, &zs_stat_frag_ops);
+	if (!entry) {
+		pr_warn("%s: debugfs file entry <%s> creation failed\n",
+				name, "fragmentation");
+		return -ENOMEM;
+	}
+
 	return 0;
 }
 
@@ -1666,6 +1769,14 @@ static void obj_free(struct size_class *class, unsigned long obj)
 	zs_stat_dec(class, OBJ_USED, 1);
 }
 
+static inline void zs_bg_compact_kick(struct zs_pool *pool)
+{
+	if (zs_bg_compact_threshold &&
+	    !(atomic_inc_return(&pool->bg_compact_frees) % ZS_BG_COMPACT_CHECK))
+		queue_delayed_work(system_unbound_wq,
+				   &pool->bg_compact_work, 0);
+}
+
 void zs_free(struct zs_pool *pool, unsigned long handle)
 {
 	struct zspage *zspage;
@@ -1707,6 +1818,7 @@ out:
 
 	spin_unlock(&class->lock);
 	unpin_tag(handle);
+	zs_bg_compact_kick(pool);
 	cache_free_handle(pool, handle);
 }
 EXPORT_SYMBOL_GPL(zs_free);
@@ -2373,6 +2485,65 @@ unsigned long zs_compact(struct zs_pool *pool)
 }
 EXPORT_SYMBOL_GPL(zs_compact);
 
+/* percentage of the pool's pages not covered by live objects */
+static unsigned int zs_pool_waste(struct zs_pool *pool)
+{
+	unsigned long used = 0, total = zs_get_total_pages(pool);
+	struct size_class *class;
+	int i;
+
+	if (total < ZS_BG_COMPACT_MIN_PAGES)
+		return 0;
+
+	for (i = 0; i < zs_size_classes; i++) {
+		class = pool->size_class[i];
+		if (!class || class->index != i)
+			continue;
+		used += zs_stat_get(class, OBJ_USED) * class->size;
+	}
+
+	used >>= PAGE_SHIFT;
+	return used < total ? (total - used) * 100 / total : 0;
+}
+
+/*
+ * Compact class by class, largest first as zs_compact() does, and hand
+ * the CPU back once the time budget of this run is spent. The next run
+ * resumes at the class where this one stopped.
+ */
+static void zs_bg_compact_work(struct work_struct *work)
+{
+	struct zs_pool *pool = container_of(to_delayed_work(work),
+					struct zs_pool, bg_compact_work);
+	struct size_class *class;
+	u64 end;
+	int i;
+
+	if (pool->bg_compact_next < 0) {
+		if (!zs_bg_compact_threshold ||
+		    zs_pool_waste(pool) < zs_bg_compact_threshold)
+			return;
+		pool->bg_compact_next = zs_size_classes - 1;
+		pool->bg_compact_runs++;
+	}
+
+	end = ktime_get_ns() + (u64)zs_bg_compact_budget_ms * NSEC_PER_MSEC;
+	for (i = pool->bg_compact_next; i >= 0; i--) {
+		class = pool->size_class[i];
+		if (!class || class->index != i)
+			continue;
+		if (zs_can_compact(class))
+			__zs_compact(pool, class);
+		if (ktime_get_ns() > end)
+			break;
+	}
+
+	pool->bg_compact_next = i > 0 ? i - 1 : -1;
+	if (pool->bg_compact_next >= 0)
+		queue_delayed_work(system_unbound_wq, &pool->bg_compact_work,
+				   ZS_BG_COMPACT_DELAY);
+}
+
 void zs_pool_stats(struct zs_pool *pool, struct zs_pool_stats *stats)
 {
 	memcpy(stats, &pool->stats, sizeof(struct zs_pool_stats));
@@ -2470,6 +2641,8 @@ struct zs_pool *zs_create_pool(const char *name)
 		return NULL;
 
 	init_deferred_free(pool);
+	INIT_DELAYED_WORK(&pool->bg_compact_work, zs_bg_compact_work);
+	pool->bg_compact_next = -1;
 	pool->size_class = kcalloc(zs_size_classes, sizeof(struct size_class *),
 			GFP_KERNEL);
 	if (!pool->size_class) {
@@ -2580,6 +2753,7 @@ void zs_destroy_pool(struct zs_pool *pool)
 {
 	int i;
 
+	cancel_delayed_work_sync(&pool->bg_compact_work);
 	zs_unregister_shrinker(pool);
 	zs_unregister_migration(pool);
 	zs_pool_stat_destroy(pool);
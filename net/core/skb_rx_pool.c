@@ -0,0 +1,365 @@
+/*
+ * Per cpu recycling pools of receive pages
+ *
+ * Drivers such as SCSC WLAN and the modem_v1 link devices copy every
+ * frame out of shared memory into an skb they just allocated. The
+ * netdev page fragment cache serves those heads, but it never gets a
+ * page back: each refill is a trip to the page allocator, which falls
+ * back to order-0 and gets slower as memory fragments.
+ *
+ * A pool keeps a small ring of order-0 pages per cpu. Skb heads are
+ * carved out of the current page, each holding a page reference, and
+ * the ring keeps one reference of its own. When the cpu moves on to
+ * the next slot of the ring and finds only the ring's reference left,
+ * every skb built on that page has been freed and the page is carved
+ * again without touching the allocator. A page still in use is given
+ * up to its skbs and replaced. Idle pages are handed back under memory
+ * pressure through a shrinker, and on pool destruction.
+ *
+ * Per pool hit, miss and fallback counts are in /proc/net/skb_rx_pool.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version
+ * 2 of the License, or (at your option) any later version.
+ */
+
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/shrinker.h>
+#include <linux/skb_rx_pool.h>
+#include <linux/slab.h>
+#include <net/net_namespace.h>
+
+struct skb_rx_pool_cpu {
+	spinlock_t		lock;
+	struct page		**ring;
+	/* ring slot the next page is taken from */
+	unsigned int		next;
+	/* page being carved, also held by the ring */
+	struct page		*page;
+	unsigned int		offset;
+	unsigned long		hits;
+	unsigned long		misses;
+	unsigned long		fallbacks;
+};
+
+struct skb_rx_pool {
+	struct list_head		list;
+	const char			*name;
+	unsigned int			pages;
+	struct skb_rx_pool_cpu __percpu	*cpu;
+	struct shrinker			shrinker;
+};
+
+static LIST_HEAD(skb_rx_pools);
+static DEFINE_MUTEX(skb_rx_pools_lock);
+
+/* Called with c->lock held, returns the page to carve next or NULL */
+static struct page *skb_rx_pool_refill(struct skb_rx_pool *pool,
+				       struct skb_rx_pool_cpu *c,
+				       gfp_t gfp_mask)
+{
+	struct page **slot = &c->ring[c->next];
+	struct page *page = *slot;
+
+	if (++c->next == pool->pages)
+		c->next = 0;
+
+	if (page && page_count(page) == 1) {
+		c->hits++;
+		return page;
+	}
+
+	/* Still referenced by skbs, the last of them frees it */
+	if (page)
+		put_page(page);
+	*slot = NULL;
+	c->misses++;
+
+	page = alloc_page(gfp_mask);
+	if (!page)
+		return NULL;
+
+	/* Emergency reserves are not kept around for recycling */
+	if (page_is_pfmemalloc(page)) {
+		__free_page(page);
+		return NULL;
+	}
+
+	*slot = page;
+	return page;
+}
+
+/**
+ * skb_rx_pool_alloc - allocate an skbuff for rx from a recycling pool
+ * @pool: pool to allocate from, %NULL for the netdev fragment cache
+ * @len: length to allocate
+ * @gfp_mask: get_free_pages mask
+ *
+ * Like __netdev_alloc_skb(), the buffer has NET_SKB_PAD headroom built
+ * in. Heads that do not fit in a page, and allocations the pool cannot
+ * serve, fall back to __netdev_alloc_skb().
+ */
+struct sk_buff *skb_rx_pool_alloc(struct skb_rx_pool *pool, unsigned int len,
+				  gfp_t gfp_mask)
+{
+	struct skb_rx_pool_cpu *c;
+	unsigned int fragsz;
+	unsigned long flags;
+	struct sk_buff *skb;
+	struct page *page;
+	void *data = NULL;
+
+	if (!pool)
+		goto fallback;
+
+	fragsz = SKB_DATA_ALIGN(len + NET_SKB_PAD) +
+		 SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+
+	/* Being migrated only means carving from another cpu's page */
+	c = raw_cpu_ptr(pool->cpu);
+
+	spin_lock_irqsave(&c->lock, flags);
+	page = c->page;
+	if (fragsz > PAGE_SIZE) {
+		page = NULL;
+	} else if (!page || c->offset + fragsz > PAGE_SIZE) {
+		/* The lock is held, never sleep for the page */
+		page = skb_rx_pool_refill(pool, c,
+				(gfp_mask & ~__GFP_DIRECT_RECLAIM) |
+				__GFP_COLD | __GFP_NOWARN | __GFP_NOMEMALLOC);
+		c->page = page;
+		c->offset = 0;
+	}
+	if (page) {
+		get_page(page);
+		data = page_address(page) + c->offset;
+		c->offset += fragsz;
+	} else {
+		c->fallbacks++;
+	}
+	spin_unlock_irqrestore(&c->lock, flags);
+
+	if (unlikely(!data))
+		goto fallback;
+
+	skb = build_skb(data, fragsz);
+	if (unlikely(!skb)) {
+		put_page(page);
+		return NULL;
+	}
+
+	skb_reserve(skb, NET_SKB_PAD);
+	return skb;
+
+fallback:
+	return __netdev_alloc_skb(NULL, len, gfp_mask);
+}
+EXPORT_SYMBOL(skb_rx_pool_alloc);
+
+/* Drop the ring's reference on idle pages, all of them if @all is set */
+static unsigned long skb_rx_pool_release(struct skb_rx_pool *pool, bool all,
+					 unsigned long nr_to_scan)
+{
+	unsigned long freed = 0;
+	unsigned int i;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct skb_rx_pool_cpu *c = per_cpu_ptr(pool->cpu, cpu);
+		unsigned long flags;
+
+		spin_lock_irqsave(&c->lock, flags);
+		for (i = 0; i < pool->pages && freed < nr_to_scan; i++) {
+			struct page *page = c->ring[i];
+
+			if (!page)
+				continue;
+			if (!all && (page == c->page || page_count(page) != 1))
+				continue;
+			if (page == c->page)
+				c->page = NULL;
+			c->ring[i] = NULL;
+			put_page(page);
+			freed++;
+		}
+		spin_unlock_irqrestore(&c->lock, flags);
+	}
+
+	return freed;
+}
+
+static unsigned long skb_rx_pool_count(struct shrinker *shrink,
+				       struct shrink_control *sc)
+{
+	struct skb_rx_pool *pool = container_of(shrink, struct skb_rx_pool,
+						shrinker);
+	unsigned long count = 0;
+	unsigned int i;
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct skb_rx_pool_cpu *c = per_cpu_ptr(pool->cpu, cpu);
+
+		/* Racy, only a hint for reclaim */
+		for (i = 0; i < pool->pages; i++) {
+			struct page *page = READ_ONCE(c->ring[i]);
+
+			if (page && page != READ_ONCE(c->page) &&
+			    page_count(page) == 1)
+				count++;
+		}
+	}
+
+	return count;
+}
+
+static unsigned long skb_rx_pool_scan(struct shrinker *shrink,
+				      struct shrink_control *sc)
+{
+	struct skb_rx_pool *pool = container_of(shrink, struct skb_rx_pool,
+						shrinker);
+
+	return skb_rx_pool_release(pool, false, sc->nr_to_scan);
+}
+
+static void skb_rx_pool_free(struct skb_rx_pool *pool)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		kfree(per_cpu_ptr(pool->cpu, cpu)->ring);
+	free_percpu(pool->cpu);
+	kfree(pool);
+}
+
+/**
+ * skb_rx_pool_create - create a per cpu pool of receive pages
+ * @name: name the pool is reported under
+ * @pages: number of pages kept per cpu
+ *
+ * The ring needs to be deeper than the number of pages the skbs of one
+ * cpu hold at a time for pages to come back idle; a shallow ring only
+ * costs misses. Returns %NULL if @pages is 0 or on allocation failure,
+ * which skb_rx_pool_alloc() accepts.
+ */
+struct skb_rx_pool *skb_rx_pool_create(const char *name, unsigned int pages)
+{
+	struct skb_rx_pool *pool;
+	int cpu;
+
+	if (!pages)
+		return NULL;
+
+	pool = kzalloc(sizeof(*pool), GFP_KERNEL);
+	if (!pool)
+		return NULL;
+
+	pool->name = name;
+	pool->pages = pages;
+	pool->cpu = alloc_percpu(struct skb_rx_pool_cpu);
+	if (!pool->cpu) {
+		kfree(pool);
+		return NULL;
+	}
+
+	for_each_possible_cpu(cpu) {
+		struct skb_rx_pool_cpu *c = per_cpu_ptr(pool->cpu, cpu);
+
+		spin_lock_init(&c->lock);
+		c->ring = kcalloc_node(pages, sizeof(*c->ring), GFP_KERNEL,
+				       cpu_to_node(cpu));
+		if (!c->ring) {
+			skb_rx_pool_free(pool);
+			return NULL;
+		}
+	}
+
+	pool->shrinker.count_objects = skb_rx_pool_count;
+	pool->shrinker.scan_objects = skb_rx_pool_scan;
+	pool->shrinker.seeks = DEFAULT_SEEKS;
+	if (register_shrinker(&pool->shrinker)) {
+		skb_rx_pool_free(pool);
+		return NULL;
+	}
+
+	mutex_lock(&skb_rx_pools_lock);
+	list_add_tail(&pool->list, &skb_rx_pools);
+	mutex_unlock(&skb_rx_pools_lock);
+
+	return pool;
+}
+EXPORT_SYMBOL(skb_rx_pool_create);
+
+/**
+ * skb_rx_pool_destroy - release a pool and its idle pages
+ * @pool: pool to destroy, may be %NULL
+ *
+ * Pages still held by skbs are freed along with the last of them.
+ */
+void skb_rx_pool_destroy(struct skb_rx_pool *pool)
+{
+	if (!pool)
+		return;
+
+	mutex_lock(&skb_rx_pools_lock);
+	list_del(&pool->list);
+	mutex_unlock(&skb_rx_pools_lock);
+
+	unregister_shrinker(&pool->shrinker);
+	skb_rx_pool_release(pool, true, ULONG_MAX);
+	skb_rx_pool_free(pool);
+}
+EXPORT_SYMBOL(skb_rx_pool_destroy);
+
+#ifdef CONFIG_PROC_FS
+static int skb_rx_pool_seq_show(struct seq_file *seq, void *v)
+{
+	struct skb_rx_pool *pool;
+	int cpu;
+
+	seq_puts(seq, "pool             cpu pages       hits     misses  fallbacks\n");
+	mutex_lock(&skb_rx_pools_lock);
+	list_for_each_entry(pool, &skb_rx_pools, list) {
+		for_each_online_cpu(cpu) {
+			struct skb_rx_pool_cpu *c = per_cpu_ptr(pool->cpu, cpu);
+
+			seq_printf(seq, "%-16s %3d %5u %10lu %10lu %10lu\n",
+				   pool->name, cpu, pool->pages, c->hits,
+				   c->misses, c->fallbacks);
+		}
+	}
+	mutex_unlock(&skb_rx_pools_lock);
+
+	return 0;
+}
+
+static int skb_rx_pool_seq_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, skb_rx_pool_seq_show, NULL);
+}
+
+static const struct file_operations skb_rx_pool_seq_fops = {
+	.owner		= THIS_MODULE,
+	.open		= skb_rx_pool_seq_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static int __init skb_rx_pool_proc_init(void)
+{
+	if (!proc_create("skb_rx_pool", S_IRUGO, init_net.proc_net,
+			 &skb_rx_pool_seq_fops))
+		return -ENOMEM;
+	return 0;
+}
+fs_initcall(skb_rx_pool_proc_init);
+#endif
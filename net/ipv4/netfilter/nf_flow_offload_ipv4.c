@@ -0,0 +1,658 @@
+/*
+ * Software flow offload for forwarded IPv4 connections
+ *
+ * When conntrack has seen both directions of a forwarded TCP or UDP
+ * connection, each direction goes into a flow table. The key is the
+ * tuple the packets arrive with plus the input device. A PRE_ROUTING
+ * hook ahead of defragmentation looks incoming packets up there. A hit
+ * is NATed from the conntrack tuples and handed to the neighbour
+ * output of the cached route. Conntrack, NAT, the routing lookup and
+ * the FORWARD and POST_ROUTING hooks are all skipped. Tethering is the
+ * main user: USB rndis/ncm to the cellular or wlan netdev and back.
+ *
+ * Packets the slow path has to see are left to it: fragments, IP
+ * options, packets above the route MTU and TCP SYN, FIN or RST. The
+ * latter also end the offload of that direction. Like ip_forward() in
+ * this tree, the fast path does not decrement the TTL.
+ *
+ * Entries have no timeouts of their own. A periodic worker pushes the
+ * conntrack timeout forward for flows that saw traffic and frees the
+ * entries of dead conntracks, so idle flows still expire through the
+ * conntrack timeouts.
+ *
+ * Offloaded packets bypass iptables rules and counters in FORWARD and
+ * POST_ROUTING; conntrack accounting still sees them. Set the "enable"
+ * parameter to 0 where those rules have to see every packet.
+ *
+ * Hit rates are in /proc/net/nf_flow_offload.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation.
+ */
+
+#include <linux/types.h>
+#include <linux/ip.h>
+#include <linux/jhash.h>
+#include <linux/module.h>
+#include <linux/netdevice.h>
+#include <linux/netfilter.h>
+#include <linux/netfilter_ipv4.h>
+#include <linux/percpu.h>
+#include <linux/proc_fs.h>
+#include <linux/seq_file.h>
+#include <linux/skbuff.h>
+#include <linux/slab.h>
+#include <linux/tcp.h>
+#include <linux/udp.h>
+#include <linux/workqueue.h>
+#include <net/arp.h>
+#include <net/checksum.h>
+#include <net/dst.h>
+#include <net/ip.h>
+#include <net/neighbour.h>
+#include <net/route.h>
+#include <net/netfilter/nf_conntrack.h>
+#include <net/netfilter/nf_conntrack_acct.h>
+#include <net/netfilter/nf_conntrack_helper.h>
+#include <net/netfilter/nf_conntrack_seqadj.h>
+
+#define NF_FLOW_HASH_BITS	10
+#define NF_FLOW_GC_INTERVAL	HZ
+
+static bool nf_flow_enable = true;
+module_param_named(enable, nf_flow_enable, bool, 0644);
+MODULE_PARM_DESC(enable, "Forward established flows on the fast path");
+
+static unsigned int nf_flow_max = 4096;
+module_param_named(max_flows, nf_flow_max, uint, 0644);
+MODULE_PARM_DESC(max_flows, "Maximum number of offloaded flow directions");
+
+struct nf_flow_tuple {
+	__be32			saddr;
+	__be32			daddr;
+	__be16			sport;
+	__be16			dport;
+	int			iifidx;
+	u8			l4proto;
+	u8			pad[3];
+};
+
+/* One direction of an offloaded connection */
+struct nf_flow {
+	struct hlist_node	node;
+	struct nf_flow_tuple	tuple;
+	/* what the packet leaves with, from the other direction's tuple */
+	__be32			new_saddr;
+	__be32			new_daddr;
+	__be16			new_sport;
+	__be16			new_dport;
+	enum ip_conntrack_dir	dir;
+	bool			teardown;
+	unsigned int		mtu;
+	struct dst_entry	*dst;
+	struct nf_conn		*ct;
+	/* conntrack timeout of the flow when it was offloaded */
+	unsigned long		ct_timeout;
+	unsigned long		last_used;
+	struct rcu_head		rcu;
+};
+
+struct nf_flow_stats {
+	unsigned long		hits;
+	unsigned long		misses;
+	unsigned long		slowpath;
+	unsigned long		learned;
+	unsigned long		expired;
+};
+
+static struct hlist_head nf_flow_hash[1 << NF_FLOW_HASH_BITS];
+static DEFINE_SPINLOCK(nf_flow_lock);
+static atomic_t nf_flow_count = ATOMIC_INIT(0);
+static u32 nf_flow_seed __read_mostly;
+static struct nf_flow_stats __percpu *nf_flow_stats;
+static unsigned long nf_flow_gc_stamp;
+
+static void nf_flow_gc_work(struct work_struct *work);
+static DECLARE_DELAYED_WORK(nf_flow_gc, nf_flow_gc_work);
+
+static inline u32 nf_flow_hashfn(const struct nf_flow_tuple *tuple)
+{
+	return jhash2((const u32 *)tuple, sizeof(*tuple) / sizeof(u32),
+		      nf_flow_seed) >> (32 - NF_FLOW_HASH_BITS);
+}
+
+/* Called under rcu_read_lock() or nf_flow_lock */
+static struct nf_flow *nf_flow_lookup(const struct nf_flow_tuple *tuple)
+{
+	struct nf_flow *flow;
+
+	hlist_for_each_entry_rcu(flow, &nf_flow_hash[nf_flow_hashfn(tuple)],
+				 node) {
+		if (!memcmp(&flow->tuple, tuple, sizeof(*tuple)))
+			return flow;
+	}
+	return NULL;
+}
+
+static void nf_flow_free_rcu(struct rcu_head *head)
+{
+	struct nf_flow *flow = container_of(head, struct nf_flow, rcu);
+
+	dst_release(flow->dst);
+	nf_ct_put(flow->ct);
+	kfree(flow);
+}
+
+/* Called with nf_flow_lock held */
+static void nf_flow_del(struct nf_flow *flow)
+{
+	hlist_del_rcu(&flow->node);
+	atomic_dec(&nf_flow_count);
+	call_rcu(&flow->rcu, nf_flow_free_rcu);
+}
+
+static void nf_flow_tuple_fill(struct nf_flow_tuple *tuple,
+			       const struct nf_conntrack_tuple *t, int iifidx)
+{
+	memset(tuple, 0, sizeof(*tuple));
+	tuple->saddr = t->src.u3.ip;
+	tuple->daddr = t->dst.u3.ip;
+	tuple->sport = t->src.u.all;
+	tuple->dport = t->dst.u.all;
+	tuple->l4proto = t->dst.protonum;
+	tuple->iifidx = iifidx;
+}
+
+static bool nf_flow_offloadable(const struct nf_conn *ct,
+				const struct sk_buff *skb)
+{
+	const struct rtable *rt = skb_rtable(skb);
+	u8 l4proto = nf_ct_protonum(ct);
+
+	if (nf_ct_l3num(ct) != AF_INET ||
+	    (l4proto != IPPROTO_TCP && l4proto != IPPROTO_UDP))
+		return false;
+
+	if (l4proto == IPPROTO_TCP &&
+	    ct->proto.tcp.state != TCP_CONNTRACK_ESTABLISHED)
+		return false;
+
+	/* Helpers and sequence adjustment need every packet */
+	if (nfct_help(ct) || nfct_seqadj(ct) || nf_ct_is_dying(ct))
+		return false;
+
+	return rt && rt->rt_type == RTN_UNICAST && !dst_xfrm(&rt->dst);
+}
+
+static void nf_flow_add(struct nf_conn *ct, enum ip_conntrack_dir dir,
+			struct sk_buff *skb, const struct net_device *in)
+{
+	const struct nf_conntrack_tuple *reply = &ct->tuplehash[!dir].tuple;
+	struct nf_flow_tuple tuple;
+	struct nf_flow *flow;
+	long timeout;
+
+	nf_flow_tuple_fill(&tuple, &ct->tuplehash[dir].tuple, in->ifindex);
+
+	rcu_read_lock();
+	flow = nf_flow_lookup(&tuple);
+	rcu_read_unlock();
+	if (flow || atomic_read(&nf_flow_count) >= nf_flow_max)
+		return;
+
+	flow = kzalloc(sizeof(*flow), GFP_ATOMIC);
+	if (!flow)
+		return;
+
+	flow->tuple = tuple;
+	flow->new_saddr = reply->dst.u3.ip;
+	flow->new_daddr = reply->src.u3.ip;
+	flow->new_sport = reply->dst.u.all;
+	flow->new_dport = reply->src.u.all;
+	flow->dir = dir;
+	flow->dst = skb_dst(skb);
+	dst_hold(flow->dst);
+	flow->mtu = dst_mtu(flow->dst);
+	flow->ct = ct;
+	nf_conntrack_get(&ct->ct_general);
+	flow->last_used = jiffies;
+
+	/* conntrack has just refreshed the timeout for this packet */
+	timeout = (long)(ct->timeout.expires - jiffies);
+	flow->ct_timeout = max_t(long, timeout, 2 * NF_FLOW_GC_INTERVAL);
+
+	/* The window tracking will miss the packets of the fast path */
+	if (nf_ct_protonum(ct) == IPPROTO_TCP) {
+		spin_lock_bh(&ct->lock);
+		ct->proto.tcp.seen[0].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		ct->proto.tcp.seen[1].flags |= IP_CT_TCP_FLAG_BE_LIBERAL;
+		spin_unlock_bh(&ct->lock);
+	}
+
+	spin_lock_bh(&nf_flow_lock);
+	if (nf_flow_lookup(&tuple)) {
+		spin_unlock_bh(&nf_flow_lock);
+		dst_release(flow->dst);
+		nf_ct_put(ct);
+		kfree(flow);
+		return;
+	}
+	hlist_add_head_rcu(&flow->node, &nf_flow_hash[nf_flow_hashfn(&tuple)]);
+	atomic_inc(&nf_flow_count);
+	spin_unlock_bh(&nf_flow_lock);
+
+	this_cpu_inc(nf_flow_stats->learned);
+}
+
+static void nf_flow_nat(struct sk_buff *skb, struct iphdr *iph,
+			const struct nf_flow *flow)
+{
+	__be16 *ports = (__be16 *)((u8 *)iph + sizeof(*iph));
+	__sum16 *check = NULL;
+
+	if (iph->protocol == IPPROTO_TCP)
+		check = &((struct tcphdr *)ports)->check;
+	else if (((struct udphdr *)ports)->check ||
+		 skb->ip_summed == CHECKSUM_PARTIAL)
+		check = &((struct udphdr *)ports)->check;
+
+	if (iph->saddr != flow->new_saddr) {
+		if (check)
+			inet_proto_csum_replace4(check, skb, iph->saddr,
+						 flow->new_saddr, true);
+		csum_replace4(&iph->check, iph->saddr, flow->new_saddr);
+		iph->saddr = flow->new_saddr;
+	}
+	if (iph->daddr != flow->new_daddr) {
+		if (check)
+			inet_proto_csum_replace4(check, skb, iph->daddr,
+						 flow->new_daddr, true);
+		csum_replace4(&iph->check, iph->daddr, flow->new_daddr);
+		iph->daddr = flow->new_daddr;
+	}
+	if (ports[0] != flow->new_sport) {
+		if (check)
+			inet_proto_csum_replace2(check, skb, ports[0],
+						 flow->new_sport, false);
+		ports[0] = flow->new_sport;
+	}
+	if (ports[1] != flow->new_dport) {
+		if (check)
+			inet_proto_csum_replace2(check, skb, ports[1],
+						 flow->new_dport, false);
+		ports[1] = flow->new_dport;
+	}
+
+	if (check && iph->protocol == IPPROTO_UDP && !*check)
+		*check = CSUM_MANGLED_0;
+}
+
+static void nf_flow_acct(const struct nf_flow *flow,
+			 const struct sk_buff *skb)
+{
+	struct nf_conn_acct *acct = nf_conn_acct_find(flow->ct);
+
+	if (acct) {
+		struct nf_conn_counter *counter = acct->counter;
+
+		atomic64_inc(&counter[flow->dir].packets);
+		atomic64_add(skb->len, &counter[flow->dir].bytes);
+	}
+}
+
+/* ip_finish_output2() without the hooks, skb has its dst set */
+static int nf_flow_xmit(struct sk_buff *skb)
+{
+	struct dst_entry *dst = skb_dst(skb);
+	struct rtable *rt = (struct rtable *)dst;
+	struct net_device *dev = dst->dev;
+	unsigned int hh_len = LL_RESERVED_SPACE(dev);
+	struct neighbour *neigh;
+	u32 nexthop;
+	int res;
+
+	if (unlikely(skb_headroom(skb) < hh_len && dev->header_ops)) {
+		struct sk_buff *skb2;
+
+		skb2 = skb_realloc_headroom(skb, hh_len);
+		consume_skb(skb);
+		if (!skb2)
+			return -ENOMEM;
+		skb = skb2;
+	}
+
+	skb->dev = dev;
+	skb->protocol = htons(ETH_P_IP);
+
+	rcu_read_lock_bh();
+	nexthop = (__force u32)rt_nexthop(rt, ip_hdr(skb)->daddr);
+	neigh = __ipv4_neigh_lookup_noref(dev, nexthop);
+	if (unlikely(!neigh))
+		neigh = __neigh_create(&arp_tbl, &nexthop, dev, false);
+	if (IS_ERR(neigh)) {
+		rcu_read_unlock_bh();
+		kfree_skb(skb);
+		return -EINVAL;
+	}
+	res = dst_neigh_output(dst, neigh, skb);
+	rcu_read_unlock_bh();
+
+	return res;
+}
+
+static unsigned int nf_flow_ipv4_hook(void *priv, struct sk_buff *skb,
+				      const struct nf_hook_state *state)
+{
+	struct nf_flow_tuple tuple;
+	struct dst_entry *dst;
+	struct nf_flow *flow;
+	struct iphdr *iph;
+	unsigned int thlen;
+	__be16 *ports;
+
+	if (!atomic_read(&nf_flow_count) || skb->pkt_type != PACKET_HOST ||
+	    !net_eq(state->net, &init_net) || skb->sk)
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	if (iph->ihl != 5 || ip_is_fragment(iph))
+		return NF_ACCEPT;
+
+	if (iph->protocol == IPPROTO_TCP)
+		thlen = sizeof(struct tcphdr);
+	else if (iph->protocol == IPPROTO_UDP)
+		thlen = sizeof(struct udphdr);
+	else
+		return NF_ACCEPT;
+
+	if (!pskb_may_pull(skb, sizeof(*iph) + thlen))
+		return NF_ACCEPT;
+
+	iph = ip_hdr(skb);
+	ports = (__be16 *)((u8 *)iph + sizeof(*iph));
+
+	memset(&tuple, 0, sizeof(tuple));
+	tuple.saddr = iph->saddr;
+	tuple.daddr = iph->daddr;
+	tuple.sport = ports[0];
+	tuple.dport = ports[1];
+	tuple.l4proto = iph->protocol;
+	tuple.iifidx = state->in->ifindex;
+
+	flow = nf_flow_lookup(&tuple);
+	if (!flow) {
+		this_cpu_inc(nf_flow_stats->misses);
+		return NF_ACCEPT;
+	}
+
+	if (unlikely(flow->teardown || nf_ct_is_dying(flow->ct)))
+		goto slowpath;
+
+	if (iph->protocol == IPPROTO_TCP) {
+		const struct tcphdr *th = (const struct tcphdr *)ports;
+
+		if (unlikely(th->syn || th->fin || th->rst)) {
+			flow->teardown = true;
+			goto slowpath;
+		}
+	}
+
+	/* the slow path sends ICMP_FRAG_NEEDED */
+	if (skb_is_gso(skb) ? skb_gso_network_seglen(skb) > flow->mtu :
+			      skb->len > flow->mtu)
+		goto slowpath;
+
+	dst = dst_check(flow->dst, 0);
+	if (unlikely(!dst)) {
+		flow->teardown = true;
+		goto slowpath;
+	}
+
+	if (skb_try_make_writable(skb, sizeof(*iph) + thlen))
+		goto slowpath;
+
+	iph = ip_hdr(skb);
+	nf_flow_nat(skb, iph, flow);
+	skb_forward_csum(skb);
+	skb_sender_cpu_clear(skb);
+
+	if (flow->last_used != jiffies)
+		WRITE_ONCE(flow->last_used, jiffies);
+	nf_flow_acct(flow, skb);
+
+	IP_INC_STATS_BH(state->net, IPSTATS_MIB_OUTFORWDATAGRAMS);
+	IP_ADD_STATS_BH(state->net, IPSTATS_MIB_OUTOCTETS, skb->len);
+	this_cpu_inc(nf_flow_stats->hits);
+
+	skb_dst_drop(skb);
+	dst_hold(dst);
+	skb_dst_set(skb, dst);
+	nf_flow_xmit(skb);
+	return NF_STOLEN;
+
+slowpath:
+	this_cpu_inc(nf_flow_stats->slowpath);
+	return NF_ACCEPT;
+}
+
+static unsigned int nf_flow_learn_hook(void *priv, struct sk_buff *skb,
+				       const struct nf_hook_state *state)
+{
+	enum ip_conntrack_info ctinfo;
+	struct nf_conn *ct;
+
+	if (!READ_ONCE(nf_flow_enable) || !net_eq(state->net, &init_net))
+		return NF_ACCEPT;
+
+	ct = nf_ct_get(skb, &ctinfo);
+	if (!ct || (ctinfo != IP_CT_ESTABLISHED &&
+		    ctinfo != IP_CT_ESTABLISHED_REPLY))
+		return NF_ACCEPT;
+
+	if (nf_flow_offloadable(ct, skb))
+		nf_flow_add(ct, CTINFO2DIR(ctinfo), skb, state->in);
+
+	return NF_ACCEPT;
+}
+
+static struct nf_hook_ops nf_flow_ipv4_ops[] __read_mostly = {
+	{
+		.hook		= nf_flow_ipv4_hook,
+		.pf		= NFPROTO_IPV4,
+		.hooknum	= NF_INET_PRE_ROUTING,
+		.priority	= NF_IP_PRI_CONNTRACK_DEFRAG - 1,
+	},
+	{
+		/* after the filter table dropped what it wants dropped */
+		.hook		= nf_flow_learn_hook,
+		.pf		= NFPROTO_IPV4,
+		.hooknum	= NF_INET_FORWARD,
+		.priority	= NF_IP_PRI_LAST,
+	},
+};
+
+static bool nf_flow_expired(const struct nf_flow *flow)
+{
+	const struct nf_conn *ct = flow->ct;
+
+	if (flow->teardown || !READ_ONCE(nf_flow_enable) ||
+	    nf_ct_is_dying((struct nf_conn *)ct))
+		return true;
+
+	return nf_ct_protonum(ct) == IPPROTO_TCP &&
+	       ct->proto.tcp.state != TCP_CONNTRACK_ESTABLISHED;
+}
+
+/* __nf_ct_refresh_acct() without a packet to account */
+static void nf_flow_refresh(struct nf_conn *ct, unsigned long timeout)
+{
+	unsigned long newtime = jiffies + timeout;
+
+	if (test_bit(IPS_FIXED_TIMEOUT_BIT, &ct->status))
+		return;
+
+	if (newtime - ct->timeout.expires >= HZ)
+		mod_timer_pending(&ct->timeout, newtime);
+}
+
+static void nf_flow_gc_work(struct work_struct *work)
+{
+	unsigned long since = nf_flow_gc_stamp;
+	struct hlist_node *tmp;
+	struct nf_flow *flow;
+	unsigned int expired = 0;
+	int i;
+
+	nf_flow_gc_stamp = jiffies;
+
+	for (i = 0; i < ARRAY_SIZE(nf_flow_hash); i++) {
+		if (hlist_empty(&nf_flow_hash[i]))
+			continue;
+
+		spin_lock_bh(&nf_flow_lock);
+		hlist_for_each_entry_safe(flow, tmp, &nf_flow_hash[i], node) {
+			if (nf_flow_expired(flow)) {
+				nf_flow_del(flow);
+				expired++;
+			} else if (time_after_eq(READ_ONCE(flow->last_used),
+						 since)) {
+				nf_flow_refresh(flow->ct, flow->ct_timeout);
+			}
+		}
+		spin_unlock_bh(&nf_flow_lock);
+	}
+
+	if (expired) {
+		preempt_disable();
+		__this_cpu_add(nf_flow_stats->expired, expired);
+		preempt_enable();
+	}
+
+	schedule_delayed_work(&nf_flow_gc, NF_FLOW_GC_INTERVAL);
+}
+
+static void nf_flow_flush(const struct net_device *dev)
+{
+	struct hlist_node *tmp;
+	struct nf_flow *flow;
+	int i;
+
+	spin_lock_bh(&nf_flow_lock);
+	for (i = 0; i < ARRAY_SIZE(nf_flow_hash); i++) {
+		hlist_for_each_entry_safe(flow, tmp, &nf_flow_hash[i], node) {
+			if (!dev || flow->tuple.iifidx == dev->ifindex ||
+			    flow->dst->dev == dev)
+				nf_flow_del(flow);
+		}
+	}
+	spin_unlock_bh(&nf_flow_lock);
+}
+
+static int nf_flow_netdev_event(struct notifier_block *this,
+				unsigned long event, void *ptr)
+{
+	struct net_device *dev = netdev_notifier_info_to_dev(ptr);
+
+	if (event == NETDEV_DOWN && net_eq(dev_net(dev), &init_net))
+		nf_flow_flush(dev);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block nf_flow_netdev_notifier = {
+	.notifier_call	= nf_flow_netdev_event,
+};
+
+#ifdef CONFIG_PROC_FS
+static int nf_flow_seq_show(struct seq_file *seq, void *v)
+{
+	int cpu;
+
+	seq_printf(seq, "flows %d\n", atomic_read(&nf_flow_count));
+	seq_puts(seq, "cpu       hits     misses   slowpath    learned    expired\n");
+	for_each_possible_cpu(cpu) {
+		struct nf_flow_stats *s = per_cpu_ptr(nf_flow_stats, cpu);
+
+		seq_printf(seq, "%3d %10lu %10lu %10lu %10lu %10lu\n", cpu,
+			   s->hits, s->misses, s->slowpath, s->learned,
+			   s->expired);
+	}
+
+	return 0;
+}
+
+static int nf_flow_seq_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, nf_flow_seq_show, NULL);
+}
+
+static const struct file_operations nf_flow_seq_fops = {
+	.owner		= THIS_MODULE,
+	.open		= nf_flow_seq_open,
+	.read		= seq_read,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+#endif
+
+static int __init nf_flow_offload_init(void)
+{
+	int err;
+
+	nf_flow_stats = alloc_percpu(struct nf_flow_stats);
+	if (!nf_flow_stats)
+		return -ENOMEM;
+
+	get_random_bytes(&nf_flow_seed, sizeof(nf_flow_seed));
+
+#ifdef CONFIG_PROC_FS
+	if (!proc_create("nf_flow_offload", S_IRUGO, init_net.proc_net,
+			 &nf_flow_seq_fops)) {
+		err = -ENOMEM;
+		goto err_proc;
+	}
+#endif
+
+	err = register_netdevice_notifier(&nf_flow_netdev_notifier);
+	if (err)
+		goto err_notifier;
+
+	err = nf_register_hooks(nf_flow_ipv4_ops,
+				ARRAY_SIZE(nf_flow_ipv4_ops));
+	if (err)
+		goto err_hooks;
+
+	nf_flow_gc_stamp = jiffies;
+	schedule_delayed_work(&nf_flow_gc, NF_FLOW_GC_INTERVAL);
+	return 0;
+
+err_hooks:
+	unregister_netdevice_notifier(&nf_flow_netdev_notifier);
+err_notifier:
+#ifdef CONFIG_PROC_FS
+	remove_proc_entry("nf_flow_offload", init_net.proc_net);
+err_proc:
+#endif
+	free_percpu(nf_flow_stats);
+	return err;
+}
+
+static void __exit nf_flow_offload_fini(void)
+{
+	nf_unregister_hooks(nf_flow_ipv4_ops, ARRAY_SIZE(nf_flow_ipv4_ops));
+	unregister_netdevice_notifier(&nf_flow_netdev_notifier);
+	cancel_delayed_work_sync(&nf_flow_gc);
+	nf_flow_flush(NULL);
+	rcu_barrier();
+#ifdef CONFIG_PROC_FS
+	remove_proc_entry("nf_flow_offload", init_net.proc_net);
+#endif
+	free_percpu(nf_flow_stats);
+}
+
+module_init(nf_flow_offload_init);
+module_exit(nf_flow_offload_fini);
+
+MODULE_LICENSE("GPL");
+MODULE_DESCRIPTION("IPv4 software flow offload for forwarded connections");
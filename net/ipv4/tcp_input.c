@@ -111,6 +111,11 @@ int sysctl_tcp_early_retrans __read_mostly = 3;
 int sysctl_tcp_invalid_ratelimit __read_mostly = HZ/2;
 int sysctl_tcp_default_init_rwnd __read_mostly = TCP_INIT_CWND * 2;
 
+/* ACK thinning, for devices with conf/<dev>/tcp_ack_thin set */
+int sysctl_tcp_ack_thin_segs __read_mostly = 8;
+int sysctl_tcp_ack_thin_rtt_us __read_mostly = 40000;
+int sysctl_tcp_ack_thin_delay_us __read_mostly = 10000;
+
 #ifdef CONFIG_CLTCP
 int sysctl_tcp_cltcp[4] __read_mostly;	/* Time stamp, Avg Time, Avg TP, Avg MCS, Avg NRB, DL grant freq., RSRP, RSRQ, RSSI, CINR */
 unsigned long long sysctl_tcp_cltcp_ifdevs __read_mostly;
@@ -5671,6 +5676,52 @@ static inline void tcp_data_snd_check(struct sock *sk)
 /*
  * Check if sending an ack is needed.
  */
+/* On paths through a device with tcp_ack_thin set, typically a cellular
+ * link whose uplink is far narrower than its downlink, the ACK a second
+ * full frame calls for may be held back while the RTT is high: until
+ * tcp_ack_thin_segs frames are pending or tcp_ack_thin_delay_us passed,
+ * whichever comes first. Quickack mode and out of order data, i.e. loss,
+ * still get their ACK right away, as does a sender about to run out of
+ * advertised window.
+ */
+static bool tcp_ack_thin(struct sock *sk)
+{
+	struct inet_connection_sock *icsk = inet_csk(sk);
+	struct tcp_sock *tp = tcp_sk(sk);
+	u32 budget = sysctl_tcp_ack_thin_segs * icsk->icsk_ack.rcv_mss;
+	const struct dst_entry *dst;
+	struct in_device *in_dev;
+	unsigned long delay;
+	bool thin = false;
+
+	if (!budget || (tp->srtt_us >> 3) < sysctl_tcp_ack_thin_rtt_us)
+		return false;
+	if (tp->rcv_nxt - tp->rcv_wup >= budget ||
+	    tcp_receive_window(tp) < 2 * budget)
+		return false;
+
+	rcu_read_lock();
+	dst = __sk_dst_get(sk);
+	if (dst && dst->dev) {
+		in_dev = __in_dev_get_rcu(dst->dev);
+		thin = in_dev && IN_DEV_TCP_ACK_THIN(in_dev);
+	}
+	rcu_read_unlock();
+	if (!thin)
+		return false;
+
+	/* ACK within the time budget, an earlier delayed ACK stands */
+	delay = max_t(unsigned long, 1,
+		      usecs_to_jiffies(sysctl_tcp_ack_thin_delay_us));
+	if (!(icsk->icsk_ack.pending & ICSK_ACK_TIMER) ||
+	    time_before(jiffies + delay, icsk->icsk_ack.timeout))
+		inet_csk_reset_xmit_timer(sk, ICSK_TIME_DACK, delay,
+					  TCP_DELACK_MAX);
+
+	NET_INC_STATS_BH(sock_net(sk), LINUX_MIB_TCPACKTHINNED);
+	return true;
+}
+
 static void __tcp_ack_snd_check(struct sock *sk, int ofo_possible)
 {
 	struct tcp_sock *tp = tcp_sk(sk);
@@ -5689,7 +5740,13 @@ static void __tcp_ack_snd_check(struct sock *sk, int ofo_possible)
 	    tcp_in_quickack_mode(sk) ||
 	    /* We have out of order data. */
 	    (ofo_possible && !RB_EMPTY_ROOT(&tp->out_of_order_queue))) {
-		/* Then ack it now */
+		/* Then ack it now, unless the window alone calls for it on
+		 * a path thinning ACKs
+		 */
+		if (!tcp_in_quickack_mode(sk) &&
+		    (!ofo_possible || RB_EMPTY_ROOT(&tp->out_of_order_queue)) &&
+		    tcp_ack_thin(sk))
+			return;
 		tcp_send_ack(sk);
 	} else {
 		/* Else, send delayed ack. */
@@ -71,6 +71,9 @@ static struct sk_buff *udp6_ufo_fragment(struct sk_buff *skb,
 		if (!pskb_may_pull(skb, sizeof(struct udphdr)))
 			goto out;
 
+		if (skb_shinfo(skb)->gso_type & SKB_GSO_UDP_L4)
+			return __udp_gso_segment(skb, features);
+
 		/* Do software UFO. Complete and fill in the UDP checksum as HW cannot
 		 * do checksum of UDP packets sent as multiple IP fragments.
 		 */
@@ -130,6 +133,22 @@ out:
 	return segs;
 }
 
+static bool udp6_gro_sk_enabled(struct sk_buff *skb, struct udphdr *uh)
+{
+	const struct ipv6hdr *iph = skb_gro_network_header(skb);
+	struct sock *sk;
+	bool enabled;
+
+	rcu_read_lock();
+	sk = __udp6_lib_lookup(dev_net(skb->dev), &iph->saddr, uh->source,
+			       &iph->daddr, uh->dest, skb->dev->ifindex,
+			       &udp_table, NULL);
+	enabled = sk && udp_sk(sk)->gro_enabled;
+	rcu_read_unlock();
+
+	return enabled;
+}
+
 static struct sk_buff **udp6_gro_receive(struct sk_buff **head,
 					 struct sk_buff *skb)
 {
@@ -151,6 +170,10 @@ static struct sk_buff **udp6_gro_receive(struct sk_buff **head,
 
 skip:
 	NAPI_GRO_CB(skb)->is_ipv6 = 1;
+	if (static_key_false(&udp_gro_needed) &&
+	    !NAPI_GRO_CB(skb)->encap_mark &&
+	    udp6_gro_sk_enabled(skb, uh))
+		return udp_gro_receive_segment(head, skb, uh);
 	return udp_gro_receive(head, skb, uh);
 
 flush:
@@ -163,6 +186,12 @@ static int udp6_gro_complete(struct sk_buff *skb, int nhoff)
 	const struct ipv6hdr *ipv6h = ipv6_hdr(skb);
 	struct udphdr *uh = (struct udphdr *)(skb->data + nhoff);
 
+	if (NAPI_GRO_CB(skb)->udp_gso) {
+		uh->check = ~udp_v6_check(skb->len - nhoff, &ipv6h->saddr,
+					  &ipv6h->daddr, 0);
+		return udp_gro_complete_segment(skb, nhoff);
+	}
+
 	if (uh->check) {
 		skb_shinfo(skb)->gso_type |= SKB_GSO_UDP_TUNNEL_CSUM;
 		uh->check = ~udp_v6_check(skb->len - nhoff, &ipv6h->saddr,
@@ -44,6 +44,7 @@
 #include <linux/syscalls.h>
 #include <linux/uaccess.h>
 #include <linux/file.h>
+#include <linux/ktime.h>
 
 #include <asm/cacheflush.h>
 #include <asm/cachetype.h>
@@ -660,14 +661,41 @@ static void esa_free_rtd(struct esa_rtd *rtd)
 
 	spin_unlock(&si.lock);
 
+	free_page((unsigned long)rtd->status);
 	kfree(rtd);
 }
 
+static void esa_update_status(struct esa_rtd *rtd, int response,
+				ktime_t start)
+{
+	struct seiren_ch_status *status = rtd->status;
+	ktime_t now = ktime_get();
+	u32 usecs = (u32)ktime_us_delta(now, start);
+
+	if (!status)
+		return;
+
+	status->seq++;
+	smp_wmb();
+	status->exe_count++;
+	if (response == 0) {
+		status->in_bytes += readl(si.mailbox + CONSUMED_BYTE_IN);
+		status->out_bytes += readl(si.mailbox + SIZE_OUT_DATA);
+	}
+	status->last_exe_us = usecs;
+	if (usecs > status->max_exe_us)
+		status->max_exe_us = usecs;
+	status->last_exe_ns = ktime_to_ns(now);
+	smp_wmb();
+	status->seq++;
+}
+
 static int esa_send_cmd_exe(struct esa_rtd *rtd, unsigned char *ibuf,
 				unsigned char *obuf, size_t size)
 {
 	u32 ibuf_ca5_pa, obuf_ca5_pa;
 	u32 ibuf_offset, obuf_offset;
+	ktime_t start = ktime_get();
 	int out_size;
 	int response;
 
@@ -701,6 +729,7 @@ static int esa_send_cmd_exe(struct esa_rtd *rtd, unsigned char *ibuf,
 
 	/* check response of FW */
 	response = readl(si.mailbox + RETURN_CMD);
+	esa_update_status(rtd, response, start);
 
 	if (rtd->use_sram) {
 		out_size = readl(si.mailbox + SIZE_OUT_DATA);
@@ -1274,7 +1303,7 @@ static int esa_exe(struct file *file, unsigned int param,
 	unsigned char *obuf = rtd->obuf0;
 	int ret = 0;
 
-	mutex_lock(&esa_mutex);
+	/* esa_ioctl() holds esa_mutex */
 
 	/* receive ibuf_info from user */
 	if (copy_from_user(&ibuf_info, (struct audio_mem_info_t *)arg,
@@ -1330,10 +1359,41 @@ static int esa_exe(struct file *file, unsigned int param,
 
 	return ret;
 err:
-	mutex_unlock(&esa_mutex);
 	return -EFAULT;
 }
 
+/*
+ * Same as esa_exe() with the input already written by user space into
+ * the buffer it mapped at SEIREN_MMAP_CH_BUF, and the output left in
+ * place for it to read, so nothing is copied.
+ */
+static int esa_exe_mmap(struct file *file, unsigned int param,
+							unsigned long arg)
+{
+	struct esa_rtd *rtd = file->private_data;
+	unsigned char *ibuf = (param & 1) ? rtd->ibuf1 : rtd->ibuf0;
+	unsigned char *obuf = (param & 1) ? rtd->obuf1 : rtd->obuf0;
+	int response;
+
+	/* esa_ioctl() holds esa_mutex */
+
+	if (!rtd->ibuf0)
+		return -EINVAL;
+
+	if (arg > rtd->ibuf_size) {
+		esa_err("%s: There is too much input data", __func__);
+		return -EINVAL;
+	}
+
+	response = esa_send_cmd_exe(rtd, ibuf, obuf, arg);
+	if (response) {
+		esa_debug("%s: cmd_exe Fail: %d\n", __func__, response);
+		return 0;
+	}
+
+	return readl(si.mailbox + SIZE_OUT_DATA);
+}
+
 static int esa_set_params(struct file *file, unsigned int param,
 							unsigned long arg)
 {
@@ -1765,6 +1825,9 @@ static long esa_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		esa_debug("CH_EXE\n");
 		ret = esa_exe(file, param, arg);
 		break;
+	case SEIREN_IOCTL_CH_EXE_MMAP:
+		ret = esa_exe_mmap(file, param, arg);
+		break;
 	case SEIREN_IOCTL_CH_SET_PARAMS:
 		esa_debug("CH_SET_PARAMS\n");
 		ret = esa_set_params(file, param, arg);
@@ -2028,12 +2091,57 @@ static long esa_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 }
 #endif
 
+#ifndef CONFIG_SND_SAMSUNG_SEIREN_OFFLOAD
+static int esa_mmap_ch(struct file *filep, struct vm_area_struct *vmarea)
+{
+	struct esa_rtd *rtd = filep->private_data;
+	unsigned long len = vmarea->vm_end - vmarea->vm_start;
+	phys_addr_t pa;
+
+	if (vmarea->vm_pgoff == SEIREN_MMAP_CH_STATUS) {
+		if (len > PAGE_SIZE)
+			return -EINVAL;
+		if (!rtd->status) {
+			rtd->status = (struct seiren_ch_status *)
+					get_zeroed_page(GFP_KERNEL);
+			if (!rtd->status)
+				return -ENOMEM;
+		}
+		return remap_pfn_range(vmarea, vmarea->vm_start,
+				virt_to_pfn(rtd->status), len,
+				vmarea->vm_page_prot);
+	}
+
+	/* the buffers are placed by CH_CREATE */
+	if (!rtd->ibuf0 || len > BUF_SIZE_MAX)
+		return -EINVAL;
+
+	pa = si.fwarea_pa[rtd->block_num] +
+			(rtd->ibuf0 - si.fwarea[rtd->block_num]);
+
+	vmarea->vm_flags |= VM_IO;
+
+	return remap_pfn_range(vmarea, vmarea->vm_start, pa >> PAGE_SHIFT,
+			len, pgprot_noncached(vmarea->vm_page_prot));
+}
+#endif
+
 static int esa_mmap(struct file *filep, struct vm_area_struct *vmarea)
 {
 	unsigned int pfn;
 	unsigned long len = vmarea->vm_end - vmarea->vm_start;
 	int ret = 0;
 
+#ifndef CONFIG_SND_SAMSUNG_SEIREN_OFFLOAD
+	if (vmarea->vm_pgoff == SEIREN_MMAP_CH_BUF ||
+	    vmarea->vm_pgoff == SEIREN_MMAP_CH_STATUS) {
+		mutex_lock(&esa_mutex);
+		ret = esa_mmap_ch(filep, vmarea);
+		mutex_unlock(&esa_mutex);
+		return ret;
+	}
+#endif
+
 	esa_info("%s: start=0x%p, size=%ld, offset=%ld, phys=0x%llX",
 			__func__,
 			(void *)vmarea->vm_start, len, vmarea->vm_pgoff,
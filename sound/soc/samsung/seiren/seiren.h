@@ -418,6 +418,9 @@ struct esa_rtd {
 
 	/* multi-instance */
 	unsigned int	idx;
+
+	/* page mapped at SEIREN_MMAP_CH_STATUS */
+	struct seiren_ch_status	*status;
 };
 
 #ifdef CONFIG_SND_SAMSUNG_SEIREN_OFFLOAD
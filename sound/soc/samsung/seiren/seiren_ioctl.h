@@ -4,6 +4,7 @@
 #define SEIREN_IOCTL_CH_CREATE		(0x1001)
 #define SEIREN_IOCTL_CH_DESTROY		(0x1002)
 #define SEIREN_IOCTL_CH_EXE		(0x1003)
+#define SEIREN_IOCTL_CH_EXE_MMAP	(0x1004)
 #define SEIREN_IOCTL_CH_SET_PARAMS	(0x2001)
 #define SEIREN_IOCTL_CH_GET_PARAMS	(0x2002)
 #define SEIREN_IOCTL_CH_RESET		(0x2003)
@@ -12,4 +13,34 @@
 #define SEIREN_IOCTL_FX_EXT		(0x4000)
 #define SEIREN_IOCTL_ELPE_DONE		(0x5000)
 
+/*
+ * mmap() offsets of a channel, in pages.  SEIREN_MMAP_CH_BUF maps the
+ * channel's IBUF0/IBUF1/OBUF0/OBUF1 area so samples are written and
+ * decoded output read in place, SEIREN_MMAP_CH_STATUS maps one page
+ * holding struct seiren_ch_status.  Offset 0 keeps mapping the whole
+ * second firmware area as before.
+ */
+#define SEIREN_MMAP_CH_BUF		(0x1000)
+#define SEIREN_MMAP_CH_STATUS		(0x2000)
+
+/*
+ * SEIREN_IOCTL_CH_EXE_MMAP: arg is the number of bytes already placed
+ * in the mmap'ed input buffer, param bit 0 selects IBUF1/OBUF1 instead
+ * of IBUF0/OBUF0.  Returns the number of output bytes in the matching
+ * output buffer.
+ *
+ * The status page is updated after every execute command.  seq is odd
+ * while an update is in progress, readers retry until they see the
+ * same even value before and after reading the other fields.
+ */
+struct seiren_ch_status {
+	__u32	seq;
+	__u32	exe_count;
+	__u64	in_bytes;	/* consumed by the firmware */
+	__u64	out_bytes;	/* produced by the firmware */
+	__u32	last_exe_us;	/* round trip of the last command */
+	__u32	max_exe_us;
+	__u64	last_exe_ns;	/* CLOCK_MONOTONIC at completion */
+};
+
 #endif /* __SEIREN_IOCTL_H */
@@ -61,6 +61,17 @@ static void update_mask_value(volatile void __iomem *sfr,
 #define LIMIT_IN_JIFFIES (msecs_to_jiffies(1000))
 #define DMIC_CLK_RATE (768000)
 
+/*
+ * Start copying the trigger history into DRAM as soon as the keyword is
+ * detected instead of when user space starts the trigger record stream,
+ * so the backfill runs while the assistant is still opening the device.
+ * The copy is stopped again if no stream picks it up within this time.
+ */
+static unsigned int early_copy_ms = 3000;
+module_param(early_copy_ms, uint, 0644);
+MODULE_PARM_DESC(early_copy_ms,
+		"Stop an early history copy no stream started after this many ms, 0 disables early copy");
+
 /* For only external static functions */
 static struct vts_data *p_vts_data;
 
@@ -933,6 +944,109 @@ static irqreturn_t vts_ipc_received_handler(int irq, void *dev_id)
 	return IRQ_HANDLED;
 }
 
+int vts_start_copy(struct device *dev, struct vts_data *data, bool *early)
+{
+	enum vts_copy_state prev;
+	unsigned long flags;
+	u32 values[3] = {0,};
+	int result = 0;
+
+	spin_lock_irqsave(&data->copy_lock, flags);
+	prev = data->copy_state;
+	data->copy_state = VTS_COPY_STREAM;
+	if (prev == VTS_COPY_IDLE) {
+		result = vts_start_ipc_transaction(dev, data,
+				VTS_IRQ_AP_START_COPY, &values, 1, 1);
+		if (IS_ERR_VALUE(result))
+			data->copy_state = VTS_COPY_IDLE;
+	}
+	if (data->latency_pending)
+		data->trigger_to_stream_us =
+			ktime_us_delta(ktime_get(), data->triggered);
+	spin_unlock_irqrestore(&data->copy_lock, flags);
+
+	*early = (prev == VTS_COPY_EARLY);
+
+	return result;
+}
+
+int vts_stop_copy(struct device *dev, struct vts_data *data)
+{
+	unsigned long flags;
+	u32 values[3] = {0,};
+	int result = 0;
+
+	spin_lock_irqsave(&data->copy_lock, flags);
+	if (data->copy_state != VTS_COPY_IDLE) {
+		result = vts_start_ipc_transaction(dev, data,
+				VTS_IRQ_AP_STOP_COPY, &values, 1, 1);
+		data->copy_state = VTS_COPY_IDLE;
+	}
+	data->latency_pending = false;
+	spin_unlock_irqrestore(&data->copy_lock, flags);
+
+	return result;
+}
+
+static void vts_early_copy_work_func(struct work_struct *work)
+{
+	struct vts_data *data = container_of(work, struct vts_data,
+			early_copy_work);
+	struct device *dev = &data->pdev->dev;
+	unsigned long flags;
+	u32 values[3] = {0,};
+	int result;
+
+	spin_lock_irqsave(&data->copy_lock, flags);
+	if (data->copy_state != VTS_COPY_IDLE) {
+		spin_unlock_irqrestore(&data->copy_lock, flags);
+		return;
+	}
+	result = vts_start_ipc_transaction(dev, data,
+			VTS_IRQ_AP_START_COPY, &values, 1, 1);
+	if (!IS_ERR_VALUE(result))
+		data->copy_state = VTS_COPY_EARLY;
+	spin_unlock_irqrestore(&data->copy_lock, flags);
+
+	if (IS_ERR_VALUE(result)) {
+		dev_warn(dev, "Early history copy failed: %d\n", result);
+		return;
+	}
+
+	schedule_delayed_work(&data->early_copy_timeout,
+			msecs_to_jiffies(early_copy_ms));
+}
+
+static void vts_early_copy_timeout_func(struct work_struct *work)
+{
+	struct vts_data *data = container_of(to_delayed_work(work),
+			struct vts_data, early_copy_timeout);
+	struct device *dev = &data->pdev->dev;
+	unsigned long flags;
+	u32 values[3] = {0,};
+
+	spin_lock_irqsave(&data->copy_lock, flags);
+	if (data->copy_state == VTS_COPY_EARLY) {
+		dev_info(dev, "No stream for the early history copy\n");
+		vts_start_ipc_transaction(dev, data,
+				VTS_IRQ_AP_STOP_COPY, &values, 1, 1);
+		data->copy_state = VTS_COPY_IDLE;
+		data->latency_pending = false;
+	}
+	spin_unlock_irqrestore(&data->copy_lock, flags);
+}
+
+static ssize_t trigger_latency_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct vts_data *data = dev_get_drvdata(dev);
+
+	return scnprintf(buf, PAGE_SIZE,
+			"trigger_to_stream_us: %lld\ntrigger_to_data_us: %lld\n",
+			data->trigger_to_stream_us, data->trigger_to_data_us);
+}
+static DEVICE_ATTR_RO(trigger_latency);
+
 static irqreturn_t vts_voice_triggered_handler(int irq, void *dev_id)
 {
 	struct platform_device *pdev = dev_id;
@@ -952,6 +1066,13 @@ static irqreturn_t vts_voice_triggered_handler(int irq, void *dev_id)
 
 	dev_info(dev, "VTS triggered: id=%u,score=%u,frame_count=%u\n", id, score, frame_count);
 
+	data->triggered = ktime_get();
+	data->trigger_to_stream_us = -1;
+	data->trigger_to_data_us = -1;
+	data->latency_pending = true;
+	if (early_copy_ms)
+		schedule_work(&data->early_copy_work);
+
 	if (data->exec_mode == VTS_VOICE_TRIGGER_MODE
 		 || data->exec_mode == VTS_VT_ALWAYS_ON_MODE) {
 		keyword_type = 1;
@@ -984,6 +1105,13 @@ static irqreturn_t vts_trigger_period_elapsed_handler(int irq, void *dev_id)
 		platform_data->pointer = pointer - data->dma_area_vts;
 	vts_ipc_ack(data, 1);
 
+	if (data->latency_pending) {
+		data->latency_pending = false;
+		data->trigger_to_data_us =
+			ktime_us_delta(ktime_get(), data->triggered);
+		dev_info(dev, "Trigger to first history period: %lld us\n",
+				data->trigger_to_data_us);
+	}
 
 	snd_pcm_period_elapsed(platform_data->substream);
 
@@ -1286,6 +1414,13 @@ static int samsung_vts_probe(struct platform_device *pdev)
 	init_waitqueue_head(&data->ipc_wait_queue);
 	spin_lock_init(&data->ipc_spinlock);
 	mutex_init(&data->ipc_mutex);
+	spin_lock_init(&data->copy_lock);
+	data->copy_state = VTS_COPY_IDLE;
+	INIT_WORK(&data->early_copy_work, vts_early_copy_work_func);
+	INIT_DELAYED_WORK(&data->early_copy_timeout,
+			vts_early_copy_timeout_func);
+	data->trigger_to_stream_us = -1;
+	data->trigger_to_data_us = -1;
 
 	data->pinctrl = devm_pinctrl_get(dev);
 	if (IS_ERR(data->pinctrl)) {
@@ -1440,6 +1575,11 @@ static int samsung_vts_probe(struct platform_device *pdev)
 	dev_dbg(dev, "DMIC_CLK_CTRL: Before 0x%x After 0x%x \n", dmic_clkctrl,
 			readl(data->sfr_base + VTS_DMIC_CLK_CTRL));
 
+	result = device_create_file(dev, &dev_attr_trigger_latency);
+	if (IS_ERR_VALUE(result))
+		dev_warn(dev, "Failed to create trigger_latency file\n");
+	result = 0;
+
 	dev_info(dev, "Probed successfully\n");
 
 error:
@@ -1451,6 +1591,9 @@ static int samsung_vts_remove(struct platform_device *pdev)
 	struct device *dev = &pdev->dev;
 	struct vts_data *data = platform_get_drvdata(pdev);
 
+	device_remove_file(dev, &dev_attr_trigger_latency);
+	cancel_work_sync(&data->early_copy_work);
+	cancel_delayed_work_sync(&data->early_copy_timeout);
 	pm_runtime_disable(dev);
 	clk_unprepare(data->clk_dmic);
 #ifndef CONFIG_PM
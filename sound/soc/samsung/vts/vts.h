@@ -12,6 +12,9 @@
 #ifndef __SND_SOC_VTS_H
 #define __SND_SOC_VTS_H
 
+#include <linux/ktime.h>
+#include <linux/workqueue.h>
+
 /* SYSREG_VTS */
 #define VTS_USER_REG2			(0x0008)
 #define VTS_BUS_COMPONENT_DRCG_EN	(0x0200)
@@ -170,6 +173,12 @@ enum executionmode {
 	VTS_MODE_COUNT,
 };
 
+enum vts_copy_state {
+	VTS_COPY_IDLE,
+	VTS_COPY_EARLY,		/* started by the trigger, no stream yet */
+	VTS_COPY_STREAM,	/* owned by the trigger record stream */
+};
+
 struct vts_ipc_msg {
 	int msg;
 	u32 values[3];
@@ -209,6 +218,14 @@ struct vts_data {
 	volatile bool enabled;
 	struct snd_soc_card *card;
 	int micclk_init_cnt;
+	spinlock_t copy_lock;
+	enum vts_copy_state copy_state;
+	struct work_struct early_copy_work;
+	struct delayed_work early_copy_timeout;
+	ktime_t triggered;
+	bool latency_pending;
+	s64 trigger_to_stream_us;
+	s64 trigger_to_data_us;
 };
 
 struct vts_platform_data {
@@ -226,4 +243,7 @@ extern int vts_start_ipc_transaction(struct device *dev, struct vts_data *data,
 extern void vts_register_dma(struct platform_device *pdev_vts,
 		struct platform_device *pdev_vts_dma, unsigned int id);
 extern void vts_set_dmicctrl(struct platform_device *pdev, bool enable);
+extern int vts_start_copy(struct device *dev, struct vts_data *data,
+		bool *early);
+extern int vts_stop_copy(struct device *dev, struct vts_data *data);
 #endif /* __SND_SOC_VTS_H */
@@ -62,17 +62,20 @@ static int vts_platform_hw_params(struct snd_pcm_substream *substream,
 
 	if (data->type == PLATFORM_VTS_TRIGGER_RECORD) {
 		snd_pcm_set_runtime_buffer(substream, &data->vts_data->dmab);
+		/* an early history copy already moved the pointer */
+		if (data->vts_data->copy_state == VTS_COPY_EARLY)
+			goto out;
 	} else {
 		snd_pcm_set_runtime_buffer(substream, &data->vts_data->dmab_rec);
 	}
+	data->pointer = 0;
+out:
 	dev_info(dev, "%s:%s:DmaAddr=%pad Total=%zu PrdSz=%u(%u) #Prds=%u dma_area=%p\n",
 			__func__, snd_pcm_stream_str(substream), &runtime->dma_addr,
 			runtime->dma_bytes, params_period_size(params),
 			params_period_bytes(params), params_periods(params),
 			runtime->dma_area);
 
-	data->pointer = 0;
-
 	return 0;
 }
 
@@ -105,6 +108,7 @@ static int vts_platform_trigger(struct snd_pcm_substream *substream, int cmd)
 	struct device *dev = platform->dev;
 	struct vts_platform_data *data = dev_get_drvdata(dev);
 	u32 values[3];
+	bool early;
 	int result = 0;
 
 	dev_info(dev, "%s ++ CMD: %d\n", __func__, cmd);
@@ -115,7 +119,9 @@ static int vts_platform_trigger(struct snd_pcm_substream *substream, int cmd)
 	case SNDRV_PCM_TRIGGER_PAUSE_RELEASE:
 		if (data->type == PLATFORM_VTS_TRIGGER_RECORD) {
 			dev_dbg(dev, "%s VTS_IRQ_AP_START_COPY\n", __func__);
-			result = vts_start_ipc_transaction(dev, data->vts_data, VTS_IRQ_AP_START_COPY, &values, 1, 1);
+			result = vts_start_copy(dev, data->vts_data, &early);
+			if (early)
+				dev_info(dev, "%s history copy already running\n", __func__);
 		} else {
 			dev_dbg(dev, "%s VTS_IRQ_AP_START_REC\n", __func__);
 			result = vts_start_ipc_transaction(dev, data->vts_data, VTS_IRQ_AP_START_REC, &values, 1, 1);
@@ -126,7 +132,7 @@ static int vts_platform_trigger(struct snd_pcm_substream *substream, int cmd)
 	case SNDRV_PCM_TRIGGER_PAUSE_PUSH:
 		if (data->type == PLATFORM_VTS_TRIGGER_RECORD) {
 			dev_dbg(dev, "%s VTS_IRQ_AP_STOP_COPY\n", __func__);
-			result = vts_start_ipc_transaction(dev, data->vts_data, VTS_IRQ_AP_STOP_COPY, &values, 1, 1);
+			result = vts_stop_copy(dev, data->vts_data);
 		} else {
 			dev_dbg(dev, "%s VTS_IRQ_AP_STOP_REC\n", __func__);
 			result = vts_start_ipc_transaction(dev, data->vts_data, VTS_IRQ_AP_STOP_REC, &values, 1, 1);